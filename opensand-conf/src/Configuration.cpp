@@ -37,9 +37,7 @@
 #include <libxml/tree.h>
 #include <libxml/parser.h>
 
-#include <cstdio>
-#include <locale>
-#include <codecvt>
+#include <algorithm>
 
 #include <vector>
 #include <tuple>
@@ -66,6 +64,7 @@ std::string getAttribute(xmlNodePtr &node, const std::string &name);
 std::string getNodeContent(xmlNodePtr &node);
 
 // toXSD functions
+xmlDocPtr modelToXSD(std::shared_ptr<OpenSANDConf::MetaModel> model);
 std::vector<xmlNodePtr> enumerationsToXSD(std::shared_ptr<OpenSANDConf::MetaTypesList> types);
 xmlNodePtr rootToXSD(std::shared_ptr<OpenSANDConf::MetaComponent> element);
 
@@ -83,6 +82,24 @@ bool OpenSANDConf::toXSD(std::shared_ptr<OpenSANDConf::MetaModel> model, const s
 {
 	int code;
 
+	auto doc = modelToXSD(model);
+	if(doc == nullptr)
+	{
+		xmlCleanupParser();
+		xmlMemoryDump();
+		return false;
+	}
+
+	// Write XSD file
+	code = xmlSaveFormatFileEnc(filepath.c_str(), doc, CONFIGURATION_FILES_ENCODING, 1);
+	xmlFreeDoc(doc);
+	xmlCleanupParser();
+	xmlMemoryDump();
+	return (code != -1);
+}
+
+xmlDocPtr modelToXSD(std::shared_ptr<OpenSANDConf::MetaModel> model)
+{
 	// Initialize XSD document
 	auto doc = xmlNewDoc(BAD_CAST CONFIGURATION_FILES_VERSION);
 	auto schema = xmlNewNode(nullptr, BAD_CAST "xs:schema");
@@ -131,18 +148,11 @@ bool OpenSANDConf::toXSD(std::shared_ptr<OpenSANDConf::MetaModel> model, const s
 	if(root == nullptr)
 	{
 		xmlFreeDoc(doc);
-		xmlCleanupParser();
-		xmlMemoryDump();
-		return false;
+		return nullptr;
 	}
 	xmlAddChild(seq, root);
 
-	// Write XSD file
-	code = xmlSaveFormatFileEnc(filepath.c_str(), doc, CONFIGURATION_FILES_ENCODING, 1);
-	xmlFreeDoc(doc);
-	xmlCleanupParser();
-	xmlMemoryDump();
-	return (code != -1);
+	return doc;
 }
 
 std::shared_ptr<OpenSANDConf::MetaModel> OpenSANDConf::fromXSD(const std::string &filepath)
@@ -277,23 +287,31 @@ std::shared_ptr<OpenSANDConf::DataModel> OpenSANDConf::fromXML(std::shared_ptr<O
 	std::shared_ptr<OpenSANDConf::DataModel> datamodel;
 	xmlNodePtr node;
 	std::string version;
+	xmlChar *xsd;
+	int xsd_len;
 
-	// Get XSD schema
-	std::string tmppath(tmpnam(nullptr));
-	if(!toXSD(model, tmppath))
+	// Get XSD schema, serialized in memory rather than in a temporary file
+	auto xsd_doc = modelToXSD(model);
+	if(xsd_doc == nullptr)
 	{
 		return nullptr;
 	}
-	auto sctxt = xmlSchemaNewParserCtxt(tmppath.c_str());
+	xmlDocDumpFormatMemoryEnc(xsd_doc, &xsd, &xsd_len, CONFIGURATION_FILES_ENCODING, 0);
+	xmlFreeDoc(xsd_doc);
+	if(xsd == nullptr)
+	{
+		return nullptr;
+	}
+	auto sctxt = xmlSchemaNewMemParserCtxt((const char *)xsd, xsd_len);
 	if(sctxt == nullptr)
 	{
-		remove(tmppath.c_str());
+		xmlFree(xsd);
 		return nullptr;
 	}
 	//xmlSchemaSetParserErrors(sctxt, (xmlSchemaValidityErrorFunc) fprintf, (xmlSchemaValidityWarningFunc) fprintf, stderr);
 	schema = xmlSchemaParse(sctxt);
 	xmlSchemaFreeParserCtxt(sctxt);
-	remove(tmppath.c_str());
+	xmlFree(xsd);
 	if(schema == nullptr)
 	{
 		return nullptr;
@@ -368,7 +386,6 @@ std::vector<xmlNodePtr> getChildNodes(xmlNodePtr &node, const std::string &ns, c
 	std::vector<xmlNodePtr> nodes;
 	for(xmlNodePtr child=node->children; child != nullptr; child = child->next)
 	{
-		std::string tmp = child->ns != nullptr ? std::string((char *)child->ns->prefix) : "NULL";
 		if(child->type != XML_ELEMENT_NODE
 		   || xmlStrcmp(child->name, BAD_CAST name.c_str()) != 0)
 		{
@@ -431,21 +448,13 @@ xmlNodePtr getUniqueChildNodeWithAttribute(xmlNodePtr &node,
 
 std::string getAttribute(xmlNodePtr &node, const std::string &name)
 {
+	// libxml2 already checked the document is valid UTF-8
 	auto tmp = xmlGetProp(node, BAD_CAST name.c_str());
 	if(tmp != nullptr)
 	{
-		try
-		{
-			std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> conv;
-			std::wstring wcontent = conv.from_bytes((const char *)tmp);
-			std::string content = conv.to_bytes(wcontent);
-			xmlFree(tmp);
-			return content;
-		}
-		catch(const std::range_error& e)
-		{
-			xmlFree(tmp);
-		}
+		std::string content((const char *)tmp);
+		xmlFree(tmp);
+		return content;
 	}
 
 	return "";
@@ -453,21 +462,13 @@ std::string getAttribute(xmlNodePtr &node, const std::string &name)
 
 std::string getNodeContent(xmlNodePtr &node)
 {
+	// libxml2 already checked the document is valid UTF-8
 	auto tmp = xmlNodeGetContent(node);
 	if(tmp != nullptr)
 	{
-		try
-		{
-			std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> conv;
-			std::wstring wcontent = conv.from_bytes((const char *)tmp);
-			std::string content = conv.to_bytes(wcontent);
-			xmlFree(tmp);
-			return content;
-		}
-		catch(const std::range_error& e)
-		{
-			xmlFree(tmp);
-		}
+		std::string content((const char *)tmp);
+		xmlFree(tmp);
+		return content;
 	}
 
 	return "";
@@ -1202,6 +1203,10 @@ xmlNodePtr rootToXML(std::shared_ptr<OpenSANDConf::DataComponent> element)
 //================================================================
 bool loadComponentFromXML(std::shared_ptr<OpenSANDConf::DataComponent> current, xmlNodePtr node)
 {
+	// The XML children are usually written in the order of the items,
+	// try the item following the last one found before searching them all
+	const auto &items = current->getItems();
+	auto next = items.begin();
 	for(auto child = node->children; child != nullptr; child = child->next)
 	{
 		if(child->type != XML_ELEMENT_NODE)
@@ -1209,8 +1214,18 @@ bool loadComponentFromXML(std::shared_ptr<OpenSANDConf::DataComponent> current,
 			continue;
 		}
 
-		std::string id((char *)(child->name));
-		auto element = current->getItem(id);
+		std::shared_ptr<OpenSANDConf::DataElement> element = nullptr;
+		if(next != items.end() && xmlStrcmp(child->name, BAD_CAST (*next)->getId().c_str()) == 0)
+		{
+			element = *next;
+		}
+		else
+		{
+			std::string id((char *)(child->name));
+			next = std::find_if(items.begin(), items.end(),
+			                    [&id](const std::shared_ptr<OpenSANDConf::DataElement> &item) { return item->getId() == id; });
+			element = next != items.end() ? *next : nullptr;
+		}
 		if(element == nullptr)
 		{
 			return false;
@@ -1249,6 +1264,7 @@ bool loadComponentFromXML(std::shared_ptr<OpenSANDConf::DataComponent> current,
 		{
 			return false;
 		}
+		++next;
 	}
 	return true;
 }
@@ -82,6 +82,37 @@ namespace OpenSANDConf
 	 * @return The new generated datamodel from XML on success, nullptr otherwise
 	 */
   std::shared_ptr<DataModel> fromXML(std::shared_ptr<MetaModel> model, const std::string &filepath);
+
+	/**
+	 * @brief Write a datamodel in a compiled cache, keyed on the content
+	 *        of its source XML file and on the structure of its model.
+	 *
+	 * @param  datamodel  The datamodel to write
+	 * @param  model      The model which the datamodel matches to
+	 * @param  source     The XML file the datamodel was read from
+	 * @param  folder     The cache folder
+	 *
+	 * @return True on success, false otherwise
+	 */
+	bool toCache(std::shared_ptr<DataModel> datamodel,
+	             std::shared_ptr<MetaModel> model,
+	             const std::string &source,
+	             const std::string &folder);
+
+	/**
+	 * @brief Read a datamodel from a compiled cache instead of its XML file,
+	 *        without parsing nor validating it again.
+	 *
+	 * @param  model   The model which the new datamodel will match to
+	 * @param  source  The XML file the datamodel is read from
+	 * @param  folder  The cache folder
+	 *
+	 * @return The datamodel on success, nullptr if the cache has no
+	 *         valid entry for this XML file and model
+	 */
+	std::shared_ptr<DataModel> fromCache(std::shared_ptr<MetaModel> model,
+	                                     const std::string &source,
+	                                     const std::string &folder);
 }
 
 #endif // OPENSAND_CONF_CONFIGURATION_HPP
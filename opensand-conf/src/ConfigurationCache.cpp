@@ -0,0 +1,375 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 Viveris Technologies
+ * Copyright © 2020 TAS
+ * Copyright © 2020 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file ConfigurationCache.cpp
+ * @brief Functions to store DataModel into a compiled cache.
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "Configuration.h"
+#include "MetaTypesList.h"
+#include "MetaParameter.h"
+#include "MetaList.h"
+#include "DataParameter.h"
+#include "DataList.h"
+
+
+namespace
+{
+
+/// The header of a cache file, followed by its records
+struct CacheHeader
+{
+	char magic[4];
+	uint32_t format;
+	uint64_t source_hash;
+	uint64_t model_hash;
+	uint64_t records;
+};
+
+constexpr char cache_magic[4] = {'O', 'S', 'C', 'C'};
+/// The version of the records layout, bumped on each change
+constexpr uint32_t cache_format = 1;
+
+/// A list record gives the number of items of the list, it comes before
+/// the items records; a parameter record gives the parameter value
+constexpr uint8_t list_record = 'L';
+constexpr uint8_t parameter_record = 'P';
+
+
+uint64_t hashBytes(uint64_t hash, const void *data, std::size_t length)
+{
+	// FNV-1a
+	auto bytes = static_cast<const unsigned char *>(data);
+	for(std::size_t index = 0; index < length; ++index)
+	{
+		hash ^= bytes[index];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+uint64_t hashString(uint64_t hash, const std::string &value)
+{
+	hash = hashBytes(hash, value.data(), value.size());
+	return hashBytes(hash, "", 1);
+}
+
+uint64_t hashMetaElement(uint64_t hash, std::shared_ptr<OpenSANDConf::MetaElement> element)
+{
+	hash = hashString(hash, element->getPath());
+
+	auto parameter = std::dynamic_pointer_cast<OpenSANDConf::MetaParameter>(element);
+	if(parameter != nullptr)
+	{
+		return hashString(hash, parameter->getType()->getId());
+	}
+	auto list = std::dynamic_pointer_cast<OpenSANDConf::MetaList>(element);
+	if(list != nullptr)
+	{
+		return hashMetaElement(hash, list->getPattern());
+	}
+	auto component = std::dynamic_pointer_cast<OpenSANDConf::MetaComponent>(element);
+	if(component != nullptr)
+	{
+		for(auto &item : component->getItems())
+		{
+			hash = hashMetaElement(hash, item);
+		}
+	}
+	return hash;
+}
+
+/**
+ * @brief Hash the structure of a model: its version, enumerations
+ *        and elements, so that a cache is not used for another model
+ */
+uint64_t hashModel(std::shared_ptr<OpenSANDConf::MetaModel> model)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	hash = hashString(hash, model->getVersion());
+	for(auto &type : model->getTypesDefinition()->getEnumTypes())
+	{
+		hash = hashString(hash, type->getId());
+		for(auto &value : type->getValues())
+		{
+			hash = hashString(hash, value);
+		}
+	}
+	return hashMetaElement(hash, model->getRoot());
+}
+
+bool hashFile(const std::string &filepath, uint64_t &hash)
+{
+	std::ifstream ifs(filepath, std::ios::binary);
+	if(!ifs)
+	{
+		return false;
+	}
+	std::vector<char> content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+	if(ifs.bad())
+	{
+		return false;
+	}
+	hash = hashBytes(14695981039346656037ULL, content.data(), content.size());
+	return true;
+}
+
+std::string getCachePath(const std::string &folder, uint64_t source_hash, uint64_t model_hash)
+{
+	char name[40];
+	snprintf(name, sizeof(name), "%016llx-%016llx.cache",
+	         (unsigned long long)source_hash, (unsigned long long)model_hash);
+	return folder + "/" + name;
+}
+
+void appendRecord(std::string &blob, uint8_t kind, const std::string &path, uint32_t value_length)
+{
+	uint32_t path_length = path.size();
+	blob.push_back(kind);
+	blob.append(reinterpret_cast<const char *>(&path_length), sizeof(path_length));
+	blob.append(path);
+	blob.append(reinterpret_cast<const char *>(&value_length), sizeof(value_length));
+}
+
+void appendElement(std::string &blob, uint64_t &records, std::shared_ptr<OpenSANDConf::DataElement> element)
+{
+	auto parameter = std::dynamic_pointer_cast<OpenSANDConf::DataParameter>(element);
+	if(parameter != nullptr)
+	{
+		auto data = parameter->getData();
+		if(data->isSet())
+		{
+			std::string value = data->toString();
+			appendRecord(blob, parameter_record, parameter->getPath(), value.size());
+			blob.append(value);
+			++records;
+		}
+		return;
+	}
+	auto list = std::dynamic_pointer_cast<OpenSANDConf::DataList>(element);
+	if(list != nullptr)
+	{
+		if(!list->getItems().empty())
+		{
+			appendRecord(blob, list_record, list->getPath(), list->getItems().size());
+			++records;
+		}
+		for(auto &item : list->getItems())
+		{
+			appendElement(blob, records, item);
+		}
+		return;
+	}
+	auto component = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(element);
+	if(component != nullptr)
+	{
+		for(auto &item : component->getItems())
+		{
+			appendElement(blob, records, item);
+		}
+	}
+}
+
+/**
+ * @brief Read the next field of a record, checking the cache bounds
+ */
+bool readField(const char *&cursor, const char *end, void *field, std::size_t length)
+{
+	if(static_cast<std::size_t>(end - cursor) < length)
+	{
+		return false;
+	}
+	memcpy(field, cursor, length);
+	cursor += length;
+	return true;
+}
+
+bool loadRecords(std::shared_ptr<OpenSANDConf::DataModel> datamodel,
+                 const char *cursor, const char *end, uint64_t records)
+{
+	for(uint64_t record = 0; record < records; ++record)
+	{
+		uint8_t kind;
+		uint32_t path_length;
+		uint32_t value_length;
+		if(!readField(cursor, end, &kind, sizeof(kind)) ||
+		   !readField(cursor, end, &path_length, sizeof(path_length)) ||
+		   static_cast<std::size_t>(end - cursor) < path_length)
+		{
+			return false;
+		}
+		std::string path(cursor, path_length);
+		cursor += path_length;
+		if(!readField(cursor, end, &value_length, sizeof(value_length)))
+		{
+			return false;
+		}
+
+		auto element = datamodel->getItemByPath(path);
+		if(kind == list_record)
+		{
+			auto list = std::dynamic_pointer_cast<OpenSANDConf::DataList>(element);
+			if(list == nullptr)
+			{
+				return false;
+			}
+			for(uint32_t index = 0; index < value_length; ++index)
+			{
+				if(list->addItem() == nullptr)
+				{
+					return false;
+				}
+			}
+		}
+		else if(kind == parameter_record)
+		{
+			auto parameter = std::dynamic_pointer_cast<OpenSANDConf::DataParameter>(element);
+			if(parameter == nullptr || static_cast<std::size_t>(end - cursor) < value_length)
+			{
+				return false;
+			}
+			if(!parameter->getData()->fromString(std::string(cursor, value_length)))
+			{
+				return false;
+			}
+			cursor += value_length;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return cursor == end;
+}
+
+}
+
+
+bool OpenSANDConf::toCache(std::shared_ptr<OpenSANDConf::DataModel> datamodel,
+                           std::shared_ptr<OpenSANDConf::MetaModel> model,
+                           const std::string &source,
+                           const std::string &folder)
+{
+	CacheHeader header;
+	memcpy(header.magic, cache_magic, sizeof(header.magic));
+	header.format = cache_format;
+	if(!hashFile(source, header.source_hash))
+	{
+		return false;
+	}
+	header.model_hash = hashModel(model);
+	header.records = 0;
+
+	std::string blob(sizeof(header), '\0');
+	appendElement(blob, header.records, datamodel->getRoot());
+	memcpy(&blob[0], &header, sizeof(header));
+
+	// the cache is written aside then renamed for the processes
+	// reading it concurrently
+	std::string filepath = getCachePath(folder, header.source_hash, header.model_hash);
+	std::string temporary = filepath + "." + std::to_string(getpid());
+	std::ofstream ofs(temporary, std::ios::binary | std::ios::trunc);
+	if(!ofs)
+	{
+		return false;
+	}
+	ofs.write(blob.data(), blob.size());
+	ofs.close();
+	if(!ofs || rename(temporary.c_str(), filepath.c_str()) != 0)
+	{
+		remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+std::shared_ptr<OpenSANDConf::DataModel> OpenSANDConf::fromCache(std::shared_ptr<OpenSANDConf::MetaModel> model,
+                                                                 const std::string &source,
+                                                                 const std::string &folder)
+{
+	uint64_t source_hash;
+	if(!hashFile(source, source_hash))
+	{
+		return nullptr;
+	}
+	uint64_t model_hash = hashModel(model);
+
+	int fd = open(getCachePath(folder, source_hash, model_hash).c_str(), O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+	{
+		return nullptr;
+	}
+	struct stat info;
+	if(fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(CacheHeader))
+	{
+		close(fd);
+		return nullptr;
+	}
+	// the pages are shared by all the processes reading the cache
+	std::size_t length = info.st_size;
+	void *blob = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(blob == MAP_FAILED)
+	{
+		return nullptr;
+	}
+
+	CacheHeader header;
+	const char *begin = static_cast<const char *>(blob);
+	memcpy(&header, begin, sizeof(header));
+	std::shared_ptr<DataModel> datamodel;
+	if(memcmp(header.magic, cache_magic, sizeof(header.magic)) == 0 &&
+	   header.format == cache_format &&
+	   header.source_hash == source_hash &&
+	   header.model_hash == model_hash)
+	{
+		datamodel = model->createData();
+		if(datamodel != nullptr &&
+		   !loadRecords(datamodel, begin + sizeof(header), begin + length, header.records))
+		{
+			datamodel = nullptr;
+		}
+	}
+
+	munmap(blob, length);
+	return datamodel;
+}
@@ -37,36 +37,44 @@
 #include "DataContainer.h"
 
 
+std::atomic<unsigned long> OpenSANDConf::DataContainer::revision{0};
+
+// Below this number of items, a linear search is faster than hashing
+static constexpr std::size_t indexed_items = 8;
+
 OpenSANDConf::DataContainer::DataContainer(const std::string &id, const std::string &parent):
 	DataElement(id, parent),
-	items()
+	items(),
+	items_index()
 {
 }
 
 OpenSANDConf::DataContainer::DataContainer(const OpenSANDConf::DataContainer &other, std::shared_ptr<OpenSANDConf::DataTypesList> types):
 	DataElement(other),
-	items()
+	items(),
+	items_index()
 {
 	for(auto item: other.items)
 	{
 		auto copy = std::dynamic_pointer_cast<DataElement>(item->clone(types));
 		if(copy != nullptr)
 		{
-			this->items.push_back(copy);
+			this->addItem(copy);
 		}
 	}
 }
 
 OpenSANDConf::DataContainer::DataContainer(const std::string &id, const std::string &parent, const OpenSANDConf::DataContainer &other):
 	DataElement(id, parent),
-	items()
+	items(),
+	items_index()
 {
 	for(auto item: other.items)
 	{
 		auto copy = std::dynamic_pointer_cast<DataElement>(item->duplicate(item->getId(), this->getPath()));
 		if(copy != nullptr)
 		{
-			this->items.push_back(copy);
+			this->addItem(copy);
 		}
 	}
 }
@@ -115,21 +123,45 @@ const std::vector<std::shared_ptr<OpenSANDConf::DataElement>> &OpenSANDConf::Dat
 	return this->items;
 }
 
-std::shared_ptr<OpenSANDConf::DataElement> OpenSANDConf::DataContainer::getItem(std::string id) const
+std::shared_ptr<OpenSANDConf::DataElement> OpenSANDConf::DataContainer::getItem(const std::string &id) const
 {
-	auto elt = std::find_if(this->items.begin(), this->items.end(),
-		[id](std::shared_ptr<DataElement> elt) { return elt->getId() == id; });
-	return elt != this->items.end() ? *elt : nullptr;
+	if(this->items_index.empty())
+	{
+		auto elt = std::find_if(this->items.begin(), this->items.end(),
+			[&id](const std::shared_ptr<DataElement> &elt) { return elt->getId() == id; });
+		return elt != this->items.end() ? *elt : nullptr;
+	}
+	auto elt = this->items_index.find(id);
+	return elt != this->items_index.end() ? this->items[elt->second] : nullptr;
 }
 
 void OpenSANDConf::DataContainer::addItem(std::shared_ptr<OpenSANDConf::DataElement> item)
 {
+	++revision;
 	this->items.push_back(item);
+	if(this->items.size() < indexed_items)
+	{
+		return;
+	}
+	// keep the first item on duplicated identifiers as the linear search did
+	if(this->items_index.empty())
+	{
+		for(std::size_t i = 0; i < this->items.size(); ++i)
+		{
+			this->items_index.emplace(this->items[i]->getId(), i);
+		}
+	}
+	else
+	{
+		this->items_index.emplace(item->getId(), this->items.size() - 1);
+	}
 }
 
 void OpenSANDConf::DataContainer::clearItems()
 {
 	this->items.clear();
+	this->items_index.clear();
+	++revision;
 }
 
 bool OpenSANDConf::DataContainer::equal(const OpenSANDConf::DataElement &other) const
@@ -34,8 +34,10 @@
 #ifndef OPENSAND_CONF_DATA_CONTAINER_H
 #define OPENSAND_CONF_DATA_CONTAINER_H
 
+#include <atomic>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "DataElement.h"
@@ -142,7 +144,7 @@ class DataContainer: public DataElement
 	 *
 	 * @return  The item if found, nullptr otherwise
 	 */
-	virtual std::shared_ptr<DataElement> getItem(std::string id) const;
+	virtual std::shared_ptr<DataElement> getItem(const std::string &id) const;
 
 	/**
 	 * @brief Add an item.
@@ -158,6 +160,12 @@ class DataContainer: public DataElement
 
  private:
 	std::vector<std::shared_ptr<DataElement>> items;
+	/// The position of the items by identifier, for large containers only
+	std::unordered_map<std::string, std::size_t> items_index;
+
+	/// Incremented each time items are added to or removed from any
+	/// container, so that resolved paths can be checked as still valid
+	static std::atomic<unsigned long> revision;
 };
 
 }
@@ -31,7 +31,6 @@
  * @brief Base class of all datamodel elements.
  */
 
-#include <sstream>
 
 #include "DataElement.h"
 #include "DataTypesList.h"
@@ -40,6 +39,7 @@
 #include "DataComponent.h"
 #include "Data.h"
 #include "DataContainer.h"
+#include "Path.h"
 
 
 std::shared_ptr<OpenSANDConf::DataElement> OpenSANDConf::DataElement::getItemFromRoot(std::shared_ptr<OpenSANDConf::DataElement> root, const std::string &path, bool meta)
@@ -48,19 +48,15 @@ std::shared_ptr<OpenSANDConf::DataElement> OpenSANDConf::DataElement::getItemFro
   std::shared_ptr<OpenSANDConf::DataContainer> cont;
 
   std::string item;
-  std::stringstream ss(path);
+  std::size_t pos = 0;
 
 	if(path.empty())
 	{
 		return nullptr;
 	}
-       	elt = root;
-        while(elt != nullptr && std::getline(ss, item, '/'))
-        {
-		if(item.empty())
-		{
-			continue;
-		}
+	elt = root;
+	while(elt != nullptr && nextPathId(path, pos, item))
+	{
 		cont = std::dynamic_pointer_cast<OpenSANDConf::DataContainer>(elt);
 		if(cont == nullptr)
 		{
@@ -79,13 +75,13 @@ std::shared_ptr<OpenSANDConf::DataElement> OpenSANDConf::DataElement::getItemFro
 			continue;
 		}
 		elt = cont->getItem(item);
-        }
+	}
 	return elt;
 }
 
 OpenSANDConf::DataElement::DataElement(const std::string &id, const std::string &parent):
 	OpenSANDConf::BaseElement(id),
-	parent(parent)
+	parent(std::make_shared<const std::string>(parent))
 {
 	this->reference = std::make_tuple<std::shared_ptr<const OpenSANDConf::DataParameter>, std::shared_ptr<OpenSANDConf::Data>>(nullptr, nullptr);
 }
@@ -151,15 +147,23 @@ bool OpenSANDConf::DataElement::checkReference() const
 
 const std::string &OpenSANDConf::DataElement::getParentPath() const
 {
-	return this->parent;
+	return *(this->parent);
 }
 
 std::string OpenSANDConf::DataElement::getPath() const
 {
-	std::stringstream ss;
-	ss << this->parent << "/" << this->getId();
+	const std::string &id = this->getId();
 	// check root case
-	return ss.str() != "/" ? ss.str() : "";
+	if(this->parent->empty() && id.empty())
+	{
+		return "";
+	}
+	std::string path;
+	path.reserve(this->parent->size() + 1 + id.size());
+	path += *(this->parent);
+	path += "/";
+	path += id;
+	return path;
 }
 
 void OpenSANDConf::DataElement::setReference(std::shared_ptr<const OpenSANDConf::DataParameter> target)
@@ -205,7 +209,7 @@ bool OpenSANDConf::DataElement::equal(const OpenSANDConf::DataElement &other) co
 		return false;
 	}
 	return this->getId() == other.getId()
-		&& this->parent == other.parent;
+		&& *(this->parent) == *(other.parent);
 }
 
 bool OpenSANDConf::operator== (const OpenSANDConf::DataElement &v1, const OpenSANDConf::DataElement &v2)
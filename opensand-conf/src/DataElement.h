@@ -182,7 +182,9 @@ class DataElement: public BaseElement
 	const std::string &getParentPath() const;
 
  private:
-	std::string parent;
+	/// The parent path, shared by the clones of the element
+	/// as it never changes once the element is created
+	std::shared_ptr<const std::string> parent;
 	std::tuple<std::shared_ptr<const DataParameter>, std::shared_ptr<Data>> reference;
 
 	/**
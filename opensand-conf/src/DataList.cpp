@@ -48,7 +48,9 @@ OpenSANDConf::DataList::DataList(
 		std::shared_ptr<DataTypesList> types):
 	OpenSANDConf::DataContainer(id, parent),
 	pattern(pattern),
-	types(types)
+	types(types),
+	pattern_references(),
+	pattern_references_found(false)
 {
 }
 
@@ -57,14 +59,18 @@ OpenSANDConf::DataList::DataList(
 		std::shared_ptr<DataTypesList> types):
 	OpenSANDConf::DataContainer(other, types),
 	pattern(std::static_pointer_cast<OpenSANDConf::DataComponent>(other.pattern->clone(types))),
-	types(types)
+	types(types),
+	pattern_references(),
+	pattern_references_found(false)
 {
 }
 
 OpenSANDConf::DataList::DataList(const std::string &id, const std::string &parent, const DataList &other):
 	OpenSANDConf::DataContainer(id, parent, other),
 	pattern(nullptr),
-	types(other.types)
+	types(other.types),
+	pattern_references(),
+	pattern_references_found(false)
 {
 	this->pattern = std::static_pointer_cast<OpenSANDConf::DataComponent>(other.pattern->duplicate(other.pattern->getId(), this->getPath()));
 }
@@ -78,15 +84,15 @@ std::shared_ptr<OpenSANDConf::DataComponent> OpenSANDConf::DataList::getPattern(
 	return this->pattern;
 }
 
-std::shared_ptr<OpenSANDConf::DataComponent> OpenSANDConf::DataList::addItem()
+const std::vector<OpenSANDConf::DataList::pattern_reference_t> &OpenSANDConf::DataList::getPatternReferences()
 {
-	std::stringstream ss;
-	ss << this->getItems().size();
-	auto item = std::static_pointer_cast<OpenSANDConf::DataComponent>(this->pattern->duplicate(ss.str(), this->getPath()));
+	if(this->pattern_references_found)
+	{
+		return this->pattern_references;
+	}
 
 	// Get pattern references
 	std::queue<std::shared_ptr<DataElement>> queue;
-	std::vector<std::shared_ptr<DataElement>> referenced;
 	queue.push(this->pattern);
 	while(!queue.empty())
 	{
@@ -100,7 +106,11 @@ std::shared_ptr<OpenSANDConf::DataComponent> OpenSANDConf::DataList::addItem()
 			auto remaining_ids = splitPath(getRelativePath(common_path, target->getPath()));
 			if(common_path == this->getPath() && remaining_ids.front() == "*")
 			{
-				referenced.push_back(elt);
+				pattern_reference_t ref;
+				ref.element_path = getRelativePath(this->getPath() + "/*", elt->getPath());
+				ref.target_path = getRelativePath(this->getPath() + "/*", target->getPath());
+				ref.expected = elt->getReferenceData();
+				this->pattern_references.push_back(ref);
 			}
 		}
 		auto cont = std::dynamic_pointer_cast<DataContainer>(elt);
@@ -119,28 +129,33 @@ std::shared_ptr<OpenSANDConf::DataComponent> OpenSANDConf::DataList::addItem()
 		}
 		queue.push(lst->getPattern());
 	}
+	this->pattern_references_found = true;
+	return this->pattern_references;
+}
+
+std::shared_ptr<OpenSANDConf::DataComponent> OpenSANDConf::DataList::addItem()
+{
+	std::stringstream ss;
+	ss << this->getItems().size();
+	auto item = std::static_pointer_cast<OpenSANDConf::DataComponent>(this->pattern->duplicate(ss.str(), this->getPath()));
 
 	// Update item references
-	for(auto elt: referenced)
+	for(auto &ref: this->getPatternReferences())
 	{
-		auto elt_path = getRelativePath(this->getPath() + "/*", elt->getPath());
-		auto pattern_target = elt->getReferenceTarget();
-		auto pattern_expected = elt->getReferenceData();
-		auto item_elt = OpenSANDConf::DataElement::getItemFromRoot(item, elt_path, true);
+		auto item_elt = OpenSANDConf::DataElement::getItemFromRoot(item, ref.element_path, true);
 		if (item_elt == nullptr)
 		{
 			return nullptr;
 		}
 
-		auto target_path = getRelativePath(this->getPath() + "/*", pattern_target->getPath());
-		auto item_target = std::dynamic_pointer_cast<DataParameter>(OpenSANDConf::DataElement::getItemFromRoot(item, target_path, true));
+		auto item_target = std::dynamic_pointer_cast<DataParameter>(OpenSANDConf::DataElement::getItemFromRoot(item, ref.target_path, true));
 		if(item_target == nullptr)
 		{
 			return nullptr;
 		}
 		item_elt->setReference(item_target);
 		auto item_expected = item_elt->getReferenceData();
-		if(!item_expected->copy(pattern_expected))
+		if(!item_expected->copy(ref.expected))
 		{
 			return nullptr;
 		}
@@ -38,6 +38,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "DataContainer.h"
 
@@ -136,6 +137,24 @@ class DataList: public DataContainer
 	*/
 	std::shared_ptr<DataComponent> getPattern() const;
 
+	/**
+	 * @brief A reference of the pattern to reproduce in each item
+	 */
+	struct pattern_reference_t
+	{
+		std::string element_path;            ///< The referencing element, relative to the item
+		std::string target_path;             ///< The referenced parameter, relative to the item
+		std::shared_ptr<Data> expected;      ///< The expected value of the reference
+	};
+
+	/**
+	* @brief Get the pattern references targetting the pattern itself,
+	*        found once for all the items of the list.
+	*
+	* @return  The pattern references
+	*/
+	const std::vector<pattern_reference_t> &getPatternReferences();
+
  public:
 	/**
 	 * @brief Compare to another element
@@ -149,6 +168,8 @@ class DataList: public DataContainer
  private:
 	std::shared_ptr<DataComponent> pattern;
 	std::shared_ptr<DataTypesList> types;
+	std::vector<pattern_reference_t> pattern_references;
+	bool pattern_references_found;
 };
 
 }
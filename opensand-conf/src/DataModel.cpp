@@ -32,7 +32,10 @@
  * @brief Represents a metamodel.
  */
 
+#include <algorithm>
+#include <future>
 #include <queue>
+#include <thread>
 
 #include "DataModel.h"
 #include "DataTypesList.h"
@@ -42,16 +45,23 @@
 OpenSANDConf::DataModel::DataModel(const std::string &version, std::shared_ptr<OpenSANDConf::DataTypesList> types, std::shared_ptr<OpenSANDConf::DataComponent> root):
 	version(version),
 	types(types),
-	root(root)
+	root(root),
+	resolved(),
+	resolved_revision(0),
+	resolved_mutex()
 {
 }
 
 OpenSANDConf::DataModel::DataModel(const OpenSANDConf::DataModel &other):
 	version(other.version),
-	types(nullptr),
-	root(nullptr)
+	types(other.types),
+	root(nullptr),
+	resolved(),
+	resolved_revision(0),
+	resolved_mutex()
 {
-	this->types = other.types->clone();
+	// the types are not modified once the datamodel is created,
+	// the clones share them and only copy the elements and values
 	this->root = std::static_pointer_cast<OpenSANDConf::DataComponent>(other.root->clone(this->types));
 }
 
@@ -64,52 +74,55 @@ std::shared_ptr<OpenSANDConf::DataModel> OpenSANDConf::DataModel::clone() const
 	// Copy data
 	auto clone = std::shared_ptr<OpenSANDConf::DataModel>(new OpenSANDConf::DataModel(*this));
 
-	// Find references
-	std::queue<std::shared_ptr<DataElement>> queue;
-  std::vector<std::shared_ptr<DataElement>> referenced;
-	queue.push(this->root);
+	// Match the elements of both models, their trees have the same shape
+	std::queue<std::pair<std::shared_ptr<DataElement>, std::shared_ptr<DataElement>>> queue;
+	std::vector<std::pair<std::shared_ptr<DataElement>, std::shared_ptr<DataElement>>> referenced;
+	queue.push({this->root, clone->root});
 	while(!queue.empty())
 	{
 		// Check element has a reference
 		auto elt = queue.front();
 		queue.pop();
-		if(elt->getReferenceTarget() != nullptr)
+		if(elt.first->getReferenceTarget() != nullptr)
 		{
 			referenced.push_back(elt);
 		}
-		auto cont = std::dynamic_pointer_cast<DataContainer>(elt);
+		auto cont = std::dynamic_pointer_cast<DataContainer>(elt.first);
 		if(cont == nullptr)
 		{
 			continue;
 		}
+		auto clone_cont = std::static_pointer_cast<DataContainer>(elt.second);
 		auto lst = std::dynamic_pointer_cast<DataList>(cont);
 		if(lst != nullptr)
 		{
-			queue.push(lst->getPattern());
+			auto clone_lst = std::static_pointer_cast<DataList>(clone_cont);
+			queue.push({lst->getPattern(), clone_lst->getPattern()});
 		}
-		for(auto elt2: cont->getItems())
+		const auto &items = cont->getItems();
+		const auto &clone_items = clone_cont->getItems();
+		if(items.size() != clone_items.size())
 		{
-			queue.push(elt2);
+			return nullptr;
+		}
+		for(std::size_t i = 0; i < items.size(); ++i)
+		{
+			queue.push({items[i], clone_items[i]});
 		}
 	}
 
 	// Copy reference
 	for(auto elt: referenced)
 	{
-		auto target = elt->getReferenceTarget();
-		auto data = elt->getReferenceData();
-		auto clone_elt = OpenSANDConf::DataElement::getItemFromRoot(clone->root, elt->getPath(), true);
-		if(clone_elt == nullptr)
-		{
-			return nullptr;
-		}
+		auto target = elt.first->getReferenceTarget();
+		auto data = elt.first->getReferenceData();
 		auto clone_target = std::dynamic_pointer_cast<DataParameter>(OpenSANDConf::DataElement::getItemFromRoot(clone->root, target->getPath(), true));
 		if(clone_target == nullptr)
 		{
 			return nullptr;
 		}
-		clone_elt->setReference(clone_target);
-		auto clone_data = clone_elt->getReferenceData();
+		elt.second->setReference(clone_target);
+		auto clone_data = elt.second->getReferenceData();
 		if(!clone_data->copy(data))
 		{
 			return nullptr;
@@ -121,7 +134,75 @@ std::shared_ptr<OpenSANDConf::DataModel> OpenSANDConf::DataModel::clone() const
 
 bool OpenSANDConf::DataModel::validate() const
 {
-	return this->root->validate();
+	// Below this number of subtrees, spawning threads costs more than it saves
+	const std::size_t min_subtrees = 64;
+	std::size_t workers = std::thread::hardware_concurrency();
+
+	// Expand the containers level by level until there are enough
+	// independent subtrees to feed the workers; a container whose
+	// reference is not fulfilled is disabled and valid with its items
+	std::vector<std::shared_ptr<DataElement>> subtrees = {this->root};
+	bool expanded = true;
+	while(expanded && subtrees.size() < 4 * workers)
+	{
+		std::vector<std::shared_ptr<DataElement>> next;
+		expanded = false;
+		for(auto &elt: subtrees)
+		{
+			auto cont = std::dynamic_pointer_cast<DataContainer>(elt);
+			if(cont == nullptr)
+			{
+				next.push_back(elt);
+				continue;
+			}
+			expanded = true;
+			if(!cont->checkReference())
+			{
+				continue;
+			}
+			next.insert(next.end(), cont->getItems().begin(), cont->getItems().end());
+		}
+		subtrees.swap(next);
+	}
+	if(workers < 2 || subtrees.size() < min_subtrees)
+	{
+		for(auto &elt: subtrees)
+		{
+			if(!elt->validate())
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Validate contiguous slices of subtrees, the result does not depend
+	// on the order in which they complete
+	auto validateSlice = [&subtrees](std::size_t begin, std::size_t end)
+	{
+		for(std::size_t i = begin; i < end; ++i)
+		{
+			if(!subtrees[i]->validate())
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+	workers = std::min(workers, subtrees.size() / (min_subtrees / 4));
+	std::vector<std::future<bool>> slices;
+	std::size_t step = (subtrees.size() + workers - 1) / workers;
+	for(std::size_t begin = step; begin < subtrees.size(); begin += step)
+	{
+		slices.push_back(std::async(std::launch::async, validateSlice,
+		                            begin, std::min(begin + step, subtrees.size())));
+	}
+	bool valid = validateSlice(0, step);
+	for(auto &slice: slices)
+	{
+		valid = slice.get() && valid;
+	}
+	return valid;
 }
 
 bool OpenSANDConf::DataModel::equal(const OpenSANDConf::DataModel &other) const
@@ -143,12 +224,43 @@ std::shared_ptr<OpenSANDConf::DataComponent> OpenSANDConf::DataModel::getRoot()
 
 std::shared_ptr<OpenSANDConf::DataElement> OpenSANDConf::DataModel::getItemByPath(const std::string &path) const
 {
-	return OpenSANDConf::DataElement::getItemFromRoot(this->root, path, false);
+	return this->getCachedItem(path, false);
 }
 
 std::shared_ptr<OpenSANDConf::DataElement> OpenSANDConf::DataModel::getItemByMetaPath(const std::string &path) const
 {
-	return OpenSANDConf::DataElement::getItemFromRoot(this->root, path, true);
+	return this->getCachedItem(path, true);
+}
+
+std::shared_ptr<OpenSANDConf::DataElement> OpenSANDConf::DataModel::getCachedItem(const std::string &path, bool meta) const
+{
+	std::lock_guard<std::mutex> lock(this->resolved_mutex);
+
+	// any item added or removed may change what a path resolves to
+	unsigned long revision = OpenSANDConf::DataContainer::revision;
+	if(revision != this->resolved_revision)
+	{
+		this->resolved[0].clear();
+		this->resolved[1].clear();
+		this->resolved_revision = revision;
+	}
+
+	auto &cache = this->resolved[meta ? 1 : 0];
+	auto found = cache.find(path);
+	if(found != cache.end())
+	{
+		auto elt = found->second.lock();
+		if(elt != nullptr)
+		{
+			return elt;
+		}
+	}
+	auto elt = OpenSANDConf::DataElement::getItemFromRoot(this->root, path, meta);
+	if(elt != nullptr)
+	{
+		cache[path] = elt;
+	}
+	return elt;
 }
 
 bool OpenSANDConf::operator== (const OpenSANDConf::DataModel &v1, const OpenSANDConf::DataModel &v2)
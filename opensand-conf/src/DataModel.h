@@ -36,7 +36,9 @@
 #define OPENSAND_CONF_DATA_MODEL_H
 
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 #include "DataTypesList.h"
 #include "DataType.h"
@@ -81,6 +83,8 @@ class DataModel
 
 	/**
 	 * @brief Validate the datamodel.
+	 *        Large models are split in subtrees validated concurrently,
+	 *        the datamodel must not be modified meanwhile.
 	 *
 	 * @return True if the datamodel is valid, false otherwise
 	 */
@@ -141,9 +145,26 @@ class DataModel
 	std::shared_ptr<DataElement> getItemByMetaPath(const std::string &path) const;
 
  private:
+	/**
+	 * @brief Get an item by path, from the resolved paths when the
+	 *        containers were not modified since they were resolved.
+	 *
+	 * @param  path  The item's path
+	 * @param  meta  Whether the path is a metamodel path
+	 *
+	 * @return  The item if found, nullptr otherwise
+	 */
+	std::shared_ptr<DataElement> getCachedItem(const std::string &path, bool meta) const;
+
 	std::string version;
 	std::shared_ptr<DataTypesList> types;
 	std::shared_ptr<DataComponent> root;
+
+	/// The items resolved by path and by metamodel path
+	mutable std::unordered_map<std::string, std::weak_ptr<DataElement>> resolved[2];
+	/// The containers revision the resolved items are valid for
+	mutable unsigned long resolved_revision;
+	mutable std::mutex resolved_mutex;
 };
 
 bool operator== (const DataModel &v1, const DataModel &v2);
@@ -38,6 +38,9 @@
 #include "DataContainer.h"
 
 
+// Below this number of items, a linear search is faster than hashing
+static constexpr std::size_t indexed_items = 8;
+
 OpenSANDConf::MetaContainer::MetaContainer(
 		const std::string &id,
 		const std::string &parent,
@@ -46,7 +49,8 @@ OpenSANDConf::MetaContainer::MetaContainer(
 		std::weak_ptr<const MetaTypesList> types):
 	MetaElement(id, parent, name, description),
 	types(types),
-	items()
+	items(),
+	items_index()
 {
 }
 
@@ -55,14 +59,15 @@ OpenSANDConf::MetaContainer::MetaContainer(
 		std::weak_ptr<const MetaTypesList> types):
 	MetaElement(other),
 	types(types),
-	items()
+	items(),
+	items_index()
 {
 	for(auto item: other.items)
 	{
 		auto copy = std::dynamic_pointer_cast<MetaElement>(item->clone(types));
 		if(copy != nullptr)
 		{
-			this->items.push_back(copy);
+			this->addItem(copy);
 		}
 	}
 }
@@ -83,14 +88,35 @@ const std::vector<std::shared_ptr<OpenSANDConf::MetaElement>> &OpenSANDConf::Met
 
 std::shared_ptr<OpenSANDConf::MetaElement> OpenSANDConf::MetaContainer::getItem(const std::string &id) const
 {
-	auto elt = std::find_if(this->items.begin(), this->items.end(),
-		[id](std::shared_ptr<MetaElement> elt) { return elt->getId() == id; });
-	return elt != this->items.end() ? *elt : nullptr;
+	if(this->items_index.empty())
+	{
+		auto elt = std::find_if(this->items.begin(), this->items.end(),
+			[&id](const std::shared_ptr<MetaElement> &elt) { return elt->getId() == id; });
+		return elt != this->items.end() ? *elt : nullptr;
+	}
+	auto elt = this->items_index.find(id);
+	return elt != this->items_index.end() ? this->items[elt->second] : nullptr;
 }
 
 void OpenSANDConf::MetaContainer::addItem(std::shared_ptr<OpenSANDConf::MetaElement> item)
 {
 	this->items.push_back(item);
+	if(this->items.size() < indexed_items)
+	{
+		return;
+	}
+	// keep the first item on duplicated identifiers as the linear search did
+	if(this->items_index.empty())
+	{
+		for(std::size_t i = 0; i < this->items.size(); ++i)
+		{
+			this->items_index.emplace(this->items[i]->getId(), i);
+		}
+	}
+	else
+	{
+		this->items_index.emplace(item->getId(), this->items.size() - 1);
+	}
 }
 
 void OpenSANDConf::MetaContainer::createAndAddDataItems(
@@ -37,6 +37,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "MetaElement.h"
@@ -145,6 +146,8 @@ namespace OpenSANDConf
 	private:
     std::weak_ptr<const MetaTypesList> types;
     std::vector<std::shared_ptr<MetaElement>> items;
+		/// The position of the items by identifier, for large containers only
+		std::unordered_map<std::string, std::size_t> items_index;
 	};
 }
 
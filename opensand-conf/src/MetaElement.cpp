@@ -41,6 +41,7 @@
 #include "DataType.h"
 #include "Data.h"
 #include "MetaContainer.h"
+#include "Path.h"
 
 
 std::shared_ptr<OpenSANDConf::MetaElement> OpenSANDConf::MetaElement::getItemFromRoot(std::shared_ptr<OpenSANDConf::MetaElement> root, const std::string &path)
@@ -49,19 +50,15 @@ std::shared_ptr<OpenSANDConf::MetaElement> OpenSANDConf::MetaElement::getItemFro
   std::shared_ptr<OpenSANDConf::MetaContainer> cont;
 
   std::string item;
-  std::stringstream ss(path);
+  std::size_t pos = 0;
 
 	if(path.empty())
 	{
 		return nullptr;
 	}
 	elt = root;
-	while(elt != nullptr && std::getline(ss, item, '/'))
+	while(elt != nullptr && nextPathId(path, pos, item))
 	{
-		if(item.empty())
-		{
-			continue;
-		}
 		cont = std::dynamic_pointer_cast<OpenSANDConf::MetaContainer>(elt);
 		if(cont == nullptr)
 		{
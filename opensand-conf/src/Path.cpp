@@ -32,37 +32,27 @@
  * @brief Provides util functions to handle path.
  */
 
-#include <sstream>
-
 #include "Path.h"
 
 
 std::vector<std::string> OpenSANDConf::splitPath(const std::string &path, const char &separator)
 {
-  std::string item;
-  std::vector<std::string> split;
-        std::stringstream ss(path);
+	std::string item;
+	std::vector<std::string> split;
+	std::size_t pos = 0;
 
-	if(path.empty())
+	while(nextPathId(path, pos, item, separator))
 	{
-		return split;
+		split.push_back(item);
 	}
-        while(std::getline(ss, item, separator))
-        {
-		if(!item.empty())
-		{
-			split.push_back(item);
-		}
-        }
 	return split;
 }
 
 std::string OpenSANDConf::getCommonPath(const std::string &path1, const std::string &path2, const char &separator)
 {
-	bool equal;
-	unsigned int i, n;
-  std::vector<std::string> split1, split2;
-	std::stringstream ss;
+	std::string item1, item2;
+	std::string common;
+	std::size_t pos1 = 0, pos2 = 0;
 
 	// Check equality
 	if(path1 == path2)
@@ -70,20 +60,16 @@ std::string OpenSANDConf::getCommonPath(const std::string &path1, const std::str
 		return path1;
 	}
 
-	// Split paths
-	split1 = splitPath(path1, separator);
-	split2 = splitPath(path2, separator);
-	n = split1.size() <= split2.size() ? split1.size() : split2.size();
-	
 	// Get greater common path between element and target
-	equal = true;
-	i = 0;
-	while(equal && i < n && split1[i] == split2[i])
+	common.reserve(path1.size() <= path2.size() ? path1.size() : path2.size());
+	while(nextPathId(path1, pos1, item1, separator)
+	      && nextPathId(path2, pos2, item2, separator)
+	      && item1 == item2)
 	{
-		ss << "/" << split1[i];
-		++i;
+		common += "/";
+		common += item1;
 	}
-	return ss.str();
+	return common;
 }
 
 std::string OpenSANDConf::getRelativePath(const std::string &parentpath, const std::string &path, const char &separator)
@@ -109,3 +95,23 @@ bool OpenSANDConf::checkPathId(const std::string &id, const char &separator)
 {
 	return id.find(separator) == std::string::npos;
 }
+
+bool OpenSANDConf::nextPathId(const std::string &path, std::size_t &pos, std::string &id, const char &separator)
+{
+	while(pos < path.size() && path[pos] == separator)
+	{
+		++pos;
+	}
+	if(pos >= path.size())
+	{
+		return false;
+	}
+	auto end = path.find(separator, pos);
+	if(end == std::string::npos)
+	{
+		end = path.size();
+	}
+	id.assign(path, pos, end - pos);
+	pos = end;
+	return true;
+}
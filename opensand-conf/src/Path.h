@@ -82,6 +82,20 @@ namespace OpenSANDConf
 	 * @return True if the string is a valid path id, False otherwise
 	 */
 	bool checkPathId(const std::string &id, const char &separator='/');
+
+	/**
+	 * @brief Read the next id of a path, using a specific separator.
+	 *        The id buffer is reused so that walking a path does not
+	 *        allocate once its capacity fits the longest id.
+	 *
+	 * @param  path       The path to read
+	 * @param  pos        IN/OUT: the position to start from, set after the id read
+	 * @param  id         OUT: the id read
+	 * @param  separator  The separator to use
+	 *
+	 * @return True if an id was read, False at the end of the path
+	 */
+	bool nextPathId(const std::string &path, std::size_t &pos, std::string &id, const char &separator='/');
 }
 
 #endif // OPENSAND_CONF_PATH_H
@@ -46,6 +46,264 @@ using std::shared_ptr;
 using std::string;
 using std::vector;
 
+/**
+ * @brief Release the Python interpreter lock while a long call
+ *        does not use any Python object
+ */
+class GILRelease
+{
+ public:
+	GILRelease(): state(PyEval_SaveThread()) {}
+	~GILRelease() { PyEval_RestoreThread(this->state); }
+
+ private:
+	PyThreadState *state;
+};
+
+static bool validateModel(const DataModel &datamodel)
+{
+	GILRelease release;
+	return datamodel.validate();
+}
+
+static bool toXSDFile(shared_ptr<MetaModel> model, const string &filepath)
+{
+	GILRelease release;
+	return toXSD(model, filepath);
+}
+
+static shared_ptr<MetaModel> fromXSDFile(const string &filepath)
+{
+	GILRelease release;
+	return fromXSD(filepath);
+}
+
+static bool toXMLFile(shared_ptr<DataModel> datamodel, const string &filepath)
+{
+	GILRelease release;
+	return toXML(datamodel, filepath);
+}
+
+static shared_ptr<DataModel> fromXMLFile(shared_ptr<MetaModel> model, const string &filepath)
+{
+	GILRelease release;
+	return fromXML(model, filepath);
+}
+
+/**
+ * @brief Get the value of a data as a native Python object
+ *
+ * @param data  The data
+ * @return the value, None if it is not set
+ */
+template <typename T>
+static bool valueToPython(shared_ptr<Data> data, boost::python::object &value)
+{
+	auto typed = std::dynamic_pointer_cast<DataValue<T>>(data);
+	if(typed == nullptr)
+	{
+		return false;
+	}
+	value = boost::python::object(typed->get());
+	return true;
+}
+
+static boost::python::object dataToPython(shared_ptr<Data> data)
+{
+	boost::python::object value;
+	if(data == nullptr || !data->isSet())
+	{
+		return value;
+	}
+	if(valueToPython<bool>(data, value) ||
+	   valueToPython<double>(data, value) ||
+	   valueToPython<float>(data, value) ||
+	   valueToPython<int>(data, value) ||
+	   valueToPython<short>(data, value) ||
+	   valueToPython<long>(data, value) ||
+	   valueToPython<string>(data, value))
+	{
+		return value;
+	}
+	return boost::python::object(data->toString());
+}
+
+/**
+ * @brief Set the value of a data from a native Python object
+ *
+ * @param data   The data
+ * @param value  The value, None resets the data
+ * @param set    OUT: whether the value was accepted by the data type
+ * @return true if the data has the type T, false otherwise
+ */
+template <typename T>
+static bool valueFromPython(shared_ptr<Data> data, boost::python::object value, bool &set)
+{
+	auto typed = std::dynamic_pointer_cast<DataValue<T>>(data);
+	if(typed == nullptr)
+	{
+		return false;
+	}
+	boost::python::extract<T> extracted(value);
+	set = extracted.check() && typed->set(extracted());
+	return true;
+}
+
+static bool dataFromPython(shared_ptr<Data> data, boost::python::object value)
+{
+	if(value.is_none())
+	{
+		data->reset();
+		return true;
+	}
+	bool set = false;
+	if(valueFromPython<bool>(data, value, set) ||
+	   valueFromPython<double>(data, value, set) ||
+	   valueFromPython<float>(data, value, set) ||
+	   valueFromPython<int>(data, value, set) ||
+	   valueFromPython<short>(data, value, set) ||
+	   valueFromPython<long>(data, value, set) ||
+	   valueFromPython<string>(data, value, set))
+	{
+		return set;
+	}
+	return false;
+}
+
+static boost::python::object elementToPython(shared_ptr<DataElement> element);
+
+/**
+ * @brief Export a component subtree in one call
+ *
+ * @param component  The component
+ * @return a dict of the component items by identifier: the parameter
+ *         values, dicts for components and lists of dicts for lists
+ */
+static boost::python::dict componentToDict(shared_ptr<DataComponent> component)
+{
+	boost::python::dict items;
+	for(auto &item : component->getItems())
+	{
+		items[item->getId()] = elementToPython(item);
+	}
+	return items;
+}
+
+/**
+ * @brief Export the items of a list in one call
+ *
+ * @param list  The list
+ * @return a list of dicts, one per item
+ */
+static boost::python::list listToList(shared_ptr<DataList> list)
+{
+	boost::python::list items;
+	for(auto &item : list->getItems())
+	{
+		items.append(elementToPython(item));
+	}
+	return items;
+}
+
+static boost::python::object elementToPython(shared_ptr<DataElement> element)
+{
+	auto parameter = std::dynamic_pointer_cast<DataParameter>(element);
+	if(parameter != nullptr)
+	{
+		return dataToPython(parameter->getData());
+	}
+	auto component = std::dynamic_pointer_cast<DataComponent>(element);
+	if(component != nullptr)
+	{
+		return componentToDict(component);
+	}
+	auto list = std::dynamic_pointer_cast<DataList>(element);
+	if(list != nullptr)
+	{
+		return listToList(list);
+	}
+	return boost::python::object();
+}
+
+static bool addListItems(shared_ptr<DataList> list, boost::python::object items);
+
+/**
+ * @brief Populate a component subtree in one call
+ *
+ * Every entry is applied even if a previous one failed.
+ *
+ * @param component  The component
+ * @param values     A dict of values by item identifier: the parameter
+ *                   values, dicts for components and sequences of dicts
+ *                   replacing the items of lists
+ * @return true if all the entries were applied, false otherwise
+ */
+static bool populateComponent(shared_ptr<DataComponent> component, boost::python::dict values)
+{
+	bool success = true;
+	boost::python::list entries = values.items();
+	for(boost::python::ssize_t index = 0; index < boost::python::len(entries); ++index)
+	{
+		boost::python::object entry = entries[index];
+		boost::python::extract<string> id(entry[0]);
+		boost::python::object value = entry[1];
+		if(!id.check())
+		{
+			success = false;
+			continue;
+		}
+
+		auto item = component->getItem(id());
+		auto parameter = std::dynamic_pointer_cast<DataParameter>(item);
+		auto subcomponent = std::dynamic_pointer_cast<DataComponent>(item);
+		auto list = std::dynamic_pointer_cast<DataList>(item);
+		if(parameter != nullptr)
+		{
+			success &= dataFromPython(parameter->getData(), value);
+		}
+		else if(subcomponent != nullptr)
+		{
+			boost::python::extract<boost::python::dict> subvalues(value);
+			success &= subvalues.check() && populateComponent(subcomponent, subvalues());
+		}
+		else if(list != nullptr)
+		{
+			list->clearItems();
+			success &= addListItems(list, value);
+		}
+		else
+		{
+			success = false;
+		}
+	}
+	return success;
+}
+
+/**
+ * @brief Create and populate list items in one call
+ *
+ * @param list   The list
+ * @param items  A sequence of dicts, one per new item
+ * @return true if all the items were created and populated, false otherwise
+ */
+static bool addListItems(shared_ptr<DataList> list, boost::python::object items)
+{
+	bool success = true;
+	boost::python::stl_input_iterator<boost::python::object> begin(items), end;
+	for(auto it = begin; it != end; ++it)
+	{
+		boost::python::extract<boost::python::dict> values(*it);
+		if(!values.check())
+		{
+			success = false;
+			continue;
+		}
+		auto item = list->addItem();
+		success &= item != nullptr && populateComponent(item, values());
+	}
+	return success;
+}
+
 struct iterable_converter
 {
 	template <typename Container>
@@ -296,7 +554,9 @@ BOOST_PYTHON_MODULE(py_opensand_conf)
 		.def("get_items", &DataList::getItems, python::return_value_policy<python::return_by_value>())
 		.def("get_item", &DataList::getItem)
 		.def("add_item", &DataList::addItem)
+		.def("add_items", &addListItems)
 		.def("clear_items", &DataList::clearItems)
+		.def("to_list", &listToList)
 	;
 
 	python::class_<DataComponent, shared_ptr<DataComponent>, python::bases<DataElement>, boost::noncopyable>("DataComponent", python::no_init)
@@ -305,19 +565,21 @@ BOOST_PYTHON_MODULE(py_opensand_conf)
 		.def("get_parameter", &DataComponent::getParameter)
 		.def("get_list", &DataComponent::getList)
 		.def("get_component", &DataComponent::getComponent)
+		.def("populate", &populateComponent)
+		.def("to_dict", &componentToDict)
 	;
 
 	python::class_<DataModel, shared_ptr<DataModel>>("DataModel", python::no_init)
 		.def("get_version", &DataModel::getVersion, python::return_value_policy<python::return_by_value>())
 		.def("get_root", &DataModel::getRoot)
 		.def("get_item_by_path", &DataModel::getItemByPath)
-		.def("validate", &DataModel::validate)
+		.def("validate", &validateModel)
 		.def("clone", &DataModel::clone)
 	;
 
-	python::def("toXSD", toXSD);
-	python::def("fromXSD", fromXSD);
+	python::def("toXSD", toXSDFile);
+	python::def("fromXSD", fromXSDFile);
 
-	python::def("toXML", toXML);
-	python::def("fromXML", fromXML);
+	python::def("toXML", toXMLFile);
+	python::def("fromXML", fromXMLFile);
 }
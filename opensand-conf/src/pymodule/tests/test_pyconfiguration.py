@@ -993,6 +993,84 @@ class ModelDataTests(unittest.TestCase):
         self.assertTrue(datamodel2.validate())
 
 
+class ModelBulkTests(unittest.TestCase):
+    def setUp(self):
+        self.version = "1.2.3"
+        self.model = OpenSandConf.MetaModel(self.version)
+        types = self.model.get_types_definition()
+        self.assertIsNotNone(types.add_enum_type("e", "Enum", ["val1", "val2"]))
+        root = self.model.get_root()
+        self.assertIsNotNone(root.add_parameter("name", "Name", types.get_type("string")))
+        cpt = root.add_component("c", "Component")
+        self.assertIsNotNone(cpt)
+        self.assertIsNotNone(cpt.add_parameter("ratio", "Ratio", types.get_type("double")))
+        self.assertIsNotNone(cpt.add_parameter("kind", "Kind", types.get_type("e")))
+        lst = root.add_list("l", "List", "Item")
+        self.assertIsNotNone(lst)
+        self.assertIsNotNone(lst.get_pattern().add_parameter("id", "Id", types.get_type("int")))
+        self.assertIsNotNone(lst.get_pattern().add_parameter("enabled", "Enabled", types.get_type("bool")))
+        self.datamodel = self.model.create_data()
+        self.assertIsNotNone(self.datamodel)
+
+    def test_add_items(self):
+        lst = self.datamodel.get_root().get_list("l")
+        self.assertTrue(lst.add_items([{"id": i, "enabled": i % 2 == 0} for i in range(100)]))
+        self.assertEqual(len(lst.get_items()), 100)
+        self.assertEqual(lst.get_item("42").get_parameter("id").get_data().get(), 42)
+        self.assertTrue(lst.get_item("42").get_parameter("enabled").get_data().get())
+        self.assertFalse(lst.get_item("43").get_parameter("enabled").get_data().get())
+
+        # the valid entries are applied even when another one fails
+        self.assertFalse(lst.add_items([{"id": 100, "unknown": 1}, {"id": "wrong"}, 3]))
+        self.assertEqual(len(lst.get_items()), 102)
+        self.assertEqual(lst.get_item("100").get_parameter("id").get_data().get(), 100)
+        self.assertFalse(lst.get_item("101").get_parameter("id").get_data().is_set())
+
+    def test_populate(self):
+        root = self.datamodel.get_root()
+        self.assertFalse(self.datamodel.validate())
+        self.assertTrue(root.populate({
+            "name": "platform",
+            "c": {"ratio": 0.5, "kind": "val2"},
+            "l": [{"id": 1, "enabled": True}, {"id": 2, "enabled": False}],
+        }))
+        self.assertTrue(self.datamodel.validate())
+        self.assertEqual(root.get_parameter("name").get_data().get(), "platform")
+        self.assertEqual(root.get_component("c").get_parameter("ratio").get_data().get(), 0.5)
+        self.assertEqual(root.get_component("c").get_parameter("kind").get_data().get(), "val2")
+        self.assertEqual(len(root.get_list("l").get_items()), 2)
+
+        # lists are replaced, None resets a parameter
+        self.assertTrue(root.populate({"l": [{"id": 3, "enabled": True}], "name": None}))
+        self.assertEqual(len(root.get_list("l").get_items()), 1)
+        self.assertFalse(root.get_parameter("name").get_data().is_set())
+
+        # enum values are checked
+        self.assertFalse(root.populate({"c": {"kind": "val3"}}))
+        self.assertEqual(root.get_component("c").get_parameter("kind").get_data().get(), "val2")
+
+    def test_to_dict(self):
+        root = self.datamodel.get_root()
+        self.assertEqual(root.to_dict(), {
+            "name": None,
+            "c": {"ratio": None, "kind": None},
+            "l": [],
+        })
+        values = {
+            "name": "platform",
+            "c": {"ratio": 0.25, "kind": "val1"},
+            "l": [{"id": i, "enabled": i % 3 == 0} for i in range(10)],
+        }
+        self.assertTrue(root.populate(values))
+        self.assertEqual(root.to_dict(), values)
+        self.assertEqual(root.get_list("l").to_list(), values["l"])
+
+        # the export is a copy of the data model
+        exported = root.to_dict()
+        exported["c"]["ratio"] = 2.0
+        self.assertEqual(root.get_component("c").get_parameter("ratio").get_data().get(), 0.25)
+
+
 class ModelReferenceTestsVariousTypes(unittest.TestCase):
     def setUp(self):
         self.version = "1.2.3"
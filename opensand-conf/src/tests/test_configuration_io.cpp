@@ -29,6 +29,8 @@ using OpenSANDConf::toXSD;
 using OpenSANDConf::fromXSD;
 using OpenSANDConf::toXML;
 using OpenSANDConf::fromXML;
+using OpenSANDConf::toCache;
+using OpenSANDConf::fromCache;
 
 std::string readFile(const std::string &filepath);
 
@@ -238,6 +240,32 @@ TEST_CASE("Model read/write from/to file", "[Model][Read/Write]")
 		auto content2 = readFile(path2);
 		REQUIRE(content == content2);
 	}
+
+	SECTION("Read/Write data model cache")
+	{
+		std::string path = "my_cachedmodel.xml";
+		std::string path2 = "my_cachedmodel2.xml";
+		remove(path.c_str());
+		remove(path2.c_str());
+		REQUIRE(toXML(datamodel, path) == true);
+
+		// Test writing datamodel to cache
+		REQUIRE(toCache(datamodel, model, path, ".") == true);
+
+		// Test reading datamodel from cache
+		auto datamodel2 = fromCache(model, path, ".");
+		REQUIRE(datamodel2 != nullptr);
+		REQUIRE(toXML(datamodel2, path2) == true);
+		auto content = readFile(path);
+		auto content2 = readFile(path2);
+		REQUIRE(content == content2);
+
+		// Test the cache is not used once the source changed
+		std::ofstream ofs(path, std::ios::app);
+		ofs << std::endl;
+		ofs.close();
+		REQUIRE(fromCache(model, path, ".") == nullptr);
+	}
 }
 
 std::string readFile(const std::string &filepath)
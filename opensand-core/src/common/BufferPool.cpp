@@ -0,0 +1,310 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file BufferPool.cpp
+ * @brief Per-thread pool of fixed-size blocks used for packets and their data
+ * @author Viveris Technologies
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include <opensand_rt/RtMemory.h>
+
+#include "BufferPool.h"
+
+
+namespace
+{
+
+/// The payload size of each block class: small objects,
+/// MTU-sized packets, BBFrame-sized payloads and jumbo frames
+constexpr std::size_t size_classes[] = {64, 256, 2048, 8192, 9216};
+constexpr std::size_t nb_classes = sizeof(size_classes) / sizeof(size_classes[0]);
+
+/// The size of the slabs carved into blocks when a cache is empty,
+/// a huge page for the threads whose memory uses them
+constexpr std::size_t slab_size = 256 * 1024;
+
+/// The minimum number of blocks carved from a slab
+constexpr std::size_t min_slab_blocks = 16;
+
+
+struct ThreadCache;
+
+
+/**
+ * @brief The header preceding every block, it keeps the payload
+ *        aligned for any type
+ */
+struct alignas(alignof(std::max_align_t)) BlockHeader
+{
+	union
+	{
+		/// The cache owning an allocated block, nullptr for large blocks
+		ThreadCache *owner;
+		/// The next block of a free list
+		BlockHeader *next;
+	};
+	/// The block size class, nb_classes for large blocks
+	std::size_t size_class;
+};
+
+
+/**
+ * @brief A counter only written by its owner thread and read by anyone
+ */
+class Counter
+{
+ public:
+	Counter(): value{0} {};
+
+	void increment()
+	{
+		this->value.store(this->value.load(std::memory_order_relaxed) + 1,
+		                  std::memory_order_relaxed);
+	};
+
+	uint64_t get() const
+	{
+		return this->value.load(std::memory_order_relaxed);
+	};
+
+ private:
+	std::atomic<uint64_t> value;
+};
+
+
+/**
+ * @brief The free blocks and counters of a thread
+ */
+struct ThreadCache
+{
+	ThreadCache()
+	{
+		for(std::size_t index = 0; index < nb_classes; ++index)
+		{
+			this->local[index] = nullptr;
+			this->remote[index].store(nullptr, std::memory_order_relaxed);
+		}
+	};
+
+	/// The blocks freed by the owner thread
+	BlockHeader *local[nb_classes];
+	/// The blocks freed by the other threads
+	std::atomic<BlockHeader *> remote[nb_classes];
+
+	Counter allocations;
+	Counter slab_allocations;
+	Counter remote_frees;
+	Counter large_allocations;
+};
+
+
+/// The caches of all the threads, for statistics
+struct Registry
+{
+	std::mutex mutex;
+	std::vector<ThreadCache *> caches;
+};
+
+
+Registry &getRegistry()
+{
+	static Registry registry;
+	return registry;
+}
+
+
+/**
+ * @brief Get the cache of the calling thread, creating it if needed
+ *
+ * @return the cache, nullptr if it cannot be created
+ */
+ThreadCache *getCache()
+{
+	static thread_local ThreadCache *cache = nullptr;
+	if(cache == nullptr)
+	{
+		cache = new (std::nothrow) ThreadCache();
+		if(cache == nullptr)
+		{
+			return nullptr;
+		}
+		Registry &registry = getRegistry();
+		std::lock_guard<std::mutex> lock{registry.mutex};
+		registry.caches.push_back(cache);
+	}
+	return cache;
+}
+
+
+/**
+ * @brief Get a list of free blocks for an empty cache, the blocks
+ *        freed by other threads are reused before carving a new slab
+ *
+ * @param cache       The empty cache
+ * @param size_class  The class of the requested blocks
+ * @return the list of free blocks, nullptr if the system is out of memory
+ */
+BlockHeader *refill(ThreadCache *cache, std::size_t size_class)
+{
+	BlockHeader *head = cache->remote[size_class].exchange(nullptr, std::memory_order_acquire);
+	if(head != nullptr)
+	{
+		return head;
+	}
+
+	std::size_t block_size = sizeof(BlockHeader) + size_classes[size_class];
+	// the slab is placed on the memory of the thread channel
+	std::size_t size = RtMemory::hasHugePages() ? RtMemory::huge_page_size : slab_size;
+	std::size_t count = std::max(size / block_size, min_slab_blocks);
+	char *slab = static_cast<char *>(RtMemory::allocate(count * block_size));
+	if(slab == nullptr)
+	{
+		return nullptr;
+	}
+	cache->slab_allocations.increment();
+
+	// slabs are never given back to the system
+	for(std::size_t index = count; index-- > 0;)
+	{
+		BlockHeader *block = reinterpret_cast<BlockHeader *>(slab + index * block_size);
+		block->size_class = size_class;
+		block->next = head;
+		head = block;
+	}
+	return head;
+}
+
+}
+
+
+void *BufferPool::allocate(std::size_t size)
+{
+	ThreadCache *cache = getCache();
+	if(cache == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	std::size_t size_class = 0;
+	while(size_class < nb_classes && size_classes[size_class] < size)
+	{
+		size_class++;
+	}
+
+	if(size_class == nb_classes)
+	{
+		auto block = static_cast<BlockHeader *>(std::malloc(sizeof(BlockHeader) + size));
+		if(block == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+		block->owner = nullptr;
+		block->size_class = nb_classes;
+		cache->large_allocations.increment();
+		return block + 1;
+	}
+
+	BlockHeader *block = cache->local[size_class];
+	if(block == nullptr)
+	{
+		block = refill(cache, size_class);
+		if(block == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+	}
+	cache->local[size_class] = block->next;
+	block->owner = cache;
+	cache->allocations.increment();
+	return block + 1;
+}
+
+
+void BufferPool::release(void *ptr) noexcept
+{
+	if(ptr == nullptr)
+	{
+		return;
+	}
+
+	BlockHeader *block = static_cast<BlockHeader *>(ptr) - 1;
+	std::size_t size_class = block->size_class;
+	if(size_class >= nb_classes)
+	{
+		std::free(block);
+		return;
+	}
+
+	ThreadCache *owner = block->owner;
+	ThreadCache *cache = getCache();
+	if(owner == cache)
+	{
+		block->next = cache->local[size_class];
+		cache->local[size_class] = block;
+		return;
+	}
+
+	if(cache != nullptr)
+	{
+		cache->remote_frees.increment();
+	}
+	std::atomic<BlockHeader *> &remote = owner->remote[size_class];
+	BlockHeader *head = remote.load(std::memory_order_relaxed);
+	do
+	{
+		block->next = head;
+	}
+	while(!remote.compare_exchange_weak(head, block,
+	                                    std::memory_order_release,
+	                                    std::memory_order_relaxed));
+}
+
+
+BufferPool::Statistics BufferPool::getStatistics()
+{
+	Statistics stats{0, 0, 0, 0};
+	Registry &registry = getRegistry();
+	std::lock_guard<std::mutex> lock{registry.mutex};
+	for(const ThreadCache *cache: registry.caches)
+	{
+		stats.allocations += cache->allocations.get();
+		stats.slab_allocations += cache->slab_allocations.get();
+		stats.remote_frees += cache->remote_frees.get();
+		stats.large_allocations += cache->large_allocations.get();
+	}
+	return stats;
+}
@@ -0,0 +1,140 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file BufferPool.h
+ * @brief Per-thread pool of fixed-size blocks used for packets and their data
+ * @author Viveris Technologies
+ */
+
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+
+/**
+ * @class BufferPool
+ * @brief Per-thread pool of fixed-size blocks
+ *
+ * Each thread owns a cache of free blocks for a few size classes
+ * (small objects, MTU-sized packets, BBFrame-sized payloads and jumbo frames),
+ * refilled from large slabs when empty. The slabs are mapped on the
+ * NUMA nodes of the thread channel, in huge pages if its placement
+ * asks so (see RtMemory). A block freed by its owner
+ * goes back to the local cache; a block freed by another thread is
+ * pushed on the owner remote-free list, which the owner drains on
+ * its next refill. Requests bigger than the largest class are
+ * forwarded to the system allocator.
+ *
+ * Caches are never destroyed as blocks may outlive the thread
+ * that allocated them.
+ */
+class BufferPool
+{
+ public:
+	/// Allocation counters summed over all the threads
+	struct Statistics
+	{
+		/// Blocks handed out by the pool
+		uint64_t allocations;
+		/// Slabs requested to the system to refill a cache
+		uint64_t slab_allocations;
+		/// Blocks released by another thread than their owner
+		uint64_t remote_frees;
+		/// Requests too big for the pool, forwarded to the system
+		uint64_t large_allocations;
+	};
+
+	/**
+	 * @brief Allocate a block from the calling thread cache
+	 *
+	 * @param size  The number of bytes requested
+	 * @return the allocated block, throws std::bad_alloc on failure
+	 */
+	static void *allocate(std::size_t size);
+
+	/**
+	 * @brief Release a block allocated by any thread
+	 *
+	 * @param ptr  The block to release, may be nullptr
+	 */
+	static void release(void *ptr) noexcept;
+
+	/**
+	 * @brief Get the allocation counters of all the threads
+	 *
+	 * @return the counters
+	 */
+	static Statistics getStatistics();
+};
+
+
+/**
+ * @class PoolAllocator
+ * @brief Standard allocator drawing its memory from the BufferPool
+ */
+template<class T>
+struct PoolAllocator
+{
+	using value_type = T;
+
+	PoolAllocator() noexcept = default;
+
+	template<class U>
+	PoolAllocator(const PoolAllocator<U> &) noexcept {};
+
+	T *allocate(std::size_t n)
+	{
+		return static_cast<T *>(BufferPool::allocate(n * sizeof(T)));
+	};
+
+	void deallocate(T *ptr, std::size_t) noexcept
+	{
+		BufferPool::release(ptr);
+	};
+};
+
+
+template<class T, class U>
+bool operator ==(const PoolAllocator<T> &, const PoolAllocator<U> &) noexcept
+{
+	return true;
+}
+
+
+template<class T, class U>
+bool operator !=(const PoolAllocator<T> &, const PoolAllocator<U> &) noexcept
+{
+	return false;
+}
+
+
+#endif
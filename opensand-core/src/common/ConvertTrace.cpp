@@ -0,0 +1,77 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file ConvertTrace.cpp
+ * @brief Convert a text trace of the File attenuation and FileDelay
+ *        plugins into the binary format mapped at startup
+ * @author Viveris Technologies
+ */
+
+
+#include "TimeSeries.h"
+
+#include <opensand_output/Output.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+
+int main(int argc, char **argv)
+{
+	if(argc != 3 && argc != 4)
+	{
+		fprintf(stderr, "usage: %s <text trace> <binary trace> [tolerance]\n"
+		                "  the entries given back by the interpolation of their\n"
+		                "  neighbours, within the tolerance (0 by default), are removed\n",
+		        argv[0]);
+		return 1;
+	}
+	double tolerance = argc == 4 ? atof(argv[3]) : 0;
+
+	auto output = Output::Get();
+	output->configureTerminalOutput();
+	auto log = output->registerLog(LEVEL_WARNING, "ConvertTrace");
+	output->finalizeConfiguration();
+
+	TimeSeries trace;
+	if(!trace.load(argv[1], log))
+	{
+		return 1;
+	}
+	std::size_t removed = trace.compact(tolerance);
+	if(!trace.save(argv[2], log))
+	{
+		return 1;
+	}
+
+	printf("%zu entries written in %s, %zu redundant entries removed\n",
+	       trace.size(), argv[2], removed);
+	return 0;
+}
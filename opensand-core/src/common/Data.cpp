@@ -31,34 +31,59 @@
  * @author Didier Barvaux <didier.barvaux@toulouse.viveris.com>
  */
 
+#include <utility>
+
 #include "Data.h"
 
 
-Data::Data(): std::basic_string<unsigned char>()
+Data::Data(): PooledString()
 {
 }
 
 
-Data::Data(std::basic_string<unsigned char> string):
-	std::basic_string<unsigned char>(string)
+Data::Data(const PooledString &string):
+	PooledString(string)
+{
+}
+
+
+Data::Data(PooledString &&string):
+	PooledString(std::move(string))
+{
+}
+
+
+Data::Data(const std::basic_string<unsigned char> &string):
+	PooledString(string.data(), string.size())
 {
 }
 
 
 Data::Data(std::string string):
-	std::basic_string<unsigned char>(reinterpret_cast<const unsigned char *>(string.c_str()),
-	                                 string.size())
+	PooledString(reinterpret_cast<const unsigned char *>(string.c_str()),
+	             string.size())
 {
 }
 
 
 Data::Data(const unsigned char *data, Data::size_type len):
-	std::basic_string<unsigned char>(data, len)
+	PooledString(data, len)
+{
+}
+
+
+Data::Data(const Data &data, Data::size_type pos, Data::size_type len):
+	PooledString(data, pos, len)
 {
 }
 
 
-Data::Data(Data data, Data::size_type pos, Data::size_type len):
-	std::basic_string<unsigned char>(data, pos, len)
+Data::Data(const unsigned char *header, Data::size_type header_len,
+           const Data &payload, Data::size_type reserved):
+	PooledString()
 {
+	this->reserve(header_len + reserved + payload.length());
+	this->append(header, header_len);
+	this->append(reserved, 0);
+	this->append(payload);
 }
@@ -37,12 +37,20 @@
 
 #include <string>
 
+#include "BufferPool.h"
+
+
+/// The string type underlying Data, its buffers come from the BufferPool
+using PooledString = std::basic_string<unsigned char,
+                                       std::char_traits<unsigned char>,
+                                       PoolAllocator<unsigned char>>;
+
 
 /**
  * @class Data
  * @brief A set of data for network packets
  */
-class Data: public std::basic_string<unsigned char>
+class Data: public PooledString
 {
 public:
 	/**
@@ -55,7 +63,21 @@ public:
 	 *
 	 * @param string  the string of unsigned characters
 	 */
-	Data(std::basic_string<unsigned char> string);
+	Data(const PooledString &string);
+
+	/**
+	 * Create a set of data taking the buffer of a string of unsigned characters
+	 *
+	 * @param string  the string of unsigned characters
+	 */
+	Data(PooledString &&string);
+
+	/**
+	 * Create a set of data from a system allocated string of unsigned characters
+	 *
+	 * @param string  the string of unsigned characters
+	 */
+	Data(const std::basic_string<unsigned char> &string);
 
 	/**
 	 * Create a set of data from a string
@@ -79,7 +101,21 @@ public:
 	 * @param pos   the index of first byte to copy from
 	 * @param len   the number of bytes to copy
 	 */
-	Data(Data data, Data::size_type pos, Data::size_type len);
+	Data(const Data &data, Data::size_type pos, Data::size_type len);
+
+	/**
+	 * Create a set of data made of a header followed by a payload,
+	 * the buffer is allocated once at its final size so the header
+	 * does not have to be inserted in front of the payload afterwards
+	 *
+	 * @param header      the header to copy
+	 * @param header_len  the header length
+	 * @param payload     the payload to copy after the header
+	 * @param reserved    the number of zeroed bytes to reserve
+	 *                    between the header and the payload
+	 */
+	Data(const unsigned char *header, Data::size_type header_len,
+	     const Data &payload, Data::size_type reserved = 0);
 };
 
 
@@ -42,8 +42,9 @@
 
 DelayFifo::DelayFifo(vol_pkt_t max_size_pkt):
 	queue(),
+	size_pkt(0),
 	max_size_pkt(max_size_pkt),
-	fifo_mutex()
+	fifo_mutex("delay_fifo")
 {
 }
 
@@ -58,14 +59,14 @@ DelayFifo::~DelayFifo()
 vol_pkt_t DelayFifo::getCurrentSize() const
 {
 	RtLock lock(this->fifo_mutex);
-	return this->queue.size();
+	return this->size_pkt;
 }
 
 bool DelayFifo::setMaxSize(vol_pkt_t max_size_pkt)
 {
 	RtLock lock(this->fifo_mutex);
 	// check if current size is bigger than the new max value
-	if(this->queue.size() > max_size_pkt)
+	if(this->size_pkt > max_size_pkt)
 		return false;
 	this->max_size_pkt = max_size_pkt;
 	return true;
@@ -80,35 +81,48 @@ vol_pkt_t DelayFifo::getMaxSize() const
 clock_t DelayFifo::getTickOut() const
 {
 	RtLock lock(this->fifo_mutex);
-	if(queue.size() > 0)
+	if(this->size_pkt > 0)
 	{
-		return this->queue.front()->getTickOut();
+		return this->queue.begin()->second.front()->getTickOut();
 	}
 	return 0;
 }
 
 std::vector<FifoElement *> DelayFifo::getQueue(void)
 {
-	return this->queue;
+	RtLock lock(this->fifo_mutex);
+	std::vector<FifoElement *> elements;
+	elements.reserve(this->size_pkt);
+	for(auto &&bucket: this->queue)
+	{
+		elements.insert(elements.end(), bucket.second.begin(), bucket.second.end());
+	}
+	return elements;
 }
 
 bool DelayFifo::push(FifoElement *elem)
 {
-	int pos;
 	RtLock lock(this->fifo_mutex);
 
-	if(this->queue.size() >= this->max_size_pkt)
+	if(this->size_pkt >= this->max_size_pkt)
 	{
 		return false;
 	}
 
-	pos = this->getTickOutPosition(elem->getTickOut());
-
-	// insert in correct position
-	if(pos >= 0)
+	// most elements leave after the previous ones, whatever the delay,
+	// a delay decrease only looks for the bucket of the tick out
+	time_t tick_out = elem->getTickOut();
+	auto bucket = this->queue.end();
+	if(this->queue.empty() || this->queue.rbegin()->first < tick_out)
 	{
-		this->queue.insert(this->queue.begin()+pos, elem);
+		bucket = this->queue.emplace_hint(bucket, tick_out, std::deque<FifoElement *>{});
 	}
+	else
+	{
+		bucket = this->queue.try_emplace(tick_out).first;
+	}
+	bucket->second.push_back(elem);
+	this->size_pkt++;
 
 	return true;
 }
@@ -118,9 +132,14 @@ bool DelayFifo::pushFront(FifoElement *elem)
 	RtLock lock(this->fifo_mutex);
 
 	// insert in head of fifo
-	if(this->queue.size() < this->max_size_pkt)
+	if(this->size_pkt < this->max_size_pkt)
 	{
-		this->queue.insert(this->queue.begin(), elem);
+		if(this->queue.empty())
+		{
+			this->queue.try_emplace(elem->getTickOut());
+		}
+		this->queue.begin()->second.push_front(elem);
+		this->size_pkt++;
 		return true;
 	}
 
@@ -132,10 +151,15 @@ bool DelayFifo::pushBack(FifoElement *elem)
 {
 	RtLock lock(this->fifo_mutex);
 
-	// insert in head of fifo
-	if(this->queue.size() < this->max_size_pkt)
+	// insert in tail of fifo
+	if(this->size_pkt < this->max_size_pkt)
 	{
-		this->queue.insert(this->queue.end(), elem);
+		if(this->queue.empty())
+		{
+			this->queue.try_emplace(elem->getTickOut());
+		}
+		this->queue.rbegin()->second.push_back(elem);
+		this->size_pkt++;
 		return true;
 	}
 
@@ -147,15 +171,21 @@ FifoElement *DelayFifo::pop()
 	RtLock lock(this->fifo_mutex);
 	FifoElement *elem;
 
-	if(this->queue.size() <= 0)
+	if(this->size_pkt <= 0)
 	{
 		return NULL;
 	}
 
-	elem = this->queue.front();
+	auto bucket = this->queue.begin();
+	elem = bucket->second.front();
 
-	// remove the packet
-	this->queue.erase(this->queue.begin());
+	// remove the packet, and its bucket once empty
+	bucket->second.pop_front();
+	if(bucket->second.empty())
+	{
+		this->queue.erase(bucket);
+	}
+	this->size_pkt--;
 
 	return elem;
 }
@@ -163,47 +193,14 @@ FifoElement *DelayFifo::pop()
 void DelayFifo::flush()
 {
 	RtLock lock(this->fifo_mutex);
-	std::vector<FifoElement *>::iterator it;
-	for(it = this->queue.begin(); it != this->queue.end(); ++it)
+	for(auto &&bucket: this->queue)
 	{
-		delete *it;
+		for(auto &&elem: bucket.second)
+		{
+			delete elem;
+		}
 	}
 
 	this->queue.clear();
-}
-
-int DelayFifo::getTickOutPosition(time_t time_out)
-{
-	time_t time_elem;
-	int pos = -1;
-	int start = 0;
-	int test = 0;
-	int end = this->queue.size() - 1;
-
-	// Implement a divide and conquer approach
-	// TODO: if this proves too consuming, implement one FIFO for
-	// each SPOT/GW, and always push_back (all elements will
-	// have the same delay, except for those with 0 delay)
-	while(end > start)
-	{
-		test = (end + start)/2;
-		time_elem = this->queue.at(test)->getTickOut();
-		if(time_elem > time_out)
-			end = test;
-		else
-			start = test + 1;
-	}
-	if(end == start)
-	{
-		time_elem = this->queue.at(start)->getTickOut();
-		if(time_elem > time_out)
-			pos = start;
-		else
-			pos = start + 1;
-	}
-	else if(end < 0)
-	{
-		pos = 0;
-	}
-	return pos;
+	this->size_pkt = 0;
 }
@@ -39,6 +39,8 @@
 
 #include <opensand_rt/RtMutex.h>
 
+#include <deque>
+#include <map>
 #include <vector>
 #include <sys/times.h>
 
@@ -91,8 +93,10 @@ public:
 	clock_t getTickOut() const;
 
 	/**
-	 * @brief Add an element at the end of the list
-	 *        (Increments new_size_pkt)
+	 * @brief Add an element in the list according to its tick out,
+	 *        after the elements with the same tick out
+	 *        (constant time if it is not before the last element,
+	 *        logarithmic in the number of tick outs otherwise)
 	 *
 	 * @param elem is the pointer on FifoElement
 	 * @return true on success, false otherwise
@@ -100,7 +104,8 @@ public:
 	bool push(FifoElement *elem);
 
 	/**
-	 * @brief Add an element at the head of the list
+	 * @brief Add an element at the head of the list, with the elements
+	 *        of the first tick out
 	 * @warning This function should be use only to replace a fragment of
 	 *          previously removed data in the fifo
 	 *
@@ -110,7 +115,8 @@ public:
 	bool pushFront(FifoElement *elem);
 
 	/**
-	 * @brief Add an element at the back of the list
+	 * @brief Add an element at the back of the list, with the elements
+	 *        of the last tick out
 	 *
 	 * @param elem is the pointer on FifoElement
 	 * @return true on success, false otherwise
@@ -133,14 +139,14 @@ public:
 	std::vector<FifoElement *> getQueue(void);
 
 protected:
-	/**
-	 * @brief Get the index where time_out should be placed
-	 * @param time_out the tick out 
-	 * @return -1 on error, the index on success
-	 */
-	int getTickOutPosition(time_t time_out);
-
-	std::vector<FifoElement *> queue; ///< the FIFO itself
+	/// the FIFO itself, a bucket per tick out in milliseconds: a push
+	/// before the last element only looks for its bucket instead of
+	/// moving the elements behind it, and the elements with the same
+	/// tick out are kept in their push order
+	std::map<time_t, std::deque<FifoElement *>> queue;
+
+	/// the number of elements in the buckets
+	vol_pkt_t size_pkt;
 
 	vol_pkt_t max_size_pkt;         ///< the maximum size for that FIFO
 
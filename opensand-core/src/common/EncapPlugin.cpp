@@ -40,6 +40,7 @@
 #include <opensand_output/Output.h>
 
 #include <cassert>
+#include <limits>
 
 
 EncapPlugin::EncapPlugin(NET_PROTO ether_type):
@@ -118,21 +119,52 @@ bool EncapPlugin::EncapPacketHandler::encapNextPacket(std::unique_ptr<NetPacket>
 }
 
 
+bool EncapPlugin::EncapPacketHandler::encapNextPacketInto(std::unique_ptr<NetPacket> packet,
+                                                          std::size_t remaining_length,
+                                                          bool new_burst,
+                                                          Data &frame,
+                                                          std::unique_ptr<NetPacket> &remaining_data)
+{
+	std::unique_ptr<NetPacket> encap_packet;
+	if(!this->encapNextPacket(std::move(packet), remaining_length, new_burst,
+	                          encap_packet, remaining_data))
+	{
+		return false;
+	}
+	if(encap_packet)
+	{
+		frame.append(encap_packet->getData());
+	}
+	return true;
+}
+
+
 bool EncapPlugin::EncapPacketHandler::getEncapsulatedPackets(std::unique_ptr<NetContainer> packet,
                                                              bool &partial_decap,
                                                              std::vector<std::unique_ptr<NetPacket>> &decap_packets,
                                                              unsigned int decap_packets_count)
 {
-	std::vector<std::unique_ptr<NetPacket>> packets{};
-	std::size_t previous_length = 0;
-
 	// Set the default returned values
 	partial_decap = false;
+	decap_packets.clear();
+
+	return this->getEncapsulatedPacketsFor(std::move(packet),
+	                                       decap_packets_count,
+	                                       BROADCAST_TAL_ID,
+	                                       decap_packets);
+}
+
+
+bool EncapPlugin::EncapPacketHandler::getEncapsulatedPacketsFor(std::unique_ptr<NetContainer> packet,
+                                                                unsigned int decap_packets_count,
+                                                                tal_id_t dst_tal_id,
+                                                                std::vector<std::unique_ptr<NetPacket>> &decap_packets)
+{
+	std::size_t previous_length = 0;
 
 	// Sanity check
 	if(decap_packets_count <= 0)
 	{
-		decap_packets = std::move(packets);
 		LOG(this->log, LEVEL_INFO,
 			"No packet to decapsulate\n");
 		return true;
@@ -141,24 +173,40 @@ bool EncapPlugin::EncapPacketHandler::getEncapsulatedPackets(std::unique_ptr<Net
 	LOG(this->log, LEVEL_DEBUG,
 		"%u packet(s) to decapsulate\n",
 		decap_packets_count);
-	// auto dst_tal_id = packet->getDstTalId();
+	const unsigned char *payload = packet->getRawData() + packet->getHeaderLength();
+	std::size_t payload_length = packet->getPayloadLength();
 	for(unsigned int i = 0; i < decap_packets_count; ++i)
 	{
 		// Get the current packet length
-		std::size_t current_length = this->getLength(packet->getPayload(previous_length).c_str());
-		if(current_length <= 0)
+		std::size_t current_length = 0;
+		if(previous_length < payload_length)
+		{
+			current_length = this->getLength(payload + previous_length);
+		}
+		if(current_length <= 0 || previous_length + current_length > payload_length)
 		{
 			LOG(this->log, LEVEL_ERROR,
 				"cannot create one %s packet (no data)\n",
-				this->getName().c_str(), current_length);
+				this->getName().c_str());
 			return false;
 		}
 
+		// Skip the packets for another terminal
+		if(dst_tal_id != BROADCAST_TAL_ID &&
+		   this->isForOtherTerminal(payload + previous_length, dst_tal_id))
+		{
+			LOG(this->log, LEVEL_DEBUG,
+			    "skip %s packet for another terminal\n",
+			    this->getName().c_str());
+			previous_length += current_length;
+			continue;
+		}
+
 		// Get the current packet
 		std::unique_ptr<NetPacket> current;
 		try
 		{
-			current = this->build(packet->getPayload(previous_length),
+			current = this->build(Data(payload + previous_length, current_length),
 			                      current_length,
 			                      0x00,
 			                      BROADCAST_TAL_ID,
@@ -173,11 +221,32 @@ bool EncapPlugin::EncapPacketHandler::getEncapsulatedPackets(std::unique_ptr<Net
 		}
 
 		// Add the current packet to decapsulated packets
-		packets.push_back(std::move(current));
+		decap_packets.push_back(std::move(current));
 		previous_length += current_length;
 	}
 
-	// Set returned decapsulated packets
-	decap_packets = std::move(packets);
 	return true;
 }
+
+
+bool EncapPlugin::EncapPacketHandler::getDst(const unsigned char *, tal_id_t &) const
+{
+	return false;
+}
+
+
+std::size_t EncapPlugin::EncapPacketHandler::getMaxPduLength() const
+{
+	return std::numeric_limits<std::size_t>::max();
+}
+
+
+bool EncapPlugin::EncapPacketHandler::isForOtherTerminal(const unsigned char *data, tal_id_t tal_id)
+{
+	tal_id_t dst_tal_id;
+	if(!this->getDst(data, dst_tal_id))
+	{
+		return false;
+	}
+	return dst_tal_id != tal_id && dst_tal_id != BROADCAST_TAL_ID;
+}
@@ -91,6 +91,37 @@ public:
 		 */
 		virtual bool getQos(const Data &data, qos_t &qos) const = 0;
 
+		/**
+		 * @brief Get the destination terminal ID of a packet
+		 *        without building it
+		 *
+		 * @param data    The packet content
+		 * @param tal_id  OUT: the destination terminal ID of the packet
+		 * @return true on success, false if the packet does not
+		 *         carry its destination
+		 */
+		virtual bool getDst(const unsigned char *data, tal_id_t &tal_id) const;
+
+		/**
+		 * @brief Check whether a packet is destined to another terminal
+		 *        without building it
+		 *
+		 * @param data    The packet content
+		 * @param tal_id  The terminal ID
+		 * @return true if the packet can be dropped, false if it is
+		 *         for the terminal, broadcast or of unknown destination
+		 */
+		virtual bool isForOtherTerminal(const unsigned char *data, tal_id_t tal_id);
+
+		/**
+		 * @brief Get the length of the longest upper packet the
+		 *        encapsulation carries
+		 *
+		 * @return the maximum length of the encapsulated packets,
+		 *         the default implementation does not limit them
+		 */
+		virtual std::size_t getMaxPduLength() const;
+
 		virtual bool init();
 
 		/**
@@ -112,6 +143,29 @@ public:
 		                     std::unique_ptr<NetPacket> &encap_packet,
 		                     std::unique_ptr<NetPacket> &remaining_data) override;
 
+		/**
+		 * @brief Encapsulate the next part of a packet straight at the
+		 *        end of a frame buffer, without building an intermediate
+		 *        encapsulation packet
+		 *
+		 * The default implementation appends the packet built by
+		 * encapNextPacket.
+		 *
+		 * @param[in]     packet            The packet to encapsulate
+		 * @param[in]     remaining_length  The remaining length in the frame
+		 * @param[in]     new_burst         The new burst status
+		 * @param[in,out] frame             The frame buffer, the encapsulated
+		 *                                  part is appended to it
+		 * @param[out]    remaining_data    The part of the packet that is
+		 *                                  not encapsulated yet
+		 * @return  true if success, false otherwise
+		 */
+		virtual bool encapNextPacketInto(std::unique_ptr<NetPacket> packet,
+		                                 std::size_t remaining_length,
+		                                 bool new_burst,
+		                                 Data &frame,
+		                                 std::unique_ptr<NetPacket> &remaining_data);
+
 		/**
 		 * @brief Get encapsulated packet from payload
 		 *
@@ -126,6 +180,25 @@ public:
 		                            std::vector<std::unique_ptr<NetPacket>> &decap_packets,
 		                            unsigned int decap_packet_count=0) override;
 
+		/**
+		 * @brief Get the encapsulated packets of a payload destined to a terminal
+		 *
+		 * The packets for other terminals are skipped before being built,
+		 * the others are appended so that the caller can reuse the same
+		 * vector from one frame to the other.
+		 *
+		 * @param[in]  packet              The packet storing payload
+		 * @param[in]  decap_packets_count The packet count to decapsulate
+		 * @param[in]  dst_tal_id          The terminal ID, BROADCAST_TAL_ID
+		 *                                 to keep all the packets
+		 * @param[out] decap_packets       The decapsulated packets
+		 * @return true on success, false otherwise
+		 */
+		virtual bool getEncapsulatedPacketsFor(std::unique_ptr<NetContainer> packet,
+		                                       unsigned int decap_packets_count,
+		                                       tal_id_t dst_tal_id,
+		                                       std::vector<std::unique_ptr<NetPacket>> &decap_packets);
+
 		virtual bool checkPacketForHeaderExtensions(std::unique_ptr<NetPacket> &packet) = 0;
 
 		virtual bool setHeaderExtensions(std::unique_ptr<NetPacket> packet,
@@ -36,6 +36,14 @@
 #include "NetContainer.h"
 
 
+FifoElement::FifoElement():
+	elem{nullptr},
+	tick_in{0},
+	tick_out{0}
+{
+}
+
+
 FifoElement::FifoElement(std::unique_ptr<NetContainer> elem,
                          time_t tick_in, time_t tick_out):
 	elem{std::move(elem)},
@@ -50,6 +58,12 @@ FifoElement::~FifoElement()
 }
 
 
+FifoElement::FifoElement(FifoElement &&) = default;
+
+
+FifoElement &FifoElement::operator=(FifoElement &&) = default;
+
+
 template<>
 std::unique_ptr<NetContainer> FifoElement::getElem()
 {
@@ -37,6 +37,8 @@
 
 #include <memory>
 
+#include <opensand_rt/RtAccounting.h>
+
 #include "OpenSandCore.h"
 
 
@@ -58,7 +60,18 @@ protected:
 	/// The minimal time the packet will output the FIFO (in ms)
 	time_t tick_out;
 
+	/// The count of the live elements of the building channel
+	RtAccounted<FifoElement> accounted;
+
 public:
+	/// The name of the elements in the memory accounting
+	static constexpr const char *accounting_name = "fifo_element";
+
+	/**
+	 * Build an empty fifo element
+	 */
+	FifoElement();
+
 	/**
 	 * Build a fifo element
 	 * @param elem       The element to store in the FIFO
@@ -73,6 +86,9 @@ public:
 	 */
 	~FifoElement();
 
+	FifoElement(FifoElement &&other);
+	FifoElement &operator=(FifoElement &&other);
+
 	/**
 	 * Get the FIFO elelement
 	 * @return The FIFO element
@@ -34,6 +34,7 @@
 #include "LanAdaptationPlugin.h"
 #include "NetBurst.h"
 #include "NetContainer.h"
+#include "NetPacket.h"
 #include "SarpTable.h"
 
 #include <opensand_output/Output.h>
@@ -116,6 +117,27 @@ bool LanAdaptationPlugin::LanAdaptationContext::initLanAdaptationContext(tal_id_
 	return true;
 }
 
+bool LanAdaptationPlugin::LanAdaptationContext::canEncapsulatePacket() const
+{
+	return false;
+}
+
+void LanAdaptationPlugin::LanAdaptationContext::startPackets()
+{
+}
+
+void LanAdaptationPlugin::LanAdaptationContext::encapsulatePacket(std::unique_ptr<NetPacket> &packet)
+{
+	LOG(this->log, LEVEL_ERROR,
+	    "the %s context cannot encapsulate packet by packet, drop the packet\n",
+	    this->getName().c_str());
+	packet.reset();
+}
+
+void LanAdaptationPlugin::LanAdaptationContext::endPackets()
+{
+}
+
 bool LanAdaptationPlugin::LanAdaptationContext::setUpperPacketHandler(StackPlugin::StackPacketHandler *pkt_hdl)
 {
 	if(!pkt_hdl && this->handle_net_packet)
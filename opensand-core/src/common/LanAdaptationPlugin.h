@@ -134,6 +134,34 @@ public:
 		 */
 		virtual bool handleTap() = 0;
 
+		/**
+		 * @brief Check whether the context encapsulates the packets one
+		 *        by one, without holding them, so that it can be fused
+		 *        with the other contexts of the stack in a single pass
+		 *        per packet (see LanAdaptationChain)
+		 *
+		 * @return true if encapsulatePacket is implemented, false otherwise
+		 */
+		virtual bool canEncapsulatePacket() const;
+
+		/**
+		 * @brief Prepare the encapsulation of a burst packet by packet
+		 */
+		virtual void startPackets();
+
+		/**
+		 * @brief Encapsulate a single packet
+		 *
+		 * @param packet  IN/OUT: The packet to encapsulate, replaced by the
+		 *                encapsulated packet or reset if it is dropped
+		 */
+		virtual void encapsulatePacket(std::unique_ptr<NetPacket> &packet);
+
+		/**
+		 * @brief End the encapsulation of a burst packet by packet
+		 */
+		virtual void endPackets();
+
 		bool setUpperPacketHandler(StackPlugin::StackPacketHandler *pkt_hdl);
 
 		virtual bool init();
@@ -114,3 +114,37 @@ bool MacAddress::matches(const MacAddress *addr) const
 	}
 	return true;
 }
+
+
+uint64_t MacAddress::getKey() const
+{
+	return MacAddress::getKey(this->mac) & this->getMask();
+}
+
+
+uint64_t MacAddress::getMask() const
+{
+	uint64_t mask = 0;
+	for(std::size_t i = 0; i < MacAddress::bytes_count; ++i)
+	{
+		mask = (mask << 8) | (this->generic_bytes[i] ? 0x00 : 0xff);
+	}
+	return mask;
+}
+
+
+bool MacAddress::isGeneric() const
+{
+	return this->getMask() != 0xffffffffffff;
+}
+
+
+uint64_t MacAddress::getKey(const unsigned char *bytes)
+{
+	uint64_t key = 0;
+	for(std::size_t i = 0; i < MacAddress::bytes_count; ++i)
+	{
+		key = (key << 8) | bytes[i];
+	}
+	return key;
+}
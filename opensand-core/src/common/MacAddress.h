@@ -108,6 +108,37 @@ public:
 	 * @return true if MAC addresses matches, false otherwise
 	 */
 	bool matches(const MacAddress *addr) const;
+
+	/**
+	 * @brief Get the 48 bits of the MAC address packed in an integer,
+	 *        the first byte being the most significant one
+	 *
+	 * @return the packed MAC address, the generic bytes being set to 0
+	 */
+	uint64_t getKey() const;
+
+	/**
+	 * @brief Get the mask of the bytes that are not generic
+	 *        in the packed MAC address
+	 *
+	 * @return the mask of the significant bits of the packed MAC address
+	 */
+	uint64_t getMask() const;
+
+	/**
+	 * @brief Check whether some bytes of the MAC address match all occurences
+	 *
+	 * @return true if the MAC address matches several addresses, false otherwise
+	 */
+	bool isGeneric() const;
+
+	/**
+	 * @brief Pack the 6 bytes of a MAC address in an integer
+	 *
+	 * @param bytes  The MAC address bytes, as in an Ethernet header
+	 * @return the packed MAC address
+	 */
+	static uint64_t getKey(const unsigned char *bytes);
 };
 
 
@@ -32,7 +32,7 @@
  * @author Didier Barvaux <didier.barvaux@toulouse.viveris.com>
  */
 
-#include <numeric>
+#include <algorithm>
 
 #include <opensand_output/Output.h>
 
@@ -45,9 +45,16 @@ std::shared_ptr<OutputLog> NetBurst::log_net_burst = nullptr;
 
 
 // max_packets = 0 => unlimited length
-NetBurst::NetBurst(unsigned int max_packets): std::list<std::unique_ptr<NetPacket>>()
+NetBurst::NetBurst(unsigned int max_packets):
+	max_packets(max_packets),
+	inline_packets(),
+	heap_packets(),
+	packets(inline_packets.data()),
+	count(0),
+	capacity(inline_capacity),
+	total_bytes(0),
+	bytes_valid(true)
 {
-	this->max_packets = max_packets;
 
 	LOG(log_net_burst, LEVEL_INFO,
 	    "burst created (max length = %d)\n",
@@ -57,7 +64,6 @@ NetBurst::NetBurst(unsigned int max_packets): std::list<std::unique_ptr<NetPacke
 
 NetBurst::~NetBurst()
 {
-	this->clear();
 }
 
 
@@ -106,7 +112,7 @@ bool NetBurst::isFull() const
 
 unsigned int NetBurst::length() const
 {
-	return this->size();
+	return this->count;
 }
 
 
@@ -117,7 +123,10 @@ Data NetBurst::data() const
 	// add the data of each network packet of the burst
 	for(auto&& packet : *this)
 	{
-		data.append(packet->getData());
+		if(packet)
+		{
+			data.append(packet->getData());
+		}
 	}
 
 	return data;
@@ -126,16 +135,25 @@ Data NetBurst::data() const
 
 long NetBurst::bytes() const
 {
-	return std::accumulate(this->begin(), this->end(), 0L,
-	                       [](long length, const std::unique_ptr<NetPacket>& packet){
-	                          return length + packet->getTotalLength();
-	                       });
+	if(!this->bytes_valid)
+	{
+		this->total_bytes = 0;
+		for(auto&& packet : *this)
+		{
+			if(packet)
+			{
+				this->total_bytes += packet->getTotalLength();
+			}
+		}
+		this->bytes_valid = true;
+	}
+	return this->total_bytes;
 }
 
 
 NET_PROTO NetBurst::type() const
 {
-	if(!this->size())
+	if(this->empty())
 	{
 		// no packet in the burst, impossible to get the packet type
 		LOG(log_net_burst, LEVEL_ERROR,
@@ -153,7 +171,7 @@ NET_PROTO NetBurst::type() const
 
 std::string NetBurst::name() const
 {
-	if(!this->size())
+	if(this->empty())
 	{
 		// no packet in the burst, impossible to get the packet name
 		return std::string{"unknown"};
@@ -164,3 +182,103 @@ std::string NetBurst::name() const
 		return this->front()->getName();
 	}
 }
+
+
+void NetBurst::push_back(std::unique_ptr<NetPacket> packet)
+{
+	if(this->count == this->capacity)
+	{
+		this->reserve(2 * this->capacity);
+	}
+	if(this->bytes_valid && packet)
+	{
+		this->total_bytes += packet->getTotalLength();
+	}
+	this->packets[this->count++] = std::move(packet);
+}
+
+
+NetBurst::iterator NetBurst::erase(const_iterator position)
+{
+	return this->erase(position, position + 1);
+}
+
+
+NetBurst::iterator NetBurst::erase(const_iterator first, const_iterator last)
+{
+	iterator start = this->packets + (first - this->packets);
+	iterator stop = this->packets + (last - this->packets);
+	iterator end = this->packets + this->count;
+
+	if(start == stop)
+	{
+		return start;
+	}
+	// the packets may have been moved out of the burst,
+	// the amount of data is computed again
+	this->bytes_valid = false;
+	iterator new_end = std::move(stop, end, start);
+	for(iterator it = new_end; it != end; ++it)
+	{
+		it->reset();
+	}
+	this->count = new_end - this->packets;
+	return start;
+}
+
+
+void NetBurst::splice(const_iterator position, NetBurst &other)
+{
+	if(&other == this || other.empty())
+	{
+		return;
+	}
+	bool valid = this->bytes_valid && other.bytes_valid;
+	long bytes = this->total_bytes + other.total_bytes;
+
+	iterator gap = this->openGap(position - this->packets, other.count);
+	std::move(other.packets, other.packets + other.count, gap);
+	other.clear();
+	this->total_bytes = bytes;
+	this->bytes_valid = valid;
+}
+
+
+void NetBurst::clear()
+{
+	for(size_type i = 0; i < this->count; ++i)
+	{
+		this->packets[i].reset();
+	}
+	this->count = 0;
+	this->total_bytes = 0;
+	this->bytes_valid = true;
+}
+
+
+void NetBurst::reserve(size_type capacity)
+{
+	if(capacity <= this->capacity)
+	{
+		return;
+	}
+	std::unique_ptr<value_type[]> heap{new value_type[capacity]};
+	std::move(this->packets, this->packets + this->count, heap.get());
+	this->heap_packets = std::move(heap);
+	this->packets = this->heap_packets.get();
+	this->capacity = capacity;
+}
+
+
+NetBurst::iterator NetBurst::openGap(size_type position, size_type length)
+{
+	if(this->count + length > this->capacity)
+	{
+		this->reserve(std::max(this->count + length, 2 * this->capacity));
+	}
+	iterator gap = this->packets + position;
+	std::move_backward(gap, this->packets + this->count,
+	                   this->packets + this->count + length);
+	this->count += length;
+	return gap;
+}
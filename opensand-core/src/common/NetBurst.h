@@ -37,7 +37,8 @@
 #define NET_BURST_H
 
 
-#include <list>
+#include <array>
+#include <cstddef>
 #include <string>
 #include <memory>
 
@@ -51,9 +52,23 @@ enum class NET_PROTO : uint16_t;
 /**
  * @class NetBurst
  * @brief Generic network burst
+ *
+ * The packets are kept in a contiguous array, stored in the burst itself
+ * while they are few, so that building a burst does not allocate.
  */
-class NetBurst: public std::list<std::unique_ptr<NetPacket>>
+class NetBurst
 {
+public:
+	typedef std::unique_ptr<NetPacket> value_type;
+	typedef value_type &reference;
+	typedef const value_type &const_reference;
+	typedef value_type *iterator;
+	typedef const value_type *const_iterator;
+	typedef std::size_t size_type;
+
+	/// The number of packets stored in the burst before using the heap
+	static constexpr size_type inline_capacity = 8;
+
 protected:
 	/// The maximum number of network packets in the burst
 	/// (0 for unlimited length)
@@ -73,6 +88,9 @@ public:
 	 */
 	~NetBurst();
 
+	NetBurst(const NetBurst &) = delete;
+	NetBurst &operator=(const NetBurst &) = delete;
+
 	/**
 	 * Get the maximum number of network packets in the burst
 	 *
@@ -123,6 +141,9 @@ public:
 	/**
 	 * Get the amount of data (in bytes) stored in the burst
 	 *
+	 * The amount is kept up to date while the packets are only added,
+	 * it is computed again after the packets were accessed for writing.
+	 *
 	 * @return the amount of data in the burst
 	 */
 	long bytes() const;
@@ -143,8 +164,102 @@ public:
 	 */
 	std::string name() const;
 
+	// The accesses to the packets, as a sequence container.
+	// The non-const ones may modify the packets and thus the burst length.
+
+	iterator begin() { this->bytes_valid = false; return this->packets; };
+	iterator end() { this->bytes_valid = false; return this->packets + this->count; };
+	const_iterator begin() const { return this->packets; };
+	const_iterator end() const { return this->packets + this->count; };
+	const_iterator cbegin() const { return this->packets; };
+	const_iterator cend() const { return this->packets + this->count; };
+
+	reference front() { this->bytes_valid = false; return this->packets[0]; };
+	const_reference front() const { return this->packets[0]; };
+	reference back() { this->bytes_valid = false; return this->packets[this->count - 1]; };
+	const_reference back() const { return this->packets[this->count - 1]; };
+
+	size_type size() const { return this->count; };
+	bool empty() const { return this->count == 0; };
+
+	/**
+	 * Append a packet to the burst, whether it is full or not
+	 *
+	 * @param packet  the network packet to append
+	 */
+	void push_back(std::unique_ptr<NetPacket> packet);
+
+	/**
+	 * Remove a packet from the burst
+	 *
+	 * @param position  the packet to remove
+	 * @return the position of the packet following the removed one
+	 */
+	iterator erase(const_iterator position);
+
+	/**
+	 * Remove packets from the burst
+	 *
+	 * @param first  the first packet to remove
+	 * @param last   the packet following the last one to remove
+	 * @return the position of the packet following the removed ones
+	 */
+	iterator erase(const_iterator first, const_iterator last);
+
+	/**
+	 * Move all the packets of another burst into this one
+	 *
+	 * @param position  the position where the packets are inserted
+	 * @param other     the burst emptied of its packets
+	 */
+	void splice(const_iterator position, NetBurst &other);
+
+	/**
+	 * Remove and release all the packets of the burst
+	 */
+	void clear();
+
+	/**
+	 * Make room for packets in the burst
+	 *
+	 * @param capacity  the number of packets the burst can hold
+	 *                  without allocating again
+	 */
+	void reserve(size_type capacity);
+
 	/// Netburst log
 	static std::shared_ptr<OutputLog> log_net_burst;
+
+private:
+	/// The packets stored in the burst itself
+	std::array<value_type, inline_capacity> inline_packets;
+
+	/// The packets stored on the heap once there are too many
+	std::unique_ptr<value_type[]> heap_packets;
+
+	/// The packets, either inline_packets or heap_packets
+	value_type *packets;
+
+	/// The number of packets
+	size_type count;
+
+	/// The number of packets that fit in packets
+	size_type capacity;
+
+	/// The amount of data in the burst, if bytes_valid
+	mutable long total_bytes;
+
+	/// Whether total_bytes is up to date
+	mutable bool bytes_valid;
+
+	/**
+	 * Open a gap of packets in the burst
+	 *
+	 * @param position  the index of the gap
+	 * @param length    the number of packets of the gap
+	 * @return the start of the gap
+	 */
+	iterator openGap(size_type position, size_type length);
 };
 
 
@@ -33,7 +33,10 @@
  * @author Julien BERNARD <julien.bernard@toulouse.viveris.com>
  */
 
+#include <utility>
+
 #include "NetContainer.h"
+#include "BufferPool.h"
 
 
 NetContainer::NetContainer(const unsigned char *data, std::size_t length):
@@ -41,7 +44,8 @@ NetContainer::NetContainer(const unsigned char *data, std::size_t length):
 		name("unknown"),
 		header_length(0),
 		trailer_length(0),
-		spot(255)
+		spot(255),
+		timestamp(0)
 {
 	this->data.append(data, length);
 }
@@ -52,17 +56,45 @@ NetContainer::NetContainer(const Data &data, std::size_t length):
 		name("unknown"),
 		header_length(0),
 		trailer_length(0),
-		spot(255)
+		spot(255),
+		timestamp(0)
 {
 }
 
 
+NetContainer::NetContainer(Data &&data, std::size_t length):
+		data(std::move(data)),
+		name("unknown"),
+		header_length(0),
+		trailer_length(0),
+		spot(255),
+		timestamp(0)
+{
+	if(length < this->data.length())
+	{
+		this->data.resize(length);
+	}
+}
+
+
 NetContainer::NetContainer(const Data &data):
 		data(data),
 		name("unknown"),
 		header_length(0),
 		trailer_length(0),
-		spot(255)
+		spot(255),
+		timestamp(0)
+{
+}
+
+
+NetContainer::NetContainer(Data &&data):
+		data(std::move(data)),
+		name("unknown"),
+		header_length(0),
+		trailer_length(0),
+		spot(255),
+		timestamp(0)
 {
 }
 
@@ -72,7 +104,8 @@ NetContainer::NetContainer():
 		name("unknown"),
 		header_length(0),
 		trailer_length(0),
-		spot(255)
+		spot(255),
+		timestamp(0)
 {
 }
 
@@ -88,11 +121,30 @@ std::string NetContainer::getName() const
 }
 
 
-Data NetContainer::getData() const
+void *NetContainer::operator new(std::size_t size)
+{
+	return BufferPool::allocate(size);
+}
+
+
+void NetContainer::operator delete(void *ptr) noexcept
+{
+	BufferPool::release(ptr);
+}
+
+
+const Data &NetContainer::getData() const
 {
 	return this->data;
 }
 
+Data NetContainer::releaseData()
+{
+	Data data{std::move(this->data)};
+	this->data.clear();
+	return data;
+}
+
 const uint8_t *NetContainer::getRawData() const
 {
 	return this->data.data();
@@ -67,6 +67,10 @@ protected:
 	/// The destination spot ID
 	spot_id_t spot;
 
+	/// The time the container entered the current processing stage
+	/// (ns, see getTimestampNs), 0 if not timestamped
+	uint64_t timestamp;
+
 public:
 	/**
 	 * Build a generic OpenSAND network container
@@ -83,6 +87,14 @@ public:
 	 */
 	NetContainer(const Data &data);
 
+	/**
+	 * Build a generic OpenSAND network container
+	 * taking the ownership of the raw data buffer
+	 *
+	 * @param data raw data from which a network-layer packet can be created
+	 */
+	NetContainer(Data &&data);
+
 	/**
 	 * Build a generic OpenSAND network container
 	 *
@@ -91,6 +103,15 @@ public:
 	 */
 	NetContainer(const Data &data, std::size_t length);
 
+	/**
+	 * Build a generic OpenSAND network container taking the
+	 * ownership of the raw data buffer, truncated to the length
+	 *
+	 * @param data raw data from which a network-layer packet can be created
+	 * @param length length of raw data
+	 */
+	NetContainer(Data &&data, std::size_t length);
+
 	/**
 	 * Build an empty generic OpenSAND network container
 	 */
@@ -101,6 +122,21 @@ public:
 	 */
 	virtual ~NetContainer();
 
+	/**
+	 * Allocate the containers from the BufferPool of the calling thread
+	 *
+	 * @param size  the size of the container object
+	 * @return the allocated memory
+	 */
+	static void *operator new(std::size_t size);
+
+	/**
+	 * Give the memory of a container back to the BufferPool
+	 *
+	 * @param ptr  the memory to release
+	 */
+	static void operator delete(void *ptr) noexcept;
+
 	/**
 	 * Get the name of the network protocol
 	 *
@@ -117,10 +153,20 @@ public:
 
 	/**
 	 * Get data string
+	 * Warning: the reference is invalidated when the container is destroyed.
+	 *
+	 * @return the data string
+	 */
+	const Data &getData() const;
+
+	/**
+	 * Take the data string, the container is left empty.
+	 * A packet consumed to build another one hands its buffer
+	 * over instead of having it copied.
 	 *
 	 * @return the data string
 	 */
-	Data getData() const;
+	Data releaseData();
 
 	/**
 	 * Returns a const pointer to the raw data. 
@@ -185,6 +231,22 @@ public:
 	 * @return the destination spot ID
 	 */
 	spot_id_t getSpot() const;
+
+	/**
+	 * Set the time the container entered the current processing stage:
+	 * the kernel reception of its carrier datagram, or its emission by
+	 * the DVB layer or the delay FIFO of the physical layer
+	 *
+	 * @param timestamp  The time (ns, see getTimestampNs)
+	 */
+	inline void setTimestamp(uint64_t timestamp) { this->timestamp = timestamp; };
+
+	/**
+	 * Get the time the container entered the current processing stage
+	 *
+	 * @return the time (ns, see getTimestampNs), 0 if not timestamped
+	 */
+	inline uint64_t getTimestamp() const { return this->timestamp; };
 };
 
 
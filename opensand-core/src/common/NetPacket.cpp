@@ -32,6 +32,8 @@
  * @author Didier Barvaux <didier.barvaux@toulouse.viveris.com>
  */
 
+#include <utility>
+
 #include "NetPacket.h"
 
 
@@ -57,6 +59,17 @@ NetPacket::NetPacket(const Data &data):
 }
 
 
+NetPacket::NetPacket(Data &&data):
+		NetContainer{std::move(data)},
+		type{NET_PROTO::ERROR},
+		qos{},
+		src_tal_id{},
+		dst_tal_id{}
+{
+	this->name = "NetPacket";
+}
+
+
 NetPacket::NetPacket(const Data &data, std::size_t length):
 		NetContainer{data, length},
 		type{NET_PROTO::ERROR},
@@ -110,6 +123,44 @@ NetPacket::NetPacket(const Data &data,
 }
 
 
+NetPacket::NetPacket(Data &&data,
+                     std::size_t length,
+                     std::string name,
+                     NET_PROTO type,
+                     uint8_t qos,
+                     uint8_t src_tal_id,
+                     uint8_t dst_tal_id,
+                     std::size_t header_length):
+	NetContainer{std::move(data), length},
+	type{type},
+	qos{qos},
+	src_tal_id{src_tal_id},
+	dst_tal_id{dst_tal_id}
+{
+	this->name = name;
+	this->header_length = header_length;
+}
+
+
+NetPacket::NetPacket(const unsigned char *data,
+                     std::size_t length,
+                     std::string name,
+                     NET_PROTO type,
+                     uint8_t qos,
+                     uint8_t src_tal_id,
+                     uint8_t dst_tal_id,
+                     std::size_t header_length):
+	NetContainer{data, length},
+	type{type},
+	qos{qos},
+	src_tal_id{src_tal_id},
+	dst_tal_id{dst_tal_id}
+{
+	this->name = name;
+	this->header_length = header_length;
+}
+
+
 NetPacket::~NetPacket()
 {
 }
@@ -155,3 +206,16 @@ uint8_t NetPacket::getDstTalId() const
 {
 	return this->dst_tal_id;
 }
+
+
+void NetPacket::setEncapsulation(Data &&data,
+                                 const std::string &name,
+                                 NET_PROTO type,
+                                 std::size_t header_length)
+{
+	this->data = std::move(data);
+	this->name = name;
+	this->type = type;
+	this->header_length = header_length;
+	this->trailer_length = 0;
+}
@@ -37,6 +37,8 @@
 
 #include <linux/if_ether.h>
 
+#include <opensand_rt/RtAccounting.h>
+
 #include "NetContainer.h"
 
 
@@ -95,8 +97,6 @@ enum class NET_PROTO : uint16_t
 };
 
 
-// TODO we may add an option to enable jumbo frames
-
 // Size of a IEEE 802.3 Ethernet frame
 // dmac(6) + smac(6) + etype(2) + max_payload(1500) = 1514 bytes
 #define ETHERNET_2_SIZE			ETH_FRAME_LEN
@@ -114,6 +114,12 @@ enum class NET_PROTO : uint16_t
 
 #define MAX_ETHERNET_SIZE ETHERNET_802_1AD_SIZE
 
+// MTU of the jumbo frames, the largest one the TAP interface may use
+#define ETHERNET_JUMBO_MTU 9000
+// Size of the largest Ethernet frame carrying a given MTU
+#define ETHERNET_FRAME_SIZE(mtu) ((mtu) + ETHERNET_802_1AD_HEADSIZE)
+#define MAX_JUMBO_ETHERNET_SIZE ETHERNET_FRAME_SIZE(ETHERNET_JUMBO_MTU)
+
 
 /**
  * @class NetPacket
@@ -130,8 +136,13 @@ protected:
 	uint8_t src_tal_id;
 	/// The packet destination TalID
 	uint8_t dst_tal_id;
+	/// The count of the live packets of the building channel
+	RtAccounted<NetPacket> accounted;
 
 public:
+	/// The name of the packets in the memory accounting
+	static constexpr const char *accounting_name = "net_packet";
+
 	/**
 	 * Build a network-layer packet
 	 * @param data raw data from which a network-layer packet can be created
@@ -145,6 +156,12 @@ public:
 	 */
 	NetPacket(const Data &data);
 
+	/**
+	 * Build a network-layer packet taking the ownership of the raw data buffer
+	 * @param data raw data from which a network-layer packet can be created
+	 */
+	NetPacket(Data &&data);
+
 	/**
 	 * Build a network-layer packet
 	 * @param data raw data from which a network-layer packet can be created
@@ -184,6 +201,49 @@ public:
 	          uint8_t dst_tal_id,
 	          std::size_t header_length);
 
+	/**
+	 * Build a network-layer packet initialized, taking the ownership
+	 * of the raw data buffer
+	 *
+	 * @param data              raw data from which a network-layer packet can be created
+	 * @param length            length of raw data
+	 * @param name              the name of the network protocol
+	 * @param type              the type of the network protocol
+	 * @param qos               the QoS value to associate with the packet
+	 * @param src_tal_id        the source terminal ID to associate with the packet
+	 * @param dst_tal_id        the destination terminal ID to associate with the packet
+	 * @param header_length     the header length of the packet
+	 */
+	NetPacket(Data &&data,
+	          std::size_t length,
+	          std::string name,
+	          NET_PROTO type,
+	          uint8_t qos,
+	          uint8_t src_tal_id,
+	          uint8_t dst_tal_id,
+	          std::size_t header_length);
+
+	/**
+	 * Build a network-layer packet initialized from a raw buffer
+	 *
+	 * @param data              raw data from which a network-layer packet can be created
+	 * @param length            length of raw data
+	 * @param name              the name of the network protocol
+	 * @param type              the type of the network protocol
+	 * @param qos               the QoS value to associate with the packet
+	 * @param src_tal_id        the source terminal ID to associate with the packet
+	 * @param dst_tal_id        the destination terminal ID to associate with the packet
+	 * @param header_length     the header length of the packet
+	 */
+	NetPacket(const unsigned char *data,
+	          std::size_t length,
+	          std::string name,
+	          NET_PROTO type,
+	          uint8_t qos,
+	          uint8_t src_tal_id,
+	          uint8_t dst_tal_id,
+	          std::size_t header_length);
+
 	/**
 	 * Destroy the network-layer packet
 	 */
@@ -237,6 +297,20 @@ public:
 	 * @return the type of network protocol
 	 */
 	NET_PROTO getType() const;
+
+	/**
+	 * Replace the data of the packet by their encapsulation, the packet
+	 * and its QoS, terminal IDs and spot are kept
+	 *
+	 * @param data           the encapsulated data, whose buffer is taken
+	 * @param name           the name of the encapsulation protocol
+	 * @param type           the type of the encapsulation protocol
+	 * @param header_length  the header length of the encapsulated packet
+	 */
+	void setEncapsulation(Data &&data,
+	                      const std::string &name,
+	                      NET_PROTO type,
+	                      std::size_t header_length);
 };
 
 
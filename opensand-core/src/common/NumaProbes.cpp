@@ -0,0 +1,78 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file NumaProbes.cpp
+ * @brief Probes of the memory used on the NUMA nodes of the spots
+ * @author Viveris Technologies
+ */
+
+
+#include "NumaProbes.h"
+
+#include <opensand_output/Output.h>
+#include <opensand_rt/RtMemory.h>
+
+
+NumaProbes::NumaProbes():
+	nodes()
+{
+}
+
+
+void NumaProbes::init(const std::string &prefix, const std::vector<int> &nodes)
+{
+	auto output = Output::Get();
+	for(int node: nodes)
+	{
+		std::string name = prefix + "Memory.Node_" + std::to_string(node) + ".";
+		this->nodes.push_back({node,
+		                       output->registerProbe<int32_t>(name + "Used", "kB", true, SAMPLE_LAST),
+		                       output->registerProbe<int32_t>(name + "Buffers", "kB", true, SAMPLE_LAST)});
+	}
+}
+
+
+bool NumaProbes::isEnabled(void) const
+{
+	return !this->nodes.empty();
+}
+
+
+void NumaProbes::update(void)
+{
+	for(auto &&probes: this->nodes)
+	{
+		// the host usage is read from sysfs, only when it is exported
+		if(probes.used->isEnabled())
+		{
+			probes.used->put(RtMemory::getNodeUsedMemory(probes.node));
+		}
+		probes.buffers->put(RtMemory::getNodeAllocatedMemory(probes.node) / 1024);
+	}
+}
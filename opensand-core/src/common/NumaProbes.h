@@ -0,0 +1,92 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file NumaProbes.h
+ * @brief Probes of the memory used on the NUMA nodes of the spots
+ * @author Viveris Technologies
+ */
+
+#ifndef NUMA_PROBES_H
+#define NUMA_PROBES_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+template<typename T>
+class Probe;
+
+
+/**
+ * @class NumaProbes
+ * @brief Export the memory used on some NUMA nodes: the memory used by
+ *        the whole host on each node and the memory of the channels
+ *        buffers placed on it
+ */
+class NumaProbes
+{
+ public:
+	NumaProbes();
+
+	/**
+	 * @brief Register the probes of the nodes
+	 *
+	 * @param prefix  The probes prefix
+	 * @param nodes   The NUMA nodes
+	 */
+	void init(const std::string &prefix, const std::vector<int> &nodes);
+
+	/**
+	 * @brief Check whether some nodes are monitored
+	 *
+	 * @return true if the probes of at least one node are registered
+	 */
+	bool isEnabled(void) const;
+
+	/**
+	 * @brief Read the memory of the nodes and put it in the probes
+	 */
+	void update(void);
+
+ private:
+	/// The probes of a node
+	struct NodeProbes
+	{
+		int node;
+		std::shared_ptr<Probe<int32_t>> used;
+		std::shared_ptr<Probe<int32_t>> buffers;
+	};
+
+	std::vector<NodeProbes> nodes;
+};
+
+
+#endif
@@ -43,8 +43,11 @@
 #include <stdint.h>
 #include <cmath>
 #include <sys/time.h>
+#include <time.h>
 #include <arpa/inet.h>
 
+#include <opensand_rt/RtVirtualClock.h>
+
 
 /** unused macro to avoid compilation warning with unused parameters. */
 #ifdef __GNUC__
@@ -208,11 +211,47 @@ constexpr auto to_enum(I i) noexcept -> typename std::enable_if<std::is_same<I,
  */
 inline clock_t getCurrentTime(void)
 {
+	if(RtVirtualClock::isEnabled())
+	{
+		return RtVirtualClock::getTime() / 1000000;
+	}
+
 	timeval current;
 	gettimeofday(&current, NULL);
 	return current.tv_sec * 1000 + current.tv_usec / 1000;
 };
 
+/**
+ * @brief Get the current time on the clock of getCurrentTime
+ *        with a microsecond resolution
+ *
+ * @return the current time (ms)
+ */
+inline double getPreciseTime(void)
+{
+	if(RtVirtualClock::isEnabled())
+	{
+		return RtVirtualClock::getTime() / 1000000.0;
+	}
+
+	timeval current;
+	gettimeofday(&current, NULL);
+	return current.tv_sec * 1000.0 + current.tv_usec / 1000.0;
+};
+
+/**
+ * @brief Get the current time on the clock of the kernel socket
+ *        timestamps (CLOCK_REALTIME), whatever the virtual time
+ *
+ * @return the current time (ns)
+ */
+inline uint64_t getTimestampNs(void)
+{
+	struct timespec current;
+	clock_gettime(CLOCK_REALTIME, &current);
+	return current.tv_sec * UINT64_C(1000000000) + current.tv_nsec;
+};
+
 /**
  * @brief  Tokenize a string
  *
@@ -347,6 +386,8 @@ struct SpotTopology
 	tal_id_t sat_id_st;                  ///< The satellite connected to the terminals of this spot
 	RegenLevel forward_regen_level;      ///< The regeneration level of the forward channel
 	RegenLevel return_regen_level;       ///< The regeneration level of the return channel
+	int gw_numa_node;                    ///< The NUMA node of the spot blocks on the gateway, -1 if not placed
+	int sat_numa_node;                   ///< The NUMA node of the spot blocks on the satellites, -1 if not placed
 };
 
 struct IslConfig
@@ -0,0 +1,425 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file PacketMirror.cpp
+ * @brief Mirror points copying the packets of the internal stages
+ *        in a pcap-ng file
+ * @author Viveris Technologies
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sched.h>
+
+#include "PacketMirror.h"
+
+
+namespace
+{
+
+/// The capacity of the ring of each thread, a power of 2
+constexpr std::size_t ring_capacity = 4 * 1024 * 1024;
+
+/// The longest packet part kept, the packets are truncated beyond
+constexpr std::size_t max_copy_length = 65536;
+
+/// The pause of the writer when all the rings are empty
+constexpr std::chrono::milliseconds writer_pause{1};
+
+/// The pcap-ng blocks types and options
+constexpr uint32_t pcapng_section_header = 0x0A0D0D0A;
+constexpr uint32_t pcapng_interface_description = 0x00000001;
+constexpr uint32_t pcapng_enhanced_packet = 0x00000006;
+constexpr uint32_t pcapng_byte_order_magic = 0x1A2B3C4D;
+constexpr uint16_t pcapng_opt_endofopt = 0;
+constexpr uint16_t pcapng_opt_comment = 1;
+constexpr uint16_t pcapng_if_name = 2;
+constexpr uint16_t pcapng_if_tsresol = 9;
+
+/// The stages frames have no standard link type, LINKTYPE_USER0
+constexpr uint16_t pcapng_linktype_user0 = 147;
+
+
+/**
+ * @brief The header of a packet in a ring, followed by the
+ *        packet padded to 8 bytes
+ */
+struct RecordHeader
+{
+	/// The length copied, wrap_marker when the ring restarts from its beginning
+	uint32_t length;
+	/// The packet length before truncation
+	uint32_t original_length;
+	uint32_t interface_id;
+	uint16_t tal_id;
+	uint16_t padding;
+	uint64_t time_ns;
+};
+
+constexpr uint32_t wrap_marker = UINT32_MAX;
+
+
+constexpr std::size_t align8(std::size_t length)
+{
+	return (length + 7) & ~static_cast<std::size_t>(7);
+}
+
+
+/**
+ * @brief A ring written by one thread and read by the writer thread
+ */
+struct ThreadRing
+{
+	ThreadRing(): head{0}, tail{0}, buffer(ring_capacity) {};
+
+	/// The bytes written and read since the ring creation
+	alignas(64) std::atomic<uint64_t> head;
+	alignas(64) std::atomic<uint64_t> tail;
+
+	std::vector<unsigned char> buffer;
+};
+
+
+/// The rings of all the threads, the mirror stages and the writer
+struct Registry
+{
+	std::mutex mutex;
+	std::vector<ThreadRing *> rings;
+	std::vector<std::string> stages;
+
+	std::atomic<bool> running{false};
+	std::thread writer;
+	std::FILE *file = nullptr;
+	std::size_t written_interfaces = 0;
+};
+
+
+Registry &getRegistry()
+{
+	// never destroyed as the channels threads may still mirror packets
+	static Registry *registry = new Registry();
+	return *registry;
+}
+
+
+/**
+ * @brief Get the ring of the calling thread, creating it if needed
+ *
+ * @return the ring
+ */
+ThreadRing *getRing()
+{
+	static thread_local ThreadRing *ring = nullptr;
+	if(ring == nullptr)
+	{
+		ring = new ThreadRing();
+		Registry &registry = getRegistry();
+		std::lock_guard<std::mutex> lock{registry.mutex};
+		registry.rings.push_back(ring);
+	}
+	return ring;
+}
+
+
+/**
+ * @brief Write a pcap-ng block: its type, length, body and length again
+ *
+ * @param file  The pcap-ng file
+ * @param type  The block type
+ * @param body  The block body, padded to 4 bytes
+ */
+void writeBlock(std::FILE *file, uint32_t type, const std::vector<unsigned char> &body)
+{
+	uint32_t length = 12 + body.size();
+	std::fwrite(&type, sizeof(type), 1, file);
+	std::fwrite(&length, sizeof(length), 1, file);
+	std::fwrite(body.data(), 1, body.size(), file);
+	std::fwrite(&length, sizeof(length), 1, file);
+}
+
+
+template<typename T>
+void append(std::vector<unsigned char> &body, T value)
+{
+	const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&value);
+	body.insert(body.end(), bytes, bytes + sizeof(value));
+}
+
+
+void appendOption(std::vector<unsigned char> &body, uint16_t code,
+                  const void *value, std::size_t length)
+{
+	append<uint16_t>(body, code);
+	append<uint16_t>(body, length);
+	const unsigned char *bytes = static_cast<const unsigned char *>(value);
+	body.insert(body.end(), bytes, bytes + length);
+	body.resize((body.size() + 3) & ~static_cast<std::size_t>(3), 0);
+}
+
+
+void writeSectionHeader(std::FILE *file)
+{
+	std::vector<unsigned char> body;
+	append<uint32_t>(body, pcapng_byte_order_magic);
+	append<uint16_t>(body, 1);
+	append<uint16_t>(body, 0);
+	// the section length is not known
+	append<int64_t>(body, -1);
+	writeBlock(file, pcapng_section_header, body);
+}
+
+
+void writeInterface(std::FILE *file, const std::string &stage)
+{
+	std::vector<unsigned char> body;
+	append<uint16_t>(body, pcapng_linktype_user0);
+	append<uint16_t>(body, 0);
+	append<uint32_t>(body, max_copy_length);
+	appendOption(body, pcapng_if_name, stage.c_str(), stage.size());
+	// timestamps in nanoseconds
+	uint8_t resolution = 9;
+	appendOption(body, pcapng_if_tsresol, &resolution, sizeof(resolution));
+	appendOption(body, pcapng_opt_endofopt, nullptr, 0);
+	writeBlock(file, pcapng_interface_description, body);
+}
+
+
+void writePacket(std::FILE *file, const RecordHeader &header, const unsigned char *data)
+{
+	std::vector<unsigned char> body;
+	append<uint32_t>(body, header.interface_id);
+	append<uint32_t>(body, header.time_ns >> 32);
+	append<uint32_t>(body, header.time_ns & 0xFFFFFFFF);
+	append<uint32_t>(body, header.length);
+	append<uint32_t>(body, header.original_length);
+	body.insert(body.end(), data, data + header.length);
+	body.resize((body.size() + 3) & ~static_cast<std::size_t>(3), 0);
+	char comment[32];
+	int length = std::snprintf(comment, sizeof(comment), "tal_id=%u", header.tal_id);
+	appendOption(body, pcapng_opt_comment, comment, length);
+	appendOption(body, pcapng_opt_endofopt, nullptr, 0);
+	writeBlock(file, pcapng_enhanced_packet, body);
+}
+
+
+/**
+ * @brief Write the packets of a ring in the mirror file
+ *
+ * @param registry  The mirrors registry
+ * @param ring      The ring to drain
+ * @return the number of packets written
+ */
+std::size_t drain(Registry &registry, ThreadRing *ring)
+{
+	std::size_t count = 0;
+	uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+	uint64_t head = ring->head.load(std::memory_order_acquire);
+	while(tail != head)
+	{
+		std::size_t offset = tail & (ring_capacity - 1);
+		std::size_t contiguous = ring_capacity - offset;
+		RecordHeader header;
+		if(contiguous < sizeof(header))
+		{
+			tail += contiguous;
+			continue;
+		}
+		std::memcpy(&header, &ring->buffer[offset], sizeof(header));
+		if(header.length == wrap_marker)
+		{
+			tail += contiguous;
+			continue;
+		}
+
+		// the interfaces are described before their first packet
+		if(header.interface_id >= registry.written_interfaces)
+		{
+			std::lock_guard<std::mutex> lock{registry.mutex};
+			for(; registry.written_interfaces < registry.stages.size(); ++registry.written_interfaces)
+			{
+				writeInterface(registry.file, registry.stages[registry.written_interfaces]);
+			}
+		}
+		writePacket(registry.file, header, &ring->buffer[offset + sizeof(header)]);
+		tail += sizeof(header) + align8(header.length);
+		ring->tail.store(tail, std::memory_order_release);
+		++count;
+	}
+	ring->tail.store(tail, std::memory_order_release);
+	return count;
+}
+
+
+/**
+ * @brief Drain the rings of all the threads until the mirrors are stopped
+ */
+void write()
+{
+	Registry &registry = getRegistry();
+	bool running = true;
+	while(running)
+	{
+		// the last rings are drained after the stop
+		running = registry.running.load(std::memory_order_acquire);
+
+		std::vector<ThreadRing *> rings;
+		{
+			std::lock_guard<std::mutex> lock{registry.mutex};
+			rings = registry.rings;
+		}
+		std::size_t count = 0;
+		for(auto &&ring: rings)
+		{
+			count += drain(registry, ring);
+		}
+		if(count == 0)
+		{
+			std::fflush(registry.file);
+			std::this_thread::sleep_for(writer_pause);
+		}
+	}
+	std::fflush(registry.file);
+}
+
+}
+
+
+PacketMirror::PacketMirror(const std::string &stage):
+	interface_id{0},
+	probe{nullptr}
+{
+	Registry &registry = getRegistry();
+	{
+		std::lock_guard<std::mutex> lock{registry.mutex};
+		this->interface_id = registry.stages.size();
+		registry.stages.push_back(stage);
+	}
+	this->probe = Output::Get()->registerProbe<int>("Mirror." + stage, "packets",
+	                                                false, SAMPLE_SUM);
+}
+
+
+void PacketMirror::copy(const unsigned char *data, std::size_t length, tal_id_t tal_id)
+{
+	Registry &registry = getRegistry();
+	if(!registry.running.load(std::memory_order_acquire))
+	{
+		return;
+	}
+
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	RecordHeader header;
+	header.length = std::min(length, max_copy_length);
+	header.original_length = length;
+	header.interface_id = this->interface_id;
+	header.tal_id = tal_id;
+	header.padding = 0;
+	header.time_ns = now.tv_sec * 1000000000ULL + now.tv_nsec;
+
+	ThreadRing *ring = getRing();
+	std::size_t needed = sizeof(header) + align8(header.length);
+	uint64_t head = ring->head.load(std::memory_order_relaxed);
+	std::size_t offset = head & (ring_capacity - 1);
+	std::size_t contiguous = ring_capacity - offset;
+	// a record does not wrap, the end of the ring is skipped instead
+	std::size_t reserved = contiguous < needed ? contiguous + needed : needed;
+	while(ring_capacity - (head - ring->tail.load(std::memory_order_acquire)) < reserved)
+	{
+		if(!registry.running.load(std::memory_order_acquire))
+		{
+			return;
+		}
+		sched_yield();
+	}
+
+	if(contiguous < needed)
+	{
+		if(contiguous >= sizeof(header))
+		{
+			RecordHeader marker{};
+			marker.length = wrap_marker;
+			std::memcpy(&ring->buffer[offset], &marker, sizeof(marker));
+		}
+		head += contiguous;
+		offset = 0;
+	}
+	std::memcpy(&ring->buffer[offset], &header, sizeof(header));
+	std::memcpy(&ring->buffer[offset + sizeof(header)], data, header.length);
+	ring->head.store(head + needed, std::memory_order_release);
+
+	this->probe->put(1);
+}
+
+
+bool PacketMirror::start(const std::string &filename)
+{
+	Registry &registry = getRegistry();
+	if(registry.running.load())
+	{
+		return true;
+	}
+
+	registry.file = std::fopen(filename.c_str(), "wb");
+	if(registry.file == nullptr)
+	{
+		DFLTLOG(LEVEL_ERROR,
+		        "cannot open the mirror file %s: %s",
+		        filename.c_str(), strerror(errno));
+		return false;
+	}
+	writeSectionHeader(registry.file);
+	registry.written_interfaces = 0;
+	registry.running.store(true, std::memory_order_release);
+	registry.writer = std::thread{write};
+	return true;
+}
+
+
+void PacketMirror::stop()
+{
+	Registry &registry = getRegistry();
+	if(!registry.running.exchange(false))
+	{
+		return;
+	}
+	registry.writer.join();
+	std::fclose(registry.file);
+	registry.file = nullptr;
+}
@@ -0,0 +1,119 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file PacketMirror.h
+ * @brief Mirror points copying the packets of the internal stages
+ *        in a pcap-ng file
+ * @author Viveris Technologies
+ */
+
+#ifndef PACKET_MIRROR_H
+#define PACKET_MIRROR_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <opensand_output/Output.h>
+
+#include "OpenSandCore.h"
+
+
+/**
+ * @class PacketMirror
+ * @brief A mirror point of an internal stage of the stack
+ *        (encapsulated packets, BBFrames, SALOHA slots, ...)
+ *
+ * Each mirror point registers a disabled Mirror.<stage> probe counting
+ * the mirrored packets, the point copies the packets only while its
+ * probe is enabled through the output (Output::setProbeState, which
+ * also accepts the Mirror group to enable all the points at once), so
+ * a disabled point only costs a test.
+ *
+ * The packets are copied in a lock-free ring owned by the calling
+ * thread and written in the pcap-ng file by a background thread, with
+ * one interface per stage and the terminal ID in the packets comment.
+ * No packet is lost: a thread whose ring is full waits for the writer.
+ */
+class PacketMirror
+{
+public:
+	/**
+	 * @brief Create a mirror point
+	 *
+	 * @param stage  The stage name, unique in the entity
+	 *               (e.g. Encap.Downward.packets)
+	 */
+	PacketMirror(const std::string &stage);
+
+	/**
+	 * @brief Check whether the packets of the stage are mirrored
+	 *
+	 * @return true if the packets must be given to copy
+	 */
+	inline bool isEnabled() const
+	{
+		return this->probe != nullptr && this->probe->isEnabled();
+	};
+
+	/**
+	 * @brief Copy a packet of the stage in the mirror file
+	 *
+	 * @param data    The packet
+	 * @param length  The packet length
+	 * @param tal_id  The terminal the packet belongs to
+	 */
+	void copy(const unsigned char *data, std::size_t length, tal_id_t tal_id);
+
+	/**
+	 * @brief Open the mirror file and start the writer thread,
+	 *        the mirrors are ignored until then
+	 *
+	 * @param filename  The pcap-ng file the packets are written in
+	 * @return true on success, false otherwise
+	 */
+	static bool start(const std::string &filename);
+
+	/**
+	 * @brief Write the remaining packets, stop the writer thread
+	 *        and close the mirror file
+	 */
+	static void stop();
+
+private:
+	/// The pcap-ng interface of the stage
+	uint32_t interface_id;
+
+	/// The probe enabling the mirror and counting the mirrored packets
+	std::shared_ptr<Probe<int>> probe;
+};
+
+
+#endif
@@ -37,9 +37,18 @@
 
 #include <opensand_output/Output.h>
 
+#include <map>
+
+
+/// The precomputed attenuation profiles of the process, by model key
+static std::map<std::string, std::shared_ptr<const std::vector<double>>> attenuation_profiles;
+static std::mutex attenuation_profiles_mutex;
+
 
 AttenuationModelPlugin::AttenuationModelPlugin():
-		OpenSandPlugin()
+		OpenSandPlugin(),
+		profile(),
+		profile_step(0)
 {
 	this->log_init = Output::Get()->registerLog(LEVEL_WARNING, "PhysicalLayer.init");
 	this->log_attenuation = Output::Get()->registerLog(LEVEL_WARNING, "PhysicalLayer.Attenuation");
@@ -59,6 +68,53 @@ double AttenuationModelPlugin::getAttenuation() const
 	return this->attenuation;
 }
 
+bool AttenuationModelPlugin::precomputeProfile(const std::string &key,
+                                               std::size_t length,
+                                               const std::function<double(std::size_t)> &compute)
+{
+	if(length == 0)
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "cannot precompute the empty attenuation profile %s",
+		    key.c_str());
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock{attenuation_profiles_mutex};
+	auto &shared = attenuation_profiles[key];
+	if(shared == nullptr)
+	{
+		auto table = std::make_shared<std::vector<double>>(length);
+		for(std::size_t step = 0; step < length; ++step)
+		{
+			(*table)[step] = compute(step);
+		}
+		shared = table;
+		LOG(this->log_init, LEVEL_INFO,
+		    "attenuation profile %s precomputed over %zu refresh periods",
+		    key.c_str(), length);
+	}
+	this->profile = shared;
+	this->profile_step = 0;
+	return true;
+}
+
+bool AttenuationModelPlugin::refreshAttenuation()
+{
+	if(this->profile == nullptr)
+	{
+		return this->updateAttenuationModel();
+	}
+
+	const std::vector<double> &table = *this->profile;
+	if(++this->profile_step == table.size())
+	{
+		this->profile_step = 0;
+	}
+	this->attenuation = table[this->profile_step];
+	return true;
+}
+
 
 MinimalConditionPlugin::MinimalConditionPlugin():
 		OpenSandPlugin()
@@ -76,6 +132,22 @@ double MinimalConditionPlugin::getMinimalCN() const
 	return this->minimal_cn;
 }
 
+bool MinimalConditionPlugin::updateThresholds(const uint8_t *modcod_ids,
+                                              const EmulatedMessageType *message_types,
+                                              double *minimal_cns,
+                                              std::size_t count)
+{
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		if(!this->updateThreshold(modcod_ids[i], message_types[i]))
+		{
+			return false;
+		}
+		minimal_cns[i] = this->getMinimalCN();
+	}
+	return true;
+}
+
 
 ErrorInsertionPlugin::ErrorInsertionPlugin():
 		OpenSandPlugin()
@@ -88,11 +160,33 @@ ErrorInsertionPlugin::~ErrorInsertionPlugin()
 {
 }
 
+void ErrorInsertionPlugin::areToBeModifiedPackets(const double *cn_totals,
+                                                  const double *thresholds_qef,
+                                                  bool *to_modify,
+                                                  std::size_t count)
+{
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		to_modify[i] = this->isToBeModifiedPacket(cn_totals[i], thresholds_qef[i]);
+	}
+}
+
+bool ErrorInsertionPlugin::modifyPayload(unsigned char *payload,
+                                         std::size_t length,
+                                         double,
+                                         double,
+                                         bool &corrupted)
+{
+	corrupted = true;
+	return this->modifyPacket(Data(payload, length));
+}
+
 
 SatDelayPlugin::SatDelayPlugin():
 		OpenSandPlugin(),
 		delay(0),
 		refresh_period_ms(1000),
+		entity_id(0),
 		delay_mutex()
 {
 	this->log_init = Output::Get()->registerLog(LEVEL_WARNING, "SatDelay.init");
@@ -119,3 +213,8 @@ time_ms_t SatDelayPlugin::getRefreshPeriod() const
 {
 	return this->refresh_period_ms;
 }
+
+void SatDelayPlugin::setEntityId(tal_id_t entity_id)
+{
+	this->entity_id = entity_id;
+}
@@ -40,9 +40,12 @@
 #include "OpenSandCore.h"
 #include "OpenSandPlugin.h"
 
+#include <cstddef>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 
 class Data;
@@ -67,6 +70,25 @@ protected:
 	/* channel refreshing period */
 	time_ms_t refresh_period_ms;
 
+	/**
+	 * @brief Replace the model updates by an indexed load in a
+	 *        precomputed period of the attenuation profile, the
+	 *        profiles are shared by the models with the same key
+	 *
+	 * @param key      The name and parameters of the model
+	 * @param length   The number of refresh periods in a period of the profile
+	 * @param compute  The attenuation at each step of the period
+	 * @return true on success, false otherwise
+	 */
+	bool precomputeProfile(const std::string &key,
+	                       std::size_t length,
+	                       const std::function<double(std::size_t)> &compute);
+
+private:
+	/* The precomputed period of the profile, if any, and the current step */
+	std::shared_ptr<const std::vector<double>> profile;
+	std::size_t profile_step;
+
 public:
 	/**
 	 * @brief AttenuationModelPlugin constructor
@@ -107,6 +129,14 @@ public:
 	 * @return true on success, false otherwise
 	 */
 	virtual bool updateAttenuationModel() = 0;
+
+	/**
+	 * @brief Move the current attenuation to the next refresh period,
+	 *        from the precomputed profile if the model has one
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool refreshAttenuation();
 };
 
 
@@ -158,6 +188,24 @@ public:
 	 * @return true on success, false otherwise
 	 */
 	virtual bool updateThreshold(uint8_t modcod_id, EmulatedMessageType message_type) = 0;
+
+	/**
+	 * @brief Get the minimal C/N of a batch of frames, the threshold
+	 *        is updated for each frame as updateThreshold does
+	 *
+	 * The default implementation calls updateThreshold and getMinimalCN
+	 * for each frame, plugins can override it with a loop on tables.
+	 *
+	 * @param modcod_ids     The MODCOD ids carried by the frames
+	 * @param message_types  The frames types
+	 * @param minimal_cns    OUT: the minimal C/N of each frame
+	 * @param count          The number of frames
+	 * @return true on success, false otherwise
+	 */
+	virtual bool updateThresholds(const uint8_t *modcod_ids,
+	                              const EmulatedMessageType *message_types,
+	                              double *minimal_cns,
+	                              std::size_t count);
 };
 
 /**
@@ -196,6 +244,22 @@ public:
 	virtual bool isToBeModifiedPacket(double cn_total,
 	                                  double threshold_qef) = 0;
 
+	/**
+	 * @brief Determine which packets of a batch shall be corrupted
+	 *
+	 * The default implementation calls isToBeModifiedPacket for each
+	 * packet, plugins can override it with a loop on the arrays.
+	 *
+	 * @param cn_totals       The total C/N of the link for each packet
+	 * @param thresholds_qef  The minimal C/N of the link for each packet
+	 * @param to_modify       OUT: whether each packet must be corrupted
+	 * @param count           The number of packets
+	 */
+	virtual void areToBeModifiedPackets(const double *cn_totals,
+	                                    const double *thresholds_qef,
+	                                    bool *to_modify,
+	                                    std::size_t count);
+
 	/**
 	 * @brief Corrupt a packet with error bits 
 	 *
@@ -207,6 +271,27 @@ public:
 	 */
 	virtual bool modifyPacket(const Data &payload) = 0;
 
+	/**
+	 * @brief Corrupt the payload of a frame in place
+	 *
+	 * The default implementation hands a copy of the payload to
+	 * modifyPacket and tags the frame as corrupted, plugins inserting
+	 * bit errors override it to flip the bits of the frame itself.
+	 *
+	 * @param payload        The payload of the frame
+	 * @param length         The payload length
+	 * @param cn_total       The total C/N of the link
+	 * @param threshold_qef  The minimal C/N of the link
+	 * @param corrupted      OUT: whether the frame must be tagged as corrupted
+	 *
+	 * @return true on success, false otherwise
+	 */
+	virtual bool modifyPayload(unsigned char *payload,
+	                           std::size_t length,
+	                           double cn_total,
+	                           double threshold_qef,
+	                           bool &corrupted);
+
 protected:
 	/* Output log */
 	std::shared_ptr<OutputLog> log_init;
@@ -231,6 +316,9 @@ protected:
 	/* satdelay refreshing period */
 	time_ms_t refresh_period_ms;
 
+	/* The terminal or gateway whose link is delayed */
+	tal_id_t entity_id;
+
 private:
 	/* Mutex to prevent concurrent access to delay */
 	mutable std::mutex delay_mutex;
@@ -270,6 +358,14 @@ public:
 	*/
 	time_ms_t getRefreshPeriod() const;
 
+	/**
+	* @brief Set the terminal or gateway whose link is delayed,
+	*        before the model initialization
+	*
+	* @param entity_id  the entity id
+	*/
+	void setEntityId(tal_id_t entity_id);
+
 	/**
 	* @brief update the sat delay model current delay
 	*
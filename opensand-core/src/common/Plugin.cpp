@@ -55,6 +55,12 @@ void Plugin::releasePlugins()
 }
 
 
+std::string Plugin::getPluginsSignature()
+{
+	return utils.getPluginsSignature();
+}
+
+
 bool Plugin::getEncapsulationPlugin(std::string name,
                                     EncapPlugin **encapsulation)
 {
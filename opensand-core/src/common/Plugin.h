@@ -127,6 +127,13 @@ public:
 	 */
 	static void getAllEncapsulationPlugins(PluginConfigurationContainer &encapsulation);
 
+	/**
+	 * @brief get the identity of the loaded plugins
+	 *
+	 * @return the plugins signature, it changes with their libraries
+	 */
+	static std::string getPluginsSignature();
+
 	static void generatePluginsConfiguration(std::shared_ptr<OpenSANDConf::MetaComponent> parent,
 	                                         PluginType plugin_type,
 	                                         const std::string &parameter_id,
@@ -45,6 +45,11 @@
 #include <dirent.h>
 #include <errno.h>
 #include <dlfcn.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <set>
 
 #include <opensand_output/Output.h>
 
@@ -58,10 +63,11 @@ PluginUtils::PluginUtils()
 }
 
 
-bool PluginUtils::loadPlugins(bool enable_phy_layer)
+void PluginUtils::findPluginFiles(std::vector<std::string> &files)
 {
 	std::vector<std::string> path;
-	this->log_init = Output::Get()->registerLog(LEVEL_WARNING, "init");
+	std::set<std::string> directories;
+	std::set<std::string> filenames;
 
 	char *lib_path = getenv("LD_LIBRARY_PATH");
 	if(lib_path)
@@ -75,6 +81,16 @@ bool PluginUtils::loadPlugins(bool enable_phy_layer)
 	for(auto& directory : path)
 	{
 		std::string dir = directory + PLUGIN_DIRECTORY;
+
+		// the same folder is often reachable from several paths
+		// (/lib is a link to /usr/lib on most systems), search it once
+		char real_dir[PATH_MAX];
+		if(realpath(dir.c_str(), real_dir) != NULL &&
+		   !directories.insert(real_dir).second)
+		{
+			continue;
+		}
+
 		DIR *plugin_dir = opendir(dir.c_str());
 		if(!plugin_dir)
 		{
@@ -94,101 +110,135 @@ bool PluginUtils::loadPlugins(bool enable_phy_layer)
 			{
 				continue;
 			}
-			if(!filename.compare(filename.length() - PLUGIN_FILE_END.length(),
-			                     PLUGIN_FILE_END.length(),
-								 PLUGIN_FILE_END))
+			if(filename.compare(filename.length() - PLUGIN_FILE_END.length(),
+			                    PLUGIN_FILE_END.length(),
+			                    PLUGIN_FILE_END))
+			{
+				continue;
+			}
+			// a library found in a previous folder takes precedence,
+			// opening its copies would only load the same plugins
+			if(!filenames.insert(filename).second)
 			{
-				std::string plugin_name = dir + filename;
-
 				LOG(this->log_init, LEVEL_INFO,
-				    "find plugin library %s\n", filename.c_str());
-				void *handle = dlopen(plugin_name.c_str(), RTLD_LAZY);
-				if(!handle)
+				    "skip plugin library %s already found\n",
+				    (dir + filename).c_str());
+				continue;
+			}
+			LOG(this->log_init, LEVEL_INFO,
+			    "find plugin library %s\n", filename.c_str());
+			files.push_back(dir + filename);
+		}
+		closedir(plugin_dir);
+	}
+}
+
+
+bool PluginUtils::loadPlugins(bool enable_phy_layer)
+{
+	std::vector<std::string> files;
+	this->log_init = Output::Get()->registerLog(LEVEL_WARNING, "init");
+
+	this->findPluginFiles(files);
+	this->signature = enable_phy_layer ? "phy" : "nophy";
+	for(auto& plugin_name : files)
+	{
+		std::string filename = plugin_name.substr(plugin_name.rfind('/') + 1);
+		struct stat status;
+		if(stat(plugin_name.c_str(), &status) == 0)
+		{
+			this->signature += ";" + plugin_name + ":" + std::to_string(status.st_size) +
+			                   ":" + std::to_string(status.st_mtime);
+		}
+		void *handle = dlopen(plugin_name.c_str(), RTLD_LAZY);
+		if(!handle)
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "cannot load plugin %s (%s)\n",
+			    filename.c_str(), dlerror());
+			continue;
+		}
+
+		void *sym = dlsym(handle, "init");
+		if(!sym)
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "cannot find 'init' method in plugin %s "
+			    "(%s)\n", filename.c_str(), dlerror());
+			dlclose(handle);
+			return false;
+		}
+
+		OpenSandPluginFactory *plugin = reinterpret_cast<fn_init *>(sym)();
+		if(!plugin)
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "cannot create plugin\n");
+			dlclose(handle);
+			continue;
+		}
+
+		switch(plugin->type)
+		{
+			case PluginType::Encapsulation:
+				storePlugin(this->encapsulation, plugin, handle);
+				break;
+
+			case PluginType::SatDelay:
+				storePlugin(this->sat_delay, plugin, handle);
+				break;
+
+			case PluginType::Attenuation:
+				if(!enable_phy_layer)
+				{
+					dlclose(handle);
+				}
+				else
 				{
-					LOG(this->log_init, LEVEL_ERROR,
-					    "cannot load plugin %s (%s)\n",
-					    filename.c_str(), dlerror());
-					continue;
+					storePlugin(this->attenuation, plugin, handle);
 				}
+				break;
 
-				void *sym = dlsym(handle, "init");
-				if(!sym)
+			case PluginType::Minimal:
+				if(!enable_phy_layer)
 				{
-					LOG(this->log_init, LEVEL_ERROR,
-					    "cannot find 'init' method in plugin %s "
-					    "(%s)\n", filename.c_str(), dlerror());
 					dlclose(handle);
-					closedir(plugin_dir);
-					return false;
 				}
+				else
+				{
+					storePlugin(this->minimal, plugin, handle);
+				}
+				break;
 
-				OpenSandPluginFactory *plugin = reinterpret_cast<fn_init *>(sym)();
-				if(!plugin)
+			case PluginType::Error:
+				if(!enable_phy_layer)
 				{
-					LOG(this->log_init, LEVEL_ERROR,
-					    "cannot create plugin\n");
 					dlclose(handle);
-					continue;
 				}
-
-				switch(plugin->type)
+				else
 				{
-					case PluginType::Encapsulation:
-						storePlugin(this->encapsulation, plugin, handle);
-						break;
-
-					case PluginType::SatDelay:
-						storePlugin(this->sat_delay, plugin, handle);
-						break;
-
-					case PluginType::Attenuation:
-						if(!enable_phy_layer)
-						{
-							dlclose(handle);
-						}
-						else
-						{
-							storePlugin(this->attenuation, plugin, handle);
-						}
-						break;
-
-					case PluginType::Minimal:
-						if(!enable_phy_layer)
-						{
-							dlclose(handle);
-						}
-						else
-						{
-							storePlugin(this->minimal, plugin, handle);
-						}
-						break;
-
-					case PluginType::Error:
-						if(!enable_phy_layer)
-						{
-							dlclose(handle);
-						}
-						else
-						{
-							storePlugin(this->error, plugin, handle);
-						}
-						break;
-
-					default:
-						LOG(this->log_init, LEVEL_ERROR,
-						    "Wrong plugin type %d for %s",
-						    plugin->type, filename.c_str());
+					storePlugin(this->error, plugin, handle);
 				}
-				delete plugin;
-			}
+				break;
+
+			default:
+				LOG(this->log_init, LEVEL_ERROR,
+				    "Wrong plugin type %d for %s",
+				    plugin->type, filename.c_str());
 		}
-		closedir(plugin_dir);
+		delete plugin;
 	}
 
 	return true;
 }
 
 
+const std::string &PluginUtils::getPluginsSignature() const
+{
+	return this->signature;
+}
+
+
 void PluginUtils::storePlugin(PluginConfigurationContainer &container, OpenSandPluginFactory *plugin, void *handle)
 {
 	const std::string plugin_name = plugin->name;
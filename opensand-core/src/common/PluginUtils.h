@@ -82,9 +82,20 @@ protected:
 	PluginConfigurationContainer sat_delay;
 	std::vector<void *> handlers;
 	std::vector<OpenSandPlugin *> plugins;
+	/// The identity of the loaded plugin libraries
+	std::string signature;
 
 	PluginUtils();
 
+	/**
+	 * @brief find the plugin libraries in the plugin folders, each folder
+	 *        and each library name being searched only once
+	 *
+	 * @param files  OUT: the paths of the plugin libraries to load,
+	 *               by order of precedence
+	 */
+	void findPluginFiles(std::vector<std::string> &files);
+
 	/**
 	 * @brief load the plugins
 	 *
@@ -93,6 +104,15 @@ protected:
 	 */
 	bool loadPlugins(bool enable_phy_layer);
 
+	/**
+	 * @brief get the identity of the loaded plugins: the path, size and
+	 *        modification time of their libraries, which changes with
+	 *        the configuration they generate
+	 *
+	 * @return the plugins signature
+	 */
+	const std::string &getPluginsSignature() const;
+
 	/**
 	 * @brief store the plugin in the appropirate container
 	 *        Check for duplicates before doing so.
@@ -37,11 +37,28 @@
 #include "MacAddress.h"
 
 
+/// The lifetime of the learned entries, as the default Linux bridges one
+constexpr std::chrono::seconds DEFAULT_AGING_TIME{300};
+
+
 SarpTable::SarpTable(unsigned int max_entries):
-	eth_sarp{}
+	eth_sarp{},
+	eth_sarp_count{0},
+	eth_masks{},
+	eth_configured{},
+	default_dest{0},
+	aging_time{DEFAULT_AGING_TIME}
 {
 	this->max_entries = (max_entries == 0 ? SarpTable::SARP_MAX : max_entries);
 
+	// keep the load factor under one half for short probe sequences
+	std::size_t slots = 1;
+	while(slots < 2 * this->max_entries)
+	{
+		slots <<= 1;
+	}
+	this->eth_sarp.assign(slots, SarpEthEntry{SarpTable::EMPTY_KEY, 0, false, {}});
+
 	// Output Log
 	this->log_sarp = Output::Get()->registerLog(LEVEL_WARNING, "LanAdaptation.SarpTable");
 }
@@ -52,39 +69,212 @@ SarpTable::~SarpTable()
 }
 
 
-bool SarpTable::add(std::unique_ptr<MacAddress> mac_address, tal_id_t tal)
+std::size_t SarpTable::getSlot(uint64_t mac) const
 {
-	LOG(this->log_sarp, LEVEL_INFO,
-	    "add new entry in SARP table (%s)\n",
-	    mac_address->str().c_str());
+	// Fibonacci hashing, the table size is a power of 2
+	return (mac * 0x9E3779B97F4A7C15ULL >> 32) & (this->eth_sarp.size() - 1);
+}
+
+
+std::size_t SarpTable::find(uint64_t mac) const
+{
+	std::size_t mask = this->eth_sarp.size() - 1;
+	for(std::size_t slot = this->getSlot(mac);
+	    this->eth_sarp[slot].mac != SarpTable::EMPTY_KEY;
+	    slot = (slot + 1) & mask)
+	{
+		if(this->eth_sarp[slot].mac == mac)
+		{
+			return slot;
+		}
+	}
+	return this->eth_sarp.size();
+}
+
+
+bool SarpTable::insert(uint64_t mac, tal_id_t tal, bool learned)
+{
+	if(this->eth_sarp_count >= this->max_entries)
+	{
+		return false;
+	}
+
+	std::size_t mask = this->eth_sarp.size() - 1;
+	std::size_t slot = this->getSlot(mac);
+	while(this->eth_sarp[slot].mac != SarpTable::EMPTY_KEY)
+	{
+		slot = (slot + 1) & mask;
+	}
+	this->eth_sarp[slot] = {mac, tal, learned, std::chrono::steady_clock::now()};
+	this->eth_sarp_count++;
+	return true;
+}
+
+
+void SarpTable::erase(std::size_t slot)
+{
+	std::size_t mask = this->eth_sarp.size() - 1;
+	std::size_t hole = slot;
+	for(std::size_t next = (hole + 1) & mask;
+	    this->eth_sarp[next].mac != SarpTable::EMPTY_KEY;
+	    next = (next + 1) & mask)
+	{
+		// move the entry back if the hole is on its probe sequence
+		std::size_t home = this->getSlot(this->eth_sarp[next].mac);
+		if(((next - home) & mask) >= ((next - hole) & mask))
+		{
+			this->eth_sarp[hole] = this->eth_sarp[next];
+			hole = next;
+		}
+	}
+	this->eth_sarp[hole].mac = SarpTable::EMPTY_KEY;
+	this->eth_sarp_count--;
+}
+
+
+void SarpTable::expire(std::chrono::steady_clock::time_point now)
+{
+	std::size_t slot = 0;
+	while(slot < this->eth_sarp.size())
+	{
+		const SarpEthEntry &entry = this->eth_sarp[slot];
+		if(entry.mac != SarpTable::EMPTY_KEY && entry.learned &&
+		   now - entry.last_seen > this->aging_time)
+		{
+			LOG(this->log_sarp, LEVEL_INFO,
+			    "SARP entry %012llx expired\n",
+			    static_cast<unsigned long long>(entry.mac));
+			// an entry may have been moved in this slot
+			this->erase(slot);
+			continue;
+		}
+		++slot;
+	}
+}
+
 
-	if((this->eth_sarp.size() >= this->max_entries) || mac_address == nullptr)
+bool SarpTable::add(std::unique_ptr<MacAddress> mac_address, tal_id_t tal)
+{
+	if(mac_address == nullptr)
 	{
 		LOG(this->log_sarp, LEVEL_ERROR,
-		    "SARP table full or address is empry, "
-		    "cannot add entry\n");
+		    "SARP address is empty, cannot add entry\n");
 		return false;
 	}
 
+	LOG(this->log_sarp, LEVEL_INFO,
+	    "add new entry in SARP table (%s)\n",
+	    mac_address->str().c_str());
+
 	// add entry to if not presents
+	uint64_t mac = mac_address->getKey();
+	uint64_t mask = mac_address->getMask();
 	tal_id_t tal_id = 255;
-	if(!SarpTable::getTalByMac(*mac_address, tal_id))
+	if(mac_address->isGeneric())
+	{
+		for(auto&& entry : this->eth_masks)
+		{
+			if(entry.mac == mac && entry.mask == mask)
+			{
+				return true;
+			}
+		}
+		if(this->eth_masks.size() >= this->max_entries)
+		{
+			LOG(this->log_sarp, LEVEL_ERROR,
+			    "SARP table full, cannot add entry\n");
+			return false;
+		}
+		this->eth_masks.push_back({mac, mask, tal});
+	}
+	else if(!this->getTalByMac(mac, tal_id))
+	{
+		if(!this->insert(mac, tal, false))
+		{
+			LOG(this->log_sarp, LEVEL_ERROR,
+			    "SARP table full, cannot add entry\n");
+			return false;
+		}
+	}
+	else
+	{
+		return true;
+	}
+
+	this->eth_configured.push_back({mac, mask, tal});
+	return true;
+}
+
+
+bool SarpTable::learn(uint64_t mac, tal_id_t tal)
+{
+	auto now = std::chrono::steady_clock::now();
+
+	std::size_t slot = this->find(mac);
+	if(slot < this->eth_sarp.size())
 	{
-		// set entry
-		this->eth_sarp.push_back({std::move(mac_address), tal});
-	}	
+		// refresh the learned entries, a host may have moved
+		SarpEthEntry &entry = this->eth_sarp[slot];
+		if(entry.learned)
+		{
+			entry.tal_id = tal;
+			entry.last_seen = now;
+		}
+		return true;
+	}
+
+	// the addresses matching a generic entry are not learned
+	for(auto&& entry : this->eth_masks)
+	{
+		if((mac & entry.mask) == entry.mac)
+		{
+			return true;
+		}
+	}
 
+	if(this->eth_sarp_count >= this->max_entries)
+	{
+		this->expire(now);
+	}
+	if(!this->insert(mac, tal, true))
+	{
+		LOG(this->log_sarp, LEVEL_ERROR,
+		    "SARP table full, cannot learn entry %012llx\n",
+		    static_cast<unsigned long long>(mac));
+		return false;
+	}
+	LOG(this->log_sarp, LEVEL_INFO,
+	    "learn new entry in SARP table (%012llx)\n",
+	    static_cast<unsigned long long>(mac));
 	return true;
 }
 
 
 bool SarpTable::getTalByMac(const MacAddress &mac_address, tal_id_t &tal_id) const
+{
+	return this->getTalByMac(mac_address.getKey(), tal_id);
+}
+
+
+bool SarpTable::getTalByMac(uint64_t mac, tal_id_t &tal_id) const
 {
 	tal_id = this->default_dest;
 
-	for(auto&& entry : this->eth_sarp)
+	std::size_t slot = this->find(mac);
+	if(slot < this->eth_sarp.size())
+	{
+		const SarpEthEntry &entry = this->eth_sarp[slot];
+		if(!entry.learned ||
+		   std::chrono::steady_clock::now() - entry.last_seen <= this->aging_time)
+		{
+			tal_id = entry.tal_id;
+			return true;
+		}
+	}
+
+	for(auto&& entry : this->eth_masks)
 	{
-		if(entry.mac->matches(&mac_address))
+		if((mac & entry.mask) == entry.mac)
 		{
 			tal_id = entry.tal_id;
 			return true;
@@ -97,16 +287,35 @@ bool SarpTable::getTalByMac(const MacAddress &mac_address, tal_id_t &tal_id) con
 
 bool SarpTable::getMacByTal(tal_id_t tal_id, std::vector<MacAddress> &mac_address) const
 {
-	for(auto&& entry : this->eth_sarp)
+	SarpEthMask found{0, 0, 0};
+	bool is_found = false;
+	for(auto&& entry : this->eth_configured)
 	{
 		if(entry.tal_id == tal_id)
 		{
-			mac_address.emplace_back(entry.mac->str());
-			return true;
+			found = entry;
+			is_found = true;
+			break;
 		}
 	}
+	for(std::size_t slot = 0; !is_found && slot < this->eth_sarp.size(); ++slot)
+	{
+		const SarpEthEntry &entry = this->eth_sarp[slot];
+		if(entry.mac != SarpTable::EMPTY_KEY && entry.tal_id == tal_id)
+		{
+			found.mac = entry.mac;
+			is_found = true;
+		}
+	}
+	if(!is_found)
+	{
+		return false;
+	}
 
-	return false;
+	mac_address.emplace_back((found.mac >> 40) & 0xff, (found.mac >> 32) & 0xff,
+	                         (found.mac >> 24) & 0xff, (found.mac >> 16) & 0xff,
+	                         (found.mac >> 8) & 0xff, found.mac & 0xff);
+	return true;
 }
 
 
@@ -114,3 +323,9 @@ void SarpTable::setDefaultTal(tal_id_t dflt)
 {
 	this->default_dest = dflt;
 }
+
+
+void SarpTable::setAgingTime(std::chrono::steady_clock::duration aging_time)
+{
+	this->aging_time = aging_time;
+}
@@ -35,6 +35,8 @@
 #define SARP_TABLE_H
 
 
+#include <chrono>
+#include <cstdint>
 #include <vector>
 #include <memory>
 
@@ -45,10 +47,21 @@ class MacAddress;
 class OutputLog;
 
 
-/// SARP table entry for Ethernet
+/// SARP table entry for Ethernet, keyed by the packed MAC address
 struct SarpEthEntry
 {
-	std::unique_ptr<MacAddress> mac;
+	uint64_t mac;
+	tal_id_t tal_id;
+	bool learned;  ///< learned from the traffic, subject to aging
+	std::chrono::steady_clock::time_point last_seen;
+};
+
+
+/// SARP table entry for Ethernet matching several MAC addresses
+struct SarpEthMask
+{
+	uint64_t mac;
+	uint64_t mask;
 	tal_id_t tal_id;
 };
 
@@ -56,15 +69,66 @@ struct SarpEthEntry
 /**
  * @class SarpTable
  * @brief SARP table
+ *
+ * The MAC addresses are stored in an open addressing hash table with
+ * linear probing, the entries with generic bytes (e.g. multicast
+ * prefixes) are kept in a separate list checked when no address
+ * matches exactly. The addresses learned from the traffic expire
+ * when they are not seen during the aging time.
  */
 class SarpTable
 {
 private:
-	static constexpr unsigned int SARP_MAX = 50;
+	static constexpr unsigned int SARP_MAX = 4096;
+
+	/// The key of the free slots, not a 48-bit MAC address
+	static constexpr uint64_t EMPTY_KEY = UINT64_MAX;
 
 	unsigned int max_entries;    ///< maximum number of entries in SARP table
-	std::vector<SarpEthEntry> eth_sarp; ///< The Ethernet entries in SARP table
+	std::vector<SarpEthEntry> eth_sarp; ///< The hash table of the Ethernet entries
+	std::size_t eth_sarp_count;  ///< The number of entries in the hash table
+	std::vector<SarpEthMask> eth_masks; ///< The Ethernet entries with generic bytes
+	std::vector<SarpEthMask> eth_configured; ///< The entries added by add, in order
 	tal_id_t default_dest;  ///< the default terminal ID if no entry is found
+	std::chrono::steady_clock::duration aging_time; ///< lifetime of the learned entries
+
+	/**
+	 * @brief Get the first slot of a MAC address in the hash table
+	 *
+	 * @param mac  The packed MAC address
+	 * @return the slot index
+	 */
+	std::size_t getSlot(uint64_t mac) const;
+
+	/**
+	 * @brief Find the slot holding a MAC address
+	 *
+	 * @param mac  The packed MAC address
+	 * @return the slot index, or the size of the table if not found
+	 */
+	std::size_t find(uint64_t mac) const;
+
+	/**
+	 * @brief Store a MAC address in the hash table
+	 *
+	 * @return true on success, false if the table is full
+	 */
+	bool insert(uint64_t mac, tal_id_t tal, bool learned);
+
+	/**
+	 * @brief Remove the entry of a slot, moving back the following ones
+	 *        of the probe sequence so the lookups need no tombstone
+	 *
+	 * @param slot  The slot index
+	 */
+	void erase(std::size_t slot);
+
+	/**
+	 * @brief Remove the learned entries older than the aging time
+	 *
+	 * @param now  The current time
+	 */
+	void expire(std::chrono::steady_clock::time_point now);
 
 protected:
 	// Output Log
@@ -85,7 +149,7 @@ public:
 	~SarpTable();
 
 	/**
-	 * Add an Ethernet entry in the SARP table
+	 * Add an Ethernet entry in the SARP table, it never expires
 	 *
 	 * @param max_addr  the MAC address for the SARP entry
 	 * @param tal the tal ID associated with the IP address
@@ -94,6 +158,18 @@ public:
 	 */
 	bool add(std::unique_ptr<MacAddress> mac_address, tal_id_t tal);
 
+	/**
+	 * Learn the terminal behind a MAC address seen in the traffic,
+	 * the entry expires if the address is not seen again during the
+	 * aging time
+	 *
+	 * @param mac  the packed MAC address
+	 * @param tal  the tal ID the address was seen from
+	 * @return true if the entry was successfully added or refreshed,
+	 *         false if the table is full
+	 */
+	bool learn(uint64_t mac, tal_id_t tal);
+
 	/**
 	 * Get the tal ID associated with the MAC address in the SARP table
 	 *
@@ -104,6 +180,16 @@ public:
 	 */
 	bool getTalByMac(const MacAddress &mac_address, tal_id_t &tal_id) const;
 
+	/**
+	 * Get the tal ID associated with a packed MAC address in the SARP table
+	 *
+	 * @param mac     the packed MAC address to search for
+	 * @param tal_id  the tal ID associated with the MAC address if found
+	 *                the default tal_id otherwise (false will be returned)
+	 * @return true on success, false otherwise
+	 */
+	bool getTalByMac(uint64_t mac, tal_id_t &tal_id) const;
+
 	/**
 	 * Get the MAC address associated with the terminal ID in the SARP table
 	 *
@@ -119,6 +205,13 @@ public:
 	 * @param dlft  the default terminal ID
 	 */
 	void setDefaultTal(tal_id_t dflt);
+
+	/**
+	 * @brief Set the lifetime of the learned entries
+	 *
+	 * @param aging_time  the time after which an entry not seen expires
+	 */
+	void setAgingTime(std::chrono::steady_clock::duration aging_time);
 };
 
 
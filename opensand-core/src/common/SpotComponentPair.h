@@ -36,6 +36,10 @@
 #ifndef SPOTCOMPONENTPAIR_H
 #define SPOTCOMPONENTPAIR_H
 
+#include <limits>
+
+#include <opensand_rt/RtDemuxFifos.h>
+
 #include "OpenSandCore.h"
 
 
@@ -92,4 +96,21 @@ struct hash<IslComponentPair>
 };
 } // namespace std
 
+
+/**
+ * @brief The regenerative spot components select the fifos of the
+ *        satellite dispatcher in an array: 8 bits of spot ID, 2 bits
+ *        of component and the transparency
+ */
+template <>
+struct RtDenseKey<RegenerativeSpotComponent>
+{
+	static constexpr bool dense = true;
+	static constexpr std::size_t size = (std::numeric_limits<spot_id_t>::max() + 1) << 3;
+	static constexpr std::size_t index(const RegenerativeSpotComponent &key)
+	{
+		return key.spot_id << 3 | to_underlying(key.dest) << 1 | key.is_transparent;
+	}
+};
+
 #endif
@@ -0,0 +1,298 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file TerminalMap.h
+ * @brief A map of terminals stored in a vector indexed by terminal ID
+ * @author Viveris Technologies
+ */
+
+#ifndef TERMINAL_MAP_H
+#define TERMINAL_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "OpenSandCore.h"
+
+
+/**
+ * @class TerminalMap
+ * @brief A map keyed by terminal ID with the std::map interface used by the
+ *        DAMA, FMT and SALOHA components but stored in a vector indexed by
+ *        the terminal ID, the IDs being small integers there is no tree to
+ *        walk on lookups and iterations go through contiguous memory in the
+ *        terminal ID order.
+ *
+ * The generation counter changes each time a terminal is added or removed
+ * so that data derived from the terminals list can be kept while it does
+ * not change.
+ */
+template<class T>
+class TerminalMap
+{
+public:
+	typedef tal_id_t key_type;
+	typedef T mapped_type;
+	typedef std::pair<const tal_id_t, T> value_type;
+	typedef std::size_t size_type;
+
+private:
+	typedef std::vector<std::optional<value_type>> slots_t;
+
+	/**
+	 * @brief Iterate on the used slots
+	 */
+	template<class Slots, class Value>
+	class Iterator
+	{
+		friend class TerminalMap;
+
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef Value value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef Value *pointer;
+		typedef Value &reference;
+
+		Iterator(): slots{nullptr}, index{0} {};
+
+		/// allow the conversion of an iterator in a const_iterator
+		template<class OtherSlots, class OtherValue>
+		Iterator(const Iterator<OtherSlots, OtherValue> &other):
+			slots{other.slots},
+			index{other.index}
+		{
+		};
+
+		reference operator*() const { return *(*this->slots)[this->index]; };
+		pointer operator->() const { return &*(*this->slots)[this->index]; };
+
+		Iterator &operator++()
+		{
+			this->index++;
+			this->skip();
+			return *this;
+		};
+
+		Iterator operator++(int)
+		{
+			Iterator previous = *this;
+			++(*this);
+			return previous;
+		};
+
+		bool operator==(const Iterator &other) const { return this->index == other.index; };
+		bool operator!=(const Iterator &other) const { return this->index != other.index; };
+
+	private:
+		template<class, class> friend class Iterator;
+
+		Iterator(Slots *slots, std::size_t index):
+			slots{slots},
+			index{index}
+		{
+			this->skip();
+		};
+
+		/// go to the next used slot
+		void skip()
+		{
+			while(this->index < this->slots->size() && !(*this->slots)[this->index])
+			{
+				this->index++;
+			}
+		};
+
+		Slots *slots;
+		std::size_t index;
+	};
+
+public:
+	typedef Iterator<slots_t, value_type> iterator;
+	typedef Iterator<const slots_t, const value_type> const_iterator;
+
+	TerminalMap(): slots{}, nb_terminals{0}, generation{0} {};
+
+	iterator begin() { return iterator(&this->slots, 0); };
+	iterator end() { return iterator(&this->slots, this->slots.size()); };
+	const_iterator begin() const { return const_iterator(&this->slots, 0); };
+	const_iterator end() const { return const_iterator(&this->slots, this->slots.size()); };
+
+	/**
+	 * @brief Get the number of terminals
+	 *
+	 * @return the number of terminals
+	 */
+	size_type size() const { return this->nb_terminals; };
+
+	/**
+	 * @brief Check whether there is no terminal
+	 *
+	 * @return true if there is no terminal, false otherwise
+	 */
+	bool empty() const { return this->nb_terminals == 0; };
+
+	/**
+	 * @brief Get the generation of the terminals list
+	 *
+	 * @return a value that changes each time a terminal is added or removed
+	 */
+	uint32_t getGeneration() const { return this->generation; };
+
+	/**
+	 * @brief Find a terminal
+	 *
+	 * @param tal_id  The terminal ID
+	 * @return an iterator on the terminal, end() if it is not registered
+	 */
+	iterator find(tal_id_t tal_id)
+	{
+		return this->contains(tal_id) ? iterator(&this->slots, tal_id) : this->end();
+	};
+
+	const_iterator find(tal_id_t tal_id) const
+	{
+		return this->contains(tal_id) ? const_iterator(&this->slots, tal_id) : this->end();
+	};
+
+	/**
+	 * @brief Check whether a terminal is registered
+	 *
+	 * @param tal_id  The terminal ID
+	 * @return 1 if the terminal is registered, 0 otherwise
+	 */
+	size_type count(tal_id_t tal_id) const { return this->contains(tal_id) ? 1 : 0; };
+
+	/**
+	 * @brief Add a terminal if it is not already registered
+	 *
+	 * @param tal_id  The terminal ID
+	 * @param args    The arguments to construct the terminal value
+	 * @return an iterator on the terminal and true if it was added,
+	 *         false if it was already registered
+	 */
+	template<class... Args>
+	std::pair<iterator, bool> emplace(tal_id_t tal_id, Args &&... args)
+	{
+		if(this->contains(tal_id))
+		{
+			return {iterator(&this->slots, tal_id), false};
+		}
+		if(this->slots.size() <= tal_id)
+		{
+			this->slots.resize(tal_id + 1);
+		}
+		this->slots[tal_id].emplace(std::piecewise_construct,
+		                            std::forward_as_tuple(tal_id),
+		                            std::forward_as_tuple(std::forward<Args>(args)...));
+		this->nb_terminals++;
+		this->generation++;
+		return {iterator(&this->slots, tal_id), true};
+	};
+
+	std::pair<iterator, bool> insert(const value_type &value)
+	{
+		return this->emplace(value.first, value.second);
+	};
+
+	/**
+	 * @brief Get a terminal value, it is added with a default value
+	 *        if it is not registered
+	 *
+	 * @param tal_id  The terminal ID
+	 * @return the terminal value
+	 */
+	T &operator[](tal_id_t tal_id)
+	{
+		return this->emplace(tal_id).first->second;
+	};
+
+	/**
+	 * @brief Remove a terminal
+	 *
+	 * @param tal_id  The terminal ID
+	 * @return the number of removed terminals
+	 */
+	size_type erase(tal_id_t tal_id)
+	{
+		if(!this->contains(tal_id))
+		{
+			return 0;
+		}
+		this->slots[tal_id].reset();
+		this->nb_terminals--;
+		this->generation++;
+		return 1;
+	};
+
+	/**
+	 * @brief Remove a terminal
+	 *
+	 * @param it  An iterator on the terminal
+	 * @return an iterator on the next terminal
+	 */
+	iterator erase(const_iterator it)
+	{
+		size_type tal_id = it.index;
+		this->erase(static_cast<tal_id_t>(tal_id));
+		return iterator(&this->slots, tal_id + 1);
+	};
+
+	/**
+	 * @brief Remove all the terminals
+	 */
+	void clear()
+	{
+		this->slots.clear();
+		this->nb_terminals = 0;
+		this->generation++;
+	};
+
+private:
+	bool contains(tal_id_t tal_id) const
+	{
+		return tal_id < this->slots.size() && this->slots[tal_id];
+	};
+
+	/// The terminals indexed by ID, empty for unregistered IDs
+	slots_t slots;
+
+	/// The number of registered terminals
+	size_type nb_terminals;
+
+	/// Changed each time a terminal is added or removed
+	uint32_t generation;
+};
+
+
+#endif
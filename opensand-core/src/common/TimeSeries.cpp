@@ -0,0 +1,508 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file TimeSeries.cpp
+ * @brief A time series of values read from a trace file, with linear
+ *        interpolation between the entries
+ * @author Viveris Technologies
+ */
+
+
+#include "TimeSeries.h"
+
+#include <opensand_output/Output.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+constexpr char TimeSeries::magic[8];
+
+
+TimeSeries::TimeSeries():
+	values{nullptr},
+	times{nullptr},
+	count{0},
+	index{nullptr},
+	bucket_count{0},
+	first_time{0},
+	last_time{0},
+	bucket_width{1},
+	max_value{0},
+	value_buffer{},
+	time_buffer{},
+	index_buffer{},
+	mapping{nullptr},
+	mapping_length{0},
+	prefetch_position{0}
+{
+}
+
+
+TimeSeries::~TimeSeries()
+{
+	this->clear();
+}
+
+
+void TimeSeries::clear()
+{
+	if(this->mapping != nullptr)
+	{
+		munmap(this->mapping, this->mapping_length);
+		this->mapping = nullptr;
+		this->mapping_length = 0;
+	}
+	this->value_buffer.clear();
+	this->time_buffer.clear();
+	this->index_buffer.clear();
+	this->values = nullptr;
+	this->times = nullptr;
+	this->index = nullptr;
+	this->count = 0;
+	this->bucket_count = 0;
+	this->prefetch_position = 0;
+}
+
+
+bool TimeSeries::load(const std::string &filename, std::shared_ptr<OutputLog> log)
+{
+	this->clear();
+
+	int fd = open(filename.c_str(), O_RDONLY);
+	if(fd < 0)
+	{
+		LOG(log, LEVEL_ERROR,
+		    "Cannot open file %s: %s\n", filename.c_str(), strerror(errno));
+		return false;
+	}
+
+	struct stat status;
+	if(fstat(fd, &status) < 0 || status.st_size == 0)
+	{
+		LOG(log, LEVEL_ERROR,
+		    "File %s is empty or cannot be read\n", filename.c_str());
+		close(fd);
+		return false;
+	}
+
+	std::size_t length = status.st_size;
+	void *memory = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(memory == MAP_FAILED)
+	{
+		LOG(log, LEVEL_ERROR,
+		    "Cannot map file %s: %s\n", filename.c_str(), strerror(errno));
+		return false;
+	}
+	this->mapping = memory;
+	this->mapping_length = length;
+
+	const unsigned char *content = static_cast<const unsigned char *>(memory);
+	bool loaded;
+	if(length >= sizeof(magic) && memcmp(content, magic, sizeof(magic)) == 0)
+	{
+		loaded = this->loadBinary(filename, content, length, log);
+	}
+	else
+	{
+		madvise(memory, length, MADV_SEQUENTIAL);
+		loaded = this->loadText(filename, content, length, log);
+		// the entries are copied, the text is not needed anymore
+		munmap(this->mapping, this->mapping_length);
+		this->mapping = nullptr;
+		this->mapping_length = 0;
+	}
+
+	if(!loaded)
+	{
+		this->clear();
+		return false;
+	}
+
+	this->max_value = *std::max_element(this->values, this->values + this->count);
+	LOG(log, LEVEL_INFO,
+	    "Trace %s loaded: %zu entries from %u to %u\n",
+	    filename.c_str(), this->count, this->first_time, this->last_time);
+	return true;
+}
+
+
+bool TimeSeries::loadBinary(const std::string &filename,
+                            const unsigned char *content,
+                            std::size_t length,
+                            std::shared_ptr<OutputLog> log)
+{
+	time_series_header_t header;
+	if(length < sizeof(header))
+	{
+		LOG(log, LEVEL_ERROR,
+		    "Truncated header in trace file %s\n", filename.c_str());
+		return false;
+	}
+	memcpy(&header, content, sizeof(header));
+
+	std::size_t expected = sizeof(header) +
+	                       header.count * sizeof(double) +
+	                       header.count * sizeof(uint32_t) +
+	                       header.bucket_count * sizeof(uint32_t);
+	if(header.count == 0 || header.bucket_count == 0 ||
+	   header.bucket_width == 0 || length != expected)
+	{
+		LOG(log, LEVEL_ERROR,
+		    "Malformed trace file %s: %u entries and %u buckets "
+		    "announced for %zu bytes\n",
+		    filename.c_str(), header.count, header.bucket_count, length);
+		return false;
+	}
+
+	// the header keeps the values aligned on 8 bytes
+	this->values = reinterpret_cast<const double *>(content + sizeof(header));
+	this->times = reinterpret_cast<const uint32_t *>(this->values + header.count);
+	this->index = this->times + header.count;
+	this->count = header.count;
+	this->bucket_count = header.bucket_count;
+	this->first_time = header.first_time;
+	this->last_time = this->times[this->count - 1];
+	this->bucket_width = header.bucket_width;
+
+	if(this->times[0] != this->first_time ||
+	   (this->last_time - this->first_time) / this->bucket_width >= this->bucket_count)
+	{
+		LOG(log, LEVEL_ERROR,
+		    "Malformed trace file %s: the index does not cover "
+		    "the entries\n", filename.c_str());
+		return false;
+	}
+
+	// the pages are only read when the emulation reaches them
+	madvise(this->mapping, this->mapping_length, MADV_RANDOM);
+	this->prefetch(0);
+	return true;
+}
+
+
+bool TimeSeries::loadText(const std::string &filename,
+                          const unsigned char *content,
+                          std::size_t length,
+                          std::shared_ptr<OutputLog> log)
+{
+	const char *position = reinterpret_cast<const char *>(content);
+	const char *end = position + length;
+	unsigned int line_number = 0;
+
+	auto is_blank = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+	auto is_separator = [](char c) { return c == ' ' || c == '\t' || c == ',' || c == ';'; };
+
+	while(position < end)
+	{
+		const char *line_end = static_cast<const char *>(memchr(position, '\n', end - position));
+		if(line_end == nullptr)
+		{
+			line_end = end;
+		}
+		line_number++;
+
+		const char *cursor = position;
+		position = line_end + 1;
+		while(cursor < line_end && is_blank(*cursor))
+		{
+			cursor++;
+		}
+		// skip line if empty or commented
+		if(cursor == line_end || *cursor == '#')
+		{
+			continue;
+		}
+
+		uint32_t time;
+		auto result = std::from_chars(cursor, line_end, time);
+		if(result.ec != std::errc())
+		{
+			LOG(log, LEVEL_ERROR,
+			    "Bad syntax in file '%s', line %u: "
+			    "there should be a timestamp (integer) "
+			    "instead of '%.*s'\n",
+			    filename.c_str(), line_number,
+			    static_cast<int>(line_end - cursor), cursor);
+			return false;
+		}
+
+		cursor = result.ptr;
+		while(cursor < line_end && is_separator(*cursor))
+		{
+			cursor++;
+		}
+
+		double value;
+		result = std::from_chars(cursor, line_end, value);
+		if(result.ec != std::errc())
+		{
+			LOG(log, LEVEL_ERROR,
+			    "Error while parsing the value of line %u in file '%s'\n",
+			    line_number, filename.c_str());
+			return false;
+		}
+
+		this->time_buffer.push_back(time);
+		this->value_buffer.push_back(value);
+	}
+
+	if(this->time_buffer.empty())
+	{
+		LOG(log, LEVEL_ERROR,
+		    "No entry in trace file '%s'\n", filename.c_str());
+		return false;
+	}
+
+	this->buildIndex();
+	return true;
+}
+
+
+void TimeSeries::buildIndex()
+{
+	std::size_t entries = this->time_buffer.size();
+	if(!std::is_sorted(this->time_buffer.begin(), this->time_buffer.end()) ||
+	   std::adjacent_find(this->time_buffer.begin(), this->time_buffer.end()) != this->time_buffer.end())
+	{
+		std::vector<std::size_t> order(entries);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(),
+		                 [this](std::size_t a, std::size_t b)
+		                 {
+		                     return this->time_buffer[a] < this->time_buffer[b];
+		                 });
+
+		std::vector<uint32_t> sorted_times;
+		std::vector<double> sorted_values;
+		sorted_times.reserve(entries);
+		sorted_values.reserve(entries);
+		for(std::size_t position : order)
+		{
+			uint32_t time = this->time_buffer[position];
+			if(!sorted_times.empty() && sorted_times.back() == time)
+			{
+				// the last entry of a given time wins
+				sorted_values.back() = this->value_buffer[position];
+				continue;
+			}
+			sorted_times.push_back(time);
+			sorted_values.push_back(this->value_buffer[position]);
+		}
+		this->time_buffer.swap(sorted_times);
+		this->value_buffer.swap(sorted_values);
+		entries = this->time_buffer.size();
+	}
+	this->time_buffer.shrink_to_fit();
+	this->value_buffer.shrink_to_fit();
+
+	this->first_time = this->time_buffer.front();
+	this->last_time = this->time_buffer.back();
+	// about one entry per bucket
+	uint64_t range = uint64_t(this->last_time) - this->first_time;
+	this->bucket_width = range / entries + 1;
+	this->bucket_count = range / this->bucket_width + 1;
+
+	this->index_buffer.resize(this->bucket_count);
+	std::size_t position = 0;
+	for(std::size_t bucket = 0; bucket < this->bucket_count; ++bucket)
+	{
+		uint64_t start = this->first_time + uint64_t(bucket) * this->bucket_width;
+		while(this->time_buffer[position] < start)
+		{
+			position++;
+		}
+		this->index_buffer[bucket] = position;
+	}
+
+	this->values = this->value_buffer.data();
+	this->times = this->time_buffer.data();
+	this->index = this->index_buffer.data();
+	this->count = entries;
+}
+
+
+bool TimeSeries::save(const std::string &filename, std::shared_ptr<OutputLog> log) const
+{
+	if(this->count == 0)
+	{
+		LOG(log, LEVEL_ERROR,
+		    "Cannot save an empty trace in %s\n", filename.c_str());
+		return false;
+	}
+
+	time_series_header_t header;
+	memcpy(header.magic, magic, sizeof(magic));
+	header.count = this->count;
+	header.bucket_count = this->bucket_count;
+	header.first_time = this->first_time;
+	header.bucket_width = this->bucket_width;
+
+	std::ofstream file{filename, std::ios::binary | std::ios::trunc};
+	file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char *>(this->values), this->count * sizeof(double));
+	file.write(reinterpret_cast<const char *>(this->times), this->count * sizeof(uint32_t));
+	file.write(reinterpret_cast<const char *>(this->index), this->bucket_count * sizeof(uint32_t));
+	file.close();
+	if(!file)
+	{
+		LOG(log, LEVEL_ERROR,
+		    "Cannot write trace file %s\n", filename.c_str());
+		return false;
+	}
+	return true;
+}
+
+
+std::size_t TimeSeries::compact(double tolerance)
+{
+	if(this->count < 3)
+	{
+		return 0;
+	}
+
+	// work on copies when the entries are mapped
+	if(this->values != this->value_buffer.data())
+	{
+		this->value_buffer.assign(this->values, this->values + this->count);
+		this->time_buffer.assign(this->times, this->times + this->count);
+	}
+
+	// an entry is removed if the line from the last kept entry to the
+	// next one passes close enough to it and to the entries removed
+	// since, they bound the slopes of the lines allowed
+	std::size_t kept = 1;
+	double low_slope = -std::numeric_limits<double>::infinity();
+	double high_slope = std::numeric_limits<double>::infinity();
+	for(std::size_t position = 1; position + 1 < this->count; ++position)
+	{
+		uint32_t start_time = this->time_buffer[kept - 1];
+		double start_value = this->value_buffer[kept - 1];
+		double value = this->value_buffer[position];
+		double span = double(this->time_buffer[position]) - start_time;
+		low_slope = std::max(low_slope, (value - tolerance - start_value) / span);
+		high_slope = std::min(high_slope, (value + tolerance - start_value) / span);
+
+		double slope = (this->value_buffer[position + 1] - start_value) /
+		               (double(this->time_buffer[position + 1]) - start_time);
+		if(slope < low_slope || slope > high_slope)
+		{
+			this->time_buffer[kept] = this->time_buffer[position];
+			this->value_buffer[kept] = value;
+			kept++;
+			low_slope = -std::numeric_limits<double>::infinity();
+			high_slope = std::numeric_limits<double>::infinity();
+		}
+	}
+	this->time_buffer[kept] = this->time_buffer[this->count - 1];
+	this->value_buffer[kept] = this->value_buffer[this->count - 1];
+	kept++;
+
+	std::size_t removed = this->count - kept;
+	this->time_buffer.resize(kept);
+	this->value_buffer.resize(kept);
+	if(this->mapping != nullptr)
+	{
+		munmap(this->mapping, this->mapping_length);
+		this->mapping = nullptr;
+		this->mapping_length = 0;
+	}
+	this->buildIndex();
+	return removed;
+}
+
+
+void TimeSeries::prefetch(std::size_t position) const
+{
+	std::size_t end = std::min(position + prefetch_window, this->count);
+	long page = sysconf(_SC_PAGESIZE);
+	auto advise = [page](const void *first, const void *last)
+	{
+		uintptr_t start = reinterpret_cast<uintptr_t>(first) & ~uintptr_t(page - 1);
+		madvise(reinterpret_cast<void *>(start),
+		        reinterpret_cast<uintptr_t>(last) - start,
+		        MADV_WILLNEED);
+	};
+	advise(this->values + position, this->values + end);
+	advise(this->times + position, this->times + end);
+	// read the next window when half of this one is reached
+	this->prefetch_position = position + prefetch_window / 2;
+}
+
+
+bool TimeSeries::getValue(uint32_t time, double &value) const
+{
+	if(this->count == 0 || time > this->last_time)
+	{
+		return false;
+	}
+	if(time <= this->first_time)
+	{
+		value = this->values[0];
+		return true;
+	}
+
+	// first entry whose time is equal or greater than time,
+	// the last entry stops the search
+	std::size_t bucket = (time - this->first_time) / this->bucket_width;
+	std::size_t position = std::min<std::size_t>(this->index[bucket], this->count - 1);
+	while(this->times[position] < time)
+	{
+		position++;
+	}
+	if(position >= this->prefetch_position && this->mapping != nullptr)
+	{
+		this->prefetch(position);
+	}
+	if(position == 0 || this->times[position] == time)
+	{
+		value = this->values[position];
+		return true;
+	}
+
+	// linear interpolation
+	uint32_t old_time = this->times[position - 1];
+	double old_value = this->values[position - 1];
+	double coef = (this->values[position] - old_value) /
+	              (double(this->times[position]) - old_time);
+	value = old_value + coef * (time - old_time);
+	return true;
+}
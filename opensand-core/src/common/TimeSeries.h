@@ -0,0 +1,242 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file TimeSeries.h
+ * @brief A time series of values read from a trace file, with linear
+ *        interpolation between the entries
+ * @author Viveris Technologies
+ */
+
+#ifndef TIME_SERIES_H
+#define TIME_SERIES_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+class OutputLog;
+
+
+/**
+ * @brief The header of a binary time series file, in host byte order
+ *
+ * It is followed by the values (double), the times (uint32_t) and the
+ * index of the first entry of each bucket (uint32_t).
+ */
+struct time_series_header_t
+{
+	char magic[8];
+	uint32_t count;
+	uint32_t bucket_count;
+	uint32_t first_time;
+	uint32_t bucket_width;
+} __attribute__((__packed__));
+
+
+/**
+ * @class TimeSeries
+ * @brief A trace of values indexed by time
+ *
+ * The traces are either text files with one "time value" entry per line
+ * (lines starting with '#' are comments), or binary files produced from
+ * them by opensand_convert_trace that are mapped in memory as is.
+ *
+ * The entries are kept in two compact arrays sorted by time. The time
+ * range is split in buckets of the same width that give the first entry
+ * of each bucket, so a lookup only reads a couple of entries.
+ */
+class TimeSeries
+{
+public:
+	/// The magic number at the start of the binary files
+	static constexpr char magic[8] = {'O', 'S', 'N', 'D', 'T', 'S', '0', '1'};
+
+	TimeSeries();
+	~TimeSeries();
+
+	TimeSeries(const TimeSeries &) = delete;
+	TimeSeries &operator=(const TimeSeries &) = delete;
+
+	/**
+	 * @brief Load a trace, binary or text depending on its first bytes
+	 *
+	 * @param filename  The trace file name
+	 * @param log       The log for errors
+	 * @return true on success, false otherwise
+	 */
+	bool load(const std::string &filename, std::shared_ptr<OutputLog> log);
+
+	/**
+	 * @brief Save the trace in the binary format
+	 *
+	 * @param filename  The binary file name
+	 * @param log       The log for errors
+	 * @return true on success, false otherwise
+	 */
+	bool save(const std::string &filename, std::shared_ptr<OutputLog> log) const;
+
+	/**
+	 * @brief Remove the entries that the interpolation between their
+	 *        neighbours gives back, so the constant or linear runs
+	 *        of a trace only keep their ends
+	 *
+	 * @param tolerance  The greatest error allowed on a removed entry,
+	 *                   0 to keep the interpolated values unchanged
+	 * @return the number of entries removed
+	 */
+	std::size_t compact(double tolerance = 0);
+
+	/**
+	 * @brief Get the value at a given time, interpolated between the
+	 *        surrounding entries
+	 *
+	 * Before the first entry, the first value is used.
+	 *
+	 * @param time   The time
+	 * @param value  OUT: the value
+	 * @return true on success, false if the time is after the last entry
+	 */
+	bool getValue(uint32_t time, double &value) const;
+
+	/**
+	 * @brief Get the number of entries
+	 *
+	 * @return the number of entries
+	 */
+	std::size_t size() const { return this->count; };
+
+	/**
+	 * @brief Get the value of the first entry
+	 *
+	 * @return the first value
+	 */
+	double getFirstValue() const { return this->values[0]; };
+
+	/**
+	 * @brief Get the value of the last entry
+	 *
+	 * @return the last value
+	 */
+	double getLastValue() const { return this->values[this->count - 1]; };
+
+	/**
+	 * @brief Get the greatest value of the trace
+	 *
+	 * @return the greatest value
+	 */
+	double getMaxValue() const { return this->max_value; };
+
+private:
+	/**
+	 * @brief Map a binary trace in memory
+	 *
+	 * @param filename  The trace file name
+	 * @param mapping   The trace mapped in memory
+	 * @param length    The trace length
+	 * @param log       The log for errors
+	 * @return true on success, false otherwise
+	 */
+	bool loadBinary(const std::string &filename,
+	                const unsigned char *mapping,
+	                std::size_t length,
+	                std::shared_ptr<OutputLog> log);
+
+	/**
+	 * @brief Parse a text trace
+	 *
+	 * @param filename  The trace file name
+	 * @param mapping   The trace mapped in memory
+	 * @param length    The trace length
+	 * @param log       The log for errors
+	 * @return true on success, false otherwise
+	 */
+	bool loadText(const std::string &filename,
+	              const unsigned char *mapping,
+	              std::size_t length,
+	              std::shared_ptr<OutputLog> log);
+
+	/**
+	 * @brief Sort the parsed entries by time, the last entry of
+	 *        a given time wins, and build the bucket index
+	 */
+	void buildIndex();
+
+	/**
+	 * @brief Release the entries and the mapping
+	 */
+	void clear();
+
+	/// The values of the entries
+	const double *values;
+	/// The times of the entries, in ascending order
+	const uint32_t *times;
+	/// The number of entries
+	std::size_t count;
+	/// The first entry of each bucket
+	const uint32_t *index;
+	/// The number of buckets
+	std::size_t bucket_count;
+	/// The time of the first entry
+	uint32_t first_time;
+	/// The time of the last entry
+	uint32_t last_time;
+	/// The time range covered by a bucket
+	uint32_t bucket_width;
+	/// The greatest value
+	double max_value;
+
+	/// The storage of the entries parsed from a text trace
+	std::vector<double> value_buffer;
+	std::vector<uint32_t> time_buffer;
+	std::vector<uint32_t> index_buffer;
+
+	/// The binary trace mapped in memory
+	void *mapping;
+	std::size_t mapping_length;
+
+	/// The number of entries read ahead in a mapped trace at once
+	static constexpr std::size_t prefetch_window = 8192;
+
+	/// The entry from which the next window of a mapped trace is read ahead
+	mutable std::size_t prefetch_position;
+
+	/**
+	 * @brief Ask the kernel to read the next entries of a mapped trace
+	 *        in the background, the lookups move forward in time
+	 *
+	 * @param position  The entry reached by the last lookup
+	 */
+	void prefetch(std::size_t position) const;
+};
+
+#endif
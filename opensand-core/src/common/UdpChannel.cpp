@@ -42,9 +42,15 @@
 #include <sys/types.h>
 #include <sys/ioctl.h>
 #include <linux/if_packet.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#include <time.h>
+#include <algorithm>
+#include <climits>
 
 #include <opensand_output/Output.h>
 #include <opensand_rt/NetSocketEvent.h>
+#include <opensand_rt/RtTrace.h>
 
 #include "UdpChannel.h"
 
@@ -85,8 +91,42 @@ UdpChannel::UdpChannel(std::string name,
 	init_success(false),
 	sock_channel(-1),
 	m_multicast(multicast),
-	stacked_ip(""),
-	max_stack(stack)
+	counter(0),
+	send_queue(),
+	send_counters(),
+	send_owners(),
+	send_iovecs(),
+	send_msgs(),
+	pacing(Pacing::none),
+	pacing_ns_per_byte(0),
+	next_departure_ns(0),
+	send_controls(),
+	timestamping(false),
+	send_timestamps(),
+	sent_datagrams(),
+	next_datagram_id(0),
+	recv_controls(),
+	recv_timestamps(),
+	last_timestamp(0),
+	recv_buffers(),
+	recv_iovecs(),
+	recv_msgs(),
+	recv_addrs(),
+	recv_count(0),
+	recv_index(0),
+	stacks(),
+	last_source(0),
+	last_stack(nullptr),
+	stacked(nullptr),
+	max_stack(stack),
+	probe_lost(nullptr),
+	probe_reordered(nullptr),
+	probe_late(nullptr),
+	probe_prefix(name + "." + std::to_string(s_id) + "." + std::to_string(channel_id)),
+	probe_socket_residency(nullptr),
+	probe_queue_residency(nullptr),
+	probe_kernel_residency(nullptr),
+	probe_emulator_residency(nullptr)
 {
 	struct ip_mreq imr;
 	unsigned char ttl = 1;
@@ -181,6 +221,17 @@ UdpChannel::UdpChannel(std::string name,
 		LOG(this->log_init, LEVEL_NOTICE,
 		    "size of socket buffer: %d \n", rmem);
 
+		// sequencing statistics, the probes already exist
+		// if another channel uses the same name and ID
+		const std::string &prefix = this->probe_prefix;
+		auto output = Output::Get();
+		this->probe_lost =
+		    output->registerProbe<int>(prefix + ".UDP lost", "datagrams", true, SAMPLE_SUM);
+		this->probe_reordered =
+		    output->registerProbe<int>(prefix + ".UDP reordered", "datagrams", true, SAMPLE_SUM);
+		this->probe_late =
+		    output->registerProbe<int>(prefix + ".UDP late", "datagrams", true, SAMPLE_SUM);
+
 		if(this->m_multicast)
 		{
 			if(inet_aton(ip_addr.c_str(), &this->m_socketAddr.sin_addr) < 0)
@@ -235,7 +286,9 @@ UdpChannel::UdpChannel(std::string name,
 		    "channel doesn't receive and doesn't send data\n");
 		goto error;
 	}
-	bzero(this->send_buffer, sizeof(this->send_buffer));
+	this->send_queue.reserve(max_batch);
+	this->send_counters.reserve(max_batch);
+	this->send_owners.reserve(max_batch);
 
 	LOG(this->log_init, LEVEL_NOTICE,
 	    "UDP channel %u created with local IP %s and local "
@@ -257,13 +310,6 @@ error:
 UdpChannel::~UdpChannel()
 {
 	close(this->sock_channel);
-	this->udp_counters.clear();
-	for(std::map<std::string, UdpStack *>::iterator it = this->stacks.begin();
-	    it != this->stacks.end(); ++it)
-	{
-		delete (*it).second;
-	}
-	this->stacks.clear();
 }
 
 
@@ -331,203 +377,351 @@ spot_id_t UdpChannel::getSpotId()
  *                 called another time, -1 on error
  */
 // TODO why not work directly with Data here instead of buf, length
-int UdpChannel::receive(NetSocketEvent *const event,
-                        unsigned char **buf, size_t &data_len)
+int UdpChannel::receive(NetSocketEvent *const event, Data &packet)
 {
-	struct sockaddr_in remote_addr;
-	std::map<std::string , uint8_t>::iterator ip_count_it;
-	std::string ip_address;
-	uint8_t nb_sequencing;
-	uint8_t current_sequencing;
 	unsigned char *data;
-	size_t recv_len;
-	unsigned char *recv_data;
+	int ret;
 
-	if(!this->stacked_ip.empty())
+	packet.clear();
+
+	if(this->stacked != nullptr)
+	{
+		ret = this->handleStack(packet);
+	}
+	else if(this->recv_index < this->recv_count)
+	{
+		// datagram fetched with the previous batch
+		std::size_t index = this->recv_index++;
+		if(this->recv_msgs[index].msg_hdr.msg_flags & MSG_TRUNC)
+		{
+			LOG(this->log_sat_carrier, LEVEL_ERROR,
+			    "datagram truncated on channel %d\n",
+			    this->getChannelID());
+			return -1;
+		}
+		this->stampReceived(index);
+		ret = this->handleDatagram(this->recv_addrs[index],
+		                           &this->recv_buffers[index * MAX_SOCK_SIZE],
+		                           this->recv_msgs[index].msg_len,
+		                           packet);
+		if(this->recv_index == this->recv_count &&
+		   this->recv_count == max_batch)
+		{
+			// the batch was full, some datagrams may still be pending
+			this->receiveBatch();
+		}
+	}
+	else
 	{
 		LOG(this->log_sat_carrier, LEVEL_INFO,
-		    "Send content of stack for address %s\n",
-		    this->stacked_ip.c_str());
-		if(!this->handleStack(buf, data_len))
+		    "try to receive a packet from satellite channel %d\n",
+		    this->getChannelID());
+
+		// the channel file descriptor must be valid
+		if(this->getChannelFd() < 0)
 		{
-			goto error;
+			LOG(this->log_sat_carrier, LEVEL_ERROR,
+			    "socket not opened !\n");
+			return -1;
 		}
-		if(!this->stacked_ip.empty())
+
+		// error if channel doesn't accept incoming data
+		if(!this->isInputOk())
 		{
-			// we still have packets to send
-			goto stacked;
+			LOG(this->log_sat_carrier, LEVEL_ERROR,
+			    "channel %d does not accept data\n",
+			    this->getChannelID());
+			return -1;
 		}
-		goto end;
+
+		// the event does not carry the kernel timestamp
+		this->last_timestamp = 0;
+		data = event->getData();
+		ret = this->handleDatagram(event->getSrcAddr(), data, event->getSize(),
+		                           packet);
+		event->releaseData(data);
+
+		// the event only carries one datagram, fetch the other pending ones
+		// at once instead of waking up for each of them
+		this->receiveBatch();
 	}
 
-	LOG(this->log_sat_carrier, LEVEL_INFO,
-	    "try to receive a packet from satellite channel %d\n",
-	    this->getChannelID());
+	if(ret == 0 && this->recv_index < this->recv_count)
+	{
+		// handle the remaining datagrams of the batch
+		return 1;
+	}
+	return ret;
+}
 
-	// the channel file descriptor must be valid
-	if(this->getChannelFd() < 0)
+
+int UdpChannel::receivePending(Data &packet)
+{
+	packet.clear();
+
+	if(this->stacked != nullptr)
 	{
-		LOG(this->log_sat_carrier, LEVEL_ERROR,
-		    "socket not opened !\n");
-		goto error;
+		this->handleStack(packet);
+		return 1;
+	}
+
+	if(this->recv_index >= this->recv_count)
+	{
+		this->receiveBatch();
+		if(this->recv_count == 0)
+		{
+			return 0;
+		}
 	}
 
-	// error if channel doesn't accept incoming data
-	if(!this->isInputOk())
+	std::size_t index = this->recv_index++;
+	if(this->recv_msgs[index].msg_hdr.msg_flags & MSG_TRUNC)
 	{
 		LOG(this->log_sat_carrier, LEVEL_ERROR,
-		    "channel %d does not accept data\n",
+		    "datagram truncated on channel %d\n",
 		    this->getChannelID());
-		goto error;
+		return -1;
 	}
+	this->stampReceived(index);
+	if(this->handleDatagram(this->recv_addrs[index],
+	                        &this->recv_buffers[index * MAX_SOCK_SIZE],
+	                        this->recv_msgs[index].msg_len,
+	                        packet) < 0)
+	{
+		return -1;
+	}
+	// a late datagram gives no packet, the next ones are still pending
+	return 1;
+}
 
-	// we need to memcpy as the start pointer cannot be reused
-	recv_len = event->getSize() - 1;
-	recv_data = (unsigned char *)calloc(recv_len, sizeof(unsigned char));
-	data = event->getData();
-	memcpy(recv_data, data + 1, recv_len);
-	remote_addr = event->getSrcAddr();
 
-	// get the IP address of the sender
-	ip_address = inet_ntoa(remote_addr.sin_addr);
+void UdpChannel::receiveBatch()
+{
+	RtTrace::Span span{"udp.receive"};
+	this->recv_count = 0;
+	this->recv_index = 0;
 
-	// check the sequencing of the datagramm
-	nb_sequencing = data[0];
-	free(data);
-	ip_count_it = this->udp_counters.find(ip_address);
-	if(ip_count_it == this->udp_counters.end())
+	if(this->recv_buffers.empty())
 	{
-		this->udp_counters[ip_address] = nb_sequencing;
-		if(nb_sequencing != 0)
-		{
-			LOG(this->log_sat_carrier, LEVEL_NOTICE,
-			    "force synchronisation on UDP channel %d "
-			    "from %s at startup: received counter is %d "
-			    "while it should have been 0\n",
-			    this->getChannelID(), ip_address.c_str(),
-			    nb_sequencing);
-		}
-		this->stacks[ip_address] = new UdpStack();
-		current_sequencing = nb_sequencing;
+		this->recv_buffers.resize(max_batch * MAX_SOCK_SIZE);
+		this->recv_iovecs.resize(max_batch);
+		this->recv_msgs.resize(max_batch);
+		this->recv_addrs.resize(max_batch);
 	}
-	else
+	const std::size_t control_size = CMSG_SPACE(sizeof(struct scm_timestamping));
+	if(this->timestamping && this->recv_controls.empty())
 	{
-		current_sequencing = (ip_count_it->second + 1) % 256;
-		LOG(this->log_sat_carrier, LEVEL_DEBUG,
-		    "Current UDP sequencing for address %s: %u\n",
-		    ip_address.c_str(), current_sequencing);
+		this->recv_controls.resize(max_batch * control_size);
+		this->recv_timestamps.resize(max_batch);
 	}
-	// add the new packet in stack
-	this->stacks[ip_address]->add(nb_sequencing, recv_data, recv_len);
-	this->stacked_ip = ip_address;
-	// send the current packet
-	if(this->stacks[ip_address]->hasNext(current_sequencing))
+
+	for(std::size_t index = 0; index < max_batch; ++index)
 	{
-		LOG(this->log_sat_carrier, LEVEL_DEBUG,
-		    "Next UDP packet is in stack\n");
-		this->handleStack(buf, data_len, current_sequencing,
-		                  this->stacks[ip_address]);
-		if(!this->stacked_ip.empty())
+		struct iovec &iov = this->recv_iovecs[index];
+		iov.iov_base = &this->recv_buffers[index * MAX_SOCK_SIZE];
+		iov.iov_len = MAX_SOCK_SIZE;
+
+		struct mmsghdr &msg = this->recv_msgs[index];
+		bzero(&msg, sizeof(msg));
+		msg.msg_hdr.msg_name = &this->recv_addrs[index];
+		msg.msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+		msg.msg_hdr.msg_iov = &iov;
+		msg.msg_hdr.msg_iovlen = 1;
+		if(this->timestamping)
 		{
-			// we still have packets to send
-			goto stacked;
+			msg.msg_hdr.msg_control = &this->recv_controls[index * control_size];
+			msg.msg_hdr.msg_controllen = control_size;
 		}
-		ip_count_it->second = current_sequencing;
 	}
-	else
+
+	int ret = recvmmsg(this->sock_channel, this->recv_msgs.data(), max_batch,
+	                   MSG_DONTWAIT, nullptr);
+	if(ret < 0)
 	{
-		this->stacked_ip = "";
-		LOG(this->log_sat_carrier, LEVEL_INFO,
-		    "No UDP packet for current sequencing (%u) at IP %s "
-		    "wait for next packets (last received %u)\n",
-		    current_sequencing, ip_address.c_str(), nb_sequencing);
+		if(errno != EAGAIN && errno != EWOULDBLOCK)
+		{
+			LOG(this->log_sat_carrier, LEVEL_ERROR,
+			    "cannot receive datagrams on channel %d: %s (%d)\n",
+			    this->getChannelID(), strerror(errno), errno);
+		}
+		return;
 	}
-	// check that we do not have to much packets in stack
-	if(this->stacks[ip_address]->getCounter() > this->max_stack)
+	this->recv_count = ret;
+
+	for(int index = 0; this->timestamping && index < ret; ++index)
 	{
-		// suppose we lost the packet
-		LOG(this->log_sat_carrier, LEVEL_ERROR,
-		    "we may have lost UDP packets, check "
-		    "and adjust UDP buffers\n");
-		// send the next packets from stack
-		current_sequencing = (current_sequencing + 1) % 256;
-		while(!this->stacks[ip_address]->hasNext(current_sequencing))
+		struct msghdr &hdr = this->recv_msgs[index].msg_hdr;
+		uint64_t timestamp = 0;
+		for(struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr);
+		    cmsg != nullptr;
+		    cmsg = CMSG_NXTHDR(&hdr, cmsg))
 		{
-			LOG(this->log_sat_carrier, LEVEL_INFO,
-			    "packet missing: %u\n", current_sequencing);
-			current_sequencing = (current_sequencing + 1) % 256;
+			if(cmsg->cmsg_level != SOL_SOCKET ||
+			   cmsg->cmsg_type != SCM_TIMESTAMPING)
+			{
+				continue;
+			}
+			struct scm_timestamping stamps;
+			memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+			// prefer the NIC timestamp when the hardware provides one
+			const struct timespec &ts = (stamps.ts[2].tv_sec || stamps.ts[2].tv_nsec) ?
+			                            stamps.ts[2] : stamps.ts[0];
+			timestamp = ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
 		}
-		// we should be able to return a packet here
-		ip_count_it->second = current_sequencing;
-		this->stacked_ip = ip_address;
-		goto stacked;
+		this->recv_timestamps[index] = timestamp;
 	}
 
-end:
-	return 0;
+	LOG(this->log_sat_carrier, LEVEL_DEBUG,
+	    "%d pending datagrams received on channel %d\n",
+	    ret, this->getChannelID());
+}
 
-stacked:
-	return 1;
 
-error:
-	return -1;
+void UdpChannel::stampReceived(std::size_t index)
+{
+	if(!this->timestamping)
+	{
+		this->last_timestamp = 0;
+		return;
+	}
+	this->last_timestamp = this->recv_timestamps[index];
+	uint64_t now = getTimestampNs();
+	if(this->probe_socket_residency &&
+	   this->last_timestamp != 0 && now >= this->last_timestamp)
+	{
+		this->probe_socket_residency->put((now - this->last_timestamp) / 1000);
+	}
 }
 
 
-bool UdpChannel::handleStack(unsigned char **buf, size_t &data_len)
+UdpStack &UdpChannel::getStack(const struct sockaddr_in &remote_addr,
+                               uint8_t udp_counter)
 {
-	std::map<std::string , uint8_t>::iterator count_it = this->udp_counters.find(this->stacked_ip);
-	std::map<std::string, UdpStack *>::iterator stack_it = this->stacks.find(this->stacked_ip);
-	uint8_t counter;
-	
-	if(count_it == this->udp_counters.end())
+	uint64_t source = (uint64_t(remote_addr.sin_addr.s_addr) << 16) | remote_addr.sin_port;
+	if(this->last_stack != nullptr && this->last_source == source)
 	{
-		LOG(this->log_sat_carrier, LEVEL_ERROR,
-		    "cannot find UDP counter for IP %s\n",
-		    this->stacked_ip.c_str());
-		return false;
+		return *this->last_stack;
 	}
+
+	auto stack_it = this->stacks.find(source);
 	if(stack_it == this->stacks.end())
+	{
+		if(udp_counter != 0)
+		{
+			LOG(this->log_sat_carrier, LEVEL_NOTICE,
+			    "force synchronisation on UDP channel %d "
+			    "from %s:%u at startup: received counter is %d "
+			    "while it should have been 0\n",
+			    this->getChannelID(), inet_ntoa(remote_addr.sin_addr),
+			    ntohs(remote_addr.sin_port), udp_counter);
+		}
+		stack_it = this->stacks.emplace(source, udp_counter).first;
+	}
+	this->last_source = source;
+	this->last_stack = &stack_it->second;
+	return stack_it->second;
+}
+
+
+int UdpChannel::handleDatagram(const struct sockaddr_in &remote_addr,
+                               const unsigned char *data,
+                               std::size_t length,
+                               Data &packet)
+{
+	uint8_t nb_sequencing;
+
+	if(length == 0)
 	{
 		LOG(this->log_sat_carrier, LEVEL_ERROR,
-		    "cannot find UDP stack for IP %s\n",
-		    this->stacked_ip.c_str());
-		return false;
+		    "empty datagram received on channel %d\n",
+		    this->getChannelID());
+		return -1;
 	}
 
-	counter = (*count_it).second;
-	this->handleStack(buf, data_len,
-	                  counter,
-	                  (*stack_it).second);
-	if(!this->stacked_ip.empty())
+	// check the sequencing of the datagramm
+	nb_sequencing = data[0];
+	UdpStack &stack = this->getStack(remote_addr, nb_sequencing);
+	if(stack.isLate(nb_sequencing))
 	{
-		// update counter for next stacked packet
-		(*count_it).second = (counter + 1) % 256;
+		LOG(this->log_sat_carrier, LEVEL_INFO,
+		    "drop late UDP packet %u from %s on channel %d\n",
+		    nb_sequencing, inet_ntoa(remote_addr.sin_addr),
+		    this->getChannelID());
+		if(this->probe_late)
+		{
+			this->probe_late->put(1);
+		}
+		return 0;
 	}
-	return true;
+
+	// add the new packet in stack, the payload buffer comes from the packets pool
+	auto now = std::chrono::steady_clock::now();
+	if(!stack.add(nb_sequencing, Data{data + 1, length - 1}, now))
+	{
+		LOG(this->log_sat_carrier, LEVEL_ERROR,
+		    "new data for UDP stack at position %u, erase "
+		    "previous data\n", nb_sequencing);
+	}
+
+	if(!stack.hasNext())
+	{
+		LOG(this->log_sat_carrier, LEVEL_INFO,
+		    "No UDP packet in sequence at IP %s, wait for next "
+		    "packets (last received %u)\n",
+		    inet_ntoa(remote_addr.sin_addr), nb_sequencing);
+		if(this->probe_reordered)
+		{
+			this->probe_reordered->put(1);
+		}
+
+		// check that we do not wait for too long or have to much packets in stack
+		if(stack.getCounter() <= this->max_stack &&
+		   !stack.isExpired(now, reorder_timeout))
+		{
+			return 0;
+		}
+
+		// suppose we lost the packet, send the next packets from stack
+		unsigned int lost = stack.skip();
+		LOG(this->log_sat_carrier, LEVEL_ERROR,
+		    "we may have lost %u UDP packets, check "
+		    "and adjust UDP buffers\n", lost);
+		if(this->probe_lost)
+		{
+			this->probe_lost->put(lost);
+		}
+	}
+
+	// send the current packet
+	this->stacked = &stack;
+	return this->handleStack(packet);
 }
-	
-	
-void UdpChannel::handleStack(unsigned char **buf, size_t &data_len,
-                             uint8_t counter, UdpStack *stack)
+
+
+int UdpChannel::handleStack(Data &packet)
 {
 	LOG(this->log_sat_carrier, LEVEL_INFO,
-	    "transmit UDP packet for source IP %s at counter %d\n",
-	    this->stacked_ip.c_str(), counter);
-	stack->remove(counter, buf, data_len);
-	counter = (counter + 1) % 256;
-	// if we don't have following packets in FIFO reset stacked_ip
-	if(!stack->hasNext(counter))
+	    "transmit next stacked UDP packet\n");
+	this->stacked->next(packet);
+	// if we don't have following packets in stack reset stacked
+	if(!this->stacked->hasNext())
 	{
-		this->stacked_ip = "";
+		this->stacked = nullptr;
+		return 0;
 	}
+	return 1;
 }
 
 
 bool UdpChannel::send(const unsigned char *data, size_t length)
 {
-	ssize_t slen;
+	return this->queue(data, length) && this->flush();
+}
+
 
+bool UdpChannel::queue(const unsigned char *data, size_t length, uint64_t timestamp,
+                       std::shared_ptr<const void> owner)
+{
 	LOG(this->log_sat_carrier, LEVEL_INFO,
 	    "data are trying to be send on channel %d\n", m_channel_id);
 
@@ -537,7 +731,7 @@ bool UdpChannel::send(const unsigned char *data, size_t length)
 		LOG(this->log_sat_carrier, LEVEL_ERROR,
 		    "Channel %d is not configure to send data\n",
 		    m_channel_id);
-		goto error;
+		return false;
 	}
 
 	// check if the socket is open
@@ -545,109 +739,433 @@ bool UdpChannel::send(const unsigned char *data, size_t length)
 	{
 		LOG(this->log_sat_carrier, LEVEL_ERROR,
 		    "Socket not open !\n");
-		goto error;
+		return false;
 	}
 
-	// add a sequencing field
-	bzero(this->send_buffer, sizeof(this->send_buffer));
-	this->send_buffer[0] = this->counter;
-	memcpy(send_buffer + 1, data, length);
-	slen = length + 1;
-
-	if(sendto(this->sock_channel, this->send_buffer, slen, 0,
-	          (struct sockaddr *) &this->m_remoteIPAddress,
-	          sizeof(this->m_remoteIPAddress)) < slen)
+	if(length + 1 > MAX_SOCK_SIZE)
 	{
 		LOG(this->log_sat_carrier, LEVEL_ERROR,
-		    "Error:  sendto(..,0,..) errno %s (%d)\n",
-		    strerror(errno), errno);
-		goto error;
+		    "cannot send %zu bytes on channel %d\n",
+		    length, m_channel_id);
+		return false;
+	}
+
+	// the sequencing field is set now so that the datagrams keep their order
+	this->send_queue.emplace_back(data, length);
+	this->send_counters.push_back(this->counter);
+	this->send_owners.push_back(std::move(owner));
+	if(this->timestamping)
+	{
+		this->send_timestamps.push_back(timestamp);
 	}
 
 	// update of the counter
 	this->counter = (this->counter + 1) % 256;
 
+	if(this->send_queue.size() >= max_batch)
+	{
+		return this->flush();
+	}
+	return true;
+}
+
+
+bool UdpChannel::flush()
+{
+	RtTrace::Span span{"udp.send"};
+	std::size_t nb_msgs = this->send_queue.size();
+	std::size_t sent = 0;
+	bool status = true;
+
+	if(nb_msgs == 0)
+	{
+		return true;
+	}
+
+	// gather the sequencing field and the data of each datagram
+	this->send_iovecs.resize(2 * nb_msgs);
+	this->send_msgs.resize(nb_msgs);
+	for(std::size_t index = 0; index < nb_msgs; ++index)
+	{
+		struct iovec *iov = &this->send_iovecs[2 * index];
+		iov[0].iov_base = &this->send_counters[index];
+		iov[0].iov_len = 1;
+		iov[1].iov_base = const_cast<unsigned char *>(this->send_queue[index].first);
+		iov[1].iov_len = this->send_queue[index].second;
+
+		struct mmsghdr &msg = this->send_msgs[index];
+		bzero(&msg, sizeof(msg));
+		msg.msg_hdr.msg_name = &this->m_remoteIPAddress;
+		msg.msg_hdr.msg_namelen = sizeof(this->m_remoteIPAddress);
+		msg.msg_hdr.msg_iov = iov;
+		msg.msg_hdr.msg_iovlen = 2;
+	}
+	if(this->pacing == Pacing::departure_time)
+	{
+		this->setDepartureTimes(nb_msgs);
+	}
+
+	while(sent < nb_msgs)
+	{
+		uint64_t now = this->timestamping ? getTimestampNs() : 0;
+		int ret = sendmmsg(this->sock_channel, &this->send_msgs[sent],
+		                   nb_msgs - sent, 0);
+		if(ret < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			LOG(this->log_sat_carrier, LEVEL_ERROR,
+			    "Error:  sendmmsg(..,0) errno %s (%d), %zu datagrams "
+			    "dropped\n", strerror(errno), errno, nb_msgs - sent);
+			status = false;
+			break;
+		}
+		for(int index = 0; index < ret; ++index)
+		{
+			const struct mmsghdr &msg = this->send_msgs[sent + index];
+			if(msg.msg_len < msg.msg_hdr.msg_iov[1].iov_len + 1)
+			{
+				LOG(this->log_sat_carrier, LEVEL_ERROR,
+				    "datagram with counter %u truncated on channel %d\n",
+				    this->send_counters[sent + index], m_channel_id);
+				status = false;
+			}
+			if(!this->timestamping)
+			{
+				continue;
+			}
+			// the kernel stamps each sent datagram with the next identifier
+			uint64_t stamped = this->send_timestamps[sent + index];
+			this->sent_datagrams[this->next_datagram_id % max_stamped_datagrams] =
+			    {this->next_datagram_id, now, stamped};
+			this->next_datagram_id++;
+			if(this->probe_queue_residency && stamped != 0 && now >= stamped)
+			{
+				this->probe_queue_residency->put((now - stamped) / 1000);
+			}
+		}
+		sent += ret;
+	}
+
 	LOG(this->log_sat_carrier, LEVEL_INFO,
-	    "==> SAT_Channel_Send [%d] (%s:%d): len=%zd, counter: %d\n",
+	    "==> SAT_Channel_Send [%d] (%s:%d): %zu datagrams, counter: %d\n",
 	    m_channel_id, inet_ntoa(this->m_remoteIPAddress.sin_addr),
-	    ntohs(this->m_remoteIPAddress.sin_port), slen,
+	    ntohs(this->m_remoteIPAddress.sin_port), sent,
 	    this->counter);
 
-	return true;
+	this->send_queue.clear();
+	this->send_counters.clear();
+	this->send_owners.clear();
+	if(this->timestamping)
+	{
+		this->send_timestamps.clear();
+		this->readSendTimestamps();
+	}
+	return status;
+}
 
-error:
+
+void UdpChannel::readSendTimestamps()
+{
+	char control[256];
+	struct msghdr hdr;
+
+	// the timestamps of the datagrams not sent yet by the driver
+	// are read with the next flush
+	while(true)
+	{
+		bzero(&hdr, sizeof(hdr));
+		hdr.msg_control = control;
+		hdr.msg_controllen = sizeof(control);
+		if(recvmsg(this->sock_channel, &hdr, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			break;
+		}
+
+		uint64_t timestamp = 0;
+		const struct sock_extended_err *error = nullptr;
+		for(struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr);
+		    cmsg != nullptr;
+		    cmsg = CMSG_NXTHDR(&hdr, cmsg))
+		{
+			if(cmsg->cmsg_level == SOL_SOCKET &&
+			   cmsg->cmsg_type == SCM_TIMESTAMPING)
+			{
+				struct scm_timestamping stamps;
+				memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+				timestamp = stamps.ts[0].tv_sec * UINT64_C(1000000000) +
+				            stamps.ts[0].tv_nsec;
+			}
+			else if(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+			{
+				error = reinterpret_cast<const struct sock_extended_err *>(CMSG_DATA(cmsg));
+			}
+		}
+		if(error == nullptr || timestamp == 0 ||
+		   error->ee_origin != SO_EE_ORIGIN_TIMESTAMPING)
+		{
+			continue;
+		}
+
+		const sent_datagram_t &datagram =
+		    this->sent_datagrams[error->ee_data % max_stamped_datagrams];
+		if(datagram.id != error->ee_data || timestamp < datagram.sent)
+		{
+			// too many datagrams were waiting for their timestamp
+			continue;
+		}
+		if(this->probe_kernel_residency)
+		{
+			this->probe_kernel_residency->put((timestamp - datagram.sent) / 1000);
+		}
+		if(this->probe_emulator_residency &&
+		   datagram.stamped != 0 && timestamp >= datagram.stamped)
+		{
+			this->probe_emulator_residency->put((timestamp - datagram.stamped) / 1000);
+		}
+	}
+}
+
+
+void UdpChannel::setDepartureTimes(std::size_t nb_msgs)
+{
+#ifdef SO_TXTIME
+	const std::size_t control_size = CMSG_SPACE(sizeof(uint64_t));
+	this->send_controls.assign(nb_msgs * control_size, 0);
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	uint64_t now_ns = now.tv_sec * UINT64_C(1000000000) + now.tv_nsec;
+
+	// the unused rate is not kept for a later burst, and the datagrams
+	// sent above the rate are not delayed beyond the horizon
+	uint64_t departure = std::min(std::max(this->next_departure_ns, now_ns),
+	                              now_ns + pacing_horizon_ns);
+	for(std::size_t index = 0; index < nb_msgs; ++index)
+	{
+		struct msghdr &hdr = this->send_msgs[index].msg_hdr;
+		hdr.msg_control = &this->send_controls[index * control_size];
+		hdr.msg_controllen = control_size;
+
+		struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_TXTIME;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+		memcpy(CMSG_DATA(cmsg), &departure, sizeof(departure));
+
+		std::size_t length = this->send_queue[index].second + 1 + datagram_overhead;
+		departure += length * this->pacing_ns_per_byte;
+	}
+	this->next_departure_ns = departure;
+#else
+	(void)nb_msgs;
+#endif
+}
+
+
+bool UdpChannel::setPacing(double rate_bps)
+{
+	if(!this->isOutputOk() || rate_bps <= 0)
+	{
+		return false;
+	}
+	this->pacing_ns_per_byte = 8e9 / rate_bps;
+	this->next_departure_ns = 0;
+
+#ifdef SO_TXTIME
+	struct sock_txtime txtime;
+	txtime.clockid = CLOCK_MONOTONIC;
+	txtime.flags = 0;
+	if(setsockopt(this->sock_channel, SOL_SOCKET, SO_TXTIME,
+	              &txtime, sizeof(txtime)) == 0)
+	{
+		this->pacing = Pacing::departure_time;
+		LOG(this->log_init, LEVEL_NOTICE,
+		    "datagrams of channel %d paced at %.0f bits/s with "
+		    "their departure time\n", m_channel_id, rate_bps);
+		return true;
+	}
+#endif
+
+	uint32_t rate = std::min<double>(rate_bps / 8, UINT32_MAX);
+	if(setsockopt(this->sock_channel, SOL_SOCKET, SO_MAX_PACING_RATE,
+	              &rate, sizeof(rate)) == 0)
+	{
+		this->pacing = Pacing::socket_rate;
+		LOG(this->log_init, LEVEL_NOTICE,
+		    "datagrams of channel %d paced at %.0f bits/s by the socket\n",
+		    m_channel_id, rate_bps);
+		return true;
+	}
+
+	LOG(this->log_init, LEVEL_WARNING,
+	    "cannot pace the datagrams of channel %d: %s (%d)\n",
+	    m_channel_id, strerror(errno), errno);
 	return false;
 }
 
 
-UdpStack::UdpStack()
+bool UdpChannel::enableTimestamping()
 {
-	// Output log
-	this->log_sat_carrier = Output::Get()->registerLog(LEVEL_WARNING, "SatCarrier.Channel");
-	// reserve space for all UDP counters
-	this->reserve(256);
-	for(unsigned int i = 0; i < 256; i++)
+	unsigned int flags = SOF_TIMESTAMPING_SOFTWARE;
+	if(this->isInputOk())
+	{
+		// the hardware timestamps are only generated once the
+		// timestamping of the NIC is configured (SIOCSHWTSTAMP)
+		flags |= SOF_TIMESTAMPING_RX_SOFTWARE |
+		         SOF_TIMESTAMPING_RX_HARDWARE |
+		         SOF_TIMESTAMPING_RAW_HARDWARE;
+	}
+	else
+	{
+		// the datagrams are not looped back with their timestamp
+		flags |= SOF_TIMESTAMPING_TX_SOFTWARE |
+		         SOF_TIMESTAMPING_OPT_ID |
+		         SOF_TIMESTAMPING_OPT_TSONLY;
+	}
+	if(setsockopt(this->sock_channel, SOL_SOCKET, SO_TIMESTAMPING,
+	              &flags, sizeof(flags)) < 0)
+	{
+		LOG(this->log_init, LEVEL_WARNING,
+		    "cannot timestamp the datagrams of channel %d: %s (%d)\n",
+		    m_channel_id, strerror(errno), errno);
+		return false;
+	}
+
+	auto output = Output::Get();
+	const std::string &prefix = this->probe_prefix;
+	if(this->isInputOk())
+	{
+		this->probe_socket_residency =
+		    output->registerHistogram(prefix + ".UDP socket residency", "us", true);
+	}
+	else
 	{
-		this->push_back(std::make_pair<unsigned char *, size_t>(NULL, 0));
+		this->sent_datagrams.assign(max_stamped_datagrams, {UINT32_MAX, 0, 0});
+		this->send_timestamps.reserve(max_batch);
+		this->next_datagram_id = 0;
+		this->probe_queue_residency =
+		    output->registerHistogram(prefix + ".UDP queue residency", "us", true);
+		this->probe_kernel_residency =
+		    output->registerHistogram(prefix + ".UDP kernel residency", "us", true);
+		this->probe_emulator_residency =
+		    output->registerHistogram(prefix + ".UDP emulator residency", "us", true);
+	}
+	this->timestamping = true;
+
+	LOG(this->log_init, LEVEL_NOTICE,
+	    "datagrams of channel %d timestamped by the kernel\n",
+	    m_channel_id);
+	return true;
+}
+
+
+
+UdpStack::UdpStack(uint8_t first_counter):
+	slots(),
+	next_counter(first_counter),
+	nb_stored(0),
+	waiting_since()
+{
+	for(auto &&slot: this->slots)
+	{
+		slot.used = false;
 	}
-	this->counter = 0;
 }
 
 
-UdpStack::~UdpStack()
+bool UdpStack::isLate(uint8_t udp_counter) const
 {
-	this->reset();
-	this->clear();
+	// counters more than half the window behind the next
+	// one belong to datagrams already delivered or skipped
+	return uint8_t(udp_counter - this->next_counter) >= 128;
 }
 
 
-void UdpStack::add(uint8_t udp_counter, unsigned char *data, size_t data_length)
+bool UdpStack::add(uint8_t udp_counter, Data &&data, time_point_t arrival)
 {
-	if(this->at(udp_counter).first)
+	Slot &slot = this->slots[udp_counter];
+	bool replaced = slot.used;
+	if(this->nb_stored == 0 && udp_counter != this->next_counter)
 	{
-		LOG(this->log_sat_carrier, LEVEL_ERROR, 
-		    "new data for UDP stack at position %u, erase "
-		    "previous data\n", udp_counter);
-		this->counter--;
-		delete (this->at(udp_counter).first);
+		// first datagram waiting for a missing one
+		this->waiting_since = arrival;
+	}
+	if(!replaced)
+	{
+		this->nb_stored++;
 	}
-	this->at(udp_counter).first = data;
-	this->at(udp_counter).second = data_length;
-	this->counter++;
+	slot.data = std::move(data);
+	slot.used = true;
+	slot.arrival = arrival;
+	return !replaced;
 }
 
 
-void UdpStack::remove(uint8_t udp_counter, unsigned char **data, size_t &data_length)
+bool UdpStack::hasNext() const
 {
-	*data = this->at(udp_counter).first;
-	if(*data)
+	return this->slots[this->next_counter].used;
+}
+
+
+bool UdpStack::next(Data &data)
+{
+	Slot &slot = this->slots[this->next_counter];
+	if(!slot.used)
+	{
+		return false;
+	}
+	data = std::move(slot.data);
+	slot.used = false;
+	this->nb_stored--;
+	this->next_counter++;
+	if(this->nb_stored > 0 && !this->hasNext())
 	{
-		this->counter--;
+		// a new gap is reached
+		this->updateWaiting();
 	}
-	data_length = this->at(udp_counter).second;
-	this->at(udp_counter).first = NULL;
-	this->at(udp_counter).second = 0;
+	return true;
 }
 
 
-bool UdpStack::hasNext(uint8_t udp_counter)
+unsigned int UdpStack::skip()
 {
-	auto& value = this->at(udp_counter);
-	return (value.first != nullptr && value.second != 0);
+	if(this->nb_stored == 0)
+	{
+		return 0;
+	}
+
+	unsigned int lost = 0;
+	while(!this->slots[this->next_counter].used)
+	{
+		this->next_counter++;
+		lost++;
+	}
+	return lost;
 }
 
 
-void UdpStack::reset()
+void UdpStack::updateWaiting()
 {
-	std::vector<std::pair<unsigned char *, size_t> >::iterator it;
-	for(it = this->begin(); it != this->end(); ++it)
+	bool found = false;
+	for(const auto &slot: this->slots)
 	{
-		if((*it).first)
+		if(slot.used && (!found || slot.arrival < this->waiting_since))
 		{
-			delete (*it).first;
-			(*it).first = NULL;
-			(*it).second = 0;
+			this->waiting_since = slot.arrival;
+			found = true;
 		}
-		this->counter = 0;
 	}
 }
+
+
+bool UdpStack::isExpired(time_point_t now, std::chrono::milliseconds timeout) const
+{
+	return this->nb_stored > 0 && now - this->waiting_since > timeout;
+}
@@ -38,20 +38,137 @@
 
 
 #include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
-#include <map>
+#include <array>
+#include <chrono>
 #include <string>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include <opensand_rt/Types.h>
 
 #include "OpenSandCore.h"
+#include "Data.h"
 
 
-class UdpStack;
 class OutputLog;
 class NetSocketEvent;
+class HistogramProbe;
+template<typename> class Probe;
+
+
+/*
+ * @class UdpStack
+ * @brief The reorder window of the datagrams received from a source,
+ *        it allows UDP packets ordering in order to avoid
+ *        sequence desynchronizations
+ *
+ * The window is a ring indexed by the 8-bit sequencing counter,
+ * each slot holds a pooled buffer so no lookup nor allocation
+ * outside the packets pool is required per datagram.
+ */
+class UdpStack
+{
+public:
+	using time_point_t = std::chrono::steady_clock::time_point;
+
+	/**
+	 * @brief Create the reorder window of a source
+	 *
+	 * @param first_counter  The counter of the first datagram of the source
+	 */
+	UdpStack(uint8_t first_counter);
+
+	/**
+	 * @brief Check whether a counter is behind the window, i.e. the
+	 *        datagram arrives after the next ones were delivered
+	 *
+	 * @param udp_counter  The datagram counter
+	 * @return true if the datagram is late, false otherwise
+	 */
+	bool isLate(uint8_t udp_counter) const;
+
+	/**
+	 * @brief Store a datagram in the window
+	 *
+	 * @param udp_counter  The datagram counter
+	 * @param data         The datagram payload
+	 * @param arrival      The datagram arrival time
+	 * @return false if a datagram was already stored with this counter and
+	 *         has been replaced, true otherwise
+	 */
+	bool add(uint8_t udp_counter, Data &&data, time_point_t arrival);
+
+	/**
+	 * @brief Check if the next datagram in sequence is stored
+	 *
+	 * @return true if we have the next datagram, false otherwise
+	 */
+	bool hasNext() const;
+
+	/**
+	 * @brief Get the next datagram in sequence
+	 *
+	 * @param data  OUT: the datagram payload
+	 * @return true if the datagram was stored, false otherwise
+	 */
+	bool next(Data &data);
+
+	/**
+	 * @brief Consider the missing datagrams before the first
+	 *        stored one as lost
+	 *
+	 * @return the number of lost datagrams
+	 */
+	unsigned int skip();
+
+	/**
+	 * @brief Check whether the datagrams stored after a gap in the
+	 *        sequence have waited for too long
+	 *
+	 * @param now      The current time
+	 * @param timeout  The maximum waiting time
+	 * @return true if the missing datagrams should be considered lost
+	 */
+	bool isExpired(time_point_t now, std::chrono::milliseconds timeout) const;
+
+	/**
+	 * @brief Get the number of stored datagrams
+	 *
+	 * @return the number of stored datagrams
+	 */
+	inline std::size_t getCounter() const { return this->nb_stored; };
+
+private:
+	/**
+	 * @brief Update the arrival of the oldest stored datagram
+	 *        when a new gap in the sequence is reached
+	 */
+	void updateWaiting();
+
+	/// A slot of the window
+	struct Slot
+	{
+		Data data;
+		bool used;
+		time_point_t arrival;
+	};
+
+	/// The window slots, indexed by counter
+	std::array<Slot, 256> slots;
+
+	/// The counter of the next datagram in sequence
+	uint8_t next_counter;
+
+	/// The number of stored datagrams
+	std::size_t nb_stored;
+
+	/// The arrival of the oldest datagram waiting for a missing one
+	time_point_t waiting_since;
+};
 
 
 /*
@@ -74,7 +191,7 @@ public:
 	           unsigned int rmem,
 	           unsigned int wmem);
 
-	~UdpChannel();
+	virtual ~UdpChannel();
 
 	bool isInit();
 
@@ -92,35 +209,178 @@ public:
 	 * @return true on success, false otherwise
 	 */
 	bool send(const unsigned char *data, std::size_t length);
-	int receive(NetSocketEvent *const event,
-	            unsigned char **buf,
-	            std::size_t &data_len);
+
+	/**
+	 * @brief Queue data to be sent on the satellite carrier by the next
+	 *        flush, the data must remain valid until then unless its
+	 *        owner is given to the channel.
+	 *        The queue is flushed when it reaches the maximum batch size
+	 *
+	 * @param data        The data to send
+	 * @param length      The length of the data
+	 * @param timestamp   The time the data entered the emulator processing,
+	 *                    0 if unknown (ns, see getTimestampNs)
+	 * @param owner       The object holding the data, kept by the channel
+	 *                    as long as the kernel may read the data
+	 * @return true on success, false otherwise
+	 */
+	bool queue(const unsigned char *data, std::size_t length, uint64_t timestamp = 0,
+	           std::shared_ptr<const void> owner = nullptr);
+
+	/**
+	 * @brief Send all the queued data on the satellite carrier
+	 *        with as few system calls as possible
+	 *
+	 * @return true on success, false if some data could not be sent
+	 */
+	virtual bool flush();
+
+	/**
+	 * @brief Pace the datagrams sent on the channel at a rate instead of
+	 *        sending them in bursts: each datagram gets its earliest
+	 *        departure time (SO_TXTIME), or the socket is rate limited
+	 *        (SO_MAX_PACING_RATE) on kernels without it. The fq qdisc
+	 *        of the emulation interface enforces both.
+	 *
+	 * @param rate_bps  The pacing rate (bits/s)
+	 * @return true if the datagrams are paced, false otherwise
+	 */
+	bool setPacing(double rate_bps);
+
+	/**
+	 * @brief Timestamp the datagrams of the channel in the kernel
+	 *        (SO_TIMESTAMPING) to export, as histogram probes, the time
+	 *        the received datagrams wait in the socket, and the time the
+	 *        sent ones wait in the channel, then in the kernel until the
+	 *        driver sends them. The received datagrams are timestamped by
+	 *        the NIC when its hardware timestamping is configured and its
+	 *        clock synchronized with the system one.
+	 *        Only the datagrams received in batches are timestamped.
+	 *
+	 * @return true if the datagrams are timestamped, false otherwise
+	 */
+	bool enableTimestamping();
+
+	/**
+	 * @brief Get the kernel reception time of the last datagram read
+	 *
+	 * @return the time (ns, see getTimestampNs), 0 if unknown
+	 */
+	inline uint64_t getLastTimestamp() const { return this->last_timestamp; };
+
+	/**
+	 * @brief Receive the datagram of a socket event, then the datagrams
+	 *        already pending on the socket are fetched in a batch
+	 *        and returned by the next calls
+	 *
+	 * @param event     The event on the channel socket
+	 * @param packet    OUT: the received packet, empty if none
+	 * @return  0 on success, 1 if the function should be
+	 *          called another time, -1 on error
+	 */
+	int receive(NetSocketEvent *const event, Data &packet);
+
+	/**
+	 * @brief Receive the next datagram pending on the socket without
+	 *        an event of the channel thread, for the receive workers
+	 *
+	 * @param packet    OUT: the received packet, empty if none
+	 * @return  0 if nothing is pending on the socket anymore,
+	 *          1 if the function should be called another time,
+	 *          -1 on error
+	 */
+	int receivePending(Data &packet);
 
 	int getChannelFd();
 	
 	spot_id_t getSpotId();
 
+	/// The time after which the datagrams missing in a sequence are
+	/// considered lost, even if the stack is not full
+	static constexpr std::chrono::milliseconds reorder_timeout{100};
+
+protected:
 	/**
 	 * @brief Get the next stacked packet
 	 *
-	 * @param buf      OUT: the stacked packet
-	 * @param data_len OUT: the length of the packet
-	 * @return true on success, false otherwise
+	 * @param packet  OUT: the stacked packet
+	 * @return  0 if there is no more stacked packets, 1 otherwise
 	 */
-	bool handleStack(unsigned char **buf, size_t &data_len);
+	int handleStack(Data &packet);
 
+	/**
+	 * @brief Get the reorder window of a source, create it on
+	 *        the first datagram received from the source
+	 *
+	 * @param remote_addr  The source address
+	 * @param udp_counter  The counter of the received datagram
+	 * @return the reorder window of the source
+	 */
+	UdpStack &getStack(const struct sockaddr_in &remote_addr, uint8_t udp_counter);
 
 	/**
-	 * @brief Get the next stacked packet
+	 * @brief Check the sequencing of a received datagram and
+	 *        get the next packet in sequence
 	 *
-	 * @param buf      OUT: the stacked packet
-	 * @param data_len OUT: the length of the packet
-	 * @param stack    The stack in which to get packet
+	 * @param remote_addr  The datagram source address
+	 * @param data         The datagram, starting with the sequencing counter
+	 * @param length       The datagram length
+	 * @param packet       OUT: the packet in sequence, if any
+	 * @return  0 on success, 1 if stacked packets remain, -1 on error
 	 */
-	void handleStack(unsigned char **buf, size_t &data_len,
-	                 uint8_t counter, UdpStack *stack);
+	int handleDatagram(const struct sockaddr_in &remote_addr,
+	                   const unsigned char *data,
+	                   std::size_t length,
+	                   Data &packet);
+
+	/**
+	 * @brief Fetch the datagrams pending on the socket without blocking
+	 */
+	void receiveBatch();
+
+	/**
+	 * @brief Give their departure time to the queued datagrams,
+	 *        spaced by their duration at the pacing rate
+	 *
+	 * @param nb_msgs  The number of queued datagrams
+	 */
+	void setDepartureTimes(std::size_t nb_msgs);
+
+	/**
+	 * @brief Keep the timestamp of a datagram of the received batch
+	 *        as the last one and measure its time in the socket
+	 *
+	 * @param index  The datagram index in the batch
+	 */
+	void stampReceived(std::size_t index);
+
+	/**
+	 * @brief Measure the residency of the sent datagrams
+	 *        whose kernel timestamps are available
+	 */
+	void readSendTimestamps();
+
+	/// The maximum number of datagrams sent or received with one system call
+	static constexpr std::size_t max_batch = 32;
+
+	/// The IP and UDP headers added to each datagram on the wire
+	static constexpr std::size_t datagram_overhead = 28;
+
+	/// The delay a datagram may be paced by when more data is sent than
+	/// the pacing rate allows, the later ones are sent in a burst
+	static constexpr uint64_t pacing_horizon_ns = 100000000;
+
+	/// The number of sent datagrams that may wait for their kernel timestamp
+	static constexpr std::size_t max_stamped_datagrams = 1024;
+
+	/// How the sent datagrams are paced
+	enum class Pacing
+	{
+		none,
+		departure_time,
+		socket_rate,
+	};
 
-protected:
 	/// the spot id
 	spot_id_t spot_id;
 
@@ -151,26 +411,83 @@ protected:
 	/// boolean which indicates if the channel is multicast
 	bool m_multicast;
 
-	/// A map whose key is an IP address and value is a counter
-	/// (counter ranges from 0 to 255)
-	/// (IP address, counter) map used to check that UDP packets are received in
-	/// sequence on every UDP communication channel
-	std::map<std::string , uint8_t> udp_counters;
-
 	/// Counter for sending packets
 	uint8_t counter;
 
-	/// internal buffer to build and send udp datagramms
-	unsigned char send_buffer[MAX_SOCK_SIZE];
+	/// The data queued for the next flush
+	std::vector<std::pair<const unsigned char *, std::size_t>> send_queue;
+	/// The sequencing counters of the queued data, each one is gathered
+	/// with its data by the send so they do not need to be copied together
+	std::vector<uint8_t> send_counters;
+	/// The owners of the queued data, null if the data is only
+	/// guaranteed to be valid until the flush returns
+	std::vector<std::shared_ptr<const void>> send_owners;
+	/// The scatter-gather buffers of the queued datagrams
+	std::vector<struct iovec> send_iovecs;
+	/// The headers of the queued datagrams
+	std::vector<struct mmsghdr> send_msgs;
+
+	/// How the sent datagrams are paced
+	Pacing pacing;
+	/// The time to send a byte at the pacing rate (ns)
+	double pacing_ns_per_byte;
+	/// The earliest departure time of the next datagram (ns, monotonic clock)
+	uint64_t next_departure_ns;
+	/// The control messages holding the departure times of the queued datagrams
+	std::vector<char> send_controls;
+
+	/// Whether the datagrams are timestamped by the kernel
+	bool timestamping;
+	/// The timestamps of the queued data
+	std::vector<uint64_t> send_timestamps;
+	/// A sent datagram waiting for its kernel timestamp
+	struct sent_datagram_t
+	{
+		/// the kernel timestamp identifier
+		uint32_t id;
+		/// the time it was given to the kernel (ns)
+		uint64_t sent;
+		/// the time it entered the emulator processing (ns), 0 if unknown
+		uint64_t stamped;
+	};
+	/// The sent datagrams by kernel timestamp identifier, modulo its size
+	std::vector<sent_datagram_t> sent_datagrams;
+	/// The kernel timestamp identifier of the next sent datagram
+	uint32_t next_datagram_id;
+	/// The control messages receiving the timestamps of the received batch
+	std::vector<char> recv_controls;
+	/// The kernel timestamps of the datagrams of the received batch
+	std::vector<uint64_t> recv_timestamps;
+	/// The kernel timestamp of the last datagram read
+	uint64_t last_timestamp;
+
+	/// The buffers receiving a batch of datagrams
+	std::vector<unsigned char> recv_buffers;
+	/// The scatter-gather buffers of the received datagrams
+	std::vector<struct iovec> recv_iovecs;
+	/// The headers of the received datagrams
+	std::vector<struct mmsghdr> recv_msgs;
+	/// The source addresses of the received datagrams
+	std::vector<struct sockaddr_in> recv_addrs;
+	/// The number of datagrams in the received batch
+	std::size_t recv_count;
+	/// The next datagram to handle in the received batch
+	std::size_t recv_index;
 
 	/// sometimes an UDP datagram containing unfragmented IP packet overtake one
 	/// containing fragmented IP packets during its reassembly
-	/// Thus, we use the stacks per IP sources to keep the UDP datagram arrived too early
-	std::map<std::string, UdpStack *> stacks;
+	/// Thus, we use the stacks per sources to keep the UDP datagram arrived too early,
+	/// the key is built from the binary source address and port
+	std::unordered_map<uint64_t, UdpStack> stacks;
+
+	/// The source of the last received datagram and its stack,
+	/// most channels only have one source
+	uint64_t last_source;
+	UdpStack *last_stack;
 
-	/// the IP address of the stack for which we need to send a packet or
-	//  empty string if we have nothing to send
-	std::string stacked_ip;
+	/// the stack for which we need to send a packet or
+	//  nullptr if we have nothing to send
+	UdpStack *stacked;
 
 	/// The maximum number of packets buffered in the software stack before sending content
 	unsigned int max_stack;
@@ -178,70 +495,26 @@ protected:
 	/// Output Log
 	std::shared_ptr<OutputLog> log_sat_carrier;
 	std::shared_ptr<OutputLog> log_init;
-};
-
-/*
- * @class The UDP stack
- * @brief This stack allows UDP packets ordering in order to avoid
- *        sequence desynchronizations
- */
-class UdpStack: std::vector<std::pair<unsigned char *, size_t> > 
-{
-public:
-	/**
-	 * @brief Create the stack
-	 *
-	 */
-	UdpStack();
-
-	~UdpStack();
-
-	/**
-	 * @brief Add a packet in the stack
-	 *
-	 * @param udp_counter  The position of the packet in the stack
-	 * @param data         The packet to store
-	 * @param data_length  The packet length
-	 */
-	void add(uint8_t udp_counter, unsigned char *data, size_t data_length);
-
-	/**
-	 * @brief Remove a packet from the stack
-	 *
-	 * @param udp_counter  The position of the packet in the stack
-	 * @param data         OUT: the packet stored in the stack or NULL if there
-	 *                          is no packet with this counter
-	 * @param data_length  OUT: the packet length or 0 if there is no packet
-	 */
-	void remove(uint8_t udp_counter, unsigned char **data, size_t &data_length);
-
-	/**
-	 * @brief Check if we have a packet at a specified counter
-	 *
-	 * @param udp_counter  The counter for which we need a packet
-	 * @return true if we have a packet, false otherwise
-	 */
-	bool hasNext(uint8_t udp_counter);
-
-	/**
-	 * @brief Get the packet counter
-	 * @return the counter
-	 */
-	inline uint8_t getCounter() const { return this->counter; };
 
-	/**
-	 * @brief Reset the stack
-	 */
-	void reset();
-
-private:
-	/// A counter that increase each time we receive a packet and decrease each time
-	//  we handle a packet
-	uint8_t counter;
-
-	// Output log
-	std::shared_ptr<OutputLog> log_sat_carrier;
+	/// The datagrams considered lost after a gap in the sequence
+	std::shared_ptr<Probe<int>> probe_lost;
+	/// The datagrams received before a previous one in the sequence
+	std::shared_ptr<Probe<int>> probe_reordered;
+	/// The datagrams received after being considered lost
+	std::shared_ptr<Probe<int>> probe_late;
+
+	/// The prefix of the channel probes
+	std::string probe_prefix;
+	/// The time the received datagrams waited in the socket (us)
+	std::shared_ptr<HistogramProbe> probe_socket_residency;
+	/// The time the sent datagrams waited in the channel since their timestamp (us)
+	std::shared_ptr<HistogramProbe> probe_queue_residency;
+	/// The time the sent datagrams waited in the kernel (us)
+	std::shared_ptr<HistogramProbe> probe_kernel_residency;
+	/// The time from the timestamp of the sent datagrams to their
+	/// emission by the driver (us), from wire to wire for the frames
+	/// received on a carrier
+	std::shared_ptr<HistogramProbe> probe_emulator_residency;
 };
 
-
 #endif
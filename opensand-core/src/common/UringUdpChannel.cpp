@@ -0,0 +1,474 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file UringUdpChannel.cpp
+ * @brief An UDP satellite carrier channel sending its datagrams through io_uring
+ * @author Viveris Technologies
+ */
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#if HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#endif
+
+// zero-copy sendmsg appeared with Linux 6.1, along with the deferred task run
+#if defined(IORING_SETUP_DEFER_TASKRUN)
+#define URING_SENDMSG_ZC 1
+#endif
+
+#include <opensand_output/Output.h>
+
+#include "UringUdpChannel.h"
+
+
+UringUdpChannel::UringUdpChannel(std::string name,
+                                 spot_id_t s_id,
+                                 unsigned int channel_id,
+                                 bool input,
+                                 bool output,
+                                 unsigned short port,
+                                 bool multicast,
+                                 const std::string local_ip_addr,
+                                 const std::string ip_addr,
+                                 unsigned int stack,
+                                 unsigned int rmem,
+                                 unsigned int wmem):
+	UdpChannel(name, s_id, channel_id, input, output, port, multicast,
+	           local_ip_addr, ip_addr, stack, rmem, wmem),
+	ring_fd(-1),
+	sq_ring(MAP_FAILED),
+	sq_ring_size(0),
+	cq_ring(MAP_FAILED),
+	cq_ring_size(0),
+	sqes(nullptr),
+	sqes_size(0),
+	sq_head(nullptr),
+	sq_tail(nullptr),
+	sq_mask(nullptr),
+	sq_array(nullptr),
+	sq_entries(0),
+	cq_head(nullptr),
+	cq_tail(nullptr),
+	cq_mask(nullptr),
+	cqes(nullptr),
+	slots(),
+	free_slots(),
+	copy_buffer()
+{
+	if(!this->isInit() || !this->isOutputOk())
+	{
+		// only the emission goes through the ring
+		return;
+	}
+
+	if(!this->initRing())
+	{
+		LOG(this->log_init, LEVEL_WARNING,
+		    "cannot use io_uring on channel %d, fall back on UDP sockets\n",
+		    this->getChannelID());
+		return;
+	}
+
+	LOG(this->log_init, LEVEL_NOTICE,
+	    "channel %d sends its datagrams through io_uring (%u entries)\n",
+	    this->getChannelID(), this->sq_entries);
+}
+
+
+UringUdpChannel::~UringUdpChannel()
+{
+#if URING_SENDMSG_ZC
+	// the kernel may still read the data of the datagrams in flight
+	while(this->isRingUsed() && this->free_slots.size() < this->slots.size())
+	{
+		if(!this->enter(true))
+		{
+			break;
+		}
+		this->reap();
+	}
+#endif
+	if(this->sqes != nullptr)
+	{
+		munmap(this->sqes, this->sqes_size);
+	}
+	if(this->cq_ring != MAP_FAILED && this->cq_ring != this->sq_ring)
+	{
+		munmap(this->cq_ring, this->cq_ring_size);
+	}
+	if(this->sq_ring != MAP_FAILED)
+	{
+		munmap(this->sq_ring, this->sq_ring_size);
+	}
+	if(this->ring_fd >= 0)
+	{
+		// also unregisters the buffers
+		close(this->ring_fd);
+	}
+}
+
+
+bool UringUdpChannel::isRingUsed() const
+{
+	return this->ring_fd >= 0;
+}
+
+
+#if URING_SENDMSG_ZC
+
+bool UringUdpChannel::initRing()
+{
+	struct io_uring_params params;
+	bzero(&params, sizeof(params));
+
+	// each datagram in flight completes with its result and its notification
+	params.flags = IORING_SETUP_CQSIZE;
+	params.cq_entries = 2 * max_inflight;
+
+	int fd = syscall(__NR_io_uring_setup, max_batch, &params);
+	if(fd < 0)
+	{
+		LOG(this->log_init, LEVEL_WARNING,
+		    "cannot create io_uring: %s (%d)\n", strerror(errno), errno);
+		return false;
+	}
+	this->ring_fd = fd;
+
+	// the datagrams are sent with zero-copy sendmsg
+	std::vector<unsigned char> probe_buffer(sizeof(struct io_uring_probe) +
+	                                        256 * sizeof(struct io_uring_probe_op));
+	struct io_uring_probe *probe = reinterpret_cast<struct io_uring_probe *>(probe_buffer.data());
+	if(syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0 ||
+	   probe->last_op < IORING_OP_SENDMSG_ZC ||
+	   !(probe->ops[IORING_OP_SENDMSG_ZC].flags & IO_URING_OP_SUPPORTED))
+	{
+		LOG(this->log_init, LEVEL_WARNING,
+		    "io_uring zero-copy sends are not supported by the kernel\n");
+		close(fd);
+		this->ring_fd = -1;
+		return false;
+	}
+
+	this->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	this->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	if(params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		this->sq_ring_size = std::max(this->sq_ring_size, this->cq_ring_size);
+		this->cq_ring_size = this->sq_ring_size;
+	}
+
+	this->sq_ring = mmap(nullptr, this->sq_ring_size, PROT_READ | PROT_WRITE,
+	                     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if(this->sq_ring == MAP_FAILED)
+	{
+		LOG(this->log_init, LEVEL_WARNING,
+		    "cannot map io_uring submission queue: %s (%d)\n",
+		    strerror(errno), errno);
+		return false;
+	}
+	if(params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		this->cq_ring = this->sq_ring;
+	}
+	else
+	{
+		this->cq_ring = mmap(nullptr, this->cq_ring_size, PROT_READ | PROT_WRITE,
+		                     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if(this->cq_ring == MAP_FAILED)
+		{
+			LOG(this->log_init, LEVEL_WARNING,
+			    "cannot map io_uring completion queue: %s (%d)\n",
+			    strerror(errno), errno);
+			return false;
+		}
+	}
+
+	this->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	void *sqes = mmap(nullptr, this->sqes_size, PROT_READ | PROT_WRITE,
+	                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if(sqes == MAP_FAILED)
+	{
+		LOG(this->log_init, LEVEL_WARNING,
+		    "cannot map io_uring submission entries: %s (%d)\n",
+		    strerror(errno), errno);
+		return false;
+	}
+	this->sqes = static_cast<struct io_uring_sqe *>(sqes);
+
+	unsigned char *sq = static_cast<unsigned char *>(this->sq_ring);
+	this->sq_head = reinterpret_cast<unsigned int *>(sq + params.sq_off.head);
+	this->sq_tail = reinterpret_cast<unsigned int *>(sq + params.sq_off.tail);
+	this->sq_mask = reinterpret_cast<unsigned int *>(sq + params.sq_off.ring_mask);
+	this->sq_array = reinterpret_cast<unsigned int *>(sq + params.sq_off.array);
+	this->sq_entries = params.sq_entries;
+
+	unsigned char *cq = static_cast<unsigned char *>(this->cq_ring);
+	this->cq_head = reinterpret_cast<unsigned int *>(cq + params.cq_off.head);
+	this->cq_tail = reinterpret_cast<unsigned int *>(cq + params.cq_off.tail);
+	this->cq_mask = reinterpret_cast<unsigned int *>(cq + params.cq_off.ring_mask);
+	this->cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+
+	this->slots.resize(max_inflight);
+	this->free_slots.reserve(max_inflight);
+	for(unsigned int slot = max_inflight; slot > 0; --slot)
+	{
+		this->free_slots.push_back(slot - 1);
+	}
+	this->copy_buffer.resize(max_inflight * slot_size);
+
+	return true;
+}
+
+
+bool UringUdpChannel::flush()
+{
+	// the zero-copy sends do not carry the departure times,
+	// and their kernel timestamps are not matched with the datagrams
+	if(!this->isRingUsed() || this->pacing == Pacing::departure_time ||
+	   this->timestamping)
+	{
+		return UdpChannel::flush();
+	}
+
+	// release the slots of the previous flushes first
+	bool status = this->reap();
+
+	std::size_t nb_msgs = this->send_queue.size();
+	std::size_t prepared = 0;
+	while(prepared < nb_msgs)
+	{
+		unsigned int sq_used = *this->sq_tail - __atomic_load_n(this->sq_head, __ATOMIC_ACQUIRE);
+		if(this->free_slots.empty() || sq_used >= this->sq_entries)
+		{
+			// submit what is prepared, and wait for slots if all are in flight
+			if(!this->enter(this->free_slots.empty()))
+			{
+				status = false;
+				break;
+			}
+			status &= this->reap();
+			continue;
+		}
+		this->prepare(prepared++);
+	}
+	if(prepared < nb_msgs)
+	{
+		LOG(this->log_sat_carrier, LEVEL_ERROR,
+		    "Error: %zu datagrams dropped on channel %d\n",
+		    nb_msgs - prepared, m_channel_id);
+	}
+	else if(!this->enter(false))
+	{
+		status = false;
+	}
+	// the sends completed inline report their errors now
+	status &= this->reap();
+
+	LOG(this->log_sat_carrier, LEVEL_INFO,
+	    "==> SAT_Channel_Send [%d] (%s:%d): %zu datagrams, counter: %d\n",
+	    m_channel_id, inet_ntoa(this->m_remoteIPAddress.sin_addr),
+	    ntohs(this->m_remoteIPAddress.sin_port), nb_msgs,
+	    this->counter);
+
+	this->send_queue.clear();
+	this->send_counters.clear();
+	this->send_owners.clear();
+	return status;
+}
+
+
+void UringUdpChannel::prepare(std::size_t index)
+{
+	unsigned int slot_index = this->free_slots.back();
+	this->free_slots.pop_back();
+
+	SendSlot &slot = this->slots[slot_index];
+	const auto &datagram = this->send_queue[index];
+	slot.counter = this->send_counters[index];
+	slot.length = datagram.second;
+	slot.owner = std::move(this->send_owners[index]);
+	const unsigned char *data = datagram.first;
+	if(!slot.owner)
+	{
+		// the data is only valid until the flush returns
+		unsigned char *copy = &this->copy_buffer[slot_index * slot_size];
+		memcpy(copy, datagram.first, datagram.second);
+		data = copy;
+	}
+
+	slot.iov[0].iov_base = &slot.counter;
+	slot.iov[0].iov_len = 1;
+	slot.iov[1].iov_base = const_cast<unsigned char *>(data);
+	slot.iov[1].iov_len = slot.length;
+	bzero(&slot.msg, sizeof(slot.msg));
+	slot.msg.msg_name = &this->m_remoteIPAddress;
+	slot.msg.msg_namelen = sizeof(this->m_remoteIPAddress);
+	slot.msg.msg_iov = slot.iov;
+	slot.msg.msg_iovlen = 2;
+
+	unsigned int tail = *this->sq_tail;
+	unsigned int position = tail & *this->sq_mask;
+	struct io_uring_sqe *sqe = &this->sqes[position];
+	bzero(sqe, sizeof(*sqe));
+	sqe->opcode = IORING_OP_SENDMSG_ZC;
+	sqe->fd = this->sock_channel;
+	sqe->addr = reinterpret_cast<uint64_t>(&slot.msg);
+	sqe->len = 1;
+	sqe->user_data = slot_index;
+	this->sq_array[position] = position;
+	__atomic_store_n(this->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+
+bool UringUdpChannel::enter(bool wait)
+{
+	bool retried = false;
+	while(true)
+	{
+		unsigned int head = __atomic_load_n(this->sq_head, __ATOMIC_ACQUIRE);
+		unsigned int to_submit = *this->sq_tail - head;
+		if(to_submit == 0 && !wait)
+		{
+			return true;
+		}
+		int ret = syscall(__NR_io_uring_enter, this->ring_fd, to_submit,
+		                  wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0,
+		                  nullptr, 0);
+		if(ret >= 0)
+		{
+			return true;
+		}
+		if(errno == EINTR)
+		{
+			continue;
+		}
+		if((errno == EBUSY || errno == EAGAIN) && !retried)
+		{
+			// the completion queue is full, make room and retry once
+			this->reap();
+			retried = true;
+			continue;
+		}
+
+		LOG(this->log_sat_carrier, LEVEL_ERROR,
+		    "Error: io_uring_enter errno %s (%d), %u datagrams "
+		    "dropped\n", strerror(errno), errno, to_submit);
+		// the kernel did not consume these entries, withdraw them
+		// so their slots are not reused while still submitted
+		head = __atomic_load_n(this->sq_head, __ATOMIC_ACQUIRE);
+		for(unsigned int position = head; position != *this->sq_tail; ++position)
+		{
+			this->release(this->sqes[position & *this->sq_mask].user_data);
+		}
+		__atomic_store_n(this->sq_tail, head, __ATOMIC_RELEASE);
+		return false;
+	}
+}
+
+
+bool UringUdpChannel::reap()
+{
+	bool status = true;
+
+	// each send completes with its result, then with a notification
+	// once the kernel released the data if the result has the MORE flag
+	unsigned int head = *this->cq_head;
+	unsigned int cq_tail = __atomic_load_n(this->cq_tail, __ATOMIC_ACQUIRE);
+	for(; head != cq_tail; ++head)
+	{
+		const struct io_uring_cqe &cqe = this->cqes[head & *this->cq_mask];
+		unsigned int slot_index = cqe.user_data;
+		if(cqe.flags & IORING_CQE_F_NOTIF)
+		{
+			this->release(slot_index);
+			continue;
+		}
+
+		const SendSlot &slot = this->slots[slot_index];
+		if(cqe.res < 0)
+		{
+			LOG(this->log_sat_carrier, LEVEL_ERROR,
+			    "Error: datagram with counter %u not sent on channel %d: "
+			    "%s (%d)\n", slot.counter, m_channel_id,
+			    strerror(-cqe.res), -cqe.res);
+			status = false;
+		}
+		else if(std::size_t(cqe.res) < slot.length + 1)
+		{
+			LOG(this->log_sat_carrier, LEVEL_ERROR,
+			    "datagram with counter %u truncated on channel %d\n",
+			    slot.counter, m_channel_id);
+			status = false;
+		}
+		if(!(cqe.flags & IORING_CQE_F_MORE))
+		{
+			// no notification follows
+			this->release(slot_index);
+		}
+	}
+	__atomic_store_n(this->cq_head, head, __ATOMIC_RELEASE);
+
+	return status;
+}
+
+
+void UringUdpChannel::release(unsigned int slot)
+{
+	this->slots[slot].owner.reset();
+	this->free_slots.push_back(slot);
+}
+
+#else
+
+bool UringUdpChannel::initRing()
+{
+	LOG(this->log_init, LEVEL_WARNING,
+	    "io_uring zero-copy sends were not available at build time\n");
+	return false;
+}
+
+
+bool UringUdpChannel::flush()
+{
+	return UdpChannel::flush();
+}
+
+#endif
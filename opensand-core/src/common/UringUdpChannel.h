@@ -0,0 +1,195 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file UringUdpChannel.h
+ * @brief An UDP satellite carrier channel sending its datagrams through io_uring
+ * @author Viveris Technologies
+ */
+
+#ifndef SAT_CARRIER_URING_UDP_CHANNEL_H
+#define SAT_CARRIER_URING_UDP_CHANNEL_H
+
+
+#include <vector>
+
+#include "UdpChannel.h"
+
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+
+/*
+ * @class UringUdpChannel
+ * @brief UDP satellite carrier channel whose queued datagrams are submitted
+ *        through an io_uring ring as zero-copy sends, so a flush costs one
+ *        system call and the kernel does not copy the datagrams.
+ *
+ * The data given with its owner is sent in place, the channel keeps the
+ * owner until the kernel notifies that it released the data, so a flush
+ * does not wait for the notifications: they are reaped by the next
+ * flushes, which only wait when all the send slots are in flight.
+ * The data queued without owner is copied in its send slot first.
+ * The datagrams keep the UDP channel format and sequencing, so the
+ * remote side may indifferently use this channel or an UdpChannel.
+ * Reception is not changed as the reordering needs the source address
+ * of each datagram, which the recvmmsg batches already provide.
+ * If the ring cannot be created (kernel support, locked memory limit)
+ * the channel behaves as an UdpChannel.
+ */
+class UringUdpChannel: public UdpChannel
+{
+public:
+	UringUdpChannel(std::string name,
+	                spot_id_t s_id,
+	                unsigned int channel_id,
+	                bool input, bool output,
+	                unsigned short port,
+	                bool multicast,
+	                const std::string local_ip_addr,
+	                const std::string ip_addr,
+	                unsigned int stack,
+	                unsigned int rmem,
+	                unsigned int wmem);
+
+	~UringUdpChannel();
+
+	/**
+	 * @brief Send all the queued datagrams with one ring submission
+	 *
+	 * @return true on success, false if some data could not be sent,
+	 *         the errors of asynchronous sends are reported by the
+	 *         flush that reaps them
+	 */
+	bool flush() override;
+
+	/**
+	 * @brief Check whether the datagrams are sent through io_uring
+	 *
+	 * @return true if the ring is used, false if the channel fell back on UDP
+	 */
+	bool isRingUsed() const;
+
+private:
+	/**
+	 * @brief Create the ring and register the send buffers
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool initRing();
+
+	/**
+	 * @brief Prepare the submission of a queued datagram in a free send slot
+	 *
+	 * @param index  The index of the datagram in the queue
+	 */
+	void prepare(std::size_t index);
+
+	/**
+	 * @brief Submit the prepared datagrams, the submissions the kernel
+	 *        did not consume are withdrawn on error
+	 *
+	 * @param wait  Whether to wait for at least one completion
+	 * @return true on success, false otherwise
+	 */
+	bool enter(bool wait);
+
+	/**
+	 * @brief Handle the available completions and release
+	 *        the send slots whose data the kernel released
+	 *
+	 * @return true on success, false if some datagrams could not be sent
+	 */
+	bool reap();
+
+	/**
+	 * @brief Release a send slot and the owner of its data
+	 *
+	 * @param slot  The index of the slot
+	 */
+	void release(unsigned int slot);
+
+	/// The size of the copy of a datagram sent without owner
+	static constexpr std::size_t slot_size = MAX_SOCK_SIZE;
+
+	/// The number of datagrams that may be in flight,
+	/// each one needs a result and a notification completion
+	static constexpr std::size_t max_inflight = 4 * max_batch;
+
+	/// A datagram submitted to the ring
+	struct SendSlot
+	{
+		/// The sequencing field
+		uint8_t counter;
+		/// The length of the data
+		std::size_t length;
+		/// The owner of the data, kept until the kernel released it
+		std::shared_ptr<const void> owner;
+		/// The sequencing field and the data of the datagram
+		struct iovec iov[2];
+		/// The header of the datagram
+		struct msghdr msg;
+	};
+
+	/// The ring file descriptor
+	int ring_fd;
+
+	/// The submission queue ring mapping
+	void *sq_ring;
+	std::size_t sq_ring_size;
+	/// The completion queue ring mapping, may be the same as the submission one
+	void *cq_ring;
+	std::size_t cq_ring_size;
+	/// The submission queue entries
+	struct io_uring_sqe *sqes;
+	std::size_t sqes_size;
+
+	/// The submission queue fields
+	unsigned int *sq_head;
+	unsigned int *sq_tail;
+	unsigned int *sq_mask;
+	unsigned int *sq_array;
+	unsigned int sq_entries;
+
+	/// The completion queue fields
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int *cq_mask;
+	struct io_uring_cqe *cqes;
+
+	/// The datagrams that may be in flight
+	std::vector<SendSlot> slots;
+	/// The indexes of the slots not in flight
+	std::vector<unsigned int> free_slots;
+	/// The copies of the data queued without owner, one per slot
+	std::vector<unsigned char> copy_buffer;
+};
+
+#endif
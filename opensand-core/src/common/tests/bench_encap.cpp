@@ -0,0 +1,577 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * Micro-benchmark of the encapsulation plugins
+ *
+ * The application generates synthetic flows of Ethernet frames (IMIX, VoIP
+ * and bulk TCP), encapsulates them with each encapsulation plugin in frames
+ * of several sizes as the DVB schedulers do, then decapsulates the frames
+ * as the DVB receivers do and checks that all the frames are retrieved.
+ *
+ * For each plugin, flow and frame size, it reports the packets and bytes
+ * rates, the allocations per packet and the median and 99th percentile
+ * of the encapsulation latency of a packet. The allocations include the
+ * bursts and packets the plugins API hands over (a NetBurst and a NetPacket
+ * per packet and per fragment at least), a plugin in steady state adds
+ * none to them.
+ *
+ * Launch the application with -h to learn how to use it.
+ *
+ * Author: Viveris Technologies
+ */
+
+// OpenSAND includes
+#include "EncapPlugin.h"
+#include "Ethernet.h"
+#include "NetBurst.h"
+#include "NetContainer.h"
+#include "NetPacket.h"
+#include "OpenSandModelConf.h"
+#include "Plugin.h"
+
+#include <opensand_output/Output.h>
+
+// system includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+
+/// The program usage
+#define USAGE \
+"Encapsulation plugins benchmark: measure the encapsulation plugins performances on synthetic flows\n\n\
+usage: bench_encap [-h] [-n packets] [-p profile] [plugin...]\n\
+\t-h          print this usage and exit\n\
+\t-n packets  the number of packets of each flow (default: 100000)\n\
+\t-p profile  the entity profile giving the network and plugins configuration\n\
+\t            (default: Ethernet frames, GSE packing threshold of 3 ms\n\
+\t            and RLE sequence numbers)\n\
+\tplugin      the encapsulation plugins to benchmark (default: GSE RLE)\n\n"
+
+#define ERROR(format, ...) \
+	do { \
+		fprintf(stderr, format, ##__VA_ARGS__); \
+	} while(0)
+
+
+/// The profile used when none is given
+static const char *default_profile =
+"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+"<model version=\"1.0.0\">\n"
+"  <root>\n"
+"    <network>\n"
+"      <qos_classes>\n"
+"        <item><pcp>0</pcp><name>BE</name><fifo>BE</fifo></item>\n"
+"      </qos_classes>\n"
+"      <virtual_connections/>\n"
+"      <qos_settings>\n"
+"        <lan_frame_type>Ethernet</lan_frame_type>\n"
+"        <sat_frame_type>Ethernet</sat_frame_type>\n"
+"        <default_pcp>0</default_pcp>\n"
+"      </qos_settings>\n"
+"    </network>\n"
+"    <encap>\n"
+"      <gse><packing_threshold>3</packing_threshold></gse>\n"
+"      <rle><alpdu_protection>Sequence Number</alpdu_protection></rle>\n"
+"    </encap>\n"
+"  </root>\n"
+"</model>\n";
+
+
+/*
+ * Count the allocations, the ones of the C libraries (libgse, librle)
+ * included, by interposing the glibc allocator; the C++ allocations
+ * go through malloc
+ */
+static std::atomic<uint64_t> allocations{0};
+
+extern "C"
+{
+	void *__libc_malloc(std::size_t size);
+	void *__libc_calloc(std::size_t count, std::size_t size);
+	void *__libc_realloc(void *pointer, std::size_t size);
+
+	void *malloc(std::size_t size)
+	{
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		return __libc_malloc(size);
+	}
+
+	void *calloc(std::size_t count, std::size_t size)
+	{
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		return __libc_calloc(count, size);
+	}
+
+	void *realloc(void *pointer, std::size_t size)
+	{
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		return __libc_realloc(pointer, size);
+	}
+}
+
+
+/// A synthetic flow: IP packets lengths and their weights
+struct traffic_mix_t
+{
+	const char *name;
+	std::vector<std::pair<std::size_t, unsigned int>> lengths;
+};
+
+static const std::vector<traffic_mix_t> traffic_mixes =
+{
+	// simple IMIX
+	{"imix", {{40, 7}, {576, 4}, {1500, 1}}},
+	// G.711 voice over RTP, 20 ms per packet
+	{"voip", {{200, 1}}},
+	// bulk TCP transfer and its delayed acknowledgements
+	{"bulk", {{1500, 2}, {40, 1}}},
+};
+
+/// The frames payload lengths to fill for each plugin:
+/// BBFrames for GSE and DVB-RCS2 bursts for RLE
+static const std::map<std::string, std::vector<std::size_t>> frame_lengths =
+{
+	{"GSE", {1000, 4000, 7000}},
+	{"RLE", {60, 120, 460}},
+};
+
+
+/// The results of a run
+struct bench_result_t
+{
+	uint64_t packets;
+	uint64_t bytes;
+	uint64_t frames;
+	double encap_seconds;
+	double decap_seconds;
+	uint64_t encap_allocations;
+	uint64_t decap_allocations;
+	std::vector<uint64_t> latencies_ns;
+	uint64_t decap_packets;
+	uint64_t decap_bytes;
+};
+
+
+using bench_clock = std::chrono::steady_clock;
+
+static double seconds(bench_clock::duration duration)
+{
+	return std::chrono::duration<double>(duration).count();
+}
+
+
+/**
+ * @brief Generate the Ethernet frames of a flow
+ *
+ * @param mix      The traffic mix
+ * @param count    The number of frames
+ * @param frames   OUT: the frames
+ */
+static void generate_flow(const traffic_mix_t &mix,
+                          std::size_t count,
+                          std::vector<Data> &frames)
+{
+	std::mt19937 random{42};
+	std::vector<unsigned int> weights;
+	for(auto &&length: mix.lengths)
+	{
+		weights.push_back(length.second);
+	}
+	std::discrete_distribution<std::size_t> pick{weights.begin(), weights.end()};
+
+	frames.clear();
+	frames.reserve(count);
+	for(std::size_t index = 0; index < count; ++index)
+	{
+		std::size_t ip_length = mix.lengths[pick(random)].first;
+		Data frame;
+		frame.assign(14 + ip_length, 0);
+
+		// Ethernet header: destination, source, IPv4 ethertype
+		const unsigned char dst_mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x02};
+		const unsigned char src_mac[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x01};
+		std::copy(dst_mac, dst_mac + 6, frame.begin());
+		std::copy(src_mac, src_mac + 6, frame.begin() + 6);
+		frame[12] = 0x08;
+		frame[13] = 0x00;
+
+		// IPv4 header with the total length, UDP protocol
+		frame[14] = 0x45;
+		frame[16] = ip_length >> 8;
+		frame[17] = ip_length & 0xff;
+		frame[22] = 64;
+		frame[23] = 17;
+		for(std::size_t byte = 34; byte < frame.size(); ++byte)
+		{
+			frame[byte] = random();
+		}
+		frames.push_back(frame);
+	}
+}
+
+
+/**
+ * @brief Decapsulate a complete frame
+ *
+ * @return false if the decapsulation failed
+ */
+static bool decapsulate_frame(EncapPlugin *plugin,
+                              const Data &frame,
+                              unsigned int frame_packets,
+                              bench_result_t &result)
+{
+	if(frame_packets == 0)
+	{
+		return true;
+	}
+	result.frames++;
+
+	uint64_t allocations_start = allocations.load(std::memory_order_relaxed);
+	auto start = bench_clock::now();
+
+	bool partial_decap;
+	std::vector<std::unique_ptr<NetPacket>> decap_packets;
+	std::unique_ptr<NetContainer> container{new NetContainer{frame}};
+	if(!plugin->getPacketHandler()->getEncapsulatedPackets(std::move(container),
+	                                                        partial_decap,
+	                                                        decap_packets,
+	                                                        frame_packets))
+	{
+		ERROR("%s: cannot get the packets of a frame\n", plugin->getName().c_str());
+		return false;
+	}
+
+	NetBurst *burst = new NetBurst();
+	for(auto &&packet: decap_packets)
+	{
+		burst->push_back(std::move(packet));
+	}
+	burst = plugin->getContext()->deencapsulate(burst);
+	if(burst == nullptr)
+	{
+		ERROR("%s: cannot decapsulate a frame\n", plugin->getName().c_str());
+		return false;
+	}
+
+	result.decap_seconds += seconds(bench_clock::now() - start);
+	result.decap_allocations += allocations.load(std::memory_order_relaxed) - allocations_start;
+
+	for(auto &&packet: *burst)
+	{
+		result.decap_packets++;
+		result.decap_bytes += packet->getTotalLength();
+	}
+	delete burst;
+	return true;
+}
+
+
+/**
+ * @brief Encapsulate a flow in frames of a given length and decapsulate them
+ *
+ * @return false if the encapsulation or the decapsulation failed
+ */
+static bool run(EncapPlugin *plugin,
+                Ethernet *lan,
+                const std::vector<Data> &flow,
+                std::size_t frame_length,
+                bench_result_t &result)
+{
+	EncapPlugin::EncapContext *context = plugin->getContext();
+	EncapPlugin::EncapPacketHandler *handler = plugin->getPacketHandler();
+	std::map<long, int> time_contexts;
+
+	result = bench_result_t{};
+	result.latencies_ns.reserve(flow.size());
+
+	Data frame;
+	frame.reserve(frame_length);
+	unsigned int frame_packets = 0;
+
+	for(auto &&data: flow)
+	{
+		// the LAN packet is built by the LAN adaptation, out of the measure
+		std::unique_ptr<NetPacket> lan_packet = lan->getPacketHandler()->build(data, data.size(), 0, 1, 0);
+		result.packets++;
+		result.bytes += data.size();
+
+		uint64_t allocations_start = allocations.load(std::memory_order_relaxed);
+		auto start = bench_clock::now();
+		bench_clock::duration decap_time{0};
+		uint64_t decap_allocations = 0;
+
+		NetBurst *burst = new NetBurst();
+		burst->push_back(std::move(lan_packet));
+		burst = context->encapsulate(burst, time_contexts);
+		if(burst == nullptr)
+		{
+			ERROR("%s: cannot encapsulate a packet\n", plugin->getName().c_str());
+			return false;
+		}
+		NetBurst *flushed = context->flushAll();
+		if(flushed != nullptr)
+		{
+			for(auto &&packet: *flushed)
+			{
+				burst->push_back(std::move(packet));
+			}
+			delete flushed;
+		}
+
+		// fill the frames as the schedulers do
+		for(auto &&packet: *burst)
+		{
+			std::unique_ptr<NetPacket> encap_packet = std::move(packet);
+			while(encap_packet != nullptr)
+			{
+				std::unique_ptr<NetPacket> chunk;
+				std::unique_ptr<NetPacket> remaining;
+				if(!handler->encapNextPacket(std::move(encap_packet),
+				                             frame_length - frame.size(),
+				                             frame_packets == 0,
+				                             chunk, remaining))
+				{
+					ERROR("%s: cannot put a packet in a %zu-byte frame\n",
+					      plugin->getName().c_str(), frame_length);
+					return false;
+				}
+				if(chunk != nullptr)
+				{
+					frame.append(chunk->getData());
+					frame_packets++;
+				}
+				else if(frame_packets == 0)
+				{
+					ERROR("%s: a packet does not fit in an empty %zu-byte frame\n",
+					      plugin->getName().c_str(), frame_length);
+					return false;
+				}
+
+				if(remaining != nullptr || frame.size() >= frame_length)
+				{
+					// the frame is complete, send it to the receiver
+					uint64_t frame_allocations = result.decap_allocations;
+					auto decap_start = bench_clock::now();
+					if(!decapsulate_frame(plugin, frame, frame_packets, result))
+					{
+						return false;
+					}
+					decap_time += bench_clock::now() - decap_start;
+					decap_allocations += result.decap_allocations - frame_allocations;
+					frame.clear();
+					frame_packets = 0;
+				}
+				encap_packet = std::move(remaining);
+			}
+		}
+		delete burst;
+
+		// the receiver side is not part of the packet encapsulation
+		auto encap_time = bench_clock::now() - start - decap_time;
+		result.encap_seconds += seconds(encap_time);
+		result.encap_allocations += allocations.load(std::memory_order_relaxed) - allocations_start - decap_allocations;
+		result.latencies_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(encap_time).count());
+	}
+
+	// send the last frame
+	return decapsulate_frame(plugin, frame, frame_packets, result);
+}
+
+
+static void report(const std::string &plugin,
+                   const traffic_mix_t &mix,
+                   std::size_t frame_length,
+                   bench_result_t &result)
+{
+	std::sort(result.latencies_ns.begin(), result.latencies_ns.end());
+	uint64_t p50 = result.latencies_ns[result.latencies_ns.size() / 2];
+	uint64_t p99 = result.latencies_ns[result.latencies_ns.size() * 99 / 100];
+
+	printf("%-4s %-5s %5zu | %9.0f %8.2f %6.2f %7llu %7llu | %9.0f %8.2f %6.2f | %8llu %s\n",
+	       plugin.c_str(), mix.name, frame_length,
+	       result.packets / result.encap_seconds,
+	       result.bytes / result.encap_seconds / 1e6,
+	       static_cast<double>(result.encap_allocations) / result.packets,
+	       static_cast<unsigned long long>(p50),
+	       static_cast<unsigned long long>(p99),
+	       result.decap_packets / result.decap_seconds,
+	       result.decap_bytes / result.decap_seconds / 1e6,
+	       static_cast<double>(result.decap_allocations) / result.packets,
+	       static_cast<unsigned long long>(result.frames),
+	       (result.decap_packets == result.packets && result.decap_bytes == result.bytes) ? "ok" : "LOST");
+}
+
+
+int main(int argc, char *argv[])
+{
+	std::size_t count = 100000;
+	std::string profile_path = "";
+	std::vector<std::string> plugins;
+	int opt;
+
+	while((opt = getopt(argc, argv, "hn:p:")) != -1)
+	{
+		switch(opt)
+		{
+			case 'n':
+				count = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'p':
+				profile_path = optarg;
+				break;
+			case 'h':
+			default:
+				ERROR(USAGE);
+				return EXIT_FAILURE;
+		}
+	}
+	for(int index = optind; index < argc; ++index)
+	{
+		plugins.push_back(argv[index]);
+	}
+	if(plugins.empty())
+	{
+		plugins = {"GSE", "RLE"};
+	}
+	if(count == 0)
+	{
+		ERROR(USAGE);
+		return EXIT_FAILURE;
+	}
+
+	auto output = Output::Get();
+	output->configureTerminalOutput();
+
+	// load the plugins and their configuration
+	auto Conf = OpenSandModelConf::Get();
+	Conf->createModels();
+	if(!Plugin::loadPlugins(false))
+	{
+		ERROR("cannot load the plugins\n");
+		return EXIT_FAILURE;
+	}
+	Ethernet::generateConfiguration();
+	Plugin::generatePluginsConfiguration(nullptr,
+	                                     PluginType::Encapsulation,
+	                                     "encapsulation_scheme",
+	                                     "Encapsulation Scheme");
+
+	bool temporary_profile = profile_path.empty();
+	if(temporary_profile)
+	{
+		char path[] = "/tmp/bench_encap_XXXXXX";
+		int fd = mkstemp(path);
+		if(fd < 0)
+		{
+			ERROR("cannot create the default profile\n");
+			return EXIT_FAILURE;
+		}
+		close(fd);
+		profile_path = path;
+		std::ofstream{profile_path} << default_profile;
+	}
+	bool profile_read = Conf->readProfile(profile_path);
+	if(temporary_profile)
+	{
+		unlink(profile_path.c_str());
+	}
+	if(!profile_read)
+	{
+		ERROR("cannot read the profile %s\n", profile_path.c_str());
+		return EXIT_FAILURE;
+	}
+	output->finalizeConfiguration();
+
+	Ethernet *lan = Ethernet::constructPlugin();
+	if(lan == nullptr)
+	{
+		ERROR("cannot initialize the Ethernet LAN adaptation\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("                 |             encapsulation               |      decapsulation        |\n");
+	printf("plug flow  frame |     pkt/s     MB/s allocs p50(ns) p99(ns) |     pkt/s     MB/s allocs |   frames\n");
+
+	bool success = true;
+	for(auto &&name: plugins)
+	{
+		EncapPlugin *plugin = nullptr;
+		if(!Plugin::getEncapsulationPlugin(name, &plugin) || plugin == nullptr)
+		{
+			ERROR("cannot initialize the %s plugin\n", name.c_str());
+			success = false;
+			continue;
+		}
+		EncapPlugin::EncapContext *context = plugin->getContext();
+		if(!context->setUpperPacketHandler(lan->getPacketHandler()))
+		{
+			ERROR("%s does not support Ethernet as upper layer\n", name.c_str());
+			success = false;
+			continue;
+		}
+		context->setFilterTalId(0);
+
+		auto lengths = frame_lengths.find(name);
+		std::vector<std::size_t> sizes = lengths != frame_lengths.end() ?
+		                                 lengths->second :
+		                                 std::vector<std::size_t>{1000, 4000};
+		for(auto &&mix: traffic_mixes)
+		{
+			std::vector<Data> flow;
+			generate_flow(mix, count, flow);
+			for(auto &&frame_length: sizes)
+			{
+				bench_result_t result;
+				if(!run(plugin, lan, flow, frame_length, result))
+				{
+					success = false;
+					continue;
+				}
+				report(name, mix, frame_length, result);
+				if(result.decap_packets != result.packets ||
+				   result.decap_bytes != result.bytes)
+				{
+					success = false;
+				}
+			}
+		}
+	}
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
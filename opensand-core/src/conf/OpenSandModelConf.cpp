@@ -34,8 +34,14 @@
  * @author Mathias ETTINGER / <mathias.ettinger@viveris.fr>
  */
 
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
 #include <sstream>
 #include <utility>
+#include <sched.h>
+#include <unistd.h>
 
 #include <opensand_conf/Configuration.h>
 
@@ -43,6 +49,9 @@
 #include "MacAddress.h"
 #include "SarpTable.h"
 #include "CarrierType.h"
+#include "NetPacket.h"
+#include "ModulationTypes.h"
+#include "CodingTypes.h"
 
 
 const std::map<std::string, log_level_t> levels_map{
@@ -54,6 +63,14 @@ const std::map<std::string, log_level_t> levels_map{
 	{"critical", LEVEL_CRITICAL},
 };
 
+/// The bits carried by a symbol with the most efficient MODCOD
+/// (32APSK), the paced carriers never send slower than their band
+constexpr double max_bits_per_symbol = 5;
+
+/// The messages taken from a fifo on one wakeup when the batch is not
+/// configured, enough to amortise the wakeups on the traffic paths
+constexpr unsigned int default_message_batch = 16;
+
 
 OpenSandModelConf::OpenSandModelConf():
 	topology_model{nullptr},
@@ -61,7 +78,10 @@ OpenSandModelConf::OpenSandModelConf():
 	profile_model{nullptr},
 	topology{nullptr},
 	infrastructure{nullptr},
-	profile{nullptr}
+	profile{nullptr},
+	has_random_seed{false},
+	random_seed{0},
+	default_gateway_id{-1}
 {
 	this->log = Output::Get()->registerLog(LEVEL_WARNING, "Configuration");
 }
@@ -87,6 +107,12 @@ void OpenSandModelConf::createModels()
 	types->addEnumType("log_level", "Log Level", {"debug", "info", "notice", "warning", "error", "critical"});
 	types->addEnumType("entity_type", "Entity Type", {"Gateway", "Gateway Net Access", "Gateway Phy", "Satellite", "Terminal"});
 	types->addEnumType("isl_type", "Type of ISL", {"LanAdaptation", "Interconnect", "None"});
+	types->addEnumType("channel_direction", "Channel Direction", {"Both", "Upward", "Downward"});
+	types->addEnumType("sched_policy", "Scheduling Policy", {"Default", "FIFO", "RR"});
+	types->addEnumType("carrier_backend", "Carrier Backend", {"UDP", "io_uring"});
+	types->addEnumType("interco_transport", "Interconnect Transport", {"UDP", "TCP"});
+	types->addEnumType("interco_compression", "Interconnect Compression", {"None", "LZ4"});
+	types->addEnumType("probe_sampling", "Probe Sampling", {"All", "Window", "On Change"});
 
 	auto entity = infrastructure_model->getRoot()->addComponent("entity", "Emulated Entity");
 	auto entity_type = entity->addParameter("entity_type", "Entity Type", types->getType("entity_type"));
@@ -127,6 +153,17 @@ void OpenSandModelConf::createModels()
 		interco_params->addParameter("interco_udp_stack", "UDP Stack (Interconnect)", types->getType("int"))->setAdvanced(true);
 		interco_params->addParameter("interco_udp_rmem", "UDP RMem (Interconnect)", types->getType("int"))->setAdvanced(true);
 		interco_params->addParameter("interco_udp_wmem", "UDP WMem (Interconnect)", types->getType("int"))->setAdvanced(true);
+		interco_params->addParameter("interco_transport", "Transport (Interconnect)", types->getType("interco_transport"),
+		                             "TCP streams the messages without datagram length limit, large bursts are not split")->setAdvanced(true);
+		auto flush_deadline = interco_params->addParameter("interco_flush_deadline", "Flush Deadline (Interconnect)", types->getType("double"),
+		                                                   "Time the messages sent without delay wait to be gathered in datagrams, 0 sends them at once");
+		flush_deadline->setUnit("ms");
+		flush_deadline->setAdvanced(true);
+		interco_params->addParameter("interco_compression", "Compression (Interconnect Data)", types->getType("interco_compression"),
+		                             "LZ4 compresses the data datagrams sent to a remote host, skipped for incompressible data")->setAdvanced(true);
+		interco_params->addParameter("interco_data_streams", "Data Streams (Interconnect)", types->getType("int"),
+		                             "Number of UDP sockets the data messages are spread over by spot, each one received by its own thread; "
+		                             "the stream N uses the data port + 4 * N")->setAdvanced(true);
 
 		// LanAdaptation params
 		auto lan_params = isl_settings->addComponent("lan_adaptation", "Lan Adaptation",
@@ -160,6 +197,11 @@ void OpenSandModelConf::createModels()
 		gateway->addParameter("udp_stack", "UDP Stack", types->getType("int"))->setAdvanced(true);
 		gateway->addParameter("udp_rmem", "UDP RMem", types->getType("int"))->setAdvanced(true);
 		gateway->addParameter("udp_wmem", "UDP WMem", types->getType("int"))->setAdvanced(true);
+		gateway->addParameter("data_carrier_backend", "Carrier Backend (Data)", types->getType("carrier_backend"),
+		                      "io_uring sends the data carriers with zero-copy submissions, UDP is used if unavailable")->setAdvanced(true);
+		gateway->addParameter("data_carrier_pacing", "Carrier Pacing (Data)", types->getType("bool"),
+		                      "Spread the frames of the data carriers at the rate of their symbol rate instead "
+		                      "of sending them in bursts; needs the fq qdisc on the emulation interface")->setAdvanced(true);
 		gateway->addParameter("pep_port", "PEP DAMA Port", types->getType("int"))->setAdvanced(true);
 		gateway->addParameter("svno_port", "SVNO Port", types->getType("int"))->setAdvanced(true);
 	}
@@ -190,6 +232,17 @@ void OpenSandModelConf::createModels()
 		interco_params->addParameter("interco_udp_stack", "UDP Stack (Interconnect)", types->getType("int"))->setAdvanced(true);
 		interco_params->addParameter("interco_udp_rmem", "UDP RMem (Interconnect)", types->getType("int"))->setAdvanced(true);
 		interco_params->addParameter("interco_udp_wmem", "UDP WMem (Interconnect)", types->getType("int"))->setAdvanced(true);
+		interco_params->addParameter("interco_transport", "Transport (Interconnect)", types->getType("interco_transport"),
+		                             "TCP streams the messages without datagram length limit, large bursts are not split")->setAdvanced(true);
+		auto flush_deadline = interco_params->addParameter("interco_flush_deadline", "Flush Deadline (Interconnect)", types->getType("double"),
+		                                                   "Time the messages sent without delay wait to be gathered in datagrams, 0 sends them at once");
+		flush_deadline->setUnit("ms");
+		flush_deadline->setAdvanced(true);
+		interco_params->addParameter("interco_compression", "Compression (Interconnect Data)", types->getType("interco_compression"),
+		                             "LZ4 compresses the data datagrams sent to a remote host, skipped for incompressible data")->setAdvanced(true);
+		interco_params->addParameter("interco_data_streams", "Data Streams (Interconnect)", types->getType("int"),
+		                             "Number of UDP sockets the data messages are spread over by spot, each one received by its own thread; "
+		                             "the stream N uses the data port + 4 * N")->setAdvanced(true);
 		gateway_net_acc->addParameter("pep_port", "PEP DAMA Port", types->getType("int"))->setAdvanced(true);
 		gateway_net_acc->addParameter("svno_port", "SVNO Port", types->getType("int"))->setAdvanced(true);
 	}
@@ -218,6 +271,17 @@ void OpenSandModelConf::createModels()
 		interco_params->addParameter("interco_udp_stack", "UDP Stack (Interconnect)", types->getType("int"))->setAdvanced(true);
 		interco_params->addParameter("interco_udp_rmem", "UDP RMem (Interconnect)", types->getType("int"))->setAdvanced(true);
 		interco_params->addParameter("interco_udp_wmem", "UDP WMem (Interconnect)", types->getType("int"))->setAdvanced(true);
+		interco_params->addParameter("interco_transport", "Transport (Interconnect)", types->getType("interco_transport"),
+		                             "TCP streams the messages without datagram length limit, large bursts are not split")->setAdvanced(true);
+		auto flush_deadline = interco_params->addParameter("interco_flush_deadline", "Flush Deadline (Interconnect)", types->getType("double"),
+		                                                   "Time the messages sent without delay wait to be gathered in datagrams, 0 sends them at once");
+		flush_deadline->setUnit("ms");
+		flush_deadline->setAdvanced(true);
+		interco_params->addParameter("interco_compression", "Compression (Interconnect Data)", types->getType("interco_compression"),
+		                             "LZ4 compresses the data datagrams sent to a remote host, skipped for incompressible data")->setAdvanced(true);
+		interco_params->addParameter("interco_data_streams", "Data Streams (Interconnect)", types->getType("int"),
+		                             "Number of UDP sockets the data messages are spread over by spot, each one received by its own thread; "
+		                             "the stream N uses the data port + 4 * N")->setAdvanced(true);
 		gateway_phy->addParameter("emu_address", "Emulation Address", types->getType("string"), "Address this gateway should listen on for messages from the satellite");
 		gateway_phy->addParameter("ctrl_multicast_address", "Multicast IP Address (Control Messages)", types->getType("string"))->setAdvanced(true);
 		gateway_phy->addParameter("data_multicast_address", "Multicast IP Address (Data)", types->getType("string"))->setAdvanced(true);
@@ -234,6 +298,11 @@ void OpenSandModelConf::createModels()
 		gateway_phy->addParameter("udp_stack", "UDP Stack (Satellite)", types->getType("int"))->setAdvanced(true);
 		gateway_phy->addParameter("udp_rmem", "UDP RMem (Satellite)", types->getType("int"))->setAdvanced(true);
 		gateway_phy->addParameter("udp_wmem", "UDP WMem (Satellite)", types->getType("int"))->setAdvanced(true);
+		gateway_phy->addParameter("data_carrier_backend", "Carrier Backend (Data, Satellite)", types->getType("carrier_backend"),
+		                          "io_uring sends the data carriers with zero-copy submissions, UDP is used if unavailable")->setAdvanced(true);
+		gateway_phy->addParameter("data_carrier_pacing", "Carrier Pacing (Data, Satellite)", types->getType("bool"),
+		                          "Spread the frames of the data carriers at the rate of their symbol rate instead "
+		                          "of sending them in bursts; needs the fq qdisc on the emulation interface")->setAdvanced(true);
 	}
 
 	{
@@ -250,6 +319,14 @@ void OpenSandModelConf::createModels()
 		                       "MAC address this satellite terminal routes traffic to");
 		terminal->addParameter("qos_server_host", "QoS server Host Agent", types->getType("string"))->setAdvanced(true);
 		terminal->addParameter("qos_server_port", "QoS server Host Port", types->getType("int"))->setAdvanced(true);
+		auto farm = terminal->addList("terminal_farm", "Terminal Farm", "farm_terminal",
+		                              "Additional terminals emulated in this process, "
+		                              "sharing its configuration and emulation address");
+		farm->setAdvanced(true);
+		auto farm_terminal = farm->getPattern();
+		farm_terminal->addParameter("entity_id", "Terminal ID", types->getType("int"));
+		farm_terminal->addParameter("tap_iface", "TAP Interface", types->getType("string"),
+		                            "Name of the TAP interface used by this satellite terminal");
 	}
 
 	auto log_levels = infrastructure_model->getRoot()->addComponent("logs", "Logs");
@@ -270,6 +347,27 @@ void OpenSandModelConf::createModels()
 	auto expected = std::dynamic_pointer_cast<OpenSANDConf::DataValue<bool>>(path_storage->getReferenceData());
 	expected->set(true);
 
+	auto rotation_size = storage->addParameter("local_rotation_size", "Size of the Local Files Rotation (MB)", types->getType("int"),
+	                                           "Size of the logs and probes files triggering their rotation, 0 to disable");
+	infrastructure_model->setReference(rotation_size, local_storage);
+	expected = std::dynamic_pointer_cast<OpenSANDConf::DataValue<bool>>(rotation_size->getReferenceData());
+	expected->set(true);
+	rotation_size->setAdvanced(true);
+
+	auto rotation_period = storage->addParameter("local_rotation_period", "Period of the Local Files Rotation (s)", types->getType("int"),
+	                                             "Age of the logs and probes files triggering their rotation, 0 to disable");
+	infrastructure_model->setReference(rotation_period, local_storage);
+	expected = std::dynamic_pointer_cast<OpenSANDConf::DataValue<bool>>(rotation_period->getReferenceData());
+	expected->set(true);
+	rotation_period->setAdvanced(true);
+
+	auto rotation_compress = storage->addParameter("local_rotation_compress", "Compress the Rotated Local Files", types->getType("bool"),
+	                                               "Compress the rotated logs and probes files with zstd");
+	infrastructure_model->setReference(rotation_compress, local_storage);
+	expected = std::dynamic_pointer_cast<OpenSANDConf::DataValue<bool>>(rotation_compress->getReferenceData());
+	expected->set(true);
+	rotation_compress->setAdvanced(true);
+
 	auto collector_storage = storage->addParameter("enable_collector", "Enable Storage to OpenSAND Collector", types->getType("bool"));
 	auto collector_address = storage->addParameter("collector_address", "IP address of the Collector", types->getType("string"));
 	infrastructure_model->setReference(collector_address, collector_storage);
@@ -288,6 +386,137 @@ void OpenSandModelConf::createModels()
 	expected->set(true);
 	collector_probes->setAdvanced(true);
 
+	auto collector_binary = storage->addParameter("collector_binary_probes", "Send the Probes in Binary Format", types->getType("bool"),
+	                                              "Send the probes with the compact binary protocol instead of text, the collector must support it");
+	infrastructure_model->setReference(collector_binary, collector_storage);
+	expected = std::dynamic_pointer_cast<OpenSANDConf::DataValue<bool>>(collector_binary->getReferenceData());
+	expected->set(true);
+	collector_binary->setAdvanced(true);
+
+	auto carrier_timestamping = storage->addParameter("carrier_timestamping", "Timestamp the Carrier Datagrams", types->getType("bool"),
+	                                                  "Probe the latency of the datagrams in the sockets and the emulator with the kernel timestamps");
+	carrier_timestamping->setAdvanced(true);
+
+	auto probes_shm = storage->addParameter("probes_shared_memory", "Probes Shared Memory", types->getType("string"),
+	                                        "POSIX shared memory object where the latest value of each probe is published "
+	                                        "for the local collectors; empty to disable");
+	probes_shm->setAdvanced(true);
+	auto metrics_port = storage->addParameter("metrics_port", "Metrics Endpoint Port", types->getType("int"),
+	                                          "TCP port of the OpenMetrics/Prometheus HTTP endpoint scraped by the "
+	                                          "monitoring systems for the latest probes values; 0 to disable");
+	metrics_port->setAdvanced(true);
+
+	auto events_statistics = storage->addParameter("events_statistics_period", "Period of the Events Statistics Probes (ms)", types->getType("int"),
+	                                               "Period of the probes exporting the processing time and latency of the channels events, 0 to disable");
+	events_statistics->setAdvanced(true);
+	auto hardware_counters = storage->addParameter("hardware_counters", "Hardware Counters in the Events Statistics", types->getType("bool"),
+	                                               "Export the instructions per cycle and the cache and branch misses of the channels events "
+	                                               "per event type with the events statistics, needs access to perf_event_open");
+	hardware_counters->setAdvanced(true);
+	auto lock_profiling = storage->addParameter("lock_profiling", "Locks Profiling", types->getType("bool"),
+	                                            "Record the wait and hold times of the locks per lock site in histogram "
+	                                            "probes, the totals are logged at exit");
+	lock_profiling->setAdvanced(true);
+	auto trace_file = storage->addParameter("trace_file", "Trace File", types->getType("string"),
+	                                        "JSON trace (Chrome/Perfetto format) of the superframe processing spans, "
+	                                        "SIGUSR2 starts the tracing and the next one writes the trace; empty to disable");
+	trace_file->setAdvanced(true);
+
+	auto captures = storage->addList("captures", "Messages Captures", "capture");
+	captures->setAdvanced(true);
+	auto capture = captures->getPattern();
+	capture->addParameter("block", "Block Name", types->getType("string"),
+	                      "Name of the block whose sent messages are recorded (e.g. Dvb, Encap)");
+	capture->addParameter("direction", "Channel Direction", types->getType("channel_direction"));
+	capture->addParameter("file", "Capture File", types->getType("string"),
+	                      "File the messages are recorded in, suffixed by .upward or .downward "
+	                      "when both channels are recorded");
+
+	auto mirror_file = storage->addParameter("mirror_file", "Packets Mirror File", types->getType("string"),
+	                                         "pcap-ng file the packets of the internal stages are mirrored in, "
+	                                         "empty to disable the mirrors");
+	mirror_file->setAdvanced(true);
+	auto mirrors = storage->addList("mirrors", "Enabled Mirrors", "mirror");
+	mirrors->setAdvanced(true);
+	mirrors->getPattern()->addParameter("name", "Mirror Name", types->getType("string"),
+	                                    "Name of a mirror or of a group of mirrors enabled at startup "
+	                                    "(e.g. Mirror.Encap or Mirror.Dvb.Downward.bbframes), "
+	                                    "the mirrors probes can also be enabled at runtime");
+
+	auto samplings = storage->addList("probes_sampling", "Probes Sampling", "sampling");
+	samplings->setAdvanced(true);
+	auto sampling = samplings->getPattern();
+	sampling->addParameter("name", "Probes Name", types->getType("string"),
+	                       "Name of a probe or of a group of probes (e.g. Spot_1.Throughputs)");
+	sampling->addParameter("policy", "Sampling Policy", types->getType("probe_sampling"),
+	                       "Window sends the values accumulated over several periods with the sample type of the probes, "
+	                       "On Change sends a value only if it changed since the last value sent");
+	sampling->addParameter("period", "Window Length", types->getType("int"),
+	                       "Number of statistics periods accumulated in a window");
+	sampling->addParameter("threshold", "Change Threshold", types->getType("double"),
+	                       "Minimum change needed to send a new value, 0 to send any change");
+
+	auto threads = infrastructure_model->getRoot()->addComponent("threads", "Threads Placement");
+	threads->setAdvanced(true);
+	auto placements = threads->addList("placements", "Channels Placement", "placement")->getPattern();
+	placements->addParameter("block", "Block Name", types->getType("string"),
+	                         "Name of the block whose channels are placed (e.g. Dvb, Encap)");
+	placements->addParameter("direction", "Channel Direction", types->getType("channel_direction"));
+	placements->addParameter("cpus", "CPU Set", types->getType("string"),
+	                         "Comma separated list of CPUs or CPU ranges (e.g. 0-3,8), empty to keep the default affinity");
+	placements->addParameter("policy", "Scheduling Policy", types->getType("sched_policy"));
+	placements->addParameter("priority", "Real-Time Priority", types->getType("int"),
+	                         "Priority of the channel thread for the FIFO and RR policies");
+	placements->addParameter("numa_nodes", "NUMA Nodes", types->getType("string"),
+	                         "Comma separated list of NUMA nodes or node ranges the channel memory is bound to, "
+	                         "empty to prefer the node of the CPU set");
+	placements->addParameter("busy_poll", "Busy Poll", types->getType("int"),
+	                         "Time the channel spins on its input fifos and timers before sleeping, "
+	                         "for latency-critical channels pinned on isolated CPUs; 0 to always sleep")->setUnit("us");
+	placements->addParameter("huge_pages", "Huge Pages", types->getType("bool"),
+	                         "Back the fifos rings and packets pools of the channel with 2 MB huge pages, "
+	                         "reserved hugetlbfs pages are used if available, transparent huge pages otherwise");
+	auto fused_links = threads->addList("fused_links", "Fused Links", "fused_link")->getPattern();
+	fused_links->addParameter("block", "Block Name", types->getType("string"),
+	                          "Name of the block whose channels run the next blocks channels on the messages "
+	                          "they send whenever these are idle, instead of waking them up through their fifo; "
+	                          "for entities running on few CPUs (e.g. Encap, Dvb)");
+	fused_links->addParameter("direction", "Channel Direction", types->getType("channel_direction"));
+	threads->addParameter("task_workers", "Task Workers", types->getType("int"),
+	                      "Number of threads shared by the blocks to run their parallel computations "
+	                      "(encapsulation and DAMA shards); 0 to run them in the blocks channels");
+	threads->addParameter("task_cpus", "Task Workers CPU Set", types->getType("string"),
+	                      "Comma separated list of CPUs or CPU ranges spread one per task worker, "
+	                      "their memory preferring the node of their CPU; empty to keep the default affinity");
+	threads->addParameter("encap_workers", "Encapsulation Shards", types->getType("int"),
+	                      "Number of shards of the traffic sent to the satellite encapsulated in parallel "
+	                      "by the task workers, by destination terminal; 0 or 1 to encapsulate in the Encap block channel");
+	threads->addParameter("dama_workers", "DAMA Shards", types->getType("int"),
+	                      "Number of shards of the return link allocations of the NCC computed in parallel "
+	                      "by the task workers, by terminal category; 0 or 1 to compute them in the DVB block channel");
+	threads->addParameter("dama_look_ahead", "DAMA Look-Ahead", types->getType("int"),
+	                      "Number of superframes the return link allocations of the NCC are computed ahead, "
+	                      "in the middle of the superframes instead of on their change; the RBDC requests "
+	                      "received in between correct them on the capacity left; 0 to compute them on "
+	                      "the superframe change");
+	threads->addParameter("parallel_vcm", "Parallel VCM Scheduling", types->getType("bool"),
+	                      "Schedule the VCM carriers of the forward carriers groups of a gateway in parallel "
+	                      "by the task workers, each from its own VCM FIFOs and with its own BBFrames");
+	threads->addParameter("carrier_receivers", "Carrier Receive Workers", types->getType("int"),
+	                      "Number of threads receiving the input carriers of each sat carrier block, the "
+	                      "carriers are spread between them; 0 to receive them in the sat carrier channel");
+	threads->addParameter("flow_control", "Drop Data on Congestion", types->getType("bool"),
+	                      "Drop the traffic messages sent to a block whose fifo is full instead of blocking "
+	                      "the sending channel; the signalling messages always wait for space");
+	threads->addParameter("message_batch", "Messages Batch", types->getType("int"),
+	                      "Maximum number of messages a channel takes from each of its input fifos on a "
+	                      "single wakeup (e.g. the encapsulated packets sent by Encap to Dvb), the fifos "
+	                      "hold two batches; 0 for the default of 16, 1 to handle one message per wakeup");
+	threads->addParameter("virtual_time", "Virtual Time", types->getType("bool"),
+	                      "Drive the timers with a simulated clock jumping to the next expiration once all "
+	                      "the blocks are idle, to run a scenario as fast as possible; only for an entity "
+	                      "whose traffic is generated inside the process");
+
 	auto infra = infrastructure_model->getRoot()->addComponent("infrastructure", "Infrastructure");
 	infra->setAdvanced(true);
 	infra->setReadOnly(true);
@@ -317,6 +546,11 @@ void OpenSandModelConf::createModels()
 	gateways->addParameter("udp_stack", "UDP Stack", types->getType("int"))->setAdvanced(true);
 	gateways->addParameter("udp_rmem", "UDP RMem", types->getType("int"))->setAdvanced(true);
 	gateways->addParameter("udp_wmem", "UDP WMem", types->getType("int"))->setAdvanced(true);
+	gateways->addParameter("data_carrier_backend", "Carrier Backend (Data)", types->getType("carrier_backend"),
+	                       "io_uring sends the data carriers with zero-copy submissions, UDP is used if unavailable")->setAdvanced(true);
+	gateways->addParameter("data_carrier_pacing", "Carrier Pacing (Data)", types->getType("bool"),
+	                       "Spread the frames of the data carriers at the rate of their symbol rate instead "
+	                       "of sending them in bursts; needs the fq qdisc on the emulation interface")->setAdvanced(true);
 
 	auto terminals = infra->addList("terminals", "Terminals", "terminal")->getPattern();
 	terminals->addParameter("entity_id", "Entity ID", types->getType("int"));
@@ -338,8 +572,8 @@ void OpenSandModelConf::createModels()
 	types->addEnumType("forward_type", "Forward Carrier Type", {"ACM", "VCM"});
 	types->addEnumType("return_type", "Return Carrier Type", {"DAMA", "ALOHA", "SCPC"});
 	types->addEnumType("carrier_group", "Carrier Group", {"Standard", "Premium", "Professional", "SVNO1", "SVNO2", "SVNO3", "SNO"});
-	types->addEnumType("modulation", "Modulation", {"BPSK", "Pi/2BPSK", "QPSK", "8PSK", "16APSK", "16QAM", "32APSK"});
-	types->addEnumType("coding", "Coding", {"1/4", "1/3", "2/5", "1/2", "3/5", "2/3", "3/4", "4/5", "5/6", "6/7", "8/9", "9/10"});
+	types->addEnumType("modulation", "Modulation", ModulationTypes::getLabels());
+	types->addEnumType("coding", "Coding", CodingTypes::getLabels());
 	types->addEnumType("sat_regen_level", "Regeneration Level for Satellite", {"Transparent", "BBFrame", "IP"});
 
 	auto frequency_plan = topology_model->getRoot()->addComponent("frequency_plan", "Spots / Frequency Plan");
@@ -356,6 +590,12 @@ void OpenSandModelConf::createModels()
 	                              "Regeneration level for the forward channel (gateway -> terminal)");
 	spot_assignment->addParameter("return_regen_level", "Return channel regeneration level", types->getType("sat_regen_level"),
 	                              "Regeneration level for the return channel (terminal -> gateway)");
+	spot_assignment->addParameter("gw_numa_node", "Gateway NUMA node", types->getType("int"),
+	                              "NUMA node the blocks of the spot run on and allocate from on the gateway; "
+	                              "-1 or unset to keep the threads placement of the infrastructure")->setAdvanced(true);
+	spot_assignment->addParameter("sat_numa_node", "Satellite NUMA node", types->getType("int"),
+	                              "NUMA node the blocks of the spot run on and allocate from on the satellites; "
+	                              "-1 or unset to keep the threads placement of the infrastructure")->setAdvanced(true);
 	auto roll_offs = spots->addComponent("roll_off", "Roll Off");
 	roll_offs->addParameter("forward", "Forward Band Roll Off", types->getType("double"), "Usually 0.35, 0.25 or 0.2 for DVB-S2");
 	roll_offs->addParameter("return", "Return Band Roll Off", types->getType("double"), "Usually 0.2 for DVB-RCS2");
@@ -450,10 +690,62 @@ std::shared_ptr<OpenSANDConf::DataComponent> OpenSandModelConf::getProfileData(c
 		return profile->getRoot();
 	}
 
+	auto indexed = profile_index.find(path);
+	if (indexed != profile_index.end())
+	{
+		return std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(indexed->second);
+	}
+
+	// paths with leading or doubled separators are not indexed
 	return std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(profile->getItemByPath(path));
 }
 
 
+std::shared_ptr<OpenSANDConf::DataParameter> OpenSandModelConf::getProfileParameter(const std::string &path) const
+{
+	if (profile == nullptr)
+	{
+		return nullptr;
+	}
+
+	auto indexed = profile_index.find(path);
+	if (indexed != profile_index.end())
+	{
+		return std::dynamic_pointer_cast<OpenSANDConf::DataParameter>(indexed->second);
+	}
+
+	return std::dynamic_pointer_cast<OpenSANDConf::DataParameter>(profile->getItemByPath(path));
+}
+
+
+void OpenSandModelConf::indexProfile(std::shared_ptr<OpenSANDConf::DataElement> element,
+                                     const std::string &path)
+{
+	const std::vector<std::shared_ptr<OpenSANDConf::DataElement>> *items = nullptr;
+	auto component = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(element);
+	auto list = std::dynamic_pointer_cast<OpenSANDConf::DataList>(element);
+	if (component != nullptr)
+	{
+		items = &component->getItems();
+	}
+	else if (list != nullptr)
+	{
+		items = &list->getItems();
+	}
+	else
+	{
+		return;
+	}
+
+	for (auto &&item : *items)
+	{
+		std::string item_path = path.empty() ? item->getId() : path + "/" + item->getId();
+		indexProfile(item, item_path);
+		profile_index.emplace(std::move(item_path), item);
+	}
+}
+
+
 std::shared_ptr<OpenSANDConf::MetaTypesList> OpenSandModelConf::getModelTypesDefinition() const
 {
 	if (profile_model == nullptr)
@@ -589,6 +881,128 @@ bool OpenSandModelConf::writeProfileModel(const std::string& filename) const
 }
 
 
+void OpenSandModelConf::setConfigurationCache(const std::string &folder)
+{
+	cache_folder = folder;
+}
+
+
+void OpenSandModelConf::setRandomSeed(unsigned int seed)
+{
+	has_random_seed = true;
+	random_seed = seed;
+}
+
+
+bool OpenSandModelConf::getRandomSeed(unsigned int &seed) const
+{
+	if (!has_random_seed) {
+		return false;
+	}
+	seed = random_seed;
+	return true;
+}
+
+
+std::string OpenSandModelConf::getProfileModelPath(const std::string &key) const
+{
+	std::ostringstream path;
+	path << cache_folder << "/profile_" << std::hex << std::hash<std::string>{}(key) << ".xsd";
+	return path.str();
+}
+
+
+bool OpenSandModelConf::loadProfileModel(const std::string &key)
+{
+	if (cache_folder.empty())
+	{
+		return false;
+	}
+
+	// the key is stored aside, a model generated by other plugins is not used
+	std::string filepath = getProfileModelPath(key);
+	std::ifstream key_file(filepath + ".key");
+	if (!key_file)
+	{
+		return false;
+	}
+	std::string stored_key{std::istreambuf_iterator<char>(key_file), std::istreambuf_iterator<char>()};
+	if (stored_key != key)
+	{
+		return false;
+	}
+
+	auto model = OpenSANDConf::fromXSD(filepath);
+	if (model == nullptr)
+	{
+		LOG(log, LEVEL_WARNING, "cannot read profile model %s from cache", filepath.c_str());
+		return false;
+	}
+	profile_model = model;
+	LOG(log, LEVEL_INFO, "profile model read from cache %s", filepath.c_str());
+	return true;
+}
+
+
+bool OpenSandModelConf::storeProfileModel(const std::string &key) const
+{
+	if (cache_folder.empty())
+	{
+		return true;
+	}
+	if (profile_model == nullptr)
+	{
+		return false;
+	}
+
+	// the files are written aside then renamed for the processes
+	// reading them concurrently, the model before its key
+	std::string filepath = getProfileModelPath(key);
+	std::string suffix = "." + std::to_string(getpid());
+	if (!OpenSANDConf::toXSD(profile_model, filepath + suffix) ||
+	    rename((filepath + suffix).c_str(), filepath.c_str()) != 0)
+	{
+		remove((filepath + suffix).c_str());
+		return false;
+	}
+	std::ofstream key_file(filepath + ".key" + suffix, std::ios::trunc);
+	key_file << key;
+	key_file.close();
+	if (!key_file || rename((filepath + ".key" + suffix).c_str(), (filepath + ".key").c_str()) != 0)
+	{
+		remove((filepath + ".key" + suffix).c_str());
+		return false;
+	}
+	return true;
+}
+
+
+std::shared_ptr<OpenSANDConf::DataModel> OpenSandModelConf::readData(std::shared_ptr<OpenSANDConf::MetaModel> model,
+                                                                     const std::string &filename) const
+{
+	if (cache_folder.empty())
+	{
+		return OpenSANDConf::fromXML(model, filename);
+	}
+
+	auto data = OpenSANDConf::fromCache(model, filename, cache_folder);
+	if (data != nullptr)
+	{
+		LOG(log, LEVEL_INFO, "configuration file %s read from cache", filename.c_str());
+		return data;
+	}
+
+	data = OpenSANDConf::fromXML(model, filename);
+	if (data != nullptr && !OpenSANDConf::toCache(data, model, filename, cache_folder))
+	{
+		LOG(log, LEVEL_WARNING,
+		    "cannot store configuration file %s in cache folder %s",
+		    filename.c_str(), cache_folder.c_str());
+	}
+	return data;
+}
+
+
 bool OpenSandModelConf::readTopology(const std::string& filename)
 {
 	if (topology_model == nullptr)
@@ -596,12 +1010,13 @@ bool OpenSandModelConf::readTopology(const std::string& filename)
 		createModels();
 	}
 
-	topology = OpenSANDConf::fromXML(topology_model, filename);
+	topology = readData(topology_model, filename);
 	if (topology == nullptr)
 	{
 		LOG(log, LEVEL_ERROR, "parse error when reading topology file");
 		return false;
 	}
+	topology_path = filename;
 
 	if (infrastructure == nullptr)
 	{
@@ -610,10 +1025,19 @@ bool OpenSandModelConf::readTopology(const std::string& filename)
 	}
 	
 	spots_topology.clear();
+	spots_by_gateway.clear();
+	spots_per_gateway.clear();
+	terminals_gateway.clear();
+	default_gateway_id = -1;
+	{
+		std::lock_guard<std::mutex> lock(spots_carriers_lock);
+		spots_carriers.clear();
+	}
 	auto spot_list = topology->getRoot()->getComponent("frequency_plan")->getList("spots");
 	bool ok = true;
 	for (auto &&spot_item: spot_list->getItems()) {
-		auto spot_assignement = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(spot_item)->getComponent("assignments");
+		auto spot_component = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(spot_item);
+		auto spot_assignement = spot_component->getComponent("assignments");
 		int gw_id, sat_id_gw, sat_id_st;
 		std::string forward_str, return_str;
 		ok &= extractParameterData(spot_assignement, "gateway_id", gw_id);
@@ -629,7 +1053,17 @@ bool OpenSandModelConf::readTopology(const std::string& filename)
 		spot_topo.sat_id_st = sat_id_st;
 		spot_topo.forward_regen_level = strToRegenLevel(forward_str);
 		spot_topo.return_regen_level = strToRegenLevel(return_str);
+		if (!extractParameterData(spot_assignement, "gw_numa_node", spot_topo.gw_numa_node))
+		{
+			spot_topo.gw_numa_node = -1;
+		}
+		if (!extractParameterData(spot_assignement, "sat_numa_node", spot_topo.sat_numa_node))
+		{
+			spot_topo.sat_numa_node = -1;
+		}
 		spots_topology[gw_id] = spot_topo;
+		spots_by_gateway.emplace(gw_id, spot_component);
+		++spots_per_gateway[gw_id];
 	}
 	if (!ok) {
 		LOG(log, LEVEL_ERROR, "A problem occurred while extracting spot assignments");
@@ -666,6 +1100,7 @@ bool OpenSandModelConf::readTopology(const std::string& filename)
 			return false;
 		}
 		spots_topology[spot_id].st_ids.insert(st_id);
+		terminals_gateway[st_id] = spot_id;
 
 		auto non_default_st = terminal_ids.find(st_id);
 		if (non_default_st != terminal_ids.end())
@@ -674,11 +1109,15 @@ bool OpenSandModelConf::readTopology(const std::string& filename)
 		}
 	}
 
+	int default_spot;
+	auto assigned_spot = st_assignments->getComponent("defaults")->getParameter("default_gateway");
+	if (extractParameterData(assigned_spot, default_spot)) {
+		default_gateway_id = default_spot;
+	}
+
 	if (terminal_ids.size())
 	{
-		auto assigned_spot = st_assignments->getComponent("defaults")->getParameter("default_gateway");
-		int default_spot;
-		if (!extractParameterData(assigned_spot, default_spot)) {
+		if (default_gateway_id < 0) {
 			return false;
 		}
 		if (spots_topology.find(default_spot) == spots_topology.end())
@@ -698,6 +1137,29 @@ bool OpenSandModelConf::readTopology(const std::string& filename)
 }
 
 
+std::shared_ptr<OpenSANDConf::DataModel> OpenSandModelConf::readTopologyUpdate() const
+{
+	if (topology_model == nullptr || topology_path.empty())
+	{
+		LOG(log, LEVEL_ERROR, "no topology file was read yet");
+		return nullptr;
+	}
+
+	auto update = readData(topology_model, topology_path);
+	if (update == nullptr)
+	{
+		LOG(log, LEVEL_ERROR, "parse error when reading topology file update");
+	}
+	return update;
+}
+
+
+const std::string &OpenSandModelConf::getTopologyPath() const
+{
+	return topology_path;
+}
+
+
 bool OpenSandModelConf::readInfrastructure(const std::string& filename)
 {
 	if (infrastructure_model == nullptr)
@@ -706,7 +1168,8 @@ bool OpenSandModelConf::readInfrastructure(const std::string& filename)
 	}
 
 	entities_type.clear();
-	infrastructure = OpenSANDConf::fromXML(infrastructure_model, filename);
+	gateways_by_id.clear();
+	infrastructure = readData(infrastructure_model, filename);
 	if (infrastructure == nullptr) {
 		LOG(log, LEVEL_ERROR, "parse error when reading infrastructure file");
 		return false;
@@ -718,6 +1181,7 @@ bool OpenSandModelConf::readInfrastructure(const std::string& filename)
 		int gateway_id;
 		if (extractParameterData(gateway, "entity_id", gateway_id)) {
 			entities_type[gateway_id] = Component::gateway;
+			gateways_by_id.emplace(gateway_id, gateway);
 		}
 	}
 	auto satellites = infrastructure->getRoot()->getComponent("infrastructure")->getList("satellites");
@@ -748,13 +1212,17 @@ bool OpenSandModelConf::readProfile(const std::string& filename)
 		createModels();
 	}
 
-	profile = OpenSANDConf::fromXML(profile_model, filename);
+	profile_index.clear();
+	profile = readData(profile_model, filename);
 	if (profile == nullptr)
 	{
 		LOG(log, LEVEL_ERROR, "parse error when reading profile file");
 		return false;
 	}
 
+	// resolve the paths once instead of walking the tree on each access
+	indexProfile(profile->getRoot(), "");
+
 	return true;
 }
 
@@ -939,6 +1407,29 @@ bool OpenSandModelConf::getGroundInfrastructure(std::string &ip_address, std::st
 }
 
 
+bool OpenSandModelConf::getTerminalFarm(std::vector<OpenSandModelConf::farm_terminal> &terminals) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	auto terminal = infrastructure->getRoot()->getComponent("entity")->getComponent("entity_st");
+	for (auto& terminal_item : terminal->getList("terminal_farm")->getItems()) {
+		auto terminal_data = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(terminal_item);
+		int entity_id;
+		OpenSandModelConf::farm_terminal farm_terminal;
+		if (!extractParameterData(terminal_data, "entity_id", entity_id) ||
+		    !extractParameterData(terminal_data, "tap_iface", farm_terminal.tap_iface)) {
+			return false;
+		}
+		farm_terminal.entity_id = entity_id;
+		terminals.push_back(farm_terminal);
+	}
+
+	return true;
+}
+
+
 bool OpenSandModelConf::getLocalStorage(bool &enabled, std::string &output_folder) const
 {
 	if (infrastructure == nullptr) {
@@ -956,6 +1447,41 @@ bool OpenSandModelConf::getLocalStorage(bool &enabled, std::string &output_folde
 }
 
 
+bool OpenSandModelConf::getLocalStorageRotation(unsigned int &size_mb, unsigned int &period_s, bool &compress) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	int size = 0;
+	int period = 0;
+	compress = false;
+	auto storage = infrastructure->getRoot()->getComponent("storage");
+	extractParameterData(storage, "local_rotation_size", size);
+	extractParameterData(storage, "local_rotation_period", period);
+	extractParameterData(storage, "local_rotation_compress", compress);
+	if (size < 0 || period < 0) {
+		return false;
+	}
+	size_mb = size;
+	period_s = period;
+	return true;
+}
+
+
+bool OpenSandModelConf::getCarrierTimestamping(bool &enabled) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	enabled = false;
+	auto storage = infrastructure->getRoot()->getComponent("storage");
+	extractParameterData(storage, "carrier_timestamping", enabled);
+	return true;
+}
+
+
 bool OpenSandModelConf::getRemoteStorage(bool &enabled, std::string &address, unsigned short &stats_port, unsigned short &logs_port) const
 {
 	if (infrastructure == nullptr) {
@@ -977,11 +1503,312 @@ bool OpenSandModelConf::getRemoteStorage(bool &enabled, std::string &address, un
 	int stats = 5361;
 	extractParameterData(storage, "collector_probes", stats);
 
-	int logs = 5362;
-	extractParameterData(storage, "collector_logs", logs);
+	int logs = 5362;
+	extractParameterData(storage, "collector_logs", logs);
+
+	stats_port = stats;
+	logs_port = logs;
+	return true;
+}
+
+
+bool OpenSandModelConf::getRemoteStorageBinary(bool &binary) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	binary = false;
+	auto storage = infrastructure->getRoot()->getComponent("storage");
+	extractParameterData(storage, "collector_binary_probes", binary);
+	return true;
+}
+
+
+bool OpenSandModelConf::getProbesSharedMemory(std::string &name) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	name = "";
+	auto storage = infrastructure->getRoot()->getComponent("storage");
+	extractParameterData(storage, "probes_shared_memory", name);
+	return true;
+}
+
+
+bool OpenSandModelConf::getMetricsPort(int &port) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	port = 0;
+	auto storage = infrastructure->getRoot()->getComponent("storage");
+	extractParameterData(storage, "metrics_port", port);
+	return port >= 0 && port <= UINT16_MAX;
+}
+
+
+bool OpenSandModelConf::getEventsStatisticsPeriod(int &period_ms) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	period_ms = 0;
+	auto storage = infrastructure->getRoot()->getComponent("storage");
+	extractParameterData(storage, "events_statistics_period", period_ms);
+	return period_ms >= 0;
+}
+
+
+bool OpenSandModelConf::getHardwareCounters(bool &enabled) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	enabled = false;
+	auto storage = infrastructure->getRoot()->getComponent("storage");
+	extractParameterData(storage, "hardware_counters", enabled);
+	return true;
+}
+
+
+bool OpenSandModelConf::getLockProfiling(bool &enabled) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	enabled = false;
+	auto storage = infrastructure->getRoot()->getComponent("storage");
+	extractParameterData(storage, "lock_profiling", enabled);
+	return true;
+}
+
+
+bool OpenSandModelConf::getTraceFile(std::string &filename) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	filename = "";
+	auto storage = infrastructure->getRoot()->getComponent("storage");
+	extractParameterData(storage, "trace_file", filename);
+	return true;
+}
+
+
+bool OpenSandModelConf::getEncapWorkers(unsigned int &workers) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	int count = 0;
+	auto threads = infrastructure->getRoot()->getComponent("threads");
+	extractParameterData(threads, "encap_workers", count);
+	if (count < 0) {
+		return false;
+	}
+	workers = count;
+	return true;
+}
+
+
+bool OpenSandModelConf::getDamaWorkers(unsigned int &workers) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	int count = 0;
+	auto threads = infrastructure->getRoot()->getComponent("threads");
+	extractParameterData(threads, "dama_workers", count);
+	if (count < 0) {
+		return false;
+	}
+	workers = count;
+	return true;
+}
+
+
+bool OpenSandModelConf::getDamaLookAhead(unsigned int &superframes) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	int count = 0;
+	auto threads = infrastructure->getRoot()->getComponent("threads");
+	extractParameterData(threads, "dama_look_ahead", count);
+	if (count < 0) {
+		return false;
+	}
+	superframes = count;
+	return true;
+}
+
+
+bool OpenSandModelConf::getParallelVcm(bool &enabled) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	enabled = false;
+	auto threads = infrastructure->getRoot()->getComponent("threads");
+	extractParameterData(threads, "parallel_vcm", enabled);
+	return true;
+}
+
+
+bool OpenSandModelConf::getCarrierReceivers(unsigned int &workers) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	int count = 0;
+	auto threads = infrastructure->getRoot()->getComponent("threads");
+	extractParameterData(threads, "carrier_receivers", count);
+	if (count < 0) {
+		return false;
+	}
+	workers = count;
+	return true;
+}
+
+
+bool OpenSandModelConf::getFlowControl(bool &enabled) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	enabled = false;
+	auto threads = infrastructure->getRoot()->getComponent("threads");
+	extractParameterData(threads, "flow_control", enabled);
+	return true;
+}
+
+
+bool OpenSandModelConf::getMessageBatch(unsigned int &batch_size) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	int size = 0;
+	auto threads = infrastructure->getRoot()->getComponent("threads");
+	extractParameterData(threads, "message_batch", size);
+	if (size < 0) {
+		return false;
+	}
+	batch_size = size == 0 ? default_message_batch : size;
+	return true;
+}
+
+
+bool OpenSandModelConf::getVirtualTime(bool &enabled) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	enabled = false;
+	auto threads = infrastructure->getRoot()->getComponent("threads");
+	extractParameterData(threads, "virtual_time", enabled);
+	return true;
+}
+
+
+bool OpenSandModelConf::getCaptures(std::vector<OpenSandModelConf::capture> &captures) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	auto storage = infrastructure->getRoot()->getComponent("storage");
+	for (auto& capture_item : storage->getList("captures")->getItems()) {
+		auto capture_data = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(capture_item);
+		OpenSandModelConf::capture capture{"", true, true, ""};
+		if (!extractParameterData(capture_data, "block", capture.block) ||
+		    !extractParameterData(capture_data, "file", capture.file)) {
+			return false;
+		}
+
+		std::string direction = "Both";
+		extractParameterData(capture_data, "direction", direction);
+		capture.upward = direction != "Downward";
+		capture.downward = direction != "Upward";
+		captures.push_back(capture);
+	}
+
+	return true;
+}
+
+
+bool OpenSandModelConf::getMirrors(std::string &file, std::vector<std::string> &names) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	file = "";
+	auto storage = infrastructure->getRoot()->getComponent("storage");
+	extractParameterData(storage, "mirror_file", file);
+	for (auto& mirror_item : storage->getList("mirrors")->getItems()) {
+		auto mirror = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(mirror_item);
+		std::string name;
+		if (!extractParameterData(mirror, "name", name)) {
+			return false;
+		}
+		names.push_back(name);
+	}
+
+	return true;
+}
+
+
+bool OpenSandModelConf::getProbesSampling(std::vector<OpenSandModelConf::probe_sampling> &samplings) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	auto storage = infrastructure->getRoot()->getComponent("storage");
+	for (auto& sampling_item : storage->getList("probes_sampling")->getItems()) {
+		auto sampling = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(sampling_item);
+		OpenSandModelConf::probe_sampling probes{"", SAMPLING_ALL, 1, 0};
+		if (!extractParameterData(sampling, "name", probes.path)) {
+			return false;
+		}
+
+		std::string policy = "All";
+		extractParameterData(sampling, "policy", policy);
+		if (policy == "Window") {
+			probes.policy = SAMPLING_WINDOW;
+			int period = 1;
+			if (!extractParameterData(sampling, "period", period) || period < 1) {
+				DFLTLOG(LEVEL_ERROR,
+				        "Conf: invalid sampling window for probes %s",
+				        probes.path.c_str());
+				return false;
+			}
+			probes.period = period;
+		} else if (policy == "On Change") {
+			probes.policy = SAMPLING_ON_CHANGE;
+			extractParameterData(sampling, "threshold", probes.threshold);
+		}
+
+		samplings.push_back(probes);
+	}
 
-	stats_port = stats;
-	logs_port = logs;
 	return true;
 }
 
@@ -1034,6 +1861,158 @@ bool OpenSandModelConf::logLevels(std::map<std::string, log_level_t> &levels) co
 }
 
 
+/**
+ * @brief Parse a list of CPUs or NUMA nodes such as "0-3,8"
+ *
+ * @param list    The list to parse
+ * @param values  OUT: the parsed values
+ * @return true on success, false otherwise
+ */
+static bool parseIndexList(const std::string &list, std::vector<int> &values)
+{
+	std::istringstream stream{list};
+	std::string range;
+	while (std::getline(stream, range, ',')) {
+		if (range.empty()) {
+			continue;
+		}
+		int first;
+		int last;
+		char separator;
+		std::istringstream range_stream{range};
+		if (!(range_stream >> first)) {
+			return false;
+		}
+		last = first;
+		if (range_stream >> separator) {
+			if (separator != '-' || !(range_stream >> last)) {
+				return false;
+			}
+		}
+		if (first < 0 || last < first) {
+			return false;
+		}
+		for (int value = first; value <= last; ++value) {
+			values.push_back(value);
+		}
+	}
+	return true;
+}
+
+
+bool OpenSandModelConf::getThreadPlacements(std::vector<OpenSandModelConf::thread_placement> &placements) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	auto threads = infrastructure->getRoot()->getComponent("threads");
+	for (auto& placement_item : threads->getList("placements")->getItems()) {
+		auto placement = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(placement_item);
+		OpenSandModelConf::thread_placement thread{"", true, true, {{}, SCHED_OTHER, 0, {}, 0, false}};
+		if (!extractParameterData(placement, "block", thread.block)) {
+			return false;
+		}
+
+		std::string direction = "Both";
+		extractParameterData(placement, "direction", direction);
+		thread.upward = direction != "Downward";
+		thread.downward = direction != "Upward";
+
+		std::string cpus;
+		extractParameterData(placement, "cpus", cpus);
+		if (!parseIndexList(cpus, thread.placement.cpus)) {
+			DFLTLOG(LEVEL_ERROR,
+			        "Conf: invalid CPU set '%s' for block %s",
+			        cpus.c_str(), thread.block.c_str());
+			return false;
+		}
+
+		std::string policy = "Default";
+		extractParameterData(placement, "policy", policy);
+		if (policy == "FIFO") {
+			thread.placement.policy = SCHED_FIFO;
+		} else if (policy == "RR") {
+			thread.placement.policy = SCHED_RR;
+		}
+		if (thread.placement.policy != SCHED_OTHER &&
+		    !extractParameterData(placement, "priority", thread.placement.priority)) {
+			return false;
+		}
+
+		std::string numa_nodes;
+		extractParameterData(placement, "numa_nodes", numa_nodes);
+		if (!parseIndexList(numa_nodes, thread.placement.numa_nodes)) {
+			DFLTLOG(LEVEL_ERROR,
+			        "Conf: invalid NUMA nodes '%s' for block %s",
+			        numa_nodes.c_str(), thread.block.c_str());
+			return false;
+		}
+
+		int busy_poll_us = 0;
+		extractParameterData(placement, "busy_poll", busy_poll_us);
+		thread.placement.busy_poll_us = busy_poll_us;
+		extractParameterData(placement, "huge_pages", thread.placement.huge_pages);
+
+		placements.push_back(thread);
+	}
+
+	return true;
+}
+
+
+bool OpenSandModelConf::getFusedLinks(std::vector<OpenSandModelConf::fused_link> &links) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	auto threads = infrastructure->getRoot()->getComponent("threads");
+	for (auto& link_item : threads->getList("fused_links")->getItems()) {
+		auto link_data = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(link_item);
+		OpenSandModelConf::fused_link link{"", true, true};
+		if (!extractParameterData(link_data, "block", link.block)) {
+			return false;
+		}
+
+		std::string direction = "Both";
+		extractParameterData(link_data, "direction", direction);
+		link.upward = direction != "Downward";
+		link.downward = direction != "Upward";
+		links.push_back(link);
+	}
+
+	return true;
+}
+
+
+bool OpenSandModelConf::getTaskWorkers(unsigned int &workers, rt_thread_placement_t &placement) const
+{
+	if (infrastructure == nullptr) {
+		return false;
+	}
+
+	int count = 0;
+	auto threads = infrastructure->getRoot()->getComponent("threads");
+	extractParameterData(threads, "task_workers", count);
+	if (count < 0) {
+		return false;
+	}
+	workers = count;
+
+	placement = {{}, SCHED_OTHER, 0, {}, 0, false};
+	std::string cpus;
+	extractParameterData(threads, "task_cpus", cpus);
+	if (!parseIndexList(cpus, placement.cpus)) {
+		DFLTLOG(LEVEL_ERROR,
+		        "Conf: invalid CPU set '%s' for the task workers",
+		        cpus.c_str());
+		return false;
+	}
+	return true;
+}
+
+
 inline std::unique_ptr<MacAddress> make_unique_mac(std::string address)
 {
 	return std::unique_ptr<MacAddress>{new MacAddress{address}};
@@ -1457,32 +2436,44 @@ bool OpenSandModelConf::getControlPlaneDisabled(bool &disabled) const
 }
 
 
+bool OpenSandModelConf::getTapMtu(std::size_t &mtu) const
+{
+	// standard Ethernet frames unless jumbo frames are configured
+	mtu = ETH_DATA_LEN;
+	if (profile == nullptr)
+		return true;
+
+	int value;
+	auto elem = profile->getItemByPath("network/tap/mtu");
+	if (!extractParameterData(std::dynamic_pointer_cast<OpenSANDConf::DataParameter>(elem), value))
+		return true;
+
+	if (value < ETH_MIN_MTU || value > ETHERNET_JUMBO_MTU) {
+		return false;
+	}
+	mtu = value;
+	return true;
+}
+
+
 bool OpenSandModelConf::getGwWithTalId(uint16_t tal_id, uint16_t &gw_id) const
 {
 	if (topology == nullptr) {
 		return false;
 	}
 
-	auto st_assignments = topology->getRoot()->getComponent("st_assignment");
-	auto assigned_spot = st_assignments->getComponent("defaults")->getParameter("default_gateway");
-
-	for (auto& assignment : st_assignments->getList("assignments")->getItems()) {
-		auto st_assignment = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(assignment);
-		int st_id;
-		if (!extractParameterData(st_assignment, "terminal_id", st_id)) {
-			return false;
-		}
-		if (tal_id == st_id) {
-			assigned_spot = st_assignment->getParameter("gateway_id");
-		}
+	// the assignments are indexed when the topology is read
+	auto assignment = terminals_gateway.find(tal_id);
+	if (assignment != terminals_gateway.end()) {
+		gw_id = assignment->second;
+		return true;
 	}
 
-	int assigned_spot_id;
-	if (!extractParameterData(assigned_spot, assigned_spot_id)) {
+	if (default_gateway_id < 0) {
 		return false;
 	}
 
-	gw_id = assigned_spot_id;
+	gw_id = default_gateway_id;
 	return true;
 }
 
@@ -1496,19 +2487,8 @@ bool OpenSandModelConf::getGwWithCarrierId(unsigned int car_id, uint16_t &gw) co
 	gw = car_id / 10;
 
 	// Check the spot exists, fail in case of multiple spots configured for a gateway
-	unsigned int amount_found = 0;
-	for (auto& spot : topology->getRoot()->getComponent("frequency_plan")->getList("spots")->getItems()) {
-		auto gw_assignment = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(spot)->getComponent("assignments");
-		int gw_id;
-		if (!extractParameterData(gw_assignment, "gateway_id", gw_id)) {
-			return false;
-		}
-		if (gw == gw_id) {
-			++amount_found;
-		}
-	}
-
-	return amount_found == 1;
+	auto spots_count = spots_per_gateway.find(gw);
+	return spots_count != spots_per_gateway.end() && spots_count->second == 1;
 }
 
 
@@ -1610,7 +2590,11 @@ bool OpenSandModelConf::getSpotInfrastructure(uint16_t gw_id, spot_infrastructur
 
 	auto infra = infrastructure->getRoot()->getComponent("infrastructure");
 
-	std::shared_ptr<OpenSANDConf::DataComponent> gateway = getEntityById(infra->getList("gateways"), gw_id);
+	auto gateway_it = gateways_by_id.find(gw_id);
+	std::shared_ptr<OpenSANDConf::DataComponent> gateway = nullptr;
+	if (gateway_it != gateways_by_id.end()) {
+		gateway = gateway_it->second;
+	}
 	if (gateway == nullptr) {
 		LOG(this->log, LEVEL_ERROR,
 		    "The gateway %d was not found in the infrastructure configuration", gw_id);
@@ -1704,6 +2688,30 @@ bool OpenSandModelConf::getSpotInfrastructure(uint16_t gw_id, spot_infrastructur
 	extractParameterData(gateway, "udp_rmem", udp_rmem);
 	int udp_wmem = 1048580;
 	extractParameterData(gateway, "udp_wmem", udp_wmem);
+	std::string data_carrier_backend = "UDP";
+	extractParameterData(gateway, "data_carrier_backend", data_carrier_backend);
+	bool data_io_uring = data_carrier_backend == "io_uring";
+
+	// the data carriers are paced at the highest rate their bands may
+	// reach, so the pacing spreads the frames without delaying them
+	bool data_pacing = false;
+	extractParameterData(gateway, "data_carrier_pacing", data_pacing);
+	double forward_pacing_rate = 0;
+	double return_pacing_rate = 0;
+	if (data_pacing) {
+		OpenSandModelConf::spot forward_band;
+		OpenSandModelConf::spot return_band;
+		if (!getSpotForwardCarriers(gw_id, forward_band) ||
+		    !getSpotReturnCarriers(gw_id, return_band)) {
+			return false;
+		}
+		for (auto &&carrier: forward_band.carriers) {
+			forward_pacing_rate += carrier.symbol_rate * max_bits_per_symbol;
+		}
+		for (auto &&carrier: return_band.carriers) {
+			return_pacing_rate += carrier.symbol_rate * max_bits_per_symbol;
+		}
+	}
 
 	int fifo_sizes = default_fifos_size;
 	extractParameterData(gateway, "fifos_size", fifo_sizes);  // TODO: add this to conf file?
@@ -1746,7 +2754,9 @@ bool OpenSandModelConf::getSpotInfrastructure(uint16_t gw_id, spot_infrastructur
 	    static_cast<std::size_t>(logon_in_fifo_size),
 	    static_cast<unsigned>(udp_stack),
 	    static_cast<unsigned>(udp_rmem),
-	    static_cast<unsigned>(udp_wmem)
+	    static_cast<unsigned>(udp_wmem),
+	    false,
+	    0
 	};
 	carriers.logon_out = carrier_socket{
 	    carrier_id + CarrierType::LOGON_OUT,
@@ -1756,7 +2766,9 @@ bool OpenSandModelConf::getSpotInfrastructure(uint16_t gw_id, spot_infrastructur
 	    static_cast<std::size_t>(logon_out_fifo_size),
 	    static_cast<unsigned>(udp_stack),
 	    static_cast<unsigned>(udp_rmem),
-	    static_cast<unsigned>(udp_wmem)
+	    static_cast<unsigned>(udp_wmem),
+	    false,
+	    0
 	};
 	carriers.ctrl_in_st = carrier_socket{
 	    carrier_id + CarrierType::CTRL_IN_ST,
@@ -1766,7 +2778,9 @@ bool OpenSandModelConf::getSpotInfrastructure(uint16_t gw_id, spot_infrastructur
 	    static_cast<std::size_t>(ctrl_in_st_fifo_size),
 	    static_cast<unsigned>(udp_stack),
 	    static_cast<unsigned>(udp_rmem),
-	    static_cast<unsigned>(udp_wmem)
+	    static_cast<unsigned>(udp_wmem),
+	    false,
+	    0
 	};
 	carriers.ctrl_out_gw = carrier_socket{
 	    carrier_id + CarrierType::CTRL_OUT_GW,
@@ -1776,7 +2790,9 @@ bool OpenSandModelConf::getSpotInfrastructure(uint16_t gw_id, spot_infrastructur
 	    static_cast<std::size_t>(ctrl_out_gw_fifo_size),
 	    static_cast<unsigned>(udp_stack),
 	    static_cast<unsigned>(udp_rmem),
-	    static_cast<unsigned>(udp_wmem)
+	    static_cast<unsigned>(udp_wmem),
+	    false,
+	    0
 	};
 	carriers.ctrl_in_gw = carrier_socket{
 	    carrier_id + CarrierType::CTRL_IN_GW,
@@ -1786,7 +2802,9 @@ bool OpenSandModelConf::getSpotInfrastructure(uint16_t gw_id, spot_infrastructur
 	    static_cast<std::size_t>(ctrl_in_gw_fifo_size),
 	    static_cast<unsigned>(udp_stack),
 	    static_cast<unsigned>(udp_rmem),
-	    static_cast<unsigned>(udp_wmem)
+	    static_cast<unsigned>(udp_wmem),
+	    false,
+	    0
 	};
 	carriers.ctrl_out_st = carrier_socket{
 	    carrier_id + CarrierType::CTRL_OUT_ST,
@@ -1796,7 +2814,9 @@ bool OpenSandModelConf::getSpotInfrastructure(uint16_t gw_id, spot_infrastructur
 	    static_cast<std::size_t>(ctrl_out_st_fifo_size),
 	    static_cast<unsigned>(udp_stack),
 	    static_cast<unsigned>(udp_rmem),
-	    static_cast<unsigned>(udp_wmem)
+	    static_cast<unsigned>(udp_wmem),
+	    false,
+	    0
 	};
 	carriers.data_in_st = carrier_socket{
 	    carrier_id + CarrierType::DATA_IN_ST,
@@ -1806,7 +2826,9 @@ bool OpenSandModelConf::getSpotInfrastructure(uint16_t gw_id, spot_infrastructur
 	    static_cast<std::size_t>(data_in_st_fifo_size),
 	    static_cast<unsigned>(udp_stack),
 	    static_cast<unsigned>(udp_rmem),
-	    static_cast<unsigned>(udp_wmem)
+	    static_cast<unsigned>(udp_wmem),
+	    data_io_uring,
+	    return_pacing_rate
 	};
 	carriers.data_out_gw = carrier_socket{
 	    carrier_id + CarrierType::DATA_OUT_GW,
@@ -1816,7 +2838,9 @@ bool OpenSandModelConf::getSpotInfrastructure(uint16_t gw_id, spot_infrastructur
 	    static_cast<std::size_t>(data_out_gw_fifo_size),
 	    static_cast<unsigned>(udp_stack),
 	    static_cast<unsigned>(udp_rmem),
-	    static_cast<unsigned>(udp_wmem)
+	    static_cast<unsigned>(udp_wmem),
+	    data_io_uring,
+	    return_pacing_rate
 	};
 	carriers.data_in_gw = carrier_socket{
 	    carrier_id + CarrierType::DATA_IN_GW,
@@ -1826,7 +2850,9 @@ bool OpenSandModelConf::getSpotInfrastructure(uint16_t gw_id, spot_infrastructur
 	    static_cast<std::size_t>(data_in_gw_fifo_size),
 	    static_cast<unsigned>(udp_stack),
 	    static_cast<unsigned>(udp_rmem),
-	    static_cast<unsigned>(udp_wmem)
+	    static_cast<unsigned>(udp_wmem),
+	    data_io_uring,
+	    forward_pacing_rate
 	};
 	carriers.data_out_st = carrier_socket{
 	    carrier_id + CarrierType::DATA_OUT_ST,
@@ -1836,7 +2862,9 @@ bool OpenSandModelConf::getSpotInfrastructure(uint16_t gw_id, spot_infrastructur
 	    static_cast<std::size_t>(data_out_st_fifo_size),
 	    static_cast<unsigned>(udp_stack),
 	    static_cast<unsigned>(udp_rmem),
-	    static_cast<unsigned>(udp_wmem)
+	    static_cast<unsigned>(udp_wmem),
+	    data_io_uring,
+	    forward_pacing_rate
 	};
 
 	return true;
@@ -1857,30 +2885,59 @@ bool OpenSandModelConf::getSpotReturnCarriers(uint16_t gw_id, OpenSandModelConf:
 
 bool OpenSandModelConf::getSpotCarriers(uint16_t gw_id, OpenSandModelConf::spot &spot, bool forward) const
 {
-	const std::string roll_off_parameter = forward ? "forward" : "return";
-	const std::string band_parameter = roll_off_parameter + "_band";
+	if (topology == nullptr) {
+		return false;
+	}
+
+	// the carriers of a spot are read by every block of its entities
+	std::lock_guard<std::mutex> lock(spots_carriers_lock);
+	auto key = std::make_pair(gw_id, forward);
+	auto cached = spots_carriers.find(key);
+	if (cached != spots_carriers.end()) {
+		spot = cached->second;
+		return true;
+	}
+
+	auto spot_it = spots_by_gateway.find(gw_id);
+	if (spot_it == spots_by_gateway.end()) {
+		return false;
+	}
+	if (!readSpotCarriers(spot_it->second, spot, forward)) {
+		return false;
+	}
+	spots_carriers.emplace(key, spot);
+	return true;
+}
 
+
+bool OpenSandModelConf::getSpotReturnCarriers(tal_id_t gw_id, OpenSandModelConf::spot &spot,
+                                              std::shared_ptr<const OpenSANDConf::DataModel> topology) const
+{
 	if (topology == nullptr) {
 		return false;
 	}
 
-	std::shared_ptr<OpenSANDConf::DataComponent> selected_spot = nullptr;
-	for (auto& spot_topology_item : topology->getRoot()->getComponent("frequency_plan")->getList("spots")->getItems()) {
-		auto spot_topology = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(spot_topology_item);
-		auto spot_assignment = spot_topology->getComponent("assignments");
-		int gateway_id;
-		if (!extractParameterData(spot_assignment, "gateway_id", gateway_id)) {
+	// the first spot of the gateway, as in readTopology
+	auto spot_list = topology->getRoot()->getComponent("frequency_plan")->getList("spots");
+	for (auto &&spot_item: spot_list->getItems()) {
+		auto spot_component = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(spot_item);
+		int spot_gw_id;
+		if (!extractParameterData(spot_component->getComponent("assignments"), "gateway_id", spot_gw_id)) {
 			return false;
 		}
-		if (gateway_id == gw_id) {
-			selected_spot = spot_topology;
-			break;
+		if (spot_gw_id == gw_id) {
+			return readSpotCarriers(spot_component, spot, false);
 		}
 	}
+	return false;
+}
 
-	if (selected_spot == nullptr) {
-		return false;
-	}
+
+bool OpenSandModelConf::readSpotCarriers(std::shared_ptr<const OpenSANDConf::DataComponent> selected_spot,
+                                         OpenSandModelConf::spot &spot, bool forward) const
+{
+	const std::string roll_off_parameter = forward ? "forward" : "return";
+	const std::string band_parameter = roll_off_parameter + "_band";
 
 	if (!extractParameterData(selected_spot->getComponent("roll_off"), roll_off_parameter, spot.roll_off)) {
 		return false;
@@ -1965,47 +3022,14 @@ bool OpenSandModelConf::getInterconnectCarrier(bool upward,
                                                unsigned int &udp_wmem,
 											   std::size_t isl_index) const
 {
-	if (infrastructure == nullptr) {
-		return false;
-	}
-
-	std::string type;
-	tal_id_t id;
-	if (!this->getComponentType(type, id)) {
-		return false;
-	}
-
-	if (type != "gw_net_acc" && type != "gw_phy" && type != "sat")
+	auto interco_params = this->getInterconnectParams(isl_index);
+	if (interco_params == nullptr)
 	{
 		return false;
 	}
 
 	std::string direction = upward ? "upward_" : "downward_";
 
-	std::shared_ptr<OpenSANDConf::DataComponent> interco_params;
-	if (type == "sat")
-	{
-		auto isl_settings = infrastructure->getRoot()
-		                        ->getComponent("entity")
-		                        ->getComponent("entity_" + type)
-		                        ->getList("isl_settings")
-		                        ->getItems();
-		if (isl_settings.size() <= isl_index)
-		{
-			LOG(log, LEVEL_ERROR, "ISL configuration #%d requested but this satellite only have %d.",
-			    isl_index, isl_settings.size());
-			return false;
-		}
-		interco_params = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(isl_settings[isl_index])
-		                     ->getComponent("interconnect_params");
-	}
-	else
-	{
-		interco_params = infrastructure->getRoot()
-		                     ->getComponent("entity")
-		                     ->getComponent("entity_" + type)
-		                     ->getComponent("interconnect_params");
-	}
 	if (!extractParameterData(interco_params, "interconnect_remote", remote))
 	{
 		return false;
@@ -2032,10 +3056,118 @@ bool OpenSandModelConf::getInterconnectCarrier(bool upward,
 }
 
 
+bool OpenSandModelConf::getInterconnectTransport(bool &stream, std::size_t isl_index) const
+{
+	auto interco_params = this->getInterconnectParams(isl_index);
+	if (interco_params == nullptr)
+	{
+		return false;
+	}
+
+	std::string transport = "UDP";
+	extractParameterData(interco_params, "interco_transport", transport);
+	stream = transport == "TCP";
+	return true;
+}
+
+
+bool OpenSandModelConf::getInterconnectFlushDeadline(double &flush_deadline, std::size_t isl_index) const
+{
+	auto interco_params = this->getInterconnectParams(isl_index);
+	if (interco_params == nullptr)
+	{
+		return false;
+	}
+
+	flush_deadline = 0;
+	extractParameterData(interco_params, "interco_flush_deadline", flush_deadline);
+	return true;
+}
+
+
+bool OpenSandModelConf::getInterconnectCompression(bool &lz4, std::size_t isl_index) const
+{
+	auto interco_params = this->getInterconnectParams(isl_index);
+	if (interco_params == nullptr)
+	{
+		return false;
+	}
+
+	std::string compression = "None";
+	extractParameterData(interco_params, "interco_compression", compression);
+	lz4 = compression == "LZ4";
+	return true;
+}
+
+
+bool OpenSandModelConf::getInterconnectDataStreams(unsigned int &streams, std::size_t isl_index) const
+{
+	auto interco_params = this->getInterconnectParams(isl_index);
+	if (interco_params == nullptr)
+	{
+		return false;
+	}
+
+	int streams_value = 1;
+	extractParameterData(interco_params, "interco_data_streams", streams_value);
+	if (streams_value < 1)
+	{
+		return false;
+	}
+	streams = streams_value;
+	return true;
+}
+
+
+std::shared_ptr<OpenSANDConf::DataComponent> OpenSandModelConf::getInterconnectParams(std::size_t isl_index) const
+{
+	if (infrastructure == nullptr) {
+		return nullptr;
+	}
+
+	std::string type;
+	tal_id_t id;
+	if (!this->getComponentType(type, id)) {
+		return nullptr;
+	}
+
+	if (type != "gw_net_acc" && type != "gw_phy" && type != "sat")
+	{
+		return nullptr;
+	}
+
+	if (type == "sat")
+	{
+		auto isl_settings = infrastructure->getRoot()
+		                        ->getComponent("entity")
+		                        ->getComponent("entity_" + type)
+		                        ->getList("isl_settings")
+		                        ->getItems();
+		if (isl_settings.size() <= isl_index)
+		{
+			LOG(log, LEVEL_ERROR, "ISL configuration #%d requested but this satellite only have %d.",
+			    isl_index, isl_settings.size());
+			return nullptr;
+		}
+		return std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(isl_settings[isl_index])
+		           ->getComponent("interconnect_params");
+	}
+
+	return infrastructure->getRoot()
+	           ->getComponent("entity")
+	           ->getComponent("entity_" + type)
+	           ->getComponent("interconnect_params");
+}
+
+
 bool OpenSandModelConf::getTerminalAffectation(spot_id_t &default_spot_id,
                                                std::string &default_category_name,
-                                               std::map<tal_id_t, std::pair<spot_id_t, std::string>> &terminal_categories) const
+                                               std::map<tal_id_t, std::pair<spot_id_t, std::string>> &terminal_categories,
+                                               std::shared_ptr<const OpenSANDConf::DataModel> topology) const
 {
+	if (topology == nullptr) {
+		topology = this->topology;
+	}
 	if (topology == nullptr) {
 		return false;
 	}
@@ -2081,18 +3213,11 @@ bool OpenSandModelConf::getTerminalAffectation(spot_id_t &default_spot_id,
 
 bool OpenSandModelConf::getDefaultSpotId(spot_id_t &default_spot_id) const
 {
-	if (topology == nullptr) {
+	if (topology == nullptr || default_gateway_id < 0) {
 		return false;
 	}
 
-	auto assignments = topology->getRoot()->getComponent("st_assignment");
-	auto defaults = assignments->getComponent("defaults");
-
-	int spot_id;
-	if (!extractParameterData(defaults, "default_gateway", spot_id)) {
-		return false;
-	}
-	default_spot_id = spot_id;
+	default_spot_id = default_gateway_id;
 
 	return true;
 }
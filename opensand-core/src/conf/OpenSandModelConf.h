@@ -38,7 +38,9 @@
 #define OPENSAND_MODEL_CONF_H
 
 
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -49,6 +51,7 @@
 #include <opensand_conf/DataParameter.h>
 #include <opensand_conf/DataValue.h>
 #include <opensand_output/Output.h>
+#include <opensand_rt/Types.h>
 
 #include "OpenSandCore.h"
 #include "SpotComponentPair.h"
@@ -87,6 +90,9 @@ public:
 		unsigned int udp_stack;
 		unsigned int udp_rmem;
 		unsigned int udp_wmem;
+		bool io_uring;
+		/// The rate the datagrams are paced at (bits/s), 0 if not paced
+		double pacing_rate_bps;
 	};
 
 	struct spot_infrastructure {
@@ -116,11 +122,62 @@ public:
 		std::vector<OpenSandModelConf::carrier> carriers;
 	};
 
+	struct thread_placement {
+		std::string block;
+		bool upward;
+		bool downward;
+		rt_thread_placement_t placement;
+	};
+
+	struct farm_terminal {
+		tal_id_t entity_id;
+		std::string tap_iface;
+	};
+
+	struct fused_link {
+		std::string block;
+		bool upward;
+		bool downward;
+	};
+
+	struct capture {
+		std::string block;
+		bool upward;
+		bool downward;
+		std::string file;
+	};
+
+	struct probe_sampling {
+		std::string path;
+		sampling_policy_t policy;
+		unsigned int period;
+		double threshold;
+	};
+
 	static std::shared_ptr<OpenSandModelConf> Get();
 	~OpenSandModelConf();
 
 	void createModels();
 	std::shared_ptr<OpenSANDConf::DataComponent> getProfileData(const std::string &path="") const;
+
+	/**
+	 * @brief Get a parameter of the profile from its path, the
+	 *        profile elements are indexed by path when it is read
+	 *
+	 * @param path  The parameter path, e.g. "network/simulation"
+	 * @return the parameter, nullptr if it does not exist
+	 */
+	std::shared_ptr<OpenSANDConf::DataParameter> getProfileParameter(const std::string &path) const;
+
+	/**
+	 * @brief Get the value of a parameter of the profile from its path
+	 *
+	 * @param path    The parameter path
+	 * @param result  OUT: the parameter value
+	 * @return true if the parameter is set, false otherwise
+	 */
+	template<typename T>
+	bool getProfileValue(const std::string &path, T &result) const;
 	std::shared_ptr<OpenSANDConf::MetaTypesList> getModelTypesDefinition() const;
 	MetaComponentPtr getOrCreateComponent(const std::string &id,
 	                                      const std::string &name,
@@ -145,10 +202,70 @@ public:
 	bool writeInfrastructureModel(const std::string& filename) const;
 	bool writeProfileModel(const std::string& filename) const;
 
+	/**
+	 * @brief Set the folder of the compiled configuration cache, the
+	 *        configuration files are then read from it when they did
+	 *        not change since a previous run
+	 *
+	 * @param folder  The cache folder, empty to disable the cache
+	 */
+	void setConfigurationCache(const std::string &folder);
+
+	/**
+	 * @brief Use the profile model stored in the configuration cache
+	 *        instead of generating it again
+	 *
+	 * @param key  The identity of the generator of the model: the
+	 *             entity, the program and the loaded plugins
+	 * @return true if the profile model was read from the cache,
+	 *         false if it must be generated
+	 */
+	bool loadProfileModel(const std::string &key);
+
+	/**
+	 * @brief Store the generated profile model in the configuration cache
+	 *
+	 * @param key  The identity of the generator of the model
+	 * @return true on success or without cache, false otherwise
+	 */
+	bool storeProfileModel(const std::string &key) const;
+
+	/**
+	 * @brief Set the seed of the random generators of the entity,
+	 *        so that a run can be reproduced
+	 *
+	 * @param seed  The seed
+	 */
+	void setRandomSeed(unsigned int seed);
+
+	/**
+	 * @brief Get the seed of the random generators of the entity
+	 *
+	 * @param seed  The seed, if it was set
+	 * @return true if a seed was set, false if the generators
+	 *         must be seeded from the clock
+	 */
+	bool getRandomSeed(unsigned int &seed) const;
+
 	bool readTopology(const std::string& filename);
 	bool readInfrastructure(const std::string& filename);
 	bool readProfile(const std::string& filename);
 
+	/**
+	 * @brief Read again the topology file the running topology was read
+	 *        from, without changing the running configuration
+	 *
+	 * @return the topology read, nullptr on error
+	 */
+	std::shared_ptr<OpenSANDConf::DataModel> readTopologyUpdate() const;
+
+	/**
+	 * @brief Get the path of the topology file
+	 *
+	 * @return the path given to readTopology
+	 */
+	const std::string &getTopologyPath() const;
+
 	template<typename T>
 	static bool extractParameterData(std::shared_ptr<const OpenSANDConf::DataParameter> parameter, T &result);
 
@@ -169,12 +286,41 @@ public:
 	 *                       network (except for Gateway Phy: interconnection network IP).
 	 */
 	bool getGroundInfrastructure(std::string &ip_address, std::string &tap_iface) const;
+	/**
+	 * @brief: get the additional terminals emulated by a terminal process
+	 *
+	 * @param: terminals     The ID and tap interface of each terminal
+	 */
+	bool getTerminalFarm(std::vector<OpenSandModelConf::farm_terminal> &terminals) const;
 	bool getLocalStorage(bool &enabled, std::string &output_folder) const;
+	bool getLocalStorageRotation(unsigned int &size_mb, unsigned int &period_s, bool &compress) const;
+	bool getCarrierTimestamping(bool &enabled) const;
 	bool getRemoteStorage(bool &enabled,
 	                      std::string &address,
 	                      unsigned short &stats_port,
 	                      unsigned short &logs_port) const;
+	bool getRemoteStorageBinary(bool &binary) const;
+	bool getProbesSharedMemory(std::string &name) const;
+	bool getMetricsPort(int &port) const;
+	bool getEventsStatisticsPeriod(int &period_ms) const;
+	bool getHardwareCounters(bool &enabled) const;
+	bool getLockProfiling(bool &enabled) const;
+	bool getTraceFile(std::string &filename) const;
+	bool getProbesSampling(std::vector<OpenSandModelConf::probe_sampling> &samplings) const;
+	bool getCaptures(std::vector<OpenSandModelConf::capture> &captures) const;
+	bool getMirrors(std::string &file, std::vector<std::string> &names) const;
 	bool logLevels(std::map<std::string, log_level_t> &levels) const;
+	bool getThreadPlacements(std::vector<OpenSandModelConf::thread_placement> &placements) const;
+	bool getFusedLinks(std::vector<OpenSandModelConf::fused_link> &links) const;
+	bool getTaskWorkers(unsigned int &workers, rt_thread_placement_t &placement) const;
+	bool getEncapWorkers(unsigned int &workers) const;
+	bool getDamaWorkers(unsigned int &workers) const;
+	bool getDamaLookAhead(unsigned int &superframes) const;
+	bool getParallelVcm(bool &enabled) const;
+	bool getCarrierReceivers(unsigned int &workers) const;
+	bool getFlowControl(bool &enabled) const;
+	bool getMessageBatch(unsigned int &batch_size) const;
+	bool getVirtualTime(bool &enabled) const;
 	bool getSarp(SarpTable &sarp_table) const;
 	bool getNccPorts(int &pep_tcp_port, int &svno_tcp_port) const;
 	bool getQosServerHost(std::string &qos_server_host_agent, int &qos_server_host_port) const;
@@ -195,6 +341,7 @@ public:
 	bool getDelayBufferSize(std::size_t &size) const;
 	bool getDelayTimer(time_ms_t &period) const;
 	bool getControlPlaneDisabled(bool &disabled) const;
+	bool getTapMtu(std::size_t &mtu) const;
 	bool getGwWithTalId(tal_id_t terminal_id, tal_id_t &gw_id) const;
 	bool getGwWithCarrierId(unsigned int carrier_id, tal_id_t &gw) const;
 	bool isGw(tal_id_t gw_id) const;
@@ -204,6 +351,17 @@ public:
 	bool getScpcEncapStack(std::vector<std::string> &encap_stack) const;
 	bool getSpotInfrastructure(tal_id_t gw_id, OpenSandModelConf::spot_infrastructure &carriers) const;
 	bool getSpotReturnCarriers(tal_id_t gw_id, OpenSandModelConf::spot &spot) const;
+	/**
+	 * @brief Get the return carriers of a spot in a topology read
+	 *        with readTopologyUpdate
+	 *
+	 * @param gw_id     The gateway of the spot
+	 * @param spot      OUT: the carriers of the spot
+	 * @param topology  The topology
+	 * @return true on success, false otherwise
+	 */
+	bool getSpotReturnCarriers(tal_id_t gw_id, OpenSandModelConf::spot &spot,
+	                           std::shared_ptr<const OpenSANDConf::DataModel> topology) const;
 	bool getSpotForwardCarriers(tal_id_t gw_id, OpenSandModelConf::spot &spot) const;
 	bool getInterconnectCarrier(bool upward_connection,
 	                            std::string &remote_address,
@@ -213,9 +371,24 @@ public:
 	                            unsigned int &udp_rmem,
 	                            unsigned int &udp_wmem,
 								std::size_t isl_index = 0) const;
+	bool getInterconnectTransport(bool &stream, std::size_t isl_index = 0) const;
+	bool getInterconnectFlushDeadline(double &flush_deadline, std::size_t isl_index = 0) const;
+	bool getInterconnectCompression(bool &lz4, std::size_t isl_index = 0) const;
+	bool getInterconnectDataStreams(unsigned int &streams, std::size_t isl_index = 0) const;
+	/**
+	 * @brief Get the categories the terminals are affected to
+	 *
+	 * @param default_spot_id        OUT: the spot of the other terminals
+	 * @param default_category_name  OUT: the category of the other terminals
+	 * @param terminal_categories    OUT: the spot and category of the terminals
+	 * @param topology               The topology read with readTopologyUpdate,
+	 *                               nullptr for the running one
+	 * @return true on success, false otherwise
+	 */
 	bool getTerminalAffectation(spot_id_t &default_spot_id,
 	                            std::string &default_category_name,
-	                            std::map<tal_id_t, std::pair<spot_id_t, std::string>> &terminal_categories) const;
+	                            std::map<tal_id_t, std::pair<spot_id_t, std::string>> &terminal_categories,
+	                            std::shared_ptr<const OpenSANDConf::DataModel> topology = nullptr) const;
 
 	bool getDefaultSpotId(spot_id_t &default_spot_id) const;
 	const std::unordered_map<spot_id_t, SpotTopology> &getSpotsTopology() const;
@@ -230,14 +403,53 @@ private:
 
 	std::shared_ptr<OpenSANDConf::DataModel> topology;
 	std::shared_ptr<OpenSANDConf::DataModel> infrastructure;
+
+	/// The file the topology was read from
+	std::string topology_path;
 	std::shared_ptr<OpenSANDConf::DataModel> profile;
 
+	/// The folder of the compiled configuration cache, empty if disabled
+	std::string cache_folder;
+
+	/// Whether the random generators are seeded with random_seed
+	bool has_random_seed;
+	unsigned int random_seed;
+
 	std::shared_ptr<OutputLog> log;
 	
 	std::unordered_map<tal_id_t, Component> entities_type;
 	std::unordered_map<spot_id_t, SpotTopology> spots_topology;
 
+	/// The profile elements by path, built when the profile is read
+	std::unordered_map<std::string, std::shared_ptr<OpenSANDConf::DataElement>> profile_index;
+
+	/// The gateways of the infrastructure by id
+	std::unordered_map<tal_id_t, std::shared_ptr<OpenSANDConf::DataComponent>> gateways_by_id;
+
+	/// The topology of the spots by gateway id, the first one when a
+	/// gateway is configured on several spots
+	std::unordered_map<tal_id_t, std::shared_ptr<OpenSANDConf::DataComponent>> spots_by_gateway;
+	/// The number of spots configured for each gateway
+	std::unordered_map<tal_id_t, unsigned int> spots_per_gateway;
+	/// The gateway of the terminals assigned to one
+	std::unordered_map<tal_id_t, tal_id_t> terminals_gateway;
+	/// The gateway of the other terminals, negative if not configured
+	int default_gateway_id;
+
+	/// The carriers of the spots already read, by gateway id and direction
+	mutable std::map<std::pair<tal_id_t, bool>, OpenSandModelConf::spot> spots_carriers;
+	mutable std::mutex spots_carriers_lock;
+
+	std::string getProfileModelPath(const std::string &key) const;
+
+	std::shared_ptr<OpenSANDConf::DataModel> readData(std::shared_ptr<OpenSANDConf::MetaModel> model,
+	                                                  const std::string &filename) const;
+	void indexProfile(std::shared_ptr<OpenSANDConf::DataElement> element,
+	                  const std::string &path);
 	bool getSpotCarriers(uint16_t gw_id, OpenSandModelConf::spot &spot, bool forward) const;
+	std::shared_ptr<OpenSANDConf::DataComponent> getInterconnectParams(std::size_t isl_index) const;
+	bool readSpotCarriers(std::shared_ptr<const OpenSANDConf::DataComponent> selected_spot,
+	                      OpenSandModelConf::spot &spot, bool forward) const;
 };
 
 
@@ -261,6 +473,13 @@ bool OpenSandModelConf::extractParameterData(std::shared_ptr<const OpenSANDConf:
 }
 
 
+template<typename T>
+bool OpenSandModelConf::getProfileValue(const std::string &path, T &result) const
+{
+	return extractParameterData(this->getProfileParameter(path), result);
+}
+
+
 template<typename T>
 bool OpenSandModelConf::extractParameterData(std::shared_ptr<const OpenSANDConf::DataComponent> component,
                                              const std::string& parameter,
@@ -112,7 +112,11 @@ bool BlockDvb::DvbUpward::shareFrame(DvbFrame *frame)
 BlockDvb::DvbDownward::DvbDownward(const std::string &name, dvb_specific specific):
 	DvbChannel(),
 	RtDownward(name),
-	disable_control_plane{specific.disable_control_plane}
+	disable_control_plane{specific.disable_control_plane},
+	mirror_bbframes{name + ".Downward.bbframes"},
+	mirror_saloha{name + ".Downward.saloha"},
+	mirror_frames{name + ".Downward.frames"},
+	mirror_tal_id{specific.mac_id}
 {
 }
 
@@ -180,6 +184,11 @@ bool BlockDvb::DvbDownward::sendDvbFrame(DvbFrame *dvb_frame,
 	}
 
 	dvb_frame->setCarrierId(carrier_id);
+	// the frames built from a received carrier frame keep its timestamp
+	if(dvb_frame->getTimestamp() == 0)
+	{
+		dvb_frame->setTimestamp(getTimestampNs());
+	}
 
 	if(dvb_frame->getTotalLength() <= 0)
 	{
@@ -188,13 +197,19 @@ bool BlockDvb::DvbDownward::sendDvbFrame(DvbFrame *dvb_frame,
 		return false;
 	}
 
-	// send the message to the lower layer
+	PacketMirror &mirror = this->getMirror(dvb_frame->getMessageType());
+	if(mirror.isEnabled())
+	{
+		mirror.copy(dvb_frame->getRawData(), dvb_frame->getTotalLength(),
+		            this->mirror_tal_id);
+	}
+
+	// send the message to the lower layer, the frame is released on failure
 	// do not count carrier_id in len, this is the dvb_meta->hdr length
-	if(!this->enqueueMessage((void **)&dvb_frame, 0, to_underlying(InternalMessageType::unknown)))
+	if(!this->enqueueMessage(std::unique_ptr<DvbFrame>{dvb_frame}, 0, to_underlying(InternalMessageType::unknown)))
 	{
 		LOG(this->log_send, LEVEL_ERROR,
 		    "failed to send DVB frame to lower layer\n");
-		delete dvb_frame;
 		return false;
 	}
 	// TODO make a log_send_frame and a log_send_sig
@@ -205,6 +220,21 @@ bool BlockDvb::DvbDownward::sendDvbFrame(DvbFrame *dvb_frame,
 }
 
 
+PacketMirror &BlockDvb::DvbDownward::getMirror(EmulatedMessageType msg_type)
+{
+	switch(msg_type)
+	{
+		case EmulatedMessageType::BbFrame:
+			return this->mirror_bbframes;
+		case EmulatedMessageType::SalohaData:
+		case EmulatedMessageType::SalohaCtrl:
+			return this->mirror_saloha;
+		default:
+			return this->mirror_frames;
+	}
+}
+
+
 bool BlockDvb::DvbDownward::onRcvEncapPacket(std::unique_ptr<NetPacket> packet,
                                              DvbFifo *fifo,
                                              time_ms_t fifo_delay)
@@ -61,6 +61,7 @@
 #include "PhysicStd.h"
 #include "TerminalCategory.h"
 #include "DvbChannel.h"
+#include "PacketMirror.h"
 
 #include <opensand_rt/Rt.h>
 #include <opensand_rt/RtChannel.h>
@@ -166,6 +167,24 @@ public:
 		virtual void updateStats(void) = 0;
 
 		bool disable_control_plane;
+
+	private:
+		/// The mirrors of the frames sent to the lower layer:
+		/// BBFrames, SALOHA slots and the other DVB-RCS2 and signalling frames
+		PacketMirror mirror_bbframes;
+		PacketMirror mirror_saloha;
+		PacketMirror mirror_frames;
+
+		/// The terminal ID given to the mirrored frames
+		tal_id_t mirror_tal_id;
+
+		/**
+		 * @brief Get the mirror of a frame type
+		 *
+		 * @param msg_type  The frame type
+		 * @return the mirror of the frames of this type
+		 */
+		PacketMirror &getMirror(EmulatedMessageType msg_type);
 	};
 };
 
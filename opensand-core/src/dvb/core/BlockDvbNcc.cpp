@@ -46,8 +46,11 @@
 #include "Sof.h"
 
 #include <errno.h>
+#include <limits>
+#include <opensand_rt/FileEvent.h>
 #include <opensand_rt/TcpListenEvent.h>
 #include <opensand_rt/MessageEvent.h>
+#include <opensand_rt/RtMemory.h>
 
 
 
@@ -58,6 +61,8 @@
 BlockDvbNcc::BlockDvbNcc(const std::string &name, struct dvb_specific specific):
 	BlockDvb{name},
 	mac_id{specific.mac_id},
+	disable_control_plane{specific.disable_control_plane},
+	checkpoint{nullptr},
 	output_sts{nullptr},
 	input_sts{nullptr}
 {
@@ -66,6 +71,10 @@ BlockDvbNcc::BlockDvbNcc(const std::string &name, struct dvb_specific specific):
 
 BlockDvbNcc::~BlockDvbNcc()
 {
+	// the last terminal states are written before the writer stops
+	delete this->checkpoint;
+	this->checkpoint = nullptr;
+
 	delete this->input_sts;
 	this->input_sts = nullptr;
 
@@ -88,6 +97,13 @@ bool BlockDvbNcc::onInit(void)
 		return false;
 	}
 
+	if(!this->initCheckpoint())
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "Failed to initialize the checkpoint\n");
+		return false;
+	}
+
 	return true;
 }
 
@@ -123,6 +139,46 @@ bool BlockDvbNcc::initListsSts()
 }
 
 
+bool BlockDvbNcc::initCheckpoint()
+{
+	// the terminals are only logged on with a control plane
+	if(this->disable_control_plane)
+	{
+		return true;
+	}
+
+	std::string path;
+	int period_sf = 0;
+	auto network = OpenSandModelConf::Get()->getProfileData()->getComponent("network");
+	if(!OpenSandModelConf::extractParameterData(network->getParameter("checkpoint_file"), path) ||
+	   path.empty())
+	{
+		return true;
+	}
+	if(!OpenSandModelConf::extractParameterData(network->getParameter("checkpoint_period"), period_sf) ||
+	   period_sf <= 0 || period_sf > std::numeric_limits<time_sf_t>::max())
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "section 'network': the checkpoint period should be a "
+		    "positive number of superframes\n");
+		return false;
+	}
+
+	this->checkpoint = new NccCheckpoint(path, period_sf);
+	if(!this->checkpoint->init())
+	{
+		return false;
+	}
+
+	// the upward registers the restored terminals first, then the
+	// downward logs them on in the DAMA controller
+	static_cast<Upward *>(this->upward)->setCheckpoint(this->checkpoint);
+	static_cast<Downward *>(this->downward)->setCheckpoint(this->checkpoint);
+
+	return true;
+}
+
+
 /*****************************************************************************/
 /*                              Downward                                     */
 /*****************************************************************************/
@@ -138,7 +194,16 @@ BlockDvbNcc::Downward::Downward(const std::string &name, struct dvb_specific spe
 	spot_id{specific.spot_id},
 	fwd_frame_counter{0},
 	fwd_timer{-1},
-	probe_frame_interval{nullptr}
+	topology_event{-1},
+	look_ahead_timer{-1},
+	spot{nullptr},
+	ctrl_bundle{nullptr},
+	checkpoint{nullptr},
+	probe_frame_interval{nullptr},
+	frame_tick_monitor{},
+	fwd_tick_monitor{},
+	numa_probes{},
+	numa_timer{-1}
 {
 }
 
@@ -148,6 +213,12 @@ BlockDvbNcc::Downward::~Downward()
 }
 
 
+void BlockDvbNcc::Downward::setCheckpoint(NccCheckpoint *checkpoint)
+{
+	this->checkpoint = checkpoint;
+}
+
+
 bool BlockDvbNcc::Downward::onInit(void)
 {
 	// get the common parameters
@@ -225,6 +296,21 @@ bool BlockDvbNcc::Downward::onInit(void)
 		}
 		this->addTcpListenEvent("svno_listen",
 		                        this->svno_interface.getSvnoListenSocket(), 200);
+
+		// the terminals of a previous NCC keep their requests
+		if(this->checkpoint && !this->spot->restoreCheckpoint(this->checkpoint))
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "failed to restore the checkpointed terminals\n");
+			return false;
+		}
+
+		// the return band follows the topology file without restart
+		int topology_fd = spot->initTopologyWatch();
+		if(topology_fd >= 0)
+		{
+			this->topology_event = this->addFileEvent("topology", topology_fd, 4096);
+		}
 	}
 
 	// generate probes prefix
@@ -235,6 +321,24 @@ bool BlockDvbNcc::Downward::onInit(void)
 	this->probe_frame_interval = Output::Get()->registerProbe<float>(prefix + "Perf.Frames_interval",
 	                                                                 "ms", true,
 	                                                                 SAMPLE_LAST);
+	this->fwd_tick_monitor.init(prefix, "Fwd_frame_tick",
+	                            this->fwd_down_frame_duration_ms,
+	                            this->stats_period_ms / std::max<time_ms_t>(1, this->fwd_down_frame_duration_ms),
+	                            true);
+	if(!this->disable_control_plane)
+	{
+		this->frame_tick_monitor.init(prefix, "Frame_tick",
+		                              this->ret_up_frame_duration_ms,
+		                              this->stats_period_ms / std::max<time_ms_t>(1, this->ret_up_frame_duration_ms),
+		                              true);
+	}
+
+	// the spot was built on the NUMA nodes of the channel placement
+	this->numa_probes.init(prefix, RtMemory::getThreadNodes());
+	if(this->numa_probes.isEnabled())
+	{
+		this->numa_timer = this->addTimerEvent("numa_stats", this->stats_period_ms);
+	}
 
 	return true;
 }
@@ -242,18 +346,19 @@ bool BlockDvbNcc::Downward::onInit(void)
 
 bool BlockDvbNcc::Downward::initTimers(void)
 {
-	// Set #sf and launch frame timer
+	// Set #sf and launch frame timer, the timers are aligned on the
+	// clock so the frames of all the spots start together
 	this->super_frame_counter = 0;
-	this->fwd_timer = this->addTimerEvent("fwd_timer",
-	                                      this->fwd_down_frame_duration_ms);
+	this->fwd_timer = this->addAlignedTimerEvent("fwd_timer",
+	                                             this->fwd_down_frame_duration_ms);
 
 	if (this->disable_control_plane)
 	{
 		return true;
 	}
 
-	this->frame_timer = this->addTimerEvent("frame",
-	                                        this->ret_up_frame_duration_ms);
+	this->frame_timer = this->addAlignedTimerEvent("frame",
+	                                               this->ret_up_frame_duration_ms);
 
 	auto Conf = OpenSandModelConf::Get();
 
@@ -286,6 +391,17 @@ bool BlockDvbNcc::Downward::initTimers(void)
 		    "Error when getting spot %d\n", spot_id);
 		return false;
 	}
+	// the DAMA allocations of the next superframes are computed in
+	// the middle of the current one, once its TTP is sent
+	if(spot->getDamaLookAhead() > 0)
+	{
+		this->look_ahead_timer = this->addTimerEvent("dama_look_ahead",
+		                                             this->ret_up_frame_duration_ms / 2.0,
+		                                             false, // no rearm
+		                                             false // do not start
+		                                             );
+	}
+
 	spot->setPepCmdApplyTimer(this->addTimerEvent("pep_request",
 	                                              pep_alloc_delay,
 	                                              false, // no rearm
@@ -402,6 +518,7 @@ bool BlockDvbNcc::Downward::onEvent(const RtEvent *const event)
 			    "timer event received on downward channel");
 			if(*event == this->frame_timer)
 			{
+				this->frame_tick_monitor.tickStart();
 				if(this->probe_frame_interval->isEnabled())
 				{
 					time_val_t time = event->getAndSetCustomTime();
@@ -428,8 +545,21 @@ bool BlockDvbNcc::Downward::onEvent(const RtEvent *const event)
 				// send Start Of Frame
 				this->sendSOF(spot->getSofCarrierId());
 
+				// admit the logons queued during a logon storm, before
+				// the allocation so that the terminals get their capacity
+				std::vector<tal_id_t> admitted;
+				if(!spot->admitLogons(admitted))
+				{
+					LOG(this->log_receive, LEVEL_ERROR,
+					    "SF#%u: some queued logon requests failed\n",
+					    this->super_frame_counter);
+				}
+				this->sendLogonResponses(admitted, spot);
+
 				if(spot->checkDama())
 				{
+					this->flushCtrlBundle(spot);
+					this->frame_tick_monitor.tickEnd();
 					break;
 				}
 
@@ -441,11 +571,36 @@ bool BlockDvbNcc::Downward::onEvent(const RtEvent *const event)
 					return false;
 				}
 
-				// send TTP computed by DAMA
+				// send TTP computed by DAMA, with the logon responses
 				this->sendTTP(spot);
+				this->flushCtrlBundle(spot);
+				if(this->look_ahead_timer >= 0 &&
+				   !this->startTimer(this->look_ahead_timer))
+				{
+					LOG(this->log_receive, LEVEL_ERROR,
+					    "SF#%u: cannot start the DAMA look-ahead timer\n",
+					    this->super_frame_counter);
+				}
+				this->frame_tick_monitor.tickEnd();
+			}
+			else if(*event == this->look_ahead_timer)
+			{
+				// the allocations not computed ahead are computed
+				// on the superframe change
+				if(!spot->handleLookAheadTimer())
+				{
+					LOG(this->log_receive, LEVEL_ERROR,
+					    "SF#%u: cannot compute the DAMA allocations ahead\n",
+					    this->super_frame_counter);
+				}
+			}
+			else if(*event == this->numa_timer)
+			{
+				this->numa_probes.update();
 			}
 			else if(*event == this->fwd_timer)
 			{
+				this->fwd_tick_monitor.tickStart();
 				this->fwd_frame_counter++;
 				if(!spot->handleFwdFrameTimer(this->fwd_frame_counter))
 				{
@@ -461,24 +616,42 @@ bool BlockDvbNcc::Downward::onEvent(const RtEvent *const event)
 					    "frames\n");
 					return false;
 				}
+				this->fwd_tick_monitor.tickEnd();
 			}
 			else if(*event == spot->getPepCmdApplyTimer())
 			{
 				// it is time to apply the command sent by the external
 				// PEP component
 
-				PepRequest *pep_request;
+				// the requests received from now on are kept
+				// for the next application
+				const std::vector<PepRequest> &pep_requests =
+					this->pep_interface.swapPepRequests();
 
 				LOG(this->log_receive, LEVEL_NOTICE,
-				    "apply PEP requests now\n");
-				while((pep_request = this->pep_interface.getNextPepRequest()) != NULL)
+				    "apply %zu PEP requests now\n", pep_requests.size());
+				for(auto &&pep_request: pep_requests)
 				{
-					spot->applyPepCommand(pep_request);
+					spot->applyPepCommand(&pep_request);
 				}
 			}
 
 			break;
 		}
+		case EventType::File:
+		{
+			if(*event == this->topology_event)
+			{
+				auto file_event = static_cast<const FileEvent *>(event);
+				unsigned char *data = file_event->getData();
+				if(data)
+				{
+					spot->handleTopologyChange(data, file_event->getSize());
+					file_event->releaseData(data);
+				}
+			}
+			break;
+		}
 		// TODO factorize, some elements are exactly the same between NccInterface classes
 		case EventType::NetSocket:
 		{
@@ -618,7 +791,7 @@ bool BlockDvbNcc::Downward::onEvent(const RtEvent *const event)
 				// add a fd to handle events on the client socket
 				this->addNetSocketEvent("pep_client",
 				                        this->pep_interface.getPepClientSocket(),
-				                        200);
+				                        NccInterface::max_message_length);
 			}
 			else if(*event == this->svno_interface.getSvnoListenSocket())
 			{
@@ -635,7 +808,7 @@ bool BlockDvbNcc::Downward::onEvent(const RtEvent *const event)
 				// add a fd to handle events on the client socket
 				this->addNetSocketEvent("svno_client",
 				                        this->svno_interface.getSvnoClientSocket(),
-				                        200);
+				                        NccInterface::max_message_length);
 			}
 			break;
 		}
@@ -688,9 +861,8 @@ void BlockDvbNcc::Downward::sendTTP(SpotDownward *spot)
 		return;
 	};
 
-	if(!this->sendDvbFrame(reinterpret_cast<DvbFrame *>(ttp), spot->getCtrlCarrierId()))
+	if(!this->sendCtrlFrame(reinterpret_cast<DvbFrame *>(ttp), spot))
 	{
-		delete ttp;
 		LOG(this->log_send, LEVEL_ERROR,
 				"Failed to send TTP\n");
 		return;
@@ -701,39 +873,90 @@ void BlockDvbNcc::Downward::sendTTP(SpotDownward *spot)
 }
 
 
-bool BlockDvbNcc::Downward::handleLogonReq(DvbFrame *dvb_frame, SpotDownward *spot)
+bool BlockDvbNcc::Downward::sendCtrlFrame(DvbFrame *dvb_frame, SpotDownward *spot)
 {
-	LogonRequest *logon_req = reinterpret_cast<LogonRequest *>(dvb_frame);
-	uint16_t mac = logon_req->getMac();
+	std::unique_ptr<DvbFrame> frame{dvb_frame};
 
-	// Inform the Dama controller (for its own context)
-	if(!spot->handleLogonReq(logon_req))
+	if(this->ctrl_bundle && this->ctrl_bundle->addFrame(*frame))
+	{
+		return true;
+	}
+	// the bundle is full, send it and start a new one
+	if(!this->flushCtrlBundle(spot))
 	{
-		delete dvb_frame;
 		return false;
 	}
+	this->ctrl_bundle.reset(new ControlBundle());
+	if(this->ctrl_bundle->addFrame(*frame))
+	{
+		return true;
+	}
 
-	// TODO only used here tal_id and logon_id are the same
-	// may be we can simplify the constructor
-	LogonResponse *logon_resp = new LogonResponse(mac, this->mac_id, mac);
+	// too large for a bundle, send it alone
+	LOG(this->log_send, LEVEL_INFO,
+	    "SF#%u: control frame of %u bytes sent out of the bundle\n",
+	    this->super_frame_counter, frame->getMessageLength());
+	return this->sendDvbFrame(frame.release(), spot->getCtrlCarrierId());
+}
 
-	LOG(this->log_send, LEVEL_DEBUG,
-			"SF#%u: logon response sent to lower layer\n",
-			this->super_frame_counter);
 
+bool BlockDvbNcc::Downward::flushCtrlBundle(SpotDownward *spot)
+{
+	if(!this->ctrl_bundle || this->ctrl_bundle->getFramesCount() == 0)
+	{
+		return true;
+	}
 
-	if(!this->sendDvbFrame(reinterpret_cast<DvbFrame *>(logon_resp),
-	                       spot->getCtrlCarrierId()))
+	LOG(this->log_send, LEVEL_DEBUG,
+	    "SF#%u: bundle of %u control frames sent\n",
+	    this->super_frame_counter, this->ctrl_bundle->getFramesCount());
+	if(!this->sendDvbFrame(this->ctrl_bundle.release(), spot->getCtrlCarrierId()))
 	{
 		LOG(this->log_send, LEVEL_ERROR,
-				"Failed send logon response\n");
+		    "Failed to send the bundle of control frames\n");
 		return false;
 	}
-
 	return true;
 }
 
 
+bool BlockDvbNcc::Downward::handleLogonReq(DvbFrame *dvb_frame, SpotDownward *spot)
+{
+	std::vector<tal_id_t> admitted;
+
+	// Inform the Dama controller (for its own context), during a logon
+	// storm the request waits for the next superframes
+	bool status = spot->queueLogonReq(dvb_frame, admitted);
+	return this->sendLogonResponses(admitted, spot) && status;
+}
+
+
+bool BlockDvbNcc::Downward::sendLogonResponses(const std::vector<tal_id_t> &admitted,
+                                               SpotDownward *spot)
+{
+	bool status = true;
+	for(tal_id_t mac : admitted)
+	{
+		// TODO only used here tal_id and logon_id are the same
+		// may be we can simplify the constructor
+		LogonResponse *logon_resp = new LogonResponse(mac, this->mac_id, mac);
+
+		LOG(this->log_send, LEVEL_DEBUG,
+				"SF#%u: logon response sent to lower layer\n",
+				this->super_frame_counter);
+
+		if(!this->sendCtrlFrame(reinterpret_cast<DvbFrame *>(logon_resp), spot))
+		{
+			LOG(this->log_send, LEVEL_ERROR,
+					"Failed send logon response\n");
+			status = false;
+		}
+	}
+
+	return status;
+}
+
+
 // updateStats is pure virtual in BlockDvb not used in this case
 void BlockDvbNcc::Downward::updateStats(void)
 {
@@ -749,6 +972,9 @@ BlockDvbNcc::Upward::Upward(const std::string &name, struct dvb_specific specifi
 	DvbFmt{},
 	mac_id{specific.mac_id},
 	spot_id{specific.spot_id},
+	spot{nullptr},
+	batch_timer{-1},
+	checkpoint{nullptr},
 	log_saloha{nullptr},
 	probe_gw_received_modcod{nullptr},
 	probe_gw_rejected_modcod{nullptr}
@@ -761,6 +987,12 @@ BlockDvbNcc::Upward::~Upward()
 }
 
 
+void BlockDvbNcc::Upward::setCheckpoint(NccCheckpoint *checkpoint)
+{
+	this->checkpoint = checkpoint;
+}
+
+
 bool BlockDvbNcc::Upward::onInit(void)
 {
 	LOG(this->log_init, LEVEL_DEBUG,
@@ -779,6 +1011,25 @@ bool BlockDvbNcc::Upward::onInit(void)
 		return false;
 	}
 
+	if(this->checkpoint && !this->spot->restoreCheckpoint(*this->checkpoint))
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "failed to restore the checkpointed terminals\n");
+		return false;
+	}
+
+	// the received packets are batched until the next SoF, the timer
+	// bounds their delay to a return frame if no SoF comes back
+	time_ms_t ret_up_frame_duration_ms;
+	if(!OpenSandModelConf::Get()->getReturnFrameDuration(ret_up_frame_duration_ms))
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "missing parameter 'return link frame duration'\n");
+		return false;
+	}
+	this->batch_timer = this->addTimerEvent("rcv_batch",
+	                                        ret_up_frame_duration_ms);
+
 	// create and send a "link is up" message to upper layer
 	T_LINK_UP *link_is_up = new T_LINK_UP;
 	if(!link_is_up)
@@ -854,6 +1105,15 @@ bool BlockDvbNcc::Upward::onEvent(const RtEvent *const event)
 		}
 		break;
 
+		case EventType::Timer:
+		{
+			if(*event == this->batch_timer && !this->sendBatch())
+			{
+				return false;
+			}
+		}
+		break;
+
 		default:
 			LOG(this->log_receive, LEVEL_ERROR,
 			    "unknown event received %s",
@@ -865,6 +1125,28 @@ bool BlockDvbNcc::Upward::onEvent(const RtEvent *const event)
 }
 
 
+bool BlockDvbNcc::Upward::sendBatch(void)
+{
+	std::unique_ptr<NetBurst> burst = this->spot->flushBatch();
+	if(burst == nullptr)
+	{
+		return true;
+	}
+
+	// send the message to the upper layer, it may be dropped
+	// if the flow control is enabled and the upper layer is congested
+	if(!this->enqueueMessage(std::move(burst), 0, to_underlying(InternalMessageType::decap_data)))
+	{
+		LOG(this->log_send, LEVEL_ERROR,
+		    "failed to send burst of packets to upper layer\n");
+		return false;
+	}
+	LOG(this->log_send, LEVEL_INFO,
+	    "burst sent to the upper layer\n");
+	return true;
+}
+
+
 bool BlockDvbNcc::Upward::onRcvDvbFrame(DvbFrame* dvb_frame)
 {
 	spot_id_t dest_spot = dvb_frame->getSpot();
@@ -916,25 +1198,17 @@ bool BlockDvbNcc::Upward::onRcvDvbFrame(DvbFrame* dvb_frame)
 				this->probe_gw_received_modcod->put(0);
 			}
 
-			NetBurst *burst{nullptr};
-			if(!spot->handleFrame(dvb_frame, &burst))
+			// the packets are batched until the next SoF, the batch
+			// timer or the batch is full
+			if(!spot->handleFrame(dvb_frame))
 			{
 				LOG(this->log_receive, LEVEL_ERROR,
 				    "failed to handle the frame\n");
 				return false;
 			}
-			if (burst != nullptr)
+			if(spot->isBatchFull() && !this->sendBatch())
 			{
-				// send the message to the upper layer
-				if (!this->enqueueMessage((void **)&burst, 0, to_underlying(InternalMessageType::decap_data)))
-				{
-					LOG(this->log_send, LEVEL_ERROR,
-					    "failed to send burst of packets to upper layer\n");
-					delete burst;
-					return false;
-				}
-				LOG(this->log_send, LEVEL_INFO,
-				    "burst sent to the upper layer\n");
+				return false;
 			}
 		}
 		break;
@@ -983,6 +1257,26 @@ bool BlockDvbNcc::Upward::onRcvDvbFrame(DvbFrame* dvb_frame)
 		}
 		break;
 
+		case EmulatedMessageType::CtrlBundle:
+		{
+			// handle the control frames looped back one by one
+			std::vector<DvbFrame *> frames;
+			bool success = ControlBundle::split(*dvb_frame, frames);
+			delete dvb_frame;
+			if(!success)
+			{
+				LOG(this->log_receive, LEVEL_ERROR,
+				    "malformed bundle of control frames\n");
+				return false;
+			}
+			for(DvbFrame *frame: frames)
+			{
+				success = this->onRcvDvbFrame(frame) && success;
+			}
+			return success;
+		}
+		break;
+
 		case EmulatedMessageType::Ttp:
 		case EmulatedMessageType::SessionLogonResp:
 		{
@@ -1002,6 +1296,12 @@ bool BlockDvbNcc::Upward::onRcvDvbFrame(DvbFrame* dvb_frame)
 
 		case EmulatedMessageType::Sof:
 		{
+			// a new superframe begins, flush the packets of the previous one
+			if(!this->sendBatch())
+			{
+				return false;
+			}
+
 			// use SoF for SAloha scheduling
 			spot->updateStats();
 
@@ -68,6 +68,10 @@
 #include "NccPepInterface.h"
 #include "NccSvnoInterface.h"
 #include "DvbChannel.h"
+#include "FrameTickMonitor.h"
+#include "NumaProbes.h"
+#include "NccCheckpoint.h"
+#include "ControlBundle.h"
 
 
 class SpotDownward;
@@ -95,6 +99,13 @@ public:
 		bool onInit(void);
 		bool onEvent(const RtEvent *const event);
 
+		/**
+		 * @brief Set the checkpoint whose terminals are restored
+		 *
+		 * @param checkpoint  The checkpoint, owned by the block
+		 */
+		void setCheckpoint(NccCheckpoint *checkpoint);
+
 	protected:
 		/**
 		 * @brief Initialize the output
@@ -105,6 +116,13 @@ public:
 		
 		bool onRcvDvbFrame(DvbFrame *frame);
 
+		/**
+		 * @brief Send the packets batched by the spot to the upper layer
+		 *
+		 * @return  true on success, false otherwise
+		 */
+		bool sendBatch(void);
+
 		/// the MAC ID of the ST (as specified in configuration)
 		int mac_id;
 
@@ -113,6 +131,12 @@ public:
 
 		SpotUpward* spot;
 
+		/// The timer bounding the time the packets stay batched
+		event_id_t batch_timer;
+
+		/// The checkpoint of the terminal states, nullptr if disabled
+		NccCheckpoint *checkpoint;
+
 		// log for slotted aloha
 		std::shared_ptr<OutputLog> log_saloha;
 
@@ -130,6 +154,13 @@ public:
 			bool onInit(void);
 			bool onEvent(const RtEvent *const event);
 
+			/**
+			 * @brief Set the checkpoint fed with the terminal states
+			 *
+			 * @param checkpoint  The checkpoint, owned by the block
+			 */
+			void setCheckpoint(NccCheckpoint *checkpoint);
+
 		protected:
 			/**
 			 * Read configuration for the downward timers
@@ -161,11 +192,31 @@ public:
 			bool handleLogonReq(DvbFrame *dvb_frame, SpotDownward *spot);
 
 			/**
-			 * @brief Send a SAC message containing ACM parameters
+			 *  @brief Send the logon responses of the admitted terminals
+			 *
+			 *  @param admitted  The terminals whose logon was admitted
+			 *  @param spot      The spot concerned by the requests
+			 *  @return true on success, false otherwise
+			 */
+			bool sendLogonResponses(const std::vector<tal_id_t> &admitted, SpotDownward *spot);
+
+			/**
+			 * @brief Add a control frame to the bundle sent at the end of
+			 *        the superframe tick
 			 *
+			 * @param dvb_frame  The control frame, released by the call
+			 * @param spot       The spot the frame is sent on
 			 * @return true on success, false otherwise
 			 */
-			bool sendAcmParameters(SpotDownward *spot_downward);
+			bool sendCtrlFrame(DvbFrame *dvb_frame, SpotDownward *spot);
+
+			/**
+			 * @brief Send the control frames bundled since the last flush
+			 *
+			 * @param spot  The spot the bundle is sent on
+			 * @return true on success, false otherwise
+			 */
+			bool flushCtrlBundle(SpotDownward *spot);
 
 			// statistics update
 			void updateStats(void);
@@ -191,21 +242,58 @@ public:
 			/// frame timer for forward, used to awake the block every frame period
 			event_id_t fwd_timer;
 
+			/// changes of the topology file, to reconfigure the return band
+			event_id_t topology_event;
+
+			/// timer in the middle of a superframe computing the DAMA
+			/// allocations ahead, -1 if they are computed on the superframe change
+			event_id_t look_ahead_timer;
+
 			/// Delay for allocation requests from PEP (in ms)
 			int pep_alloc_delay;
 
 			SpotDownward* spot;
 
+			/// The TTP and logon responses waiting for the end of the
+			/// superframe tick, nullptr if none
+			std::unique_ptr<ControlBundle> ctrl_bundle;
+
+			/// The checkpoint of the terminal states, nullptr if disabled
+			NccCheckpoint *checkpoint;
+
 			// Frame interval
 			std::shared_ptr<Probe<float>> probe_frame_interval;
+
+			/// The deadlines of the return (DAMA) and forward frame ticks
+			FrameTickMonitor frame_tick_monitor;
+			FrameTickMonitor fwd_tick_monitor;
+
+			/// The memory of the NUMA nodes the spot is placed on,
+			/// exported every statistics period
+			NumaProbes numa_probes;
+			event_id_t numa_timer;
 	};
 
 protected:
 	bool initListsSts();
 
+	/**
+	 * @brief Read the terminal states checkpointed by a previous NCC
+	 *        and start checkpointing, if enabled
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool initCheckpoint();
+
 	/// the MAC ID of the ST (as specified in configuration)
 	int mac_id;
 
+	/// whether the control plane is disabled
+	bool disable_control_plane;
+
+	/// The checkpoint of the terminal states, nullptr if disabled
+	NccCheckpoint *checkpoint;
+
 	/// The list of Sts with forward/down modcod for this spot
 	StFmtSimuList* output_sts;
 
@@ -52,6 +52,7 @@
 #include "DvbS2Std.h"
 #include "Ttp.h"
 #include "Sof.h"
+#include "ControlBundle.h"
 
 #include "UnitConverterFixedSymbolLength.h"
 #include "OpenSandModelConf.h"
@@ -126,9 +127,11 @@ void BlockDvbTal::generateConfiguration(std::shared_ptr<OpenSANDConf::MetaParame
 		Conf->setProfileReference(access, disable_ctrl_plane, false);
 
 		types->addEnumType("st_fifo_access_type", "Access Type", {"DAMA_RBDC", "DAMA_VBDC", "DAMA_CRA", "SALOHA"});
+		types->addEnumType("fifo_aqm", "Active Queue Management", {"None", "CoDel", "PIE"});
 		// TODO: Keep in sync with topology
 		types->addEnumType("carrier_group", "Carrier Group", {"Standard", "Premium", "Professional", "SVNO1", "SVNO2", "SVNO3", "SNO"});
 		types->addEnumType("dama_algorithm", "DAMA Agent Algorithm", {"Legacy"});
+		types->addEnumType("fifo_scheduling", "FIFO Scheduling", {"Strict Priority", "DRR", "WFQ"});
 
 		auto settings = access->addComponent("settings", "Settings");
 		settings->addParameter("category", "Category", types->getType("carrier_group"));
@@ -147,10 +150,18 @@ void BlockDvbTal::generateConfiguration(std::shared_ptr<OpenSANDConf::MetaParame
 		vbdc->setUnit("kb/sync period");
 		Conf->setProfileReference(vbdc, enabled, true);
 		dama->addParameter("algorithm", "DAMA Agent Algorithm", types->getType("dama_algorithm"));
+		dama->addParameter("fifo_scheduling", "FIFO Scheduling", types->getType("fifo_scheduling"),
+		                   "How the allocation is shared between the DAMA FIFOs: "
+		                   "by priority, or by weight with a deficit round robin "
+		                   "or a weighted fair queuing");
 		dama->addParameter("duration", "MSL Duration", types->getType("int"))->setUnit("frames");
 
 		SlottedAlohaTal::generateConfiguration();
 
+		settings->addParameter("batched_ingest", "Batched Ingest", types->getType("bool"),
+		                       "Keep the packets received during a frame and store them "
+		                       "in the MAC FIFOs all at once at the frame tick");
+
 		auto scpc_enabled = settings->addParameter("scpc_enabled", "Enabled SCPC", types->getType("bool"));
 		auto scpc = access->addComponent("scpc", "SCPC");
 		Conf->setProfileReference(scpc, scpc_enabled, true);
@@ -164,6 +175,16 @@ void BlockDvbTal::generateConfiguration(std::shared_ptr<OpenSANDConf::MetaParame
 	pattern->getOrCreateParameter("name", "Name", types->getType("string"));
 	pattern->getOrCreateParameter("capacity", "Capacity", types->getType("int"))->setUnit("packets");
 	pattern->getOrCreateParameter("access_type", "Access Type", types->getType("st_fifo_access_type"));
+	pattern->getOrCreateParameter("weight", "Weight", types->getType("int"),
+	                              "The share of the allocation of the FIFO with a DRR or "
+	                              "WFQ scheduling, relative to the other FIFOs weights");
+	pattern->getOrCreateParameter("aqm", "Active Queue Management", types->getType("fifo_aqm"));
+	pattern->getOrCreateParameter("aqm_target", "AQM Target Delay", types->getType("int"),
+	                              "The target sojourn time in the FIFO, 0 for the algorithm default")->setUnit("ms");
+	pattern->getOrCreateParameter("aqm_interval", "AQM Interval", types->getType("int"),
+	                              "CoDel: the window the sojourn time must stay above the target in, "
+	                              "about the round trip time; PIE: the drop probability update period; "
+	                              "0 for the algorithm default")->setUnit("ms");
 
 	{ // Access section when control plane is disabled
 		auto access = Conf->getOrCreateComponent("access2", "Access", "MAC layer configuration");
@@ -255,6 +276,8 @@ BlockDvbTal::Downward::Downward(const std::string &name, struct dvb_specific spe
 	carrier_id_logon{},
 	carrier_id_data{},
 	dvb_fifos{},
+	batched_ingest{false},
+	staged_packets{},
 	default_fifo_id{0},
 	sync_period_frame{std::numeric_limits<decltype(sync_period_frame)>::max()},
 	obr_slot_frame{std::numeric_limits<decltype(obr_slot_frame)>::max()},
@@ -262,13 +285,12 @@ BlockDvbTal::Downward::Downward(const std::string &name, struct dvb_specific spe
 	logon_timer{-1},
 	qos_server_host{},
 	event_login{nullptr},
+	frame_tick_monitor{},
 	log_frame_tick{nullptr},
 	log_qos_server{nullptr},
 	log_saloha{nullptr},
-	probe_st_queue_size{},
-	probe_st_queue_size_kb{},
-	probe_st_l2_to_sat_before_sched{},
-	probe_st_l2_to_sat_after_sched{},
+	probes_st_fifos{},
+	fifo_probes{},
 	l2_to_sat_total_bytes{0},
 	probe_st_l2_to_sat_total{nullptr},
 	probe_st_phy_to_sat{nullptr},
@@ -355,6 +377,10 @@ bool BlockDvbTal::Downward::onInit(void)
 		auto access = OpenSandModelConf::Get()->getProfileData()->getComponent("access");
 		auto scpc_enabled = access->getComponent("settings")->getParameter("scpc_enabled");
 		OpenSandModelConf::extractParameterData(scpc_enabled, this->is_scpc);
+
+		// the parameter is optional, packets are stored on reception by default
+		auto batched_ingest = access->getComponent("settings")->getParameter("batched_ingest");
+		OpenSandModelConf::extractParameterData(batched_ingest, this->batched_ingest);
 	}
 
 	if(!this->is_scpc)
@@ -568,6 +594,34 @@ bool BlockDvbTal::Downward::initMacFifo(void)
 		DvbFifo *fifo = new DvbFifo(fifo_priority, fifo_name,
 		                            fifo_access_type, fifo_size);
 
+		int fifo_weight = 1;
+		OpenSandModelConf::extractParameterData(fifo_item->getParameter("weight"), fifo_weight);
+		if(fifo_weight < 1)
+		{
+			LOG(this->log_init_channel, LEVEL_ERROR,
+			    "wrong weight %d for fifo %s\n",
+			    fifo_weight, fifo_name.c_str());
+			delete fifo;
+			return releaseMap(this->dvb_fifos, true);
+		}
+		fifo->setWeight(fifo_weight);
+
+		std::string fifo_aqm = "None";
+		int aqm_target = 0;
+		int aqm_interval = 0;
+		OpenSandModelConf::extractParameterData(fifo_item->getParameter("aqm"), fifo_aqm);
+		OpenSandModelConf::extractParameterData(fifo_item->getParameter("aqm_target"), aqm_target);
+		OpenSandModelConf::extractParameterData(fifo_item->getParameter("aqm_interval"), aqm_interval);
+		if(aqm_target < 0 || aqm_interval < 0 ||
+		   !fifo->setAqm(fifo_aqm, aqm_target, aqm_interval))
+		{
+			LOG(this->log_init_channel, LEVEL_ERROR,
+			    "wrong active queue management for fifo %s\n",
+			    fifo_name.c_str());
+			delete fifo;
+			return releaseMap(this->dvb_fifos, true);
+		}
+
 		LOG(this->log_init, LEVEL_NOTICE,
 		    "Fifo priority = %u, FIFO name %s, size %u, "
 		    "CR type %d\n",
@@ -1264,38 +1318,51 @@ bool BlockDvbTal::Downward::initOutput(void)
 	std::string prefix = generateProbePrefix(gw_id, Component::terminal, is_sat);
 
 	this->event_login = output->registerEvent("DVB.login");
+	this->frame_tick_monitor.init(prefix, "Frame_tick",
+	                              this->ret_up_frame_duration_ms,
+	                              this->stats_period_frame,
+	                              true);
 
 	if(this->saloha)
 	{
 		this->log_saloha = output->registerLog(LEVEL_WARNING, "Dvb.SlottedAloha");
 	}
 
+	this->probes_st_fifos.reserve(this->dvb_fifos.size());
 	for(auto&& it : this->dvb_fifos)
 	{
-		unsigned int id = it.first;
+		fifo_probes_t probes;
 		DvbFifo *fifo = it.second;
 		std::string fifo_name = fifo->getName();
 
-		this->probe_st_queue_size[id] =
-		    output->registerProbe<int>(prefix + "Queue size.packets." + fifo_name,
-		                               "Packets", true, SAMPLE_LAST);
-		this->probe_st_queue_size_kb[id] =
-		    output->registerProbe<int>(prefix + "Queue size.capacity." + fifo_name,
-		                               "kbits", true, SAMPLE_LAST);
-
-		this->probe_st_l2_to_sat_before_sched[id] =
-		    output->registerProbe<int>(prefix + "Throughputs.L2_to_SAT_before_sched." + fifo_name,
-		                               "Kbits/s", true,
-		                               SAMPLE_AVG);
-		this->probe_st_l2_to_sat_after_sched[id] =
-		    output->registerProbe<int>(prefix + "Throughputs.L2_to_SAT_after_sched." + fifo_name,
-		                               "Kbits/s", true,
-		                               SAMPLE_AVG);
-		this->probe_st_queue_loss[id] =
-		    output->registerProbe<int>(prefix + "Queue loss.packets." + fifo_name, "Packets", true, SAMPLE_LAST);
-		this->probe_st_queue_loss_kb[id] =
-		    output->registerProbe<int>(prefix + "Queue loss.capacity." + fifo_name,
-		                               "kbits", true, SAMPLE_LAST);
+		probes.fifo = fifo;
+		probes.queue_size =
+		    this->fifo_probes.get(prefix + "Queue size.packets." + fifo_name,
+		                          "Packets", true, SAMPLE_LAST);
+		probes.queue_size_kb =
+		    this->fifo_probes.get(prefix + "Queue size.capacity." + fifo_name,
+		                          "kbits", true, SAMPLE_LAST);
+
+		probes.l2_to_sat_before_sched =
+		    this->fifo_probes.get(prefix + "Throughputs.L2_to_SAT_before_sched." + fifo_name,
+		                          "Kbits/s", true,
+		                          SAMPLE_AVG);
+		probes.l2_to_sat_after_sched =
+		    this->fifo_probes.get(prefix + "Throughputs.L2_to_SAT_after_sched." + fifo_name,
+		                          "Kbits/s", true,
+		                          SAMPLE_AVG);
+		probes.queue_loss =
+		    this->fifo_probes.get(prefix + "Queue loss.packets." + fifo_name, "Packets", true, SAMPLE_LAST);
+		probes.queue_loss_kb =
+		    this->fifo_probes.get(prefix + "Queue loss.capacity." + fifo_name,
+		                          "kbits", true, SAMPLE_LAST);
+		probes.queue_sojourn =
+		    this->fifo_probes.get(prefix + "Queue sojourn.mean." + fifo_name,
+		                          "ms", true, SAMPLE_AVG);
+		probes.queue_sojourn_max =
+		    this->fifo_probes.get(prefix + "Queue sojourn.max." + fifo_name,
+		                          "ms", true, SAMPLE_MAX);
+		this->probes_st_fifos.push_back(probes);
 	}
 	this->probe_st_l2_to_sat_total =
 	    output->registerProbe<int>(prefix + "Throughputs.L2_to_SAT_after_sched.total",
@@ -1396,10 +1463,13 @@ bool BlockDvbTal::Downward::onEvent(const RtEvent *const event)
 				    "(QoS = %d)\n", this->super_frame_counter,
 				    fifo_priority);
 
-				// store the encapsulation packet in the FIFO
-				if(!this->onRcvEncapPacket(std::move(packet),
-				                           this->dvb_fifos[fifo_priority],
-				                           0))
+				// store the encapsulation packet in the FIFO,
+				// or until the next frame tick
+				if(!(this->batched_ingest ?
+				     this->stageEncapPacket(std::move(packet), fifo_priority) :
+				     this->onRcvEncapPacket(std::move(packet),
+				                            this->dvb_fifos[fifo_priority],
+				                            0)))
 				{
 					// a problem occured, we got memory allocation error
 					// or fifo full and we won't empty fifo until next
@@ -1499,6 +1569,7 @@ bool BlockDvbTal::Downward::onEvent(const RtEvent *const event)
 				// TODO fct ++ add extension dans GSE
 				uint32_t remaining_alloc_sym = 0;
 
+				this->enqueueStagedPackets();
 				this->updateStats();
 				this->scpc_frame_counter++;
 
@@ -1568,9 +1639,10 @@ bool BlockDvbTal::Downward::addCniExt(void)
 	{
 		DvbFifo *fifo = fifos_it.second;
 
-		for (auto &&elem: fifo->getQueue())
+		for (vol_pkt_t index = 0; index < fifo->getCurrentSize(); ++index)
 		{
-			std::unique_ptr<NetPacket> packet = elem->getElem<NetPacket>();
+			FifoElement &elem = fifo->peek(index);
+			std::unique_ptr<NetPacket> packet = elem.getElem<NetPacket>();
 			tal_id_t gw = packet->getDstTalId();
 
 			if(gw == this->gw_id && this->is_scpc && this->getCniInputHasChanged(this->tal_id))
@@ -1595,7 +1667,7 @@ bool BlockDvbTal::Downward::addCniExt(void)
 			else
 			{
 				// Put the packet back into the fifo
-				elem->setElem(std::move(packet));
+				elem.setElem(std::move(packet));
 			}
 		}
 	}
@@ -1603,7 +1675,7 @@ bool BlockDvbTal::Downward::addCniExt(void)
 	if(this->is_scpc && this->getCniInputHasChanged(this->tal_id)
 	                 && !in_fifo)
 	{
-		FifoElement *new_el = new FifoElement(nullptr, 0, 0);
+		FifoElement new_el;
 		// set packet extension to this new empty packet
 		if(!this->setPacketExtension(this->pkt_hdl,
 		                             new_el,
@@ -1613,12 +1685,11 @@ bool BlockDvbTal::Downward::addCniExt(void)
 		                             this->super_frame_counter,
 		                             false))
 		{
-			delete new_el;
 			return false;
 		}
 
 		// highest priority fifo
-		this->dvb_fifos[0]->pushBack(new_el);
+		this->dvb_fifos[0]->pushBack(std::move(new_el));
 
 		LOG(this->log_send_channel, LEVEL_DEBUG,
 		    "SF #%d: adding empty packet into FIFO NM\n",
@@ -1852,6 +1923,7 @@ bool BlockDvbTal::Downward::handleStartOfFrame(DvbFrame *dvb_frame)
 
 	// we have consumed all of our frames, we start a new one immediately
 	// this is the first frame of the new superframe
+	this->frame_tick_monitor.tickStart();
 	if(!this->processOnFrameTick())
 	{
 		// exit because the bloc is unable to continue
@@ -1873,6 +1945,7 @@ bool BlockDvbTal::Downward::handleStartOfFrame(DvbFrame *dvb_frame)
 			goto error;
 		}
 	}
+	this->frame_tick_monitor.tickEnd();
 
 	return true;
 
@@ -1883,6 +1956,7 @@ error:
 
 bool BlockDvbTal::Downward::processOnFrameTick(void)
 {
+	this->enqueueStagedPackets();
 	this->updateStats();
 
 	LOG(this->log_frame_tick, LEVEL_INFO,
@@ -1979,25 +2053,35 @@ void BlockDvbTal::Downward::updateStats(void)
 
 	mac_fifo_stat_context_t fifo_stat;
 	// MAC fifos stats
-	for(auto&& it : this->dvb_fifos)
+	bool total_enabled = this->probe_st_l2_to_sat_total->isEnabled();
+	for(auto&& probes : this->probes_st_fifos)
 	{
-		it.second->getStatsCxt(fifo_stat);
+		// the counters of the unused fifos are only reset
+		if(!total_enabled && !probes.isEnabled())
+		{
+			probes.fifo->skipStats();
+			continue;
+		}
+		probes.fifo->getStatsCxt(fifo_stat);
 
 		this->l2_to_sat_total_bytes += fifo_stat.out_length_bytes;
 
-		// write in statitics file
-		this->probe_st_l2_to_sat_before_sched[it.first]->put(
+		// write in statitics file, the probes of a fifo are registered
+		// once it is used
+		probes.l2_to_sat_before_sched.putNonZero(
 			fifo_stat.in_length_bytes * 8 /
 			this->stats_period_ms);
-		this->probe_st_l2_to_sat_after_sched[it.first]->put(
+		probes.l2_to_sat_after_sched.putNonZero(
 			fifo_stat.out_length_bytes * 8 /
 			this->stats_period_ms);
 
-		this->probe_st_queue_size[it.first]->put(fifo_stat.current_pkt_nbr);
-		this->probe_st_queue_size_kb[it.first]->put(
+		probes.queue_size.putNonZero(fifo_stat.current_pkt_nbr);
+		probes.queue_size_kb.putNonZero(
 			fifo_stat.current_length_bytes * 8 / 1000);
-		this->probe_st_queue_loss[it.first]->put(fifo_stat.drop_pkt_nbr);
-		this->probe_st_queue_loss_kb[it.first]->put(fifo_stat.drop_bytes * 8);
+		probes.queue_loss.putNonZero(fifo_stat.drop_pkt_nbr);
+		probes.queue_loss_kb.putNonZero(fifo_stat.drop_bytes * 8);
+		probes.queue_sojourn.putNonZero(fifo_stat.sojourn_avg_ms);
+		probes.queue_sojourn_max.putNonZero(fifo_stat.sojourn_max_ms);
 	}
 	this->probe_st_l2_to_sat_total->put(
 		this->l2_to_sat_total_bytes * 8 /
@@ -2185,6 +2269,54 @@ void BlockDvbTal::Downward::deletePackets()
 	{
 		it.second->flush();
 	}
+	for(auto&& it : this->staged_packets)
+	{
+		it.second.clear();
+	}
+}
+
+
+bool BlockDvbTal::Downward::stageEncapPacket(std::unique_ptr<NetPacket> packet,
+                                             qos_t fifo_priority)
+{
+	DvbFifo *fifo = this->dvb_fifos[fifo_priority];
+	std::vector<FifoElement> &staged = this->staged_packets[fifo_priority];
+
+	if(fifo->getCurrentSize() + staged.size() >= fifo->getMaxSize())
+	{
+		// the FIFO is full once the staged packets are stored,
+		// let it handle the overflow
+		fifo->push(staged);
+		return this->onRcvEncapPacket(std::move(packet), fifo, 0);
+	}
+
+	time_ms_t current_time = getCurrentTime();
+	staged.emplace_back(std::move(packet), current_time, current_time);
+	return true;
+}
+
+
+void BlockDvbTal::Downward::enqueueStagedPackets()
+{
+	for(auto&& it : this->staged_packets)
+	{
+		std::size_t count = it.second.size();
+		if(count == 0)
+		{
+			continue;
+		}
+
+		DvbFifo *fifo = this->dvb_fifos[it.first];
+		std::size_t added = fifo->push(it.second);
+		if(added < count)
+		{
+			LOG(this->log_receive, LEVEL_ERROR,
+			    "SF#%u: FIFO %s is full: drop %zu of the %zu "
+			    "packets received during the frame\n",
+			    this->super_frame_counter, fifo->getName().c_str(),
+			    count - added, count);
+		}
+	}
 }
 
 
@@ -2461,6 +2593,26 @@ bool BlockDvbTal::Upward::onRcvDvbFrame(DvbFrame *dvb_frame)
 	    dvb_frame->getMessageType(),
 	    dvb_frame->getSpot());
 
+	if(msg_type == EmulatedMessageType::CtrlBundle)
+	{
+		// handle the control frames of the superframe in sending order
+		std::vector<DvbFrame *> frames;
+		bool success = ControlBundle::split(*dvb_frame, frames);
+		delete dvb_frame;
+		if(!success)
+		{
+			LOG(this->log_receive, LEVEL_ERROR,
+			    "SF#%u: malformed bundle of control frames\n",
+			    this->super_frame_counter);
+			return false;
+		}
+		for(DvbFrame *frame: frames)
+		{
+			success = this->onRcvDvbFrame(frame) && success;
+		}
+		return success;
+	}
+
 	// get ACM parameters that will be transmited to GW in SAC  TODO check it
 	if(IsCnCapableFrame(msg_type) && this->state == TalState::running)
 	{
@@ -2540,12 +2692,12 @@ bool BlockDvbTal::Upward::onRcvDvbFrame(DvbFrame *dvb_frame)
 				this->probe_st_received_modcod->put(0);
 			}
 
-			// send the message to the upper layer
-			if (burst && !this->enqueueMessage((void **)&burst, 0, to_underlying(InternalMessageType::decap_data)))
+			// send the message to the upper layer, it may be dropped
+			// if the flow control is enabled and the upper layer is congested
+			if (burst && !this->enqueueMessage(std::unique_ptr<NetBurst>{burst}, 0, to_underlying(InternalMessageType::decap_data)))
 			{
 				LOG(this->log_send, LEVEL_ERROR,
 				    "failed to send burst of packets to upper layer\n");
-				delete burst;
 				goto error;
 			}
 			LOG(this->log_send, LEVEL_INFO,
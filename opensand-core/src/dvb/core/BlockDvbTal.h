@@ -48,6 +48,7 @@
 #include "SlottedAlohaTal.h"
 #include "Scheduling.h"
 #include "UnitConverter.h"
+#include "FrameTickMonitor.h"
 #include "OpenSandFrames.h"
 #include "OpenSandCore.h"
 
@@ -345,6 +346,23 @@ public:
 		 */
 		void deletePackets(void);
 
+		/**
+		 * @brief Keep a packet received from the upper layer until the
+		 *        next frame tick, or store it in its FIFO right away if
+		 *        the FIFO could not hold the packets already kept
+		 *
+		 * @param packet         The encapsulation packet
+		 * @param fifo_priority  The ID of the FIFO of the packet
+		 * @return true on success, false otherwise
+		 */
+		bool stageEncapPacket(std::unique_ptr<NetPacket> packet, qos_t fifo_priority);
+
+		/**
+		 * @brief Store the packets kept since the last frame tick in
+		 *        their FIFOs, one batch per FIFO
+		 */
+		void enqueueStagedPackets(void);
+
 		/// reception standard (DVB-RCS or DVB-S2)
 		PhysicStd *reception_std; 
 
@@ -399,6 +417,13 @@ public:
 		/* Fifos */
 		/// map of FIFOs per MAX priority to manage different queues
 		fifos_t dvb_fifos;
+
+		/// Whether the packets from the upper layer are stored in the
+		/// FIFOs once per frame tick rather than on reception
+		bool batched_ingest;
+
+		/// The packets received since the last frame tick, per FIFO
+		std::map<qos_t, std::vector<FifoElement>> staged_packets;
 		/// the default MAC fifo index = fifo with the smallest priority
 		unsigned int default_fifo_id;
 		
@@ -423,6 +448,9 @@ public:
 		// Output events
 		std::shared_ptr<OutputEvent> event_login;
 
+		/// The deadlines of the frame ticks started by the SOF
+		FrameTickMonitor frame_tick_monitor;
+
 		// Output Logs
 		std::shared_ptr<OutputLog> log_frame_tick;
 		std::shared_ptr<OutputLog> log_qos_server;
@@ -430,17 +458,13 @@ public:
 		std::shared_ptr<OutputLog> log_saloha;
 
 		/* Output probes and stats */
-		// Queue sizes
-		std::map<unsigned int, std::shared_ptr<Probe<int> > > probe_st_queue_size;
-		std::map<unsigned int, std::shared_ptr<Probe<int> > > probe_st_queue_size_kb;
-		// Queue loss
-		std::map<unsigned int, std::shared_ptr<Probe<int> > > probe_st_queue_loss;
-		std::map<unsigned int, std::shared_ptr<Probe<int> > > probe_st_queue_loss_kb;
+		// Queue sizes, loss, sojourn times and layer 2 to SAT rates,
+		// in the FIFOs order
+		std::vector<fifo_probes_t> probes_st_fifos;
+		LazyProbes<int> fifo_probes;
 		// Rates
 		// Layer 2 to SAT
-		std::map<unsigned int, std::shared_ptr<Probe<int> > > probe_st_l2_to_sat_before_sched;
 		std::map<unsigned int, int> l2_to_sat_cells_before_sched;
-		std::map<unsigned int, std::shared_ptr<Probe<int> > > probe_st_l2_to_sat_after_sched;
 		int l2_to_sat_total_bytes;
 		std::shared_ptr<Probe<int>> probe_st_l2_to_sat_total;
 		// PHY to SAT
@@ -47,6 +47,10 @@
 
 std::shared_ptr<OutputLog> DvbChannel::dvb_fifo_log = nullptr;
 
+std::map<std::pair<DvbFmt::ModcodDefFileType, vol_sym_t>,
+         std::weak_ptr<FmtDefinitionTable>> DvbFmt::shared_modcod_defs;
+std::mutex DvbFmt::shared_modcod_defs_lock;
+
 /**
  * @brief Check if a file exists
  *
@@ -232,35 +236,21 @@ bool DvbChannel::pushInFifo(DvbFifo *fifo,
                             std::unique_ptr<NetContainer> data,
                             time_ms_t fifo_delay)
 {
-	FifoElement *elem;
 	time_ms_t current_time = getCurrentTime();
 	std::string data_name = data->getName();
 
-	// create a new FIFO element to store the packet
-	try
-	{
-		elem = new FifoElement(std::move(data), current_time, current_time + fifo_delay);
-	}
-	catch (const std::bad_alloc&)
-	{
-		LOG(DvbChannel::dvb_fifo_log, LEVEL_ERROR,
-		    "cannot allocate FIFO element, drop data\n");
-		return false;
-	}
-
 	// append the data in the fifo
-	if(!fifo->push(elem))
+	if(!fifo->push(FifoElement(std::move(data), current_time, current_time + fifo_delay)))
 	{
 		LOG(DvbChannel::dvb_fifo_log, LEVEL_ERROR,
 		    "FIFO is full: drop data\n");
-		delete elem;
 		return false;
 	}
 
 	LOG(DvbChannel::dvb_fifo_log, LEVEL_NOTICE,
 	    "%s data stored in FIFO %s (tick_in = %ld, tick_out = %ld)\n",
 	    data_name.c_str(), fifo->getName().c_str(),
-	    elem->getTickIn(), elem->getTickOut());
+	    static_cast<long>(current_time), static_cast<long>(current_time + fifo_delay));
 
 	return true;
 }
@@ -288,20 +278,38 @@ DvbFmt::DvbFmt():
 
 DvbFmt::~DvbFmt()
 {
-	if(this->s2_modcod_def)
+	// the MODCOD definition tables are released with the last channel using them
+}
+
+bool DvbFmt::initModcodDefFile(ModcodDefFileType def, FmtDefinitionTable **modcod_def, vol_sym_t req_burst_length)
+{
+	std::lock_guard<std::mutex> lock(shared_modcod_defs_lock);
+
+	auto key = std::make_pair(def, req_burst_length);
+	auto table = shared_modcod_defs[key].lock();
+	if(table == nullptr)
 	{
-		delete this->s2_modcod_def;
+		table = std::make_shared<FmtDefinitionTable>();
+		if(!this->loadModcodDefFile(def, *table, req_burst_length))
+		{
+			return false;
+		}
+		shared_modcod_defs[key] = table;
 	}
-	if(this->rcs_modcod_def)
+	else
 	{
-		delete this->rcs_modcod_def;
+		LOG(this->log_fmt, LEVEL_DEBUG,
+		    "reuse the MODCOD definitions already loaded\n");
 	}
+
+	this->modcod_defs.push_back(table);
+	*modcod_def = table.get();
+	return true;
 }
 
-bool DvbFmt::initModcodDefFile(ModcodDefFileType def, FmtDefinitionTable **modcod_def, vol_sym_t req_burst_length)
+bool DvbFmt::loadModcodDefFile(ModcodDefFileType def, FmtDefinitionTable &modcod_def, vol_sym_t req_burst_length)
 {
 	auto Conf = OpenSandModelConf::Get();
-	*modcod_def = new FmtDefinitionTable();
 	std::vector<OpenSandModelConf::fmt_definition_parameters> modcod_params;
 
 	switch(def)
@@ -315,11 +323,11 @@ bool DvbFmt::initModcodDefFile(ModcodDefFileType def, FmtDefinitionTable **modco
 		}
 		for(auto& param : modcod_params)
 		{
-			if(!(*modcod_def)->add(new FmtDefinition(param.id,
-			                                         param.modulation_type,
-			                                         param.coding_type,
-			                                         param.spectral_efficiency,
-			                                         param.required_es_no)))
+			if(!modcod_def.add(new FmtDefinition(param.id,
+			                                     param.modulation_type,
+			                                     param.coding_type,
+			                                     param.spectral_efficiency,
+			                                     param.required_es_no)))
 			{
 				LOG(this->log_fmt, LEVEL_ERROR,
 				    "failed to create MODCOD table for S2 waveforms\n");
@@ -336,12 +344,12 @@ bool DvbFmt::initModcodDefFile(ModcodDefFileType def, FmtDefinitionTable **modco
 		}
 		for(auto& param : modcod_params)
 		{
-			if(!(*modcod_def)->add(new FmtDefinition(param.id,
-			                                         param.modulation_type,
-			                                         param.coding_type,
-			                                         param.spectral_efficiency,
-			                                         param.required_es_no,
-			                                         req_burst_length)))
+			if(!modcod_def.add(new FmtDefinition(param.id,
+			                                     param.modulation_type,
+			                                     param.coding_type,
+			                                     param.spectral_efficiency,
+			                                     param.required_es_no,
+			                                     req_burst_length)))
 			{
 				LOG(this->log_fmt, LEVEL_ERROR,
 				    "failed to create MODCOD table for RCS2 waveforms\n");
@@ -455,7 +463,7 @@ bool DvbFmt::getCniOutputHasChanged(tal_id_t tal_id)
 }
 
 bool DvbFmt::setPacketExtension(EncapPlugin::EncapPacketHandler *pkt_hdl,
-                                FifoElement *elem,
+                                FifoElement &elem,
                                 std::unique_ptr<NetPacket> packet,
                                 tal_id_t source,
                                 tal_id_t dest,
@@ -527,7 +535,7 @@ bool DvbFmt::setPacketExtension(EncapPlugin::EncapPacketHandler *pkt_hdl,
 	}
 
 	// And replace the packet in the FIFO
-	elem->setElem(std::move(extension_pkt));
+	elem.setElem(std::move(extension_pkt));
 
 	return true;
 }
@@ -42,6 +42,8 @@
 #define DVB_CHANNEL_H
 
 #include <sstream>
+#include <map>
+#include <mutex>
 
 #include "PhysicStd.h"
 #include "TerminalCategory.h"
@@ -151,6 +153,8 @@ protected:
 	 * @param   default_category     OUT: The default category if terminal is not
 	 *                                    in terminal affectation
 	 * @param   fmt_groups           OUT: The groups of FMT ids
+	 * @param   topology             The topology the terminal affectation is
+	 *                               read from, nullptr for the running one
 	 * @return true on success, false otherwise
 	 */
 	template<class T>
@@ -162,7 +166,8 @@ protected:
 	              TerminalCategories<T> &categories,
 	              TerminalMapping<T> &terminal_affectation,
 	              T **default_category,
-	              fmt_groups_t &fmt_groups);
+	              fmt_groups_t &fmt_groups,
+	              std::shared_ptr<const OpenSANDConf::DataModel> topology = nullptr);
 
 	/**
 	 * @brief  Compute the bandplan.
@@ -353,7 +358,8 @@ bool DvbChannel::initBand(const OpenSandModelConf::spot &spot,
                           TerminalCategories<T> &categories,
                           TerminalMapping<T> &terminal_affectation,
                           T **default_category,
-                          fmt_groups_t &fmt_groups)
+                          fmt_groups_t &fmt_groups,
+                          std::shared_ptr<const OpenSANDConf::DataModel> topology)
 {
 	// Get the value of the bandwidth
 	freq_khz_t bandwidth_khz = spot.bandwidth_khz;
@@ -465,7 +471,8 @@ bool DvbChannel::initBand(const OpenSandModelConf::spot &spot,
 	std::map<tal_id_t, std::pair<spot_id_t, std::string>> terminals;
 	if (!OpenSandModelConf::Get()->getTerminalAffectation(default_spot_id,
 	                                                      default_category_name,
-	                                                      terminals))
+	                                                      terminals,
+	                                                      topology))
 	{
 		LOG(this->log_init_channel, LEVEL_ERROR,
 		    "Terminals categories initialisation failed\n");
@@ -668,6 +675,9 @@ protected:
 	 * @brief Read configuration for the MODCOD definition file and create the
 	 *        FmtDefinitionTable class
 	 *
+	 * The tables are identical for all the spots and channels of the process,
+	 * they are loaded once and shared, read-only, by all the channels using them.
+	 *
 	 * @param def               The section in configuration file for MODCOD definitions
 	 *                          (up/return or down/forward)
 	 * @param modcod_def        The FMT Definition Table attribute to initialize
@@ -763,7 +773,7 @@ protected:
 	 * @return true on success, false otherwise
 	 */
 	bool setPacketExtension(EncapPlugin::EncapPacketHandler *pkt_hdl,
-	                        FifoElement *elem,
+	                        FifoElement &elem,
 	                        std::unique_ptr<NetPacket> packet,
 	                        tal_id_t source,
 	                        tal_id_t dest,
@@ -794,6 +804,25 @@ private:
 	/// Whether we can send stats or not (can send stats when 0)
 	time_frame_t check_send_stats;
 
+	/// The MODCOD Definition Tables used by this channel
+	std::vector<std::shared_ptr<FmtDefinitionTable>> modcod_defs;
+
+	/// The MODCOD Definition Tables of the process, by type and burst length
+	static std::map<std::pair<ModcodDefFileType, vol_sym_t>,
+	                std::weak_ptr<FmtDefinitionTable>> shared_modcod_defs;
+	static std::mutex shared_modcod_defs_lock;
+
+	/**
+	 * @brief Read configuration for the MODCOD definition file and create
+	 *        a new FmtDefinitionTable
+	 *
+	 * @param def               The section in configuration file for MODCOD definitions
+	 * @param modcod_def        The FMT Definition Table to fill
+	 * @param req_burst_length  The required burst length (only for DVB-RCS2)
+	 * @return  true on success, false otherwise
+	 */
+	bool loadModcodDefFile(ModcodDefFileType def, FmtDefinitionTable &modcod_def, vol_sym_t req_burst_length);
+
 	/**
 	 * @brief Delete a Satellite Terminal (ST) from the list
 	 *
@@ -87,9 +87,6 @@ bool DvbS2Std::onRcvFrame(DvbFrame *dvb_frame,
 	auto Conf = OpenSandModelConf::Get();
 	int real_mod = 0;     // real modcod of the receiver
 
-	std::vector<std::unique_ptr<NetPacket>> decap_packets;
-	bool partial_decap = false;
-
 	*burst = nullptr;
 
 	// sanity check
@@ -171,11 +168,14 @@ bool DvbS2Std::onRcvFrame(DvbFrame *dvb_frame,
 		return true;
 	}
 
-	// get encapsulated packets received from lower layer
-	if(!this->packet_handler->getEncapsulatedPackets(std::move(bbframe_burst),
-	                                                 partial_decap,
-	                                                 decap_packets,
-	                                                 burst_length))
+	// get encapsulated packets received from lower layer, a terminal
+	// drops the packets for the others as its encapsulation contexts
+	// would, while the gateway forwards the SCPC packets
+	this->decap_packets.clear();
+	if(!this->packet_handler->getEncapsulatedPacketsFor(std::move(bbframe_burst),
+	                                                    burst_length,
+	                                                    this->is_scpc ? BROADCAST_TAL_ID : tal_id,
+	                                                    this->decap_packets))
 	{
 		LOG(this->log_rcv_from_down, LEVEL_ERROR,
 		    "cannot create one %s packet\n",
@@ -198,7 +198,7 @@ bool DvbS2Std::onRcvFrame(DvbFrame *dvb_frame,
 	}
 
 	// add packets to the newly created burst
-	for (auto&& packet : decap_packets)
+	for (auto&& packet : this->decap_packets)
 	{
 		// add the packet to the burst of packets
 		LOG(this->log_rcv_from_down, LEVEL_INFO,
@@ -207,6 +207,7 @@ bool DvbS2Std::onRcvFrame(DvbFrame *dvb_frame,
 		    packet->getTotalLength());
 		(*burst)->add(std::move(packet));
 	}
+	this->decap_packets.clear();
 
 	return true;
 }
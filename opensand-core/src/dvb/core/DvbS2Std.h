@@ -60,6 +60,9 @@ private:
 	/** The modcod definition table */
 	FmtDefinitionTable *modcod_def;
 
+	/// The packets of the last BB frame, kept to reuse their storage
+	std::vector<std::unique_ptr<NetPacket>> decap_packets;
+
 protected:
 	// whether this is a SCPC reception standard
 	bool is_scpc;
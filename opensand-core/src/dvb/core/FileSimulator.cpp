@@ -37,17 +37,22 @@
 
 #include <errno.h>
 #include <cinttypes>
+#include <limits>
 
 
 FileSimulator::FileSimulator(spot_id_t spot_id,
                              tal_id_t mac_id,
                              FILE** evt_file,
                              std::string &str_config):
-	RequestSimulator(spot_id, mac_id, evt_file)
+	RequestSimulator(spot_id, mac_id, evt_file),
+	timeline(),
+	timeline_pos(0),
+	streamed(false)
 {
 	if(str_config == "stdin")
 	{
 		this->simu_file = stdin;
+		this->streamed = true;
 	}
 	else
 	{
@@ -66,6 +71,26 @@ FileSimulator::FileSimulator(spot_id_t spot_id,
 				"events simulated from %s.\n",
 				str_config.c_str());
 	}
+	if(this->simu_file == NULL)
+	{
+		this->simu_eof = true;
+	}
+
+	// parse the whole trace once instead of scanning it on each superframe
+	if(!this->streamed && !this->simu_eof)
+	{
+		if(!this->readEvents(std::numeric_limits<time_sf_t>::max()))
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "cannot read the simulation file %s\n",
+			    str_config.c_str());
+		}
+		fclose(this->simu_file);
+		this->simu_file = NULL;
+		LOG(this->log_init, LEVEL_NOTICE,
+		    "%zu events loaded from %s\n",
+		    this->timeline.size(), str_config.c_str());
+	}
 }
 
 FileSimulator::~FileSimulator()
@@ -73,148 +98,179 @@ FileSimulator::~FileSimulator()
 }
 
 
-// TODO create a class for simulation and subclass file/random
 bool FileSimulator::simulation(std::list<DvbFrame *>* msgs,
                                time_sf_t super_frame_counter)
 {
-	enum
-	{ none, cr, logon, logoff } event_selected;
-
-	int resul;
-	time_sf_t sf_nr;
-	tal_id_t st_id;
-	uint32_t st_request;
-	rate_kbps_t st_rt;
-	rate_kbps_t st_rbdc;
-	vol_kb_t st_vbdc;
-	uint8_t cr_type;
+	if(this->streamed)
+	{
+		// drop the simulated events and read the ones of this superframe
+		this->timeline.erase(this->timeline.begin(),
+		                     this->timeline.begin() + this->timeline_pos);
+		this->timeline_pos = 0;
+		if(!this->readEvents(super_frame_counter))
+		{
+			return false;
+		}
+	}
 
-	if(this->simu_eof)
+	// skip the events of the past superframes
+	while(this->timeline_pos < this->timeline.size() &&
+	      this->timeline[this->timeline_pos].sf_nr < super_frame_counter)
 	{
-		LOG(this->log_request_simulation, LEVEL_DEBUG,
-		    "End of file\n");
-		goto end;
+		this->timeline_pos++;
 	}
 
-	sf_nr = 0;
-	while(sf_nr <= super_frame_counter)
+	for(; this->timeline_pos < this->timeline.size() &&
+	      this->timeline[this->timeline_pos].sf_nr == super_frame_counter;
+	    this->timeline_pos++)
 	{
-		if(4 ==
-		   sscanf(this->simu_buffer,
-		          "SF%hu CR st%hu cr=%u type=%" SCNu8,
-		          &sf_nr, &st_id, &st_request, &cr_type))
-		{
-			event_selected = cr;
-		}
-		else if(5 ==
-		        sscanf(this->simu_buffer,
-		               "SF%hu LOGON st%hu rt=%hu rbdc=%hu vbdc=%hu",
-		               &sf_nr, &st_id, &st_rt, &st_rbdc, &st_vbdc))
-		{
-			event_selected = logon;
-		}
-		else if(2 ==
-		        sscanf(this->simu_buffer, "SF%hu LOGOFF st%hu", &sf_nr, &st_id))
-		{
-			event_selected = logoff;
-		}
-		else
+		const simu_event_t &event = this->timeline[this->timeline_pos];
+		switch(event.kind)
 		{
-			event_selected = none;
-		}
-		if(event_selected != none && st_id <= BROADCAST_TAL_ID)
-		{
-			LOG(this->log_request_simulation, LEVEL_WARNING,
-			    "Simulated ST%u ignored, IDs smaller than %u "
-			    "reserved for emulated terminals\n",
-			    st_id, BROADCAST_TAL_ID);
-			goto loop_step;
-		}
-		if(event_selected == none)
-			goto loop_step;
-		if(sf_nr < super_frame_counter)
-			goto loop_step;
-		if(sf_nr > super_frame_counter)
-			break;
-		switch (event_selected)
-		{
-			case cr:
+			case simu_event_t::cr:
 			{
-				Sac *sac = new Sac(st_id);
-				sac->addRequest(0, to_enum<ReturnAccessType>(cr_type), st_request);
-				sac->setAcm(0xffff);
-				msgs->push_back((DvbFrame*)sac);
+				if(!this->addRequest(msgs, event.st_id,
+				                     event.cr_type, event.cr_value))
+				{
+					return false;
+				}
 				LOG(this->log_request_simulation, LEVEL_INFO,
 				    "SF#%u: send a simulated CR of type %u with "
 				    "value = %u for ST %hu\n",
-				    super_frame_counter, cr_type,
-				    st_request, st_id);
+				    super_frame_counter, to_underlying(event.cr_type),
+				    event.cr_value, event.st_id);
 				break;
 			}
-			case logon:
+			case simu_event_t::logon:
 			{
-				LogonRequest *logon_req = new LogonRequest(st_id,
-				                                           st_rt,
-				                                           st_rbdc,
-				                                           st_vbdc);
+				LogonRequest *logon_req = new LogonRequest(event.st_id,
+				                                           event.rt,
+				                                           event.rbdc,
+				                                           event.vbdc);
 				msgs->push_back((DvbFrame *)logon_req);
 				
 				LOG(this->log_request_simulation, LEVEL_INFO,
 				    "SF#%u: send a simulated logon for ST %d\n",
-				    super_frame_counter, st_id);
+				    super_frame_counter, event.st_id);
 				break;
 			}
-			case logoff:
+			case simu_event_t::logoff:
 			{
-				Logoff *logoff_req = new Logoff(st_id);
+				Logoff *logoff_req = new Logoff(event.st_id);
 				msgs->push_back((DvbFrame*)logoff_req);
 				LOG(this->log_request_simulation, LEVEL_INFO,
 				    "SF#%u: send a simulated logoff for ST %d\n",
-				    super_frame_counter, st_id);
+				    super_frame_counter, event.st_id);
 				break;
 			}
-			default:
-				break;
 		}
-	 loop_step:
-		resul = -1;
-		while(resul < 1)
+	}
+
+	if(this->simu_eof && this->timeline_pos >= this->timeline.size())
+	{
+		LOG(this->log_request_simulation, LEVEL_DEBUG,
+		    "End of file\n");
+	}
+
+	if(this->event_file)
+	{
+		fflush(this->event_file);
+	}
+	return true;
+}
+
+
+bool FileSimulator::readEvents(time_sf_t until_sf)
+{
+	while(!this->simu_eof &&
+	      (this->timeline.empty() || this->timeline.back().sf_nr <= until_sf))
+	{
+		simu_event_t event;
+		int resul = fscanf(this->simu_file, "%254[^\n]\n", this->simu_buffer);
+		LOG(this->log_request_simulation, LEVEL_DEBUG,
+		    "fscanf result=%d: %s", resul, this->simu_buffer);
+		if(resul == EOF)
 		{
-			resul = fscanf(this->simu_file, "%254[^\n]\n", this->simu_buffer);
-			if(resul == 0)
-			{
-				int ret;
-				// No conversion occured, we simply skip the line
-				ret = fscanf(this->simu_file, "%*s");
-				if ((ret == 0) || (ret == EOF))
-				{
-					return false;
-				}
-			}
-			LOG(this->log_request_simulation, LEVEL_DEBUG,
-			    "fscanf result=%d: %s", resul, this->simu_buffer);
-			//fprintf (stderr, "frame %d\n", super_frame_counter);
+			this->simu_eof = true;
 			LOG(this->log_request_simulation, LEVEL_DEBUG,
-			    "frame %u\n", super_frame_counter);
-			if(resul == -1)
+			    "End of file.\n");
+			break;
+		}
+		if(resul == 0)
+		{
+			// No conversion occured, we simply skip the line
+			if(fscanf(this->simu_file, "%*s") == EOF)
 			{
 				this->simu_eof = true;
-				LOG(this->log_request_simulation, LEVEL_DEBUG,
-				    "End of file.\n");
-				goto end;
 			}
+			continue;
+		}
+		if(this->parseEvent(this->simu_buffer, event))
+		{
+			this->timeline.push_back(event);
 		}
 	}
 
-end:
-	fflush(this->event_file);
+	if(this->simu_file && ferror(this->simu_file))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+bool FileSimulator::parseEvent(const char *line, simu_event_t &event) const
+{
+	uint8_t cr_type;
+
+	if(4 ==
+	   sscanf(line,
+	          "SF%hu CR st%hu cr=%u type=%" SCNu8,
+	          &event.sf_nr, &event.st_id, &event.cr_value, &cr_type))
+	{
+		event.kind = simu_event_t::cr;
+		event.cr_type = to_enum<ReturnAccessType>(cr_type);
+	}
+	else if(5 ==
+	        sscanf(line,
+	               "SF%hu LOGON st%hu rt=%hu rbdc=%hu vbdc=%hu",
+	               &event.sf_nr, &event.st_id,
+	               &event.rt, &event.rbdc, &event.vbdc))
+	{
+		event.kind = simu_event_t::logon;
+	}
+	else if(2 ==
+	        sscanf(line, "SF%hu LOGOFF st%hu", &event.sf_nr, &event.st_id))
+	{
+		event.kind = simu_event_t::logoff;
+	}
+	else
+	{
+		return false;
+	}
+
+	if(event.st_id <= BROADCAST_TAL_ID)
+	{
+		LOG(this->log_request_simulation, LEVEL_WARNING,
+		    "Simulated ST%u ignored, IDs smaller than %u "
+		    "reserved for emulated terminals\n",
+		    event.st_id, BROADCAST_TAL_ID);
+		return false;
+	}
+
 	return true;
 }
 
 
 bool FileSimulator::stopSimulation(void)
 {
-	fclose(this->simu_file);
-	this->simu_file = NULL;
+	if(this->simu_file)
+	{
+		fclose(this->simu_file);
+		this->simu_file = NULL;
+	}
+	this->timeline.clear();
+	this->timeline_pos = 0;
 	return true;
 }
@@ -38,6 +38,22 @@
 
 #include "RequestSimulator.h"
 
+#include <vector>
+
+
+/// A simulated event, the trace is parsed once in a timeline of them
+typedef struct
+{
+	time_sf_t sf_nr;      ///< The superframe the event happens in
+	tal_id_t st_id;       ///< The simulated terminal
+	enum { cr, logon, logoff } kind;
+	ReturnAccessType cr_type;
+	uint32_t cr_value;    ///< The request value, for cr events
+	rate_kbps_t rt;       ///< The CRA, for logon events
+	rate_kbps_t rbdc;     ///< The maximum RBDC, for logon events
+	vol_kb_t vbdc;        ///< The maximum VBDC, for logon events
+} simu_event_t;
+
 
 class FileSimulator: public RequestSimulator
 {
@@ -61,6 +77,34 @@ public:
 	 */ 
 	bool stopSimulation(void);
 
+private:
+	/**
+	 * @brief Read the trace lines in the timeline until the first event
+	 *        after a superframe or the end of the trace
+	 *
+	 * @param until_sf  The last superframe to read the events of
+	 * @return true on success, false otherwise
+	 */
+	bool readEvents(time_sf_t until_sf);
+
+	/**
+	 * @brief Parse a trace line
+	 *
+	 * @param line   The trace line
+	 * @param event  OUT: the event described by the line
+	 * @return true if the line describes an event to simulate
+	 */
+	bool parseEvent(const char *line, simu_event_t &event) const;
+
+	/// The simulated events, the whole trace for a file and the
+	/// pending events when streamed on stdin
+	std::vector<simu_event_t> timeline;
+
+	/// The next event to simulate in the timeline
+	std::size_t timeline_pos;
+
+	/// Whether the trace is read as the simulation goes
+	bool streamed;
 };
 
 #endif
@@ -0,0 +1,635 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file NccCheckpoint.cpp
+ * @brief Checkpoint the terminal states of the NCC for a standby NCC
+ * @author Viveris Technologies
+ */
+
+#include "NccCheckpoint.h"
+
+#include <opensand_output/Output.h>
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <endian.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <system_error>
+#include <unistd.h>
+
+
+/// The first bytes of a snapshot file
+static const unsigned char CHECKPOINT_MAGIC[4] = {'O', 'S', 'C', 'K'};
+/// The version of the encoding
+constexpr const uint8_t CHECKPOINT_VERSION = 1;
+/// The terminal uses SCPC
+constexpr const uint8_t STATE_FLAG_SCPC = 0x01;
+/// The terminal has a DAMA context, its request state follows
+constexpr const uint8_t STATE_FLAG_DAMA = 0x02;
+/// The size of a journal entry header: generation, superframe and counts
+constexpr const size_t JOURNAL_HEADER_LENGTH = 4 + 2 + 2 + 2;
+
+
+typedef std::vector<uint8_t> buffer_t;
+
+
+static void put8(buffer_t &buffer, uint8_t value)
+{
+	buffer.push_back(value);
+}
+
+static void put16(buffer_t &buffer, uint16_t value)
+{
+	value = htons(value);
+	const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+	buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+}
+
+static void put32(buffer_t &buffer, uint32_t value)
+{
+	value = htonl(value);
+	const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+	buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+}
+
+static void putDouble(buffer_t &buffer, double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	bits = htobe64(bits);
+	const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&bits);
+	buffer.insert(buffer.end(), bytes, bytes + sizeof(bits));
+}
+
+
+/**
+ * @brief Decode the fields of a buffer, a read past the end fails
+ *        and so do all the following ones
+ */
+class BufferReader
+{
+ public:
+	BufferReader(const uint8_t *data, size_t length):
+		data{data},
+		remaining{length},
+		valid{true}
+	{
+	};
+
+	uint8_t get8()
+	{
+		uint8_t value = 0;
+		this->get(&value, sizeof(value));
+		return value;
+	};
+
+	uint16_t get16()
+	{
+		uint16_t value = 0;
+		this->get(&value, sizeof(value));
+		return ntohs(value);
+	};
+
+	uint32_t get32()
+	{
+		uint32_t value = 0;
+		this->get(&value, sizeof(value));
+		return ntohl(value);
+	};
+
+	double getDouble()
+	{
+		uint64_t bits = 0;
+		double value;
+		this->get(&bits, sizeof(bits));
+		bits = be64toh(bits);
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	};
+
+	bool isValid() const { return this->valid; };
+	size_t getRemaining() const { return this->remaining; };
+	const uint8_t *getData() const { return this->data; };
+
+ private:
+	void get(void *value, size_t length)
+	{
+		if(!this->valid || this->remaining < length)
+		{
+			this->valid = false;
+			return;
+		}
+		memcpy(value, this->data, length);
+		this->data += length;
+		this->remaining -= length;
+	};
+
+	const uint8_t *data;
+	size_t remaining;
+	bool valid;
+};
+
+
+static void encodeState(buffer_t &buffer, const ncc_terminal_state_t &state)
+{
+	uint8_t flags = 0;
+	if(state.is_scpc)
+	{
+		flags |= STATE_FLAG_SCPC;
+	}
+	if(state.has_dama)
+	{
+		flags |= STATE_FLAG_DAMA;
+	}
+	put16(buffer, state.tal_id);
+	put8(buffer, flags);
+	put8(buffer, state.input_modcod_id);
+	put8(buffer, state.output_modcod_id);
+	if(!state.has_dama)
+	{
+		return;
+	}
+	put16(buffer, state.dama.cra_kbps);
+	put16(buffer, state.dama.max_rbdc_kbps);
+	put16(buffer, state.dama.max_vbdc_kb);
+	put16(buffer, state.dama.rbdc_request_kbps);
+	putDouble(buffer, state.dama.rbdc_credit);
+	put16(buffer, state.dama.rbdc_timer_sf);
+	put16(buffer, state.dama.vbdc_request_kb);
+}
+
+static bool decodeState(BufferReader &reader, ncc_terminal_state_t &state)
+{
+	state.tal_id = reader.get16();
+	uint8_t flags = reader.get8();
+	state.is_scpc = (flags & STATE_FLAG_SCPC) != 0;
+	state.has_dama = (flags & STATE_FLAG_DAMA) != 0;
+	state.input_modcod_id = reader.get8();
+	state.output_modcod_id = reader.get8();
+	state.dama = dama_terminal_state_t{};
+	if(state.has_dama)
+	{
+		state.dama.cra_kbps = reader.get16();
+		state.dama.max_rbdc_kbps = reader.get16();
+		state.dama.max_vbdc_kb = reader.get16();
+		state.dama.rbdc_request_kbps = reader.get16();
+		state.dama.rbdc_credit = reader.getDouble();
+		state.dama.rbdc_timer_sf = reader.get16();
+		state.dama.vbdc_request_kb = reader.get16();
+	}
+	return reader.isValid();
+}
+
+static bool isSameState(const ncc_terminal_state_t &state1,
+                        const ncc_terminal_state_t &state2)
+{
+	if(state1.tal_id != state2.tal_id ||
+	   state1.is_scpc != state2.is_scpc ||
+	   state1.input_modcod_id != state2.input_modcod_id ||
+	   state1.output_modcod_id != state2.output_modcod_id ||
+	   state1.has_dama != state2.has_dama)
+	{
+		return false;
+	}
+	return !state1.has_dama ||
+	       (state1.dama.cra_kbps == state2.dama.cra_kbps &&
+	        state1.dama.max_rbdc_kbps == state2.dama.max_rbdc_kbps &&
+	        state1.dama.max_vbdc_kb == state2.dama.max_vbdc_kb &&
+	        state1.dama.rbdc_request_kbps == state2.dama.rbdc_request_kbps &&
+	        state1.dama.rbdc_credit == state2.dama.rbdc_credit &&
+	        state1.dama.rbdc_timer_sf == state2.dama.rbdc_timer_sf &&
+	        state1.dama.vbdc_request_kb == state2.dama.vbdc_request_kb);
+}
+
+static bool writeAll(int fd, const buffer_t &buffer)
+{
+	size_t offset = 0;
+	while(offset < buffer.size())
+	{
+		ssize_t written = ::write(fd, buffer.data() + offset, buffer.size() - offset);
+		if(written < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return false;
+		}
+		offset += written;
+	}
+	return fdatasync(fd) == 0;
+}
+
+static bool readFile(const std::string &path, buffer_t &buffer)
+{
+	std::ifstream file(path, std::ios::binary);
+	if(!file)
+	{
+		return false;
+	}
+	buffer.assign(std::istreambuf_iterator<char>(file),
+	              std::istreambuf_iterator<char>());
+	return !file.bad();
+}
+
+
+NccCheckpoint::NccCheckpoint(const std::string &path, time_sf_t period_sf):
+	path{path},
+	journal_path{path + ".journal"},
+	period_sf{period_sf},
+	restored{},
+	pending{},
+	pending_sf{0},
+	has_pending{false},
+	stopping{false},
+	pending_lock{},
+	pending_cond{},
+	writer{},
+	writing{},
+	written{},
+	generation{0},
+	has_snapshot{false},
+	journal_fd{-1},
+	snapshot_size{0},
+	journal_size{0}
+{
+	this->log_checkpoint = Output::Get()->registerLog(LEVEL_WARNING, "Dvb.Checkpoint");
+}
+
+
+NccCheckpoint::~NccCheckpoint()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->pending_lock);
+		this->stopping = true;
+	}
+	this->pending_cond.notify_one();
+	if(this->writer.joinable())
+	{
+		this->writer.join();
+	}
+	if(this->journal_fd >= 0)
+	{
+		close(this->journal_fd);
+	}
+}
+
+
+bool NccCheckpoint::init()
+{
+	if(this->read())
+	{
+		LOG(this->log_checkpoint, LEVEL_NOTICE,
+		    "%zu terminals restored from the checkpoint %s\n",
+		    this->restored.size(), this->path.c_str());
+	}
+
+	// the previous journal is kept until a new snapshot replaces it
+	this->journal_fd = open(this->journal_path.c_str(),
+	                        O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if(this->journal_fd < 0)
+	{
+		LOG(this->log_checkpoint, LEVEL_ERROR,
+		    "cannot open the checkpoint journal %s: %s\n",
+		    this->journal_path.c_str(), strerror(errno));
+		return false;
+	}
+
+	try
+	{
+		this->writer = std::thread(&NccCheckpoint::run, this);
+	}
+	catch(const std::system_error &error)
+	{
+		LOG(this->log_checkpoint, LEVEL_ERROR,
+		    "cannot start the checkpoint writer: %s\n", error.what());
+		return false;
+	}
+
+	LOG(this->log_checkpoint, LEVEL_NOTICE,
+	    "terminal states checkpointed in %s every %u superframes\n",
+	    this->path.c_str(), this->period_sf);
+	return true;
+}
+
+
+const std::vector<ncc_terminal_state_t> &NccCheckpoint::getRestoredTerminals() const
+{
+	return this->restored;
+}
+
+
+bool NccCheckpoint::isDue(time_sf_t superframe_sf) const
+{
+	return this->period_sf != 0 && superframe_sf % this->period_sf == 0;
+}
+
+
+void NccCheckpoint::push(std::vector<ncc_terminal_state_t> &states, time_sf_t superframe_sf)
+{
+	{
+		std::lock_guard<std::mutex> lock(this->pending_lock);
+		this->pending.swap(states);
+		this->pending_sf = superframe_sf;
+		this->has_pending = true;
+	}
+	this->pending_cond.notify_one();
+}
+
+
+void NccCheckpoint::run()
+{
+	std::unique_lock<std::mutex> lock(this->pending_lock);
+	while(true)
+	{
+		this->pending_cond.wait(lock, [this]{ return this->has_pending || this->stopping; });
+		if(!this->has_pending)
+		{
+			// stopping, the last states were written
+			break;
+		}
+		this->writing.swap(this->pending);
+		time_sf_t superframe_sf = this->pending_sf;
+		this->has_pending = false;
+		lock.unlock();
+
+		if(!this->write(this->writing, superframe_sf))
+		{
+			LOG(this->log_checkpoint, LEVEL_WARNING,
+			    "SF#%u: terminal states not checkpointed\n", superframe_sf);
+		}
+
+		lock.lock();
+	}
+}
+
+
+bool NccCheckpoint::write(const std::vector<ncc_terminal_state_t> &states,
+                          time_sf_t superframe_sf)
+{
+	if(!this->has_snapshot)
+	{
+		return this->writeSnapshot(states);
+	}
+
+	// both lists are sorted by terminal ID
+	buffer_t records;
+	std::vector<tal_id_t> removed;
+	uint16_t updated = 0;
+	auto previous = this->written.begin();
+	for(auto &&state: states)
+	{
+		while(previous != this->written.end() && previous->tal_id < state.tal_id)
+		{
+			removed.push_back(previous->tal_id);
+			++previous;
+		}
+		if(previous != this->written.end() && previous->tal_id == state.tal_id)
+		{
+			bool same = isSameState(*previous, state);
+			++previous;
+			if(same)
+			{
+				continue;
+			}
+		}
+		encodeState(records, state);
+		++updated;
+	}
+	for(; previous != this->written.end(); ++previous)
+	{
+		removed.push_back(previous->tal_id);
+	}
+
+	if(updated == 0 && removed.empty())
+	{
+		return true;
+	}
+	for(auto &&tal_id: removed)
+	{
+		put16(records, tal_id);
+	}
+
+	buffer_t entry;
+	put32(entry, JOURNAL_HEADER_LENGTH + records.size());
+	put32(entry, this->generation);
+	put16(entry, superframe_sf);
+	put16(entry, updated);
+	put16(entry, removed.size());
+	entry.insert(entry.end(), records.begin(), records.end());
+
+	// the snapshot is written again once it is cheaper than the journal
+	if(this->journal_size + entry.size() > this->snapshot_size)
+	{
+		return this->writeSnapshot(states);
+	}
+
+	if(!writeAll(this->journal_fd, entry))
+	{
+		LOG(this->log_checkpoint, LEVEL_ERROR,
+		    "cannot write the checkpoint journal %s: %s\n",
+		    this->journal_path.c_str(), strerror(errno));
+		// a partial entry is dropped on read, start again from a snapshot
+		this->has_snapshot = false;
+		return false;
+	}
+	this->journal_size += entry.size();
+	this->written = states;
+
+	LOG(this->log_checkpoint, LEVEL_DEBUG,
+	    "SF#%u: %u terminal states updated and %zu removed in the journal\n",
+	    superframe_sf, updated, removed.size());
+	return true;
+}
+
+
+bool NccCheckpoint::writeSnapshot(const std::vector<ncc_terminal_state_t> &states)
+{
+	buffer_t snapshot;
+	uint32_t generation = this->generation + 1;
+	snapshot.insert(snapshot.end(), std::begin(CHECKPOINT_MAGIC), std::end(CHECKPOINT_MAGIC));
+	put8(snapshot, CHECKPOINT_VERSION);
+	put32(snapshot, generation);
+	put16(snapshot, states.size());
+	for(auto &&state: states)
+	{
+		encodeState(snapshot, state);
+	}
+
+	// a snapshot is never left half written, the old one stays until
+	// the new one is complete
+	std::string tmp_path = this->path + ".tmp";
+	int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if(fd < 0)
+	{
+		LOG(this->log_checkpoint, LEVEL_ERROR,
+		    "cannot create the checkpoint %s: %s\n",
+		    tmp_path.c_str(), strerror(errno));
+		return false;
+	}
+	bool status = writeAll(fd, snapshot);
+	close(fd);
+	if(!status || rename(tmp_path.c_str(), this->path.c_str()) != 0)
+	{
+		LOG(this->log_checkpoint, LEVEL_ERROR,
+		    "cannot write the checkpoint %s: %s\n",
+		    this->path.c_str(), strerror(errno));
+		unlink(tmp_path.c_str());
+		return false;
+	}
+
+	// the journal entries of the previous generation are ignored
+	// on read if the journal cannot be emptied
+	this->generation = generation;
+	this->has_snapshot = true;
+	this->snapshot_size = snapshot.size();
+	this->written = states;
+	if(ftruncate(this->journal_fd, 0) != 0)
+	{
+		LOG(this->log_checkpoint, LEVEL_WARNING,
+		    "cannot empty the checkpoint journal %s: %s\n",
+		    this->journal_path.c_str(), strerror(errno));
+	}
+	this->journal_size = 0;
+
+	LOG(this->log_checkpoint, LEVEL_DEBUG,
+	    "checkpoint generation %u written with %zu terminals\n",
+	    generation, states.size());
+	return true;
+}
+
+
+bool NccCheckpoint::read()
+{
+	buffer_t snapshot;
+	if(!readFile(this->path, snapshot))
+	{
+		LOG(this->log_checkpoint, LEVEL_INFO,
+		    "no checkpoint to restore in %s\n", this->path.c_str());
+		return false;
+	}
+
+	BufferReader reader(snapshot.data(), snapshot.size());
+	unsigned char magic[sizeof(CHECKPOINT_MAGIC)];
+	for(auto &&byte: magic)
+	{
+		byte = reader.get8();
+	}
+	uint8_t version = reader.get8();
+	uint32_t generation = reader.get32();
+	uint16_t count = reader.get16();
+	if(!reader.isValid() ||
+	   memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0 ||
+	   version != CHECKPOINT_VERSION)
+	{
+		LOG(this->log_checkpoint, LEVEL_WARNING,
+		    "%s is not a checkpoint of this version, ignore it\n",
+		    this->path.c_str());
+		return false;
+	}
+
+	std::map<tal_id_t, ncc_terminal_state_t> states;
+	for(uint16_t index = 0; index < count; ++index)
+	{
+		ncc_terminal_state_t state;
+		if(!decodeState(reader, state))
+		{
+			LOG(this->log_checkpoint, LEVEL_WARNING,
+			    "checkpoint %s is truncated, ignore it\n",
+			    this->path.c_str());
+			return false;
+		}
+		states[state.tal_id] = state;
+	}
+
+	// the entries of the journal are applied in order, a truncated
+	// entry is the end of an interrupted write
+	buffer_t journal;
+	unsigned int entries = 0;
+	if(readFile(this->journal_path, journal))
+	{
+		BufferReader journal_reader(journal.data(), journal.size());
+		while(journal_reader.getRemaining() > 0)
+		{
+			uint32_t length = journal_reader.get32();
+			if(!journal_reader.isValid() ||
+			   length < JOURNAL_HEADER_LENGTH ||
+			   length > journal_reader.getRemaining())
+			{
+				LOG(this->log_checkpoint, LEVEL_WARNING,
+				    "checkpoint journal %s is truncated after %u entries\n",
+				    this->journal_path.c_str(), entries);
+				break;
+			}
+			BufferReader entry(journal_reader.getData(), length);
+			journal_reader = BufferReader(journal_reader.getData() + length,
+			                              journal_reader.getRemaining() - length);
+			if(entry.get32() != generation)
+			{
+				continue;
+			}
+			entry.get16();
+			uint16_t updated = entry.get16();
+			uint16_t removed = entry.get16();
+			for(uint16_t index = 0; index < updated; ++index)
+			{
+				ncc_terminal_state_t state;
+				if(decodeState(entry, state))
+				{
+					states[state.tal_id] = state;
+				}
+			}
+			for(uint16_t index = 0; index < removed; ++index)
+			{
+				tal_id_t tal_id = entry.get16();
+				if(entry.isValid())
+				{
+					states.erase(tal_id);
+				}
+			}
+			++entries;
+		}
+	}
+
+	this->generation = generation;
+	this->restored.clear();
+	for(auto &&state: states)
+	{
+		this->restored.push_back(state.second);
+	}
+	LOG(this->log_checkpoint, LEVEL_INFO,
+	    "checkpoint generation %u read with %u journal entries\n",
+	    generation, entries);
+	return true;
+}
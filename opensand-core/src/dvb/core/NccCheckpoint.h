@@ -0,0 +1,213 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file NccCheckpoint.h
+ * @brief Checkpoint the terminal states of the NCC for a standby NCC
+ * @author Viveris Technologies
+ */
+
+#ifndef NCC_CHECKPOINT_H
+#define NCC_CHECKPOINT_H
+
+#include "OpenSandCore.h"
+#include "TerminalContextDama.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+class OutputLog;
+
+
+/**
+ * @brief The state of a logged terminal kept by the NCC
+ */
+struct ncc_terminal_state_t
+{
+	/// The terminal ID
+	tal_id_t tal_id;
+	/// Whether the terminal uses SCPC on the return link
+	bool is_scpc;
+	/// The current return link MODCOD ID, 0 if unknown
+	fmt_id_t input_modcod_id;
+	/// The current forward link MODCOD ID, 0 if unknown
+	fmt_id_t output_modcod_id;
+	/// Whether the terminal has a DAMA context
+	bool has_dama;
+	/// The DAMA request state, if the terminal has a DAMA context
+	dama_terminal_state_t dama;
+};
+
+
+/**
+ * @class NccCheckpoint
+ * @brief Periodic checkpoints of the terminal states of the NCC
+ *
+ * The checkpoint is a snapshot file followed by a journal of the
+ * terminals whose state changed since the snapshot, so each period
+ * only writes what changed. The snapshot is rewritten (written aside
+ * then renamed) once the journal grows bigger than it.
+ *
+ * The states are captured on the superframe tick into a buffer that is
+ * swapped with the one of the writer thread, the encoding, the diff and
+ * the file writes never delay the tick. A standby NCC started on the same
+ * file logs the checkpointed terminals on again at its initialisation,
+ * so they keep their requests without going through the logon again.
+ */
+class NccCheckpoint
+{
+ public:
+	/**
+	 * @brief Create a checkpoint
+	 *
+	 * @param path       The checkpoint file, the journal is next to it
+	 * @param period_sf  The number of superframes between two checkpoints
+	 */
+	NccCheckpoint(const std::string &path, time_sf_t period_sf);
+
+	/**
+	 * @brief Stop the writer thread once the last states are written
+	 */
+	~NccCheckpoint();
+
+	/**
+	 * @brief Read the terminal states left by a previous NCC, if any,
+	 *        and start the writer thread
+	 *
+	 * @return true on success, false if the writer cannot be started;
+	 *         a missing or corrupted checkpoint is not an error
+	 */
+	bool init();
+
+	/**
+	 * @brief Get the terminal states read at initialisation
+	 *
+	 * @return the terminal states, sorted by terminal ID
+	 */
+	const std::vector<ncc_terminal_state_t> &getRestoredTerminals() const;
+
+	/**
+	 * @brief Whether the terminal states shall be checkpointed
+	 *        on a superframe
+	 *
+	 * @param superframe_sf  The superframe number
+	 * @return true if a checkpoint is due
+	 */
+	bool isDue(time_sf_t superframe_sf) const;
+
+	/**
+	 * @brief Hand the terminal states over to the writer thread
+	 *
+	 * The buffers are swapped, so the storage of the states given on a
+	 * previous call is reused; states not written yet are replaced
+	 *
+	 * @param states         IN: the terminal states sorted by terminal ID,
+	 *                       OUT: a buffer to fill with the next states
+	 * @param superframe_sf  The superframe of the states
+	 */
+	void push(std::vector<ncc_terminal_state_t> &states, time_sf_t superframe_sf);
+
+ private:
+	/// The writer thread loop
+	void run();
+
+	/**
+	 * @brief Write the changes since the last written states
+	 *
+	 * @param states         The terminal states
+	 * @param superframe_sf  The superframe of the states
+	 * @return true on success, false otherwise
+	 */
+	bool write(const std::vector<ncc_terminal_state_t> &states, time_sf_t superframe_sf);
+
+	/**
+	 * @brief Write a new snapshot and empty the journal
+	 *
+	 * @param states  The terminal states
+	 * @return true on success, false otherwise
+	 */
+	bool writeSnapshot(const std::vector<ncc_terminal_state_t> &states);
+
+	/**
+	 * @brief Read the snapshot and apply the journal on it
+	 *
+	 * @return true if a checkpoint was read, false otherwise
+	 */
+	bool read();
+
+	/// The snapshot file
+	std::string path;
+	/// The journal file
+	std::string journal_path;
+	/// The number of superframes between two checkpoints
+	time_sf_t period_sf;
+
+	/// The terminal states read at initialisation
+	std::vector<ncc_terminal_state_t> restored;
+
+	/// The states captured on the last tick, not written yet
+	std::vector<ncc_terminal_state_t> pending;
+	/// The superframe of the pending states
+	time_sf_t pending_sf;
+	/// Whether there are pending states
+	bool has_pending;
+	/// Whether the writer thread shall stop
+	bool stopping;
+	/// Protect the pending states
+	std::mutex pending_lock;
+	/// Wake up the writer thread
+	std::condition_variable pending_cond;
+	/// The writer thread
+	std::thread writer;
+
+	/// The states being written, owned by the writer thread
+	std::vector<ncc_terminal_state_t> writing;
+	/// The last written states, owned by the writer thread
+	std::vector<ncc_terminal_state_t> written;
+	/// The generation of the snapshot, the journal entries carry it
+	uint32_t generation;
+	/// Whether the states were written once since the initialisation
+	bool has_snapshot;
+	/// The journal file descriptor
+	int journal_fd;
+	/// The snapshot size
+	size_t snapshot_size;
+	/// The journal size
+	size_t journal_size;
+
+	/// The checkpoint log
+	std::shared_ptr<OutputLog> log_checkpoint;
+};
+
+
+#endif
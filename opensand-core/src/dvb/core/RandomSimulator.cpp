@@ -34,6 +34,7 @@
  */
 
 #include "RandomSimulator.h"
+#include "OpenSandModelConf.h"
 
 #include <errno.h>
 
@@ -64,7 +65,12 @@ RandomSimulator::RandomSimulator(spot_id_t spot_id,
 	    this->simu_st, this->simu_rt, this->simu_max_rbdc,
 	    this->simu_max_vbdc, this->simu_cr,
 	    this->simu_interval);
-	srandom(times(NULL));
+	unsigned int seed;
+	if(!OpenSandModelConf::Get()->getRandomSeed(seed))
+	{
+		seed = times(NULL);
+	}
+	srandom(seed);
 }
 
 RandomSimulator::~RandomSimulator()
@@ -99,7 +105,6 @@ bool RandomSimulator::simulation(std::list<DvbFrame *>* msgs,
 	for(i = 0; i < this->simu_st; i++)
 	{
 		uint32_t val;
-		Sac *sac = new Sac(sim_tal_id + i);
 
 		if(this->simu_interval)
 		{
@@ -110,9 +115,11 @@ bool RandomSimulator::simulation(std::list<DvbFrame *>* msgs,
 	    {
 			val = this->simu_cr;
 	    }
-		sac->addRequest(0, ReturnAccessType::dama_rbdc, val);
-		sac->setAcm(0xffff);
-		msgs->push_back((DvbFrame*)sac);
+		if(!this->addRequest(msgs, sim_tal_id + i,
+		                     ReturnAccessType::dama_rbdc, val))
+		{
+			return false;
+		}
 	}
 
 	return true;
@@ -35,6 +35,7 @@
 
 #include "RequestSimulator.h"
 #include "OpenSandModelConf.h"
+#include "DamaCtrl.h"
 
 #include <opensand_output/Output.h>
 #include <errno.h>
@@ -45,6 +46,7 @@ RequestSimulator::RequestSimulator(spot_id_t spot_id,
                                    FILE** evt_file):
 	spot_id(spot_id),
 	mac_id(mac_id),
+	dama_ctrl(NULL),
 	dvb_fifos(),
 	event_file(NULL),
 	simu_file(NULL),
@@ -108,6 +110,30 @@ void RequestSimulator::generateConfiguration()
 	                   "Leave empty to not generate anything.");
 }
 
+void RequestSimulator::setDirectInjection(DamaCtrl *dama_ctrl)
+{
+	this->dama_ctrl = dama_ctrl;
+}
+
+bool RequestSimulator::addRequest(std::list<DvbFrame *>* msgs,
+                                  tal_id_t st_id,
+                                  ReturnAccessType type,
+                                  uint32_t value)
+{
+	// a request following a logon or a logoff of the same superframe
+	// is queued with it so they are handled in order
+	if(this->dama_ctrl && msgs->empty())
+	{
+		return this->dama_ctrl->hereIsRequest(st_id, type, value);
+	}
+
+	Sac *sac = new Sac(st_id);
+	sac->addRequest(0, type, value);
+	sac->setAcm(0xffff);
+	msgs->push_back((DvbFrame*)sac);
+	return true;
+}
+
 bool RequestSimulator::initRequestSimulation()
 {
 	memset(this->simu_buffer, '\0', SIMU_BUFF_LEN);
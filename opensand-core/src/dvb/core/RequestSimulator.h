@@ -46,6 +46,7 @@
 
 
 class OutputLog;
+class DamaCtrl;
 
 enum Simulate
 {
@@ -74,6 +75,16 @@ public:
 	
 	virtual bool stopSimulation(void) = 0;
 
+	/**
+	 * @brief Inject the simulated capacity requests straight in the DAMA
+	 *        controller instead of building SAC frames for them, the
+	 *        logons and logoffs are still returned as frames and the
+	 *        requests following them in a superframe too
+	 *
+	 * @param dama_ctrl  The DAMA controller, NULL to build SAC frames
+	 */
+	void setDirectInjection(DamaCtrl *dama_ctrl);
+
 	// statistics update
 	void updateStatistics(void);
 
@@ -84,12 +95,30 @@ protected:
 	 */
 	bool initRequestSimulation();
 
+	/**
+	 * @brief Emit a simulated capacity request, either in a SAC frame
+	 *        or directly in the DAMA controller
+	 *
+	 * @param msgs    The simulated frames
+	 * @param st_id   The simulated terminal
+	 * @param type    The request type
+	 * @param value   The request value
+	 * @return true on success, false otherwise
+	 */
+	bool addRequest(std::list<DvbFrame *>* msgs,
+	                tal_id_t st_id,
+	                ReturnAccessType type,
+	                uint32_t value);
+
 	/// spot id
 	uint8_t spot_id;
 	
 	// gw tal id
 	uint8_t mac_id;
 
+	/// The DAMA controller the requests are injected in, if any
+	DamaCtrl *dama_ctrl;
+
 	/* Fifos */
 	/// map of FIFOs per MAX priority to manage different queues
 	fifos_t dvb_fifos;
@@ -47,10 +47,29 @@
 #include "OpenSandModelConf.h"
 #include "FifoElement.h"
 
+#include <algorithm>
+#include <cstring>
 #include <errno.h>
+#include <set>
+#include <sys/inotify.h>
+#include <unistd.h>
 #include <opensand_output/OutputEvent.h>
 
 
+/**
+ * @brief Whether two carriers of a band plan are the same
+ */
+static bool sameCarrier(const OpenSandModelConf::carrier &carrier,
+                        const OpenSandModelConf::carrier &other)
+{
+	return carrier.access_type == other.access_type &&
+	       carrier.category == other.category &&
+	       carrier.symbol_rate == other.symbol_rate &&
+	       carrier.format_ratios == other.format_ratios &&
+	       carrier.bandwidth_khz == other.bandwidth_khz;
+}
+
+
 SpotDownward::SpotDownward(spot_id_t spot_id,
                            tal_id_t mac_id,
                            time_ms_t fwd_down_frame_duration,
@@ -81,15 +100,36 @@ SpotDownward::SpotDownward(spot_id_t spot_id,
 	ret_fmt_groups(),
 	cni(100),
 	pep_cmd_apply_timer(),
+	dama_look_ahead_sf(0),
 	request_simu(NULL),
 	event_file(NULL),
 	simulate(none_simu),
+	simulate_direct_injection(false),
+	probes_gw_fifos(),
+	fifo_probes(),
 	probe_gw_l2_to_sat_total(),
 	l2_to_sat_total_bytes(),
 	probe_frame_interval(NULL),
 	probe_sent_modcod(NULL),
 	log_request_simulation(NULL),
-	event_logon_resp(NULL)
+	event_logon_resp(NULL),
+	pending_logons(),
+	pending_logon_ids(),
+	max_logons_per_sf(0),
+	admitted_logons(0),
+	probe_logon_queue(NULL),
+	probe_logons_admitted(NULL),
+	topology_file(),
+	return_plan(),
+	pending_band(),
+	reconfiguration_running(false),
+	reconfiguration_requested(false),
+	reconfiguration_lock(),
+	reconfiguration_thread(),
+	checkpoint(nullptr),
+	checkpoint_states(),
+	checkpoint_input_modcods(),
+	checkpoint_output_modcods()
 {
 	this->fwd_down_frame_duration_ms = fwd_down_frame_duration;
 	this->ret_up_frame_duration_ms = ret_up_frame_duration;
@@ -106,8 +146,20 @@ SpotDownward::SpotDownward(spot_id_t spot_id,
 
 SpotDownward::~SpotDownward()
 {
+	// the band being built is released with the pending one
+	if(this->reconfiguration_thread.joinable())
+	{
+		this->reconfiguration_thread.join();
+	}
+	this->pending_band.reset();
+
 	this->categories.clear();
 
+	for(auto &&dvb_frame : this->pending_logons)
+	{
+		delete dvb_frame;
+	}
+
 	delete this->dama_ctrl;
 
 	for (auto& it : this->scheduling)
@@ -154,7 +206,8 @@ void SpotDownward::generateConfiguration(std::shared_ptr<OpenSANDConf::MetaParam
 	auto types = Conf->getModelTypesDefinition();
 	types->addEnumType("ncc_simulation", "Simulated Requests", {"None", "Random", "File"});
 	types->addEnumType("gw_fifo_access_type", "Access Type", {"ACM", "VCM0", "VCM1", "VCM2", "VCM3"});
-	types->addEnumType("dama_algorithm", "DAMA Algorithm", {"Legacy",});
+	types->addEnumType("fifo_aqm", "Active Queue Management", {"None", "CoDel", "PIE"});
+	types->addEnumType("dama_algorithm", "DAMA Algorithm", {"Legacy", "Weighted Fair Share"});
 
 	auto conf = Conf->getOrCreateComponent("network", "Network", "The DVB layer configuration");
 	auto fifos = conf->addList("gw_fifos", "FIFOs to send messages to Terminals", "gw_fifo")->getPattern();
@@ -162,6 +215,13 @@ void SpotDownward::generateConfiguration(std::shared_ptr<OpenSANDConf::MetaParam
 	fifos->addParameter("name", "Name", types->getType("string"));
 	fifos->addParameter("capacity", "Capacity", types->getType("int"))->setUnit("packets");
 	fifos->addParameter("access_type", "Access Type", types->getType("gw_fifo_access_type"));
+	fifos->addParameter("aqm", "Active Queue Management", types->getType("fifo_aqm"));
+	fifos->addParameter("aqm_target", "AQM Target Delay", types->getType("int"),
+	                    "The target sojourn time in the FIFO, 0 for the algorithm default")->setUnit("ms");
+	fifos->addParameter("aqm_interval", "AQM Interval", types->getType("int"),
+	                    "CoDel: the window the sojourn time must stay above the target in, "
+	                    "about the round trip time; PIE: the drop probability update period; "
+	                    "0 for the algorithm default")->setUnit("ms");
 	auto simulation = conf->addParameter("simulation",
 	                                     "Simulated Requests",
 	                                     types->getType("ncc_simulation"),
@@ -172,6 +232,13 @@ void SpotDownward::generateConfiguration(std::shared_ptr<OpenSANDConf::MetaParam
 	                                    types->getType("string"),
 	                                    "Path to a file containing requests traces; or stdin");
 	Conf->setProfileReference(parameter, simulation, "File");
+	parameter = conf->addParameter("simulation_direct_injection",
+	                               "Direct Requests Injection",
+	                               types->getType("bool"),
+	                               "Give the simulated requests straight to the DAMA "
+	                               "controller instead of building SAC frames for them, "
+	                               "for simulations of a large number of terminals");
+	Conf->setProfileReference(parameter, disable_ctrl_plane, false);
 
 	parameter = conf->addParameter("simulation_nb_station",
 	                               "Simulated Station ID",
@@ -206,8 +273,33 @@ void SpotDownward::generateConfiguration(std::shared_ptr<OpenSANDConf::MetaParam
 
 	auto fca = conf->addParameter("fca", "FCA", types->getType("int"));
 	Conf->setProfileReference(fca, disable_ctrl_plane, false);
-	auto dama_algo = conf->addParameter("dama_algorithm", "DAMA Algorithm", types->getType("dama_algorithm"));
+	auto dama_algo = conf->addParameter("dama_algorithm", "DAMA Algorithm", types->getType("dama_algorithm"),
+	                                    "Legacy reduces the RBDC requests in proportion on congestion, "
+	                                    "Weighted Fair Share shares the capacity in max-min fair share "
+	                                    "weighted by the terminals maximal RBDC");
 	Conf->setProfileReference(dama_algo, disable_ctrl_plane, false);
+	auto logons = conf->addParameter("logons_per_superframe", "Logons per Superframe", types->getType("int"),
+	                                 "Logon requests admitted at most per superframe, the other ones "
+	                                 "wait in their arrival order; 0 for no limit");
+	logons->setAdvanced(true);
+	Conf->setProfileReference(logons, disable_ctrl_plane, false);
+	auto sparse_ttp = conf->addParameter("sparse_ttp", "Sparse TTP", types->getType("bool"),
+	                                     "Only send the Time Plans of the terminals with an "
+	                                     "allocation in the TTPs, indexed by terminal, for "
+	                                     "the large populations of mostly idle terminals");
+	sparse_ttp->setAdvanced(true);
+	Conf->setProfileReference(sparse_ttp, disable_ctrl_plane, false);
+	auto checkpoint_file = conf->addParameter("checkpoint_file", "Checkpoint File", types->getType("string"),
+	                                          "File where the NCC checkpoints the logged terminals and "
+	                                          "their requests, restored by the next NCC started on it; "
+	                                          "empty to disable");
+	checkpoint_file->setAdvanced(true);
+	Conf->setProfileReference(checkpoint_file, disable_ctrl_plane, false);
+	auto checkpoint_period = conf->addParameter("checkpoint_period", "Checkpoint Period", types->getType("int"),
+	                                            "Superframes between two checkpoints");
+	checkpoint_period->setUnit("superframes");
+	checkpoint_period->setAdvanced(true);
+	Conf->setProfileReference(checkpoint_period, disable_ctrl_plane, false);
 }
 
 
@@ -264,6 +356,15 @@ bool SpotDownward::onInit(void)
 
 	this->initStatsTimer(this->fwd_down_frame_duration_ms);
 
+	// the parameter is optional, the logons are not limited by default
+	int max_logons = 0;
+	auto network = OpenSandModelConf::Get()->getProfileData()->getComponent("network");
+	OpenSandModelConf::extractParameterData(network->getParameter("logons_per_superframe"), max_logons);
+	this->max_logons_per_sf = std::max(max_logons, 0);
+	LOG(this->log_init_channel, LEVEL_NOTICE,
+	    "logons admitted per superframe: %u (0 for no limit)\n",
+	    this->max_logons_per_sf);
+
 	if(!this->initRequestSimulation())
 	{
 		LOG(this->log_init_channel, LEVEL_ERROR,
@@ -296,10 +397,13 @@ bool SpotDownward::onInit(void)
 
 bool SpotDownward::initMode(void)
 {
+	auto Conf = OpenSandModelConf::Get();
+	bool parallel_vcm = false;
+
 	// initialize scheduling
 	// depending on the satellite type
 	OpenSandModelConf::spot current_spot;
-	if (!OpenSandModelConf::Get()->getSpotForwardCarriers(this->spot_id, current_spot))
+	if (!Conf->getSpotForwardCarriers(this->spot_id, current_spot))
 	{
 		LOG(this->log_init_channel, LEVEL_ERROR,
 		    "there is no gateways with value: "
@@ -322,6 +426,13 @@ bool SpotDownward::initMode(void)
 	}
 
 
+	if(!Conf->getParallelVcm(parallel_vcm))
+	{
+		LOG(this->log_init_channel, LEVEL_ERROR,
+		    "cannot get whether the VCM carriers are scheduled in parallel\n");
+		return false;
+	}
+
 	// check that there is at least DVB fifos for VCM carriers
 	for (auto&& cat_it: this->categories)
 	{
@@ -391,7 +502,8 @@ bool SpotDownward::initMode(void)
 		                                    this->output_sts,
 		                                    this->s2_modcod_def,
 		                                    cat, this->spot_id,
-		                                    true, this->mac_id, "");
+		                                    true, this->mac_id, "",
+		                                    parallel_vcm);
 		if(!schedule)
 		{
 			LOG(this->log_init_channel, LEVEL_ERROR,
@@ -414,6 +526,9 @@ bool SpotDownward::initDama(void)
 	time_sf_t rbdc_timeout_sf;
 	rate_kbps_t fca_kbps;
 	std::string dama_algo;
+	unsigned int dama_workers = 0;
+	unsigned int dama_look_ahead = 0;
+	bool sparse_ttp = false;
 
 	TerminalCategories<TerminalCategoryDama> dc_categories;
 	TerminalMapping<TerminalCategoryDama> dc_terminal_affectation;
@@ -485,6 +600,21 @@ bool SpotDownward::initDama(void)
 	}
 
 
+	// keep the plan the return band was built from, to compare it
+	// with the topology updates
+	this->return_plan.carriers = current_spot;
+	{
+		spot_id_t default_spot_id;
+		if(!Conf->getTerminalAffectation(default_spot_id,
+		                                 this->return_plan.default_category,
+		                                 this->return_plan.terminal_categories))
+		{
+			LOG(this->log_init_channel, LEVEL_ERROR,
+			    "Terminals categories initialisation failed\n");
+			return false;
+		}
+	}
+
 	// check if there is DAMA carriers
 	if(dc_categories.size() == 0)
 	{
@@ -510,12 +640,25 @@ bool SpotDownward::initDama(void)
 		return false;
 	}
 
+	if(!Conf->getDamaWorkers(dama_workers))
+	{
+		LOG(this->log_init_channel, LEVEL_ERROR,
+		    "Invalid number of DAMA workers\n");
+		return false;
+	}
+
 	/* select the specified DAMA algorithm */
 	if(dama_algo == "Legacy")
 	{
 		LOG(this->log_init_channel, LEVEL_NOTICE,
 		    "creating Legacy DAMA controller\n");
-		this->dama_ctrl = new DamaCtrlRcs2Legacy(this->spot_id);
+		this->dama_ctrl = new DamaCtrlRcs2Legacy(this->spot_id, dama_workers);
+	}
+	else if(dama_algo == "Weighted Fair Share")
+	{
+		LOG(this->log_init_channel, LEVEL_NOTICE,
+		    "creating Legacy DAMA controller with weighted fair share\n");
+		this->dama_ctrl = new DamaCtrlRcs2Legacy(this->spot_id, dama_workers, true);
 	}
 	else
 	{
@@ -558,6 +701,37 @@ bool SpotDownward::initDama(void)
 	}
 	this->dama_ctrl->setRecordFile(this->event_file);
 
+	if(!Conf->getDamaLookAhead(dama_look_ahead))
+	{
+		LOG(this->log_init_channel, LEVEL_ERROR,
+		    "Invalid DAMA look-ahead\n");
+		goto release_dama;
+	}
+	if(dama_look_ahead > 0)
+	{
+		LOG(this->log_init_channel, LEVEL_NOTICE,
+		    "DAMA allocations computed %u superframes ahead\n",
+		    dama_look_ahead);
+	}
+	this->dama_ctrl->setLookAhead(dama_look_ahead);
+	this->dama_look_ahead_sf = dama_look_ahead;
+
+	// the parameter is optional, the TTPs have all the terminals by default
+	OpenSandModelConf::extractParameterData(ncc->getParameter("sparse_ttp"), sparse_ttp);
+	if(sparse_ttp)
+	{
+		LOG(this->log_init_channel, LEVEL_NOTICE,
+		    "sparse TTPs, without the terminals that have no allocation\n");
+	}
+	this->dama_ctrl->setSparseTtp(sparse_ttp);
+
+	if(this->request_simu && this->simulate_direct_injection)
+	{
+		LOG(this->log_init_channel, LEVEL_NOTICE,
+		    "simulated requests injected in the DAMA controller\n");
+		this->request_simu->setDirectInjection(this->dama_ctrl);
+	}
+
 	return true;
 
 release_dama:
@@ -674,6 +848,22 @@ bool SpotDownward::initFifo(fifos_t &fifos)
 
 		DvbFifo *fifo = new DvbFifo(fifo_priority, fifo_name, fifo_access_type, fifo_size);
 
+		std::string fifo_aqm = "None";
+		int aqm_target = 0;
+		int aqm_interval = 0;
+		OpenSandModelConf::extractParameterData(fifo_item->getParameter("aqm"), fifo_aqm);
+		OpenSandModelConf::extractParameterData(fifo_item->getParameter("aqm_target"), aqm_target);
+		OpenSandModelConf::extractParameterData(fifo_item->getParameter("aqm_interval"), aqm_interval);
+		if(aqm_target < 0 || aqm_interval < 0 ||
+		   !fifo->setAqm(fifo_aqm, aqm_target, aqm_interval))
+		{
+			LOG(this->log_init_channel, LEVEL_ERROR,
+			    "wrong active queue management for fifo %s\n",
+			    fifo_name.c_str());
+			delete fifo;
+			goto err_fifo_release;
+		}
+
 		LOG(this->log_init_channel, LEVEL_NOTICE,
 		    "Fifo priority = %u, FIFO name %s, size %u, "
 		    "access type %d\n",
@@ -733,6 +923,10 @@ bool SpotDownward::initRequestSimulation(void)
 		return false;
 	}
 
+	// the parameter is optional, SAC frames are built by default
+	OpenSandModelConf::extractParameterData(ncc->getParameter("simulation_direct_injection"),
+	                                        this->simulate_direct_injection);
+
 	// TODO for stdin use FileEvent for simu_timer ?
 	if(str_config == "File")
 	{
@@ -826,44 +1020,49 @@ bool SpotDownward::initOutput(void)
 
 	// Events
 	this->event_logon_resp = output->registerEvent(prefix + "DVB.logon_response");
+	this->probe_logon_queue = output->registerProbe<int>(prefix + "DVB.Logon queue",
+	                                                     "requests", true, SAMPLE_LAST);
+	this->probe_logons_admitted = output->registerProbe<int>(prefix + "DVB.Logons admitted",
+	                                                         "requests", true, SAMPLE_SUM);
 
 	for (auto &&label_fifos_pair: dvb_fifos)
 	{
 		const std::string cat_label = label_fifos_pair.first;
 		const fifos_t &fifos = label_fifos_pair.second;
 
+		std::vector<fifo_probes_t> &category_probes = this->probes_gw_fifos[cat_label];
+		category_probes.reserve(fifos.size());
 		for (auto &&qos_fifo_pair: fifos)
 		{
-			qos_t id = qos_fifo_pair.first;
 			DvbFifo *fifo = qos_fifo_pair.second;
 			std::string fifo_name = fifo->getName();
+			fifo_probes_t probes;
+
+			probes.fifo = fifo;
+			probes.queue_size = this->fifo_probes.get(prefix + cat_label + ".Queue size.packets." + fifo_name,
+			                                          "Packets", true, SAMPLE_LAST);
 
-			std::shared_ptr<Probe<int>> probe_temp;
-			std::string name;
+			probes.queue_size_kb = this->fifo_probes.get(prefix + cat_label + ".Queue size.capacity." + fifo_name,
+			                                             "kbits", true, SAMPLE_LAST);
 
-			probe_temp = output->registerProbe<int>(prefix + cat_label + ".Queue size.packets." + fifo_name,
-			                                        "Packets", true, SAMPLE_LAST);
-			this->probe_gw_queue_size[cat_label].emplace(id, probe_temp);
+			probes.l2_to_sat_before_sched = this->fifo_probes.get(prefix + cat_label + ".Throughputs.L2_to_SAT_before_sched." + fifo_name,
+			                                                      "Kbits/s", true, SAMPLE_AVG);
 
-			probe_temp = output->registerProbe<int>(prefix + cat_label + ".Queue size.capacity." + fifo_name,
-			                                        "kbits", true, SAMPLE_LAST);
-			this->probe_gw_queue_size_kb[cat_label].emplace(id, probe_temp);
+			probes.l2_to_sat_after_sched = this->fifo_probes.get(prefix + cat_label + ".Throughputs.L2_to_SAT_after_sched." + fifo_name,
+			                                                     "Kbits/s", true, SAMPLE_AVG);
 
-			probe_temp = output->registerProbe<int>(prefix + cat_label + ".Throughputs.L2_to_SAT_before_sched." + fifo_name,
-			                                        "Kbits/s", true, SAMPLE_AVG);
-			this->probe_gw_l2_to_sat_before_sched[cat_label].emplace(id, probe_temp);
+			probes.queue_loss = this->fifo_probes.get(prefix + cat_label + ".Queue loss.packets." + fifo_name,
+			                                          "Packets", true, SAMPLE_SUM);
 
-			probe_temp = output->registerProbe<int>(prefix + cat_label + ".Throughputs.L2_to_SAT_after_sched." + fifo_name,
-			                                        "Kbits/s", true, SAMPLE_AVG);
-			this->probe_gw_l2_to_sat_after_sched[cat_label].emplace(id, probe_temp);
+			probes.queue_loss_kb = this->fifo_probes.get(prefix + cat_label + ".Queue loss.rate." + fifo_name,
+			                                             "Kbits/s", true, SAMPLE_SUM);
 
-			probe_temp = output->registerProbe<int>(prefix + cat_label + ".Queue loss.packets." + fifo_name,
-			                                        "Packets", true, SAMPLE_SUM);
-			this->probe_gw_queue_loss[cat_label].emplace(id, probe_temp);
+			probes.queue_sojourn = this->fifo_probes.get(prefix + cat_label + ".Queue sojourn.mean." + fifo_name,
+			                                             "ms", true, SAMPLE_AVG);
 
-			probe_temp = output->registerProbe<int>(prefix + cat_label + ".Queue loss.rate." + fifo_name,
-			                                        "Kbits/s", true, SAMPLE_SUM);
-			this->probe_gw_queue_loss_kb[cat_label].emplace(id, probe_temp);
+			probes.queue_sojourn_max = this->fifo_probes.get(prefix + cat_label + ".Queue sojourn.max." + fifo_name,
+			                                                 "ms", true, SAMPLE_MAX);
+			category_probes.push_back(probes);
 		}
 		this->probe_gw_l2_to_sat_total[cat_label] =
 		    output->registerProbe<int>(prefix + cat_label + ".Throughputs.L2_to_SAT_after_sched.total",
@@ -983,6 +1182,100 @@ bool SpotDownward::handleLogonReq(const LogonRequest *logon_req)
 }
 
 
+bool SpotDownward::queueLogonReq(DvbFrame *dvb_frame, std::vector<tal_id_t> &admitted)
+{
+	LogonRequest *logon_req = reinterpret_cast<LogonRequest *>(dvb_frame);
+	tal_id_t mac = logon_req->getMac();
+	if(this->pending_logon_ids.count(mac) > 0)
+	{
+		// the terminal retried before its request was admitted
+		LOG(this->log_receive_channel, LEVEL_INFO,
+		    "SF#%u: logon request from ST%u already queued\n",
+		    this->super_frame_counter, mac);
+		delete dvb_frame;
+		return true;
+	}
+
+	if(this->pending_logons.empty() &&
+	   (this->max_logons_per_sf == 0 || this->admitted_logons < this->max_logons_per_sf))
+	{
+		++this->admitted_logons;
+		this->probe_logons_admitted->put(1);
+		bool status = this->handleLogonReq(logon_req);
+		delete dvb_frame;
+		if(status)
+		{
+			admitted.push_back(mac);
+		}
+		return status;
+	}
+
+	this->pending_logons.push_back(dvb_frame);
+	this->pending_logon_ids.insert(mac);
+	this->probe_logon_queue->put(this->pending_logons.size());
+	return true;
+}
+
+
+bool SpotDownward::admitLogons(std::vector<tal_id_t> &admitted)
+{
+	bool status = true;
+	unsigned int count = 0;
+
+	this->admitted_logons = 0;
+	while(!this->pending_logons.empty() &&
+	      (this->max_logons_per_sf == 0 || this->admitted_logons < this->max_logons_per_sf))
+	{
+		DvbFrame *dvb_frame = this->pending_logons.front();
+		LogonRequest *logon_req = reinterpret_cast<LogonRequest *>(dvb_frame);
+		tal_id_t mac = logon_req->getMac();
+		this->pending_logons.pop_front();
+		this->pending_logon_ids.erase(mac);
+		++this->admitted_logons;
+		++count;
+		if(this->handleLogonReq(logon_req))
+		{
+			admitted.push_back(mac);
+		}
+		else
+		{
+			status = false;
+		}
+		delete dvb_frame;
+	}
+	if(count > 0)
+	{
+		LOG(this->log_receive_channel, LEVEL_NOTICE,
+		    "SF#%u: %u queued logon requests admitted, %zu still waiting\n",
+		    this->super_frame_counter, count, this->pending_logons.size());
+		this->probe_logons_admitted->put(count);
+		this->probe_logon_queue->put(this->pending_logons.size());
+	}
+	return status;
+}
+
+
+bool SpotDownward::restoreCheckpoint(NccCheckpoint *checkpoint)
+{
+	for(auto &&state: checkpoint->getRestoredTerminals())
+	{
+		if(state.is_scpc)
+		{
+			this->is_tal_scpc.push_back(state.tal_id);
+		}
+		else if(state.has_dama && this->dama_ctrl &&
+		        !this->dama_ctrl->restoreTerminal(state.tal_id, state.dama))
+		{
+			LOG(this->log_init_channel, LEVEL_ERROR,
+			    "cannot restore the DAMA context of ST%u\n", state.tal_id);
+			return false;
+		}
+	}
+	this->checkpoint = checkpoint;
+	return true;
+}
+
+
 bool SpotDownward::handleLogoffReq(const DvbFrame *dvb_frame)
 {
 	// TODO	Logoff *logoff = dynamic_cast<Logoff *>(dvb_frame);
@@ -1025,6 +1318,16 @@ bool SpotDownward::buildTtp(Ttp *ttp)
 	return this->dama_ctrl->buildTTP(ttp);
 }
 
+bool SpotDownward::handleLookAheadTimer(void)
+{
+	return this->dama_ctrl->runAhead(this->super_frame_counter);
+}
+
+time_sf_t SpotDownward::getDamaLookAhead(void) const
+{
+	return this->dama_look_ahead_sf;
+}
+
 void SpotDownward::updateStatistics(void)
 {
 	if(!this->doSendStats())
@@ -1041,36 +1344,43 @@ void SpotDownward::updateStatistics(void)
 	mac_fifo_stat_context_t fifo_stat;
 	// MAC fifos stats
 
-	for (auto &&label_fifos_pair: dvb_fifos)
+	for (auto &&label_probes_pair: this->probes_gw_fifos)
 	{
-		const std::string cat_label = label_fifos_pair.first;
-		const fifos_t &fifos = label_fifos_pair.second;
+		const std::string &cat_label = label_probes_pair.first;
+		int &total_bytes = this->l2_to_sat_total_bytes[cat_label];
+		auto &total_probe = this->probe_gw_l2_to_sat_total[cat_label];
+		bool total_enabled = total_probe->isEnabled();
 
-		for (auto &&qos_fifo_pair: fifos)
+		for (auto &&probes: label_probes_pair.second)
 		{
-			qos_t id = qos_fifo_pair.first;
-			DvbFifo *fifo = qos_fifo_pair.second;
-
-			fifo->getStatsCxt(fifo_stat);
+			// the counters of the unused fifos are only reset
+			if (!total_enabled && !probes.isEnabled())
+			{
+				probes.fifo->skipStats();
+				continue;
+			}
+			probes.fifo->getStatsCxt(fifo_stat);
 
-			this->l2_to_sat_total_bytes[cat_label] += fifo_stat.out_length_bytes;
+			total_bytes += fifo_stat.out_length_bytes;
 
-			this->probe_gw_l2_to_sat_before_sched[cat_label][id]->put(
+			// the probes of a fifo are registered once it is used
+			probes.l2_to_sat_before_sched.putNonZero(
 			    fifo_stat.in_length_bytes * 8.0 / this->stats_period_ms);
 
-			this->probe_gw_l2_to_sat_after_sched[cat_label][id]->put(
+			probes.l2_to_sat_after_sched.putNonZero(
 			    fifo_stat.out_length_bytes * 8.0 / this->stats_period_ms);
 
 			// Mac fifo stats
-			this->probe_gw_queue_size[cat_label][id]->put(fifo_stat.current_pkt_nbr);
-			this->probe_gw_queue_size_kb[cat_label][id]->put(
+			probes.queue_size.putNonZero(fifo_stat.current_pkt_nbr);
+			probes.queue_size_kb.putNonZero(
 			    fifo_stat.current_length_bytes * 8 / 1000);
-			this->probe_gw_queue_loss[cat_label][id]->put(fifo_stat.drop_pkt_nbr);
-			this->probe_gw_queue_loss_kb[cat_label][id]->put(fifo_stat.drop_bytes * 8);
+			probes.queue_loss.putNonZero(fifo_stat.drop_pkt_nbr);
+			probes.queue_loss_kb.putNonZero(fifo_stat.drop_bytes * 8);
+			probes.queue_sojourn.putNonZero(fifo_stat.sojourn_avg_ms);
+			probes.queue_sojourn_max.putNonZero(fifo_stat.sojourn_max_ms);
 		}
-		this->probe_gw_l2_to_sat_total[cat_label]->put(this->l2_to_sat_total_bytes[cat_label] * 8 /
-	                                                   this->stats_period_ms);
-		this->l2_to_sat_total_bytes[cat_label] = 0;
+		total_probe->put(total_bytes * 8 / this->stats_period_ms);
+		total_bytes = 0;
 	}
 }
 
@@ -1091,9 +1401,17 @@ bool SpotDownward::handleFrameTimer(time_sf_t super_frame_counter)
 	// Upate the superframe counter
 	this->super_frame_counter = super_frame_counter;
 
+	// a new return band is swapped in between two allocations
+	this->applyReconfiguration();
+
 	// run the allocation algorithms (DAMA)
 	this->dama_ctrl->runOnSuperFrameChange(this->super_frame_counter);
 
+	if(this->checkpoint && this->checkpoint->isDue(this->super_frame_counter))
+	{
+		this->saveCheckpoint();
+	}
+
 	std::list<DvbFrame *> msgs;
 	std::list<DvbFrame *>::iterator msg;
 
@@ -1181,6 +1499,8 @@ bool SpotDownward::handleFrameTimer(time_sf_t super_frame_counter)
 					"default");
 				break;
 		}
+		// the simulated frames are not kept by the DAMA controller
+		delete *msg;
 	}
 
 	return true;
@@ -1288,7 +1608,7 @@ bool SpotDownward::handleSac(const DvbFrame *dvb_frame)
 }
 
 
-bool SpotDownward::applyPepCommand(PepRequest *pep_request)
+bool SpotDownward::applyPepCommand(const PepRequest *pep_request)
 {
 	if(this->dama_ctrl->applyPepCommand(pep_request))
 	{
@@ -1355,6 +1675,392 @@ bool SpotDownward::applySvnoCommand(SvnoRequest *svno_request)
 }
 
 
+SpotDownward::return_band_t::return_band_t():
+	plan(),
+	categories(),
+	terminal_affectation(),
+	default_category(NULL),
+	fmt_groups()
+{
+}
+
+
+SpotDownward::return_band_t::~return_band_t()
+{
+	for(auto &&category_it: this->categories)
+	{
+		delete category_it.second;
+	}
+	for(auto &&group_it: this->fmt_groups)
+	{
+		delete group_it.second;
+	}
+}
+
+
+int SpotDownward::initTopologyWatch(void)
+{
+	if(!this->dama_ctrl)
+	{
+		return -1;
+	}
+
+	const std::string &path = OpenSandModelConf::Get()->getTopologyPath();
+	std::string directory = ".";
+	std::size_t separator = path.rfind('/');
+	this->topology_file = path;
+	if(separator != std::string::npos)
+	{
+		directory = separator == 0 ? "/" : path.substr(0, separator);
+		this->topology_file = path.substr(separator + 1);
+	}
+
+	int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(fd < 0)
+	{
+		LOG(this->log_init_channel, LEVEL_ERROR,
+		    "cannot watch the topology file: %s\n", strerror(errno));
+		return -1;
+	}
+
+	// the editors often replace the file, so its directory is watched
+	if(inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		LOG(this->log_init_channel, LEVEL_ERROR,
+		    "cannot watch the topology directory %s: %s\n",
+		    directory.c_str(), strerror(errno));
+		close(fd);
+		return -1;
+	}
+	LOG(this->log_init_channel, LEVEL_NOTICE,
+	    "the return band is reconfigured when %s is written\n",
+	    path.c_str());
+
+	return fd;
+}
+
+
+void SpotDownward::handleTopologyChange(const unsigned char *data, std::size_t size)
+{
+	bool changed = false;
+	std::size_t offset = 0;
+
+	while(offset + sizeof(struct inotify_event) <= size)
+	{
+		auto event = reinterpret_cast<const struct inotify_event *>(data + offset);
+		if(event->len > 0 && this->topology_file == event->name)
+		{
+			changed = true;
+		}
+		offset += sizeof(struct inotify_event) + event->len;
+	}
+	if(!changed)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock{this->reconfiguration_lock};
+	if(this->reconfiguration_running)
+	{
+		// the band is built again once the current one is
+		this->reconfiguration_requested = true;
+		return;
+	}
+	if(this->reconfiguration_thread.joinable())
+	{
+		this->reconfiguration_thread.join();
+	}
+
+	LOG(this->log_receive_channel, LEVEL_NOTICE,
+	    "SF#%u: topology file written, building the return band\n",
+	    this->super_frame_counter);
+	try
+	{
+		this->reconfiguration_thread = std::thread{&SpotDownward::runReconfiguration, this};
+		this->reconfiguration_running = true;
+	}
+	catch(const std::system_error &error)
+	{
+		LOG(this->log_receive_channel, LEVEL_ERROR,
+		    "cannot create the return band reconfiguration thread: %s\n",
+		    error.what());
+	}
+}
+
+
+void SpotDownward::runReconfiguration(void)
+{
+	while(true)
+	{
+		// the XML parsing and the band computation stay off the
+		// channel thread, only the swap is done between superframes
+		std::unique_ptr<return_band_t> band = this->buildReturnBand();
+
+		std::lock_guard<std::mutex> lock{this->reconfiguration_lock};
+		if(band)
+		{
+			// a band not applied yet is replaced by the newer one
+			this->pending_band = std::move(band);
+		}
+		if(!this->reconfiguration_requested)
+		{
+			this->reconfiguration_running = false;
+			return;
+		}
+		this->reconfiguration_requested = false;
+	}
+}
+
+
+std::unique_ptr<SpotDownward::return_band_t> SpotDownward::buildReturnBand(void)
+{
+	auto Conf = OpenSandModelConf::Get();
+	spot_id_t default_spot_id;
+
+	auto topology = Conf->readTopologyUpdate();
+	if(topology == nullptr)
+	{
+		LOG(this->log_receive_channel, LEVEL_ERROR,
+		    "cannot read the updated topology, the return band is kept\n");
+		return nullptr;
+	}
+
+	std::unique_ptr<return_band_t> band{new return_band_t()};
+	if(!Conf->getSpotReturnCarriers(this->mac_id, band->plan.carriers, topology) ||
+	   !Conf->getTerminalAffectation(default_spot_id,
+	                                 band->plan.default_category,
+	                                 band->plan.terminal_categories,
+	                                 topology))
+	{
+		LOG(this->log_receive_channel, LEVEL_ERROR,
+		    "cannot get the return band of gateway %u in the updated "
+		    "topology, the return band is kept\n", this->mac_id);
+		return nullptr;
+	}
+
+	if(!this->diffReturnPlan(band->plan))
+	{
+		LOG(this->log_receive_channel, LEVEL_NOTICE,
+		    "the return band did not change in the updated topology\n");
+		return nullptr;
+	}
+
+	if(!this->initBand<TerminalCategoryDama>(band->plan.carriers,
+	                                         "return up frequency plan update",
+	                                         AccessType::DAMA,
+	                                         this->ret_up_frame_duration_ms,
+	                                         this->rcs_modcod_def,
+	                                         band->categories,
+	                                         band->terminal_affectation,
+	                                         &band->default_category,
+	                                         band->fmt_groups,
+	                                         topology))
+	{
+		LOG(this->log_receive_channel, LEVEL_ERROR,
+		    "cannot build the updated return band, it is not applied\n");
+		return nullptr;
+	}
+	if(band->categories.empty())
+	{
+		LOG(this->log_receive_channel, LEVEL_ERROR,
+		    "no DAMA carrier in the updated return band, it is not applied\n");
+		return nullptr;
+	}
+
+	return band;
+}
+
+
+bool SpotDownward::diffReturnPlan(const return_plan_t &plan) const
+{
+	std::map<std::string, std::vector<const OpenSandModelConf::carrier *>> running_carriers;
+	std::map<std::string, std::vector<const OpenSandModelConf::carrier *>> carriers;
+	std::set<tal_id_t> terminals;
+	unsigned int moved_terminals = 0;
+	return_plan_t running;
+	bool changed = false;
+
+	{
+		std::lock_guard<std::mutex> lock{this->reconfiguration_lock};
+		running = this->return_plan;
+	}
+
+	// the band plan is shared by the categories, check it first
+	if(plan.carriers.roll_off != running.carriers.roll_off ||
+	   plan.carriers.bandwidth_khz != running.carriers.bandwidth_khz)
+	{
+		LOG(this->log_receive_channel, LEVEL_NOTICE,
+		    "return band: %u kHz with roll-off %.2f, was %u kHz with roll-off %.2f\n",
+		    plan.carriers.bandwidth_khz, plan.carriers.roll_off,
+		    running.carriers.bandwidth_khz, running.carriers.roll_off);
+		changed = true;
+	}
+
+	for(auto &&carrier: running.carriers.carriers)
+	{
+		running_carriers[carrier.category].push_back(&carrier);
+	}
+	for(auto &&carrier: plan.carriers.carriers)
+	{
+		carriers[carrier.category].push_back(&carrier);
+	}
+	for(auto &&category_it: carriers)
+	{
+		const std::string &label = category_it.first;
+		auto &category_carriers = category_it.second;
+		auto running_it = running_carriers.find(label);
+		if(running_it == running_carriers.end())
+		{
+			LOG(this->log_receive_channel, LEVEL_NOTICE,
+			    "return band: category %s added with %zu carriers\n",
+			    label.c_str(), category_carriers.size());
+			changed = true;
+			continue;
+		}
+		auto &running_category_carriers = running_it->second;
+		bool same = running_category_carriers.size() == category_carriers.size();
+		for(std::size_t index = 0; same && index < category_carriers.size(); ++index)
+		{
+			same = sameCarrier(*category_carriers[index], *running_category_carriers[index]);
+		}
+		if(!same)
+		{
+			LOG(this->log_receive_channel, LEVEL_NOTICE,
+			    "return band: carriers of category %s updated\n",
+			    label.c_str());
+			changed = true;
+		}
+		running_carriers.erase(running_it);
+	}
+	for(auto &&category_it: running_carriers)
+	{
+		LOG(this->log_receive_channel, LEVEL_NOTICE,
+		    "return band: category %s removed\n",
+		    category_it.first.c_str());
+		changed = true;
+	}
+
+	// the terminals not assigned go in the default category
+	if(plan.default_category != running.default_category)
+	{
+		LOG(this->log_receive_channel, LEVEL_NOTICE,
+		    "return band: default category %s, was %s\n",
+		    plan.default_category.c_str(), running.default_category.c_str());
+		changed = true;
+	}
+	for(auto &&terminal_it: running.terminal_categories)
+	{
+		terminals.insert(terminal_it.first);
+	}
+	for(auto &&terminal_it: plan.terminal_categories)
+	{
+		terminals.insert(terminal_it.first);
+	}
+	for(tal_id_t tal_id: terminals)
+	{
+		auto running_it = running.terminal_categories.find(tal_id);
+		auto terminal_it = plan.terminal_categories.find(tal_id);
+		const std::string &running_category = running_it == running.terminal_categories.end() ?
+		                                      running.default_category : running_it->second.second;
+		const std::string &category = terminal_it == plan.terminal_categories.end() ?
+		                              plan.default_category : terminal_it->second.second;
+		if(category != running_category)
+		{
+			++moved_terminals;
+		}
+	}
+	if(moved_terminals > 0)
+	{
+		LOG(this->log_receive_channel, LEVEL_NOTICE,
+		    "return band: %u terminals change of category\n",
+		    moved_terminals);
+		changed = true;
+	}
+
+	return changed;
+}
+
+
+bool SpotDownward::applyReconfiguration(void)
+{
+	std::unique_ptr<return_band_t> band;
+	{
+		std::lock_guard<std::mutex> lock{this->reconfiguration_lock};
+		if(!this->pending_band)
+		{
+			return true;
+		}
+		band = std::move(this->pending_band);
+	}
+
+	if(!this->dama_ctrl->reconfigure(band->categories,
+	                                 band->terminal_affectation,
+	                                 band->default_category))
+	{
+		LOG(this->log_receive_channel, LEVEL_ERROR,
+		    "SF#%u: the updated return band is refused, the running "
+		    "one is kept\n", this->super_frame_counter);
+		return false;
+	}
+
+	// the DAMA controller owns the categories now, the FMT groups of
+	// the previous ones are released with the band
+	band->categories.clear();
+	std::swap(this->ret_fmt_groups, band->fmt_groups);
+	{
+		std::lock_guard<std::mutex> lock{this->reconfiguration_lock};
+		this->return_plan = band->plan;
+	}
+	LOG(this->log_receive_channel, LEVEL_NOTICE,
+	    "SF#%u: return band reconfigured\n",
+	    this->super_frame_counter);
+
+	return true;
+}
+
+
+void SpotDownward::saveCheckpoint(void)
+{
+	// only copies on the superframe tick, the checkpoint encodes and
+	// writes the states in its own thread
+	this->input_sts->getCurrentModcodIds(this->checkpoint_input_modcods);
+	this->output_sts->getCurrentModcodIds(this->checkpoint_output_modcods);
+	this->checkpoint_states.clear();
+
+	auto output = this->checkpoint_output_modcods.begin();
+	for(auto &&input: this->checkpoint_input_modcods)
+	{
+		tal_id_t tal_id = input.first;
+		if(tal_id >= BROADCAST_TAL_ID)
+		{
+			// the simulated terminals log on again with the simulation
+			break;
+		}
+		while(output != this->checkpoint_output_modcods.end() && output->first < tal_id)
+		{
+			++output;
+		}
+
+		ncc_terminal_state_t state;
+		state.tal_id = tal_id;
+		state.is_scpc = std::find(this->is_tal_scpc.begin(),
+		                          this->is_tal_scpc.end(),
+		                          tal_id) != this->is_tal_scpc.end();
+		state.input_modcod_id = input.second;
+		state.output_modcod_id = 0;
+		if(output != this->checkpoint_output_modcods.end() && output->first == tal_id)
+		{
+			state.output_modcod_id = output->second;
+		}
+		state.dama = dama_terminal_state_t{};
+		state.has_dama = this->dama_ctrl->getTerminalState(tal_id, state.dama);
+		this->checkpoint_states.push_back(state);
+	}
+
+	this->checkpoint->push(this->checkpoint_states, this->super_frame_counter);
+}
+
+
 /**
  * Add a CNI extension in the next GSE packet header
  * Only for SCPC
@@ -1375,9 +2081,10 @@ bool SpotDownward::addCniExt(void)
 		for(auto&& fifos_it : dvb_fifos_it.second)
 		{
 			DvbFifo *fifo = fifos_it.second;
-			for(auto&& elem : fifo->getQueue())
+			for(vol_pkt_t index = 0; index < fifo->getCurrentSize(); ++index)
 			{
-				std::unique_ptr<NetPacket> packet = elem->getElem<NetPacket>();
+				FifoElement &elem = fifo->peek(index);
+				std::unique_ptr<NetPacket> packet = elem.getElem<NetPacket>();
 				tal_id_t tal_id = packet->getDstTalId();
 
 				auto it = std::find(this->is_tal_scpc.begin(), this->is_tal_scpc.end(), tal_id);
@@ -1404,7 +2111,7 @@ bool SpotDownward::addCniExt(void)
 				else
 				{
 					// Put packet back into the fifo element
-					elem->setElem(std::move(packet));
+					elem.setElem(std::move(packet));
 				}
 			}
 		}
@@ -1456,7 +2163,7 @@ bool SpotDownward::addCniExt(void)
 				return false;
 			}
 
-			FifoElement *new_el = new FifoElement(nullptr, 0, 0);
+			FifoElement new_el;
 			// set packet extension to this new empty packet
 			if(!this->setPacketExtension(this->pkt_hdl,
 				                         new_el,
@@ -1470,7 +2177,7 @@ bool SpotDownward::addCniExt(void)
 				return false;
 			}
 			// highest priority fifo
-			(fifos_it->second)[0]->pushBack(new_el);
+			(fifos_it->second)[0]->pushBack(std::move(new_el));
 
 			LOG(this->log_send_channel, LEVEL_DEBUG,
 			    "SF #%d: adding empty packet into FIFO NM\n",
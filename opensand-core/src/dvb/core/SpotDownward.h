@@ -37,10 +37,17 @@
 #ifndef SPOT_DOWNWARD_H
 #define SPOT_DOWNWARD_H
 
+#include <deque>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 #include <opensand_rt/Types.h>
 
 #include "DvbChannel.h"
+#include "NccCheckpoint.h"
 #include "RequestSimulator.h"
 #include "TerminalCategoryDama.h"
 
@@ -103,6 +110,36 @@ public:
 	 */
 	bool handleLogonReq(const LogonRequest *logon_req);
 
+	/**
+	 * @brief Queue a logon request transmitted by the opposite block,
+	 *        it is admitted right away if the superframe budget allows
+	 *        it and no request is waiting
+	 *
+	 * @param dvb_frame  The frame containing the logon request,
+	 *                   released by the spot
+	 * @param admitted   OUT: the terminals whose logon was admitted
+	 * @return true on success, false otherwise
+	 */
+	bool queueLogonReq(DvbFrame *dvb_frame, std::vector<tal_id_t> &admitted);
+
+	/**
+	 * @brief Admit the queued logon requests allowed in a new superframe
+	 *
+	 * @param admitted  OUT: the terminals whose logon was admitted
+	 * @return true on success, false if some logons failed
+	 */
+	bool admitLogons(std::vector<tal_id_t> &admitted);
+
+	/**
+	 * @brief Log the terminals of a checkpoint on again in the DAMA
+	 *        controller, then checkpoint the terminal states
+	 *        periodically
+	 *
+	 * @param checkpoint  The checkpoint, kept by the spot
+	 * @return true on success, false otherwise
+	 */
+	bool restoreCheckpoint(NccCheckpoint *checkpoint);
+
 	/**
 	 * @brief Handle a logoff request transmitted by the opposite
 	 *        block
@@ -135,6 +172,22 @@ public:
 	 */
 	bool handleFwdFrameTimer(time_sf_t fwd_frame_counter);
 
+	/**
+	 * @brief Compute the DAMA allocations of the next superframes,
+	 *        in the idle part of the current one
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool handleLookAheadTimer(void);
+
+	/**
+	 * @brief Get the number of superframes the DAMA allocations
+	 *        are computed ahead
+	 *
+	 * @return the look-ahead, 0 if they are computed on the superframe change
+	 */
+	time_sf_t getDamaLookAhead(void) const;
+
 	/**
 	 * @brief  handle a SAC frame
 	 *
@@ -153,7 +206,7 @@ public:
 	 * @param pep_request the pep request
 	 * @return true on success, false otherwise
 	 */
-	bool applyPepCommand(PepRequest *pep_request);
+	bool applyPepCommand(const PepRequest *pep_request);
 
 	/**
 	 * @briel apply SVNO command
@@ -179,6 +232,25 @@ public:
 	void setPepCmdApplyTimer(event_id_t pep_cmd_a_timer);
 	event_id_t getPepCmdApplyTimer(void);
 
+	/**
+	 * @brief Watch the topology file to reconfigure the return band
+	 *        when it is written
+	 *
+	 * @return the inotify file descriptor to read the changes on,
+	 *         -1 if there is no DAMA or on error
+	 */
+	int initTopologyWatch(void);
+
+	/**
+	 * @brief Handle the changes read on the topology watch, the new
+	 *        return band is built in background and applied at the
+	 *        beginning of a superframe
+	 *
+	 * @param data  The inotify events
+	 * @param size  The size of the events
+	 */
+	void handleTopologyChange(const unsigned char *data, std::size_t size);
+
 protected:
 	/**
 	 * Read configuration for the downward timers
@@ -223,6 +295,62 @@ protected:
 	 */
 	bool initOutput(void);
 
+	/// The return band plan, as read from the topology
+	struct return_plan_t
+	{
+		OpenSandModelConf::spot carriers;
+		std::string default_category;
+		std::map<tal_id_t, std::pair<spot_id_t, std::string>> terminal_categories;
+	};
+
+	/// A return band built from an updated topology
+	struct return_band_t
+	{
+		return_band_t();
+		~return_band_t();
+
+		return_plan_t plan;
+		TerminalCategories<TerminalCategoryDama> categories;
+		TerminalMapping<TerminalCategoryDama> terminal_affectation;
+		TerminalCategoryDama *default_category;
+		fmt_groups_t fmt_groups;
+	};
+
+	/**
+	 * @brief Build the return bands of the updated topology until
+	 *        no other update is requested, in the reconfiguration thread
+	 */
+	void runReconfiguration(void);
+
+	/**
+	 * @brief Build the return band of the updated topology
+	 *
+	 * @return the band, nullptr if it did not change or on error
+	 */
+	std::unique_ptr<return_band_t> buildReturnBand(void);
+
+	/**
+	 * @brief Log the differences between the running return band
+	 *        and an updated one
+	 *
+	 * @param plan  The updated return band plan
+	 * @return true if the plans differ, false otherwise
+	 */
+	bool diffReturnPlan(const return_plan_t &plan) const;
+
+	/**
+	 * @brief Apply the return band built, if any, before the DAMA
+	 *        allocation of a superframe
+	 *
+	 * @return true on success, false if the band is refused
+	 */
+	bool applyReconfiguration(void);
+
+	/**
+	 * @brief Hand the terminal states over to the checkpoint
+	 */
+	void saveCheckpoint(void);
+
 	/** Read configuration for the request simulation
 	 *
 	 * @return  true on success, false otherwise
@@ -314,23 +442,23 @@ protected:
 	/// timer used for applying resources allocations received from PEP
 	event_id_t pep_cmd_apply_timer;
 
+	/// The number of superframes the DAMA allocations are computed ahead
+	time_sf_t dama_look_ahead_sf;
+
 	RequestSimulator *request_simu;
 
 	/// parameters for request simulation
 	FILE *event_file;
 	Simulate simulate;
+	/// whether the simulated requests bypass the SAC frames
+	bool simulate_direct_injection;
 
 	// Output probes and stats
-	using ProbeListPerId = std::map<unsigned int, std::shared_ptr<Probe<int>>>;
-	// Queue sizes
-	std::map<std::string, ProbeListPerId> probe_gw_queue_size;
-	std::map<std::string, ProbeListPerId> probe_gw_queue_size_kb;
-	// Queue loss
-	std::map<std::string, ProbeListPerId> probe_gw_queue_loss;
-	std::map<std::string, ProbeListPerId> probe_gw_queue_loss_kb;
+	// Queue sizes, loss, sojourn times and layer 2 to SAT rates
+	// of each category, in the FIFOs order
+	std::map<std::string, std::vector<fifo_probes_t>> probes_gw_fifos;
+	LazyProbes<int> fifo_probes;
 	// Rates
-	std::map<std::string, ProbeListPerId> probe_gw_l2_to_sat_before_sched;
-	std::map<std::string, ProbeListPerId> probe_gw_l2_to_sat_after_sched;
 	std::map<std::string, std::shared_ptr<Probe<int>>> probe_gw_l2_to_sat_total;
 	std::map<std::string, int> l2_to_sat_total_bytes;
 	// Frame interval
@@ -343,6 +471,39 @@ protected:
 
 	/// logon response sent
 	std::shared_ptr<OutputEvent> event_logon_resp;
+
+	/// The logon requests waiting for admission, in arrival order
+	std::deque<DvbFrame *> pending_logons;
+	/// The terminals of the pending logon requests
+	std::unordered_set<tal_id_t> pending_logon_ids;
+	/// The logons admitted at most per superframe, 0 for no limit
+	unsigned int max_logons_per_sf;
+	/// The logons admitted during the current superframe
+	unsigned int admitted_logons;
+	std::shared_ptr<Probe<int>> probe_logon_queue;
+	std::shared_ptr<Probe<int>> probe_logons_admitted;
+
+	/// The name of the topology file in its watched directory
+	std::string topology_file;
+	/// The running return band plan
+	return_plan_t return_plan;
+	/// The return band built and not applied yet
+	std::unique_ptr<return_band_t> pending_band;
+	/// Whether the reconfiguration thread is building a band
+	bool reconfiguration_running;
+	/// Whether the topology changed again while building a band
+	bool reconfiguration_requested;
+	/// Protect the running plan copy and the pending band
+	mutable std::mutex reconfiguration_lock;
+	std::thread reconfiguration_thread;
+
+	/// The checkpoint of the terminal states, nullptr if disabled
+	NccCheckpoint *checkpoint;
+	/// The terminal states buffer, swapped with the checkpoint one
+	std::vector<ncc_terminal_state_t> checkpoint_states;
+	/// The MODCOD IDs of the terminals, kept to reuse their storage
+	std::vector<std::pair<tal_id_t, fmt_id_t>> checkpoint_input_modcods;
+	std::vector<std::pair<tal_id_t, fmt_id_t>> checkpoint_output_modcods;
 };
 
 #endif
@@ -41,6 +41,7 @@
 #include "PhysicStd.h"
 #include "NetBurst.h"
 #include "SlottedAlohaNcc.h"
+#include "NccCheckpoint.h"
 #include "TerminalCategoryDama.h"
 #include "UnitConverterFixedSymbolLength.h"
 #include "OpenSandModelConf.h"
@@ -63,6 +64,9 @@ SpotUpward::SpotUpward(spot_id_t spot_id,
 	scpc_pkt_hdl{nullptr},
 	ret_fmt_groups{},
 	is_tal_scpc{},
+	batch_burst{nullptr},
+	batch_cni_input{},
+	batch_cni_output{},
 	probe_gw_l2_from_sat{nullptr},
 	probe_received_modcod{nullptr},
 	probe_rejected_modcod{nullptr},
@@ -495,8 +499,9 @@ bool SpotUpward::checkIfScpc()
 }
 
 
-bool SpotUpward::handleFrame(DvbFrame *frame, NetBurst **burst)
+bool SpotUpward::handleFrame(DvbFrame *frame)
 {
+	NetBurst *burst{nullptr};
 	EmulatedMessageType msg_type = frame->getMessageType();
 	bool corrupted = frame->isCorrupted();
 	PhysicStd *std = this->reception_std;
@@ -517,22 +522,26 @@ bool SpotUpward::handleFrame(DvbFrame *frame, NetBurst **burst)
 	// Update stats
 	this->l2_from_sat_bytes += frame->getPayloadLength();
 
-	if(!std->onRcvFrame(frame, this->mac_id, burst))
+	if(!std->onRcvFrame(frame, this->mac_id, &burst))
 	{
 		LOG(this->log_receive_channel, LEVEL_ERROR,
 		    "failed to handle DVB frame or BB frame\n");
 		return false;
 	}
-	NetBurst *pkt_burst = *burst;
+	std::unique_ptr<NetBurst> pkt_burst{burst};
 	if(pkt_burst)
 	{
+		if(!this->batch_burst)
+		{
+			this->batch_burst.reset(new NetBurst());
+			this->batch_burst->reserve(max_batch_packets);
+		}
+
+		bool cni_found = false;
 		for (auto&& packet : *pkt_burst)
 		{
 			tal_id_t tal_id = packet->getSrcTalId();
-			auto it_scpc = std::find(this->is_tal_scpc.begin(),
-			                         this->is_tal_scpc.end(),
-			                         tal_id);
-			if(it_scpc != this->is_tal_scpc.end() &&
+			if(!cni_found && this->isTalScpc(tal_id) &&
 			   packet->getDstTalId() == this->mac_id)
 			{
 				uint32_t opaque = 0;
@@ -549,10 +558,11 @@ bool SpotUpward::handleFrame(DvbFrame *frame, NetBurst **burst)
 					// This is the C/N0 value evaluated by the Terminal
 					// and transmitted via GSE extensions
 					// TODO we could make specific SCPC function
-					this->setRequiredCniOutput(tal_id, ncntoh(opaque));
-					break;
+					this->batch_cni_output.set(tal_id, ncntoh(opaque));
+					cni_found = true;
 				}
 			}
+			this->batch_burst->add(std::move(packet));
 		}
 	}
 
@@ -578,6 +588,39 @@ bool SpotUpward::handleFrame(DvbFrame *frame, NetBurst **burst)
 }
 
 
+bool SpotUpward::isBatchFull() const
+{
+	return this->batch_burst &&
+	       this->batch_burst->length() >= max_batch_packets;
+}
+
+
+std::unique_ptr<NetBurst> SpotUpward::flushBatch()
+{
+	// apply the C/N of the window at once, only the latest one of each
+	// terminal matters for the MODCOD
+	this->input_sts->setRequiredCni(this->batch_cni_input);
+	this->output_sts->setRequiredCni(this->batch_cni_output);
+	return std::move(this->batch_burst);
+}
+
+
+bool SpotUpward::isTalScpc(tal_id_t tal_id) const
+{
+	return tal_id < this->is_tal_scpc.size() && this->is_tal_scpc[tal_id];
+}
+
+
+void SpotUpward::setTalScpc(tal_id_t tal_id)
+{
+	if(tal_id >= this->is_tal_scpc.size())
+	{
+		this->is_tal_scpc.resize(tal_id + 1, false);
+	}
+	this->is_tal_scpc[tal_id] = true;
+}
+
+
 void SpotUpward::handleFrameCni(DvbFrame *dvb_frame)
 {
 	double curr_cni = dvb_frame->getCn();
@@ -599,7 +642,11 @@ void SpotUpward::handleFrameCni(DvbFrame *dvb_frame)
 				    " value\n");
 				return;
 			}
-			break;
+			// the SAC is handled right away, it is more recent than
+			// the C/N of the batched frames
+			this->batch_cni_input.unset(tal_id);
+			this->setRequiredCniInput(tal_id, curr_cni);
+			return;
 		}
 		case EmulatedMessageType::DvbBurst:
 		{
@@ -640,7 +687,7 @@ void SpotUpward::handleFrameCni(DvbFrame *dvb_frame)
 			    "Wrong message type %u, this shouldn't happened", msg_type);
 			return;
 	}
-	this->setRequiredCniInput(tal_id, curr_cni);
+	this->batch_cni_input.set(tal_id, curr_cni);
 }
 
 
@@ -682,7 +729,7 @@ bool SpotUpward::onRcvLogonReq(DvbFrame *dvb_frame)
 
 	if(logon_req->getIsScpc())
 	{
-		this->is_tal_scpc.push_back(mac);
+		this->setTalScpc(mac);
 		// handle ST for FMT simulation
 		if(!(this->input_sts->isStPresent(mac) && this->output_sts->isStPresent(mac)))
 		{
@@ -727,6 +774,52 @@ bool SpotUpward::onRcvLogonReq(DvbFrame *dvb_frame)
 }
 
 
+bool SpotUpward::restoreCheckpoint(const NccCheckpoint &checkpoint)
+{
+	for(auto &&state: checkpoint.getRestoredTerminals())
+	{
+		const FmtDefinitionTable *input_modcod_def = state.is_scpc ?
+		                                             this->s2_modcod_def :
+		                                             this->rcs_modcod_def;
+		// the MODCOD definitions may have changed since the checkpoint
+		fmt_id_t input_modcod = state.input_modcod_id;
+		if(!input_modcod_def->doFmtIdExist(input_modcod))
+		{
+			input_modcod = input_modcod_def->getMaxId();
+		}
+		fmt_id_t output_modcod = state.output_modcod_id;
+		if(!this->s2_modcod_def->doFmtIdExist(output_modcod))
+		{
+			output_modcod = this->s2_modcod_def->getMaxId();
+		}
+
+		if(state.is_scpc)
+		{
+			this->setTalScpc(state.tal_id);
+		}
+		if(!this->input_sts->addTerminal(state.tal_id, input_modcod, input_modcod_def) ||
+		   !this->output_sts->addTerminal(state.tal_id, output_modcod, this->s2_modcod_def))
+		{
+			LOG(this->log_init_channel, LEVEL_ERROR,
+			    "failed to handle FMT for restored ST %u\n", state.tal_id);
+			return false;
+		}
+		if(this->saloha && !this->saloha->addTerminal(state.tal_id))
+		{
+			LOG(this->log_init_channel, LEVEL_ERROR,
+			    "Cannot add restored terminal %u in Slotted Aloha context\n",
+			    state.tal_id);
+			return false;
+		}
+	}
+
+	LOG(this->log_init_channel, LEVEL_NOTICE,
+	    "%zu terminals restored on spot %u\n",
+	    checkpoint.getRestoredTerminals().size(), this->spot_id);
+	return true;
+}
+
+
 void SpotUpward::updateStats(void)
 {
 	if(!this->doSendStats())
@@ -38,12 +38,16 @@
 #define SPOT_UPWARD_H
 
 #include <list>
+#include <memory>
+#include <vector>
 
 #include "DvbChannel.h"
+#include "StFmtSimu.h"
 
 
 class SlottedAlohaNcc;
 class StFmtSimuList;
+class NccCheckpoint;
 class PhysicStd;
 class NetBurst;
 
@@ -68,17 +72,37 @@ class SpotUpward: public DvbChannel, public DvbFmt
 		bool onInit();
 
 
+		/// The maximum number of packets batched before a flush
+		static constexpr unsigned int max_batch_packets = 256;
+
 		/**
-		 * @brief Handle a DVB frame
+		 * @brief Handle a DVB frame, its packets are appended to the
+		 *        burst batched until the next flush
 		 *
 		 * @param frame  The frame
-		 * @param burst  OUT: the burst of packets
 		 * @return true on success, false otherwise
 		 */
-		bool handleFrame(DvbFrame *frame, NetBurst **burst);
+		bool handleFrame(DvbFrame *frame);
 
 		/**
-		 * @brief get CNI in a frame
+		 * @brief Whether the batched burst should be flushed before the
+		 *        next frame
+		 *
+		 * @return true if the batched burst is full
+		 */
+		bool isBatchFull() const;
+
+		/**
+		 * @brief Apply the C/N updates received since the last flush
+		 *        and get the burst of packets batched meanwhile
+		 *
+		 * @return the batched burst, nullptr if no packet was received
+		 */
+		std::unique_ptr<NetBurst> flushBatch();
+
+		/**
+		 * @brief get CNI in a frame, the CNI of the data frames is
+		 *        applied at the next flush
 		 *
 		 * @param dvb_frame the Dvb Frame corrupted
 		 */
@@ -104,6 +128,15 @@ class SpotUpward: public DvbChannel, public DvbFmt
 		 */
 		bool onRcvLogonReq(DvbFrame *dvb_frame);
 
+		/**
+		 *  @brief Register the terminals of a checkpoint again for the
+		 *         FMT simulation and Slotted Aloha, with their MODCOD
+		 *
+		 *  @param checkpoint  The checkpoint
+		 *  @return true on success, false otherwise
+		 */
+		bool restoreCheckpoint(const NccCheckpoint &checkpoint);
+
 		/**
 		 *  @brief Handle a Slotted Aloha Data Frame
 		 *
@@ -198,8 +231,32 @@ class SpotUpward: public DvbChannel, public DvbFmt
 		/// FMT groups for up/return
 		fmt_groups_t ret_fmt_groups;
 
-		/// is terminal scpc map
-		std::list<tal_id_t> is_tal_scpc;
+		/**
+		 * @brief Whether a terminal is in SCPC mode
+		 *
+		 * @param tal_id  The terminal ID
+		 * @return true if the terminal logged on in SCPC mode
+		 */
+		bool isTalScpc(tal_id_t tal_id) const;
+
+		/**
+		 * @brief Register a terminal in SCPC mode
+		 *
+		 * @param tal_id  The terminal ID
+		 */
+		void setTalScpc(tal_id_t tal_id);
+
+		/// is terminal scpc map, indexed by terminal ID
+		std::vector<bool> is_tal_scpc;
+
+		/// The packets received since the last flush
+		std::unique_ptr<NetBurst> batch_burst;
+
+		/// The C/N of the data frames received since the last flush
+		StFmtCniBatch batch_cni_input;
+
+		/// The C/N reported by the SCPC terminals since the last flush
+		StFmtCniBatch batch_cni_output;
 
 		// Output probes and stats
 		// Rates
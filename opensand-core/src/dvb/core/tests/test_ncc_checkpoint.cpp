@@ -0,0 +1,267 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file test_ncc_checkpoint.cpp
+ * @brief Check the terminal states restored from a checkpoint snapshot
+ *        and journal, when the last journal entry is truncated
+ * @author Viveris Technologies
+ */
+
+
+#include "NccCheckpoint.h"
+
+#include <opensand_output/Output.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+#define CHECK(condition) do \
+{ \
+	if(!(condition)) \
+	{ \
+		fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+		return false; \
+	} \
+} while(0)
+
+
+typedef std::vector<ncc_terminal_state_t> states_t;
+
+
+static states_t createStates(unsigned int count)
+{
+	states_t states;
+	for(tal_id_t tal_id = 1; tal_id <= count; ++tal_id)
+	{
+		ncc_terminal_state_t state{};
+		state.tal_id = tal_id;
+		state.is_scpc = tal_id % 5 == 0;
+		state.input_modcod_id = 1 + tal_id % 7;
+		state.output_modcod_id = 2 + tal_id % 11;
+		state.has_dama = !state.is_scpc;
+		if(state.has_dama)
+		{
+			state.dama.cra_kbps = 100 + tal_id;
+			state.dama.max_rbdc_kbps = 2000;
+			state.dama.max_vbdc_kb = 500;
+			state.dama.rbdc_request_kbps = 10 * tal_id;
+			state.dama.rbdc_credit = 0.25 * tal_id;
+			state.dama.rbdc_timer_sf = 8;
+			state.dama.vbdc_request_kb = tal_id;
+		}
+		states.push_back(state);
+	}
+	return states;
+}
+
+static bool isSame(const states_t &states1, const states_t &states2)
+{
+	CHECK(states1.size() == states2.size());
+	for(std::size_t index = 0; index < states1.size(); ++index)
+	{
+		const ncc_terminal_state_t &state1 = states1[index];
+		const ncc_terminal_state_t &state2 = states2[index];
+		CHECK(state1.tal_id == state2.tal_id);
+		CHECK(state1.is_scpc == state2.is_scpc);
+		CHECK(state1.input_modcod_id == state2.input_modcod_id);
+		CHECK(state1.output_modcod_id == state2.output_modcod_id);
+		CHECK(state1.has_dama == state2.has_dama);
+		CHECK(state1.dama.cra_kbps == state2.dama.cra_kbps);
+		CHECK(state1.dama.max_rbdc_kbps == state2.dama.max_rbdc_kbps);
+		CHECK(state1.dama.max_vbdc_kb == state2.dama.max_vbdc_kb);
+		CHECK(state1.dama.rbdc_request_kbps == state2.dama.rbdc_request_kbps);
+		CHECK(state1.dama.rbdc_credit == state2.dama.rbdc_credit);
+		CHECK(state1.dama.rbdc_timer_sf == state2.dama.rbdc_timer_sf);
+		CHECK(state1.dama.vbdc_request_kb == state2.dama.vbdc_request_kb);
+	}
+	return true;
+}
+
+static off_t getSize(const std::string &path)
+{
+	struct stat info;
+	return stat(path.c_str(), &info) == 0 ? info.st_size : -1;
+}
+
+/**
+ * @brief Wait for the writer thread to change the size of a file
+ *
+ * @param path      The file
+ * @param previous  The size before the write
+ * @return the new size, -1 if still unchanged after some time
+ */
+static off_t waitWrite(const std::string &path, off_t previous)
+{
+	for(unsigned int retry = 0; retry < 500; ++retry)
+	{
+		off_t size = getSize(path);
+		if(size != previous)
+		{
+			return size;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return -1;
+}
+
+/**
+ * @brief Hand states over to a checkpoint
+ */
+static void push(NccCheckpoint &checkpoint, const states_t &states, time_sf_t superframe_sf)
+{
+	states_t buffer = states;
+	checkpoint.push(buffer, superframe_sf);
+}
+
+/**
+ * @brief Restore the states of a checkpoint, without writing it
+ */
+static bool restore(const std::string &path, states_t &states)
+{
+	NccCheckpoint checkpoint{path, 10};
+	CHECK(checkpoint.init());
+	states = checkpoint.getRestoredTerminals();
+	return true;
+}
+
+
+/**
+ * @brief Write a snapshot and two journal entries, then restore them
+ *        from the whole journal and from truncated ones
+ */
+static bool checkRestore(const std::string &dir)
+{
+	std::string path = dir + "/ncc.checkpoint";
+	std::string journal_path = path + ".journal";
+
+	// the snapshot, then an updated terminal and a removed one in the
+	// first entry, a modified request and a new terminal in the second one
+	states_t snapshot = createStates(30);
+	states_t first = snapshot;
+	first[3].dama.rbdc_request_kbps = 1234;
+	first[3].dama.rbdc_credit = 4.5;
+	first.erase(first.begin() + 7);
+	states_t second = first;
+	second[10].dama.vbdc_request_kb = 321;
+	second[10].output_modcod_id = 27;
+	ncc_terminal_state_t new_terminal = createStates(31).back();
+	new_terminal.is_scpc = true;
+	new_terminal.has_dama = false;
+	new_terminal.dama = dama_terminal_state_t{};
+	second.push_back(new_terminal);
+
+	off_t first_size;
+	off_t second_size;
+	{
+		NccCheckpoint checkpoint{path, 10};
+		CHECK(checkpoint.init());
+		CHECK(checkpoint.getRestoredTerminals().empty());
+		CHECK(checkpoint.isDue(20) && !checkpoint.isDue(25));
+
+		push(checkpoint, snapshot, 10);
+		CHECK(waitWrite(path, -1) > 0);
+		CHECK(getSize(journal_path) == 0);
+		push(checkpoint, first, 20);
+		first_size = waitWrite(journal_path, 0);
+		CHECK(first_size > 0);
+		// an unchanged state writes nothing
+		push(checkpoint, first, 30);
+		push(checkpoint, second, 40);
+		second_size = waitWrite(journal_path, first_size);
+		CHECK(second_size > first_size);
+	}
+	CHECK(getSize(journal_path) == second_size);
+
+	states_t restored;
+	CHECK(restore(path, restored));
+	CHECK(isSame(restored, second));
+
+	// the second entry is cut in its records, then in its length
+	CHECK(truncate(journal_path.c_str(), second_size - 3) == 0);
+	CHECK(restore(path, restored));
+	CHECK(isSame(restored, first));
+	CHECK(truncate(journal_path.c_str(), first_size + 2) == 0);
+	CHECK(restore(path, restored));
+	CHECK(isSame(restored, first));
+
+	// the first entry is cut after its header
+	CHECK(truncate(journal_path.c_str(), 14) == 0);
+	CHECK(restore(path, restored));
+	CHECK(isSame(restored, snapshot));
+
+	// the next NCC starts with a new snapshot and empties the journal
+	{
+		NccCheckpoint checkpoint{path, 10};
+		CHECK(checkpoint.init());
+		CHECK(isSame(checkpoint.getRestoredTerminals(), snapshot));
+		push(checkpoint, second, 50);
+		CHECK(waitWrite(journal_path, 14) == 0);
+	}
+	CHECK(restore(path, restored));
+	CHECK(isSame(restored, second));
+
+	// a corrupted snapshot is ignored
+	CHECK(truncate(path.c_str(), 20) == 0);
+	CHECK(restore(path, restored));
+	CHECK(restored.empty());
+
+	unlink(path.c_str());
+	unlink(journal_path.c_str());
+	return true;
+}
+
+
+int main()
+{
+	auto output = Output::Get();
+	output->configureTerminalOutput();
+	output->finalizeConfiguration();
+
+	char dir[] = "/tmp/test_ncc_checkpoint.XXXXXX";
+	if(mkdtemp(dir) == nullptr)
+	{
+		perror("mkdtemp");
+		return 1;
+	}
+	bool success = checkRestore(dir);
+	rmdir(dir);
+	if(!success)
+	{
+		return 1;
+	}
+
+	printf("NCC checkpoint restore checked\n");
+	return 0;
+}
@@ -37,44 +37,252 @@
 
 #include "OpenSandCore.h"
 
-#include <opensand_output/OutputLog.h>
+#include <opensand_output/Output.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <type_traits>
+#include <vector>
+
 
 /**
  * @class CircularBuffer
  * @brief Manage a circular buffer with >= 1 elem, or a buffer saving only
  *        last value
+ *
+ * The sum of the values is kept up to date on each insertion in a wider
+ * type than the values, so the sum and the mean are constant-time.
+ *
+ * @tparam T         The type of the values
+ * @tparam Capacity  The buffer size if it is known at compile time,
+ *                   0 to give it to the constructor
  */
+template<typename T, std::size_t Capacity = 0>
 class CircularBuffer
 {
+public:
+	/// The type of the sum of the values
+	typedef typename std::conditional<std::is_floating_point<T>::value, double,
+	        typename std::conditional<std::is_signed<T>::value, int64_t,
+	                                  uint64_t>::type>::type sum_t;
+
+	/**
+	 * Create and initialize the circular buffer
+	 *
+	 * @param buffer_size Circular buffer size, ignored with a compile-time
+	 *                    capacity; 0 to only save the last value
+	 */
+	CircularBuffer(size_t buffer_size = Capacity);
+
+	void Update(T new_value);
+	T GetLastValue() const;
+	T GetPreviousValue() const;
+	sum_t GetMean() const;
+	T GetMin() const;
+	sum_t GetSum() const;
+	sum_t GetPartialSumFromPrevious(int value_number) const;
+	T GetValueIndex(int i) const;
+	void Debug() const;
+
 private:
+	/// The storage of the values, sized at compile-time if possible
+	typedef typename std::conditional<Capacity != 0,
+	                                  std::array<T, Capacity ? Capacity : 1>,
+	                                  std::vector<T>>::type values_t;
+
 	/// if size = 0 --> flag = true --> only last value is saved, sum = 0
 	bool save_only_last_value;
 
-	size_t size;              ///< circular buffer max size
+	size_t size;        ///< circular buffer max size
 	size_t index;       ///< current index
 	size_t nbr_values;  ///< current nb of elem
-	rate_kbps_t sum;    ///< sum of all values contained in the circular buffer
-	rate_kbps_t min_value;    ///< min value contained in the circular buffer
-	rate_kbps_t *values; ///< circular buffer array
-
-protected:
-	// Output Log
-	std::shared_ptr<OutputLog> log_circular_buffer;
+	sum_t sum;          ///< sum of all values contained in the circular buffer
+	values_t values;    ///< circular buffer array
 
-public:
+	template<std::size_t N>
+	static void initValues(std::array<T, N> &values, size_t)
+	{
+		values.fill(T(0));
+	};
 
-	CircularBuffer(size_t buffer_size);
-	virtual ~CircularBuffer();
-
-	void Update(rate_kbps_t new_value);
-	rate_kbps_t GetLastValue();
-	rate_kbps_t GetPreviousValue();
-	rate_kbps_t GetMean();
-	rate_kbps_t GetMin();
-	rate_kbps_t GetSum();
-	rate_kbps_t GetPartialSumFromPrevious(int value_number);
-	rate_kbps_t GetValueIndex(int i);
-	void Debug();
+	static void initValues(std::vector<T> &values, size_t size)
+	{
+		values.assign(size, T(0));
+	};
 };
 
+
+template<typename T, std::size_t Capacity>
+CircularBuffer<T, Capacity>::CircularBuffer(size_t buffer_size):
+	save_only_last_value(false),
+	size(Capacity ? Capacity : buffer_size),
+	index(0),
+	nbr_values(0),
+	sum(0),
+	values()
+{
+	if(this->size == 0)
+	{
+		this->save_only_last_value = true;
+		this->size = 1;
+		DFLTLOG(LEVEL_NOTICE,
+		        "Circular buffer size was %zu --> set to %zu, with "
+		        " only saving last value option (sum = 0)\n",
+		        buffer_size, this->size);
+	}
+
+	this->index = this->size - 1;
+	initValues(this->values, this->size);
+}
+
+
+/**
+ * Update the circular buffer : insert a new value
+ *
+ * @param value New value to be inserted
+ */
+template<typename T, std::size_t Capacity>
+void CircularBuffer<T, Capacity>::Update(T value)
+{
+	// number of value update
+	this->nbr_values = std::min(this->nbr_values + 1, this->size);
+
+	// circular buffer index update
+	if(++this->index == this->size)
+	{
+		this->index = 0;
+	}
+
+	// sum update, the overwritten value leaves it
+	this->sum = this->sum - this->values[this->index] + value;
+
+	// new value insertion
+	this->values[this->index] = value;
+}
+
+/**
+ * Get the circular buffer last, i.e. one buffer turn before, value (returns 0
+ * if the buffer is not fullfiled yet)
+ *
+ * @return Last value
+ */
+template<typename T, std::size_t Capacity>
+T CircularBuffer<T, Capacity>::GetLastValue() const
+{
+	return this->values[(this->index + 1) % this->size];
+}
+
+/**
+ * Get the circular buffer previous, i.e. last inserted, value (returns 0 if
+ * the buffer is empty)
+ *
+ * @return Previous value
+ */
+template<typename T, std::size_t Capacity>
+T CircularBuffer<T, Capacity>::GetPreviousValue() const
+{
+	return this->values[this->index];
+}
+
+/**
+ * Get the circular buffer mean value (returns 0 if the buffer is empty)
+ *
+ * @return Mean value
+ */
+template<typename T, std::size_t Capacity>
+typename CircularBuffer<T, Capacity>::sum_t CircularBuffer<T, Capacity>::GetMean() const
+{
+	if(this->nbr_values == 0)
+	{
+		return 0;
+	}
+	return this->sum / (sum_t)this->nbr_values;
+}
+
+/**
+ * Get the circular buffer min value, looked for in the buffer
+ * (returns 0 if the buffer is empty)
+ *
+ * @return Min value
+ */
+template<typename T, std::size_t Capacity>
+T CircularBuffer<T, Capacity>::GetMin() const
+{
+	if(this->nbr_values == 0)
+	{
+		return 0;
+	}
+	// the values are the first ones until the buffer is filled
+	return *std::min_element(this->values.begin(),
+	                         this->values.begin() + this->nbr_values);
+}
+
+/**
+ * Get the circular buffer sum value
+ *
+ * @return Sum value
+ */
+template<typename T, std::size_t Capacity>
+typename CircularBuffer<T, Capacity>::sum_t CircularBuffer<T, Capacity>::GetSum() const
+{
+	if(this->save_only_last_value)
+	{
+		return 0;
+	}
+	return this->sum;
+}
+
+/**
+ * Get the sum of a part of the value stored in the circular buffer starting
+ * from the newest value (return 0 if the buffer is empty)
+ *
+ * @return the partial sum
+ */
+template<typename T, std::size_t Capacity>
+typename CircularBuffer<T, Capacity>::sum_t
+CircularBuffer<T, Capacity>::GetPartialSumFromPrevious(int value_number) const
+{
+	sum_t partial_sum = 0;
+	for(int i = 0; i < value_number; i++)
+	{
+		partial_sum += this->GetValueIndex(-i);
+	}
+	return partial_sum;
+}
+
+/**
+ * Get the value at an index relative to the newest value
+ * (return 0 if the buffer is empty)
+ *
+ * @return value at index
+ */
+template<typename T, std::size_t Capacity>
+T CircularBuffer<T, Capacity>::GetValueIndex(int i) const
+{
+	long position = ((long)this->index + i) % (long)this->size;
+	if(position < 0)
+	{
+		position += this->size;
+	}
+	return this->values[position];
+}
+
+/**
+ * Trace the circular buffer contents
+ */
+template<typename T, std::size_t Capacity>
+void CircularBuffer<T, Capacity>::Debug() const
+{
+	fprintf(stderr, "CB : size %zu index %zu nbr_alues %zu min_value %g sum %g\n",
+	        this->size, this->index, this->nbr_values,
+	        (double)this->GetMin(), (double)this->sum);
+	fprintf(stderr, "CB : ");
+	for(size_t i = 0; i < this->size; i++)
+	{
+		fprintf(stderr, "%g ", (double)this->values[i]);
+	}
+	fprintf(stderr, "\n");
+}
+
 #endif
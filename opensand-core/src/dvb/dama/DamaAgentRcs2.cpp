@@ -93,7 +93,7 @@ bool DamaAgentRcs2::init(spot_id_t)
 		// (in frame number)
 		// NB: if size = 0, only last req is saved and sum is always 0
 		this->rbdc_request_buffer =
-			new CircularBuffer((size_t) this->msl_sf / this->sync_period_sf);
+			new CircularBuffer<rate_kbps_t>((size_t) this->msl_sf / this->sync_period_sf);
 		if(this->rbdc_request_buffer == nullptr)
 		{
 			LOG(this->log_init, LEVEL_ERROR,
@@ -136,6 +136,16 @@ bool DamaAgentRcs2::init(spot_id_t)
 		return false;
 	}
 
+	std::string fifo_scheduling = "Strict Priority";
+	auto dama = OpenSandModelConf::Get()->getProfileData()->getComponent("access")->getComponent("dama");
+	OpenSandModelConf::extractParameterData(dama->getParameter("fifo_scheduling"), fifo_scheduling);
+	if(!this->ret_schedule->setDiscipline(fifo_scheduling))
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "Cannot set the return link fifo scheduling\n");
+		return false;
+	}
+
 	this->modcod_id = this->ret_modcod_def->getMaxId();
 	fmt_def = this->ret_modcod_def->getDefinition(this->modcod_id);
 	if(fmt_def != NULL)
@@ -155,14 +165,8 @@ bool DamaAgentRcs2::init(spot_id_t)
 
 bool DamaAgentRcs2::processOnFrameTick()
 {
-	FmtDefinition *fmt_def;
-	vol_b_t length_b;
-
 	this->remaining_allocation_b = this->dynamic_allocation_kb * 1000;
-	this->burst_length_b = this->converter->getPacketBitLength();
-
-	fmt_def = this->ret_modcod_def->getDefinition(this->modcod_id);
-	if(fmt_def == NULL)
+	if(!this->getBurstLength(this->burst_length_b))
 	{
 		LOG(this->log_schedule, LEVEL_WARNING,
 		    "SF#%u: no MODCOD %u found",
@@ -170,14 +174,25 @@ bool DamaAgentRcs2::processOnFrameTick()
 		    this->modcod_id);
 		return false;
 	}
+	return true;
+}
 
-	length_b = this->burst_length_b;
-	this->burst_length_b = fmt_def->removeFec(this->burst_length_b);
+bool DamaAgentRcs2::getBurstLength(vol_b_t &length_b) const
+{
+	FmtDefinition *fmt_def;
+
+	fmt_def = this->ret_modcod_def->getDefinition(this->modcod_id);
+	if(fmt_def == NULL)
+	{
+		return false;
+	}
+
+	length_b = fmt_def->removeFec(this->converter->getPacketBitLength());
 	LOG(this->log_schedule, LEVEL_DEBUG,
 	    "SF#%u: burst length without FEC %u b, with FEC %u b",
 	    this->current_superframe_sf,
-	    this->burst_length_b,
-	    length_b);
+	    length_b,
+	    this->converter->getPacketBitLength());
 	return true;
 }
 
@@ -276,6 +291,18 @@ bool DamaAgentRcs2::hereIsTTP(Ttp *ttp)
 	LOG(this->log_ttp, LEVEL_INFO,
 	    "SF#%u: allocated = %u kbits/s\n",
 	    ttp->getSuperframeCount(), alloc_kbps);
+
+	// the allocation and MODCOD are known until the next frame tick,
+	// build the bursts now rather than in the tick
+	vol_b_t burst_length_b;
+	if(this->getBurstLength(burst_length_b) &&
+	   !this->ret_schedule->prepare(burst_length_b, this->allocated_kb * 1000))
+	{
+		LOG(this->log_ttp, LEVEL_WARNING,
+		    "SF#%u: cannot prepare the bursts, they will be "
+		    "built at the frame tick\n",
+		    ttp->getSuperframeCount());
+	}
 	return true;
 }
 
@@ -37,7 +37,7 @@
 #define _DAMA_AGENT_RCS2_H_
 
 #include "DamaAgent.h"
-#include "UnitConverter.h"
+#include "UnitConverterFixedSymbolLength.h"
 #include "ReturnSchedulingRcs2.h"
 #include "CircularBuffer.h"
 #include "FmtDefinitionTable.h"
@@ -76,13 +76,14 @@ protected:
 	vol_b_t burst_length_b;
 
 	/** Circular buffer to store previous RBDC requests */
-	CircularBuffer *rbdc_request_buffer;
+	CircularBuffer<rate_kbps_t> *rbdc_request_buffer;
 
 	/** Uplink Scheduling functions */
 	ReturnSchedulingRcs2 *ret_schedule;
 
-	/** Unit converter */
-	UnitConverter *converter;
+	/** Unit converter, held through its own type so that its conversions
+	    are inlined in the requests computation */
+	UnitConverterFixedSymbolLength *converter;
 
 	/** RBDC timer */
 	time_sf_t rbdc_timer_sf;
@@ -105,6 +106,14 @@ protected:
 	 */
 	vol_b_t getMacBufferLength(ReturnAccessType cr_type);
 
+	/**
+	 * @brief Get the burst payload length for the current MODCOD
+	 *
+	 * @param length_b  OUT: the burst length without FEC in bits
+	 * @return true on success, false if the MODCOD is unknown
+	 */
+	bool getBurstLength(vol_b_t &length_b) const;
+
 	/**
 	 * @brief Utility function to get total number of "last arrived" packets
 	 *        (since last SAC) of all MAC fifos associated to the concerned CR type
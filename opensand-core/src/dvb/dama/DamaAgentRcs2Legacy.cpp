@@ -57,7 +57,7 @@ rate_kbps_t DamaAgentRcs2Legacy::computeRbdcRequest()
 	rate_kbps_t rbdc_request_kbps;
 	vol_b_t rbdc_length_b;
 	vol_b_t rbdc_pkt_arrival_b;
-	rate_kbps_t rbdc_req_in_previous_msl_kbps;
+	uint32_t rbdc_req_in_previous_msl_kbps;
 	double req_kbps = 0.0;
 
 	/* get data length of outstanding packets in RBDC related MAC FIFOs */
@@ -38,6 +38,7 @@
 
 #include "OpenSandModelConf.h"
 #include <opensand_output/Output.h>
+#include <opensand_rt/RtTrace.h>
 
 #include <assert.h>
 #include <math.h>
@@ -49,6 +50,10 @@ DamaCtrl::DamaCtrl(spot_id_t spot):
 	is_parent_init(false),
 	terminals(), // TODO not very useful, they are stored in categories
 	current_superframe_sf(0),
+	look_ahead_sf(0),
+	plans(),
+	sparse_ttp(false),
+	current_plan(),
 	frame_duration_ms(0),
 	rbdc_timeout_sf(0),
 	fca_kbps(0),
@@ -61,6 +66,7 @@ DamaCtrl::DamaCtrl(spot_id_t spot):
 	input_sts(NULL),
 	input_modcod_def(NULL),
 	simulated(false),
+	event_file(NULL),
 	spot_id(spot)
 {
 	// Output Log
@@ -106,7 +112,7 @@ bool DamaCtrl::initParent(time_ms_t frame_duration_ms,
                           TerminalCategories<TerminalCategoryDama> categories,
                           TerminalMapping<TerminalCategoryDama> terminal_affectation,
                           TerminalCategoryDama *default_category,
-                          const StFmtSimuList *const input_sts,
+                          StFmtSimuList *const input_sts,
                           FmtDefinitionTable *const input_modcod_def,
                           bool simulated)
 {
@@ -206,33 +212,49 @@ bool DamaCtrl::initOutput()
 	    output->registerProbe<int>(output_prefix + "Global.ST number", "", true, SAMPLE_LAST);
 	this->gw_st_num = 0;
 
+	// The probes of the STs, only registered once they have a value,
+	// the logged on terminals that never report cost no probe
+	auto st_family = [this](const std::string &name, const std::string &unit,
+	                        sample_type_t type)
+	{
+		return std::make_unique<ProbeFamily<int>>(this->output_prefix + "st",
+		                                          "_allocation." + name,
+		                                          unit, true, type);
+	};
+	this->family_st_cra_alloc = st_family("CRA allocation", "Kbits/s", SAMPLE_MAX);
+	this->family_st_rbdc_max = st_family("RBDC max", "Kbits/s", SAMPLE_MAX);
+	this->family_st_rbdc_alloc = st_family("RBDC allocation", "Kbits/s", SAMPLE_MAX);
+	this->family_st_vbdc_alloc = st_family("VBDC allocation", "Kbits", SAMPLE_SUM);
+	// only create FCA probe if it is enabled
+	if(this->fca_kbps != 0)
+	{
+		this->family_st_fca_alloc = st_family("FCA allocation", "Kbits/s", SAMPLE_MAX);
+	}
+
 	// Register output probes for simulated STs
 	if(this->simulated)
 	{
 		// tal_id 0 is for GW so it is unused
 		tal_id_t tal_id = 0;
-		auto probe_cra = output->registerProbe<int>(output_prefix + "Simulated_ST.CRA allocation",
-		                                            "Kbits/s", true, SAMPLE_MAX);
-		this->probes_st_cra_alloc.emplace(tal_id, probe_cra);
-
-		auto probe_rbdc_max = output->registerProbe<int>(output_prefix + "Simulated_ST.RBDC max",
-		                                                 "Kbits/s", true, SAMPLE_MAX);
-		this->probes_st_rbdc_max.emplace(tal_id, probe_rbdc_max);
-
-		auto probe_rbdc = output->registerProbe<int>(output_prefix + "Simulated_ST.RBDC allocation",
-		                                             "Kbits/s", true, SAMPLE_MAX);
-		this->probes_st_rbdc_alloc.emplace(tal_id, probe_rbdc);
-
-		auto probe_vbdc = output->registerProbe<int>(output_prefix + "Simulated_ST.VBDC allocation",
-		                                             "Kbits", true, SAMPLE_SUM);
-		this->probes_st_vbdc_alloc.emplace(tal_id, probe_vbdc);
+		auto simulated_probe = [this, tal_id](ProbeListPerTerminal &probes,
+		                                      const std::string &name,
+		                                      const std::string &unit,
+		                                      sample_type_t type)
+		{
+			auto probe = this->probes_simulated.get(this->output_prefix + "Simulated_ST." + name,
+			                                        unit, true, type);
+			probe.create();
+			probes.emplace(tal_id, probe);
+		};
+		simulated_probe(this->probes_st_cra_alloc, "CRA allocation", "Kbits/s", SAMPLE_MAX);
+		simulated_probe(this->probes_st_rbdc_max, "RBDC max", "Kbits/s", SAMPLE_MAX);
+		simulated_probe(this->probes_st_rbdc_alloc, "RBDC allocation", "Kbits/s", SAMPLE_MAX);
+		simulated_probe(this->probes_st_vbdc_alloc, "VBDC allocation", "Kbits", SAMPLE_SUM);
 
 		// only create FCA probe if it is enabled
 		if(this->fca_kbps != 0)
 		{
-			auto probe_fca = output->registerProbe<int>(output_prefix + "Simulated_ST.FCA allocation",
-			                                            "Kbits/s", true, SAMPLE_MAX);
-			this->probes_st_fca_alloc.emplace(tal_id, probe_fca);
+			simulated_probe(this->probes_st_fca_alloc, "FCA allocation", "Kbits/s", SAMPLE_MAX);
 		}
 	}
 
@@ -313,33 +335,18 @@ bool DamaCtrl::hereIsLogon(const LogonRequest *logon)
 
 		if(tal_id < BROADCAST_TAL_ID)
 		{
-			auto output = Output::Get();
-
-			auto prefix = output_prefix + "st" + std::to_string(tal_id) + "_allocation.";
-
-			// Output probes and stats
-			auto probe_cra = output->registerProbe<int>(prefix + "CRA allocation",
-			                                            "Kbits/s", true, SAMPLE_MAX);
-			this->probes_st_cra_alloc.emplace(tal_id, probe_cra);
-
-			auto probe_rbdc_max = output->registerProbe<int>(prefix + "RBDC max",
-			                                                 "Kbits/s", true, SAMPLE_MAX);
-			this->probes_st_rbdc_max.emplace(tal_id, probe_rbdc_max);
+			std::string key = std::to_string(tal_id);
 
-			auto probe_rbdc = output->registerProbe<int>(prefix + "RBDC allocation",
-			                                             "Kbits/s", true, SAMPLE_MAX);
-			this->probes_st_rbdc_alloc.emplace(tal_id, probe_rbdc);
-
-			auto probe_vbdc = output->registerProbe<int>(prefix + "VBDC allocation",
-			                                             "Kbits", true, SAMPLE_SUM);
-			this->probes_st_vbdc_alloc.emplace(tal_id, probe_vbdc);
+			// Output probes and stats, registered on their first value
+			this->probes_st_cra_alloc.emplace(tal_id, this->family_st_cra_alloc->get(key));
+			this->probes_st_rbdc_max.emplace(tal_id, this->family_st_rbdc_max->get(key));
+			this->probes_st_rbdc_alloc.emplace(tal_id, this->family_st_rbdc_alloc->get(key));
+			this->probes_st_vbdc_alloc.emplace(tal_id, this->family_st_vbdc_alloc->get(key));
 
 			// only create FCA probe if it is enabled
 			if(this->fca_kbps != 0)
 			{
-				auto probe_fca = output->registerProbe<int>(prefix + "FCA allocation",
-				                                            "Kbits/s", true, SAMPLE_MAX);
-				this->probes_st_fca_alloc.emplace(tal_id, probe_fca);
+				this->probes_st_fca_alloc.emplace(tal_id, this->family_st_fca_alloc->get(key));
 			}
 		}
 
@@ -443,10 +450,141 @@ bool DamaCtrl::hereIsLogoff(const Logoff *logoff)
 	return true;
 }
 
+bool DamaCtrl::getTerminalState(tal_id_t tal_id, dama_terminal_state_t &state) const
+{
+	auto it = this->terminals.find(tal_id);
+	if(it == this->terminals.end())
+	{
+		return false;
+	}
+	it->second->getState(state);
+	return true;
+}
+
+bool DamaCtrl::restoreTerminal(tal_id_t tal_id, const dama_terminal_state_t &state)
+{
+	LogonRequest logon(tal_id, state.cra_kbps, state.max_rbdc_kbps, state.max_vbdc_kb);
+	if(!this->hereIsLogon(&logon))
+	{
+		return false;
+	}
+
+	auto it = this->terminals.find(tal_id);
+	if(it == this->terminals.end())
+	{
+		// the terminal category does not use DAMA anymore
+		return true;
+	}
+	it->second->setState(state);
+
+	// the requests are served before the terminal sends any new SAC
+	if(state.rbdc_request_kbps > 0)
+	{
+		this->enable_rbdc = true;
+	}
+	if(state.vbdc_request_kb > 0)
+	{
+		this->enable_vbdc = true;
+	}
+	LOG(this->log_logon, LEVEL_INFO,
+	    "ST%u restored with RBDC %u kb/s and VBDC %u kb requests\n",
+	    tal_id, state.rbdc_request_kbps, state.vbdc_request_kb);
+	return true;
+}
+
 bool DamaCtrl::runOnSuperFrameChange(time_sf_t superframe_number_sf)
 {
+	RtTrace::Span span{"dama.superframe"};
 	this->current_superframe_sf = superframe_number_sf;
 
+	if(this->look_ahead_sf > 0)
+	{
+		auto plan_it = this->plans.find(superframe_number_sf);
+		if(plan_it != this->plans.end())
+		{
+			// computed ahead, only the late requests are left to apply
+			this->current_plan = std::move(plan_it->second);
+			this->plans.erase(this->plans.begin(), std::next(plan_it));
+			this->correctPlan(this->current_plan);
+			return true;
+		}
+		// on start or after a reconfiguration
+		this->plans.erase(this->plans.begin(),
+		                  this->plans.upper_bound(superframe_number_sf));
+		LOG(this->log_super_frame_tick, LEVEL_INFO,
+		    "SF#%u: allocations not computed ahead, compute them now\n",
+		    this->current_superframe_sf);
+	}
+
+	if(!this->computeSuperFrame())
+	{
+		return false;
+	}
+	if(this->look_ahead_sf > 0)
+	{
+		this->current_plan = dama_plan_t();
+		this->savePlan(this->current_plan);
+	}
+	return true;
+}
+
+bool DamaCtrl::runAhead(time_sf_t superframe_number_sf)
+{
+	if(this->look_ahead_sf == 0)
+	{
+		return true;
+	}
+
+	RtTrace::Span span{"dama.ahead"};
+	time_sf_t superframe_sf = this->current_superframe_sf;
+	time_sf_t target_sf = superframe_number_sf + this->look_ahead_sf;
+	bool ret = true;
+
+	// each superframe up to the look-ahead is computed once, in order,
+	// usually only the last one is missing
+	for(time_sf_t next_sf = superframe_number_sf + 1; next_sf <= target_sf; ++next_sf)
+	{
+		if(this->plans.find(next_sf) != this->plans.end())
+		{
+			continue;
+		}
+		this->current_superframe_sf = next_sf;
+		if(!this->computeSuperFrame())
+		{
+			ret = false;
+			break;
+		}
+		this->savePlan(this->plans[next_sf]);
+	}
+	this->current_superframe_sf = superframe_sf;
+	return ret;
+}
+
+void DamaCtrl::setLookAhead(time_sf_t superframes)
+{
+	this->look_ahead_sf = superframes;
+	this->plans.clear();
+}
+
+void DamaCtrl::setSparseTtp(bool sparse)
+{
+	this->sparse_ttp = sparse;
+}
+
+void DamaCtrl::addLateRequest(tal_id_t tal_id)
+{
+	for(auto &&plan_it: this->plans)
+	{
+		std::vector<tal_id_t> &late_requests = plan_it.second.late_requests;
+		if(late_requests.empty() || late_requests.back() != tal_id)
+		{
+			late_requests.push_back(tal_id);
+		}
+	}
+}
+
+bool DamaCtrl::computeSuperFrame()
+{
 	// reset capacity of carriers
 	if(!this->resetCarriersCapacity())
 	{
@@ -474,12 +612,13 @@ bool DamaCtrl::runOnSuperFrameChange(time_sf_t superframe_number_sf)
 		return false;
 	}
 
-	return 0;
+	return true;
 }
 
 
 bool DamaCtrl::computeTerminalsAllocations()
 {
+	RtTrace::Span span{"dama.allocations"};
 	DamaTerminalList::iterator tal_it;
 
 	// reset the terminals allocations
@@ -507,12 +646,12 @@ bool DamaCtrl::computeTerminalsAllocations()
 			tal_id_t tal_id = tal_it->first;
 			if(tal_id < BROADCAST_TAL_ID)
 			{
-				this->probes_st_rbdc_alloc[tal_id]->put(0);
+				this->probes_st_rbdc_alloc[tal_id].putNonZero(0);
 			}
 		}
 		if(this->simulated)
 		{
-			this->probes_st_rbdc_alloc[0]->put(0);
+			this->probes_st_rbdc_alloc[0].put(0);
 		}
 		this->probe_gw_rbdc_req_num->put(0);
 		this->probe_gw_rbdc_req_size->put(0);
@@ -534,12 +673,12 @@ bool DamaCtrl::computeTerminalsAllocations()
 			tal_id_t tal_id = tal_it->first;
 			if(tal_id < BROADCAST_TAL_ID)
 			{
-				this->probes_st_vbdc_alloc[tal_id]->put(0);
+				this->probes_st_vbdc_alloc[tal_id].putNonZero(0);
 			}
 		}
 		if(this->simulated)
 		{
-			this->probes_st_vbdc_alloc[0]->put(0);
+			this->probes_st_vbdc_alloc[0].put(0);
 		}
 
 
@@ -596,16 +735,16 @@ void DamaCtrl::updateStatistics(time_ms_t UNUSED(period_ms))
 		}
 		else
 		{
-			this->probes_st_cra_alloc[tal_id]->put(
+			this->probes_st_cra_alloc[tal_id].putNonZero(
 				terminal->getRequiredCra());
-			this->probes_st_rbdc_max[tal_id]->put(
+			this->probes_st_rbdc_max[tal_id].putNonZero(
 				terminal->getMaxRbdc());
 		}
 	}
 	if(this->simulated)
 	{
-		this->probes_st_cra_alloc[0]->put(simu_cra);
-		this->probes_st_rbdc_max[0]->put(simu_rbdc);
+		this->probes_st_cra_alloc[0].put(simu_cra);
+		this->probes_st_rbdc_max[0].put(simu_rbdc);
 	}
 	this->probe_gw_return_remaining_capacity->put(this->gw_remaining_capacity);
 	for(cat_it = this->categories.begin();
@@ -646,6 +785,80 @@ TerminalCategories<TerminalCategoryDama> *DamaCtrl::getCategories()
 	return &(this->categories);
 }
 
+bool DamaCtrl::reconfigure(const TerminalCategories<TerminalCategoryDama> &categories,
+                           const TerminalMapping<TerminalCategoryDama> &terminal_affectation,
+                           TerminalCategoryDama *default_category)
+{
+	std::vector<std::pair<TerminalContextDama *, TerminalCategoryDama *>> moves;
+
+	if(!this->checkCategories(categories))
+	{
+		return false;
+	}
+
+	// find the new category of the logged terminals as on logon, a
+	// terminal cannot loose its DAMA capacity while it is logged
+	for(auto &&terminal_it: this->terminals)
+	{
+		tal_id_t tal_id = terminal_it.first;
+		TerminalCategoryDama *category = default_category;
+		auto affectation_it = terminal_affectation.find(tal_id);
+		if(affectation_it != terminal_affectation.end())
+		{
+			category = affectation_it->second;
+		}
+		if(category == nullptr ||
+		   categories.find(category->getLabel()) == categories.end())
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "SF#%u: ST%u would not have any DAMA category, "
+			    "reconfiguration refused\n",
+			    this->current_superframe_sf, tal_id);
+			return false;
+		}
+		moves.emplace_back(terminal_it.second, category);
+	}
+
+	// the terminals are kept by the controller, not by the categories
+	for(auto &&category_it: this->categories)
+	{
+		delete category_it.second;
+	}
+	this->categories = categories;
+	this->terminal_affectation = terminal_affectation;
+	this->default_category = default_category;
+
+	for(auto &&move: moves)
+	{
+		TerminalContextDama *terminal = move.first;
+		TerminalCategoryDama *category = move.second;
+		category->addTerminal(terminal);
+		terminal->setCurrentCategory(category->getLabel());
+		LOG(this->log_init, LEVEL_INFO,
+		    "SF#%u: ST%u moved in category %s\n",
+		    this->current_superframe_sf, terminal->getTerminalId(),
+		    category->getLabel().c_str());
+	}
+	LOG(this->log_init, LEVEL_NOTICE,
+	    "SF#%u: %zu categories in use, %zu terminals moved\n",
+	    this->current_superframe_sf, this->categories.size(), moves.size());
+
+	// the allocations computed ahead refer to the previous carriers
+	this->plans.clear();
+
+	this->initCategories();
+	return true;
+}
+
+bool DamaCtrl::checkCategories(const TerminalCategories<TerminalCategoryDama> &UNUSED(categories)) const
+{
+	return true;
+}
+
+void DamaCtrl::initCategories()
+{
+}
+
 TerminalContextDama *DamaCtrl::getTerminalContext(tal_id_t tal_id) const
 {
 	DamaTerminalList::const_iterator it;
@@ -46,11 +46,15 @@
 #include "OpenSandFrames.h"
 #include "Logon.h"
 #include "Logoff.h"
+#include "TerminalMap.h"
 
 #include <opensand_output/Output.h>
+#include <opensand_output/LazyProbe.h>
 
 #include <cstdio>
 #include <map>
+#include <memory>
+#include <vector>
 
 
 /**
@@ -91,7 +95,7 @@ public:
 	                        TerminalCategories<TerminalCategoryDama> categories,
 	                        TerminalMapping<TerminalCategoryDama> terminal_affectation,
 	                        TerminalCategoryDama *default_category,
-	                        const StFmtSimuList *const input_sts,
+	                        StFmtSimuList *const input_sts,
 	                        FmtDefinitionTable *const input_modcod_def,
 	                        bool simulated);
 
@@ -113,6 +117,25 @@ public:
 	 */
 	virtual bool hereIsLogoff(const Logoff *logoff);
 
+	/**
+	 * @brief  Get the request state of a logged terminal
+	 *
+	 * @param   tal_id  The terminal ID
+	 * @param   state   OUT: the request state of the terminal
+	 * @return  true if the terminal has a DAMA context, false otherwise
+	 */
+	bool getTerminalState(tal_id_t tal_id, dama_terminal_state_t &state) const;
+
+	/**
+	 * @brief  Log a terminal on again with the request state it had
+	 *         on a previous NCC, as if its logon was just received
+	 *
+	 * @param   tal_id  The terminal ID
+	 * @param   state   The request state of the terminal
+	 * @return  true on success, false otherwise.
+	 */
+	bool restoreTerminal(tal_id_t tal_id, const dama_terminal_state_t &state);
+
 	/**
 	 * @brief  Process a SAC frame.
 	 * @warning Should set enable_rbdc or enable_vbdc to true depending on
@@ -123,6 +146,21 @@ public:
 	 */
 	virtual bool hereIsSAC(const Sac *sac) = 0;
 
+	/**
+	 * @brief  Process a single capacity request as if it was read in a SAC,
+	 *         used to inject simulated requests without building frames
+	 * @warning Should set enable_rbdc or enable_vbdc to true depending on
+	 *          the type of CR it receives
+	 *
+	 * @param   tal_id  The terminal requesting capacity
+	 * @param   type    The request type
+	 * @param   value   The request value, in kb/s for RBDC and kb for VBDC
+	 * @return  true on success, false otherwise.
+	 */
+	virtual bool hereIsRequest(tal_id_t tal_id,
+	                           ReturnAccessType type,
+	                           uint32_t value) = 0;
+
 	/**
 	 * @brief  Build the TTP frame.
 	 *
@@ -148,6 +186,36 @@ public:
 	 */
 	virtual bool runOnSuperFrameChange(time_sf_t superframe_number_sf);
 
+	/**
+	 * @brief  Compute the allocations of the superframes following the
+	 *         current one by the look-ahead, to be called in the idle part
+	 *         of the current superframe (after its TTP is built)
+	 *
+	 * The allocations of a superframe are kept until its change, the RBDC
+	 * requests received in between are applied to them as corrections.
+	 *
+	 * @param   superframe_number_sf  the current superframe number
+	 * @return  true on success, false otherwise
+	 */
+	bool runAhead(time_sf_t superframe_number_sf);
+
+	/**
+	 * @brief  Set the number of superframes the allocations are computed
+	 *         ahead by @ref runAhead
+	 *
+	 * @param   superframes  the look-ahead, 0 to compute the allocations
+	 *                       on the superframe change only
+	 */
+	void setLookAhead(time_sf_t superframes);
+
+	/**
+	 * @brief  Set whether the TTPs are sparse, without the Time Plans of
+	 *         the terminals that have no allocation
+	 *
+	 * @param   sparse  whether the TTPs are sparse
+	 */
+	void setSparseTtp(bool sparse);
+
 	/**
 	 * @brief  Update the DAMA statistics
 	 *         Called each frame
@@ -176,7 +244,91 @@ public:
 	 */
 	TerminalCategories<TerminalCategoryDama> *getCategories();
 
+	/**
+	 * @brief  Replace the terminal categories between two superframes,
+	 *         the logged terminals are moved to their new category
+	 *
+	 * @param   categories            The new categories, released by the
+	 *                                controller on success
+	 * @param   terminal_affectation  The new mapping of terminal Id <-> category
+	 * @param   default_category      The new default category
+	 * @return  true on success, false if the categories are refused and
+	 *          the running ones kept
+	 */
+	bool reconfigure(const TerminalCategories<TerminalCategoryDama> &categories,
+	                 const TerminalMapping<TerminalCategoryDama> &terminal_affectation,
+	                 TerminalCategoryDama *default_category);
+
 protected:
+	/**
+	 * @brief The allocation of a terminal computed for a superframe
+	 */
+	struct dama_allocation_t
+	{
+		tal_id_t tal_id;
+		/// The FMT the terminal is served with, 0 if it cannot be served
+		fmt_id_t fmt_id;
+		/// The carriers group of the terminal, in its category
+		std::size_t carriers_index;
+		/// The total rate allocation, RBDC included
+		rate_kbps_t rate_kbps;
+		/// The RBDC allocation
+		rate_kbps_t rbdc_kbps;
+		/// The volume allocation
+		vol_kb_t volume_kb;
+	};
+
+	/**
+	 * @brief The allocations computed ahead for a superframe
+	 */
+	struct dama_plan_t
+	{
+		/// The allocations in the TTP order
+		std::vector<dama_allocation_t> allocations;
+		/// The index of each terminal in the allocations
+		std::map<tal_id_t, std::size_t> terminals;
+		/// The capacity left by the computation on each carriers group (pkt/sf)
+		std::vector<unsigned int> remaining_pktpf;
+		/// The terminals whose RBDC request changed since the computation
+		std::vector<tal_id_t> late_requests;
+	};
+
+	/**
+	 * @brief  Keep the allocations computed in the terminals contexts
+	 *
+	 * @param   plan  OUT: the allocations and the remaining capacity
+	 */
+	virtual void savePlan(dama_plan_t &plan) const = 0;
+
+	/**
+	 * @brief  Apply the RBDC requests received since a plan was computed
+	 *
+	 * @param   plan  The allocations to correct
+	 */
+	virtual void correctPlan(dama_plan_t &plan) = 0;
+
+	/**
+	 * @brief  Record a RBDC request received after the allocations of
+	 *         the next superframes were computed
+	 *
+	 * @param   tal_id  The requesting terminal
+	 */
+	void addLateRequest(tal_id_t tal_id);
+
+	/**
+	 * @brief  Check the controller can allocate the carriers of
+	 *         some categories
+	 *
+	 * @param   categories  The categories
+	 * @return  true if the categories are supported, false otherwise
+	 */
+	virtual bool checkCategories(const TerminalCategories<TerminalCategoryDama> &categories) const;
+
+	/**
+	 * @brief  Update the controller state once the categories changed
+	 */
+	virtual void initCategories();
+
 	/**
 	 * @brief 	Init the output probes and stats
 	 *
@@ -248,6 +400,13 @@ protected:
 	 */
 	virtual bool updateWaveForms() = 0;
 
+	/**
+	 * @brief  Run all the allocation steps of a superframe
+	 *
+	 * @return  true on success, false otherwise
+	 */
+	bool computeSuperFrame();
+
 	/**
 	 * @brief Compute the terminals alllocations, it allocates exactly what
 	 *        have been asked using internal requests, TBTP and contexts.
@@ -307,7 +466,7 @@ protected:
 	bool is_parent_init;
 
 	// Helper to simplify context manipulation
-	typedef std::map<tal_id_t, TerminalContextDama *> DamaTerminalList;
+	typedef TerminalMap<TerminalContextDama *> DamaTerminalList;
 
 	/** List of registered terminals */
 	DamaTerminalList terminals;
@@ -315,6 +474,18 @@ protected:
 	/** Current SuperFrame number */
 	time_sf_t current_superframe_sf;
 
+	/** The number of superframes the allocations are computed ahead */
+	time_sf_t look_ahead_sf;
+
+	/** The allocations computed ahead, by superframe number */
+	std::map<time_sf_t, dama_plan_t> plans;
+
+	/** Whether the TTPs only have the terminals with an allocation */
+	bool sparse_ttp;
+
+	/** The allocations of the current superframe, when computed ahead */
+	dama_plan_t current_plan;
+
 	/** frame duration (in ms) */
 	time_ms_t frame_duration_ms;
 
@@ -350,7 +521,7 @@ protected:
 	TerminalCategoryDama *default_category;
 
 	/** list of Sts with modcod informations for input link */
-	const StFmtSimuList *input_sts;
+	StFmtSimuList *input_sts;
 
 	/** Fmt Definition table for input link */
 	FmtDefinitionTable *input_modcod_def;
@@ -363,7 +534,7 @@ protected:
 
 	/// Output probe and stats
 
-	typedef std::map<tal_id_t, std::shared_ptr<Probe<int> > > ProbeListPerTerminal;
+	typedef TerminalMap<LazyProbe<int>> ProbeListPerTerminal;
 	typedef std::map<std::string, std::shared_ptr<Probe<int> > > ProbeListPerCategory;
 	typedef std::map<unsigned int, std::shared_ptr<Probe<int> > > ProbeListPerCarrier;
 	typedef std::map<std::string, ProbeListPerCarrier> ProbeListPerCategoryPerCarrier;
@@ -406,6 +577,15 @@ protected:
 		// FCA by ST
 	ProbeListPerTerminal probes_st_fca_alloc;
 
+	/* The probes by ST, registered on their first value */
+	std::unique_ptr<ProbeFamily<int>> family_st_cra_alloc;
+	std::unique_ptr<ProbeFamily<int>> family_st_rbdc_alloc;
+	std::unique_ptr<ProbeFamily<int>> family_st_rbdc_max;
+	std::unique_ptr<ProbeFamily<int>> family_st_vbdc_alloc;
+	std::unique_ptr<ProbeFamily<int>> family_st_fca_alloc;
+	/* The probes of the simulated STs */
+	LazyProbes<int> probes_simulated;
+
 	/* Logged ST number  */
 	std::shared_ptr<Probe<int>> probe_gw_st_num;
 	int gw_st_num;
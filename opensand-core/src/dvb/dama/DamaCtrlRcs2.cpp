@@ -40,8 +40,10 @@
 #include "UnitConverterFixedSymbolLength.h"
 
 #include <opensand_output/Output.h>
+#include <opensand_rt/RtTrace.h>
 
 #include <math.h>
+#include <algorithm>
 #include <vector>
 
 
@@ -50,7 +52,10 @@
  */
 DamaCtrlRcs2::DamaCtrlRcs2(spot_id_t spot):
 	DamaCtrl(spot),
-	converter(NULL)
+	converter(NULL),
+	changed_fmt_terminals(),
+	required_fmts_init(false),
+	required_fmts_generation(0)
 {
 }
 
@@ -69,6 +74,17 @@ bool DamaCtrlRcs2::init()
 {
 	vol_sym_t length_sym = 0;
 
+	if(!OpenSandModelConf::Get()->getRcs2BurstLength(length_sym))
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "cannot get RCS2 burst length value");
+		return false;
+	}
+	return this->init(length_sym);
+}
+
+bool DamaCtrlRcs2::init(vol_sym_t length_sym)
+{
 	// Ensure parent init has been done
 	if(!this->is_parent_init)
 	{
@@ -76,13 +92,7 @@ bool DamaCtrlRcs2::init()
 		    "Parent 'init()' method must be called first.\n");
 		goto error;
 	}
-	
-	if(!OpenSandModelConf::Get()->getRcs2BurstLength(length_sym))
-	{
-		LOG(this->log_init, LEVEL_ERROR,
-		    "cannot get RCS2 burst length value");
-		return false;
-	}
+
 	if(length_sym == 0)
 	{
 		LOG(this->log_init, LEVEL_ERROR,
@@ -109,11 +119,10 @@ error:
 
 bool DamaCtrlRcs2::hereIsSAC(const Sac *sac)
 {
+	RtTrace::Span span{"dama.sac"};
 	TerminalContextDamaRcs *terminal;
-	vol_kb_t request_kb;
-	rate_kbps_t request_kbps;
 	tal_id_t tal_id = sac->getTerminalId();
-	std::vector<cr_info_t> requests = sac->getRequests();
+	uint8_t requests_count = sac->getRequestsCount();
 
 	// Checking if the station is registered
 	// if we get GW terminal ID this is for physical layer parameters
@@ -123,79 +132,166 @@ bool DamaCtrlRcs2::hereIsSAC(const Sac *sac)
 		LOG(this->log_sac, LEVEL_ERROR, 
 		    "SF#%u: CR for an unknown st (logon_id=%u). "
 		    "Discarded.\n" , this->current_superframe_sf, tal_id);
-		goto error;
+		return false;
+	}
+	if(terminal == NULL)
+	{
+		// the GW SAC only carries physical layer parameters
+		return true;
 	}
 
-	for (auto&& cr_info: requests)
+	// the requests are read in place from the SAC
+	for(uint8_t index = 0; index < requests_count; ++index)
 	{
-		// take into account the new request
-		switch(cr_info.type)
-		{
-			case ReturnAccessType::dama_vbdc:
-				request_kb = cr_info.value;
-				LOG(this->log_sac, LEVEL_INFO,
-				    "SF#%u: ST%u received VBDC requests %u kb\n",
-				    this->current_superframe_sf, tal_id, request_kb);
-				
-				request_kb = std::min(request_kb, terminal->getMaxVbdc());
-				LOG(this->log_sac, LEVEL_INFO,
-				    "SF#%u: ST%u updated VBDC requests %u kb (<= max VBDC %u kb)\n",
-				    this->current_superframe_sf, tal_id, request_kb, terminal->getMaxVbdc());
-
-				terminal->setRequiredVbdc(request_kb);
-				this->enable_vbdc = true;
-
-				if(tal_id > BROADCAST_TAL_ID)
-				{
-					DC_RECORD_EVENT("CR st%u cr=%u type=%u",
-					                tal_id, request_kb, ReturnAccessType::dama_vbdc);
-				}
-				break;
+		this->handleRequest(terminal, sac->getRequest(index));
+	}
 
-			case ReturnAccessType::dama_rbdc:
-				request_kbps = cr_info.value;
-				LOG(this->log_sac, LEVEL_INFO,
-				    "SF#%u: ST%u received RBDC requests %u kb/s\n",
-				    this->current_superframe_sf, tal_id, request_kbps);
-
-				// remove the CRA of the RBDC request
-				// the CRA is not taken into acount on ST side
-				request_kbps = std::max(request_kbps - terminal->getRequiredCra(), 0);
-				LOG(this->log_sac, LEVEL_INFO,
-				    "SF#%u: ST%u updated RBDC requests %u kb/s (removing CRA %u kb/s)\n",
-				    this->current_superframe_sf, tal_id, request_kbps, terminal->getRequiredCra());
-
-				request_kbps = std::min(request_kbps, terminal->getMaxRbdc());
-				LOG(this->log_sac, LEVEL_INFO,
-				    "SF#%u: ST%u updated RBDC requests %u kb/s (<= max RBDC %u kb/s)\n",
-				    this->current_superframe_sf, tal_id, request_kbps, terminal->getMaxRbdc());
-
-				terminal->setRequiredRbdc(request_kbps);
-				this->enable_rbdc = true;
-				if(tal_id > BROADCAST_TAL_ID)
-				{
-					DC_RECORD_EVENT("CR st%u cr=%u type=%u",
-					                tal_id, request_kbps, ReturnAccessType::dama_rbdc);
-				}
-				break;
+	return true;
+}
 
-			default:
-				LOG(this->log_sac, LEVEL_INFO,
-				    "SF#%u: ST%u received request of unkwon type %d\n",
-				    this->current_superframe_sf, tal_id, cr_info.type);
-				break;
-		}
+bool DamaCtrlRcs2::hereIsRequest(tal_id_t tal_id,
+                                 ReturnAccessType type,
+                                 uint32_t value)
+{
+	TerminalContextDamaRcs *terminal;
+
+	terminal = (TerminalContextDamaRcs *)this->getTerminalContext(tal_id);
+	if(terminal == NULL)
+	{
+		LOG(this->log_sac, LEVEL_ERROR,
+		    "SF#%u: CR for an unknown st (logon_id=%u). "
+		    "Discarded.\n" , this->current_superframe_sf, tal_id);
+		return false;
 	}
 
+	cr_info_t cr_info;
+	cr_info.prio = 0;
+	cr_info.type = type;
+	cr_info.value = value;
+	this->handleRequest(terminal, cr_info);
+
 	return true;
+}
 
-error:
-	return false;
+void DamaCtrlRcs2::handleRequest(TerminalContextDamaRcs *terminal,
+                                 const cr_info_t &cr_info)
+{
+	vol_kb_t request_kb;
+	rate_kbps_t request_kbps;
+	tal_id_t tal_id = terminal->getTerminalId();
+
+	// take into account the new request
+	switch(cr_info.type)
+	{
+		case ReturnAccessType::dama_vbdc:
+			request_kb = cr_info.value;
+			LOG(this->log_sac, LEVEL_INFO,
+			    "SF#%u: ST%u received VBDC requests %u kb\n",
+			    this->current_superframe_sf, tal_id, request_kb);
+			
+			request_kb = std::min(request_kb, terminal->getMaxVbdc());
+			LOG(this->log_sac, LEVEL_INFO,
+			    "SF#%u: ST%u updated VBDC requests %u kb (<= max VBDC %u kb)\n",
+			    this->current_superframe_sf, tal_id, request_kb, terminal->getMaxVbdc());
+
+			terminal->setRequiredVbdc(request_kb);
+			this->enable_vbdc = true;
+
+			if(tal_id > BROADCAST_TAL_ID)
+			{
+				DC_RECORD_EVENT("CR st%u cr=%u type=%u",
+				                tal_id, request_kb, ReturnAccessType::dama_vbdc);
+			}
+			break;
+
+		case ReturnAccessType::dama_rbdc:
+			request_kbps = cr_info.value;
+			LOG(this->log_sac, LEVEL_INFO,
+			    "SF#%u: ST%u received RBDC requests %u kb/s\n",
+			    this->current_superframe_sf, tal_id, request_kbps);
+
+			// remove the CRA of the RBDC request
+			// the CRA is not taken into acount on ST side
+			request_kbps = std::max(request_kbps - terminal->getRequiredCra(), 0);
+			LOG(this->log_sac, LEVEL_INFO,
+			    "SF#%u: ST%u updated RBDC requests %u kb/s (removing CRA %u kb/s)\n",
+			    this->current_superframe_sf, tal_id, request_kbps, terminal->getRequiredCra());
+
+			request_kbps = std::min(request_kbps, terminal->getMaxRbdc());
+			LOG(this->log_sac, LEVEL_INFO,
+			    "SF#%u: ST%u updated RBDC requests %u kb/s (<= max RBDC %u kb/s)\n",
+			    this->current_superframe_sf, tal_id, request_kbps, terminal->getMaxRbdc());
+
+			terminal->setRequiredRbdc(request_kbps);
+			this->enable_rbdc = true;
+			if(!this->plans.empty())
+			{
+				this->addLateRequest(tal_id);
+			}
+			if(tal_id > BROADCAST_TAL_ID)
+			{
+				DC_RECORD_EVENT("CR st%u cr=%u type=%u",
+				                tal_id, request_kbps, ReturnAccessType::dama_rbdc);
+			}
+			break;
+
+		default:
+			LOG(this->log_sac, LEVEL_INFO,
+			    "SF#%u: ST%u received request of unkwon type %d\n",
+			    this->current_superframe_sf, tal_id, cr_info.type);
+			break;
+	}
 }
 
 bool DamaCtrlRcs2::buildTTP(Ttp *ttp)
 {
+	RtTrace::Span span{"dama.ttp"};
 	TerminalCategories<TerminalCategoryDama>::const_iterator category_it;
+	std::size_t terminals_count = 0;
+
+	// a terminal without Time Plan in a sparse TTP has no allocation
+	ttp->setSparse(this->sparse_ttp);
+
+	if(this->look_ahead_sf > 0)
+	{
+		// the allocations were computed ahead and corrected since
+		ttp->reserveTimePlans(this->current_plan.allocations.size());
+		for(auto&& allocation : this->current_plan.allocations)
+		{
+			vol_kb_t total_allocation_kb = 0;
+
+			if(this->terminals.find(allocation.tal_id) == this->terminals.end())
+			{
+				// logged off since
+				continue;
+			}
+			if(allocation.fmt_id != 0)
+			{
+				total_allocation_kb += allocation.volume_kb;
+				total_allocation_kb += this->converter->psToPf(allocation.rate_kbps);
+			}
+			if(this->sparse_ttp && total_allocation_kb == 0)
+			{
+				continue;
+			}
+			if(!ttp->addTimePlan(0, allocation.tal_id, 0, total_allocation_kb,
+			                     allocation.fmt_id, 0))
+			{
+				LOG(this->log_ttp, LEVEL_ERROR,
+				    "SF#%u: cannot add TimePlan for terminal %u\n",
+				    this->current_superframe_sf, allocation.tal_id);
+			}
+		}
+		return this->finalizeTTP(ttp);
+	}
+
+	// the time plans are encoded straight in the TTP, reserve it once
+	for(auto&& category : this->categories)
+	{
+		terminals_count += category.second->getTerminals().size();
+	}
+	ttp->reserveTimePlans(terminals_count);
+
 	for(category_it = this->categories.begin();
 	    category_it != this->categories.end();
 	    category_it++)
@@ -212,7 +308,7 @@ bool DamaCtrlRcs2::buildTTP(Ttp *ttp)
 			terminal_index++)
 		{
 			TerminalContextDamaRcs *terminal =
-					dynamic_cast<TerminalContextDamaRcs*>(terminals[terminal_index]);
+					static_cast<TerminalContextDamaRcs *>(terminals[terminal_index]);
 			vol_kb_t total_allocation_kb = 0;
 
 			// we need to do that else some CRA will be allocated and the terminal
@@ -232,6 +328,10 @@ bool DamaCtrlRcs2::buildTTP(Ttp *ttp)
 			    "[Tal %u] total allocation = %u kb",
 			    terminal->getTerminalId(),
 			    total_allocation_kb);
+			if(this->sparse_ttp && total_allocation_kb == 0)
+			{
+				continue;
+			}
 
 			//FIXME: is the offset to be 0 ???
 			if(!ttp->addTimePlan(0 /*FIXME: should it be the frame_counter of the bloc_ncc ?*/,
@@ -248,8 +348,21 @@ bool DamaCtrlRcs2::buildTTP(Ttp *ttp)
 			}
 		}
 	}
-	ttp->build();
 
+	return this->finalizeTTP(ttp);
+}
+
+bool DamaCtrlRcs2::finalizeTTP(Ttp *ttp) const
+{
+	// the full TTPs are sent anyway, as it has always been done, but
+	// the terminals cannot read a sparse TTP without its index
+	if(!ttp->build() && this->sparse_ttp)
+	{
+		LOG(this->log_ttp, LEVEL_ERROR,
+		    "SF#%u: cannot build the sparse TTP\n",
+		    this->current_superframe_sf);
+		return false;
+	}
 	return true;
 }
 
@@ -261,7 +374,7 @@ bool DamaCtrlRcs2::applyPepCommand(const PepRequest *request)
 	rate_kbps_t rbdc_kbps;
 
 	// check that the ST is logged on
-	terminal = dynamic_cast<TerminalContextDamaRcs *>(this->getTerminalContext(request->getStId()));
+	terminal = static_cast<TerminalContextDamaRcs *>(this->getTerminalContext(request->getStId()));
 	if(terminal == NULL)
 	{
 		LOG(this->log_pep, LEVEL_ERROR, 
@@ -299,7 +412,7 @@ bool DamaCtrlRcs2::applyPepCommand(const PepRequest *request)
 		// Output probes and stats
 		this->gw_rbdc_max_kbps += max_rbdc_kbps;
 		this->probe_gw_rbdc_max->put(this->gw_rbdc_max_kbps);
-		this->probes_st_rbdc_max[terminal->getTerminalId()]->put(max_rbdc_kbps);
+		this->probes_st_rbdc_max[terminal->getTerminalId()].putNonZero(max_rbdc_kbps);
 	}
 
 	// inject one RDBC allocation ?
@@ -318,6 +431,7 @@ bool DamaCtrlRcs2::applyPepCommand(const PepRequest *request)
 
 		// change back RDBC timeout
 		terminal->updateRbdcTimeout(this->rbdc_timeout_sf);
+		this->addLateRequest(terminal->getTerminalId());
 	}
 
 	return true;
@@ -328,62 +442,76 @@ abort:
 
 void DamaCtrlRcs2::updateRequiredFmts()
 {
-	DamaTerminalList::iterator it;
-	TerminalContextDamaRcs *terminal;
-	tal_id_t tal_id;
+	// only the terminals whose MODCOD changed need a new required FMT,
+	// unless terminals logged on or off since they were all updated
+	this->input_sts->popChangedTerminals(this->changed_fmt_terminals);
+	if(!this->required_fmts_init ||
+	   this->required_fmts_generation != this->terminals.getGeneration())
+	{
+		for(auto&& it : this->terminals)
+		{
+			this->updateRequiredFmt(static_cast<TerminalContextDamaRcs *>(it.second));
+		}
+		this->required_fmts_init = true;
+		this->required_fmts_generation = this->terminals.getGeneration();
+		return;
+	}
+
+	for(tal_id_t tal_id : this->changed_fmt_terminals)
+	{
+		auto it = this->terminals.find(tal_id);
+		if(it == this->terminals.end())
+		{
+			// not a DAMA terminal
+			continue;
+		}
+		this->updateRequiredFmt(static_cast<TerminalContextDamaRcs *>(it->second));
+	}
+}
+
+void DamaCtrlRcs2::updateRequiredFmt(TerminalContextDamaRcs *terminal)
+{
+	tal_id_t tal_id = terminal->getTerminalId();
 	double cni;
 	fmt_id_t fmt_id;
-	
+
 	if(!this->simulated)
 	{
 		// Update required Fmt in function of the Cni
-		for(it = this->terminals.begin(); it != this->terminals.end(); ++it)
+
+		// Get CNI
+		cni = this->input_sts->getRequiredCni(tal_id);
+		LOG(this->log_fmt, LEVEL_DEBUG,
+		    "SF#%u: ST%u CNI before affectation: %f\n",
+		    this->current_superframe_sf, tal_id, cni);
+
+		// Get required Modcod from the CNI
+		fmt_id = this->input_modcod_def->getRequiredModcod(cni);
+		if(fmt_id == 0)
 		{
-			terminal = dynamic_cast<TerminalContextDamaRcs *>(it->second);
-			tal_id = terminal->getTerminalId();
-
-			// Get CNI
-			cni = this->input_sts->getRequiredCni(tal_id);
-			LOG(this->log_fmt, LEVEL_DEBUG,
-			    "SF#%u: ST%u CNI before affectation: %f\n",
-			    this->current_superframe_sf, tal_id, cni);
-			
-			// Get required Modcod from the CNI
-			fmt_id = this->input_modcod_def->getRequiredModcod(cni);
-			if(fmt_id == 0)
-			{
-				fmt_id = this->input_modcod_def->getMinId();
-			}
-			LOG(this->log_fmt, LEVEL_DEBUG,
-				"SF#%u: ST%u FMT ID before affectation (CNI %f): %u\n",
-				this->current_superframe_sf, tal_id, cni, fmt_id);
-	
-			// Set required Modcod to the terminal context
-			terminal->setRequiredFmt(this->input_modcod_def->getDefinition(fmt_id));
+			fmt_id = this->input_modcod_def->getMinId();
 		}
+		LOG(this->log_fmt, LEVEL_DEBUG,
+			"SF#%u: ST%u FMT ID before affectation (CNI %f): %u\n",
+			this->current_superframe_sf, tal_id, cni, fmt_id);
 	}
 	else
 	{
 		// Update required Fmt in function of the simulation file
-		for(it = this->terminals.begin(); it != this->terminals.end(); ++it)
-		{
-			terminal = dynamic_cast<TerminalContextDamaRcs *>(it->second);
-			tal_id = terminal->getTerminalId();
 
-			// Get required Modcod from the simulation file
-			fmt_id = this->input_sts->getCurrentModcodId(tal_id);
-			if(fmt_id == 0)
-			{
-				fmt_id = this->input_modcod_def->getMinId();
-			}
-			LOG(this->log_fmt, LEVEL_DEBUG,
-				"SF#%u: ST%u simulated FMT ID before affectation: %u\n",
-				this->current_superframe_sf, tal_id, fmt_id);
-	
-			// Set required Modcod to the terminal context
-			terminal->setRequiredFmt(this->input_modcod_def->getDefinition(fmt_id));
+		// Get required Modcod from the simulation file
+		fmt_id = this->input_sts->getCurrentModcodId(tal_id);
+		if(fmt_id == 0)
+		{
+			fmt_id = this->input_modcod_def->getMinId();
 		}
+		LOG(this->log_fmt, LEVEL_DEBUG,
+			"SF#%u: ST%u simulated FMT ID before affectation: %u\n",
+			this->current_superframe_sf, tal_id, fmt_id);
 	}
+
+	// Set required Modcod to the terminal context
+	terminal->setRequiredFmt(this->input_modcod_def->getDefinition(fmt_id));
 }
 
 bool DamaCtrlRcs2::updateWaveForms()
@@ -395,7 +523,7 @@ bool DamaCtrlRcs2::updateWaveForms()
 	{
 		TerminalCategoryDama *category;
 		TerminalCategories<TerminalCategoryDama>::const_iterator category_it;
-		TerminalContextDamaRcs *terminal = dynamic_cast<TerminalContextDamaRcs *>(terminal_it->second);
+		TerminalContextDamaRcs *terminal = static_cast<TerminalContextDamaRcs *>(terminal_it->second);
 		tal_id_t tal_id = terminal->getTerminalId();
 		std::vector<CarriersGroupDama *> carriers_group;
 		FmtDefinition *fmt_def;
@@ -454,7 +582,7 @@ bool DamaCtrlRcs2::updateWaveForms()
 				if(required_fmt <= fmt)
 				{
 					// we have a carrier with the corresponding MODCOD
-					terminal->setCarrierId(carriers->getCarriersId());
+					category->setTerminalCarrier(terminal, carriers->getCarriersId());
 					available_fmt = fmt;
 					LOG(this->log_fmt, LEVEL_DEBUG,
 						"SF#%u: ST%u will be served with the required "
@@ -468,7 +596,7 @@ bool DamaCtrlRcs2::updateWaveForms()
 				{
 					// take the closest FMT id (i.e. the bigger value)
 					available_fmt = std::max(available_fmt, fmt);
-					terminal->setCarrierId(carriers->getCarriersId());
+					category->setTerminalCarrier(terminal, carriers->getCarriersId());
 				}
 			}
 		}
@@ -590,6 +718,89 @@ bool DamaCtrlRcs2::resetTerminalsAllocations()
 	return ret;
 }
 
+void DamaCtrlRcs2::savePlan(dama_plan_t &plan) const
+{
+	plan.allocations.clear();
+	plan.terminals.clear();
+	plan.remaining_pktpf.clear();
+	plan.late_requests.clear();
+
+	// the allocations in the order they are put in the TTP
+	for(auto&& category_it : this->categories)
+	{
+		TerminalCategoryDama *category = category_it.second;
+		std::map<unsigned int, std::size_t> carriers_index;
+		for(auto *carriers: category->getCarriersGroups())
+		{
+			carriers_index[carriers->getCarriersId()] = plan.remaining_pktpf.size();
+			plan.remaining_pktpf.push_back(carriers->getRemainingCapacity());
+		}
+
+		for(auto *context: category->getTerminals())
+		{
+			TerminalContextDamaRcs *terminal = static_cast<TerminalContextDamaRcs *>(context);
+			dama_allocation_t allocation;
+			auto index_it = carriers_index.find(terminal->getCarrierId());
+
+			allocation.tal_id = terminal->getTerminalId();
+			allocation.fmt_id = terminal->getFmtId();
+			allocation.carriers_index = index_it != carriers_index.end() ?
+			                            index_it->second : plan.remaining_pktpf.size();
+			allocation.rate_kbps = terminal->getTotalRateAllocation();
+			allocation.rbdc_kbps = terminal->getRbdcAllocation();
+			allocation.volume_kb = terminal->getTotalVolumeAllocation();
+			plan.terminals[allocation.tal_id] = plan.allocations.size();
+			plan.allocations.push_back(allocation);
+		}
+	}
+}
+
+void DamaCtrlRcs2::correctPlan(dama_plan_t &plan)
+{
+	std::sort(plan.late_requests.begin(), plan.late_requests.end());
+	plan.late_requests.erase(std::unique(plan.late_requests.begin(), plan.late_requests.end()),
+	                         plan.late_requests.end());
+
+	for(tal_id_t tal_id : plan.late_requests)
+	{
+		auto terminal_it = plan.terminals.find(tal_id);
+		TerminalContextDama *terminal = this->getTerminalContext(tal_id);
+		if(terminal_it == plan.terminals.end() || terminal == NULL)
+		{
+			// logged on or off since the computation
+			continue;
+		}
+		dama_allocation_t &allocation = plan.allocations[terminal_it->second];
+		FmtDefinition *fmt_def = this->input_modcod_def->getDefinition(allocation.fmt_id);
+		if(allocation.fmt_id == 0 || fmt_def == NULL ||
+		   allocation.carriers_index >= plan.remaining_pktpf.size())
+		{
+			continue;
+		}
+		this->converter->setModulationEfficiency(fmt_def->getModulationEfficiency());
+
+		// the RBDC allocation follows the new request as far as the capacity
+		// left by the computation allows, without fair share nor credit
+		unsigned int &remaining_pktpf = plan.remaining_pktpf[allocation.carriers_index];
+		unsigned int alloc_pktpf = this->converter->kbpsToPktpf(fmt_def->addFec(allocation.rbdc_kbps));
+		unsigned int request_pktpf = this->converter->kbpsToPktpf(fmt_def->addFec(terminal->getRequiredRbdc()));
+		request_pktpf = std::min(request_pktpf, alloc_pktpf + remaining_pktpf);
+		if(request_pktpf == alloc_pktpf)
+		{
+			continue;
+		}
+		remaining_pktpf = remaining_pktpf + alloc_pktpf - request_pktpf;
+
+		rate_kbps_t rbdc_kbps = fmt_def->removeFec(this->converter->pktpfToKbps(request_pktpf));
+		LOG(this->log_run_dama, LEVEL_DEBUG,
+		    "SF#%u: ST%u RBDC allocation corrected from %u to %u kb/s\n",
+		    this->current_superframe_sf, tal_id, allocation.rbdc_kbps, rbdc_kbps);
+		allocation.rate_kbps = allocation.rate_kbps - allocation.rbdc_kbps + rbdc_kbps;
+		allocation.rbdc_kbps = rbdc_kbps;
+	}
+	plan.late_requests.clear();
+}
+
 bool DamaCtrlRcs2::resetCarriersCapacity()
 {
 	rate_symps_t gw_return_total_capacity_symps = 0;
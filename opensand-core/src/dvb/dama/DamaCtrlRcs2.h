@@ -39,7 +39,7 @@
 #include "DamaCtrl.h"
 #include "FmtDefinitionTable.h"
 #include "TerminalContextDamaRcs.h"
-#include "UnitConverter.h"
+#include "UnitConverterFixedSymbolLength.h"
 
 #include <opensand_output/Output.h>
 
@@ -63,10 +63,21 @@ public:
 	 *
 	 * @return  true on success, false otherwise
 	 */
-	virtual bool init();
+	bool init();
+
+	/**
+	 * @brief  Initializes internal data structure with the RCS2 burst length
+	 *
+	 * @param   length_sym  The RCS2 burst length (in symbols)
+	 * @return  true on success, false otherwise
+	 */
+	virtual bool init(vol_sym_t length_sym);
 
 	// Process DVB frames
 	virtual bool hereIsSAC(const Sac *sac);
+	virtual bool hereIsRequest(tal_id_t tal_id,
+	                           ReturnAccessType type,
+	                           uint32_t value);
 
 	// Build allocation table
 	virtual bool buildTTP(Ttp *ttp);
@@ -81,9 +92,37 @@ public:
 	virtual bool updateWaveForms();
 
 protected:
-	UnitConverter *converter;
+	/// The unit converter, held through its own type so that its
+	/// conversions are inlined in the allocation loops
+	UnitConverterFixedSymbolLength *converter;
+
+	/// The terminals whose MODCOD changed since the last FMTs update
+	std::vector<tal_id_t> changed_fmt_terminals;
+
+	/// Whether the required FMTs of all the terminals were set once
+	bool required_fmts_init;
+
+	/// The generation of the terminals list when the required FMTs
+	/// of all the terminals were last set
+	uint32_t required_fmts_generation;
+
+	/**
+	 * @brief  Update the required FMT of a terminal
+	 *
+	 * @param terminal  The terminal context
+	 */
+	void updateRequiredFmt(TerminalContextDamaRcs *terminal);
+
+	/**
+	 * @brief  Build a TTP whose Time Plans are added
+	 *
+	 * @param ttp  The TTP
+	 * @return false if a sparse TTP cannot be built, true otherwise
+	 */
+	bool finalizeTTP(Ttp *ttp) const;
 
-	/// Create a terminal context
+	/// Create a terminal context, the controller only holds DVB-RCS2
+	/// contexts so that they are statically cast back on the data path
 	virtual bool createTerminal(TerminalContextDama **terminal,
 	                            tal_id_t tal_id,
 	                            rate_kbps_t cra_kbps,
@@ -94,9 +133,24 @@ protected:
 	/// Remove a terminal context
 	virtual bool removeTerminal(TerminalContextDama **terminal);
 
+	/**
+	 * @brief  Take a capacity request of a registered terminal into account
+	 *
+	 * @param terminal  The terminal context
+	 * @param cr_info   The request
+	 */
+	void handleRequest(TerminalContextDamaRcs *terminal,
+	                   const cr_info_t &cr_info);
+
 	/// Reset all terminals allocations
 	virtual bool resetTerminalsAllocations();
 
+	/// Keep the allocations computed in the terminals contexts
+	virtual void savePlan(dama_plan_t &plan) const;
+
+	/// Apply the late RBDC requests on the capacity left by a plan
+	virtual void correctPlan(dama_plan_t &plan);
+
 	 ///  Reset the capacity of carriers
 	virtual bool resetCarriersCapacity();
 
@@ -37,9 +37,11 @@
 
 #include "OpenSandFrames.h"
 #include "TerminalContextDamaRcs.h"
+#include "UnitConverterFixedSymbolLength.h"
 
 #include <opensand_output/Output.h>
 
+#include <algorithm>
 #include <math.h>
 #include <string>
 #include <sstream>
@@ -48,8 +50,14 @@
 /**
  * Constructor
  */
-DamaCtrlRcs2Legacy::DamaCtrlRcs2Legacy(spot_id_t spot):
-	DamaCtrlRcs2(spot)
+DamaCtrlRcs2Legacy::DamaCtrlRcs2Legacy(spot_id_t spot, unsigned int workers,
+                                       bool fair_share):
+	DamaCtrlRcs2(spot),
+	workers_count(workers),
+	fair_share(fair_share),
+	rbdc_fair_shares(),
+	shards(),
+	workers(this->log_run_dama)
 {
 }
 
@@ -59,26 +67,41 @@ DamaCtrlRcs2Legacy::DamaCtrlRcs2Legacy(spot_id_t spot):
  */
 DamaCtrlRcs2Legacy::~DamaCtrlRcs2Legacy()
 {
+	// the first shard uses the converter of the controller
+	for(std::size_t index = 1; index < this->shards.size(); ++index)
+	{
+		delete this->shards[index].converter;
+	}
 }
 
-bool DamaCtrlRcs2Legacy::init()
+bool DamaCtrlRcs2Legacy::init(vol_sym_t length_sym)
 {
-	TerminalCategories<TerminalCategoryDama>::const_iterator category_it;
-	std::vector<CarriersGroupDama *>::const_iterator carrier_it;
+	if(!DamaCtrlRcs2::init(length_sym))
+	{
+		return false;
+	}
 
-	if(!DamaCtrlRcs2::init())
+	if(!this->checkCategories(this->categories))
 	{
 		return false;
 	}
+	this->initCategoryProbes();
+
+	return this->initShards();
+}
+
+bool DamaCtrlRcs2Legacy::checkCategories(const TerminalCategories<TerminalCategoryDama> &categories) const
+{
+	TerminalCategories<TerminalCategoryDama>::const_iterator category_it;
+	std::vector<CarriersGroupDama *>::const_iterator carrier_it;
 
 	// check that we have only one MODCOD per carrier
-	for(category_it = this->categories.begin();
-	    category_it != this->categories.end();
+	for(category_it = categories.begin();
+	    category_it != categories.end();
 	    ++category_it)
 	{
 		TerminalCategoryDama *category = (*category_it).second;
 		std::vector<CarriersGroupDama *> carriers_group;
-		std::string label = category->getLabel();
 
 		carriers_group = category->getCarriersGroups();
 		if(carriers_group.size() > 1 || carriers_group[0]->getCarriersNumber() > 1)
@@ -101,70 +124,206 @@ bool DamaCtrlRcs2Legacy::init()
 				    "group for DVB-RCS2 Legacy DAMA\n");
 				return false;
 			}
-			// Output probes and stats
-			std::shared_ptr<Probe<int>> probe_carrier;
-			unsigned int carrier_id = carriers->getCarriersId();
-			probe_carrier = this->generateCarrierCapacityProbe(label, carrier_id, "Available");
-			this->probes_carrier_return_capacity[label].emplace(carrier_id, probe_carrier);
+		}
+	}
 
-			probe_carrier = this->generateCarrierCapacityProbe(label, carrier_id, "Remaining");
-			this->probes_carrier_return_remaining_capacity[label].emplace(carrier_id, probe_carrier);
+	return true;
+}
+
+void DamaCtrlRcs2Legacy::initCategoryProbes()
+{
+	for(auto &&category_it: this->categories)
+	{
+		TerminalCategoryDama *category = category_it.second;
+		std::string label = category->getLabel();
 
+		for(auto *carriers: category->getCarriersGroups())
+		{
+			// Output probes and stats
+			unsigned int carrier_id = carriers->getCarriersId();
+			auto &probes_capa = this->probes_carrier_return_capacity[label];
+			if(probes_capa.find(carrier_id) == probes_capa.end())
+			{
+				auto probe_carrier = this->generateCarrierCapacityProbe(label, carrier_id, "Available");
+				probes_capa.emplace(carrier_id, probe_carrier);
+			}
+			auto &probes_remain_capa = this->probes_carrier_return_remaining_capacity[label];
+			if(probes_remain_capa.find(carrier_id) == probes_remain_capa.end())
+			{
+				auto probe_carrier = this->generateCarrierCapacityProbe(label, carrier_id, "Remaining");
+				probes_remain_capa.emplace(carrier_id, probe_carrier);
+			}
 			this->carrier_return_remaining_capacity[label].emplace(carrier_id, 0);
 		}
+
 		// Output probes and stats
-		std::shared_ptr<Probe<int>> probe_category;
+		if(this->probes_category_return_capacity.find(label) ==
+		   this->probes_category_return_capacity.end())
+		{
+			auto probe_category = this->generateCategoryCapacityProbe(label, "Available");
+			this->probes_category_return_capacity.emplace(label, probe_category);
 
-		probe_category = this->generateCategoryCapacityProbe(label, "Available");
-		this->probes_category_return_capacity.emplace(label, probe_category);
+			probe_category = this->generateCategoryCapacityProbe(label, "Remaining");
+			this->probes_category_return_remaining_capacity.emplace(label, probe_category);
+		}
+		this->category_return_remaining_capacity.emplace(label, 0);
+	}
+}
+
+void DamaCtrlRcs2Legacy::initCategories()
+{
+	this->initCategoryProbes();
 
-		probe_category = this->generateCategoryCapacityProbe(label, "Remaining");
-		this->probes_category_return_remaining_capacity.emplace(label, probe_category);
+	// the flows of the previous carriers groups are dropped
+	this->rbdc_fair_shares.clear();
 
-		this->category_return_remaining_capacity.emplace(label, 0);
+	// the workers started are kept, the categories are spread between them
+	this->assignShards();
+}
+
+bool DamaCtrlRcs2Legacy::initShards()
+{
+	std::size_t shards_count = std::max(this->workers_count, 1U);
+	std::size_t index = 0;
+
+	// the carriers groups are the unit of capacity and each category
+	// has one of them, a shard never allocates capacity of another one
+	shards_count = std::min(shards_count, this->categories.size());
+	shards_count = std::max(shards_count, std::size_t(1));
+	this->shards.resize(shards_count);
+	for(auto &&shard: this->shards)
+	{
+		if(index == 0)
+		{
+			shard.converter = this->converter;
+		}
+		else
+		{
+			shard.converter = new UnitConverterFixedSymbolLength(this->frame_duration_ms,
+				0, this->converter->getPacketSymbolLength());
+		}
+		shard.remaining_capacity = 0;
+		shard.request = 0;
+		shard.alloc = 0;
+		shard.req_num = 0;
+		++index;
 	}
 
-	return true;
+	this->assignShards();
+
+	if(this->workers_count > shards_count)
+	{
+		LOG(this->log_init, LEVEL_NOTICE,
+		    "%u DAMA workers requested for %zu categories, "
+		    "using %zu workers\n", this->workers_count,
+		    this->categories.size(), shards_count);
+	}
+	return this->workers.start(shards_count);
+}
+
+void DamaCtrlRcs2Legacy::assignShards()
+{
+	std::size_t index = 0;
+
+	for(auto &&shard: this->shards)
+	{
+		shard.categories.clear();
+	}
+	for(auto &&category_it: this->categories)
+	{
+		this->shards[index % this->shards.size()].categories.push_back(category_it.second);
+		++index;
+	}
+}
+
+bool DamaCtrlRcs2Legacy::runShards(const std::function<bool(dama_shard_t &)> &step)
+{
+	int remaining_capacity = this->gw_remaining_capacity;
+	bool status;
+
+	for(auto &&shard: this->shards)
+	{
+		shard.remaining_capacity = remaining_capacity;
+		shard.request = 0;
+		shard.alloc = 0;
+		shard.req_num = 0;
+		shard.probes_values.clear();
+	}
+
+	status = this->workers.run([this, &step](std::size_t index)
+	{
+		return step(this->shards[index]);
+	});
+
+	// merge the capacity consumed by each shard, and put the values
+	// of its probes now that the workers are done
+	for(auto &&shard: this->shards)
+	{
+		this->gw_remaining_capacity -= remaining_capacity - shard.remaining_capacity;
+		for(auto &&probe_value: shard.probes_values)
+		{
+			LazyProbe<int> &probe = (*probe_value.probes)[probe_value.tal_id];
+			if(probe_value.non_zero)
+			{
+				probe.putNonZero(probe_value.value);
+			}
+			else
+			{
+				probe.put(probe_value.value);
+			}
+		}
+	}
+
+	return status;
+}
+
+void DamaCtrlRcs2Legacy::putProbe(dama_shard_t &shard, ProbeListPerTerminal &probes,
+                                  tal_id_t tal_id, int value, bool non_zero)
+{
+	shard.probes_values.push_back({&probes, tal_id, value, non_zero});
 }
 
 bool DamaCtrlRcs2Legacy::computeTerminalsCraAllocation()
 {
-	bool stat = true;
+	bool stat;
 	rate_kbps_t gw_cra_request_kbps = 0;
-	TerminalCategories<TerminalCategoryDama>::const_iterator category_it;
 
 	this->gw_cra_alloc_kbps = 0;
 
-	for(category_it = this->categories.begin();
-	    category_it != this->categories.end();
-	    ++category_it)
+	stat = this->runShards([this](dama_shard_t &shard)
 	{
-		TerminalCategoryDama *category = category_it->second;
-		std::vector<CarriersGroupDama *> carriers_group;
-		std::vector<CarriersGroupDama *>::const_iterator carrier_it;
+		bool shard_stat = true;
 
-		// we can compute CRA per carriers group because a terminal
-		// is assigned to one on each frame, depending on its DRA
-		carriers_group = category->getCarriersGroups();
-		for(carrier_it = carriers_group.begin();
-		    carrier_it != carriers_group.end();
-		    ++carrier_it)
+		for(auto &&category: shard.categories)
 		{
-			rate_kbps_t cra_request_kbps = 0;
-			rate_kbps_t cra_alloc_kbps = 0;
-
-			this->computeDamaCraPerCarrier(*carrier_it,
-			                               category,
-				                           cra_request_kbps,
-				                           cra_alloc_kbps);
-			gw_cra_request_kbps += cra_request_kbps;
-			this->gw_cra_alloc_kbps += cra_alloc_kbps;;
-
-			if(cra_alloc_kbps < cra_request_kbps)
+			// we can compute CRA per carriers group because a terminal
+			// is assigned to one on each frame, depending on its DRA
+			for(auto &&carriers: category->getCarriersGroups())
 			{
-				stat = false;
+				rate_kbps_t cra_request_kbps = 0;
+				rate_kbps_t cra_alloc_kbps = 0;
+
+				this->computeDamaCraPerCarrier(shard,
+				                               carriers,
+				                               category,
+				                               cra_request_kbps,
+				                               cra_alloc_kbps);
+				shard.request += cra_request_kbps;
+				shard.alloc += cra_alloc_kbps;
+
+				if(cra_alloc_kbps < cra_request_kbps)
+				{
+					shard_stat = false;
+				}
 			}
 		}
+		return shard_stat;
+	});
+
+	for(auto &&shard: this->shards)
+	{
+		gw_cra_request_kbps += shard.request;
+		this->gw_cra_alloc_kbps += shard.alloc;
 	}
 	//this->probe_gw_cra_request->put(this->gw_cra_request_kbps);
 
@@ -176,33 +335,48 @@ bool DamaCtrlRcs2Legacy::computeTerminalsRbdcAllocation()
 	rate_kbps_t gw_rbdc_request_kbps = 0;
 	rate_kbps_t gw_rbdc_alloc_kbps = 0;
 
-	TerminalCategories<TerminalCategoryDama>::const_iterator category_it;
-	std::vector<CarriersGroupDama *>::const_iterator carrier_it;
-
-	for(category_it = this->categories.begin();
-	    category_it != this->categories.end();
-	    ++category_it)
+	if(this->fair_share)
 	{
-		TerminalCategoryDama *category = (*category_it).second;
-		std::vector<CarriersGroupDama *> carriers_group;
-
-		// we ca compute RBDC per carriers group because a terminal
-		// is assigned to one on each frame, depending on its DRA
-		carriers_group = category->getCarriersGroups();
-		for(carrier_it = carriers_group.begin();
-		    carrier_it != carriers_group.end();
-		    ++carrier_it)
+		// the shards only look the fair shares up, the ones of the
+		// carriers groups added by the SVNO requests are created here
+		for(auto &&category_it: this->categories)
 		{
-			rate_kbps_t rbdc_request_kbps = 0;
-			rate_kbps_t rbdc_alloc_kbps = 0;
+			auto &fair_shares = this->rbdc_fair_shares[category_it.first];
+			for(auto &&carriers: category_it.second->getCarriersGroups())
+			{
+				fair_shares[carriers->getCarriersId()];
+			}
+		}
+	}
 
-			this->computeDamaRbdcPerCarrier(*carrier_it,
-			                            category,
-			                            rbdc_request_kbps,
-			                            rbdc_alloc_kbps);
-			gw_rbdc_request_kbps += rbdc_request_kbps;
-			gw_rbdc_alloc_kbps += rbdc_alloc_kbps;
+	this->runShards([this](dama_shard_t &shard)
+	{
+		for(auto &&category: shard.categories)
+		{
+			// we ca compute RBDC per carriers group because a terminal
+			// is assigned to one on each frame, depending on its DRA
+			for(auto &&carriers: category->getCarriersGroups())
+			{
+				rate_kbps_t rbdc_request_kbps = 0;
+				rate_kbps_t rbdc_alloc_kbps = 0;
+
+				this->computeDamaRbdcPerCarrier(shard,
+				                                carriers,
+				                                category,
+				                                rbdc_request_kbps,
+				                                rbdc_alloc_kbps);
+				shard.request += rbdc_request_kbps;
+				shard.alloc += rbdc_alloc_kbps;
+			}
 		}
+		return true;
+	});
+
+	for(auto &&shard: this->shards)
+	{
+		gw_rbdc_request_kbps += shard.request;
+		gw_rbdc_alloc_kbps += shard.alloc;
+		this->gw_rbdc_req_num += shard.req_num;
 	}
 	// Output stats and probes
 	this->probe_gw_rbdc_req_num->put(gw_rbdc_req_num);
@@ -218,31 +392,33 @@ bool DamaCtrlRcs2Legacy::computeTerminalsVbdcAllocation()
 {
 	vol_kb_t gw_vbdc_request_kb = 0;
 	vol_kb_t gw_vbdc_alloc_kb = 0;
-	TerminalCategories<TerminalCategoryDama>::const_iterator category_it;
-	std::vector<CarriersGroupDama *>::const_iterator carrier_it;
 
-	for(category_it = this->categories.begin();
-	    category_it != this->categories.end();
-	    ++category_it)
+	this->runShards([this](dama_shard_t &shard)
 	{
-		TerminalCategoryDama *category = (*category_it).second;
-		std::vector<CarriersGroupDama *> carriers_group;
-
-		carriers_group = category->getCarriersGroups();
-		for(carrier_it = carriers_group.begin();
-		    carrier_it != carriers_group.end();
-		    ++carrier_it)
+		for(auto &&category: shard.categories)
 		{
-			vol_kb_t vbdc_request_kb = 0;
-			vol_kb_t vbdc_alloc_kb = 0;
-
-			this->computeDamaVbdcPerCarrier(*carrier_it,
-			                            category,
-			                            vbdc_request_kb,
-			                            vbdc_alloc_kb);
-			gw_vbdc_request_kb += vbdc_request_kb;
-			gw_vbdc_alloc_kb += vbdc_alloc_kb;
+			for(auto &&carriers: category->getCarriersGroups())
+			{
+				vol_kb_t vbdc_request_kb = 0;
+				vol_kb_t vbdc_alloc_kb = 0;
+
+				this->computeDamaVbdcPerCarrier(shard,
+				                                carriers,
+				                                category,
+				                                vbdc_request_kb,
+				                                vbdc_alloc_kb);
+				shard.request += vbdc_request_kb;
+				shard.alloc += vbdc_alloc_kb;
+			}
 		}
+		return true;
+	});
+
+	for(auto &&shard: this->shards)
+	{
+		gw_vbdc_request_kb += shard.request;
+		gw_vbdc_alloc_kb += shard.alloc;
+		this->gw_vbdc_req_num += shard.req_num;
 	}
 
 	// Output stats and probes
@@ -258,8 +434,6 @@ bool DamaCtrlRcs2Legacy::computeTerminalsVbdcAllocation()
 bool DamaCtrlRcs2Legacy::computeTerminalsFcaAllocation()
 {
 	rate_kbps_t gw_fca_alloc_kbps = 0;
-	TerminalCategories<TerminalCategoryDama>::const_iterator category_it;
-	std::vector<CarriersGroupDama *>::const_iterator carrier_it;
 
 	if(this->fca_kbps == 0)
 	{
@@ -268,25 +442,27 @@ bool DamaCtrlRcs2Legacy::computeTerminalsFcaAllocation()
 		return true;
 	}
 
-	for(category_it = this->categories.begin();
-	    category_it != this->categories.end();
-	    ++category_it)
+	this->runShards([this](dama_shard_t &shard)
 	{
-		TerminalCategoryDama *category = (*category_it).second;
-		std::vector<CarriersGroupDama *> carriers_group;
-
-		carriers_group = category->getCarriersGroups();
-		for(carrier_it = carriers_group.begin();
-		    carrier_it != carriers_group.end();
-		    ++carrier_it)
+		for(auto &&category: shard.categories)
 		{
-			rate_kbps_t fca_alloc_kbps = 0;
+			for(auto &&carriers: category->getCarriersGroups())
+			{
+				rate_kbps_t fca_alloc_kbps = 0;
 
-			this->computeDamaFcaPerCarrier(*carrier_it,
-			                            category,
-			                            fca_alloc_kbps);
-			gw_fca_alloc_kbps += fca_alloc_kbps;
+				this->computeDamaFcaPerCarrier(shard,
+				                               carriers,
+				                               category,
+				                               fca_alloc_kbps);
+				shard.alloc += fca_alloc_kbps;
+			}
 		}
+		return true;
+	});
+
+	for(auto &&shard: this->shards)
+	{
+		gw_fca_alloc_kbps += shard.alloc;
 	}
 
 	// Be careful to use probes only if FCA is enabled
@@ -296,7 +472,8 @@ bool DamaCtrlRcs2Legacy::computeTerminalsFcaAllocation()
 	return true;
 }
 
-void DamaCtrlRcs2Legacy::computeDamaCraPerCarrier(CarriersGroupDama *carriers,
+void DamaCtrlRcs2Legacy::computeDamaCraPerCarrier(dama_shard_t &shard,
+                                                  CarriersGroupDama *carriers,
                                                   const TerminalCategoryDama *category,
                                                   rate_kbps_t &request_rate_kbps,
                                                   rate_kbps_t &alloc_rate_kbps)
@@ -305,12 +482,11 @@ void DamaCtrlRcs2Legacy::computeDamaCraPerCarrier(CarriersGroupDama *carriers,
 	std::string label = category->getLabel();
 	std::string debug;
 
-	std::vector<TerminalContextDamaRcs *> tal;
 	TerminalContextDamaRcs *terminal;
 	unsigned int carrier_id = carriers->getCarriersId();
 	rate_pktpf_t remaining_capacity_pktpf;
 	rate_pktpf_t total_capacity_pktpf;
-	std::vector<TerminalContextDamaRcs *>::iterator tal_it;
+	std::vector<TerminalContextDamaRcs *>::const_iterator tal_it;
 	tal_id_t tal_id;
 	rate_kbps_t simu_cra_kbps = 0;
 
@@ -320,13 +496,14 @@ void DamaCtrlRcs2Legacy::computeDamaCraPerCarrier(CarriersGroupDama *carriers,
 
 	// Get the remaining capacity in timeslot number (per frame)
 	remaining_capacity_pktpf = carriers->getRemainingCapacity();
-	total_capacity_pktpf = this->converter->symToPkt(carriers->getTotalCapacity());
+	total_capacity_pktpf = shard.converter->symToPkt(carriers->getTotalCapacity());
 
 	LOG(this->log_run_dama, LEVEL_INFO,
 	    "%s remaining capacity = %u packets per superframe before CRA allocation (total: %u packets)\n",
 	    debug.c_str(), remaining_capacity_pktpf, total_capacity_pktpf);
 
-	tal = category->getTerminalsInCarriersGroup<TerminalContextDamaRcs>(carrier_id);
+	// the CRA step does not sort the terminals, use the category index
+	const std::vector<TerminalContextDamaRcs *> &tal = category->getTerminalsInCarriersGroup(carrier_id);
 
 	// get total CRA allocation
 	for(tal_it = tal.begin(); tal_it != tal.end(); ++tal_it)
@@ -342,7 +519,7 @@ void DamaCtrlRcs2Legacy::computeDamaCraPerCarrier(CarriersGroupDama *carriers,
 		{
 			continue;
 		}
-		this->converter->setModulationEfficiency(fmt_def->getModulationEfficiency());
+		shard.converter->setModulationEfficiency(fmt_def->getModulationEfficiency());
 
 		cra_kbps = terminal->getRequiredCra();
 		LOG(this->log_run_dama, LEVEL_DEBUG,
@@ -356,13 +533,13 @@ void DamaCtrlRcs2Legacy::computeDamaCraPerCarrier(CarriersGroupDama *carriers,
 		    "%s ST%d: CRA with FEC %u kb/s",
 		    debug.c_str(), tal_id, cra_kbps);
 
-		cra_pktpf = this->converter->kbpsToPktpf(cra_kbps);
+		cra_pktpf = shard.converter->kbpsToPktpf(cra_kbps);
 		LOG(this->log_run_dama, LEVEL_DEBUG,
 		    "%s ST%d: CRA %u packets per frame",
 		    debug.c_str(), tal_id, cra_pktpf);
 
 		// Evaluate the real requested rate (multiple of the timeslot rate)
-		cra_kbps = this->converter->pktpfToKbps(cra_pktpf);
+		cra_kbps = shard.converter->pktpfToKbps(cra_pktpf);
 		cra_kbps = fmt_def->removeFec(cra_kbps);
 		LOG(this->log_run_dama, LEVEL_DEBUG,
 		    "%s ST%d: Updated CRA %u kb/s to timeslot use consequence",
@@ -386,13 +563,13 @@ void DamaCtrlRcs2Legacy::computeDamaCraPerCarrier(CarriersGroupDama *carriers,
 		}
 		else
 		{
-			this->probes_st_cra_alloc[tal_id]->put(cra_kbps);
+			this->putProbe(shard, this->probes_st_cra_alloc, tal_id, cra_kbps, true);
 		}
 	}
 
 	if(this->simulated)
 	{
-		this->probes_st_cra_alloc[0]->put(simu_cra_kbps);
+		this->putProbe(shard, this->probes_st_cra_alloc, 0, simu_cra_kbps, false);
 	}
 
 	LOG(this->log_run_dama, LEVEL_INFO,
@@ -402,7 +579,8 @@ void DamaCtrlRcs2Legacy::computeDamaCraPerCarrier(CarriersGroupDama *carriers,
 	carriers->setRemainingCapacity(remaining_capacity_pktpf);
 }
 
-void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
+void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(dama_shard_t &shard,
+                                                   CarriersGroupDama *carriers,
                                                    const TerminalCategoryDama *category,
                                                    rate_kbps_t &request_rate_kbps,
                                                    rate_kbps_t &alloc_rate_kbps)
@@ -412,6 +590,8 @@ void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
 	rate_kbps_t request_kbps;
 	rate_kbps_t rbdc_alloc_kbps;
 	double fair_share;
+	double fair_share_level = 0.0;
+	bool congested;
 	rate_pktpf_t rbdc_alloc_pktpf = 0;
 	std::vector<TerminalContextDamaRcs *> tal;
 	TerminalContextDamaRcs *terminal;
@@ -425,7 +605,11 @@ void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
 	std::string label = category->getLabel();
 	std::string debug;
 
-	std::map<tal_id_t, rate_pktpf_t> tal_request_pktpf;
+	// the requests in the terminals order, set before they are sorted
+	std::vector<rate_pktpf_t> tal_request_pktpf;
+	// the fair share weights in the terminals order
+	std::vector<double> tal_weight_pktpf;
+	DamaFairShare *weighted_share = nullptr;
 
 	// set default values
 	request_rate_kbps = 0;
@@ -437,7 +621,7 @@ void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
 
 	// Get the remaining capacity in timeslot number (per frame)
 	remaining_capacity_pktpf = carriers->getRemainingCapacity();
-	total_capacity_pktpf = this->converter->symToPkt(carriers->getTotalCapacity());
+	total_capacity_pktpf = shard.converter->symToPkt(carriers->getTotalCapacity());
 
 	if(remaining_capacity_pktpf == 0)
 	{
@@ -451,7 +635,14 @@ void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
 	    "%s remaining capacity = %u packets per superframe before RBDC allocation (total: %u packets)\n",
 	    debug.c_str(), remaining_capacity_pktpf, total_capacity_pktpf);
 
-	tal = category->getTerminalsInCarriersGroup<TerminalContextDamaRcs>(carrier_id);
+	tal = category->getTerminalsInCarriersGroup(carrier_id);
+	tal_request_pktpf.assign(tal.size(), 0);
+	if(this->fair_share)
+	{
+		weighted_share = &this->rbdc_fair_shares.at(label).at(carrier_id);
+		weighted_share->beginUpdate();
+		tal_weight_pktpf.assign(tal.size(), 1.0);
+	}
 
 	// get total RBDC requests
 	for(tal_it = tal.begin(); tal_it != tal.end(); ++tal_it)
@@ -464,7 +655,7 @@ void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
 		{
 			continue;
 		}
-		this->converter->setModulationEfficiency(fmt_def->getModulationEfficiency());
+		shard.converter->setModulationEfficiency(fmt_def->getModulationEfficiency());
 
 		request_kbps = terminal->getRequiredRbdc();
 		LOG(this->log_run_dama, LEVEL_DEBUG,
@@ -476,14 +667,23 @@ void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
 		    "%s ST%d: RBDC request with FEC %u kb/s",
 		    debug.c_str(), tal_id, request_kbps);
 
-		request_pktpf = this->converter->kbpsToPktpf(request_kbps);
+		request_pktpf = shard.converter->kbpsToPktpf(request_kbps);
 		LOG(this->log_run_dama, LEVEL_DEBUG,
 		    "%s ST%d: RBDC request %u packets per frame",
 		    debug.c_str(), tal_id, request_pktpf);
-		tal_request_pktpf[tal_id] = request_pktpf;
+		tal_request_pktpf[tal_it - tal.begin()] = request_pktpf;
+		if(weighted_share != nullptr)
+		{
+			// the terminals get the same part of their maximal RBDC
+			rate_pktpf_t max_rbdc_pktpf;
+			max_rbdc_pktpf = shard.converter->kbpsToPktpf(fmt_def->addFec(terminal->getMaxRbdc()));
+			tal_weight_pktpf[tal_it - tal.begin()] = std::max(max_rbdc_pktpf, rate_pktpf_t(1));
+			weighted_share->setFlow(tal_id, request_pktpf,
+			                        tal_weight_pktpf[tal_it - tal.begin()]);
+		}
 
 		// Evaluate the real requested rate (multiple of the timeslot rate)
-		request_kbps = this->converter->pktpfToKbps(request_pktpf);
+		request_kbps = shard.converter->pktpfToKbps(request_pktpf);
 		request_kbps = fmt_def->removeFec(request_kbps);
 		LOG(this->log_run_dama, LEVEL_DEBUG,
 		    "%s ST%d: Updated RBDC request %u kb/s to timeslot use consequence",
@@ -493,11 +693,15 @@ void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
 
 		// Output stats and probes
 		if (request_pktpf > 0)
-			this->gw_rbdc_req_num++;
+			shard.req_num++;
 
 		// Output stats and probes
 		request_rate_kbps += request_kbps;
 	}
+	if(weighted_share != nullptr)
+	{
+		weighted_share->endUpdate();
+	}
 
 	if(total_request_pktpf == 0)
 	{
@@ -511,12 +715,12 @@ void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
 			tal_id_t tal_id = terminal->getTerminalId();
 			if(tal_id < BROADCAST_TAL_ID)
 			{
-				this->probes_st_rbdc_alloc[tal_id]->put(0);
+				this->putProbe(shard, this->probes_st_rbdc_alloc, tal_id, 0, true);
 			}
 		}
 		if(this->simulated)
 		{
-			this->probes_st_rbdc_alloc[0]->put(0);
+			this->putProbe(shard, this->probes_st_rbdc_alloc, 0, 0, false);
 		}
 
 		return;
@@ -531,6 +735,11 @@ void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
 	{
 		fair_share = 1.0;
 	}
+	congested = fair_share > 1.0;
+	if(weighted_share != nullptr && congested)
+	{
+		fair_share_level = weighted_share->getLevel(remaining_capacity_pktpf);
+	}
 
 	LOG(this->log_run_dama, LEVEL_INFO,
 	    "%s: sum of all RBDC requests = %u packets per superframe, "
@@ -552,23 +761,34 @@ void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
 		{
 			if(tal_id <= BROADCAST_TAL_ID)
 			{
-				this->probes_st_rbdc_alloc[tal_id]->put(0);
+				this->putProbe(shard, this->probes_st_rbdc_alloc, tal_id, 0, true);
 			}
 			continue;
 		}
-		this->converter->setModulationEfficiency(fmt_def->getModulationEfficiency());
+		shard.converter->setModulationEfficiency(fmt_def->getModulationEfficiency());
 
 		// apply the fair share coef to all requests
-		request_pktpf = tal_request_pktpf[tal_id];
-		fair_rbdc_pktpf = (double) (request_pktpf / fair_share);
+		request_pktpf = tal_request_pktpf[tal_it - tal.begin()];
+		if(weighted_share != nullptr && congested)
+		{
+			fair_rbdc_pktpf = DamaFairShare::getShare(request_pktpf,
+			                                          tal_weight_pktpf[tal_it - tal.begin()],
+			                                          fair_share_level);
+		}
+		else
+		{
+			fair_rbdc_pktpf = (double) (request_pktpf / fair_share);
+		}
 
-		// take the integer part of fair RBDC
-		rbdc_alloc_pktpf = floor(fair_rbdc_pktpf);
+		// take the integer part of fair RBDC, the rounding errors of the
+		// fair share level cannot exceed the capacity
+		rbdc_alloc_pktpf = std::min<rate_pktpf_t>(floor(fair_rbdc_pktpf),
+		                                          remaining_capacity_pktpf);
 		LOG(this->log_run_dama, LEVEL_DEBUG,
 		    "%s ST%d: RBDC allocation %u packets per frame",
 		    debug.c_str(), tal_id, rbdc_alloc_pktpf);
 
-		rbdc_alloc_kbps = this->converter->pktpfToKbps(rbdc_alloc_pktpf);
+		rbdc_alloc_kbps = shard.converter->pktpfToKbps(rbdc_alloc_pktpf);
 		LOG(this->log_run_dama, LEVEL_DEBUG,
 		    "%s ST%d: RBDC allocation with FEC %u kb/s",
 		    debug.c_str(), tal_id, rbdc_alloc_kbps);
@@ -591,19 +811,19 @@ void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
 		}
 		else
 		{
-			this->probes_st_rbdc_alloc[tal_id]->put(rbdc_alloc_kbps);
+			this->putProbe(shard, this->probes_st_rbdc_alloc, tal_id, rbdc_alloc_kbps, true);
 		}
-		rbdc_alloc_symps = this->converter->pktpfToSymps(rbdc_alloc_pktpf);
+		rbdc_alloc_symps = shard.converter->pktpfToSymps(rbdc_alloc_pktpf);
 		this->carrier_return_remaining_capacity[label][carrier_id] -= rbdc_alloc_symps;
 		this->category_return_remaining_capacity[label] -= rbdc_alloc_symps;
-		this->gw_remaining_capacity -= rbdc_alloc_symps;
+		shard.remaining_capacity -= rbdc_alloc_symps;
 
-		if(fair_share > 1.0)
+		if(congested)
 		{
 			// add the decimal part of the fair RBDC
 			double rbdc_credit_kbps = (fair_rbdc_pktpf - rbdc_alloc_pktpf)
-				* this->converter->getPacketBitLength()
-				/ (double)(this->converter->getFrameDuration());
+				* shard.converter->getPacketBitLength()
+				/ (double)(shard.converter->getFrameDuration());
 			rbdc_credit_kbps /= (fmt_def->getCodingRate());
 			terminal->addRbdcCredit(rbdc_credit_kbps);
 
@@ -614,11 +834,11 @@ void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
 	}
 	if(this->simulated)
 	{
-		this->probes_st_rbdc_alloc[0]->put(simu_rbdc);
+		this->putProbe(shard, this->probes_st_rbdc_alloc, 0, simu_rbdc, false);
 	}
 
 	// second step : RBDC decimal part treatment
-	if(fair_share > 1.0)
+	if(congested)
 	{
 		// sort terminal according to their remaining credit
 		std::stable_sort(tal.begin(), tal.end(),
@@ -636,9 +856,9 @@ void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
 			{
 				continue;
 			}
-			this->converter->setModulationEfficiency(fmt_def->getModulationEfficiency());
+			shard.converter->setModulationEfficiency(fmt_def->getModulationEfficiency());
 
-			slot_kbps = fmt_def->removeFec(this->converter->pktpfToKbps(1));
+			slot_kbps = fmt_def->removeFec(shard.converter->pktpfToKbps(1));
 			credit_kbps = terminal->getRbdcCredit();
 			LOG(this->log_run_dama, LEVEL_DEBUG,
 			    "%s step 2 scanning ST%u remaining capacity=%u packet "
@@ -666,10 +886,10 @@ void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
 					    "%s step 2 allocating 1 timeslot to ST%u\n",
 					    debug.c_str(), tal_id);
 					// Update probes and stats
-					slot_symps = this->converter->pktpfToSymps(1);
+					slot_symps = shard.converter->pktpfToSymps(1);
 					this->carrier_return_remaining_capacity[label][carrier_id] -= slot_symps;
 					this->category_return_remaining_capacity[label] -= slot_symps;
-					this->gw_remaining_capacity -= slot_symps;
+					shard.remaining_capacity -= slot_symps;
 				}
 			}
 		}
@@ -682,7 +902,8 @@ void DamaCtrlRcs2Legacy::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
 	carriers->setRemainingCapacity(remaining_capacity_pktpf);
 }
 
-void DamaCtrlRcs2Legacy::computeDamaVbdcPerCarrier(CarriersGroupDama *carriers,
+void DamaCtrlRcs2Legacy::computeDamaVbdcPerCarrier(dama_shard_t &shard,
+                                                   CarriersGroupDama *carriers,
                                                    const TerminalCategoryDama *category,
                                                    vol_kb_t &request_vol_kb,
                                                    vol_kb_t &alloc_vol_kb)
@@ -707,9 +928,9 @@ void DamaCtrlRcs2Legacy::computeDamaVbdcPerCarrier(CarriersGroupDama *carriers,
 
 	// Get the remaining capacity in timeslot number (per frame)
 	remaining_capacity_pktpf = carriers->getRemainingCapacity();
-	total_capacity_pktpf = this->converter->symToPkt(carriers->getTotalCapacity());
+	total_capacity_pktpf = shard.converter->symToPkt(carriers->getTotalCapacity());
 
-	tal = category->getTerminalsInCarriersGroup<TerminalContextDamaRcs>(carrier_id);
+	tal = category->getTerminalsInCarriersGroup(carrier_id);
 	if(remaining_capacity_pktpf == 0)
 	{
 		LOG(this->log_run_dama, LEVEL_NOTICE,
@@ -723,12 +944,12 @@ void DamaCtrlRcs2Legacy::computeDamaVbdcPerCarrier(CarriersGroupDama *carriers,
 			tal_id_t tal_id = terminal->getTerminalId();
 			if(tal_id < BROADCAST_TAL_ID)
 			{
-				this->probes_st_vbdc_alloc[tal_id]->put(0);
+				this->putProbe(shard, this->probes_st_vbdc_alloc, tal_id, 0, true);
 			}
 		}
 		if(this->simulated)
 		{
-			this->probes_st_vbdc_alloc[0]->put(0);
+			this->putProbe(shard, this->probes_st_vbdc_alloc, 0, 0, false);
 		}
 
 		return;
@@ -738,9 +959,6 @@ void DamaCtrlRcs2Legacy::computeDamaVbdcPerCarrier(CarriersGroupDama *carriers,
 	    "%s remaining capacity = %u packets per superframe before VBDC allocation (total: %u packets)\n",
 	    debug.c_str(), remaining_capacity_pktpf, total_capacity_pktpf);
 
-	// sort terminal according to their VBDC requests
-	std::stable_sort(tal.begin(), tal.end(),
-	                 TerminalContextDamaRcs::sortByVbdcReq);
 	tal_it = tal.begin();
 	if(tal_it == tal.end())
 	{
@@ -770,11 +988,11 @@ void DamaCtrlRcs2Legacy::computeDamaVbdcPerCarrier(CarriersGroupDama *carriers,
 			// Output probes and stats
 			if(tal_id <= BROADCAST_TAL_ID)
 			{
-				this->probes_st_vbdc_alloc[tal_id]->put(0);
+				this->putProbe(shard, this->probes_st_vbdc_alloc, tal_id, 0, true);
 			}
 			continue;
 		}
-		this->converter->setModulationEfficiency(fmt_def->getModulationEfficiency());
+		shard.converter->setModulationEfficiency(fmt_def->getModulationEfficiency());
 
 		request_kb = terminal->getRequiredVbdc();
 		LOG(this->log_run_dama, LEVEL_DEBUG,
@@ -786,7 +1004,7 @@ void DamaCtrlRcs2Legacy::computeDamaVbdcPerCarrier(CarriersGroupDama *carriers,
 		    "%s ST%u: VBDC request with FEC %u kb",
 		    debug.c_str(), tal_id, request_kb);
 
-		request_pkt = this->converter->kbitsToPkt(request_kb);
+		request_pkt = shard.converter->kbitsToPkt(request_kb);
 		LOG(this->log_run_dama, LEVEL_DEBUG,
 		    "%s ST%u: VBDC request %u packets",
 		    debug.c_str(), tal_id, request_pkt);
@@ -795,7 +1013,7 @@ void DamaCtrlRcs2Legacy::computeDamaVbdcPerCarrier(CarriersGroupDama *carriers,
 		{
 			continue;
 		}
-		this->gw_vbdc_req_num++;
+		shard.req_num++;
 		request_vol_kb += request_kb;
 
 		if(request_pkt <= remaining_capacity_pktpf)
@@ -813,7 +1031,7 @@ void DamaCtrlRcs2Legacy::computeDamaVbdcPerCarrier(CarriersGroupDama *carriers,
 		    debug.c_str(), tal_id, alloc_pkt);
 		remaining_capacity_pktpf -= alloc_pkt;
 
-		alloc_kb = this->converter->pktToKbits(alloc_pkt);
+		alloc_kb = shard.converter->pktToKbits(alloc_pkt);
 		LOG(this->log_run_dama, LEVEL_DEBUG,
 		    "%s ST%u: VBDC allocation with FEC %u kb",
 		    debug.c_str(), tal_id, alloc_kb);
@@ -833,17 +1051,17 @@ void DamaCtrlRcs2Legacy::computeDamaVbdcPerCarrier(CarriersGroupDama *carriers,
 		}
 		else
 		{
-			this->probes_st_vbdc_alloc[tal_id]->put(alloc_kb);
+			this->putProbe(shard, this->probes_st_vbdc_alloc, tal_id, alloc_kb, true);
 		}
-		alloc_symps = this->converter->pktpfToSymps(alloc_pkt);
+		alloc_symps = shard.converter->pktpfToSymps(alloc_pkt);
 		this->carrier_return_remaining_capacity[label][carrier_id] -= alloc_symps;
 		this->category_return_remaining_capacity[label] -= alloc_symps;
-		this->gw_remaining_capacity -= alloc_symps;
+		shard.remaining_capacity -= alloc_symps;
 	}
 
 	if(this->simulated)
 	{
-		this->probes_st_vbdc_alloc[0]->put(simu_vbdc);
+		this->putProbe(shard, this->probes_st_vbdc_alloc, 0, simu_vbdc, false);
 	}
 
 	// Check if other terminals required capacity
@@ -855,7 +1073,7 @@ void DamaCtrlRcs2Legacy::computeDamaVbdcPerCarrier(CarriersGroupDama *carriers,
 		if(request_kb > 0)
 		{
 			request_vol_kb += request_kb;
-			this->gw_vbdc_req_num++;
+			shard.req_num++;
 		}
 	}
 
@@ -870,7 +1088,8 @@ void DamaCtrlRcs2Legacy::computeDamaVbdcPerCarrier(CarriersGroupDama *carriers,
 //      we try to move some terminals not totally served in supported carriers
 //      (in the same category and with supported MODCOD value) in which there
 //      is still capacity
-void DamaCtrlRcs2Legacy::computeDamaFcaPerCarrier(CarriersGroupDama *carriers,
+void DamaCtrlRcs2Legacy::computeDamaFcaPerCarrier(dama_shard_t &shard,
+                                                  CarriersGroupDama *carriers,
                                                   const TerminalCategoryDama *category,
                                                   rate_kbps_t &alloc_rate_kbps)
 {
@@ -892,7 +1111,7 @@ void DamaCtrlRcs2Legacy::computeDamaFcaPerCarrier(CarriersGroupDama *carriers,
 	    << carrier_id << ", category " << label << ":";
 	debug = buf.str();
 
-	tal = category->getTerminalsInCarriersGroup<TerminalContextDamaRcs>(carrier_id);
+	tal = category->getTerminalsInCarriersGroup(carrier_id);
 	tal_it = tal.begin();
 	if(tal_it == tal.end())
 	{
@@ -901,7 +1120,7 @@ void DamaCtrlRcs2Legacy::computeDamaFcaPerCarrier(CarriersGroupDama *carriers,
 	}
 
 	remaining_capacity_pktpf = carriers->getRemainingCapacity();
-	total_capacity_pktpf = this->converter->symToPkt(carriers->getTotalCapacity());
+	total_capacity_pktpf = shard.converter->symToPkt(carriers->getTotalCapacity());
 
 	if(remaining_capacity_pktpf <= 0)
 	{
@@ -912,13 +1131,13 @@ void DamaCtrlRcs2Legacy::computeDamaFcaPerCarrier(CarriersGroupDama *carriers,
 			tal_id_t tal_id = (*tal_it)->getTerminalId();
 			if(tal_id < BROADCAST_TAL_ID)
 			{
-				this->probes_st_fca_alloc[tal_id]->put(0);
+				this->putProbe(shard, this->probes_st_fca_alloc, tal_id, 0, true);
 			}
 			tal_it++;
 		}
 		if(this->simulated)
 		{
-			this->probes_st_fca_alloc[0]->put(0);
+			this->putProbe(shard, this->probes_st_fca_alloc, 0, 0, false);
 		}
 
 		LOG(this->log_run_dama, LEVEL_NOTICE,
@@ -931,25 +1150,46 @@ void DamaCtrlRcs2Legacy::computeDamaFcaPerCarrier(CarriersGroupDama *carriers,
 	    "%s remaining capacity = %u packets per superframe before FCA allocation (total: %u packets)\n",
 	    debug.c_str(), remaining_capacity_pktpf, total_capacity_pktpf);
 
-	// sort terminal according to their remaining credit
-	// this is a random but logical choice
-	std::stable_sort(tal.begin(), tal.end(),
-	                 TerminalContextDamaRcs::sortByRemainingCredit);
+	// serve the terminals by descending remaining credit, this is a
+	// random but logical choice; the capacity is usually exhausted after
+	// a few of them so they are popped from a heap instead of sorting
+	// all the terminals, the ties are served in the terminals order
+	std::vector<std::pair<TerminalContextDamaRcs *, std::size_t>> eligible;
+	eligible.reserve(tal.size());
+	for(tal_it = tal.begin(); tal_it != tal.end(); ++tal_it)
+	{
+		if((*tal_it)->getFmt() != NULL)
+		{
+			eligible.emplace_back(*tal_it, tal_it - tal.begin());
+		}
+	}
+	auto is_served_after = [](const std::pair<TerminalContextDamaRcs *, std::size_t> &e1,
+	                          const std::pair<TerminalContextDamaRcs *, std::size_t> &e2)
+	{
+		if(TerminalContextDamaRcs::sortByRemainingCredit(e1.first, e2.first))
+		{
+			return false;
+		}
+		if(TerminalContextDamaRcs::sortByRemainingCredit(e2.first, e1.first))
+		{
+			return true;
+		}
+		return e1.second > e2.second;
+	};
+	std::make_heap(eligible.begin(), eligible.end(), is_served_after);
 
-	while(tal_it != tal.end() && 0 < remaining_capacity_pktpf)
+	while(!eligible.empty() && 0 < remaining_capacity_pktpf)
 	{
 		rate_pktpf_t fca_alloc_pktpf;
 		rate_kbps_t fca_alloc_kbps;
 		FmtDefinition *fmt_def;
-		terminal = *tal_it;
+		std::pop_heap(eligible.begin(), eligible.end(), is_served_after);
+		terminal = eligible.back().first;
+		eligible.pop_back();
 		tal_id_t tal_id = terminal->getTerminalId();
 		fmt_def = terminal->getFmt();
-		if(fmt_def == NULL)
-		{
-			continue;
-		}
 
-		fca_pktpf = this->converter->kbpsToPktpf(fmt_def->addFec(this->fca_kbps));
+		fca_pktpf = shard.converter->kbpsToPktpf(fmt_def->addFec(this->fca_kbps));
 		if (remaining_capacity_pktpf > fca_pktpf)
 		{
 			fca_alloc_pktpf = fca_pktpf;
@@ -964,7 +1204,7 @@ void DamaCtrlRcs2Legacy::computeDamaFcaPerCarrier(CarriersGroupDama *carriers,
 		    "%s ST%u: FCA alloc %u packets per superframe",
 		    debug.c_str(), tal_id, fca_alloc_pktpf);
 
-		fca_alloc_kbps = fmt_def->removeFec(this->converter->pktpfToKbps(fca_alloc_pktpf));
+		fca_alloc_kbps = fmt_def->removeFec(shard.converter->pktpfToKbps(fca_alloc_pktpf));
 		LOG(this->log_run_dama, LEVEL_DEBUG,
 		    "%s ST%u: FCA alloc %u kb/s",
 		    debug.c_str(), tal_id, fca_alloc_kbps);
@@ -978,17 +1218,15 @@ void DamaCtrlRcs2Legacy::computeDamaFcaPerCarrier(CarriersGroupDama *carriers,
 		}
 		else
 		{
-			this->probes_st_fca_alloc[tal_id]->put(fca_alloc_kbps);
+			this->putProbe(shard, this->probes_st_fca_alloc, tal_id, fca_alloc_kbps, true);
 		}
 		this->carrier_return_remaining_capacity[label][carrier_id] -= fca_alloc_kbps;
 		this->category_return_remaining_capacity[label] -= fca_alloc_kbps;
-		this->gw_remaining_capacity -= fca_alloc_kbps;
-
-		tal_it++;
+		shard.remaining_capacity -= fca_alloc_kbps;
 	}
 	if(this->simulated)
 	{
-		this->probes_st_fca_alloc[0]->put(simu_fca);
+		this->putProbe(shard, this->probes_st_fca_alloc, 0, simu_fca, false);
 	}
 
 	LOG(this->log_run_dama, LEVEL_INFO,
@@ -39,25 +39,47 @@
 #define _DAMA_CONTROLLER_RCS2_LEGACY_H
 
 #include "DamaCtrlRcs2.h"
+#include "DamaFairShare.h"
+#include "DamaWorkers.h"
 
 #include "OpenSandCore.h"
 #include "CarriersGroup.h"
 #include "TerminalCategoryDama.h"
 
+#include <functional>
+
 /**
  *  @class DamaCtrlRcs2Legacy
  *  @brief This library defines the legacy DAMA controller.
+ *
+ * The allocations of all the terminals are computed again on each
+ * superframe, not only the ones of the terminals which sent a SAC: the
+ * RBDC credits and timeouts and the VBDC volumes of every terminal change
+ * from one superframe to the next one.
  */
 class DamaCtrlRcs2Legacy: public DamaCtrlRcs2
 {
 public:
-	DamaCtrlRcs2Legacy(spot_id_t spot);
+	/**
+	 * @brief Create the legacy DAMA controller
+	 *
+	 * @param spot     The spot of the controller
+	 * @param workers     The number of threads computing the allocations,
+	 *                    the carriers groups are sharded between them
+	 * @param fair_share  Whether the congested RBDC capacity is shared in
+	 *                    weighted max-min fair share, the weights being
+	 *                    the terminals maximal RBDC, instead of reducing
+	 *                    the requests in proportion
+	 */
+	DamaCtrlRcs2Legacy(spot_id_t spot, unsigned int workers = 1,
+	                   bool fair_share = false);
 	virtual ~DamaCtrlRcs2Legacy();
 
-private:
 	/// initialize
-	virtual bool init();
+	using DamaCtrlRcs2::init;
+	virtual bool init(vol_sym_t length_sym);
 
+protected:
 	/// CRA allocation
 	virtual bool computeTerminalsCraAllocation();
 
@@ -70,15 +92,101 @@ private:
 	/// FCA allocation
 	virtual bool computeTerminalsFcaAllocation();
 
+	/// check there is one carrier with FMT IDs per category
+	virtual bool checkCategories(const TerminalCategories<TerminalCategoryDama> &categories) const;
+
+	/// create the probes of the new categories and shard them again
+	virtual void initCategories();
+
+private:
+	/**
+	 * @brief A terminal probe value computed by a DAMA worker
+	 */
+	struct dama_probe_value_t
+	{
+		/// The probes of the terminals the value belongs to
+		ProbeListPerTerminal *probes;
+		/// The terminal, 0 for the simulated terminals
+		tal_id_t tal_id;
+		int value;
+		/// Whether the probe is only registered by a value other than zero
+		bool non_zero;
+	};
+
+	/**
+	 * @brief The state of a DAMA worker during an allocation step
+	 */
+	struct dama_shard_t
+	{
+		/// The unit converter of the worker, its modulation efficiency
+		/// is set for each terminal
+		UnitConverterFixedSymbolLength *converter;
+		/// The categories whose carriers groups are allocated by the worker
+		std::vector<TerminalCategoryDama *> categories;
+		/// The gateway remaining capacity, initialized at each step
+		int remaining_capacity;
+		/// The capacity requested during the step, in the step unit
+		unsigned int request;
+		/// The capacity allocated during the step, in the step unit
+		unsigned int alloc;
+		/// The number of requests handled during the step
+		int req_num;
+		/// The probes values of the step, put once the workers are done
+		std::vector<dama_probe_value_t> probes_values;
+	};
+
+	/**
+	 * @brief Shard the categories between the DAMA workers and start them
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool initShards();
+
+	/**
+	 * @brief Spread the categories between the shards
+	 */
+	void assignShards();
+
+	/**
+	 * @brief Create the capacity probes of the categories and carriers
+	 *        groups which do not have them yet
+	 */
+	void initCategoryProbes();
+
+	/**
+	 * @brief Run an allocation step on all the shards, merge
+	 *        their gateway remaining capacity and put their probes
+	 *
+	 * @param step  The allocation step of a shard
+	 * @return true if the step succeeded on all the shards, false otherwise
+	 */
+	bool runShards(const std::function<bool(dama_shard_t &)> &step);
+
+	/**
+	 * @brief Keep a terminal probe value computed by a shard, the probes
+	 *        are not thread-safe and are registered on their first value,
+	 *        so they are only put by the controller thread
+	 *
+	 * @param shard     The worker computing the value
+	 * @param probes    The probes of the terminals
+	 * @param tal_id    The terminal, 0 for the simulated terminals
+	 * @param value     The value
+	 * @param non_zero  Whether the value is put with LazyProbe::putNonZero
+	 */
+	void putProbe(dama_shard_t &shard, ProbeListPerTerminal &probes,
+	              tal_id_t tal_id, int value, bool non_zero);
+
 	/**
 	 * @brief Compute CRA per carriers group
 	 *
+	 * @param shard              The worker computing the carriers group
 	 * @param carriers           The carrier group
 	 * @param category           The terminal category containing the carrier
 	 * @param request_rate_kbps  The requested rate in kbit/s
 	 * @param alloc_rate_kbps    The allocated rate in kbit/s
 	 */
-	void computeDamaCraPerCarrier(CarriersGroupDama *carriers,
+	void computeDamaCraPerCarrier(dama_shard_t &shard,
+	                              CarriersGroupDama *carriers,
 	                              const TerminalCategoryDama *category,
 	                              rate_kbps_t &request_rate_kbps,
 	                              rate_kbps_t &alloc_rate_kbps);
@@ -86,12 +194,14 @@ private:
 	/**
 	 * @brief Compute RBDC per carriers group
 	 *
+	 * @param shard              The worker computing the carriers group
 	 * @param carriers           The carrier group
 	 * @param category           The terminal category containing the carrier
 	 * @param request_rate_kbps  The requested rate in kbit/s
 	 * @param alloc_rate_kbps    The allocated rate in kbit/s
 	 */
-	void computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
+	void computeDamaRbdcPerCarrier(dama_shard_t &shard,
+	                               CarriersGroupDama *carriers,
 	                               const TerminalCategoryDama *category,
 	                               rate_kbps_t &request_rate_kbps,
 	                               rate_kbps_t &alloc_rate_kbps);
@@ -99,12 +209,14 @@ private:
 	/**
 	 * @brief Compute VBDC per carriers group
 	 *
+	 * @param shard           The worker computing the carriers group
 	 * @param carriers        The carrier group
 	 * @param category        The terminal category containing the carrier
 	 * @param request_vol_kb  The requested volume in kbit
 	 * @param alloc_vol_kb    The allocated volume in kbit
 	 */
-	void computeDamaVbdcPerCarrier(CarriersGroupDama *carriers,
+	void computeDamaVbdcPerCarrier(dama_shard_t &shard,
+	                               CarriersGroupDama *carriers,
 	                               const TerminalCategoryDama *category,
 	                               vol_kb_t &request_vol_kb,
 	                               vol_kb_t &alloc_vol_kb);
@@ -112,14 +224,29 @@ private:
 	/**
 	 * @brief Compute FCA per carriers group
 	 *
+	 * @param shard              The worker computing the carriers group
 	 * @param carriers           The carrier group
 	 * @param category           The terminal category containing the carrier
 	 * @param alloc_rate_kbps    The allocated rate in kbit/s
 	 */
-	void computeDamaFcaPerCarrier(CarriersGroupDama *carriers,
+	void computeDamaFcaPerCarrier(dama_shard_t &shard,
+	                              CarriersGroupDama *carriers,
 	                              const TerminalCategoryDama *category,
 	                              rate_kbps_t &alloc_rate_kbps);
 
+	/// The number of DAMA workers requested
+	unsigned int workers_count;
+
+	/// Whether the RBDC capacity is shared in weighted fair share
+	bool fair_share;
+
+	/// The RBDC fair shares of the carriers groups per category, kept
+	/// between the superframes to only move the changed requests
+	std::map<std::string, std::map<unsigned int, DamaFairShare>> rbdc_fair_shares;
+
+	/// The workers, each one owning the carriers groups of its categories
+	std::vector<dama_shard_t> shards;
+	DamaWorkers workers;
 };
 
 #endif
@@ -0,0 +1,307 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file DamaFairShare.cpp
+ * @brief The weighted fair share of a carriers group capacity
+ * @author Viveris Technologies
+ */
+
+#include "DamaFairShare.h"
+
+#include <algorithm>
+#include <limits>
+
+
+DamaFairShare::DamaFairShare():
+	flows(),
+	free_flows(),
+	terminals(),
+	root(nil),
+	generation(0),
+	updated(0),
+	seed(0x9e3779b9)
+{
+}
+
+void DamaFairShare::beginUpdate()
+{
+	this->generation++;
+	this->updated = 0;
+}
+
+void DamaFairShare::setFlow(tal_id_t tal_id, double demand, double weight)
+{
+	uint32_t node;
+	auto terminal_it = this->terminals.find(tal_id);
+	if(terminal_it != this->terminals.end())
+	{
+		node = terminal_it->second;
+		flow_t &flow = this->flows[node];
+		if(flow.generation != this->generation)
+		{
+			flow.generation = this->generation;
+			this->updated++;
+		}
+		if(flow.demand == demand && flow.weight == weight)
+		{
+			return;
+		}
+		this->root = this->erase(this->root, node);
+	}
+	else
+	{
+		if(this->free_flows.empty())
+		{
+			node = this->flows.size();
+			this->flows.emplace_back();
+		}
+		else
+		{
+			node = this->free_flows.back();
+			this->free_flows.pop_back();
+		}
+		// xorshift, the priorities only have to be spread
+		this->seed ^= this->seed << 13;
+		this->seed ^= this->seed >> 17;
+		this->seed ^= this->seed << 5;
+		this->flows[node].tal_id = tal_id;
+		this->flows[node].priority = this->seed;
+		this->flows[node].generation = this->generation;
+		this->terminals.emplace(tal_id, node);
+		this->updated++;
+	}
+
+	flow_t &flow = this->flows[node];
+	flow.demand = demand;
+	flow.weight = weight;
+	flow.ratio = demand / weight;
+	flow.left = nil;
+	flow.right = nil;
+	this->updateSums(node);
+	this->root = this->insert(this->root, node);
+}
+
+void DamaFairShare::endUpdate()
+{
+	if(this->updated == this->terminals.size())
+	{
+		return;
+	}
+	std::vector<uint32_t> stale;
+	for(auto &&terminal_it: this->terminals)
+	{
+		if(this->flows[terminal_it.second].generation != this->generation)
+		{
+			stale.push_back(terminal_it.second);
+		}
+	}
+	for(uint32_t node: stale)
+	{
+		this->removeFlow(node);
+	}
+}
+
+void DamaFairShare::clear()
+{
+	this->flows.clear();
+	this->free_flows.clear();
+	this->terminals.clear();
+	this->root = nil;
+	this->updated = 0;
+}
+
+std::size_t DamaFairShare::getFlowsCount() const
+{
+	return this->terminals.size();
+}
+
+double DamaFairShare::getLevel(double capacity) const
+{
+	if(this->root == nil)
+	{
+		return std::numeric_limits<double>::infinity();
+	}
+	const double total_weight = this->flows[this->root].weight_sum;
+	double served_demand = 0.0;
+	double served_weight = 0.0;
+	uint32_t node = this->root;
+
+	// the flows served up to their demand are a prefix of the tree,
+	// find the last one: serving a flow and all the flows before it
+	// costs its demand per weight for each weight unit of the others
+	while(node != nil)
+	{
+		const flow_t &flow = this->flows[node];
+		double demand = served_demand + flow.demand;
+		double weight = served_weight + flow.weight;
+		if(flow.left != nil)
+		{
+			demand += this->flows[flow.left].demand_sum;
+			weight += this->flows[flow.left].weight_sum;
+		}
+		if(demand + flow.ratio * (total_weight - weight) <= capacity)
+		{
+			served_demand = demand;
+			served_weight = weight;
+			node = flow.right;
+		}
+		else
+		{
+			node = flow.left;
+		}
+	}
+
+	if(total_weight - served_weight <= 0.0)
+	{
+		return std::numeric_limits<double>::infinity();
+	}
+	return std::max(0.0, capacity - served_demand) / (total_weight - served_weight);
+}
+
+double DamaFairShare::getShare(double demand, double weight, double level)
+{
+	return std::min(demand, weight * level);
+}
+
+bool DamaFairShare::isBefore(const flow_t &flow, const flow_t &other) const
+{
+	if(flow.ratio != other.ratio)
+	{
+		return flow.ratio < other.ratio;
+	}
+	return flow.tal_id < other.tal_id;
+}
+
+void DamaFairShare::updateSums(uint32_t node)
+{
+	flow_t &flow = this->flows[node];
+	flow.demand_sum = flow.demand;
+	flow.weight_sum = flow.weight;
+	if(flow.left != nil)
+	{
+		flow.demand_sum += this->flows[flow.left].demand_sum;
+		flow.weight_sum += this->flows[flow.left].weight_sum;
+	}
+	if(flow.right != nil)
+	{
+		flow.demand_sum += this->flows[flow.right].demand_sum;
+		flow.weight_sum += this->flows[flow.right].weight_sum;
+	}
+}
+
+uint32_t DamaFairShare::insert(uint32_t root, uint32_t node)
+{
+	if(root == nil)
+	{
+		return node;
+	}
+	if(this->flows[node].priority > this->flows[root].priority)
+	{
+		this->split(root, node, this->flows[node].left, this->flows[node].right);
+		this->updateSums(node);
+		return node;
+	}
+	if(this->isBefore(this->flows[node], this->flows[root]))
+	{
+		this->flows[root].left = this->insert(this->flows[root].left, node);
+	}
+	else
+	{
+		this->flows[root].right = this->insert(this->flows[root].right, node);
+	}
+	this->updateSums(root);
+	return root;
+}
+
+uint32_t DamaFairShare::erase(uint32_t root, uint32_t node)
+{
+	if(root == node)
+	{
+		return this->merge(this->flows[node].left, this->flows[node].right);
+	}
+	if(this->isBefore(this->flows[node], this->flows[root]))
+	{
+		this->flows[root].left = this->erase(this->flows[root].left, node);
+	}
+	else
+	{
+		this->flows[root].right = this->erase(this->flows[root].right, node);
+	}
+	this->updateSums(root);
+	return root;
+}
+
+uint32_t DamaFairShare::merge(uint32_t left, uint32_t right)
+{
+	if(left == nil)
+	{
+		return right;
+	}
+	if(right == nil)
+	{
+		return left;
+	}
+	if(this->flows[left].priority > this->flows[right].priority)
+	{
+		this->flows[left].right = this->merge(this->flows[left].right, right);
+		this->updateSums(left);
+		return left;
+	}
+	this->flows[right].left = this->merge(left, this->flows[right].left);
+	this->updateSums(right);
+	return right;
+}
+
+void DamaFairShare::split(uint32_t root, uint32_t node, uint32_t &left, uint32_t &right)
+{
+	if(root == nil)
+	{
+		left = nil;
+		right = nil;
+		return;
+	}
+	if(this->isBefore(this->flows[root], this->flows[node]))
+	{
+		this->split(this->flows[root].right, node, this->flows[root].right, right);
+		left = root;
+	}
+	else
+	{
+		this->split(this->flows[root].left, node, left, this->flows[root].left);
+		right = root;
+	}
+	this->updateSums(root);
+}
+
+void DamaFairShare::removeFlow(uint32_t node)
+{
+	this->root = this->erase(this->root, node);
+	this->terminals.erase(this->flows[node].tal_id);
+	this->free_flows.push_back(node);
+}
@@ -0,0 +1,197 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file DamaFairShare.h
+ * @brief The weighted fair share of a carriers group capacity
+ * @author Viveris Technologies
+ */
+
+#ifndef _DAMA_FAIR_SHARE_H
+#define _DAMA_FAIR_SHARE_H
+
+#include "OpenSandCore.h"
+
+#include <unordered_map>
+#include <vector>
+
+
+/**
+ * @class DamaFairShare
+ * @brief The weighted max-min fair share of a capacity between flows
+ *
+ * The flows are kept ordered by their demand per weight in a treap
+ * whose nodes carry the demand and weight sums of their subtree. The
+ * share level, the capacity each flow gets per weight unit, is found
+ * in one descent of the tree and a flow gets the minimum of its demand
+ * and of its weight at the share level. The tree is kept between the
+ * allocations: a flow whose demand changed is moved in O(log n), the
+ * other ones cost nothing.
+ */
+class DamaFairShare
+{
+public:
+	DamaFairShare();
+
+	/**
+	 * @brief Start setting the flows of an allocation, the flows which
+	 *        are not set before endUpdate are removed
+	 */
+	void beginUpdate();
+
+	/**
+	 * @brief Set the demand and weight of a flow
+	 *
+	 * @param tal_id  The terminal of the flow
+	 * @param demand  The demand of the flow
+	 * @param weight  The weight of the flow, strictly positive
+	 */
+	void setFlow(tal_id_t tal_id, double demand, double weight);
+
+	/**
+	 * @brief Remove the flows which were not set since beginUpdate
+	 */
+	void endUpdate();
+
+	/**
+	 * @brief Remove all the flows
+	 */
+	void clear();
+
+	/**
+	 * @brief Get the number of flows
+	 *
+	 * @return the number of flows
+	 */
+	std::size_t getFlowsCount() const;
+
+	/**
+	 * @brief Get the share level of a capacity
+	 *
+	 * @param capacity  The capacity shared between the flows
+	 * @return the capacity a flow gets per weight unit, infinite if the
+	 *         capacity serves all the demands
+	 */
+	double getLevel(double capacity) const;
+
+	/**
+	 * @brief Get the share of a flow at a share level
+	 *
+	 * @param demand  The demand of the flow
+	 * @param weight  The weight of the flow
+	 * @param level   The share level
+	 * @return the share of the flow
+	 */
+	static double getShare(double demand, double weight, double level);
+
+private:
+	/// no node
+	static constexpr uint32_t nil = UINT32_MAX;
+
+	/**
+	 * @brief A flow in the tree
+	 */
+	struct flow_t
+	{
+		tal_id_t tal_id;
+		double demand;
+		double weight;
+		/// the demand per weight, the key of the tree
+		double ratio;
+		uint32_t priority;
+		uint32_t left;
+		uint32_t right;
+		/// the sums of the subtree
+		double demand_sum;
+		double weight_sum;
+		/// the last update the flow was set in
+		unsigned int generation;
+	};
+
+	/**
+	 * @brief Whether a flow is before another one in the tree
+	 */
+	bool isBefore(const flow_t &flow, const flow_t &other) const;
+
+	/**
+	 * @brief Update the sums of a node from its children
+	 */
+	void updateSums(uint32_t node);
+
+	/**
+	 * @brief Insert a node in a subtree
+	 *
+	 * @return the new root of the subtree
+	 */
+	uint32_t insert(uint32_t root, uint32_t node);
+
+	/**
+	 * @brief Remove a node from a subtree
+	 *
+	 * @return the new root of the subtree
+	 */
+	uint32_t erase(uint32_t root, uint32_t node);
+
+	/**
+	 * @brief Merge two subtrees, the nodes of the first one are before
+	 *        the ones of the second one
+	 *
+	 * @return the root of the merged subtree
+	 */
+	uint32_t merge(uint32_t left, uint32_t right);
+
+	/**
+	 * @brief Split a subtree around a node which is not in it
+	 */
+	void split(uint32_t root, uint32_t node, uint32_t &left, uint32_t &right);
+
+	/**
+	 * @brief Remove a flow
+	 */
+	void removeFlow(uint32_t node);
+
+	/// the flows, the free ones are reused
+	std::vector<flow_t> flows;
+	std::vector<uint32_t> free_flows;
+
+	/// the node of each terminal
+	std::unordered_map<tal_id_t, uint32_t> terminals;
+
+	/// the root of the tree
+	uint32_t root;
+
+	/// the current update and the number of flows set in it
+	unsigned int generation;
+	std::size_t updated;
+
+	/// the state of the priorities generator
+	uint32_t seed;
+};
+
+
+#endif
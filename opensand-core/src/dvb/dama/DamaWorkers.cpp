@@ -0,0 +1,94 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file DamaWorkers.cpp
+ * @brief The DAMA allocations of several shards of carriers groups
+ *        computed in parallel by the runtime workers
+ * @author Viveris Technologies
+ */
+
+
+#include "DamaWorkers.h"
+
+#include <opensand_output/Output.h>
+#include <opensand_rt/Rt.h>
+
+#include <atomic>
+
+
+DamaWorkers::DamaWorkers(std::shared_ptr<OutputLog> log):
+	log{log},
+	shards{0}
+{
+}
+
+
+bool DamaWorkers::start(std::size_t shards)
+{
+	if(shards == 0 || this->shards != 0)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "cannot start the DAMA workers\n");
+		return false;
+	}
+	this->shards = shards;
+
+	if(this->shards > 1)
+	{
+		LOG(this->log, LEVEL_NOTICE,
+		    "%zu DAMA shards run on %zu workers\n",
+		    this->shards, Rt::getTaskPool().size());
+	}
+	return true;
+}
+
+
+std::size_t DamaWorkers::size() const
+{
+	return this->shards;
+}
+
+
+bool DamaWorkers::run(const std::function<bool(std::size_t)> &step)
+{
+	if(this->shards <= 1)
+	{
+		return step(0);
+	}
+
+	std::atomic<bool> failed{false};
+	Rt::getTaskPool().parallelFor(0, this->shards, [&step, &failed](std::size_t shard)
+	{
+		if(!step(shard))
+		{
+			failed = true;
+		}
+	});
+	return !failed;
+}
@@ -0,0 +1,94 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file DamaWorkers.h
+ * @brief The DAMA allocations of several shards of carriers groups
+ *        computed in parallel by the runtime workers
+ * @author Viveris Technologies
+ */
+
+#ifndef DAMA_WORKERS_H
+#define DAMA_WORKERS_H
+
+#include <functional>
+#include <memory>
+
+
+class OutputLog;
+
+
+/**
+ * @class DamaWorkers
+ * @brief Run a DAMA allocation step on several shards in parallel
+ *
+ * Each shard owns its carriers groups and their terminals, so the
+ * shards never share capacity and their results are merged by the
+ * caller once the step is over. The shards are given as tasks to the
+ * workers shared by the channels (Rt::getTaskPool), the calling thread
+ * runs the first one and helps with the others while it waits.
+ */
+class DamaWorkers
+{
+public:
+	DamaWorkers(std::shared_ptr<OutputLog> log);
+
+	DamaWorkers(const DamaWorkers &) = delete;
+	DamaWorkers &operator=(const DamaWorkers &) = delete;
+
+	/**
+	 * @brief Set the number of shards
+	 *
+	 * @param shards  The number of shards, the number of tasks
+	 *                of each step
+	 * @return true on success, false otherwise
+	 */
+	bool start(std::size_t shards);
+
+	/**
+	 * @brief Get the number of shards
+	 *
+	 * @return the number of shards, 0 if the pool is not started
+	 */
+	std::size_t size() const;
+
+	/**
+	 * @brief Run a step on all the shards and wait for them
+	 *
+	 * @param step  The step, called with the shard index
+	 * @return true if the step succeeded on all the shards, false otherwise
+	 */
+	bool run(const std::function<bool(std::size_t)> &step);
+
+private:
+	std::shared_ptr<OutputLog> log;
+
+	std::size_t shards;
+};
+
+#endif
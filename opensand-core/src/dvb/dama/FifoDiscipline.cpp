@@ -0,0 +1,301 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file FifoDiscipline.cpp
+ * @brief The disciplines sharing the return link allocation between
+ *        the MAC FIFOs of a terminal
+ * @author Viveris Technologies
+ */
+
+
+#include "FifoDiscipline.h"
+
+#include <algorithm>
+#include <limits>
+
+
+FifoDiscipline::FifoDiscipline(const std::vector<DvbFifo *> &fifos):
+	fifos(fifos),
+	weights(),
+	non_empty((fifos.size() + 63) / 64, 0),
+	non_empty_count(0),
+	current(fifos.size())
+{
+	for(auto &&fifo: this->fifos)
+	{
+		this->weights.push_back(std::max(fifo->getWeight(), 1U));
+	}
+}
+
+
+FifoDiscipline::~FifoDiscipline()
+{
+}
+
+
+std::unique_ptr<FifoDiscipline> FifoDiscipline::create(const std::string &name,
+                                                       const fifos_t &fifos)
+{
+	std::vector<DvbFifo *> scheduled;
+	// the map is ordered by priority
+	for(auto &&it: fifos)
+	{
+		if(it.second->getAccessType() != ForwardOrReturnAccessType{ReturnAccessType::saloha})
+		{
+			scheduled.push_back(it.second);
+		}
+	}
+
+	if(name == "Strict Priority")
+	{
+		return std::unique_ptr<FifoDiscipline>{new FifoDisciplinePriority(scheduled)};
+	}
+	else if(name == "DRR")
+	{
+		return std::unique_ptr<FifoDiscipline>{new FifoDisciplineDrr(scheduled)};
+	}
+	else if(name == "WFQ")
+	{
+		return std::unique_ptr<FifoDiscipline>{new FifoDisciplineWfq(scheduled)};
+	}
+	return nullptr;
+}
+
+
+void FifoDiscipline::refresh()
+{
+	this->non_empty_count = 0;
+	for(std::size_t index = 0; index < this->fifos.size(); ++index)
+	{
+		uint64_t bit = uint64_t(1) << (index % 64);
+		if(this->fifos[index]->getCurrentSize() > 0)
+		{
+			this->non_empty[index / 64] |= bit;
+			this->non_empty_count++;
+		}
+		else if(this->non_empty[index / 64] & bit)
+		{
+			this->non_empty[index / 64] &= ~bit;
+			if(index == this->current)
+			{
+				this->current = this->fifos.size();
+			}
+			this->emptied(index);
+		}
+	}
+}
+
+
+DvbFifo *FifoDiscipline::getFifo()
+{
+	if(this->current < this->fifos.size())
+	{
+		return this->fifos[this->current];
+	}
+	if(this->non_empty_count == 0)
+	{
+		return nullptr;
+	}
+	this->current = this->select();
+	return this->fifos[this->current];
+}
+
+
+void FifoDiscipline::addSent(vol_bytes_t length)
+{
+	if(this->current < this->fifos.size() &&
+	   !this->sent(this->current, length))
+	{
+		// the turn ends, the FIFO keeps its place in the bitmap
+		this->current = this->fifos.size();
+	}
+}
+
+
+void FifoDiscipline::setEmpty()
+{
+	if(this->current >= this->fifos.size())
+	{
+		return;
+	}
+	uint64_t bit = uint64_t(1) << (this->current % 64);
+	if(this->non_empty[this->current / 64] & bit)
+	{
+		this->non_empty[this->current / 64] &= ~bit;
+		this->non_empty_count--;
+	}
+	this->emptied(this->current);
+	this->current = this->fifos.size();
+}
+
+
+void FifoDiscipline::emptied(std::size_t)
+{
+}
+
+
+std::size_t FifoDiscipline::findNonEmpty(std::size_t from) const
+{
+	std::size_t word = from / 64;
+	if(word >= this->non_empty.size())
+	{
+		return this->fifos.size();
+	}
+	uint64_t bits = this->non_empty[word] & (~uint64_t(0) << (from % 64));
+	while(!bits)
+	{
+		if(++word >= this->non_empty.size())
+		{
+			return this->fifos.size();
+		}
+		bits = this->non_empty[word];
+	}
+	return word * 64 + __builtin_ctzll(bits);
+}
+
+
+bool FifoDiscipline::isNonEmpty(std::size_t index) const
+{
+	return this->non_empty[index / 64] & (uint64_t(1) << (index % 64));
+}
+
+
+FifoDisciplinePriority::FifoDisciplinePriority(const std::vector<DvbFifo *> &fifos):
+	FifoDiscipline(fifos)
+{
+}
+
+
+std::size_t FifoDisciplinePriority::select()
+{
+	return this->findNonEmpty(0);
+}
+
+
+bool FifoDisciplinePriority::sent(std::size_t, vol_bytes_t)
+{
+	// a FIFO is served until it is empty
+	return true;
+}
+
+
+FifoDisciplineDrr::FifoDisciplineDrr(const std::vector<DvbFifo *> &fifos):
+	FifoDiscipline(fifos),
+	quanta(),
+	deficits(fifos.size(), 0),
+	next(0)
+{
+	for(auto &&weight: this->weights)
+	{
+		this->quanta.push_back(base_quantum * weight);
+	}
+}
+
+
+std::size_t FifoDisciplineDrr::select()
+{
+	std::size_t index = this->findNonEmpty(this->next);
+	if(index >= this->fifos.size())
+	{
+		index = this->findNonEmpty(0);
+	}
+	this->deficits[index] += this->quanta[index];
+	this->next = index + 1;
+	return index;
+}
+
+
+bool FifoDisciplineDrr::sent(std::size_t index, vol_bytes_t length)
+{
+	this->deficits[index] -= length;
+	return this->deficits[index] > 0;
+}
+
+
+void FifoDisciplineDrr::emptied(std::size_t index)
+{
+	// an empty FIFO does not keep its credit
+	this->deficits[index] = std::min<int64_t>(this->deficits[index], 0);
+}
+
+
+FifoDisciplineWfq::FifoDisciplineWfq(const std::vector<DvbFifo *> &fifos):
+	FifoDiscipline(fifos),
+	costs(),
+	finish_times(fifos.size(), 0),
+	idle(fifos.size(), true),
+	virtual_time(0)
+{
+	for(auto &&weight: this->weights)
+	{
+		this->costs.push_back((uint64_t(1) << 16) / weight);
+	}
+}
+
+
+std::size_t FifoDisciplineWfq::select()
+{
+	std::size_t selected = this->fifos.size();
+	uint64_t smallest = std::numeric_limits<uint64_t>::max();
+	for(std::size_t index = this->findNonEmpty(0);
+	    index < this->fifos.size();
+	    index = this->findNonEmpty(index + 1))
+	{
+		if(this->idle[index])
+		{
+			// a FIFO becoming active cannot claim the service it missed
+			this->finish_times[index] = std::max(this->finish_times[index],
+			                                     this->virtual_time);
+			this->idle[index] = false;
+		}
+		// on equal finish times, the highest priority FIFO wins
+		if(this->finish_times[index] < smallest)
+		{
+			smallest = this->finish_times[index];
+			selected = index;
+		}
+	}
+	return selected;
+}
+
+
+bool FifoDisciplineWfq::sent(std::size_t index, vol_bytes_t length)
+{
+	this->finish_times[index] += length * this->costs[index];
+	this->virtual_time = this->finish_times[index];
+	// select again for each packet
+	return false;
+}
+
+
+void FifoDisciplineWfq::emptied(std::size_t index)
+{
+	this->idle[index] = true;
+}
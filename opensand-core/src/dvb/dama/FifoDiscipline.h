@@ -0,0 +1,244 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file FifoDiscipline.h
+ * @brief The disciplines sharing the return link allocation between
+ *        the MAC FIFOs of a terminal
+ * @author Viveris Technologies
+ */
+
+#ifndef FIFO_DISCIPLINE_H
+#define FIFO_DISCIPLINE_H
+
+#include "DvbFifo.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/**
+ * @class FifoDiscipline
+ * @brief Select the MAC FIFO to serve next
+ *
+ * The FIFOs are stored in a flat array in priority order with their
+ * weights; the FIFOs holding packets are flagged in a bitmap refreshed
+ * at the beginning of each scheduling so that the empty ones are skipped
+ * without being looked at.
+ * A FIFO is served for a turn: packets are taken from it until it is
+ * empty or the discipline ends its turn on the data sent.
+ */
+class FifoDiscipline
+{
+public:
+	/**
+	 * @brief Create a discipline
+	 *
+	 * @param fifos  The MAC FIFOs to schedule, in priority order
+	 */
+	FifoDiscipline(const std::vector<DvbFifo *> &fifos);
+
+	virtual ~FifoDiscipline();
+
+	/**
+	 * @brief Create a discipline from its name
+	 *
+	 * @param name   The discipline name: "Strict Priority", "DRR" or "WFQ"
+	 * @param fifos  The MAC FIFOs, the ones that are not scheduled on
+	 *               the DAMA allocation (Slotted Aloha) are ignored
+	 * @return the discipline, nullptr if the name is unknown
+	 */
+	static std::unique_ptr<FifoDiscipline> create(const std::string &name,
+	                                              const fifos_t &fifos);
+
+	/**
+	 * @brief Flag the FIFOs holding packets before a scheduling
+	 */
+	void refresh();
+
+	/**
+	 * @brief Get the FIFO to serve
+	 *
+	 * @return the FIFO in turn, nullptr if they are all empty
+	 */
+	DvbFifo *getFifo();
+
+	/**
+	 * @brief Account the data sent from the FIFO in turn
+	 *
+	 * @param length  The length of the data sent (in bytes)
+	 */
+	void addSent(vol_bytes_t length);
+
+	/**
+	 * @brief Notify that the FIFO in turn has no more data
+	 */
+	void setEmpty();
+
+protected:
+	/**
+	 * @brief Select the next FIFO to serve among the non empty ones,
+	 *        there is at least one
+	 *
+	 * @return the index of the FIFO
+	 */
+	virtual std::size_t select() = 0;
+
+	/**
+	 * @brief Account the data sent from a FIFO
+	 *
+	 * @param index   The index of the FIFO
+	 * @param length  The length of the data sent (in bytes)
+	 * @return true if the FIFO turn goes on, false otherwise
+	 */
+	virtual bool sent(std::size_t index, vol_bytes_t length) = 0;
+
+	/**
+	 * @brief Notify that a FIFO has no more data
+	 *
+	 * @param index  The index of the FIFO
+	 */
+	virtual void emptied(std::size_t index);
+
+	/**
+	 * @brief Get the first non empty FIFO from an index
+	 *
+	 * @param from  The first index to look at
+	 * @return the index of the FIFO, the FIFOs count if there is none
+	 */
+	std::size_t findNonEmpty(std::size_t from) const;
+
+	/**
+	 * @brief Check whether a FIFO is flagged as holding packets
+	 *
+	 * @param index  The index of the FIFO
+	 * @return true if the FIFO is not empty
+	 */
+	bool isNonEmpty(std::size_t index) const;
+
+	/// The FIFOs in priority order
+	std::vector<DvbFifo *> fifos;
+
+	/// The FIFOs weights, in the same order
+	std::vector<unsigned int> weights;
+
+	/// The bitmap of the non empty FIFOs
+	std::vector<uint64_t> non_empty;
+
+	/// The number of non empty FIFOs
+	std::size_t non_empty_count;
+
+	/// The index of the FIFO in turn, the FIFOs count if none
+	std::size_t current;
+};
+
+
+/**
+ * @class FifoDisciplinePriority
+ * @brief Strict priority: the highest priority FIFO holding packets
+ *        is always served first
+ */
+class FifoDisciplinePriority: public FifoDiscipline
+{
+public:
+	FifoDisciplinePriority(const std::vector<DvbFifo *> &fifos);
+
+protected:
+	std::size_t select() override;
+	bool sent(std::size_t index, vol_bytes_t length) override;
+};
+
+
+/**
+ * @class FifoDisciplineDrr
+ * @brief Deficit round robin: each FIFO is credited of its quantum
+ *        at the beginning of its turn and served while its deficit
+ *        is positive, the overshoot is taken back on the next turn
+ */
+class FifoDisciplineDrr: public FifoDiscipline
+{
+public:
+	/// The quantum of a FIFO of weight 1 (in bytes)
+	static constexpr int64_t base_quantum = 1500;
+
+	FifoDisciplineDrr(const std::vector<DvbFifo *> &fifos);
+
+protected:
+	std::size_t select() override;
+	bool sent(std::size_t index, vol_bytes_t length) override;
+	void emptied(std::size_t index) override;
+
+private:
+	/// The FIFOs quanta (in bytes)
+	std::vector<int64_t> quanta;
+
+	/// The FIFOs deficits (in bytes)
+	std::vector<int64_t> deficits;
+
+	/// The index the next round robin lookup starts from
+	std::size_t next;
+};
+
+
+/**
+ * @class FifoDisciplineWfq
+ * @brief Weighted fair queuing: the FIFO with the smallest virtual
+ *        finish time is served, one packet at a time; the finish time
+ *        grows with the data sent divided by the FIFO weight
+ *        (self-clocked, a FIFO becoming active starts at the current
+ *        virtual time)
+ */
+class FifoDisciplineWfq: public FifoDiscipline
+{
+public:
+	FifoDisciplineWfq(const std::vector<DvbFifo *> &fifos);
+
+protected:
+	std::size_t select() override;
+	bool sent(std::size_t index, vol_bytes_t length) override;
+	void emptied(std::size_t index) override;
+
+private:
+	/// The virtual time cost of a byte for each FIFO (inverse of the weight)
+	std::vector<uint64_t> costs;
+
+	/// The FIFOs virtual finish times
+	std::vector<uint64_t> finish_times;
+
+	/// Whether the FIFOs were idle since their last service
+	std::vector<bool> idle;
+
+	/// The virtual time: the finish time of the last FIFO served
+	uint64_t virtual_time;
+};
+
+
+#endif
@@ -42,47 +42,13 @@
 
 #include "OpenSandModelConf.h"
 #include <opensand_output/Output.h>
+#include <opensand_rt/Rt.h>
+#include <opensand_rt/RtTrace.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
-
-/**
- * @brief Get the payload size in Bytes according to coding rate
- *
- * @param coding_rate  The coding rate
- * @return the payload size in Bytes
- */
-static size_t getPayloadSize(std::string coding_rate)
-{
-	size_t payload;
-
-	// see ESTI EN 302 307 v1.2.1 Table 5a
-	if(!coding_rate.compare("1/4"))
-		payload = 2001;
-	else if(!coding_rate.compare("1/3"))
-		payload = 2676;
-	else if(!coding_rate.compare("2/5"))
-		payload = 3216;
-	else if(!coding_rate.compare("1/2"))
-		payload = 4026;
-	else if(!coding_rate.compare("3/5"))
-		payload = 4836;
-	else if(!coding_rate.compare("2/3"))
-		payload = 5380;
-	else if(!coding_rate.compare("3/4"))
-		payload = 6051;
-	else if(!coding_rate.compare("4/5"))
-		payload = 6456;
-	else if(!coding_rate.compare("5/6"))
-		payload = 6730;
-	else if(!coding_rate.compare("8/9"))
-		payload = 7184;
-	else if(!coding_rate.compare("9/10"))
-		payload = 7274;
-	else
-		payload = 8100; //size of a normal FECFRAME
-
-	return payload;
-}
+#include <tuple>
 
 
 ForwardSchedulingS2::ForwardSchedulingS2(time_ms_t fwd_timer_ms,
@@ -94,12 +60,13 @@ ForwardSchedulingS2::ForwardSchedulingS2(time_ms_t fwd_timer_ms,
                                          spot_id_t spot, 
                                          bool is_gw, 
                                          tal_id_t gw_id,
-                                         std::string dst_name):
+                                         std::string dst_name,
+                                         bool parallel_vcm):
 	Scheduling(packet_handler, fifos, fwd_sts),
 	fwd_timer_ms(fwd_timer_ms),
-	incomplete_bb_frames(),
-	incomplete_bb_frames_ordered(),
-	pending_bbframes(),
+	bbframes(fwd_modcod_def->getMaxId() + 1),
+	parallel_vcm(parallel_vcm),
+	vcm_bbframes(),
 	fwd_modcod_def(fwd_modcod_def),
 	category(category),
 	spot_id(spot),
@@ -148,16 +115,29 @@ ForwardSchedulingS2::ForwardSchedulingS2(time_ms_t fwd_timer_ms,
 
 ForwardSchedulingS2::~ForwardSchedulingS2()
 {
-	for (auto&& bb_frame : this->incomplete_bb_frames_ordered)
+	delete this->category;
+}
+
+
+ForwardSchedulingS2::bbframes_t::bbframes_t(std::size_t modcods):
+	incomplete_ordered(),
+	incomplete(modcods, this->incomplete_ordered.end()),
+	fifo_modcods(),
+	pending()
+{
+}
+
+
+ForwardSchedulingS2::bbframes_t::~bbframes_t()
+{
+	for (auto&& bb_frame : this->incomplete_ordered)
 	{
 		delete bb_frame;
 	}
-	for (auto&& bb_frame : this->pending_bbframes)
+	for (auto&& bb_frame : this->pending)
 	{
 		delete bb_frame;
 	}
-
-	delete this->category;
 }
 
 
@@ -166,11 +146,10 @@ bool ForwardSchedulingS2::schedule(const time_sf_t current_superframe_sf,
                                    std::list<DvbFrame *> *complete_dvb_frames,
                                    uint32_t &remaining_allocation)
 {
-	fifos_t::const_iterator fifo_it;
+	RtTrace::Span span{"forward.schedule"};
 	std::vector<CarriersGroupDama *> carriers_group;
 	std::vector<CarriersGroupDama *>::iterator carrier_it;
 	carriers_group = this->category->getCarriersGroups();
-	vol_sym_t init_capacity_sym;
 	int total_capa = 0;
 
 	for (carrier_it = carriers_group.begin();
@@ -179,139 +158,64 @@ bool ForwardSchedulingS2::schedule(const time_sf_t current_superframe_sf,
 	{
 		CarriersGroupDama *carriers = *carrier_it;
 		std::vector<CarriersGroupDama *> vcm_carriers;
-		std::vector<CarriersGroupDama *>::iterator vcm_it;
-		unsigned int vcm_id = 0;
 
 		vcm_carriers = carriers->getVcmCarriers();
 		// if no VCM, getVcm() will return only one carrier
-		for (vcm_it = vcm_carriers.begin();
-		     vcm_it != vcm_carriers.end();
-		     ++vcm_it)
-		{
-			std::list<BBFrame *>::iterator it;
-			CarriersGroupDama *vcm = *vcm_it;
-			vol_sym_t capacity_sym;
-			vol_sym_t previous_sym;
-
-			// initialize carriers capacity, remaining capacity should be 0
-			// as we use previous capacity to keep track of unused capacity here
-			init_capacity_sym = vcm->getTotalCapacity() +
-			                    vcm->getRemainingCapacity();
-			vcm->setRemainingCapacity(init_capacity_sym);
-			total_capa += init_capacity_sym;
-
-			capacity_sym = init_capacity_sym;
-			previous_sym = vcm->getPreviousCapacity(current_superframe_sf);
-			capacity_sym += previous_sym;
-
-			for(fifo_it = this->dvb_fifos.begin();
-			    fifo_it != this->dvb_fifos.end(); ++fifo_it)
+		bool is_vcm = vcm_carriers.size() > 1;
+		if(!is_vcm || !this->parallel_vcm)
+		{
+			for(unsigned int vcm_id = 0; vcm_id < vcm_carriers.size(); vcm_id++)
 			{
-				DvbFifo *fifo = (*fifo_it).second;
-
-				// check if the FIFO can emit on this carriers group
-				if(vcm_carriers.size() <= 1)
-				{
-					// ACM
-					if(fifo->getAccessType() != ForwardOrReturnAccessType{ForwardAccessType::acm})
-					{
-						LOG(this->log_scheduling, LEVEL_DEBUG,
-						    "SF#%u: Ignore carriers with id %u in category %s "
-						    "for non-ACM fifo %s\n",
-						    current_superframe_sf,
-						    carriers->getCarriersId(),
-						    this->category->getLabel().c_str(),
-						    fifo->getName().c_str());
-						continue;
-					}
-				}
-				else
-				{
-					// VCM
-					if(fifo->getAccessType() != ForwardOrReturnAccessType{ForwardAccessType::vcm})
-					{
-						LOG(this->log_scheduling, LEVEL_DEBUG,
-						    "SF#%u: Ignore carriers with id %u in category %s "
-						    "for non-VCM fifo %s\n",
-						    current_superframe_sf,
-						    carriers->getCarriersId(),
-						    this->category->getLabel().c_str(),
-						    fifo->getName().c_str());
-						continue;
-					}
-					if(fifo->getVcmId() != vcm_id)
-					{
-						continue;
-					}
-				}
-				LOG(this->log_scheduling, LEVEL_DEBUG,
-				    "SF#%u: Can send data from fifo %s on carriers group "
-				    "%u in category %s\n",
-				    current_superframe_sf,
-				    fifo->getName().c_str(), carriers->getCarriersId(),
-				    this->category->getLabel().c_str());
-
-				if(!this->scheduleEncapPackets(fifo,
-				                               current_superframe_sf,
-				                               current_time,
-				                               complete_dvb_frames,
-				                               *vcm_it,
-				                               capacity_sym,
-				                               init_capacity_sym))
+				vol_sym_t init_capacity_sym;
+				if(!this->scheduleCarrier(this->bbframes, carriers,
+				                          vcm_carriers[vcm_id], vcm_id, is_vcm,
+				                          current_superframe_sf, current_time,
+				                          complete_dvb_frames, init_capacity_sym))
 				{
 					return false;
 				}
-
-				if(fifo->getCurrentSize() > 0)
-				{
-					// Still have data on FIFO, do not schedule BBF for lower QoS
-					break;
-				}
+				total_capa += init_capacity_sym;
 			}
+			continue;
+		}
 
-			vcm->setPreviousCapacity(capacity_sym, current_superframe_sf + 1);
-
-			// try to fill the BBFrames list with the remaining
-			// incomplete BBFrames
-			for(it = this->incomplete_bb_frames_ordered.begin();
-			    it != this->incomplete_bb_frames_ordered.end();
-			    it = this->incomplete_bb_frames_ordered.erase(it))
+		// each VCM carrier only schedules the FIFOs of its VCM ID, they are
+		// scheduled in parallel with their own BBFrames then their frames are
+		// merged in the VCM order, as if they were scheduled one after the other
+		std::vector<bbframes_t *> vcm_frames;
+		for(unsigned int vcm_id = 0; vcm_id < vcm_carriers.size(); vcm_id++)
+		{
+			auto key = std::make_pair(carriers->getCarriersId(), vcm_id);
+			auto frames_it = this->vcm_bbframes.find(key);
+			if(frames_it == this->vcm_bbframes.end())
 			{
-				int ret; 
-				if(capacity_sym <= 0)
-				{
-					break;
-				}
-
-				ret = this->addCompleteBBFrame(complete_dvb_frames, *it,
-				                               current_superframe_sf,
-				                               capacity_sym);
-				if(ret == status_error)
-				{
-					return false;
-				}
-				else if(ret == status_ok)
-				{
-					unsigned int modcod = (*it)->getModcodId();
-
-					this->incomplete_bb_frames.erase(modcod);
-					// incomplete ordered erased in loop
-				}
-				else if(ret == status_full)
-				{
-					time_sf_t next_sf = current_superframe_sf + 1;
-					// we keep the remaining capacity that won't be used for
-					// next frame
-					(*vcm_it)->setPreviousCapacity(std::min(capacity_sym,
-					                                        init_capacity_sym),
-					                               next_sf);
-					break;
-				}
+				frames_it = this->vcm_bbframes.emplace(std::piecewise_construct,
+				                                       std::forward_as_tuple(key),
+				                                       std::forward_as_tuple(this->fwd_modcod_def->getMaxId() + 1)).first;
 			}
-			// update remaining capacity for statistics
-			vcm->setRemainingCapacity(std::min(capacity_sym,
-			                                         init_capacity_sym));
-			vcm_id++;
+			vcm_frames.push_back(&frames_it->second);
+		}
+		std::vector<std::list<DvbFrame *>> vcm_complete(vcm_carriers.size());
+		std::vector<vol_sym_t> vcm_capacity(vcm_carriers.size(), 0);
+		std::atomic<bool> failed{false};
+		Rt::getTaskPool().parallelFor(0, vcm_carriers.size(), [&](std::size_t vcm_id)
+		{
+			if(!this->scheduleCarrier(*vcm_frames[vcm_id], carriers,
+			                          vcm_carriers[vcm_id], vcm_id, true,
+			                          current_superframe_sf, current_time,
+			                          &vcm_complete[vcm_id], vcm_capacity[vcm_id]))
+			{
+				failed = true;
+			}
+		});
+		for(unsigned int vcm_id = 0; vcm_id < vcm_carriers.size(); vcm_id++)
+		{
+			complete_dvb_frames->splice(complete_dvb_frames->end(), vcm_complete[vcm_id]);
+			total_capa += vcm_capacity[vcm_id];
+		}
+		if(failed)
+		{
+			return false;
 		}
 	}
 	this->probe_fwd_total_capacity->put(total_capa);
@@ -374,7 +278,143 @@ bool ForwardSchedulingS2::schedule(const time_sf_t current_superframe_sf,
 	return true;
 }
 
-bool ForwardSchedulingS2::scheduleEncapPackets(DvbFifo *fifo,
+bool ForwardSchedulingS2::scheduleCarrier(bbframes_t &frames,
+                                          CarriersGroupDama *carriers,
+                                          CarriersGroupDama *vcm,
+                                          unsigned int vcm_id,
+                                          bool is_vcm,
+                                          const time_sf_t current_superframe_sf,
+                                          clock_t current_time,
+                                          std::list<DvbFrame *> *complete_dvb_frames,
+                                          vol_sym_t &init_capacity_sym)
+{
+	std::list<BBFrame *>::iterator it;
+	vol_sym_t capacity_sym;
+	vol_sym_t previous_sym;
+
+	// initialize carriers capacity, remaining capacity should be 0
+	// as we use previous capacity to keep track of unused capacity here
+	init_capacity_sym = vcm->getTotalCapacity() +
+	                    vcm->getRemainingCapacity();
+	vcm->setRemainingCapacity(init_capacity_sym);
+
+	capacity_sym = init_capacity_sym;
+	previous_sym = vcm->getPreviousCapacity(current_superframe_sf);
+	capacity_sym += previous_sym;
+
+	for(auto fifo_it = this->dvb_fifos.begin();
+	    fifo_it != this->dvb_fifos.end(); ++fifo_it)
+	{
+		DvbFifo *fifo = (*fifo_it).second;
+
+		// check if the FIFO can emit on this carriers group
+		if(!is_vcm)
+		{
+			// ACM
+			if(fifo->getAccessType() != ForwardOrReturnAccessType{ForwardAccessType::acm})
+			{
+				LOG(this->log_scheduling, LEVEL_DEBUG,
+				    "SF#%u: Ignore carriers with id %u in category %s "
+				    "for non-ACM fifo %s\n",
+				    current_superframe_sf,
+				    carriers->getCarriersId(),
+				    this->category->getLabel().c_str(),
+				    fifo->getName().c_str());
+				continue;
+			}
+		}
+		else
+		{
+			// VCM
+			if(fifo->getAccessType() != ForwardOrReturnAccessType{ForwardAccessType::vcm})
+			{
+				LOG(this->log_scheduling, LEVEL_DEBUG,
+				    "SF#%u: Ignore carriers with id %u in category %s "
+				    "for non-VCM fifo %s\n",
+				    current_superframe_sf,
+				    carriers->getCarriersId(),
+				    this->category->getLabel().c_str(),
+				    fifo->getName().c_str());
+				continue;
+			}
+			if(fifo->getVcmId() != vcm_id)
+			{
+				continue;
+			}
+		}
+		LOG(this->log_scheduling, LEVEL_DEBUG,
+		    "SF#%u: Can send data from fifo %s on carriers group "
+		    "%u in category %s\n",
+		    current_superframe_sf,
+		    fifo->getName().c_str(), carriers->getCarriersId(),
+		    this->category->getLabel().c_str());
+
+		if(!this->scheduleEncapPackets(frames,
+		                               fifo,
+		                               current_superframe_sf,
+		                               current_time,
+		                               complete_dvb_frames,
+		                               vcm,
+		                               capacity_sym,
+		                               init_capacity_sym))
+		{
+			return false;
+		}
+
+		if(fifo->getCurrentSize() > 0)
+		{
+			// Still have data on FIFO, do not schedule BBF for lower QoS
+			break;
+		}
+	}
+
+	vcm->setPreviousCapacity(capacity_sym, current_superframe_sf + 1);
+
+	// try to fill the BBFrames list with the remaining
+	// incomplete BBFrames
+	for(it = frames.incomplete_ordered.begin();
+	    it != frames.incomplete_ordered.end();
+	    it = frames.incomplete_ordered.erase(it))
+	{
+		int ret; 
+		if(capacity_sym <= 0)
+		{
+			break;
+		}
+
+		ret = this->addCompleteBBFrame(complete_dvb_frames, *it,
+		                               current_superframe_sf,
+		                               capacity_sym);
+		if(ret == status_error)
+		{
+			return false;
+		}
+		else if(ret == status_ok)
+		{
+			unsigned int modcod = (*it)->getModcodId();
+
+			frames.incomplete[modcod] = frames.incomplete_ordered.end();
+			// incomplete ordered erased in loop
+		}
+		else if(ret == status_full)
+		{
+			time_sf_t next_sf = current_superframe_sf + 1;
+			// we keep the remaining capacity that won't be used for
+			// next frame
+			vcm->setPreviousCapacity(std::min(capacity_sym,
+			                                  init_capacity_sym),
+			                         next_sf);
+			break;
+		}
+	}
+	// update remaining capacity for statistics
+	vcm->setRemainingCapacity(std::min(capacity_sym,
+	                                   init_capacity_sym));
+	return true;
+}
+
+bool ForwardSchedulingS2::scheduleEncapPackets(bbframes_t &frames,
+                                               DvbFifo *fifo,
                                                const time_sf_t current_superframe_sf,
                                                clock_t current_time,
                                                std::list<DvbFrame *> *complete_dvb_frames,
@@ -384,14 +424,14 @@ bool ForwardSchedulingS2::scheduleEncapPackets(DvbFifo *fifo,
 {
 	int ret;
 	unsigned int sent_packets = 0;
-	FifoElement *elem;
+	FifoElement elem;
 	long max_to_send;
 	BBFrame *current_bbframe;
-	std::list<fmt_id_t> supported_modcods = carriers->getFmtIds();
+	const FmtGroup *supported_modcods = carriers->getFmtGroup();
 
 	// retrieve the number of packets waiting for retransmission
 	max_to_send = fifo->getCurrentSize();
-	if (max_to_send <= 0 && this->pending_bbframes.size() == 0)
+	if (max_to_send <= 0 && frames.pending.size() == 0)
 	{
 		return true;
 	}
@@ -407,13 +447,13 @@ bool ForwardSchedulingS2::scheduleEncapPackets(DvbFifo *fifo,
 	// we add previous remaining capacity here because if a BBFrame was
 	// not send before, previous_capacity contains the remaining capacity at the
 	// end of the previous frame
-	this->schedulePending(supported_modcods, current_superframe_sf,
+	this->schedulePending(frames, supported_modcods, current_superframe_sf,
 	                      complete_dvb_frames, capacity_sym);
 
 	// all the previous capacity was not consumed, remove it as we are not on
 	// pending frames anymore of if there is no incomplete frame
 	// (we consider incomplete frames can use previous capacity)
-	if(this->incomplete_bb_frames.size() == 0)
+	if(frames.incomplete_ordered.empty())
 	{
 		capacity_sym = std::min(init_capa, capacity_sym);
 	}
@@ -424,6 +464,9 @@ bool ForwardSchedulingS2::scheduleEncapPackets(DvbFifo *fifo,
 		return true;
 	}
 
+	// the terminals MODCOD are retrieved once for all their packets in the FIFO
+	std::fill(frames.fifo_modcods.begin(), frames.fifo_modcods.end(), 0);
+
 	// there are really packets to send
 	LOG(this->log_scheduling, LEVEL_INFO,
 	    "SF#%u: send at most %ld encapsulation packets "
@@ -435,7 +478,6 @@ bool ForwardSchedulingS2::scheduleEncapPackets(DvbFifo *fifo,
 	{
 		tal_id_t tal_id;
 		std::unique_ptr<NetPacket> encap_packet;
-		std::unique_ptr<NetPacket> data;
 		std::unique_ptr<NetPacket> remaining_data;
 
 		// simulate the satellite delay
@@ -449,9 +491,13 @@ bool ForwardSchedulingS2::scheduleEncapPackets(DvbFifo *fifo,
 			    break;
 		}
 
-		elem = fifo->pop();
+		// the active queue management may drop the remaining packets
+		if(!fifo->pop(elem, current_time))
+		{
+			break;
+		}
 
-		encap_packet = elem->getElem<NetPacket>();
+		encap_packet = elem.getElem<NetPacket>();
 		// retrieve the encapsulation packet
 		if(!encap_packet)
 		{
@@ -459,7 +505,6 @@ bool ForwardSchedulingS2::scheduleEncapPackets(DvbFifo *fifo,
 			    "SF#%u: invalid packet #%u in MAC FIFO "
 			    "element\n", current_superframe_sf,
 			    sent_packets + 1);
-			delete elem;
 			return false;
 		}
 
@@ -489,17 +534,15 @@ bool ForwardSchedulingS2::scheduleEncapPackets(DvbFifo *fifo,
 			    tal_id);
 		}
 
-		if(!this->getIncompleteBBFrame(tal_id, carriers, current_superframe_sf,
+		if(!this->getIncompleteBBFrame(frames, tal_id, carriers, current_superframe_sf,
 		                               &current_bbframe))
 		{
 			// cannot initialize incomplete BB Frame
-			delete elem;
 			return false;
 		}
 		else if(!current_bbframe)
 		{
 			// cannot get modcod for the ST delete the element
-			delete elem;
 			continue;
 		}
 
@@ -508,28 +551,30 @@ bool ForwardSchedulingS2::scheduleEncapPackets(DvbFifo *fifo,
 		    "there is now %zu complete BBFrames and %zu "
 		    "incomplete\n", current_superframe_sf,
 		    sent_packets + 1, complete_dvb_frames->size(),
-		    this->incomplete_bb_frames.size());
+		    frames.incomplete_ordered.size());
 
-		// Encapsulate packet
+		// Encapsulate packet, straight at the end of the BBFrame
 		auto encap_packet_total_length = encap_packet->getTotalLength();
-		ret = this->packet_handler->encapNextPacket(std::move(encap_packet),
-		                                            current_bbframe->getFreeSpace(),
-		                                            current_bbframe->getPacketsCount() == 0,
-		                                            data, remaining_data);
+		std::size_t free_space = current_bbframe->getFreeSpace();
+		Data &frame_buffer = current_bbframe->getPacketBuffer();
+		std::size_t frame_length = frame_buffer.length();
+		ret = this->packet_handler->encapNextPacketInto(std::move(encap_packet),
+		                                                free_space,
+		                                                current_bbframe->getPacketsCount() == 0,
+		                                                frame_buffer, remaining_data);
 		if(!ret)
 		{
 			LOG(this->log_scheduling, LEVEL_ERROR,
 			    "SF#%u: error while processing packet "
 			    "#%u\n", current_superframe_sf,
 			    sent_packets + 1);
-			delete elem;
 		}
 
 		bool partial_encap = remaining_data != nullptr;
-		if(data)
+		std::size_t written = frame_buffer.length() - frame_length;
+		if(written > 0)
 		{
-			// Add data
-			if(!current_bbframe->addPacket(data.get()))
+			if(written > free_space)
 			{
 				LOG(this->log_scheduling, LEVEL_ERROR,
 				    "SF#%u: failed to add encapsulation "
@@ -538,11 +583,12 @@ bool ForwardSchedulingS2::scheduleEncapPackets(DvbFifo *fifo,
 				    current_superframe_sf,
 				    sent_packets + 1,
 				    current_bbframe->getModcodId(),
-				    data->getTotalLength(),
-				    current_bbframe->getFreeSpace());
-				delete elem;
+				    written,
+				    free_space);
+				frame_buffer.resize(frame_length);
 				return false;
 			}
+			current_bbframe->commitPacket(written);
 
 			if(partial_encap)
 			{
@@ -550,7 +596,6 @@ bool ForwardSchedulingS2::scheduleEncapPackets(DvbFifo *fifo,
 				    "SF#%u: packet fragmented",
 				    current_superframe_sf);
 			}
-			// delete the NetPacket once it has been copied in the BBFrame
 			sent_packets++;
 		}
 		else
@@ -566,13 +611,8 @@ bool ForwardSchedulingS2::scheduleEncapPackets(DvbFifo *fifo,
 		if(partial_encap)
 		{
 			// Re-insert packet
-			elem->setElem(std::move(remaining_data));
-			fifo->pushFront(elem);
-		}
-		else
-		{
-			// Delete packet	
-			delete elem;
+			elem.setElem(std::move(remaining_data));
+			fifo->pushFront(std::move(elem));
 		}
 
 		// the BBFrame has been completed or the next packet is too long
@@ -592,8 +632,8 @@ bool ForwardSchedulingS2::scheduleEncapPackets(DvbFifo *fifo,
 			{
 				unsigned int modcod = current_bbframe->getModcodId();
 
-				this->incomplete_bb_frames_ordered.remove(current_bbframe);
-				this->incomplete_bb_frames.erase(modcod);
+				frames.incomplete_ordered.erase(frames.incomplete[modcod]);
+				frames.incomplete[modcod] = frames.incomplete_ordered.end();
 				if(ret == status_full)
 				{
 					time_sf_t next_sf = current_superframe_sf + 1;
@@ -602,7 +642,7 @@ bool ForwardSchedulingS2::scheduleEncapPackets(DvbFifo *fifo,
 					carriers->setPreviousCapacity(capacity_sym,
 					                              next_sf);
 
-					this->pending_bbframes.push_back(current_bbframe);
+					frames.pending.push_back(current_bbframe);
 					break;
 				}
 			}
@@ -711,29 +751,35 @@ unsigned int ForwardSchedulingS2::getBBFrameSizeBytes(unsigned int modcod_id)
 	{
 		// TODO: remove default value. Calling methods should check that return
 		// value is OK.
-		size_t bbframe_size = getPayloadSize("");
+		size_t bbframe_size = CodingTypes::getDefaultPayloadSize();
 		LOG(this->log_scheduling, LEVEL_ERROR,
 		    "could not find fmt definition with id %u, use bbframe size %u bytes",
 		    modcod_id, bbframe_size);
 		return bbframe_size;
 	}
-	return getPayloadSize(fmt_def->getCoding());
+	return fmt_def->getPayloadSize();
 }
 
 
 
 
-bool ForwardSchedulingS2::getIncompleteBBFrame(tal_id_t tal_id,
+bool ForwardSchedulingS2::getIncompleteBBFrame(bbframes_t &frames,
+                                               tal_id_t tal_id,
                                                CarriersGroupDama *carriers,
                                                const time_sf_t current_superframe_sf,
                                                BBFrame **bbframe)
 {
-	std::map<unsigned int, BBFrame *>::iterator iter;
 	unsigned int desired_modcod;
 	unsigned int modcod_id;
 
 	*bbframe = NULL;
 
+	if(tal_id < frames.fifo_modcods.size() && frames.fifo_modcods[tal_id] != 0)
+	{
+		modcod_id = frames.fifo_modcods[tal_id];
+		goto found;
+	}
+
 	// retrieve the current MODCOD for the ST
 	if(!this->simu_sts->isStPresent(tal_id))
 	{
@@ -763,15 +809,26 @@ bool ForwardSchedulingS2::getIncompleteBBFrame(tal_id_t tal_id,
 	LOG(this->log_scheduling, LEVEL_DEBUG,
 	    "SF#%u: Available MODCOD for ST id %u = %u\n",
 	    current_superframe_sf, tal_id, modcod_id);
+	if(frames.fifo_modcods.size() <= tal_id)
+	{
+		frames.fifo_modcods.resize(tal_id + 1, 0);
+	}
+	frames.fifo_modcods[tal_id] = modcod_id;
+
+found:
+	if(frames.incomplete.size() <= modcod_id)
+	{
+		frames.incomplete.resize(modcod_id + 1,
+		                         frames.incomplete_ordered.end());
+	}
 
 	// find if the BBFrame exists
-	iter = this->incomplete_bb_frames.find(modcod_id);
-	if(iter != this->incomplete_bb_frames.end() && (*iter).second != NULL)
+	if(frames.incomplete[modcod_id] != frames.incomplete_ordered.end())
 	{
 		LOG(this->log_scheduling, LEVEL_DEBUG,
 		    "SF#%u: Found a BBFrame for MODCOD %u\n",
 		    current_superframe_sf, modcod_id);
-		*bbframe = (*iter).second;
+		*bbframe = *frames.incomplete[modcod_id];
 	}
 	// no BBFrame for this MOCDCOD create a new one
 	else
@@ -786,9 +843,10 @@ bool ForwardSchedulingS2::getIncompleteBBFrame(tal_id_t tal_id,
 			goto error;
 		}
 
-		// add the BBFrame in the map and list
-		this->incomplete_bb_frames[modcod_id] = *bbframe;
-		this->incomplete_bb_frames_ordered.push_back(*bbframe);
+		// add the BBFrame in the list and keep its position for the MODCOD
+		frames.incomplete[modcod_id] =
+			frames.incomplete_ordered.insert(frames.incomplete_ordered.end(),
+			                                 *bbframe);
 	}
 
 skip:
@@ -843,23 +901,23 @@ sched_status_t ForwardSchedulingS2::addCompleteBBFrame(std::list<DvbFrame *> *co
 }
 
 
-void ForwardSchedulingS2::schedulePending(const std::list<fmt_id_t> supported_modcods,
+void ForwardSchedulingS2::schedulePending(bbframes_t &frames,
+                                          const FmtGroup *supported_modcods,
                                           const time_sf_t current_superframe_sf,
                                           std::list<DvbFrame *> *complete_dvb_frames,
                                           vol_sym_t &remaining_capacity_sym)
 {
-	if(this->pending_bbframes.size() == 0)
+	if(frames.pending.size() == 0)
 	{
 		return;
 	}
 
 	std::list<BBFrame *> new_pending;
-	for (auto&& pending_frame : this->pending_bbframes)
+	for (auto&& pending_frame : frames.pending)
 	{
 		unsigned int modcod = pending_frame->getModcodId();
 
-		if(std::find(supported_modcods.begin(), supported_modcods.end(), modcod) !=
-		   supported_modcods.end())
+		if(supported_modcods->contains(modcod))
 		{
 			sched_status_t status;
 			status = this->addCompleteBBFrame(complete_dvb_frames,
@@ -890,9 +948,9 @@ void ForwardSchedulingS2::schedulePending(const std::list<fmt_id_t> supported_mo
 		    "%zu pending frames scheduled, %zu remaining\n",
 		    complete_dvb_frames->size(), new_pending.size());
 	}
-	this->pending_bbframes.clear();
-	this->pending_bbframes.insert(this->pending_bbframes.end(),
-	                              new_pending.begin(), new_pending.end());
+	frames.pending.clear();
+	frames.pending.insert(frames.pending.end(),
+	                      new_pending.begin(), new_pending.end());
 
 }
 
@@ -902,9 +960,9 @@ void ForwardSchedulingS2::checkBBFrameSize(CarriersGroupDama *vcm,
 	unsigned int vcm_id = 0;
 	vol_sym_t carrier_size_sym = vcm->getTotalCapacity() /
 	                             vcm->getCarriersNumber();
-	std::list<fmt_id_t> fmt_ids = vcm->getFmtIds();
+	const std::vector<fmt_id_t> &fmt_ids = vcm->getFmtIds();
 
-	for(std::list<fmt_id_t>::const_iterator fmt_it = fmt_ids.begin();
+	for(std::vector<fmt_id_t>::const_iterator fmt_it = fmt_ids.begin();
 	    fmt_it != fmt_ids.end(); ++fmt_it)
 	{
 		fmt_id_t fmt_id = *fmt_it;
@@ -968,7 +1026,6 @@ void ForwardSchedulingS2::createProbes(CarriersGroupDama *vcm,
 {
 	auto output = Output::Get();
 
-	unsigned int vcm_id = 0;
 	std::shared_ptr<Probe<int>> remain_probe;
 	std::shared_ptr<Probe<int>> avail_probe;
 
@@ -992,11 +1049,12 @@ void ForwardSchedulingS2::createProbes(CarriersGroupDama *vcm,
 	}
 	else
 	{
-		remain_probe = output->registerProbe<int>(prefix + ".VCM" + std::to_string(vcm_id) + ".Remaining",
+		// the probes are named after the position of the VCM carrier
+		auto vcm_id = std::find(vcm_carriers.begin(), vcm_carriers.end(), vcm) - vcm_carriers.begin();
+		remain_probe = output->registerProbe<int>(prefix + "VCM" + std::to_string(vcm_id) + ".Remaining",
 		                                                 "Kbits/s", true, SAMPLE_AVG);
-		avail_probe = output->registerProbe<int>(prefix + ".VCM" + std::to_string(vcm_id) + ".Available",
+		avail_probe = output->registerProbe<int>(prefix + "VCM" + std::to_string(vcm_id) + ".Available",
 		                                                "Kbits/s", true, SAMPLE_AVG);
-		vcm_id++;
 	}
 	avail_probes.push_back(avail_probe);
 	remain_probes.push_back(remain_probe);
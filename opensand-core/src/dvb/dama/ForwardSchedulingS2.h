@@ -42,15 +42,7 @@
 #include "BBFrame.h"
 #include "TerminalCategoryDama.h"
 
-
-/** Status for the carrier capacity */
-typedef enum
-{
-	status_ok,    // BBFrame added in the complete BBFrames list
-	status_error, // Error when adding the BBFrame in the list
-	status_full,  // The carrier is full, cannot add the BBFrame
-} sched_status_t;
-
+#include <map>
 
 
 /**
@@ -69,7 +61,8 @@ public:
 	                    spot_id_t spot,
 	                    bool is_gw,
 	                    tal_id_t gw,
-	                    std::string dst_name);
+	                    std::string dst_name,
+	                    bool parallel_vcm = false);
 
 	virtual ~ForwardSchedulingS2();
 
@@ -79,18 +72,47 @@ public:
 	                      uint32_t &remaining_allocation);
 
 protected:
+	/**
+	 * @brief The BBFrames being built on carriers, the VCM carriers
+	 *        scheduled in parallel each own theirs
+	 */
+	struct bbframes_t
+	{
+		bbframes_t(std::size_t modcods);
+		~bbframes_t();
+
+		bbframes_t(const bbframes_t &) = delete;
+		bbframes_t &operator=(const bbframes_t &) = delete;
+
+		/** the BBframe being built in their created order */
+		std::list<BBFrame *> incomplete_ordered;
+
+		/** the BBFrame being built for each MODCOD, indexed by MODCOD ID,
+		 *  its position in incomplete_ordered or the list end */
+		std::vector<std::list<BBFrame *>::iterator> incomplete;
+
+		/** the MODCOD of the terminals for the FIFO being scheduled,
+		 *  indexed by terminal ID, 0 if it is not known yet */
+		std::vector<fmt_id_t> fifo_modcods;
+
+		/** the pending BBFrame list if there was not enough space in previous
+		 *  iteration for the corresponding MODCOD */
+		std::list<BBFrame *> pending;
+	};
+
 	/** The timer for forward scheduling (ms) */
 	time_ms_t fwd_timer_ms;
 
-	/** the BBFrame being built identified by their modcod */
-	std::map<unsigned int, BBFrame *> incomplete_bb_frames;
+	/** The BBFrames of the carriers scheduled one after the other */
+	bbframes_t bbframes;
 
-	/** the BBframe being built in their created order */
-	std::list<BBFrame *> incomplete_bb_frames_ordered;
+	/** Whether the VCM carriers of a carriers group are scheduled in
+	 *  parallel by the task workers, their FIFOs being distinct */
+	bool parallel_vcm;
 
-	/** the pending BBFrame list if there was not enough space in previous iteration
-	 *  for the corresponding MODCOD */
-	std::list<BBFrame *> pending_bbframes;
+	/** The BBFrames of the VCM carriers scheduled in parallel, indexed by
+	 *  carriers group ID and VCM ID, a map so that they never move */
+	std::map<std::pair<unsigned int, unsigned int>, bbframes_t> vcm_bbframes;
 
 	/** The FMT Definition Table associed */
 	const FmtDefinitionTable *fwd_modcod_def;
@@ -114,10 +136,36 @@ protected:
 	/// The MODCOD for emmited frames
 	std::shared_ptr<Probe<int>> probe_gw_sent_modcod;
 
+	/**
+	 * @brief Schedule the FIFOs of a carrier then fill it with the
+	 *        incomplete BBFrames
+	 *
+	 * @param frames                 The BBFrames being built on the carrier
+	 * @param carriers               The carriers group
+	 * @param vcm                    The carrier, one of the VCM carriers of the group
+	 * @param vcm_id                 The VCM ID of the carrier
+	 * @param is_vcm                 Whether the group has several VCM carriers
+	 * @param current_superframe_sf  The current superframe number
+	 * @param current_time           The current time
+	 * @param complete_dvb_frames    The list of complete DVB frames
+	 * @param total_capa             OUT: The capacity of the carrier for this cycle
+	 * @return true on success, false otherwise
+	 */
+	bool scheduleCarrier(bbframes_t &frames,
+	                     CarriersGroupDama *carriers,
+	                     CarriersGroupDama *vcm,
+	                     unsigned int vcm_id,
+	                     bool is_vcm,
+	                     const time_sf_t current_superframe_sf,
+	                     clock_t current_time,
+	                     std::list<DvbFrame *> *complete_dvb_frames,
+	                     vol_sym_t &total_capa);
+
 	/**
 	 * @brief Schedule encapsulated packets from a FIFO and for a given Rs
 	 *        The available capacity is obtained from carrier capacity in symbols
 	 *
+	 * @param frames  The BBFrames being built on the carrier
 	 * @param fifo  The FIFO whee packets are stored
 	 * @param current_superframe_sf  The current superframe number
 	 * @param current_time           The current time
@@ -126,7 +174,8 @@ protected:
 	 * @param capacity_sym           The capacity for this cycle, including previous space
 	 * @param init_capa              The capacity for a whole cycle
 	 */
-	bool scheduleEncapPackets(DvbFifo *fifo,
+	bool scheduleEncapPackets(bbframes_t &frames,
+	                          DvbFifo *fifo,
 	                          const time_sf_t current_superframe_sf,
 	                          clock_t current_time,
 	                          std::list<DvbFrame *> *complete_dvb_frames,
@@ -150,13 +199,15 @@ protected:
 	/**
 	 * @brief Get the incomplete BBFrame for the current destination terminal
 	 *
+	 * @param frames    the BBFrames being built on the carrier
 	 * @param tal_id    the terminal ID we want to send the frame
 	 * @paarm carriers  the carriers group to which the terminal belongs
 	 * @param current_superframe_sf  The current superframe number
 	 * @param bbframe   OUT: the BBframe for this packet
 	 * @return          true on success, false otherwise
 	 */
-	bool getIncompleteBBFrame(tal_id_t tal_id,
+	bool getIncompleteBBFrame(bbframes_t &frames,
+	                          tal_id_t tal_id,
 	                          CarriersGroupDama *carriers,
 	                          const time_sf_t current_superframe_sf,
 	                          BBFrame **bbframe);
@@ -180,12 +231,14 @@ protected:
 	/**
 	 * @brief Schedule pending BBFrames from previous slot
 	 *
-	 * @param supported_modcods    The list of supported MODCODS for the current carrier
+	 * @param frames               The BBFrames being built on the carrier
+	 * @param supported_modcods    The FMT group of the current carrier
 	 * @param current_superframe_sf  The current superframe number
 	 * @param complete_dvb_frames  IN/OUT: The list of complete DVB frames
 	 * @param capacity_sym         IN/OUT: The remaining capacity on carriers
 	 */
-	void schedulePending(const std::list<fmt_id_t> supported_modcods,
+	void schedulePending(bbframes_t &frames,
+	                     const FmtGroup *supported_modcods,
 	                     const time_sf_t current_superframe_sf,
 	                     std::list<DvbFrame *> *complete_dvb_frames,
 	                     vol_sym_t &remaining_capacity_sym);
@@ -46,6 +46,9 @@
 
 constexpr const uint32_t max_allocation = 1U << (8 * sizeof(vol_kb_t));
 
+/// The maximum number of bursts built ahead of the frame tick
+constexpr const std::size_t max_prepared_frames = 256;
+
 
 typedef enum
 {
@@ -63,7 +66,10 @@ typedef enum
 ReturnSchedulingRcs2::ReturnSchedulingRcs2(EncapPlugin::EncapPacketHandler *packet_handler,
                                            const fifos_t &fifos):
 	Scheduling(packet_handler, fifos, NULL),
-	max_burst_length_b(0)
+	max_burst_length_b(0),
+	discipline(FifoDiscipline::create("Strict Priority", fifos)),
+	prepared_frames(),
+	prepared_burst_length_b(0)
 {
 }
 
@@ -74,6 +80,23 @@ vol_b_t ReturnSchedulingRcs2::getMaxBurstLength() const
 }
 
 
+bool ReturnSchedulingRcs2::setDiscipline(const std::string &name)
+{
+	auto discipline = FifoDiscipline::create(name, this->dvb_fifos);
+	if(!discipline)
+	{
+		LOG(this->log_scheduling, LEVEL_ERROR,
+		    "unknown fifo scheduling discipline '%s'\n",
+		    name.c_str());
+		return false;
+	}
+	this->discipline = std::move(discipline);
+	LOG(this->log_scheduling, LEVEL_NOTICE,
+	    "fifo scheduling discipline: %s\n", name.c_str());
+	return true;
+}
+
+
 void ReturnSchedulingRcs2::setMaxBurstLength(vol_b_t length_b)
 {
 	this->max_burst_length_b = length_b;
@@ -84,7 +107,7 @@ void ReturnSchedulingRcs2::setMaxBurstLength(vol_b_t length_b)
 
 
 bool ReturnSchedulingRcs2::schedule(const time_sf_t current_superframe_sf,
-                                    clock_t UNUSED(current_time),
+                                    clock_t current_time,
                                     std::list<DvbFrame *> *complete_dvb_frames,
                                     uint32_t &remaining_allocation)
 {
@@ -104,6 +127,7 @@ bool ReturnSchedulingRcs2::schedule(const time_sf_t current_superframe_sf,
 	// extract and send encap packets from MAC FIFOs, in function of
 	// UL allocation
 	if(!this->macSchedule(current_superframe_sf,
+	                      current_time,
 	                      complete_dvb_frames,
 	                      (vol_b_t &)remaining_allocation))
 	{
@@ -116,7 +140,41 @@ bool ReturnSchedulingRcs2::schedule(const time_sf_t current_superframe_sf,
 	return true;
 }
 
+bool ReturnSchedulingRcs2::prepare(vol_b_t burst_length_b,
+                                   vol_b_t allocation_b)
+{
+	std::size_t count;
+
+	if(burst_length_b != this->prepared_burst_length_b)
+	{
+		// the bursts would not be taken back
+		this->prepared_frames.clear();
+		this->prepared_burst_length_b = burst_length_b;
+	}
+	if((burst_length_b >> 3) <= 0)
+	{
+		return true;
+	}
+
+	count = std::min<std::size_t>((allocation_b + burst_length_b - 1) / burst_length_b,
+	                              max_prepared_frames);
+	while(this->prepared_frames.size() < count)
+	{
+		DvbRcsFrame *frame;
+		if(!this->buildDvbRcsFrame(burst_length_b, &frame))
+		{
+			return false;
+		}
+		this->prepared_frames.emplace_back(frame);
+	}
+	LOG(this->log_scheduling, LEVEL_DEBUG,
+	    "%zu DVB-RCS2 frames prepared for an allocation of %u kbits\n",
+	    this->prepared_frames.size(), allocation_b / 1000);
+	return true;
+}
+
 bool ReturnSchedulingRcs2::macSchedule(const time_sf_t current_superframe_sf,
+                                       clock_t current_time,
                                        std::list<DvbFrame *> *complete_dvb_frames,
                                        vol_b_t &remaining_allocation_b)
 {
@@ -125,11 +183,10 @@ bool ReturnSchedulingRcs2::macSchedule(const time_sf_t current_superframe_sf,
 	unsigned int sent_packets;
 	vol_b_t frame_length_b;
 	DvbRcsFrame *incomplete_dvb_frame = NULL;
-	fifos_t::const_iterator fifo_it;
 	std::unique_ptr<NetPacket> encap_packet;
 	std::unique_ptr<NetPacket> data;
 	std::unique_ptr<NetPacket> remaining_data;
-	FifoElement *elem = NULL;
+	FifoElement elem;
 	DvbFifo *fifo = NULL;
 	sched_state_t state;
 
@@ -147,12 +204,11 @@ bool ReturnSchedulingRcs2::macSchedule(const time_sf_t current_superframe_sf,
 	//frame_length_b = incomplete_dvb_frame->getHeaderLength() << 3;
 	frame_length_b = 0;
 
-	// extract encap packets from MAC FIFOs while some UL capacity is available
-	// (MAC fifos priorities are in MAC IDs order)
-	// fifo are classified by priority value (map are ordered)
+	// extract encap packets from MAC FIFOs while some UL capacity is available,
+	// the discipline selects the fifo to serve among the non empty ones
 	complete_frames_count = 0;
 	sent_packets = 0;
-	fifo_it = this->dvb_fifos.begin();
+	this->discipline->refresh();
 	state = state_get_fifo;
 
 	LOG(this->log_scheduling, LEVEL_DEBUG,
@@ -176,35 +232,21 @@ bool ReturnSchedulingRcs2::macSchedule(const time_sf_t current_superframe_sf,
 		{
 		case state_next_fifo:      // Go to the next fifo
 
-			// Pass to the next fifo
-			++fifo_it;
+			// The fifo has no data left, pass to the next one
+			this->discipline->setEmpty();
 			state = state_get_fifo;
 			break;
 
 		case state_get_fifo:        // Get the fifo
 
-			// Check this is not the end of the fifos list
-			if(fifo_it == this->dvb_fifos.end())
+			// Get the fifo in turn, none if they are all empty
+			fifo = this->discipline->getFifo();
+			if(!fifo)
 			{
 				state = state_end;
 				break;
 			}
 
-			// Check the fifo access
-			fifo = (*fifo_it).second;
-			if(fifo->getAccessType() == ForwardOrReturnAccessType{ReturnAccessType::saloha})
-			{
-				// not the good fifo
-				LOG(this->log_scheduling, LEVEL_DEBUG,
-				    "SF#%u: ignore MAC FIFO %s  "
-				    "not the right access type (%d)\n",
-				    current_superframe_sf,
-				    fifo->getName().c_str(),
-				    fifo->getAccessType());
-				state = state_next_fifo;
-				break;
-			}
-
 			state = state_next_encap_pkt;
 			break;
 
@@ -233,17 +275,20 @@ bool ReturnSchedulingRcs2::macSchedule(const time_sf_t current_superframe_sf,
 			    fifo->getCurrentSize(),
 			    remaining_allocation_b / 1000);
 
-			// extract next encap packet context from MAC fifo
-			elem = fifo->pop();
-			encap_packet = elem->getElem<NetPacket>();
+			// extract next encap packet context from MAC fifo,
+			// the active queue management may drop the remaining ones
+			if(!fifo->pop(elem, current_time))
+			{
+				state = state_next_fifo;
+				break;
+			}
+			encap_packet = elem.getElem<NetPacket>();
 			if(!encap_packet)
 			{
 				LOG(this->log_scheduling, LEVEL_ERROR,
 				    "SF#%u: error while getting packet (null) "
 				    "#%u\n", current_superframe_sf,
 				    sent_packets + 1);
-				delete elem;
-				elem = nullptr;
 				break;
 			}
 
@@ -270,8 +315,6 @@ bool ReturnSchedulingRcs2::macSchedule(const time_sf_t current_superframe_sf,
 				    "SF#%u: error while processing packet "
 				    "#%u\n", current_superframe_sf,
 				    sent_packets + 1);
-				delete elem;
-				elem = nullptr;
 				state = state_next_encap_pkt;
 				break;
 			}
@@ -290,14 +333,8 @@ bool ReturnSchedulingRcs2::macSchedule(const time_sf_t current_superframe_sf,
 			if(remaining_data)
 			{
 				// Re-insert packet
-				elem->setElem(std::move(remaining_data));
-				fifo->pushFront(elem);
-			}
-			else
-			{
-				// Delete packet
-				delete elem;
-				elem = NULL;
+				elem.setElem(std::move(remaining_data));
+				fifo->pushFront(std::move(elem));
 			}
 			break;
 			
@@ -322,6 +359,7 @@ bool ReturnSchedulingRcs2::macSchedule(const time_sf_t current_superframe_sf,
 			// Delete the NetPacket once it has been copied in the DVB-RCS2 Frame
 			frame_length_b += data->getTotalLength() << 3;
 			sent_packets++;
+			this->discipline->addSent(data->getTotalLength());
 
 			LOG(this->log_scheduling, LEVEL_DEBUG,
 				"SF#%u: DVB Frame filling (%d packets): used %d kbits (%d bytes), free %d kbits (%d bytes)",
@@ -346,7 +384,7 @@ bool ReturnSchedulingRcs2::macSchedule(const time_sf_t current_superframe_sf,
 				break;
 			}
 
-			state = state_next_encap_pkt;
+			state = state_get_fifo;
 			break;
 
 		case state_finalize_frame: // Finalize frame
@@ -412,7 +450,7 @@ bool ReturnSchedulingRcs2::macSchedule(const time_sf_t current_superframe_sf,
 				(incomplete_dvb_frame->getFreeSpace() << 3) / 1000,
 				incomplete_dvb_frame->getFreeSpace());
 
-			state = state_next_encap_pkt;
+			state = state_get_fifo;
 			break;
 
 		default:
@@ -474,6 +512,21 @@ bool ReturnSchedulingRcs2::macSchedule(const time_sf_t current_superframe_sf,
 }
 
 bool ReturnSchedulingRcs2::allocateDvbRcsFrame(DvbRcsFrame **incomplete_dvb_frame)
+{
+	// take back a frame built ahead of the tick, it is
+	// the same as a new one while the burst length is unchanged
+	if(!this->prepared_frames.empty() &&
+	   this->prepared_burst_length_b == this->max_burst_length_b)
+	{
+		*incomplete_dvb_frame = this->prepared_frames.back().release();
+		this->prepared_frames.pop_back();
+		return true;
+	}
+	return this->buildDvbRcsFrame(this->max_burst_length_b, incomplete_dvb_frame);
+}
+
+bool ReturnSchedulingRcs2::buildDvbRcsFrame(vol_b_t burst_length_b,
+                                            DvbRcsFrame **incomplete_dvb_frame)
 {
 	vol_bytes_t length_bytes;
 
@@ -489,7 +542,7 @@ bool ReturnSchedulingRcs2::allocateDvbRcsFrame(DvbRcsFrame **incomplete_dvb_fram
 	}
 
 	// Get the max burst length
-	length_bytes = this->max_burst_length_b >> 3;
+	length_bytes = burst_length_b >> 3;
 	if(length_bytes <= 0)
 	{
 		delete (*incomplete_dvb_frame);
@@ -40,9 +40,13 @@
 
 #include "Scheduling.h"
 #include "DvbRcsFrame.h"
+#include "FifoDiscipline.h"
 
 #include <opensand_output/OutputLog.h>
 
+#include <memory>
+#include <vector>
+
 /**
  * @class ReturnSchedulingRcs2
  * @brief Scheduling functions for MAC FIFOs with DVB-RCS2 return link
@@ -57,20 +61,51 @@ public:
 
 	vol_b_t getMaxBurstLength() const;
 	void setMaxBurstLength(vol_b_t length_b);
+
+	/**
+	 * @brief Set the discipline sharing the allocation between the fifos
+	 *
+	 * @param name  The discipline name: "Strict Priority", "DRR" or "WFQ"
+	 * @return true on success, false if the discipline is unknown
+	 */
+	bool setDiscipline(const std::string &name);
 	
 	bool schedule(const time_sf_t current_superframe_sf,
 	              clock_t current_time,
 	              std::list<DvbFrame *> *complete_dvb_frames,
 	              uint32_t &remaining_allocation);
 
+	/**
+	 * @brief Build, ahead of the frame tick, the empty bursts the next
+	 *        scheduling is expected to fill
+	 *
+	 * The scheduling takes them back while the maximum burst length is the
+	 * expected one, they are dropped when it changes.
+	 *
+	 * @param burst_length_b  The maximum burst length expected
+	 * @param allocation_b    The allocation expected
+	 * @return true on success, false otherwise
+	 */
+	bool prepare(vol_b_t burst_length_b, vol_b_t allocation_b);
+
 protected:
 	/// The maximum burst length in bits
 	vol_b_t max_burst_length_b;
 
+	/// The discipline selecting the fifo to serve
+	std::unique_ptr<FifoDiscipline> discipline;
+
+	/// The empty bursts built ahead of the frame tick
+	std::vector<std::unique_ptr<DvbRcsFrame>> prepared_frames;
+
+	/// The maximum burst length of the prepared bursts in bits
+	vol_b_t prepared_burst_length_b;
+
 	/**
 	 * @brief schedule the DVB packets that are stored in the MAC Fifo
 	 *
 	 * @param current_superframe_sf        the current superframe (for logging)
+	 * @param current_time                 the current time
 	 * @param complete_dvb_frames          a list of completed DVB frames
 	 * @param remaining_allocation_b       the remaining allocated data length after
 	 *                                     scheduling on the current superframe
@@ -78,6 +113,7 @@ protected:
 	 * @return true on success, false otherwise
 	 */
 	bool macSchedule(const time_sf_t current_superframe_sf,
+	                 clock_t current_time,
 	                 std::list<DvbFrame *> *complete_dvb_frames,
 	                 vol_b_t &remaining_allocation_b);
 
@@ -89,6 +125,17 @@ protected:
 	 * @return true on sucess, false otherwise
 	 */
 	bool allocateDvbRcsFrame(DvbRcsFrame **incomplete_dvb_frame);
+
+	/**
+	 * @brief Build an empty DVB frame
+	 *
+	 * @param burst_length_b        the maximum burst length in bits
+	 * @param incomplete_dvb_frame  the created DVB frame
+	 *
+	 * @return true on sucess, false otherwise
+	 */
+	bool buildDvbRcsFrame(vol_b_t burst_length_b,
+	                      DvbRcsFrame **incomplete_dvb_frame);
 };
 
 #endif
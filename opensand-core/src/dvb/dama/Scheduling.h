@@ -43,6 +43,15 @@
 #include "StFmtSimu.h"
 
 
+/** Status for the carrier capacity */
+typedef enum
+{
+	status_ok,    // BBFrame added in the complete BBFrames list
+	status_error, // Error when adding the BBFrame in the list
+	status_full,  // The carrier is full, cannot add the BBFrame
+} sched_status_t;
+
+
 /**
  * Scheduling is done each frame (not each superframe),
  * so allocation should be done in slot per frame (packet per frame)
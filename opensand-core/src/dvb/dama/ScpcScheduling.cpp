@@ -45,46 +45,7 @@
 #include <opensand_output/Output.h>
 
 #include <cassert>
-
-
-/**
- * @brief Get the payload size in Bytes according to coding rate
- *
- * @param coding_rate  The coding rate
- * @return the payload size in Bytes
- */
-static size_t getPayloadSize(std::string coding_rate)
-{
-	size_t payload;
-
-	// see ESTI EN 302 307 v1.2.1 Table 5a
-	if(!coding_rate.compare("1/4"))
-		payload = 2001;
-	else if(!coding_rate.compare("1/3"))
-		payload = 2676;
-	else if(!coding_rate.compare("2/5"))
-		payload = 3216;
-	else if(!coding_rate.compare("1/2"))
-		payload = 4026;
-	else if(!coding_rate.compare("3/5"))
-		payload = 4836;
-	else if(!coding_rate.compare("2/3"))
-		payload = 5380;
-	else if(!coding_rate.compare("3/4"))
-		payload = 6051;
-	else if(!coding_rate.compare("4/5"))
-		payload = 6456;
-	else if(!coding_rate.compare("5/6"))
-		payload = 6730;
-	else if(!coding_rate.compare("8/9"))
-		payload = 7184;
-	else if(!coding_rate.compare("9/10"))
-		payload = 7274;
-	else
-		payload = 8100; //size of a normal FECFRAME
-
-	return payload;
-}
+#include <limits>
 
 
 // TODO try to factorize with S2Scheduling
@@ -102,10 +63,14 @@ ScpcScheduling::ScpcScheduling(time_ms_t scpc_timer_ms,
 	pending_bbframes(),
 	scpc_modcod_def(scpc_modcod_def),
 	category(category),
-	gw_id(gw_id)
+	gw_id(gw_id),
+	bbframe_sizes(),
+	carriers_modcods()
 {
 	auto output = Output::Get();
 
+	this->computeModcodTables();
+
 	// generate probes prefix
 	bool is_sat = OpenSandModelConf::Get()->getComponentType() == Component::satellite;
 	std::string prefix = generateProbePrefix(gw_id, Component::terminal, is_sat);
@@ -137,17 +102,14 @@ ScpcScheduling::ScpcScheduling(time_ms_t scpc_timer_ms,
 
 		for(auto&& fmt_id : carriers->getFmtIds())
 		{
-			vol_sym_t size;
 			// check that the BBFrame maximum size is smaller than the carrier size
-			if(!this->getBBFrameSizeSym(this->getBBFrameSizeBytes(fmt_id),
-			                            fmt_id,
-			                            0,
-			                            size))
+			if(!this->bbframe_sizes[fmt_id].size_bytes)
 			{
 				LOG(this->log_scheduling, LEVEL_ERROR,
 					"Cannot determine the maximum BBFrame size\n");
 				continue;
 			}
+			vol_sym_t size = this->bbframe_sizes[fmt_id].size_sym;
 
 			if (size > carrier_size_sym) {
 				// send a warning message, this will work but this is not
@@ -196,6 +158,41 @@ ScpcScheduling::~ScpcScheduling()
 }
 
 
+void ScpcScheduling::computeModcodTables()
+{
+	// the MODCOD IDs are the indexes of the tables
+	std::size_t ids_count = std::numeric_limits<fmt_id_t>::max() + 1;
+
+	this->bbframe_sizes.assign(ids_count, bbframe_size_t{0, 0});
+	for(auto&& definition : this->scpc_modcod_def->getDefinitions())
+	{
+		fmt_id_t modcod_id = definition.first;
+		bbframe_size_t &size = this->bbframe_sizes[modcod_id];
+		size.size_bytes = definition.second->getPayloadSize();
+		// duration is calculated over the complete BBFrame size, the BBFrame data
+		// size represents the payload without coding
+		size.size_sym = (size.size_bytes * 8) /
+		                this->scpc_modcod_def->getSpectralEfficiency(modcod_id);
+	}
+
+	this->carriers_modcods.clear();
+	for(auto&& carriers : this->category->getCarriersGroups())
+	{
+		carriers_modcods_t &modcods = this->carriers_modcods[carriers->getCarriersId()];
+		modcods.supported.assign(ids_count, false);
+		modcods.nearest.assign(ids_count, 0);
+		for(auto&& fmt_id : carriers->getFmtIds())
+		{
+			modcods.supported[fmt_id] = true;
+		}
+		for(auto&& definition : this->scpc_modcod_def->getDefinitions())
+		{
+			modcods.nearest[definition.first] = carriers->getNearestFmtId(definition.first);
+		}
+	}
+}
+
+
 bool ScpcScheduling::schedule(const time_sf_t current_superframe_sf,
                               clock_t current_time,
                               std::list<DvbFrame *> *complete_dvb_frames,
@@ -205,6 +202,18 @@ bool ScpcScheduling::schedule(const time_sf_t current_superframe_sf,
 	vol_sym_t init_capacity_sym;
 	int total_capa = 0;
 
+	// without any data to send, the carriers are only accounted
+	bool pending_data = !this->pending_bbframes.empty() ||
+	                    !this->incomplete_bb_frames_ordered.empty();
+	for(auto&& fifo_it : this->dvb_fifos)
+	{
+		if(pending_data)
+		{
+			break;
+		}
+		pending_data = fifo_it.second->getCurrentSize() > 0;
+	}
+
 	for(auto&& carriers : carriers_group)
 	{
 		unsigned int capacity_sym = 0;
@@ -216,6 +225,13 @@ bool ScpcScheduling::schedule(const time_sf_t current_superframe_sf,
 		carriers->setRemainingCapacity(init_capacity_sym);
 		total_capa += init_capacity_sym;
 
+		if(!pending_data)
+		{
+			// the capacity left from the previous frame is lost
+			carriers->setPreviousCapacity(0, 0);
+			continue;
+		}
+
 		for(auto&& fifo_it : this->dvb_fifos)
 		{
 			// check if the FIFO can emit on this carriers group
@@ -322,10 +338,12 @@ bool ScpcScheduling::scheduleEncapPackets(DvbFifo *fifo,
 {
 	int ret;
 	unsigned int sent_packets = 0;
-	FifoElement *elem;
+	FifoElement elem;
 	long max_to_send;
 	BBFrame *current_bbframe;
-	std::list<fmt_id_t> supported_modcods = carriers->getFmtIds();
+	fmt_id_t modcod_id;
+	const std::vector<bool> &supported_modcods =
+		this->carriers_modcods[carriers->getCarriersId()].supported;
 	vol_sym_t capacity_sym = carriers->getRemainingCapacity();
 	vol_sym_t previous_sym = carriers->getPreviousCapacity(current_superframe_sf);
 	vol_sym_t init_capa = capacity_sym;
@@ -385,6 +403,9 @@ bool ScpcScheduling::scheduleEncapPackets(DvbFifo *fifo,
 	    "for %s fifo\n", current_superframe_sf,
 	    max_to_send, fifo->getName().c_str());
 
+	// the MODCOD does not change during the scheduling
+	modcod_id = this->getCarriersModcod(carriers, current_superframe_sf);
+
 	// now build BB frames with packets extracted from the MAC FIFO
 	while(fifo->getCurrentSize() > 0)
 	{
@@ -403,9 +424,13 @@ bool ScpcScheduling::scheduleEncapPackets(DvbFifo *fifo,
 			    break;
 		}
 
-		elem = fifo->pop();
+		// the active queue management may drop the remaining packets
+		if(!fifo->pop(elem, current_time))
+		{
+			break;
+		}
 
-		encap_packet = elem->getElem<NetPacket>();
+		encap_packet = elem.getElem<NetPacket>();
 		// retrieve the encapsulation packet
 		if(!encap_packet)
 		{
@@ -413,22 +438,19 @@ bool ScpcScheduling::scheduleEncapPackets(DvbFifo *fifo,
 			    "SF#%u: invalid packet #%u in MAC FIFO "
 			    "element\n", current_superframe_sf,
 			    sent_packets + 1);
-			delete elem;
 			return false;
 		}
 
 
-		if(!this->getIncompleteBBFrame(carriers, current_superframe_sf,
+		if(!this->getIncompleteBBFrame(modcod_id, current_superframe_sf,
 		                               &current_bbframe))
 		{
 			// cannot initialize incomplete BB Frame
-			delete elem;
 			return false;
 		}
 		else if(!current_bbframe)
 		{
 			// cannot get modcod for the ST delete the element
-			delete elem;
 			continue;
 		}
 
@@ -451,7 +473,6 @@ bool ScpcScheduling::scheduleEncapPackets(DvbFifo *fifo,
 			    "SF#%u: error while processing packet "
 			    "#%u\n", current_superframe_sf,
 			    sent_packets + 1);
-			delete elem;
 		}
 
 		bool partial_encap = remaining_data != nullptr;
@@ -463,7 +484,6 @@ bool ScpcScheduling::scheduleEncapPackets(DvbFifo *fifo,
 			    current_superframe_sf,
 			    sent_packets + 1);
 			assert(0);
-			delete elem;
 		}
 		if(data)
 		{
@@ -479,7 +499,6 @@ bool ScpcScheduling::scheduleEncapPackets(DvbFifo *fifo,
 				    current_bbframe->getModcodId(),
 				    data->getTotalLength(),
 				    current_bbframe->getFreeSpace());
-				delete elem;
 				return false;
 			}
 
@@ -506,13 +525,8 @@ bool ScpcScheduling::scheduleEncapPackets(DvbFifo *fifo,
 		if(partial_encap)
 		{
 			// Re-insert packet
-			elem->setElem(std::move(remaining_data));
-			fifo->pushFront(elem);
-		}
-		else
-		{
-			// Delete packet	
-			delete elem;
+			elem.setElem(std::move(remaining_data));
+			fifo->pushFront(std::move(elem));
 		}
 
 		// the BBFrame has been completed or the next packet is too long
@@ -614,66 +628,34 @@ error:
 	return false;
 }
 
-bool ScpcScheduling::getBBFrameSizeSym(size_t bbframe_size_bytes,
-                                       fmt_id_t modcod_id,
-                                       const time_sf_t current_superframe_sf,
-                                       vol_sym_t &bbframe_size_sym)
-{
-	float spectral_efficiency;
-
-	if(!this->scpc_modcod_def->doFmtIdExist(modcod_id))
-	{
-		LOG(this->log_scheduling, LEVEL_ERROR,
-		    "SF#%u: failed to found the definition of MODCOD ID %u\n",
-		    current_superframe_sf, modcod_id);
-		goto error;
-	}
-	spectral_efficiency = this->scpc_modcod_def->getSpectralEfficiency(modcod_id);
-
-	// duration is calculated over the complete BBFrame size, the BBFrame data
-	// size represents the payload without coding
-	bbframe_size_sym = (bbframe_size_bytes * 8) / spectral_efficiency;
-
-	LOG(this->log_scheduling, LEVEL_DEBUG,
-	    "size of the BBFRAME = %u symbols\n", bbframe_size_sym);
-
-	return true;
-
-error:
-	return false;
-}
-
 unsigned int ScpcScheduling::getBBFrameSizeBytes(fmt_id_t modcod_id)
 {
 	// get the payload size
-	FmtDefinition *fmt_def = this->scpc_modcod_def->getDefinition(modcod_id);
-	if(fmt_def == NULL)
+	if(!this->bbframe_sizes[modcod_id].size_bytes)
 	{
 		// TODO: remove default value. Calling methods should check that return
 		// value is OK.
-		size_t bbframe_size = getPayloadSize("");
+		size_t bbframe_size = CodingTypes::getDefaultPayloadSize();
 		LOG(this->log_scheduling, LEVEL_ERROR,
 		    "could not find fmt definition with id %u, use bbframe size %u bytes",
 				modcod_id, bbframe_size);
 		return bbframe_size;
 	}
-	return getPayloadSize(fmt_def->getCoding());
+	return this->bbframe_sizes[modcod_id].size_bytes;
 }
 
 
 
 
-bool ScpcScheduling::getIncompleteBBFrame(CarriersGroupDama *carriers,
-                                          const time_sf_t current_superframe_sf,
-                                          BBFrame **bbframe)
+fmt_id_t ScpcScheduling::getCarriersModcod(CarriersGroupDama *carriers,
+                                           const time_sf_t current_superframe_sf)
 {
-	*bbframe = nullptr;
 	auto desired_modcod = this->getCurrentModcodId(this->gw_id);
 	LOG(this->log_scheduling, LEVEL_DEBUG,
 	    "Simulated MODCOD for GW = %u\n", desired_modcod);
 
 	// get best modcod ID according to carrier
-	auto modcod_id = carriers->getNearestFmtId(desired_modcod);
+	fmt_id_t modcod_id = this->carriers_modcods[carriers->getCarriersId()].nearest[desired_modcod];
 	if(modcod_id == 0)
 	{
 		LOG(this->log_scheduling, LEVEL_WARNING,
@@ -688,6 +670,16 @@ bool ScpcScheduling::getIncompleteBBFrame(CarriersGroupDama *carriers,
 	    "SF#%u: Available MODCOD for GW = %u\n",
 	    current_superframe_sf, modcod_id);
 
+	return modcod_id;
+}
+
+
+bool ScpcScheduling::getIncompleteBBFrame(fmt_id_t modcod_id,
+                                          const time_sf_t current_superframe_sf,
+                                          BBFrame **bbframe)
+{
+	*bbframe = nullptr;
+
 	// find if the BBFrame exists
 	auto bbframes = this->incomplete_bb_frames.find(modcod_id);
 	if(bbframes != this->incomplete_bb_frames.end() && bbframes->second != nullptr)
@@ -723,18 +715,18 @@ sched_status_t ScpcScheduling::addCompleteBBFrame(std::list<DvbFrame *> *complet
                                                   vol_sym_t &remaining_capacity_sym)
 {
 	fmt_id_t modcod_id = bbframe->getModcodId();
-	size_t bbframe_size_bytes = bbframe->getMaxSize();
 	vol_sym_t bbframe_size_sym;
 
 	// how much time do we need to send the BB frame ?
-	if(!this->getBBFrameSizeSym(bbframe_size_bytes, modcod_id,
-	                            current_superframe_sf, bbframe_size_sym))
+	// (the BBFrames size is the payload size of their MODCOD)
+	if(!this->bbframe_sizes[modcod_id].size_bytes)
 	{
 		LOG(this->log_scheduling, LEVEL_ERROR,
 		    "SF#%u: failed to get BB frame size (MODCOD ID = %u)\n",
 		    current_superframe_sf, modcod_id);
 		return status_error;
 	}
+	bbframe_size_sym = this->bbframe_sizes[modcod_id].size_sym;
 
 	// not enough space for this BBFrame
 	if(remaining_capacity_sym < bbframe_size_sym)
@@ -760,7 +752,7 @@ sched_status_t ScpcScheduling::addCompleteBBFrame(std::list<DvbFrame *> *complet
 }
 
 
-void ScpcScheduling::schedulePending(const std::list<fmt_id_t> supported_modcods,
+void ScpcScheduling::schedulePending(const std::vector<bool> &supported_modcods,
                                      const time_sf_t current_superframe_sf,
                                      std::list<DvbFrame *> *complete_dvb_frames,
                                      vol_sym_t &remaining_capacity_sym)
@@ -775,8 +767,7 @@ void ScpcScheduling::schedulePending(const std::list<fmt_id_t> supported_modcods
 	{
 		fmt_id_t modcod = pending_bbframe->getModcodId();
 
-		if(std::find(supported_modcods.begin(), supported_modcods.end(), modcod) !=
-		   supported_modcods.end())
+		if(supported_modcods[modcod])
 		{
 			if(this->addCompleteBBFrame(complete_dvb_frames,
 			                            pending_bbframe,
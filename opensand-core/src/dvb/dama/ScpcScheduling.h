@@ -36,23 +36,15 @@
  *
  */
 
-#ifndef _FORWARD_SCHEDULING_S2_H_
-#define _FORWARD_SCHEDULING_S2_H_
+#ifndef _SCPC_SCHEDULING_H_
+#define _SCPC_SCHEDULING_H_
 
 #include "Scheduling.h"
 
 #include "BBFrame.h"
 #include "TerminalCategoryDama.h"
 
-
-/** Status for the carrier capacity */
-typedef enum
-{
-	status_ok,    // BBFrame added in the complete BBFrames list
-	status_error, // Error when adding the BBFrame in the list
-	status_full,  // The carrier is full, cannot add the BBFrame
-} sched_status_t;
-
+#include <vector>
 
 
 /**
@@ -78,6 +70,21 @@ public:
 	              uint32_t &remaining_allocation);
 
 private:
+	/** The BBFrame size for a MODCOD */
+	struct bbframe_size_t
+	{
+		size_t size_bytes;    ///< the payload size, 0 if the MODCOD is not defined
+		vol_sym_t size_sym;   ///< the size on the carrier
+	};
+
+	/** The MODCODs usable on a carriers group */
+	struct carriers_modcods_t
+	{
+		std::vector<bool> supported;  ///< whether each MODCOD ID is supported
+		std::vector<fmt_id_t> nearest; ///< the supported MODCOD for each desired
+		                               ///< MODCOD ID, 0 if there is none
+	};
+
 	/** The timer for forward scheduling (ms) */
 	time_ms_t scpc_timer_ms;
 
@@ -100,6 +107,12 @@ private:
 	/** The gw id */
 	tal_id_t gw_id;
 
+	/** The BBFrame sizes indexed by MODCOD ID */
+	std::vector<bbframe_size_t> bbframe_sizes;
+
+	/** The MODCODs of the carriers groups, indexed by carriers ID */
+	std::map<unsigned int, carriers_modcods_t> carriers_modcods;
+
 	// Total and unused capacity probes
 	std::shared_ptr<Probe<int>> probe_scpc_total_capacity;
 	std::shared_ptr<Probe<int>> probe_scpc_total_remaining_capacity;
@@ -108,6 +121,12 @@ private:
 	std::map<unsigned int, std::vector<std::shared_ptr<Probe<int> > > > probe_scpc_remaining_capacity;
 	std::map<unsigned int, std::vector<std::shared_ptr<Probe<int> > > > probe_scpc_available_capacity;
 
+	/**
+	 * @brief Compute the BBFrame sizes and the MODCODs of the carriers groups,
+	 *        to be called again when the carriers groups change
+	 */
+	void computeModcodTables();
+
 	/**
 	 * @brief Schedule encapsulated packets from a FIFO and for a given Rs
 	 *        The available SCPC capacity is obtained from carrier capacity in symbols
@@ -139,15 +158,25 @@ private:
 	/**
 	 * @brief Get the incomplete BBFrame for the current destination terminal
 	 *
-	 * @param carriers  the carriers group to which the terminal belongs
+	 * @param modcod_id the MODCOD of the BBFrame
 	 * @param current_superframe_sf  The current superframe number
 	 * @param bbframe   OUT: the BBframe for this packet
 	 * @return          true on success, false otherwise
 	 */
-	bool getIncompleteBBFrame(CarriersGroupDama *carriers,
+	bool getIncompleteBBFrame(fmt_id_t modcod_id,
 	                          const time_sf_t current_superframe_sf,
 	                          BBFrame **bbframe);
 
+	/**
+	 * @brief Get the MODCOD serving the gateway on a carriers group
+	 *
+	 * @param carriers  the carriers group
+	 * @param current_superframe_sf  The current superframe number
+	 * @return the MODCOD ID
+	 */
+	fmt_id_t getCarriersModcod(CarriersGroupDama *carriers,
+	                           const time_sf_t current_superframe_sf);
+
 	/**
 	 * @brief Add a BBframe to the list of complete BB frames
 	 *
@@ -167,30 +196,16 @@ private:
 	/**
 	 * @brief Schedule pending BBFrames from previous slot
 	 *
-	 * @param supported_modcods    The list of supported MODCODS for the current carrier
+	 * @param supported_modcods    Whether each MODCOD is supported on the current carrier
 	 * @param current_superframe_sf  The current superframe number
 	 * @param complete_dvb_frames  IN/OUT: The list of complete DVB frames
 	 * @param capacity_sym         IN/OUT: The remaining capacity on carriers
 	 */
-	void schedulePending(const std::list<fmt_id_t> supported_modcods,
+	void schedulePending(const std::vector<bool> &supported_modcods,
 	                     const time_sf_t current_superframe_sf,
 	                     std::list<DvbFrame *> *complete_dvb_frames,
 	                     vol_sym_t &remaining_capacity_sym);
 
-	/**
-	 * @brief  Get BBFrame size in symbols according to its MODCOD and size in bytes
-	 *
-	 * @param bbframe_size_bytes  The BBFrame size in bytes
-	 * @param modcod_id           The BBFrame MODCOD ID
-	 * @param current_superframe_sf  The current superframe number
-	 * @param bbframe_size_sym    OUT: The BBFrame size in symbols
-	 * @return true on success, false otherwise
-	 */
-	bool getBBFrameSizeSym(size_t bbframe_size_bytes,
-	                       fmt_id_t modcod_id,
-	                       const time_sf_t current_superframe_sf,
-	                       vol_sym_t &bbframe_size_sym);
-
 	/**
 	 * @brief  Get BBFrame size in bytes according to its MODCOD
 	 *
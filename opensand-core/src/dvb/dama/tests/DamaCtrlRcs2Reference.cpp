@@ -0,0 +1,380 @@
+/*
+ *
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file DamaCtrlRcs2Reference.cpp
+ * @brief The original legacy DAMA controller, kept as the reference
+ *        of the allocations of the DVB-RCS2 Legacy DAMA controller
+ * @author Viveris Technologies
+ */
+
+
+#include "DamaCtrlRcs2Reference.h"
+
+#include "TerminalContextDamaRcs.h"
+
+#include <algorithm>
+#include <math.h>
+
+
+DamaCtrlRcs2Reference::DamaCtrlRcs2Reference(spot_id_t spot):
+	DamaCtrlRcs2(spot)
+{
+}
+
+DamaCtrlRcs2Reference::~DamaCtrlRcs2Reference()
+{
+}
+
+bool DamaCtrlRcs2Reference::init(vol_sym_t length_sym)
+{
+	if(!DamaCtrlRcs2::init(length_sym))
+	{
+		return false;
+	}
+
+	// the capacity probes are still put by the base controller
+	for(auto &&category_it: this->categories)
+	{
+		std::string label = category_it.second->getLabel();
+		for(auto &&carriers: category_it.second->getCarriersGroups())
+		{
+			unsigned int carrier_id = carriers->getCarriersId();
+			this->probes_carrier_return_capacity[label].emplace(carrier_id,
+				this->generateCarrierCapacityProbe(label, carrier_id, "Available"));
+			this->probes_carrier_return_remaining_capacity[label].emplace(carrier_id,
+				this->generateCarrierCapacityProbe(label, carrier_id, "Remaining"));
+			this->carrier_return_remaining_capacity[label].emplace(carrier_id, 0);
+		}
+		this->probes_category_return_capacity.emplace(label,
+			this->generateCategoryCapacityProbe(label, "Available"));
+		this->probes_category_return_remaining_capacity.emplace(label,
+			this->generateCategoryCapacityProbe(label, "Remaining"));
+		this->category_return_remaining_capacity.emplace(label, 0);
+	}
+	return true;
+}
+
+std::vector<TerminalContextDamaRcs *> DamaCtrlRcs2Reference::scanTerminals(
+	const TerminalCategoryDama *category,
+	unsigned int carrier_id) const
+{
+	std::vector<TerminalContextDamaRcs *> tal;
+	for(auto &&context: category->getTerminals())
+	{
+		TerminalContextDamaRcs *terminal = dynamic_cast<TerminalContextDamaRcs *>(context);
+		if(terminal != NULL && terminal->getCarrierId() == carrier_id)
+		{
+			tal.push_back(terminal);
+		}
+	}
+	return tal;
+}
+
+bool DamaCtrlRcs2Reference::computeTerminalsCraAllocation()
+{
+	for(auto &&category_it: this->categories)
+	{
+		for(auto &&carriers: category_it.second->getCarriersGroups())
+		{
+			this->computeDamaCraPerCarrier(carriers, category_it.second);
+		}
+	}
+	return true;
+}
+
+bool DamaCtrlRcs2Reference::computeTerminalsRbdcAllocation()
+{
+	for(auto &&category_it: this->categories)
+	{
+		for(auto &&carriers: category_it.second->getCarriersGroups())
+		{
+			this->computeDamaRbdcPerCarrier(carriers, category_it.second);
+		}
+	}
+	return true;
+}
+
+bool DamaCtrlRcs2Reference::computeTerminalsVbdcAllocation()
+{
+	for(auto &&category_it: this->categories)
+	{
+		for(auto &&carriers: category_it.second->getCarriersGroups())
+		{
+			this->computeDamaVbdcPerCarrier(carriers, category_it.second);
+		}
+	}
+	return true;
+}
+
+bool DamaCtrlRcs2Reference::computeTerminalsFcaAllocation()
+{
+	if(this->fca_kbps == 0)
+	{
+		return true;
+	}
+	for(auto &&category_it: this->categories)
+	{
+		for(auto &&carriers: category_it.second->getCarriersGroups())
+		{
+			this->computeDamaFcaPerCarrier(carriers, category_it.second);
+		}
+	}
+	return true;
+}
+
+void DamaCtrlRcs2Reference::computeDamaCraPerCarrier(CarriersGroupDama *carriers,
+                                                     const TerminalCategoryDama *category)
+{
+	rate_pktpf_t remaining_capacity_pktpf = carriers->getRemainingCapacity();
+
+	for(auto &&terminal: this->scanTerminals(category, carriers->getCarriersId()))
+	{
+		FmtDefinition *fmt_def = terminal->getFmt();
+		if(fmt_def == NULL)
+		{
+			continue;
+		}
+		this->converter->setModulationEfficiency(fmt_def->getModulationEfficiency());
+
+		rate_kbps_t cra_kbps = fmt_def->addFec(terminal->getRequiredCra());
+		rate_pktpf_t cra_pktpf = this->converter->kbpsToPktpf(cra_kbps);
+
+		// the real requested rate, multiple of the timeslot rate
+		cra_kbps = fmt_def->removeFec(this->converter->pktpfToKbps(cra_pktpf));
+		if(remaining_capacity_pktpf < cra_pktpf)
+		{
+			continue;
+		}
+		remaining_capacity_pktpf -= cra_pktpf;
+		terminal->setCraAllocation(cra_kbps);
+	}
+
+	carriers->setRemainingCapacity(remaining_capacity_pktpf);
+}
+
+void DamaCtrlRcs2Reference::computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
+                                                      const TerminalCategoryDama *category)
+{
+	rate_pktpf_t total_request_pktpf = 0;
+	rate_pktpf_t remaining_capacity_pktpf = carriers->getRemainingCapacity();
+	std::map<tal_id_t, rate_pktpf_t> tal_request_pktpf;
+	double fair_share;
+
+	if(remaining_capacity_pktpf == 0)
+	{
+		return;
+	}
+
+	std::vector<TerminalContextDamaRcs *> tal = this->scanTerminals(category,
+	                                                                carriers->getCarriersId());
+
+	// get total RBDC requests
+	for(auto &&terminal: tal)
+	{
+		FmtDefinition *fmt_def = terminal->getFmt();
+		if(fmt_def == NULL)
+		{
+			continue;
+		}
+		this->converter->setModulationEfficiency(fmt_def->getModulationEfficiency());
+
+		rate_kbps_t request_kbps = fmt_def->addFec(terminal->getRequiredRbdc());
+		rate_pktpf_t request_pktpf = this->converter->kbpsToPktpf(request_kbps);
+		tal_request_pktpf[terminal->getTerminalId()] = request_pktpf;
+		total_request_pktpf += request_pktpf;
+	}
+
+	if(total_request_pktpf == 0)
+	{
+		return;
+	}
+
+	// if there is no congestion, force the ratio to 1.0
+	// in order to avoid requests limitation
+	fair_share = (double) total_request_pktpf / remaining_capacity_pktpf;
+	if(fair_share < 1.0)
+	{
+		fair_share = 1.0;
+	}
+
+	// first step : serve the integer part of the fair RBDC
+	for(auto &&terminal: tal)
+	{
+		FmtDefinition *fmt_def = terminal->getFmt();
+		if(fmt_def == NULL)
+		{
+			continue;
+		}
+		this->converter->setModulationEfficiency(fmt_def->getModulationEfficiency());
+
+		// apply the fair share coef to all requests
+		rate_pktpf_t request_pktpf = tal_request_pktpf[terminal->getTerminalId()];
+		double fair_rbdc_pktpf = (double) (request_pktpf / fair_share);
+
+		// take the integer part of fair RBDC
+		rate_pktpf_t rbdc_alloc_pktpf = floor(fair_rbdc_pktpf);
+		rate_kbps_t rbdc_alloc_kbps = this->converter->pktpfToKbps(rbdc_alloc_pktpf);
+		terminal->setRbdcAllocation(fmt_def->removeFec(rbdc_alloc_kbps));
+
+		// decrease the total capacity
+		remaining_capacity_pktpf -= rbdc_alloc_pktpf;
+
+		if(fair_share > 1.0)
+		{
+			// add the decimal part of the fair RBDC
+			double rbdc_credit_kbps = (fair_rbdc_pktpf - rbdc_alloc_pktpf)
+				* this->converter->getPacketBitLength()
+				/ (double)(this->converter->getFrameDuration());
+			rbdc_credit_kbps /= (fmt_def->getCodingRate());
+			terminal->addRbdcCredit(rbdc_credit_kbps);
+		}
+	}
+
+	// second step : RBDC decimal part treatment
+	if(fair_share > 1.0)
+	{
+		// sort terminal according to their remaining credit
+		std::stable_sort(tal.begin(), tal.end(),
+		                 TerminalContextDamaRcs::sortByRemainingCredit);
+		for(auto tal_it = tal.begin(); tal_it != tal.end() && remaining_capacity_pktpf > 0; ++tal_it)
+		{
+			TerminalContextDamaRcs *terminal = *tal_it;
+			FmtDefinition *fmt_def = terminal->getFmt();
+			if(fmt_def == NULL)
+			{
+				continue;
+			}
+			this->converter->setModulationEfficiency(fmt_def->getModulationEfficiency());
+
+			rate_kbps_t slot_kbps = fmt_def->removeFec(this->converter->pktpfToKbps(1));
+			if(terminal->getRbdcCredit() > slot_kbps)
+			{
+				rate_kbps_t max_rbdc_kbps = terminal->getMaxRbdc();
+				rate_kbps_t cra_kbps = terminal->getCraAllocation();
+				rate_kbps_t rbdc_alloc_kbps = terminal->getRbdcAllocation();
+
+				if(max_rbdc_kbps - rbdc_alloc_kbps - cra_kbps > slot_kbps)
+				{
+					// enough capacity to allocate
+					terminal->setRbdcAllocation(rbdc_alloc_kbps + slot_kbps);
+					terminal->addRbdcCredit(-slot_kbps);
+					remaining_capacity_pktpf--;
+				}
+			}
+		}
+	}
+
+	carriers->setRemainingCapacity(remaining_capacity_pktpf);
+}
+
+void DamaCtrlRcs2Reference::computeDamaVbdcPerCarrier(CarriersGroupDama *carriers,
+                                                      const TerminalCategoryDama *category)
+{
+	rate_pktpf_t remaining_capacity_pktpf = carriers->getRemainingCapacity();
+
+	if(remaining_capacity_pktpf == 0)
+	{
+		return;
+	}
+
+	// sort terminal according to their VBDC requests
+	std::vector<TerminalContextDamaRcs *> tal = this->scanTerminals(category,
+	                                                                carriers->getCarriersId());
+	std::stable_sort(tal.begin(), tal.end(),
+	                 TerminalContextDamaRcs::sortByVbdcReq);
+	for(auto tal_it = tal.begin(); tal_it != tal.end() && 0 < remaining_capacity_pktpf; ++tal_it)
+	{
+		TerminalContextDamaRcs *terminal = *tal_it;
+		FmtDefinition *fmt_def = terminal->getFmt();
+		if(fmt_def == NULL)
+		{
+			continue;
+		}
+		this->converter->setModulationEfficiency(fmt_def->getModulationEfficiency());
+
+		vol_kb_t request_kb = fmt_def->addFec(terminal->getRequiredVbdc());
+		vol_pkt_t request_pkt = this->converter->kbitsToPkt(request_kb);
+		if(request_pkt <= 0)
+		{
+			continue;
+		}
+
+		vol_pkt_t alloc_pkt = std::min<vol_pkt_t>(request_pkt, remaining_capacity_pktpf);
+		remaining_capacity_pktpf -= alloc_pkt;
+
+		vol_kb_t alloc_kb = this->converter->pktToKbits(alloc_pkt);
+		terminal->setVbdcAllocation(fmt_def->removeFec(alloc_kb));
+	}
+
+	carriers->setRemainingCapacity(remaining_capacity_pktpf);
+}
+
+void DamaCtrlRcs2Reference::computeDamaFcaPerCarrier(CarriersGroupDama *carriers,
+                                                     const TerminalCategoryDama *category)
+{
+	rate_pktpf_t remaining_capacity_pktpf = carriers->getRemainingCapacity();
+
+	if(remaining_capacity_pktpf <= 0)
+	{
+		return;
+	}
+
+	// sort terminal according to their remaining credit
+	// this is a random but logical choice
+	std::vector<TerminalContextDamaRcs *> tal = this->scanTerminals(category,
+	                                                                carriers->getCarriersId());
+	std::stable_sort(tal.begin(), tal.end(),
+	                 TerminalContextDamaRcs::sortByRemainingCredit);
+	for(auto tal_it = tal.begin(); tal_it != tal.end() && 0 < remaining_capacity_pktpf; ++tal_it)
+	{
+		TerminalContextDamaRcs *terminal = *tal_it;
+		FmtDefinition *fmt_def = terminal->getFmt();
+		if(fmt_def == NULL)
+		{
+			continue;
+		}
+
+		rate_pktpf_t fca_pktpf = this->converter->kbpsToPktpf(fmt_def->addFec(this->fca_kbps));
+		rate_pktpf_t fca_alloc_pktpf;
+		if(remaining_capacity_pktpf > fca_pktpf)
+		{
+			fca_alloc_pktpf = fca_pktpf;
+			remaining_capacity_pktpf -= fca_pktpf;
+		}
+		else
+		{
+			fca_alloc_pktpf = remaining_capacity_pktpf;
+			remaining_capacity_pktpf = 0;
+		}
+		terminal->setFcaAllocation(fmt_def->removeFec(this->converter->pktpfToKbps(fca_alloc_pktpf)));
+	}
+
+	carriers->setRemainingCapacity(remaining_capacity_pktpf);
+}
@@ -0,0 +1,128 @@
+/*
+ *
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file DamaCtrlRcs2Reference.h
+ * @brief The original legacy DAMA controller, kept as the reference
+ *        of the allocations of the DVB-RCS2 Legacy DAMA controller
+ * @author Viveris Technologies
+ */
+
+#ifndef _DAMA_CONTROLLER_RCS2_REFERENCE_H
+#define _DAMA_CONTROLLER_RCS2_REFERENCE_H
+
+#include "DamaCtrlRcs2.h"
+
+#include "OpenSandCore.h"
+#include "CarriersGroup.h"
+#include "TerminalCategoryDama.h"
+
+#include <vector>
+
+/**
+ *  @class DamaCtrlRcs2Reference
+ *  @brief The legacy DAMA controller as it was before its allocations
+ *         were indexed per carriers group, sharded and computed ahead:
+ *         each step scans all the terminals of the categories and sorts
+ *         them again. Only the allocations are computed, the terminals
+ *         and capacity probes are left out.
+ */
+class DamaCtrlRcs2Reference: public DamaCtrlRcs2
+{
+public:
+	DamaCtrlRcs2Reference(spot_id_t spot);
+	virtual ~DamaCtrlRcs2Reference();
+
+	/// initialize
+	using DamaCtrlRcs2::init;
+	virtual bool init(vol_sym_t length_sym);
+
+protected:
+	/// CRA allocation
+	virtual bool computeTerminalsCraAllocation();
+
+	/// RBDC allocation
+	virtual bool computeTerminalsRbdcAllocation();
+
+	/// VBDC allocation
+	virtual bool computeTerminalsVbdcAllocation();
+
+	/// FCA allocation
+	virtual bool computeTerminalsFcaAllocation();
+
+private:
+	/**
+	 * @brief Get the terminals of a carriers group by scanning all
+	 *        the terminals of its category
+	 *
+	 * @param category    The terminal category containing the carrier
+	 * @param carrier_id  The carriers group ID
+	 * @return the terminals of the carriers group, in the category order
+	 */
+	std::vector<TerminalContextDamaRcs *> scanTerminals(const TerminalCategoryDama *category,
+	                                                    unsigned int carrier_id) const;
+
+	/**
+	 * @brief Compute CRA per carriers group
+	 *
+	 * @param carriers  The carrier group
+	 * @param category  The terminal category containing the carrier
+	 */
+	void computeDamaCraPerCarrier(CarriersGroupDama *carriers,
+	                              const TerminalCategoryDama *category);
+
+	/**
+	 * @brief Compute RBDC per carriers group
+	 *
+	 * @param carriers  The carrier group
+	 * @param category  The terminal category containing the carrier
+	 */
+	void computeDamaRbdcPerCarrier(CarriersGroupDama *carriers,
+	                               const TerminalCategoryDama *category);
+
+	/**
+	 * @brief Compute VBDC per carriers group
+	 *
+	 * @param carriers  The carrier group
+	 * @param category  The terminal category containing the carrier
+	 */
+	void computeDamaVbdcPerCarrier(CarriersGroupDama *carriers,
+	                               const TerminalCategoryDama *category);
+
+	/**
+	 * @brief Compute FCA per carriers group
+	 *
+	 * @param carriers  The carrier group
+	 * @param category  The terminal category containing the carrier
+	 */
+	void computeDamaFcaPerCarrier(CarriersGroupDama *carriers,
+	                              const TerminalCategoryDama *category);
+};
+
+#endif
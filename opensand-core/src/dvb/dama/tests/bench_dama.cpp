@@ -0,0 +1,629 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * Benchmark of the DAMA controller
+ *
+ * The application logs synthetic terminal populations on a DVB-RCS2
+ * Legacy DAMA controller, spread between several categories of one
+ * carrier each, and feeds it every superframe with randomised SAC
+ * requests: the terminals are split between CRA only, RBDC and VBDC
+ * ones and a part of them change their MODCOD.
+ *
+ * For each population, it reports the mean time spent per superframe
+ * handling the SACs, updating the required FMTs, in each allocation
+ * step run on the superframe change and building the TTP, so that the
+ * scaling of the controller can be followed from a few terminals to
+ * tens of thousands. The time of the superframe change, from the
+ * allocations to the TTP built, is reported apart as it is the latency
+ * critical path, shortened by computing the allocations ahead.
+ *
+ * Launch the application with -h to learn how to use it.
+ *
+ * Author: Viveris Technologies
+ */
+
+// OpenSAND includes
+#include "DamaCtrlRcs2Legacy.h"
+#include "TerminalContextDamaRcs.h"
+#include "FmtDefinitionTable.h"
+#include "FmtGroup.h"
+#include "StFmtSimu.h"
+#include "Logon.h"
+#include "Sac.h"
+#include "Ttp.h"
+
+#include <opensand_output/Output.h>
+
+// system includes
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+
+/// The program usage
+#define USAGE \
+"DAMA benchmark: measure the DAMA controller on synthetic terminal populations\n\n\
+usage: bench_dama [-h] [-c categories] [-k ksymps] [-m cra:rbdc:vbdc] [-s superframes]\n\
+                  [-w workers] [-a fca] [-l superframes] [-f] [-t] [-g ns]\n\
+                  [terminals...]\n\
+\t-h                print this usage and exit\n\
+\t-c categories     the number of terminal categories, of one carrier each\n\
+\t                  (default: one per 250 terminals)\n\
+\t-k ksymps         the carriers symbol rate per terminal in ksym/s (default: 200)\n\
+\t-m cra:rbdc:vbdc  the share of CRA only, RBDC and VBDC terminals (default: 20:50:30)\n\
+\t-s superframes    the number of superframes of each population (default: 50)\n\
+\t-w workers        the number of DAMA workers (default: 1)\n\
+\t-a fca            the FCA maximum rate in kb/s, 0 to disable (default: 0)\n\
+\t-l superframes    compute the allocations ahead by this number of superframes,\n\
+\t                  in the middle of the SACs (default: 0)\n\
+\t-f                share the RBDC capacity in weighted fair share\n\
+\t-t                build sparse TTPs, without the terminals that have no allocation\n\
+\t-g ns             fail if a superframe takes more than ns per terminal (default: no limit)\n\
+\tterminals         the populations (default: 10 100 1000 5000 10000 20000)\n\n"
+
+#define ERROR(format, ...) \
+	do { \
+		fprintf(stderr, format, ##__VA_ARGS__); \
+	} while(0)
+
+
+/// The superframe duration (ms)
+static const time_ms_t frame_duration_ms = 26;
+
+/// The RCS2 burst length (sym)
+static const vol_sym_t burst_length_sym = 536;
+
+/// The RBDC timeout (superframes)
+static const time_sf_t rbdc_timeout_sf = 16;
+
+/// The terminals capacity limits
+static const rate_kbps_t cra_kbps = 64;
+static const rate_kbps_t max_rbdc_kbps = 2048;
+static const vol_kb_t max_vbdc_kb = 512;
+
+/// The terminals per category when their number is not given
+static const unsigned int terminals_per_category = 250;
+
+/// The share of terminals whose CNI changes each superframe (%)
+static const unsigned int cni_changes = 5;
+
+
+/**
+ * @brief The type of a synthetic terminal
+ */
+enum class TerminalType
+{
+	cra,
+	rbdc,
+	vbdc,
+};
+
+
+/**
+ * @brief The time spent in each step during the superframes of a population
+ */
+struct dama_times_t
+{
+	std::chrono::nanoseconds sac{0};
+	std::chrono::nanoseconds fmt{0};
+	std::chrono::nanoseconds reset{0};
+	std::chrono::nanoseconds cra{0};
+	std::chrono::nanoseconds rbdc{0};
+	std::chrono::nanoseconds vbdc{0};
+	std::chrono::nanoseconds fca{0};
+	std::chrono::nanoseconds ttp{0};
+	/// The superframe change, from the allocations to the TTP, already
+	/// counted in the other steps
+	std::chrono::nanoseconds change{0};
+
+	std::chrono::nanoseconds total() const
+	{
+		return sac + fmt + reset + cra + rbdc + vbdc + fca + ttp;
+	}
+};
+
+
+/**
+ * @brief Add the duration of a scope to a step time
+ */
+class StepTimer
+{
+public:
+	StepTimer(std::chrono::nanoseconds &time):
+		time(time),
+		start(std::chrono::steady_clock::now())
+	{
+	}
+
+	~StepTimer()
+	{
+		this->time += std::chrono::steady_clock::now() - this->start;
+	}
+
+private:
+	std::chrono::nanoseconds &time;
+	std::chrono::steady_clock::time_point start;
+};
+
+
+/**
+ * @brief The legacy DAMA controller, timing its allocation steps
+ */
+class BenchDamaCtrl: public DamaCtrlRcs2Legacy
+{
+public:
+	BenchDamaCtrl(spot_id_t spot, unsigned int workers, bool fair_share):
+		DamaCtrlRcs2Legacy(spot, workers, fair_share),
+		times()
+	{
+	}
+
+	/**
+	 * @brief Get the capacity allocated to the terminals on the last superframe
+	 *
+	 * @return the allocated capacity (kb)
+	 */
+	uint64_t getAllocation() const
+	{
+		uint64_t allocation_kb = 0;
+		if(this->look_ahead_sf > 0)
+		{
+			for(auto &&allocation: this->current_plan.allocations)
+			{
+				allocation_kb += allocation.volume_kb;
+				allocation_kb += this->converter->psToPf(allocation.rate_kbps);
+			}
+			return allocation_kb;
+		}
+		for(auto &&terminal_it: this->terminals)
+		{
+			auto terminal = static_cast<TerminalContextDamaRcs *>(terminal_it.second);
+			allocation_kb += terminal->getTotalVolumeAllocation();
+			allocation_kb += this->converter->psToPf(terminal->getTotalRateAllocation());
+		}
+		return allocation_kb;
+	}
+
+	dama_times_t times;
+
+protected:
+	bool resetCarriersCapacity() override
+	{
+		StepTimer timer(this->times.reset);
+		return DamaCtrlRcs2Legacy::resetCarriersCapacity();
+	}
+
+	bool updateWaveForms() override
+	{
+		StepTimer timer(this->times.reset);
+		return DamaCtrlRcs2Legacy::updateWaveForms();
+	}
+
+	bool resetTerminalsAllocations() override
+	{
+		StepTimer timer(this->times.reset);
+		return DamaCtrlRcs2Legacy::resetTerminalsAllocations();
+	}
+
+	bool computeTerminalsCraAllocation() override
+	{
+		StepTimer timer(this->times.cra);
+		return DamaCtrlRcs2Legacy::computeTerminalsCraAllocation();
+	}
+
+	bool computeTerminalsRbdcAllocation() override
+	{
+		StepTimer timer(this->times.rbdc);
+		return DamaCtrlRcs2Legacy::computeTerminalsRbdcAllocation();
+	}
+
+	bool computeTerminalsVbdcAllocation() override
+	{
+		StepTimer timer(this->times.vbdc);
+		return DamaCtrlRcs2Legacy::computeTerminalsVbdcAllocation();
+	}
+
+	bool computeTerminalsFcaAllocation() override
+	{
+		StepTimer timer(this->times.fca);
+		return DamaCtrlRcs2Legacy::computeTerminalsFcaAllocation();
+	}
+};
+
+
+/**
+ * @brief Fill the DVB-RCS2 MODCOD definitions of 536 symbols bursts
+ *
+ * @param modcod_def  The MODCOD definitions table
+ */
+static void fillModcodDefinitions(FmtDefinitionTable &modcod_def)
+{
+	static const struct
+	{
+		unsigned int id;
+		const char *modulation;
+		const char *coding;
+		float efficiency;
+		double threshold;
+	} definitions[] = {
+		{3, "QPSK", "1/3", 0.56, 0.22},
+		{4, "QPSK", "1/2", 0.87, 2.34},
+		{5, "QPSK", "2/3", 1.26, 4.29},
+		{6, "QPSK", "3/4", 1.42, 5.36},
+		{7, "QPSK", "5/6", 1.60, 6.68},
+		{8, "8PSK", "2/3", 1.70, 8.08},
+		{9, "8PSK", "3/4", 1.93, 9.31},
+		{10, "8PSK", "5/6", 2.13, 10.82},
+		{11, "16QAM", "3/4", 2.59, 11.17},
+		{12, "16QAM", "5/6", 2.87, 12.56},
+	};
+	for(auto &&definition: definitions)
+	{
+		modcod_def.add(new FmtDefinition(definition.id,
+		                                 definition.modulation,
+		                                 definition.coding,
+		                                 definition.efficiency,
+		                                 definition.threshold,
+		                                 burst_length_sym));
+	}
+}
+
+
+/**
+ * @brief The benchmark parameters
+ */
+struct bench_options_t
+{
+	/// The number of terminal categories, 0 for one per terminals_per_category
+	unsigned int categories;
+	/// The carriers symbol rate per terminal (ksym/s)
+	double ksymps;
+	/// The share of CRA only, RBDC and VBDC terminals
+	unsigned int shares[3];
+	/// The number of superframes of each population
+	unsigned int superframes;
+	/// The number of DAMA workers
+	unsigned int workers;
+	/// The FCA maximum rate (kb/s)
+	rate_kbps_t fca_kbps;
+	/// The number of superframes the allocations are computed ahead
+	time_sf_t look_ahead;
+	/// Whether the RBDC capacity is shared in weighted fair share
+	bool fair_share;
+	/// Whether the TTPs are sparse
+	bool sparse_ttp;
+};
+
+
+/**
+ * @brief Run the superframes of a terminal population
+ *
+ * @param spot         The spot of the controller, distinct for each
+ *                     population so that their probes do not conflict
+ * @param terminals    The number of terminals
+ * @param options      The benchmark parameters
+ * @param times        OUT: the time spent in each step
+ * @param alloc_kb     OUT: the mean capacity allocated per superframe (kb)
+ * @return true on success, false otherwise
+ */
+static bool runPopulation(spot_id_t spot, unsigned int terminals,
+                          const bench_options_t &options,
+                          dama_times_t &times, double &alloc_kb)
+{
+	FmtDefinitionTable modcod_def;
+	fillModcodDefinitions(modcod_def);
+	FmtGroup fmt_group(1, "3-12", &modcod_def);
+	StFmtSimuList input_sts("Bench");
+
+	// one carrier per category, as required by the legacy DAMA
+	TerminalCategories<TerminalCategoryDama> categories;
+	TerminalMapping<TerminalCategoryDama> terminal_affectation;
+	unsigned int categories_count = options.categories;
+	if(categories_count == 0)
+	{
+		categories_count = (terminals + terminals_per_category - 1) / terminals_per_category;
+	}
+	const unsigned int per_category = (terminals + categories_count - 1) / categories_count;
+	for(unsigned int index = 0; index < categories_count; ++index)
+	{
+		auto category = new TerminalCategoryDama("Category" + std::to_string(index));
+		category->addCarriersGroup(index, &fmt_group, 1,
+		                           per_category * options.ksymps * 1000,
+		                           AccessType::DAMA);
+		category->updateCarriersGroups(1, frame_duration_ms);
+		categories[category->getLabel()] = category;
+	}
+	TerminalCategoryDama *default_category = categories.begin()->second;
+
+	// the synthetic terminals use the ids of the simulated ones,
+	// after the broadcast id, so they have no per terminal probes
+	std::vector<tal_id_t> tal_ids;
+	std::vector<TerminalType> types;
+	std::vector<TerminalCategoryDama *> all_categories;
+	for(auto &&category_it: categories)
+	{
+		all_categories.push_back(category_it.second);
+	}
+	std::mt19937 generator{terminals};
+	std::discrete_distribution<int> type_distribution{
+		options.shares[0] * 1.0, options.shares[1] * 1.0, options.shares[2] * 1.0};
+	for(unsigned int index = 0; index < terminals; ++index)
+	{
+		tal_id_t tal_id = BROADCAST_TAL_ID + 1 + index;
+		tal_ids.push_back(tal_id);
+		types.push_back(static_cast<TerminalType>(type_distribution(generator)));
+		terminal_affectation[tal_id] = all_categories[index % all_categories.size()];
+		input_sts.addTerminal(tal_id, modcod_def.getMinId(), &modcod_def);
+	}
+
+	std::unique_ptr<BenchDamaCtrl> dama{new BenchDamaCtrl(spot, options.workers, options.fair_share)};
+	if(!dama->initParent(frame_duration_ms, rbdc_timeout_sf, options.fca_kbps,
+	                     categories, terminal_affectation, default_category,
+	                     &input_sts, &modcod_def, false) ||
+	   !dama->init(burst_length_sym))
+	{
+		ERROR("cannot initialize the DAMA controller\n");
+		return false;
+	}
+	dama->setLookAhead(options.look_ahead);
+	dama->setSparseTtp(options.sparse_ttp);
+
+	for(unsigned int index = 0; index < terminals; ++index)
+	{
+		const TerminalType type = types[index];
+		LogonRequest logon(tal_ids[index],
+		                   type == TerminalType::cra ? cra_kbps : 0,
+		                   type == TerminalType::rbdc ? max_rbdc_kbps : 0,
+		                   type == TerminalType::vbdc ? max_vbdc_kb : 0);
+		if(!dama->hereIsLogon(&logon))
+		{
+			ERROR("cannot log terminal %u on\n", tal_ids[index]);
+			return false;
+		}
+	}
+
+	std::uniform_real_distribution<double> cni_distribution(0.0, 14.0);
+	std::uniform_int_distribution<unsigned int> percent_distribution(0, 99);
+	std::uniform_int_distribution<uint32_t> rbdc_distribution(0, max_rbdc_kbps);
+	std::uniform_int_distribution<uint32_t> vbdc_distribution(0, max_vbdc_kb);
+	for(tal_id_t tal_id: tal_ids)
+	{
+		input_sts.setRequiredCni(tal_id, cni_distribution(generator));
+	}
+
+	double allocated_kb = 0;
+	std::vector<std::unique_ptr<Sac>> sacs;
+	for(time_sf_t superframe = 1; superframe <= options.superframes; ++superframe)
+	{
+		// build the SACs received during the superframe
+		sacs.clear();
+		for(unsigned int index = 0; index < terminals; ++index)
+		{
+			if(percent_distribution(generator) < cni_changes)
+			{
+				input_sts.setRequiredCni(tal_ids[index], cni_distribution(generator));
+			}
+			if(types[index] == TerminalType::cra)
+			{
+				continue;
+			}
+			std::unique_ptr<Sac> sac{new Sac(tal_ids[index])};
+			if(types[index] == TerminalType::rbdc)
+			{
+				sac->addRequest(0, ReturnAccessType::dama_rbdc, rbdc_distribution(generator));
+			}
+			else
+			{
+				sac->addRequest(0, ReturnAccessType::dama_vbdc, vbdc_distribution(generator));
+			}
+			sacs.push_back(std::move(sac));
+		}
+
+		{
+			StepTimer timer(dama->times.fmt);
+			dama->updateRequiredFmts();
+		}
+		// the allocations of the next superframes are computed ahead in
+		// the middle of the SACs, the SACs received later correct them
+		const std::size_t middle = sacs.size() / 2;
+		for(std::size_t half = 0; half < 2; ++half)
+		{
+			if(half == 1 && !dama->runAhead(superframe - 1))
+			{
+				ERROR("cannot compute the allocations after superframe %u\n", superframe - 1);
+				return false;
+			}
+			StepTimer timer(dama->times.sac);
+			for(std::size_t index = half ? middle : 0;
+			    index < (half ? sacs.size() : middle);
+			    ++index)
+			{
+				if(!dama->hereIsSAC(sacs[index].get()))
+				{
+					ERROR("cannot handle the SAC of terminal %u\n", sacs[index]->getTerminalId());
+					return false;
+				}
+			}
+		}
+		// the allocation steps are timed by the controller
+		{
+			StepTimer change_timer(dama->times.change);
+			dama->runOnSuperFrameChange(superframe);
+			Ttp ttp(0, superframe);
+			StepTimer timer(dama->times.ttp);
+			if(!dama->buildTTP(&ttp))
+			{
+				ERROR("cannot build the TTP of superframe %u\n", superframe);
+				return false;
+			}
+		}
+		allocated_kb += dama->getAllocation();
+	}
+
+	times = dama->times;
+	alloc_kb = allocated_kb / options.superframes;
+	return true;
+}
+
+
+int main(int argc, char *argv[])
+{
+	bench_options_t options{0, 200, {20, 50, 30}, 50, 1, 0, 0, false, false};
+	long max_ns_per_terminal = 0;
+	std::vector<unsigned int> populations;
+	int opt;
+
+	while((opt = getopt(argc, argv, "hc:k:m:s:w:a:l:ftg:")) != -1)
+	{
+		switch(opt)
+		{
+			case 'c':
+				options.categories = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'k':
+				options.ksymps = std::strtod(optarg, nullptr);
+				break;
+			case 'm':
+				if(sscanf(optarg, "%u:%u:%u", &options.shares[0],
+				          &options.shares[1], &options.shares[2]) != 3)
+				{
+					ERROR(USAGE);
+					return EXIT_FAILURE;
+				}
+				break;
+			case 's':
+				options.superframes = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'w':
+				options.workers = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'a':
+				options.fca_kbps = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'l':
+				options.look_ahead = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'f':
+				options.fair_share = true;
+				break;
+			case 't':
+				options.sparse_ttp = true;
+				break;
+			case 'g':
+				max_ns_per_terminal = std::strtol(optarg, nullptr, 10);
+				break;
+			case 'h':
+			default:
+				ERROR(USAGE);
+				return EXIT_FAILURE;
+		}
+	}
+	for(int index = optind; index < argc; ++index)
+	{
+		populations.push_back(std::strtoul(argv[index], nullptr, 10));
+	}
+	if(populations.empty())
+	{
+		populations = {10, 100, 1000, 5000, 10000, 20000};
+	}
+	bool valid = options.ksymps > 0 &&
+	             options.shares[0] + options.shares[1] + options.shares[2] > 0 &&
+	             options.superframes > 0 && populations.size() < UINT8_MAX;
+	for(unsigned int terminals: populations)
+	{
+		// the terminal ids are 16 bits long, after the broadcast id
+		valid &= terminals > 0 && terminals <= UINT16_MAX - BROADCAST_TAL_ID;
+	}
+	if(!valid)
+	{
+		ERROR(USAGE);
+		return EXIT_FAILURE;
+	}
+
+	auto output = Output::Get();
+	output->configureTerminalOutput();
+	Sac::sac_log = output->registerLog(LEVEL_WARNING, "Dvb.SAC");
+	Ttp::ttp_log = output->registerLog(LEVEL_WARNING, "Dvb.TTP");
+	output->finalizeConfiguration();
+
+	const std::string categories = options.categories ?
+	                               std::to_string(options.categories) + " categories" :
+	                               "1 category per " + std::to_string(terminals_per_category) + " terminals";
+	printf("%s, %.0f ksym/s per terminal, %u:%u:%u CRA:RBDC:VBDC terminals, "
+	       "%u superframes, %u workers, %u superframes look-ahead, %s RBDC share, "
+	       "%s TTPs\n\n",
+	       categories.c_str(), options.ksymps, options.shares[0], options.shares[1],
+	       options.shares[2], options.superframes, options.workers, options.look_ahead,
+	       options.fair_share ? "weighted fair" : "proportional",
+	       options.sparse_ttp ? "sparse" : "full");
+	printf("%9s %9s %9s %9s %9s %9s %9s %9s %9s %10s %11s %12s %11s\n",
+	       "terminals", "sac (us)", "fmt (us)", "reset (us)", "cra (us)", "rbdc (us)",
+	       "vbdc (us)", "fca (us)", "ttp (us)", "total (us)", "per ST (ns)", "alloc (kb)",
+	       "change (us)");
+
+	bool within_limit = true;
+	spot_id_t spot = 0;
+	for(unsigned int terminals: populations)
+	{
+		dama_times_t times;
+		double alloc_kb;
+		if(!runPopulation(++spot, terminals, options, times, alloc_kb))
+		{
+			return EXIT_FAILURE;
+		}
+
+		const auto mean_us = [&](std::chrono::nanoseconds time)
+		{
+			return time.count() / 1000.0 / options.superframes;
+		};
+		const double per_terminal_ns = times.total().count() /
+		                               static_cast<double>(options.superframes) / terminals;
+		printf("%9u %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %10.1f %11.1f %12.0f %11.1f\n",
+		       terminals, mean_us(times.sac), mean_us(times.fmt), mean_us(times.reset),
+		       mean_us(times.cra), mean_us(times.rbdc), mean_us(times.vbdc),
+		       mean_us(times.fca), mean_us(times.ttp), mean_us(times.total()),
+		       per_terminal_ns, alloc_kb, mean_us(times.change));
+		if(max_ns_per_terminal > 0 && per_terminal_ns > max_ns_per_terminal)
+		{
+			within_limit = false;
+		}
+	}
+
+	if(!within_limit)
+	{
+		ERROR("\na superframe took more than %ld ns per terminal\n", max_ns_per_terminal);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,687 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * Benchmark of the DVB-S2 forward and SCPC schedulers
+ *
+ * The application fills the MAC FIFOs of a gateway with the packets of an
+ * encapsulation plugin (GSE by default) for synthetic terminal populations
+ * and runs the forward scheduler on them every frame, the terminals getting
+ * randomised MODCODs from a synthetic FMT simulation. The carriers are set
+ * in ACM or in several VCM configurations, each terminal being served on
+ * one VCM carrier and changing of MODCOD among the ones of its carrier, and
+ * the SCPC scheduler of a terminal is run the same way on its return carrier.
+ *
+ * For each configuration and population, it reports the BBFrames built
+ * per frame and per second of scheduling, the fill efficiency of the
+ * BBFrames (their payload over their capacity) and the mean and 99th
+ * percentile of the scheduling time of a frame, so that both the throughput
+ * and the packing quality of the schedulers can be followed.
+ *
+ * Launch the application with -h to learn how to use it.
+ *
+ * Author: Viveris Technologies
+ */
+
+// OpenSAND includes
+#include "ForwardSchedulingS2.h"
+#include "ScpcScheduling.h"
+#include "BBFrame.h"
+#include "DvbFifo.h"
+#include "EncapPlugin.h"
+#include "Ethernet.h"
+#include "FifoElement.h"
+#include "FmtDefinitionTable.h"
+#include "FmtGroup.h"
+#include "NetBurst.h"
+#include "OpenSandModelConf.h"
+#include "Plugin.h"
+#include "StFmtSimu.h"
+#include "TerminalCategoryDama.h"
+
+#include <opensand_output/Output.h>
+
+// system includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+
+/// The program usage
+#define USAGE \
+"Scheduling benchmark: measure the forward and SCPC schedulers on synthetic terminal populations\n\n\
+usage: bench_scheduling [-h] [-e plugin] [-p profile] [-r msymps] [-l load] [-s frames]\n\
+                        [-g fill] [terminals...]\n\
+\t-h          print this usage and exit\n\
+\t-e plugin   the encapsulation plugin filling the FIFOs (default: GSE)\n\
+\t-p profile  the entity profile giving the network and plugins configuration\n\
+\t-r msymps   the carriers symbol rate in Msym/s (default: 50)\n\
+\t-l load     the offered load in percent of the carriers capacity (default: 90)\n\
+\t-s frames   the number of frames of each run (default: 200)\n\
+\t-g fill     fail if the BBFrames fill efficiency of a run is below fill percent\n\
+\t            (default: no limit)\n\
+\tterminals   the populations, at most 254 terminals (default: 10 50 100 250)\n\n"
+
+#define ERROR(format, ...) \
+	do { \
+		fprintf(stderr, format, ##__VA_ARGS__); \
+	} while(0)
+
+
+/// The profile used when none is given
+static const char *default_profile =
+"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+"<model version=\"1.0.0\">\n"
+"  <root>\n"
+"    <network>\n"
+"      <qos_classes>\n"
+"        <item><pcp>0</pcp><name>BE</name><fifo>BE</fifo></item>\n"
+"      </qos_classes>\n"
+"      <virtual_connections/>\n"
+"      <qos_settings>\n"
+"        <lan_frame_type>Ethernet</lan_frame_type>\n"
+"        <sat_frame_type>Ethernet</sat_frame_type>\n"
+"        <default_pcp>0</default_pcp>\n"
+"      </qos_settings>\n"
+"    </network>\n"
+"    <encap>\n"
+"      <gse><packing_threshold>3</packing_threshold></gse>\n"
+"      <rle><alpdu_protection>Sequence Number</alpdu_protection></rle>\n"
+"    </encap>\n"
+"  </root>\n"
+"</model>\n";
+
+
+/// The frame duration (ms)
+static const time_ms_t frame_duration_ms = 10;
+
+/// The gateway ID
+static const tal_id_t gw_id = 0;
+
+/// The MAC FIFOs size (packets)
+static const vol_pkt_t fifo_size_pkt = 10000;
+
+/// The share of terminals whose CNI changes each frame (%)
+static const unsigned int cni_changes = 5;
+
+/// The IP packets lengths of the traffic and their weights (simple IMIX)
+static const std::vector<std::pair<std::size_t, unsigned int>> imix_lengths =
+{
+	{40, 7}, {576, 4}, {1500, 1},
+};
+
+
+/**
+ * @brief A carriers configuration: its VCM carriers, a single one for ACM
+ */
+struct sched_config_t
+{
+	/// The configuration name
+	const char *name;
+	/// Whether the SCPC scheduler is run instead of the forward one
+	bool scpc;
+	/// The VCM carriers: the range of their MODCODs and their ratio
+	std::vector<std::tuple<fmt_id_t, fmt_id_t, unsigned int>> vcm;
+};
+
+static const std::vector<sched_config_t> configurations =
+{
+	{"ACM", false, {std::make_tuple(1, 28, 100)}},
+	{"VCM2", false, {std::make_tuple(1, 11, 50), std::make_tuple(12, 28, 50)}},
+	{"VCM4", false, {std::make_tuple(1, 11, 25), std::make_tuple(12, 17, 25),
+	                 std::make_tuple(18, 23, 25), std::make_tuple(24, 28, 25)}},
+	{"SCPC", true, {std::make_tuple(1, 28, 100)}},
+};
+
+
+/**
+ * @brief The benchmark parameters
+ */
+struct bench_options_t
+{
+	/// The carriers symbol rate (Msym/s)
+	double msymps;
+	/// The offered load (% of the carriers capacity)
+	unsigned int load;
+	/// The number of frames of each run
+	unsigned int frames;
+};
+
+
+/**
+ * @brief The results of a run
+ */
+struct sched_result_t
+{
+	/// The complete BBFrames
+	uint64_t bbframes = 0;
+	/// The payload and the capacity of the complete BBFrames (bytes)
+	uint64_t payload_bytes = 0;
+	uint64_t capacity_bytes = 0;
+	/// The scheduling time of each frame (ns)
+	std::vector<uint64_t> times_ns;
+};
+
+
+/**
+ * @brief Fill the DVB-S2 MODCOD definitions
+ *
+ * @param modcod_def  The MODCOD definitions table
+ */
+static void fillModcodDefinitions(FmtDefinitionTable &modcod_def)
+{
+	static const struct
+	{
+		unsigned int id;
+		const char *modulation;
+		const char *coding;
+		float efficiency;
+		double threshold;
+	} definitions[] = {
+		{1, "QPSK", "1/4", 0.490, -2.35},
+		{2, "QPSK", "1/3", 0.656, -1.24},
+		{3, "QPSK", "2/5", 0.789, -0.30},
+		{4, "QPSK", "1/2", 0.988, 1.00},
+		{5, "QPSK", "3/5", 1.188, 2.23},
+		{6, "QPSK", "2/3", 1.322, 3.10},
+		{7, "QPSK", "3/4", 1.487, 4.03},
+		{8, "QPSK", "4/5", 1.587, 4.68},
+		{9, "QPSK", "5/6", 1.655, 5.18},
+		{10, "QPSK", "8/9", 1.767, 6.20},
+		{11, "QPSK", "9/10", 1.789, 6.42},
+		{12, "8PSK", "3/5", 1.780, 5.50},
+		{13, "8PSK", "2/3", 1.981, 6.62},
+		{14, "8PSK", "3/4", 2.228, 7.91},
+		{15, "8PSK", "5/6", 2.479, 9.35},
+		{16, "8PSK", "8/9", 2.646, 10.69},
+		{17, "8PSK", "9/10", 2.679, 10.98},
+		{18, "16APSK", "2/3", 2.637, 8.97},
+		{19, "16APSK", "3/4", 2.967, 10.21},
+		{20, "16APSK", "4/5", 3.166, 11.03},
+		{21, "16APSK", "5/6", 3.300, 11.61},
+		{22, "16APSK", "8/9", 3.523, 12.89},
+		{23, "16APSK", "9/10", 3.567, 13.13},
+		{24, "32APSK", "3/4", 3.703, 12.73},
+		{25, "32APSK", "4/5", 3.952, 13.64},
+		{26, "32APSK", "5/6", 4.120, 14.28},
+		{27, "32APSK", "8/9", 4.398, 15.69},
+		{28, "32APSK", "9/10", 4.453, 16.05},
+	};
+	for(auto &&definition: definitions)
+	{
+		modcod_def.add(new FmtDefinition(definition.id,
+		                                 definition.modulation,
+		                                 definition.coding,
+		                                 definition.efficiency,
+		                                 definition.threshold));
+	}
+}
+
+
+/**
+ * @brief Generate the Ethernet frames of the traffic
+ *
+ * @param count   The number of frames
+ * @param frames  OUT: the frames
+ */
+static void generateFrames(std::size_t count, std::vector<Data> &frames)
+{
+	std::mt19937 random{42};
+	std::vector<unsigned int> weights;
+	for(auto &&length: imix_lengths)
+	{
+		weights.push_back(length.second);
+	}
+	std::discrete_distribution<std::size_t> pick{weights.begin(), weights.end()};
+
+	frames.clear();
+	frames.reserve(count);
+	for(std::size_t index = 0; index < count; ++index)
+	{
+		std::size_t ip_length = imix_lengths[pick(random)].first;
+		Data frame;
+		frame.assign(14 + ip_length, 0);
+
+		// Ethernet header: destination, source, IPv4 ethertype
+		frame[5] = 0x02;
+		frame[11] = 0x01;
+		frame[12] = 0x08;
+		frame[13] = 0x00;
+
+		// IPv4 header with the total length, UDP protocol
+		frame[14] = 0x45;
+		frame[16] = ip_length >> 8;
+		frame[17] = ip_length & 0xff;
+		frame[22] = 64;
+		frame[23] = 17;
+		for(std::size_t byte = 34; byte < frame.size(); ++byte)
+		{
+			frame[byte] = random();
+		}
+		frames.push_back(frame);
+	}
+}
+
+
+/**
+ * @brief Run the frames of a carriers configuration and a terminal population
+ *
+ * @param spot           The spot of the scheduler, distinct for each run
+ *                       so that their probes do not conflict
+ * @param configuration  The carriers configuration
+ * @param terminals      The number of terminals, ignored for SCPC where
+ *                       a single terminal emits towards the gateway
+ * @param options        The benchmark parameters
+ * @param plugin         The encapsulation plugin
+ * @param lan            The LAN adaptation building the packets
+ * @param traffic        The Ethernet frames sent to the terminals
+ * @param result         OUT: the run results
+ * @return true on success, false otherwise
+ */
+static bool runConfiguration(spot_id_t spot,
+                             const sched_config_t &configuration,
+                             unsigned int terminals,
+                             const bench_options_t &options,
+                             EncapPlugin *plugin,
+                             Ethernet *lan,
+                             const std::vector<Data> &traffic,
+                             sched_result_t &result)
+{
+	FmtDefinitionTable modcod_def;
+	fillModcodDefinitions(modcod_def);
+	StFmtSimuList simu_sts("Bench");
+	std::mt19937 generator{spot};
+
+	// the terminal IDs are 8 bits long in the packets,
+	// the broadcast one is skipped, for SCPC the emitting terminal
+	// is the only one known and is the spot ID so that the probes
+	// do not conflict
+	std::vector<tal_id_t> tal_ids;
+	if(configuration.scpc)
+	{
+		tal_ids.push_back(spot);
+	}
+	for(tal_id_t tal_id = gw_id + 1;
+	    !configuration.scpc && tal_ids.size() < terminals;
+	    ++tal_id)
+	{
+		if(tal_id != BROADCAST_TAL_ID)
+		{
+			tal_ids.push_back(tal_id);
+		}
+	}
+
+	// the terminals are spread between the VCM carriers and get the CNI
+	// required by one of the MODCODs of their carrier
+	std::vector<unsigned int> terminal_vcm(tal_ids.size(), 0);
+	const auto setRandomCni = [&](unsigned int index)
+	{
+		const auto &vcm = configuration.vcm[terminal_vcm[index]];
+		std::uniform_int_distribution<unsigned int> modcod_distribution(std::get<0>(vcm),
+		                                                                std::get<1>(vcm));
+		simu_sts.setRequiredCni(tal_ids[index],
+		                        modcod_def.getRequiredEsN0(modcod_distribution(generator)));
+	};
+	for(unsigned int index = 0; index < tal_ids.size(); ++index)
+	{
+		terminal_vcm[index] = index % configuration.vcm.size();
+		simu_sts.addTerminal(tal_ids[index], modcod_def.getMinId(), &modcod_def);
+		setRandomCni(index);
+	}
+
+	// the FMT groups have to outlive the scheduler and its carriers
+	std::vector<std::unique_ptr<FmtGroup>> fmt_groups;
+	auto category = new TerminalCategoryDama("Bench",
+	                                         configuration.scpc ? AccessType::SCPC : AccessType::TDM);
+	const rate_symps_t rate_symps = options.msymps * 1e6;
+	for(auto &&vcm: configuration.vcm)
+	{
+		std::string ids = std::to_string(std::get<0>(vcm)) + "-" + std::to_string(std::get<1>(vcm));
+		fmt_groups.emplace_back(new FmtGroup(fmt_groups.size() + 1, ids, &modcod_def));
+		category->addCarriersGroup(0, fmt_groups.back().get(), std::get<2>(vcm),
+		                           rate_symps,
+		                           configuration.scpc ? AccessType::SCPC : AccessType::TDM);
+	}
+	category->updateCarriersGroups(1, frame_duration_ms);
+	const vol_sym_t capacity_sym = category->getCarriersGroups().front()->getTotalCapacity();
+
+	// one FIFO per VCM carrier, or a single ACM one
+	fifos_t fifos;
+	const bool vcm = configuration.vcm.size() > 1;
+	for(unsigned int index = 0; index < configuration.vcm.size(); ++index)
+	{
+		std::string type = vcm ? "VCM" + std::to_string(index) : "ACM";
+		fifos[index] = new DvbFifo(index, "BE" + std::to_string(index), type, fifo_size_pkt);
+	}
+
+	std::unique_ptr<Scheduling> scheduler;
+	if(configuration.scpc)
+	{
+		scheduler.reset(new ScpcScheduling(frame_duration_ms, plugin->getPacketHandler(),
+		                                   fifos, &simu_sts, &modcod_def, category,
+		                                   spot));
+	}
+	else
+	{
+		scheduler.reset(new ForwardSchedulingS2(frame_duration_ms, plugin->getPacketHandler(),
+		                                        fifos, &simu_sts, &modcod_def, category,
+		                                        spot, true, gw_id, ""));
+	}
+
+	const std::size_t header_length = BBFrame().getTotalLength();
+	EncapPlugin::EncapContext *context = plugin->getContext();
+	std::map<long, int> time_contexts;
+	std::uniform_int_distribution<unsigned int> percent_distribution(0, 99);
+	std::vector<double> credits(tal_ids.size(), 0);
+	std::size_t traffic_index = 0;
+	bool success = true;
+
+	result = sched_result_t{};
+	result.times_ns.reserve(options.frames);
+	for(time_sf_t frame = 1; frame <= options.frames && success; ++frame)
+	{
+		const clock_t current_time = frame * frame_duration_ms;
+
+		// give each VCM carrier its load, shared between the terminals
+		// served on it, according to their MODCOD
+		std::vector<double> efficiencies(configuration.vcm.size(), 0);
+		std::vector<unsigned int> served(configuration.vcm.size(), 0);
+		for(unsigned int index = 0; index < tal_ids.size(); ++index)
+		{
+			if(percent_distribution(generator) < cni_changes)
+			{
+				setRandomCni(index);
+			}
+			const unsigned int vcm_index = terminal_vcm[index];
+			fmt_id_t modcod_id = simu_sts.getCurrentModcodId(tal_ids[index]);
+			efficiencies[vcm_index] += modcod_def.getSpectralEfficiency(modcod_id);
+			served[vcm_index]++;
+		}
+
+		NetBurst *burst = new NetBurst();
+		for(unsigned int index = 0; index < tal_ids.size(); ++index)
+		{
+			const unsigned int vcm_index = terminal_vcm[index];
+			const double share = std::get<2>(configuration.vcm[vcm_index]) / 100.0;
+			const double mean_efficiency = efficiencies[vcm_index] / served[vcm_index];
+			credits[index] += capacity_sym * share * options.load / 100.0 *
+			                  mean_efficiency / 8 / served[vcm_index];
+			while(credits[index] >= traffic[traffic_index].size())
+			{
+				const Data &data = traffic[traffic_index];
+				credits[index] -= data.size();
+				traffic_index = (traffic_index + 1) % traffic.size();
+				tal_id_t src = configuration.scpc ? tal_ids[index] : gw_id;
+				tal_id_t dst = configuration.scpc ? gw_id : tal_ids[index];
+				burst->add(lan->getPacketHandler()->build(data, data.size(), 0, src, dst));
+			}
+		}
+
+		// the encapsulation is not part of the measure
+		burst = context->encapsulate(burst, time_contexts);
+		if(burst == nullptr)
+		{
+			ERROR("%s: cannot encapsulate the traffic\n", plugin->getName().c_str());
+			success = false;
+			break;
+		}
+		NetBurst *flushed = context->flushAll();
+		if(flushed != nullptr)
+		{
+			for(auto &&packet: *flushed)
+			{
+				burst->push_back(std::move(packet));
+			}
+			delete flushed;
+		}
+		for(auto &&packet: *burst)
+		{
+			std::size_t index = configuration.scpc ? 0 :
+			                    std::find(tal_ids.begin(), tal_ids.end(),
+			                              packet->getDstTalId()) - tal_ids.begin();
+			DvbFifo *fifo = fifos[index < tal_ids.size() ? terminal_vcm[index] : 0];
+			FifoElement elem(std::move(packet), current_time, current_time);
+			// the packets exceeding the FIFO size are dropped
+			fifo->push(std::move(elem));
+		}
+		delete burst;
+
+		std::list<DvbFrame *> complete_frames;
+		uint32_t remaining_allocation = 0;
+		auto start = std::chrono::steady_clock::now();
+		success = scheduler->schedule(frame, current_time, &complete_frames, remaining_allocation);
+		auto time = std::chrono::steady_clock::now() - start;
+		result.times_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+
+		for(auto &&complete_frame: complete_frames)
+		{
+			result.bbframes++;
+			result.payload_bytes += complete_frame->getTotalLength() - header_length;
+			result.capacity_bytes += complete_frame->getMaxSize() - header_length;
+			delete complete_frame;
+		}
+	}
+	if(!success)
+	{
+		ERROR("%s: cannot schedule the frames\n", configuration.name);
+	}
+
+	scheduler.reset();
+	for(auto &&fifo: fifos)
+	{
+		delete fifo.second;
+	}
+	return success;
+}
+
+
+int main(int argc, char *argv[])
+{
+	bench_options_t options{50, 90, 200};
+	std::string plugin_name = "GSE";
+	std::string profile_path = "";
+	double min_fill = 0;
+	std::vector<unsigned int> populations;
+	int opt;
+
+	while((opt = getopt(argc, argv, "he:p:r:l:s:g:")) != -1)
+	{
+		switch(opt)
+		{
+			case 'e':
+				plugin_name = optarg;
+				break;
+			case 'p':
+				profile_path = optarg;
+				break;
+			case 'r':
+				options.msymps = std::strtod(optarg, nullptr);
+				break;
+			case 'l':
+				options.load = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 's':
+				options.frames = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'g':
+				min_fill = std::strtod(optarg, nullptr);
+				break;
+			case 'h':
+			default:
+				ERROR(USAGE);
+				return EXIT_FAILURE;
+		}
+	}
+	for(int index = optind; index < argc; ++index)
+	{
+		populations.push_back(std::strtoul(argv[index], nullptr, 10));
+	}
+	if(populations.empty())
+	{
+		populations = {10, 50, 100, 250};
+	}
+	bool valid = options.msymps > 0 && options.load > 0 && options.frames > 0 &&
+	             populations.size() * configurations.size() < UINT8_MAX;
+	for(unsigned int terminals: populations)
+	{
+		// the terminal IDs are 8 bits long in the packets, the gateway
+		// and the broadcast IDs excluded
+		valid &= terminals > 0 && terminals <= UINT8_MAX - 1;
+	}
+	if(!valid)
+	{
+		ERROR(USAGE);
+		return EXIT_FAILURE;
+	}
+
+	auto output = Output::Get();
+	output->configureTerminalOutput();
+	BBFrame::bbframe_log = output->registerLog(LEVEL_WARNING, "Dvb.Net.BBFrame");
+	NetBurst::log_net_burst = output->registerLog(LEVEL_WARNING, "NetBurst");
+
+	// load the plugins and their configuration
+	auto Conf = OpenSandModelConf::Get();
+	Conf->createModels();
+	if(!Plugin::loadPlugins(false))
+	{
+		ERROR("cannot load the plugins\n");
+		return EXIT_FAILURE;
+	}
+	Ethernet::generateConfiguration();
+	Plugin::generatePluginsConfiguration(nullptr,
+	                                     PluginType::Encapsulation,
+	                                     "encapsulation_scheme",
+	                                     "Encapsulation Scheme");
+
+	bool temporary_profile = profile_path.empty();
+	if(temporary_profile)
+	{
+		char path[] = "/tmp/bench_scheduling_XXXXXX";
+		int fd = mkstemp(path);
+		if(fd < 0)
+		{
+			ERROR("cannot create the default profile\n");
+			return EXIT_FAILURE;
+		}
+		close(fd);
+		profile_path = path;
+		std::ofstream{profile_path} << default_profile;
+	}
+	bool profile_read = Conf->readProfile(profile_path);
+	if(temporary_profile)
+	{
+		unlink(profile_path.c_str());
+	}
+	if(!profile_read)
+	{
+		ERROR("cannot read the profile %s\n", profile_path.c_str());
+		return EXIT_FAILURE;
+	}
+	output->finalizeConfiguration();
+
+	Ethernet *lan = Ethernet::constructPlugin();
+	if(lan == nullptr)
+	{
+		ERROR("cannot initialize the Ethernet LAN adaptation\n");
+		return EXIT_FAILURE;
+	}
+	EncapPlugin *plugin = nullptr;
+	if(!Plugin::getEncapsulationPlugin(plugin_name, &plugin) || plugin == nullptr)
+	{
+		ERROR("cannot initialize the %s plugin\n", plugin_name.c_str());
+		return EXIT_FAILURE;
+	}
+	if(!plugin->getContext()->setUpperPacketHandler(lan->getPacketHandler()))
+	{
+		ERROR("%s does not support Ethernet as upper layer\n", plugin_name.c_str());
+		return EXIT_FAILURE;
+	}
+
+	std::vector<Data> traffic;
+	generateFrames(4096, traffic);
+
+	printf("%s packets, %.1f Msym/s carriers, %u%% load, %u frames of %u ms\n\n",
+	       plugin_name.c_str(), options.msymps, options.load, options.frames,
+	       frame_duration_ms);
+	printf("%6s %9s %8s %10s %8s %10s %10s\n",
+	       "config", "terminals", "bbf/frm", "kbbf/s", "fill (%)", "mean (us)", "p99 (us)");
+
+	bool within_limit = true;
+	spot_id_t spot = 0;
+	for(auto &&configuration: configurations)
+	{
+		for(unsigned int terminals: populations)
+		{
+			sched_result_t result;
+			if(!runConfiguration(++spot, configuration, terminals, options,
+			                     plugin, lan, traffic, result))
+			{
+				return EXIT_FAILURE;
+			}
+
+			uint64_t total_ns = 0;
+			for(auto &&time_ns: result.times_ns)
+			{
+				total_ns += time_ns;
+			}
+			std::sort(result.times_ns.begin(), result.times_ns.end());
+			const double p99_us = result.times_ns[result.times_ns.size() * 99 / 100] / 1000.0;
+			const double fill = result.capacity_bytes ?
+			                    100.0 * result.payload_bytes / result.capacity_bytes : 0;
+			printf("%6s %9u %8.1f %10.1f %8.1f %10.1f %10.1f\n",
+			       configuration.name, configuration.scpc ? 1 : terminals,
+			       static_cast<double>(result.bbframes) / options.frames,
+			       total_ns ? result.bbframes * 1e6 / total_ns : 0,
+			       fill, total_ns / 1000.0 / options.frames, p99_us);
+			if(min_fill > 0 && fill < min_fill)
+			{
+				within_limit = false;
+			}
+
+			// a single terminal emits with SCPC
+			if(configuration.scpc)
+			{
+				break;
+			}
+		}
+	}
+
+	if(!within_limit)
+	{
+		ERROR("\nthe BBFrames were filled at less than %.1f%%\n", min_fill);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,389 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * Differential test of the legacy DAMA controller
+ *
+ * The application feeds the same terminal population and the same
+ * randomised SAC requests to a reference controller and to DVB-RCS2
+ * Legacy DAMA controllers computing the allocations in sequence or
+ * sharding the carriers groups between several workers. The reference
+ * is the original full scan allocator (DamaCtrlRcs2Reference) when the
+ * RBDC requests are reduced in proportion, and the sequential Legacy
+ * controller with the weighted fair share it does not implement. The
+ * comparisons are run on several request sets. The terminals
+ * are spread between several categories of one carrier each, split
+ * between CRA only, RBDC and VBDC ones, a part of them change their
+ * MODCOD, and the capacity is congested so that the RBDC requests are
+ * reduced and the VBDC and FCA steps share the remaining capacity.
+ *
+ * The TTPs built on each superframe must be identical, byte per byte.
+ *
+ * Author: Viveris Technologies
+ */
+
+// OpenSAND includes
+#include "DamaCtrlRcs2Legacy.h"
+#include "DamaCtrlRcs2Reference.h"
+#include "TerminalContextDamaRcs.h"
+#include "FmtDefinitionTable.h"
+#include "FmtGroup.h"
+#include "StFmtSimu.h"
+#include "Logon.h"
+#include "Sac.h"
+#include "Ttp.h"
+
+#include <opensand_output/Output.h>
+
+// system includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+
+#define ERROR(format, ...) \
+	do { \
+		fprintf(stderr, format, ##__VA_ARGS__); \
+	} while(0)
+
+
+/// The superframe duration (ms)
+static const time_ms_t frame_duration_ms = 26;
+
+/// The RCS2 burst length (sym)
+static const vol_sym_t burst_length_sym = 536;
+
+/// The RBDC timeout (superframes)
+static const time_sf_t rbdc_timeout_sf = 16;
+
+/// The terminals capacity limits
+static const rate_kbps_t cra_kbps = 64;
+static const rate_kbps_t max_rbdc_kbps = 2048;
+static const vol_kb_t max_vbdc_kb = 512;
+static const rate_kbps_t fca_kbps = 128;
+
+/// The population, small enough for the capacity to be congested
+static const unsigned int terminals = 400;
+static const unsigned int categories_count = 4;
+static const double ksymps_per_terminal = 40;
+static const unsigned int superframes = 40;
+
+/// The share of terminals whose CNI changes each superframe (%)
+static const unsigned int cni_changes = 5;
+
+
+/**
+ * @brief The type of a synthetic terminal
+ */
+enum class TerminalType
+{
+	cra,
+	rbdc,
+	vbdc,
+};
+
+
+/**
+ * @brief Fill the DVB-RCS2 MODCOD definitions of 536 symbols bursts
+ *
+ * @param modcod_def  The MODCOD definitions table
+ */
+static void fillModcodDefinitions(FmtDefinitionTable &modcod_def)
+{
+	static const struct
+	{
+		unsigned int id;
+		const char *modulation;
+		const char *coding;
+		float efficiency;
+		double threshold;
+	} definitions[] = {
+		{3, "QPSK", "1/3", 0.56, 0.22},
+		{4, "QPSK", "1/2", 0.87, 2.34},
+		{5, "QPSK", "2/3", 1.26, 4.29},
+		{6, "QPSK", "3/4", 1.42, 5.36},
+		{7, "QPSK", "5/6", 1.60, 6.68},
+		{8, "8PSK", "2/3", 1.70, 8.08},
+		{9, "8PSK", "3/4", 1.93, 9.31},
+		{10, "8PSK", "5/6", 2.13, 10.82},
+		{11, "16QAM", "3/4", 2.59, 11.17},
+		{12, "16QAM", "5/6", 2.87, 12.56},
+	};
+	for(auto &&definition: definitions)
+	{
+		modcod_def.add(new FmtDefinition(definition.id,
+		                                 definition.modulation,
+		                                 definition.coding,
+		                                 definition.efficiency,
+		                                 definition.threshold,
+		                                 burst_length_sym));
+	}
+}
+
+
+/**
+ * @brief A DAMA controller and the context it is initialized with
+ */
+struct Controller
+{
+	Controller(const std::string &name):
+		modcod_def(),
+		fmt_group(),
+		input_sts(name),
+		categories(),
+		terminal_affectation(),
+		dama()
+	{
+	}
+
+	FmtDefinitionTable modcod_def;
+	std::unique_ptr<FmtGroup> fmt_group;
+	StFmtSimuList input_sts;
+	TerminalCategories<TerminalCategoryDama> categories;
+	TerminalMapping<TerminalCategoryDama> terminal_affectation;
+	std::unique_ptr<DamaCtrlRcs2> dama;
+};
+
+
+/**
+ * @brief Create a controller and log the population on
+ *
+ * @param controller  The controller context
+ * @param spot        The spot of the controller, distinct for each
+ *                    controller so that their probes do not conflict
+ * @param workers     The number of DAMA workers, 0 for the original
+ *                    full scan allocator
+ * @param fair_share  Whether the RBDC capacity is shared in weighted fair share
+ * @param tal_ids     The terminals ids
+ * @param types       The terminals types
+ * @return true on success, false otherwise
+ */
+static bool createController(Controller &controller, spot_id_t spot,
+                             unsigned int workers, bool fair_share,
+                             const std::vector<tal_id_t> &tal_ids,
+                             const std::vector<TerminalType> &types)
+{
+	fillModcodDefinitions(controller.modcod_def);
+	controller.fmt_group.reset(new FmtGroup(1, "3-12", &controller.modcod_def));
+
+	std::vector<TerminalCategoryDama *> all_categories;
+	const unsigned int per_category = terminals / categories_count;
+	for(unsigned int index = 0; index < categories_count; ++index)
+	{
+		auto category = new TerminalCategoryDama("Category" + std::to_string(index));
+		category->addCarriersGroup(index, controller.fmt_group.get(), 1,
+		                           per_category * ksymps_per_terminal * 1000,
+		                           AccessType::DAMA);
+		category->updateCarriersGroups(1, frame_duration_ms);
+		controller.categories[category->getLabel()] = category;
+		all_categories.push_back(category);
+	}
+
+	for(std::size_t index = 0; index < tal_ids.size(); ++index)
+	{
+		controller.terminal_affectation[tal_ids[index]] = all_categories[index % all_categories.size()];
+		controller.input_sts.addTerminal(tal_ids[index], controller.modcod_def.getMinId(),
+		                                 &controller.modcod_def);
+	}
+
+	if(workers == 0)
+	{
+		controller.dama.reset(new DamaCtrlRcs2Reference(spot));
+	}
+	else
+	{
+		controller.dama.reset(new DamaCtrlRcs2Legacy(spot, workers, fair_share));
+	}
+	if(!controller.dama->initParent(frame_duration_ms, rbdc_timeout_sf, fca_kbps,
+	                                controller.categories, controller.terminal_affectation,
+	                                all_categories.front(), &controller.input_sts,
+	                                &controller.modcod_def, false) ||
+	   !controller.dama->init(burst_length_sym))
+	{
+		ERROR("cannot initialize the DAMA controller of spot %u\n", spot);
+		return false;
+	}
+
+	for(std::size_t index = 0; index < tal_ids.size(); ++index)
+	{
+		const TerminalType type = types[index];
+		LogonRequest logon(tal_ids[index],
+		                   type == TerminalType::cra ? cra_kbps : 0,
+		                   type == TerminalType::rbdc ? max_rbdc_kbps : 0,
+		                   type == TerminalType::vbdc ? max_vbdc_kb : 0);
+		if(!controller.dama->hereIsLogon(&logon))
+		{
+			ERROR("cannot log terminal %u on\n", tal_ids[index]);
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/**
+ * @brief Compare the TTPs of a Legacy controller to the ones of the
+ *        reference controller on the same superframes
+ *
+ * @param seed        The seed of the terminals types and requests
+ * @param spot        The first spot of the controllers
+ * @param workers     The number of DAMA workers of the compared controller
+ * @param fair_share  Whether the RBDC capacity is shared in weighted fair share
+ * @return true if all the TTPs are identical, false otherwise
+ */
+static bool compareAllocations(unsigned int seed, spot_id_t spot,
+                               unsigned int workers, bool fair_share)
+{
+	std::mt19937 generator{seed};
+	std::discrete_distribution<int> type_distribution{20.0, 50.0, 30.0};
+	std::vector<tal_id_t> tal_ids;
+	std::vector<TerminalType> types;
+	for(unsigned int index = 0; index < terminals; ++index)
+	{
+		// after the broadcast id, so they have no per terminal probes
+		tal_ids.push_back(BROADCAST_TAL_ID + 1 + index);
+		types.push_back(static_cast<TerminalType>(type_distribution(generator)));
+	}
+
+	Controller reference("Reference");
+	Controller sharded("Sharded");
+	if(!createController(reference, spot, fair_share ? 1 : 0, fair_share, tal_ids, types) ||
+	   !createController(sharded, spot + 1, workers, fair_share, tal_ids, types))
+	{
+		return false;
+	}
+
+	std::uniform_real_distribution<double> cni_distribution(0.0, 14.0);
+	std::uniform_int_distribution<unsigned int> percent_distribution(0, 99);
+	std::uniform_int_distribution<uint32_t> rbdc_distribution(0, max_rbdc_kbps);
+	std::uniform_int_distribution<uint32_t> vbdc_distribution(0, max_vbdc_kb);
+	for(tal_id_t tal_id: tal_ids)
+	{
+		double cni = cni_distribution(generator);
+		reference.input_sts.setRequiredCni(tal_id, cni);
+		sharded.input_sts.setRequiredCni(tal_id, cni);
+	}
+
+	std::size_t ttp_bytes = 0;
+	for(time_sf_t superframe = 1; superframe <= superframes; ++superframe)
+	{
+		for(unsigned int index = 0; index < terminals; ++index)
+		{
+			if(percent_distribution(generator) < cni_changes)
+			{
+				double cni = cni_distribution(generator);
+				reference.input_sts.setRequiredCni(tal_ids[index], cni);
+				sharded.input_sts.setRequiredCni(tal_ids[index], cni);
+			}
+		}
+		reference.dama->updateRequiredFmts();
+		sharded.dama->updateRequiredFmts();
+
+		for(unsigned int index = 0; index < terminals; ++index)
+		{
+			if(types[index] == TerminalType::cra)
+			{
+				continue;
+			}
+			Sac sac(tal_ids[index]);
+			if(types[index] == TerminalType::rbdc)
+			{
+				sac.addRequest(0, ReturnAccessType::dama_rbdc, rbdc_distribution(generator));
+			}
+			else
+			{
+				sac.addRequest(0, ReturnAccessType::dama_vbdc, vbdc_distribution(generator));
+			}
+			if(!reference.dama->hereIsSAC(&sac) || !sharded.dama->hereIsSAC(&sac))
+			{
+				ERROR("cannot handle the SAC of terminal %u\n", tal_ids[index]);
+				return false;
+			}
+		}
+
+		reference.dama->runOnSuperFrameChange(superframe);
+		sharded.dama->runOnSuperFrameChange(superframe);
+		Ttp reference_ttp(0, superframe);
+		Ttp sharded_ttp(0, superframe);
+		if(!reference.dama->buildTTP(&reference_ttp) ||
+		   !sharded.dama->buildTTP(&sharded_ttp))
+		{
+			ERROR("cannot build the TTPs of superframe %u\n", superframe);
+			return false;
+		}
+		if(reference_ttp.getTotalLength() != sharded_ttp.getTotalLength() ||
+		   memcmp(reference_ttp.getRawData(), sharded_ttp.getRawData(),
+		          reference_ttp.getTotalLength()) != 0)
+		{
+			ERROR("seed %u, %u workers, %s RBDC share: TTP of superframe %u "
+			      "differs from the reference allocation\n", seed, workers,
+			      fair_share ? "weighted fair" : "proportional", superframe);
+			return false;
+		}
+		ttp_bytes += reference_ttp.getTotalLength();
+	}
+
+	printf("seed %u, %u workers, %s RBDC share: %u identical TTPs (%zu bytes)\n",
+	       seed, workers, fair_share ? "weighted fair" : "proportional",
+	       superframes, ttp_bytes);
+	return true;
+}
+
+
+int main()
+{
+	auto output = Output::Get();
+	output->configureTerminalOutput();
+	Sac::sac_log = output->registerLog(LEVEL_WARNING, "Dvb.SAC");
+	Ttp::ttp_log = output->registerLog(LEVEL_WARNING, "Dvb.TTP");
+	output->finalizeConfiguration();
+
+	bool success = true;
+	spot_id_t spot = 1;
+	for(unsigned int seed: {terminals, 1U, 2U})
+	{
+		// the sequential controller is checked against the full scan one
+		// before it is the reference of the weighted fair share
+		for(unsigned int workers: {1, 2, 4})
+		{
+			success &= compareAllocations(seed, spot, workers, false);
+			spot += 2;
+		}
+		for(unsigned int workers: {2, 4})
+		{
+			success &= compareAllocations(seed, spot, workers, true);
+			spot += 2;
+		}
+	}
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
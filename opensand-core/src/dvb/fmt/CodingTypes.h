@@ -35,18 +35,61 @@
 #ifndef CODING_TYPES_H
 #define CODING_TYPES_H
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <map>
+#include <string_view>
+#include <vector>
+
+
+/// The codings of DVB-S2 and DVB-RCS2, indexes of the catalogue
+enum class coding_id_t : uint8_t
+{
+	rate_1_4,
+	rate_1_3,
+	rate_2_5,
+	rate_1_2,
+	rate_3_5,
+	rate_2_3,
+	rate_3_4,
+	rate_4_5,
+	rate_5_6,
+	rate_6_7,
+	rate_8_9,
+	rate_9_10,
+	unknown,
+};
 
 
 /**
  * @class CodingTypes
- * @brief The coding types
+ * @brief The catalogue of the coding types, resolved at compile time
+ *
+ * The labels are only converted when the FMT definitions are read,
+ * the identifiers are used everywhere else.
  */
 class CodingTypes
 {
 public:
-	~CodingTypes();
+	/**
+	 * @brief Get the identifier of a coding
+	 *
+	 * @param coding_label  The coding label
+	 *
+	 * @return  The coding identifier, unknown if the label is not managed
+	 */
+	static constexpr coding_id_t getId(std::string_view coding_label)
+	{
+		for(std::size_t index = 0; index < catalogue.size(); ++index)
+		{
+			if(catalogue[index].label == coding_label)
+			{
+				return static_cast<coding_id_t>(index);
+			}
+		}
+		return coding_id_t::unknown;
+	}
 
 	/**
 	 * @brief Check a coding exists
@@ -55,30 +98,115 @@ public:
 	 *
 	 * @return  True if the label is managed, false otherwise
 	 */
-	static bool exist(std::string coding_label);
+	static constexpr bool exist(std::string_view coding_label)
+	{
+		return getId(coding_label) != coding_id_t::unknown;
+	}
 
 	/**
 	 * @brief Get the default coding rate
 	 *
 	 * @return  The default coding rate
 	 */
-	static float getDefaultRate();
+	static constexpr float getDefaultRate()
+	{
+		return 1;
+	}
+
+	/**
+	 * @brief Get a coding rate
+	 *
+	 * @param coding_id  The coding identifier
+	 *
+	 * @return  The coding rate, the default one for an unknown coding
+	 */
+	static constexpr float getRate(coding_id_t coding_id)
+	{
+		return coding_id < coding_id_t::unknown ?
+		       catalogue[static_cast<std::size_t>(coding_id)].rate :
+		       getDefaultRate();
+	}
 
 	/**
 	 * @brief Get a coding rate
 	 *
 	 * @param coding_label  The coding label
 	 *
-	 * @return  The coding rate
+	 * @return  The coding rate, the default one for an unknown label
+	 */
+	static constexpr float getRate(std::string_view coding_label)
+	{
+		return getRate(getId(coding_label));
+	}
+
+	/**
+	 * @brief Get the default BBFrame payload size, the size of a normal FECFRAME
+	 *
+	 * @return  The default payload size in bytes
+	 */
+	static constexpr std::size_t getDefaultPayloadSize()
+	{
+		return 8100;
+	}
+
+	/**
+	 * @brief Get the payload size of a normal BBFrame
+	 *        (see ETSI EN 302 307 v1.2.1 Table 5a)
+	 *
+	 * @param coding_id  The coding identifier
+	 *
+	 * @return  The payload size in bytes, the default one for a coding
+	 *          without normal FECFRAME
+	 */
+	static constexpr std::size_t getPayloadSize(coding_id_t coding_id)
+	{
+		return coding_id < coding_id_t::unknown ?
+		       catalogue[static_cast<std::size_t>(coding_id)].payload_size :
+		       getDefaultPayloadSize();
+	}
+
+	/**
+	 * @brief Get the labels of the managed codings, in the catalogue order
+	 *
+	 * @return  The coding labels
 	 */
-	static float getRate(std::string coding_label);
+	static std::vector<std::string> getLabels()
+	{
+		std::vector<std::string> labels;
+		for(auto &&coding : catalogue)
+		{
+			labels.emplace_back(coding.label);
+		}
+		return labels;
+	}
 
 private:
-	float default_coding_rate;
-	std::map<std::string, float> coding_rates;
+	struct coding_t
+	{
+		std::string_view label;
+		float rate;
+		std::size_t payload_size;
+	};
 
-	CodingTypes();
+	/// The codings, indexed by identifier (keep the coding_id_t order)
+	static constexpr std::array<coding_t, static_cast<std::size_t>(coding_id_t::unknown)> catalogue{{
+		{"1/4",  1.0 / 4.0,  2001},  // rate_1_4
+		{"1/3",  1.0 / 3.0,  2676},  // rate_1_3
+		{"2/5",  2.0 / 5.0,  3216},  // rate_2_5
+		{"1/2",  1.0 / 2.0,  4026},  // rate_1_2
+		{"3/5",  3.0 / 5.0,  4836},  // rate_3_5
+		{"2/3",  2.0 / 3.0,  5380},  // rate_2_3
+		{"3/4",  3.0 / 4.0,  6051},  // rate_3_4
+		{"4/5",  4.0 / 5.0,  6456},  // rate_4_5
+		{"5/6",  5.0 / 6.0,  6730},  // rate_5_6
+		{"6/7",  6.0 / 7.0,  8100},  // rate_6_7, no DVB-S2 FECFRAME
+		{"8/9",  8.0 / 9.0,  7184},  // rate_8_9
+		{"9/10", 9.0 / 10.0, 7274},  // rate_9_10
+	}};
 };
 
-#endif
+static_assert(CodingTypes::getPayloadSize(CodingTypes::getId("9/10")) == 7274 &&
+              CodingTypes::getRate(coding_id_t::rate_9_10) == CodingTypes::getRate("9/10"),
+              "the codings catalogue is not indexed by identifier");
 
+#endif
@@ -34,8 +34,6 @@
  */
 
 #include "FmtDefinition.h"
-#include "ModulationTypes.h"
-#include "CodingTypes.h"
 
 #include <opensand_output/Output.h>
 
@@ -63,11 +61,7 @@ FmtDefinition::FmtDefinition(const unsigned int id,
 	has_burst_length(true),
 	burst_length_sym(burst_length)
 {
-	this->modulation_efficiency =
-		ModulationTypes::getEfficiency(this->modulation_type);
-
-	this->coding_rate =
-		CodingTypes::getRate(this->coding_type);
+	this->resolveTypes();
 }
 
 /**
@@ -92,25 +86,41 @@ FmtDefinition::FmtDefinition(const unsigned int id,
 	has_burst_length(false),
 	burst_length_sym(0)
 {
-	this->modulation_efficiency =
-		ModulationTypes::getEfficiency(this->modulation_type);
-
-	this->coding_rate =
-		CodingTypes::getRate(this->coding_type);
+	this->resolveTypes();
 }
 
 FmtDefinition::FmtDefinition(const FmtDefinition &fmt_def)
 {
 	this->id = fmt_def.id;
 	this->modulation_type = fmt_def.modulation_type;
+	this->modulation_id = fmt_def.modulation_id;
 	this->modulation_efficiency = fmt_def.modulation_efficiency;
+	this->modulation_efficiency_inv = fmt_def.modulation_efficiency_inv;
 	this->coding_type = fmt_def.coding_type;
+	this->coding_id = fmt_def.coding_id;
 	this->coding_rate = fmt_def.coding_rate;
+	this->coding_rate_inv = fmt_def.coding_rate_inv;
 	this->spectral_efficiency = fmt_def.spectral_efficiency;
 	this->required_Es_N0 = fmt_def.required_Es_N0;
+	this->has_burst_length = fmt_def.has_burst_length;
 	this->burst_length_sym = fmt_def.burst_length_sym;
 }
 
+/**
+ * @brief Resolve the modulation and coding labels in the catalogues,
+ *        once for all the conversions
+ */
+void FmtDefinition::resolveTypes()
+{
+	this->modulation_id = ModulationTypes::getId(this->modulation_type);
+	this->modulation_efficiency = ModulationTypes::getEfficiency(this->modulation_id);
+	this->modulation_efficiency_inv = 1.0 / this->modulation_efficiency;
+
+	this->coding_id = CodingTypes::getId(this->coding_type);
+	this->coding_rate = CodingTypes::getRate(this->coding_id);
+	this->coding_rate_inv = 1.0 / this->coding_rate;
+}
+
 /**
  * @brief Destroy a FMT definition
  */
@@ -140,6 +150,16 @@ std::string FmtDefinition::getModulation() const
 	return this->modulation_type;
 }
 
+/**
+ * @brief Get the modulation identifier of the FMT definition
+ *
+ * @return  the identifier of modulation of the FMT, unknown if not managed
+ */
+modulation_id_t FmtDefinition::getModulationId() const
+{
+	return this->modulation_id;
+}
+
 /**
  * @brief Get the modulation efficiency of the FMT definition
  *
@@ -160,6 +180,16 @@ std::string FmtDefinition::getCoding() const
 	return this->coding_type;
 }
 
+/**
+ * @brief Get the coding identifier of the FMT definition
+ *
+ * @return  the identifier of coding of the FMT, unknown if not managed
+ */
+coding_id_t FmtDefinition::getCodingId() const
+{
+	return this->coding_id;
+}
+
 /**
  * @brief Get the coding rate of the FMT definition
  *
@@ -170,6 +200,16 @@ float FmtDefinition::getCodingRate() const
 	return this->coding_rate;
 }
 
+/**
+ * @brief Get the payload size of a BBFrame with the coding of the FMT definition
+ *
+ * @return  the payload size in bytes
+ */
+std::size_t FmtDefinition::getPayloadSize() const
+{
+	return CodingTypes::getPayloadSize(this->coding_id);
+}
+
 /**
  * @brief Get the spectral efficiency of the FMT definition
  *
@@ -38,6 +38,9 @@
 #define FMT_DEFINITION_H
 
 #include "OpenSandCore.h"
+#include "ModulationTypes.h"
+#include "CodingTypes.h"
+
 #include <string>
 
 
@@ -54,6 +57,9 @@ protected:
 	/** The modulation type of the FMT definition */
 	std::string modulation_type;
 
+	/** The modulation identifier of the FMT definition */
+	modulation_id_t modulation_id;
+
 	/** The modulation efficiency of the FMT definition */
 	unsigned int modulation_efficiency;
 
@@ -63,6 +69,9 @@ protected:
 	/** The coding type of the FMT definition */
 	std::string coding_type;
 
+	/** The coding identifier of the FMT definition */
+	coding_id_t coding_id;
+
 	/** The coding rate of the FMT definition */
 	float coding_rate;
 
@@ -110,15 +119,24 @@ public:
 	/* get the modulation type of the FMT definition */
 	std::string getModulation() const;
 
+	/* get the modulation identifier of the FMT definition */
+	modulation_id_t getModulationId() const;
+
 	/* get the modulation efficiency of the FMT definition */
 	unsigned int getModulationEfficiency() const;
 
 	/* get the coding type of the FMT definition */
 	std::string getCoding() const;
 
+	/* get the coding identifier of the FMT definition */
+	coding_id_t getCodingId() const;
+
 	/* get the coding rate of the FMT definition */
 	float getCodingRate() const;
 
+	/* get the payload size of a BBFrame with the coding of the FMT definition */
+	std::size_t getPayloadSize() const;
+
 	/* get the spectral efficiency of the FMT definition */
 	float getSpectralEfficiency() const;
 
@@ -145,6 +163,10 @@ public:
 
 	virtual void print(void) const; /// For debug
 
+private:
+	/* resolve the modulation and coding labels */
+	void resolveTypes();
+
 };
 
 #endif
@@ -40,6 +40,7 @@
 
 #include <opensand_output/Output.h>
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -68,7 +69,9 @@ inline bool isSpace(std::string str)
  * @brief Create a table of FMT definitions
  */
 FmtDefinitionTable::FmtDefinitionTable():
-	definitions()
+	definitions(),
+	definitions_by_id(),
+	required_esn0()
 {
 	// Output Log
 	this->log_fmt = Output::Get()->registerLog(LEVEL_WARNING, "Dvb.Fmt.DefinitionTable");
@@ -93,13 +96,26 @@ bool FmtDefinitionTable::add(FmtDefinition *fmt_def)
 		return false;
 	}
 
-	this->definitions[fmt_def->getId()] = fmt_def;
+	fmt_id_t id = fmt_def->getId();
+	this->definitions[id] = fmt_def;
+
+	if(this->definitions_by_id.size() <= id)
+	{
+		this->definitions_by_id.resize(id + 1, NULL);
+	}
+	this->definitions_by_id[id] = fmt_def;
+
+	std::pair<double, fmt_id_t> threshold(fmt_def->getRequiredEsN0(), id);
+	this->required_esn0.insert(std::upper_bound(this->required_esn0.begin(),
+	                                            this->required_esn0.end(),
+	                                            threshold),
+	                           threshold);
 	return true;
 }
 
 bool FmtDefinitionTable::doFmtIdExist(fmt_id_t id) const
 {
-	return (this->definitions.find(id) != this->definitions.end());
+	return this->getDefinition(id) != NULL;
 }
 
 
@@ -113,10 +129,12 @@ void FmtDefinitionTable::clear()
 
 	// now clear the map itself
 	this->definitions.clear();
+	this->definitions_by_id.clear();
+	this->required_esn0.clear();
 }
 
 
-std::map<fmt_id_t, FmtDefinition* > FmtDefinitionTable::getDefinitions(void) const
+const std::map<fmt_id_t, FmtDefinition* > &FmtDefinitionTable::getDefinitions(void) const
 {
 	return this->definitions;
 }
@@ -200,28 +218,23 @@ vol_sym_t FmtDefinitionTable::getBurstLength(fmt_id_t id) const
 fmt_id_t FmtDefinitionTable::getRequiredModcod(double cni) const
 {
 	fmt_id_t modcod_id = 0;
-	double current_cni;
-	double previous_cni = 0.0;
-	if(this->definitions.begin() != this->definitions.end())
-	{
-		previous_cni = this->definitions.begin()->second->getRequiredEsN0();
-	}
-	fmt_def_table_pos_t it;
 
-	for(it = this->definitions.begin(); it != this->definitions.end(); it++)
+	// the best MODCOD is the one with the highest supported Es/N0 ratio,
+	// the highest ID among those with the same ratio, and MODCODs less
+	// robust than the lowest ID are not considered
+	auto best = std::upper_bound(this->required_esn0.begin(),
+	                             this->required_esn0.end(),
+	                             cni,
+	                             [](double value, const std::pair<double, fmt_id_t> &threshold)
+	                             {
+	                               return value < threshold.first;
+	                             });
+	if(best != this->required_esn0.begin())
 	{
-		current_cni = (*it).second->getRequiredEsN0();
-		if(current_cni > cni)
-		{
-			// not supported
-			continue;
-		}
-		// here we have a supported Es/N0 value check if it is better than the
-		// previous one
-		if(current_cni >= previous_cni)
+		--best;
+		if(best->first >= this->definitions.begin()->second->getRequiredEsN0())
 		{
-			previous_cni = current_cni;
-			modcod_id = (*it).first;
+			modcod_id = best->second;
 		}
 	}
 	if(modcod_id <= 0)
@@ -235,56 +248,30 @@ fmt_id_t FmtDefinitionTable::getRequiredModcod(double cni) const
 
 FmtDefinition *FmtDefinitionTable::getDefinition(fmt_id_t id) const
 {
-	fmt_def_table_pos_t it;
-	FmtDefinition *def = NULL;
-
-	it = this->definitions.find(id);
-	if(it != this->definitions.end())
+	if(id >= this->definitions_by_id.size())
 	{
-		def = it->second;
+		return NULL;
 	}
-
-	return def;
+	return this->definitions_by_id[id];
 }
 
 fmt_id_t FmtDefinitionTable::getMinId() const
 {
-	fmt_def_table_pos_t it = this->definitions.begin();
-	fmt_id_t id;
-	if(this->definitions.size() <= 0)
-	{
-		return 0;	
-	}
-	id = (*it).first;
-	++it;
-	for(; it != this->definitions.end(); ++it)
+	if(this->definitions.empty())
 	{
-		if((*it).first < id)
-		{
-			id = (*it).first;
-		}
+		return 0;
 	}
-	return id;
+	// the map is sorted by ID
+	return this->definitions.begin()->first;
 }
 
 fmt_id_t FmtDefinitionTable::getMaxId() const
 {
-	fmt_def_table_pos_t it = this->definitions.begin();
-	fmt_id_t id;
-	if(this->definitions.size() <= 0)
+	if(this->definitions.empty())
 	{
-		return 0;	
-	}
-	id = (*it).first;
-	++it;
-	for(; it != this->definitions.end(); ++it)
-	{
-		if((*it).first > id)
-		{
-			id = (*it).first;
-		}
+		return 0;
 	}
-	return id;
+	return this->definitions.rbegin()->first;
 }
 
 vol_kb_t FmtDefinitionTable::symToKbits(fmt_id_t id,
@@ -43,6 +43,8 @@
 #include <opensand_output/OutputLog.h>
 
 #include <map>
+#include <utility>
+#include <vector>
 
 
 typedef std::map<fmt_id_t, FmtDefinition *>::const_iterator fmt_def_table_pos_t;
@@ -57,6 +59,13 @@ private:
 	/** The internal map that stores all the FMT definitions */
 	std::map<fmt_id_t, FmtDefinition *> definitions;
 
+	/** The FMT definitions indexed by ID, NULL for the unused IDs */
+	std::vector<FmtDefinition *> definitions_by_id;
+
+	/** The required Es/N0 ratios and IDs of the FMT definitions
+	 *  sorted by Es/N0 then by ID */
+	std::vector<std::pair<double, fmt_id_t>> required_esn0;
+
 protected:
 	// Output Log
 	std::shared_ptr<OutputLog> log_fmt;
@@ -100,7 +109,7 @@ public:
 	 *
 	 * @return    definitions
 	 */
-	std::map<fmt_id_t, FmtDefinition* > getDefinitions(void) const;
+	const std::map<fmt_id_t, FmtDefinition* > &getDefinitions(void) const;
 
 	/**
 	 * @brief Get a FMT definition in the table
@@ -35,18 +35,55 @@
 #ifndef MODULATION_TYPES_H
 #define MODULATION_TYPES_H
 
+#include <array>
+#include <cstdint>
 #include <string>
-#include <map>
+#include <string_view>
+#include <vector>
+
+
+/// The modulations of DVB-S2 and DVB-RCS2, indexes of the catalogue
+enum class modulation_id_t : uint8_t
+{
+	bpsk,
+	pi2_bpsk,
+	qpsk,
+	psk8,
+	apsk16,
+	qam16,
+	apsk32,
+	unknown,
+};
 
 
 /**
  * @class ModulationTypes
- * @brief The modulation types
+ * @brief The catalogue of the modulation types, resolved at compile time
+ *
+ * The labels are only converted when the FMT definitions are read,
+ * the identifiers are used everywhere else.
  */
 class ModulationTypes
 {
 public:
-	~ModulationTypes();
+	/**
+	 * @brief Get the identifier of a modulation
+	 *
+	 * @param modulation_label  The modulation label
+	 *
+	 * @return  The modulation identifier, unknown if the label is not managed
+	 */
+	static constexpr modulation_id_t getId(std::string_view modulation_label)
+	{
+		for(std::size_t index = 0; index < catalogue.size(); ++index)
+		{
+			if(catalogue[index].label == modulation_label)
+			{
+				return static_cast<modulation_id_t>(index);
+			}
+		}
+		return modulation_id_t::unknown;
+	}
 
 	/**
 	 * @brief Check a modulation exists
@@ -55,30 +92,83 @@ public:
 	 *
 	 * @return  True if the label is managed, false otherwise
 	 */
-	static bool exist(std::string modulation_label);
+	static constexpr bool exist(std::string_view modulation_label)
+	{
+		return getId(modulation_label) != modulation_id_t::unknown;
+	}
 
 	/**
 	 * @brief Get the default modulation efficiency
 	 *
 	 * @return  The default modulation effiency
 	 */
-	static unsigned int getDefaultEfficiency();
+	static constexpr unsigned int getDefaultEfficiency()
+	{
+		return 1;
+	}
+
+	/**
+	 * @brief Get a modulation efficiency
+	 *
+	 * @param modulation_id  The modulation identifier
+	 *
+	 * @return  The modulation effiency, the default one for an unknown modulation
+	 */
+	static constexpr unsigned int getEfficiency(modulation_id_t modulation_id)
+	{
+		return modulation_id < modulation_id_t::unknown ?
+		       catalogue[static_cast<std::size_t>(modulation_id)].efficiency :
+		       getDefaultEfficiency();
+	}
 
 	/**
 	 * @brief Get a modulation efficiency
 	 *
 	 * @param modulation_label  The modulation label
 	 *
-	 * @return  The modulation effiency
+	 * @return  The modulation effiency, the default one for an unknown label
 	 */
-	static unsigned int getEfficiency(std::string modulation_label);
+	static constexpr unsigned int getEfficiency(std::string_view modulation_label)
+	{
+		return getEfficiency(getId(modulation_label));
+	}
+
+	/**
+	 * @brief Get the labels of the managed modulations, in the catalogue order
+	 *
+	 * @return  The modulation labels
+	 */
+	static std::vector<std::string> getLabels()
+	{
+		std::vector<std::string> labels;
+		for(auto &&modulation : catalogue)
+		{
+			labels.emplace_back(modulation.label);
+		}
+		return labels;
+	}
 
 private:
-	unsigned int default_modulation_efficiency;
-	std::map<std::string, unsigned int> modulation_efficiencies;
+	struct modulation_t
+	{
+		std::string_view label;
+		unsigned int efficiency;
+	};
 
-	ModulationTypes();
+	/// The modulations, indexed by identifier (keep the modulation_id_t order)
+	static constexpr std::array<modulation_t, static_cast<std::size_t>(modulation_id_t::unknown)> catalogue{{
+		{"BPSK",     1},  // bpsk
+		{"Pi/2BPSK", 1},  // pi2_bpsk
+		{"QPSK",     2},  // qpsk
+		{"8PSK",     3},  // psk8
+		{"16APSK",   4},  // apsk16
+		{"16QAM",    4},  // qam16
+		{"32APSK",   5},  // apsk32
+	}};
 };
 
-#endif
+static_assert(ModulationTypes::getEfficiency("32APSK") == 5 &&
+              ModulationTypes::getEfficiency(modulation_id_t::apsk32) == 5,
+              "the modulations catalogue is not indexed by identifier");
 
+#endif
@@ -158,11 +158,74 @@ bool StFmtSimu::getCniHasChanged()
 ////////////////////////////////////////////////////////////////////////////////
 
 
+StFmtCniBatch::StFmtCniBatch():
+	updates{},
+	positions{}
+{
+}
+
+void StFmtCniBatch::set(tal_id_t st_id, double cni)
+{
+	if(st_id >= this->positions.size())
+	{
+		this->positions.resize(st_id + 1, 0);
+	}
+	std::size_t &position = this->positions[st_id];
+	if(position == 0)
+	{
+		this->updates.emplace_back(st_id, cni);
+		position = this->updates.size();
+	}
+	else
+	{
+		this->updates[position - 1].second = cni;
+	}
+}
+
+void StFmtCniBatch::unset(tal_id_t st_id)
+{
+	if(st_id >= this->positions.size() || this->positions[st_id] == 0)
+	{
+		return;
+	}
+	// move the last update in place of the removed one
+	std::size_t position = this->positions[st_id];
+	this->positions[st_id] = 0;
+	if(position != this->updates.size())
+	{
+		this->updates[position - 1] = this->updates.back();
+		this->positions[this->updates.back().first] = position;
+	}
+	this->updates.pop_back();
+}
+
+bool StFmtCniBatch::empty() const
+{
+	return this->updates.empty();
+}
+
+void StFmtCniBatch::clear()
+{
+	for(auto &&update: this->updates)
+	{
+		this->positions[update.first] = 0;
+	}
+	this->updates.clear();
+}
+
+const std::vector<std::pair<tal_id_t, double>> &StFmtCniBatch::getUpdates() const
+{
+	return this->updates;
+}
+
+
 StFmtSimuList::StFmtSimuList(std::string name):
 	name{name},
 	sts{nullptr},
 	acm_loop_margin_db{0.0},
-	sts_mutex{}
+	changed_sts{},
+	is_changed{},
+	sts_mutex{"fmt.sts"}
 {
 	// Output Log
 	this->log_fmt = Output::Get()->registerLog(LEVEL_WARNING,
@@ -216,6 +279,7 @@ bool StFmtSimuList::addTerminal(tal_id_t st_id, fmt_id_t init_modcod,
 	// insert it
 	this->sts->insert(std::make_pair(st_id, new_st));
 	this->insert(st_id);
+	this->markChanged(st_id);
 
 	return true;
 }
@@ -256,7 +320,46 @@ void StFmtSimuList::setRequiredCni(tal_id_t st_id, double cni)
 	LOG(this->log_fmt, LEVEL_INFO,
 	    "set required CNI %.2f for ST%u\n", cni, st_id);
 
-	st_iter->second->updateCni(cni, this->acm_loop_margin_db);
+	StFmtSimu *st = st_iter->second;
+	fmt_id_t previous_modcod_id = st->getCurrentModcodId();
+	st->updateCni(cni, this->acm_loop_margin_db);
+	if(st->getCurrentModcodId() != previous_modcod_id)
+	{
+		this->markChanged(st_id);
+	}
+}
+
+void StFmtSimuList::setRequiredCni(StFmtCniBatch &batch)
+{
+	if(batch.empty())
+	{
+		return;
+	}
+
+	RtLock lock(this->sts_mutex);
+
+	for(auto &&update: batch.getUpdates())
+	{
+		tal_id_t st_id = update.first;
+		auto st_iter = this->sts->find(st_id);
+		if(st_iter == this->sts->end())
+		{
+			LOG(this->log_fmt, LEVEL_ERROR,
+			    "ST%u not found, cannot set required CNI\n", st_id);
+			continue;
+		}
+		LOG(this->log_fmt, LEVEL_INFO,
+		    "set required CNI %.2f for ST%u\n", update.second, st_id);
+
+		StFmtSimu *st = st_iter->second;
+		fmt_id_t previous_modcod_id = st->getCurrentModcodId();
+		st->updateCni(update.second, this->acm_loop_margin_db);
+		if(st->getCurrentModcodId() != previous_modcod_id)
+		{
+			this->markChanged(st_id);
+		}
+	}
+	batch.clear();
 }
 
 double StFmtSimuList::getRequiredCni(tal_id_t st_id) const
@@ -308,7 +411,44 @@ bool StFmtSimuList::getCniHasChanged(tal_id_t st_id)
 bool StFmtSimuList::isStPresent(tal_id_t st_id) const
 {
 	RtLock lock(this->sts_mutex);
-	return std::find(this->begin(), this->end(), st_id) != this->end();
+	return this->sts->find(st_id) != this->sts->end();
+}
+
+void StFmtSimuList::markChanged(tal_id_t st_id)
+{
+	if(st_id >= this->is_changed.size())
+	{
+		this->is_changed.resize(st_id + 1, false);
+	}
+	if(!this->is_changed[st_id])
+	{
+		this->is_changed[st_id] = true;
+		this->changed_sts.push_back(st_id);
+	}
+}
+
+void StFmtSimuList::popChangedTerminals(std::vector<tal_id_t> &st_ids)
+{
+	RtLock lock(this->sts_mutex);
+
+	st_ids.clear();
+	st_ids.swap(this->changed_sts);
+	for(tal_id_t st_id : st_ids)
+	{
+		this->is_changed[st_id] = false;
+	}
+}
+
+void StFmtSimuList::getCurrentModcodIds(std::vector<std::pair<tal_id_t, fmt_id_t>> &modcod_ids) const
+{
+	RtLock lock(this->sts_mutex);
+
+	modcod_ids.clear();
+	for(auto&& st_iterator : *this->sts)
+	{
+		modcod_ids.emplace_back(st_iterator.first,
+		                        st_iterator.second->getCurrentModcodId());
+	}
 }
 
 tal_id_t StFmtSimuList::getTalIdWithLowerModcod() const
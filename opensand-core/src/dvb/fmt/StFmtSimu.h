@@ -41,6 +41,7 @@
 
 #include <OpenSandCore.h>
 #include <FmtDefinitionTable.h>
+#include <TerminalMap.h>
 
 #include <opensand_rt/RtMutex.h>
 #include <opensand_output/Output.h>
@@ -49,6 +50,7 @@
 
 #include <map>
 #include <set>
+#include <vector>
 
 
 /**
@@ -174,6 +176,56 @@ private:
 
 
 
+/**
+ * @class StFmtCniBatch
+ * @brief The latest CNI of each terminal received within a window,
+ *        applied at once to a list of terminals
+ */
+class StFmtCniBatch
+{
+public:
+	StFmtCniBatch();
+
+	/**
+	 * @brief Set the CNI of a terminal, replacing the one already
+	 *        set in the window
+	 *
+	 * @param st_id  The terminal ID
+	 * @param cni    The CNI value
+	 */
+	void set(tal_id_t st_id, double cni);
+
+	/**
+	 * @brief Forget the CNI of a terminal set in the window
+	 *
+	 * @param st_id  The terminal ID
+	 */
+	void unset(tal_id_t st_id);
+
+	/**
+	 * @brief Whether no CNI was set in the window
+	 */
+	bool empty() const;
+
+	/**
+	 * @brief Forget all the CNI set in the window
+	 */
+	void clear();
+
+	/**
+	 * @brief Get the CNI set in the window, one per terminal
+	 */
+	const std::vector<std::pair<tal_id_t, double>> &getUpdates() const;
+
+private:
+	/** The CNI updates of the window, one per terminal */
+	std::vector<std::pair<tal_id_t, double>> updates;
+
+	/** The position + 1 of the update of each terminal, 0 if none */
+	std::vector<std::size_t> positions;
+};
+
+
 /**
  * @class StFmtSimuList
  *        The class is also a list of registered terminal IDs
@@ -182,7 +234,7 @@ private:
 class StFmtSimuList: public std::set<tal_id_t>
 {
 private:
-	typedef std::map<tal_id_t, StFmtSimu *> ListStFmt;
+	typedef TerminalMap<StFmtSimu *> ListStFmt;
 
 	/** A name to know is this is input or output terminals */
 	std::string name;
@@ -196,10 +248,24 @@ private:
 	// Output Log
 	std::shared_ptr<OutputLog> log_fmt;
 
+	/** The terminals whose MODCOD changed since they were last popped */
+	std::vector<tal_id_t> changed_sts;
+
+	/** Whether a terminal is in changed_sts, indexed by terminal ID */
+	std::vector<bool> is_changed;
+
 	/** a list which associate a st id with its spot id */
 	/** the mutex to protect the list from concurrent access */
 	mutable RtMutex sts_mutex;
 
+	/**
+	 * @brief  Record that the MODCOD of a terminal changed,
+	 *         the mutex shall be locked
+	 *
+	 * @param  st_id  the id of the terminal
+	 */
+	void markChanged(tal_id_t st_id);
+
 public:
 	/// Constructor and destructor
 	StFmtSimuList(std::string name);
@@ -239,6 +305,14 @@ public:
 	 */
 	void setRequiredCni(tal_id_t st_id, double cni);
 
+	/**
+	 * @brief Set the CNI of the terminals of a batch under a single
+	 *        lock, then clear the batch
+	 *
+	 * @param batch  The CNI batch
+	 */
+	void setRequiredCni(StFmtCniBatch &batch);
+
 	/**
 	 * @brief Get the required CNI of a terminal
 	 *
@@ -271,6 +345,22 @@ public:
 	 */
 	bool isStPresent(tal_id_t st_id) const;
 
+	/**
+	 * @brief  Get the terminals whose MODCOD changed or that were added
+	 *         since the last call
+	 *
+	 * @param  st_ids  OUT: the terminal IDs, the previous content is dropped
+	 */
+	void popChangedTerminals(std::vector<tal_id_t> &st_ids);
+
+	/**
+	 * @brief  Get the current MODCOD ID of all the terminals at once
+	 *
+	 * @param  modcod_ids  OUT: the terminal IDs with their MODCOD ID sorted
+	 *                     by terminal ID, the previous content is dropped
+	 */
+	void getCurrentModcodIds(std::vector<std::pair<tal_id_t, fmt_id_t>> &modcod_ids) const;
+
 	/**
 	 * @brief  get the terminal ID with the lowest MODCOD id in the list
 	 *
@@ -160,3 +160,26 @@ close_socket:
 error:
 	return false;
 }
+
+
+char *NccInterface::nextLine(char *&pos, char *end)
+{
+	char *line = pos;
+	char *eol;
+
+	if(pos >= end || *pos == '\0')
+	{
+		return NULL;
+	}
+
+	eol = static_cast<char *>(memchr(pos, '\n', end - pos));
+	if(eol == NULL)
+	{
+		// the buffer of the event is NUL terminated after its end
+		pos = end;
+		return line;
+	}
+	*eol = '\0';
+	pos = eol + 1;
+	return line;
+}
@@ -41,12 +41,18 @@
 #include <opensand_output/Output.h>
 #include <opensand_rt/Rt.h>
 
+#include <cstddef>
+
 /**
  * @class NccInterface
  * @brief Class that describes the TCP Socket
  */
 class NccInterface
 {
+public:
+	/// The maximum length of a message read on the client socket
+	static constexpr std::size_t max_message_length = 65536;
+
 protected:
 	/**
 	 * @brief The TCP socket that listens for a connection
@@ -82,6 +88,17 @@ public:
 	
 	/*create a TCP socket connected to the component */
 	bool initSocket(int tcp_port);
+
+protected:
+	/**
+	 * @brief Split the next line of a received message in place
+	 *
+	 * @param pos  IN: the start of the remaining message,
+	 *             OUT: the start of the following line
+	 * @param end  The end of the message
+	 * @return the line, terminated in place, NULL at the end of the message
+	 */
+	static char *nextLine(char *&pos, char *end);
 };
 
 #endif
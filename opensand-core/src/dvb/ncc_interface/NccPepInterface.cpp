@@ -41,8 +41,7 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <stdio.h>
-
-#include <sstream>
+#include <string.h>
 
 
 /**
@@ -50,7 +49,10 @@
  */
 NccPepInterface::NccPepInterface():
 	NccInterface(),
-	requests_list()
+	requests(),
+	pending(0),
+	pending_index(),
+	requests_type(PEP_REQUEST_UNKNOWN)
 {
 }
 
@@ -60,14 +62,6 @@ NccPepInterface::NccPepInterface():
  */
 NccPepInterface::~NccPepInterface()
 {
-	std::vector<PepRequest *>::iterator it;
-
-	// free all PEP requests stored in list
-	for(it = this->requests_list.begin();
-	    it != this->requests_list.end();
-		it = requests_list.erase(it));
-
-	this->~NccInterface();
 }
 
 
@@ -100,50 +94,25 @@ int NccPepInterface::getPepClientSocket()
  */
 pep_request_type_t NccPepInterface::getPepRequestType()
 {
-	pep_request_type_t type;
-
-	if(this->requests_list.empty())
-	{
-		type = PEP_REQUEST_UNKNOWN;
-	}
-	else
+	if(this->requests[this->pending].empty())
 	{
-		type = this->requests_list.front()->getType();
+		return PEP_REQUEST_UNKNOWN;
 	}
 
-	return type;
+	return this->requests_type;
 }
 
 
-/**
- * @brief Get the first request of the list of PEP requests
- *
- * @return  the first request of the list of PEP requests,
- *          NULL if no request is available
- */
-PepRequest * NccPepInterface::getNextPepRequest()
+const std::vector<PepRequest> &NccPepInterface::swapPepRequests()
 {
-	PepRequest *request;
-	std::vector<PepRequest *>::iterator it;
+	unsigned int applied = this->pending;
 
-	if(this->requests_list.empty())
-	{
-		request = NULL;
-	}
-	else
-	{
-		// get the first request of the list and make a copy of it.
-		// the erase() method calls the object's destructor,
-		// so we have to deference the request object in order to preserve it.
-		it = this->requests_list.begin();
-		request = *it;
-		*it = NULL; // FIXME *it = NULL before erase it ?
-
-		// remove the first request of the list
-		this->requests_list.erase(it);
-	}
+	// the table applied previously is reused for the next messages
+	this->pending = 1 - applied;
+	this->requests[this->pending].clear();
+	this->pending_index.clear();
 
-	return request;
+	return this->requests[applied];
 }
 
 
@@ -170,7 +139,7 @@ bool NccPepInterface::initPepSocket(int tcp_port)
 
 bool NccPepInterface::readPepMessage(NetSocketEvent *const event, tal_id_t &tal_id)
 {
-	char *recv_buffer;
+	unsigned char *recv_buffer;
 
 	// a PEP must be connected to read a message from it!
 	if(!this->is_connected)
@@ -181,21 +150,35 @@ bool NccPepInterface::readPepMessage(NetSocketEvent *const event, tal_id_t &tal_
 		goto error;
 	}
 
-	recv_buffer = (char *)(event->getData());
+	recv_buffer = event->getData();
 
-	// parse message received from PEP
-	if(this->parsePepMessage(recv_buffer, tal_id) != true)
+	// parse message received from PEP in place
+	if(event->getSize() > 0 && recv_buffer[0] == PEP_BINARY_MARKER)
+	{
+		if(!this->parsePepBinaryMessage(recv_buffer + 1,
+		                                event->getSize() - 1,
+		                                tal_id))
+		{
+			LOG(this->log_ncc_interface, LEVEL_ERROR,
+			    "failed to parse binary message received from PEP "
+			    "component\n");
+			goto release;
+		}
+	}
+	else if(this->parsePepMessage((char *)recv_buffer, event->getSize(), tal_id) != true)
 	{
 		// an error occured when parsing the PEP message
 		LOG(this->log_ncc_interface, LEVEL_ERROR,
 		    "failed to parse message received from PEP "
 		    "component\n");
-		goto close;
+		goto release;
 	}
 
+	event->releaseData(recv_buffer);
 	return true;
 
-close:
+release:
+	event->releaseData(recv_buffer);
 	LOG(this->log_ncc_interface, LEVEL_ERROR,
 	    "close PEP client socket because of previous errors\n");
 	this->is_connected = false;
@@ -211,13 +194,17 @@ error:
  * allocation commands or release commands. All the commands in a message
  * must be of the same type.
  *
+ * The lines are split in place in the received buffer, the commands of
+ * a ST are merged with its commands received since the last application.
+ *
  * @param message   the message sent by the PEP component
+ * @param length    the length of the message
  * @return          true if message was successfully parsed, false otherwise
  */
-bool NccPepInterface::parsePepMessage(const char *message, tal_id_t &tal_id)
+bool NccPepInterface::parsePepMessage(char *message, std::size_t length, tal_id_t &tal_id)
 {
-	std::stringstream stream;
-	char cmd[64];
+	char *pos = message;
+	char *cmd;
 	unsigned int nb_cmds;
 	int all_cmds_type = -1; /* initialized because GCC is not smart enough
 	                           to find that the variable can not be used
@@ -225,14 +212,12 @@ bool NccPepInterface::parsePepMessage(const char *message, tal_id_t &tal_id)
 
 	// for every command in the message...
 	nb_cmds = 0;
-	stream << message;
-	while(stream.getline(cmd, 64))
+	while((cmd = NccInterface::nextLine(pos, message + length)) != NULL)
 	{
-		PepRequest *request;
+		PepRequest request(PEP_REQUEST_UNKNOWN, 0, 0, 0, 0);
 
 		// parse the command
-		request = this->parsePepCommand(cmd);
-		if(request == NULL)
+		if(!this->parsePepCommand(cmd, request))
 		{
 			LOG(this->log_ncc_interface, LEVEL_ERROR,
 			    "failed to parse command #%d in PEP message, "
@@ -240,27 +225,26 @@ bool NccPepInterface::parsePepMessage(const char *message, tal_id_t &tal_id)
 			continue;
 		}
 
-		tal_id = request->getStId();
+		tal_id = request.getStId();
 
 		// check that all commands are of of the same type
 		// (ie. all allocations or all de-allocations)
 		if(nb_cmds == 0)
 		{
 			// first command, set the type
-			all_cmds_type = request->getType();
+			all_cmds_type = request.getType();
 		}
-		else if(request->getType() != all_cmds_type)
+		else if(request.getType() != all_cmds_type)
 		{
 			LOG(this->log_ncc_interface, LEVEL_ERROR,
 			    "command #%d is not of the same type "
 			    "as command #1, this is not accepted, "
 			    "so ignore the command\n", nb_cmds);
-			delete request;
 			continue;
 		}
 
 		// store the command parameters in context
-		this->requests_list.push_back(request);
+		this->addPepRequest(request);
 
 		nb_cmds++;
 	}
@@ -271,18 +255,113 @@ bool NccPepInterface::parsePepMessage(const char *message, tal_id_t &tal_id)
 		return false;
 	}
 
+	this->requests_type = (pep_request_type_t)all_cmds_type;
 	return true;
 }
 
 
+/**
+ * @brief Parse a binary message sent by the PEP component
+ *
+ * The message is a sequence of pep_binary_command_t, all of the same type
+ *
+ * @param message   the commands of the message, after the marker
+ * @param length    the length of the commands
+ * @return          true if message was successfully parsed, false otherwise
+ */
+bool NccPepInterface::parsePepBinaryMessage(const unsigned char *message,
+                                            std::size_t length,
+                                            tal_id_t &tal_id)
+{
+	const std::size_t cmd_length = sizeof(pep_binary_command_t);
+	unsigned int nb_cmds = 0;
+	uint8_t all_cmds_type = 0;
+
+	if(length == 0 || length % cmd_length != 0)
+	{
+		LOG(this->log_ncc_interface, LEVEL_ERROR,
+		    "bad length %zu of binary PEP message, should be "
+		    "a multiple of %zu\n", length, cmd_length);
+		return false;
+	}
+
+	for(std::size_t offset = 0; offset < length; offset += cmd_length)
+	{
+		pep_binary_command_t cmd;
+
+		// the commands are not aligned after the marker
+		memcpy(&cmd, message + offset, cmd_length);
+		if(cmd.type != PEP_REQUEST_ALLOCATION && cmd.type != PEP_REQUEST_RELEASE)
+		{
+			LOG(this->log_ncc_interface, LEVEL_ERROR,
+			    "bad request type %u in binary PEP command #%u, "
+			    "skip the command\n", cmd.type, nb_cmds + 1);
+			continue;
+		}
+		if(nb_cmds == 0)
+		{
+			all_cmds_type = cmd.type;
+		}
+		else if(cmd.type != all_cmds_type)
+		{
+			LOG(this->log_ncc_interface, LEVEL_ERROR,
+			    "binary command #%u is not of the same type "
+			    "as command #1, ignore the command\n", nb_cmds);
+			continue;
+		}
+
+		PepRequest request((pep_request_type_t)cmd.type,
+		                   ntohs(cmd.st_id),
+		                   ntohs(cmd.cra_kbps),
+		                   ntohs(cmd.rbdc_kbps),
+		                   ntohs(cmd.rbdc_max_kbps));
+		tal_id = request.getStId();
+		this->addPepRequest(request);
+		nb_cmds++;
+	}
+
+	if(nb_cmds == 0)
+	{
+		return false;
+	}
+
+	LOG(this->log_ncc_interface, LEVEL_INFO,
+	    "%u binary PEP %s commands received\n", nb_cmds,
+	    ((all_cmds_type == PEP_REQUEST_ALLOCATION) ? "allocation" : "release"));
+	this->requests_type = (pep_request_type_t)all_cmds_type;
+	return true;
+}
+
+
+/**
+ * @brief Store a PEP command until it is applied
+ *
+ * @param request  the command
+ */
+void NccPepInterface::addPepRequest(const PepRequest &request)
+{
+	std::vector<PepRequest> &table = this->requests[this->pending];
+	auto index = this->pending_index.find(request.getStId());
+
+	// only the last value of each field is applied for a ST
+	if(index != this->pending_index.end())
+	{
+		table[index->second].update(request);
+		return;
+	}
+	this->pending_index.emplace(request.getStId(), table.size());
+	table.push_back(request);
+}
+
+
 /**
  * @brief Parse one of the commands sent in a message by the PEP component
  *
  * @param cmd       a command sent by the PEP component
- * @return          the created PEP request if command was successfully parsed,
- *                  NULL in case of failure
+ * @param request   OUT: the PEP request if command was successfully parsed
+ * @return          true if command was successfully parsed, false otherwise
  */
-PepRequest * NccPepInterface::parsePepCommand(const char *cmd)
+bool NccPepInterface::parsePepCommand(const char *cmd, PepRequest &request)
 {
 	unsigned int type;      // allocation or release request
 	unsigned int st_id;     // the ID of the ST the request is for
@@ -297,7 +376,7 @@ PepRequest * NccPepInterface::parsePepCommand(const char *cmd)
 	{
 		LOG(this->log_ncc_interface, LEVEL_ERROR,
 		    "bad formated PEP command received: '%s'\n", cmd);
-		return NULL;
+		return false;
 	}
 	else
 	{
@@ -312,7 +391,7 @@ PepRequest * NccPepInterface::parsePepCommand(const char *cmd)
 		    "bad request type in PEP command '%s', "
 		    "should be %u or %u\n", cmd,
 		    PEP_REQUEST_ALLOCATION, PEP_REQUEST_RELEASE);
-		return NULL;
+		return false;
 	}
 
 	LOG(this->log_ncc_interface, LEVEL_INFO,
@@ -322,5 +401,6 @@ PepRequest * NccPepInterface::parsePepCommand(const char *cmd)
 	    st_id, cra, rbdc, rbdc_max);
 
 	// build PEP request object
-	return new PepRequest((pep_request_type_t) type, st_id, cra, rbdc, rbdc_max);
+	request = PepRequest((pep_request_type_t) type, st_id, cra, rbdc, rbdc_max);
+	return true;
 }
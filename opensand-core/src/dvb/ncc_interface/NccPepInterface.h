@@ -36,11 +36,31 @@
 
 #include "PepRequest.h"
 #include "NccInterface.h"
+#include <map>
 #include <vector>
 
 #include <opensand_rt/NetSocketEvent.h>
 #include <opensand_rt/Rt.h>
 
+/// The first byte of a binary PEP message, a text message starts with a digit
+#define PEP_BINARY_MARKER 0xB5
+
+/**
+ * @brief A command of a binary PEP message, in network byte order
+ *
+ * The commands follow the PEP_BINARY_MARKER byte, their fields are
+ * those of the text commands "type:st_id:cra:rbdc:rbdc_max"
+ */
+struct pep_binary_command_t
+{
+	uint8_t type;
+	uint8_t reserved;
+	uint16_t st_id;
+	uint16_t cra_kbps;
+	uint16_t rbdc_kbps;
+	uint16_t rbdc_max_kbps;
+} __attribute__((__packed__));
+
 /**
  * @class NccPepInterface
  * @brief Interface between NCC and PEP components
@@ -48,8 +68,20 @@
 class NccPepInterface: public NccInterface
 {
 private:
-	/** The list of commands received from the PEP component */
-	std::vector<PepRequest *> requests_list;
+	/**
+	 * The commands received from the PEP component, one per ST: the table
+	 * filled by the messages and the one applied, swapped at each application
+	 */
+	std::vector<PepRequest> requests[2];
+
+	/** The index of the table filled by the messages */
+	unsigned int pending;
+
+	/** The position of each ST in the table filled by the messages */
+	std::map<tal_id_t, std::size_t> pending_index;
+
+	/** The type of the last message received */
+	pep_request_type_t requests_type;
 
 public:
 	/**** constructor/destructor ****/
@@ -72,8 +104,14 @@ public:
 	/* get the type of current PEP requests */
 	pep_request_type_t getPepRequestType();
 
-	/* get the list of PEP requests */
-	PepRequest * getNextPepRequest();
+	/**
+	 * @brief Take the PEP requests received since the previous call,
+	 *        the next messages fill the other table
+	 *
+	 * @return the requests to apply, at most one per ST,
+	 *         valid until the next call
+	 */
+	const std::vector<PepRequest> &swapPepRequests();
 
 
 	/**** socket management ****/
@@ -93,10 +131,17 @@ public:
 
 private:
 	/* parse a message sent by the PEP component */
-	bool parsePepMessage(const char *message, tal_id_t & tal_id);
+	bool parsePepMessage(char *message, std::size_t length, tal_id_t & tal_id);
+
+	/* parse a binary message sent by the PEP component */
+	bool parsePepBinaryMessage(const unsigned char *message, std::size_t length,
+	                           tal_id_t & tal_id);
 
 	/* parse one of the commands sent in a message by the PEP component */
-	PepRequest * parsePepCommand(const char *cmd);
+	bool parsePepCommand(const char *cmd, PepRequest &request);
+
+	/* store a command, merged with the pending one of its ST */
+	void addPepRequest(const PepRequest &request);
 };
 
 #endif
@@ -158,14 +158,10 @@ bool NccSvnoInterface::readSvnoMessage(NetSocketEvent *const event)
 
 	recv_buffer = (char *)(event->getData());
 
-	// parse message received from SVNO
-	if(this->parseSvnoMessage(recv_buffer) != true)
-	{
-		// an error occured when parsing the SVNO message
-		return false;
-	}
-
-	return true;
+	// parse message received from SVNO in place
+	bool status = this->parseSvnoMessage(recv_buffer, event->getSize());
+	event->releaseData(reinterpret_cast<unsigned char *>(recv_buffer));
+	return status;
 }
 
 
@@ -177,12 +173,13 @@ bool NccSvnoInterface::readSvnoMessage(NetSocketEvent *const event)
  * must be of the same type.
  *
  * @param message   the message sent by the SVNO component
+ * @param length    the length of the message
  * @return          true if message was successfully parsed, false otherwise
  */
-bool NccSvnoInterface::parseSvnoMessage(const char *message)
+bool NccSvnoInterface::parseSvnoMessage(char *message, std::size_t length)
 {
-	std::stringstream stream;
-	char cmd[64];
+	char *pos = message;
+	char *cmd;
 	unsigned int nb_cmds;
 	int all_cmds_type = -1; /* initialized because GCC is not smart enough
 	                           to find that the variable can not be used
@@ -190,8 +187,7 @@ bool NccSvnoInterface::parseSvnoMessage(const char *message)
 
 	// for every command in the message...
 	nb_cmds = 0;
-	stream << message;
-	while(stream.getline(cmd, 64))
+	while((cmd = NccInterface::nextLine(pos, message + length)) != NULL)
 	{
 		SvnoRequest *request;
 
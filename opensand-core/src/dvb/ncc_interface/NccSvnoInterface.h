@@ -90,7 +90,7 @@ public:
 
 private:
 	/* parse a message sent by the SVNO component */
-	bool parseSvnoMessage(const char *message);
+	bool parseSvnoMessage(char *message, std::size_t length);
 
 	/* parse one of the commands sent in a message by the SVNO component */
 	SvnoRequest * parseSvnoCommand(const char *cmd);
@@ -110,3 +110,22 @@ rate_kbps_t PepRequest::getRbdcMax() const
 {
 	return this->rbdc_max_kbps;
 }
+
+
+void PepRequest::update(const PepRequest &request)
+{
+	// a value of 0 leaves the current one unchanged when applied
+	this->type = request.type;
+	if(request.cra_kbps != 0)
+	{
+		this->cra_kbps = request.cra_kbps;
+	}
+	if(request.rbdc_kbps != 0)
+	{
+		this->rbdc_kbps = request.rbdc_kbps;
+	}
+	if(request.rbdc_max_kbps != 0)
+	{
+		this->rbdc_max_kbps = request.rbdc_max_kbps;
+	}
+}
@@ -78,6 +78,14 @@ public:
 	rate_kbps_t getCra() const;
 	rate_kbps_t getRbdc() const;
 	rate_kbps_t getRbdcMax() const;
+
+	/**
+	 * @brief Update the request with a newer one for the same ST,
+	 *        the values left to 0 by the newer request are kept
+	 *
+	 * @param request  The newer request
+	 */
+	void update(const PepRequest &request);
 };
 
 #endif
@@ -58,7 +58,12 @@ SlottedAloha::SlottedAloha():
 bool SlottedAloha::initParent(time_ms_t frame_duration_ms,
                               EncapPlugin::EncapPacketHandler *const pkt_hdl)
 {
-	srand(time(NULL));
+	unsigned int seed;
+	if(!OpenSandModelConf::Get()->getRandomSeed(seed))
+	{
+		seed = time(NULL);
+	}
+	srand(seed);
 	this->frame_duration_ms = frame_duration_ms;
 	this->pkt_hdl = pkt_hdl;
 
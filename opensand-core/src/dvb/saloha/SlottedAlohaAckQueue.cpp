@@ -0,0 +1,144 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file SlottedAlohaAckQueue.cpp
+ * @brief The Slotted Aloha packets of a terminal waiting for their ACK
+ * @author Viveris Technologies
+ */
+
+
+#include "SlottedAlohaAckQueue.h"
+
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+
+
+SlottedAlohaAckQueue::SlottedAlohaAckQueue():
+	slots(),
+	free_slots(),
+	ids(),
+	deadlines(),
+	counts(),
+	next_seq(0)
+{
+}
+
+void SlottedAlohaAckQueue::push(std::unique_ptr<SlottedAlohaPacketData> packet,
+                                qos_t qos,
+                                uint64_t now)
+{
+	std::size_t slot;
+	if(this->free_slots.empty())
+	{
+		slot = this->slots.size();
+		this->slots.emplace_back();
+	}
+	else
+	{
+		slot = this->free_slots.back();
+		this->free_slots.pop_back();
+	}
+
+	uint64_t seq = this->next_seq++;
+	this->deadlines.push({now + packet->getTimeout(), seq, slot});
+	this->ids.emplace(packet->getAckId(), slot);
+	this->counts[qos]++;
+	this->slots[slot] = {std::move(packet), qos, seq};
+}
+
+bool SlottedAlohaAckQueue::ack(const saloha_ack_id_t &id)
+{
+	// the equal IDs are not kept in their insertion order, the oldest
+	// packet is the one sent first
+	auto range = this->ids.equal_range(id);
+	if(range.first == range.second)
+	{
+		return false;
+	}
+	auto oldest = range.first;
+	for(auto id_it = std::next(range.first); id_it != range.second; ++id_it)
+	{
+		if(this->slots[id_it->second].seq < this->slots[oldest->second].seq)
+		{
+			oldest = id_it;
+		}
+	}
+	std::size_t slot = oldest->second;
+	this->ids.erase(oldest);
+	// its deadline in the heap is stale now and skipped when reached
+	this->release(slot);
+	return true;
+}
+
+void SlottedAlohaAckQueue::popExpired(uint64_t now, saloha_packets_data_t &expired)
+{
+	std::vector<std::tuple<qos_t, uint64_t, std::size_t>> expired_slots;
+	while(!this->deadlines.empty() && this->deadlines.top().tick <= now)
+	{
+		deadline_t deadline = this->deadlines.top();
+		this->deadlines.pop();
+		const waiting_packet_t &waiting = this->slots[deadline.slot];
+		if(waiting.packet == nullptr || waiting.seq != deadline.seq)
+		{
+			continue;
+		}
+		expired_slots.emplace_back(waiting.qos, waiting.seq, deadline.slot);
+	}
+	std::sort(expired_slots.begin(), expired_slots.end());
+
+	for(auto &&expired_slot: expired_slots)
+	{
+		std::size_t slot = std::get<2>(expired_slot);
+		auto range = this->ids.equal_range(this->slots[slot].packet->getAckId());
+		for(auto id_it = range.first; id_it != range.second; ++id_it)
+		{
+			if(id_it->second == slot)
+			{
+				this->ids.erase(id_it);
+				break;
+			}
+		}
+		expired.push_back(this->release(slot));
+	}
+}
+
+std::size_t SlottedAlohaAckQueue::size(qos_t qos) const
+{
+	auto count = this->counts.find(qos);
+	return count == this->counts.end() ? 0 : count->second;
+}
+
+std::unique_ptr<SlottedAlohaPacketData> SlottedAlohaAckQueue::release(std::size_t slot)
+{
+	waiting_packet_t &waiting = this->slots[slot];
+	this->counts[waiting.qos]--;
+	this->free_slots.push_back(slot);
+	return std::move(waiting.packet);
+}
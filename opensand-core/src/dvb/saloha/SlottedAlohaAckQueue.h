@@ -0,0 +1,144 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file SlottedAlohaAckQueue.h
+ * @brief The Slotted Aloha packets of a terminal waiting for their ACK
+ * @author Viveris Technologies
+ */
+
+#ifndef SALOHA_ACK_QUEUE_H
+#define SALOHA_ACK_QUEUE_H
+
+#include "SlottedAlohaPacketData.h"
+#include "OpenSandCore.h"
+
+#include <map>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+
+/**
+ * @class SlottedAlohaAckQueue
+ * @brief The packets sent by a terminal, ordered by their ACK deadline
+ *
+ * The packets are kept in reused slots, reached by a hash of their ID for
+ * the ACKs and by a min-heap of deadlines for the timeouts, so that an ACK
+ * costs O(1) and a timeout O(log n) instead of a scan of all the waiting
+ * packets at each Slotted Aloha frame. The deadlines are counted in Slotted
+ * Aloha frames ticks of the terminal.
+ */
+class SlottedAlohaAckQueue
+{
+public:
+	SlottedAlohaAckQueue();
+
+	/**
+	 * @brief Wait for the ACK of a sent packet
+	 *
+	 * @param packet  The packet, its timeout is the number of ticks to wait
+	 * @param qos     The packet QoS
+	 * @param now     The current tick
+	 */
+	void push(std::unique_ptr<SlottedAlohaPacketData> packet, qos_t qos, uint64_t now);
+
+	/**
+	 * @brief Release the packet acknowledged by an ACK, the oldest
+	 *        one if several packets have the same ID
+	 *
+	 * @param id  The packet ID
+	 * @return true if a packet was waiting for this ACK, false otherwise
+	 */
+	bool ack(const saloha_ack_id_t &id);
+
+	/**
+	 * @brief Get the packets whose ACK deadline passed, ordered by QoS
+	 *        then by sending order
+	 *
+	 * @param now      The current tick
+	 * @param expired  OUT: the expired packets
+	 */
+	void popExpired(uint64_t now, saloha_packets_data_t &expired);
+
+	/**
+	 * @brief Get the number of packets waiting for their ACK
+	 *
+	 * @param qos  The QoS of the packets
+	 * @return the number of packets
+	 */
+	std::size_t size(qos_t qos) const;
+
+private:
+	/// A sent packet, in a slot reused once the packet is released
+	struct waiting_packet_t
+	{
+		std::unique_ptr<SlottedAlohaPacketData> packet;
+		qos_t qos;
+		/// The sending order, to tell a slot reuse from its previous packet
+		uint64_t seq;
+	};
+
+	/// A deadline in the heap, stale once its slot is released or reused
+	struct deadline_t
+	{
+		uint64_t tick;
+		uint64_t seq;
+		std::size_t slot;
+
+		bool operator>(const deadline_t &other) const
+		{
+			return this->tick > other.tick ||
+			       (this->tick == other.tick && this->seq > other.seq);
+		}
+	};
+
+	/**
+	 * @brief Release the packet of a slot
+	 *
+	 * @param slot  The slot
+	 * @return the packet
+	 */
+	std::unique_ptr<SlottedAlohaPacketData> release(std::size_t slot);
+
+	std::vector<waiting_packet_t> slots;
+	std::vector<std::size_t> free_slots;
+
+	/// The slots of the packets per ID
+	std::unordered_multimap<saloha_ack_id_t, std::size_t, saloha_ack_id_hash> ids;
+
+	std::priority_queue<deadline_t, std::vector<deadline_t>, std::greater<deadline_t>> deadlines;
+
+	/// The number of waiting packets per QoS
+	std::map<qos_t, std::size_t> counts;
+
+	uint64_t next_seq;
+};
+
+#endif
@@ -37,6 +37,7 @@
 #define SALOHA_ALGO_H
 
 #include "SlottedAlohaFrame.h"
+#include "SlottedAlohaSlots.h"
 #include "Slot.h"
 
 #include <algorithm>
@@ -79,6 +80,9 @@ public:
 
 protected:
 	std::shared_ptr<OutputLog> log_saloha;
+
+	/// The flat model of the slots the collisions are removed from
+	SlottedAlohaSlots flat_slots;
 };
 
 
@@ -35,6 +35,8 @@
 
 #include <opensand_output/Output.h>
 
+#include <tuple>
+
 #include "SlottedAlohaAlgoCrdsa.h"
 
 
@@ -47,110 +49,155 @@ SlottedAlohaAlgoCrdsa::~SlottedAlohaAlgoCrdsa()
 {
 }
 
+bool SlottedAlohaAlgoCrdsa::replica_key_t::operator <(const replica_key_t &other) const
+{
+	return std::tie(tal_id, id, seq, pdu_nb, qos, replica) <
+	       std::tie(other.tal_id, other.id, other.seq, other.pdu_nb, other.qos, other.replica);
+}
+
+bool SlottedAlohaAlgoCrdsa::replica_key_t::isSamePacket(const replica_key_t &other) const
+{
+	return tal_id == other.tal_id && id == other.id && seq == other.seq &&
+	       pdu_nb == other.pdu_nb && qos == other.qos;
+}
+
 uint16_t SlottedAlohaAlgoCrdsa::removeCollisions(std::map<unsigned int, Slot *> &slots,
                                                  saloha_packets_data_t *accepted_packets)
 {
-	std::map<tal_id_t, std::vector<saloha_id_t> > accepted_ids;
 	uint16_t nbr_collisions = 0;
-	bool stop;
-	
-	//cf: CRDSA algorithm, but here, each packet is searched in accepted_packets
-	//    for each iteration
+
+	//cf: CRDSA algorithm
 	LOG(this->log_saloha, LEVEL_DEBUG,
 	    "Start removing collisions\n");
+
+	// flatten the slots and the keys of their replicas
+	SlottedAlohaSlots &flat = this->flat_slots;
+	flat.build(slots);
+	const std::size_t slots_count = flat.getSlotsCount();
+	const uint32_t replicas_count = flat.getReplicasCount();
+	this->replica_keys.clear();
+	for(uint32_t replica = 0; replica < replicas_count; ++replica)
+	{
+		const uint32_t position = flat.getReplicaPosition(replica);
+		if(position == SlottedAlohaSlots::simulated_position)
+		{
+			this->replica_keys.push_back({simulated_tal_id, flat.getSimulatedPacket(replica),
+			                              0, 0, 0, replica});
+			continue;
+		}
+		const auto &packet = (*flat.getSlot(flat.getReplicaSlot(replica)))[position];
+		this->replica_keys.push_back({packet->getSrcTalId(),
+		                              packet->getId(),
+		                              packet->getSeq(),
+		                              packet->getPduNb(),
+		                              packet->getQos(),
+		                              replica});
+	}
+	this->groupReplicas();
+
+	// start from the slots without collision
+	this->slot_remaining.resize(slots_count);
+	for(std::size_t slot = 0; slot < slots_count; ++slot)
+	{
+		this->slot_remaining[slot] = flat.getReplicasCount(slot);
+	}
+	this->single_slots = flat.getSingleMask();
+
+	// decode the packets alone in their slot in slots order, a decoded
+	// packet is cancelled in the other slots which may become decodable:
+	// the following ones in this pass, the previous ones in the next pass
+	bool decoded;
 	do
 	{
-		stop = true;
-		for(auto&& slot_it : slots)
+		decoded = false;
+		std::size_t slot = 0;
+		while((slot = flat.findNext(this->single_slots, slot)) < slots_count)
 		{
-			Slot *slot = slot_it.second;
-			if(!slot->size())
-			{
-				continue;
-			}
-			LOG(this->log_saloha, LEVEL_DEBUG,
-			    "Remove collisions on slot %u, containing %zu packets\n",
-			    slot->getId(), slot->size());
-
-			auto pkt_it = slot->begin();
-			// remove packets that were accepted on another slot from this slot
-			// (i.e. signal suppression of this packet)
-			while(pkt_it != slot->end())
-			{
-				auto& packet = *pkt_it;
-				tal_id_t tal_id = packet->getSrcTalId();
-
-				// create accepted_ids for this terminal if it does not exist
-				if(accepted_ids.find(tal_id) == accepted_ids.end())
-				{
-					accepted_ids[tal_id] = std::vector<saloha_id_t>();
-				}
-
-				if(std::find(accepted_ids[tal_id].begin(),
-				             accepted_ids[tal_id].end(),
-				             packet->getUniqueId()) != accepted_ids[tal_id].end())
-				{
-					slot->erase(pkt_it);
-					// avoid removing an accepted packet
-					/*
-					if(std::find(accepted_packets->begin(),
-					             accepted_packets->end(),
-					             packet) == accepted_packets->end())
-					{
-						delete packet;
-					}
-					*/
-					// erase goes to next iterator
-					continue;
-				}
-				pkt_it++;
-			}
-			LOG(this->log_saloha, LEVEL_DEBUG,
-			    "Slot %u contains %zu packets after signal suppression\n",
-			    slot->getId(), slot->size());
-			if(slot->size() == 1)
-			{
-				auto& packet = slot->front();
-				tal_id_t tal_id = packet->getSrcTalId();
-
-				// create accepted_ids for this terminal if it does not exist
-				if(accepted_ids.find(tal_id) == accepted_ids.end())
-				{
-					accepted_ids[tal_id] = std::vector<saloha_id_t>();
-				}
-
-				accepted_ids[tal_id].push_back(packet->getUniqueId());
-				accepted_packets->push_back(std::move(packet));
-				// packet is decoded, we need to restart the check all slots
-				// to remove the signal of this packet when a duplicate was found
-				stop = false;
-				LOG(this->log_saloha, LEVEL_DEBUG,
-				    "No collision on slot %u, keep packet from terminal %u\n",
-				    slot->getId(), tal_id);
-			}
-			else if(slot->size())
-			{
-				LOG(this->log_saloha, LEVEL_DEBUG,
-				    "Collision on slot %u at the moment\n",
-				    slot->getId());
-			}
+			this->decodeSlot(slot, accepted_packets);
+			decoded = true;
+			++slot;
 		}
 	}
-	while(!stop);
+	while(decoded);
 
-	for(auto&& slot_it : slots)
+	// check for collisions here, we do not count collisions that were avoided
+	std::size_t slot = 0;
+	while((slot = flat.findNext(flat.getCollisionMask(), slot)) < slots_count)
 	{
-		Slot *slot = slot_it.second;
-		// check for collisions here, we do not count collisions that were avoided
-		if(slot->size() > 1)
+		if(this->slot_remaining[slot] > 1)
 		{
 			LOG(this->log_saloha, LEVEL_NOTICE,
 			    "There is still collision on slot %u, remove packets\n",
-			    slot->getId());
-			nbr_collisions += slot->size();
+			    flat.getSlot(slot)->getId());
+			nbr_collisions += this->slot_remaining[slot];
 		}
-		slot->clear();
+		++slot;
 	}
+	flat.release();
 	return nbr_collisions;
 }
 
+void SlottedAlohaAlgoCrdsa::groupReplicas()
+{
+	const std::size_t replicas_count = this->replica_keys.size();
+	std::sort(this->replica_keys.begin(), this->replica_keys.end());
+
+	this->replica_packet.resize(replicas_count);
+	this->packet_replicas.resize(replicas_count);
+	this->packet_start.clear();
+	for(std::size_t index = 0; index < replicas_count; ++index)
+	{
+		const replica_key_t &key = this->replica_keys[index];
+		if(index == 0 || !key.isSamePacket(this->replica_keys[index - 1]))
+		{
+			this->packet_start.push_back(index);
+		}
+		this->replica_packet[key.replica] = this->packet_start.size() - 1;
+		this->packet_replicas[index] = key.replica;
+	}
+	this->packet_decoded.assign(this->packet_start.size(), false);
+	this->packet_start.push_back(replicas_count);
+}
+
+void SlottedAlohaAlgoCrdsa::decodeSlot(std::size_t slot, saloha_packets_data_t *accepted_packets)
+{
+	// find the replica whose packet is not decoded yet
+	const SlottedAlohaSlots &flat = this->flat_slots;
+	uint32_t replica = flat.getFirstReplica(slot);
+	while(this->packet_decoded[this->replica_packet[replica]])
+	{
+		++replica;
+	}
+	const uint32_t packet = this->replica_packet[replica];
+	this->packet_decoded[packet] = true;
+
+	// a simulated packet is only cancelled
+	if(flat.getReplicaPosition(replica) != SlottedAlohaSlots::simulated_position)
+	{
+		auto &data = (*flat.getSlot(slot))[flat.getReplicaPosition(replica)];
+		LOG(this->log_saloha, LEVEL_DEBUG,
+		    "No collision on slot %u, keep packet from terminal %u\n",
+		    flat.getSlot(slot)->getId(), data->getSrcTalId());
+		// the replica holding the payload may be released with its slot
+		data->unshare();
+		accepted_packets->push_back(std::move(data));
+	}
+
+	// signal suppression of the packet in all its slots
+	for(uint32_t index = this->packet_start[packet];
+	    index < this->packet_start[packet + 1];
+	    ++index)
+	{
+		const uint32_t other_slot = flat.getReplicaSlot(this->packet_replicas[index]);
+		const uint32_t remaining = --this->slot_remaining[other_slot];
+		const uint64_t bit = UINT64_C(1) << (other_slot % 64);
+		if(remaining == 1)
+		{
+			this->single_slots[other_slot / 64] |= bit;
+		}
+		else
+		{
+			this->single_slots[other_slot / 64] &= ~bit;
+		}
+	}
+}
@@ -38,9 +38,16 @@
 
 #include "SlottedAlohaAlgo.h"
 
+#include <vector>
+
 /**
  * @class SlottedAlohaCrdsa
  * @brief The CRDSA algo
+ *
+ * The successive interference cancellation runs on the flat slot model
+ * completed with the replicas of each packet and a bitmap of the slots
+ * holding a single packet not decoded yet. The bitmap is scanned in slots order, in passes, as the
+ * slots themselves were, so packets are decoded in the same order.
 */
 class SlottedAlohaAlgoCrdsa: public SlottedAlohaAlgo
 {
@@ -53,6 +60,55 @@ public:
 private:
 	uint16_t removeCollisions(std::map<unsigned int, Slot *> &slots,
 	                          saloha_packets_data_t *accepted_packets);
+
+	/**
+	 * @brief Group the replicas of each packet: the replicas of a
+	 *        packet share their source terminal and unique id
+	 */
+	void groupReplicas();
+
+	/**
+	 * @brief Decode the single packet remaining in a slot and
+	 *        cancel its replicas in the other slots
+	 *
+	 * @param slot              The slot index
+	 * @param accepted_packets  The decoded packets
+	 */
+	void decodeSlot(std::size_t slot, saloha_packets_data_t *accepted_packets);
+
+	/// The terminal of the simulated packets, their id is their index
+	static constexpr tal_id_t simulated_tal_id = UINT16_MAX;
+
+	/// The fields of the unique id of a replica and its index
+	struct replica_key_t
+	{
+		tal_id_t tal_id;
+		saloha_pdu_id_t id;
+		uint16_t seq;
+		uint16_t pdu_nb;
+		uint8_t qos;
+		uint32_t replica;
+
+		bool operator <(const replica_key_t &other) const;
+		bool isSamePacket(const replica_key_t &other) const;
+	};
+
+	/// The number of replicas of each slot whose packet is not decoded
+	std::vector<uint32_t> slot_remaining;
+	/// The slots holding a single replica whose packet is not decoded
+	std::vector<uint64_t> single_slots;
+
+	/// The packet of each replica
+	std::vector<uint32_t> replica_packet;
+	/// The replica keys, sorted to group the replicas by packet
+	std::vector<replica_key_t> replica_keys;
+
+	/// The index of the first replica of each packet in packet_replicas
+	std::vector<uint32_t> packet_start;
+	/// The replicas of each packet
+	std::vector<uint32_t> packet_replicas;
+	/// Whether each packet is decoded
+	std::vector<bool> packet_decoded;
 };
 
 #endif
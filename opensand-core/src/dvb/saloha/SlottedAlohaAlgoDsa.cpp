@@ -52,24 +52,20 @@ uint16_t SlottedAlohaAlgoDsa::removeCollisions(std::map<unsigned int, Slot *> &s
 {
 	std::map<tal_id_t, std::vector<saloha_id_t> > accepted_ids;
 	uint16_t nbr_collisions = 0;
+	SlottedAlohaSlots &flat = this->flat_slots;
 
 	// cf: DSA algorithm
-	for(auto&& slot_it : slots)
+	flat.build(slots);
+	const std::size_t slots_count = flat.getSlotsCount();
+	// only the packets alone in their slot are looked at, in slots order,
+	// the simulated packets only collide with the other ones
+	std::size_t slot = 0;
+	while((slot = flat.findNext(flat.getSingleMask(), slot)) < slots_count)
 	{
-		Slot *slot = slot_it.second;
-		saloha_packets_data_t::iterator pkt_it;
-		if(!slot->size())
+		const uint32_t replica = flat.getFirstReplica(slot);
+		if(flat.getReplicaPosition(replica) != SlottedAlohaSlots::simulated_position)
 		{
-			continue;
-		}
-
-		LOG(this->log_saloha, LEVEL_DEBUG,
-		    "Remove collisions on slot %u, containing %zu packets\n",
-		    slot->getId(), slot->size());
-
-		if(slot->size() == 1)
-		{
-			auto& packet = slot->front();
+			auto& packet = flat.getSlot(slot)->front();
 			tal_id_t tal_id = packet->getSrcTalId();
 
 			// create accepted_ids for this terminal if it does not exist
@@ -84,20 +80,26 @@ uint16_t SlottedAlohaAlgoDsa::removeCollisions(std::map<unsigned int, Slot *> &s
 			{
 				// packet was not already received on another slot
 				accepted_ids[tal_id].push_back(packet->getUniqueId());
+				// the replica holding the payload may be released with its slot
+				packet->unshare();
 				accepted_packets->push_back(std::move(packet));
 				LOG(this->log_saloha, LEVEL_DEBUG,
-				    "No collision, keep packet from terminal %u\n",
-				    tal_id);
+				    "No collision on slot %u, keep packet from terminal %u\n",
+				    flat.getSlot(slot)->getId(), tal_id);
 			}
 		}
-		else
-		{
-			LOG(this->log_saloha, LEVEL_NOTICE,
-			    "Collision on slot %u, remove packets\n", slot->getId());
-			nbr_collisions += slot->size();
-		}
-		slot->clear();
+		++slot;
 	}
+
+	slot = 0;
+	while((slot = flat.findNext(flat.getCollisionMask(), slot)) < slots_count)
+	{
+		LOG(this->log_saloha, LEVEL_NOTICE,
+		    "Collision on slot %u, remove packets\n", flat.getSlot(slot)->getId());
+		nbr_collisions += flat.getReplicasCount(slot);
+		++slot;
+	}
+
+	flat.release();
 	return nbr_collisions;
 }
-
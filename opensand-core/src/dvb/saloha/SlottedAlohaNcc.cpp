@@ -39,8 +39,10 @@
 #include "SlottedAlohaPacketCtrl.h"
 #include "SlottedAlohaAlgoDsa.h"
 #include "SlottedAlohaAlgoCrdsa.h"
+#include "SlottedAlohaSimuLoad.h"
 #include "OpenSandModelConf.h"
 
+#include <algorithm>
 #include <stdlib.h>
 #include <math.h>
 
@@ -56,7 +58,8 @@ SlottedAlohaNcc::SlottedAlohaNcc():
 	spot_id(0),
 	terminals(),
 	algo(NULL),
-	simu()
+	simu(),
+	simu_loads()
 {
 }
 
@@ -96,6 +99,7 @@ void SlottedAlohaNcc::generateConfiguration(std::shared_ptr<OpenSANDConf::MetaPa
 	auto types = Conf->getModelTypesDefinition();
 	types->addEnumType("saloha_algo", "Slotted Aloha Algorithm", {"DSA", "CRDSA"});
 	types->addEnumType("traffic_type", "Simulated Slotted Aloha Traffic", {"Standard", "Premium", "Professional", "SVNO1", "SVNO2", "SVNO3", "SNO"});
+	types->addEnumType("simulation_mode", "Simulated Slotted Aloha Traffic Mode", {"Packets", "Statistical"});
 
 	auto conf = Conf->getOrCreateComponent("access", "Access");
 	Conf->setProfileReference(conf, disable_ctrl_plane, false);
@@ -106,6 +110,13 @@ void SlottedAlohaNcc::generateConfiguration(std::shared_ptr<OpenSANDConf::MetaPa
 	simu_list->addParameter("max_packets", "Max Packets", types->getType("int"))->setUnit("packets");
 	simu_list->addParameter("replicas", "Replicas", types->getType("int"))->setUnit("packets");
 	simu_list->addParameter("ratio", "Ratio", types->getType("int"));
+	simu_list->addParameter("mode", "Mode", types->getType("simulation_mode"),
+	                        "Packets: create the packets of each simulated terminal; "
+	                        "Statistical: draw the load of a terminals population "
+	                        "without creating packets");
+	simu_list->addParameter("terminals", "Terminals", types->getType("int"),
+	                        "Statistical mode: the number of simulated terminals, 0 to get "
+	                        "it from the max packets per terminal");
 }
 
 bool SlottedAlohaNcc::init(TerminalCategories<TerminalCategorySaloha> &categories,
@@ -260,6 +271,38 @@ bool SlottedAlohaNcc::init(TerminalCategories<TerminalCategorySaloha> &categorie
 			continue;
 		}
 		
+		std::string mode = "Packets";
+		OpenSandModelConf::extractParameterData(simulated_traffic->getParameter("mode"), mode);
+		if(mode == "Statistical")
+		{
+			TerminalCategorySaloha *category = cat_iter->second;
+			double mean_load = category->getSlotsNumber() * ratio / 100.0;
+			int terminals = 0;
+			OpenSandModelConf::extractParameterData(simulated_traffic->getParameter("terminals"), terminals);
+			if(terminals <= 0)
+			{
+				terminals = ceil(mean_load / nb_max_packets);
+			}
+			LOG(this->log_init, LEVEL_NOTICE,
+			    "category %s, simulate a mean load of %.1f packets out of %u slots "
+			    "from %d terminals, %u replicas\n",
+			    label.c_str(), mean_load, category->getSlotsNumber(),
+			    terminals, nb_replicas);
+			auto load = std::unique_ptr<SlottedAlohaSimuLoad>{
+				new SlottedAlohaSimuLoad(label,
+				                         category->getSlotsNumber(),
+				                         terminals,
+				                         mean_load,
+				                         nb_replicas,
+				                         this->log_init)};
+			if(!load->start())
+			{
+				return false;
+			}
+			this->simu_loads.push_back(std::move(load));
+			continue;
+		}
+
 		SlottedAlohaSimu *simulation = new SlottedAlohaSimu(cat_iter->second,
 		                                                    nb_max_packets,
 		                                                    nb_replicas,
@@ -273,7 +316,8 @@ bool SlottedAlohaNcc::init(TerminalCategories<TerminalCategorySaloha> &categorie
 bool SlottedAlohaNcc::onRcvFrame(DvbFrame *dvb_frame)
 {
 	SlottedAlohaFrame *frame;
-	size_t previous_length;
+	const unsigned char *payload;
+	size_t remaining_length;
 
 	// TODO static cast
 	frame = dvb_frame->operator SlottedAlohaFrame*();
@@ -290,18 +334,55 @@ bool SlottedAlohaNcc::onRcvFrame(DvbFrame *dvb_frame)
 	    "Receive Slotted Aloha frame containing %u packets\n",
 	    frame->getDataLength());
 
-	previous_length = 0;
+	// the packets are read in place, only the first replica of a packet
+	// received in the frames copies its payload
+	payload = frame->getRawData() + frame->getHeaderLength();
+	remaining_length = frame->getTotalLength() - frame->getHeaderLength();
 	for(unsigned int cpt = 0; cpt < frame->getDataLength(); cpt++)
 	{
-		Data payload = frame->getPayload(previous_length);
+		if(remaining_length < sizeof(saloha_data_hdr_t))
+		{
+			LOG(this->log_saloha, LEVEL_ERROR,
+			    "truncated Slotted Aloha frame\n");
+			break;
+		}
 		size_t current_length =
 			SlottedAlohaPacketData::getPacketLength(payload);
+		if(current_length < sizeof(saloha_data_hdr_t) ||
+		   current_length > remaining_length)
+		{
+			LOG(this->log_saloha, LEVEL_ERROR,
+			    "wrong Slotted Aloha packet length %zu\n", current_length);
+			break;
+		}
+		const unsigned char *current = payload;
+		payload += current_length;
+		remaining_length -= current_length;
+
+		const SlottedAlohaPacketData *payload_replica = nullptr;
+		uint32_t id = ntohl(((const saloha_data_hdr_t *)current)->id);
+		auto candidates = this->received_replicas.equal_range(id);
+		for(auto it = candidates.first; it != candidates.second; ++it)
+		{
+			if(it->second->isReplica(current, current_length))
+			{
+				payload_replica = it->second;
+				break;
+			}
+		}
 
-		previous_length += current_length;
 		std::unique_ptr<SlottedAlohaPacketData> sa_packet;
+		tal_id_t src_tal_id;
 		try
 		{
-			sa_packet = std::unique_ptr<SlottedAlohaPacketData>(new SlottedAlohaPacketData{payload, current_length});
+			if(payload_replica != nullptr)
+			{
+				sa_packet = std::unique_ptr<SlottedAlohaPacketData>(new SlottedAlohaPacketData{current, payload_replica});
+			}
+			else
+			{
+				sa_packet = std::unique_ptr<SlottedAlohaPacketData>(new SlottedAlohaPacketData{current, current_length});
+			}
 		}
 		catch (const std::bad_alloc&)
 		{
@@ -309,14 +390,20 @@ bool SlottedAlohaNcc::onRcvFrame(DvbFrame *dvb_frame)
 			    "cannot create a Slotted Aloha data packet\n");
 			continue;
 		}
-		// we need to keep qos and src_tal_id of inner encapsulated packet
-		qos_t qos;
-		tal_id_t src_tal_id;
-		Data encap = sa_packet->getPayload();
-		this->pkt_hdl->getSrc(encap, src_tal_id); 
-		this->pkt_hdl->getQos(encap, qos); 
-		sa_packet->setSrcTalId(src_tal_id);
-		sa_packet->setQos(qos);
+		if(payload_replica == nullptr)
+		{
+			// we need to keep qos and src_tal_id of inner encapsulated packet
+			qos_t qos;
+			Data encap = sa_packet->getPayload();
+			this->pkt_hdl->getSrc(encap, src_tal_id); 
+			this->pkt_hdl->getQos(encap, qos); 
+			sa_packet->setSrcTalId(src_tal_id);
+			sa_packet->setQos(qos);
+		}
+		else
+		{
+			src_tal_id = sa_packet->getSrcTalId();
+		}
 
 		// find the associated terminal category
 		auto st = this->terminals.find(src_tal_id);
@@ -331,15 +418,18 @@ bool SlottedAlohaNcc::onRcvFrame(DvbFrame *dvb_frame)
 		auto category = this->categories[terminal->getCurrentCategory()];
 
 		// Add replicas in the corresponding slots
-		auto slots = category->getSlots();
-		auto slot_it = slots.find(sa_packet->getTs());
-		if(slot_it == slots.end())
+		Slot *slot = category->getSlot(sa_packet->getTs());
+		if(slot == nullptr)
 		{
 			LOG(this->log_saloha, LEVEL_ERROR,
 			    "packet received on a slot that does not exist\n");
 			continue;
 		}
-		slot_it->second->push_back(std::move(sa_packet));
+		if(payload_replica == nullptr)
+		{
+			this->received_replicas.emplace(id, sa_packet.get());
+		}
+		slot->push_back(std::move(sa_packet));
 		category->increaseReceivedPacketsNbr();
 	}
 
@@ -364,9 +454,12 @@ bool SlottedAlohaNcc::schedule(NetBurst **burst,
 		TerminalCategorySaloha *category = (*cat_iter).second;
 		if(!this->scheduleCategory(category, burst, complete_dvb_frames))
 		{
+			this->received_replicas.clear();
 			return false;
 		}
 	}
+	// the slots are released, the replicas cannot be shared anymore
+	this->received_replicas.clear();
 	return true;
 }
 
@@ -376,7 +469,7 @@ bool SlottedAlohaNcc::scheduleCategory(TerminalCategorySaloha *category,
 {
 	SlottedAlohaFrameCtrl *frame;
 	saloha_packets_data_t *accepted_packets;
-	saloha_packets_data_t::iterator pkt_it;
+	saloha_packets_data_t pdu;
 	// refresh the probe in case of no traffic
 	this->probe_collisions[category->getLabel()]->put(0);
 	this->probe_collisions_before[category->getLabel()]->put(0);
@@ -405,6 +498,15 @@ bool SlottedAlohaNcc::scheduleCategory(TerminalCategorySaloha *category,
 			this->simulateTraffic(category, *it);
 		}
 	}
+	uint32_t simulated_index = 0;
+	for(auto&& load : this->simu_loads)
+	{
+		if(load->getCategory() == category->getLabel())
+		{
+			std::map<unsigned int, Slot *> slots = category->getSlots();
+			simulated_index += load->merge(slots, simulated_index);
+		}
+	}
 
 	category->resetReceivedPacketsNbr();
 	LOG(this->log_saloha, LEVEL_DEBUG,
@@ -427,19 +529,15 @@ bool SlottedAlohaNcc::scheduleCategory(TerminalCategorySaloha *category,
 
 	// Propagate if possible all packets received to encap block
 	accepted_packets = category->getAcceptedPackets();
-	pkt_it = accepted_packets->begin();
-	while(pkt_it != accepted_packets->end())
+	for(auto&& accepted_packet : *accepted_packets)
 	{
-		std::unique_ptr<SlottedAlohaPacketData> sa_packet = std::move(*pkt_it);
-		SlottedAlohaPacketCtrl *ack;
+		std::unique_ptr<SlottedAlohaPacketData> sa_packet = std::move(accepted_packet);
 		TerminalContextSaloha *terminal;
 		saloha_terminals_t::iterator st;
 		saloha_pdu_id_t id_pdu;
 		saloha_id_t id_packet;
 		tal_id_t tal_id;
 
-		// erase goes to next iterator
-		accepted_packets->erase(pkt_it);
 		id_packet = sa_packet->getUniqueId();
 		id_pdu = sa_packet->getId();
 		tal_id = sa_packet->getSrcTalId();
@@ -468,43 +566,12 @@ bool SlottedAlohaNcc::scheduleCategory(TerminalCategorySaloha *category,
 			continue;
 		}
 
-		// Send an ACK
-		ack = new SlottedAlohaPacketCtrl(id_packet, SALOHA_CTRL_ACK, tal_id);
-		if(!ack)
-		{
-			LOG(this->log_saloha, LEVEL_ERROR,
-			    "failed to create a Slotted Aloha signal control "
-			    "packet");
-			continue;
-		}
-
-		if(frame->getFreeSpace() < ack->getTotalLength())
-		{
-			// add the previous frame in complete frames
-			complete_dvb_frames.push_back((DvbFrame *)frame);
-			// create a new Slotted Aloha control frame
-			frame = new SlottedAlohaFrameCtrl();
-			if(!frame)
-			{
-				LOG(this->log_saloha, LEVEL_ERROR,
-				    "failed to create a Slotted Aloha signal control frame");
-				return false;
-			}
-			frame->setSpot(this->spot_id);
-		}
-		if(!frame->addPacket(ack))
-		{
-			LOG(this->log_saloha, LEVEL_ERROR,
-			    "failed to add a Slotted Aloha packet in "
-			    "signal control frame");
-			delete ack;
-			continue;
-		}
+		// the ACK is sent with the other packets of the terminal
+		this->accepted_acks.emplace_back(tal_id, sa_packet->getAckId());
 		LOG(this->log_saloha, LEVEL_INFO,
 		    "Ack packet %s on ST%u\n", id_packet.c_str(), tal_id);
-		delete ack;
 
-		saloha_packets_data_t pdu;
+		pdu.clear();
 		auto state = terminal->addPacket(std::move(sa_packet), pdu);
 		LOG(this->log_saloha, LEVEL_DEBUG,
 		    "New Slotted Aloha packet with ID %s received from terminal %u\n", 
@@ -528,8 +595,59 @@ bool SlottedAlohaNcc::scheduleCategory(TerminalCategorySaloha *category,
 			}
 		}
 	}
+	accepted_packets->clear();
 	// NB: if a pdu is never completed, it will be overwritten once
 	//     PDU id would have looped
+
+	// send one compacted ACK per terminal, split over the frames if needed
+	std::stable_sort(this->accepted_acks.begin(), this->accepted_acks.end(),
+	                 [](const std::pair<tal_id_t, saloha_ack_id_t> &a,
+	                    const std::pair<tal_id_t, saloha_ack_id_t> &b)
+	                 { return a.first < b.first; });
+	auto group = this->accepted_acks.begin();
+	while(group != this->accepted_acks.end())
+	{
+		tal_id_t tal_id = group->first;
+		std::size_t written = 0;
+
+		this->terminal_acks.clear();
+		for(; group != this->accepted_acks.end() && group->first == tal_id; ++group)
+		{
+			this->terminal_acks.push_back(group->second);
+		}
+		while(written < this->terminal_acks.size())
+		{
+			std::size_t added = frame->addAcks(tal_id,
+			                                   this->terminal_acks.data() + written,
+			                                   this->terminal_acks.size() - written);
+			if(added)
+			{
+				written += added;
+				continue;
+			}
+			if(!frame->getDataLength())
+			{
+				LOG(this->log_saloha, LEVEL_ERROR,
+				    "failed to add a Slotted Aloha ACK in "
+				    "signal control frame");
+				break;
+			}
+			// add the previous frame in complete frames
+			complete_dvb_frames.push_back((DvbFrame *)frame);
+			// create a new Slotted Aloha control frame
+			frame = new SlottedAlohaFrameCtrl();
+			if(!frame)
+			{
+				LOG(this->log_saloha, LEVEL_ERROR,
+				    "failed to create a Slotted Aloha signal control frame");
+				this->accepted_acks.clear();
+				return false;
+			}
+			frame->setSpot(this->spot_id);
+		}
+	}
+	this->accepted_acks.clear();
+
 	// add last frame in complete frames
 	if(frame->getDataLength())
 	{
@@ -558,10 +676,7 @@ void SlottedAlohaNcc::removeCollisions(TerminalCategorySaloha *category)
 	// we remove collision per category as in the same category
 	// we do as if there was only one big carrier
 	uint16_t nbr;
-	unsigned int slots_per_carrier = floor(category->getSlotsNumber() /
-	                                       category->getCarriersNumber());
 	std::map<unsigned int, Slot *> slots = category->getSlots();
-	AlohaPacketComparator comparator(slots_per_carrier);
 	saloha_packets_data_t *accepted_packets = category->getAcceptedPackets();
 
 	if(this->probe_collisions_before[category->getLabel()]->isEnabled())
@@ -571,9 +686,10 @@ void SlottedAlohaNcc::removeCollisions(TerminalCategorySaloha *category)
 		    slot_it != slots.end(); ++slot_it)
 		{
 			Slot *slot = (*slot_it).second;
-			if(slot->size() > 1)
+			std::size_t total = slot->size() + slot->getSimulatedPackets().size();
+			if(total > 1)
 			{
-				coll += slot->size();
+				coll += total;
 			}
 		}
 		this->probe_collisions_before[category->getLabel()]->put(coll);
@@ -582,8 +698,6 @@ void SlottedAlohaNcc::removeCollisions(TerminalCategorySaloha *category)
 	this->probe_collisions[category->getLabel()]->put(nbr);
 	this->probe_collisions_ratio[category->getLabel()]->put(nbr * 100 /
 	                                                        category->getSlotsNumber());
-	// Because of CRDSA algorithm for example, need to sort packets
-	sort(accepted_packets->begin(), accepted_packets->end(), comparator);
 }
 
 void SlottedAlohaNcc::simulateTraffic(TerminalCategorySaloha *category,
@@ -622,7 +736,6 @@ void SlottedAlohaNcc::simulateTraffic(TerminalCategorySaloha *category,
 		it = time_slots.begin();
 		while(it != time_slots.end())
 		{
-			std::map<unsigned int, Slot *> slots = category->getSlots();
 			uint16_t nb_replicas = simulation->getNbReplicas();
 			uint16_t replicas[nb_replicas];
 			for(uint16_t rep_cpt = 0; rep_cpt < nb_replicas; rep_cpt++)
@@ -651,7 +764,7 @@ void SlottedAlohaNcc::simulateTraffic(TerminalCategorySaloha *category,
 				sa_packet->setTs(slot_id);
 				// no need to check here if id exists as we directly
 				// get info from the map itself to get IDs
-				slots[slot_id]->push_back(std::move(sa_packet));
+				category->getSlot(slot_id)->push_back(std::move(sa_packet));
 			}
 			pdu_id++;
 		}
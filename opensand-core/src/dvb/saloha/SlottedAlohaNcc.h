@@ -45,11 +45,15 @@
 #include "TerminalCategorySaloha.h"
 #include "SlottedAlohaAlgo.h"
 #include "UnitConverter.h"
+#include "TerminalMap.h"
 #include "opensand_conf/MetaParameter.h"
 
 #include <list>
+#include <memory>
+#include <unordered_map>
 
 class SlottedAlohaSimu;
+class SlottedAlohaSimuLoad;
 
 /**
  * @class SlottedAlohaNcc
@@ -71,7 +75,7 @@ private:
 	spot_id_t spot_id;
 
 	// Helper to simplify context manipulation
-	typedef std::map<tal_id_t, TerminalContextSaloha *> saloha_terminals_t;
+	typedef TerminalMap<TerminalContextSaloha *> saloha_terminals_t;
 
 	/** List of registered terminals */
 	saloha_terminals_t terminals;
@@ -82,12 +86,25 @@ private:
 	/// Parameters to simulate Slotted Aloha traffic
 	std::vector<SlottedAlohaSimu *> simu;
 
+	/// The statistical Slotted Aloha traffic simulations
+	std::vector<std::unique_ptr<SlottedAlohaSimuLoad>> simu_loads;
+
 	typedef std::map<std::string, std::shared_ptr<Probe<int> > > probe_per_cat_t;
 	/// Statistics
 	probe_per_cat_t probe_collisions;
 	probe_per_cat_t probe_collisions_before;
 	probe_per_cat_t probe_collisions_ratio;
 
+	/// The received packets holding their payload, per ID, the replicas
+	/// received later share it. They are valid until the slots are released
+	std::unordered_multimap<uint32_t, const SlottedAlohaPacketData *> received_replicas;
+
+	/// The IDs of the packets accepted on a category, to acknowledge per terminal
+	std::vector<std::pair<tal_id_t, saloha_ack_id_t>> accepted_acks;
+
+	/// The IDs of the packets of one terminal, written in the same ACK
+	std::vector<saloha_ack_id_t> terminal_acks;
+
 public:
 	SlottedAlohaNcc();
 
@@ -176,49 +193,6 @@ private:
 	                      std::list<DvbFrame *> &complete_dvb_frames);
 };
 
-/**
- * @class AlohaPacketComparator
- * @brief Functor to compare data Aloha packets for the std::sort function
- */
-class AlohaPacketComparator
-{
-public:
-	AlohaPacketComparator(uint16_t slots_per_carrier):
-		slots_per_carrier(slots_per_carrier)
-	{};
-
-	/**
-	 * Sort packets after removing algorithm to propagate packets to encap block
-	 * in the correct order. This method is a std::sort callback called for
-	 * each iteration
-	 *
-	 * @param pkt1  first packet to compare
-	 * @param pkt2  second packet to compare
-	 *
-	 * @return true if order is good, false otherwise
-	 */
-	bool operator()(const std::unique_ptr<SlottedAlohaPacketData>& pkt1,
-	                const std::unique_ptr<SlottedAlohaPacketData>& pkt2)
-	{
-		uint16_t replica_1 = pkt1->getReplica(0);
-		uint16_t replica_2 = pkt2->getReplica(0);
-
-		// First replica slot allows ordering
-		// TODO in terminal, we use slots sorted in the entire category,
-		// not per carrier => no module here !
-		return (((replica_1 /*% this->slots_per_carrier*/) <
-		         (replica_2 /*% this->slots_per_carrier*/)) &&
-		        (pkt1->getSrcTalId() == pkt2->getSrcTalId()) &&
-		        (pkt1->getSrcTalId())); // no need to sort simulated traffic
-	};
-
-private:
-	/// The slots per carrier
-	uint16_t slots_per_carrier; // TODO we work per category, not useful,
-	                            //      see upper todo
-};
-
-
 /**
  * @class SlottedAlohaSimu
  * @brief Parameters for Slotted Aloha traffic simulation on a category
@@ -0,0 +1,185 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file SlottedAlohaSimuLoad.cpp
+ * @brief The statistical Slotted Aloha load generation
+ * @author Viveris Technologies
+ */
+
+#include "SlottedAlohaSimuLoad.h"
+
+#include <opensand_output/Output.h>
+
+#include <algorithm>
+#include <system_error>
+
+
+SlottedAlohaSimuLoad::SlottedAlohaSimuLoad(const std::string &category,
+                                           std::size_t slots_count,
+                                           uint32_t terminals,
+                                           double mean_load,
+                                           uint16_t nb_replicas,
+                                           std::shared_ptr<OutputLog> log):
+	category{category},
+	slots_count{slots_count},
+	terminals{terminals},
+	activity{terminals ? std::min(1.0, mean_load / terminals) : 0.0},
+	nb_replicas{std::min<uint16_t>(nb_replicas, slots_count)},
+	log{log},
+	generator{std::random_device{}()},
+	current{0, {}},
+	next{0, {}},
+	thread{},
+	lock{},
+	wake_generator{},
+	wake_caller{},
+	ready{false},
+	stopping{false}
+{
+}
+
+
+SlottedAlohaSimuLoad::~SlottedAlohaSimuLoad()
+{
+	{
+		std::lock_guard<std::mutex> guard{this->lock};
+		this->stopping = true;
+	}
+	this->wake_generator.notify_all();
+	if(this->thread.joinable())
+	{
+		this->thread.join();
+	}
+}
+
+
+bool SlottedAlohaSimuLoad::start()
+{
+	try
+	{
+		this->thread = std::thread{&SlottedAlohaSimuLoad::run, this};
+	}
+	catch(const std::system_error &error)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "cannot create the Slotted Aloha load generation of category %s: %s\n",
+		    this->category.c_str(), error.what());
+		return false;
+	}
+	return true;
+}
+
+
+const std::string &SlottedAlohaSimuLoad::getCategory() const
+{
+	return this->category;
+}
+
+
+uint32_t SlottedAlohaSimuLoad::merge(std::map<unsigned int, Slot *> &slots,
+                                     uint32_t first_index)
+{
+	{
+		std::unique_lock<std::mutex> guard{this->lock};
+		this->wake_caller.wait(guard, [this]{ return this->ready; });
+		std::swap(this->current, this->next);
+		this->ready = false;
+	}
+	this->wake_generator.notify_one();
+
+	if(slots.size() != this->slots_count)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "the category %s has %zu slots instead of %zu, "
+		    "no simulated packet added\n",
+		    this->category.c_str(), slots.size(), this->slots_count);
+		return 0;
+	}
+
+	// the map is walked once, the replicas are added in slot order
+	std::vector<Slot *> slot_list;
+	slot_list.reserve(slots.size());
+	for(auto&& slot_it : slots)
+	{
+		slot_list.push_back(slot_it.second);
+	}
+	for(uint32_t packet = 0; packet < this->current.packets; ++packet)
+	{
+		for(uint16_t replica = 0; replica < this->nb_replicas; ++replica)
+		{
+			uint32_t slot = this->current.replica_slots[packet * this->nb_replicas + replica];
+			slot_list[slot]->addSimulatedPacket(first_index + packet);
+		}
+	}
+	return this->current.packets;
+}
+
+
+void SlottedAlohaSimuLoad::run()
+{
+	std::unique_lock<std::mutex> guard{this->lock};
+	while(!this->stopping)
+	{
+		if(!this->ready)
+		{
+			// the next frame is only used by this thread until it is ready
+			guard.unlock();
+			this->generate(this->next);
+			guard.lock();
+			this->ready = true;
+			this->wake_caller.notify_one();
+		}
+		this->wake_generator.wait(guard, [this]{ return this->stopping || !this->ready; });
+	}
+}
+
+
+void SlottedAlohaSimuLoad::generate(frame_t &frame)
+{
+	std::binomial_distribution<uint32_t> packets_distribution{this->terminals, this->activity};
+	std::uniform_int_distribution<uint32_t> slot_distribution{0, static_cast<uint32_t>(this->slots_count - 1)};
+
+	frame.packets = this->slots_count ? packets_distribution(this->generator) : 0;
+	frame.replica_slots.resize(frame.packets * this->nb_replicas);
+	for(uint32_t packet = 0; packet < frame.packets; ++packet)
+	{
+		// the replicas of a packet are on distinct slots
+		uint32_t *replicas = frame.replica_slots.data() + packet * this->nb_replicas;
+		for(uint16_t replica = 0; replica < this->nb_replicas; ++replica)
+		{
+			uint32_t slot;
+			do
+			{
+				slot = slot_distribution(this->generator);
+			}
+			while(std::find(replicas, replicas + replica, slot) != replicas + replica);
+			replicas[replica] = slot;
+		}
+	}
+}
@@ -0,0 +1,162 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file SlottedAlohaSimuLoad.h
+ * @brief The statistical Slotted Aloha load generation
+ * @author Viveris Technologies
+ */
+
+#ifndef SALOHA_SIMU_LOAD_H
+#define SALOHA_SIMU_LOAD_H
+
+#include "Slot.h"
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+class OutputLog;
+
+
+/**
+ * @class SlottedAlohaSimuLoad
+ * @brief Generate the random access load of a population of virtual
+ *        terminals on a category without creating packets
+ *
+ * Each virtual terminal sends a packet on a Slotted Aloha frame with a
+ * probability giving the requested mean load; a packet is only its
+ * replicas slots. The frames are generated by a background thread one
+ * frame ahead, and merged in the slots of the category as simulated
+ * packets that the collisions removal algorithms handle along with the
+ * received packets.
+ */
+class SlottedAlohaSimuLoad
+{
+public:
+	/**
+	 * @brief Constructor
+	 *
+	 * @param category     The label of the category to load
+	 * @param slots_count  The number of slots of the category
+	 * @param terminals    The number of virtual terminals
+	 * @param mean_load    The mean number of packets per frame
+	 * @param nb_replicas  The number of replicas of each packet
+	 * @param log          The log for the errors
+	 */
+	SlottedAlohaSimuLoad(const std::string &category,
+	                     std::size_t slots_count,
+	                     uint32_t terminals,
+	                     double mean_load,
+	                     uint16_t nb_replicas,
+	                     std::shared_ptr<OutputLog> log);
+	~SlottedAlohaSimuLoad();
+
+	SlottedAlohaSimuLoad(const SlottedAlohaSimuLoad &) = delete;
+	SlottedAlohaSimuLoad &operator=(const SlottedAlohaSimuLoad &) = delete;
+
+	/**
+	 * @brief Start generating the first frame in background
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool start();
+
+	/**
+	 * @brief Get the label of the loaded category
+	 *
+	 * @return the label of the category
+	 */
+	const std::string &getCategory() const;
+
+	/**
+	 * @brief Add the packets of the frame generated in background to the
+	 *        slots, then start generating the next frame
+	 *
+	 * @param slots        The slots of the category, in the order of their id
+	 * @param first_index  The index of the first simulated packet, the
+	 *                     indexes of the packets of a frame must be unique
+	 *                     in each category
+	 * @return the number of packets added
+	 */
+	uint32_t merge(std::map<unsigned int, Slot *> &slots, uint32_t first_index);
+
+private:
+	/// A frame of simulated packets
+	struct frame_t
+	{
+		/// The number of packets
+		uint32_t packets;
+		/// The slot index of each replica, nb_replicas per packet
+		std::vector<uint32_t> replica_slots;
+	};
+
+	/**
+	 * @brief The loop of the generation thread
+	 */
+	void run();
+
+	/**
+	 * @brief Draw the packets of a frame
+	 *
+	 * @param frame  OUT: the frame
+	 */
+	void generate(frame_t &frame);
+
+	std::string category;
+	std::size_t slots_count;
+	uint32_t terminals;
+	double activity;
+	uint16_t nb_replicas;
+	std::shared_ptr<OutputLog> log;
+
+	/// The random generator, only used by the generation thread
+	std::mt19937_64 generator;
+
+	/// The frame being merged and the frame generated in background
+	frame_t current;
+	frame_t next;
+
+	std::thread thread;
+	std::mutex lock;
+	std::condition_variable wake_generator;
+	std::condition_variable wake_caller;
+
+	/// Whether the next frame is generated
+	bool ready;
+
+	bool stopping;
+};
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file SlottedAlohaSlots.cpp
+ * @brief The flat model of the Slotted Aloha slots shared by the algos
+ * @author Viveris Technologies
+*/
+
+#include "SlottedAlohaSlots.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+void SlottedAlohaSlots::build(const std::map<unsigned int, Slot *> &slots)
+{
+	this->slot_list.clear();
+	this->slot_start.clear();
+	this->occupancy.clear();
+	this->replica_slot.clear();
+	this->replica_position.clear();
+	for(auto&& slot_it : slots)
+	{
+		Slot *slot = slot_it.second;
+		const uint32_t slot_index = this->slot_list.size();
+		const std::size_t packets = slot->size();
+		const std::size_t total = packets + slot->getSimulatedPackets().size();
+		this->slot_list.push_back(slot);
+		this->slot_start.push_back(this->replica_slot.size());
+		this->occupancy.push_back(total < UINT8_MAX ? total : UINT8_MAX);
+		this->replica_slot.insert(this->replica_slot.end(), total, slot_index);
+		for(std::size_t position = 0; position < packets; ++position)
+		{
+			this->replica_position.push_back(position);
+		}
+		this->replica_position.insert(this->replica_position.end(),
+		                              total - packets, simulated_position);
+	}
+	this->slot_start.push_back(this->replica_slot.size());
+	this->occupancy.resize((this->slot_list.size() + 63) / 64 * 64, 0);
+	this->computeMasks();
+}
+
+void SlottedAlohaSlots::computeMasks()
+{
+	const std::size_t words = this->occupancy.size() / 64;
+	this->single_mask.resize(words);
+	this->collision_mask.resize(words);
+	this->used_mask.resize(words);
+	for(std::size_t word = 0; word < words; ++word)
+	{
+		const uint8_t *counts = this->occupancy.data() + word * 64;
+		uint64_t single = 0;
+		uint64_t at_most_one = 0;
+		uint64_t empty = 0;
+#ifdef __SSE2__
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i one = _mm_set1_epi8(1);
+		for(unsigned int lane = 0; lane < 4; ++lane)
+		{
+			const __m128i value = _mm_loadu_si128(
+				reinterpret_cast<const __m128i *>(counts + lane * 16));
+			const unsigned int shift = lane * 16;
+			// there is no unsigned compare, count <= 1 iff min(count, 1) == count
+			single |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(value, one)))) << shift;
+			at_most_one |= uint64_t(uint16_t(_mm_movemask_epi8(
+				_mm_cmpeq_epi8(_mm_min_epu8(value, one), value)))) << shift;
+			empty |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(value, zero)))) << shift;
+		}
+#else
+		for(unsigned int slot = 0; slot < 64; ++slot)
+		{
+			single |= uint64_t(counts[slot] == 1) << slot;
+			at_most_one |= uint64_t(counts[slot] <= 1) << slot;
+			empty |= uint64_t(counts[slot] == 0) << slot;
+		}
+#endif
+		this->single_mask[word] = single;
+		this->collision_mask[word] = ~at_most_one;
+		this->used_mask[word] = ~empty;
+	}
+}
+
+std::size_t SlottedAlohaSlots::findNext(const std::vector<uint64_t> &mask,
+                                        std::size_t from) const
+{
+	std::size_t word = from / 64;
+	if(word >= mask.size())
+	{
+		return this->slot_list.size();
+	}
+	uint64_t bits = mask[word] & (~UINT64_C(0) << (from % 64));
+	while(!bits)
+	{
+		if(++word >= mask.size())
+		{
+			return this->slot_list.size();
+		}
+		bits = mask[word];
+	}
+	// the padding slots are empty, they are never set
+	return word * 64 + __builtin_ctzll(bits);
+}
+
+void SlottedAlohaSlots::release()
+{
+	std::size_t slot = 0;
+	while((slot = this->findNext(this->used_mask, slot)) < this->slot_list.size())
+	{
+		this->slot_list[slot]->release();
+		++slot;
+	}
+}
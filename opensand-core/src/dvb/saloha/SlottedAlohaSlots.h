@@ -0,0 +1,217 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file SlottedAlohaSlots.h
+ * @brief The flat model of the Slotted Aloha slots shared by the algos
+ * @author Viveris Technologies
+*/
+
+#ifndef SALOHA_SLOTS_H
+#define SALOHA_SLOTS_H
+
+#include "Slot.h"
+
+#include <map>
+#include <vector>
+
+
+/**
+ * @class SlottedAlohaSlots
+ * @brief The slots of a frame flattened in contiguous arrays
+ *
+ * The replicas of each slot are indexed in a CSR layout, the number of
+ * replicas of each slot is kept in a saturated byte array which the
+ * collision masks are computed from, 16 slots at a time with SSE2.
+ * The algos only dereference the packets of the slots they keep.
+*/
+class SlottedAlohaSlots
+{
+public:
+	/// The position of the replicas of the simulated packets
+	static constexpr uint32_t simulated_position = UINT32_MAX;
+
+	/**
+	 * @brief Flatten the slots and compute their masks
+	 *
+	 * @param slots  The slots, in the order of their id
+	 */
+	void build(const std::map<unsigned int, Slot *> &slots);
+
+	/**
+	 * @brief Get the number of slots
+	 *
+	 * @return the number of slots
+	 */
+	inline std::size_t getSlotsCount() const
+	{
+		return this->slot_list.size();
+	}
+
+	/**
+	 * @brief Get a slot
+	 *
+	 * @param slot  The slot index
+	 * @return the slot
+	 */
+	inline Slot *getSlot(std::size_t slot) const
+	{
+		return this->slot_list[slot];
+	}
+
+	/**
+	 * @brief Get the index of the first replica of a slot
+	 *
+	 * @param slot  The slot index
+	 * @return the index of the first replica, the replicas count
+	 *         for the slot following the last one
+	 */
+	inline uint32_t getFirstReplica(std::size_t slot) const
+	{
+		return this->slot_start[slot];
+	}
+
+	/**
+	 * @brief Get the number of replicas in a slot, simulated ones included
+	 *
+	 * @param slot  The slot index
+	 * @return the number of replicas
+	 */
+	inline uint32_t getReplicasCount(std::size_t slot) const
+	{
+		return this->slot_start[slot + 1] - this->slot_start[slot];
+	}
+
+	/**
+	 * @brief Get the total number of replicas
+	 *
+	 * @return the number of replicas
+	 */
+	inline std::size_t getReplicasCount() const
+	{
+		return this->replica_slot.size();
+	}
+
+	/**
+	 * @brief Get the slot of a replica
+	 *
+	 * @param replica  The replica index
+	 * @return the slot index
+	 */
+	inline uint32_t getReplicaSlot(uint32_t replica) const
+	{
+		return this->replica_slot[replica];
+	}
+
+	/**
+	 * @brief Get the position of a replica in its slot
+	 *
+	 * @param replica  The replica index
+	 * @return the position of the packet in the slot,
+	 *         simulated_position for a simulated packet
+	 */
+	inline uint32_t getReplicaPosition(uint32_t replica) const
+	{
+		return this->replica_position[replica];
+	}
+
+	/**
+	 * @brief Get the simulated packet of a replica
+	 *
+	 * @param replica  The replica index, a simulated one
+	 * @return the index of the simulated packet
+	 */
+	inline uint32_t getSimulatedPacket(uint32_t replica) const
+	{
+		std::size_t slot = this->replica_slot[replica];
+		return this->slot_list[slot]->getSimulatedPackets()[replica - this->slot_start[slot] -
+		                                                    this->slot_list[slot]->size()];
+	}
+
+	/**
+	 * @brief Get the slots holding a single replica
+	 *
+	 * @return the bitmap of the slots, 64 slots per word
+	 */
+	inline const std::vector<uint64_t> &getSingleMask() const
+	{
+		return this->single_mask;
+	}
+
+	/**
+	 * @brief Get the slots holding more than one replica
+	 *
+	 * @return the bitmap of the slots, 64 slots per word
+	 */
+	inline const std::vector<uint64_t> &getCollisionMask() const
+	{
+		return this->collision_mask;
+	}
+
+	/**
+	 * @brief Find the next slot set in a bitmap
+	 *
+	 * @param mask  The bitmap of the slots
+	 * @param from  The first slot index to check
+	 * @return the slot index, the slots count if there is none
+	 */
+	std::size_t findNext(const std::vector<uint64_t> &mask, std::size_t from) const;
+
+	/**
+	 * @brief Release the packets of all the slots holding replicas
+	 */
+	void release();
+
+private:
+	/**
+	 * @brief Compute the masks from the occupancy of the slots
+	 */
+	void computeMasks();
+
+	/// The slots, in the order of their id
+	std::vector<Slot *> slot_list;
+	/// The index of the first replica of each slot, and the replicas count
+	std::vector<uint32_t> slot_start;
+	/// The number of replicas of each slot saturated at 255, padded
+	/// with empty slots up to a multiple of 64
+	std::vector<uint8_t> occupancy;
+
+	/// The slot of each replica
+	std::vector<uint32_t> replica_slot;
+	/// The position of each replica in its slot
+	std::vector<uint32_t> replica_position;
+
+	/// The slots holding a single replica
+	std::vector<uint64_t> single_mask;
+	/// The slots holding more than one replica
+	std::vector<uint64_t> collision_mask;
+	/// The slots holding at least one replica
+	std::vector<uint64_t> used_mask;
+};
+
+#endif
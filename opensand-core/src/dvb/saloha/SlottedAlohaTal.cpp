@@ -49,6 +49,7 @@ SlottedAlohaTal::SlottedAlohaTal():
 	SlottedAloha(),
 	tal_id(),
 	timeout_saf(),
+	saframe_tick(0),
 	packets_wait_ack(),
 	nb_success(0),
 	nb_max_packets(0),
@@ -294,6 +295,8 @@ std::unique_ptr<SlottedAlohaPacketData> SlottedAlohaTal::addSalohaHeader(std::un
 bool SlottedAlohaTal::onRcvFrame(DvbFrame *dvb_frame)
 {
 	SlottedAlohaFrame *frame;
+	const unsigned char *payload;
+	size_t payload_length;
 	size_t previous_length;
 
 	// TODO static cast
@@ -309,15 +312,29 @@ bool SlottedAlohaTal::onRcvFrame(DvbFrame *dvb_frame)
 	    "New Slotted Aloha frame containing %u packets\n",
 	    frame->getDataLength());
 
+	// the control packets are read in place
+	payload = frame->getRawData() + frame->getHeaderLength();
+	payload_length = frame->getPayloadLength();
 	previous_length = 0;
 	for(unsigned int cpt = 0; cpt < frame->getDataLength(); cpt++)
 	{
 		SlottedAlohaPacketCtrl *ctrl_pkt;
-		Data payload = frame->getPayload(previous_length);
-		size_t current_length =
-			SlottedAlohaPacketCtrl::getPacketLength(payload);
+		const saloha_ctrl_hdr_t *header;
+		size_t current_length = 0;
 
-		ctrl_pkt = new SlottedAlohaPacketCtrl(payload.c_str(),
+		header = (const saloha_ctrl_hdr_t *)(payload + previous_length);
+		if(payload_length - previous_length >= sizeof(saloha_ctrl_hdr_t))
+		{
+			current_length = ntohs(header->total_length);
+		}
+		if(current_length < sizeof(saloha_ctrl_hdr_t) ||
+		   current_length > payload_length - previous_length)
+		{
+			LOG(this->log_saloha, LEVEL_ERROR,
+			    "truncated Slotted Aloha control packet\n");
+			break;
+		}
+		ctrl_pkt = new SlottedAlohaPacketCtrl(payload + previous_length,
 		                                      current_length);
 		previous_length += current_length;
 		if(!ctrl_pkt)
@@ -337,41 +354,32 @@ bool SlottedAlohaTal::onRcvFrame(DvbFrame *dvb_frame)
 		{
 			case SALOHA_CTRL_ACK:
 			{
-				uint16_t ids[4];
-				bool dup = true;
-				saloha_packets_data_t::iterator packet;
-				saloha_id_t id = ctrl_pkt->getId();
-				delete ctrl_pkt;
-
-				SlottedAlohaPacket::convertPacketId(id, ids);
-				packet = this->packets_wait_ack[ids[SALOHA_ID_QOS]].begin();
-				LOG(this->log_saloha, LEVEL_DEBUG,
-				    "ACK received for packet with ID %s\n",
-				    id.c_str());
-				while(packet != this->packets_wait_ack[ids[SALOHA_ID_QOS]].end())
+				// the packets of the terminal acknowledged at once
+				for(std::size_t index = 0; index < ctrl_pkt->getAcksCount(); ++index)
 				{
-					saloha_id_t data_id = (*packet)->getUniqueId();
-					if(id == data_id)
+					saloha_ack_id_t id = ctrl_pkt->getAck(index);
+
+					LOG(this->log_saloha, LEVEL_DEBUG,
+					    "ACK received for packet with ID %u:%u:%u:%u\n",
+					    id.id, id.seq, id.pdu_nb, id.qos);
+					if(this->packets_wait_ack.ack(id))
 					{
 						uint16_t cw;
 						LOG(this->log_saloha, LEVEL_DEBUG,
-						    "Packet with ID %s found in packets waiting for ack "
-						    "and removed\n", data_id.c_str());
+						    "Packet with ID %u:%u:%u:%u found in packets waiting "
+						    "for ack and removed\n", id.id, id.seq, id.pdu_nb, id.qos);
 						this->nb_success++;
 						cw = this->backoff->setReady();
 						this->probe_backoff->put(cw);
-						this->packets_wait_ack[ids[SALOHA_ID_QOS]].erase(packet);
-						dup = false;
-						break;
 					}
-					packet++;
-				}
-				if(dup)
-				{
-					LOG(this->log_saloha, LEVEL_NOTICE,
-					    "Potentially duplicated ACK received for ID %s\n",
-					    id.c_str());
+					else
+					{
+						LOG(this->log_saloha, LEVEL_NOTICE,
+						    "Potentially duplicated ACK received for ID %u:%u:%u:%u\n",
+						    id.id, id.seq, id.pdu_nb, id.qos);
+					}
 				}
+				delete ctrl_pkt;
 				break;
 			}
 			//NB: Possibility to add new control signals
@@ -393,7 +401,7 @@ bool SlottedAlohaTal::schedule(std::list<DvbFrame *> &complete_dvb_frames,
                                time_sf_t sf_counter)
 {
 	uint16_t nb_retransmissions;
-	std::map<qos_t, saloha_packets_data_t>::iterator wack_it;
+	saloha_packets_data_t expired;
 	saloha_packets_data_t::iterator packet;
 	SlottedAlohaFrame *frame;
 	saloha_ts_list_t ts;
@@ -407,17 +415,9 @@ bool SlottedAlohaTal::schedule(std::list<DvbFrame *> &complete_dvb_frames,
 	}
 	this->backoff->tick();
 	nb_retransmissions = 0;
-	// Decrease timeout of waiting packets
+	// The waiting packets deadlines are counted in Slotted Aloha frames
 	// We do that here because we may skip depending on backoff
-	for(wack_it = this->packets_wait_ack.begin();
-	    wack_it != this->packets_wait_ack.end();
-	    ++wack_it)
-	{
-		for(auto&& packet : wack_it->second)
-		{
-			packet->decTimeout();
-		}
-	}
+	this->saframe_tick++;
 
 	if(!this->backoff->isReady())
 	{
@@ -432,43 +432,30 @@ bool SlottedAlohaTal::schedule(std::list<DvbFrame *> &complete_dvb_frames,
 	}
 
 	// If waiting packets can be retransmitted, store them in retransmission_packets
-	for(wack_it = this->packets_wait_ack.begin();
-	    wack_it != this->packets_wait_ack.end();
-	    ++wack_it)
+	this->packets_wait_ack.popExpired(this->saframe_tick, expired);
+	for(auto&& sa_packet : expired)
 	{
-		packet = wack_it->second.begin();
-		while(packet != wack_it->second.end())
+		if(sa_packet->canBeRetransmitted(this->nb_max_retransmissions))
 		{
-			auto& sa_packet = *packet;
-			if(sa_packet->isTimeout())
-			{
-				if(sa_packet->canBeRetransmitted(this->nb_max_retransmissions))
-				{
-					LOG(this->log_saloha, LEVEL_NOTICE,
-					    "Packet %s not acked, will be retransmitted\n",
-					    sa_packet->getUniqueId().c_str());
-					sa_packet->incNbRetransmissions();
-					sa_packet->setTimeout(this->timeout_saf);
-					this->retransmission_packets.insert(
-						this->retransmission_packets.begin() + nb_retransmissions,
-						std::move(sa_packet));
-					nb_retransmissions++;
-				}
-				else
-				{
-					uint16_t cw;
-					LOG(this->log_saloha, LEVEL_WARNING,
-					    "Packet %s lost\n",
-					    sa_packet->getUniqueId().c_str());
-					this->probe_drop[sa_packet->getQos()]->put(1);
-					cw = this->backoff->setCollision();
-					this->probe_backoff->put(cw);
-				}
-				// erase goes to next iterator
-				wack_it->second.erase(packet);
-				continue;
-			}
-			packet++;
+			LOG(this->log_saloha, LEVEL_NOTICE,
+			    "Packet %s not acked, will be retransmitted\n",
+			    sa_packet->getUniqueId().c_str());
+			sa_packet->incNbRetransmissions();
+			sa_packet->setTimeout(this->timeout_saf);
+			this->retransmission_packets.insert(
+				this->retransmission_packets.begin() + nb_retransmissions,
+				std::move(sa_packet));
+			nb_retransmissions++;
+		}
+		else
+		{
+			uint16_t cw;
+			LOG(this->log_saloha, LEVEL_WARNING,
+			    "Packet %s lost\n",
+			    sa_packet->getUniqueId().c_str());
+			this->probe_drop[sa_packet->getQos()]->put(1);
+			cw = this->backoff->setCollision();
+			this->probe_backoff->put(cw);
 		}
 	}
 
@@ -542,12 +529,15 @@ bool SlottedAlohaTal::schedule(std::list<DvbFrame *> &complete_dvb_frames,
 		{
 			continue;
 		}
-		while(fifo->getCurrentSize() &&
+		// the packets are taken in place, their elements are removed at once
+		vol_pkt_t consumed = 0;
+		while(consumed < fifo->getCurrentSize() &&
 		      nbr_packets_total + this->nb_replicas <= ts.size())
 		{
-			FifoElement *elem = fifo->pop();
-			std::unique_ptr<SlottedAlohaPacketData> sa_packet = elem->getElem<SlottedAlohaPacketData>();
+			FifoElement &elem = fifo->peek(consumed);
+			std::unique_ptr<SlottedAlohaPacketData> sa_packet = elem.getElem<SlottedAlohaPacketData>();
 			auto replicas = sa_packet->getNbReplicas();
+			consumed++;
 
 			if(!this->addPacketInFrames(complete_dvb_frames,
 			                            &frame, std::move(sa_packet),
@@ -557,10 +547,10 @@ bool SlottedAlohaTal::schedule(std::list<DvbFrame *> &complete_dvb_frames,
 				    "failed to add a Slotted Aloha packet in data frame");
 				continue;
 			}
-			delete elem;
 			nbr_packets++;
 			nbr_packets_total += replicas;
 		}
+		fifo->consume(consumed);
 		if(nbr_packets)
 		{
 			LOG(this->log_saloha, LEVEL_INFO,
@@ -586,11 +576,9 @@ bool SlottedAlohaTal::schedule(std::list<DvbFrame *> &complete_dvb_frames,
 	}
 
 skip:
-	for(wack_it = this->packets_wait_ack.begin();
-	    wack_it != this->packets_wait_ack.end();
-	    ++wack_it)
+	for(auto&& probe : this->probe_wait_ack)
 	{
-		this->probe_wait_ack[(*wack_it).first]->put((*wack_it).second.size());
+		probe.second->put(this->packets_wait_ack.size(probe.first));
 	}
 
 	// keep the probes refreshing
@@ -703,7 +691,7 @@ bool SlottedAlohaTal::addPacketInFrames(std::list<DvbFrame *> &complete_dvb_fram
 		}
 	}
 
-	this->packets_wait_ack[qos].push_back(std::move(packet));
+	this->packets_wait_ack.push(std::move(packet), qos, this->saframe_tick);
 
 	return true;
 }
@@ -38,6 +38,7 @@
 
 #include "SlottedAloha.h"
 
+#include "SlottedAlohaAckQueue.h"
 #include "SlottedAlohaBackoff.h"
 #include "SlottedAlohaFrame.h"
 #include "SlottedAlohaAlgo.h"
@@ -65,8 +66,12 @@ private:
 	/// packet timeout in Slotted Aloha frame number
 	time_sf_t timeout_saf;
 
+	/// The number of Slotted Aloha frames since the start,
+	/// the clock of the ACK deadlines
+	uint64_t saframe_tick;
+
 	/// The packets waiting for ACK
-	std::map<qos_t, saloha_packets_data_t> packets_wait_ack;
+	SlottedAlohaAckQueue packets_wait_ack;
 
 	/// list of  packets to be retransmitted
 	saloha_packets_data_t retransmission_packets;
@@ -0,0 +1,335 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * Benchmark of the CRDSA collisions removal
+ *
+ * The application fills the slots of a random access carrier with the
+ * replicas of packets sent by synthetic terminals, then removes the
+ * collisions with the CRDSA algorithm and with a reference version of
+ * the successive interference cancellation looping on the slots and on
+ * the accepted ids, and checks that both decode the same packets in the
+ * same order and count the same collisions.
+ *
+ * For each load, it reports the mean time to remove the collisions of
+ * a Slotted Aloha frame with both versions and the decoding ratio.
+ *
+ * Launch the application with -h to learn how to use it.
+ *
+ * Author: Viveris Technologies
+ */
+
+// OpenSAND includes
+#include "SlottedAlohaAlgoCrdsa.h"
+#include "SlottedAlohaPacketData.h"
+#include "Slot.h"
+
+#include <opensand_output/Output.h>
+
+// system includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+
+/// The program usage
+#define USAGE \
+"CRDSA benchmark: measure the CRDSA collisions removal on synthetic random access traffic\n\n\
+usage: bench_crdsa [-h] [-s slots] [-r replicas] [-f frames] [load...]\n\
+\t-h           print this usage and exit\n\
+\t-s slots     the number of slots of the carrier (default: 4096)\n\
+\t-r replicas  the number of replicas of each packet (default: 3)\n\
+\t-f frames    the number of Slotted Aloha frames of each load (default: 20)\n\
+\tload         the number of packets per slot (default: 0.2 0.4 0.5 0.6 0.8)\n\n"
+
+#define ERROR(format, ...) \
+	do { \
+		fprintf(stderr, format, ##__VA_ARGS__); \
+	} while(0)
+
+
+/// The number of packets sent by each synthetic terminal on a frame
+static const unsigned int packets_per_terminal = 4;
+
+
+/**
+ * @brief The slots of a carrier, owning them
+ */
+class Slots: public std::map<unsigned int, Slot *>
+{
+public:
+	Slots(unsigned int count)
+	{
+		for(unsigned int id = 0; id < count; ++id)
+		{
+			(*this)[id] = new Slot(0, id);
+		}
+	}
+
+	~Slots()
+	{
+		for(auto &&slot_it: *this)
+		{
+			delete slot_it.second;
+		}
+	}
+};
+
+
+/**
+ * @brief Fill the slots with the replicas of random packets
+ *
+ * @param slots      The slots to fill
+ * @param packets    The number of packets
+ * @param replicas   The number of replicas of each packet
+ * @param generator  The random generator
+ */
+static void fillSlots(Slots &slots, unsigned int packets, uint16_t replicas,
+                      std::mt19937 &generator)
+{
+	std::uniform_int_distribution<unsigned int> slot_distribution(0, slots.size() - 1);
+	std::vector<uint16_t> time_slots(replicas);
+	for(unsigned int packet = 0; packet < packets; ++packet)
+	{
+		const uint8_t tal_id = 1 + (packet / packets_per_terminal) % 250;
+		const saloha_pdu_id_t pdu_id = packet / (packets_per_terminal * 250);
+		const uint16_t seq = packet % packets_per_terminal;
+
+		// distinct slots for the replicas of a packet
+		for(uint16_t replica = 0; replica < replicas; ++replica)
+		{
+			uint16_t slot;
+			do
+			{
+				slot = slot_distribution(generator);
+			}
+			while(std::find(time_slots.begin(), time_slots.begin() + replica, slot) !=
+			      time_slots.begin() + replica);
+			time_slots[replica] = slot;
+		}
+		std::sort(time_slots.begin(), time_slots.end());
+
+		for(uint16_t replica = 0; replica < replicas; ++replica)
+		{
+			auto sa_packet = std::unique_ptr<SlottedAlohaPacketData>(
+				new SlottedAlohaPacketData(Data(), pdu_id, time_slots[replica],
+				                           seq, packets_per_terminal, replicas, 0));
+			sa_packet->setSrcTalId(tal_id);
+			sa_packet->setQos(0);
+			sa_packet->setReplicas(time_slots.data(), replicas);
+			slots[time_slots[replica]]->push_back(std::move(sa_packet));
+		}
+	}
+}
+
+
+/**
+ * @brief The reference successive interference cancellation: loop on the
+ *        slots until no packet is decoded, remove from each slot the
+ *        replicas of the packets already accepted and accept the packet
+ *        of the slots holding a single one
+ */
+static uint16_t referenceRemoveCollisions(std::map<unsigned int, Slot *> &slots,
+                                          saloha_packets_data_t *accepted_packets)
+{
+	std::map<tal_id_t, std::vector<saloha_id_t>> accepted_ids;
+	uint16_t nbr_collisions = 0;
+	bool stop;
+
+	do
+	{
+		stop = true;
+		for(auto &&slot_it: slots)
+		{
+			Slot *slot = slot_it.second;
+			auto pkt_it = slot->begin();
+			while(pkt_it != slot->end())
+			{
+				auto &ids = accepted_ids[(*pkt_it)->getSrcTalId()];
+				if(std::find(ids.begin(), ids.end(), (*pkt_it)->getUniqueId()) != ids.end())
+				{
+					pkt_it = slot->erase(pkt_it);
+					continue;
+				}
+				pkt_it++;
+			}
+			if(slot->size() == 1)
+			{
+				auto &packet = slot->front();
+				accepted_ids[packet->getSrcTalId()].push_back(packet->getUniqueId());
+				accepted_packets->push_back(std::move(packet));
+				slot->clear();
+				stop = false;
+			}
+		}
+	}
+	while(!stop);
+
+	for(auto &&slot_it: slots)
+	{
+		Slot *slot = slot_it.second;
+		if(slot->size() > 1)
+		{
+			nbr_collisions += slot->size();
+		}
+		slot->clear();
+	}
+	return nbr_collisions;
+}
+
+
+/**
+ * @brief Describe the decoded packets: their terminal, unique id
+ *        and slot, in decoding order
+ */
+static std::string describe(const saloha_packets_data_t &packets)
+{
+	std::ostringstream description;
+	for(auto &&packet: packets)
+	{
+		description << (int)packet->getSrcTalId() << '/'
+		            << packet->getUniqueId().c_str() << '@'
+		            << packet->getTs() << ' ';
+	}
+	return description.str();
+}
+
+
+int main(int argc, char *argv[])
+{
+	unsigned int slots_count = 4096;
+	uint16_t replicas = 3;
+	unsigned int frames = 20;
+	std::vector<double> loads;
+	int opt;
+
+	while((opt = getopt(argc, argv, "hs:r:f:")) != -1)
+	{
+		switch(opt)
+		{
+			case 's':
+				slots_count = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'r':
+				replicas = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'f':
+				frames = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'h':
+			default:
+				ERROR(USAGE);
+				return EXIT_FAILURE;
+		}
+	}
+	for(int index = optind; index < argc; ++index)
+	{
+		loads.push_back(std::strtod(argv[index], nullptr));
+	}
+	if(loads.empty())
+	{
+		loads = {0.2, 0.4, 0.5, 0.6, 0.8};
+	}
+	if(slots_count == 0 || slots_count > UINT16_MAX + 1 || replicas == 0 ||
+	   replicas > slots_count || frames == 0)
+	{
+		ERROR(USAGE);
+		return EXIT_FAILURE;
+	}
+
+	auto output = Output::Get();
+	output->configureTerminalOutput();
+	std::unique_ptr<SlottedAlohaAlgo> algo{new SlottedAlohaAlgoCrdsa()};
+	output->finalizeConfiguration();
+
+	printf("%u slots, %u replicas, %u frames per load\n\n", slots_count, replicas, frames);
+	printf("%6s %10s %12s %14s %9s %10s\n",
+	       "load", "packets", "crdsa (us)", "reference (us)", "speedup", "decoded");
+
+	bool identical = true;
+	for(double load: loads)
+	{
+		const unsigned int packets = load * slots_count;
+		std::chrono::nanoseconds crdsa_time{0};
+		std::chrono::nanoseconds reference_time{0};
+		uint64_t decoded = 0;
+
+		for(unsigned int frame = 0; frame < frames; ++frame)
+		{
+			Slots crdsa_slots{slots_count};
+			Slots reference_slots{slots_count};
+			std::mt19937 crdsa_generator{frame};
+			std::mt19937 reference_generator{frame};
+			fillSlots(crdsa_slots, packets, replicas, crdsa_generator);
+			fillSlots(reference_slots, packets, replicas, reference_generator);
+
+			saloha_packets_data_t crdsa_packets;
+			saloha_packets_data_t reference_packets;
+
+			auto start = std::chrono::steady_clock::now();
+			uint16_t crdsa_collisions = algo->removeCollisions(crdsa_slots, &crdsa_packets);
+			auto middle = std::chrono::steady_clock::now();
+			uint16_t reference_collisions = referenceRemoveCollisions(reference_slots,
+			                                                          &reference_packets);
+			auto end = std::chrono::steady_clock::now();
+			crdsa_time += middle - start;
+			reference_time += end - middle;
+			decoded += crdsa_packets.size();
+
+			if(crdsa_collisions != reference_collisions ||
+			   describe(crdsa_packets) != describe(reference_packets))
+			{
+				ERROR("load %.2f, frame %u: the CRDSA algorithm decoded %zu packets "
+				      "with %u collisions, the reference %zu packets with %u collisions\n",
+				      load, frame, crdsa_packets.size(), crdsa_collisions,
+				      reference_packets.size(), reference_collisions);
+				identical = false;
+			}
+		}
+
+		const double crdsa_us = crdsa_time.count() / 1000.0 / frames;
+		const double reference_us = reference_time.count() / 1000.0 / frames;
+		printf("%6.2f %10u %12.1f %14.1f %8.1fx %9.1f%%\n",
+		       load, packets, crdsa_us, reference_us,
+		       crdsa_us > 0 ? reference_us / crdsa_us : 0.0,
+		       packets ? decoded * 100.0 / (packets * frames) : 100.0);
+	}
+
+	if(!identical)
+	{
+		ERROR("\nthe CRDSA algorithm and the reference differ\n");
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
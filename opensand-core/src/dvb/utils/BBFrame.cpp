@@ -93,16 +93,28 @@ BBFrame::~BBFrame()
 
 bool BBFrame::addPacket(NetPacket *packet)
 {
-	bool is_added;
-
-	is_added = DvbFrameTpl<T_DVB_BBFRAME>::addPacket(packet);
-	if(is_added)
+	// is the frame large enough to contain the packet ?
+	if(packet->getTotalLength() > this->getFreeSpace())
 	{
-		this->setMessageLength(this->getMessageLength() + packet->getTotalLength());
-		this->frame()->data_length = htons(this->num_packets);
+		return false;
 	}
 
-	return is_added;
+	this->data.append(packet->getData());
+	this->commitPacket(packet->getTotalLength());
+
+	return true;
+}
+
+Data &BBFrame::getPacketBuffer(void)
+{
+	return this->data;
+}
+
+void BBFrame::commitPacket(std::size_t length)
+{
+	this->num_packets++;
+	this->setMessageLength(this->getMessageLength() + length);
+	this->frame()->data_length = htons(this->num_packets);
 }
 
 // TODO not used => remove ?!
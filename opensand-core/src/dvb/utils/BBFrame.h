@@ -44,7 +44,7 @@
  * @class BBFrame
  * @brief BB frame
  */
-class BBFrame: public DvbFrameTpl<T_DVB_BBFRAME>
+class BBFrame final: public DvbFrameTpl<T_DVB_BBFRAME>
 {
 public:
 	/**
@@ -80,10 +80,26 @@ public:
 	 */
 	~BBFrame();
 
-	// implementation of virtual functions
+	// specialization of the frame accessors
 	bool addPacket(NetPacket *packet);
 	void empty(void);
 
+	/**
+	 * @brief Get the buffer of the BB frame, for an encapsulation
+	 *        packet to be written at its end in place
+	 *
+	 * @return the buffer of the BB frame
+	 */
+	Data &getPacketBuffer(void);
+
+	/**
+	 * @brief Account an encapsulation packet written in place at the
+	 *        end of the BB frame buffer
+	 *
+	 * @param length  the length of the packet
+	 */
+	void commitPacket(std::size_t length);
+
 	// BB frame specific
 
 	/**
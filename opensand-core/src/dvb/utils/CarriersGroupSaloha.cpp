@@ -89,3 +89,13 @@ std::map<unsigned int, Slot *> CarriersGroupSaloha::getSlots(void) const
 {
 	return this->slots;
 }
+
+Slot *CarriersGroupSaloha::getSlot(unsigned int slot_id) const
+{
+	auto slot_it = this->slots.find(slot_id);
+	if(slot_it == this->slots.end())
+	{
+		return nullptr;
+	}
+	return slot_it->second;
+}
@@ -89,6 +89,14 @@ public:
 	 */
 	std::map<unsigned int, Slot *> getSlots(void) const;
 
+	/**
+	 * @brief Get a slot
+	 *
+	 * @param slot_id  The slot ID in the terminal category
+	 * @return the slot, nullptr if it is not in the carriers group
+	 */
+	Slot *getSlot(unsigned int slot_id) const;
+
 private:
 	/** The slots */
 	std::map<unsigned int, Slot *> slots;
@@ -0,0 +1,114 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file    ControlBundle.cpp
+ * @brief   Represent the control frames of a superframe sent at once
+ * @author  Viveris Technologies
+ */
+
+#include "ControlBundle.h"
+
+
+ControlBundle::ControlBundle():
+	DvbFrame()
+{
+	// keep room for the physical layer trailer
+	this->setMaxSize(MSG_CTRL_BUNDLE_SIZE_MAX - sizeof(T_DVB_PHY));
+	this->setMessageType(EmulatedMessageType::CtrlBundle);
+	this->setMessageLength(sizeof(T_DVB_HDR));
+}
+
+ControlBundle::~ControlBundle()
+{
+}
+
+bool ControlBundle::addFrame(const DvbFrame &frame)
+{
+	uint16_t frame_length = frame.getMessageLength();
+	if(frame_length < sizeof(T_DVB_HDR) || frame_length > this->getFreeSpace())
+	{
+		return false;
+	}
+
+	this->data.append(frame.getRawData(), frame_length);
+	this->setMessageLength(this->getMessageLength() + frame_length);
+	this->num_packets++;
+	return true;
+}
+
+unsigned int ControlBundle::getFramesCount() const
+{
+	return this->num_packets;
+}
+
+bool ControlBundle::split(const DvbFrame &bundle, std::vector<DvbFrame *> &frames)
+{
+	const uint8_t *raw = bundle.getRawData();
+	std::size_t length = bundle.getMessageLength();
+	// only the physical layer adds a trailer, holding the C/N
+	bool has_cn = bundle.getTotalLength() > length;
+	double cn = has_cn ? bundle.getCn() : 0.0;
+	std::size_t offset = sizeof(T_DVB_HDR);
+
+	frames.clear();
+	while(offset < length)
+	{
+		if(length - offset < sizeof(T_DVB_HDR))
+		{
+			break;
+		}
+		const T_DVB_HDR *hdr = reinterpret_cast<const T_DVB_HDR *>(raw + offset);
+		std::size_t frame_length = ntohs(hdr->msg_length);
+		if(frame_length < sizeof(T_DVB_HDR) || frame_length > length - offset)
+		{
+			break;
+		}
+
+		DvbFrame *frame = new DvbFrame(raw + offset, frame_length);
+		frame->setCarrierId(bundle.getCarrierId());
+		frame->setSpot(bundle.getSpot());
+		if(has_cn)
+		{
+			frame->setCn(cn);
+		}
+		frames.push_back(frame);
+		offset += frame_length;
+	}
+
+	if(offset != length)
+	{
+		for(DvbFrame *frame: frames)
+		{
+			delete frame;
+		}
+		frames.clear();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,89 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file    ControlBundle.h
+ * @brief   Represent the control frames of a superframe sent at once
+ * @author  Viveris Technologies
+ */
+
+#ifndef _CONTROL_BUNDLE_H_
+#define _CONTROL_BUNDLE_H_
+
+
+#include <vector>
+
+#include "OpenSandCore.h"
+#include "DvbFrame.h"
+
+
+/**
+ * @class ControlBundle
+ * @brief Represent the control frames of a superframe sent at once
+ *
+ * The frames follow the bundle header back to back, each one with its
+ * own DVB header giving its length.
+ */
+class ControlBundle: public DvbFrame
+{
+public:
+	/**
+	 * @brief Build an empty bundle for NCC (sender)
+	 */
+	ControlBundle();
+
+	~ControlBundle();
+
+	/**
+	 * @brief Append a frame to the bundle
+	 *
+	 * @param frame  The frame, it is copied without its physical layer trailer
+	 * @return true if the frame was added, false if the bundle is full
+	 */
+	bool addFrame(const DvbFrame &frame);
+
+	/**
+	 * @brief Get the number of frames in the bundle
+	 *
+	 * @return the number of frames
+	 */
+	unsigned int getFramesCount() const;
+
+	/**
+	 * @brief Split a received bundle into its frames, they get the C/N,
+	 *        the spot and the carrier of the bundle
+	 *
+	 * @param bundle  The received bundle
+	 * @param frames  OUT: the frames of the bundle, in sending order
+	 * @return true on success, false if the bundle is malformed
+	 */
+	static bool split(const DvbFrame &bundle, std::vector<DvbFrame *> &frames);
+};
+
+
+#endif
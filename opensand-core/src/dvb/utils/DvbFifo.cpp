@@ -34,6 +34,8 @@
 
 
 #include "DvbFifo.h"
+#include "FifoAqmCodel.h"
+#include "FifoAqmPie.h"
 
 #include <opensand_output/Output.h>
 
@@ -41,13 +43,22 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <cstring>
+#include <algorithm>
 
 
 DvbFifo::DvbFifo(unsigned int fifo_priority, std::string fifo_name,
                  std::string type_name,
                  vol_pkt_t max_size_pkt):
-	queue(),
+	queue(max_size_pkt),
+	queue_lengths(max_size_pkt, 0),
+	queue_head(0),
+	queue_size(0),
+	head_fragment(false),
+	aqm(nullptr),
+	sojourn_sum_ms(0),
+	sojourn_count(0),
 	fifo_priority(fifo_priority),
+	fifo_weight(1),
 	fifo_name(fifo_name),
 	access_type(),
 	vcm_id(),
@@ -56,7 +67,7 @@ DvbFifo::DvbFifo(unsigned int fifo_priority, std::string fifo_name,
 	new_length_bytes(0),
 	max_size_pkt(max_size_pkt),
 	carrier_id(0),
-	fifo_mutex(),
+	fifo_mutex("dvb.fifo"),
 	cni(0)
 {
 	// Output log
@@ -102,8 +113,16 @@ DvbFifo::DvbFifo(unsigned int fifo_priority, std::string fifo_name,
 DvbFifo::DvbFifo(uint8_t carrier_id,
                  vol_pkt_t max_size_pkt,
                  std::string fifo_name):
-	queue(),
+	queue(max_size_pkt),
+	queue_lengths(max_size_pkt, 0),
+	queue_head(0),
+	queue_size(0),
+	head_fragment(false),
+	aqm(nullptr),
+	sojourn_sum_ms(0),
+	sojourn_count(0),
 	fifo_priority(0),
+	fifo_weight(1),
 	fifo_name(fifo_name),
 	access_type(),
 	new_size_pkt(0),
@@ -111,7 +130,7 @@ DvbFifo::DvbFifo(uint8_t carrier_id,
 	new_length_bytes(0),
 	max_size_pkt(max_size_pkt),
 	carrier_id(carrier_id),
-	fifo_mutex()
+	fifo_mutex("dvb.fifo")
 {
 	// Output log
 	this->log_dvb_fifo = Output::Get()->registerLog(LEVEL_WARNING, "Dvb.Fifo");
@@ -150,6 +169,16 @@ unsigned int DvbFifo::getPriority() const
 
 }
 
+unsigned int DvbFifo::getWeight() const
+{
+	return this->fifo_weight;
+}
+
+void DvbFifo::setWeight(unsigned int weight)
+{
+	this->fifo_weight = std::max(weight, 1U);
+}
+
 // FIFO Carrier ID for SAT and GW
 uint8_t DvbFifo::getCarrierId() const
 {
@@ -181,7 +210,7 @@ void DvbFifo::resetNew(const ForwardOrReturnAccessType cr_type)
 vol_pkt_t DvbFifo::getCurrentSize() const
 {
 	RtLock lock(this->fifo_mutex);
-	return this->queue.size();
+	return this->queue_size;
 }
 
 vol_bytes_t DvbFifo::getCurrentDataLength() const
@@ -199,9 +228,9 @@ vol_pkt_t DvbFifo::getMaxSize() const
 clock_t DvbFifo::getTickOut() const
 {
 	RtLock lock(this->fifo_mutex);
-	if(queue.size() > 0)
+	if(this->queue_size > 0)
 	{
-		return this->queue.front()->getTickOut();
+		return this->queue[this->queue_head].getTickOut();
 	}
 	return 0;
 }
@@ -216,33 +245,42 @@ uint8_t DvbFifo::getCni(void) const
 	return this->cni;
 }
 
-const std::deque<FifoElement *> &DvbFifo::getQueue() const
+std::size_t DvbFifo::getIndex(std::size_t position) const
 {
-	return this->queue;
+	std::size_t index = this->queue_head + position;
+	return index < this->queue.size() ? index : index - this->queue.size();
+}
+
+vol_bytes_t DvbFifo::store(std::size_t index, FifoElement &&elem)
+{
+	vol_bytes_t length = elem.getTotalLength();
+	this->queue[index] = std::move(elem);
+	this->queue_lengths[index] = length;
+	this->queue_size++;
+	this->cur_length_bytes += length;
+	this->stat_context.current_pkt_nbr = this->queue_size;
+	this->stat_context.current_length_bytes += length;
+	return length;
 }
 
-bool DvbFifo::push(FifoElement *elem)
+bool DvbFifo::push(FifoElement &&elem)
 {
 	RtLock lock(this->fifo_mutex);
 	vol_bytes_t length;
-	length = elem->getTotalLength();
 
-	if(this->queue.size() >= this->max_size_pkt)
+	if(this->queue_size >= this->max_size_pkt)
 	{
 		this->stat_context.drop_pkt_nbr++;
-		this->stat_context.drop_bytes += length;
+		this->stat_context.drop_bytes += elem.getTotalLength();
 		return false;
 	}
 
 	// insert in top of fifo
-	this->queue.push_back(elem);
+	length = this->store(this->getIndex(this->queue_size), std::move(elem));
 	// update counter
 	this->new_size_pkt++;
-	this->stat_context.current_pkt_nbr = this->queue.size();
 	this->stat_context.in_pkt_nbr++;
 	this->new_length_bytes += length;
-	this->cur_length_bytes += length;
-	this->stat_context.current_length_bytes += length;
 	this->stat_context.in_length_bytes += length;
 
 	LOG(this->log_dvb_fifo, LEVEL_INFO,
@@ -251,20 +289,51 @@ bool DvbFifo::push(FifoElement *elem)
 	return true;
 }
 
-bool DvbFifo::pushFront(FifoElement *elem)
+std::size_t DvbFifo::push(std::vector<FifoElement> &elems)
 {
 	RtLock lock(this->fifo_mutex);
+	std::size_t added = 0;
+	vol_bytes_t total_length = 0;
 
-	// insert in head of fifo
-	if(this->queue.size() < this->max_size_pkt)
+	for(auto &&elem: elems)
 	{
-		vol_bytes_t length = elem->getTotalLength();
+		if(this->queue_size >= this->max_size_pkt)
+		{
+			this->stat_context.drop_pkt_nbr++;
+			this->stat_context.drop_bytes += elem.getTotalLength();
+			continue;
+		}
+
+		// insert in top of fifo
+		vol_bytes_t length = this->store(this->getIndex(this->queue_size), std::move(elem));
+		// update counter
+		this->new_size_pkt++;
+		this->stat_context.in_pkt_nbr++;
+		this->new_length_bytes += length;
+		this->stat_context.in_length_bytes += length;
+		total_length += length;
+		added++;
+	}
+	elems.clear();
+
+	LOG(this->log_dvb_fifo, LEVEL_INFO,
+	    "Added %zu elements of %u bytes, new size is %u bytes\n",
+	    added, total_length, this->cur_length_bytes);
+
+	return added;
+}
+
+bool DvbFifo::pushFront(FifoElement &&elem)
+{
+	RtLock lock(this->fifo_mutex);
 
-		this->queue.push_front(elem);
-		this->cur_length_bytes += length;
+	// insert in head of fifo
+	if(this->queue_size < this->max_size_pkt)
+	{
+		this->queue_head = this->getIndex(this->queue.size() - 1);
+		this->head_fragment = true;
+		vol_bytes_t length = this->store(this->queue_head, std::move(elem));
 		// update counter but not new ones as it is a fragment of an old element
-		this->stat_context.current_pkt_nbr = this->queue.size();
-		this->stat_context.current_length_bytes += length;
 		// remove the remainng part of element from out counter
 		this->stat_context.out_length_bytes -= length;
 
@@ -278,20 +347,15 @@ bool DvbFifo::pushFront(FifoElement *elem)
 
 }
 
-bool DvbFifo::pushBack(FifoElement *elem)
+bool DvbFifo::pushBack(FifoElement &&elem)
 {
 	RtLock lock(this->fifo_mutex);
 
 	// insert in head of fifo
-	if(this->queue.size() < this->max_size_pkt)
+	if(this->queue_size < this->max_size_pkt)
 	{
-		vol_bytes_t length = elem->getTotalLength();
-
-		this->queue.insert(this->queue.end(), elem);
-		this->cur_length_bytes += length;
+		vol_bytes_t length = this->store(this->getIndex(this->queue_size), std::move(elem));
 		// update counter but not new ones as it is a fragment of an old element
-		this->stat_context.current_pkt_nbr = this->queue.size();
-		this->stat_context.current_length_bytes += length;
 		// remove the remainng part of element from out counter
 		this->stat_context.out_length_bytes -= length;
 
@@ -304,26 +368,28 @@ bool DvbFifo::pushBack(FifoElement *elem)
 	return false;
 
 }
-FifoElement *DvbFifo::pop()
+
+bool DvbFifo::pop(FifoElement &elem)
 {
 	RtLock lock(this->fifo_mutex);
-	FifoElement *elem;
 	vol_bytes_t length;
 
-	if(this->queue.size() <= 0)
+	if(this->queue_size <= 0)
 	{
-		return NULL;
+		return false;
 	}
 
-	elem = this->queue.front();
-	length = elem->getTotalLength();
+	elem = std::move(this->queue[this->queue_head]);
+	length = this->queue_lengths[this->queue_head];
 
 	// remove the packet
-	this->queue.erase(this->queue.begin());
+	this->queue_head = this->getIndex(1);
+	this->queue_size--;
+	this->head_fragment = false;
 	this->cur_length_bytes -= length;
 
 	// update counters
-	this->stat_context.current_pkt_nbr = this->queue.size();
+	this->stat_context.current_pkt_nbr = this->queue_size;
 	this->stat_context.out_pkt_nbr++;
 
 	this->stat_context.current_length_bytes -= length;
@@ -332,18 +398,139 @@ FifoElement *DvbFifo::pop()
 	LOG(this->log_dvb_fifo, LEVEL_INFO,
 		    "Removed %u bytes, new size is %u bytes\n", length, this->cur_length_bytes);
 
-	return elem;
+	return true;
+}
+
+bool DvbFifo::pop(FifoElement &elem, clock_t current_time)
+{
+	RtLock lock(this->fifo_mutex);
+	bool dropped = false;
+
+	while(this->queue_size > 0)
+	{
+		FifoElement &head = this->queue[this->queue_head];
+		if(dropped && head.getTickOut() > current_time)
+		{
+			// keep the elements that are not ready for the next extraction
+			break;
+		}
+
+		vol_bytes_t length = this->queue_lengths[this->queue_head];
+		time_ms_t sojourn = current_time > head.getTickOut() ? current_time - head.getTickOut() : 0;
+		bool fragment = this->head_fragment;
+		elem = std::move(head);
+
+		this->queue_head = this->getIndex(1);
+		this->queue_size--;
+		this->head_fragment = false;
+		this->cur_length_bytes -= length;
+		this->stat_context.current_pkt_nbr = this->queue_size;
+		this->stat_context.current_length_bytes -= length;
+
+		this->sojourn_sum_ms += sojourn;
+		this->sojourn_count++;
+		this->stat_context.sojourn_max_ms = std::max(this->stat_context.sojourn_max_ms, sojourn);
+
+		// the remaining fragment of a sent element is never dropped
+		if(!this->aqm || fragment ||
+		   !this->aqm->drop(sojourn, length, this->cur_length_bytes, current_time))
+		{
+			this->stat_context.out_pkt_nbr++;
+			this->stat_context.out_length_bytes += length;
+
+			LOG(this->log_dvb_fifo, LEVEL_INFO,
+			    "Removed %u bytes, new size is %u bytes\n", length, this->cur_length_bytes);
+			return true;
+		}
+
+		LOG(this->log_dvb_fifo, LEVEL_INFO,
+		    "AQM dropped %u bytes after %u ms in fifo %s\n",
+		    length, sojourn, this->fifo_name.c_str());
+		this->stat_context.drop_pkt_nbr++;
+		this->stat_context.drop_bytes += length;
+		elem = FifoElement();
+		dropped = true;
+	}
+	return false;
+}
+
+bool DvbFifo::setAqm(const std::string &name, time_ms_t target_ms, time_ms_t interval_ms)
+{
+	RtLock lock(this->fifo_mutex);
+	if(name == "None")
+	{
+		this->aqm.reset();
+	}
+	else if(name == "CoDel")
+	{
+		this->aqm.reset(new FifoAqmCodel(target_ms ? target_ms : 5,
+		                                 interval_ms ? interval_ms : 100));
+	}
+	else if(name == "PIE")
+	{
+		this->aqm.reset(new FifoAqmPie(target_ms ? target_ms : 15,
+		                               interval_ms ? interval_ms : 15));
+	}
+	else
+	{
+		LOG(this->log_dvb_fifo, LEVEL_ERROR,
+		    "unknown active queue management %s for fifo %s\n",
+		    name.c_str(), this->fifo_name.c_str());
+		return false;
+	}
+	return true;
+}
+
+FifoElement &DvbFifo::peek(vol_pkt_t index)
+{
+	RtLock lock(this->fifo_mutex);
+	assert(index < this->queue_size);
+	// the ring is never reallocated, the element stays in place
+	// until it is consumed
+	return this->queue[this->getIndex(index)];
+}
+
+void DvbFifo::consume(vol_pkt_t count)
+{
+	RtLock lock(this->fifo_mutex);
+	vol_bytes_t length = 0;
+
+	assert(count <= this->queue_size);
+	if(count > 0)
+	{
+		this->head_fragment = false;
+	}
+	for(vol_pkt_t removed = 0; removed < count; ++removed)
+	{
+		this->queue[this->queue_head] = FifoElement();
+		length += this->queue_lengths[this->queue_head];
+		this->queue_head = this->getIndex(1);
+	}
+	this->queue_size -= count;
+	this->cur_length_bytes -= length;
+
+	// update counters
+	this->stat_context.current_pkt_nbr = this->queue_size;
+	this->stat_context.out_pkt_nbr += count;
+
+	this->stat_context.current_length_bytes -= length;
+	this->stat_context.out_length_bytes += length;
+
+	LOG(this->log_dvb_fifo, LEVEL_INFO,
+		    "Removed %u bytes, new size is %u bytes\n", length, this->cur_length_bytes);
 }
 
 void DvbFifo::flush()
 {
 	RtLock lock(this->fifo_mutex);
-	for(auto *elem: queue)
+	for(vol_pkt_t position = 0; position < this->queue_size; ++position)
 	{
-		delete elem;
+		this->queue[this->getIndex(position)] = FifoElement();
 	}
 
-	this->queue.clear();
+	this->queue_head = 0;
+	this->queue_size = 0;
+	this->head_fragment = false;
 	this->new_size_pkt = 0;
 	this->new_length_bytes = 0;
 	this->cur_length_bytes = 0;
@@ -362,11 +549,19 @@ void DvbFifo::getStatsCxt(mac_fifo_stat_context_t &stat_info)
 	stat_info.out_length_bytes = this->stat_context.out_length_bytes;
 	stat_info.drop_pkt_nbr = this->stat_context.drop_pkt_nbr;
 	stat_info.drop_bytes = this->stat_context.drop_bytes;
+	stat_info.sojourn_avg_ms = this->sojourn_count ? this->sojourn_sum_ms / this->sojourn_count : 0;
+	stat_info.sojourn_max_ms = this->stat_context.sojourn_max_ms;
 
 	// reset counters
 	this->resetStats();
 }
 
+void DvbFifo::skipStats()
+{
+	RtLock lock(this->fifo_mutex);
+	this->resetStats();
+}
+
 void DvbFifo::resetStats()
 {
 	this->stat_context.in_pkt_nbr = 0;
@@ -375,8 +570,20 @@ void DvbFifo::resetStats()
 	this->stat_context.out_length_bytes = 0;
 	this->stat_context.drop_pkt_nbr = 0;
 	this->stat_context.drop_bytes = 0;
+	this->stat_context.sojourn_max_ms = 0;
+	this->sojourn_sum_ms = 0;
+	this->sojourn_count = 0;
 }
 
 
-
-
+bool fifo_probes_t::isEnabled() const
+{
+	return this->queue_size.isEnabled() ||
+	       this->queue_size_kb.isEnabled() ||
+	       this->queue_loss.isEnabled() ||
+	       this->queue_loss_kb.isEnabled() ||
+	       this->queue_sojourn.isEnabled() ||
+	       this->queue_sojourn_max.isEnabled() ||
+	       this->l2_to_sat_before_sched.isEnabled() ||
+	       this->l2_to_sat_after_sched.isEnabled();
+}
@@ -36,13 +36,17 @@
 
 #include "OpenSandCore.h"
 #include "FifoElement.h"
+#include "FifoAqm.h"
 #include "Sac.h"
 
+#include <opensand_rt/RtMemory.h>
 #include <opensand_rt/RtMutex.h>
 #include <opensand_output/OutputLog.h>
+#include <opensand_output/LazyProbe.h>
 
-#include <deque>
 #include <map>
+#include <memory>
+#include <vector>
 #include <sys/times.h>
 
 
@@ -60,6 +64,8 @@ typedef struct
 	vol_bytes_t out_length_bytes;     ///< current length of data extraction during period
 	vol_pkt_t drop_pkt_nbr;           ///< number of elements dropped
 	vol_bytes_t drop_bytes;           ///< current length of data dropped
+	time_ms_t sojourn_avg_ms;         ///< mean sojourn time of the elements extracted during period
+	time_ms_t sojourn_max_ms;         ///< maximum sojourn time of the elements extracted during period
 } mac_fifo_stat_context_t;
 
 
@@ -144,6 +150,12 @@ public:
  * @brief Defines a DVB fifo
  *
  * Manages a DVB fifo, for queuing, statistics, ...
+ *
+ * The elements are stored in a ring of max_size_pkt elements allocated
+ * with the fifo on the memory of the channel creating it, they are
+ * moved in and out of it. The length of each
+ * element is kept with it so the counters are updated without
+ * querying the packets.
  */
 class DvbFifo
 {
@@ -203,6 +215,22 @@ public:
 	 */
 	unsigned int getPriority() const;
 
+	/**
+	 * @brief Get the weight of the fifo in the return link
+	 *        fair queuing disciplines
+	 *
+	 * @return the weight of the fifo
+	 */
+	unsigned int getWeight() const;
+
+	/**
+	 * @brief Set the weight of the fifo in the return link
+	 *        fair queuing disciplines
+	 *
+	 * @param weight  The weight of the fifo, at least 1
+	 */
+	void setWeight(unsigned int weight);
+
 	/** 
 	* @brief Get the carrier_id of the fifo (for SAT and GW configuration)
 	*
@@ -264,10 +292,21 @@ public:
 	 * @brief Add an element at the end of the list
 	 *        (Increments new_size_pkt)
 	 *
-	 * @param elem is the pointer on FifoElement
+	 * @param elem  The element, left untouched if the fifo is full
 	 * @return true on success, false otherwise
 	 */
-	bool push(FifoElement *elem);
+	bool push(FifoElement &&elem);
+
+	/**
+	 * @brief Add a batch of elements at the end of the list, in order,
+	 *        with one lock for the whole batch
+	 *        (Increments new_size_pkt)
+	 *
+	 * @param elems  The elements, the vector is emptied
+	 * @return the number of elements added, the following ones are
+	 *         dropped because the fifo is full
+	 */
+	std::size_t push(std::vector<FifoElement> &elems);
 
 	/**
 	 * @brief Add an element at the head of the list
@@ -275,27 +314,75 @@ public:
 	 * @warning This function should be use only to replace a fragment of
 	 *          previously removed data in the fifo
 	 *
-	 * @param elem is the pointer on FifoElement
+	 * @param elem  The element, left untouched if the fifo is full
 	 * @return true on success, false otherwise
 	 */
-	bool pushFront(FifoElement *elem);
+	bool pushFront(FifoElement &&elem);
 
 	/**
 	 * @brief Add an element at the back of the list
 	 *        (Decrements new_length_bytes)
 	 *
-	 * @param elem is the pointer on FifoElement
+	 * @param elem  The element, left untouched if the fifo is full
 	 * @return true on success, false otherwise
 	 */
-	bool pushBack(FifoElement *elem);
+	bool pushBack(FifoElement &&elem);
 
 	/**
 	 * @brief Remove an element at the head of the list
 	 *
-	 * @return NULL pointer if extraction failed because fifo is empty
-	 *         pointer on extracted FifoElement otherwise
+	 * @param elem  OUT: the extracted element
+	 * @return false if extraction failed because fifo is empty,
+	 *         true otherwise
+	 */
+	bool pop(FifoElement &elem);
+
+	/**
+	 * @brief Remove the first element ready to be sent at the head of
+	 *        the list, after the drops of the active queue management
+	 *
+	 * The sojourn time of an element is counted from its tick out, the
+	 * time it was ready to be sent. Once an element is dropped, the
+	 * following ones are only extracted if they are ready.
+	 *
+	 * @param elem          OUT: the extracted element
+	 * @param current_time  The current time
+	 * @return false if no element was extracted, true otherwise
+	 */
+	bool pop(FifoElement &elem, clock_t current_time);
+
+	/**
+	 * @brief Set the active queue management of the fifo
+	 *
+	 * @param name         The algorithm name: None, CoDel or PIE
+	 * @param target_ms    The target sojourn time, 0 for the algorithm
+	 *                     default (CoDel 5 ms, PIE 15 ms)
+	 * @param interval_ms  The CoDel interval or the PIE update period,
+	 *                     0 for the algorithm default (CoDel 100 ms,
+	 *                     PIE 15 ms)
+	 * @return true on success, false if the algorithm is unknown
+	 */
+	bool setAqm(const std::string &name, time_ms_t target_ms, time_ms_t interval_ms);
+
+	/**
+	 * @brief Access an element without removing it
+	 * @warning The element stays in the fifo, its packet may be taken
+	 *          before it is removed with consume
+	 *
+	 * @param index  The position of the element from the head,
+	 *               lower than the current size
+	 * @return the element
 	 */
-	FifoElement *pop();
+	FifoElement &peek(vol_pkt_t index);
+
+	/**
+	 * @brief Remove elements at the head of the list, their packets
+	 *        are released
+	 *
+	 * @param count  The number of elements to remove, at most the
+	 *               current size
+	 */
+	void consume(vol_pkt_t count);
 
 	/**
 	 * @brief Flush the dvb fifo and reset counters
@@ -310,21 +397,53 @@ public:
 	 */
 	void getStatsCxt(mac_fifo_stat_context_t &stat_info);
 
+	/**
+	 * @brief Reset the statistics of the period without reading them,
+	 *        when no probe uses them
+	 */
+	void skipStats();
+
 	void setCni(uint8_t cni);
 
 	uint8_t getCni(void) const;
 
-	const std::deque<FifoElement *> &getQueue() const;
-
 protected:
 	/**
 	 * @brief Reset the fifo counters
 	 */
 	void resetStats();
 
-	std::deque<FifoElement *> queue; ///< the FIFO itself
+	/**
+	 * @brief Get the ring index of an element
+	 *
+	 * @param position  The position of the element from the head
+	 * @return the index of the element in the ring
+	 */
+	std::size_t getIndex(std::size_t position) const;
+
+	/**
+	 * @brief Move an element in the ring and count it
+	 *
+	 * @param index  The index of the element in the ring
+	 * @param elem   The element
+	 * @return the length of the element
+	 */
+	vol_bytes_t store(std::size_t index, FifoElement &&elem);
+
+	std::vector<FifoElement, RtAllocator<FifoElement>> queue;  ///< the FIFO itself, a ring of max_size_pkt elements
+	std::vector<vol_bytes_t, RtAllocator<vol_bytes_t>> queue_lengths; ///< the length of each element when queued
+	std::size_t queue_head;         ///< the ring index of the head element
+	vol_pkt_t queue_size;           ///< the number of elements in the ring
+	bool head_fragment;             ///< whether the head element is the remaining
+	                                ///< fragment of an extracted element
+
+	std::unique_ptr<FifoAqm> aqm;   ///< the active queue management, if any
+	uint64_t sojourn_sum_ms;        ///< the sojourn times of the elements extracted
+	                                ///< with a time since previous statistics
+	vol_pkt_t sojourn_count;        ///< the number of these elements
 
 	unsigned int fifo_priority;     ///< the MAC priority of the fifo
+	unsigned int fifo_weight;       ///< the weight of the fifo in fair queuing
 	std::string fifo_name;          ///< the MAC fifo name: for ST (EF, AF, BE, ...) or SAT
 	ForwardOrReturnAccessType access_type;   ///< the forward or return access type
 	unsigned int vcm_id;            ///< the associated VCM id (if VCM access type)
@@ -349,4 +468,35 @@ protected:
 typedef std::map<qos_t, DvbFifo *> fifos_t;
 
 
+/**
+ * @brief The statistics probes of a MAC FIFO, kept together so that the
+ *        statistics update walks them without lookup, and registered on
+ *        their first value other than zero so that the unused FIFOs cost
+ *        no probe
+ */
+struct fifo_probes_t
+{
+	DvbFifo *fifo;
+	// Queue sizes
+	LazyProbe<int> queue_size;
+	LazyProbe<int> queue_size_kb;
+	// Queue loss
+	LazyProbe<int> queue_loss;
+	LazyProbe<int> queue_loss_kb;
+	// Queue sojourn times
+	LazyProbe<int> queue_sojourn;
+	LazyProbe<int> queue_sojourn_max;
+	// Layer 2 to SAT rates
+	LazyProbe<int> l2_to_sat_before_sched;
+	LazyProbe<int> l2_to_sat_after_sched;
+
+	/**
+	 * @brief Check whether one of the probes is enabled
+	 *
+	 * @return true if the fifo statistics are used
+	 */
+	bool isEnabled() const;
+};
+
+
 #endif
@@ -39,6 +39,8 @@
 
 #include <cstring>
 
+#include <opensand_rt/RtAccounting.h>
+
 #include "OpenSandFrames.h"
 #include "NetContainer.h"
 #include "NetPacket.h"
@@ -52,6 +54,11 @@ class SlottedAlohaFrame;
 /**
  * @class DvbFrameTpl
  * @brief DVB frame template
+ *
+ * The packet accessors are not virtual: the frames are given their type
+ * once, when their message type is checked at the block boundary, and the
+ * schedulers then fill them through the statically typed frame, so that
+ * these accessors are resolved and inlined at compile time.
  */
 template<class T = T_DVB_FRAME>
 class DvbFrameTpl: public NetContainer
@@ -66,7 +73,29 @@ protected:
 	/** The carrier Id */
 	uint8_t carrier_id;
 
+	/** The count of the live frames of the building channel */
+	RtAccounted<DvbFrameTpl> accounted;
+
 public:
+	/** The name of the frames in the memory accounting */
+	static constexpr const char *accounting_name = "dvb_frame";
+
+	/**
+	 * Build a DVB frame by taking over received data
+	 *
+	 * @param data  raw data from which a DVB frame can be created
+	 */
+	DvbFrameTpl(Data &&data):
+		NetContainer(std::move(data)),
+		max_size(sizeof(T)),
+		num_packets(0),
+		carrier_id(0)
+	{
+		this->name = "DvbFrame";
+		this->trailer_length = this->getTotalLength() - this->getMessageLength();
+		this->header_length = sizeof(T);
+	};
+
 	/**
 	 * Build a DVB frame
 	 *
@@ -228,7 +257,9 @@ public:
 	void setMaxSize(unsigned int size)
 	{
 		this->max_size = size;
-		this->data.reserve(size);
+		// a frame being built keeps room for the physical layer trailer,
+		// so that it is sent from the buffer it was filled in
+		this->data.reserve(this->trailer_length == 0 ? size + sizeof(T_DVB_PHY) : size);
 		// we need to do that again because data may have moved
 		// this is very important to set max size because data may also move
 		// when using append
@@ -271,7 +302,7 @@ public:
 	 * @return        true if the packet was added to the DVB frame,
 	 *                false if an error occurred
 	 */
-	virtual bool addPacket(NetPacket *packet)
+	bool addPacket(NetPacket *packet)
 	{
 		// is the frame large enough to contain the packet ?
 		if(packet->getTotalLength() > this->getFreeSpace())
@@ -291,7 +322,7 @@ public:
 	 *
 	 * @return  the encapsulation packets count
 	 */
-	virtual unsigned int getPacketsCount() const
+	unsigned int getPacketsCount() const
 	{
 		return this->num_packets;
 	}
@@ -299,7 +330,7 @@ public:
 	/**
 	 * Empty the DVB frame
 	 */
-	virtual void empty(void) {};
+	void empty(void) {};
 
 	/**
 	 * Get the C/N value carried by the frame
@@ -45,7 +45,7 @@
  *        be choosen with a relevant size in order to be totally included
  *        in one sat_carrier paquets (ie. < MTU for UDP)
  */
-class DvbRcsFrame: public DvbFrameTpl<T_DVB_ENCAP_BURST>
+class DvbRcsFrame final: public DvbFrameTpl<T_DVB_ENCAP_BURST>
 {
 public:
 	/**
@@ -102,7 +102,7 @@ public:
 	 */
 	uint8_t getModcodId(void) const;
 
-	// implementation of virtual functions
+	// specialization of the frame accessors
 	bool addPacket(NetPacket *packet);
 	void empty(void);
 };
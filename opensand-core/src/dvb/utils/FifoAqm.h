@@ -0,0 +1,79 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file FifoAqm.h
+ * @brief The active queue management algorithms generic class
+ * @author Viveris Technologies
+ */
+
+#ifndef FIFO_AQM_H
+#define FIFO_AQM_H
+
+#include "OpenSandCore.h"
+
+
+/**
+ * @class FifoAqm
+ * @brief The active queue management of a fifo, the drop decisions
+ *        are taken when the elements are extracted, from their
+ *        sojourn time in the fifo
+ */
+class FifoAqm
+{
+public:
+	/**
+	 * @brief Build the generic AQM class
+	 *
+	 * @param target_ms  The target sojourn time
+	 */
+	FifoAqm(time_ms_t target_ms);
+
+	virtual ~FifoAqm();
+
+	/**
+	 * @brief Decide whether an extracted element is dropped
+	 *
+	 * @param sojourn_ms     The time the element spent in the fifo
+	 * @param length         The element length
+	 * @param backlog_bytes  The length of the elements left in the fifo
+	 * @param now            The current time (in ms)
+	 * @return true if the element must be dropped, false otherwise
+	 */
+	virtual bool drop(time_ms_t sojourn_ms,
+	                  vol_bytes_t length,
+	                  vol_bytes_t backlog_bytes,
+	                  clock_t now) = 0;
+
+protected:
+	/// The target sojourn time
+	time_ms_t target_ms;
+};
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file FifoAqmCodel.cpp
+ * @brief The CoDel active queue management (RFC 8289)
+ * @author Viveris Technologies
+ */
+
+
+#include "FifoAqmCodel.h"
+
+#include <cmath>
+
+
+FifoAqmCodel::FifoAqmCodel(time_ms_t target_ms, time_ms_t interval_ms):
+	FifoAqm(target_ms),
+	interval_ms{interval_ms},
+	first_above{0},
+	drop_next{0},
+	count{0},
+	last_count{0},
+	dropping{false},
+	max_length{0}
+{
+}
+
+
+clock_t FifoAqmCodel::controlLaw(clock_t time) const
+{
+	return time + this->interval_ms / std::sqrt(this->count);
+}
+
+
+bool FifoAqmCodel::drop(time_ms_t sojourn_ms,
+                        vol_bytes_t length,
+                        vol_bytes_t backlog_bytes,
+                        clock_t now)
+{
+	bool ok_to_drop = false;
+
+	this->max_length = std::max(this->max_length, length);
+	if(sojourn_ms < this->target_ms || backlog_bytes <= this->max_length)
+	{
+		// went below the target, stay below for an interval
+		this->first_above = 0;
+	}
+	else if(this->first_above == 0)
+	{
+		// just went above the target
+		this->first_above = now + this->interval_ms;
+	}
+	else if(now >= this->first_above)
+	{
+		ok_to_drop = true;
+	}
+
+	if(this->dropping)
+	{
+		if(!ok_to_drop)
+		{
+			// sojourn time below the target, leave the dropping state
+			this->dropping = false;
+			return false;
+		}
+		if(now < this->drop_next)
+		{
+			return false;
+		}
+		this->count++;
+		this->drop_next = this->controlLaw(this->drop_next);
+		return true;
+	}
+
+	if(!ok_to_drop)
+	{
+		return false;
+	}
+
+	// enter the dropping state, start from the previous drop rate
+	// if the last dropping state was recent
+	this->dropping = true;
+	uint32_t delta = this->count - this->last_count;
+	if(delta > 1 && now - this->drop_next < 16 * this->interval_ms)
+	{
+		this->count = delta;
+	}
+	else
+	{
+		this->count = 1;
+	}
+	this->drop_next = this->controlLaw(now);
+	this->last_count = this->count;
+	return true;
+}
@@ -0,0 +1,96 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file FifoAqmCodel.h
+ * @brief The CoDel active queue management (RFC 8289)
+ * @author Viveris Technologies
+ */
+
+#ifndef FIFO_AQM_CODEL_H
+#define FIFO_AQM_CODEL_H
+
+#include "FifoAqm.h"
+
+
+/**
+ * @class FifoAqmCodel
+ * @brief The CoDel active queue management
+ *
+ * The fifo enters the dropping state once the sojourn time stayed above
+ * the target for an interval, then drops at a rate increasing with the
+ * square root of the drops count until the sojourn time gets below the
+ * target. The RFC dequeue loop is taken one element at a time: each
+ * element extracted while dropping is dropped if the next drop time
+ * is reached.
+ */
+class FifoAqmCodel: public FifoAqm
+{
+public:
+	/**
+	 * @brief Build the CoDel AQM
+	 *
+	 * @param target_ms    The target sojourn time
+	 * @param interval_ms  The window the sojourn time must stay above
+	 *                     the target in, about the flows round trip time
+	 */
+	FifoAqmCodel(time_ms_t target_ms, time_ms_t interval_ms);
+
+	bool drop(time_ms_t sojourn_ms,
+	          vol_bytes_t length,
+	          vol_bytes_t backlog_bytes,
+	          clock_t now) override;
+
+private:
+	/**
+	 * @brief Get the time of the next drop
+	 *
+	 * @param time  The time of the last drop
+	 * @return the time of the next drop
+	 */
+	clock_t controlLaw(clock_t time) const;
+
+	/// The window the sojourn time must stay above the target in
+	time_ms_t interval_ms;
+	/// The time the sojourn time will have been above the target
+	/// for an interval, 0 if it is below
+	clock_t first_above;
+	/// The time of the next drop in the dropping state
+	clock_t drop_next;
+	/// The number of drops since entering the dropping state
+	uint32_t count;
+	/// The number of drops of the previous dropping state
+	uint32_t last_count;
+	/// Whether the fifo is in the dropping state
+	bool dropping;
+	/// The longest element, the fifo is never emptied below it
+	vol_bytes_t max_length;
+};
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file FifoAqmPie.cpp
+ * @brief The PIE active queue management (RFC 8033)
+ * @author Viveris Technologies
+ */
+
+
+#include "FifoAqmPie.h"
+
+#include <algorithm>
+
+
+/// The weights of the sojourn time distance to the target and of its
+/// trend, in Hz
+constexpr double pie_alpha = 0.125;
+constexpr double pie_beta = 1.25;
+
+/// The fifo is not dropped below this backlog (two 1500 bytes packets)
+constexpr vol_bytes_t pie_min_backlog = 2 * 1500;
+
+
+FifoAqmPie::FifoAqmPie(time_ms_t target_ms, time_ms_t update_ms, unsigned int seed):
+	FifoAqm(target_ms),
+	update_ms{update_ms},
+	next_update{0},
+	delay_ms{0},
+	old_delay_ms{0},
+	probability{0},
+	generator{seed},
+	distribution{0.0, 1.0}
+{
+}
+
+
+void FifoAqmPie::updateProbability()
+{
+	double delta = pie_alpha * (static_cast<double>(this->delay_ms) - this->target_ms) / 1000 +
+	               pie_beta * (static_cast<double>(this->delay_ms) - this->old_delay_ms) / 1000;
+
+	// the adjustment is scaled down while the probability is low
+	// to converge without oscillations
+	if(this->probability < 0.000001)
+	{
+		delta /= 2048;
+	}
+	else if(this->probability < 0.00001)
+	{
+		delta /= 512;
+	}
+	else if(this->probability < 0.0001)
+	{
+		delta /= 128;
+	}
+	else if(this->probability < 0.001)
+	{
+		delta /= 32;
+	}
+	else if(this->probability < 0.01)
+	{
+		delta /= 8;
+	}
+	else if(this->probability < 0.1)
+	{
+		delta /= 2;
+	}
+	this->probability += delta;
+
+	// decay the probability while the fifo is idle
+	if(this->delay_ms == 0 && this->old_delay_ms == 0)
+	{
+		this->probability *= 0.98;
+	}
+	this->probability = std::min(1.0, std::max(0.0, this->probability));
+	this->old_delay_ms = this->delay_ms;
+}
+
+
+bool FifoAqmPie::drop(time_ms_t sojourn_ms,
+                      vol_bytes_t UNUSED(length),
+                      vol_bytes_t backlog_bytes,
+                      clock_t now)
+{
+	this->delay_ms = sojourn_ms;
+	if(now >= this->next_update)
+	{
+		if(this->next_update != 0)
+		{
+			this->updateProbability();
+		}
+		this->next_update = now + this->update_ms;
+	}
+
+	// do not drop while the delay is low or the fifo nearly empty
+	if((this->old_delay_ms < this->target_ms / 2 && this->probability < 0.2) ||
+	   backlog_bytes <= pie_min_backlog)
+	{
+		return false;
+	}
+	return this->distribution(this->generator) < this->probability;
+}
@@ -0,0 +1,93 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file FifoAqmPie.h
+ * @brief The PIE active queue management (RFC 8033)
+ * @author Viveris Technologies
+ */
+
+#ifndef FIFO_AQM_PIE_H
+#define FIFO_AQM_PIE_H
+
+#include "FifoAqm.h"
+
+#include <random>
+
+
+/**
+ * @class FifoAqmPie
+ * @brief The PIE active queue management
+ *
+ * A drop probability is updated periodically from the distance of the
+ * sojourn time to the target and from its trend, the elements are
+ * dropped at random with this probability. The sojourn time of the
+ * extracted elements is used as the queuing delay, and the drops are
+ * done at extraction instead of at insertion.
+ */
+class FifoAqmPie: public FifoAqm
+{
+public:
+	/**
+	 * @brief Build the PIE AQM
+	 *
+	 * @param target_ms  The target sojourn time
+	 * @param update_ms  The period of the drop probability update
+	 * @param seed       The seed of the random drops
+	 */
+	FifoAqmPie(time_ms_t target_ms, time_ms_t update_ms,
+	           unsigned int seed = std::random_device{}());
+
+	bool drop(time_ms_t sojourn_ms,
+	          vol_bytes_t length,
+	          vol_bytes_t backlog_bytes,
+	          clock_t now) override;
+
+private:
+	/**
+	 * @brief Update the drop probability
+	 */
+	void updateProbability();
+
+	/// The period of the drop probability update
+	time_ms_t update_ms;
+	/// The time of the next drop probability update
+	clock_t next_update;
+	/// The sojourn time of the last extracted element
+	time_ms_t delay_ms;
+	/// The sojourn time at the previous drop probability update
+	time_ms_t old_delay_ms;
+	/// The drop probability
+	double probability;
+
+	std::minstd_rand generator;
+	std::uniform_real_distribution<double> distribution;
+};
+
+#endif
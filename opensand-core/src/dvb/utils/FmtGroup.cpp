@@ -39,6 +39,7 @@
 
 #include <opensand_output/Output.h>
 
+#include <algorithm>
 #include <vector>
 #include <sstream>
 
@@ -48,44 +49,103 @@ FmtGroup::FmtGroup(unsigned int group_id,
                    const FmtDefinitionTable *modcod_def):
 	id(group_id),
 	fmt_ids(),
-	num_fmt_ids(),
+	robustness_set(),
+	rank_fmt_ids(),
+	fmt_ranks(),
+	nearest_ranks(),
 	modcod_def(modcod_def)
 {
 	// Output log
 	this->log_fmt = Output::Get()->registerLog(LEVEL_WARNING, "Dvb.Fmt.Group");
 
+	this->rank();
 	this->parse(ids);
 };
 
 fmt_id_t FmtGroup::getNearest(fmt_id_t fmt_id) const
 {
-	std::list<FmtId>::const_reverse_iterator it; 
-	double esn0 = this->modcod_def->getRequiredEsN0(fmt_id);
-	if(esn0 == 0.0)
+	int limit = this->nearest_ranks[fmt_id];
+	if(limit < 0)
 	{
 		LOG(this->log_fmt, LEVEL_ERROR,
 		    "Cannot get nearest FMT id\n");
 		return 0;
 	}
-	FmtId desired_fmt(fmt_id, esn0);
-	// FMT IDs are sorted from more to less robust
-	for(it = this->fmt_ids.rbegin();
-	    it != this->fmt_ids.rend();
-	    ++it)
+
+	// the highest member rank below the limit is the less robust
+	// MODCOD the desired one can be replaced with
+	std::size_t word = limit / word_bits;
+	uint64_t bits = this->robustness_set[word];
+	std::size_t shift = word_bits - 1 - limit % word_bits;
+	bits = (bits << shift) >> shift;
+	while(bits == 0)
 	{
-		if((*it) <= desired_fmt)
+		if(word == 0)
 		{
-			return (*it).id;
+			return 0;
 		}
+		bits = this->robustness_set[--word];
 	}
-	return 0;
+	std::size_t rank = word * word_bits + word_bits - 1 - __builtin_clzll(bits);
+	return this->rank_fmt_ids[rank];
 };
 
+bool FmtGroup::contains(fmt_id_t fmt_id) const
+{
+	int rank = this->fmt_ranks[fmt_id];
+	return rank >= 0 &&
+	       (this->robustness_set[rank / word_bits] >> (rank % word_bits)) & 1;
+}
+
+void FmtGroup::rank()
+{
+	std::vector<std::pair<double, fmt_id_t>> thresholds;
+
+	this->fmt_ranks.fill(-1);
+	this->nearest_ranks.fill(-1);
+	for(auto &&definition : this->modcod_def->getDefinitions())
+	{
+		thresholds.emplace_back(definition.second->getRequiredEsN0(), definition.first);
+	}
+	// from more to less robust
+	std::sort(thresholds.begin(), thresholds.end());
+	for(std::size_t rank = 0; rank < thresholds.size(); ++rank)
+	{
+		this->rank_fmt_ids[rank] = thresholds[rank].second;
+		this->fmt_ranks[thresholds[rank].second] = rank;
+	}
+	for(auto &&threshold : thresholds)
+	{
+		if(threshold.first == 0.0)
+		{
+			// not a usable definition, as for the groups
+			continue;
+		}
+		auto last = std::upper_bound(thresholds.begin(), thresholds.end(), threshold.first,
+			[](double es_n0, const std::pair<double, fmt_id_t> &other)
+			{
+				return es_n0 < other.first;
+			});
+		this->nearest_ranks[threshold.second] = last - thresholds.begin() - 1;
+	}
+}
+
+bool FmtGroup::add(fmt_id_t fmt_id)
+{
+	double esn0 = this->modcod_def->getRequiredEsN0(fmt_id);
+	if(esn0 == 0.0 || this->fmt_ranks[fmt_id] < 0)
+	{
+		return false;
+	}
+	int rank = this->fmt_ranks[fmt_id];
+	this->robustness_set[rank / word_bits] |= uint64_t{1} << (rank % word_bits);
+	return true;
+}
+
 void FmtGroup::parse(std::string ids)
 {
 	std::vector<std::string>::iterator it;
 	std::vector<std::string> first_step;
-	std::list<fmt_id_t>::const_iterator id_it;
 
 	// first get groups of strings separated by ';'
 	tokenize(ids, first_step, ";");
@@ -110,19 +170,14 @@ void FmtGroup::parse(std::string ids)
 			}
 			val = (fmt_id_t)dummy;
 			// keep the current value if it does not exists
-			if(std::find(this->fmt_ids.begin(),
-			             this->fmt_ids.end(), val) == this->fmt_ids.end())
+			if(!this->contains(val))
 			{
-				double esn0 = this->modcod_def->getRequiredEsN0(val);
-				if(esn0 == 0.0)
+				if(!this->add(val))
 				{
 					LOG(this->log_fmt, LEVEL_ERROR,
 					    "Cannot parse FMT group\n");
 					continue;
 				}
-				FmtId fmt_id(val, esn0);
-
-				this->fmt_ids.push_back(fmt_id);
 				LOG(this->log_fmt, LEVEL_INFO,
 				    "Add ID %u in FMT group %u\n", val, this->id);
 			}
@@ -136,19 +191,10 @@ void FmtGroup::parse(std::string ids)
 			for(fmt_id_t i = std::min(previous_id + 1, val + 1);
 			    i < std::max(previous_id, val); i++)
 			{
-				if(std::find(this->fmt_ids.begin(),
-				             this->fmt_ids.end(), i) == this->fmt_ids.end())
+				if(!this->contains(i) && !this->add(i))
 				{
-					double esn0 = this->modcod_def->getRequiredEsN0(i);
-					if(esn0 == 0.0)
-					{
-						LOG(this->log_fmt, LEVEL_ERROR,
-						    "Cannot parse FMT group\n");
-						continue;
-					}
-					FmtId fmt_id(i, esn0);
-
-					this->fmt_ids.push_back(fmt_id);
+					LOG(this->log_fmt, LEVEL_ERROR,
+					    "Cannot parse FMT group\n");
 				}
 			}
 
@@ -156,21 +202,22 @@ void FmtGroup::parse(std::string ids)
 		}
 	}
 
-	this->fmt_ids.sort();
 	// we need the list of numeric IDs to avoid creating it each time
 	// we call getFmtIds
-	for(std::list<FmtId>::const_iterator id_it = this->fmt_ids.begin();
-	    id_it != this->fmt_ids.end(); ++id_it)
+	for(std::size_t rank = 0; rank < max_fmt_ids; ++rank)
 	{
-		LOG(this->log_fmt, LEVEL_INFO,
-		    "Add ID %u in FMT group %u\n", (*id_it).id, this->id);
-		this->num_fmt_ids.push_back((*id_it).id);
+		if((this->robustness_set[rank / word_bits] >> (rank % word_bits)) & 1)
+		{
+			LOG(this->log_fmt, LEVEL_INFO,
+			    "Add ID %u in FMT group %u\n", this->rank_fmt_ids[rank], this->id);
+			this->fmt_ids.push_back(this->rank_fmt_ids[rank]);
+		}
 	}
 }
 
-const std::list<fmt_id_t> FmtGroup::getFmtIds() const
+const std::vector<fmt_id_t> &FmtGroup::getFmtIds() const
 {
-	return this->num_fmt_ids;
+	return this->fmt_ids;
 }
 
 const FmtDefinitionTable *FmtGroup::getModcodDefinitions() const
@@ -180,6 +227,5 @@ const FmtDefinitionTable *FmtGroup::getModcodDefinitions() const
 
 fmt_id_t FmtGroup::getMaxFmtId() const
 {
-	return this->num_fmt_ids.back();
+	return this->fmt_ids.back();
 }
-
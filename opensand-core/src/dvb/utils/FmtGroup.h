@@ -41,28 +41,50 @@
 
 #include <opensand_output/OutputLog.h>
 
-#include <list>
+#include <array>
+#include <cstdint>
 #include <string>
 #include <map>
+#include <vector>
 
 
-class FmtId;
-
 /**
  * @class FmtGroup
  * @brief The definition of a FMT
+ *
+ * The FMT IDs of the group are kept as a bitset over the MODCODs of the
+ * definitions table ordered from the most to the less robust, so the
+ * membership test and the search of the nearest supported MODCOD are
+ * a few word operations instead of walks of the ID list.
  */
 class FmtGroup
 {
 private:
+	/// The number of FMT IDs
+	static constexpr std::size_t max_fmt_ids = 256;
+
+	/// The number of bits in a word of the robustness bitset
+	static constexpr std::size_t word_bits = 64;
+
 	/** The ID of the FMT group */
 	fmt_id_t id;
 
-	/** The list of FMT IDs */
-	std::list<FmtId> fmt_ids;
+	/** The IDs of the group, from more to less robust */
+	std::vector<fmt_id_t> fmt_ids;
 
-	/** The list of IDs from FMT IDs */
-	std::list<fmt_id_t> num_fmt_ids;
+	/** The group members, bit r set for the r-th most robust MODCOD
+	 *  of the definitions table */
+	std::array<uint64_t, max_fmt_ids / word_bits> robustness_set;
+
+	/** The FMT ID of each robustness rank */
+	std::array<fmt_id_t, max_fmt_ids> rank_fmt_ids;
+
+	/** The robustness rank of each FMT ID, -1 if it is not defined */
+	std::array<int16_t, max_fmt_ids> fmt_ranks;
+
+	/** The highest rank with a required Es/N0 lower or equal to the one
+	 *  of each FMT ID, -1 if it is not defined */
+	std::array<int16_t, max_fmt_ids> nearest_ranks;
 
 	/** The table of MODCOD definitions */
 	const FmtDefinitionTable *modcod_def;
@@ -94,12 +116,20 @@ public:
 	 */
 	fmt_id_t getNearest(fmt_id_t fmt_id) const;
 
+	/**
+	 * @brief Check whether a MODCOD is in the group
+	 *
+	 * @param fmt_id  The FMT id
+	 * @return true if the group contains the MODCOD, false otherwise
+	 */
+	bool contains(fmt_id_t fmt_id) const;
+
 	/**
 	 * @brief Get the list of available MODCODs
 	 *
-	 * @return the list of MODCODs
+	 * @return the list of MODCODs, from more to less robust
 	 */
-	const std::list<fmt_id_t> getFmtIds() const;
+	const std::vector<fmt_id_t> &getFmtIds() const;
 
 	/**
 	 * @brief Get the MODCOD definitions
@@ -116,6 +146,19 @@ public:
 	fmt_id_t getMaxFmtId() const;
 
 private:
+	/**
+	 * @brief Rank the MODCODs of the definitions table by robustness
+	 */
+	void rank();
+
+	/**
+	 * @brief Add a MODCOD to the group
+	 *
+	 * @param fmt_id  The FMT id
+	 * @return true if the MODCOD is defined, false otherwise
+	 */
+	bool add(fmt_id_t fmt_id);
+
 	/**
 	 * @brief parse the FMT IDs string read in configuration
 	 *
@@ -125,88 +168,6 @@ private:
 };
 
 
-/**
- * @class FmtId
- * @brief A FMT ID
- */
-class FmtId
-{
-public:
-	FmtId(fmt_id_t id, float es_n0):
-		id(id),
-		es_n0(es_n0)
-	{};
-
-	/// operator < used by sort on required Es/N0
-	bool operator<(const FmtId &id) const
-	{
-		return (this->es_n0 < id.es_n0);
-	}
-
-	/// operator <= used to compare with FMT ID
-	bool operator<=(fmt_id_t id) const
-	{
-		return (this->id <= id);
-	}
-
-	/// operator >= used to compare with FMT ID
-	bool operator>=(fmt_id_t id) const
-	{
-		return (this->id >= id);
-	}
-
-	/// operator == used to compare with FMT ID
-	bool operator==(fmt_id_t id) const
-	{
-		return (this->id == id);
-	}
-
-	/// operator != used to compare with FMT ID
-	bool operator!=(fmt_id_t id) const
-	{
-		return (this->id != id);
-	}
-
-	/// operator <= used to compare two FmtId
-	bool operator<=(const FmtId &id) const
-	{
-		return (this->es_n0 <= id.es_n0);
-	}
-
-	/// operator > used to compare two FmtId
-	bool operator>(const FmtId &id) const
-	{
-		return (this->es_n0 > id.es_n0);
-	}
-
-	/// operator >= used to compare two FmtId
-	bool operator>=(const FmtId &id) const
-	{
-		return (this->es_n0 >= id.es_n0);
-	}
-
-	/// operator == used to compare two FmtId
-	bool operator==(const FmtId &id) const
-	{
-		return (this->es_n0 == id.es_n0);
-	}
-
-	/// operator != used to compare two FmtId
-	bool operator!=(const FmtId &id) const
-	{
-		return (this->es_n0 != id.es_n0);
-	}
-
-	/// The FMT ID
-	fmt_id_t id;
-
-private:
-	/// The required Es/N0
-	float es_n0;
-};
-
-
-
 typedef std::map<fmt_id_t, FmtGroup *> fmt_groups_t;
 
 
@@ -0,0 +1,186 @@
+/*
+ *
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file FrameTickMonitor.cpp
+ * @brief Monitor the deadlines of the frame ticks of a DVB channel
+ * @author Viveris Technologies
+ */
+
+
+#include "FrameTickMonitor.h"
+
+#include <opensand_output/Output.h>
+#include <opensand_output/OutputEvent.h>
+
+#include <algorithm>
+
+
+FrameTickMonitor::FrameTickMonitor():
+	name(),
+	period_us(0),
+	export_ticks(0),
+	started(false),
+	expected(),
+	start(),
+	lateness(),
+	processing(),
+	overruns(0),
+	missed(0),
+	probe_lateness_p50(nullptr),
+	probe_lateness_p99(nullptr),
+	probe_lateness_max(nullptr),
+	probe_processing_p50(nullptr),
+	probe_processing_p99(nullptr),
+	probe_processing_max(nullptr),
+	probe_headroom(nullptr),
+	probe_overruns(nullptr),
+	probe_missed(nullptr),
+	event_overrun(nullptr)
+{
+}
+
+
+void FrameTickMonitor::init(const std::string &prefix,
+                            const std::string &name,
+                            time_ms_t period_ms,
+                            unsigned int export_ticks,
+                            bool overrun_event)
+{
+	auto output = Output::Get();
+	std::string path = prefix + "Perf." + name + ".";
+
+	this->name = name;
+	this->period_us = int64_t(period_ms) * 1000;
+	this->export_ticks = std::max(1U, export_ticks);
+
+	this->probe_lateness_p50 = output->registerProbe<int32_t>(path + "lateness_p50", "us", true, SAMPLE_LAST);
+	this->probe_lateness_p99 = output->registerProbe<int32_t>(path + "lateness_p99", "us", true, SAMPLE_LAST);
+	this->probe_lateness_max = output->registerProbe<int32_t>(path + "lateness_max", "us", true, SAMPLE_LAST);
+	this->probe_processing_p50 = output->registerProbe<int32_t>(path + "processing_p50", "us", true, SAMPLE_LAST);
+	this->probe_processing_p99 = output->registerProbe<int32_t>(path + "processing_p99", "us", true, SAMPLE_LAST);
+	this->probe_processing_max = output->registerProbe<int32_t>(path + "processing_max", "us", true, SAMPLE_LAST);
+	this->probe_headroom = output->registerProbe<int32_t>(path + "headroom_min", "us", true, SAMPLE_LAST);
+	this->probe_overruns = output->registerProbe<int32_t>(path + "overruns", "ticks", true, SAMPLE_SUM);
+	this->probe_missed = output->registerProbe<int32_t>(path + "missed", "ticks", true, SAMPLE_SUM);
+	if(overrun_event)
+	{
+		this->event_overrun = output->registerEvent(prefix + "Perf." + name + "_overrun");
+	}
+}
+
+
+void FrameTickMonitor::tickStart(void)
+{
+	auto now = std::chrono::steady_clock::now();
+	if(this->period_us <= 0)
+	{
+		return;
+	}
+
+	if(this->expected == std::chrono::steady_clock::time_point())
+	{
+		// first tick, the following ones are expected one period later each
+		this->expected = now;
+	}
+	else
+	{
+		this->expected += std::chrono::microseconds(this->period_us);
+	}
+
+	int64_t late = std::chrono::duration_cast<std::chrono::microseconds>(now - this->expected).count();
+	if(late >= this->period_us)
+	{
+		// the timer merges the expirations of the ticks we were too late for
+		int64_t skipped = late / this->period_us;
+		this->missed += skipped;
+		this->expected += std::chrono::microseconds(skipped * this->period_us);
+		late -= skipped * this->period_us;
+	}
+	else if(late < -this->period_us)
+	{
+		// earlier than a whole period (the ticks source restarted)
+		this->expected = now;
+		late = 0;
+	}
+	this->lateness.record(late);
+	this->start = now;
+	this->started = true;
+}
+
+
+void FrameTickMonitor::tickEnd(void)
+{
+	if(!this->started)
+	{
+		return;
+	}
+	this->started = false;
+
+	auto now = std::chrono::steady_clock::now();
+	int64_t duration = std::chrono::duration_cast<std::chrono::microseconds>(now - this->start).count();
+	this->processing.record(duration);
+	if(duration > this->period_us)
+	{
+		this->overruns++;
+	}
+
+	if(this->processing.getCount() >= this->export_ticks)
+	{
+		this->exportStatistics();
+	}
+}
+
+
+void FrameTickMonitor::exportStatistics(void)
+{
+	this->probe_lateness_p50->put(this->lateness.getPercentile(50));
+	this->probe_lateness_p99->put(this->lateness.getPercentile(99));
+	this->probe_lateness_max->put(this->lateness.getMax());
+	this->probe_processing_p50->put(this->processing.getPercentile(50));
+	this->probe_processing_p99->put(this->processing.getPercentile(99));
+	this->probe_processing_max->put(this->processing.getMax());
+	this->probe_headroom->put(this->period_us - this->processing.getMax());
+	this->probe_overruns->put(this->overruns);
+	this->probe_missed->put(this->missed);
+
+	if(this->event_overrun != nullptr && (this->overruns > 0 || this->missed > 0))
+	{
+		this->event_overrun->sendEvent("%u of the last %lu %s ticks overran their "
+		                               "%ld us budget (max %ld us), %u ticks missed",
+		                               this->overruns, this->processing.getCount(),
+		                               this->name.c_str(), this->period_us,
+		                               this->processing.getMax(), this->missed);
+	}
+
+	this->lateness.reset();
+	this->processing.reset();
+	this->overruns = 0;
+	this->missed = 0;
+}
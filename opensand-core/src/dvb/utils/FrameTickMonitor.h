@@ -0,0 +1,145 @@
+/*
+ *
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file FrameTickMonitor.h
+ * @brief Monitor the deadlines of the frame ticks of a DVB channel
+ * @author Viveris Technologies
+ */
+
+#ifndef FRAME_TICK_MONITOR_H
+#define FRAME_TICK_MONITOR_H
+
+#include "OpenSandCore.h"
+
+#include <opensand_rt/RtHistogram.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+
+template<typename T>
+class Probe;
+class OutputEvent;
+
+
+/**
+ * @class FrameTickMonitor
+ * @brief Record how late each frame tick starts and how long its
+ *        processing takes, compared to the frame duration
+ *
+ * The processing of a tick should end before the next tick starts,
+ * the frame duration is the budget of each tick. The statistics are
+ * exported in probes every few ticks, the headroom is the part of the
+ * budget left by the longest processing.
+ */
+class FrameTickMonitor
+{
+ public:
+	FrameTickMonitor();
+
+	/**
+	 * @brief Register the probes of the monitor
+	 *
+	 * @param prefix         The probes prefix
+	 * @param name           The name of the ticks in the probes
+	 * @param period_ms      The frame duration, expected between two ticks
+	 * @param export_ticks   The number of ticks between two exports
+	 * @param overrun_event  Whether to send an event when some ticks
+	 *                       overran their budget since the last export
+	 */
+	void init(const std::string &prefix,
+	          const std::string &name,
+	          time_ms_t period_ms,
+	          unsigned int export_ticks,
+	          bool overrun_event);
+
+	/**
+	 * @brief Signal the beginning of a tick processing
+	 */
+	void tickStart(void);
+
+	/**
+	 * @brief Signal the end of a tick processing
+	 */
+	void tickEnd(void);
+
+ private:
+	/**
+	 * @brief Export the statistics in the probes and reset them
+	 */
+	void exportStatistics(void);
+
+	/// The name of the ticks
+	std::string name;
+
+	/// The frame duration (us)
+	int64_t period_us;
+
+	/// The number of ticks between two exports
+	unsigned int export_ticks;
+
+	/// Whether a tick is being processed
+	bool started;
+
+	/// The expected start of the current tick
+	std::chrono::steady_clock::time_point expected;
+
+	/// The start of the current tick
+	std::chrono::steady_clock::time_point start;
+
+	/// The lateness of the ticks start (us)
+	RtHistogram lateness;
+
+	/// The processing time of the ticks (us)
+	RtHistogram processing;
+
+	/// The number of ticks whose processing exceeded the frame duration
+	uint32_t overruns;
+
+	/// The number of ticks missed because the previous ones were too late
+	uint32_t missed;
+
+	std::shared_ptr<Probe<int32_t>> probe_lateness_p50;
+	std::shared_ptr<Probe<int32_t>> probe_lateness_p99;
+	std::shared_ptr<Probe<int32_t>> probe_lateness_max;
+	std::shared_ptr<Probe<int32_t>> probe_processing_p50;
+	std::shared_ptr<Probe<int32_t>> probe_processing_p99;
+	std::shared_ptr<Probe<int32_t>> probe_processing_max;
+	std::shared_ptr<Probe<int32_t>> probe_headroom;
+	std::shared_ptr<Probe<int32_t>> probe_overruns;
+	std::shared_ptr<Probe<int32_t>> probe_missed;
+
+	/// The event sent on overruns, nullptr if disabled
+	std::shared_ptr<OutputEvent> event_overrun;
+};
+
+
+#endif
@@ -43,6 +43,7 @@
 
 
 #include <bits/endian.h>
+#include <cstddef>
 
 #include "OpenSandCore.h"
 
@@ -109,6 +110,11 @@ Ttp = 21,
  */
 Sync = 22,
 
+/**
+ * Control frames of a superframe sent at once, NCC -> ST
+ */
+CtrlBundle = 23,
+
 /**
  * Request a logon, ST -> NCC
  */
@@ -166,6 +172,7 @@ typedef struct
 #endif
 
 } __attribute__((__packed__)) T_DVB_HDR;
+static_assert(sizeof(T_DVB_HDR) == 3, "unexpected DVB header layout");
 
 /**
  * Generic Frame
@@ -174,6 +181,7 @@ typedef struct
 {
 	T_DVB_HDR hdr;
 } T_DVB_FRAME;
+static_assert(sizeof(T_DVB_FRAME) == sizeof(T_DVB_HDR), "unexpected DVB frame layout");
 
 /**
  * Carry information about physicalLayer block.
@@ -182,6 +190,7 @@ typedef struct
 {
 	uint32_t cn_previous;  ///< The C/N computed on the link (* 100)
 } __attribute__((__packed__)) T_DVB_PHY;
+static_assert(sizeof(T_DVB_PHY) == 4, "unexpected physical layer trailer layout");
 
 /**
  * This message type is a trick.
@@ -198,6 +207,8 @@ typedef struct
 	T_DVB_HDR hdr;    ///< Basic DVB Header, used only to be caught by the dvb layer
 	uint16_t sf_nbr;  ///< SuperFrame Number
 } __attribute__((__packed__)) T_DVB_SOF;
+static_assert(sizeof(T_DVB_SOF) == 5, "unexpected SOF layout");
+static_assert(offsetof(T_DVB_SOF, sf_nbr) == sizeof(T_DVB_HDR), "misaligned SOF superframe number");
 
 
 /**
@@ -212,6 +223,8 @@ typedef struct
 	vol_kb_t max_vbdc;        ///< the maximum VBDC value in kbits/s
 	bool is_scpc;             ///< is the terminal scpc
 } __attribute__((__packed__)) T_DVB_LOGON_REQ;
+static_assert(sizeof(T_DVB_LOGON_REQ) == 12, "unexpected logon request layout");
+static_assert(offsetof(T_DVB_LOGON_REQ, is_scpc) == 11, "misaligned logon request SCPC flag");
 
 
 /**
@@ -224,6 +237,8 @@ typedef struct
 	group_id_t group_id; ///< Assigned Group Id
 	tal_id_t  logon_id;  ///< Assigned Logon Id
 } __attribute__((__packed__)) T_DVB_LOGON_RESP;
+static_assert(sizeof(T_DVB_LOGON_RESP) == 9, "unexpected logon response layout");
+static_assert(offsetof(T_DVB_LOGON_RESP, logon_id) == 7, "misaligned logon response logon ID");
 
 
 /**
@@ -234,6 +249,7 @@ typedef struct
 	T_DVB_HDR hdr; ///< Basic DVB Header
 	tal_id_t mac;  ///< Satellite MAC ST address
 } __attribute__((__packed__)) T_DVB_LOGOFF;
+static_assert(sizeof(T_DVB_LOGOFF) == 5, "unexpected logoff layout");
 
 /**
  * BB frame header
@@ -244,6 +260,8 @@ typedef struct
 	uint16_t data_length;
 	uint8_t used_modcod;
 } __attribute__((__packed__)) T_DVB_BBFRAME;
+static_assert(sizeof(T_DVB_BBFRAME) == 6, "unexpected BB frame header layout");
+static_assert(offsetof(T_DVB_BBFRAME, used_modcod) == 5, "misaligned BB frame MODCOD");
 
 
 /**
@@ -256,6 +274,8 @@ typedef struct
 	uint16_t qty_element;  ///< Number of following encapsulation packets
 	uint8_t modcod;        ///< The MODCOD of the data carried in frame
 } __attribute__((__packed__)) T_DVB_ENCAP_BURST;
+static_assert(sizeof(T_DVB_ENCAP_BURST) == 6, "unexpected encapsulation burst header layout");
+static_assert(offsetof(T_DVB_ENCAP_BURST, modcod) == 5, "misaligned encapsulation burst MODCOD");
 
 
 /**
@@ -266,6 +286,7 @@ typedef struct
 	T_DVB_HDR hdr;
 	uint16_t data_length;
 } __attribute__((__packed__)) T_DVB_SALOHA;
+static_assert(sizeof(T_DVB_SALOHA) == 5, "unexpected Slotted Aloha header layout");
 
 
 /// This message is used by dvb rcs layer to advertise the upper layer
@@ -283,6 +304,8 @@ constexpr const std::size_t MSG_DVB_RCS_SIZE_MAX = 1200 + sizeof(T_DVB_PHY);
 /// The maximum size of a BBFrame
 constexpr const std::size_t MSG_BBFRAME_SIZE_MAX = 8100 + sizeof(T_DVB_PHY);
 constexpr const std::size_t MSG_SALOHA_SIZE_MAX = 1200 + sizeof(T_DVB_PHY);
+/// The maximum size of a bundle of control frames, as a BBFrame
+constexpr const std::size_t MSG_CTRL_BUNDLE_SIZE_MAX = 8100 + sizeof(T_DVB_PHY);
 
 
 #endif
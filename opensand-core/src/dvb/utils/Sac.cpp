@@ -37,6 +37,7 @@
 #include <opensand_output/Output.h>
 
 #include <cstring>
+#include <algorithm>
 
 
 // RBDC request granularity in SAC (in Kbits/s)
@@ -121,20 +122,40 @@ double Sac::getCni() const
 std::vector<cr_info_t> Sac::getRequests(void) const
 {
 	std::vector<cr_info_t> requests;
+	uint8_t count = this->getRequestsCount();
 
-	for(unsigned int i = 0; i < this->frame()->sac.cr_number; i++)
+	requests.reserve(count);
+	for(uint8_t i = 0; i < count; i++)
 	{
-		cr_info_t req;
-
-		req.prio = this->frame()->sac.cr[i].prio;
-		req.type = this->frame()->sac.cr[i].type;
-		req.value = getDecodedCrValue(this->frame()->sac.cr[i]);
-
-		requests.push_back(req);
+		requests.push_back(this->getRequest(i));
 	}
 	return requests;
 };
 
+uint8_t Sac::getRequestsCount(void) const
+{
+	// do not read past the received data
+	std::size_t length = std::min<std::size_t>(this->getMessageLength(),
+	                                           this->data.size());
+	if(length < sizeof(T_DVB_SAC))
+	{
+		return 0;
+	}
+	return std::min<std::size_t>(this->frame()->sac.cr_number,
+	                             (length - sizeof(T_DVB_SAC)) / sizeof(emu_cr_t));
+}
+
+cr_info_t Sac::getRequest(uint8_t index) const
+{
+	const emu_cr_t &cr = this->frame()->sac.cr[index];
+	cr_info_t req;
+
+	req.prio = cr.prio;
+	req.type = cr.type;
+	req.value = getDecodedCrValue(cr);
+	return req;
+}
+
 
 void Sac::setAcm(double cni)
 {
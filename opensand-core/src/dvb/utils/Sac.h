@@ -200,6 +200,21 @@ public:
 	 */
 	std::vector<cr_info_t> getRequests(void) const;
 
+	/**
+	 * @brief  Get the number of requests held in the frame
+	 *
+	 * @return  the number of requests
+	 */
+	uint8_t getRequestsCount(void) const;
+
+	/**
+	 * @brief  Get a request, decoded in place from the frame
+	 *
+	 * @param index  The request index, lower than the number of requests
+	 * @return  the request
+	 */
+	cr_info_t getRequest(uint8_t index) const;
+
 	/**
 	 * @brief Get the C/N0 ratio
 	 *
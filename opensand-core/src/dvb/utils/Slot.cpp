@@ -39,7 +39,8 @@
 Slot::Slot(unsigned int carriers_id,
            unsigned int slot_id):
 	carriers_id(carriers_id),
-	slot_id(slot_id)
+	slot_id(slot_id),
+	simulated_packets()
 {
 }
 
@@ -58,7 +59,18 @@ unsigned int Slot::getId() const
 	return this->slot_id;
 }
 
+void Slot::addSimulatedPacket(uint32_t packet)
+{
+	this->simulated_packets.push_back(packet);
+}
+
+const std::vector<uint32_t> &Slot::getSimulatedPackets() const
+{
+	return this->simulated_packets;
+}
+
 void Slot::release(void)
 {
 	this->clear();
+	this->simulated_packets.clear();
 }
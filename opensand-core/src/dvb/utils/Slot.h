@@ -37,6 +37,8 @@
 
 #include "SlottedAlohaPacketData.h"
 
+#include <vector>
+
 /**
  * @class Slot
  * @brief Represent a RCS slot in a carrier (i.e. a list of packets + attributes)
@@ -78,7 +80,22 @@ public:
 	unsigned int getNbrPackets(void) const;
 
 	/**
-	 * @brief Release all packets in slot
+	 * @brief Add the replica of a packet of the statistical simulation,
+	 *        a packet that is only known by its index
+	 *
+	 * @param packet  The index of the simulated packet
+	 */
+	void addSimulatedPacket(uint32_t packet);
+
+	/**
+	 * @brief Get the simulated packets with a replica in this slot
+	 *
+	 * @return the indexes of the simulated packets
+	 */
+	const std::vector<uint32_t> &getSimulatedPackets() const;
+
+	/**
+	 * @brief Release all packets in slot, simulated ones included
 	 */
 	void release(void);
 
@@ -88,6 +105,9 @@ private:
 
 	/** Slot id */
 	unsigned int slot_id;
+
+	/** The simulated packets with a replica in this slot */
+	std::vector<uint32_t> simulated_packets;
 };
 
 
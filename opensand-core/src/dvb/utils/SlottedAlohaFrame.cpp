@@ -34,8 +34,10 @@
  */
 
 #include "SlottedAlohaFrame.h"
+#include "SlottedAlohaPacketCtrl.h"
 #include "OpenSandFrames.h"
 
+#include <algorithm>
 #include <string.h>
 
 // TODO SALOHA is not compatible with physical layer, regenerative, ??
@@ -86,6 +88,26 @@ SlottedAlohaFrameCtrl::SlottedAlohaFrameCtrl():
 }
 
 
+std::size_t SlottedAlohaFrameCtrl::addAcks(tal_id_t tal_id,
+                                            const saloha_ack_id_t *ack_ids,
+                                            std::size_t count)
+{
+	std::size_t free_space = this->getFreeSpace();
+	if(free_space < sizeof(saloha_ctrl_hdr_t) + sizeof(saloha_ctrl_ack_t))
+	{
+		return 0;
+	}
+	count = std::min(count, (free_space - sizeof(saloha_ctrl_hdr_t)) / sizeof(saloha_ctrl_ack_t));
+
+	std::size_t length = this->data.length();
+	SlottedAlohaPacketCtrl::writeAck(tal_id, ack_ids, count, this->data);
+	this->num_packets++;
+	this->setMessageLength(this->getMessageLength() + this->data.length() - length);
+	this->frame()->data_length = htons(this->num_packets);
+	return count;
+}
+
+
 SlottedAlohaFrameData::SlottedAlohaFrameData():
 	SlottedAlohaFrame()
 {
@@ -37,6 +37,7 @@
 #define SALOHA_FRAME_H
 
 #include "DvbFrame.h"
+#include "SlottedAlohaPacket.h"
 
 /**
  * @class SlottedAlohaFrame
@@ -78,21 +79,32 @@ public:
 	 */
 	~SlottedAlohaFrame();
 
-	// Implementation of virtual functions
+	// Specialization of the frame accessors
 	bool addPacket(NetPacket* packet);
 	void empty();
 	uint16_t getDataLength(void) const;
 };
 
 
-class SlottedAlohaFrameCtrl: public SlottedAlohaFrame
+class SlottedAlohaFrameCtrl final: public SlottedAlohaFrame
 {
 public:
 	SlottedAlohaFrameCtrl();
+
+	/**
+	 * Add the compacted ACK of some packets of a terminal, written
+	 * in place in the frame, with as many packets as the frame can hold
+	 *
+	 * @param tal_id   The destination terminal ID
+	 * @param ack_ids  The identifiers of the acknowledged packets
+	 * @param count    The number of identifiers
+	 * @return the number of acknowledged packets added, 0 if the frame is full
+	 */
+	std::size_t addAcks(tal_id_t tal_id, const saloha_ack_id_t *ack_ids, std::size_t count);
 };
 
 
-class SlottedAlohaFrameData: public SlottedAlohaFrame
+class SlottedAlohaFrameData final: public SlottedAlohaFrame
 {
 public:
 	SlottedAlohaFrameData();
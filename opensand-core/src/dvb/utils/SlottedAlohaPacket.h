@@ -40,11 +40,13 @@
 #include "OpenSandCore.h"
 
 #include <stdlib.h>
+#include <functional>
 #include <sstream>
 
 
 //Control signal types
 #define SALOHA_CTRL_ERR 0
+/// The compacted ACK of some packets of a terminal
 #define SALOHA_CTRL_ACK 1
 
 /// <ID,Seq,PDU_nb,QoS> constant identifiers
@@ -57,6 +59,33 @@
 /// A Slotted Aloha ID representation
 typedef Data saloha_id_t;
 
+/// The binary <ID,Seq,PDU_nb,QoS> identifier of a packet, carried by the ACKs
+struct saloha_ack_id_t
+{
+	uint32_t id;
+	uint16_t seq;
+	uint16_t pdu_nb;
+	uint8_t qos;
+
+	bool operator==(const saloha_ack_id_t &other) const
+	{
+		return this->id == other.id && this->seq == other.seq &&
+		       this->pdu_nb == other.pdu_nb && this->qos == other.qos;
+	};
+};
+
+/// The hash of the packets identifiers, indexing the packets waiting for their ACK
+struct saloha_ack_id_hash
+{
+	std::size_t operator()(const saloha_ack_id_t &ack_id) const
+	{
+		return std::hash<uint64_t>{}((uint64_t(ack_id.qos) << 56) ^
+		                             (uint64_t(ack_id.id) << 24) ^
+		                             (uint64_t(ack_id.seq) << 12) ^
+		                             ack_id.pdu_nb);
+	};
+};
+
 
 /**
  * @class SlottedAlohaPacket
@@ -78,6 +107,14 @@ public:
 		NetPacket(data, length)
 	{};
 
+	/**
+	 * Build an empty packet, the subclass then fills the data
+	 * with its header so that no insertion is required
+	 */
+	SlottedAlohaPacket():
+		NetPacket()
+	{};
+
 	/**
 	 * Class destructor
 	 */
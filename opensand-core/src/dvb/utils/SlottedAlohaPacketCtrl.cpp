@@ -42,7 +42,7 @@
 SlottedAlohaPacketCtrl::SlottedAlohaPacketCtrl(const Data &data,
                                                uint8_t ctrl_type,
                                                tal_id_t tal_id):
-	SlottedAlohaPacket(data)
+	SlottedAlohaPacket()
 {
 	saloha_ctrl_hdr_t header;
 	this->name = "Slotted Aloha control";
@@ -50,8 +50,8 @@ SlottedAlohaPacketCtrl::SlottedAlohaPacketCtrl(const Data &data,
 
 	header.type = ctrl_type;
 	header.tal_id = htons(tal_id);
-	header.total_length = htons(this->header_length + this->data.length());
-	this->data.insert(0, (unsigned char*)&header, this->header_length);
+	header.total_length = htons(this->header_length + data.length());
+	this->data = Data{(unsigned char *)&header, this->header_length, data};
 }
 
 SlottedAlohaPacketCtrl::SlottedAlohaPacketCtrl(const unsigned char *data,
@@ -82,6 +82,41 @@ uint16_t SlottedAlohaPacketCtrl::getTerminalId() const
 	return (ntohs)(header->tal_id);
 }
 
+std::size_t SlottedAlohaPacketCtrl::getAcksCount() const
+{
+	return (this->getTotalLength() - sizeof(saloha_ctrl_hdr_t)) / sizeof(saloha_ctrl_ack_t);
+}
+
+saloha_ack_id_t SlottedAlohaPacketCtrl::getAck(std::size_t index) const
+{
+	const saloha_ctrl_ack_t *ack;
+
+	ack = (const saloha_ctrl_ack_t *)(this->data.c_str() + sizeof(saloha_ctrl_hdr_t)) + index;
+	return {ntohl(ack->id), ntohs(ack->seq), ntohs(ack->pdu_nb), ack->qos};
+}
+
+void SlottedAlohaPacketCtrl::writeAck(tal_id_t tal_id,
+                                      const saloha_ack_id_t *ack_ids,
+                                      std::size_t count,
+                                      Data &buffer)
+{
+	saloha_ctrl_hdr_t header;
+
+	header.type = SALOHA_CTRL_ACK;
+	header.tal_id = htons(tal_id);
+	header.total_length = htons(sizeof(header) + count * sizeof(saloha_ctrl_ack_t));
+	buffer.append((unsigned char *)&header, sizeof(header));
+	for(std::size_t index = 0; index < count; ++index)
+	{
+		saloha_ctrl_ack_t ack;
+		ack.id = htonl(ack_ids[index].id);
+		ack.seq = htons(ack_ids[index].seq);
+		ack.pdu_nb = htons(ack_ids[index].pdu_nb);
+		ack.qos = ack_ids[index].qos;
+		buffer.append((unsigned char *)&ack, sizeof(ack));
+	}
+}
+
 saloha_id_t SlottedAlohaPacketCtrl::getId() const
 {
 	return this->data.substr(sizeof(saloha_ctrl_hdr_t),
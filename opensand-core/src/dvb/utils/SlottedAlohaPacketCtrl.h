@@ -47,6 +47,15 @@ typedef struct
 	tal_id_t tal_id;        ///< The destination terminal
 } __attribute__((__packed__)) saloha_ctrl_hdr_t;
 
+/// A packet identifier in an ACK control packet, following the header
+typedef struct
+{
+	uint32_t id;
+	uint16_t seq;
+	uint16_t pdu_nb;
+	uint8_t qos;
+} __attribute__((__packed__)) saloha_ctrl_ack_t;
+
 
 /**
  * @class SlottedAlohaPacketCtrl
@@ -101,6 +110,34 @@ public:
 	 */
 	tal_id_t getTerminalId() const;
 
+	/**
+	 * Get the number of packets acknowledged by an ACK control packet
+	 *
+	 * @return the number of packets identifiers
+	 */
+	std::size_t getAcksCount() const;
+
+	/**
+	 * Get the identifier of a packet acknowledged by an ACK control packet
+	 *
+	 * @param index  The index of the identifier, below getAcksCount
+	 * @return the packet identifier
+	 */
+	saloha_ack_id_t getAck(std::size_t index) const;
+
+	/**
+	 * Write an ACK control packet
+	 *
+	 * @param tal_id   The destination terminal ID
+	 * @param ack_ids  The identifiers of the acknowledged packets
+	 * @param count    The number of identifiers
+	 * @param buffer   OUT: the buffer the packet is appended to
+	 */
+	static void writeAck(tal_id_t tal_id,
+	                     const saloha_ack_id_t *ack_ids,
+	                     std::size_t count,
+	                     Data &buffer);
+
 	/// implementation of virtual fonctions
 	size_t getTotalLength() const;
 	saloha_id_t getUniqueId() const;
@@ -53,7 +53,7 @@ SlottedAlohaPacketData::SlottedAlohaPacketData(const Data &data,
                                                uint16_t pdu_nb,
                                                uint16_t nb_replicas,
                                                time_sf_t timeout_saf):
-	SlottedAlohaPacket(data)
+	SlottedAlohaPacket()
 {
 	saloha_data_hdr_t tmp_head;
 	saloha_data_hdr_t *header;
@@ -61,27 +61,50 @@ SlottedAlohaPacketData::SlottedAlohaPacketData(const Data &data,
 	this->header_length = sizeof(saloha_data_hdr_t);
 	this->timeout_saf = timeout_saf;
 	this->nb_retransmissions = 0;
+	this->payload_replica = nullptr;
 
+	// build <header><replicas><data> at once, the replicas are set later
 	tmp_head.id = htonl(id);
 	tmp_head.ts = htons(ts);
 	tmp_head.seq = htons(seq);
 	tmp_head.pdu_nb = htons(pdu_nb);
-	tmp_head.nb_replicas = 0;
-	this->data.insert(0, (unsigned char *)&tmp_head, this->header_length);
+	tmp_head.nb_replicas = htons(nb_replicas);
+	this->data = Data{(unsigned char *)&tmp_head, this->header_length,
+	                  data, nb_replicas * sizeof(uint16_t)};
 
-	this->setReplicas(NULL, nb_replicas);
 	this->header_length = sizeof(saloha_data_hdr_t) + nb_replicas * sizeof(uint16_t);
 	header = (saloha_data_hdr_t *)this->data.c_str();
 	header->total_length = htons(this->data.length());
 }
 
 SlottedAlohaPacketData::SlottedAlohaPacketData(const Data &data, size_t length):
-	SlottedAlohaPacket(data, length)
+	SlottedAlohaPacket(data, length),
+	payload_replica(nullptr)
 {
 	this->name = "Slotted Aloha data";
 	this->header_length = sizeof(saloha_data_hdr_t);
 }
 
+SlottedAlohaPacketData::SlottedAlohaPacketData(const unsigned char *data, size_t length):
+	SlottedAlohaPacket(data, length),
+	payload_replica(nullptr)
+{
+	this->name = "Slotted Aloha data";
+	this->header_length = sizeof(saloha_data_hdr_t);
+}
+
+SlottedAlohaPacketData::SlottedAlohaPacketData(const unsigned char *data,
+                                               const SlottedAlohaPacketData *payload_replica):
+	SlottedAlohaPacket(data, sizeof(saloha_data_hdr_t) + payload_replica->getReplicasLength()),
+	payload_replica(payload_replica)
+{
+	this->name = "Slotted Aloha data";
+	this->header_length = sizeof(saloha_data_hdr_t);
+	// the replicas carry the same payload, so the same inner packet
+	this->setSrcTalId(payload_replica->getSrcTalId());
+	this->setQos(payload_replica->getQos());
+}
+
 SlottedAlohaPacketData::~SlottedAlohaPacketData()
 {
 }
@@ -234,6 +257,42 @@ void SlottedAlohaPacketData::incNbRetransmissions()
 	this->nb_retransmissions++;
 }
 
+bool SlottedAlohaPacketData::isReplica(const unsigned char *data, size_t length) const
+{
+	const saloha_data_hdr_t *header = (const saloha_data_hdr_t *)data;
+	const saloha_data_hdr_t *own_header = (const saloha_data_hdr_t *)this->data.c_str();
+	size_t offset = sizeof(saloha_data_hdr_t) + this->getReplicasLength();
+
+	// the QoS of the header is replaced by the one of the inner packet on
+	// reception, the inner packet is compared instead
+	if(this->payload_replica != nullptr ||
+	   length != this->getTotalLength() || length > this->data.length() ||
+	   header->id != own_header->id || header->seq != own_header->seq ||
+	   header->pdu_nb != own_header->pdu_nb ||
+	   header->nb_replicas != own_header->nb_replicas)
+	{
+		return false;
+	}
+	return std::equal(data + offset, data + length, this->data.begin() + offset);
+}
+
+bool SlottedAlohaPacketData::isSharedReplica() const
+{
+	return this->payload_replica != nullptr;
+}
+
+void SlottedAlohaPacketData::unshare()
+{
+	if(this->payload_replica == nullptr)
+	{
+		return;
+	}
+	const Data &data = this->payload_replica->getData();
+	std::size_t offset = sizeof(saloha_data_hdr_t) + this->payload_replica->getReplicasLength();
+	this->data.append(data, offset, data.length() - offset);
+	this->payload_replica = nullptr;
+}
+
 size_t SlottedAlohaPacketData::getTotalLength() const
 {
 	saloha_data_hdr_t *header;
@@ -265,9 +324,14 @@ Data SlottedAlohaPacketData::getPayload() const
 
 size_t SlottedAlohaPacketData::getPacketLength(const Data &data)
 {
-	saloha_data_hdr_t *header;
+	return getPacketLength(data.c_str());
+}
+
+size_t SlottedAlohaPacketData::getPacketLength(const unsigned char *data)
+{
+	const saloha_data_hdr_t *header;
 
-	header = (saloha_data_hdr_t *)data.c_str();
+	header = (const saloha_data_hdr_t *)data;
 	return ntohs(header->total_length);
 }
 
@@ -281,4 +345,9 @@ saloha_id_t SlottedAlohaPacketData::getUniqueId(void) const
 	return saloha_id_t(os.str());
 }
 
+saloha_ack_id_t SlottedAlohaPacketData::getAckId(void) const
+{
+	return {this->getId(), this->getSeq(), this->getPduNb(), this->getQos()};
+}
+
 
@@ -74,6 +74,10 @@ private:
 	/// The number of retransmissions of this packet
 	uint16_t nb_retransmissions;
 
+	/// The received replica holding the payload of this one, which only
+	/// holds its header, nullptr if this replica holds its payload
+	const SlottedAlohaPacketData *payload_replica;
+
 public:
 	/**
 	 * Build a slotted Aloha data packet
@@ -96,6 +100,26 @@ public:
 
 	SlottedAlohaPacketData(const Data &data, size_t length);
 
+	/**
+	 * Build a received slotted Aloha data packet
+	 *
+	 * @param data    the received packet
+	 * @param length  the packet length
+	 */
+	SlottedAlohaPacketData(const unsigned char *data, size_t length);
+
+	/**
+	 * Build a received replica of a slotted Aloha data packet which
+	 * shares the payload of another received replica, only its header
+	 * and time slots are copied
+	 *
+	 * @param data             the received replica
+	 * @param payload_replica  the received replica holding the payload,
+	 *                         it must outlive this one or be unshared
+	 */
+	SlottedAlohaPacketData(const unsigned char *data,
+	                       const SlottedAlohaPacketData *payload_replica);
+
 	/**
 	 * Class destructor
 	 */
@@ -165,6 +189,29 @@ public:
 	 */
 	uint16_t getReplica(uint16_t pos) const;
 
+	/**
+	 * Check if a received packet is a replica of this one, whose payload
+	 * can be shared: it only differs by its time slot
+	 *
+	 * @param data    the received packet
+	 * @param length  the packet length
+	 * @return true if the packet is a replica of this one
+	 */
+	bool isReplica(const unsigned char *data, size_t length) const;
+
+	/**
+	 * Check if the payload is held by another replica
+	 *
+	 * @return true if the payload is shared, only the header is available
+	 */
+	bool isSharedReplica() const;
+
+	/**
+	 * Copy the shared payload in the replica, before the replica
+	 * holding it is released
+	 */
+	void unshare();
+
 	/**
 	 * Get qos initial packet
 	 *
@@ -223,6 +270,13 @@ public:
 	void setQos(uint8_t qos);
 	saloha_id_t getUniqueId() const;
 
+	/**
+	 * Get the packet unique identifier in its binary form
+	 *
+	 * @return the identifier carried by the ACK of the packet
+	 */
+	saloha_ack_id_t getAckId() const;
+
 	/**
 	 * Get the packet length from data
 	 *
@@ -230,6 +284,14 @@ public:
 	 * @return the packet length
 	 */
 	static size_t getPacketLength(const Data &data);
+
+	/**
+	 * Get the packet length from a received packet
+	 *
+	 * @param data  The packet content, at least its header
+	 * @return the packet length
+	 */
+	static size_t getPacketLength(const unsigned char *data);
 };
 
 /// A list of Slotted Aloha Data Packets
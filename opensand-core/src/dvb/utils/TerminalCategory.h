@@ -357,7 +357,7 @@ public:
 	 *
 	 * @return  terminal list.
 	 */
-	std::vector<TerminalContext *> getTerminals() const
+	const std::vector<TerminalContext *> &getTerminals() const
 	{
 		return this->terminals;
 	};
@@ -36,14 +36,21 @@
 
 #include "TerminalCategoryDama.h"
 #include "CarriersGroupDama.h"
+#include "TerminalContextDamaRcs.h"
 
 #include <opensand_output/Output.h>
 
 #include <algorithm>
 
 
+const std::vector<TerminalContextDamaRcs *> TerminalCategoryDama::no_terminal;
+
+
 TerminalCategoryDama::TerminalCategoryDama(const std::string& label, AccessType access_type):
-	TerminalCategory<CarriersGroupDama>(label, access_type)
+	TerminalCategory<CarriersGroupDama>(label, access_type),
+	carriers_terminals(),
+	ranks(),
+	next_rank(0)
 {
 }
 
@@ -51,3 +58,86 @@ TerminalCategoryDama::~TerminalCategoryDama()
 {
 }
 
+void TerminalCategoryDama::addTerminal(TerminalContext *terminal)
+{
+	TerminalCategory<CarriersGroupDama>::addTerminal(terminal);
+	this->ranks[terminal] = this->next_rank++;
+
+	TerminalContextDamaRcs *rcs_terminal = dynamic_cast<TerminalContextDamaRcs *>(terminal);
+	if(rcs_terminal != nullptr)
+	{
+		this->indexTerminal(rcs_terminal, rcs_terminal->getCarrierId());
+	}
+}
+
+bool TerminalCategoryDama::removeTerminal(TerminalContext *terminal)
+{
+	if(!TerminalCategory<CarriersGroupDama>::removeTerminal(terminal))
+	{
+		return false;
+	}
+
+	TerminalContextDamaRcs *rcs_terminal = dynamic_cast<TerminalContextDamaRcs *>(terminal);
+	if(rcs_terminal != nullptr)
+	{
+		this->unindexTerminal(rcs_terminal, rcs_terminal->getCarrierId());
+	}
+	this->ranks.erase(terminal);
+	return true;
+}
+
+void TerminalCategoryDama::setTerminalCarrier(TerminalContextDamaRcs *terminal,
+                                              unsigned int carrier_id)
+{
+	unsigned int current_id = terminal->getCarrierId();
+	if(current_id == carrier_id)
+	{
+		return;
+	}
+	terminal->setCarrierId(carrier_id);
+	if(this->ranks.find(terminal) == this->ranks.end())
+	{
+		// not a terminal of this category
+		return;
+	}
+	this->unindexTerminal(terminal, current_id);
+	this->indexTerminal(terminal, carrier_id);
+}
+
+const std::vector<TerminalContextDamaRcs *> &TerminalCategoryDama::getTerminalsInCarriersGroup(
+	unsigned int carrier_id) const
+{
+	auto carrier_it = this->carriers_terminals.find(carrier_id);
+	if(carrier_it == this->carriers_terminals.end())
+	{
+		return no_terminal;
+	}
+	return carrier_it->second;
+}
+
+void TerminalCategoryDama::indexTerminal(TerminalContextDamaRcs *terminal,
+                                         unsigned int carrier_id)
+{
+	auto &carrier_terminals = this->carriers_terminals[carrier_id];
+	const uint64_t rank = this->ranks[terminal];
+	auto position = std::upper_bound(carrier_terminals.begin(), carrier_terminals.end(), rank,
+		[this](uint64_t value, const TerminalContextDamaRcs *other)
+		{
+			return value < this->ranks.at(other);
+		});
+	carrier_terminals.insert(position, terminal);
+}
+
+void TerminalCategoryDama::unindexTerminal(TerminalContextDamaRcs *terminal,
+                                           unsigned int carrier_id)
+{
+	auto carrier_it = this->carriers_terminals.find(carrier_id);
+	if(carrier_it == this->carriers_terminals.end())
+	{
+		return;
+	}
+	auto &carrier_terminals = carrier_it->second;
+	carrier_terminals.erase(std::remove(carrier_terminals.begin(), carrier_terminals.end(), terminal),
+	                        carrier_terminals.end());
+}
+
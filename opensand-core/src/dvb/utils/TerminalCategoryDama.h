@@ -41,9 +41,19 @@
 #include "TerminalContextDama.h"
 #include "CarriersGroupDama.h"
 
+#include <map>
+#include <vector>
+
+
+class TerminalContextDamaRcs;
+
 /**
  * @class TerminalCategoryDama
  * @brief Represent a category of terminal for DAMA
+ *
+ * The terminals of each carriers group are indexed when they log on,
+ * log off or are moved to another carriers group, in their logon order,
+ * so the allocations get them without going through the category.
  */
 class TerminalCategoryDama: public TerminalCategory<CarriersGroupDama>
 {
@@ -59,34 +69,70 @@ public:
 	~TerminalCategoryDama();
 
 	/**
-	 * @brief  Get the terminal list in a specific carriers group
+	 * @brief  Add a terminal to the category and to the
+	 *         index of its carriers group
+	 *
+	 * @param  terminal  terminal to be added.
+	 */
+	void addTerminal(TerminalContext *terminal);
+
+	/**
+	 * @brief  Remove a terminal from the category and from the
+	 *         index of its carriers group
+	 *
+	 * @param  terminal  terminal to be removed.
+	 * @return true on success, false otherwise
+	 */
+	bool removeTerminal(TerminalContext *terminal);
+
+	/**
+	 * @brief  Move a terminal of the category to another carriers group
+	 *
+	 * @param  terminal    the terminal
+	 * @param  carrier_id  the ID of its new carriers group
+	 */
+	void setTerminalCarrier(TerminalContextDamaRcs *terminal,
+	                        unsigned int carrier_id);
+
+	/**
+	 * @brief  Get the terminals in a specific carriers group
 	 *
-	 * @tparam T            a terminal context
 	 * @param  carrier_id   the carrier ID
-	 * @return  terminal list in the carriers group
+	 * @return  the terminals of the carriers group in their logon order,
+	 *          valid until a terminal of the category logs on, logs off
+	 *          or is moved
 	 */
-	template<class T>
-	std::vector<T *> getTerminalsInCarriersGroup(
+	const std::vector<TerminalContextDamaRcs *> &getTerminalsInCarriersGroup(
 	                             unsigned int carrier_id) const;
 
-};
+private:
+	/**
+	 * @brief  Insert a terminal in the index of a carriers group
+	 *
+	 * @param  terminal    the terminal
+	 * @param  carrier_id  the ID of the carriers group
+	 */
+	void indexTerminal(TerminalContextDamaRcs *terminal, unsigned int carrier_id);
 
-template<class T>
-std::vector<T *> TerminalCategoryDama::getTerminalsInCarriersGroup(unsigned int carrier_id) const
-{
-	std::vector<T *> entries;
-	std::vector<TerminalContext *>::const_iterator it;
-	for(it = this->terminals.begin();
-	    it != this->terminals.end(); ++it)
-	{
-		T *terminal = dynamic_cast<T *>(*it);
-		if(terminal->getCarrierId() == carrier_id)
-		{
-			entries.push_back(terminal);
-		}
-	}
-	return entries;
-}
+	/**
+	 * @brief  Remove a terminal from the index of a carriers group
+	 *
+	 * @param  terminal    the terminal
+	 * @param  carrier_id  the ID of the carriers group
+	 */
+	void unindexTerminal(TerminalContextDamaRcs *terminal, unsigned int carrier_id);
+
+	/// The terminals of each carriers group, in their logon order
+	std::map<unsigned int, std::vector<TerminalContextDamaRcs *>> carriers_terminals;
+
+	/// The logon rank of each terminal, to keep the index in the order
+	/// of the category terminals when a terminal changes of group
+	std::map<const TerminalContext *, uint64_t> ranks;
+	uint64_t next_rank;
+
+	/// No terminal in a carriers group
+	static const std::vector<TerminalContextDamaRcs *> no_terminal;
+};
 
 #endif
 
@@ -108,6 +108,19 @@ std::map<unsigned int, Slot *> TerminalCategorySaloha::getSlots(void) const
 	return slots;
 }
 
+Slot *TerminalCategorySaloha::getSlot(unsigned int slot_id) const
+{
+	for(auto &&carriers: this->carriers_groups)
+	{
+		Slot *slot = carriers->getSlot(slot_id);
+		if(slot != nullptr)
+		{
+			return slot;
+		}
+	}
+	return nullptr;
+}
+
 saloha_packets_data_t *TerminalCategorySaloha::getAcceptedPackets(void)
 {
 	return this->accepted_packets;
@@ -81,6 +81,14 @@ public:
 	 */
 	std::map<unsigned int, Slot *> getSlots(void) const;
 
+	/**
+	 * @brief Get a slot of the category, without gathering all of them
+	 *
+	 * @param slot_id  The slot ID
+	 * @return the slot, nullptr if it does not exist
+	 */
+	Slot *getSlot(unsigned int slot_id) const;
+
 	/**
 	 * @brief Get the packets that can be transmitted to
 	 *        encapsulation block
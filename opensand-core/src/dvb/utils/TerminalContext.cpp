@@ -42,7 +42,10 @@ TerminalContext::TerminalContext(tal_id_t tal_id):
 	tal_id(tal_id),
 	category("")
 {
-	this->log_band = Output::Get()->registerLog(LEVEL_WARNING, "Dvb.Ncc.Band");
+	// shared by all the terminals, not registered again at each logon
+	static std::shared_ptr<OutputLog> log_band =
+		Output::Get()->registerLog(LEVEL_WARNING, "Dvb.Ncc.Band");
+	this->log_band = log_band;
 }
 
 TerminalContext::~TerminalContext()
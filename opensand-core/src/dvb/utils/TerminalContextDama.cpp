@@ -257,3 +257,24 @@ bool TerminalContextDama::sortByVbdcReq(const TerminalContextDama *e1,
 	return e1->vbdc_request_kb > e2->vbdc_request_kb;
 }
 
+void TerminalContextDama::getState(dama_terminal_state_t &state) const
+{
+	state.cra_kbps = this->cra_request_kbps;
+	state.max_rbdc_kbps = this->max_rbdc_kbps;
+	state.max_vbdc_kb = this->max_vbdc_kb;
+	state.rbdc_request_kbps = this->rbdc_request_kbps;
+	state.rbdc_credit = this->rbdc_credit;
+	state.rbdc_timer_sf = this->timer_sf;
+	state.vbdc_request_kb = this->vbdc_request_kb;
+}
+
+void TerminalContextDama::setState(const dama_terminal_state_t &state)
+{
+	this->cra_request_kbps = state.cra_kbps;
+	this->max_rbdc_kbps = state.max_rbdc_kbps;
+	this->max_vbdc_kb = state.max_vbdc_kb;
+	this->rbdc_request_kbps = std::min(state.rbdc_request_kbps, this->max_rbdc_kbps);
+	this->rbdc_credit = state.rbdc_credit;
+	this->timer_sf = std::min(state.rbdc_timer_sf, this->rbdc_timeout_sf);
+	this->vbdc_request_kb = std::min(state.vbdc_request_kb, this->max_vbdc_kb);
+}
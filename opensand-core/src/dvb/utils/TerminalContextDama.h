@@ -42,6 +42,30 @@
 #include "UnitConverter.h"
 #include "FmtDefinition.h"
 
+
+/**
+ * @brief The request state of a DAMA terminal context that outlives
+ *        a superframe, as checkpointed by the NCC
+ */
+struct dama_terminal_state_t
+{
+	/// Required CRA (kb/s)
+	rate_kbps_t cra_kbps;
+	/// Maximal RBDC value (kb/s)
+	rate_kbps_t max_rbdc_kbps;
+	/// Maximal VBDC value (kb)
+	vol_kb_t max_vbdc_kb;
+	/// The RBDC request (kb/s)
+	rate_kbps_t rbdc_request_kbps;
+	/// The RBDC credit
+	double rbdc_credit;
+	/// The remaining superframes before the RBDC request times out
+	time_sf_t rbdc_timer_sf;
+	/// The VBDC request still to be served (kb)
+	vol_kb_t vbdc_request_kb;
+};
+
+
 /**
  * @class TerminalContextDama
  * @brief Interface for a terminal context to be used in a DAMA controller.
@@ -264,6 +288,21 @@ public:
 	static bool sortByVbdcReq(const TerminalContextDama *e1,
 	                          const TerminalContextDama *e2);
 
+	/**
+	 * @brief Get the request state of the terminal
+	 *
+	 * @param state  OUT: the request state
+	 */
+	void getState(dama_terminal_state_t &state) const;
+
+	/**
+	 * @brief Restore a request state, the allocations are left untouched
+	 *        as they are computed again on the next superframe
+	 *
+	 * @param state  The request state
+	 */
+	void setState(const dama_terminal_state_t &state);
+
 protected:
 	/** Required CRA for the terminal (kb/s) */
 	rate_kbps_t cra_request_kbps;
@@ -41,20 +41,16 @@
 constexpr const saloha_pdu_id_t MAX_OLD_COUNTER = 0xFFFF;
 
 
-static bool sortSalohaPacketData(const std::unique_ptr<SlottedAlohaPacketData>& pkt1,
-                                 const std::unique_ptr<SlottedAlohaPacketData>& pkt2)
-{
-	return pkt1->getSeq() < pkt2->getSeq();
-}
-
-
 TerminalContextSaloha::TerminalContextSaloha(tal_id_t tal_id):
 	TerminalContext(tal_id),
 	wait_propagation(),
 	oldest_id(),
 	old_count(0)
 {
-	this->log_saloha = Output::Get()->registerLog(LEVEL_WARNING, "Dvb.SlottedAloha");
+	// shared by all the terminals, not registered again at each logon
+	static std::shared_ptr<OutputLog> log_saloha =
+		Output::Get()->registerLog(LEVEL_WARNING, "Dvb.SlottedAloha");
+	this->log_saloha = log_saloha;
 }
 
 
@@ -69,51 +65,35 @@ PropagateState TerminalContextSaloha::addPacket(std::unique_ptr<SlottedAlohaPack
                                                 saloha_packets_data_t &pdu)
 {
 	saloha_pdu_id_t pdu_id = packet->getId();
-	saloha_id_t pkt_id = packet->getUniqueId();
 	qos_t qos = packet->getQos();
-	saloha_packets_data_t sa_packets;
-	uint16_t id[4];
-
-	SlottedAlohaPacketData::convertPacketId(pkt_id, id);
-	
-/*
-	auto wait_it = this->wait_propagation.find(qos);
-	if(wait_it != this->wait_propagation.end())
+	uint16_t seq = packet->getSeq();
+	uint16_t pdu_nb = packet->getPduNb();
+	pdus_t &pdus = this->wait_propagation[qos];
+	saloha_packets_data_t &fragments = pdus[pdu_id];
+
+	// keep the fragments sorted on their sequence, they are mostly
+	// received in order but in case of loss this order is not ensured
+	auto position = fragments.end();
+	while(position != fragments.begin() && (*(position - 1))->getSeq() > seq)
 	{
-		// the entry for this qos already exists
-		auto pdus = wait_it->second;
-		if(pdus.find(pdu_id) != pdus.end())
-		{
-			// the entry for this PDU already exists
-			this->wait_propagation[qos][pdu_id].push_back(std::move(packet));
-		}
-		else
-		{
-			// create the entry for this PDU
-			this->wait_propagation[qos][pdu_id] = {std::move(packet)};
-		}
+		--position;
 	}
-	else
+	if(position != fragments.begin() && (*(position - 1))->getSeq() == seq)
 	{
-		// create PDU entry for this qos
-		std::vector<std::unique_ptr<SlottedAlohaPacketData>> p{std::move(packet)};
-		this->wait_propagation[qos] = pdus_t{pdu_id, std::move(p)};
+		LOG(this->log_saloha, LEVEL_INFO,
+		    "Packet %u of PDU %u already received, drop it\n",
+		    seq, pdu_id);
+		return PropagateState::NoPropagation;
 	}
-*/
-	this->wait_propagation[qos][pdu_id].push_back(std::move(packet));
+	fragments.insert(position, std::move(packet));
 
 	// check if PDU is complete
-	if(id[SALOHA_ID_PDU_NB] == sa_packets.size())
+	if(fragments.size() == pdu_nb)
 	{
-		auto pdu_it = this->wait_propagation[qos].find(pdu_id);
-		pdu = std::move(pdu_it->second);
-		// packets should be received in correct order, but
-		// in case of loss this order is not ensured
-		// => need to sort on seq (see operator in SlottedAlohaPacketData)
-		sort(pdu.begin(), pdu.end(), sortSalohaPacketData);
+		pdu = std::move(fragments);
 
 		// clear element
-		this->wait_propagation[qos].erase(pdu_it);
+		pdus.erase(pdu_id);
 
 		// new pdu, increase old counter
 		this->old_count++;
@@ -68,6 +68,8 @@ public:
 
 	/**
 	 * @brief Add a new received packet in context and check if the PDU is complete
+	 *        The packets of a PDU are kept sorted on their sequence so a
+	 *        complete PDU is ready to be propagated
 	 *
 	 * @param packet  The Slotted Aloha Data packet
 	 * @param pdu     OUT: A list of packets if the PDU is complete or an empty
@@ -41,6 +41,7 @@
 
 #include <cstring>
 #include <arpa/inet.h>
+#include <endian.h>
 
 
 
@@ -69,6 +70,19 @@ Ttp::Ttp(group_id_t group_id, time_sf_t sf_id):
 	));
 	this->frame()->ttp.ttp_info.group_id = group_id;
 	this->frame()->ttp.ttp_info.superframe_count = htons(sf_id);
+	this->frame()->ttp.ttp_info.flags = 0;
+}
+
+
+void Ttp::reserveTimePlans(std::size_t tp_count)
+{
+	std::size_t size = sizeof(T_DVB_TTP) + NBR_MAX_FRAMES * (
+		sizeof(emu_frame_t) + tp_count * sizeof(emu_tp_t)
+	);
+	if(size > this->getMaxSize())
+	{
+		this->setMaxSize(size);
+	}
 }
 
 
@@ -80,6 +94,9 @@ bool Ttp::addTimePlan(time_frame_t frame_id,
                       uint8_t priority)
 {
 	emu_tp_t tp;
+	std::size_t frame_index;
+	std::size_t position;
+	frame_info_t *frame_info;
 
 	tp.tal_id = htons(tal_id);
 	tp.offset = htonl(offset);
@@ -87,26 +104,46 @@ bool Ttp::addTimePlan(time_frame_t frame_id,
 	tp.fmt_id = fmt_id;
 	tp.priority = priority;
 
-	// create the entry for this frame id if it does not exist
-	if(this->frames.find(frame_id) == this->frames.end())
+	// find the frame, or create it at the end of the TTP
+	for(frame_index = 0; frame_index < this->frames.size(); ++frame_index)
 	{
-		time_plans_t time_plans;
-		time_plans.push_back(tp);
-		this->frames.insert({frame_id, time_plans});
+		if(this->frames[frame_index].first == frame_id)
+		{
+			break;
+		}
 	}
-	// add the TP to the list of TP for this frame ID
-	else
+	if(frame_index == this->frames.size())
 	{
-		this->frames[frame_id].push_back(tp);
+		frame_info_t info;
+		info.frame_number = frame_id;
+		info.tp_loop_count = 0;
+		this->frames.emplace_back(frame_id, this->data.size());
+		this->data.append((unsigned char *)&info, sizeof(frame_info_t));
+		this->frame()->ttp.ttp_info.frame_loop_count = this->frames.size();
 	}
-	/* not compatible with simulated STs => remove if this is ok
-	if(this->frames[frame_id].size() > BROADCAST_TAL_ID)
+
+	// the TP goes after the last one of its frame, the following
+	// frames are moved if there is any
+	frame_info = (frame_info_t *)(this->data.data() + this->frames[frame_index].second);
+	position = this->frames[frame_index].second + sizeof(frame_info_t) +
+	           frame_info->tp_loop_count * sizeof(emu_tp_t);
+	if(position == this->data.size())
 	{
-		LOG(ttp_log, LEVEL_ERROR,
-		    "Too many time plans for frame id %u\n", frame_id);
-		this->frames[frame_id].pop_back();
-		return false;
-	}*/
+		this->data.append((unsigned char *)&tp, sizeof(emu_tp_t));
+	}
+	else
+	{
+		this->data.insert(position, (unsigned char *)&tp, sizeof(emu_tp_t));
+		for(std::size_t index = frame_index + 1; index < this->frames.size(); ++index)
+		{
+			this->frames[index].second += sizeof(emu_tp_t);
+		}
+	}
+	// the data may have moved
+	frame_info = (frame_info_t *)(this->data.data() + this->frames[frame_index].second);
+	frame_info->tp_loop_count++;
+	this->setMessageLength(this->data.size());
+
 	LOG(ttp_log, LEVEL_DEBUG,
 	    "Add TP for ST%u at frame %u with offset=%u, "
 	    "assignment_count=%u, fmt=%u, priority=%u\n",
@@ -116,61 +153,140 @@ bool Ttp::addTimePlan(time_frame_t frame_id,
 }
 
 
+void Ttp::reset()
+{
+	this->frames.clear();
+	this->data.resize(sizeof(T_DVB_TTP));
+	this->frame()->ttp.ttp_info.frame_loop_count = 0;
+	this->setMessageLength(sizeof(T_DVB_TTP));
+}
+
+
+void Ttp::setSparse(bool sparse)
+{
+	if(sparse)
+	{
+		this->frame()->ttp.ttp_info.flags |= TTP_FLAG_SPARSE;
+	}
+	else
+	{
+		this->frame()->ttp.ttp_info.flags &= ~TTP_FLAG_SPARSE;
+	}
+}
+
+
 bool Ttp::build(void)
 {
-	unsigned int frame_count = 0;
-	time_plans_t::iterator tp_it;
-	unsigned int tp_count;
-	size_t ttp_length = 0;
-
-	ttp_length = sizeof(T_DVB_TTP);
-	// get the beginning of the frame
-	for(auto&& frame_it : this->frames)
-	{
-		std::vector<emu_tp_t> tp_list = frame_it.second;
-		emu_frame_t emu_frame;
-
-		emu_frame.frame_info.frame_number = frame_it.first;
-		ttp_length += sizeof(frame_info_t);
-		tp_count = 0;
-		this->data.append((unsigned char *)&emu_frame, sizeof(emu_frame_t));
-		// get the first TP
-		for(tp_it = tp_list.begin(); tp_it != tp_list.end(); ++tp_it)
+	if(this->getMessageLength() != this->data.size())
+	{
+		return false;
+	}
+	return !this->isSparse() || this->buildIndex();
+}
+
+
+bool Ttp::buildIndex()
+{
+	std::size_t tp_count = 0;
+	emu_tp_t *tps = nullptr;
+	ttp_index_t index;
+
+	if(this->frames.size() > 1)
+	{
+		LOG(ttp_log, LEVEL_ERROR,
+		    "a sparse TTP has one frame, not %zu\n",
+		    this->frames.size());
+		return false;
+	}
+	if(!this->frames.empty())
+	{
+		frame_info_t *frame_info = (frame_info_t *)(this->data.data() + this->frames[0].second);
+		tp_count = frame_info->tp_loop_count;
+		tps = (emu_tp_t *)(this->data.data() + this->frames[0].second + sizeof(frame_info_t));
+	}
+
+	// the terminals of the TPs, 64 by 64
+	std::vector<ttp_index_block_t> blocks;
+	for(std::size_t position = 0; position < tp_count; ++position)
+	{
+		const tal_id_t tal_id = ntohs(tps[position].tal_id);
+		const std::size_t block = tal_id / TTP_INDEX_BLOCK_TERMINALS;
+		const uint64_t terminal = uint64_t(1) << (tal_id % TTP_INDEX_BLOCK_TERMINALS);
+		if(block >= blocks.size())
+		{
+			blocks.resize(block + 1, ttp_index_block_t{0, 0});
+		}
+		if(blocks[block].terminals & terminal)
 		{
-			this->data.append((unsigned char *)&(*tp_it), sizeof(emu_tp_t));
-			ttp_length += sizeof(emu_tp_t);
-			tp_count++;
+			LOG(ttp_log, LEVEL_ERROR,
+			    "a sparse TTP has one TP per terminal, ST%u has several\n",
+			    tal_id);
+			return false;
 		}
-		this->frame()->ttp.frames[frame_count].frame_info.tp_loop_count = tp_count;
-		frame_count++;
+		blocks[block].terminals |= terminal;
+	}
+	std::size_t rank = 0;
+	for(auto &&block: blocks)
+	{
+		block.first_tp = rank;
+		rank += __builtin_popcountll(block.terminals);
+	}
+
+	// the rank of a TP is the number of terminals before it, the TPs
+	// are moved to their rank without sorting them
+	if(tp_count > 0)
+	{
+		std::vector<emu_tp_t> added(tps, tps + tp_count);
+		for(auto &&tp: added)
+		{
+			const tal_id_t tal_id = ntohs(tp.tal_id);
+			const ttp_index_block_t &block = blocks[tal_id / TTP_INDEX_BLOCK_TERMINALS];
+			const uint64_t before = (uint64_t(1) << (tal_id % TTP_INDEX_BLOCK_TERMINALS)) - 1;
+			tps[block.first_tp + __builtin_popcountll(block.terminals & before)] = tp;
+		}
+	}
+
+	index.block_count = htons(blocks.size());
+	this->data.append((unsigned char *)&index, sizeof(ttp_index_t));
+	for(auto &&block: blocks)
+	{
+		ttp_index_block_t index_block;
+		index_block.terminals = htobe64(block.terminals);
+		index_block.first_tp = htons(block.first_tp);
+		this->data.append((unsigned char *)&index_block, sizeof(ttp_index_block_t));
 	}
-	this->frame()->ttp.ttp_info.frame_loop_count = frame_count;
-	// update message length
-	// TODO we may use getPayloadLength, this should be the same value
-	this->setMessageLength(ttp_length);
+	this->setMessageLength(this->data.size());
 
+	LOG(ttp_log, LEVEL_DEBUG,
+	    "SF#%u: sparse TTP with %zu TPs indexed in %zu blocks\n",
+	    this->getSuperframeCount(), tp_count, blocks.size());
 	return true;
 }
 
 
-bool Ttp::getTp(tal_id_t tal_id, std::map<uint8_t, emu_tp_t> &tps)
+bool Ttp::getTp(tal_id_t tal_id, std::map<uint8_t, emu_tp_t> &tps) const
 {
 	size_t length = this->getMessageLength();
-	emu_ttp_t *ttp;
+	const emu_ttp_t *ttp;
 
 	// we need this unsigned char * for arithmetical operations
 	// on pointers as frame size is not constant
-	unsigned char *frame_start;
+	const unsigned char *frame_start;
 
 	/* check that data contains DVB header, superframe_count and
 	 * frame_loop_count */
-	if(length < sizeof(T_DVB_TTP))
+	if(length < sizeof(T_DVB_TTP) || length > this->data.size())
 	{
 		LOG(ttp_log, LEVEL_ERROR,
 		    "Length is to small for a TTP\n");
 		return false;
 	}
-	length -= sizeof(T_DVB_HDR);
+	length -= sizeof(T_DVB_TTP);
+
+	if(this->isSparse())
+	{
+		return this->getIndexedTp(tal_id, tps);
+	}
 
 	ttp = &(this->frame()->ttp);
 	LOG(ttp_log, LEVEL_DEBUG,
@@ -178,57 +294,130 @@ bool Ttp::getTp(tal_id_t tal_id, std::map<uint8_t, emu_tp_t> &tps)
 	    this->getSuperframeCount(),
 	    ttp->ttp_info.frame_loop_count);
 
-	length -= sizeof(ttp_info_t);
-	frame_start = (unsigned char *)(&ttp->frames);
+	frame_start = (const unsigned char *)(&ttp->frames);
 	for(unsigned int i = 0; i < ttp->ttp_info.frame_loop_count; i++)
 	{
-		emu_tp_t *tp;
-		emu_frame_t *emu_frame = (emu_frame_t *)frame_start;
+		const emu_tp_t *tp;
+		const emu_frame_t *emu_frame = (const emu_frame_t *)frame_start;
 
-		if(length < sizeof(frame_info_t) + emu_frame->frame_info.tp_loop_count * sizeof(emu_tp_t))
+		if(length < sizeof(frame_info_t) ||
+		   length - sizeof(frame_info_t) < emu_frame->frame_info.tp_loop_count * sizeof(emu_tp_t))
 		{
 			LOG(ttp_log, LEVEL_ERROR,
 			    "Length is too small for the given tp number\n");
 			return false;
 		}
 		// update length
-		length -= sizeof(frame_info_t);
+		length -= sizeof(frame_info_t) + emu_frame->frame_info.tp_loop_count * sizeof(emu_tp_t);
 		LOG(ttp_log, LEVEL_DEBUG,
 		    "SF#%u: frame #%u tbtp_loop_count=%u\n",
 		    this->getSuperframeCount(), i,
 		    emu_frame->frame_info.tp_loop_count);
-		// get the first TP
-		// increase from 1 * sizeof(tp)
-		tp = (emu_tp_t *)(&emu_frame->tp);
-		for(unsigned int j = 0; j < emu_frame->frame_info.tp_loop_count; j++)
+		// read the TPs in place, only the ones of the terminal are copied
+		tp = (const emu_tp_t *)(&emu_frame->tp);
+		for(unsigned int j = 0; j < emu_frame->frame_info.tp_loop_count; j++, tp++)
 		{
-			length -= sizeof(emu_tp_t);
 			if(ntohs(tp->tal_id) != tal_id)
 			{
 				LOG(ttp_log, LEVEL_DEBUG,
 				    "SF#%u: TP for ST%u ignored\n",
 				    this->getSuperframeCount(),
 				    ntohs(tp->tal_id));
-				tp = tp + 1;
 				continue;
 			}
-			tp->offset = ntohl(tp->offset);
-			tp->assignment_count = ntohs(tp->assignment_count);
-			tps[emu_frame->frame_info.frame_number] = *tp;
+			emu_tp_t &found = tps[emu_frame->frame_info.frame_number];
+			found = *tp;
+			found.tal_id = tal_id;
+			found.offset = ntohl(tp->offset);
+			found.assignment_count = ntohs(tp->assignment_count);
 			LOG(ttp_log, LEVEL_DEBUG,
 			    "SF#%u: frame#%u tbtp#%u: tal_id:%u, "
 			    "offset:%u, assignment_count:%u, "
 			    "fmt_id:%u priority:%u\n",
 			    this->getSuperframeCount(), i, j,
-			    tal_id, tp->offset, tp->assignment_count,
-			    tp->fmt_id, tp->priority);
-			// increase from 1 * sizeof(tp), we do not need to
-			// use an unsigned char * for arithmetic operation here
-			tp = tp + 1;
+			    tal_id, found.offset, found.assignment_count,
+			    found.fmt_id, found.priority);
 		}
 		// go to next frame
-		frame_start = frame_start + emu_frame->frame_info.tp_loop_count * sizeof(emu_tp_t);
+		frame_start = (const unsigned char *)tp;
+	}
+
+	return true;
+}
+
+
+bool Ttp::getIndexedTp(tal_id_t tal_id, std::map<uint8_t, emu_tp_t> &tps) const
+{
+	size_t length = this->getMessageLength() - sizeof(T_DVB_TTP);
+	const emu_ttp_t *ttp = &(this->frame()->ttp);
+	const unsigned char *index_start = (const unsigned char *)(&ttp->frames);
+	const emu_frame_t *emu_frame = nullptr;
+	std::size_t tp_count = 0;
+
+	if(ttp->ttp_info.frame_loop_count > 1)
+	{
+		LOG(ttp_log, LEVEL_ERROR,
+		    "a sparse TTP has one frame, not %u\n",
+		    ttp->ttp_info.frame_loop_count);
+		return false;
+	}
+	if(ttp->ttp_info.frame_loop_count == 1)
+	{
+		emu_frame = (const emu_frame_t *)index_start;
+		if(length < sizeof(frame_info_t) ||
+		   length - sizeof(frame_info_t) < emu_frame->frame_info.tp_loop_count * sizeof(emu_tp_t))
+		{
+			LOG(ttp_log, LEVEL_ERROR,
+			    "Length is too small for the given tp number\n");
+			return false;
+		}
+		tp_count = emu_frame->frame_info.tp_loop_count;
+		length -= sizeof(frame_info_t) + tp_count * sizeof(emu_tp_t);
+		index_start = (const unsigned char *)(&emu_frame->tp[tp_count]);
 	}
 
+	const ttp_index_t *index = (const ttp_index_t *)index_start;
+	if(length < sizeof(ttp_index_t) ||
+	   length - sizeof(ttp_index_t) < ntohs(index->block_count) * sizeof(ttp_index_block_t))
+	{
+		LOG(ttp_log, LEVEL_ERROR,
+		    "Length is too small for the TTP index\n");
+		return false;
+	}
+
+	// a terminal out of the index or not set in its block has no TP
+	const std::size_t block = tal_id / TTP_INDEX_BLOCK_TERMINALS;
+	if(block >= ntohs(index->block_count))
+	{
+		return true;
+	}
+	const uint64_t terminals = be64toh(index->blocks[block].terminals);
+	const unsigned int bit = tal_id % TTP_INDEX_BLOCK_TERMINALS;
+	if(!((terminals >> bit) & 1))
+	{
+		return true;
+	}
+	const std::size_t rank = ntohs(index->blocks[block].first_tp) +
+	                         __builtin_popcountll(terminals & ((uint64_t(1) << bit) - 1));
+	if(rank >= tp_count || ntohs(emu_frame->tp[rank].tal_id) != tal_id)
+	{
+		LOG(ttp_log, LEVEL_ERROR,
+		    "the TTP index does not match the TP of ST%u\n", tal_id);
+		return false;
+	}
+
+	const emu_tp_t *tp = &emu_frame->tp[rank];
+	emu_tp_t &found = tps[emu_frame->frame_info.frame_number];
+	found = *tp;
+	found.tal_id = tal_id;
+	found.offset = ntohl(tp->offset);
+	found.assignment_count = ntohs(tp->assignment_count);
+	LOG(ttp_log, LEVEL_DEBUG,
+	    "SF#%u: frame#%u indexed tbtp#%zu: tal_id:%u, "
+	    "offset:%u, assignment_count:%u, "
+	    "fmt_id:%u priority:%u\n",
+	    this->getSuperframeCount(), emu_frame->frame_info.frame_number,
+	    rank, tal_id, found.offset, found.assignment_count,
+	    found.fmt_id, found.priority);
 	return true;
 }
@@ -54,8 +54,31 @@ typedef struct
 	uint16_t superframe_count; ///< Superframe count to wich the TP applies
 	// TODO we don't do one less
 	uint8_t frame_loop_count;  ///< One less than the number of superframe
+	uint8_t flags;             ///< The TTP flags, see TTP_FLAG_SPARSE
 } __attribute__((packed)) ttp_info_t;
 
+/// The TTP only has the Time Plans of the terminals with an allocation,
+/// in one frame, and ends with an index of the terminals
+constexpr const uint8_t TTP_FLAG_SPARSE = 0x01;
+
+/// The number of terminals of an index block of a sparse TTP
+constexpr const unsigned int TTP_INDEX_BLOCK_TERMINALS = 64;
+
+/** A block of the index of a sparse TTP */
+typedef struct
+{
+	uint64_t terminals;  ///< The terminals of the block with a Time Plan,
+	                     //   bit n for the terminal n of the block
+	uint16_t first_tp;   ///< The rank of the first Time Plan of the block
+} __attribute__((packed)) ttp_index_block_t;
+
+/** The index of a sparse TTP, after its Time Plans sorted by terminal */
+typedef struct
+{
+	uint16_t block_count;         ///< The number of blocks
+	ttp_index_block_t blocks[0];  ///< The blocks, the terminals 64 by 64
+} __attribute__((packed)) ttp_index_t;
+
 /** The information related to frame */
 typedef struct
 {
@@ -126,7 +149,15 @@ public:
 	~Ttp() {};
 
 	/**
-	 * @brief Add the new Time Plan entry
+	 * @brief Reserve the frame buffer for a number of Time Plans,
+	 *        to add them without reallocation
+	 *
+	 * @param tp_count  The number of Time Plans that will be added
+	 */
+	void reserveTimePlans(std::size_t tp_count);
+
+	/**
+	 * @brief Add the new Time Plan entry, encoded in place in the frame
 	 *
 	 * @param frame_id         The frame ID
 	 * @param tal_id           The terminal ID
@@ -145,26 +176,39 @@ public:
 	                 uint8_t priority);
 
 	/**
-	 * @brief Clean the internal frames
+	 * @brief Remove the Time Plans
 	 */
 	void reset();
 
 	/**
-	 * @brief Build the TTP
+	 * @brief Set whether the TTP is sparse: the terminals without a Time
+	 *        Plan have no allocation and a terminal finds its Time Plan
+	 *        through the index of the TTP, written when it is built
+	 *
+	 * @param sparse  Whether the TTP is sparse
+	 */
+	void setSparse(bool sparse);
+
+	/**
+	 * @brief Build the TTP, the Time Plans are already encoded
+	 *        in the frame so there is nothing left to do but the index
+	 *        of a sparse TTP, whose Time Plans are sorted by terminal
 	 *
 	 * @return true on success, false othertwise
 	 */
 	bool build(void);
 
 	/**
-	 * @brief Get the Time Plan for a terminal
+	 * @brief Get the Time Plan for a terminal, the frame is read in place
+	 *        and left untouched, the index of a sparse TTP gives the
+	 *        Time Plan without reading the other ones
 	 *
 	 * @param tal_id The terminal ID for which we want the TP
-	 * @param tp     The Time Plans per superframe id
+	 * @param tp     The Time Plans per superframe id, in host byte order
 	 *
-	 * @return true if a TP is found, false otherwise
+	 * @return false if the TTP is malformed, true otherwise
 	 */
-	bool getTp(tal_id_t tal_id, std::map<uint8_t, emu_tp_t> &tps);
+	bool getTp(tal_id_t tal_id, std::map<uint8_t, emu_tp_t> &tps) const;
 
 	/**
 	 * @brief  Get the group Id
@@ -186,17 +230,44 @@ public:
 		return ntohs(this->frame()->ttp.ttp_info.superframe_count);
 	};
 
+	/**
+	 * @brief  Whether the TTP is sparse
+	 *
+	 * @return true if the TTP only has the Time Plans of the terminals
+	 *         with an allocation
+	 */
+	bool isSparse() const
+	{
+		return this->frame()->ttp.ttp_info.flags & TTP_FLAG_SPARSE;
+	};
+
 	/// The log for TTP
 	static std::shared_ptr<OutputLog> ttp_log;
 
 private:
-	/// A list of time plans
-	typedef std::vector<emu_tp_t> time_plans_t;
-	/// The list of frames and their TP
-	typedef std::map<uint8_t, time_plans_t> frames_t;
+	/// A frame of the TTP: its number and the offset of its
+	/// information in the TTP
+	typedef std::pair<uint8_t, std::size_t> frame_offset_t;
+
+	/**
+	 * @brief Sort the Time Plans of a sparse TTP by terminal and index them
+	 *
+	 * @return true on success, false othertwise
+	 */
+	bool buildIndex();
+
+	/**
+	 * @brief Get the Time Plan for a terminal from the index of a sparse TTP
+	 *
+	 * @param tal_id  The terminal ID for which we want the TP
+	 * @param tp      The Time Plans per superframe id, in host byte order
+	 *
+	 * @return false if the TTP is malformed, true otherwise
+	 */
+	bool getIndexedTp(tal_id_t tal_id, std::map<uint8_t, emu_tp_t> &tps) const;
 
-	/// The frames, completed each time we add a TP
-	frames_t frames;
+	/// The frames, in the TTP order
+	std::vector<frame_offset_t> frames;
 };
 
 
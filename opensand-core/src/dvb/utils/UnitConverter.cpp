@@ -36,7 +36,24 @@
 
 #include <math.h>
 
-UnitConverter::UnitConverter(time_ms_t duration_ms, unsigned int efficiency)
+FixedDivisor::FixedDivisor(uint32_t divisor):
+	divisor(divisor),
+	reciprocal(0)
+{
+	if(this->divisor > 1)
+	{
+		this->reciprocal = UINT64_MAX / this->divisor + 1;
+	}
+}
+
+
+UnitConverter::UnitConverter(time_ms_t duration_ms, unsigned int efficiency):
+	frame_duration_ms(0),
+	frame_duration_ms_inv(0.0),
+	modulation_efficiency(0),
+	modulation_efficiency_inv(0.0),
+	frame_duration_div(),
+	modulation_efficiency_div()
 {
 	this->setFrameDuration(duration_ms);
 	this->setModulationEfficiency(efficiency);
@@ -46,6 +63,10 @@ UnitConverter::~UnitConverter()
 {
 }
 
+void UnitConverter::updateEfficiencyFactors()
+{
+}
+
 unsigned int UnitConverter::getSlotsNumber(rate_symps_t carrier_symps) const
 {
 	vol_sym_t slot_sym;
@@ -61,6 +82,7 @@ unsigned int UnitConverter::getSlotsNumber(rate_symps_t carrier_symps) const
 void UnitConverter::setFrameDuration(time_ms_t duration_ms)
 {
 	this->frame_duration_ms = duration_ms;
+	this->frame_duration_div = FixedDivisor(duration_ms);
 	if(0 < this->frame_duration_ms)
 	{
 		this->frame_duration_ms_inv = 1.0 / this->frame_duration_ms;
@@ -78,7 +100,13 @@ time_ms_t UnitConverter::getFrameDuration() const
 
 void UnitConverter::setModulationEfficiency(unsigned int efficiency)
 {
+	// the DAMA sets the efficiency of each terminal before its conversions
+	if(efficiency == this->modulation_efficiency)
+	{
+		return;
+	}
 	this->modulation_efficiency = efficiency;
+	this->modulation_efficiency_div = FixedDivisor(efficiency);
 	if(0 < this->modulation_efficiency)
 	{
 		this->modulation_efficiency_inv = 1.0 / this->modulation_efficiency;
@@ -87,6 +115,7 @@ void UnitConverter::setModulationEfficiency(unsigned int efficiency)
 	{
 		this->modulation_efficiency_inv = 0.0;
 	}
+	this->updateEfficiencyFactors();
 }
 
 unsigned int UnitConverter::getModulationEfficiency() const
@@ -96,7 +125,7 @@ unsigned int UnitConverter::getModulationEfficiency() const
 
 vol_sym_t UnitConverter::bitsToSym(vol_b_t vol_b) const
 {
-	return ceil(vol_b * this->modulation_efficiency_inv);
+	return this->modulation_efficiency_div.divCeil(vol_b);
 }
 
 vol_b_t UnitConverter::symToBits(vol_sym_t vol_sym) const
@@ -106,17 +135,17 @@ vol_b_t UnitConverter::symToBits(vol_sym_t vol_sym) const
 
 vol_sym_t UnitConverter::kbitsToSym(vol_kb_t vol_kb) const
 {
-	return ceil(vol_kb * 1000 * this->modulation_efficiency_inv);
+	return this->modulation_efficiency_div.divCeil(vol_kb * 1000);
 }
 
 vol_kb_t UnitConverter::symToKbits(vol_sym_t vol_sym) const
 {
-	return ceil(vol_sym * this->modulation_efficiency / 1000.0);
+	return ((uint64_t)vol_sym * this->modulation_efficiency + 999) / 1000;
 }
 
 vol_kb_t UnitConverter::bitsToKbits(vol_b_t vol_b) const
 {
-	return ceil(vol_b / 1000.0);
+	return ((uint64_t)vol_b + 999) / 1000;
 }
 
 vol_b_t UnitConverter::kbitsToBits(vol_kb_t vol_kb) const
@@ -146,7 +175,7 @@ rate_kbps_t UnitConverter::sympsToKbps(rate_symps_t rate_symps) const
 
 rate_kbps_t UnitConverter::bpsToKbps(rate_bps_t rate_bps) const
 {
-	return ceil(rate_bps / 1000.0);
+	return (rate_bps + 999) / 1000;
 }
 
 rate_bps_t UnitConverter::kbpsToBps(rate_kbps_t rate_kbps) const
@@ -156,10 +185,10 @@ rate_bps_t UnitConverter::kbpsToBps(rate_kbps_t rate_kbps) const
 
 unsigned int UnitConverter::pfToPs(unsigned int rate_pf) const
 {
-	return ceil(rate_pf * this->frame_duration_ms_inv * 1000);
+	return this->frame_duration_div.divCeil((uint64_t)rate_pf * 1000);
 }
 
 unsigned int UnitConverter::psToPf(unsigned int rate_ps) const
 {
-	return ceil(rate_ps * this->frame_duration_ms / 1000.0);
+	return ((uint64_t)rate_ps * this->frame_duration_ms + 999) / 1000;
 }
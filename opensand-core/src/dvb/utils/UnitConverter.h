@@ -37,6 +37,51 @@
 
 #include "OpenSandCore.h"
 
+#include <cstdint>
+
+
+/**
+ * @class FixedDivisor
+ * @brief An integer divisor with its precomputed reciprocal, the rounded
+ *        up quotients of 32-bit values are then computed with a multiply
+ *        and a shift instead of a division
+ *
+ * The reciprocal is ceil(2^64 / divisor), the quotient of a 32-bit value
+ * is the upper word of their 128-bit product (D. Lemire et al., Faster
+ * Remainder by Direct Computation, 2019). Larger values fall back to a
+ * division.
+ */
+class FixedDivisor
+{
+public:
+	/**
+	 * @brief Create the divisor
+	 *
+	 * @param divisor  The divisor, the quotients are null for 0
+	 */
+	FixedDivisor(uint32_t divisor = 0);
+
+	/**
+	 * @brief Get the divisor
+	 *
+	 * @return  The divisor
+	 */
+	uint32_t getDivisor() const { return this->divisor; }
+
+	/**
+	 * @brief Divide a value, rounding up
+	 *
+	 * @param value  The dividend
+	 * @return  ceil(value / divisor), 0 for a null divisor
+	 */
+	inline uint64_t divCeil(uint64_t value) const;
+
+private:
+	uint32_t divisor;     ///< The divisor
+	uint64_t reciprocal;  ///< ceil(2^64 / divisor), 0 for divisors <= 1
+};
+
+
 /**
  * @class UnitConverter
  * @brief class managing unit conversion between kbits/s, cells per frame, etc
@@ -50,6 +95,9 @@ protected:
 	unsigned int modulation_efficiency;   ///< Modulation efficiency
 	float modulation_efficiency_inv;      ///< Invers of modulation efficiency
 
+	FixedDivisor frame_duration_div;        ///< The frame duration (in ms)
+	FixedDivisor modulation_efficiency_div; ///< The modulation efficiency
+
 	/**
 	 * @brief Create the unit converter
 	 *
@@ -58,6 +106,12 @@ protected:
 	 */
 	UnitConverter(time_ms_t duration_ms, unsigned int efficiency);
 
+	/**
+	 * @brief Update the conversion factors depending on the modulation
+	 *        efficiency, called when it changes
+	 */
+	virtual void updateEfficiencyFactors();
+
 public:
 	virtual ~UnitConverter();
 
@@ -157,4 +211,19 @@ public:
 	unsigned int psToPf(unsigned int rate_ps) const;
 };
 
+
+inline uint64_t FixedDivisor::divCeil(uint64_t value) const
+{
+	if(this->divisor <= 1)
+	{
+		return this->divisor ? value : 0;
+	}
+	value += this->divisor - 1;
+	if(value > UINT32_MAX)
+	{
+		return value / this->divisor;
+	}
+	return ((unsigned __int128)this->reciprocal * value) >> 64;
+}
+
 #endif
@@ -34,13 +34,16 @@
 
 #include "UnitConverterFixedSymbolLength.h"
 
-#include <math.h>
-
 UnitConverterFixedSymbolLength::UnitConverterFixedSymbolLength(
 		time_ms_t duration_ms,
 		unsigned int efficiency,
 		vol_sym_t length_sym):
-	UnitConverter(duration_ms, efficiency)
+	UnitConverter(duration_ms, efficiency),
+	packet_length_sym(0),
+	packet_length_sym_inv(0.0),
+	packet_length_div(),
+	packet_factors(),
+	efficiency_factors()
 {
 	this->setPacketSymbolLength(length_sym);
 }
@@ -75,70 +78,25 @@ void UnitConverterFixedSymbolLength::setPacketSymbolLength(vol_sym_t length_sym)
 	{
 		this->packet_length_sym_inv = 0.0;
 	}
+	this->packet_length_div = FixedDivisor(length_sym);
+	this->efficiency_factors.clear();
+	this->updateEfficiencyFactors();
 }
 
-vol_pkt_t UnitConverterFixedSymbolLength::symToPkt(vol_sym_t vol_sym) const
-{
-	return ceil(vol_sym * this->packet_length_sym_inv);
-}
-
-vol_sym_t UnitConverterFixedSymbolLength::pktToSym(vol_pkt_t vol_pkt) const
-{
-	return vol_pkt * this->packet_length_sym;
-}
-
-vol_pkt_t UnitConverterFixedSymbolLength::bitsToPkt(vol_b_t vol_b) const
-{
-	return ceil(vol_b * this->packet_length_sym_inv * this->modulation_efficiency_inv);
-}
-
-vol_b_t UnitConverterFixedSymbolLength::pktToBits(vol_pkt_t vol_pkt) const
-{
-	return vol_pkt * this->packet_length_sym * this->modulation_efficiency;
-}
-	
-vol_pkt_t UnitConverterFixedSymbolLength::kbitsToPkt(vol_kb_t vol_kb) const
+void UnitConverterFixedSymbolLength::updateEfficiencyFactors()
 {
-	return ceil(vol_kb * this->packet_length_sym_inv * this->modulation_efficiency_inv * 1000);
-}
+	unsigned int efficiency = this->modulation_efficiency;
 
-vol_kb_t UnitConverterFixedSymbolLength::pktToKbits(vol_pkt_t vol_pkt) const
-{
-	return ceil(vol_pkt * this->packet_length_sym * this->modulation_efficiency / 1000.0);
-}
-
-rate_pktpf_t UnitConverterFixedSymbolLength::sympsToPktpf(rate_symps_t rate_symps) const
-{
-	return ceil(rate_symps * this->packet_length_sym_inv * this->frame_duration_ms * 1000);
-}
-
-rate_symps_t UnitConverterFixedSymbolLength::pktpfToSymps(rate_pktpf_t rate_pktpf) const
-{
-	return ceil(rate_pktpf * this->packet_length_sym * this->frame_duration_ms_inv / 1000.0);
-}
-
-rate_pktpf_t UnitConverterFixedSymbolLength::bpsToPktpf(rate_bps_t rate_bps) const
-{
-	return ceil(rate_bps * this->packet_length_sym_inv * this->modulation_efficiency_inv
-		* this->frame_duration_ms / 1000.0);
-}
-
-rate_bps_t UnitConverterFixedSymbolLength::pktpfToBps(rate_pktpf_t rate_pktpf) const
-{
-	return ceil(rate_pktpf * this->packet_length_sym * this->modulation_efficiency
-		* this->frame_duration_ms_inv * 1000);
-}
-	
-rate_pktpf_t UnitConverterFixedSymbolLength::kbpsToPktpf(rate_kbps_t rate_kbps) const
-{
-	// bit/ms <=> kbits/s
-	return ceil(rate_kbps * this->packet_length_sym_inv * this->modulation_efficiency_inv
-		* this->frame_duration_ms);
-}
-
-rate_kbps_t UnitConverterFixedSymbolLength::pktpfToKbps(rate_pktpf_t rate_pktpf) const
-{
-	// bit/ms <=> kbits/s
-	return ceil(rate_pktpf * this->packet_length_sym * this->modulation_efficiency
-		* this->frame_duration_ms_inv);
+	if(efficiency >= this->efficiency_factors.size())
+	{
+		this->efficiency_factors.resize(efficiency + 1);
+	}
+	packet_factors_t &factors = this->efficiency_factors[efficiency];
+	uint32_t packet_bits = this->packet_length_sym * efficiency;
+	if(factors.packet_bits.getDivisor() != packet_bits)
+	{
+		factors.packet_bits = FixedDivisor(packet_bits);
+		factors.packet_millibits = FixedDivisor(packet_bits * 1000);
+	}
+	this->packet_factors = factors;
 }
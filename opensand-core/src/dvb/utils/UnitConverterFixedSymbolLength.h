@@ -38,16 +38,38 @@
 #include "OpenSandCore.h"
 #include "UnitConverter.h"
 
+#include <vector>
+#include <math.h>
+
 /**
  * @class UnitConverterFixedSymbolLength
  * @brief class managing unit conversion between kbits/s, cells per frame, etc
+ *
+ * The conversions are defined inline, so that they are inlined in the
+ * allocation loops of the controllers and agents holding this converter
+ * through its own type.
  */
-class UnitConverterFixedSymbolLength: public UnitConverter
+class UnitConverterFixedSymbolLength final: public UnitConverter
 {
 protected:
 	vol_sym_t packet_length_sym;    ///< Fixed packet length (in symbols)
 	float packet_length_sym_inv;    ///< Inverse of fixed packet length (in symbols-1)
 
+	/// The divisors depending on the packet length and the MODCOD
+	struct packet_factors_t
+	{
+		FixedDivisor packet_bits;      ///< The packet length (in bits)
+		FixedDivisor packet_millibits; ///< The packet length (in mbits)
+	};
+
+	FixedDivisor packet_length_div;  ///< The packet length (in symbols)
+	packet_factors_t packet_factors; ///< The factors of the current efficiency
+
+	/// The factors per modulation efficiency, computed on first use
+	std::vector<packet_factors_t> efficiency_factors;
+
+	void updateEfficiencyFactors();
+
 public:
 	/**
 	 * @brief Create the unit converter
@@ -109,4 +131,69 @@ public:
 	virtual rate_kbps_t pktpfToKbps(rate_pktpf_t rate_pktpf) const;
 };
 
+
+inline vol_pkt_t UnitConverterFixedSymbolLength::symToPkt(vol_sym_t vol_sym) const
+{
+	return this->packet_length_div.divCeil(vol_sym);
+}
+
+inline vol_sym_t UnitConverterFixedSymbolLength::pktToSym(vol_pkt_t vol_pkt) const
+{
+	return vol_pkt * this->packet_length_sym;
+}
+
+inline vol_pkt_t UnitConverterFixedSymbolLength::bitsToPkt(vol_b_t vol_b) const
+{
+	return this->packet_factors.packet_bits.divCeil(vol_b);
+}
+
+inline vol_b_t UnitConverterFixedSymbolLength::pktToBits(vol_pkt_t vol_pkt) const
+{
+	return vol_pkt * this->packet_length_sym * this->modulation_efficiency;
+}
+
+inline vol_pkt_t UnitConverterFixedSymbolLength::kbitsToPkt(vol_kb_t vol_kb) const
+{
+	return this->packet_factors.packet_bits.divCeil(vol_kb * 1000);
+}
+
+inline vol_kb_t UnitConverterFixedSymbolLength::pktToKbits(vol_pkt_t vol_pkt) const
+{
+	return ((uint64_t)vol_pkt * this->packet_length_sym * this->modulation_efficiency + 999) / 1000;
+}
+
+inline rate_pktpf_t UnitConverterFixedSymbolLength::sympsToPktpf(rate_symps_t rate_symps) const
+{
+	return ceil(rate_symps * this->packet_length_sym_inv * this->frame_duration_ms * 1000);
+}
+
+inline rate_symps_t UnitConverterFixedSymbolLength::pktpfToSymps(rate_pktpf_t rate_pktpf) const
+{
+	return ceil(rate_pktpf * this->packet_length_sym * this->frame_duration_ms_inv / 1000.0);
+}
+
+inline rate_pktpf_t UnitConverterFixedSymbolLength::bpsToPktpf(rate_bps_t rate_bps) const
+{
+	return this->packet_factors.packet_millibits.divCeil((uint64_t)rate_bps * this->frame_duration_ms);
+}
+
+inline rate_bps_t UnitConverterFixedSymbolLength::pktpfToBps(rate_pktpf_t rate_pktpf) const
+{
+	return this->frame_duration_div.divCeil((uint64_t)rate_pktpf * this->packet_length_sym
+		* this->modulation_efficiency * 1000);
+}
+
+inline rate_pktpf_t UnitConverterFixedSymbolLength::kbpsToPktpf(rate_kbps_t rate_kbps) const
+{
+	// bit/ms <=> kbits/s
+	return this->packet_factors.packet_bits.divCeil((uint64_t)rate_kbps * this->frame_duration_ms);
+}
+
+inline rate_kbps_t UnitConverterFixedSymbolLength::pktpfToKbps(rate_pktpf_t rate_pktpf) const
+{
+	// bit/ms <=> kbits/s
+	return this->frame_duration_div.divCeil((uint64_t)rate_pktpf * this->packet_length_sym
+		* this->modulation_efficiency);
+}
+
 #endif
@@ -0,0 +1,172 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file test_fifo_aqm.cpp
+ * @brief Check the drop decisions of the CoDel and PIE active queue
+ *        managements on a simulated clock
+ * @author Viveris Technologies
+ *
+ * An element of 1500 bytes is extracted every millisecond from a fifo
+ * holding 100 of them, with a constant sojourn time.
+ */
+
+
+#include "FifoAqmCodel.h"
+#include "FifoAqmPie.h"
+
+#include <stdio.h>
+#include <vector>
+
+
+#define CHECK(condition) do \
+{ \
+	if(!(condition)) \
+	{ \
+		fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+		return false; \
+	} \
+} while(0)
+
+
+/// The element length
+constexpr vol_bytes_t length = 1500;
+/// The backlog left in the fifo on extraction
+constexpr vol_bytes_t backlog = 100 * length;
+
+
+/**
+ * @brief Extract one element every millisecond
+ *
+ * @param aqm         The active queue management
+ * @param now         IN: the first extraction time, OUT: the next one
+ * @param duration    The extraction duration (in ms)
+ * @param sojourn_ms  The sojourn time of the elements
+ * @param backlog     The backlog left in the fifo
+ * @return the times of the drops
+ */
+static std::vector<clock_t> extract(FifoAqm &aqm, clock_t &now, time_ms_t duration,
+                                    time_ms_t sojourn_ms, vol_bytes_t backlog)
+{
+	std::vector<clock_t> drops;
+	for(clock_t end = now + duration; now < end; ++now)
+	{
+		if(aqm.drop(sojourn_ms, length, backlog, now))
+		{
+			drops.push_back(now);
+		}
+	}
+	return drops;
+}
+
+
+/// CoDel drops once the sojourn time stayed above the target for an
+/// interval, then more and more often
+static bool checkCodel()
+{
+	FifoAqmCodel codel{5, 100};
+	clock_t now = 1000;
+
+	// below the target, or above it for less than an interval
+	CHECK(extract(codel, now, 2000, 4, backlog).empty());
+	CHECK(extract(codel, now, 90, 20, backlog).empty());
+	CHECK(extract(codel, now, 10, 4, backlog).empty());
+	CHECK(extract(codel, now, 90, 20, backlog).empty());
+	CHECK(extract(codel, now, 10, 4, backlog).empty());
+
+	// the fifo is never emptied below one element
+	CHECK(extract(codel, now, 1000, 20, length).empty());
+
+	// above the target for good, the drop interval decreases as 1/sqrt
+	clock_t start = now;
+	std::vector<clock_t> drops = extract(codel, now, 1000, 20, backlog);
+	CHECK(drops.size() > 5);
+	CHECK(drops[0] == start + 100);
+	CHECK(drops[1] - drops[0] == 100);
+	for(std::size_t index = 2; index < drops.size(); ++index)
+	{
+		CHECK(drops[index] - drops[index - 1] <= drops[index - 1] - drops[index - 2]);
+	}
+	CHECK(drops.back() - drops[drops.size() - 2] < 50);
+
+	// back below the target, the drops stop at once
+	CHECK(extract(codel, now, 1000, 4, backlog).empty());
+
+	// above the target again soon after, the previous drop rate is kept
+	start = now;
+	std::vector<clock_t> again = extract(codel, now, 300, 20, backlog);
+	CHECK(again.size() >= 2);
+	CHECK(again[0] == start + 100);
+	CHECK(again[1] - again[0] < 100);
+	return true;
+}
+
+/// PIE drops at random, with a probability growing while the sojourn
+/// time stays above the target
+static bool checkPie()
+{
+	FifoAqmPie pie{15, 15, 1};
+	clock_t now = 1000;
+
+	// below the target, the drop probability stays null
+	CHECK(extract(pie, now, 10000, 12, backlog).empty());
+
+	// above the target, the drops start after a few updates and their
+	// rate increases
+	std::vector<std::size_t> counts;
+	for(unsigned int index = 0; index < 10; ++index)
+	{
+		counts.push_back(extract(pie, now, 500, 50, backlog).size());
+	}
+	CHECK(counts[0] < 20);
+	CHECK(counts[2] > counts[0]);
+	CHECK(counts[5] > counts[2]);
+	CHECK(counts[9] > 400);
+
+	// the fifo is never dropped nearly empty
+	CHECK(extract(pie, now, 500, 50, length).empty());
+
+	// back below the target, the probability decreases to zero
+	std::vector<clock_t> drops = extract(pie, now, 20000, 5, backlog);
+	CHECK(!drops.empty());
+	CHECK(drops.back() < now - 10000);
+	CHECK(extract(pie, now, 5000, 5, backlog).empty());
+	return true;
+}
+
+
+int main()
+{
+	if(!checkCodel() || !checkPie())
+	{
+		return 1;
+	}
+
+	printf("CoDel and PIE drops checked\n");
+	return 0;
+}
@@ -38,7 +38,10 @@
 
 #include "Plugin.h"
 #include "Ethernet.h"
+#include "Phs.h"
+#include "Rohc.h"
 #include "OpenSandModelConf.h"
+#include "NetPacket.h"
 
 #include <opensand_output/Output.h>
 #include <opensand_rt/MessageEvent.h>
@@ -79,10 +82,30 @@ BlockEncap::BlockEncap(const std::string &name, EncapConfig encap_cfg):
 
 BlockEncap::Downward::Downward(const std::string &name, EncapConfig):
 	RtDownward{name},
-	EncapChannel{}
+	EncapChannel{},
+	workers{nullptr},
+	shard_bursts{},
+	shard_time_contexts{},
+	packing{},
+	packing_timer{-1},
+	packing_armed{false},
+	packing_deadline{0},
+	probe_packing_delay{nullptr},
+	probe_packing_fill{nullptr},
+	mirror{name + ".Downward.packets"}
 {
 }
 
+bool BlockEncap::Downward::onInit(void)
+{
+	// a single timer flushes all the contexts, it is armed on demand
+	this->packing_timer = this->addTimerEvent("packing", 1, false, false);
+	auto output = Output::Get();
+	this->probe_packing_delay = output->registerProbe<int>("Encap.Packing delay", "ms", true, SAMPLE_AVG);
+	this->probe_packing_fill = output->registerProbe<int>("Encap.Packing fill", "packets", true, SAMPLE_AVG);
+	return true;
+}
+
 BlockEncap::Upward::Upward(const std::string &name, EncapConfig encap_cfg):
 	RtUpward{name},
 	EncapChannel{},
@@ -107,10 +130,17 @@ bool BlockEncap::Downward::onEvent(const RtEvent *const event)
 	{
 		case EventType::Timer:
 		{
-			// timer event, flush corresponding encapsulation context
+			// timer event, flush the expired encapsulation contexts
 			LOG(this->log_receive, LEVEL_INFO,
 			    "Timer received %s\n", event->getName().c_str());
-			return this->onTimer(event->getFd());
+			if(*event != this->packing_timer)
+			{
+				LOG(this->log_receive, LEVEL_ERROR,
+				    "unknown timer event received %s\n",
+				    event->getName().c_str());
+				return false;
+			}
+			return this->onTimer();
 		}
 		break;
 
@@ -160,6 +190,19 @@ void BlockEncap::Downward::setContext(const std::vector<EncapPlugin::EncapContex
 	this->ctx = encap_ctx;
 }
 
+bool BlockEncap::Downward::setWorkersContexts(const std::vector<std::vector<EncapPlugin::EncapContext *>> &chains)
+{
+	this->workers.reset(new EncapWorkers{this->log_receive});
+	if(!this->workers->start(chains))
+	{
+		this->workers.reset();
+		return false;
+	}
+	this->shard_bursts.assign(chains.size(), nullptr);
+	this->shard_time_contexts.resize(chains.size());
+	return true;
+}
+
 bool BlockEncap::Upward::onEvent(const RtEvent *const event)
 {
 	switch(event->getType())
@@ -282,7 +325,16 @@ bool BlockEncap::onInit()
 
 	static_cast<Upward *>(this->upward)->setMacId(this->mac_id);
 	
+	// the ROHC then PHS plugins, when enabled, are stacked below Ethernet
 	LanAdaptationPlugin *lan_plugin = Ethernet::constructPlugin();
+	if(Rohc::isEnabled())
+	{
+		lan_plugin = Rohc::constructPlugin();
+	}
+	if(Phs::isEnabled())
+	{
+		lan_plugin = Phs::constructPlugin();
+	}
 	LOG(this->log_init, LEVEL_NOTICE,
 	    "lan adaptation upper layer is %s\n", lan_plugin->getName().c_str());
 
@@ -376,46 +428,103 @@ bool BlockEncap::onInit()
 		static_cast<Upward *>(this->upward)->setSCPCContext(up_return_ctx_scpc);
 	}
 
+	unsigned int workers = 0;
+	if(!OpenSandModelConf::Get()->getEncapWorkers(workers))
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "Invalid number of encapsulation workers");
+		return false;
+	}
+	if(workers > 1)
+	{
+		// the first worker uses the contexts of the channel, each
+		// other one gets its own instances of the plugins
+		std::vector<std::vector<EncapPlugin::EncapContext *>> chains;
+		chains.push_back(entity_type == Component::terminal ? up_return_ctx : down_forward_ctx);
+		for(unsigned int worker = 1; worker < workers; ++worker)
+		{
+			std::vector<EncapPlugin::EncapContext *> chain;
+			bool status;
+			if(entity_type == Component::gateway)
+			{
+				status = this->getEncapContext(EncapSchemeList::FORWARD_DOWN,
+				                               lan_plugin, chain, "forward/down");
+			}
+			else if(scpc_enabled)
+			{
+				status = this->getSCPCEncapContext(lan_plugin, chain, "return/up");
+			}
+			else
+			{
+				status = this->getEncapContext(EncapSchemeList::RETURN_UP,
+				                               lan_plugin, chain, "return/up");
+			}
+			if(!status)
+			{
+				LOG(this->log_init, LEVEL_ERROR,
+				    "Cannot get the Encapsulation context of worker %u", worker);
+				return false;
+			}
+			chains.push_back(chain);
+		}
+
+		if(!static_cast<Downward *>(this->downward)->setWorkersContexts(chains))
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "Cannot start the encapsulation workers");
+			return false;
+		}
+	}
+
 	return true;
 }
 
-bool BlockEncap::Downward::onTimer(event_id_t timer_id)
+bool BlockEncap::Downward::onTimer(void)
 {
-	std::map<event_id_t, int>::iterator it;
-	int id;
-	NetBurst *burst;
-	bool status = false;
+	std::vector<PackingFlush> flushes;
+	bool status = true;
 
 	LOG(this->log_receive, LEVEL_INFO,
-	    "emission timer received, flush corresponding emission "
-	    "context\n");
+	    "emission timer received, flush the expired emission "
+	    "contexts\n");
 
-	// find encapsulation context to flush
-	it = this->timers.find(timer_id);
-	if(it == this->timers.end())
+	this->packing_armed = false;
+	this->packing.expire(getCurrentTime(), flushes);
+	for(auto &&flush : flushes)
 	{
-		LOG(this->log_receive, LEVEL_ERROR,
-		    "timer not found\n");
-		goto error;
+		status &= this->flushContext(flush);
 	}
+	this->armPackingTimer();
+	return status;
+}
 
-	// context found
-	id = (*it).second;
-	LOG(this->log_receive, LEVEL_INFO,
-	    "corresponding emission context found (ID = %d)\n",
-	    id);
-
-	// remove emission timer from the list
-	this->removeEvent((*it).first);
-	this->timers.erase(it);
+bool BlockEncap::Downward::flushContext(const PackingFlush &flush)
+{
+	std::size_t shard = flush.context.first;
+	int id = flush.context.second;
+	NetBurst *burst;
 
-	// flush the last encapsulation contexts
-	burst = (this->ctx.back())->flush(id);
+	LOG(this->log_receive, LEVEL_INFO,
+	    "flush emission context (ID = %d, worker = %zu) after %u ms "
+	    "and %u packets\n", id, shard, flush.delay, flush.packets);
+	this->probe_packing_delay->put(flush.delay);
+	this->probe_packing_fill->put(flush.packets);
+
+	// flush the last encapsulation contexts, the workers are
+	// idle between two bursts
+	if(this->workers)
+	{
+		burst = this->workers->getContexts(shard).back()->flush(id);
+	}
+	else
+	{
+		burst = (this->ctx.back())->flush(id);
+	}
 	if(burst == NULL)
 	{
 		LOG(this->log_receive, LEVEL_ERROR,
 		    "flushing context %d failed\n", id);
-		goto error;
+		return false;
 	}
 
 	LOG(this->log_receive, LEVEL_INFO,
@@ -424,27 +533,101 @@ bool BlockEncap::Downward::onTimer(event_id_t timer_id)
 
 	if(burst->size() <= 0)
 	{
-		status = true;
-		goto clean;
+		delete burst;
+		return true;
 	}
 
-	// send the message to the lower layer
-	if (!this->enqueueMessage((void **)&burst, 0, to_underlying(InternalMessageType::decap_data)))
+	if(this->mirror.isEnabled())
+	{
+		this->mirrorBurst(*burst);
+	}
+
+	// send the message to the lower layer, the burst is released on failure
+	if (!this->enqueueMessage(std::unique_ptr<NetBurst>{burst}, 0, to_underlying(InternalMessageType::decap_data)))
 	{
 		LOG(this->log_receive, LEVEL_ERROR,
 		    "cannot send burst to lower layer failed\n");
-		goto clean;
+		return false;
 	}
 
 	LOG(this->log_receive, LEVEL_INFO,
 	    "encapsulation burst sent to the lower layer\n");
 
 	return true;
+}
 
-clean:
+void BlockEncap::Downward::armTimers(std::size_t shard, const std::map<long, int> &time_contexts)
+{
+	if(!time_contexts.empty())
+	{
+		this->packing.update(shard, time_contexts, getCurrentTime());
+	}
+}
+
+void BlockEncap::Downward::armPackingTimer(void)
+{
+	time_ms_t deadline;
+	if(!this->packing.getNextDeadline(deadline))
+	{
+		return;
+	}
+	// the timer is only moved when an earlier deadline appears
+	if(this->packing_armed && this->packing_deadline <= deadline)
+	{
+		return;
+	}
+	time_ms_t current_time = getCurrentTime();
+	double duration = deadline > current_time ? deadline - current_time : 0;
+	this->packing_armed = true;
+	this->packing_deadline = deadline;
+	if(duration <= 0)
+	{
+		this->raiseTimer(this->packing_timer);
+		return;
+	}
+	this->setDuration(this->packing_timer, duration);
+	this->startTimer(this->packing_timer);
+	LOG(this->log_receive, LEVEL_INFO,
+	    "packing timer armed with %.0f ms\n", duration);
+}
+
+NetBurst *BlockEncap::Downward::encapsulateShards(NetBurst *burst)
+{
+	// shard the packets by destination, keeping their order
+	for(auto&& packet : *burst)
+	{
+		std::size_t shard = this->workers->getShard(packet->getDstTalId());
+		if(this->shard_bursts[shard] == nullptr)
+		{
+			this->shard_bursts[shard] = new NetBurst();
+		}
+		this->shard_bursts[shard]->push_back(std::move(packet));
+	}
 	delete burst;
-error:
-	return status;
+
+	bool status = this->workers->encapsulate(this->shard_bursts,
+	                                         this->shard_time_contexts);
+
+	// merge the shards, the contexts may hold packets even if
+	// another shard failed so their timers are always armed
+	NetBurst *encap_burst = new NetBurst();
+	for(std::size_t shard = 0; shard < this->shard_bursts.size(); ++shard)
+	{
+		this->armTimers(shard, this->shard_time_contexts[shard]);
+		if(this->shard_bursts[shard] != nullptr)
+		{
+			encap_burst->splice(encap_burst->end(), *this->shard_bursts[shard]);
+			delete this->shard_bursts[shard];
+			this->shard_bursts[shard] = nullptr;
+		}
+	}
+
+	if(!status)
+	{
+		delete encap_burst;
+		return nullptr;
+	}
+	return encap_burst;
 }
 
 bool BlockEncap::Downward::onRcvBurst(NetBurst *burst)
@@ -468,55 +651,16 @@ bool BlockEncap::Downward::onRcvBurst(NetBurst *burst)
 	    size, name.c_str());
 
 	// encapsulate packet
-	for(auto&& context : this->ctx)
+	if(this->workers)
 	{
-		burst = context->encapsulate(burst, time_contexts);
-		if(burst == nullptr)
-		{
-			LOG(this->log_receive, LEVEL_ERROR,
-			    "encapsulation failed in %s context\n",
-			    context->getName().c_str());
-			return false;
-		}
+		burst = this->encapsulateShards(burst);
 	}
-
-	// set encapsulate timers if needed
-	for(auto&& time_iter : time_contexts)
+	else
 	{
-		// check if there is already a timer armed for the context
-		bool found = false;
-		for(auto&& it : this->timers)
-		{
-			if (it.second == time_iter.second)
-			{
-				found = true;
-				break;
-			}
-		}
-
-		// set a new timer if no timer was found and timer is not null
-		if(!found && time_iter.first != 0)
-		{
-			event_id_t timer;
-			std::ostringstream name;
-
-			name << "context_" << time_iter.second;
-			timer = this->addTimerEvent(name.str(),
-			                            time_iter.first,
-			                            false);
-
-			this->timers.insert(std::make_pair(timer, time_iter.second));
-			LOG(this->log_receive, LEVEL_INFO,
-			    "timer for context ID %d armed with %ld ms\n",
-			    time_iter.second, time_iter.first);
-		}
-		else
-		{
-			LOG(this->log_receive, LEVEL_INFO,
-			    "timer already set for context ID %d\n",
-			    time_iter.second);
-		}
+		burst = EncapWorkers::encapsulate(this->ctx, burst, time_contexts, this->log_receive);
+		this->armTimers(0, time_contexts);
 	}
+	this->armPackingTimer();
 
 	// check burst validity
 	if(burst == nullptr)
@@ -545,13 +689,16 @@ bool BlockEncap::Downward::onRcvBurst(NetBurst *burst)
 		return true;
 	}
 
+	if(this->mirror.isEnabled())
+	{
+		this->mirrorBurst(*burst);
+	}
 
-	// send the message to the lower layer
-	if (!this->enqueueMessage((void **)&burst, 0, to_underlying(InternalMessageType::decap_data)))
+	// send the message to the lower layer, the burst is released on failure
+	if (!this->enqueueMessage(std::unique_ptr<NetBurst>{burst}, 0, to_underlying(InternalMessageType::decap_data)))
 	{
 		LOG(this->log_receive, LEVEL_ERROR,
 		    "failed to send burst to lower layer\n");
-		delete burst;
 		return false;
 	}
 
@@ -562,6 +709,15 @@ bool BlockEncap::Downward::onRcvBurst(NetBurst *burst)
 	return true;
 }
 
+void BlockEncap::Downward::mirrorBurst(const NetBurst &burst)
+{
+	for(auto&& packet : burst)
+	{
+		const Data &data = packet->getData();
+		this->mirror.copy(data.data(), data.length(), packet->getDstTalId());
+	}
+}
+
 void BlockEncap::Upward::setContext(const std::vector<EncapPlugin::EncapContext *> &encap_ctx)
 {
 	this->ctx = encap_ctx;
@@ -631,12 +787,11 @@ bool BlockEncap::Upward::onRcvBurst(NetBurst *burst)
 		return true;
 	}
 
-	// send the burst to the upper layer
-	if (!this->enqueueMessage((void **)&burst, 0, to_underlying(InternalMessageType::decap_data)))
+	// send the burst to the upper layer, the burst is released on failure
+	if (!this->enqueueMessage(std::unique_ptr<NetBurst>{burst}, 0, to_underlying(InternalMessageType::decap_data)))
 	{
 		LOG(this->log_receive, LEVEL_ERROR,
 		    "failed to send burst to upper layer\n");
-		delete burst;
 	}
 
 	LOG(this->log_receive, LEVEL_INFO,
@@ -699,6 +854,10 @@ bool BlockEncap::getEncapContext(EncapSchemeList scheme_list,
 			    context->getName().c_str());
 			return false;
 		}
+		if(upper_encap == l_plugin)
+		{
+			this->checkMaxPduLength(plugin, link_type);
+		}
 		upper_encap = plugin;
 		
 		LOG(this->log_init, LEVEL_INFO,
@@ -708,6 +867,25 @@ bool BlockEncap::getEncapContext(EncapSchemeList scheme_list,
 	return true;
 }
 
+void BlockEncap::checkMaxPduLength(EncapPlugin *plugin, const char *link_type) const
+{
+	std::size_t mtu;
+	if(!OpenSandModelConf::Get()->getTapMtu(mtu))
+	{
+		// the lan adaptation refuses the MTU
+		return;
+	}
+
+	std::size_t max_length = plugin->getPacketHandler()->getMaxPduLength();
+	if(ETHERNET_FRAME_SIZE(mtu) > max_length)
+	{
+		LOG(this->log_init, LEVEL_WARNING,
+		    "%s encapsulation carries frames up to %zu bytes on %s link, "
+		    "the longer frames of the %zu bytes MTU are dropped\n",
+		    plugin->getName().c_str(), max_length, link_type, mtu);
+	}
+}
+
 bool BlockEncap::getSCPCEncapContext(LanAdaptationPlugin *l_plugin,
                                      std::vector <EncapPlugin::EncapContext *> &ctx,
                                      const char *link_type)
@@ -756,6 +934,10 @@ bool BlockEncap::getSCPCEncapContext(LanAdaptationPlugin *l_plugin,
 			    context->getName().c_str());
 			goto error;
 		}
+		if(upper_encap == l_plugin)
+		{
+			this->checkMaxPduLength(plugin, link_type);
+		}
 		upper_encap = plugin;
 		
 		LOG(this->log_init, LEVEL_INFO,
@@ -38,11 +38,14 @@
 #define BLOCK_ENCAP_H
 
 #include "EncapPlugin.h"
+#include "EncapWorkers.h"
 #include "LanAdaptationPlugin.h"
 #include "NetBurst.h"
 #include "NetPacket.h"
 #include "OpenSandCore.h"
 #include "OpenSandFrames.h"
+#include "PacketMirror.h"
+#include "PackingScheduler.h"
 #include "StackPlugin.h"
 
 #include <opensand_output/Output.h>
@@ -136,16 +139,76 @@ public:
 	{
 	public:
 		Downward(const std::string &name, EncapConfig encap_cfg);
+		bool onInit(void);
 		bool onEvent(const RtEvent *const event);
 
 		void setContext(const std::vector<EncapPlugin::EncapContext *> &encap_ctx);
 
+		/**
+		 * Encapsulate the bursts in parallel, sharded by destination terminal
+		 *
+		 * @param chains  The emission contexts of each worker,
+		 *                from upper to lower context
+		 * @return        Whether the workers were started or not
+		 */
+		bool setWorkersContexts(const std::vector<std::vector<EncapPlugin::EncapContext *>> &chains);
+
 	private:
 		/// the emission contexts list from lower to upper context
 		std::vector<EncapPlugin::EncapContext *> ctx;
 
-		/// Expiration timers for encapsulation contexts
-		std::map<event_id_t, int> timers;
+		/// the workers encapsulating the shards of the bursts, if any
+		std::unique_ptr<EncapWorkers> workers;
+
+		/// the bursts of each worker and their contexts expiration times,
+		/// kept from a burst to the other
+		std::vector<NetBurst *> shard_bursts;
+		std::vector<std::map<long, int>> shard_time_contexts;
+
+		/// The flush deadlines of the encapsulation contexts
+		PackingScheduler packing;
+
+		/// The single timer armed on the earliest flush deadline
+		event_id_t packing_timer;
+
+		/// The deadline the packing timer is armed on, if any
+		bool packing_armed;
+		time_ms_t packing_deadline;
+
+		/// The packing probes
+		std::shared_ptr<Probe<int>> probe_packing_delay;
+		std::shared_ptr<Probe<int>> probe_packing_fill;
+
+		/// The mirror of the encapsulated packets
+		PacketMirror mirror;
+
+		/**
+		 * Copy the encapsulated packets of a burst in the mirror
+		 *
+		 * @param burst  The burst sent to the lower-layer block
+		 */
+		void mirrorBurst(const NetBurst &burst);
+
+		/**
+		 * Update the flush deadlines of the encapsulation contexts
+		 *
+		 * @param shard          The worker whose contexts were used
+		 * @param time_contexts  The contexts expiration times
+		 */
+		void armTimers(std::size_t shard, const std::map<long, int> &time_contexts);
+
+		/**
+		 * Arm the packing timer on the earliest flush deadline
+		 */
+		void armPackingTimer(void);
+
+		/**
+		 * Encapsulate a burst with the workers
+		 *
+		 * @param burst  The burst received from the upper-layer block
+		 * @return       The encapsulated burst, nullptr on failure
+		 */
+		NetBurst *encapsulateShards(NetBurst *burst);
 
 		/**
 		 * Handle a burst received from the upper-layer block
@@ -156,12 +219,19 @@ public:
 		bool onRcvBurst(NetBurst *burst);
 
 		/**
-		 * Handle the timer event
+		 * Handle the packing timer, flush the contexts whose deadline is reached
 		 *
-		 * @param timer_id  The id of the timer to handle
 		 * @return          Whether the timer event was successfully handled or not
 		 */
-		bool onTimer(event_id_t timer_id);
+		bool onTimer(void);
+
+		/**
+		 * Flush an encapsulation context
+		 *
+		 * @param flush  The context to flush
+		 * @return       Whether the context was successfully flushed or not
+		 */
+		bool flushContext(const PackingFlush &flush);
 	};
 
 protected:
@@ -201,6 +271,15 @@ protected:
 	                         std::vector<EncapPlugin::EncapContext *> &ctx,
 	                         const char *link_type);
 
+	/**
+	 * Warn when the encapsulation right below the lan adaptation
+	 * cannot carry the frames of the TAP interface MTU
+	 *
+	 * @param plugin     The encapsulation plugin
+	 * @param link_type  The type of link: "return/up" or "forward/down"
+	 */
+	void checkMaxPduLength(EncapPlugin *plugin, const char *link_type) const;
+
 	/// initialization method
 	bool onInit();
 };
@@ -0,0 +1,133 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file EncapWorkers.cpp
+ * @brief The bursts of several destination terminals encapsulated
+ *        in parallel by the runtime workers
+ * @author Viveris Technologies
+ */
+
+
+#include "EncapWorkers.h"
+
+#include <opensand_output/Output.h>
+#include <opensand_rt/Rt.h>
+
+#include <atomic>
+
+
+EncapWorkers::EncapWorkers(std::shared_ptr<OutputLog> log):
+	log{log},
+	chains{}
+{
+}
+
+
+bool EncapWorkers::start(const std::vector<std::vector<EncapPlugin::EncapContext *>> &chains)
+{
+	if(chains.empty() || !this->chains.empty())
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "cannot start the encapsulation workers\n");
+		return false;
+	}
+	this->chains = chains;
+
+	LOG(this->log, LEVEL_NOTICE,
+	    "%zu encapsulation shards run on %zu workers\n",
+	    this->chains.size(), Rt::getTaskPool().size());
+	return true;
+}
+
+
+std::size_t EncapWorkers::size() const
+{
+	return this->chains.size();
+}
+
+
+std::size_t EncapWorkers::getShard(tal_id_t dst_tal_id) const
+{
+	return dst_tal_id % this->chains.size();
+}
+
+
+const std::vector<EncapPlugin::EncapContext *> &EncapWorkers::getContexts(std::size_t shard) const
+{
+	return this->chains[shard];
+}
+
+
+bool EncapWorkers::encapsulate(std::vector<NetBurst *> &bursts,
+                               std::vector<std::map<long, int>> &time_contexts)
+{
+	time_contexts.resize(this->chains.size());
+	for(auto &&times : time_contexts)
+	{
+		times.clear();
+	}
+
+	// each task only touches the burst and the timers of its shard
+	std::atomic<bool> failed{false};
+	Rt::getTaskPool().parallelFor(0, this->chains.size(),
+	                              [this, &bursts, &time_contexts, &failed](std::size_t shard)
+	{
+		if(bursts[shard] == nullptr)
+		{
+			return;
+		}
+		bursts[shard] = EncapWorkers::encapsulate(this->chains[shard], bursts[shard],
+		                                          time_contexts[shard], this->log);
+		if(bursts[shard] == nullptr)
+		{
+			failed = true;
+		}
+	});
+	return !failed;
+}
+
+
+NetBurst *EncapWorkers::encapsulate(const std::vector<EncapPlugin::EncapContext *> &chain,
+                                    NetBurst *burst,
+                                    std::map<long, int> &time_contexts,
+                                    std::shared_ptr<OutputLog> log)
+{
+	for(auto&& context : chain)
+	{
+		burst = context->encapsulate(burst, time_contexts);
+		if(burst == nullptr)
+		{
+			LOG(log, LEVEL_ERROR,
+			    "encapsulation failed in %s context\n",
+			    context->getName().c_str());
+			return nullptr;
+		}
+	}
+	return burst;
+}
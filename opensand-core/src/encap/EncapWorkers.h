@@ -0,0 +1,134 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file EncapWorkers.h
+ * @brief The bursts of several destination terminals encapsulated
+ *        in parallel by the runtime workers
+ * @author Viveris Technologies
+ */
+
+#ifndef ENCAP_WORKERS_H
+#define ENCAP_WORKERS_H
+
+#include "EncapPlugin.h"
+#include "NetBurst.h"
+#include "OpenSandCore.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+
+class OutputLog;
+
+
+/**
+ * @class EncapWorkers
+ * @brief Encapsulate bursts in parallel, each shard of the traffic
+ *        going through its own chain of encapsulation contexts
+ *
+ * The traffic is sharded by destination terminal so the packets of a
+ * destination always go through the same contexts, in their order.
+ * The shards are given as tasks to the workers shared by the channels
+ * (Rt::getTaskPool), the calling thread encapsulates the first one and
+ * helps with the others while it waits.
+ */
+class EncapWorkers
+{
+public:
+	EncapWorkers(std::shared_ptr<OutputLog> log);
+
+	EncapWorkers(const EncapWorkers &) = delete;
+	EncapWorkers &operator=(const EncapWorkers &) = delete;
+
+	/**
+	 * @brief Set the shards
+	 *
+	 * @param chains  The encapsulation contexts of each shard,
+	 *                from upper to lower context
+	 * @return true on success, false otherwise
+	 */
+	bool start(const std::vector<std::vector<EncapPlugin::EncapContext *>> &chains);
+
+	/**
+	 * @brief Get the number of shards
+	 *
+	 * @return the number of shards, 0 if the pool is not started
+	 */
+	std::size_t size() const;
+
+	/**
+	 * @brief Get the shard of a destination terminal
+	 *
+	 * @param dst_tal_id  The destination terminal id
+	 * @return the shard index
+	 */
+	std::size_t getShard(tal_id_t dst_tal_id) const;
+
+	/**
+	 * @brief Get the encapsulation contexts of a shard
+	 *
+	 * @param shard  The shard index
+	 * @return the contexts from upper to lower context
+	 */
+	const std::vector<EncapPlugin::EncapContext *> &getContexts(std::size_t shard) const;
+
+	/**
+	 * @brief Encapsulate the bursts of all the shards and wait for them
+	 *
+	 * @param bursts         IN: the burst of each shard, nullptr if empty;
+	 *                       OUT: the encapsulated bursts, nullptr for the
+	 *                       shards that failed
+	 * @param time_contexts  OUT: the contexts expiration times of each shard
+	 * @return true if all the shards were encapsulated, false otherwise
+	 */
+	bool encapsulate(std::vector<NetBurst *> &bursts,
+	                 std::vector<std::map<long, int>> &time_contexts);
+
+	/**
+	 * @brief Encapsulate a burst through a chain of contexts
+	 *
+	 * @param chain          The contexts from upper to lower context
+	 * @param burst          The burst, released by the contexts
+	 * @param time_contexts  OUT: the contexts expiration times
+	 * @param log            The log for the errors
+	 * @return the encapsulated burst, nullptr on failure
+	 */
+	static NetBurst *encapsulate(const std::vector<EncapPlugin::EncapContext *> &chain,
+	                             NetBurst *burst,
+	                             std::map<long, int> &time_contexts,
+	                             std::shared_ptr<OutputLog> log);
+
+private:
+	std::shared_ptr<OutputLog> log;
+
+	std::vector<std::vector<EncapPlugin::EncapContext *>> chains;
+};
+
+#endif
@@ -0,0 +1,131 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file PackingScheduler.cpp
+ * @brief The flush deadlines of the encapsulation contexts packing
+ *        several packets
+ * @author Viveris Technologies
+ */
+
+#include "PackingScheduler.h"
+
+#include <algorithm>
+
+
+PackingScheduler::PackingScheduler():
+	contexts{},
+	deadlines{}
+{
+}
+
+
+void PackingScheduler::update(std::size_t shard,
+                              const std::map<long, int> &time_contexts,
+                              time_ms_t now)
+{
+	for(auto &&time_context : time_contexts)
+	{
+		packing_context_t key{shard, time_context.second};
+		auto it = this->contexts.find(key);
+		if(it == this->contexts.end())
+		{
+			if(time_context.first <= 0)
+			{
+				// nothing is kept by a context never armed
+				continue;
+			}
+			Context context{};
+			context.armed = false;
+			context.last_arrival = now;
+			it = this->contexts.emplace(key, context).first;
+		}
+		else
+		{
+			// the interval is smoothed on 1/4 of the new samples
+			time_ms_t interval = now - it->second.last_arrival;
+			it->second.interval = it->second.interval == 0 ?
+			                      std::max<time_ms_t>(interval, 1) :
+			                      (3 * it->second.interval + interval) / 4;
+			it->second.last_arrival = now;
+		}
+
+		Context &context = it->second;
+		if(context.armed)
+		{
+			this->deadlines.erase(context.deadline_it);
+		}
+		if(time_context.first <= 0)
+		{
+			// the context was full and sent with the burst
+			context.armed = false;
+			continue;
+		}
+		if(!context.armed)
+		{
+			context.armed = true;
+			context.armed_time = now;
+			context.budget = time_context.first;
+			context.packets = 0;
+		}
+		++context.packets;
+
+		// wait for the next packet only if it is expected in time
+		context.deadline = context.armed_time + context.budget;
+		if(context.interval != 0)
+		{
+			context.deadline = std::min<time_ms_t>(context.deadline, now + 2 * context.interval);
+		}
+		context.deadline_it = this->deadlines.emplace(context.deadline, key);
+	}
+}
+
+
+bool PackingScheduler::getNextDeadline(time_ms_t &deadline) const
+{
+	if(this->deadlines.empty())
+	{
+		return false;
+	}
+	deadline = this->deadlines.begin()->first;
+	return true;
+}
+
+
+void PackingScheduler::expire(time_ms_t now, std::vector<PackingFlush> &flushes)
+{
+	while(!this->deadlines.empty() && this->deadlines.begin()->first <= now)
+	{
+		Context &context = this->contexts[this->deadlines.begin()->second];
+		flushes.push_back({this->deadlines.begin()->second,
+		                   now - context.armed_time,
+		                   context.packets});
+		context.armed = false;
+		this->deadlines.erase(this->deadlines.begin());
+	}
+}
@@ -0,0 +1,127 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file PackingScheduler.h
+ * @brief The flush deadlines of the encapsulation contexts packing
+ *        several packets
+ * @author Viveris Technologies
+ */
+
+#ifndef PACKING_SCHEDULER_H
+#define PACKING_SCHEDULER_H
+
+#include "OpenSandCore.h"
+
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+
+/// An encapsulation context: the worker (0 without workers) and its ID
+typedef std::pair<std::size_t, int> packing_context_t;
+
+
+/// A context flushed on its deadline
+struct PackingFlush
+{
+	packing_context_t context;
+	/// The time the oldest packet waited in the context (ms)
+	time_ms_t delay;
+	/// The packets added in the context since it was armed
+	unsigned int packets;
+};
+
+
+/**
+ * @class PackingScheduler
+ * @brief Schedule the flush of the encapsulation contexts
+ *
+ * The encapsulation plugins return the time a context may keep its
+ * packets, it is the latency budget of the context. The scheduler
+ * learns the packets interval of each context and flushes it as soon
+ * as the next packet is not expected before two intervals: waiting for
+ * it would add latency without filling the context much more. The
+ * dense flows are thus packed up to their budget while the sparse ones
+ * are not delayed.
+ */
+class PackingScheduler
+{
+public:
+	PackingScheduler();
+
+	/**
+	 * @brief Update the deadlines with the contexts used by an encapsulation
+	 *
+	 * @param shard          The worker whose contexts were used
+	 * @param time_contexts  The contexts expiration times, a null time
+	 *                       means that the context was sent
+	 * @param now            The current time (ms)
+	 */
+	void update(std::size_t shard, const std::map<long, int> &time_contexts,
+	            time_ms_t now);
+
+	/**
+	 * @brief Get the earliest deadline
+	 *
+	 * @param deadline  OUT: the deadline (ms)
+	 * @return false if no context waits
+	 */
+	bool getNextDeadline(time_ms_t &deadline) const;
+
+	/**
+	 * @brief Get the contexts whose deadline is reached, they are disarmed
+	 *
+	 * @param now      The current time (ms)
+	 * @param flushes  OUT: the contexts to flush
+	 */
+	void expire(time_ms_t now, std::vector<PackingFlush> &flushes);
+
+private:
+	struct Context
+	{
+		/// Whether the context keeps packets
+		bool armed;
+		/// The arrival of the oldest packet kept
+		time_ms_t armed_time;
+		/// The latency budget of the context
+		time_ms_t budget;
+		time_ms_t deadline;
+		time_ms_t last_arrival;
+		/// The smoothed interval between the packets, 0 if unknown
+		time_ms_t interval;
+		unsigned int packets;
+		std::multimap<time_ms_t, packing_context_t>::iterator deadline_it;
+	};
+
+	std::map<packing_context_t, Context> contexts;
+	std::multimap<time_ms_t, packing_context_t> deadlines;
+};
+
+#endif
@@ -35,7 +35,9 @@
 #include "BlockInterconnect.h"
 #include "OpenSandModelConf.h"
 
+#include <opensand_rt/FileEvent.h>
 #include <opensand_rt/MessageEvent.h>
+#include <opensand_rt/TcpListenEvent.h>
 
 BlockInterconnectDownward::BlockInterconnectDownward(const std::string &name,
                                                      const InterconnectConfig &):
@@ -82,11 +84,15 @@ bool BlockInterconnectDownward::Downward::onEvent(const RtEvent *const event)
 				    "error when sending data\n");
 				return false;
 			}
+			if(this->takeFlushRequest())
+			{
+				this->startTimer(this->flush_timer);
+			}
 		}
 		break;
 
 		case EventType::Timer:
-			if (event->getFd() == delay_timer)
+			if (event->getFd() == delay_timer || event->getFd() == flush_timer)
 			{
 				onTimerEvent();
 			}
@@ -101,12 +107,53 @@ bool BlockInterconnectDownward::Downward::onEvent(const RtEvent *const event)
 	return true;
 }
 
+bool BlockInterconnectDownward::Downward::onMessageBatch(const MessageEvent *const event)
+{
+	// the messages received on the same wakeup are gathered
+	// in as few datagrams as possible
+	this->deferSends();
+	bool status = RtDownward::onMessageBatch(event);
+	if(!this->flushSends())
+	{
+		LOG(this->log_interconnect, LEVEL_ERROR,
+		    "error when sending data\n");
+		status = false;
+	}
+	if(this->takeFlushRequest())
+	{
+		this->startTimer(this->flush_timer);
+	}
+	return status;
+}
+
 bool BlockInterconnectDownward::Upward::onEvent(const RtEvent *const event)
 {
 	bool status = true;
 
 	switch(event->getType())
 	{
+		case EventType::TcpListen:
+		{
+			// a local sender asks for the shared memory ring
+			// or the sender opens its stream
+			int stream_fd = -1;
+			if(!this->acceptShm((TcpListenEvent *)event) ||
+			   !this->acceptStream((TcpListenEvent *)event, stream_fd))
+			{
+				status = false;
+			}
+			else if(stream_fd >= 0 &&
+			        this->addFileEvent(this->getName() + ".stream", stream_fd,
+			                           StreamChannelReceiver::read_length) < 0)
+			{
+				LOG(this->log_interconnect, LEVEL_ERROR,
+				    "cannot monitor the stream of the sender\n");
+				status = false;
+			}
+		}
+		break;
+
+		case EventType::File:
 		case EventType::NetSocket:
 		{
 			std::list<rt_msg_t> messages;
@@ -114,13 +161,24 @@ bool BlockInterconnectDownward::Upward::onEvent(const RtEvent *const event)
 			LOG(this->log_interconnect, LEVEL_DEBUG,
 			    "NetSocket event received\n");
 
-			// Receive messages
-			if(!this->receive((NetSocketEvent *)event, messages))
+			// Receive messages from the UDP channels and their workers, the streams or the shared memory rings
+			bool closed = false;
+			bool received = event->getType() == EventType::File ?
+			                this->receiveStream((FileEvent *)event, messages, closed) &&
+			                this->receiveShm((FileEvent *)event, messages) &&
+			                this->receiveDataStreams((FileEvent *)event, messages) :
+			                this->receive((NetSocketEvent *)event, messages);
+			if(!received)
 			{
 				LOG(this->log_interconnect, LEVEL_ERROR,
 				    "error when receiving data on input channel\n");
 				status = false;
 			}
+			if(closed)
+			{
+				// the event closes the socket
+				this->removeEvent(event->getFd());
+			}
 			// Iterate over received messages
 			for(std::list<rt_msg_t>::iterator it = messages.begin();
 			    it != messages.end(); it++)
@@ -175,6 +233,15 @@ bool BlockInterconnectDownward::Upward::onInit(void)
 
 	// Create channel
 	this->initUdpChannels(data_port, sig_port, remote_addr, stack, rmem, wmem);
+	unsigned int streams = 1;
+	if(!Conf->getInterconnectDataStreams(streams, isl_index) ||
+	   !this->initDataStreams(streams, data_port, remote_addr, stack, rmem, wmem, true) ||
+	   !this->startDataReceivers())
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "Cannot create the interconnect data streams\n");
+		return false;
+	}
 
 	// Add NetSocketEvents
 	socket_event = this->addNetSocketEvent(name + "_data",
@@ -195,6 +262,49 @@ bool BlockInterconnectDownward::Upward::onInit(void)
 		    "Cannot add sig socket event to Upward channel\n");
 		return false;
 	}
+	// Add the events of the workers receiving the other data streams
+	for(std::size_t index = 0; index < this->data_receivers.size(); ++index)
+	{
+		if(this->addFileEvent(name + "_data_" + std::to_string(index + 1),
+		                      this->data_receivers[index]->getEventFd(),
+		                      sizeof(uint64_t)) < 0)
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "Cannot add data stream events to %s channel\n",
+			    name.c_str());
+			return false;
+		}
+	}
+	// Add the shared memory events used by a local sender
+	for(auto &&shm: {std::make_pair(this->data_shm.get(), "_data_shm"),
+	                 std::make_pair(this->sig_shm.get(), "_sig_shm")})
+	{
+		if(shm.first == nullptr)
+		{
+			continue;
+		}
+		if(this->addTcpListenEvent(name + shm.second + "_listen", shm.first->getListenFd()) < 0 ||
+		   this->addFileEvent(name + shm.second, shm.first->getEventFd(), sizeof(uint64_t)) < 0)
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "Cannot add shared memory events to Upward channel\n");
+			return false;
+		}
+	}
+	// Listen for the streams of the sender if they are enabled
+	bool stream = false;
+	Conf->getInterconnectTransport(stream, isl_index);
+	if(stream)
+	{
+		if(!this->initStreamChannels(data_port, sig_port, remote_addr, rmem, wmem) ||
+		   this->addTcpListenEvent(name + "_data_stream_listen", this->data_stream->getListenFd()) < 0 ||
+		   this->addTcpListenEvent(name + "_sig_stream_listen", this->sig_stream->getListenFd()) < 0)
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "Cannot add stream events to Upward channel\n");
+			return false;
+		}
+	}
 	return true;
 }
 
@@ -217,6 +327,34 @@ bool BlockInterconnectDownward::Downward::onInit()
 
 	// Create channel
 	this->initUdpChannels(data_port, sig_port, remote_addr, stack, rmem, wmem);
+	unsigned int streams = 1;
+	if(!Conf->getInterconnectDataStreams(streams, isl_index) ||
+	   !this->initDataStreams(streams, data_port, remote_addr, stack, rmem, wmem, false))
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "Cannot create the interconnect data streams\n");
+		return false;
+	}
+	bool stream = false;
+	Conf->getInterconnectTransport(stream, isl_index);
+	if(stream && !this->initStreamChannels(data_port, sig_port, remote_addr, rmem, wmem))
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "Cannot create the interconnect streams\n");
+		return false;
+	}
+
+	// gather the messages sent without delay until the flush deadline
+	double flush_deadline = 0;
+	Conf->getInterconnectFlushDeadline(flush_deadline, isl_index);
+	this->initBatching(flush_deadline);
+	bool compression = false;
+	Conf->getInterconnectCompression(compression, isl_index);
+	this->initCompression(compression);
+	if(flush_deadline > 0)
+	{
+		flush_timer = this->addTimerEvent(name + ".flush_timer", flush_deadline, false, false);
+	}
 
 	delay_timer = this->addTimerEvent(name + ".delay_timer", polling_rate);
 
@@ -258,6 +396,28 @@ bool BlockInterconnectUpward::Downward::onEvent(const RtEvent *const event)
 
 	switch(event->getType())
 	{
+		case EventType::TcpListen:
+		{
+			// a local sender asks for the shared memory ring
+			// or the sender opens its stream
+			int stream_fd = -1;
+			if(!this->acceptShm((TcpListenEvent *)event) ||
+			   !this->acceptStream((TcpListenEvent *)event, stream_fd))
+			{
+				status = false;
+			}
+			else if(stream_fd >= 0 &&
+			        this->addFileEvent(this->getName() + ".stream", stream_fd,
+			                           StreamChannelReceiver::read_length) < 0)
+			{
+				LOG(this->log_interconnect, LEVEL_ERROR,
+				    "cannot monitor the stream of the sender\n");
+				status = false;
+			}
+		}
+		break;
+
+		case EventType::File:
 		case EventType::NetSocket:
 		{
 			std::list<rt_msg_t> messages;
@@ -265,13 +425,24 @@ bool BlockInterconnectUpward::Downward::onEvent(const RtEvent *const event)
 			LOG(this->log_interconnect, LEVEL_DEBUG,
 			    "NetSocket event received\n");
 
-			// Receive messages
-			if(!this->receive((NetSocketEvent *)event, messages))
+			// Receive messages from the UDP channels and their workers, the streams or the shared memory rings
+			bool closed = false;
+			bool received = event->getType() == EventType::File ?
+			                this->receiveStream((FileEvent *)event, messages, closed) &&
+			                this->receiveShm((FileEvent *)event, messages) &&
+			                this->receiveDataStreams((FileEvent *)event, messages) :
+			                this->receive((NetSocketEvent *)event, messages);
+			if(!received)
 			{
 				LOG(this->log_interconnect, LEVEL_ERROR,
 				    "error when receiving data on input channel\n");
 				status = false;
 			}
+			if(closed)
+			{
+				// the event closes the socket
+				this->removeEvent(event->getFd());
+			}
 			// Iterate over received messages
 			for(std::list<rt_msg_t>::iterator it = messages.begin();
 			    it != messages.end(); it++)
@@ -314,11 +485,15 @@ bool BlockInterconnectUpward::Upward::onEvent(const RtEvent *const event)
 				    "error when sending data\n");
 				return false;
 			}
+			if(this->takeFlushRequest())
+			{
+				this->startTimer(this->flush_timer);
+			}
 		}
 		break;
 
 		case EventType::Timer:
-			if (event->getFd() == delay_timer)
+			if (event->getFd() == delay_timer || event->getFd() == flush_timer)
 			{
 				onTimerEvent();
 			}
@@ -333,6 +508,25 @@ bool BlockInterconnectUpward::Upward::onEvent(const RtEvent *const event)
 	return true;
 }
 
+bool BlockInterconnectUpward::Upward::onMessageBatch(const MessageEvent *const event)
+{
+	// the messages received on the same wakeup are gathered
+	// in as few datagrams as possible
+	this->deferSends();
+	bool status = RtUpward::onMessageBatch(event);
+	if(!this->flushSends())
+	{
+		LOG(this->log_interconnect, LEVEL_ERROR,
+		    "error when sending data\n");
+		status = false;
+	}
+	if(this->takeFlushRequest())
+	{
+		this->startTimer(this->flush_timer);
+	}
+	return status;
+}
+
 bool BlockInterconnectUpward::onInit(void)
 {
 	// Register log 
@@ -359,6 +553,34 @@ bool BlockInterconnectUpward::Upward::onInit(void)
 
 	// Create channel
 	this->initUdpChannels(data_port, sig_port, remote_addr, stack, rmem, wmem);
+	unsigned int streams = 1;
+	if(!Conf->getInterconnectDataStreams(streams, isl_index) ||
+	   !this->initDataStreams(streams, data_port, remote_addr, stack, rmem, wmem, false))
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "Cannot create the interconnect data streams\n");
+		return false;
+	}
+	bool stream = false;
+	Conf->getInterconnectTransport(stream, isl_index);
+	if(stream && !this->initStreamChannels(data_port, sig_port, remote_addr, rmem, wmem))
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "Cannot create the interconnect streams\n");
+		return false;
+	}
+
+	// gather the messages sent without delay until the flush deadline
+	double flush_deadline = 0;
+	Conf->getInterconnectFlushDeadline(flush_deadline, isl_index);
+	this->initBatching(flush_deadline);
+	bool compression = false;
+	Conf->getInterconnectCompression(compression, isl_index);
+	this->initCompression(compression);
+	if(flush_deadline > 0)
+	{
+		flush_timer = this->addTimerEvent(name + ".flush_timer", flush_deadline, false, false);
+	}
 
 	delay_timer = this->addTimerEvent(name + ".delay_timer", polling_rate);
 
@@ -386,6 +608,15 @@ bool BlockInterconnectUpward::Downward::onInit()
 
 	// Create channel
 	this->initUdpChannels(data_port, sig_port, remote_addr, stack, rmem, wmem);
+	unsigned int streams = 1;
+	if(!Conf->getInterconnectDataStreams(streams, isl_index) ||
+	   !this->initDataStreams(streams, data_port, remote_addr, stack, rmem, wmem, true) ||
+	   !this->startDataReceivers())
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "Cannot create the interconnect data streams\n");
+		return false;
+	}
 
 	// Add NetSocketEvents
 	socket_event = this->addNetSocketEvent(name + "_data",
@@ -406,6 +637,49 @@ bool BlockInterconnectUpward::Downward::onInit()
 		    "Cannot add data socket event to Downward channel\n");
 		return false;
 	}
+	// Add the events of the workers receiving the other data streams
+	for(std::size_t index = 0; index < this->data_receivers.size(); ++index)
+	{
+		if(this->addFileEvent(name + "_data_" + std::to_string(index + 1),
+		                      this->data_receivers[index]->getEventFd(),
+		                      sizeof(uint64_t)) < 0)
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "Cannot add data stream events to %s channel\n",
+			    name.c_str());
+			return false;
+		}
+	}
+	// Add the shared memory events used by a local sender
+	for(auto &&shm: {std::make_pair(this->data_shm.get(), "_data_shm"),
+	                 std::make_pair(this->sig_shm.get(), "_sig_shm")})
+	{
+		if(shm.first == nullptr)
+		{
+			continue;
+		}
+		if(this->addTcpListenEvent(name + shm.second + "_listen", shm.first->getListenFd()) < 0 ||
+		   this->addFileEvent(name + shm.second, shm.first->getEventFd(), sizeof(uint64_t)) < 0)
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "Cannot add shared memory events to Downward channel\n");
+			return false;
+		}
+	}
+	// Listen for the streams of the sender if they are enabled
+	bool stream = false;
+	Conf->getInterconnectTransport(stream, isl_index);
+	if(stream)
+	{
+		if(!this->initStreamChannels(data_port, sig_port, remote_addr, rmem, wmem) ||
+		   this->addTcpListenEvent(name + "_data_stream_listen", this->data_stream->getListenFd()) < 0 ||
+		   this->addTcpListenEvent(name + "_sig_stream_listen", this->sig_stream->getListenFd()) < 0)
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "Cannot add stream events to Downward channel\n");
+			return false;
+		}
+	}
 
 	return true;
 }
@@ -85,10 +85,13 @@ public:
 		Downward(const std::string &name, const InterconnectConfig &config);
 		bool onInit(void);
 		bool onEvent(const RtEvent *const event);
+		bool onMessageBatch(const MessageEvent *const event) override;
 
 	private:
 		event_id_t delay_timer;
 		uint32_t polling_rate;
+		/// The timer flushing the batches at their deadline, -1 if disabled
+		event_id_t flush_timer = -1;
 		std::size_t isl_index;
 	};
 
@@ -126,10 +129,13 @@ public:
 		Upward(const std::string &name, const InterconnectConfig &config);
 		bool onInit(void);
 		bool onEvent(const RtEvent *const event);
+		bool onMessageBatch(const MessageEvent *const event) override;
 
 	private:
 		event_id_t delay_timer;
 		uint32_t polling_rate;
+		/// The timer flushing the batches at their deadline, -1 if disabled
+		event_id_t flush_timer = -1;
 		std::size_t isl_index;
 	};
 
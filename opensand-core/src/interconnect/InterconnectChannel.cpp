@@ -32,17 +32,30 @@
  * @author Joaquin Muguerza <joaquin.muguerza@toulouse.viveris.fr>
  */
 
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <ctime>
+
+#if HAVE_LZ4_H
+#include <lz4.h>
+#endif
+
 #include "BlockInterconnect.h"
 #include "InterconnectChannel.h"
 #include "NetBurst.h"
 #include <opensand_output/Output.h>
+#include <opensand_rt/FileEvent.h>
 #include <opensand_rt/NetSocketEvent.h>
+#include <opensand_rt/TcpListenEvent.h>
 
 InterconnectChannel::InterconnectChannel(std::string name, const InterconnectConfig &config):
 	name(name),
 	interconnect_addr(config.interconnect_addr),
 	data_channel(nullptr),
-	sig_channel(nullptr)
+	sig_channel(nullptr),
+	data_streams()
 {
 	this->log_interconnect = Output::Get()->registerLog(LEVEL_WARNING, name + ".common");
 }
@@ -61,6 +74,47 @@ InterconnectChannel::~InterconnectChannel()
 	}
 }
 
+bool InterconnectChannel::initDataStreams(unsigned int streams, unsigned int data_port,
+                                          std::string remote_addr, unsigned int stack,
+                                          unsigned int rmem, unsigned int wmem,
+                                          bool input)
+{
+	for(unsigned int index = 1; index < streams; ++index)
+	{
+		std::unique_ptr<UdpChannel> channel{new UdpChannel(name + ".data." + std::to_string(index),
+		                                                   0, // no use for the spot ID
+		                                                   index,
+		                                                   input,
+		                                                   !input,
+		                                                   data_port + index * interconnect_data_port_stride,
+		                                                   false, // this socket is not multicast
+		                                                   this->interconnect_addr,
+		                                                   remote_addr,
+		                                                   stack,
+		                                                   rmem,
+		                                                   wmem)};
+		if(!channel->isInit())
+		{
+			LOG(this->log_interconnect, LEVEL_ERROR,
+			    "cannot create the data stream %u\n", index);
+			return false;
+		}
+		this->data_streams.push_back(std::move(channel));
+	}
+	if(streams > 1)
+	{
+		LOG(this->log_interconnect, LEVEL_NOTICE,
+		    "data messages spread over %u streams by spot\n", streams);
+	}
+	return true;
+}
+
+UdpChannel *InterconnectChannel::getDataChannel(spot_id_t spot) const
+{
+	std::size_t index = spot % (this->data_streams.size() + 1);
+	return index == 0 ? this->data_channel : this->data_streams[index - 1].get();
+}
+
 /*
  * INTERCONNECT_CHANNEL_SENDER
  */
@@ -99,43 +153,174 @@ void InterconnectChannelSender::initUdpChannels(unsigned int data_port, unsigned
 	                                   stack,
 	                                   rmem,
 	                                   wmem);
+	this->data_shm.reset(new ShmChannelSender(name + ".data.shm", remote_addr, data_port));
+	this->sig_shm.reset(new ShmChannelSender(name + ".sig.shm", remote_addr, sig_port));
 }
 
-bool InterconnectChannelSender::sendBuffer(bool is_sig, const interconnect_msg_buffer_t &msg)
+bool InterconnectChannelSender::initStreamChannels(unsigned int data_port, unsigned int sig_port,
+                                                   std::string remote_addr,
+                                                   unsigned int, unsigned int wmem)
 {
-	auto buffer = reinterpret_cast<const uint8_t *>(&msg);
-	auto channel = is_sig ? this->sig_channel : this->data_channel;
-	return channel->send(buffer, msg.data_len);
+	this->data_stream.reset(new StreamChannelSender(name + ".data.stream", remote_addr, data_port, wmem));
+	this->sig_stream.reset(new StreamChannelSender(name + ".sig.stream", remote_addr, sig_port, wmem));
+	this->max_length = interconnect_stream_max_length;
+	return true;
 }
 
-/*
- * Specific methods for type DvbFrame messages
+/**
+ * @brief Get the offset of the next record or message
  */
+static inline std::size_t alignLength(std::size_t length)
+{
+	return (length + interconnect_alignment - 1) & ~(interconnect_alignment - 1);
+}
+
+template <typename T>
+void serializeField(Data &buffer, const T &field)
+{
+	buffer.append(reinterpret_cast<const unsigned char *>(&field), sizeof(T));
+}
+
+/**
+ * @brief Open a new message without any record
+ */
+static void openMessage(Data &message, uint8_t msg_type)
+{
+	interconnect_header_t header{};
+	header.version = interconnect_version;
+	header.msg_type = msg_type;
+	message.clear();
+	message.reserve(interconnect_max_length);
+	serializeField(message, header);
+}
+
+/**
+ * @brief Add a record to the message header
+ */
+static void addRecord(Data &message)
+{
+	auto header = reinterpret_cast<interconnect_header_t *>(&message[0]);
+	header->nb_records++;
+	header->length = message.length();
+}
+
+bool InterconnectChannelSender::reserveRecord(uint8_t msg_type,
+                                              std::size_t record_length,
+                                              std::vector<Data> &messages,
+                                              Data &message)
+{
+	if(sizeof(interconnect_header_t) + record_length > this->max_length)
+	{
+		LOG(this->log_interconnect, LEVEL_ERROR,
+		    "record of %zu bytes is too long for an interconnect message\n",
+		    record_length);
+		return false;
+	}
+
+	if(message.empty())
+	{
+		openMessage(message, msg_type);
+	}
+	else if(alignLength(message.length()) + record_length > this->max_length ||
+	        reinterpret_cast<const interconnect_header_t *>(message.data())->nb_records == UINT16_MAX)
+	{
+		messages.push_back(std::move(message));
+		openMessage(message, msg_type);
+	}
+	else
+	{
+		// pad the previous record
+		message.resize(alignLength(message.length()), 0);
+	}
+	return true;
+}
+
+bool InterconnectChannelSender::serialize(const DvbFrame &dvb_frame,
+                                          uint8_t msg_type,
+                                          std::vector<Data> &messages,
+                                          Data &message)
+{
+	interconnect_frame_t record{};
+	record.length = sizeof(record) + dvb_frame.getTotalLength();
+	record.spot = dvb_frame.getSpot();
+	record.carrier_id = dvb_frame.getCarrierId();
+	if(!this->reserveRecord(msg_type, record.length, messages, message))
+	{
+		return false;
+	}
+
+	serializeField(message, record);
+	message.append(dvb_frame.getRawData(), dvb_frame.getTotalLength());
+	addRecord(message);
+	return true;
+}
+
+bool InterconnectChannelSender::serialize(const NetPacket &packet,
+                                          uint8_t msg_type,
+                                          std::vector<Data> &messages,
+                                          Data &message)
+{
+	interconnect_packet_t record{};
+	record.length = sizeof(record) + packet.getTotalLength();
+	record.src_id = packet.getSrcTalId();
+	record.dst_id = packet.getDstTalId();
+	record.qos = packet.getQos();
+	record.type = to_underlying(packet.getType());
+	record.header_length = packet.getHeaderLength();
+	if(!this->reserveRecord(msg_type, record.length, messages, message))
+	{
+		return false;
+	}
+
+	serializeField(message, record);
+	message.append(packet.getRawData(), packet.getTotalLength());
+	addRecord(message);
+	return true;
+}
+
 bool InterconnectChannelSender::send(rt_msg_t &message)
 {
 	time_ms_t current_time = getCurrentTime();
 
-	interconnect_msg_buffer_t msg_buffer;
-	uint32_t len;
+	std::vector<Data> messages;
+	Data current;
+	bool status = true;
+	// the messages of a spot stay on the same data stream so they keep their order
+	spot_id_t spot = 0;
 
 	auto msg_type = to_enum<InternalMessageType>(message.type);
-	msg_buffer.msg_type = message.type;
 
-	// Serialize the message
+	// Serialize the message, split in several messages if it does not fit in a datagram
 	if (msg_type == InternalMessageType::encap_data || msg_type == InternalMessageType::sig)
 	{
 		auto frame = std::unique_ptr<DvbFrame>{static_cast<DvbFrame *>(message.data)};
-		this->serialize(frame.get(), msg_buffer.msg_data, len);
+		spot = frame->getSpot();
+		status = this->serialize(*frame, message.type, messages, current);
 	}
 	else if (msg_type == InternalMessageType::saloha)
 	{
 		auto dvb_frames = std::unique_ptr<std::list<DvbFrame *>>{static_cast<std::list<DvbFrame *> *>(message.data)};
-		this->serialize(dvb_frames.get(), msg_buffer.msg_data, len);
+		if (!dvb_frames->empty())
+		{
+			spot = dvb_frames->front()->getSpot();
+		}
+		for (auto &&dvb_frame: *dvb_frames)
+		{
+			status &= this->serialize(*dvb_frame, message.type, messages, current);
+			delete dvb_frame;
+		}
 	}
 	else if (msg_type == InternalMessageType::decap_data)
 	{
 		auto net_burst = std::unique_ptr<NetBurst>{static_cast<NetBurst *>(message.data)};
-		this->serialize(*net_burst, msg_buffer.msg_data, len);
+		if (!net_burst->empty())
+		{
+			spot = net_burst->front()->getSpot();
+		}
+		for (auto &&packet: *net_burst)
+		{
+			status &= this->serialize(*packet, message.type, messages, current);
+		}
 	}
 	else
 	{
@@ -144,121 +329,348 @@ bool InterconnectChannelSender::send(rt_msg_t &message)
 		return false;
 	}
 
-	// add the length of the other fields
-	msg_buffer.data_len = len + sizeof(msg_buffer.msg_type) + sizeof(msg_buffer.data_len);
+	if (!current.empty())
+	{
+		messages.push_back(std::move(current));
+	}
 
-	// construct a NetContainer to store it in a FifoElement
-	auto buf = reinterpret_cast<const uint8_t *>(&msg_buffer);
-	std::unique_ptr<NetContainer> container{new NetContainer(buf, msg_buffer.data_len)};
-	FifoElement *elem = new FifoElement(std::move(container), current_time, current_time + delay);
+	// store the messages in FifoElements
+	for (auto &&data: messages)
+	{
+		if (delay == 0)
+		{
+			this->batch_length += data.length();
+		}
+		std::unique_ptr<NetContainer> container{new NetContainer(std::move(data))};
+		container->setSpot(spot);
+		FifoElement *elem = new FifoElement(std::move(container), current_time, current_time + delay);
 
-	if (!delay_fifo.pushBack(elem)) {
-		LOG(this->log_interconnect, LEVEL_ERROR, "failed to push the message in the fifo\n");
-		return false;
+		if (!delay_fifo.pushBack(elem)) {
+			LOG(this->log_interconnect, LEVEL_ERROR, "failed to push the message in the fifo\n");
+			delete elem;
+			return false;
+		}
 	}
-	
-	// if no delay, send directly
-	if (delay == 0)
+
+	// if no delay, send directly or with the batch
+	if (delay == 0 && !this->deferred)
 	{
-		return onTimerEvent();
+		status &= this->sendBatch();
 	}
 
-	return true;
+	return status;
 }
 
-bool InterconnectChannelSender::onTimerEvent()
+void InterconnectChannelSender::deferSends()
 {
-	time_ms_t current_time = getCurrentTime();
+	this->deferred = true;
+}
 
-	while (delay_fifo.getCurrentSize() > 0 && ((unsigned long)delay_fifo.getTickOut()) <= current_time)
+bool InterconnectChannelSender::flushSends()
+{
+	this->deferred = false;
+	if (delay != 0)
 	{
-		FifoElement *elem = delay_fifo.pop();
-		assert(elem != nullptr);
+		return this->onTimerEvent();
+	}
+	return this->sendBatch();
+}
 
-		auto container = elem->getElem<NetContainer>();
-		auto msg = reinterpret_cast<const interconnect_msg_buffer_t *>(container->getRawData());
-		bool is_sig = to_enum<InternalMessageType>(msg->msg_type) == InternalMessageType::sig;
-		if (!sendBuffer(is_sig, *msg))
-		{
-			LOG(this->log_interconnect, LEVEL_ERROR, "failed to send buffer\n");
-			return false;
-		};
+void InterconnectChannelSender::initBatching(double flush_deadline)
+{
+	auto output = Output::Get();
+	this->flush_deadline = flush_deadline;
+	this->probe_batch_size = output->registerProbe<int>(this->name + ".Batch.Size", "messages", true, SAMPLE_AVG);
+	this->probe_flush_latency = output->registerProbe<float>(this->name + ".Batch.Flush latency", "ms", true, SAMPLE_MAX);
+}
+
+bool InterconnectChannelSender::takeFlushRequest()
+{
+	bool requested = this->flush_requested;
+	this->flush_requested = false;
+	return requested;
+}
+
+void InterconnectChannelSender::initCompression(bool enabled)
+{
+#if HAVE_LZ4_H
+	auto output = Output::Get();
+	this->compression = enabled;
+	if (enabled)
+	{
+		this->probe_compression_ratio = output->registerProbe<float>(this->name + ".Compression.Ratio", true, SAMPLE_AVG);
+		this->probe_compression_time = output->registerProbe<int>(this->name + ".Compression.CPU time", "us", true, SAMPLE_SUM);
+	}
+#else
+	if (enabled)
+	{
+		LOG(this->log_interconnect, LEVEL_WARNING,
+		    "built without LZ4, the interconnect data is not compressed\n");
+	}
+#endif
+}
+
+/// The number of datagrams left uncompressed after an incompressible one
+constexpr unsigned int compression_backoff{16};
+
+/**
+ * @brief Get the thread CPU time
+ */
+static inline int64_t getCpuTime()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+const Data *InterconnectChannelSender::compress(const unsigned char *data, std::size_t length)
+{
+#if HAVE_LZ4_H
+	if (!this->compression)
+	{
+		return nullptr;
+	}
+	if (this->compression_skip > 0)
+	{
+		this->compression_skip--;
+		return nullptr;
+	}
+
+	constexpr std::size_t header_length = sizeof(interconnect_header_t) + sizeof(interconnect_compressed_t);
+	int64_t start = getCpuTime();
+	int bound = LZ4_compressBound(length);
+	this->datagrams.emplace_back();
+	Data &message = this->datagrams.back();
+	message.resize(header_length + bound);
+	int compressed = LZ4_compress_default(reinterpret_cast<const char *>(data),
+	                                      reinterpret_cast<char *>(&message[header_length]),
+	                                      length, bound);
+	this->probe_compression_time->put(getCpuTime() - start);
+
+	// keep the data as is unless it saves at least 1/16 of it
+	if (compressed <= 0 || header_length + compressed > length - length / 16)
+	{
+		this->datagrams.pop_back();
+		this->compression_skip = compression_backoff;
+		this->probe_compression_ratio->put(1);
+		return nullptr;
+	}
+
+	message.resize(header_length + compressed);
+	auto header = reinterpret_cast<interconnect_header_t *>(&message[0]);
+	header->version = interconnect_version;
+	header->msg_type = interconnect_compressed;
+	header->nb_records = 0;
+	header->length = message.length();
+	reinterpret_cast<interconnect_compressed_t *>(&message[sizeof(*header)])->length = length;
+	this->probe_compression_ratio->put(float(length) / message.length());
+	return &message;
+#else
+	(void)data;
+	(void)length;
+	return nullptr;
+#endif
+}
+
+bool InterconnectChannelSender::sendBatch()
+{
+	if (this->flush_deadline <= 0 || this->batch_length >= interconnect_max_length)
+	{
+		return this->onTimerEvent();
+	}
+	if (this->batch_start == 0)
+	{
+		// the first message of the batch starts the deadline
+		this->batch_start = getPreciseTime();
+		this->flush_requested = true;
 	}
 	return true;
 }
 
-template <typename T>
-void serializeField(uint8_t *buf, uint32_t &pos, T *data, uint32_t length = sizeof(T))
+bool InterconnectChannelSender::queueDatagram(UdpChannel *channel,
+                                              const std::vector<const Data *> &messages)
 {
-	memcpy(buf + pos, data, length);
-	pos += length;
+	const Data *datagram = messages.front();
+	if (messages.size() > 1)
+	{
+		// gather the messages, the list keeps the buffer in place until the flush
+		this->datagrams.emplace_back();
+		Data &gathered = this->datagrams.back();
+		gathered.reserve(interconnect_max_length);
+		for (auto &&message: messages)
+		{
+			gathered.resize(alignLength(gathered.length()), 0);
+			gathered.append(*message);
+		}
+		datagram = &gathered;
+	}
+
+	if (channel != this->sig_channel)
+	{
+		const Data *compressed = this->compress(datagram->data(), datagram->length());
+		if (compressed != nullptr)
+		{
+			datagram = compressed;
+		}
+	}
+	return channel->queue(datagram->data(), datagram->length());
 }
 
-void InterconnectChannelSender::serialize(DvbFrame *dvb_frame,
-                                          unsigned char *buf,
-                                          uint32_t &length)
+bool InterconnectChannelSender::queueMessages(UdpChannel *channel,
+                                              const std::vector<std::unique_ptr<NetContainer>> &messages)
 {
-	uint32_t pos = 0;
-	spot_id_t spot = dvb_frame->getSpot();
-	uint8_t carrier_id = dvb_frame->getCarrierId();
+	std::vector<const Data *> datagram;
+	std::size_t length = 0;
+	bool status = true;
 
-	serializeField(buf, pos, &spot);
-	serializeField(buf, pos, &carrier_id);
-	serializeField(buf, pos, dvb_frame->getRawData(), dvb_frame->getTotalLength());
-	length = pos;
+	for (auto &&container: messages)
+	{
+		const Data &message = container->getData();
+		if (!datagram.empty() &&
+		    alignLength(length) + message.length() > interconnect_max_length)
+		{
+			status &= this->queueDatagram(channel, datagram);
+			datagram.clear();
+			length = 0;
+		}
+		length = alignLength(length) + message.length();
+		datagram.push_back(&message);
+	}
+
+	if (!datagram.empty())
+	{
+		status &= this->queueDatagram(channel, datagram);
+	}
+	return status;
 }
 
-void InterconnectChannelSender::serialize(std::list<DvbFrame *> *dvb_frame_list,
-                                          unsigned char *buf,
-                                          uint32_t &length)
+bool InterconnectChannelSender::queueMessages(ShmChannelSender &channel,
+                                              const std::vector<std::unique_ptr<NetContainer>> &messages)
 {
-	length = 0;
-	// Iterate over dvb_frames
-	for (auto dvb_frame: *dvb_frame_list)
+	bool status = true;
+	for (auto &&container: messages)
 	{
-		uint32_t partial_len;
-		// First serialize dvb_frame
-		this->serialize(dvb_frame, buf + length + sizeof(partial_len), partial_len);
-		// Copy the size of the dvb_frame before the frame itself
-		memcpy(buf + length, &partial_len, sizeof(partial_len));
-		length += partial_len + sizeof(partial_len);
+		status &= channel.queue(container->getRawData(), container->getTotalLength());
 	}
+	return status;
 }
 
-void InterconnectChannelSender::serialize(const NetBurst &net_burst,
-                                          unsigned char *buf, uint32_t &length)
+bool InterconnectChannelSender::queueMessages(StreamChannelSender &channel,
+                                              const std::vector<std::unique_ptr<NetContainer>> &messages)
 {
-	length = 0;
-	for (auto &&packet: net_burst)
+	bool status = true;
+	for (auto &&container: messages)
 	{
-		uint32_t partial_len;
-		// First serialize the packet
-		this->serialize(*packet, buf + length + sizeof(partial_len), partial_len);
-		// Copy the size of the packet before the packet itself
-		memcpy(buf + length, &partial_len, sizeof(partial_len));
-		length += partial_len + sizeof(partial_len);
-		assert(length <= MAX_SOCK_SIZE);
+		const Data *compressed = nullptr;
+		if (&channel == this->data_stream.get())
+		{
+			compressed = this->compress(container->getRawData(), container->getTotalLength());
+		}
+		if (compressed != nullptr)
+		{
+			status &= channel.queue(compressed->data(), compressed->length());
+		}
+		else
+		{
+			status &= channel.queue(container->getRawData(), container->getTotalLength());
+		}
 	}
+	return status;
 }
 
-void InterconnectChannelSender::serialize(const NetPacket &packet,
-                                          unsigned char *buf, uint32_t &length)
+bool InterconnectChannelSender::onTimerEvent()
 {
-	uint32_t pos = 0;
+	time_ms_t current_time = getCurrentTime();
+
+	// keep the due messages until they are flushed
+	std::vector<std::unique_ptr<NetContainer>> sig_messages;
+	std::vector<std::unique_ptr<NetContainer>> data_messages;
+
+	while (delay_fifo.getCurrentSize() > 0 && ((unsigned long)delay_fifo.getTickOut()) <= current_time)
+	{
+		std::unique_ptr<FifoElement> elem{delay_fifo.pop()};
+		assert(elem != nullptr);
 
-	uint8_t src_id = packet.getSrcTalId();
-	uint8_t dest_id = packet.getDstTalId();
-	uint8_t qos = packet.getQos();
-	NET_PROTO type = packet.getType();
-	uint32_t header_length = packet.getHeaderLength();
+		auto container = elem->getElem<NetContainer>();
+		auto header = reinterpret_cast<const interconnect_header_t *>(container->getRawData());
+		bool is_sig = to_enum<InternalMessageType>(header->msg_type) == InternalMessageType::sig;
+		(is_sig ? sig_messages : data_messages).push_back(std::move(container));
+	}
 
-	serializeField(buf, pos, &src_id);
-	serializeField(buf, pos, &dest_id);
-	serializeField(buf, pos, &qos);
-	serializeField(buf, pos, &type);
-	serializeField(buf, pos, &header_length);
-	serializeField(buf, pos, packet.getRawData(), packet.getTotalLength());
-	length = pos;
+	std::size_t batch_size = sig_messages.size() + data_messages.size();
+	if (batch_size > 0 && this->probe_batch_size)
+	{
+		this->probe_batch_size->put(batch_size);
+		if (this->batch_start != 0)
+		{
+			this->probe_flush_latency->put(getPreciseTime() - this->batch_start);
+		}
+	}
+	this->batch_length = 0;
+	this->batch_start = 0;
+
+	bool status = true;
+	if (this->sig_shm->connect())
+	{
+		status &= this->queueMessages(*this->sig_shm, sig_messages);
+		status &= this->sig_shm->flush();
+	}
+	else if (this->sig_stream)
+	{
+		// the messages may not fit in a datagram, they are lost until the receiver accepts the stream
+		if (this->sig_stream->connect())
+		{
+			status &= this->queueMessages(*this->sig_stream, sig_messages);
+		}
+		status &= this->sig_stream->flush();
+	}
+	else
+	{
+		status &= this->queueMessages(this->sig_channel, sig_messages);
+		// flush even on error so no pointer to the messages remains queued
+		status &= this->sig_channel->flush();
+	}
+	if (this->data_shm->connect())
+	{
+		status &= this->queueMessages(*this->data_shm, data_messages);
+		status &= this->data_shm->flush();
+	}
+	else if (this->data_stream)
+	{
+		if (this->data_stream->connect())
+		{
+			status &= this->queueMessages(*this->data_stream, data_messages);
+		}
+		status &= this->data_stream->flush();
+	}
+	else if (!this->data_streams.empty())
+	{
+		// the messages of each spot are sent on its stream
+		std::vector<std::vector<std::unique_ptr<NetContainer>>> stream_messages(this->data_streams.size() + 1);
+		for (auto &&container: data_messages)
+		{
+			std::size_t index = container->getSpot() % stream_messages.size();
+			stream_messages[index].push_back(std::move(container));
+		}
+		for (std::size_t index = 0; index < stream_messages.size(); ++index)
+		{
+			UdpChannel *channel = index == 0 ? this->data_channel : this->data_streams[index - 1].get();
+			status &= this->queueMessages(channel, stream_messages[index]);
+			status &= channel->flush();
+		}
+	}
+	else
+	{
+		status &= this->queueMessages(this->data_channel, data_messages);
+		status &= this->data_channel->flush();
+	}
+	this->datagrams.clear();
+
+	if (!status)
+	{
+		LOG(this->log_interconnect, LEVEL_ERROR, "failed to send buffer\n");
+	}
+	return status;
 }
 
 /*
@@ -294,14 +706,33 @@ void InterconnectChannelReceiver::initUdpChannels(unsigned int data_port, unsign
 	                                   stack,
 	                                   rmem,
 	                                   wmem);
+
+	// a local sender uses these channels instead of UDP
+	this->data_shm.reset(new ShmChannelReceiver(name + ".data.shm", this->interconnect_addr, data_port));
+	if(!this->data_shm->listen())
+	{
+		this->data_shm.reset();
+	}
+	this->sig_shm.reset(new ShmChannelReceiver(name + ".sig.shm", this->interconnect_addr, sig_port));
+	if(!this->sig_shm->listen())
+	{
+		this->sig_shm.reset();
+	}
+}
+
+bool InterconnectChannelReceiver::initStreamChannels(unsigned int data_port, unsigned int sig_port,
+                                                     std::string,
+                                                     unsigned int rmem, unsigned int)
+{
+	this->data_stream.reset(new StreamChannelReceiver(name + ".data.stream", this->interconnect_addr, data_port, rmem));
+	this->sig_stream.reset(new StreamChannelReceiver(name + ".sig.stream", this->interconnect_addr, sig_port, rmem));
+	return this->data_stream->listen() && this->sig_stream->listen();
 }
 
 int InterconnectChannelReceiver::receiveToBuffer(NetSocketEvent *const event,
-                                                 interconnect_msg_buffer_t **buf)
+                                                 Data &packet)
 {
 	int ret = -1;
-	size_t length = 0;
-	*buf = NULL;
 
 	LOG(this->log_interconnect, LEVEL_DEBUG,
 	    "try to receive a packet from interconnect channel "
@@ -310,33 +741,15 @@ int InterconnectChannelReceiver::receiveToBuffer(NetSocketEvent *const event,
 	// Try to receive data from the channel
 	if(*event == this->sig_channel->getChannelFd())
 	{
-		ret = this->sig_channel->receive(event, (unsigned char **) buf, length);
+		ret = this->sig_channel->receive(event, packet);
 	}
 	else
 	{
-		ret = this->data_channel->receive(event, (unsigned char **) buf, length);
+		ret = this->data_channel->receive(event, packet);
 	}
 
 	LOG(this->log_interconnect, LEVEL_DEBUG,
-	    "Receive packet: size %zu\n", length);
-
-	// Check that the total_length is correct, and fix data length
-	if(ret >= 0 && length > 0)
-	{
-		if((*buf)->data_len != length)
-		{
-			LOG(this->log_interconnect, LEVEL_ERROR,
-			    "Data length received (%zu) mismatches with message length (%zu)\n",
-			    length, (*buf)->data_len);
-			return -1;
-		}
-		(*buf)->data_len -= (sizeof((*buf)->data_len) + sizeof((*buf)->msg_type));
-	}
-	// If empty packet, return null pointer
-	else if(ret >= 0 && length == 0)
-	{
-		*buf = NULL;
-	}
+	    "Receive packet: size %zu\n", packet.length());
 
 	return ret;
 }
@@ -359,9 +772,9 @@ bool InterconnectChannelReceiver::receive(NetSocketEvent *const event,
 	// Start receiving messages
 	do
 	{
-		interconnect_msg_buffer_t *buf = NULL;
+		Data packet;
 
-		ret = this->receiveToBuffer(event, &buf);
+		ret = this->receiveToBuffer(event, packet);
 		if(ret < 0)
 		{
 			// Problem on reception
@@ -369,162 +782,393 @@ bool InterconnectChannelReceiver::receive(NetSocketEvent *const event,
 			    "failed to receive data on input channel\n");
 			return false;
 		}
-		else if(buf)
+		else if(!packet.empty() && !this->parse(packet.data(), packet.length(), messages))
 		{
-			rt_msg_t message;
+			status = false;
+		}
+	} while (ret > 0);
+	return status;
+}
 
-			// A message was received
-			LOG(this->log_interconnect, LEVEL_DEBUG,
-			    "%zu bytes of data received\n",
-			    buf->data_len);
+bool InterconnectChannelReceiver::acceptShm(TcpListenEvent *const event)
+{
+	for(auto &&channel: {this->data_shm.get(), this->sig_shm.get()})
+	{
+		if(channel != nullptr && *event == channel->getListenFd())
+		{
+			return channel->accept(event->getSocketClient());
+		}
+	}
+	return true;
+}
+
+bool InterconnectChannelReceiver::acceptStream(TcpListenEvent *const event, int &stream_fd)
+{
+	stream_fd = -1;
+	for(auto &&channel: {this->data_stream.get(), this->sig_stream.get()})
+	{
+		if(channel != nullptr && *event == channel->getListenFd())
+		{
+			stream_fd = event->getSocketClient();
+			return channel->accept(stream_fd);
+		}
+	}
+	return true;
+}
+
+bool InterconnectChannelReceiver::receiveStream(const FileEvent *const event,
+                                                std::list<rt_msg_t> &messages,
+                                                bool &closed)
+{
+	closed = false;
+	for(auto &&channel: {this->data_stream.get(), this->sig_stream.get()})
+	{
+		if(channel == nullptr || !channel->isConnection(event->getFd()))
+		{
+			continue;
+		}
+
+		unsigned char *data = event->getData();
+		if(data == nullptr)
+		{
+			// end of stream
+			channel->release(event->getFd());
+			closed = true;
+			return true;
+		}
+
+		// the whole messages are parsed in place, the end is kept for the next read
+		const unsigned char *complete;
+		std::size_t length;
+		if(!channel->receive(event->getFd(), data, event->getSize(), complete, length))
+		{
+			// the stream cannot be resynchronized
+			event->releaseData(data);
+			channel->release(event->getFd());
+			closed = true;
+			return false;
+		}
+		bool status = length == 0 || this->parse(complete, length, messages);
+		event->releaseData(data);
+		return status;
+	}
+	return true;
+}
+
+bool InterconnectChannelReceiver::startDataReceivers()
+{
+	// the block thread keeps receiving the first data stream
+	for(auto &&channel: this->data_streams)
+	{
+		std::unique_ptr<SatCarrierReceiver> receiver{new SatCarrierReceiver(name + ".data.receiver." +
+		                                                                    std::to_string(channel->getChannelID()))};
+		receiver->addChannel(channel.get());
+		if(!receiver->start())
+		{
+			LOG(this->log_interconnect, LEVEL_ERROR,
+			    "cannot start the receiver of the data stream %u\n",
+			    channel->getChannelID());
+			return false;
+		}
+		this->data_receivers.push_back(std::move(receiver));
+	}
+	return true;
+}
 
-			message.type = buf->msg_type;
-			message.length = buf->data_len;
+bool InterconnectChannelReceiver::receiveDataStreams(const FileEvent *const event,
+                                                     std::list<rt_msg_t> &messages)
+{
+	for(auto &&receiver: this->data_receivers)
+	{
+		if(*event != receiver->getEventFd())
+		{
+			continue;
+		}
+
+		// the datagrams of a stream come in order, so do the messages of its spots
+		bool status = true;
+		sat_carrier_packet_t received;
+		while(receiver->pop(received))
+		{
+			status &= this->parse(received.packet.data(), received.packet.length(), messages);
+		}
+		return status;
+	}
+	return true;
+}
+
+bool InterconnectChannelReceiver::receiveShm(const FileEvent *const event,
+                                             std::list<rt_msg_t> &messages)
+{
+	// the eventfd counter is only a wake up
+	event->releaseData(event->getData());
 
-			// Deserialize the message
-			switch(to_enum<InternalMessageType>(buf->msg_type))
+	for(auto &&channel: {this->data_shm.get(), this->sig_shm.get()})
+	{
+		if(channel == nullptr || *event != channel->getEventFd())
+		{
+			continue;
+		}
+
+		// the records are parsed in place then released to the sender
+		bool status = true;
+		const unsigned char *data;
+		std::size_t length;
+		while(channel->front(data, length))
+		{
+			status &= this->parse(data, length, messages);
+			channel->pop();
+		}
+		return status;
+	}
+
+	LOG(this->log_interconnect, LEVEL_DEBUG,
+	    "Event does not correspond to interconnect ring\n");
+	return true;
+}
+
+bool InterconnectChannelReceiver::parse(const unsigned char *data, std::size_t size,
+                                        std::list<rt_msg_t> &messages)
+{
+	std::size_t pos = 0;
+
+	LOG(this->log_interconnect, LEVEL_DEBUG,
+	    "%zu bytes of data received\n", size);
+
+	// the messages are read in place, the receive buffers are aligned
+	while(pos < size)
+	{
+		auto header = reinterpret_cast<const interconnect_header_t *>(data + pos);
+		if(size - pos < sizeof(*header) ||
+		   header->length < sizeof(*header) ||
+		   header->length > size - pos)
+		{
+			LOG(this->log_interconnect, LEVEL_ERROR,
+			    "truncated message at offset %zu of %zu bytes of data\n",
+			    pos, size);
+			return false;
+		}
+		if(header->version != interconnect_version)
+		{
+			LOG(this->log_interconnect, LEVEL_ERROR,
+			    "unsupported interconnect version %u (expected %u)\n",
+			    header->version, interconnect_version);
+			return false;
+		}
+
+		if(header->msg_type == interconnect_compressed)
+		{
+			if(!this->decompress(data + pos, header->length, messages))
 			{
-				case InternalMessageType::encap_data:
-				case InternalMessageType::sig:
-					// Deserialize the dvb_frame
-					this->deserialize(buf->msg_data, buf->data_len,
-					                  (DvbFrame **) &message.data);
-					break;
-				case InternalMessageType::saloha:
-					// Deserialize the list of dvb_frames
-					this->deserialize(buf->msg_data, buf->data_len,
-					                  (std::list<DvbFrame *> **) &message.data);
-					break;
-				case InternalMessageType::decap_data:
-					// Deserialize the NetBurst
-					this->deserialize(buf->msg_data, buf->data_len,
-					                  (NetBurst **) &message.data);
-
-					break;
-				default:
-					LOG(this->log_interconnect, LEVEL_ERROR,
-					    "Unknown type of message received\n");
-					status = false;
-					free(buf);
-					continue;
+				return false;
 			}
-			// Free buf
-			free(buf);
+			pos = alignLength(pos + header->length);
+			continue;
+		}
+
+		const unsigned char *records = data + pos + sizeof(*header);
+		std::size_t length = header->length - sizeof(*header);
+		bool status = false;
+		rt_msg_t message;
+		message.type = header->msg_type;
+		message.length = length;
+		message.data = nullptr;
 
-			// Insert the message in the list
-			messages.push_back(message);
+		// Deserialize the message
+		switch(to_enum<InternalMessageType>(header->msg_type))
+		{
+			case InternalMessageType::encap_data:
+			case InternalMessageType::sig:
+				// Deserialize the dvb_frame
+				status = header->nb_records == 1 &&
+				         this->deserialize(records, length, (DvbFrame **) &message.data);
+				break;
+			case InternalMessageType::saloha:
+				// Deserialize the list of dvb_frames
+				status = this->deserialize(records, length, header->nb_records,
+				                           (std::list<DvbFrame *> **) &message.data);
+				break;
+			case InternalMessageType::decap_data:
+				// Deserialize the NetBurst
+				status = this->deserialize(records, length, header->nb_records,
+				                           (NetBurst **) &message.data);
+				break;
+			default:
+				LOG(this->log_interconnect, LEVEL_ERROR,
+				    "Unknown type of message received\n");
+				return false;
 		}
-	} while (ret > 0);
-	return status;
+
+		if(!status)
+		{
+			LOG(this->log_interconnect, LEVEL_ERROR,
+			    "malformed message of type %u received\n", header->msg_type);
+			return false;
+		}
+
+		// Insert the message in the list
+		messages.push_back(message);
+		pos = alignLength(pos + header->length);
+	}
+	return true;
+}
+
+bool InterconnectChannelReceiver::decompress(const unsigned char *data, std::size_t length,
+                                             std::list<rt_msg_t> &messages)
+{
+#if HAVE_LZ4_H
+	constexpr std::size_t header_length = sizeof(interconnect_header_t) + sizeof(interconnect_compressed_t);
+	if(length < header_length)
+	{
+		LOG(this->log_interconnect, LEVEL_ERROR,
+		    "truncated compressed message of %zu bytes\n", length);
+		return false;
+	}
+	auto header = reinterpret_cast<const interconnect_compressed_t *>(data + sizeof(interconnect_header_t));
+	if(header->length > interconnect_stream_max_length)
+	{
+		LOG(this->log_interconnect, LEVEL_ERROR,
+		    "compressed messages of %u bytes are too long\n", header->length);
+		return false;
+	}
+
+	Data buffer;
+	buffer.resize(header->length);
+	int ret = LZ4_decompress_safe(reinterpret_cast<const char *>(data + header_length),
+	                              reinterpret_cast<char *>(&buffer[0]),
+	                              length - header_length, header->length);
+	if(ret < 0 || static_cast<std::size_t>(ret) != header->length)
+	{
+		LOG(this->log_interconnect, LEVEL_ERROR,
+		    "malformed compressed message of %zu bytes\n", length);
+		return false;
+	}
+
+	// the payloads are copied in the messages, the buffer is not kept
+	return this->parse(buffer.data(), buffer.length(), messages);
+#else
+	(void)data;
+	(void)messages;
+	LOG(this->log_interconnect, LEVEL_ERROR,
+	    "compressed message of %zu bytes received but built without LZ4\n", length);
+	return false;
+#endif
 }
 
+/**
+ * @brief Get the record at the beginning of some data and check its length
+ */
 template <typename T>
-void deserializeField(uint8_t *buf, uint32_t &pos, T &data, uint32_t length = sizeof(T))
+const T *readRecord(const unsigned char *data, std::size_t length)
 {
-	memcpy(&data, buf + pos, length);
-	pos += length;
+	if(length < sizeof(T))
+	{
+		return nullptr;
+	}
+	auto record = reinterpret_cast<const T *>(data);
+	if(record->length < sizeof(T) || record->length > length)
+	{
+		return nullptr;
+	}
+	return record;
 }
 
-void InterconnectChannelReceiver::deserialize(unsigned char *data, uint32_t len,
+bool InterconnectChannelReceiver::deserialize(const unsigned char *data, std::size_t length,
                                               DvbFrame **dvb_frame)
 {
-	spot_id_t spot;
-	uint8_t carrier_id;
-	uint32_t pos = 0;
-
-	// Extract SpotId and CarrierId
-	deserializeField(data, pos, spot);
-	deserializeField(data, pos, carrier_id);
+	auto record = readRecord<interconnect_frame_t>(data, length);
+	if(record == nullptr)
+	{
+		return false;
+	}
 
-	// Create object    
-	*dvb_frame = new DvbFrame(data + pos, len - pos);
-	(*dvb_frame)->setCarrierId(carrier_id);
-	(*dvb_frame)->setSpot(spot);
+	// Create object
+	*dvb_frame = new DvbFrame(data + sizeof(*record), record->length - sizeof(*record));
+	(*dvb_frame)->setCarrierId(record->carrier_id);
+	(*dvb_frame)->setSpot(record->spot);
+	return true;
 }
 
 
-void InterconnectChannelReceiver::deserialize(unsigned char *data, uint32_t len,
+bool InterconnectChannelReceiver::deserialize(const unsigned char *data, std::size_t length,
+                                              uint16_t nb_records,
                                               std::list<DvbFrame *> **dvb_frame_list)
 {
-	uint32_t pos = 0;
+	std::size_t pos = 0;
 
 	// Create object
 	(*dvb_frame_list) = new std::list<DvbFrame *>();
 
 	// Iterate and create DvbFrame objects
-	do
+	for(uint16_t index = 0; index < nb_records; ++index)
 	{
-		uint32_t dvb_frame_len;
 		DvbFrame *dvb_frame = nullptr;
 
-		// Read the length of dvb_frame
-		deserializeField(data, pos, dvb_frame_len);
-
-		// Deserialize the new DvbFrame
-		this->deserialize(data + pos, dvb_frame_len, &dvb_frame);
+		if(!this->deserialize(data + pos, pos > length ? 0 : length - pos, &dvb_frame))
+		{
+			for(auto &&frame: **dvb_frame_list)
+			{
+				delete frame;
+			}
+			delete *dvb_frame_list;
+			*dvb_frame_list = nullptr;
+			return false;
+		}
 
 		// Insert the new DvbFrame in the list
 		(*dvb_frame_list)->push_back(dvb_frame);
 
 		// Update position
-		pos += dvb_frame_len;
-
-	} while(pos < len);
-	
-	assert(pos == len);
+		pos = alignLength(pos + sizeof(interconnect_frame_t) + dvb_frame->getTotalLength());
+	}
+	return true;
 }
 
-void InterconnectChannelReceiver::deserialize(uint8_t *buf, uint32_t length,
+bool InterconnectChannelReceiver::deserialize(const unsigned char *data, std::size_t length,
+                                              uint16_t nb_records,
                                               NetBurst **net_burst)
 {
-	uint32_t pos = 0;
+	std::size_t pos = 0;
 	(*net_burst) = new NetBurst{};
 
-	do
+	for(uint16_t index = 0; index < nb_records; ++index)
 	{
-		uint32_t packet_length;
 		NetPacket *packet = nullptr;
 
-		// Read the length of the packet
-		deserializeField(buf, pos, packet_length);
-
 		// Deserialize the packet
-		this->deserialize(buf + pos, packet_length, &packet);
+		if(!this->deserialize(data + pos, pos > length ? 0 : length - pos, &packet))
+		{
+			delete *net_burst;
+			*net_burst = nullptr;
+			return false;
+		}
 
 		// Insert the new packet in the burst
 		(*net_burst)->push_back(std::unique_ptr<NetPacket>{packet});
 
 		// Update position
-		pos += packet_length;
+		pos = alignLength(pos + sizeof(interconnect_packet_t) + packet->getTotalLength());
 	}
-	while (pos < length);
-
-	assert(pos == length);
+	return true;
 }
 
-void InterconnectChannelReceiver::deserialize(uint8_t *buf, uint32_t length,
+bool InterconnectChannelReceiver::deserialize(const unsigned char *data, std::size_t length,
                                               NetPacket **packet)
 {
-	uint32_t pos = 0;
-
-	uint8_t src_id;
-	uint8_t dest_id;
-	uint8_t qos;
-	NET_PROTO type;
-	uint32_t header_length;
-
-	deserializeField(buf, pos, src_id);
-	deserializeField(buf, pos, dest_id);
-	deserializeField(buf, pos, qos);
-	deserializeField(buf, pos, type);
-	deserializeField(buf, pos, header_length);
+	auto record = readRecord<interconnect_packet_t>(data, length);
+	if(record == nullptr)
+	{
+		return false;
+	}
 
-	*packet = new NetPacket{Data{buf + pos, length - pos},
-	                        length - pos,
+	// the payload is copied once from the datagram into the packet buffer
+	*packet = new NetPacket{data + sizeof(*record),
+	                        record->length - sizeof(*record),
 	                        "interconnect",
-	                        type,
-	                        qos,
-	                        src_id,
-	                        dest_id,
-	                        header_length};
+	                        static_cast<NET_PROTO>(record->type),
+	                        record->qos,
+	                        record->src_id,
+	                        record->dst_id,
+	                        record->header_length};
+	return true;
 }
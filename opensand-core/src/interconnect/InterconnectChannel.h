@@ -39,8 +39,16 @@
 
 #include "DelayFifo.h"
 #include "DvbFrame.h"
+#include "InterconnectShm.h"
+#include "InterconnectStream.h"
+#include "SatCarrierReceiver.h"
 #include "UdpChannel.h"
+#include "NetPacket.h"
+
+#include <cstddef>
 #include <list>
+#include <memory>
+#include <vector>
 
 /**
  * @brief high level channel classes that implement some functions
@@ -50,14 +58,87 @@
 class OutputLog;
 class InterconnectConfig;
 class NetBurst;
-class NetPacket;
+class FileEvent;
+class TcpListenEvent;
+template<typename> class Probe;
+
+/// The version of the interconnect wire format, bumped on any layout change
+constexpr uint8_t interconnect_version{1};
+
+/// The alignment of the messages in a datagram and of the records in a message,
+/// it is enough for all the header fields to be read in place
+constexpr std::size_t interconnect_alignment{4};
+
+/// The maximum length of an interconnect datagram,
+/// the UDP channel adds its sequencing counter to it
+constexpr std::size_t interconnect_max_length{MAX_SOCK_SIZE - 1};
+
+/// The maximum length of an interconnect message on a stream,
+/// it still fits in a shared memory ring
+constexpr std::size_t interconnect_stream_max_length{1 << 20};
+
+/// The gap between the ports of the data streams, the stream N uses
+/// the data port + N * interconnect_data_port_stride so the streams of
+/// both directions and the signalling ports do not collide
+constexpr unsigned int interconnect_data_port_stride{4};
+
+/**
+ * @brief The header of an interconnect message, several messages
+ *        can be gathered in a datagram, each one starting aligned
+ *        on interconnect_alignment. Fields are in host byte order.
+ */
+struct __attribute__((__packed__)) interconnect_header_t
+{
+	uint8_t version;      ///< interconnect_version
+	uint8_t msg_type;     ///< the InternalMessageType of the message
+	uint16_t nb_records;  ///< the number of records following the header
+	uint32_t length;      ///< the message length, header included, padding excluded
+};
+static_assert(sizeof(interconnect_header_t) == 8, "unexpected interconnect header layout");
+static_assert(offsetof(interconnect_header_t, length) == 4, "misaligned interconnect header length");
 
-struct __attribute__((__packed__)) interconnect_msg_buffer_t
+/**
+ * @brief The header of a DVB frame record, followed by the frame
+ */
+struct __attribute__((__packed__)) interconnect_frame_t
 {
-	uint32_t data_len; // NOTE: sending data lenght may actually be redundant on UDP
-	uint8_t msg_type;
-	uint8_t msg_data[MAX_SOCK_SIZE];
+	uint32_t length;     ///< the record length, header included, padding excluded
+	uint8_t spot;
+	uint8_t carrier_id;
+	uint16_t reserved;
 };
+static_assert(sizeof(interconnect_frame_t) == 8, "unexpected interconnect frame layout");
+static_assert(sizeof(spot_id_t) == sizeof(interconnect_frame_t::spot), "spot ID does not fit the frame record");
+
+/**
+ * @brief The header of a network packet record, followed by the packet
+ */
+struct __attribute__((__packed__)) interconnect_packet_t
+{
+	uint32_t length;         ///< the record length, header included, padding excluded
+	uint8_t src_id;
+	uint8_t dst_id;
+	uint8_t qos;
+	uint8_t reserved;
+	uint16_t type;           ///< the NET_PROTO of the packet
+	uint16_t header_length;
+};
+static_assert(sizeof(interconnect_packet_t) == 12, "unexpected interconnect packet layout");
+static_assert(offsetof(interconnect_packet_t, type) == 8, "misaligned interconnect packet type");
+static_assert(sizeof(NET_PROTO) == sizeof(interconnect_packet_t::type), "NET_PROTO does not fit the packet record");
+
+/// The message type of the compressed messages, out of the InternalMessageType range
+constexpr uint8_t interconnect_compressed{UINT8_MAX};
+
+/**
+ * @brief The header of a compressed message, following its message header;
+ *        it is followed by the LZ4 block of consecutive aligned messages
+ */
+struct __attribute__((__packed__)) interconnect_compressed_t
+{
+	uint32_t length;  ///< the length of the messages once decompressed
+};
+static_assert(sizeof(interconnect_compressed_t) == 4, "unexpected interconnect compressed layout");
 
 class InterconnectChannel
 {
@@ -76,6 +157,39 @@ protected:
 	                             unsigned int stack,
 	                             unsigned int rmem,
 	                             unsigned int wmem) = 0;
+
+	/**
+	 * @brief Initialize the streams carrying the messages
+	 *        instead of the UdpChannel
+	 * @return false on error, true elsewise.
+	 */
+	virtual bool initStreamChannels(unsigned int data_port,
+	                                unsigned int sig_port,
+	                                std::string remote_addr,
+	                                unsigned int rmem,
+	                                unsigned int wmem) = 0;
+
+	/**
+	 * @brief Create the UdpChannels of the additional data streams,
+	 *        after the UdpChannels
+	 * @param streams  the number of data streams, the data channel included
+	 * @return false on error, true elsewise.
+	 */
+	bool initDataStreams(unsigned int streams,
+	                     unsigned int data_port,
+	                     std::string remote_addr,
+	                     unsigned int stack,
+	                     unsigned int rmem,
+	                     unsigned int wmem,
+	                     bool input);
+
+	/**
+	 * @brief Get the data stream carrying the messages of a spot
+	 * @param spot  the spot of the messages
+	 * @return the data channel of the stream
+	 */
+	UdpChannel *getDataChannel(spot_id_t spot) const;
+
 	/// This blocks name
 	std::string name;
 	/// The interconnect interface IP address
@@ -84,6 +198,9 @@ protected:
 	UdpChannel *data_channel;
 	/// The signalling channel
 	UdpChannel *sig_channel;
+	/// The data channels of the additional streams the data messages are
+	/// spread over by spot, each one with its own sequencing
+	std::vector<std::unique_ptr<UdpChannel>> data_streams;
 	/// Output log
 	std::shared_ptr<OutputLog> log_interconnect;
 };
@@ -106,51 +223,157 @@ protected:
 	                     unsigned int rmem,
 	                     unsigned int wmem) override;
 
+	/**
+	 * @brief Connect to the receiver streams, the messages are then
+	 *        no longer split to fit in datagrams
+	 */
+	bool initStreamChannels(unsigned int data_port,
+	                        unsigned int sig_port,
+	                        std::string remote_addr,
+	                        unsigned int rmem,
+	                        unsigned int wmem) override;
+
 	/**
 	 * @brief Send a RtMessage via the interconnect channel.
+	 *        The message is serialized in one or more interconnect messages
+	 *        and sent when it is due unless the sends are deferred.
 	 * @return false on error, true elsewise.
 	 */
 	bool send(rt_msg_t &message);
 
 	/**
-	 * @brief Sends a message. total_length must contain the data length;
-	 * @param is_sig indicates if the message must be sent via the sig channel
-	 * @param msg the message to send
+	 * @brief Keep the messages in the fifo until flushSends is called
+	 *        so a batch of messages can be gathered in datagrams
+	 */
+	void deferSends();
+
+	/**
+	 * @brief Stop deferring the sends and send the due messages
+	 *        unless they wait for the flush deadline
 	 * @return false on error, true elsewise.
 	 */
-	bool sendBuffer(bool is_sig, const interconnect_msg_buffer_t &msg);
+	bool flushSends();
+
+	/**
+	 * @brief Gather the messages sent without delay until they fill
+	 *        a datagram or the oldest one reaches the flush deadline
+	 * @param flush_deadline  the deadline (ms), 0 to send the messages at once
+	 */
+	void initBatching(double flush_deadline);
+
+	/**
+	 * @brief Check whether a batch started waiting for the flush deadline,
+	 *        the caller then starts its flush timer
+	 * @return true once for each batch, false elsewise.
+	 */
+	bool takeFlushRequest();
+
+	/**
+	 * @brief Compress the datagrams of the data channel when they are
+	 *        sent to a remote host
+	 * @param enabled  whether the compression is enabled
+	 */
+	void initCompression(bool enabled);
 
 private:
 	/**
-	 * @brief Serialize a Dvb Frame to be sent via the
-	 *        interconnect channel.
+	 * @brief Queue a datagram made of consecutive messages on a channel.
+	 *        A single message is queued in place, several messages
+	 *        are gathered in a buffer kept until the channels are flushed.
+	 * @param channel   the channel to send the messages on
+	 * @param messages  the messages to send, their total length does not
+	 *                  exceed the datagram length
+	 * @return false on error, true elsewise.
+	 */
+	bool sendBatch();
+
+	/**
+	 * @brief Compress consecutive messages in a compressed message
+	 * @param data    the messages
+	 * @param length  the messages length
+	 * @return the compressed message, kept until the channels are flushed,
+	 *         nullptr if the messages are not compressed
+	 */
+	const Data *compress(const unsigned char *data, std::size_t length);
+
+	bool queueDatagram(UdpChannel *channel,
+	                   const std::vector<const Data *> &messages);
+
+	/**
+	 * @brief Queue the due messages of a channel in as few datagrams as possible
+	 * @return false on error, true elsewise.
 	 */
-	void serialize(DvbFrame *dvb_frame,
-	               unsigned char *buf, uint32_t &length);
+	bool queueMessages(UdpChannel *channel,
+	                   const std::vector<std::unique_ptr<NetContainer>> &messages);
 
 	/**
-	 * @brief Serialize a list of Dvb Frames to be sent
-	 *        via the interconnect channel.
+	 * @brief Queue the due messages of a channel in its shared memory ring
+	 * @return false on error, true elsewise.
+	 */
+	bool queueMessages(ShmChannelSender &channel,
+	                   const std::vector<std::unique_ptr<NetContainer>> &messages);
+
+	/**
+	 * @brief Queue the due messages of a channel on its stream
+	 * @return false on error, true elsewise.
 	 */
-	void serialize(std::list<DvbFrame *> *dvb_frame_list,
-	               unsigned char *buf, uint32_t &length);
+	bool queueMessages(StreamChannelSender &channel,
+	                   const std::vector<std::unique_ptr<NetContainer>> &messages);
 
 	/**
-	 * @brief Serialize a NetBurst to be sent
-	 *        via the interconnect channel.
+	 * @brief Make room in the current message for a record,
+	 *        closing it and opening a new one if it is full
+	 * @param msg_type       the type of the messages
+	 * @param record_length  the record length without padding
+	 * @param messages       IN/OUT: the closed messages
+	 * @param message        IN/OUT: the current message
+	 * @return false if the record cannot fit in any message, true elsewise.
 	 */
-	void serialize(const NetBurst &net_burst,
-	               unsigned char *buf, uint32_t &length);
+	bool reserveRecord(uint8_t msg_type, std::size_t record_length,
+	                   std::vector<Data> &messages, Data &message);
 
 	/**
-	 * @brief Serialize a NetPacket to be sent
-	 *        via the interconnect channel.
+	 * @brief Serialize a Dvb Frame as a record of the current message
 	 */
-	void serialize(const NetPacket &packet,
-	               unsigned char *buf, uint32_t &length);
+	bool serialize(const DvbFrame &dvb_frame, uint8_t msg_type,
+	               std::vector<Data> &messages, Data &message);
+
+	/**
+	 * @brief Serialize a NetPacket as a record of the current message
+	 */
+	bool serialize(const NetPacket &packet, uint8_t msg_type,
+	               std::vector<Data> &messages, Data &message);
 
 	DelayFifo delay_fifo;
 	time_ms_t delay = 0;
+	/// Whether the due messages are kept until flushSends
+	bool deferred = false;
+	/// The time the messages sent without delay wait for a batch (ms), 0 if disabled
+	double flush_deadline = 0;
+	/// The length of the messages waiting for the flush deadline
+	std::size_t batch_length = 0;
+	/// The time the oldest message of the batch was sent (ms), 0 if no batch
+	double batch_start = 0;
+	/// Whether the flush timer must be started for a new batch
+	bool flush_requested = false;
+	std::shared_ptr<Probe<int>> probe_batch_size;
+	std::shared_ptr<Probe<float>> probe_flush_latency;
+	/// Whether the data datagrams are compressed
+	bool compression = false;
+	/// The number of datagrams left uncompressed after an incompressible one
+	unsigned int compression_skip = 0;
+	std::shared_ptr<Probe<float>> probe_compression_ratio;
+	std::shared_ptr<Probe<int>> probe_compression_time;
+	/// The gathered datagrams queued on the channels until they are flushed
+	std::list<Data> datagrams;
+	/// The shared memory channels used instead of UDP when the receiver is local
+	std::unique_ptr<ShmChannelSender> data_shm;
+	std::unique_ptr<ShmChannelSender> sig_shm;
+	/// The streams used instead of UDP when they are enabled
+	std::unique_ptr<StreamChannelSender> data_stream;
+	std::unique_ptr<StreamChannelSender> sig_stream;
+	/// The maximum length of a message
+	std::size_t max_length = interconnect_max_length;
 };
 
 class InterconnectChannelReceiver: public InterconnectChannel
@@ -169,12 +392,23 @@ protected:
 	                     unsigned int rmem,
 	                     unsigned int wmem) override;
 
+	/**
+	 * @brief Listen for the streams of the sender
+	 */
+	bool initStreamChannels(unsigned int data_port,
+	                        unsigned int sig_port,
+	                        std::string remote_addr,
+	                        unsigned int rmem,
+	                        unsigned int wmem) override;
+
 	/**
 	 * @brief Receive a message from the socket
+	 *
+	 * @param event   The event on the channel socket
+	 * @param packet  OUT: the message buffer, empty if no message is ready
 	 * @return -1 on error, 1 if more packets can be read, 0 if last packet.
 	 */
-	int receiveToBuffer(NetSocketEvent *const event,
-	                    interconnect_msg_buffer_t **buf);
+	int receiveToBuffer(NetSocketEvent *const event, Data &packet);
 
 	/**
 	 * @brief Receive RtMessages
@@ -183,29 +417,110 @@ protected:
 	bool receive(NetSocketEvent *const event,
 	             std::list<rt_msg_t> &messages);
 
+	/**
+	 * @brief Give a shared memory ring to a local sender
+	 * @param event  The event on a rendezvous socket
+	 * @return false on error, true elsewise.
+	 */
+	bool acceptShm(TcpListenEvent *const event);
+
+	/**
+	 * @brief Receive the RtMessages of a shared memory ring
+	 * @param event  The event on the ring eventfd
+	 * @return false on error, true elsewise.
+	 */
+	bool receiveShm(const FileEvent *const event,
+	                std::list<rt_msg_t> &messages);
+
+	/**
+	 * @brief Accept the stream of a sender
+	 * @param event      The event on a stream listening socket
+	 * @param stream_fd  OUT: the connected socket to monitor, -1 if
+	 *                   the event is not on a stream listening socket
+	 * @return false on error, true elsewise.
+	 */
+	bool acceptStream(TcpListenEvent *const event, int &stream_fd);
+
+	/**
+	 * @brief Receive the RtMessages of a stream
+	 * @param event   The event on a stream socket
+	 * @param closed  OUT: whether the sender closed the stream,
+	 *                its event must then be removed
+	 * @return false on error, true elsewise.
+	 */
+	bool receiveStream(const FileEvent *const event,
+	                   std::list<rt_msg_t> &messages,
+	                   bool &closed);
+
+	/**
+	 * @brief Start the workers receiving the additional data streams,
+	 *        after initDataStreams
+	 * @return false on error, true elsewise.
+	 */
+	bool startDataReceivers();
+
+	/**
+	 * @brief Receive the RtMessages of the additional data streams
+	 * @param event  The event signaling the datagrams received by a worker
+	 * @return false on error, true elsewise.
+	 */
+	bool receiveDataStreams(const FileEvent *const event,
+	                        std::list<rt_msg_t> &messages);
+
+	/// The shared memory channels, null if they cannot be created
+	std::unique_ptr<ShmChannelReceiver> data_shm;
+	std::unique_ptr<ShmChannelReceiver> sig_shm;
+	/// The streams, null unless they are enabled
+	std::unique_ptr<StreamChannelReceiver> data_stream;
+	std::unique_ptr<StreamChannelReceiver> sig_stream;
+	/// The workers receiving the additional data streams, one per stream
+	std::vector<std::unique_ptr<SatCarrierReceiver>> data_receivers;
+
 private:
 	/**
-	 * @brief Create a DvbFrame from serialized data
+	 * @brief Parse the messages of a datagram or of a ring record in place
+	 * @param data      the received data
+	 * @param length    the received data length
+	 * @param messages  OUT: the deserialized messages
+	 * @return false on error, true elsewise.
+	 */
+	bool parse(const unsigned char *data, std::size_t length,
+	           std::list<rt_msg_t> &messages);
+
+	/**
+	 * @brief Decompress and parse the messages of a compressed message
+	 * @param data      the compressed message, header included
+	 * @param length    the compressed message length
+	 * @param messages  OUT: the deserialized messages
+	 * @return false on error, true elsewise.
+	 */
+	bool decompress(const unsigned char *data, std::size_t length,
+	                std::list<rt_msg_t> &messages);
+
+	/**
+	 * @brief Create a DvbFrame from a serialized record
 	 */
-	void deserialize(unsigned char *data, uint32_t len,
+	bool deserialize(const unsigned char *data, std::size_t length,
 	                 DvbFrame **dvb_frame);
 
 	/**
-	 * @brief Create a DvbFrame list from serialized data
+	 * @brief Create a DvbFrame list from serialized records
 	 */
-	void deserialize(unsigned char *data, uint32_t len,
+	bool deserialize(const unsigned char *data, std::size_t length,
+	                 uint16_t nb_records,
 	                 std::list<DvbFrame *> **dvb_frame_list);
 
 	/**
-	 * @brief Create a NetBurst from serialized data
+	 * @brief Create a NetBurst from serialized records
 	 */
-	void deserialize(uint8_t *buf, uint32_t length,
+	bool deserialize(const unsigned char *data, std::size_t length,
+	                 uint16_t nb_records,
 	                 NetBurst **net_burst);
 
 	/**
-	 * @brief Create a NetPacket from serialized data
+	 * @brief Create a NetPacket from a serialized record
 	 */
-	void deserialize(uint8_t *buf, uint32_t length,
+	bool deserialize(const unsigned char *data, std::size_t length,
 	                 NetPacket **packet);
 };
 #endif
@@ -0,0 +1,511 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file InterconnectShm.cpp
+ * @brief A shared memory transport for the interconnect channels
+ *        of entities running on the same host
+ * @author Viveris Technologies
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <opensand_output/Output.h>
+
+#include "InterconnectShm.h"
+
+
+/// The magic number of the ring header and of the rendezvous message
+constexpr uint32_t shm_magic{0x4f534952};  // "OSIR"
+/// The version of the ring layout
+constexpr uint32_t shm_version{1};
+/// The offset of the ring data in the shared memory
+constexpr std::size_t shm_data_offset{4096};
+static_assert(sizeof(shm_ring_header_t) <= shm_data_offset, "ring header too large");
+/// The length marking the end of the ring data, the next message is at its beginning
+constexpr uint32_t shm_wrap{UINT32_MAX};
+/// The length of the header preceding each message in the ring
+constexpr std::size_t shm_record_header{8};
+
+/// The period of the connection attempts to the receiver
+constexpr time_ms_t shm_retry_period{1000};
+/// The period of the checks that the receiver is still there
+constexpr time_ms_t shm_check_period{100};
+
+
+/**
+ * @brief Build the abstract unix socket address of a receiver
+ */
+static socklen_t rendezvousAddress(const std::string &path, struct sockaddr_un &addr)
+{
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	// leading zero: abstract namespace, nothing on the filesystem
+	std::size_t length = std::min(path.size(), sizeof(addr.sun_path) - 1);
+	memcpy(addr.sun_path + 1, path.data(), length);
+	return offsetof(struct sockaddr_un, sun_path) + 1 + length;
+}
+
+static std::string rendezvousPath(const std::string &addr, unsigned int port)
+{
+	return "opensand.interconnect." + addr + ":" + std::to_string(port);
+}
+
+
+/*
+ * SHM_RING
+ */
+ShmRing::ShmRing():
+	mem_fd{-1},
+	event_fd{-1},
+	header{nullptr},
+	data{nullptr},
+	write_pos{0},
+	read_pos{0},
+	next_read_pos{0}
+{
+}
+
+ShmRing::~ShmRing()
+{
+	if(this->header)
+	{
+		munmap(this->header, shm_data_offset + capacity);
+	}
+	if(this->mem_fd >= 0)
+	{
+		close(this->mem_fd);
+	}
+	if(this->event_fd >= 0)
+	{
+		close(this->event_fd);
+	}
+}
+
+bool ShmRing::map()
+{
+	void *memory = mmap(nullptr, shm_data_offset + capacity,
+	                    PROT_READ | PROT_WRITE, MAP_SHARED, this->mem_fd, 0);
+	if(memory == MAP_FAILED)
+	{
+		return false;
+	}
+	this->header = static_cast<shm_ring_header_t *>(memory);
+	this->data = static_cast<unsigned char *>(memory) + shm_data_offset;
+	return true;
+}
+
+bool ShmRing::create()
+{
+	this->mem_fd = memfd_create("opensand-interconnect", MFD_CLOEXEC);
+	if(this->mem_fd < 0 ||
+	   ftruncate(this->mem_fd, shm_data_offset + capacity) != 0 ||
+	   !this->map())
+	{
+		return false;
+	}
+
+	this->header = new (this->header) shm_ring_header_t{};
+	this->header->magic = shm_magic;
+	this->header->version = shm_version;
+	this->header->capacity = capacity;
+
+	this->event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	return this->event_fd >= 0;
+}
+
+bool ShmRing::attach(int mem_fd, int event_fd)
+{
+	struct stat info;
+
+	this->mem_fd = mem_fd;
+	this->event_fd = event_fd;
+	if(fstat(this->mem_fd, &info) != 0 ||
+	   static_cast<std::size_t>(info.st_size) != shm_data_offset + capacity ||
+	   !this->map())
+	{
+		return false;
+	}
+	if(this->header->magic != shm_magic ||
+	   this->header->version != shm_version ||
+	   this->header->capacity != capacity)
+	{
+		return false;
+	}
+
+	// a previous producer may have left messages
+	this->write_pos = this->header->head.load(std::memory_order_relaxed);
+	return true;
+}
+
+std::size_t ShmRing::recordLength(std::size_t length)
+{
+	return (shm_record_header + length + 7) & ~std::size_t{7};
+}
+
+bool ShmRing::push(const unsigned char *message, std::size_t length)
+{
+	std::size_t record = recordLength(length);
+	std::size_t pos = this->write_pos % capacity;
+	std::size_t contiguous = capacity - pos;
+	std::size_t needed = record > contiguous ? contiguous + record : record;
+
+	uint64_t tail = this->header->tail.load(std::memory_order_acquire);
+	if(this->write_pos + needed - tail > capacity)
+	{
+		return false;
+	}
+
+	if(record > contiguous)
+	{
+		uint32_t wrap = shm_wrap;
+		memcpy(this->data + pos, &wrap, sizeof(wrap));
+		this->write_pos += contiguous;
+		pos = 0;
+	}
+
+	uint32_t message_length = length;
+	memcpy(this->data + pos, &message_length, sizeof(message_length));
+	memcpy(this->data + pos + shm_record_header, message, length);
+	this->write_pos += record;
+	return true;
+}
+
+bool ShmRing::publish()
+{
+	if(this->header->head.load(std::memory_order_relaxed) == this->write_pos)
+	{
+		return true;
+	}
+	this->header->head.store(this->write_pos, std::memory_order_release);
+
+	uint64_t count = 1;
+	return write(this->event_fd, &count, sizeof(count)) == sizeof(count) || errno == EAGAIN;
+}
+
+bool ShmRing::front(const unsigned char *&message, std::size_t &length)
+{
+	uint64_t head = this->header->head.load(std::memory_order_acquire);
+
+	while(this->read_pos != head)
+	{
+		std::size_t pos = this->read_pos % capacity;
+		uint32_t message_length;
+		memcpy(&message_length, this->data + pos, sizeof(message_length));
+		if(message_length == shm_wrap)
+		{
+			this->read_pos += capacity - pos;
+			continue;
+		}
+
+		std::size_t record = recordLength(message_length);
+		if(record > capacity - pos || this->read_pos + record > head)
+		{
+			// corrupted ring, drop everything published so far
+			this->read_pos = head;
+			this->header->tail.store(head, std::memory_order_release);
+			return false;
+		}
+
+		message = this->data + pos + shm_record_header;
+		length = message_length;
+		this->next_read_pos = this->read_pos + record;
+		return true;
+	}
+	return false;
+}
+
+void ShmRing::pop()
+{
+	this->read_pos = this->next_read_pos;
+	this->header->tail.store(this->read_pos, std::memory_order_release);
+}
+
+
+/*
+ * SHM_CHANNEL_RECEIVER
+ */
+ShmChannelReceiver::ShmChannelReceiver(const std::string &name,
+                                       const std::string &addr,
+                                       unsigned int port):
+	name{name},
+	path{rendezvousPath(addr, port)},
+	listen_fd{-1},
+	client_fd{-1},
+	ring{}
+{
+	this->log = Output::Get()->registerLog(LEVEL_WARNING, name);
+}
+
+ShmChannelReceiver::~ShmChannelReceiver()
+{
+	if(this->listen_fd >= 0)
+	{
+		close(this->listen_fd);
+	}
+	if(this->client_fd >= 0)
+	{
+		close(this->client_fd);
+	}
+}
+
+bool ShmChannelReceiver::listen()
+{
+	struct sockaddr_un addr;
+	socklen_t addr_length = rendezvousAddress(this->path, addr);
+
+	if(!this->ring.create())
+	{
+		LOG(this->log, LEVEL_WARNING,
+		    "cannot create the shared memory ring: %s\n", strerror(errno));
+		return false;
+	}
+
+	this->listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if(this->listen_fd < 0 ||
+	   bind(this->listen_fd, reinterpret_cast<struct sockaddr *>(&addr), addr_length) != 0 ||
+	   ::listen(this->listen_fd, 1) != 0)
+	{
+		LOG(this->log, LEVEL_WARNING,
+		    "cannot listen on the shared memory rendezvous %s: %s\n",
+		    this->path.c_str(), strerror(errno));
+		return false;
+	}
+
+	LOG(this->log, LEVEL_INFO,
+	    "shared memory rendezvous listening on %s\n", this->path.c_str());
+	return true;
+}
+
+bool ShmChannelReceiver::accept(int client_fd)
+{
+	uint32_t magic = shm_magic;
+	struct iovec iov = {&magic, sizeof(magic)};
+	int fds[2] = {this->ring.getMemFd(), this->ring.getEventFd()};
+	alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(fds))];
+	struct msghdr msg{};
+
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+	if(sendmsg(client_fd, &msg, MSG_NOSIGNAL) != sizeof(magic))
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "cannot give the shared memory ring to the sender: %s\n",
+		    strerror(errno));
+		close(client_fd);
+		return false;
+	}
+
+	// keep the connection, the sender watches it to know we are still there
+	if(this->client_fd >= 0)
+	{
+		close(this->client_fd);
+	}
+	this->client_fd = client_fd;
+	LOG(this->log, LEVEL_NOTICE,
+	    "local sender connected on %s, using shared memory\n", this->path.c_str());
+	return true;
+}
+
+bool ShmChannelReceiver::front(const unsigned char *&data, std::size_t &length)
+{
+	return this->ring.front(data, length);
+}
+
+void ShmChannelReceiver::pop()
+{
+	this->ring.pop();
+}
+
+
+/*
+ * SHM_CHANNEL_SENDER
+ */
+ShmChannelSender::ShmChannelSender(const std::string &name,
+                                   const std::string &addr,
+                                   unsigned int port):
+	name{name},
+	path{rendezvousPath(addr, port)},
+	socket_fd{-1},
+	ring{nullptr},
+	next_check{0}
+{
+	this->log = Output::Get()->registerLog(LEVEL_WARNING, name);
+}
+
+ShmChannelSender::~ShmChannelSender()
+{
+	if(this->socket_fd >= 0)
+	{
+		close(this->socket_fd);
+	}
+}
+
+void ShmChannelSender::reset()
+{
+	this->ring.reset();
+	if(this->socket_fd >= 0)
+	{
+		close(this->socket_fd);
+		this->socket_fd = -1;
+	}
+}
+
+bool ShmChannelSender::connect()
+{
+	time_ms_t now = getCurrentTime();
+
+	if(this->ring)
+	{
+		if(now < this->next_check)
+		{
+			return true;
+		}
+		this->next_check = now + shm_check_period;
+
+		char byte;
+		ssize_t ret = recv(this->socket_fd, &byte, sizeof(byte), MSG_DONTWAIT | MSG_PEEK);
+		if(ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			return true;
+		}
+		LOG(this->log, LEVEL_WARNING,
+		    "local receiver on %s left, back to UDP\n", this->path.c_str());
+		this->reset();
+		return false;
+	}
+
+	if(this->socket_fd < 0)
+	{
+		struct sockaddr_un addr;
+		socklen_t addr_length = rendezvousAddress(this->path, addr);
+
+		if(now < this->next_check)
+		{
+			return false;
+		}
+		this->next_check = now + shm_retry_period;
+
+		this->socket_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if(this->socket_fd < 0 ||
+		   ::connect(this->socket_fd, reinterpret_cast<struct sockaddr *>(&addr), addr_length) != 0)
+		{
+			// no receiver on this host (yet)
+			this->reset();
+			return false;
+		}
+	}
+
+	// wait for the receiver to give its ring
+	uint32_t magic = 0;
+	struct iovec iov = {&magic, sizeof(magic)};
+	int fds[2] = {-1, -1};
+	alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(fds))];
+	struct msghdr msg{};
+
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	ssize_t ret = recvmsg(this->socket_fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+	if(ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+	{
+		return false;
+	}
+
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	if(ret == sizeof(magic) && cmsg != nullptr &&
+	   cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+	   cmsg->cmsg_len == CMSG_LEN(sizeof(fds)))
+	{
+		memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+	}
+	if(magic != shm_magic || fds[0] < 0 || fds[1] < 0)
+	{
+		LOG(this->log, LEVEL_WARNING,
+		    "unexpected answer from the local receiver on %s\n", this->path.c_str());
+		if(fds[0] >= 0)
+		{
+			close(fds[0]);
+			close(fds[1]);
+		}
+		this->reset();
+		return false;
+	}
+
+	this->ring.reset(new ShmRing());
+	if(!this->ring->attach(fds[0], fds[1]))
+	{
+		LOG(this->log, LEVEL_WARNING,
+		    "cannot map the shared memory ring of %s\n", this->path.c_str());
+		this->reset();
+		return false;
+	}
+
+	this->next_check = now + shm_check_period;
+	LOG(this->log, LEVEL_NOTICE,
+	    "local receiver found on %s, using shared memory\n", this->path.c_str());
+	return true;
+}
+
+bool ShmChannelSender::queue(const unsigned char *data, std::size_t length)
+{
+	if(!this->ring->push(data, length))
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "shared memory ring full, message of %zu bytes dropped\n", length);
+		return false;
+	}
+	return true;
+}
+
+bool ShmChannelSender::flush()
+{
+	return this->ring->publish();
+}
@@ -0,0 +1,278 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file InterconnectShm.h
+ * @brief A shared memory transport for the interconnect channels
+ *        of entities running on the same host
+ * @author Viveris Technologies
+ */
+
+#ifndef INTERCONNECT_SHM_H
+#define INTERCONNECT_SHM_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "OpenSandCore.h"
+
+
+class OutputLog;
+
+
+/**
+ * @brief The header at the beginning of the shared memory,
+ *        producer and consumer counters are on their own cache line
+ */
+struct shm_ring_header_t
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t capacity;
+	alignas(64) std::atomic<uint64_t> head;  ///< bytes written by the producer
+	alignas(64) std::atomic<uint64_t> tail;  ///< bytes released by the consumer
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "the ring counters must be lock free to be shared between processes");
+
+
+/**
+ * @class ShmRing
+ * @brief A single producer, single consumer ring of messages in a memfd
+ *        shared between two processes, with an eventfd to wake up
+ *        the consumer.
+ *
+ * Each message is stored contiguously behind its length, aligned
+ * on 8 bytes; a message that would cross the end of the ring is
+ * stored at its beginning instead so it can be read in place.
+ */
+class ShmRing
+{
+public:
+	/// The size of the ring data
+	static constexpr std::size_t capacity = 1 << 22;
+
+	ShmRing();
+	~ShmRing();
+
+	ShmRing(const ShmRing &) = delete;
+	ShmRing &operator=(const ShmRing &) = delete;
+
+	/**
+	 * @brief Create the shared memory and the eventfd
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool create();
+
+	/**
+	 * @brief Map a ring created by another process
+	 *
+	 * @param mem_fd    The memfd of the ring, the ring takes its ownership
+	 * @param event_fd  The eventfd of the ring, the ring takes its ownership
+	 * @return true on success, false otherwise
+	 */
+	bool attach(int mem_fd, int event_fd);
+
+	/**
+	 * @brief Write a message in the ring, it is visible to the
+	 *        consumer at the next publish
+	 *
+	 * @param data    The message
+	 * @param length  The message length
+	 * @return true on success, false if the ring is full
+	 */
+	bool push(const unsigned char *data, std::size_t length);
+
+	/**
+	 * @brief Make the pushed messages visible and wake up the consumer
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool publish();
+
+	/**
+	 * @brief Get the oldest message of the ring, in place
+	 *
+	 * @param data    OUT: the message
+	 * @param length  OUT: the message length
+	 * @return true if a message is available, false otherwise
+	 */
+	bool front(const unsigned char *&data, std::size_t &length);
+
+	/**
+	 * @brief Release the message returned by front
+	 */
+	void pop();
+
+	int getMemFd() const { return this->mem_fd; };
+	int getEventFd() const { return this->event_fd; };
+
+private:
+	/**
+	 * @brief Map the ring memory
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool map();
+
+	/// The length reserved for a message in the ring
+	static std::size_t recordLength(std::size_t length);
+
+	int mem_fd;
+	int event_fd;
+	shm_ring_header_t *header;
+	unsigned char *data;
+
+	/// The producer position, published in the header by publish
+	uint64_t write_pos;
+	/// The consumer position of the message returned by front
+	uint64_t read_pos;
+	/// The position following the message returned by front
+	uint64_t next_read_pos;
+};
+
+
+/**
+ * @class ShmChannelReceiver
+ * @brief The receiving side of a shared memory interconnect channel
+ *
+ * The receiver owns the ring and listens on an abstract unix socket
+ * named after its interconnect address and port; as abstract sockets
+ * are local to a network namespace, only a sender running on the same
+ * host can reach it and get the ring file descriptors.
+ */
+class ShmChannelReceiver
+{
+public:
+	ShmChannelReceiver(const std::string &name,
+	                   const std::string &addr,
+	                   unsigned int port);
+	~ShmChannelReceiver();
+
+	/**
+	 * @brief Create the ring and the rendezvous socket
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool listen();
+
+	/**
+	 * @brief Give the ring to a sender that connected on the rendezvous socket
+	 *
+	 * @param client_fd  The connected socket, the channel takes its ownership
+	 * @return true on success, false otherwise
+	 */
+	bool accept(int client_fd);
+
+	/**
+	 * @brief Get the oldest message received, in place
+	 *
+	 * @param data    OUT: the message
+	 * @param length  OUT: the message length
+	 * @return true if a message is available, false otherwise
+	 */
+	bool front(const unsigned char *&data, std::size_t &length);
+
+	/**
+	 * @brief Release the message returned by front
+	 */
+	void pop();
+
+	int getListenFd() const { return this->listen_fd; };
+	int getEventFd() const { return this->ring.getEventFd(); };
+
+private:
+	std::string name;
+	std::string path;
+	int listen_fd;
+	int client_fd;
+	ShmRing ring;
+	std::shared_ptr<OutputLog> log;
+};
+
+
+/**
+ * @class ShmChannelSender
+ * @brief The sending side of a shared memory interconnect channel
+ *
+ * The sender periodically tries to reach the receiver rendezvous
+ * socket and uses the ring once it got it, the caller keeps using
+ * its UDP channel meanwhile.
+ */
+class ShmChannelSender
+{
+public:
+	ShmChannelSender(const std::string &name,
+	                 const std::string &addr,
+	                 unsigned int port);
+	~ShmChannelSender();
+
+	/**
+	 * @brief Make progress on the connection to the receiver
+	 *
+	 * @return true if the ring can be used, false otherwise
+	 */
+	bool connect();
+
+	/**
+	 * @brief Write a message in the ring
+	 *
+	 * @param data    The message
+	 * @param length  The message length
+	 * @return true on success, false otherwise
+	 */
+	bool queue(const unsigned char *data, std::size_t length);
+
+	/**
+	 * @brief Make the queued messages visible to the receiver
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool flush();
+
+private:
+	/**
+	 * @brief Forget the receiver after an error or a disconnection
+	 */
+	void reset();
+
+	std::string name;
+	std::string path;
+	int socket_fd;
+	std::unique_ptr<ShmRing> ring;
+	/// The next time a connection can be tried or the receiver checked
+	time_ms_t next_check;
+	std::shared_ptr<OutputLog> log;
+};
+
+
+#endif
@@ -0,0 +1,486 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file InterconnectStream.cpp
+ * @brief A TCP stream transport for the interconnect channels,
+ *        the messages are not limited to the length of a datagram
+ * @author Viveris Technologies
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <opensand_output/Output.h>
+
+#include "InterconnectChannel.h"
+#include "InterconnectStream.h"
+
+
+/// The period of the connection attempts to the receiver
+constexpr time_ms_t stream_retry_period{1000};
+/// The maximum number of bytes kept when the socket cannot take them,
+/// the connection is reset beyond
+constexpr std::size_t stream_pending_max{1 << 24};
+/// The padding written after the messages
+static const unsigned char stream_padding[interconnect_alignment] = {};
+
+
+/**
+ * @brief Create a TCP socket bound or connected to an address
+ *
+ * @param addr     The numeric address
+ * @param port     The port
+ * @param passive  Whether the socket listens on the address
+ * @return the socket, -1 on error
+ */
+static int openSocket(const std::string &addr, unsigned int port, bool passive)
+{
+	struct addrinfo hints{};
+	struct addrinfo *info = nullptr;
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV | (passive ? AI_PASSIVE : 0);
+	if(getaddrinfo(addr.c_str(), std::to_string(port).c_str(), &hints, &info) != 0)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	int fd = socket(info->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	int one = 1;
+	int ret = -1;
+	if(fd >= 0 && passive)
+	{
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+		ret = bind(fd, info->ai_addr, info->ai_addrlen);
+		if(ret == 0)
+		{
+			ret = ::listen(fd, 4);
+		}
+	}
+	else if(fd >= 0)
+	{
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		ret = ::connect(fd, info->ai_addr, info->ai_addrlen);
+		if(ret != 0 && errno == EINPROGRESS)
+		{
+			ret = 0;
+		}
+	}
+	freeaddrinfo(info);
+
+	if(fd >= 0 && ret != 0)
+	{
+		int error = errno;
+		close(fd);
+		errno = error;
+		return -1;
+	}
+	return fd;
+}
+
+
+/**
+ * @brief Get the length of the whole messages at the beginning of a stream
+ *
+ * @param data      The stream
+ * @param length    The stream length
+ * @param complete  OUT: the length of the whole messages, padding included
+ * @return false if a message header is invalid, true otherwise
+ */
+static bool completeLength(const unsigned char *data, std::size_t length, std::size_t &complete)
+{
+	complete = 0;
+	while(length - complete >= sizeof(interconnect_header_t))
+	{
+		auto header = reinterpret_cast<const interconnect_header_t *>(data + complete);
+		if(header->length < sizeof(interconnect_header_t) ||
+		   header->length > interconnect_stream_max_length)
+		{
+			return false;
+		}
+		std::size_t next = complete + header->length;
+		next = (next + interconnect_alignment - 1) & ~(interconnect_alignment - 1);
+		if(next > length)
+		{
+			break;
+		}
+		complete = next;
+	}
+	return true;
+}
+
+
+/*
+ * STREAM_CHANNEL_RECEIVER
+ */
+StreamChannelReceiver::StreamChannelReceiver(const std::string &name,
+                                             const std::string &addr,
+                                             unsigned int port,
+                                             unsigned int rmem):
+	name{name},
+	addr{addr},
+	port{port},
+	rmem{rmem},
+	listen_fd{-1},
+	connections{}
+{
+	this->log = Output::Get()->registerLog(LEVEL_WARNING, name);
+}
+
+StreamChannelReceiver::~StreamChannelReceiver()
+{
+	if(this->listen_fd >= 0)
+	{
+		close(this->listen_fd);
+	}
+}
+
+bool StreamChannelReceiver::listen()
+{
+	this->listen_fd = openSocket(this->addr, this->port, true);
+	if(this->listen_fd < 0)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "cannot listen on %s:%u: %s\n",
+		    this->addr.c_str(), this->port, strerror(errno));
+		return false;
+	}
+
+	LOG(this->log, LEVEL_INFO,
+	    "stream listening on %s:%u\n", this->addr.c_str(), this->port);
+	return true;
+}
+
+bool StreamChannelReceiver::accept(int client_fd)
+{
+	int rmem = this->rmem;
+	if(setsockopt(client_fd, SOL_SOCKET, SO_RCVBUF, &rmem, sizeof(rmem)) != 0)
+	{
+		LOG(this->log, LEVEL_WARNING,
+		    "cannot set the receive buffer of the stream: %s\n", strerror(errno));
+	}
+
+	auto &connection = this->connections[client_fd];
+	connection.buffer.clear();
+	connection.consumed = 0;
+	LOG(this->log, LEVEL_NOTICE,
+	    "sender connected on %s:%u, using a stream\n", this->addr.c_str(), this->port);
+	return true;
+}
+
+void StreamChannelReceiver::release(int fd)
+{
+	auto it = this->connections.find(fd);
+	if(it == this->connections.end())
+	{
+		return;
+	}
+	if(it->second.buffer.length() > it->second.consumed)
+	{
+		LOG(this->log, LEVEL_WARNING,
+		    "stream closed with %zu bytes of an incomplete message\n",
+		    it->second.buffer.length() - it->second.consumed);
+	}
+	this->connections.erase(it);
+	LOG(this->log, LEVEL_NOTICE,
+	    "sender disconnected from %s:%u\n", this->addr.c_str(), this->port);
+}
+
+bool StreamChannelReceiver::isConnection(int fd) const
+{
+	return this->connections.find(fd) != this->connections.end();
+}
+
+bool StreamChannelReceiver::receive(int fd, const unsigned char *data, std::size_t length,
+                                    const unsigned char *&messages, std::size_t &messages_length)
+{
+	auto &connection = this->connections[fd];
+	std::size_t complete;
+
+	// drop the messages given by the previous call
+	connection.buffer.erase(0, connection.consumed);
+	connection.consumed = 0;
+
+	if(connection.buffer.empty())
+	{
+		// the whole messages are read in place, only the end is kept
+		if(!completeLength(data, length, complete))
+		{
+			LOG(this->log, LEVEL_ERROR, "invalid message header in the stream\n");
+			return false;
+		}
+		connection.buffer.append(data + complete, length - complete);
+		messages = data;
+		messages_length = complete;
+		return true;
+	}
+
+	connection.buffer.append(data, length);
+	if(!completeLength(connection.buffer.data(), connection.buffer.length(), complete))
+	{
+		LOG(this->log, LEVEL_ERROR, "invalid message header in the stream\n");
+		return false;
+	}
+	messages = connection.buffer.data();
+	messages_length = complete;
+	connection.consumed = complete;
+	return true;
+}
+
+
+/*
+ * STREAM_CHANNEL_SENDER
+ */
+StreamChannelSender::StreamChannelSender(const std::string &name,
+                                         const std::string &addr,
+                                         unsigned int port,
+                                         unsigned int wmem):
+	name{name},
+	addr{addr},
+	port{port},
+	wmem{wmem},
+	socket_fd{-1},
+	connected{false},
+	iovecs{},
+	queued_length{0},
+	pending{},
+	next_retry{0}
+{
+	this->log = Output::Get()->registerLog(LEVEL_WARNING, name);
+}
+
+StreamChannelSender::~StreamChannelSender()
+{
+	if(this->socket_fd >= 0)
+	{
+		close(this->socket_fd);
+	}
+}
+
+void StreamChannelSender::reset()
+{
+	if(this->socket_fd >= 0)
+	{
+		close(this->socket_fd);
+		this->socket_fd = -1;
+	}
+	this->connected = false;
+	this->iovecs.clear();
+	this->queued_length = 0;
+	this->pending.clear();
+}
+
+bool StreamChannelSender::connect()
+{
+	if(this->connected)
+	{
+		return true;
+	}
+
+	time_ms_t now = getCurrentTime();
+	if(this->socket_fd < 0)
+	{
+		if(now < this->next_retry)
+		{
+			return false;
+		}
+		this->next_retry = now + stream_retry_period;
+
+		this->socket_fd = openSocket(this->addr, this->port, false);
+		if(this->socket_fd < 0)
+		{
+			LOG(this->log, LEVEL_DEBUG,
+			    "cannot connect to %s:%u: %s\n",
+			    this->addr.c_str(), this->port, strerror(errno));
+			return false;
+		}
+		int wmem = this->wmem;
+		setsockopt(this->socket_fd, SOL_SOCKET, SO_SNDBUF, &wmem, sizeof(wmem));
+	}
+
+	// the connection is established once the socket is writable
+	struct pollfd pfd = {this->socket_fd, POLLOUT, 0};
+	if(poll(&pfd, 1, 0) == 0)
+	{
+		if(now >= this->next_retry)
+		{
+			// no answer, try again
+			this->reset();
+		}
+		return false;
+	}
+
+	int error = 0;
+	socklen_t error_length = sizeof(error);
+	if(getsockopt(this->socket_fd, SOL_SOCKET, SO_ERROR, &error, &error_length) != 0 ||
+	   error != 0)
+	{
+		LOG(this->log, LEVEL_DEBUG,
+		    "cannot connect to %s:%u: %s\n",
+		    this->addr.c_str(), this->port, strerror(error));
+		this->reset();
+		return false;
+	}
+
+	this->connected = true;
+	LOG(this->log, LEVEL_NOTICE,
+	    "connected to %s:%u, using a stream\n", this->addr.c_str(), this->port);
+	return true;
+}
+
+bool StreamChannelSender::queue(const unsigned char *data, std::size_t length)
+{
+	std::size_t padding = (interconnect_alignment - length % interconnect_alignment) % interconnect_alignment;
+
+	this->iovecs.push_back({const_cast<unsigned char *>(data), length});
+	if(padding > 0)
+	{
+		this->iovecs.push_back({const_cast<unsigned char *>(stream_padding), padding});
+	}
+	this->queued_length += length + padding;
+	return true;
+}
+
+ssize_t StreamChannelSender::write(const struct iovec *iov, std::size_t count)
+{
+	std::size_t written = 0;
+
+	while(count > 0)
+	{
+		struct msghdr msg{};
+		msg.msg_iov = const_cast<struct iovec *>(iov);
+		msg.msg_iovlen = std::min<std::size_t>(count, IOV_MAX);
+
+		ssize_t ret = sendmsg(this->socket_fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if(ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			break;
+		}
+		if(ret < 0)
+		{
+			return -1;
+		}
+		written += ret;
+
+		// skip the buffers written, the last one may be partial
+		std::size_t chunk = 0;
+		std::size_t index = 0;
+		while(index < msg.msg_iovlen && chunk + iov[index].iov_len <= (std::size_t)ret)
+		{
+			chunk += iov[index].iov_len;
+			index++;
+		}
+		if(index < msg.msg_iovlen)
+		{
+			// the socket is full
+			break;
+		}
+		iov += index;
+		count -= index;
+	}
+	return written;
+}
+
+bool StreamChannelSender::flush()
+{
+	if(!this->connected)
+	{
+		this->iovecs.clear();
+		this->queued_length = 0;
+		return true;
+	}
+
+	// the bytes left by the previous flush go first
+	if(!this->pending.empty())
+	{
+		struct iovec iov = {this->pending.data(), this->pending.length()};
+		ssize_t ret = this->write(&iov, 1);
+		if(ret < 0)
+		{
+			LOG(this->log, LEVEL_WARNING,
+			    "connection to %s:%u lost: %s\n",
+			    this->addr.c_str(), this->port, strerror(errno));
+			this->reset();
+			return false;
+		}
+		this->pending.erase(0, ret);
+	}
+
+	std::size_t written = 0;
+	if(this->pending.empty() && !this->iovecs.empty())
+	{
+		ssize_t ret = this->write(this->iovecs.data(), this->iovecs.size());
+		if(ret < 0)
+		{
+			LOG(this->log, LEVEL_WARNING,
+			    "connection to %s:%u lost: %s\n",
+			    this->addr.c_str(), this->port, strerror(errno));
+			this->reset();
+			return false;
+		}
+		written = ret;
+	}
+
+	// keep what the socket could not take, the messages are released after the flush
+	if(written < this->queued_length)
+	{
+		if(this->pending.length() + this->queued_length - written > stream_pending_max)
+		{
+			LOG(this->log, LEVEL_ERROR,
+			    "receiver on %s:%u does not read its stream, connection reset\n",
+			    this->addr.c_str(), this->port);
+			this->reset();
+			return false;
+		}
+		for(auto &&iov: this->iovecs)
+		{
+			if(written >= iov.iov_len)
+			{
+				written -= iov.iov_len;
+				continue;
+			}
+			this->pending.append(static_cast<const unsigned char *>(iov.iov_base) + written,
+			                     iov.iov_len - written);
+			written = 0;
+		}
+	}
+	this->iovecs.clear();
+	this->queued_length = 0;
+	return true;
+}
@@ -0,0 +1,223 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file InterconnectStream.h
+ * @brief A TCP stream transport for the interconnect channels,
+ *        the messages are not limited to the length of a datagram
+ * @author Viveris Technologies
+ */
+
+#ifndef INTERCONNECT_STREAM_H
+#define INTERCONNECT_STREAM_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/uio.h>
+
+#include "Data.h"
+#include "OpenSandCore.h"
+
+
+class OutputLog;
+
+
+/**
+ * @class StreamChannelReceiver
+ * @brief The receiving side of a stream interconnect channel
+ *
+ * The receiver listens on the TCP port of its UDP channel; the
+ * messages are written back to back on the stream, each one padded
+ * to the interconnect alignment, and are gathered here until they
+ * are complete.
+ */
+class StreamChannelReceiver
+{
+public:
+	/// The maximum length read on a connection at once
+	static constexpr std::size_t read_length = 1 << 16;
+
+	StreamChannelReceiver(const std::string &name,
+	                      const std::string &addr,
+	                      unsigned int port,
+	                      unsigned int rmem);
+	~StreamChannelReceiver();
+
+	StreamChannelReceiver(const StreamChannelReceiver &) = delete;
+	StreamChannelReceiver &operator=(const StreamChannelReceiver &) = delete;
+
+	/**
+	 * @brief Create the listening socket
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool listen();
+
+	/**
+	 * @brief Start reading the stream of a sender that connected
+	 *
+	 * @param client_fd  The connected socket, its event keeps its ownership
+	 * @return true on success, false otherwise
+	 */
+	bool accept(int client_fd);
+
+	/**
+	 * @brief Forget a connection closed by the sender
+	 *
+	 * @param fd  The connected socket
+	 */
+	void release(int fd);
+
+	/**
+	 * @brief Check whether a socket is a connection of this channel
+	 *
+	 * @param fd  The socket
+	 * @return true if the socket was accepted by this channel
+	 */
+	bool isConnection(int fd) const;
+
+	/**
+	 * @brief Gather the data read on a connection in whole messages
+	 *
+	 * The complete messages are given in place, in the read data if
+	 * no partial message was pending on the connection, in the
+	 * connection buffer otherwise; they remain valid until the next
+	 * call for this connection.
+	 *
+	 * @param fd               The connected socket
+	 * @param data             The data read
+	 * @param length           The data length
+	 * @param messages         OUT: the complete messages
+	 * @param messages_length  OUT: the length of the complete messages, padding included
+	 * @return true on success, false if the stream is malformed
+	 */
+	bool receive(int fd, const unsigned char *data, std::size_t length,
+	             const unsigned char *&messages, std::size_t &messages_length);
+
+	int getListenFd() const { return this->listen_fd; };
+
+private:
+	/// The bytes of a connection that do not make a whole message yet
+	struct connection_t
+	{
+		Data buffer;
+		/// The length of the messages given in place by the last receive
+		std::size_t consumed;
+	};
+
+	std::string name;
+	std::string addr;
+	unsigned int port;
+	unsigned int rmem;
+	int listen_fd;
+	std::map<int, connection_t> connections;
+
+	std::shared_ptr<OutputLog> log;
+};
+
+
+/**
+ * @class StreamChannelSender
+ * @brief The sending side of a stream interconnect channel
+ *
+ * The messages are queued in place and written with a single
+ * scatter-gather call; the bytes the socket cannot take are kept
+ * and written first on the next flush so the stream stays whole.
+ */
+class StreamChannelSender
+{
+public:
+	StreamChannelSender(const std::string &name,
+	                    const std::string &addr,
+	                    unsigned int port,
+	                    unsigned int wmem);
+	~StreamChannelSender();
+
+	StreamChannelSender(const StreamChannelSender &) = delete;
+	StreamChannelSender &operator=(const StreamChannelSender &) = delete;
+
+	/**
+	 * @brief Make progress on the connection to the receiver
+	 *
+	 * @return true if the stream can be used, false otherwise
+	 */
+	bool connect();
+
+	/**
+	 * @brief Queue a message, it must remain valid until the flush
+	 *
+	 * @param data    The message
+	 * @param length  The message length
+	 * @return true on success, false otherwise
+	 */
+	bool queue(const unsigned char *data, std::size_t length);
+
+	/**
+	 * @brief Write the queued messages on the stream
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool flush();
+
+private:
+	/**
+	 * @brief Forget the connection after an error or a disconnection
+	 */
+	void reset();
+
+	/**
+	 * @brief Write some data on the socket
+	 *
+	 * @param iov    The data to write
+	 * @param count  The number of buffers
+	 * @return the number of bytes written, -1 on error
+	 */
+	ssize_t write(const struct iovec *iov, std::size_t count);
+
+	std::string name;
+	std::string addr;
+	unsigned int port;
+	unsigned int wmem;
+	int socket_fd;
+	bool connected;
+	/// The queued messages and their padding
+	std::vector<struct iovec> iovecs;
+	std::size_t queued_length;
+	/// The bytes the socket could not take yet
+	Data pending;
+	/// The next time a connection can be tried
+	time_ms_t next_retry;
+
+	std::shared_ptr<OutputLog> log;
+};
+
+#endif
@@ -0,0 +1,262 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file MessageCapture.cpp
+ * @brief The serialization of the messages exchanged by the blocks
+ *        in the captures recorded at their boundaries
+ * @author Viveris Technologies
+ */
+
+#include <cstring>
+#include <list>
+
+#include "MessageCapture.h"
+#include "InterconnectChannel.h"
+#include "NetBurst.h"
+#include "OpenSandFrames.h"
+
+
+/**
+ * @brief Append a record header and its content to the payload
+ */
+template <typename T>
+static void appendRecord(std::vector<unsigned char> &payload, const T &record,
+                         const unsigned char *data, std::size_t length)
+{
+	auto header = reinterpret_cast<const unsigned char *>(&record);
+	payload.insert(payload.end(), header, header + sizeof(record));
+	payload.insert(payload.end(), data, data + length);
+}
+
+
+/**
+ * @brief Append a DVB frame record to the payload
+ */
+static void appendFrame(std::vector<unsigned char> &payload, const DvbFrame &frame)
+{
+	interconnect_frame_t record{};
+	record.length = sizeof(record) + frame.getTotalLength();
+	record.spot = frame.getSpot();
+	record.carrier_id = frame.getCarrierId();
+	appendRecord(payload, record, frame.getRawData(), frame.getTotalLength());
+}
+
+
+/**
+ * @brief Get the record at the beginning of some data and check its length
+ */
+template <typename T>
+static const T *readRecord(const unsigned char *data, std::size_t length)
+{
+	if(length < sizeof(T))
+	{
+		return nullptr;
+	}
+	auto record = reinterpret_cast<const T *>(data);
+	if(record->length < sizeof(T) || record->length > length)
+	{
+		return nullptr;
+	}
+	return record;
+}
+
+
+/**
+ * @brief Rebuild a DVB frame from its record
+ */
+static DvbFrame *readFrame(const unsigned char *data, std::size_t length, std::size_t &read)
+{
+	auto record = readRecord<interconnect_frame_t>(data, length);
+	if(record == nullptr)
+	{
+		return nullptr;
+	}
+	auto frame = new DvbFrame(data + sizeof(*record), record->length - sizeof(*record));
+	frame->setCarrierId(record->carrier_id);
+	frame->setSpot(record->spot);
+	read = record->length;
+	return frame;
+}
+
+
+bool MessageCapture::serialize(const rt_msg_t &message, std::vector<unsigned char> &payload)
+{
+	switch(to_enum<InternalMessageType>(message.type))
+	{
+		case InternalMessageType::encap_data:
+		case InternalMessageType::sig:
+			appendFrame(payload, *static_cast<const DvbFrame *>(message.data));
+			return true;
+
+		case InternalMessageType::saloha:
+			for(auto &&frame: *static_cast<const std::list<DvbFrame *> *>(message.data))
+			{
+				appendFrame(payload, *frame);
+			}
+			return true;
+
+		case InternalMessageType::decap_data:
+			for(auto &&packet: *static_cast<const NetBurst *>(message.data))
+			{
+				interconnect_packet_t record{};
+				record.length = sizeof(record) + packet->getTotalLength();
+				record.src_id = packet->getSrcTalId();
+				record.dst_id = packet->getDstTalId();
+				record.qos = packet->getQos();
+				record.type = to_underlying(packet->getType());
+				record.header_length = packet->getHeaderLength();
+				appendRecord(payload, record, packet->getRawData(), packet->getTotalLength());
+			}
+			return true;
+
+		case InternalMessageType::link_up:
+		{
+			auto data = static_cast<const unsigned char *>(message.data);
+			payload.insert(payload.end(), data, data + sizeof(T_LINK_UP));
+			return true;
+		}
+
+		default:
+			return false;
+	}
+}
+
+
+bool MessageCapture::deserialize(uint8_t type, const unsigned char *payload,
+                                 std::size_t length, rt_msg_t &message)
+{
+	message.type = type;
+	message.length = length;
+	message.data = nullptr;
+
+	std::size_t read = 0;
+	switch(to_enum<InternalMessageType>(type))
+	{
+		case InternalMessageType::encap_data:
+		case InternalMessageType::sig:
+			message.data = readFrame(payload, length, read);
+			return message.data != nullptr;
+
+		case InternalMessageType::saloha:
+		{
+			auto frames = new std::list<DvbFrame *>();
+			for(std::size_t pos = 0; pos < length; pos += read)
+			{
+				DvbFrame *frame = readFrame(payload + pos, length - pos, read);
+				if(frame == nullptr)
+				{
+					for(auto &&frame: *frames)
+					{
+						delete frame;
+					}
+					delete frames;
+					return false;
+				}
+				frames->push_back(frame);
+			}
+			message.data = frames;
+			return true;
+		}
+
+		case InternalMessageType::decap_data:
+		{
+			auto burst = new NetBurst{};
+			for(std::size_t pos = 0; pos < length; pos += read)
+			{
+				auto record = readRecord<interconnect_packet_t>(payload + pos, length - pos);
+				if(record == nullptr)
+				{
+					delete burst;
+					return false;
+				}
+				burst->push_back(std::unique_ptr<NetPacket>{new NetPacket{payload + pos + sizeof(*record),
+				                                                          record->length - sizeof(*record),
+				                                                          "capture",
+				                                                          static_cast<NET_PROTO>(record->type),
+				                                                          record->qos,
+				                                                          record->src_id,
+				                                                          record->dst_id,
+				                                                          record->header_length}});
+				read = record->length;
+			}
+			message.data = burst;
+			return true;
+		}
+
+		case InternalMessageType::link_up:
+		{
+			if(length != sizeof(T_LINK_UP))
+			{
+				return false;
+			}
+			auto link_up = new T_LINK_UP;
+			memcpy(link_up, payload, sizeof(T_LINK_UP));
+			message.data = link_up;
+			return true;
+		}
+
+		default:
+			return false;
+	}
+}
+
+
+void MessageCapture::release(const rt_msg_t &message)
+{
+	switch(to_enum<InternalMessageType>(message.type))
+	{
+		case InternalMessageType::encap_data:
+		case InternalMessageType::sig:
+			delete static_cast<DvbFrame *>(message.data);
+			break;
+
+		case InternalMessageType::saloha:
+		{
+			auto frames = static_cast<std::list<DvbFrame *> *>(message.data);
+			for(auto &&frame: *frames)
+			{
+				delete frame;
+			}
+			delete frames;
+			break;
+		}
+
+		case InternalMessageType::decap_data:
+			delete static_cast<NetBurst *>(message.data);
+			break;
+
+		case InternalMessageType::link_up:
+			delete static_cast<T_LINK_UP *>(message.data);
+			break;
+
+		default:
+			break;
+	}
+}
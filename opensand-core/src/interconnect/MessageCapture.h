@@ -0,0 +1,86 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file MessageCapture.h
+ * @brief The serialization of the messages exchanged by the blocks
+ *        in the captures recorded at their boundaries
+ * @author Viveris Technologies
+ */
+
+#ifndef MESSAGE_CAPTURE_H
+#define MESSAGE_CAPTURE_H
+
+#include <opensand_rt/RtCapture.h>
+
+#include <cstddef>
+#include <vector>
+
+
+/**
+ * @class MessageCapture
+ * @brief Serialize the internal messages for the rt captures and
+ *        rebuild them for a BlockReplay
+ *
+ * The frames and packets use the records of the interconnect messages,
+ * one after the other; the link up messages are copied as is.
+ */
+class MessageCapture
+{
+public:
+	/**
+	 * @brief Serialize the content of a message
+	 *
+	 * @param message  The message, it is not modified
+	 * @param payload  OUT: the serialized content
+	 * @return true on success, false if the type of message is not supported
+	 */
+	static bool serialize(const rt_msg_t &message, std::vector<unsigned char> &payload);
+
+	/**
+	 * @brief Rebuild a message from its serialized content
+	 *
+	 * @param type     The message type
+	 * @param payload  The serialized content
+	 * @param length   The serialized content length
+	 * @param message  OUT: the message, owning its new content
+	 * @return true on success, false otherwise
+	 */
+	static bool deserialize(uint8_t type, const unsigned char *payload,
+	                        std::size_t length, rt_msg_t &message);
+
+	/**
+	 * @brief Release the content of a message
+	 *
+	 * @param message  The message
+	 */
+	static void release(const rt_msg_t &message);
+};
+
+#endif
@@ -39,7 +39,10 @@
 #include "OpenSandFrames.h"
 #include "TrafficCategory.h"
 #include "Ethernet.h"
+#include "Phs.h"
+#include "Rohc.h"
 #include "OpenSandModelConf.h"
+#include "TapOffload.h"
 
 #include <opensand_output/Output.h>
 #include <opensand_rt/NetSocketEvent.h>
@@ -48,6 +51,8 @@
 #include <cstdio>
 #include <cstring>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <linux/if_tun.h>
 #include <net/if.h>
@@ -59,7 +64,6 @@
 #include <vector>
 
 #define TUNTAP_FLAGS_LEN 4 // Flags [2 bytes] + Proto [2 bytes]
-#define TUNTAP_BUFSIZE MAX_ETHERNET_SIZE // ethernet header + mtu + options, crc not included
 
 
 
@@ -69,7 +73,8 @@
 BlockLanAdaptation::BlockLanAdaptation(const std::string &name, struct la_specific specific):
 	Block{name},
 	tap_iface{specific.tap_iface},
-	packet_switch{specific.packet_switch}
+	packet_switch{specific.packet_switch},
+	pep{nullptr}
 {
 }
 
@@ -80,7 +85,22 @@ BlockLanAdaptation::Downward::Downward(const std::string &name, struct la_specif
 	contexts{},
 	tal_id{specific.connected_satellite},
 	state{specific.is_used_for_isl ? SatelliteLinkState::UP : SatelliteLinkState::DOWN},
-	packet_switch{specific.packet_switch}
+	packet_switch{specific.packet_switch},
+	vnet_hdr{false},
+	fd{-1},
+	pep{nullptr},
+	pep_timer{-1},
+	pep_stats{},
+	probe_pep_connections{nullptr},
+	probe_pep_buffered{nullptr},
+	probe_pep_acks{nullptr},
+	probe_pep_retransmissions{nullptr},
+	probe_pep_drops{nullptr},
+	buffers_stats{BufferPool::getStatistics()},
+	probe_buffers_allocations{nullptr},
+	probe_buffers_slab_allocations{nullptr},
+	probe_buffers_remote_frees{nullptr},
+	probe_buffers_large_allocations{nullptr}
 {
 }
  
@@ -88,11 +108,14 @@ BlockLanAdaptation::Downward::Downward(const std::string &name, struct la_specif
 BlockLanAdaptation::Upward::Upward(const std::string &name, struct la_specific specific):
 	RtUpward{name},
 	sarp_table{},
+	fd{-1},
+	vnet_hdr{false},
 	contexts{},
 	tal_id{specific.connected_satellite},
 	state{specific.is_used_for_isl ? SatelliteLinkState::UP : SatelliteLinkState::DOWN},
 	packet_switch{specific.packet_switch},
-	delay{specific.delay}
+	delay{specific.delay},
+	pep{nullptr}
 {
 }
 
@@ -103,6 +126,27 @@ BlockLanAdaptation::Upward::Upward(const std::string &name, struct la_specific s
 void BlockLanAdaptation::generateConfiguration()
 {
 	Ethernet::generateConfiguration();
+	Rohc::generateConfiguration();
+	Phs::generateConfiguration();
+
+	auto Conf = OpenSandModelConf::Get();
+	auto types = Conf->getModelTypesDefinition();
+	auto conf = Conf->getOrCreateComponent("network", "Network", "The DVB layer configuration");
+	auto tap = conf->addComponent("tap", "TAP Interface");
+	tap->setAdvanced(true);
+	tap->addParameter("offload", "Segmentation Offload", types->getType("bool"),
+	                  "Let the kernel hand large TCP segments split by the emulator");
+	tap->addParameter("mtu", "MTU", types->getType("int"),
+	                  "MTU of the TAP interface, up to 9000 bytes for jumbo frames")->setUnit("bytes");
+
+	auto pep = conf->addComponent("pep", "TCP Proxy");
+	pep->setAdvanced(true);
+	pep->addParameter("tcp_spoofing", "TCP Spoofing", types->getType("bool"),
+	                  "Acknowledge the TCP data of the LAN on behalf of the remote endpoints");
+	pep->addParameter("max_connections", "Maximum Connections", types->getType("int"),
+	                  "Number of TCP connections handled at most, the other ones are left untouched");
+	pep->addParameter("buffer_size", "Buffer Size", types->getType("int"),
+	                  "Data acknowledged and not yet delivered kept at most per connection")->setUnit("kB");
 }
 
 bool BlockLanAdaptation::onInit(void)
@@ -120,20 +164,106 @@ bool BlockLanAdaptation::onInit(void)
 	    "add lan adaptation: %s\n",
 	    plugin->getName().c_str());
 
+	// TAP interface tuning, no offloads by default
+	bool offload = false;
+	auto tap = OpenSandModelConf::Get()->getProfileData()->getComponent("network")->getComponent("tap");
+	if(tap != nullptr)
+	{
+		OpenSandModelConf::extractParameterData(tap, "offload", offload);
+	}
+	std::size_t mtu;
+	if(!OpenSandModelConf::Get()->getTapMtu(mtu))
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "the TAP interface MTU is out of the [%d, %d] range\n",
+		    ETH_MIN_MTU, ETHERNET_JUMBO_MTU);
+		return false;
+	}
+
+	// TCP proxy, disabled by default
+	bool tcp_spoofing = false;
+	int max_connections = 1024;
+	int buffer_size = 1024;
+	auto pep = OpenSandModelConf::Get()->getProfileData()->getComponent("network")->getComponent("pep");
+	if(pep != nullptr)
+	{
+		OpenSandModelConf::extractParameterData(pep, "tcp_spoofing", tcp_spoofing);
+		OpenSandModelConf::extractParameterData(pep, "max_connections", max_connections);
+		OpenSandModelConf::extractParameterData(pep, "buffer_size", buffer_size);
+	}
+	if(tcp_spoofing)
+	{
+		if(max_connections <= 0 || buffer_size <= 0)
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "the TCP proxy needs connections and buffers\n");
+			return false;
+		}
+		LOG(this->log_init, LEVEL_NOTICE,
+		    "TCP proxy enabled for %d connections with %d kB buffers\n",
+		    max_connections, buffer_size);
+		this->pep.reset(new TcpSpoofing(max_connections, buffer_size * 1024));
+	}
+
 	// create TAP virtual interface
 	int fd = -1;
-	if(!this->allocTap(fd))
+	if(!this->allocTap(offload, fd))
 	{
 		return false;
 	}
+	if(!this->setTapMtu(mtu))
+	{
+		// the interface keeps its MTU, the longer frames are truncated
+		LOG(this->log_init, LEVEL_WARNING,
+		    "cannot set the %zu bytes MTU on %s: %s\n",
+		    mtu, this->tap_iface.c_str(), strerror(errno));
+	}
 
 	lan_contexts_t contexts;
 	contexts.push_back(context);
+
+	// the headers of the Ethernet frames are compressed, then suppressed,
+	// on satellite
+	std::vector<LanAdaptationPlugin *> lower_plugins;
+	if(Rohc::isEnabled())
+	{
+		lower_plugins.push_back(Rohc::constructPlugin());
+	}
+	if(Phs::isEnabled())
+	{
+		lower_plugins.push_back(Phs::constructPlugin());
+	}
+	LanAdaptationPlugin *upper = plugin;
+	for(LanAdaptationPlugin *lower : lower_plugins)
+	{
+		if(lower == nullptr)
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "cannot create the lan adaptation below %s\n",
+			    upper->getName().c_str());
+			return false;
+		}
+		LanAdaptationPlugin::LanAdaptationContext *lower_context = lower->getContext();
+		if(!lower_context->setUpperPacketHandler(upper->getPacketHandler()))
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "cannot use %s over %s\n",
+			    upper->getName().c_str(), lower->getName().c_str());
+			return false;
+		}
+		LOG(this->log_init, LEVEL_INFO,
+		    "add lan adaptation: %s\n",
+		    lower->getName().c_str());
+		contexts.push_back(lower_context);
+		upper = lower;
+	}
 	((Upward *)this->upward)->setContexts(contexts);
 	((Downward *)this->downward)->setContexts(contexts);
 	// we can share FD as one thread will write, the second will read
-	((Upward *)this->upward)->setFd(fd);
-	((Downward *)this->downward)->setFd(fd);
+	((Upward *)this->upward)->setFd(fd, offload);
+	((Downward *)this->downward)->setFd(fd, offload, mtu);
+	((Upward *)this->upward)->setPep(this->pep.get());
+	((Downward *)this->downward)->setPep(this->pep.get());
 
 	return true;
 }
@@ -152,6 +282,34 @@ bool BlockLanAdaptation::Downward::onInit(void)
 	    this->stats_period_ms);
 	this->stats_timer = this->addTimerEvent("LanAdaptationStats",
 	                                        this->stats_period_ms);
+
+	// allocations done by the packets pool since the last statistics update,
+	// slab allocations should drop to zero once the traffic is steady
+	auto output = Output::Get();
+	this->probe_buffers_allocations =
+	    output->registerProbe<int>("Buffers.allocations", "blocks", true, SAMPLE_SUM);
+	this->probe_buffers_slab_allocations =
+	    output->registerProbe<int>("Buffers.slab_allocations", "slabs", true, SAMPLE_SUM);
+	this->probe_buffers_remote_frees =
+	    output->registerProbe<int>("Buffers.remote_frees", "blocks", true, SAMPLE_SUM);
+	this->probe_buffers_large_allocations =
+	    output->registerProbe<int>("Buffers.large_allocations", "blocks", true, SAMPLE_SUM);
+
+	if(this->pep != nullptr)
+	{
+		// the retransmissions timeouts are checked every 100 ms
+		this->pep_timer = this->addTimerEvent("LanAdaptationPep", 100);
+		this->probe_pep_connections =
+		    output->registerProbe<int>("PEP.Connections", "", true, SAMPLE_LAST);
+		this->probe_pep_buffered =
+		    output->registerProbe<int>("PEP.Buffered", "Bytes", true, SAMPLE_LAST);
+		this->probe_pep_acks =
+		    output->registerProbe<int>("PEP.Spoofed ACKs", "packets", true, SAMPLE_SUM);
+		this->probe_pep_retransmissions =
+		    output->registerProbe<int>("PEP.Retransmissions", "packets", true, SAMPLE_SUM);
+		this->probe_pep_drops =
+		    output->registerProbe<int>("PEP.Drops", "packets", true, SAMPLE_SUM);
+	}
 	return true;
 }
 
@@ -175,22 +333,44 @@ bool BlockLanAdaptation::Upward::onInit(void)
 void BlockLanAdaptation::Upward::setContexts(const lan_contexts_t &contexts)
 {
 	this->contexts = contexts;
+	this->encap_chain.setContexts(contexts);
 }
 
 void BlockLanAdaptation::Downward::setContexts(const lan_contexts_t &contexts)
 {
 	this->contexts = contexts;
+	this->encap_chain.setContexts(contexts);
 }
 
-void BlockLanAdaptation::Upward::setFd(int fd)
+void BlockLanAdaptation::Upward::setFd(int fd, bool vnet_hdr)
 {
 	this->fd = fd;
+	this->vnet_hdr = vnet_hdr;
 }
 
-void BlockLanAdaptation::Downward::setFd(int fd)
+void BlockLanAdaptation::Downward::setFd(int fd, bool vnet_hdr, std::size_t mtu)
 {
+	this->fd = fd;
+	this->vnet_hdr = vnet_hdr;
+	// ethernet header + mtu + options, crc not included
+	std::size_t max_size = TUNTAP_FLAGS_LEN + ETHERNET_FRAME_SIZE(mtu);
+	if(vnet_hdr)
+	{
+		max_size = TUNTAP_FLAGS_LEN + TapOffload::header_length + TapOffload::max_frame_length;
+	}
+
 	// add file descriptor for TAP interface
-	this->addFileEvent("tap", fd, TUNTAP_BUFSIZE + 4);
+	this->addFileEvent("tap", fd, max_size);
+}
+
+void BlockLanAdaptation::Upward::setPep(TcpSpoofing *pep)
+{
+	this->pep = pep;
+}
+
+void BlockLanAdaptation::Downward::setPep(TcpSpoofing *pep)
+{
+	this->pep = pep;
 }
 
 
@@ -223,12 +403,11 @@ bool BlockLanAdaptation::Downward::onEvent(const RtEvent *const event)
 			// this is not a link up message, this should be a forward burst
 			LOG(this->log_receive, LEVEL_DEBUG,
 			    "Get a forward burst from opposite channel\n");
-			NetBurst *forward_burst = static_cast<NetBurst *>(msg_event->getData());
-			if (!this->enqueueMessage((void **)&forward_burst, 0, to_underlying(InternalMessageType::decap_data)))
+			auto forward_burst = msg_event->releaseData<NetBurst>();
+			if (!this->enqueueMessage(std::move(forward_burst), 0, to_underlying(InternalMessageType::decap_data)))
 			{
 				LOG(this->log_receive, LEVEL_ERROR,
 				    "failed to forward burst to lower layer\n");
-				delete forward_burst;
 				return false;
 			}
 		}
@@ -247,6 +426,15 @@ bool BlockLanAdaptation::Downward::onEvent(const RtEvent *const event)
 				{
 					(*it)->updateStats(this->stats_period_ms);
 				}
+				this->updateBuffersStats();
+				if(this->pep != nullptr)
+				{
+					this->updatePepStats();
+				}
+			}
+			else if(this->pep != nullptr && *event == this->pep_timer)
+			{
+				return this->pollPep();
 			}
 			else
 			{
@@ -352,7 +540,7 @@ bool BlockLanAdaptation::Upward::onEvent(const RtEvent *const event)
 				{
 					FifoElement *elem = delay_fifo.pop();
 					auto packet = elem->getElem<NetPacket>();
-					if (!this->writePacket(packet->getData()))
+					if (!this->writePacket(packet))
 					{
 						return false;
 					}
@@ -382,23 +570,25 @@ bool BlockLanAdaptation::Upward::onMsgFromDown(NetBurst *burst)
 		return false;
 	}
 
-	for(auto &&context : this->contexts)
+	// the lowest context deencapsulates first
+	for(auto it = this->contexts.rbegin(); it != this->contexts.rend(); ++it)
 	{
-		burst = context->deencapsulate(burst);
+		burst = (*it)->deencapsulate(burst);
 		if(burst == nullptr)
 		{
 			LOG(this->log_receive, LEVEL_ERROR,
 			    "failed to handle packet in %s context\n",
-			    context->getName().c_str());
+			    (*it)->getName().c_str());
 			return false;
 		}
 	}
 
 	time_ms_t current_time = getCurrentTime();
+	std::vector<std::unique_ptr<NetPacket>> pep_segments;
 	auto burst_it = burst->begin();
 	while(burst_it != burst->end())
 	{
-		Data packet = (*burst_it)->getData();
+		const Data &packet = (*burst_it)->getData();
 		tal_id_t pkt_tal_id_src = (*burst_it)->getSrcTalId();
 		tal_id_t pkt_tal_id_dst = (*burst_it)->getDstTalId();
 		bool forward = false;
@@ -423,26 +613,20 @@ bool BlockLanAdaptation::Upward::onMsgFromDown(NetBurst *burst)
 			
 		}
 
-		if(packet_switch->isPacketForMe(packet, pkt_tal_id_src, forward))
+		if(packet_switch->isPacketForMe(packet, pkt_tal_id_src, forward) &&
+		   (this->pep == nullptr || this->pep->fromSatellite(packet, current_time, pep_segments)))
 		{
 			LOG(this->log_receive, LEVEL_INFO,
 			    "%s packet received from lower layer & should "
 			    "be read\n", (*burst_it)->getName().c_str());
-			
-			unsigned char head[TUNTAP_FLAGS_LEN];
-			for(unsigned int i = 0; i < TUNTAP_FLAGS_LEN; i++)
-			{
-				// add the protocol flag in the header
-				head[i] = (this->contexts.front())->getLanHeader(i, *burst_it);
-				LOG(this->log_receive, LEVEL_DEBUG,
-				    "Add 0x%2x for bit %u in TAP header\n",
-				    head[i], i);
-			}
+			LOG(this->log_receive, LEVEL_INFO,
+			    "%s packet received from lower layer & forwarded "
+			    "to network layer\n",
+			    (*burst_it)->getName().c_str());
 
-			packet.insert(0, head, TUNTAP_FLAGS_LEN);
 			if (delay == 0)
 			{
-				if(!this->writePacket(packet))
+				if(!this->writePacket(*burst_it))
 				{
 					success = false;
 					++burst_it;
@@ -451,7 +635,17 @@ bool BlockLanAdaptation::Upward::onMsgFromDown(NetBurst *burst)
 			}
 			else
 			{
-				std::unique_ptr<NetPacket> packet_ptr{new NetPacket(packet)};
+				// only the broadcast and multicast packets, also forwarded,
+				// are duplicated, the others are moved into the fifo
+				std::unique_ptr<NetPacket> packet_ptr;
+				if(forward)
+				{
+					packet_ptr.reset(new NetPacket(**burst_it));
+				}
+				else
+				{
+					packet_ptr = std::move(*burst_it);
+				}
 				FifoElement *elem = new FifoElement(std::move(packet_ptr), current_time, current_time + delay);
 				if (!delay_fifo.pushBack(elem))
 				{
@@ -461,11 +655,6 @@ bool BlockLanAdaptation::Upward::onMsgFromDown(NetBurst *burst)
 					continue;
 				}
 			}
-
-			LOG(this->log_receive, LEVEL_INFO,
-			    "%s packet received from lower layer & forwarded "
-			    "to network layer\n",
-			    (*burst_it)->getName().c_str());
 		}
 
 		auto Conf = OpenSandModelConf::Get();
@@ -501,19 +690,27 @@ bool BlockLanAdaptation::Upward::onMsgFromDown(NetBurst *burst)
 			++burst_it;
 		}
 	}
+	if(!pep_segments.empty())
+	{
+		// the data released by the acknowledgements of the
+		// TCP proxy is sent with the forwarded packets
+		if(!forward_burst)
+		{
+			forward_burst = new NetBurst();
+		}
+		for(auto &&segment : pep_segments)
+		{
+			forward_burst->add(std::move(segment));
+		}
+	}
 	if(forward_burst)
 	{
-		for(lan_contexts_t::iterator iter = this->contexts.begin();
-		    iter != this->contexts.end(); ++iter)
+		forward_burst = this->encap_chain.encapsulate(forward_burst);
+		if(forward_burst == NULL)
 		{
-			forward_burst = (*iter)->encapsulate(forward_burst);
-			if(forward_burst == NULL)
-			{
-				LOG(this->log_receive, LEVEL_ERROR,
-				    "failed to handle packet in %s context\n",
-				    (*iter)->getName().c_str());
-				return false;
-			}
+			LOG(this->log_receive, LEVEL_ERROR,
+			    "failed to handle the forwarded packets\n");
+			return false;
 		}
 
 		LOG(this->log_receive, LEVEL_INFO,
@@ -522,12 +719,11 @@ bool BlockLanAdaptation::Upward::onMsgFromDown(NetBurst *burst)
 
 		// transmit message to the opposite channel that will
 		// send it to lower layer 
-		if(!this->shareMessage((void **)&forward_burst))
+		if(!this->shareMessage(std::unique_ptr<NetBurst>{forward_burst}))
 		{
 			LOG(this->log_receive, LEVEL_ERROR,
 			    "failed to transmit forward burst to opposite "
 			    "channel\n");
-			delete forward_burst;
 			success = false;
 		}
 	}
@@ -536,10 +732,35 @@ bool BlockLanAdaptation::Upward::onMsgFromDown(NetBurst *burst)
 	return success;
 }
 
-bool BlockLanAdaptation::Upward::writePacket(const Data& packet)
+bool BlockLanAdaptation::Upward::writePacket(const std::unique_ptr<NetPacket> &packet)
 {
-	// TODO move into its own function for delay...
-	if(write(this->fd, packet.data(), packet.length()) < 0)
+	unsigned char head[TUNTAP_FLAGS_LEN];
+	for(unsigned int i = 0; i < TUNTAP_FLAGS_LEN; i++)
+	{
+		// add the protocol flag in the header
+		head[i] = (this->contexts.front())->getLanHeader(i, packet);
+		LOG(this->log_receive, LEVEL_DEBUG,
+		    "Add 0x%2x for bit %u in TAP header\n",
+		    head[i], i);
+	}
+
+	// the frames are complete, no offload is requested to the kernel
+	vnet_header_t vnet_header;
+	memset(&vnet_header, 0, sizeof(vnet_header));
+
+	const Data &data = packet->getData();
+	struct iovec frame[3];
+	int nb_iov = 0;
+	frame[nb_iov].iov_base = head;
+	frame[nb_iov++].iov_len = TUNTAP_FLAGS_LEN;
+	if(this->vnet_hdr)
+	{
+		frame[nb_iov].iov_base = &vnet_header;
+		frame[nb_iov++].iov_len = sizeof(vnet_header);
+	}
+	frame[nb_iov].iov_base = const_cast<unsigned char *>(data.data());
+	frame[nb_iov++].iov_len = data.length();
+	if(writev(this->fd, frame, nb_iov) < 0)
 	{
 		LOG(this->log_receive, LEVEL_ERROR,
 			"Unable to write data on tap "
@@ -549,11 +770,100 @@ bool BlockLanAdaptation::Upward::writePacket(const Data& packet)
 	return true;
 }
 
+void BlockLanAdaptation::Downward::updateBuffersStats(void)
+{
+	BufferPool::Statistics stats = BufferPool::getStatistics();
+	this->probe_buffers_allocations->put(stats.allocations - this->buffers_stats.allocations);
+	this->probe_buffers_slab_allocations->put(stats.slab_allocations - this->buffers_stats.slab_allocations);
+	this->probe_buffers_remote_frees->put(stats.remote_frees - this->buffers_stats.remote_frees);
+	this->probe_buffers_large_allocations->put(stats.large_allocations - this->buffers_stats.large_allocations);
+	this->buffers_stats = stats;
+}
+
+bool BlockLanAdaptation::Downward::writeAcks(std::vector<Data> &acks)
+{
+	bool success = true;
+	for(auto &&ack : acks)
+	{
+		std::unique_ptr<NetPacket> packet{new NetPacket(std::move(ack))};
+		unsigned char head[TUNTAP_FLAGS_LEN];
+		for(unsigned int i = 0; i < TUNTAP_FLAGS_LEN; i++)
+		{
+			head[i] = (this->contexts.front())->getLanHeader(i, packet);
+		}
+
+		vnet_header_t vnet_header;
+		memset(&vnet_header, 0, sizeof(vnet_header));
+
+		const Data &data = packet->getData();
+		struct iovec frame[3];
+		int nb_iov = 0;
+		frame[nb_iov].iov_base = head;
+		frame[nb_iov++].iov_len = TUNTAP_FLAGS_LEN;
+		if(this->vnet_hdr)
+		{
+			frame[nb_iov].iov_base = &vnet_header;
+			frame[nb_iov++].iov_len = sizeof(vnet_header);
+		}
+		frame[nb_iov].iov_base = const_cast<unsigned char *>(data.data());
+		frame[nb_iov++].iov_len = data.length();
+		if(writev(this->fd, frame, nb_iov) < 0)
+		{
+			LOG(this->log_receive, LEVEL_ERROR,
+			    "Unable to write TCP acknowledgement on tap "
+			    "interface: %s\n", strerror(errno));
+			success = false;
+		}
+	}
+	return success;
+}
+
+bool BlockLanAdaptation::Downward::pollPep(void)
+{
+	std::vector<std::unique_ptr<NetPacket>> segments;
+	this->pep->poll(getCurrentTime(), segments);
+	if(segments.empty() || this->state != SatelliteLinkState::UP)
+	{
+		return true;
+	}
+
+	NetBurst *burst = new NetBurst();
+	for(auto &&segment : segments)
+	{
+		burst->add(std::move(segment));
+	}
+	burst = this->encap_chain.encapsulate(burst);
+	if(burst == nullptr)
+	{
+		LOG(this->log_receive, LEVEL_ERROR,
+		    "failed to handle the retransmitted packets\n");
+		return false;
+	}
+	if(!this->enqueueMessage(std::unique_ptr<NetBurst>{burst}, 0, to_underlying(InternalMessageType::decap_data)))
+	{
+		LOG(this->log_receive, LEVEL_ERROR,
+		    "failed to send retransmitted burst to lower layer\n");
+		return false;
+	}
+	return true;
+}
+
+void BlockLanAdaptation::Downward::updatePepStats(void)
+{
+	TcpSpoofingStats stats = this->pep->getStats();
+	this->probe_pep_connections->put(stats.connections);
+	this->probe_pep_buffered->put(stats.buffered_bytes);
+	this->probe_pep_acks->put(stats.spoofed_acks - this->pep_stats.spoofed_acks);
+	this->probe_pep_retransmissions->put(stats.retransmissions - this->pep_stats.retransmissions);
+	this->probe_pep_drops->put(stats.drops - this->pep_stats.drops);
+	this->pep_stats = stats;
+}
+
 bool BlockLanAdaptation::Downward::onMsgFromUp(const NetSocketEvent *const event)
 {
 	unsigned char *read_data;
 	const unsigned char *data;
-	unsigned int length;
+	std::size_t length;
 
 	// read  data received on tap interface
 	length = event->getSize() - TUNTAP_FLAGS_LEN;
@@ -565,48 +875,100 @@ bool BlockLanAdaptation::Downward::onMsgFromUp(const NetSocketEvent *const event
 		LOG(this->log_receive, LEVEL_NOTICE,
 		    "packets received from TAP, but link is down "
 		    "=> drop packets\n");
-		delete [] read_data;
+		event->releaseData(read_data);
 		return false;
 	}
 
-	LOG(this->log_receive, LEVEL_INFO,
-	    "new %u-bytes packet received from network\n", length);
-	auto packet = std::unique_ptr<NetPacket>(new NetPacket(data, length));
-	// Learn source_mac address
-	tal_id_t pkt_tal_id_src = packet->getSrcTalId();
-	packet_switch->learn(packet->getData(), pkt_tal_id_src);
+	vnet_header_t vnet_header;
+	memset(&vnet_header, 0, sizeof(vnet_header));
+	if(this->vnet_hdr)
+	{
+		if(event->getSize() < TUNTAP_FLAGS_LEN + TapOffload::header_length)
+		{
+			LOG(this->log_receive, LEVEL_ERROR,
+			    "truncated frame received from TAP\n");
+			event->releaseData(read_data);
+			return false;
+		}
+		memcpy(&vnet_header, data, sizeof(vnet_header));
+		data += TapOffload::header_length;
+		length -= TapOffload::header_length;
+	}
 
+	LOG(this->log_receive, LEVEL_INFO,
+	    "new %zu-bytes packet received from network\n", length);
 	NetBurst *burst = new NetBurst();
-	burst->add(std::move(packet));
-	delete [] read_data;
-
-	for(auto &&context : this->contexts)
+	if(TapOffload::isOffloaded(vnet_header))
 	{
-		burst = context->encapsulate(burst);
-		if(burst == nullptr)
+		// complete the checksums and split large segments to the MSS
+		std::vector<Data> segments;
+		if(!TapOffload::split(vnet_header, data, length, segments) || segments.empty())
 		{
 			LOG(this->log_receive, LEVEL_ERROR,
-			    "failed to handle packet in %s context\n",
-			    context->getName().c_str());
+			    "cannot handle the offloads of a %zu-bytes frame "
+			    "(GSO type %u) => drop it\n", length, vnet_header.gso_type);
+			event->releaseData(read_data);
+			delete burst;
 			return false;
 		}
+		for(auto &&segment : segments)
+		{
+			burst->add(std::unique_ptr<NetPacket>(new NetPacket(std::move(segment))));
+		}
+	}
+	else
+	{
+		burst->add(std::unique_ptr<NetPacket>(new NetPacket(data, length)));
+	}
+	event->releaseData(read_data);
+
+	// Learn source_mac address, the segments share their headers
+	const std::unique_ptr<NetPacket> &packet = burst->front();
+	tal_id_t pkt_tal_id_src = packet->getSrcTalId();
+	packet_switch->learn(packet->getData(), pkt_tal_id_src);
+
+	if(this->pep != nullptr)
+	{
+		// the TCP proxy acknowledges the data on behalf of the remote
+		// endpoints, it keeps the segments that cannot be sent yet
+		std::vector<Data> acks;
+		time_ms_t current_time = getCurrentTime();
+		auto burst_it = burst->begin();
+		while(burst_it != burst->end())
+		{
+			this->pep->fromLan(*burst_it, current_time, acks);
+			burst_it = *burst_it ? std::next(burst_it) : burst->erase(burst_it);
+		}
+		// a lost acknowledgement is recovered by the next one
+		this->writeAcks(acks);
+		if(burst->length() == 0)
+		{
+			delete burst;
+			return true;
+		}
+	}
+
+	burst = this->encap_chain.encapsulate(burst);
+	if(burst == nullptr)
+	{
+		LOG(this->log_receive, LEVEL_ERROR,
+		    "failed to handle the packets\n");
+		return false;
 	}
 
-	if (!this->enqueueMessage((void **)&burst, 0, to_underlying(InternalMessageType::decap_data)))
+	if (!this->enqueueMessage(std::unique_ptr<NetBurst>{burst}, 0, to_underlying(InternalMessageType::decap_data)))
 	{
 		LOG(this->log_receive, LEVEL_ERROR,
 		    "failed to send burst to lower layer\n");
-		delete burst;
 		return false;
 	}
 
 	return true;
 }
 
-bool BlockLanAdaptation::allocTap(int &fd)
+bool BlockLanAdaptation::allocTap(bool offload, int &fd)
 {
 	struct ifreq ifr;
-	int err;
 
 	fd = open("/dev/net/tun", O_RDWR);
 	if(fd < 0)
@@ -619,30 +981,74 @@ bool BlockLanAdaptation::allocTap(int &fd)
 
 	memset(&ifr, 0, sizeof(ifr));
 
-	/* Flags: IFF_TUN   - TUN device (no Ethernet headers)
-	 *        IFF_TAP   - TAP device
-	 *        IFF_NO_PI - Do not provide packet information
+	/* Flags: IFF_TUN      - TUN device (no Ethernet headers)
+	 *        IFF_TAP      - TAP device
+	 *        IFF_NO_PI    - Do not provide packet information
+	 *        IFF_VNET_HDR - Frames are preceded by a virtio-net header
+	 *                       describing their offloads
 	 */
 
 	/* create TAP interface */
 	LOG(this->log_init, LEVEL_INFO,
 	    "create %s interface\n",
 	    this->tap_iface.c_str());
-	memcpy(ifr.ifr_name, this->tap_iface.c_str(), IFNAMSIZ);
+	memcpy(ifr.ifr_name, this->tap_iface.c_str(),
+	       std::min<std::size_t>(IFNAMSIZ, this->tap_iface.size() + 1));
 	ifr.ifr_flags = IFF_TAP;
+	if(offload)
+	{
+		ifr.ifr_flags |= IFF_VNET_HDR;
+	}
 
-	err = ioctl(fd, TUNSETIFF, (void *) &ifr);
-	if(err < 0)
+	if(ioctl(fd, TUNSETIFF, (void *) &ifr) < 0)
 	{
 		LOG(this->log_init, LEVEL_ERROR,
 		    "cannot set flags on file descriptor %s\n",
 		    strerror(errno));
 		close(fd);
+		fd = -1;
 		return false;
 	}
 
+	if(offload && !TapOffload::enable(fd))
+	{
+		// the frames are still preceded by the header, without offloads
+		LOG(this->log_init, LEVEL_WARNING,
+		    "cannot enable offloads on %s: %s\n",
+		    this->tap_iface.c_str(), strerror(errno));
+	}
+
 	LOG(this->log_init, LEVEL_NOTICE,
 	    "TAP handle with fd %d initialized\n", fd);
 
 	return true;
 }
+
+bool BlockLanAdaptation::setTapMtu(std::size_t mtu)
+{
+	struct ifreq ifr;
+
+	// the MTU is set through any socket, as ip link does
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if(sock < 0)
+	{
+		return false;
+	}
+
+	memset(&ifr, 0, sizeof(ifr));
+	memcpy(ifr.ifr_name, this->tap_iface.c_str(),
+	       std::min<std::size_t>(IFNAMSIZ, this->tap_iface.size() + 1));
+	ifr.ifr_mtu = mtu;
+	bool success = ioctl(sock, SIOCSIFMTU, (void *) &ifr) == 0;
+	int error = errno;
+	close(sock);
+	errno = error;
+
+	if(success)
+	{
+		LOG(this->log_init, LEVEL_NOTICE,
+		    "MTU of %s set to %zu bytes\n",
+		    this->tap_iface.c_str(), mtu);
+	}
+	return success;
+}
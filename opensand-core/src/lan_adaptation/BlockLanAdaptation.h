@@ -44,13 +44,19 @@
 #include "TrafficCategory.h"
 #include "NetPacket.h"
 #include "LanAdaptationPlugin.h"
+#include "LanAdaptationChain.h"
 #include "OpenSandCore.h"
 #include "DelayFifo.h"
+#include "BufferPool.h"
+#include "TcpSpoofing.h"
 
 #include <opensand_rt/Rt.h>
 #include <opensand_rt/RtChannel.h>
 #include <opensand_output/Output.h>
 
+#include <memory>
+#include <vector>
+
 
 class NetSocketEvent;
 
@@ -95,11 +101,19 @@ public:
 		void setContexts(const lan_contexts_t &contexts);
 
 		/**
-		 * @brief Set the network socket file descriptor
+		 * @brief Set the TAP interface file descriptor
+		 *
+		 * @param fd        The file descriptor the packets are written on
+		 * @param vnet_hdr  Whether the frames are preceded by a virtio-net header
+		 */
+		void setFd(int fd, bool vnet_hdr);
+
+		/**
+		 * @brief Set the TCP proxy shared by the channels
 		 *
-		 * @param fd  The socket file descriptor
+		 * @param pep  The proxy, nullptr if disabled
 		 */
-		void setFd(int fd);
+		void setPep(TcpSpoofing *pep);
 
 	private:
 		/**
@@ -113,12 +127,14 @@ public:
 		bool onMsgFromDown(NetBurst *burst);
 
 		/**
-		 * @brief Actually write the TAP header + packet to TAP interface
+		 * @brief Actually write the TAP header + packet to TAP interface,
+		 *        the header is gathered with the packet data by the write
+		 *        so that it does not need to be inserted in front of it
 		 *
-		 * @param packet  Data to write on the TAP interface
+		 * @param packet  The packet to write on the TAP interface
 		 * @return true on success, false otherwise
 		 */
-		bool writePacket(const Data& packet);
+		bool writePacket(const std::unique_ptr<NetPacket> &packet);
 
 		/// SARP table
 		SarpTable sarp_table;
@@ -126,9 +142,15 @@ public:
 		/// TAP file descriptor
 		int fd;
 
+		/// Whether the frames are preceded by a virtio-net header
+		bool vnet_hdr;
+
 		/// the contexts list from lower to upper context
 		lan_contexts_t contexts;
 
+		/// the contexts encapsulating the bursts, fused when possible
+		LanAdaptationChain encap_chain;
+
 		/// The MAC layer MAC id received through msg_link_up
 		tal_id_t tal_id;
 
@@ -146,6 +168,9 @@ public:
 
 		// Fifo to implement delay before writting on the TAP
 		DelayFifo delay_fifo;
+
+		/// The TCP proxy, nullptr if disabled
+		TcpSpoofing *pep;
 	};
 
 	class Downward: public RtDownward
@@ -164,23 +189,62 @@ public:
 		void setContexts(const lan_contexts_t &contexts);
 
 		/**
-		 * @brief Set the network socket file descriptor
+		 * @brief Set the TAP interface file descriptor
+		 *
+		 * @param fd        The file descriptor the packets are read on
+		 *                  and the acknowledgements of the TCP proxy
+		 *                  are written on
+		 * @param vnet_hdr  Whether the frames are preceded by a virtio-net header
+		 * @param mtu       The MTU of the interface, it sizes the frames read
+		 *                  without virtio-net header
+		 */
+		void setFd(int fd, bool vnet_hdr, std::size_t mtu);
+
+		/**
+		 * @brief Set the TCP proxy shared by the channels
 		 *
-		 * @param fd  The socket file descriptor
+		 * @param pep  The proxy, nullptr if disabled
 		 */
-		void setFd(int fd);
+		void setPep(TcpSpoofing *pep);
 
 	private:
 		/**
 		 * @brief Handle a message from upper block
 		 *  - read data from TAP interface
-		 *  - create a packet with data
+		 *  - create a packet with data, or a packet per segment if the
+		 *    kernel handed a large TCP segment
 		 *
 		 * @param event  The event on TAP interface, containing th message
 		 * @return true on success, false otherwise
 		 */
 		bool onMsgFromUp(const NetSocketEvent *const event);
 
+		/**
+		 * @brief Update the buffers pool probes with the
+		 *        allocations done during the last period
+		 */
+		void updateBuffersStats(void);
+
+		/**
+		 * @brief Write the acknowledgements of the TCP proxy on the TAP interface
+		 *
+		 * @param acks  The Ethernet frames
+		 * @return true on success, false otherwise
+		 */
+		bool writeAcks(std::vector<Data> &acks);
+
+		/**
+		 * @brief Send the segments retransmitted by the TCP proxy to lower layer
+		 *
+		 * @return true on success, false otherwise
+		 */
+		bool pollPep(void);
+
+		/**
+		 * @brief Update the TCP proxy probes
+		 */
+		void updatePepStats(void);
+
 		/// statistic timer
 		event_id_t stats_timer;
 
@@ -190,6 +254,9 @@ public:
 		/// the contexts list from lower to upper context
 		lan_contexts_t contexts;
 
+		/// the contexts encapsulating the bursts, fused when possible
+		LanAdaptationChain encap_chain;
+
 		/// The MAC layer MAC id received through msg_link_up
 		tal_id_t tal_id;
 
@@ -198,6 +265,37 @@ public:
 
 		// The Packet Switch including packet forwarding logic and SARP
 		PacketSwitch *packet_switch;
+
+		/// Whether the frames are preceded by a virtio-net header
+		bool vnet_hdr;
+
+		/// TAP file descriptor
+		int fd;
+
+		/// The TCP proxy, nullptr if disabled
+		TcpSpoofing *pep;
+
+		/// The TCP proxy retransmissions timer
+		event_id_t pep_timer;
+
+		/// The TCP proxy counters at the previous statistics update
+		TcpSpoofingStats pep_stats;
+
+		/// The TCP proxy probes
+		std::shared_ptr<Probe<int>> probe_pep_connections;
+		std::shared_ptr<Probe<int>> probe_pep_buffered;
+		std::shared_ptr<Probe<int>> probe_pep_acks;
+		std::shared_ptr<Probe<int>> probe_pep_retransmissions;
+		std::shared_ptr<Probe<int>> probe_pep_drops;
+
+		/// The buffers pool counters at the previous statistics update
+		BufferPool::Statistics buffers_stats;
+
+		/// The buffers pool probes
+		std::shared_ptr<Probe<int>> probe_buffers_allocations;
+		std::shared_ptr<Probe<int>> probe_buffers_slab_allocations;
+		std::shared_ptr<Probe<int>> probe_buffers_remote_frees;
+		std::shared_ptr<Probe<int>> probe_buffers_large_allocations;
 	};
 
 private:
@@ -207,13 +305,25 @@ private:
 	// The Packet Switch including packet forwarding logic and SARP
 	PacketSwitch *packet_switch;
 
+	/// The TCP proxy shared by the channels, nullptr if disabled
+	std::unique_ptr<TcpSpoofing> pep;
+
 	/**
 	 * Create or connect to an existing TAP interface
 	 *
-	 * @param fd  OUT: the file descriptor
+	 * @param offload  Whether the segmentation and checksum offloads are enabled
+	 * @param fd       OUT: the file descriptor
 	 * @return  true on success, false otherwise
 	 */
-	bool allocTap(int &fd);
+	bool allocTap(bool offload, int &fd);
+
+	/**
+	 * Set the MTU of the TAP interface
+	 *
+	 * @param mtu  The MTU of the interface
+	 * @return  true on success, false otherwise with errno set
+	 */
+	bool setTapMtu(std::size_t mtu);
 };
 
 
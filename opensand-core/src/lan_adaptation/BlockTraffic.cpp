@@ -0,0 +1,726 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file BlockTraffic.cpp
+ * @brief Synthetic traffic generator and sink replacing the TAP interface
+ * @author Viveris Technologies
+ */
+
+
+#include "BlockTraffic.h"
+#include "NetPacket.h"
+#include "NetBurst.h"
+#include "OpenSandFrames.h"
+#include "Phs.h"
+#include "Rohc.h"
+#include "OpenSandModelConf.h"
+#include <opensand_rt/MessageEvent.h>
+
+#include <algorithm>
+#include <cstring>
+#include <arpa/inet.h>
+#include <endian.h>
+
+
+/// The local experimental EtherType of the generated frames
+constexpr const uint16_t TRAFFIC_ETHER_TYPE = 0x88B5;
+/// The magic number identifying the generated frames
+constexpr const uint32_t TRAFFIC_MAGIC = 0x4F535447;
+
+/**
+ * The header placed after the Ethernet II header of the generated frames,
+ * in network byte order
+ */
+struct __attribute__((__packed__)) traffic_header_t
+{
+	uint32_t magic;
+	uint16_t flow_id;
+	uint16_t src_tal_id;
+	uint32_t sequence;
+	uint64_t timestamp_us;
+};
+
+/// The size of the smallest generated frame
+constexpr const std::size_t TRAFFIC_MIN_SIZE = ETHERNET_2_HEADSIZE + sizeof(traffic_header_t);
+
+/// The credit a flow may accumulate, to avoid bursts after a stalled timer
+constexpr const double TRAFFIC_MAX_CREDIT_MS = 100.0;
+
+
+/**
+ * @brief Write the locally administered MAC address of a terminal
+ *
+ * @param mac     OUT: the 6 bytes of the address
+ * @param tal_id  The terminal ID
+ */
+static void writeTerminalMac(unsigned char *mac, tal_id_t tal_id)
+{
+	mac[0] = 0x02;
+	mac[1] = 0x00;
+	mac[2] = 0x00;
+	mac[3] = 0x00;
+	mac[4] = tal_id >> 8;
+	mac[5] = tal_id & 0xFF;
+}
+
+
+BlockTraffic::BlockTraffic(const std::string &name, struct traffic_specific):
+	Block{name}
+{
+}
+
+
+BlockTraffic::Upward::Upward(const std::string &name, struct traffic_specific specific):
+	RtUpward{name},
+	tal_id{specific.tal_id},
+	state{SatelliteLinkState::DOWN},
+	stats_timer{-1},
+	stats_period_ms{},
+	sequences{},
+	flows_stats{},
+	total_stats{}
+{
+}
+
+
+BlockTraffic::Downward::Downward(const std::string &name, struct traffic_specific specific):
+	RtDownward{name},
+	tal_id{specific.tal_id},
+	state{SatelliteLinkState::DOWN},
+	generation_timer{-1},
+	generation_period_ms{1},
+	last_generation_ms{0.0},
+	stats_timer{-1},
+	stats_period_ms{},
+	flows{}
+{
+}
+
+
+void BlockTraffic::generateConfiguration()
+{
+	auto Conf = OpenSandModelConf::Get();
+	auto types = Conf->getModelTypesDefinition();
+	types->addEnumType("size_distribution", "Frame Size Distribution", {"Constant", "Uniform", "IMIX"});
+
+	auto conf = Conf->getOrCreateComponent("network", "Network", "The DVB layer configuration");
+	auto traffic = conf->addComponent("traffic_generator", "Traffic Generator",
+	                                  "Synthetic flows sent and measured instead of the TAP interface traffic");
+	traffic->setAdvanced(true);
+	traffic->addParameter("enabled", "Enabled", types->getType("bool"),
+	                      "Replace the TAP interface by the generator and the sink");
+	traffic->addParameter("period", "Generation Period", types->getType("int"),
+	                      "Period the flows are paced on")->setUnit("ms");
+	traffic->addParameter("measured_flows", "Measured Flows", types->getType("int"),
+	                      "Number of flow IDs, from 0, with probes on the sink, "
+	                      "the other flows are only accounted in the total");
+
+	auto flows = traffic->addList("flows", "Flows", "flow")->getPattern();
+	flows->addParameter("id", "Flow ID", types->getType("int"),
+	                    "Identifies the flow on the sinks, unique over the emulation");
+	flows->addParameter("destination", "Destination", types->getType("int"),
+	                    "The ID of the entity the flow is sent to");
+	flows->addParameter("qos", "QoS", types->getType("int"),
+	                    "The PCP of the QoS class given to the frames");
+	flows->addParameter("rate", "Rate", types->getType("int"))->setUnit("kbps");
+	flows->addParameter("distribution", "Size Distribution", types->getType("size_distribution"),
+	                    "IMIX draws the minimum, middle and maximum sizes 7, 4 and 1 times in 12");
+	flows->addParameter("min_size", "Minimum Frame Size", types->getType("int"))->setUnit("B");
+	flows->addParameter("max_size", "Maximum Frame Size", types->getType("int"))->setUnit("B");
+}
+
+
+bool BlockTraffic::isEnabled()
+{
+	bool enabled = false;
+	auto network = OpenSandModelConf::Get()->getProfileData()->getComponent("network");
+	if(network == nullptr)
+	{
+		return false;
+	}
+	auto traffic = network->getComponent("traffic_generator");
+	if(traffic != nullptr)
+	{
+		OpenSandModelConf::extractParameterData(traffic, "enabled", enabled);
+	}
+	return enabled;
+}
+
+
+bool BlockTraffic::onInit(void)
+{
+	// the encapsulation expects the frames of the stacked lan adaptation
+	// plugins, the generator only builds Ethernet frames
+	if(Rohc::isEnabled() || Phs::isEnabled())
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "the traffic generator cannot be used with header "
+		    "compression or suppression\n");
+		return false;
+	}
+	return true;
+}
+
+
+bool BlockTraffic::Upward::onInit(void)
+{
+	if(!OpenSandModelConf::Get()->getStatisticsPeriod(this->stats_period_ms))
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "section 'timers': missing parameter 'statistics'\n");
+		return false;
+	}
+	this->stats_timer = this->addTimerEvent("TrafficSinkStats",
+	                                        this->stats_period_ms);
+
+	int measured_flows = 16;
+	auto traffic = OpenSandModelConf::Get()->getProfileData()->getComponent("network")->getComponent("traffic_generator");
+	OpenSandModelConf::extractParameterData(traffic, "measured_flows", measured_flows);
+
+	this->flows_stats.resize(std::max(measured_flows, 0));
+	for(std::size_t id = 0; id < this->flows_stats.size(); ++id)
+	{
+		this->initFlowStats(this->flows_stats[id], "Traffic.Flow " + std::to_string(id) + ".");
+	}
+	this->initFlowStats(this->total_stats, "Traffic.Total.");
+	return true;
+}
+
+
+void BlockTraffic::Upward::initFlowStats(FlowStats &stats, const std::string &prefix)
+{
+	auto output = Output::Get();
+	stats.probe_throughput =
+	    output->registerProbe<int>(prefix + "Throughput", "Kbits/s", true, SAMPLE_AVG);
+	stats.probe_packets =
+	    output->registerProbe<int>(prefix + "Received", "packets", true, SAMPLE_SUM);
+	// a frame arriving after a gap was counted as lost is also counted
+	// as reordered, the frames actually lost are the difference
+	stats.probe_lost =
+	    output->registerProbe<int>(prefix + "Lost", "packets", true, SAMPLE_SUM);
+	stats.probe_reordered =
+	    output->registerProbe<int>(prefix + "Reordered", "packets", true, SAMPLE_SUM);
+	stats.probe_latency =
+	    output->registerProbe<float>(prefix + "Latency", "ms", true, SAMPLE_AVG);
+	stats.probe_latency_max =
+	    output->registerProbe<float>(prefix + "Latency max", "ms", true, SAMPLE_MAX);
+}
+
+
+bool BlockTraffic::Downward::onInit(void)
+{
+	if(!OpenSandModelConf::Get()->getStatisticsPeriod(this->stats_period_ms))
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "section 'timers': missing parameter 'statistics'\n");
+		return false;
+	}
+	this->stats_timer = this->addTimerEvent("TrafficGenStats",
+	                                        this->stats_period_ms);
+
+	if(!this->initFlows())
+	{
+		return false;
+	}
+	if(!this->flows.empty())
+	{
+		this->generation_timer = this->addTimerEvent("TrafficGen",
+		                                             this->generation_period_ms);
+	}
+	return true;
+}
+
+
+bool BlockTraffic::Downward::initFlows(void)
+{
+	auto traffic = OpenSandModelConf::Get()->getProfileData()->getComponent("network")->getComponent("traffic_generator");
+	if(traffic == nullptr)
+	{
+		return true;
+	}
+
+	int period = 1;
+	OpenSandModelConf::extractParameterData(traffic, "period", period);
+	if(period <= 0)
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "the traffic generation period must be positive\n");
+		return false;
+	}
+	this->generation_period_ms = period;
+
+	auto output = Output::Get();
+	for(auto& item : traffic->getList("flows")->getItems())
+	{
+		auto flow_conf = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(item);
+
+		int id, destination, qos, rate, min_size, max_size;
+		std::string distribution;
+		if(!OpenSandModelConf::extractParameterData(flow_conf->getParameter("id"), id) ||
+		   !OpenSandModelConf::extractParameterData(flow_conf->getParameter("destination"), destination) ||
+		   !OpenSandModelConf::extractParameterData(flow_conf->getParameter("qos"), qos) ||
+		   !OpenSandModelConf::extractParameterData(flow_conf->getParameter("rate"), rate) ||
+		   !OpenSandModelConf::extractParameterData(flow_conf->getParameter("distribution"), distribution) ||
+		   !OpenSandModelConf::extractParameterData(flow_conf->getParameter("min_size"), min_size))
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "Section network, incomplete traffic flow\n");
+			return false;
+		}
+		if(!OpenSandModelConf::extractParameterData(flow_conf->getParameter("max_size"), max_size))
+		{
+			max_size = min_size;
+		}
+
+		if(id < 0 || id > UINT16_MAX || destination < 0 || destination > UINT8_MAX ||
+		   qos < 0 || qos > UINT8_MAX || rate < 0)
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "Section network, invalid traffic flow %d\n", id);
+			return false;
+		}
+		if(min_size < static_cast<int>(TRAFFIC_MIN_SIZE) || max_size > ETHERNET_2_SIZE ||
+		   max_size < min_size)
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "Section network, the frames of traffic flow %d must be "
+			    "between %zu and %d bytes\n",
+			    id, TRAFFIC_MIN_SIZE, ETHERNET_2_SIZE);
+			return false;
+		}
+
+		Flow flow;
+		flow.id = id;
+		flow.destination = destination;
+		flow.qos = qos;
+		flow.rate_kbps = rate;
+		if(distribution == "Constant")
+		{
+			flow.distribution = TrafficSizeDistribution::constant;
+		}
+		else if(distribution == "Uniform")
+		{
+			flow.distribution = TrafficSizeDistribution::uniform;
+		}
+		else if(distribution == "IMIX")
+		{
+			flow.distribution = TrafficSizeDistribution::imix;
+		}
+		else
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "Section network, unknown size distribution %s for traffic flow %d\n",
+			    distribution.c_str(), id);
+			return false;
+		}
+		flow.min_size = min_size;
+		flow.max_size = max_size;
+		flow.sequence = 0;
+		flow.credit_bits = 0.0;
+		flow.random.seed((static_cast<uint32_t>(this->tal_id) << 16) | flow.id);
+		flow.next_size = this->drawSize(flow);
+		flow.sent_bytes = 0;
+		flow.probe_throughput =
+		    output->registerProbe<int>("Traffic.Flow " + std::to_string(id) + ".Sent", "Kbits/s", true, SAMPLE_AVG);
+
+		LOG(this->log_init, LEVEL_NOTICE,
+		    "traffic flow %u: %u kbps of %zu to %zu bytes frames "
+		    "(%s) to %u with QoS %u\n",
+		    flow.id, flow.rate_kbps, flow.min_size, flow.max_size,
+		    distribution.c_str(), flow.destination, flow.qos);
+		this->flows.push_back(std::move(flow));
+	}
+	return true;
+}
+
+
+std::size_t BlockTraffic::Downward::drawSize(Flow &flow)
+{
+	switch(flow.distribution)
+	{
+		case TrafficSizeDistribution::uniform:
+			return std::uniform_int_distribution<std::size_t>{flow.min_size, flow.max_size}(flow.random);
+
+		case TrafficSizeDistribution::imix:
+		{
+			unsigned int draw = flow.random() % 12;
+			if(draw < 7)
+			{
+				return flow.min_size;
+			}
+			if(draw < 11)
+			{
+				return (flow.min_size + flow.max_size) / 2;
+			}
+			return flow.max_size;
+		}
+
+		case TrafficSizeDistribution::constant:
+		default:
+			return flow.min_size;
+	}
+}
+
+
+bool BlockTraffic::Upward::onEvent(const RtEvent *const event)
+{
+	switch(event->getType())
+	{
+		case EventType::Message:
+		{
+			auto msg_event = static_cast<const MessageEvent *>(event);
+			if(to_enum<InternalMessageType>(msg_event->getMessageType()) == InternalMessageType::link_up)
+			{
+				// 'link is up' message advertised
+				T_LINK_UP *link_up_msg = static_cast<T_LINK_UP *>(msg_event->getData());
+				LOG(this->log_receive, LEVEL_INFO,
+				    "link up message received (group = %u, tal = %u)\n",
+				    link_up_msg->group_id,
+				    link_up_msg->tal_id);
+
+				if(this->state == SatelliteLinkState::UP)
+				{
+					LOG(this->log_receive, LEVEL_NOTICE, "duplicate link up msg\n");
+					delete link_up_msg;
+					return false;
+				}
+				this->tal_id = link_up_msg->tal_id;
+				this->state = SatelliteLinkState::UP;
+				// transmit link up to opposite channel to start the generation
+				if(!this->shareMessage((void **)&link_up_msg,
+				                       msg_event->getLength(),
+				                       msg_event->getMessageType()))
+				{
+					LOG(this->log_receive, LEVEL_ERROR,
+					    "failed to transmit link up message to "
+					    "opposite channel\n");
+					return false;
+				}
+				break;
+			}
+
+			NetBurst *burst = static_cast<NetBurst *>(msg_event->getData());
+			if(this->state != SatelliteLinkState::UP)
+			{
+				LOG(this->log_receive, LEVEL_NOTICE,
+				    "packets received from lower layer, but "
+				    "link is down => drop packets\n");
+				delete burst;
+				return false;
+			}
+			return this->onMsgFromDown(burst);
+		}
+
+		case EventType::Timer:
+			if(*event == this->stats_timer)
+			{
+				this->updateStats();
+				break;
+			}
+			LOG(this->log_receive, LEVEL_ERROR,
+			    "unknown timer event received %s\n",
+			    event->getName().c_str());
+			return false;
+
+		default:
+			LOG(this->log_receive, LEVEL_ERROR,
+			    "unknown event received %s",
+			    event->getName().c_str());
+			return false;
+	}
+
+	return true;
+}
+
+
+bool BlockTraffic::Upward::onMsgFromDown(NetBurst *burst)
+{
+	if(burst == nullptr)
+	{
+		LOG(this->log_receive, LEVEL_ERROR,
+		    "burst is not valid\n");
+		return false;
+	}
+
+	uint64_t now_us = getPreciseTime() * 1000.0;
+	NetBurst *forward_burst = nullptr;
+	auto burst_it = burst->begin();
+	while(burst_it != burst->end())
+	{
+		tal_id_t src_tal_id = (*burst_it)->getSrcTalId();
+		tal_id_t dst_tal_id = (*burst_it)->getDstTalId();
+		if(src_tal_id == this->tal_id)
+		{
+			// with broadcast, we would receive our own packets
+			++burst_it;
+			continue;
+		}
+		if(dst_tal_id != this->tal_id && dst_tal_id != BROADCAST_TAL_ID)
+		{
+			// the gateway relays the flows between terminals
+			if(forward_burst == nullptr)
+			{
+				forward_burst = new NetBurst();
+			}
+			forward_burst->add(std::move(*burst_it));
+			burst_it = burst->erase(burst_it);
+			continue;
+		}
+
+		const Data &data = (*burst_it)->getData();
+		traffic_header_t header;
+		if(data.length() < TRAFFIC_MIN_SIZE ||
+		   ((data[12] << 8) | data[13]) != TRAFFIC_ETHER_TYPE)
+		{
+			LOG(this->log_receive, LEVEL_DEBUG,
+			    "ignore a frame not built by a traffic generator\n");
+			++burst_it;
+			continue;
+		}
+		memcpy(&header, data.data() + ETHERNET_2_HEADSIZE, sizeof(header));
+		if(ntohl(header.magic) != TRAFFIC_MAGIC)
+		{
+			++burst_it;
+			continue;
+		}
+		uint16_t flow_id = ntohs(header.flow_id);
+		uint32_t sequence = ntohl(header.sequence);
+		uint64_t timestamp_us = be64toh(header.timestamp_us);
+
+		int lost = 0;
+		int reordered = 0;
+		auto key = std::make_pair(src_tal_id, flow_id);
+		auto sequence_it = this->sequences.find(key);
+		if(sequence_it == this->sequences.end())
+		{
+			this->sequences.emplace(key, sequence + 1);
+		}
+		else if(sequence >= sequence_it->second)
+		{
+			lost = sequence - sequence_it->second;
+			sequence_it->second = sequence + 1;
+		}
+		else
+		{
+			reordered = 1;
+		}
+		// the clocks of the entities may drift apart a little
+		double latency_ms = now_us > timestamp_us ? (now_us - timestamp_us) / 1000.0 : 0.0;
+
+		FlowStats *flow_stats = flow_id < this->flows_stats.size() ?
+		                        &this->flows_stats[flow_id] : nullptr;
+		for(FlowStats *stats : {flow_stats, &this->total_stats})
+		{
+			if(stats == nullptr)
+			{
+				continue;
+			}
+			stats->bytes += data.length();
+			stats->packets += 1;
+			stats->lost += lost;
+			stats->reordered += reordered;
+			stats->latency_sum += latency_ms;
+			stats->latency_max = std::max(stats->latency_max, latency_ms);
+		}
+		++burst_it;
+	}
+	delete burst;
+
+	if(forward_burst != nullptr &&
+	   !this->shareMessage(std::unique_ptr<NetBurst>{forward_burst}))
+	{
+		LOG(this->log_receive, LEVEL_ERROR,
+		    "failed to transmit forward burst to opposite "
+		    "channel\n");
+		return false;
+	}
+	return true;
+}
+
+
+void BlockTraffic::Upward::updateStats(void)
+{
+	for(FlowStats &stats : this->flows_stats)
+	{
+		this->sendFlowStats(stats);
+	}
+	this->sendFlowStats(this->total_stats);
+}
+
+
+void BlockTraffic::Upward::sendFlowStats(FlowStats &stats)
+{
+	stats.probe_throughput->put(stats.bytes * 8 / this->stats_period_ms);
+	stats.probe_packets->put(stats.packets);
+	stats.probe_lost->put(stats.lost);
+	stats.probe_reordered->put(stats.reordered);
+	if(stats.packets > 0)
+	{
+		stats.probe_latency->put(stats.latency_sum / stats.packets);
+		stats.probe_latency_max->put(stats.latency_max);
+	}
+	stats.bytes = 0;
+	stats.packets = 0;
+	stats.lost = 0;
+	stats.reordered = 0;
+	stats.latency_sum = 0.0;
+	stats.latency_max = 0.0;
+}
+
+
+bool BlockTraffic::Downward::onEvent(const RtEvent *const event)
+{
+	switch(event->getType())
+	{
+		case EventType::Message:
+		{
+			auto msg_event = static_cast<const MessageEvent *>(event);
+			if(to_enum<InternalMessageType>(msg_event->getMessageType()) == InternalMessageType::link_up)
+			{
+				// 'link is up' message advertised, the generation starts
+				T_LINK_UP *link_up_msg = static_cast<T_LINK_UP *>(msg_event->getData());
+				this->tal_id = link_up_msg->tal_id;
+				this->state = SatelliteLinkState::UP;
+				this->last_generation_ms = getPreciseTime();
+				delete link_up_msg;
+				break;
+			}
+
+			// this is not a link up message, this should be a forward burst
+			auto forward_burst = msg_event->releaseData<NetBurst>();
+			if(!this->enqueueMessage(std::move(forward_burst), 0, to_underlying(InternalMessageType::decap_data)))
+			{
+				LOG(this->log_receive, LEVEL_ERROR,
+				    "failed to forward burst to lower layer\n");
+				return false;
+			}
+		}
+		break;
+
+		case EventType::Timer:
+			if(*event == this->generation_timer)
+			{
+				return this->generate();
+			}
+			else if(*event == this->stats_timer)
+			{
+				for(Flow &flow : this->flows)
+				{
+					flow.probe_throughput->put(flow.sent_bytes * 8 / this->stats_period_ms);
+					flow.sent_bytes = 0;
+				}
+			}
+			else
+			{
+				LOG(this->log_receive, LEVEL_ERROR,
+				    "unknown timer event received %s\n",
+				    event->getName().c_str());
+				return false;
+			}
+			break;
+
+		default:
+			LOG(this->log_receive, LEVEL_ERROR,
+			    "unknown event received %s",
+			    event->getName().c_str());
+			return false;
+	}
+
+	return true;
+}
+
+
+bool BlockTraffic::Downward::generate(void)
+{
+	if(this->state != SatelliteLinkState::UP)
+	{
+		return true;
+	}
+
+	// the credits follow the elapsed time rather than the timer period
+	// so that the rates do not depend on the timer accuracy
+	double now_ms = getPreciseTime();
+	double elapsed_ms = std::min(now_ms - this->last_generation_ms, TRAFFIC_MAX_CREDIT_MS);
+	this->last_generation_ms = now_ms;
+	uint64_t timestamp_us = htobe64(static_cast<uint64_t>(now_ms * 1000.0));
+
+	unsigned char frame[ETHERNET_2_SIZE];
+	memset(frame, 0, sizeof(frame));
+	writeTerminalMac(frame + 6, this->tal_id);
+	frame[12] = TRAFFIC_ETHER_TYPE >> 8;
+	frame[13] = TRAFFIC_ETHER_TYPE & 0xFF;
+
+	NetBurst *burst = nullptr;
+	for(Flow &flow : this->flows)
+	{
+		flow.credit_bits = std::min(flow.credit_bits + flow.rate_kbps * elapsed_ms,
+		                            flow.rate_kbps * TRAFFIC_MAX_CREDIT_MS);
+		if(flow.credit_bits < flow.next_size * 8)
+		{
+			continue;
+		}
+
+		writeTerminalMac(frame, flow.destination);
+		traffic_header_t header;
+		header.magic = htonl(TRAFFIC_MAGIC);
+		header.flow_id = htons(flow.id);
+		header.src_tal_id = htons(this->tal_id);
+		header.timestamp_us = timestamp_us;
+		while(flow.credit_bits >= flow.next_size * 8)
+		{
+			header.sequence = htonl(flow.sequence++);
+			memcpy(frame + ETHERNET_2_HEADSIZE, &header, sizeof(header));
+			if(burst == nullptr)
+			{
+				burst = new NetBurst();
+			}
+			// the packet data is allocated in the buffers pool
+			burst->add(std::unique_ptr<NetPacket>(new NetPacket(frame, flow.next_size,
+			                                                    "Ethernet",
+			                                                    NET_PROTO::ETH,
+			                                                    flow.qos,
+			                                                    this->tal_id,
+			                                                    flow.destination,
+			                                                    ETHERNET_2_HEADSIZE)));
+			flow.credit_bits -= flow.next_size * 8;
+			flow.sent_bytes += flow.next_size;
+			flow.next_size = this->drawSize(flow);
+		}
+	}
+
+	if(burst != nullptr &&
+	   !this->enqueueMessage(std::unique_ptr<NetBurst>{burst}, 0, to_underlying(InternalMessageType::decap_data)))
+	{
+		LOG(this->log_receive, LEVEL_ERROR,
+		    "failed to send generated burst to lower layer\n");
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,264 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file BlockTraffic.h
+ * @brief Synthetic traffic generator and sink replacing the TAP interface
+ * @author Viveris Technologies
+ */
+
+#ifndef BLOCK_TRAFFIC_H
+#define BLOCK_TRAFFIC_H
+
+
+#include "OpenSandCore.h"
+
+#include <opensand_rt/Rt.h>
+#include <opensand_rt/RtChannel.h>
+#include <opensand_output/Output.h>
+
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+
+class NetBurst;
+
+
+struct traffic_specific
+{
+	tal_id_t tal_id = 0;
+};
+
+
+/// The distribution of the sizes of the generated frames
+enum class TrafficSizeDistribution
+{
+	/// Every frame has the minimum size
+	constant,
+	/// The sizes are uniformly drawn between the minimum and maximum sizes
+	uniform,
+	/// The minimum, middle and maximum sizes are drawn 7, 4 and 1 times in 12
+	imix,
+};
+
+
+/**
+ * @class BlockTraffic
+ * @brief Synthetic traffic generator and sink replacing BlockLanAdaptation
+ *        on top of BlockEncap.
+ *
+ * The downward channel is the generator: it paces the configured flows and
+ * sends Ethernet frames built in pooled buffers to the encapsulation. The
+ * upward channel is the sink: it measures the throughput, the losses and
+ * the one-way latency of each flow received from the encapsulation. The
+ * frames carry a flow ID, a sequence number and the emission time, the
+ * latency is only meaningful if the clocks of the entities are synchronized.
+ */
+class BlockTraffic: public Block
+{
+public:
+	BlockTraffic(const std::string &name, struct traffic_specific specific);
+
+	static void generateConfiguration();
+
+	/**
+	 * @brief Whether the generator and the sink replace the TAP interface
+	 *
+	 * @return true if the traffic generator is enabled in the profile
+	 */
+	static bool isEnabled();
+
+	bool onInit(void);
+
+
+	class Upward: public RtUpward
+	{
+	public:
+		Upward(const std::string &name, struct traffic_specific specific);
+
+		bool onInit(void);
+		bool onEvent(const RtEvent *const event);
+
+	private:
+		/// The counters and probes of a flow ID over a statistics period
+		struct FlowStats
+		{
+			std::size_t bytes = 0;
+			int packets = 0;
+			int lost = 0;
+			int reordered = 0;
+			double latency_sum = 0.0;
+			double latency_max = 0.0;
+
+			std::shared_ptr<Probe<int>> probe_throughput;
+			std::shared_ptr<Probe<int>> probe_packets;
+			std::shared_ptr<Probe<int>> probe_lost;
+			std::shared_ptr<Probe<int>> probe_reordered;
+			std::shared_ptr<Probe<float>> probe_latency;
+			std::shared_ptr<Probe<float>> probe_latency_max;
+		};
+
+		/**
+		 * @brief Register the probes of a flow ID
+		 *
+		 * @param stats   The flow statistics
+		 * @param prefix  The probes name prefix
+		 */
+		void initFlowStats(FlowStats &stats, const std::string &prefix);
+
+		/**
+		 * @brief Account the frames received from lower block and
+		 *        forward the ones addressed to other terminals
+		 *
+		 * @param burst  The burst of frames
+		 * @return true on success, false otherwise
+		 */
+		bool onMsgFromDown(NetBurst *burst);
+
+		/**
+		 * @brief Send the statistics of the last period and reset them
+		 */
+		void updateStats(void);
+
+		/**
+		 * @brief Send the statistics of a flow ID and reset them
+		 *
+		 * @param stats  The flow statistics
+		 */
+		void sendFlowStats(FlowStats &stats);
+
+		/// The MAC layer MAC id received through msg_link_up
+		tal_id_t tal_id;
+
+		/// State of the satellite link
+		SatelliteLinkState state;
+
+		/// statistic timer
+		event_id_t stats_timer;
+
+		/// The period for statistics update
+		time_ms_t stats_period_ms;
+
+		/// The next sequence number expected per source terminal and flow ID
+		std::map<std::pair<tal_id_t, uint16_t>, uint32_t> sequences;
+
+		/// The statistics of the measured flow IDs
+		std::vector<FlowStats> flows_stats;
+
+		/// The statistics of all the received frames
+		FlowStats total_stats;
+	};
+
+	class Downward: public RtDownward
+	{
+	public:
+		Downward(const std::string &name, struct traffic_specific specific);
+
+		bool onInit(void);
+		bool onEvent(const RtEvent *const event);
+
+	private:
+		/// A generated flow
+		struct Flow
+		{
+			uint16_t id;
+			tal_id_t destination;
+			qos_t qos;
+			uint32_t rate_kbps;
+			TrafficSizeDistribution distribution;
+			std::size_t min_size;
+			std::size_t max_size;
+
+			/// The sequence number of the next frame
+			uint32_t sequence;
+			/// The size of the next frame
+			std::size_t next_size;
+			/// The bits that may be sent before the next frame
+			double credit_bits;
+			/// The sizes generator, seeded per terminal and flow to be repeatable
+			std::minstd_rand random;
+
+			/// The bytes sent during the statistics period
+			std::size_t sent_bytes;
+			std::shared_ptr<Probe<int>> probe_throughput;
+		};
+
+		/**
+		 * @brief Read the flows to generate in the profile
+		 *
+		 * @return true on success, false otherwise
+		 */
+		bool initFlows(void);
+
+		/**
+		 * @brief Draw the size of the next frame of a flow
+		 *
+		 * @param flow  The flow
+		 * @return the frame size (bytes)
+		 */
+		std::size_t drawSize(Flow &flow);
+
+		/**
+		 * @brief Send to lower block the frames the flows are
+		 *        allowed to send since the previous tick
+		 *
+		 * @return true on success, false otherwise
+		 */
+		bool generate(void);
+
+		/// The entity tal_id, the sizes generators seed
+		tal_id_t tal_id;
+
+		/// State of the satellite link
+		SatelliteLinkState state;
+
+		/// The generation timer
+		event_id_t generation_timer;
+
+		/// The generation period
+		time_ms_t generation_period_ms;
+
+		/// The time of the previous generation
+		double last_generation_ms;
+
+		/// statistic timer
+		event_id_t stats_timer;
+
+		/// The period for statistics update
+		time_ms_t stats_period_ms;
+
+		/// The generated flows
+		std::vector<Flow> flows;
+	};
+};
+
+
+#endif
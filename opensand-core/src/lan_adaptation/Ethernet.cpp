@@ -47,6 +47,8 @@
 
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <chrono>
 #include <arpa/inet.h>
 
 
@@ -81,6 +83,19 @@ void Ethernet::generateConfiguration()
 	evcs->addParameter("tci_802_1ad", "TCI of the 802.1ad tag", types->getType("int"));
 	evcs->addParameter("protocol", "Inner Payload Type", types->getType("string"), "2 Bytes Hexadecimal value");
 
+	auto rules = conf->addList("flow_rules", "Flow Rules", "flow_rule",
+	                           "The classification of the IP flows, the first matching rule is applied")->getPattern();
+	rules->setAdvanced(true);
+	rules->addParameter("src_network", "Source Network", types->getType("string"),
+	                    "IPv4 or IPv6 network in CIDR notation, empty for any address");
+	rules->addParameter("dst_network", "Destination Network", types->getType("string"),
+	                    "IPv4 or IPv6 network in CIDR notation, empty for any address");
+	rules->addParameter("protocol", "IP Protocol", types->getType("int"), "0 for any protocol");
+	rules->addParameter("src_port", "Source Port", types->getType("int"), "0 for any port");
+	rules->addParameter("dst_port", "Destination Port", types->getType("int"), "0 for any port");
+	rules->addParameter("pcp", "PCP", types->getType("int"), "The PCP of the QoS class given to the flow");
+	rules->addParameter("dscp", "DSCP", types->getType("int"), "The DSCP written in the packets, -1 to keep it");
+
 	auto settings = conf->addComponent("qos_settings", "QoS Settings");
 	settings->addParameter("lan_frame_type", "Lan Frame Type", types->getType("frame_type"),
 	                       "The type of 802.1 Ethernet extension transmitted to network");
@@ -140,7 +155,13 @@ bool Ethernet::init()
 }
 
 Ethernet::Context::Context(LanAdaptationPlugin &plugin):
-	LanAdaptationContext(plugin)
+	LanAdaptationContext(plugin),
+	evc_map{},
+	evc_ids{},
+	evc_data_size{},
+	category_map{},
+	default_category{nullptr},
+	flow_classifier{}
 {
 }
 
@@ -187,6 +208,13 @@ bool Ethernet::Context::init()
 		return false;
 	}
 
+	if(!this->initFlowRules())
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "cannot Initialize flow rules\n");
+		return false;
+	}
+
 	if(lan_eth == "Ethernet")
 	{
 		LOG(this->log, LEVEL_INFO,
@@ -242,19 +270,18 @@ bool Ethernet::Context::init()
 
 Ethernet::Context::~Context()
 {
-	std::map<uint8_t, Evc *>::iterator evc_it;
-	std::map<qos_t, TrafficCategory *>::iterator cat_it;
-	for(evc_it = this->evc_map.begin(); evc_it != this->evc_map.end(); ++evc_it)
+	for(uint8_t id : this->evc_ids)
 	{
-		delete (*evc_it).second;
+		delete this->evc_map[id];
+		this->evc_map[id] = nullptr;
 	}
-	this->evc_map.clear();
-	
-	for(cat_it = this->category_map.begin(); cat_it != this->category_map.end(); ++cat_it)
+	this->evc_ids.clear();
+
+	for(auto &category : this->category_map)
 	{
-		delete (*cat_it).second;
+		delete category;
+		category = nullptr;
 	}
-	this->category_map.clear();
 
 	this->probe_evc_throughput.clear();
 	this->probe_evc_size.clear();
@@ -331,7 +358,7 @@ bool Ethernet::Context::initEvc()
 		    mac_src->str().c_str(), mac_dst->str().c_str(),
 		    q_tci, ad_tci, pt);
 
-		if(this->evc_map.find(id) != this->evc_map.end())
+		if(this->evc_map[id] != nullptr)
 		{
 			LOG(this->log, LEVEL_ERROR,
 			    "Duplicated ID %u in Ethernet Virtual Connections\n", id);
@@ -340,6 +367,10 @@ bool Ethernet::Context::initEvc()
 
 		Evc *evc = new Evc(mac_src, mac_dst, q_tci, ad_tci, to_enum<NET_PROTO>(pt));
 		this->evc_map[id] = evc;
+		this->evc_ids.insert(std::lower_bound(this->evc_ids.begin(),
+		                                      this->evc_ids.end(),
+		                                      id),
+		                     id);
 	}
 	// initialize the statistics on EVC
 	this->initStats();
@@ -388,10 +419,19 @@ bool Ethernet::Context::initTrafficCategories()
 			return false;
 		}
 
-		if(this->category_map.count(pcp))
+		if(pcp < 0 || pcp >= static_cast<int>(pcp_count))
 		{
 			LOG(this->log, LEVEL_ERROR,
-			    "Traffic category %ld - [%s] rejected: identifier "
+			    "Traffic category %d - [%s] rejected: the PCP "
+			    "must be between 0 and %zu\n", pcp,
+			    class_name.c_str(), pcp_count - 1);
+			return false;
+		}
+
+		if(this->category_map[pcp] != nullptr)
+		{
+			LOG(this->log, LEVEL_ERROR,
+			    "Traffic category %d - [%s] rejected: identifier "
 			    "already exists for [%s]\n", pcp,
 			    class_name.c_str(),
 			    this->category_map[pcp]->getName().c_str());
@@ -414,19 +454,100 @@ bool Ethernet::Context::initTrafficCategories()
 		return false;
 	}
 
-	auto found_default_category = this->category_map.find(default_category);
-	if (found_default_category == this->category_map.end())
+	if(default_category < 0 || default_category >= static_cast<int>(pcp_count) ||
+	   this->category_map[default_category] == nullptr)
 	{
 		LOG(this->log, LEVEL_ERROR,
 		    "Default PCP level does not map to a registered traffic category");
 		return false;
 	}
-	this->default_category = found_default_category->second;
+	this->default_category = this->category_map[default_category];
 	
 	return true;
 }
 
 
+bool Ethernet::Context::initFlowRules()
+{
+	auto network = OpenSandModelConf::Get()->getProfileData()->getComponent("network");
+
+	for(auto& item : network->getList("flow_rules")->getItems())
+	{
+		auto rule_conf = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(item);
+
+		std::string src_network;
+		std::string dst_network;
+		int protocol;
+		int src_port;
+		int dst_port;
+		int pcp;
+		int dscp;
+		if(!OpenSandModelConf::extractParameterData(rule_conf->getParameter("src_network"), src_network) ||
+		   !OpenSandModelConf::extractParameterData(rule_conf->getParameter("dst_network"), dst_network) ||
+		   !OpenSandModelConf::extractParameterData(rule_conf->getParameter("protocol"), protocol) ||
+		   !OpenSandModelConf::extractParameterData(rule_conf->getParameter("src_port"), src_port) ||
+		   !OpenSandModelConf::extractParameterData(rule_conf->getParameter("dst_port"), dst_port) ||
+		   !OpenSandModelConf::extractParameterData(rule_conf->getParameter("pcp"), pcp) ||
+		   !OpenSandModelConf::extractParameterData(rule_conf->getParameter("dscp"), dscp))
+		{
+			LOG(this->log, LEVEL_ERROR,
+			    "Section network, missing flow rule parameter\n");
+			return false;
+		}
+
+		FlowRule rule;
+		uint8_t src_version;
+		uint8_t dst_version;
+		if(!FlowClassifier::parseNetwork(src_network, src_version, rule.src_addr, rule.src_prefix) ||
+		   !FlowClassifier::parseNetwork(dst_network, dst_version, rule.dst_addr, rule.dst_prefix) ||
+		   (src_version != 0 && dst_version != 0 && src_version != dst_version))
+		{
+			LOG(this->log, LEVEL_ERROR,
+			    "Flow rule rejected: bad networks '%s' and '%s'\n",
+			    src_network.c_str(), dst_network.c_str());
+			return false;
+		}
+		if(protocol < 0 || protocol > UINT8_MAX ||
+		   src_port < 0 || src_port > UINT16_MAX ||
+		   dst_port < 0 || dst_port > UINT16_MAX ||
+		   pcp < 0 || pcp >= static_cast<int>(pcp_count) ||
+		   dscp < -1 || dscp > 63)
+		{
+			LOG(this->log, LEVEL_ERROR,
+			    "Flow rule rejected: protocol %d, ports %d and %d, "
+			    "PCP %d or DSCP %d out of range\n",
+			    protocol, src_port, dst_port, pcp, dscp);
+			return false;
+		}
+		rule.version = src_version != 0 ? src_version : dst_version;
+		rule.protocol = protocol;
+		rule.src_port = src_port;
+		rule.dst_port = dst_port;
+		rule.pcp = pcp;
+		rule.dscp = dscp;
+
+		LOG(this->log, LEVEL_INFO,
+		    "New flow rule: source = '%s' port %d, destination '%s' port %d, "
+		    "protocol %d => PCP %d, DSCP %d\n",
+		    src_network.c_str(), src_port, dst_network.c_str(), dst_port,
+		    protocol, pcp, dscp);
+		this->flow_classifier.addRule(rule);
+	}
+	return true;
+}
+
+
+TrafficCategory *Ethernet::Context::getCategory(qos_t pcp) const
+{
+	TrafficCategory *category = nullptr;
+	if(pcp < pcp_count)
+	{
+		category = this->category_map[pcp];
+	}
+	return category != nullptr ? category : this->default_category;
+}
+
+
 bool Ethernet::Context::initLanAdaptationContext(tal_id_t tal_id, PacketSwitch *packet_switch)
 {
 	return LanAdaptationPlugin::LanAdaptationContext::initLanAdaptationContext(tal_id, packet_switch);
@@ -436,8 +557,6 @@ bool Ethernet::Context::initLanAdaptationContext(tal_id_t tal_id, PacketSwitch *
 NetBurst *Ethernet::Context::encapsulate(NetBurst *burst,
                                          std::map<long, int> &UNUSED(time_contexts))
 {
-	NetBurst::iterator packet;
-
 	if(this->current_upper)
 	{
 		LOG(this->log, LEVEL_INFO,
@@ -464,175 +583,220 @@ NetBurst *Ethernet::Context::encapsulate(NetBurst *burst,
 		return nullptr;
 	}
 
+	this->startPackets();
 	for(auto&& packet : *burst)
 	{
-		std::unique_ptr<NetPacket> eth_frame;
-		uint8_t evc_id = 0;
-
-		if(this->current_upper)
+		this->encapsulatePacket(packet);
+		if(packet)
 		{
-			// we have to create the Ethernet header from scratch,
-			// try to find an EVC and create the header with given information
-			eth_frame = this->createEthFrameData(packet, evc_id);
-			if(!eth_frame)
-			{
-				continue;
-			}
+			eth_frames->add(std::move(packet));
 		}
-		else
+	}
+	LOG(this->log, LEVEL_INFO,
+	    "encapsulate %zu Ethernet frames\n", eth_frames->size());
+
+	// delete the burst and all frames in it
+	delete burst;
+
+	// avoid returning empty bursts
+	if(eth_frames->size() > 0)
+	{
+		return eth_frames;
+	}
+	delete eth_frames;
+	return nullptr;
+}
+
+
+bool Ethernet::Context::canEncapsulatePacket() const
+{
+	return true;
+}
+
+
+void Ethernet::Context::startPackets()
+{
+	// the flows age with a time read once per burst
+	if(!this->flow_classifier.empty())
+	{
+		this->flow_classifier.setTime(std::chrono::steady_clock::now());
+	}
+}
+
+
+void Ethernet::Context::encapsulatePacket(std::unique_ptr<NetPacket> &packet)
+{
+	std::unique_ptr<NetPacket> eth_frame;
+	uint8_t evc_id = 0;
+
+	if(this->current_upper)
+	{
+		// we have to create the Ethernet header from scratch,
+		// try to find an EVC and create the header with given information
+		eth_frame = this->createEthFrameData(packet, evc_id);
+		if(!eth_frame)
 		{
-			size_t header_length;
-			NET_PROTO ether_type = Ethernet::getPayloadEtherType(packet->getData());
-			NET_PROTO frame_type = Ethernet::getFrameType(packet->getData());
-			MacAddress src_mac = Ethernet::getSrcMac(packet->getData());
-			MacAddress dst_mac = Ethernet::getDstMac(packet->getData());
-			tal_id_t src = 255 ;
-			tal_id_t dst = 255;
-			uint16_t q_tci = Ethernet::getQTci(packet->getData());
-			uint16_t ad_tci = Ethernet::getAdTci(packet->getData());
-			qos_t pcp = (q_tci & 0xe000) >> 13;
-			qos_t qos = 0;
-			Evc *evc;
-			SarpTable *sarp_table = packet_switch->getSarpTable();
-
-			// Do not print errors here because we may want to reject trafic as spanning
-			// tree coming from miscellaneous host
-			if(!packet_switch->getPacketDestination(packet->getData(), src, dst))
-			{
-				// check default tal_id
-				if(dst > BROADCAST_TAL_ID)
-				{
-					LOG(this->log, LEVEL_WARNING,
-					    "cannot find destination MAC address %s in sarp table\n",
-					    dst_mac.str().c_str());
-					continue;
-				}
-				else
-				{
-					LOG(this->log, LEVEL_NOTICE,
-					    "cannot find destination tal ID, use default (%u)\n",
-					    dst);
-				}
-			}
-			LOG(this->log, LEVEL_INFO,
-			    "build Ethernet frame with source MAC %s corresponding "
-			    " to terminal ID %d and destination MAC %s corresponding "
-			    "to terminal ID %d\n",
-			    src_mac.str().c_str(), src, dst_mac.str().c_str(), dst);
+			packet.reset();
+			return;
+		}
+	}
+	else
+	{
+		const Data &data = packet->getData();
+		EthernetFrameView frame{data};
+		size_t header_length = frame.getHeaderLength();
+		NET_PROTO ether_type = frame.getPayloadEtherType();
+		NET_PROTO frame_type = frame.getFrameType();
+		MacAddress src_mac = frame.getSrcMac();
+		MacAddress dst_mac = frame.getDstMac();
+		tal_id_t src = 255 ;
+		tal_id_t dst = 255;
+		uint16_t q_tci = frame.getQTci();
+		uint16_t ad_tci = frame.getAdTci();
+		qos_t pcp = frame.getPcp();
+		qos_t qos = 0;
+		Evc *evc;
 
-			switch(frame_type)
+		// Do not print errors here because we may want to reject trafic as spanning
+		// tree coming from miscellaneous host
+		if(!packet_switch->getPacketDestination(data, src, dst))
+		{
+			// check default tal_id
+			if(dst > BROADCAST_TAL_ID)
 			{
-				case NET_PROTO::ETH:
-					header_length = ETHERNET_2_HEADSIZE;
-					evc = this->getEvc(src_mac, dst_mac, ether_type, evc_id);
-					qos = this->default_category->getId();
-					break;
-				case NET_PROTO::IEEE_802_1Q:
-					header_length = ETHERNET_802_1Q_HEADSIZE;
-					evc = this->getEvc(src_mac, dst_mac, q_tci, ether_type, evc_id);
-					LOG(this->log, LEVEL_INFO,
-					    "TCI = %u\n", q_tci);
-					break;
-				case NET_PROTO::IEEE_802_1AD:
-					header_length = ETHERNET_802_1AD_HEADSIZE;
-					evc = this->getEvc(src_mac, dst_mac, q_tci, ad_tci, ether_type, evc_id);
-					LOG(this->log, LEVEL_INFO,
-					    "Outer TCI = %u, Inner TCI = %u\n", ad_tci, q_tci);
-					break;
-				default:
-					LOG(this->log, LEVEL_ERROR,
-					    "wrong Ethernet frame type 0x%.4x\n", frame_type);
-					continue;
+				LOG(this->log, LEVEL_WARNING,
+				    "cannot find destination MAC address %s in sarp table\n",
+				    dst_mac.str().c_str());
+				packet.reset();
+				return;
 			}
-			if(!evc)
+			else
 			{
-				LOG(this->log, LEVEL_INFO,
-				    "cannot find EVC for this flow, use the default values\n");
+				LOG(this->log, LEVEL_NOTICE,
+				    "cannot find destination tal ID, use default (%u)\n",
+				    dst);
 			}
+		}
+		LOG(this->log, LEVEL_INFO,
+		    "build Ethernet frame with source MAC %s corresponding "
+		    " to terminal ID %d and destination MAC %s corresponding "
+		    "to terminal ID %d\n",
+		    src_mac.str().c_str(), src, dst_mac.str().c_str(), dst);
 
-			if(frame_type != NET_PROTO::ETH)
-			{
-				// get the QoS from the PCP if there is a PCP
-				auto found_category = this->category_map.find(pcp);
-				if (found_category == this->category_map.end())
-				{
-					qos = this->default_category->getId();
-				}
-				else
-				{
-					qos = found_category->second->getId();
-				}
+		switch(frame_type)
+		{
+			case NET_PROTO::ETH:
+				evc = this->getEvc(src_mac, dst_mac, ether_type, evc_id);
+				qos = this->default_category->getId();
+				break;
+			case NET_PROTO::IEEE_802_1Q:
+				evc = this->getEvc(src_mac, dst_mac, q_tci, ether_type, evc_id);
 				LOG(this->log, LEVEL_INFO,
-				    "PCP = %u corresponding to queue %s (%u)\n", pcp,
-				    found_category->second->getName().c_str(), qos);
-			}
+				    "TCI = %u\n", q_tci);
+				break;
+			case NET_PROTO::IEEE_802_1AD:
+				evc = this->getEvc(src_mac, dst_mac, q_tci, ad_tci, ether_type, evc_id);
+				LOG(this->log, LEVEL_INFO,
+				    "Outer TCI = %u, Inner TCI = %u\n", ad_tci, q_tci);
+				break;
+			default:
+				LOG(this->log, LEVEL_ERROR,
+				    "wrong Ethernet frame type 0x%.4x\n", frame_type);
+				packet.reset();
+				return;
+		}
+		if(!evc)
+		{
+			LOG(this->log, LEVEL_INFO,
+			    "cannot find EVC for this flow, use the default values\n");
+		}
 
-			if(frame_type != this->sat_frame_type)
-			{
-				if(evc)
-				{
-					// Retrieve every field, we may already have it but no need to
-					// handle every condition if we do that
-					q_tci = (evc->getQTci() & 0xffff);
-					ad_tci = (evc->getAdTci() & 0xffff);
-					qos_t pcp = (evc->getQTci() & 0xe000) > 13;
-					auto found_category = this->category_map.find(pcp);
-					if (found_category == this->category_map.end())
-					{
-						qos = this->default_category->getId();
-					}
-					else
-					{
-						qos = found_category->second->getId();
-					}
-					LOG(this->log, LEVEL_INFO,
-					    "PCP in EVC is %u corresponding to QoS %u for DVB layer\n",
-					    pcp, qos);
-				}
-				// TODO we should cast to an EthernetPacket and use getPayload instead
-				eth_frame = this->createEthFrameData(packet->getData().substr(header_length),
-				                                     src_mac, dst_mac,
-				                                     ether_type,
-				                                     q_tci, ad_tci,
-				                                     qos, src, dst,
-				                                     this->sat_frame_type);
-			}
-			else
-			{
-				eth_frame = this->createPacket(packet->getData(),
-				                               packet->getTotalLength(),
-				                               qos, src, dst);
-			}
+		if(frame_type != NET_PROTO::ETH)
+		{
+			// get the QoS from the PCP if there is a PCP
+			TrafficCategory *category = this->getCategory(pcp);
+			qos = category->getId();
+			LOG(this->log, LEVEL_INFO,
+			    "PCP = %u corresponding to queue %s (%u)\n", pcp,
+			    category->getName().c_str(), qos);
+		}
+
+		if(frame_type != this->sat_frame_type && evc)
+		{
+			// Retrieve every field, we may already have it but no need to
+			// handle every condition if we do that
+			q_tci = (evc->getQTci() & 0xffff);
+			ad_tci = (evc->getAdTci() & 0xffff);
+			qos_t pcp = (evc->getQTci() & 0xe000) >> 13;
+			qos = this->getCategory(pcp)->getId();
+			LOG(this->log, LEVEL_INFO,
+			    "PCP in EVC is %u corresponding to QoS %u for DVB layer\n",
+			    pcp, qos);
+		}
 
-			if(eth_frame == nullptr)
+		// the flow rules come last as they are the most specific
+		const FlowRule *rule = nullptr;
+		FlowKey flow;
+		if(!this->flow_classifier.empty() &&
+		   FlowClassifier::getKey(data.c_str() + header_length,
+		                          data.length() - header_length,
+		                          ether_type, flow))
+		{
+			rule = this->flow_classifier.classify(flow);
+		}
+		Data remarked;
+		const Data *frame_data = &data;
+		if(rule != nullptr)
+		{
+			qos = this->getCategory(rule->pcp)->getId();
+			if(rule->dscp >= 0)
 			{
-				LOG(this->log, LEVEL_ERROR,
-				    "cannot create the Ethernet frame\n");
-				continue;
+				remarked = data;
+				FlowClassifier::remark(&remarked[header_length], ether_type, rule->dscp);
+				frame_data = &remarked;
 			}
+			LOG(this->log, LEVEL_INFO,
+			    "flow rule gives PCP %u corresponding to QoS %u for DVB layer\n",
+			    rule->pcp, qos);
 		}
 
-		if(this->evc_data_size.find(evc_id) == this->evc_data_size.end())
+		if(frame_type != this->sat_frame_type)
 		{
-			// create the element
-			this->evc_data_size[evc_id] = 0;
+			// TODO we should cast to an EthernetPacket and use getPayload instead
+			eth_frame = this->createEthFrameData(frame_data->substr(header_length),
+			                                     src_mac, dst_mac,
+			                                     ether_type,
+			                                     q_tci, ad_tci,
+			                                     qos, src, dst,
+			                                     this->sat_frame_type);
+		}
+		else if(frame_data == &data && packet->getType() == frame_type)
+		{
+			// the frame is unchanged and already built by this plugin,
+			// as the forwarded ones, only its metadata are updated
+			packet->setQos(qos);
+			packet->setSrcTalId(src);
+			packet->setDstTalId(dst);
+			eth_frame = std::move(packet);
+		}
+		else
+		{
+			eth_frame = this->createPacket(*frame_data,
+			                               packet->getTotalLength(),
+			                               qos, src, dst);
 		}
-		this->evc_data_size[evc_id] += eth_frame->getTotalLength();
-		eth_frames->add(std::move(eth_frame));
-	}
-	LOG(this->log, LEVEL_INFO,
-	    "encapsulate %zu Ethernet frames\n", eth_frames->size());
-
-	// delete the burst and all frames in it
-	delete burst;
 
-	// avoid returning empty bursts
-	if(eth_frames->size() > 0)
-	{
-		return eth_frames;
+		if(eth_frame == nullptr)
+		{
+			LOG(this->log, LEVEL_ERROR,
+			    "cannot create the Ethernet frame\n");
+			packet.reset();
+			return;
+		}
 	}
-	delete eth_frames;
-	return nullptr;
+
+	this->evc_data_size[evc_id] += eth_frame->getTotalLength();
+	packet = std::move(eth_frame);
 }
 
 
@@ -668,29 +832,28 @@ NetBurst *Ethernet::Context::deencapsulate(NetBurst *burst)
 	{
 		std::unique_ptr<NetPacket> deenc_packet;
 		size_t data_length = packet->getTotalLength();
-		MacAddress dst_mac = Ethernet::getDstMac(packet->getData());
-		MacAddress src_mac = Ethernet::getSrcMac(packet->getData());
-		uint16_t q_tci = Ethernet::getQTci(packet->getData());
-		uint16_t ad_tci = Ethernet::getAdTci(packet->getData());
-		NET_PROTO ether_type = Ethernet::getPayloadEtherType(packet->getData());
-		NET_PROTO frame_type = Ethernet::getFrameType(packet->getData());
+		const Data &data = packet->getData();
+		EthernetFrameView frame{data};
+		MacAddress dst_mac = frame.getDstMac();
+		MacAddress src_mac = frame.getSrcMac();
+		uint16_t q_tci = frame.getQTci();
+		uint16_t ad_tci = frame.getAdTci();
+		NET_PROTO ether_type = frame.getPayloadEtherType();
+		NET_PROTO frame_type = frame.getFrameType();
 		Evc *evc;
-		size_t header_length;
+		size_t header_length = frame.getHeaderLength();
 		uint8_t evc_id = 0;
 		SarpTable *sarp_table = packet_switch->getSarpTable();
 
 		switch(frame_type)
 		{
 			case NET_PROTO::ETH:
-				header_length = ETHERNET_2_HEADSIZE;
 				evc = this->getEvc(src_mac, dst_mac, ether_type, evc_id);
 				break;
 			case NET_PROTO::IEEE_802_1Q:
-				header_length = ETHERNET_802_1Q_HEADSIZE;
 				evc = this->getEvc(src_mac, dst_mac, q_tci, ether_type, evc_id);
 				break;
 			case NET_PROTO::IEEE_802_1AD:
-				header_length = ETHERNET_802_1AD_HEADSIZE;
 				evc = this->getEvc(src_mac, dst_mac, q_tci, ad_tci, ether_type, evc_id);
 				break;
 			default:
@@ -700,10 +863,6 @@ NetBurst *Ethernet::Context::deencapsulate(NetBurst *burst)
 				continue;
 		}
 
-		if(this->evc_data_size.find(evc_id) == this->evc_data_size.end())
-		{
-			this->evc_data_size[evc_id] = 0;
-		}
 		this->evc_data_size[evc_id] += data_length;
 
 		LOG(this->log, LEVEL_INFO,
@@ -762,7 +921,7 @@ NetBurst *Ethernet::Context::deencapsulate(NetBurst *burst)
 					ad_tci = (evc->getAdTci() & 0xffff);
 				}
 				// TODO we should cast to an EthernetPacket and use getPayload instead
-				deenc_packet = this->createEthFrameData(packet->getData().substr(header_length),
+				deenc_packet = this->createEthFrameData(data.substr(header_length),
 				                                        src_mac, dst_mac,
 				                                        ether_type,
 				                                        q_tci, ad_tci,
@@ -774,7 +933,7 @@ NetBurst *Ethernet::Context::deencapsulate(NetBurst *burst)
 			else
 			{
 				// create ETH packet
-				deenc_packet = this->createPacket(packet->getData(),
+				deenc_packet = this->createPacket(data,
 				                                  data_length,
 				                                  packet->getQos(),
 				                                  packet->getSrcTalId(),
@@ -818,12 +977,12 @@ std::unique_ptr<NetPacket> Ethernet::Context::createEthFrameData(const std::uniq
 
 	// search traffic category associated with QoS value
 	// TODO we should filter on IP addresses instead of QoS
-	for(std::map<qos_t, TrafficCategory *>::const_iterator it = this->category_map.begin();
-	    it != this->category_map.end(); ++it)
+	for(qos_t pcp = 0; pcp < pcp_count; ++pcp)
 	{
-		if((*it).second->getId() == qos)
+		const TrafficCategory *category = this->category_map[pcp];
+		if(category != nullptr && category->getId() == qos)
 		{
-			ad_tci = (*it).first;
+			ad_tci = pcp;
 		}
 	}
 
@@ -891,7 +1050,7 @@ std::unique_ptr<NetPacket> Ethernet::Context::createEthFrameData(const std::uniq
 }
 
 
-std::unique_ptr<NetPacket> Ethernet::Context::createEthFrameData(Data data,
+std::unique_ptr<NetPacket> Ethernet::Context::createEthFrameData(const Data &data,
                                                                  MacAddress src_mac,
                                                                  MacAddress dst_mac,
                                                                  NET_PROTO ether_type,
@@ -907,6 +1066,7 @@ std::unique_ptr<NetPacket> Ethernet::Context::createEthFrameData(Data data,
 	eth_1ad_header_t *eth_1ad_hdr;
 
 	unsigned char header[ETHERNET_802_1AD_HEADSIZE];
+	std::size_t header_length;
 	uint16_t ether_type_value = to_underlying(ether_type);
 
 	// common part for all header
@@ -916,12 +1076,12 @@ std::unique_ptr<NetPacket> Ethernet::Context::createEthFrameData(Data data,
 		eth_2_hdr->ether_dhost[i] = dst_mac.at(i);
 		eth_2_hdr->ether_shost[i] = src_mac.at(i);
 	}
-	// build eth frame : header + whole IP packet
+	// build the header matching the frame type
 	switch(desired_frame_type)
 	{
 		case NET_PROTO::ETH:
 			eth_2_hdr->ether_type = htons(ether_type_value);
-			data.insert(0, header, ETHERNET_2_HEADSIZE);
+			header_length = ETHERNET_2_HEADSIZE;
 			LOG(this->log, LEVEL_INFO,
 			    "create an Ethernet frame with src = %s, "
 			    "dst = %s\n", src_mac.str().c_str(), dst_mac.str().c_str());
@@ -931,7 +1091,7 @@ std::unique_ptr<NetPacket> Ethernet::Context::createEthFrameData(Data data,
 			eth_1q_hdr->TPID = htons(to_underlying(NET_PROTO::IEEE_802_1Q));
 			eth_1q_hdr->TCI.tci = htons(q_tci);
 			eth_1q_hdr->ether_type = htons(ether_type_value);
-			data.insert(0, header, ETHERNET_802_1Q_HEADSIZE);
+			header_length = ETHERNET_802_1Q_HEADSIZE;
 			LOG(this->log, LEVEL_INFO,
 			    "create a 802.1Q frame with src = %s, "
 			    "dst = %s, VLAN ID = %d\n", src_mac.str().c_str(),
@@ -946,7 +1106,7 @@ std::unique_ptr<NetPacket> Ethernet::Context::createEthFrameData(Data data,
 			eth_1ad_hdr->inner_TPID = htons(to_underlying(NET_PROTO::IEEE_802_1Q));
 			eth_1ad_hdr->inner_TCI.tci = htons(q_tci);
 			eth_1ad_hdr->ether_type = htons(ether_type_value);
-			data.insert(0, header, ETHERNET_802_1AD_HEADSIZE);
+			header_length = ETHERNET_802_1AD_HEADSIZE;
 			LOG(this->log, LEVEL_INFO,
 			    "create a 802.1AD frame with src = %s, "
 			    "dst = %s, q-tag = %u, ad-tag = %u\n",
@@ -958,7 +1118,9 @@ std::unique_ptr<NetPacket> Ethernet::Context::createEthFrameData(Data data,
 			    desired_frame_type);
 			return NULL;
 	}
-	return this->createPacket(data, data.length(), qos,
+	// build eth frame : header + whole IP packet in a single copy
+	Data frame{header, header_length, data};
+	return this->createPacket(frame, frame.length(), qos,
 	                          src_tal_id, dst_tal_id);
 
 }
@@ -991,11 +1153,10 @@ void Ethernet::Context::initStats()
 		output->registerProbe<float>("EVC frame size.default",
 		                             "Bytes", true, SAMPLE_SUM);
 
-	for(std::map<uint8_t, Evc *>::const_iterator it = this->evc_map.begin();
-	    it != this->evc_map.end(); ++it)
+	for(uint8_t evc_id : this->evc_ids)
 	{
 		char probe_name[128];
-		id = (*it).first;
+		id = evc_id;
 		if(this->probe_evc_throughput.find(id) != this->probe_evc_throughput.end())
 		{
 			continue;
@@ -1014,22 +1175,14 @@ void Ethernet::Context::initStats()
 
 void Ethernet::Context::updateStats(unsigned int period)
 {
-	std::map<uint8_t, size_t>::iterator it;
-	std::map<uint8_t, Probe<float> *>::iterator found;
-	uint8_t id;
-	std::stringstream name;
-
-	for(it = this->evc_data_size.begin(); it != this->evc_data_size.end(); ++it)
+	// the frames are only accounted on the default id or on a configured EVC
+	for(auto &probe : this->probe_evc_throughput)
 	{
-		id = (*it).first;
-		if(this->probe_evc_throughput.find(id) == this->probe_evc_throughput.end())
-		{
-			// use the default id
-			id = 0;
-		}
-		this->probe_evc_throughput[id]->put((*it).second * 8 / period);
-		this->probe_evc_size[id]->put((*it).second);
-		(*it).second = 0;
+		uint8_t id = probe.first;
+		size_t &data_size = this->evc_data_size[id];
+		probe.second->put(data_size * 8 / period);
+		this->probe_evc_size[id]->put(data_size);
+		data_size = 0;
 	}
 }
 
@@ -1039,21 +1192,10 @@ std::unique_ptr<NetPacket> Ethernet::PacketHandler::build(const Data &data,
                                                           uint8_t src_tal_id,
                                                           uint8_t dst_tal_id) const
 {
-	size_t head_length = 0;
-	NET_PROTO frame_type = Ethernet::getFrameType(data);
-	switch(frame_type)
-	{
-		case NET_PROTO::IEEE_802_1Q:
-			head_length = ETHERNET_802_1Q_HEADSIZE;
-			break;
-		case NET_PROTO::IEEE_802_1AD:
-			head_length = ETHERNET_802_1AD_HEADSIZE;
-			break;
-		// Ethernet packet, this is the ethertype of the payload
-		default:
-			head_length = ETHERNET_2_HEADSIZE;
-			break;
-	}
+	EthernetFrameView frame{data};
+	NET_PROTO frame_type = frame.getFrameType();
+	// keep the Ethernet II header length on truncated frames
+	size_t head_length = frame.isValid() ? frame.getHeaderLength() : ETHERNET_2_HEADSIZE;
 
 	return std::unique_ptr<NetPacket>(new NetPacket(data, data_length,
 	                                                this->getName(),
@@ -1069,13 +1211,13 @@ Evc *Ethernet::Context::getEvc(const MacAddress src_mac,
                                NET_PROTO ether_type,
                                uint8_t &evc_id) const
 {
-	for(std::map<uint8_t, Evc *>::const_iterator it = this->evc_map.begin();
-	    it != this->evc_map.end(); ++it)
+	for(uint8_t id : this->evc_ids)
 	{
-		if((*it).second->matches(&src_mac, &dst_mac, ether_type))
+		Evc *evc = this->evc_map[id];
+		if(evc->matches(&src_mac, &dst_mac, ether_type))
 		{
-			evc_id = (*it).first;
-			return (*it).second;
+			evc_id = id;
+			return evc;
 		}
 	}
 	return NULL;
@@ -1088,13 +1230,13 @@ Evc *Ethernet::Context::getEvc(const MacAddress src_mac,
                                NET_PROTO ether_type,
                                uint8_t &evc_id) const
 {
-	for(std::map<uint8_t, Evc *>::const_iterator it = this->evc_map.begin();
-	    it != this->evc_map.end(); ++it)
+	for(uint8_t id : this->evc_ids)
 	{
-		if((*it).second->matches(&src_mac, &dst_mac, q_tci, ether_type))
+		Evc *evc = this->evc_map[id];
+		if(evc->matches(&src_mac, &dst_mac, q_tci, ether_type))
 		{
-			evc_id = (*it).first;
-			return (*it).second;
+			evc_id = id;
+			return evc;
 		}
 	}
 	return NULL;
@@ -1108,169 +1250,57 @@ Evc *Ethernet::Context::getEvc(const MacAddress src_mac,
                                NET_PROTO ether_type,
                                uint8_t &evc_id) const
 {
-	for(std::map<uint8_t, Evc *>::const_iterator it = this->evc_map.begin();
-	    it != this->evc_map.end(); ++it)
+	for(uint8_t id : this->evc_ids)
 	{
-		if((*it).second->matches(&src_mac, &dst_mac, q_tci, ad_tci, ether_type))
+		Evc *evc = this->evc_map[id];
+		if(evc->matches(&src_mac, &dst_mac, q_tci, ad_tci, ether_type))
 		{
-			evc_id = (*it).first;
-			return (*it).second;
+			evc_id = id;
+			return evc;
 		}
 	}
 	return NULL;
 }
 
 
-// TODO ENDIANESS !
 NET_PROTO Ethernet::getFrameType(const Data &data)
 {
-	NET_PROTO ether_type = NET_PROTO::ERROR;
-	NET_PROTO ether_type2 = NET_PROTO::ERROR;
-	if(data.length() < 13)
+	EthernetFrameView frame{data};
+	if(!frame.isValid())
 	{
 		DFLTLOG(LEVEL_ERROR,
 		        "cannot retrieve EtherType in Ethernet header\n");
-		return NET_PROTO::ERROR;
-	}
-	// read ethertype: 2 bytes at a 12 bytes offset
-	ether_type = to_enum<NET_PROTO>(static_cast<uint16_t>((data.at(12) << 8) | data.at(13)));
-	ether_type2 = to_enum<NET_PROTO>(static_cast<uint16_t>((data.at(16) << 8) | data.at(17)));
-	if(ether_type != NET_PROTO::IEEE_802_1Q && ether_type != NET_PROTO::IEEE_802_1AD)
-	{
-		ether_type = NET_PROTO::ETH;
 	}
-	// TODO: we need the following part because we use two 802.1Q tags for kernel support
-	else if(ether_type == NET_PROTO::IEEE_802_1Q && ether_type2 == NET_PROTO::IEEE_802_1Q)
-	{
-		ether_type = NET_PROTO::IEEE_802_1AD;
-	}
-	return ether_type;
+	return frame.getFrameType();
 }
 
 NET_PROTO Ethernet::getPayloadEtherType(const Data &data)
 {
-	NET_PROTO ether_type = NET_PROTO::ERROR;
-	if(data.length() < 13)
+	EthernetFrameView frame{data};
+	if(!frame.isValid())
 	{
 		DFLTLOG(LEVEL_ERROR,
 		        "cannot retrieve EtherType in Ethernet header\n");
-		return NET_PROTO::ERROR;
 	}
-	// read ethertype: 2 bytes at a 12 bytes offset
-	ether_type = to_enum<NET_PROTO>(static_cast<uint16_t>((data.at(12) << 8) | data.at(13)));
-	switch(ether_type)
-	{
-		case NET_PROTO::IEEE_802_1Q:
-			if(data.length() < 17)
-			{
-				DFLTLOG(LEVEL_ERROR,
-				        "cannot retrieve EtherType in Ethernet header\n");
-				return NET_PROTO::ERROR;
-			}
-			ether_type = to_enum<NET_PROTO>(static_cast<uint16_t>((data.at(16) << 8) | data.at(17)));
-
-			// TODO: we need the following part because we use two 802.1Q
-			//       tags for kernel support
-			if(ether_type != NET_PROTO::IEEE_802_1Q)
-			{
-				break;
-			}
-			// fall through
-		case NET_PROTO::IEEE_802_1AD:
-			if(data.length() < 21)
-			{
-				DFLTLOG(LEVEL_ERROR,
-				        "cannot retrieve EtherType in Ethernet header\n");
-				return NET_PROTO::ERROR;
-			}
-			ether_type = to_enum<NET_PROTO>(static_cast<uint16_t>((data.at(20) << 8) | data.at(21)));
-			break;
-	}
-
-	return ether_type;
+	return frame.getPayloadEtherType();
 }
 
 uint16_t Ethernet::getQTci(const Data &data)
 {
-	uint16_t tci = 0;
-	NET_PROTO ether_type;
-	if(data.length() < 17)
-	{
-		DFLTLOG(LEVEL_ERROR,
-		        "cannot retrieve vlan id in Ethernet header\n");
-		return 0;
-	}
-	ether_type = to_enum<NET_PROTO>(static_cast<uint16_t>((data.at(12) << 8) | data.at(13)));
-	switch(ether_type)
-	{
-		case NET_PROTO::IEEE_802_1Q:
-			tci = ((data.at(14) & 0xff) << 8) | data.at(15);
-			// TODO: we need the following part because we use two 802.1Q
-			//       tags for kernel support
-			ether_type = to_enum<NET_PROTO>(static_cast<uint16_t>((data.at(16) << 8) | data.at(17)));
-			if(ether_type != NET_PROTO::IEEE_802_1Q)
-			{
-				break;
-			}
-			// fall through
-		case NET_PROTO::IEEE_802_1AD:
-			tci = ((data.at(18) & 0xff) << 8) | data.at(19);
-			break;
-	}
-
-	return tci;
+	return EthernetFrameView{data}.getQTci();
 }
 
 uint16_t Ethernet::getAdTci(const Data &data)
 {
-	uint16_t tci = 0;
-	NET_PROTO ether_type;
-	NET_PROTO ether_type2;
-	if(data.length() < 17)
-	{
-		DFLTLOG(LEVEL_ERROR,
-		        "cannot retrieve vlan id in Ethernet header\n");
-		return 0;
-	}
-	ether_type = to_enum<NET_PROTO>(static_cast<uint16_t>((data.at(12) << 8) | data.at(13)));
-	ether_type2 = to_enum<NET_PROTO>(static_cast<uint16_t>((data.at(16) << 8) | data.at(17)));
-	// TODO: we need the following part because we use two 802.1Q tags for kernel support
-	if(ether_type == NET_PROTO::IEEE_802_1Q && ether_type2 == NET_PROTO::IEEE_802_1Q)
-	{
-		ether_type = NET_PROTO::IEEE_802_1AD;
-	}
-
-	switch(ether_type)
-	{
-		case NET_PROTO::IEEE_802_1AD:
-			tci = ((data.at(14) & 0xff) << 8) | data.at(15);
-			break;
-	}
-
-	return tci;
+	return EthernetFrameView{data}.getAdTci();
 }
 
 MacAddress Ethernet::getDstMac(const Data &data)
 {
-	if(data.length() < 6)
-	{
-		DFLTLOG(LEVEL_ERROR,
-		        "cannot retrieve destination MAC in Ethernet header\n");
-		return MacAddress(0, 0, 0, 0, 0, 0);
-	}
-
-	return MacAddress(data.at(0), data.at(1), data.at(2),
-	                  data.at(3), data.at(4), data.at(5));
+	return EthernetFrameView{data}.getDstMac();
 }
 
 MacAddress Ethernet::getSrcMac(const Data &data)
 {
-	if(data.length() < 12)
-	{
-		DFLTLOG(LEVEL_ERROR,
-		        "cannot retrieve source MAC in Ethernet header\n");
-		return MacAddress(0, 0, 0, 0, 0, 0);
-	}
-	return MacAddress(data.at(6), data.at(7), data.at(8),
-	                  data.at(9), data.at(10), data.at(11));
+	return EthernetFrameView{data}.getSrcMac();
 }
@@ -46,7 +46,9 @@
 #define ETH_CONTEXT_H
 
 #include "EthernetHeader.h"
+#include "EthernetFrameView.h"
 #include "Evc.h"
+#include "FlowClassifier.h"
 
 #include <NetBurst.h>
 #include <MacAddress.h>
@@ -56,6 +58,8 @@
 #include <opensand_output/Output.h>
 
 #include <map>
+#include <array>
+#include <vector>
 
 /**
  * @class Ethernet
@@ -94,6 +98,9 @@ public:
 		bool init();
 		NetBurst *encapsulate(NetBurst *burst, std::map<long, int> &(time_contexts));
 		NetBurst *deencapsulate(NetBurst *burst);
+		bool canEncapsulatePacket() const;
+		void startPackets();
+		void encapsulatePacket(std::unique_ptr<NetPacket> &packet);
 		char getLanHeader(unsigned int pos, const std::unique_ptr<NetPacket>& packet);
 		bool handleTap();
 		void updateStats(unsigned int period);
@@ -125,7 +132,7 @@ public:
 		 * @param desired_frame_type The frame type we want to build
 		 * @return the Ethernet frame
 		 */
-		std::unique_ptr<NetPacket> createEthFrameData(Data data,
+		std::unique_ptr<NetPacket> createEthFrameData(const Data &data,
 		                                              MacAddress mac_src, MacAddress mac_dst,
 		                                              NET_PROTO ether_type,
 		                                              uint16_t q_tci,
@@ -206,10 +213,28 @@ public:
 		 */
 		bool initTrafficCategories();
 
-		/// The Ethernet Virtual Connections
-		std::map<uint8_t, Evc *> evc_map;
+		/**
+		 * @brief Initialize the classification rules of the IP flows
+		 *
+		 * @return true on success, false otherwise
+		 */
+		bool initFlowRules();
+
+		/**
+		 * @brief Get the traffic category of a PCP
+		 *
+		 * @param pcp  The PCP
+		 * @return the traffic category, the default one if there is
+		 *         no category for this PCP
+		 */
+		TrafficCategory *getCategory(qos_t pcp) const;
+
+		/// The Ethernet Virtual Connections indexed by their id
+		std::array<Evc *, 256> evc_map;
+		/// The ids of the EVCs in evc_map in ascending order
+		std::vector<uint8_t> evc_ids;
 		/// The amount of data sent per EVC between two updates
-		std::map<uint8_t, size_t> evc_data_size;
+		std::array<size_t, 256> evc_data_size;
 		/// The throughput per EVC
 		std::map<uint8_t, std::shared_ptr<Probe<float> > > probe_evc_throughput;
 		/// The frame size per EVC
@@ -218,11 +243,17 @@ public:
 		NET_PROTO lan_frame_type; //< The type of Ethernet frame forwarded on LAN
 		NET_PROTO sat_frame_type; //< The type of Ethernet frame transmitted on satellite
 
-		/// The traffic categories
-		std::map<qos_t, TrafficCategory *> category_map;
+		/// The number of PCP values
+		static constexpr std::size_t pcp_count = 8;
+
+		/// The traffic categories indexed by PCP
+		std::array<TrafficCategory *, pcp_count> category_map;
 
 		/// The default traffic category
 		TrafficCategory *default_category;
+
+		/// The classifier of the IP flows, overriding the PCP and EVC QoS
+		FlowClassifier flow_classifier;
 	};
 
 	/**
@@ -0,0 +1,138 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file EthernetFrameView.cpp
+ * @brief A read-only view on the header of an Ethernet frame
+ * @author Viveris Technologies
+ */
+
+
+#include "EthernetFrameView.h"
+#include "OpenSandCore.h"
+
+
+EthernetFrameView::EthernetFrameView(const unsigned char *data, std::size_t length):
+	data{data},
+	length{length},
+	frame_type{NET_PROTO::ERROR},
+	ether_type{NET_PROTO::ERROR},
+	q_tci{0},
+	ad_tci{0},
+	header_length{0},
+	tos{0}
+{
+	if(this->data == nullptr || this->length < ETHERNET_2_HEADSIZE)
+	{
+		return;
+	}
+
+	NET_PROTO type = to_enum<NET_PROTO>(this->read16(12));
+	switch(type)
+	{
+		case NET_PROTO::IEEE_802_1Q:
+			if(this->length < ETHERNET_802_1Q_HEADSIZE)
+			{
+				return;
+			}
+			// TODO: we need the following part because we use two 802.1Q
+			//       tags for kernel support
+			if(to_enum<NET_PROTO>(this->read16(16)) != NET_PROTO::IEEE_802_1Q)
+			{
+				this->frame_type = NET_PROTO::IEEE_802_1Q;
+				this->q_tci = this->read16(14);
+				this->ether_type = to_enum<NET_PROTO>(this->read16(16));
+				this->header_length = ETHERNET_802_1Q_HEADSIZE;
+				break;
+			}
+			// fall through
+		case NET_PROTO::IEEE_802_1AD:
+			if(this->length < ETHERNET_802_1AD_HEADSIZE)
+			{
+				return;
+			}
+			this->frame_type = NET_PROTO::IEEE_802_1AD;
+			this->ad_tci = this->read16(14);
+			this->q_tci = this->read16(18);
+			this->ether_type = to_enum<NET_PROTO>(this->read16(20));
+			this->header_length = ETHERNET_802_1AD_HEADSIZE;
+			break;
+		default:
+			this->frame_type = NET_PROTO::ETH;
+			this->ether_type = type;
+			this->header_length = ETHERNET_2_HEADSIZE;
+			break;
+	}
+
+	const unsigned char *payload = this->data + this->header_length;
+	std::size_t payload_length = this->length - this->header_length;
+	if(payload_length < 2)
+	{
+		return;
+	}
+	switch(this->ether_type)
+	{
+		case NET_PROTO::IPV4:
+			this->tos = payload[1];
+			break;
+		case NET_PROTO::IPV6:
+			this->tos = ((payload[0] & 0x0f) << 4) | (payload[1] >> 4);
+			break;
+		default:
+			break;
+	}
+}
+
+
+EthernetFrameView::EthernetFrameView(const Data &data):
+	EthernetFrameView{data.c_str(), data.length()}
+{
+}
+
+
+MacAddress EthernetFrameView::getDstMac() const
+{
+	if(this->data == nullptr || this->length < 6)
+	{
+		return MacAddress(0, 0, 0, 0, 0, 0);
+	}
+	return MacAddress(this->data[0], this->data[1], this->data[2],
+	                  this->data[3], this->data[4], this->data[5]);
+}
+
+
+MacAddress EthernetFrameView::getSrcMac() const
+{
+	if(this->data == nullptr || this->length < 12)
+	{
+		return MacAddress(0, 0, 0, 0, 0, 0);
+	}
+	return MacAddress(this->data[6], this->data[7], this->data[8],
+	                  this->data[9], this->data[10], this->data[11]);
+}
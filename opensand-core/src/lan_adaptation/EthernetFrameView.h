@@ -0,0 +1,178 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file EthernetFrameView.h
+ * @brief A read-only view on the header of an Ethernet frame
+ * @author Viveris Technologies
+ */
+
+#ifndef ETH_FRAME_VIEW_H
+#define ETH_FRAME_VIEW_H
+
+#include <cstdint>
+#include <cstddef>
+
+#include "Data.h"
+#include "MacAddress.h"
+#include "NetPacket.h"
+
+
+/**
+ * @class EthernetFrameView
+ * @brief Parse the header of an Ethernet II, 802.1Q or 802.1ad frame
+ *        in one pass, without copying the frame
+ *
+ * The view only keeps a pointer on the frame, which must outlive it.
+ * A frame shorter than the header announced by its tags is invalid and
+ * its frame type is NET_PROTO::ERROR.
+ */
+class EthernetFrameView
+{
+public:
+	/**
+	 * @brief Parse the header of an Ethernet frame
+	 *
+	 * @param data    The frame
+	 * @param length  The frame length
+	 */
+	EthernetFrameView(const unsigned char *data, std::size_t length);
+
+	/**
+	 * @brief Parse the header of an Ethernet frame
+	 *
+	 * @param data  The frame
+	 */
+	EthernetFrameView(const Data &data);
+
+	/**
+	 * @brief Check whether the whole header is available
+	 *
+	 * @return true if the frame could be parsed, false otherwise
+	 */
+	bool isValid() const { return this->frame_type != NET_PROTO::ERROR; };
+
+	/**
+	 * @brief Get the type of frame (ETH, IEEE_802_1Q or IEEE_802_1AD)
+	 *
+	 * @return the frame type, NET_PROTO::ERROR if the frame is invalid
+	 */
+	NET_PROTO getFrameType() const { return this->frame_type; };
+
+	/**
+	 * @brief Get the EtherType of the payload
+	 *
+	 * @return the payload EtherType, NET_PROTO::ERROR if the frame is invalid
+	 */
+	NET_PROTO getPayloadEtherType() const { return this->ether_type; };
+
+	/**
+	 * @brief Get the 802.1Q TCI, 0 if the frame is not tagged
+	 *
+	 * @return the Q TCI
+	 */
+	uint16_t getQTci() const { return this->q_tci; };
+
+	/**
+	 * @brief Get the 802.1ad TCI, 0 if the frame is not double tagged
+	 *
+	 * @return the ad TCI
+	 */
+	uint16_t getAdTci() const { return this->ad_tci; };
+
+	/**
+	 * @brief Get the PCP of the 802.1Q tag
+	 *
+	 * @return the PCP, 0 if the frame is not tagged
+	 */
+	uint8_t getPcp() const { return (this->q_tci & 0xe000) >> 13; };
+
+	/**
+	 * @brief Get the length of the Ethernet header, tags included
+	 *
+	 * @return the header length, 0 if the frame is invalid
+	 */
+	std::size_t getHeaderLength() const { return this->header_length; };
+
+	/**
+	 * @brief Get the ToS of an IPv4 payload or the traffic class
+	 *        of an IPv6 payload
+	 *
+	 * @return the ToS, 0 for other payloads
+	 */
+	uint8_t getTos() const { return this->tos; };
+
+	/**
+	 * @brief Get the destination MAC address
+	 *
+	 * @return the destination MAC address, 00:00:00:00:00:00 if the
+	 *         frame is too short
+	 */
+	MacAddress getDstMac() const;
+
+	/**
+	 * @brief Get the source MAC address
+	 *
+	 * @return the source MAC address, 00:00:00:00:00:00 if the
+	 *         frame is too short
+	 */
+	MacAddress getSrcMac() const;
+
+private:
+	/**
+	 * @brief Read a 16 bits value in network byte order
+	 *
+	 * @param offset  The offset of the value in the frame
+	 * @return the value in host byte order
+	 */
+	uint16_t read16(std::size_t offset) const
+	{
+		return (this->data[offset] << 8) | this->data[offset + 1];
+	};
+
+	/// The frame
+	const unsigned char *data;
+	/// The frame length
+	std::size_t length;
+
+	/// The frame type
+	NET_PROTO frame_type;
+	/// The payload EtherType
+	NET_PROTO ether_type;
+	/// The 802.1Q TCI
+	uint16_t q_tci;
+	/// The 802.1ad TCI
+	uint16_t ad_tci;
+	/// The header length
+	std::size_t header_length;
+	/// The IPv4 ToS or IPv6 traffic class
+	uint8_t tos;
+};
+
+#endif
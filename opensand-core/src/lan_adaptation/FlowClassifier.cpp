@@ -0,0 +1,341 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file FlowClassifier.cpp
+ * @brief The classification of the IP flows on their 5-tuple
+ * @author Viveris Technologies
+ */
+
+
+#include <arpa/inet.h>
+#include <cstring>
+#include <sstream>
+
+#include "FlowClassifier.h"
+
+
+/**
+ * @brief Whether a protocol carries the ports in the first 4 bytes
+ *        of its header
+ */
+static bool hasPorts(uint8_t protocol)
+{
+	switch(protocol)
+	{
+		case IPPROTO_TCP:
+		case IPPROTO_UDP:
+		case IPPROTO_DCCP:
+		case IPPROTO_SCTP:
+		case IPPROTO_UDPLITE:
+			return true;
+		default:
+			return false;
+	}
+}
+
+
+/**
+ * @brief Whether the first bits of two addresses are equal
+ */
+static bool prefixMatch(const std::array<uint8_t, 16> &addr,
+                        const std::array<uint8_t, 16> &network,
+                        uint8_t prefix)
+{
+	std::size_t bytes = prefix / 8;
+	if(std::memcmp(addr.data(), network.data(), bytes) != 0)
+	{
+		return false;
+	}
+	uint8_t bits = prefix % 8;
+	if(bits == 0)
+	{
+		return true;
+	}
+	uint8_t bits_mask = 0xff << (8 - bits);
+	return (addr[bytes] & bits_mask) == (network[bytes] & bits_mask);
+}
+
+
+FlowClassifier::FlowClassifier(std::size_t cache_size,
+                               std::chrono::seconds flow_timeout):
+	rules{},
+	cache{},
+	mask{0},
+	start{std::chrono::steady_clock::now()},
+	timeout{static_cast<uint32_t>(flow_timeout.count())},
+	now{1},
+	hits{0},
+	misses{0},
+	evictions{0}
+{
+	std::size_t size = probe_length;
+	while(size < cache_size)
+	{
+		size <<= 1;
+	}
+	this->cache.resize(size, Entry{0, FlowKey{}, no_rule, 0});
+	this->mask = size - 1;
+}
+
+
+void FlowClassifier::addRule(const FlowRule &rule)
+{
+	this->rules.push_back(rule);
+	// the flows already seen may match the new rule
+	for(auto &&entry: this->cache)
+	{
+		entry.seen = 0;
+	}
+}
+
+
+bool FlowClassifier::parseNetwork(const std::string &network,
+                                  uint8_t &version,
+                                  std::array<uint8_t, 16> &addr,
+                                  uint8_t &prefix)
+{
+	addr.fill(0);
+	version = 0;
+	prefix = 0;
+	if(network.empty())
+	{
+		return true;
+	}
+
+	std::string address = network;
+	int length = -1;
+	std::size_t slash = network.find('/');
+	if(slash != std::string::npos)
+	{
+		address = network.substr(0, slash);
+		std::istringstream prefix_stream{network.substr(slash + 1)};
+		if(!(prefix_stream >> length) || !prefix_stream.eof() || length < 0)
+		{
+			return false;
+		}
+	}
+
+	if(inet_pton(AF_INET, address.c_str(), addr.data()) == 1)
+	{
+		version = 4;
+		length = length < 0 ? 32 : length;
+	}
+	else if(inet_pton(AF_INET6, address.c_str(), addr.data()) == 1)
+	{
+		version = 6;
+		length = length < 0 ? 128 : length;
+	}
+	else
+	{
+		return false;
+	}
+	if(length > (version == 4 ? 32 : 128))
+	{
+		return false;
+	}
+	prefix = length;
+	return true;
+}
+
+
+bool FlowClassifier::getKey(const unsigned char *packet, std::size_t length,
+                            NET_PROTO ether_type, FlowKey &key)
+{
+	std::size_t header_length;
+	bool ports;
+
+	key.src_addr.fill(0);
+	key.dst_addr.fill(0);
+	key.src_port = 0;
+	key.dst_port = 0;
+	switch(ether_type)
+	{
+		case NET_PROTO::IPV4:
+			if(length < 20 || (packet[0] >> 4) != 4)
+			{
+				return false;
+			}
+			header_length = (packet[0] & 0x0f) * 4;
+			if(header_length < 20 || header_length > length)
+			{
+				return false;
+			}
+			key.version = 4;
+			key.protocol = packet[9];
+			std::memcpy(key.src_addr.data(), packet + 12, 4);
+			std::memcpy(key.dst_addr.data(), packet + 16, 4);
+			// only the first fragment carries the ports
+			ports = (((packet[6] << 8) | packet[7]) & 0x1fff) == 0;
+			break;
+		case NET_PROTO::IPV6:
+			if(length < 40 || (packet[0] >> 4) != 6)
+			{
+				return false;
+			}
+			header_length = 40;
+			key.version = 6;
+			key.protocol = packet[6];
+			std::memcpy(key.src_addr.data(), packet + 8, 16);
+			std::memcpy(key.dst_addr.data(), packet + 24, 16);
+			ports = true;
+			break;
+		default:
+			return false;
+	}
+
+	if(ports && hasPorts(key.protocol) && length >= header_length + 4)
+	{
+		const unsigned char *transport = packet + header_length;
+		key.src_port = (transport[0] << 8) | transport[1];
+		key.dst_port = (transport[2] << 8) | transport[3];
+	}
+	return true;
+}
+
+
+void FlowClassifier::remark(unsigned char *packet, NET_PROTO ether_type, uint8_t dscp)
+{
+	if(ether_type == NET_PROTO::IPV4)
+	{
+		// incremental checksum update of RFC 1624
+		uint16_t old_word = (packet[0] << 8) | packet[1];
+		packet[1] = (dscp << 2) | (packet[1] & 0x03);
+		uint16_t new_word = (packet[0] << 8) | packet[1];
+		uint32_t sum = static_cast<uint16_t>(~((packet[10] << 8) | packet[11]));
+		sum += static_cast<uint16_t>(~old_word);
+		sum += new_word;
+		sum = (sum & 0xffff) + (sum >> 16);
+		sum = (sum & 0xffff) + (sum >> 16);
+		uint16_t checksum = ~sum;
+		packet[10] = checksum >> 8;
+		packet[11] = checksum & 0xff;
+	}
+	else if(ether_type == NET_PROTO::IPV6)
+	{
+		// the traffic class straddles the first two bytes
+		uint8_t traffic_class = (dscp << 2) | ((packet[1] >> 4) & 0x03);
+		packet[0] = (packet[0] & 0xf0) | (traffic_class >> 4);
+		packet[1] = (packet[1] & 0x0f) | ((traffic_class & 0x0f) << 4);
+	}
+}
+
+
+void FlowClassifier::setTime(std::chrono::steady_clock::time_point now)
+{
+	// 0 is kept for the free slots
+	auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - this->start);
+	this->now = static_cast<uint32_t>(elapsed.count()) + 1;
+}
+
+
+const FlowRule *FlowClassifier::classify(const FlowKey &key)
+{
+	uint64_t key_hash = FlowClassifier::hash(key);
+	std::size_t index = key_hash & this->mask;
+	Entry *victim = nullptr;
+	bool victim_live = true;
+
+	for(std::size_t probe = 0; probe < probe_length; ++probe)
+	{
+		Entry &entry = this->cache[(index + probe) & this->mask];
+		bool live = entry.seen != 0 && this->now - entry.seen <= this->timeout;
+		if(live && entry.hash == key_hash && entry.key == key)
+		{
+			entry.seen = this->now;
+			++this->hits;
+			return entry.rule == no_rule ? nullptr : &this->rules[entry.rule];
+		}
+		// replace the first forgotten flow, or the least recently seen one
+		if(victim_live && (!live || victim == nullptr || entry.seen < victim->seen))
+		{
+			victim = &entry;
+			victim_live = live;
+		}
+	}
+
+	++this->misses;
+	if(victim_live)
+	{
+		++this->evictions;
+	}
+	victim->hash = key_hash;
+	victim->key = key;
+	victim->rule = this->match(key);
+	victim->seen = this->now;
+	return victim->rule == no_rule ? nullptr : &this->rules[victim->rule];
+}
+
+
+uint64_t FlowClassifier::hash(const FlowKey &key)
+{
+	uint64_t words[5];
+	std::memcpy(words, key.src_addr.data(), 16);
+	std::memcpy(words + 2, key.dst_addr.data(), 16);
+	words[4] = (static_cast<uint64_t>(key.src_port) << 32) |
+	           (static_cast<uint64_t>(key.dst_port) << 16) |
+	           (static_cast<uint64_t>(key.protocol) << 8) |
+	           key.version;
+
+	uint64_t value = 0;
+	for(uint64_t word: words)
+	{
+		// multiply and rotate to spread each word, then the
+		// finalizer of MurmurHash3 to mix the whole key
+		value ^= word * 0x9e3779b97f4a7c15ULL;
+		value = (value << 31) | (value >> 33);
+	}
+	value ^= value >> 33;
+	value *= 0xff51afd7ed558ccdULL;
+	value ^= value >> 33;
+	value *= 0xc4ceb9fe1a85ec53ULL;
+	value ^= value >> 33;
+	return value;
+}
+
+
+int32_t FlowClassifier::match(const FlowKey &key) const
+{
+	for(std::size_t index = 0; index < this->rules.size(); ++index)
+	{
+		const FlowRule &rule = this->rules[index];
+		if((rule.version != 0 && rule.version != key.version) ||
+		   (rule.protocol != 0 && rule.protocol != key.protocol) ||
+		   (rule.src_port != 0 && rule.src_port != key.src_port) ||
+		   (rule.dst_port != 0 && rule.dst_port != key.dst_port))
+		{
+			continue;
+		}
+		if(prefixMatch(key.src_addr, rule.src_addr, rule.src_prefix) &&
+		   prefixMatch(key.dst_addr, rule.dst_addr, rule.dst_prefix))
+		{
+			return index;
+		}
+	}
+	return no_rule;
+}
@@ -0,0 +1,238 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file FlowClassifier.h
+ * @brief The classification of the IP flows on their 5-tuple
+ * @author Viveris Technologies
+ */
+
+#ifndef FLOW_CLASSIFIER_H
+#define FLOW_CLASSIFIER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "NetPacket.h"
+#include "OpenSandCore.h"
+
+
+/**
+ * @brief The 5-tuple identifying an IP flow, IPv4 addresses are
+ *        stored in the first 4 bytes
+ */
+struct FlowKey
+{
+	std::array<uint8_t, 16> src_addr;
+	std::array<uint8_t, 16> dst_addr;
+	uint16_t src_port;
+	uint16_t dst_port;
+	uint8_t protocol;
+	uint8_t version;
+
+	bool operator==(const FlowKey &other) const
+	{
+		return this->src_port == other.src_port &&
+		       this->dst_port == other.dst_port &&
+		       this->protocol == other.protocol &&
+		       this->version == other.version &&
+		       this->src_addr == other.src_addr &&
+		       this->dst_addr == other.dst_addr;
+	};
+};
+
+
+/**
+ * @brief A classification rule, the zero fields match any value
+ */
+struct FlowRule
+{
+	/// The IP version of the networks, 0 if no network is given
+	uint8_t version;
+	std::array<uint8_t, 16> src_addr;
+	uint8_t src_prefix;
+	std::array<uint8_t, 16> dst_addr;
+	uint8_t dst_prefix;
+	uint8_t protocol;
+	uint16_t src_port;
+	uint16_t dst_port;
+
+	/// The PCP of the traffic category given to the flow
+	qos_t pcp;
+	/// The DSCP written in the packets, negative to keep it
+	int dscp;
+};
+
+
+/**
+ * @class FlowClassifier
+ * @brief Give the first matching rule of the IP flows
+ *
+ * The rules are only evaluated on the first packet of a flow, their
+ * result, even no rule, is then kept in a bounded open addressing
+ * hash table keyed on the 5-tuple. A flow that was not seen for the
+ * flow timeout is evaluated again, so the table does not keep the
+ * flows that ended.
+ * A classifier belongs to the context of one channel, it is not locked.
+ */
+class FlowClassifier
+{
+public:
+	/**
+	 * @brief Create a classifier without rules
+	 *
+	 * @param cache_size    The number of flows kept, rounded up to a power of 2
+	 * @param flow_timeout  The delay after which an idle flow is forgotten
+	 */
+	FlowClassifier(std::size_t cache_size = 4096,
+	               std::chrono::seconds flow_timeout = std::chrono::seconds{30});
+
+	/**
+	 * @brief Add a rule after the existing ones
+	 *
+	 * @param rule  The rule
+	 */
+	void addRule(const FlowRule &rule);
+
+	/**
+	 * @brief Whether there is no rule, there is no need to classify then
+	 *
+	 * @return true if there is no rule
+	 */
+	bool empty() const { return this->rules.empty(); };
+
+	/**
+	 * @brief Parse a network in CIDR notation, an address without
+	 *        prefix length is a host, an empty string matches any address
+	 *
+	 * @param network  The network
+	 * @param version  OUT: the IP version, 0 for any address
+	 * @param addr     OUT: the network address
+	 * @param prefix   OUT: the prefix length in bits
+	 * @return true on success, false if the network is malformed
+	 */
+	static bool parseNetwork(const std::string &network,
+	                         uint8_t &version,
+	                         std::array<uint8_t, 16> &addr,
+	                         uint8_t &prefix);
+
+	/**
+	 * @brief Get the 5-tuple of an IP packet, the ports are 0 for the
+	 *        protocols without ports, IPv4 fragments and IPv6 packets
+	 *        with extension headers
+	 *
+	 * @param packet      The IP packet
+	 * @param length      The packet length
+	 * @param ether_type  The EtherType of the packet
+	 * @param key         OUT: the 5-tuple
+	 * @return true on success, false if this is not a valid IP packet
+	 */
+	static bool getKey(const unsigned char *packet, std::size_t length,
+	                   NET_PROTO ether_type, FlowKey &key);
+
+	/**
+	 * @brief Write the DSCP of an IP packet, and update the IPv4 checksum
+	 *
+	 * @param packet      The IP packet, of a valid 5-tuple
+	 * @param ether_type  The EtherType of the packet
+	 * @param dscp        The DSCP
+	 */
+	static void remark(unsigned char *packet, NET_PROTO ether_type, uint8_t dscp);
+
+	/**
+	 * @brief Set the time of the next classifications, it is read once
+	 *        per burst instead of once per packet
+	 *
+	 * @param now  The current time
+	 */
+	void setTime(std::chrono::steady_clock::time_point now);
+
+	/**
+	 * @brief Get the rule of a flow
+	 *
+	 * @param key  The 5-tuple of the flow
+	 * @return the first matching rule, nullptr if none
+	 */
+	const FlowRule *classify(const FlowKey &key);
+
+	/// The number of packets classified by the table
+	uint64_t getHits() const { return this->hits; };
+	/// The number of flows classified by the rules
+	uint64_t getMisses() const { return this->misses; };
+	/// The number of live flows forgotten to make room for new ones
+	uint64_t getEvictions() const { return this->evictions; };
+
+private:
+	/// The slots probed after the one of the hash
+	static constexpr std::size_t probe_length = 4;
+	/// The index of no rule in the cache entries
+	static constexpr int32_t no_rule = -1;
+
+	struct Entry
+	{
+		uint64_t hash;
+		FlowKey key;
+		int32_t rule;
+		/// The last time the flow was seen, in seconds, 0 for a free slot
+		uint32_t seen;
+	};
+
+	/**
+	 * @brief Hash a 5-tuple
+	 *
+	 * @param key  The 5-tuple
+	 * @return the hash
+	 */
+	static uint64_t hash(const FlowKey &key);
+
+	/**
+	 * @brief Evaluate the rules
+	 *
+	 * @param key  The 5-tuple of the flow
+	 * @return the index of the first matching rule, no_rule if none
+	 */
+	int32_t match(const FlowKey &key) const;
+
+	std::vector<FlowRule> rules;
+	std::vector<Entry> cache;
+	std::size_t mask;
+
+	std::chrono::steady_clock::time_point start;
+	uint32_t timeout;
+	uint32_t now;
+
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+};
+
+#endif
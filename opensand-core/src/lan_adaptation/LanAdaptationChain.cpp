@@ -0,0 +1,120 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file LanAdaptationChain.cpp
+ * @brief The chain of the LAN adaptation contexts encapsulating a burst
+ * @author Viveris Technologies
+ */
+
+
+#include "LanAdaptationChain.h"
+#include "NetBurst.h"
+#include "NetPacket.h"
+
+#include <opensand_output/Output.h>
+
+
+LanAdaptationChain::LanAdaptationChain():
+	contexts{},
+	fused{false},
+	log{}
+{
+}
+
+
+void LanAdaptationChain::setContexts(const lan_contexts_t &contexts)
+{
+	this->log = Output::Get()->registerLog(LEVEL_WARNING, "LanAdaptation.Chain");
+	this->contexts = contexts;
+	this->fused = !contexts.empty();
+	for(auto &&context : contexts)
+	{
+		this->fused &= context->canEncapsulatePacket();
+	}
+	LOG(this->log, LEVEL_NOTICE,
+	    "%zu LAN adaptation context(s) encapsulate %s\n",
+	    contexts.size(), this->fused ? "in a single pass per packet" : "burst by burst");
+}
+
+
+bool LanAdaptationChain::isFused() const
+{
+	return this->fused;
+}
+
+
+NetBurst *LanAdaptationChain::encapsulate(NetBurst *burst)
+{
+	if(!this->fused)
+	{
+		for(auto &&context : this->contexts)
+		{
+			burst = context->encapsulate(burst);
+			if(burst == nullptr)
+			{
+				LOG(this->log, LEVEL_ERROR,
+				    "failed to handle the burst in %s context\n",
+				    context->getName().c_str());
+				return nullptr;
+			}
+		}
+		return burst;
+	}
+
+	for(auto &&context : this->contexts)
+	{
+		context->startPackets();
+	}
+	for(auto it = burst->begin(); it != burst->end();)
+	{
+		for(auto &&context : this->contexts)
+		{
+			context->encapsulatePacket(*it);
+			if(!*it)
+			{
+				break;
+			}
+		}
+		it = *it ? std::next(it) : burst->erase(it);
+	}
+	for(auto &&context : this->contexts)
+	{
+		context->endPackets();
+	}
+
+	// avoid returning empty bursts, as the contexts do
+	if(burst->length() == 0)
+	{
+		LOG(this->log, LEVEL_INFO,
+		    "all the packets of the burst were dropped\n");
+		delete burst;
+		return nullptr;
+	}
+	return burst;
+}
@@ -0,0 +1,97 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file LanAdaptationChain.h
+ * @brief The chain of the LAN adaptation contexts encapsulating a burst
+ * @author Viveris Technologies
+ */
+
+#ifndef LAN_ADAPTATION_CHAIN_H
+#define LAN_ADAPTATION_CHAIN_H
+
+#include <memory>
+
+#include "LanAdaptationPlugin.h"
+
+
+class NetBurst;
+class OutputLog;
+
+
+/**
+ * @class LanAdaptationChain
+ * @brief The LAN adaptation contexts of a stack, from upper to lower
+ *
+ * When all the contexts encapsulate the packets one by one, the chain
+ * is fused: each packet goes through all the contexts in a single
+ * pass and stays in the input burst, so no intermediate burst is
+ * built. Otherwise each context encapsulates the whole burst in turn.
+ */
+class LanAdaptationChain
+{
+ public:
+	LanAdaptationChain();
+
+	/**
+	 * @brief Set the contexts of the chain and check whether it can be fused
+	 *
+	 * @param contexts  The contexts, from upper to lower
+	 */
+	void setContexts(const lan_contexts_t &contexts);
+
+	/**
+	 * @brief Check whether the contexts of the chain are fused
+	 *
+	 * @return true if the packets go through all the contexts in a
+	 *         single pass, false otherwise
+	 */
+	bool isFused() const;
+
+	/**
+	 * @brief Encapsulate a burst through all the contexts
+	 *
+	 * @param burst  The burst to encapsulate, released by the chain
+	 * @return the encapsulated burst, nullptr on failure or if
+	 *         all the packets are dropped
+	 */
+	NetBurst *encapsulate(NetBurst *burst);
+
+ private:
+	/// The contexts, from upper to lower
+	lan_contexts_t contexts;
+
+	/// Whether all the contexts encapsulate packet by packet
+	bool fused;
+
+	/// The output log
+	std::shared_ptr<OutputLog> log;
+};
+
+
+#endif
@@ -37,15 +37,42 @@
 #include "PacketSwitch.h"
 #include "Data.h"
 #include "MacAddress.h"
-#include "Ethernet.h"
 
 #include <string>
 #include <vector>
 #include <memory>
 
 
+/**
+ * @brief Get the packed destination MAC address of an Ethernet frame
+ */
+static uint64_t getDstMacKey(const Data &packet)
+{
+	if(packet.length() < 6)
+	{
+		DFLTLOG(LEVEL_ERROR,
+		        "cannot retrieve destination MAC in Ethernet header\n");
+		return 0;
+	}
+	return MacAddress::getKey(packet.data());
+}
+
+/**
+ * @brief Get the packed source MAC address of an Ethernet frame
+ */
+static uint64_t getSrcMacKey(const Data &packet)
+{
+	if(packet.length() < 12)
+	{
+		DFLTLOG(LEVEL_ERROR,
+		        "cannot retrieve source MAC in Ethernet header\n");
+		return 0;
+	}
+	return MacAddress::getKey(packet.data() + 6);
+}
+
 PacketSwitch::PacketSwitch(tal_id_t tal_id):
-	mutex(),
+	mutex("lan.packet_switch"),
 	tal_id(tal_id),
 	sarp_table()
 {
@@ -59,9 +86,9 @@ SarpTable *PacketSwitch::getSarpTable()
 
 bool PacketSwitch::learn(const Data &packet, tal_id_t src_id)
 {
-	MacAddress src_mac = Ethernet::getSrcMac(packet);
-	RtLock(this->mutex);
-	if (!this->sarp_table.add(std::unique_ptr<MacAddress>{new MacAddress{src_mac.str()}}, src_id))
+	uint64_t src_mac = getSrcMacKey(packet);
+	RtLock lock{this->mutex};
+	if (!this->sarp_table.learn(src_mac, src_id))
 	{
 		return false;
 	}
@@ -70,8 +97,8 @@ bool PacketSwitch::learn(const Data &packet, tal_id_t src_id)
 
 bool TerminalPacketSwitch::getPacketDestination(const Data &packet, tal_id_t &src_id, tal_id_t &dst_id)
 {
-	MacAddress dst_mac = Ethernet::getDstMac(packet);
-	RtLock(this->mutex);
+	uint64_t dst_mac = getDstMacKey(packet);
+	RtLock lock{this->mutex};
 	src_id = this->tal_id;
 	if (!this->sarp_table.getTalByMac(dst_mac, dst_id))
 	{
@@ -88,9 +115,8 @@ bool TerminalPacketSwitch::isPacketForMe(const Data &UNUSED(packet), tal_id_t UN
 
 bool GatewayPacketSwitch::getPacketDestination(const Data &packet, tal_id_t &src_id, tal_id_t &dst_id)
 {
-	MacAddress dst_mac = Ethernet::getDstMac(packet);
-	MacAddress src_mac = Ethernet::getSrcMac(packet);
-	RtLock(this->mutex);
+	uint64_t dst_mac = getDstMacKey(packet);
+	RtLock lock{this->mutex};
 	src_id = this->tal_id;	
 
 	if(!this->sarp_table.getTalByMac(dst_mac, dst_id))
@@ -103,9 +129,8 @@ bool GatewayPacketSwitch::getPacketDestination(const Data &packet, tal_id_t &src
 bool GatewayPacketSwitch::isPacketForMe(const Data &packet, tal_id_t src_id, bool &forward)
 {
 	tal_id_t dst_id;
-	MacAddress dst_mac = Ethernet::getDstMac(packet);
-	MacAddress src_mac = Ethernet::getSrcMac(packet);
-	RtLock(this->mutex);
+	uint64_t dst_mac = getDstMacKey(packet);
+	RtLock lock{this->mutex};
 	if(!this->sarp_table.getTalByMac(dst_mac, dst_id))
 	{
 		return false;
@@ -137,9 +162,9 @@ SatellitePacketSwitch::SatellitePacketSwitch(tal_id_t tal_id,
 
 bool SatellitePacketSwitch::getPacketDestination(const Data &packet, tal_id_t &src_id, tal_id_t &dst_id)
 {
-	MacAddress dst_mac = Ethernet::getDstMac(packet);
-	MacAddress src_mac = Ethernet::getSrcMac(packet);
-	RtLock(this->mutex);
+	uint64_t dst_mac = getDstMacKey(packet);
+	uint64_t src_mac = getSrcMacKey(packet);
+	RtLock lock{this->mutex};
 	if (!this->sarp_table.getTalByMac(dst_mac, dst_id))
 	{
 		return false;
@@ -161,8 +186,8 @@ bool SatellitePacketSwitch::isPacketForMe(const Data &packet, tal_id_t, bool &fo
 	}
 
 	tal_id_t dst_id;
-	MacAddress dst_mac = Ethernet::getDstMac(packet);
-	RtLock(this->mutex);
+	uint64_t dst_mac = getDstMacKey(packet);
+	RtLock lock{this->mutex};
 	if (!this->sarp_table.getTalByMac(dst_mac, dst_id))
 	{
 		return false;
@@ -0,0 +1,310 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file Phs.cpp
+ * @brief PHS LAN adaptation plugin implementation
+ * @author Viveris Technologies
+ */
+
+
+#include "Phs.h"
+#include "EthernetFrameView.h"
+#include "OpenSandModelConf.h"
+#include "OpenSandCore.h"
+
+#include <opensand_output/Output.h>
+
+
+Phs::Phs():
+	LanAdaptationPlugin(NET_PROTO::PHS)
+{
+}
+
+Phs::~Phs()
+{
+}
+
+void Phs::generateConfiguration()
+{
+	auto Conf = OpenSandModelConf::Get();
+	auto types = Conf->getModelTypesDefinition();
+	auto conf = Conf->getOrCreateComponent("network", "Network", "The DVB layer configuration");
+
+	auto compression = Conf->getOrCreateComponent("header_compression", "Header Compression", conf);
+	compression->setAdvanced(true);
+	compression->addParameter("phs", "PHS", types->getType("bool"),
+	                          "Replace the Ethernet headers by a rule index and generation on satellite, "
+	                          "the same setting must be used by all the entities");
+}
+
+bool Phs::isEnabled()
+{
+	bool enabled = false;
+	auto network = OpenSandModelConf::Get()->getProfileData()->getComponent("network");
+	if(network == nullptr)
+	{
+		return false;
+	}
+	auto compression = network->getComponent("header_compression");
+	if(compression != nullptr)
+	{
+		OpenSandModelConf::extractParameterData(compression, "phs", enabled);
+	}
+	return enabled;
+}
+
+Phs *Phs::constructPlugin()
+{
+	static Phs *plugin = static_cast<Phs *>(Phs::create<Phs, Phs::Context, Phs::PacketHandler>("PHS"));
+	return plugin;
+}
+
+bool Phs::init()
+{
+	if(!LanAdaptationPlugin::init())
+	{
+		return false;
+	}
+
+	this->upper.push_back("Ethernet");
+	this->upper.push_back("ROHC");
+	return true;
+}
+
+Phs::Context::Context(LanAdaptationPlugin &plugin):
+	LanAdaptationContext(plugin),
+	suppressor{},
+	suppressor_mutex{"lan.phs"},
+	restorer{},
+	restorer_stats{},
+	stats_mutex{"lan.phs.stats"},
+	last_suppressor_stats{},
+	last_restorer_stats{}
+{
+}
+
+Phs::Context::~Context()
+{
+}
+
+bool Phs::Context::init()
+{
+	if(!LanAdaptationPlugin::LanAdaptationContext::init())
+	{
+		return false;
+	}
+
+	// the frames always come from the Ethernet or ROHC plugins
+	this->handle_net_packet = false;
+
+	auto output = Output::Get();
+	this->probe_suppressed_bytes =
+		output->registerProbe<int>("PHS.Suppressed bytes", "Bytes", true, SAMPLE_SUM);
+	this->probe_definitions =
+		output->registerProbe<int>("PHS.Rule definitions", true, SAMPLE_SUM);
+	this->probe_restoration_failures =
+		output->registerProbe<int>("PHS.Restoration failures", true, SAMPLE_SUM);
+	return true;
+}
+
+bool Phs::Context::initLanAdaptationContext(tal_id_t tal_id, PacketSwitch *packet_switch)
+{
+	return LanAdaptationPlugin::LanAdaptationContext::initLanAdaptationContext(tal_id, packet_switch);
+}
+
+NetBurst *Phs::Context::encapsulate(NetBurst *burst,
+                                    std::map<long, int> &UNUSED(time_contexts))
+{
+	if(burst == nullptr)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "empty burst received\n");
+		return nullptr;
+	}
+
+	// create an empty burst of PHS packets
+	NetBurst *phs_packets = nullptr;
+	try
+	{
+		phs_packets = new NetBurst();
+	}
+	catch (const std::bad_alloc&)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "cannot allocate memory for burst of PHS packets\n");
+		delete burst;
+		return nullptr;
+	}
+
+	for(auto&& packet : *burst)
+	{
+		this->encapsulatePacket(packet);
+		if(packet)
+		{
+			phs_packets->add(std::move(packet));
+		}
+	}
+
+	LOG(this->log, LEVEL_INFO,
+	    "suppress the headers of %zu packets\n",
+	    phs_packets->size());
+
+	delete burst;
+	return phs_packets;
+}
+
+bool Phs::Context::canEncapsulatePacket() const
+{
+	return true;
+}
+
+void Phs::Context::encapsulatePacket(std::unique_ptr<NetPacket> &packet)
+{
+	const Data &data = packet->getData();
+	EthernetFrameView frame{data};
+
+	// the invalid frames are sent without suppression
+	Data phs_data;
+	{
+		RtLock lock{this->suppressor_mutex};
+		this->suppressor.suppress(data,
+		                          frame.isValid() ? frame.getHeaderLength() : 0,
+		                          packet->getSrcTalId(),
+		                          packet->getDstTalId(),
+		                          phs_data);
+	}
+	// the packet is reused for its encapsulation
+	packet->setEncapsulation(std::move(phs_data), this->getName(), this->getEtherType(), 0);
+}
+
+NetBurst *Phs::Context::deencapsulate(NetBurst *burst)
+{
+	if(burst == nullptr || this->current_upper == nullptr)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "empty burst received or no upper layer\n");
+		delete burst;
+		return nullptr;
+	}
+
+	// create an empty burst of upper packets
+	NetBurst *upper_packets = nullptr;
+	try
+	{
+		upper_packets = new NetBurst();
+	}
+	catch (const std::bad_alloc&)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "cannot allocate memory for burst of %s packets\n",
+		    this->current_upper->getName().c_str());
+		delete burst;
+		return nullptr;
+	}
+
+	for(auto&& packet : *burst)
+	{
+		Data upper_data;
+		if(!this->restorer.restore(packet->getData(),
+		                           packet->getSrcTalId(),
+		                           packet->getDstTalId(),
+		                           upper_data))
+		{
+			LOG(this->log, LEVEL_WARNING,
+			    "unknown or outdated PHS rule for packet from terminal %u "
+			    "to terminal %u, drop it\n", packet->getSrcTalId(), packet->getDstTalId());
+			continue;
+		}
+		upper_packets->add(this->current_upper->build(upper_data,
+		                                              upper_data.length(),
+		                                              packet->getQos(),
+		                                              packet->getSrcTalId(),
+		                                              packet->getDstTalId()));
+	}
+
+	{
+		RtLock lock{this->stats_mutex};
+		this->restorer_stats = this->restorer.getStats();
+	}
+
+	LOG(this->log, LEVEL_INFO,
+	    "restore the headers of %zu packets\n",
+	    upper_packets->size());
+
+	delete burst;
+	return upper_packets;
+}
+
+char Phs::Context::getLanHeader(unsigned int, const std::unique_ptr<NetPacket>&)
+{
+	return 0;
+}
+
+bool Phs::Context::handleTap()
+{
+	return false;
+}
+
+void Phs::Context::updateStats(unsigned int)
+{
+	PhsStats suppressor_stats;
+	{
+		RtLock lock{this->suppressor_mutex};
+		suppressor_stats = this->suppressor.getStats();
+	}
+	PhsStats restorer_stats;
+	{
+		RtLock lock{this->stats_mutex};
+		restorer_stats = this->restorer_stats;
+	}
+
+	this->probe_suppressed_bytes->put(suppressor_stats.suppressed_bytes -
+	                                  this->last_suppressor_stats.suppressed_bytes);
+	this->probe_definitions->put(suppressor_stats.definitions -
+	                             this->last_suppressor_stats.definitions);
+	this->probe_restoration_failures->put(restorer_stats.failures -
+	                                      this->last_restorer_stats.failures);
+	this->last_suppressor_stats = suppressor_stats;
+	this->last_restorer_stats = restorer_stats;
+}
+
+std::unique_ptr<NetPacket> Phs::PacketHandler::build(const Data &data,
+                                                     std::size_t data_length,
+                                                     uint8_t qos,
+                                                     uint8_t src_tal_id,
+                                                     uint8_t dst_tal_id) const
+{
+	return std::unique_ptr<NetPacket>(new NetPacket(data, data_length,
+	                                                this->getName(),
+	                                                this->getEtherType(),
+	                                                qos,
+	                                                src_tal_id,
+	                                                dst_tal_id,
+	                                                0));
+}
@@ -0,0 +1,154 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file Phs.h
+ * @brief PHS LAN adaptation plugin implementation
+ * @author Viveris Technologies
+ *
+ * This LAN adaptation plugin is stacked right above the encapsulation
+ * plugins when the header suppression is enabled: the Ethernet headers,
+ * nearly constant per pair of terminals and EVC, are replaced by the
+ * index and generation of a rule learnt on the fly, and restored at the far
+ * end.
+ */
+
+#ifndef PHS_CONTEXT_H
+#define PHS_CONTEXT_H
+
+#include "PhsTable.h"
+
+#include <NetBurst.h>
+#include <NetPacket.h>
+#include <LanAdaptationPlugin.h>
+#include <opensand_output/Output.h>
+#include <opensand_rt/RtMutex.h>
+
+#include <map>
+
+
+/**
+ * @class Phs
+ * @brief PHS lan adaptation plugin implementation
+ */
+class Phs: public LanAdaptationPlugin
+{
+public:
+	Phs();
+	~Phs();
+
+	/**
+	 * @brief Generate the configuration for the plugin
+	 */
+	static void generateConfiguration();
+
+	/**
+	 * @brief Whether the headers are suppressed by this plugin
+	 *
+	 * @return true if the PHS plugin is stacked above the encapsulation
+	 */
+	static bool isEnabled();
+
+	static Phs *constructPlugin();
+
+	bool init();
+
+	/**
+	 * @class Context
+	 * @brief PHS context
+	 */
+	class Context: public LanAdaptationContext
+	{
+	public:
+		/// constructor
+		Context(LanAdaptationPlugin &plugin);
+
+		/**
+		 * Destroy the  context
+		 */
+		~Context();
+
+		bool init();
+		NetBurst *encapsulate(NetBurst *burst, std::map<long, int> &(time_contexts));
+		NetBurst *deencapsulate(NetBurst *burst);
+		bool canEncapsulatePacket() const;
+		void encapsulatePacket(std::unique_ptr<NetPacket> &packet);
+		char getLanHeader(unsigned int pos, const std::unique_ptr<NetPacket>& packet);
+		bool handleTap();
+		void updateStats(unsigned int period);
+		bool initLanAdaptationContext(tal_id_t tal_id, PacketSwitch *packet_switch);
+
+	protected:
+		/// The suppressor, the frames are encapsulated by the downward
+		/// channel and by the upward one when they are forwarded
+		PhsSuppressor suppressor;
+		RtMutex suppressor_mutex;
+
+		/// The restorer, only used by the upward channel
+		PhsRestorer restorer;
+		/// The statistics of the restorer at the end of the last burst
+		PhsStats restorer_stats;
+		RtMutex stats_mutex;
+
+		/// The statistics reported at the last update
+		PhsStats last_suppressor_stats;
+		PhsStats last_restorer_stats;
+
+		std::shared_ptr<Probe<int>> probe_suppressed_bytes;
+		std::shared_ptr<Probe<int>> probe_definitions;
+		std::shared_ptr<Probe<int>> probe_restoration_failures;
+	};
+
+	/**
+	 * @class PacketHandler
+	 * @brief PHS packet handler
+	 */
+	class PacketHandler: public LanAdaptationPacketHandler
+	{
+	public:
+		PacketHandler(LanAdaptationPlugin &plugin):
+			LanAdaptationPlugin::LanAdaptationPacketHandler(plugin)
+		{};
+
+		size_t getFixedLength() const {return 0;};
+
+		size_t getLength(const unsigned char *) const
+		{
+			return 0;
+		}
+
+		std::unique_ptr<NetPacket> build(const Data &data,
+		                                 std::size_t data_length,
+		                                 uint8_t qos,
+		                                 uint8_t src_tal_id,
+		                                 uint8_t dst_tal_id) const override;
+	};
+};
+
+
+#endif
@@ -0,0 +1,223 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file PhsTable.cpp
+ * @brief The tables of the Payload Header Suppression rules
+ * @author Viveris Technologies
+ */
+
+
+#include <cstring>
+
+#include "PhsTable.h"
+
+
+/// The rules, and indexes, of each pair of terminals
+static constexpr std::size_t channel_rules = 64;
+/// The definitions sent when a rule is learnt
+static constexpr unsigned int definition_repeats = 3;
+/// The packets sent between two definitions of a rule
+static constexpr unsigned int definition_refresh = 256;
+/// The bits of the terminal ids indexing the rules
+static constexpr unsigned int tal_id_bits = 5;
+
+static constexpr uint8_t definition_type = 0x40;
+static constexpr uint8_t unsuppressed_type = 0xFF;
+
+
+/**
+ * @brief The index of the rules of a pair of terminals
+ */
+static std::size_t channelIndex(tal_id_t src_tal_id, tal_id_t dst_tal_id)
+{
+	constexpr tal_id_t mask = (1 << tal_id_bits) - 1;
+	return ((src_tal_id & mask) << tal_id_bits) | (dst_tal_id & mask);
+}
+
+
+PhsSuppressor::PhsSuppressor():
+	channels(1 << (2 * tal_id_bits), -1),
+	rules(),
+	clock(0),
+	stats()
+{
+}
+
+void PhsSuppressor::suppress(const Data &frame, std::size_t header_length,
+                             tal_id_t src_tal_id, tal_id_t dst_tal_id,
+                             Data &packet)
+{
+	this->stats.packets++;
+	if(header_length == 0 || header_length > ETHERNET_802_1AD_HEADSIZE ||
+	   header_length > frame.length())
+	{
+		packet.reserve(frame.length() + 1);
+		packet.assign(1, unsuppressed_type);
+		packet.append(frame);
+		return;
+	}
+
+	int32_t &block = this->channels[channelIndex(src_tal_id, dst_tal_id)];
+	if(block < 0)
+	{
+		block = this->rules.size();
+		this->rules.resize(this->rules.size() + channel_rules);
+	}
+
+	// the header of the flow or a free, else the least recently used, rule
+	Rule *first = &this->rules[block];
+	Rule *rule = nullptr;
+	Rule *replaced = nullptr;
+	for(std::size_t i = 0; i < channel_rules; i++)
+	{
+		Rule &candidate = first[i];
+		if(candidate.length == header_length &&
+		   std::memcmp(candidate.header, frame.data(), header_length) == 0)
+		{
+			rule = &candidate;
+			break;
+		}
+		if(replaced == nullptr ||
+		   (replaced->length != 0 &&
+		    (candidate.length == 0 || candidate.last_use < replaced->last_use)))
+		{
+			replaced = &candidate;
+		}
+	}
+	if(rule == nullptr)
+	{
+		rule = replaced;
+		rule->generation++;
+		rule->length = header_length;
+		std::memcpy(rule->header, frame.data(), header_length);
+		rule->definitions_left = definition_repeats;
+		rule->since_definition = 0;
+	}
+	rule->last_use = ++this->clock;
+	uint8_t index = rule - first;
+
+	if(rule->definitions_left > 0 || rule->since_definition >= definition_refresh)
+	{
+		this->stats.definitions++;
+		if(rule->definitions_left > 0)
+		{
+			rule->definitions_left--;
+		}
+		rule->since_definition = 0;
+		packet.reserve(frame.length() + 3);
+		packet.assign(1, definition_type | index);
+		packet.push_back(rule->generation);
+		packet.push_back(header_length);
+		packet.append(frame);
+	}
+	else
+	{
+		this->stats.suppressed_bytes += header_length - 2;
+		packet.reserve(frame.length() - header_length + 2);
+		packet.assign(1, index);
+		packet.push_back(rule->generation);
+		packet.append(frame, header_length, std::string::npos);
+	}
+	rule->since_definition++;
+}
+
+
+PhsRestorer::PhsRestorer():
+	channels(1 << (2 * tal_id_bits), -1),
+	rules(),
+	stats()
+{
+}
+
+bool PhsRestorer::restore(const Data &packet, tal_id_t src_tal_id,
+                          tal_id_t dst_tal_id, Data &frame)
+{
+	this->stats.packets++;
+	if(packet.empty())
+	{
+		this->stats.failures++;
+		return false;
+	}
+	uint8_t type = packet[0];
+	if(type == unsuppressed_type)
+	{
+		frame.assign(packet, 1, std::string::npos);
+		return true;
+	}
+	if(type >= definition_type + channel_rules)
+	{
+		this->stats.failures++;
+		return false;
+	}
+
+	int32_t &block = this->channels[channelIndex(src_tal_id, dst_tal_id)];
+	if(block < 0)
+	{
+		block = this->rules.size();
+		this->rules.resize(this->rules.size() + channel_rules);
+	}
+
+	if(packet.length() < 2)
+	{
+		this->stats.failures++;
+		return false;
+	}
+	uint8_t generation = packet[1];
+
+	if(type >= definition_type)
+	{
+		uint8_t length = packet.length() > 2 ? packet[2] : 0;
+		if(length == 0 || length > ETHERNET_802_1AD_HEADSIZE ||
+		   packet.length() < 3u + length)
+		{
+			this->stats.failures++;
+			return false;
+		}
+		Rule &rule = this->rules[block + (type - definition_type)];
+		rule.length = length;
+		rule.generation = generation;
+		std::memcpy(rule.header, packet.data() + 3, length);
+		this->stats.definitions++;
+		frame.assign(packet, 3, std::string::npos);
+		return true;
+	}
+
+	const Rule &rule = this->rules[block + type];
+	if(rule.length == 0 || rule.generation != generation)
+	{
+		// the definition of the rule, or of its reuse, was lost
+		this->stats.failures++;
+		return false;
+	}
+	this->stats.suppressed_bytes += rule.length - 2;
+	frame.reserve(rule.length + packet.length() - 2);
+	frame.assign(rule.header, rule.length);
+	frame.append(packet, 2, std::string::npos);
+	return true;
+}
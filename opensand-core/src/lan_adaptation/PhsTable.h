@@ -0,0 +1,162 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file PhsTable.h
+ * @brief The tables of the Payload Header Suppression rules
+ * @author Viveris Technologies
+ *
+ * A rule holds the Ethernet header of a flow, it is learnt by the
+ * suppressor and defined in-band to the restorer by sending the whole
+ * packet along with the rule index. The following packets of the flow
+ * only carry the index. Each pair of source and destination terminals
+ * has its own rules.
+ *
+ * The first byte of a PHS packet is:
+ *  - 0x00 to 0x3F: the index of the rule restoring the suppressed header,
+ *    followed by the rule generation and the packet without its header,
+ *  - 0x40 to 0x7F: the definition of the rule 0x3F at most, followed by
+ *    the rule generation, the header length and the whole packet,
+ *  - 0xFF: a packet without suppressed header.
+ *
+ * The generation of an index changes each time the suppressor reuses it
+ * for another header, the restorer drops the packets of a generation it
+ * did not receive the definition of, so that a lost or late definition
+ * does not restore the header of the previous rule.
+ */
+
+#ifndef PHS_TABLE_H
+#define PHS_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Data.h"
+#include "NetPacket.h"
+#include "OpenSandCore.h"
+
+
+/// The statistics of a suppressor or a restorer
+struct PhsStats
+{
+	/// The handled packets
+	uint64_t packets;
+	/// The packets sent or received with a rule definition
+	uint64_t definitions;
+	/// The bytes of the suppressed headers
+	uint64_t suppressed_bytes;
+	/// The packets dropped by the restorer
+	uint64_t failures;
+};
+
+
+/**
+ * @class PhsSuppressor
+ * @brief Suppress the Ethernet headers of the frames
+ */
+class PhsSuppressor
+{
+public:
+	PhsSuppressor();
+
+	/**
+	 * @brief Suppress the header of a frame
+	 *
+	 * @param frame          The Ethernet frame
+	 * @param header_length  The length of the Ethernet header
+	 * @param src_tal_id     The source terminal of the frame
+	 * @param dst_tal_id     The destination terminal of the frame
+	 * @param packet         OUT: The PHS packet
+	 */
+	void suppress(const Data &frame, std::size_t header_length,
+	              tal_id_t src_tal_id, tal_id_t dst_tal_id, Data &packet);
+
+	const PhsStats &getStats() const { return this->stats; };
+
+private:
+	struct Rule
+	{
+		uint8_t length;
+		uint8_t header[ETHERNET_802_1AD_HEADSIZE];
+		uint64_t last_use;
+		/// The number of headers the rule index was used for
+		uint8_t generation;
+		/// The definitions still to send
+		unsigned int definitions_left;
+		/// The packets sent since the last definition
+		unsigned int since_definition;
+	};
+
+	std::vector<int32_t> channels;
+	std::vector<Rule> rules;
+	uint64_t clock;
+	PhsStats stats;
+};
+
+
+/**
+ * @class PhsRestorer
+ * @brief Restore the headers suppressed by a PhsSuppressor
+ */
+class PhsRestorer
+{
+public:
+	PhsRestorer();
+
+	/**
+	 * @brief Restore the header of a packet
+	 *
+	 * @param packet      The PHS packet
+	 * @param src_tal_id  The source terminal of the packet
+	 * @param dst_tal_id  The destination terminal of the packet
+	 * @param frame       OUT: The Ethernet frame
+	 * @return true on success, false if the rule of the packet is unknown
+	 *         or of another generation
+	 */
+	bool restore(const Data &packet, tal_id_t src_tal_id, tal_id_t dst_tal_id,
+	             Data &frame);
+
+	const PhsStats &getStats() const { return this->stats; };
+
+private:
+	struct Rule
+	{
+		/// The header length, 0 for an undefined rule
+		uint8_t length;
+		/// The generation of the last definition received
+		uint8_t generation;
+		uint8_t header[ETHERNET_802_1AD_HEADSIZE];
+	};
+
+	std::vector<int32_t> channels;
+	std::vector<Rule> rules;
+	PhsStats stats;
+};
+
+#endif
@@ -0,0 +1,344 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file Rohc.cpp
+ * @brief ROHC LAN adaptation plugin implementation
+ * @author Viveris Technologies
+ */
+
+
+#include "Rohc.h"
+#include "EthernetFrameView.h"
+#include "OpenSandModelConf.h"
+#include "OpenSandCore.h"
+
+#include <opensand_output/Output.h>
+
+
+Rohc::Rohc():
+	LanAdaptationPlugin(NET_PROTO::ROHC)
+{
+}
+
+Rohc::~Rohc()
+{
+}
+
+void Rohc::generateConfiguration()
+{
+	auto Conf = OpenSandModelConf::Get();
+	auto types = Conf->getModelTypesDefinition();
+	auto conf = Conf->getOrCreateComponent("network", "Network", "The DVB layer configuration");
+
+	auto compression = Conf->getOrCreateComponent("header_compression", "Header Compression", conf);
+	compression->setAdvanced(true);
+	compression->addParameter("rohc", "ROHC", types->getType("bool"),
+	                          "Compress the IPv4/UDP/RTP headers of the Ethernet frames on satellite, "
+	                          "the same setting must be used by all the entities");
+}
+
+bool Rohc::isEnabled()
+{
+	bool enabled = false;
+	auto network = OpenSandModelConf::Get()->getProfileData()->getComponent("network");
+	if(network == nullptr)
+	{
+		return false;
+	}
+	auto compression = network->getComponent("header_compression");
+	if(compression != nullptr)
+	{
+		OpenSandModelConf::extractParameterData(compression, "rohc", enabled);
+	}
+	return enabled;
+}
+
+Rohc *Rohc::constructPlugin()
+{
+	static Rohc *plugin = static_cast<Rohc *>(Rohc::create<Rohc, Rohc::Context, Rohc::PacketHandler>("ROHC"));
+	return plugin;
+}
+
+bool Rohc::init()
+{
+	if(!LanAdaptationPlugin::init())
+	{
+		return false;
+	}
+
+	this->upper.push_back("Ethernet");
+	return true;
+}
+
+Rohc::Context::Context(LanAdaptationPlugin &plugin):
+	LanAdaptationContext(plugin),
+	compressor{},
+	compressor_mutex{"lan.rohc"},
+	compression_time{0},
+	decompressor{},
+	decompressor_stats{},
+	stats_mutex{"lan.rohc.stats"},
+	last_compressor_stats{},
+	last_decompressor_stats{}
+{
+}
+
+Rohc::Context::~Context()
+{
+}
+
+bool Rohc::Context::init()
+{
+	if(!LanAdaptationPlugin::LanAdaptationContext::init())
+	{
+		return false;
+	}
+
+	// the frames always come from the Ethernet plugin
+	this->handle_net_packet = false;
+
+	auto output = Output::Get();
+	this->probe_compression_ratio =
+		output->registerProbe<float>("ROHC.Compression ratio", "%", true, SAMPLE_AVG);
+	this->probe_compression_time =
+		output->registerProbe<float>("ROHC.Compression time", "us", true, SAMPLE_AVG);
+	this->probe_ir_packets =
+		output->registerProbe<int>("ROHC.IR packets", true, SAMPLE_SUM);
+	this->probe_decompression_ratio =
+		output->registerProbe<float>("ROHC.Decompression ratio", "%", true, SAMPLE_AVG);
+	this->probe_decompression_failures =
+		output->registerProbe<int>("ROHC.Decompression failures", true, SAMPLE_SUM);
+	return true;
+}
+
+bool Rohc::Context::initLanAdaptationContext(tal_id_t tal_id, PacketSwitch *packet_switch)
+{
+	return LanAdaptationPlugin::LanAdaptationContext::initLanAdaptationContext(tal_id, packet_switch);
+}
+
+NetBurst *Rohc::Context::encapsulate(NetBurst *burst,
+                                     std::map<long, int> &UNUSED(time_contexts))
+{
+	if(burst == nullptr)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "empty burst received\n");
+		return nullptr;
+	}
+
+	// create an empty burst of ROHC packets
+	NetBurst *rohc_packets = nullptr;
+	try
+	{
+		rohc_packets = new NetBurst();
+	}
+	catch (const std::bad_alloc&)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "cannot allocate memory for burst of ROHC packets\n");
+		delete burst;
+		return nullptr;
+	}
+
+	for(auto&& packet : *burst)
+	{
+		this->encapsulatePacket(packet);
+		if(packet)
+		{
+			rohc_packets->add(std::move(packet));
+		}
+	}
+
+	LOG(this->log, LEVEL_INFO,
+	    "compress %zu Ethernet frames\n",
+	    rohc_packets->size());
+
+	delete burst;
+	return rohc_packets;
+}
+
+bool Rohc::Context::canEncapsulatePacket() const
+{
+	return true;
+}
+
+void Rohc::Context::encapsulatePacket(std::unique_ptr<NetPacket> &packet)
+{
+	const Data &data = packet->getData();
+	EthernetFrameView frame{data};
+	if(!frame.isValid())
+	{
+		LOG(this->log, LEVEL_WARNING,
+		    "cannot compress an invalid Ethernet frame, drop it\n");
+		packet.reset();
+		return;
+	}
+
+	// the compressed packet is written once, at its final size
+	Data rohc_data;
+	{
+		RtLock lock{this->compressor_mutex};
+		auto start = std::chrono::steady_clock::now();
+		this->compressor.compress(data, frame.getHeaderLength(),
+		                          packet->getSrcTalId(),
+		                          packet->getDstTalId(),
+		                          rohc_data);
+		this->compression_time += std::chrono::steady_clock::now() - start;
+	}
+	// the packet is reused for its encapsulation
+	packet->setEncapsulation(std::move(rohc_data), this->getName(), this->getEtherType(), 0);
+}
+
+NetBurst *Rohc::Context::deencapsulate(NetBurst *burst)
+{
+	if(burst == nullptr || this->current_upper == nullptr)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "empty burst received or no upper layer\n");
+		delete burst;
+		return nullptr;
+	}
+
+	// create an empty burst of Ethernet frames
+	NetBurst *eth_frames = nullptr;
+	try
+	{
+		eth_frames = new NetBurst();
+	}
+	catch (const std::bad_alloc&)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "cannot allocate memory for burst of Ethernet frames\n");
+		delete burst;
+		return nullptr;
+	}
+
+	for(auto&& packet : *burst)
+	{
+		const Data &data = packet->getData();
+		EthernetFrameView frame{data};
+		Data eth_data;
+		if(!frame.isValid() ||
+		   !this->decompressor.decompress(data, frame.getHeaderLength(),
+		                                  packet->getSrcTalId(),
+		                                  packet->getDstTalId(),
+		                                  eth_data))
+		{
+			LOG(this->log, LEVEL_WARNING,
+			    "cannot decompress ROHC packet from terminal %u to terminal %u, "
+			    "drop it\n", packet->getSrcTalId(), packet->getDstTalId());
+			continue;
+		}
+		eth_frames->add(this->current_upper->build(eth_data,
+		                                           eth_data.length(),
+		                                           packet->getQos(),
+		                                           packet->getSrcTalId(),
+		                                           packet->getDstTalId()));
+	}
+
+	{
+		RtLock lock{this->stats_mutex};
+		this->decompressor_stats = this->decompressor.getStats();
+	}
+
+	LOG(this->log, LEVEL_INFO,
+	    "decompress %zu ROHC packets\n",
+	    eth_frames->size());
+
+	delete burst;
+	return eth_frames;
+}
+
+char Rohc::Context::getLanHeader(unsigned int, const std::unique_ptr<NetPacket>&)
+{
+	return 0;
+}
+
+bool Rohc::Context::handleTap()
+{
+	return false;
+}
+
+void Rohc::Context::updateStats(unsigned int)
+{
+	RohcStats compressor_stats;
+	std::chrono::steady_clock::duration compression_time;
+	{
+		RtLock lock{this->compressor_mutex};
+		compressor_stats = this->compressor.getStats();
+		compression_time = this->compression_time;
+		this->compression_time = std::chrono::steady_clock::duration{0};
+	}
+	RohcStats decompressor_stats;
+	{
+		RtLock lock{this->stats_mutex};
+		decompressor_stats = this->decompressor_stats;
+	}
+
+	RohcStats &last = this->last_compressor_stats;
+	uint64_t header_bytes = compressor_stats.header_bytes - last.header_bytes;
+	uint64_t packets = compressor_stats.packets - last.packets;
+	if(header_bytes > 0)
+	{
+		this->probe_compression_ratio->put(100.0f * (compressor_stats.rohc_bytes - last.rohc_bytes) /
+		                                   header_bytes);
+	}
+	if(packets > 0)
+	{
+		float time_us = std::chrono::duration<float, std::micro>(compression_time).count();
+		this->probe_compression_time->put(time_us / packets);
+	}
+	this->probe_ir_packets->put(compressor_stats.ir_packets - last.ir_packets);
+	last = compressor_stats;
+
+	RohcStats &last_decompressor = this->last_decompressor_stats;
+	header_bytes = decompressor_stats.header_bytes - last_decompressor.header_bytes;
+	if(header_bytes > 0)
+	{
+		this->probe_decompression_ratio->put(100.0f * (decompressor_stats.rohc_bytes - last_decompressor.rohc_bytes) /
+		                                     header_bytes);
+	}
+	this->probe_decompression_failures->put(decompressor_stats.failures - last_decompressor.failures);
+	last_decompressor = decompressor_stats;
+}
+
+std::unique_ptr<NetPacket> Rohc::PacketHandler::build(const Data &data,
+                                                      std::size_t data_length,
+                                                      uint8_t qos,
+                                                      uint8_t src_tal_id,
+                                                      uint8_t dst_tal_id) const
+{
+	return std::unique_ptr<NetPacket>(new NetPacket(data, data_length,
+	                                                this->getName(),
+	                                                this->getEtherType(),
+	                                                qos,
+	                                                src_tal_id,
+	                                                dst_tal_id,
+	                                                0));
+}
@@ -0,0 +1,159 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file Rohc.h
+ * @brief ROHC LAN adaptation plugin implementation
+ * @author Viveris Technologies
+ *
+ * This LAN adaptation plugin is stacked below the Ethernet plugin when the
+ * header compression is enabled: it compresses the IPv4/UDP and
+ * IPv4/UDP/RTP headers after the Ethernet header of the frames sent to the
+ * encapsulation plugins, and restores them on the received packets.
+ * The contexts are kept per pair of source and destination terminals.
+ */
+
+#ifndef ROHC_CONTEXT_H
+#define ROHC_CONTEXT_H
+
+#include "RohcCodec.h"
+
+#include <NetBurst.h>
+#include <NetPacket.h>
+#include <LanAdaptationPlugin.h>
+#include <opensand_output/Output.h>
+#include <opensand_rt/RtMutex.h>
+
+#include <chrono>
+#include <map>
+
+
+/**
+ * @class Rohc
+ * @brief ROHC lan adaptation plugin implementation
+ */
+class Rohc: public LanAdaptationPlugin
+{
+public:
+	Rohc();
+	~Rohc();
+
+	/**
+	 * @brief Generate the configuration for the plugin
+	 */
+	static void generateConfiguration();
+
+	/**
+	 * @brief Whether the headers are compressed by this plugin
+	 *
+	 * @return true if the ROHC plugin is stacked below Ethernet
+	 */
+	static bool isEnabled();
+
+	static Rohc *constructPlugin();
+
+	bool init();
+
+	/**
+	 * @class Context
+	 * @brief ROHC context
+	 */
+	class Context: public LanAdaptationContext
+	{
+	public:
+		/// constructor
+		Context(LanAdaptationPlugin &plugin);
+
+		/**
+		 * Destroy the  context
+		 */
+		~Context();
+
+		bool init();
+		NetBurst *encapsulate(NetBurst *burst, std::map<long, int> &(time_contexts));
+		NetBurst *deencapsulate(NetBurst *burst);
+		bool canEncapsulatePacket() const;
+		void encapsulatePacket(std::unique_ptr<NetPacket> &packet);
+		char getLanHeader(unsigned int pos, const std::unique_ptr<NetPacket>& packet);
+		bool handleTap();
+		void updateStats(unsigned int period);
+		bool initLanAdaptationContext(tal_id_t tal_id, PacketSwitch *packet_switch);
+
+	protected:
+		/// The compressor, the frames are encapsulated by the downward
+		/// channel and by the upward one when they are forwarded
+		RohcCompressor compressor;
+		RtMutex compressor_mutex;
+		/// The time spent compressing since the last update
+		std::chrono::steady_clock::duration compression_time;
+
+		/// The decompressor, only used by the upward channel
+		RohcDecompressor decompressor;
+		/// The statistics of the decompressor at the end of the last burst
+		RohcStats decompressor_stats;
+		RtMutex stats_mutex;
+
+		/// The statistics reported at the last update
+		RohcStats last_compressor_stats;
+		RohcStats last_decompressor_stats;
+
+		std::shared_ptr<Probe<float>> probe_compression_ratio;
+		std::shared_ptr<Probe<float>> probe_compression_time;
+		std::shared_ptr<Probe<int>> probe_ir_packets;
+		std::shared_ptr<Probe<float>> probe_decompression_ratio;
+		std::shared_ptr<Probe<int>> probe_decompression_failures;
+	};
+
+	/**
+	 * @class PacketHandler
+	 * @brief ROHC packet handler
+	 */
+	class PacketHandler: public LanAdaptationPacketHandler
+	{
+	public:
+		PacketHandler(LanAdaptationPlugin &plugin):
+			LanAdaptationPlugin::LanAdaptationPacketHandler(plugin)
+		{};
+
+		size_t getFixedLength() const {return 0;};
+
+		size_t getLength(const unsigned char *) const
+		{
+			return 0;
+		}
+
+		std::unique_ptr<NetPacket> build(const Data &data,
+		                                 std::size_t data_length,
+		                                 uint8_t qos,
+		                                 uint8_t src_tal_id,
+		                                 uint8_t dst_tal_id) const override;
+	};
+};
+
+
+#endif
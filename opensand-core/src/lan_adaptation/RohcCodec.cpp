@@ -0,0 +1,762 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file RohcCodec.cpp
+ * @brief The ROHC compression of the IPv4/UDP and IPv4/UDP/RTP headers
+ * @author Viveris Technologies
+ */
+
+
+#include <cstring>
+#include <netinet/in.h>
+
+#include "RohcCodec.h"
+
+
+/// The IR packets sent when a context is created or a field changes
+static constexpr unsigned int ir_repeats = 3;
+/// The packets sent between two refreshes of a context with an IR packet
+static constexpr unsigned int ir_refresh = 200;
+/// The successive CRC failures invalidating a decompression context
+static constexpr unsigned int max_failures = 3;
+/// The contexts, and CIDs, of each pair of terminals
+static constexpr std::size_t channel_contexts = 15;
+/// The bits of the terminal ids indexing the contexts
+static constexpr unsigned int tal_id_bits = 5;
+
+static constexpr uint8_t add_cid = 0xE0;
+/// The CID of the packets sent without header compression
+static constexpr uint8_t uncompressed_cid = 0x0F;
+static constexpr uint8_t ir_type = 0xFD;
+static constexpr uint8_t uor2_type = 0xC0;
+
+static constexpr std::size_t ip_udp_length = 28;
+static constexpr std::size_t ip_udp_rtp_length = 40;
+/// The longest ROHC header, an IR packet of the RTP profile
+static constexpr std::size_t max_rohc_length = 48;
+
+
+/**
+ * @brief The tables of the reflected CRCs of RFC 3095 section 5.9
+ */
+struct RohcCrc
+{
+	uint8_t crc3[256];
+	uint8_t crc7[256];
+	uint8_t crc8[256];
+
+	RohcCrc()
+	{
+		fill(this->crc3, 0x06);
+		fill(this->crc7, 0x79);
+		fill(this->crc8, 0xE0);
+	};
+
+	static void fill(uint8_t *table, uint8_t polynomial)
+	{
+		for(unsigned int byte = 0; byte < 256; byte++)
+		{
+			uint8_t crc = byte;
+			for(unsigned int bit = 0; bit < 8; bit++)
+			{
+				crc = (crc & 1) ? (crc >> 1) ^ polynomial : crc >> 1;
+			}
+			table[byte] = crc;
+		}
+	};
+
+	static uint8_t compute(const uint8_t *table, uint8_t init,
+	                       const unsigned char *data, std::size_t length)
+	{
+		uint8_t crc = init;
+		for(std::size_t i = 0; i < length; i++)
+		{
+			crc = table[crc ^ data[i]];
+		}
+		return crc;
+	};
+};
+
+static const RohcCrc rohc_crc;
+
+
+/**
+ * @brief Decode a W-LSB encoded value in the interval [ref - p, ref - p + 2^bits[
+ */
+static uint32_t decodeLsb(uint32_t ref, uint32_t lsb, unsigned int bits, int32_t p)
+{
+	uint32_t mask = (1u << bits) - 1;
+	uint32_t base = ref - p;
+	return base + ((lsb - base) & mask);
+}
+
+static uint16_t read16(const unsigned char *data)
+{
+	return (data[0] << 8) | data[1];
+}
+
+static uint32_t read32(const unsigned char *data)
+{
+	return (uint32_t(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+static void write16(unsigned char *data, uint16_t value)
+{
+	data[0] = value >> 8;
+	data[1] = value & 0xFF;
+}
+
+static void write32(unsigned char *data, uint32_t value)
+{
+	write16(data, value >> 16);
+	write16(data + 2, value & 0xFFFF);
+}
+
+/**
+ * @brief The checksum of an IPv4 header without options,
+ *        its checksum field being ignored
+ */
+static uint16_t ipChecksum(const unsigned char *header)
+{
+	uint32_t sum = 0;
+	for(std::size_t i = 0; i < 20; i += 2)
+	{
+		if(i != 10)
+		{
+			sum += read16(header + i);
+		}
+	}
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	sum = (sum & 0xFFFF) + (sum >> 16);
+	return ~sum & 0xFFFF;
+}
+
+/**
+ * @brief The index of the contexts of a pair of terminals
+ */
+static std::size_t channelIndex(tal_id_t src_tal_id, tal_id_t dst_tal_id)
+{
+	constexpr tal_id_t mask = (1 << tal_id_bits) - 1;
+	return ((src_tal_id & mask) << tal_id_bits) | (dst_tal_id & mask);
+}
+
+static std::size_t headersLength(RohcProfile profile)
+{
+	return profile == RohcProfile::Rtp ? ip_udp_rtp_length : ip_udp_length;
+}
+
+
+std::size_t RohcHeaders::parse(const unsigned char *packet, std::size_t length,
+                               RohcProfile &profile)
+{
+	profile = RohcProfile::Uncompressed;
+	// IPv4 without options nor fragmentation, carrying a whole UDP datagram
+	if(length < ip_udp_length || packet[0] != 0x45 ||
+	   read16(packet + 2) != length || (read16(packet + 6) & 0xBFFF) != 0 ||
+	   packet[9] != IPPROTO_UDP || read16(packet + 10) != ipChecksum(packet) ||
+	   read16(packet + 24) != length - 20)
+	{
+		return 0;
+	}
+	this->tos = packet[1];
+	this->ip_id = read16(packet + 4);
+	this->dont_fragment = (packet[6] & 0x40) != 0;
+	this->ttl = packet[8];
+	std::memcpy(this->src_addr, packet + 12, 4);
+	std::memcpy(this->dst_addr, packet + 16, 4);
+	this->src_port = read16(packet + 20);
+	this->dst_port = read16(packet + 22);
+	this->udp_checksum = read16(packet + 26);
+
+	// RTP version 2 without padding, extension nor CSRC, between the
+	// even unprivileged ports usually chosen for the RTP sessions
+	// and whose payload type is not one of RTCP
+	const unsigned char *rtp = packet + ip_udp_length;
+	uint8_t payload_type = length >= ip_udp_rtp_length ? rtp[1] & 0x7F : 0;
+	if(length >= ip_udp_rtp_length && rtp[0] == 0x80 &&
+	   this->src_port >= 1024 && this->src_port % 2 == 0 &&
+	   this->dst_port >= 1024 && this->dst_port % 2 == 0 &&
+	   (payload_type < 72 || payload_type > 76))
+	{
+		this->rtp_flags = rtp[0];
+		this->marker = (rtp[1] & 0x80) != 0;
+		this->payload_type = payload_type;
+		this->rtp_sn = read16(rtp + 2);
+		this->timestamp = read32(rtp + 4);
+		this->ssrc = read32(rtp + 8);
+		profile = RohcProfile::Rtp;
+		return ip_udp_rtp_length;
+	}
+	this->rtp_flags = 0;
+	this->marker = false;
+	this->payload_type = 0;
+	this->rtp_sn = 0;
+	this->timestamp = 0;
+	this->ssrc = 0;
+	profile = RohcProfile::Udp;
+	return ip_udp_length;
+}
+
+void RohcHeaders::build(RohcProfile profile, std::size_t payload_length,
+                        unsigned char *packet) const
+{
+	std::size_t length = headersLength(profile) + payload_length;
+	packet[0] = 0x45;
+	packet[1] = this->tos;
+	write16(packet + 2, length);
+	write16(packet + 4, this->ip_id);
+	write16(packet + 6, this->dont_fragment ? 0x4000 : 0);
+	packet[8] = this->ttl;
+	packet[9] = IPPROTO_UDP;
+	std::memcpy(packet + 12, this->src_addr, 4);
+	std::memcpy(packet + 16, this->dst_addr, 4);
+	write16(packet + 10, ipChecksum(packet));
+	write16(packet + 20, this->src_port);
+	write16(packet + 22, this->dst_port);
+	write16(packet + 24, length - 20);
+	write16(packet + 26, this->udp_checksum);
+	if(profile == RohcProfile::Rtp)
+	{
+		unsigned char *rtp = packet + ip_udp_length;
+		rtp[0] = this->rtp_flags;
+		rtp[1] = (this->marker ? 0x80 : 0) | this->payload_type;
+		write16(rtp + 2, this->rtp_sn);
+		write32(rtp + 4, this->timestamp);
+		write32(rtp + 8, this->ssrc);
+	}
+}
+
+bool RohcHeaders::sameFlow(const RohcHeaders &other, RohcProfile profile) const
+{
+	return std::memcmp(this->src_addr, other.src_addr, 4) == 0 &&
+	       std::memcmp(this->dst_addr, other.dst_addr, 4) == 0 &&
+	       this->src_port == other.src_port &&
+	       this->dst_port == other.dst_port &&
+	       (profile != RohcProfile::Rtp || this->ssrc == other.ssrc);
+}
+
+
+RohcCompressor::RohcCompressor():
+	channels(1 << (2 * tal_id_bits), -1),
+	contexts(),
+	clock(0),
+	stats()
+{
+}
+
+RohcCompressor::Context &RohcCompressor::getContext(tal_id_t src_tal_id,
+                                                    tal_id_t dst_tal_id,
+                                                    const RohcHeaders &headers,
+                                                    RohcProfile profile,
+                                                    uint8_t &cid)
+{
+	int32_t &block = this->channels[channelIndex(src_tal_id, dst_tal_id)];
+	if(block < 0)
+	{
+		block = this->contexts.size();
+		this->contexts.resize(this->contexts.size() + channel_contexts);
+	}
+
+	Context *first = &this->contexts[block];
+	Context *replaced = nullptr;
+	for(std::size_t i = 0; i < channel_contexts; i++)
+	{
+		Context &context = first[i];
+		if(!context.used)
+		{
+			if(replaced == nullptr || replaced->used)
+			{
+				replaced = &context;
+			}
+			continue;
+		}
+		if(context.profile == profile && context.headers.sameFlow(headers, profile))
+		{
+			context.last_use = ++this->clock;
+			cid = i;
+			return context;
+		}
+		if(replaced == nullptr ||
+		   (replaced->used && context.last_use < replaced->last_use))
+		{
+			replaced = &context;
+		}
+	}
+
+	*replaced = Context();
+	replaced->used = true;
+	replaced->last_use = ++this->clock;
+	replaced->profile = profile;
+	replaced->ir_left = ir_repeats;
+	cid = replaced - first;
+	return *replaced;
+}
+
+void RohcCompressor::compress(const Data &frame, std::size_t eth_length,
+                              tal_id_t src_tal_id, tal_id_t dst_tal_id,
+                              Data &packet)
+{
+	const unsigned char *ip = frame.data() + eth_length;
+	std::size_t ip_length = frame.length() - eth_length;
+	unsigned char rohc[max_rohc_length];
+	std::size_t rohc_length = 0;
+	RohcHeaders headers;
+	RohcProfile profile;
+
+	this->stats.packets++;
+	std::size_t header_length = headers.parse(ip, ip_length, profile);
+	if(header_length == 0)
+	{
+		this->stats.uncompressed_packets++;
+		packet.reserve(frame.length() + 1);
+		packet.assign(frame.data(), eth_length);
+		packet.push_back(add_cid | uncompressed_cid);
+		packet.append(ip, ip_length);
+		return;
+	}
+
+	uint8_t cid;
+	Context &context = this->getContext(src_tal_id, dst_tal_id, headers, profile, cid);
+	bool fresh = context.ir_left == ir_repeats && context.since_ir == 0;
+	const RohcHeaders &last = context.headers;
+	bool rtp = profile == RohcProfile::Rtp;
+	uint16_t sn = rtp ? headers.rtp_sn : uint16_t(context.sn + 1);
+	uint16_t sn_delta = sn - context.sn;
+
+	// a change of the fields sent in the IR packets only
+	bool change = !fresh &&
+	              (headers.tos != last.tos || headers.ttl != last.ttl ||
+	               headers.dont_fragment != last.dont_fragment ||
+	               (headers.udp_checksum == 0) != (last.udp_checksum == 0) ||
+	               headers.rtp_flags != last.rtp_flags ||
+	               headers.payload_type != last.payload_type);
+
+	// the IP-ID is sent raw once it does not follow the SN
+	uint16_t ip_id_offset = headers.ip_id - sn;
+	bool ip_id_jump = !fresh && ip_id_offset != context.ip_id_offset;
+	if(ip_id_jump && !context.random_ip_id)
+	{
+		change = true;
+	}
+
+	// the RTP TS is scaled by the stride learnt from the first packets
+	uint32_t ts_scaled = 0;
+	if(rtp && !fresh)
+	{
+		uint32_t ts_delta = headers.timestamp - last.timestamp;
+		if(context.ts_stride == 0)
+		{
+			if(sn_delta != 0 && ts_delta != 0 && ts_delta % sn_delta == 0)
+			{
+				context.ts_stride = ts_delta / sn_delta;
+				context.ts_offset = headers.timestamp % context.ts_stride;
+				change = true;
+			}
+		}
+		else if(headers.timestamp % context.ts_stride != context.ts_offset)
+		{
+			context.ts_stride = 0;
+			change = true;
+		}
+	}
+	if(rtp && context.ts_stride != 0)
+	{
+		ts_scaled = headers.timestamp / context.ts_stride;
+	}
+	uint32_t ts_scaled_delta = ts_scaled - context.ts_scaled;
+
+	if(cid != 0)
+	{
+		rohc[rohc_length++] = add_cid | cid;
+	}
+	bool ir = change || context.ir_left > 0 || context.since_ir >= ir_refresh ||
+	          (rtp && context.ts_stride == 0);
+	if(!ir && !rtp && sn_delta >= 1 && sn_delta <= 16)
+	{
+		// UO-0
+		rohc[rohc_length++] = (sn & 0x0F) << 3;
+	}
+	else if(!ir && !rtp && sn_delta >= 1 && sn_delta <= 32)
+	{
+		// UOR-2
+		rohc[rohc_length++] = uor2_type | (sn & 0x1F);
+		rohc[rohc_length++] = 0;
+	}
+	else if(!ir && rtp && !headers.marker && sn_delta >= 1 && sn_delta <= 16 &&
+	        ts_scaled_delta == sn_delta)
+	{
+		// UO-0, the TS is inferred from the SN
+		rohc[rohc_length++] = (sn & 0x0F) << 3;
+	}
+	else if(!ir && rtp && sn_delta >= 1 && sn_delta <= 64 && ts_scaled_delta <= 31)
+	{
+		// UOR-2
+		rohc[rohc_length++] = uor2_type | (ts_scaled & 0x1F);
+		rohc[rohc_length++] = (headers.marker ? 0x80 : 0) | (sn & 0x3F);
+		rohc[rohc_length++] = 0;
+	}
+	else
+	{
+		ir = true;
+	}
+
+	if(ir)
+	{
+		this->stats.ir_packets++;
+		if(change)
+		{
+			context.ir_left = ir_repeats;
+		}
+		if(context.ir_left > 0)
+		{
+			context.ir_left--;
+		}
+		context.since_ir = 0;
+		context.random_ip_id = ip_id_jump;
+
+		rohc[rohc_length++] = ir_type;
+		rohc[rohc_length++] = static_cast<uint8_t>(profile);
+		std::size_t crc_pos = rohc_length++;
+		rohc[crc_pos] = 0;
+		// static chain
+		rohc[rohc_length++] = 0x40;
+		rohc[rohc_length++] = IPPROTO_UDP;
+		std::memcpy(rohc + rohc_length, headers.src_addr, 4);
+		std::memcpy(rohc + rohc_length + 4, headers.dst_addr, 4);
+		rohc_length += 8;
+		write16(rohc + rohc_length, headers.src_port);
+		write16(rohc + rohc_length + 2, headers.dst_port);
+		rohc_length += 4;
+		if(rtp)
+		{
+			write32(rohc + rohc_length, headers.ssrc);
+			rohc_length += 4;
+		}
+		// dynamic chain
+		rohc[rohc_length++] = headers.tos;
+		rohc[rohc_length++] = headers.ttl;
+		write16(rohc + rohc_length, headers.ip_id);
+		rohc_length += 2;
+		rohc[rohc_length++] = (headers.dont_fragment ? 0x80 : 0) |
+		                      (context.random_ip_id ? 0x40 : 0);
+		write16(rohc + rohc_length, headers.udp_checksum);
+		rohc_length += 2;
+		if(rtp)
+		{
+			rohc[rohc_length++] = headers.rtp_flags;
+			rohc[rohc_length++] = (headers.marker ? 0x80 : 0) | headers.payload_type;
+			write16(rohc + rohc_length, sn);
+			write32(rohc + rohc_length + 2, headers.timestamp);
+			write32(rohc + rohc_length + 6, context.ts_stride);
+			rohc_length += 10;
+		}
+		else
+		{
+			write16(rohc + rohc_length, sn);
+			rohc_length += 2;
+		}
+		rohc[crc_pos] = RohcCrc::compute(rohc_crc.crc8, 0xFF, rohc, rohc_length);
+	}
+	else
+	{
+		// the CRC of the original headers closes the base header
+		std::size_t first = cid != 0 ? 1 : 0;
+		if(rohc_length - first == 1)
+		{
+			rohc[first] |= RohcCrc::compute(rohc_crc.crc3, 0x07, ip, header_length);
+		}
+		else
+		{
+			rohc[rohc_length - 1] = RohcCrc::compute(rohc_crc.crc7, 0x7F, ip, header_length);
+		}
+		if(context.random_ip_id)
+		{
+			write16(rohc + rohc_length, headers.ip_id);
+			rohc_length += 2;
+		}
+		if(headers.udp_checksum != 0)
+		{
+			write16(rohc + rohc_length, headers.udp_checksum);
+			rohc_length += 2;
+		}
+	}
+	context.since_ir++;
+	context.headers = headers;
+	context.sn = sn;
+	context.ip_id_offset = ip_id_offset;
+	context.ts_scaled = ts_scaled;
+
+	this->stats.header_bytes += header_length;
+	this->stats.rohc_bytes += rohc_length;
+	packet.reserve(eth_length + rohc_length + ip_length - header_length);
+	packet.assign(frame.data(), eth_length);
+	packet.append(rohc, rohc_length);
+	packet.append(ip + header_length, ip_length - header_length);
+}
+
+
+RohcDecompressor::RohcDecompressor():
+	channels(1 << (2 * tal_id_bits), -1),
+	contexts(),
+	stats()
+{
+}
+
+RohcDecompressor::Context &RohcDecompressor::getContext(tal_id_t src_tal_id,
+                                                        tal_id_t dst_tal_id,
+                                                        uint8_t cid)
+{
+	int32_t &block = this->channels[channelIndex(src_tal_id, dst_tal_id)];
+	if(block < 0)
+	{
+		block = this->contexts.size();
+		this->contexts.resize(this->contexts.size() + channel_contexts);
+	}
+	return this->contexts[block + cid];
+}
+
+bool RohcDecompressor::decompress(const Data &packet, std::size_t eth_length,
+                                  tal_id_t src_tal_id, tal_id_t dst_tal_id,
+                                  Data &frame)
+{
+	const unsigned char *rohc = packet.data();
+	std::size_t length = packet.length();
+	std::size_t pos = eth_length;
+	uint8_t cid = 0;
+
+	this->stats.packets++;
+	if(pos < length && (rohc[pos] & 0xF0) == add_cid)
+	{
+		cid = rohc[pos++] & 0x0F;
+		if(cid == uncompressed_cid)
+		{
+			this->stats.uncompressed_packets++;
+			frame.reserve(length - 1);
+			frame.assign(rohc, eth_length);
+			frame.append(rohc + pos, length - pos);
+			return true;
+		}
+	}
+	if(pos >= length)
+	{
+		this->stats.failures++;
+		return false;
+	}
+
+	Context &context = this->getContext(src_tal_id, dst_tal_id, cid);
+	RohcHeaders headers;
+	RohcProfile profile;
+	unsigned char header[ip_udp_rtp_length];
+	std::size_t rohc_start = pos - (cid != 0 ? 1 : 0);
+	uint8_t type = rohc[pos];
+	if(type == ir_type)
+	{
+		if(pos + 2 >= length)
+		{
+			this->stats.failures++;
+			return false;
+		}
+		profile = static_cast<RohcProfile>(rohc[pos + 1]);
+		if(profile != RohcProfile::Rtp && profile != RohcProfile::Udp)
+		{
+			this->stats.failures++;
+			return false;
+		}
+		bool rtp = profile == RohcProfile::Rtp;
+		std::size_t ir_length = rtp ? 3 + 18 + 19 : 3 + 14 + 9;
+		if(pos + ir_length > length)
+		{
+			this->stats.failures++;
+			return false;
+		}
+		unsigned char ir[max_rohc_length];
+		std::size_t rohc_length = pos + ir_length - rohc_start;
+		std::memcpy(ir, rohc + rohc_start, rohc_length);
+		ir[pos - rohc_start + 2] = 0;
+		if(RohcCrc::compute(rohc_crc.crc8, 0xFF, ir, rohc_length) != rohc[pos + 2])
+		{
+			this->stats.failures++;
+			return false;
+		}
+
+		const unsigned char *chain = rohc + pos + 3;
+		if(chain[0] != 0x40 || chain[1] != IPPROTO_UDP)
+		{
+			this->stats.failures++;
+			return false;
+		}
+		std::memcpy(headers.src_addr, chain + 2, 4);
+		std::memcpy(headers.dst_addr, chain + 6, 4);
+		headers.src_port = read16(chain + 10);
+		headers.dst_port = read16(chain + 12);
+		chain += 14;
+		headers.ssrc = 0;
+		if(rtp)
+		{
+			headers.ssrc = read32(chain);
+			chain += 4;
+		}
+		headers.tos = chain[0];
+		headers.ttl = chain[1];
+		headers.ip_id = read16(chain + 2);
+		headers.dont_fragment = (chain[4] & 0x80) != 0;
+		context.random_ip_id = (chain[4] & 0x40) != 0;
+		headers.udp_checksum = read16(chain + 5);
+		chain += 7;
+		if(rtp)
+		{
+			headers.rtp_flags = chain[0];
+			headers.marker = (chain[1] & 0x80) != 0;
+			headers.payload_type = chain[1] & 0x7F;
+			headers.rtp_sn = read16(chain + 2);
+			headers.timestamp = read32(chain + 4);
+			context.sn = headers.rtp_sn;
+			context.ts_stride = read32(chain + 8);
+			context.ts_offset = 0;
+			context.ts_scaled = 0;
+			if(context.ts_stride != 0)
+			{
+				context.ts_offset = headers.timestamp % context.ts_stride;
+				context.ts_scaled = headers.timestamp / context.ts_stride;
+			}
+		}
+		else
+		{
+			headers.rtp_flags = 0;
+			headers.marker = false;
+			headers.payload_type = 0;
+			headers.rtp_sn = 0;
+			headers.timestamp = 0;
+			context.sn = read16(chain);
+		}
+		context.valid = true;
+		context.profile = profile;
+		context.ip_id_offset = headers.ip_id - context.sn;
+		context.failures = 0;
+		pos += ir_length;
+		headers.build(profile, length - pos, header);
+		this->stats.ir_packets++;
+	}
+	else if((type & 0x80) == 0 || (type & 0xE0) == uor2_type)
+	{
+		if(!context.valid)
+		{
+			this->stats.failures++;
+			return false;
+		}
+		profile = context.profile;
+		headers = context.headers;
+		bool rtp = profile == RohcProfile::Rtp;
+		bool uo0 = (type & 0x80) == 0;
+		std::size_t base_length = uo0 ? 1 : (rtp ? 3 : 2);
+		std::size_t tail_length = (context.random_ip_id ? 2 : 0) +
+		                          (headers.udp_checksum != 0 ? 2 : 0);
+		if(pos + base_length + tail_length > length)
+		{
+			this->stats.failures++;
+			return false;
+		}
+		uint16_t sn;
+		uint32_t ts_scaled = context.ts_scaled;
+		uint8_t crc;
+		if(uo0)
+		{
+			sn = decodeLsb(context.sn, (type >> 3) & 0x0F, 4, -1);
+			ts_scaled += uint16_t(sn - context.sn);
+			headers.marker = false;
+			crc = type & 0x07;
+		}
+		else if(rtp)
+		{
+			ts_scaled = decodeLsb(context.ts_scaled, type & 0x1F, 5, 0);
+			headers.marker = (rohc[pos + 1] & 0x80) != 0;
+			sn = decodeLsb(context.sn, rohc[pos + 1] & 0x3F, 6, -1);
+			crc = rohc[pos + 2] & 0x7F;
+		}
+		else
+		{
+			sn = decodeLsb(context.sn, type & 0x1F, 5, -1);
+			crc = rohc[pos + 1] & 0x7F;
+		}
+		pos += base_length;
+		if(rtp)
+		{
+			headers.rtp_sn = sn;
+			headers.timestamp = ts_scaled * context.ts_stride + context.ts_offset;
+		}
+		headers.ip_id = sn + context.ip_id_offset;
+		if(context.random_ip_id)
+		{
+			headers.ip_id = read16(rohc + pos);
+			pos += 2;
+		}
+		if(headers.udp_checksum != 0)
+		{
+			headers.udp_checksum = read16(rohc + pos);
+			pos += 2;
+		}
+		headers.build(profile, length - pos, header);
+		std::size_t header_length = headersLength(profile);
+		uint8_t expected = uo0 ?
+			RohcCrc::compute(rohc_crc.crc3, 0x07, header, header_length) :
+			RohcCrc::compute(rohc_crc.crc7, 0x7F, header, header_length);
+		if(crc != expected)
+		{
+			// a lost context, drop its packets until the next IR
+			this->stats.failures++;
+			if(++context.failures >= max_failures)
+			{
+				context.valid = false;
+			}
+			return false;
+		}
+		context.failures = 0;
+		context.sn = sn;
+		context.ts_scaled = ts_scaled;
+		if(!context.random_ip_id)
+		{
+			context.ip_id_offset = headers.ip_id - sn;
+		}
+	}
+	else
+	{
+		this->stats.failures++;
+		return false;
+	}
+	context.headers = headers;
+
+	std::size_t header_length = headersLength(profile);
+	this->stats.header_bytes += header_length;
+	this->stats.rohc_bytes += pos - rohc_start;
+	frame.reserve(eth_length + header_length + length - pos);
+	frame.assign(rohc, eth_length);
+	frame.append(header, header_length);
+	frame.append(rohc + pos, length - pos);
+	return true;
+}
@@ -0,0 +1,246 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file RohcCodec.h
+ * @brief The ROHC compression of the IPv4/UDP and IPv4/UDP/RTP headers
+ * @author Viveris Technologies
+ *
+ * The packets follow the ROHC framework of RFC 5795 with small CIDs and
+ * the IR, UO-0 and UOR-2 packets of the RTP and UDP profiles of RFC 3095
+ * in unidirectional mode. The headers of the other packets are sent
+ * unchanged behind the Add-CID octet of the reserved CID 15.
+ */
+
+#ifndef ROHC_CODEC_H
+#define ROHC_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Data.h"
+#include "OpenSandCore.h"
+
+
+/// The ROHC profiles
+enum class RohcProfile: uint8_t
+{
+	Uncompressed = 0x00,
+	Rtp = 0x01,
+	Udp = 0x02,
+};
+
+
+/**
+ * @brief The fields of the IPv4, UDP and RTP headers of a packet
+ */
+struct RohcHeaders
+{
+	// static fields
+	uint8_t src_addr[4];
+	uint8_t dst_addr[4];
+	uint16_t src_port;
+	uint16_t dst_port;
+	uint32_t ssrc;
+
+	// dynamic fields
+	uint8_t tos;
+	uint8_t ttl;
+	uint16_t ip_id;
+	bool dont_fragment;
+	uint16_t udp_checksum;
+	/// the RTP version, padding, extension and CSRC count octet
+	uint8_t rtp_flags;
+	bool marker;
+	uint8_t payload_type;
+	uint16_t rtp_sn;
+	uint32_t timestamp;
+
+	/**
+	 * @brief Parse the headers of an IPv4 packet
+	 *
+	 * @param packet   The IPv4 packet
+	 * @param length   The packet length
+	 * @param profile  OUT: The profile compressing the headers,
+	 *                 Uncompressed if they cannot be compressed
+	 * @return the length of the compressed headers, 0 if Uncompressed
+	 */
+	std::size_t parse(const unsigned char *packet, std::size_t length,
+	                  RohcProfile &profile);
+
+	/**
+	 * @brief Write the headers, with the lengths and checksum
+	 *        matching the payload
+	 *
+	 * @param profile         The profile of the headers
+	 * @param payload_length  The length of the payload after the headers
+	 * @param packet          OUT: The headers
+	 */
+	void build(RohcProfile profile, std::size_t payload_length,
+	           unsigned char *packet) const;
+
+	/// Whether the static fields, that identify a flow, are the same
+	bool sameFlow(const RohcHeaders &other, RohcProfile profile) const;
+};
+
+
+/// The statistics of a compressor or a decompressor
+struct RohcStats
+{
+	/// The handled packets
+	uint64_t packets;
+	/// The packets sent or received with IR headers
+	uint64_t ir_packets;
+	/// The packets sent or received without header compression
+	uint64_t uncompressed_packets;
+	/// The packets dropped by the decompressor
+	uint64_t failures;
+	/// The length of the uncompressed headers
+	uint64_t header_bytes;
+	/// The length of the ROHC headers
+	uint64_t rohc_bytes;
+};
+
+
+/**
+ * @class RohcCompressor
+ * @brief Compress the headers after the Ethernet header of the frames
+ *
+ * The contexts are kept in a flat array, each pair of source and
+ * destination terminals owning a block of 15 contexts with its own CIDs.
+ */
+class RohcCompressor
+{
+public:
+	RohcCompressor();
+
+	/**
+	 * @brief Compress a frame
+	 *
+	 * @param frame       The Ethernet frame
+	 * @param eth_length  The length of the Ethernet header
+	 * @param src_tal_id  The source terminal of the frame
+	 * @param dst_tal_id  The destination terminal of the frame
+	 * @param packet      OUT: The Ethernet header, the ROHC header and the payload
+	 */
+	void compress(const Data &frame, std::size_t eth_length,
+	              tal_id_t src_tal_id, tal_id_t dst_tal_id, Data &packet);
+
+	const RohcStats &getStats() const { return this->stats; };
+
+private:
+	struct Context
+	{
+		bool used;
+		uint64_t last_use;
+		RohcProfile profile;
+		/// The headers of the last packet sent
+		RohcHeaders headers;
+		/// The last SN sent, the RTP SN or a counter for UDP
+		uint16_t sn;
+		uint16_t ip_id_offset;
+		bool random_ip_id;
+		uint32_t ts_stride;
+		uint32_t ts_offset;
+		uint32_t ts_scaled;
+		/// The IR packets still to send after a change
+		unsigned int ir_left;
+		/// The packets sent since the last IR packet
+		unsigned int since_ir;
+	};
+
+	/**
+	 * @brief Get the context of a flow, a new one replaces a free
+	 *        or the least recently used context of the terminals
+	 *
+	 * @return the context and its CID
+	 */
+	Context &getContext(tal_id_t src_tal_id, tal_id_t dst_tal_id,
+	                    const RohcHeaders &headers, RohcProfile profile,
+	                    uint8_t &cid);
+
+	std::vector<int32_t> channels;
+	std::vector<Context> contexts;
+	uint64_t clock;
+	RohcStats stats;
+};
+
+
+/**
+ * @class RohcDecompressor
+ * @brief Restore the headers compressed by a RohcCompressor
+ */
+class RohcDecompressor
+{
+public:
+	RohcDecompressor();
+
+	/**
+	 * @brief Decompress a packet
+	 *
+	 * @param packet      The Ethernet header, the ROHC header and the payload
+	 * @param eth_length  The length of the Ethernet header
+	 * @param src_tal_id  The source terminal of the packet
+	 * @param dst_tal_id  The destination terminal of the packet
+	 * @param frame       OUT: The Ethernet frame
+	 * @return true on success, false if the packet cannot be decompressed
+	 */
+	bool decompress(const Data &packet, std::size_t eth_length,
+	                tal_id_t src_tal_id, tal_id_t dst_tal_id, Data &frame);
+
+	const RohcStats &getStats() const { return this->stats; };
+
+private:
+	struct Context
+	{
+		bool valid;
+		RohcProfile profile;
+		/// The headers of the last packet decompressed
+		RohcHeaders headers;
+		uint16_t sn;
+		uint16_t ip_id_offset;
+		bool random_ip_id;
+		uint32_t ts_stride;
+		uint32_t ts_offset;
+		uint32_t ts_scaled;
+		/// The successive packets that failed the CRC
+		unsigned int failures;
+	};
+
+	/**
+	 * @brief Get the context of a CID of the terminals
+	 */
+	Context &getContext(tal_id_t src_tal_id, tal_id_t dst_tal_id, uint8_t cid);
+
+	std::vector<int32_t> channels;
+	std::vector<Context> contexts;
+	RohcStats stats;
+};
+
+#endif
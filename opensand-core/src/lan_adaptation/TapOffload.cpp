@@ -0,0 +1,223 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file TapOffload.cpp
+ * @brief The segmentation and checksum offloads of the TAP interface
+ * @author Viveris Technologies
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <arpa/inet.h>
+#include <sys/ioctl.h>
+#include <linux/if_tun.h>
+
+#include "TapOffload.h"
+
+
+#define ETHERTYPE_OFFSET 12
+#define ETHERTYPE_IPV4 0x0800
+#define ETHERTYPE_IPV6 0x86DD
+#define ETHERTYPE_8021Q 0x8100
+#define ETHERTYPE_8021AD 0x88A8
+#define IPV6_HEADER_LEN 40
+#define TCP_FLAG_FIN 0x01
+#define TCP_FLAG_PSH 0x08
+#define TCP_FLAG_CWR 0x80
+
+
+bool TapOffload::enable(int fd)
+{
+	unsigned int offloads = TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6 | TUN_F_TSO_ECN;
+	return ioctl(fd, TUNSETOFFLOAD, offloads) == 0;
+}
+
+
+bool TapOffload::isOffloaded(const vnet_header_t &header)
+{
+	return (header.flags & VNET_HDR_F_NEEDS_CSUM) ||
+	       header.gso_type != VNET_HDR_GSO_NONE;
+}
+
+
+uint32_t TapOffload::sum(uint32_t sum, const unsigned char *data, std::size_t length)
+{
+	std::size_t index = 0;
+	for(; index + 1 < length; index += 2)
+	{
+		sum += (data[index] << 8) | data[index + 1];
+	}
+	if(index < length)
+	{
+		sum += data[index] << 8;
+	}
+	return sum;
+}
+
+
+uint16_t TapOffload::fold(uint32_t sum)
+{
+	while(sum >> 16)
+	{
+		sum = (sum & 0xFFFF) + (sum >> 16);
+	}
+	uint16_t checksum = ~sum & 0xFFFF;
+	// a null checksum means no checksum for UDP
+	return htons(checksum == 0 ? 0xFFFF : checksum);
+}
+
+
+bool TapOffload::split(const vnet_header_t &header,
+                       const unsigned char *frame,
+                       std::size_t length,
+                       std::vector<Data> &segments)
+{
+	std::size_t csum_start = header.csum_start;
+	std::size_t csum_offset = header.csum_offset;
+	uint8_t gso_type = header.gso_type & ~VNET_HDR_GSO_ECN;
+
+	if(!(header.flags & VNET_HDR_F_NEEDS_CSUM) ||
+	   csum_start + csum_offset + 2 > length)
+	{
+		// the segmentation relies on the transport header location
+		return false;
+	}
+
+	if(gso_type == VNET_HDR_GSO_NONE)
+	{
+		// the checksum field holds the pseudo-header sum,
+		// add the transport header and payload
+		Data segment{frame, length};
+		uint16_t checksum = fold(sum(0, &segment[csum_start], length - csum_start));
+		memcpy(&segment[csum_start + csum_offset], &checksum, sizeof(checksum));
+		segments.push_back(std::move(segment));
+		return true;
+	}
+
+	if(gso_type != VNET_HDR_GSO_TCPV4 && gso_type != VNET_HDR_GSO_TCPV6)
+	{
+		// UDP fragmentation offload is not enabled
+		return false;
+	}
+
+	// find the network header after the VLAN tags
+	std::size_t l3_offset = ETHERTYPE_OFFSET;
+	uint16_t ethertype = (frame[l3_offset] << 8) | frame[l3_offset + 1];
+	while((ethertype == ETHERTYPE_8021Q || ethertype == ETHERTYPE_8021AD) &&
+	      l3_offset + 6 <= csum_start)
+	{
+		l3_offset += 4;
+		ethertype = (frame[l3_offset] << 8) | frame[l3_offset + 1];
+	}
+	l3_offset += 2;
+	bool ipv4 = (gso_type == VNET_HDR_GSO_TCPV4);
+	if(ethertype != (ipv4 ? ETHERTYPE_IPV4 : ETHERTYPE_IPV6))
+	{
+		return false;
+	}
+
+	std::size_t l4_offset = csum_start;
+	std::size_t headers_length = l4_offset + 4 * (frame[l4_offset + 12] >> 4);
+	std::size_t mss = header.gso_size;
+	if(mss == 0 || headers_length > length ||
+	   l4_offset < l3_offset + (ipv4 ? 20 : IPV6_HEADER_LEN))
+	{
+		return false;
+	}
+
+	std::size_t payload_length = length - headers_length;
+	uint32_t sequence;
+	memcpy(&sequence, frame + l4_offset + 4, sizeof(sequence));
+	sequence = ntohl(sequence);
+	uint16_t ip_id;
+	memcpy(&ip_id, frame + l3_offset + 4, sizeof(ip_id));
+	ip_id = ntohs(ip_id);
+
+	// a segment without payload is kept whole, its headers and
+	// checksums are completed as those of the first segment
+	for(std::size_t offset = 0; offset == 0 || offset < payload_length; offset += mss)
+	{
+		std::size_t chunk = std::min(mss, payload_length - offset);
+		std::size_t segment_length = headers_length + chunk;
+		bool first = (offset == 0);
+		bool last = (offset + chunk == payload_length);
+
+		Data segment;
+		segment.reserve(segment_length);
+		segment.append(frame, headers_length);
+		segment.append(frame + headers_length + offset, chunk);
+		unsigned char *ip = &segment[l3_offset];
+		unsigned char *tcp = &segment[l4_offset];
+
+		// network header
+		uint32_t pseudo = 0;
+		std::size_t tcp_length = segment_length - l4_offset;
+		if(ipv4)
+		{
+			std::size_t ip_header_length = 4 * (ip[0] & 0x0F);
+			uint16_t total_length = htons(segment_length - l3_offset);
+			uint16_t id = htons(ip_id + offset / mss);
+			memcpy(ip + 2, &total_length, sizeof(total_length));
+			memcpy(ip + 4, &id, sizeof(id));
+			memset(ip + 10, 0, 2);
+			uint16_t ip_checksum = fold(sum(0, ip, ip_header_length));
+			memcpy(ip + 10, &ip_checksum, sizeof(ip_checksum));
+
+			pseudo = sum(pseudo, ip + 12, 8);
+		}
+		else
+		{
+			uint16_t ip_payload_length = htons(segment_length - l3_offset - IPV6_HEADER_LEN);
+			memcpy(ip + 4, &ip_payload_length, sizeof(ip_payload_length));
+
+			pseudo = sum(pseudo, ip + 8, 32);
+		}
+		pseudo += IPPROTO_TCP + tcp_length;
+
+		// transport header
+		uint32_t segment_sequence = htonl(sequence + offset);
+		memcpy(tcp + 4, &segment_sequence, sizeof(segment_sequence));
+		if(!last)
+		{
+			tcp[13] &= ~(TCP_FLAG_FIN | TCP_FLAG_PSH);
+		}
+		if(!first)
+		{
+			tcp[13] &= ~TCP_FLAG_CWR;
+		}
+		memset(tcp + 16, 0, 2);
+		uint16_t tcp_checksum = fold(sum(pseudo, tcp, tcp_length));
+		memcpy(tcp + 16, &tcp_checksum, sizeof(tcp_checksum));
+
+		segments.push_back(std::move(segment));
+	}
+
+	return true;
+}
@@ -0,0 +1,141 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file TapOffload.h
+ * @brief The segmentation and checksum offloads of the TAP interface
+ * @author Viveris Technologies
+ */
+
+#ifndef TAP_OFFLOAD_H
+#define TAP_OFFLOAD_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Data.h"
+
+
+/**
+ * @brief The virtio-net header preceding the frames on a TAP interface
+ *        opened with IFF_VNET_HDR, in host byte order
+ *        (linux/virtio_net.h cannot be included in C++)
+ */
+struct vnet_header_t
+{
+	uint8_t flags;
+	uint8_t gso_type;
+	uint16_t hdr_len;
+	uint16_t gso_size;
+	uint16_t csum_start;
+	uint16_t csum_offset;
+} __attribute__((__packed__));
+
+/// The checksum starting at csum_start must be completed
+#define VNET_HDR_F_NEEDS_CSUM 1
+
+/// The segmentation offload types
+#define VNET_HDR_GSO_NONE 0
+#define VNET_HDR_GSO_TCPV4 1
+#define VNET_HDR_GSO_UDP 3
+#define VNET_HDR_GSO_TCPV6 4
+#define VNET_HDR_GSO_ECN 0x80
+
+
+/**
+ * @class TapOffload
+ * @brief Handle the frames read on a TAP interface with a virtio-net header
+ *
+ * With offloads enabled, the kernel hands TCP segments up to 64 KB and
+ * leaves the transport checksums to complete, the segments are split
+ * here in frames of the negotiated MSS as the network card would.
+ */
+class TapOffload
+{
+public:
+	/// The length of the header preceding each frame
+	static constexpr std::size_t header_length = sizeof(vnet_header_t);
+
+	/// The maximum length of a frame read on the interface:
+	/// a 64 KB IP packet and its link layer headers
+	static constexpr std::size_t max_frame_length = 65536 + 64;
+
+	/**
+	 * @brief Ask the kernel to send checksum-less and large TCP segments
+	 *        on a TAP interface opened with a virtio-net header
+	 *
+	 * @param fd  The TAP file descriptor
+	 * @return true on success, false otherwise
+	 */
+	static bool enable(int fd);
+
+	/**
+	 * @brief Check whether a frame needs to be completed or split
+	 *
+	 * @param header  The virtio-net header of the frame
+	 * @return true if the frame must be handled by split, false if
+	 *         it can be used as is
+	 */
+	static bool isOffloaded(const vnet_header_t &header);
+
+	/**
+	 * @brief Complete the checksums of a frame and split it in
+	 *        segments of the MSS if it is a large TCP segment
+	 *
+	 * @param header    The virtio-net header of the frame
+	 * @param frame     The Ethernet frame
+	 * @param length    The frame length
+	 * @param segments  OUT: the frames to send on the network
+	 * @return true on success, false if the frame cannot be handled
+	 */
+	static bool split(const vnet_header_t &header,
+	                  const unsigned char *frame,
+	                  std::size_t length,
+	                  std::vector<Data> &segments);
+
+	/**
+	 * @brief Add bytes to a one's complement sum
+	 *
+	 * @param sum     The current sum
+	 * @param data    The bytes to add
+	 * @param length  The number of bytes
+	 * @return the new sum, not folded
+	 */
+	static uint32_t sum(uint32_t sum, const unsigned char *data, std::size_t length);
+
+	/**
+	 * @brief Fold a one's complement sum in its 16-bit complement
+	 *
+	 * @param sum  The sum to fold
+	 * @return the checksum in network byte order
+	 */
+	static uint16_t fold(uint32_t sum);
+};
+
+#endif
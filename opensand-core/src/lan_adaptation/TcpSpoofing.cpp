@@ -0,0 +1,720 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file TcpSpoofing.cpp
+ * @brief A TCP performance enhancing proxy spoofing the acknowledgements
+ *        of the LAN endpoints
+ * @author Viveris Technologies
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include "TcpSpoofing.h"
+#include "EthernetFrameView.h"
+#include "TapOffload.h"
+
+
+#define IPV4_HEADER_LEN 20
+#define TCP_HEADER_LEN 20
+#define TCP_TIMESTAMP_LEN 12
+#define TCP_FLAG_FIN 0x01
+#define TCP_FLAG_SYN 0x02
+#define TCP_FLAG_RST 0x04
+#define TCP_FLAG_ACK 0x10
+#define TCP_OPTION_END 0
+#define TCP_OPTION_NOP 1
+#define TCP_OPTION_WSCALE 3
+#define TCP_OPTION_TIMESTAMP 8
+
+/// The duplicate acknowledgements triggering a retransmission
+#define DUPACK_THRESHOLD 3
+/// The retransmission timeouts, in ms
+#define INITIAL_RTO 1000
+#define MIN_RTO 200
+#define MAX_RTO 60000
+/// The connections without traffic are forgotten after this delay, in ms
+#define IDLE_TIMEOUT 300000
+
+
+/// Compare sequence numbers modulo 2^32
+static inline bool seqBefore(uint32_t first, uint32_t second)
+{
+	return static_cast<int32_t>(first - second) < 0;
+}
+
+static inline uint16_t read16(const unsigned char *data)
+{
+	return (data[0] << 8) | data[1];
+}
+
+static inline uint32_t read32(const unsigned char *data)
+{
+	return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) |
+	       (data[2] << 8) | data[3];
+}
+
+static inline void write16(unsigned char *data, uint16_t value)
+{
+	data[0] = value >> 8;
+	data[1] = value & 0xFF;
+}
+
+static inline void write32(unsigned char *data, uint32_t value)
+{
+	write16(data, value >> 16);
+	write16(data + 2, value & 0xFFFF);
+}
+
+
+TcpSpoofing::TcpSpoofing(std::size_t max_connections, std::size_t buffer_size):
+	buffer_size{buffer_size},
+	connections(std::max<std::size_t>(max_connections, 1)),
+	buckets{},
+	free_list{0},
+	stats{},
+	mutex{"lan.tcp_spoofing"}
+{
+	std::size_t size = 1;
+	while(size < 2 * this->connections.size())
+	{
+		size <<= 1;
+	}
+	this->buckets.assign(size, -1);
+	for(std::size_t index = 0; index < this->connections.size(); ++index)
+	{
+		this->connections[index].used = false;
+		this->connections[index].next = index + 1 < this->connections.size() ? index + 1 : -1;
+	}
+}
+
+
+void TcpSpoofing::fromLan(std::unique_ptr<NetPacket> &packet, time_ms_t now,
+                          std::vector<Data> &acks)
+{
+	Segment segment;
+	if(!parse(packet->getData(), segment))
+	{
+		return;
+	}
+
+	RtLock lock{this->mutex};
+	int32_t index = this->find(segment.src_addr, segment.src_port,
+	                           segment.dst_addr, segment.dst_port);
+	if(segment.flags & TCP_FLAG_SYN && !(segment.flags & TCP_FLAG_ACK))
+	{
+		// a new connection opened by the LAN, forget a previous one
+		if(index >= 0)
+		{
+			this->release(index);
+		}
+		index = this->allocate(segment.src_addr, segment.src_port,
+		                       segment.dst_addr, segment.dst_port);
+		if(index < 0)
+		{
+			++this->stats.untracked;
+			return;
+		}
+	}
+	if(index < 0)
+	{
+		return;
+	}
+
+	Connection &connection = this->connections[index];
+	connection.last_activity = now;
+	if(segment.flags & TCP_FLAG_RST)
+	{
+		this->release(index);
+		return;
+	}
+	if(segment.flags & TCP_FLAG_SYN)
+	{
+		if(!connection.lan_syn)
+		{
+			const Data &frame = packet->getData();
+			connection.lan_syn = true;
+			connection.lan_wscale = segment.wscale;
+			connection.lan_ts = segment.has_ts;
+			connection.lan_tsval = segment.tsval;
+			connection.lan_isn = segment.seq;
+			connection.lan_next = segment.seq + 1;
+			connection.snd_una = connection.lan_next;
+			connection.snd_nxt = connection.lan_next;
+			// the acknowledgements come from the remote endpoint
+			connection.header_length = segment.eth_length;
+			memcpy(connection.header, frame.data() + 6, 6);
+			memcpy(connection.header + 6, frame.data(), 6);
+			memcpy(connection.header + 12, frame.data() + 12, segment.eth_length - 12);
+		}
+		return;
+	}
+
+	bool fin = segment.flags & TCP_FLAG_FIN;
+	if(!connection.lan_syn || !connection.remote_syn ||
+	   (segment.length == 0 && !fin))
+	{
+		// handshake or acknowledgement of the remote data
+		return;
+	}
+	if(segment.has_ts)
+	{
+		connection.lan_tsval = segment.tsval;
+	}
+
+	uint32_t end = segment.seq + segment.length + (fin ? 1 : 0);
+	if(segment.seq != connection.lan_next ||
+	   connection.lan_fin ||
+	   connection.buffered + segment.length > this->buffer_size)
+	{
+		// a duplicate, an out of order segment or a full buffer: the
+		// acknowledgement tells the LAN endpoint what it should send
+		if(seqBefore(connection.lan_next, end))
+		{
+			++this->stats.drops;
+		}
+		this->acknowledgeLan(connection, acks);
+		packet.reset();
+		return;
+	}
+
+	Buffered buffered;
+	buffered.seq = segment.seq;
+	buffered.end = end;
+	buffered.sent = false;
+	buffered.sent_time = 0;
+	buffered.retransmitted = false;
+	connection.lan_next = end;
+	connection.lan_fin = fin;
+	connection.buffered += segment.length;
+	this->stats.buffered_bytes += segment.length;
+	if(connection.snd_nxt == segment.seq &&
+	   end - connection.snd_una <= connection.remote_window)
+	{
+		// send it right now and keep a copy for the retransmissions
+		buffered.sent = true;
+		buffered.sent_time = now;
+		buffered.frame.reset(new NetPacket(*packet));
+		if(connection.snd_una == connection.snd_nxt)
+		{
+			connection.last_progress = now;
+		}
+		connection.snd_nxt = end;
+	}
+	else
+	{
+		buffered.frame = std::move(packet);
+	}
+	connection.segments.push_back(std::move(buffered));
+	this->acknowledgeLan(connection, acks);
+}
+
+
+bool TcpSpoofing::fromSatellite(const Data &frame, time_ms_t now,
+                                std::vector<std::unique_ptr<NetPacket>> &segments)
+{
+	Segment segment;
+	if(!parse(frame, segment))
+	{
+		return true;
+	}
+
+	RtLock lock{this->mutex};
+	int32_t index = this->find(segment.dst_addr, segment.dst_port,
+	                           segment.src_addr, segment.src_port);
+	if(segment.flags & TCP_FLAG_SYN && !(segment.flags & TCP_FLAG_ACK))
+	{
+		// a new connection opened towards the LAN
+		if(index >= 0)
+		{
+			this->release(index);
+		}
+		index = this->allocate(segment.dst_addr, segment.dst_port,
+		                       segment.src_addr, segment.src_port);
+		if(index < 0)
+		{
+			++this->stats.untracked;
+			return true;
+		}
+	}
+	if(index < 0)
+	{
+		return true;
+	}
+
+	Connection &connection = this->connections[index];
+	connection.last_activity = now;
+	if(segment.flags & TCP_FLAG_RST)
+	{
+		this->release(index);
+		return true;
+	}
+	if(segment.has_ts)
+	{
+		connection.remote_tsval = segment.tsval;
+	}
+	if(segment.flags & TCP_FLAG_SYN)
+	{
+		if(!connection.remote_syn)
+		{
+			connection.remote_syn = true;
+			connection.remote_wscale = segment.wscale;
+			connection.remote_ts = segment.has_ts;
+			connection.remote_next = segment.seq + 1;
+			// the window of a SYN is never scaled
+			connection.remote_window = segment.window;
+		}
+		return true;
+	}
+	if(!connection.lan_syn || !connection.remote_syn)
+	{
+		return true;
+	}
+
+	bool fin = segment.flags & TCP_FLAG_FIN;
+	uint32_t end = segment.seq + segment.length + (fin ? 1 : 0);
+	if(seqBefore(connection.remote_next, end))
+	{
+		connection.remote_next = end;
+	}
+	connection.remote_fin |= fin;
+
+	if(segment.flags & TCP_FLAG_ACK)
+	{
+		uint32_t window = segment.window;
+		if(connection.lan_wscale >= 0 && connection.remote_wscale >= 0)
+		{
+			window <<= connection.remote_wscale;
+		}
+		connection.remote_window = window;
+
+		if(seqBefore(connection.snd_una, segment.ack) &&
+		   !seqBefore(connection.snd_nxt, segment.ack))
+		{
+			// release the acknowledged segments
+			bool sample = false;
+			while(!connection.segments.empty() &&
+			      !seqBefore(segment.ack, connection.segments.front().end))
+			{
+				Buffered &buffered = connection.segments.front();
+				if(!sample && !buffered.retransmitted)
+				{
+					time_ms_t rtt = now - buffered.sent_time;
+					connection.srtt = connection.srtt == 0 ? rtt : (7 * connection.srtt + rtt) / 8;
+					connection.rto = std::min<time_ms_t>(std::max<time_ms_t>(2 * connection.srtt, MIN_RTO), MAX_RTO);
+					sample = true;
+				}
+				std::size_t length = buffered.end - buffered.seq;
+				if(connection.lan_fin && buffered.end == connection.lan_next)
+				{
+					--length;
+				}
+				connection.buffered -= length;
+				this->stats.buffered_bytes -= length;
+				connection.segments.pop_front();
+			}
+			connection.snd_una = segment.ack;
+			connection.dupacks = 0;
+			connection.last_progress = now;
+		}
+		else if(segment.ack == connection.snd_una &&
+		        connection.snd_una != connection.snd_nxt &&
+		        segment.length == 0 && !fin)
+		{
+			++connection.dupacks;
+			if(connection.dupacks == DUPACK_THRESHOLD)
+			{
+				this->retransmit(connection, now, segments);
+			}
+		}
+		this->sendPending(connection, now, segments);
+	}
+
+	if(connection.lan_fin && connection.remote_fin &&
+	   connection.snd_una == connection.lan_next)
+	{
+		// both sides are closed and all the data was delivered
+		bool deliver = segment.length > 0 || fin;
+		this->release(index);
+		return deliver;
+	}
+
+	// the pure acknowledgements of spoofed data are already handled,
+	// the one completing the handshake is still needed
+	return segment.length > 0 || fin || !(segment.flags & TCP_FLAG_ACK) ||
+	       !seqBefore(connection.lan_isn + 1, segment.ack) ||
+	       seqBefore(connection.lan_next, segment.ack);
+}
+
+
+void TcpSpoofing::poll(time_ms_t now, std::vector<std::unique_ptr<NetPacket>> &segments)
+{
+	RtLock lock{this->mutex};
+	for(std::size_t index = 0; index < this->connections.size(); ++index)
+	{
+		Connection &connection = this->connections[index];
+		if(!connection.used)
+		{
+			continue;
+		}
+		if(now - connection.last_activity > IDLE_TIMEOUT)
+		{
+			this->release(index);
+			continue;
+		}
+		if(connection.snd_una != connection.snd_nxt &&
+		   now - connection.last_progress >= connection.rto)
+		{
+			connection.rto = std::min<time_ms_t>(2 * connection.rto, MAX_RTO);
+			connection.dupacks = 0;
+			this->retransmit(connection, now, segments);
+		}
+		else if(connection.snd_una == connection.snd_nxt &&
+		        connection.snd_nxt != connection.lan_next &&
+		        now - connection.last_progress >= connection.rto)
+		{
+			// the window stays closed, an update may have been lost
+			connection.rto = std::min<time_ms_t>(2 * connection.rto, MAX_RTO);
+			this->probe(connection, now, segments);
+		}
+	}
+}
+
+
+TcpSpoofingStats TcpSpoofing::getStats()
+{
+	RtLock lock{this->mutex};
+	return this->stats;
+}
+
+
+bool TcpSpoofing::parse(const Data &frame, Segment &segment)
+{
+	EthernetFrameView view{frame};
+	if(!view.isValid() || view.getPayloadEtherType() != NET_PROTO::IPV4)
+	{
+		return false;
+	}
+	std::size_t ip_offset = view.getHeaderLength();
+	if(frame.length() < ip_offset + IPV4_HEADER_LEN)
+	{
+		return false;
+	}
+	const unsigned char *ip = frame.data() + ip_offset;
+	std::size_t ip_header_length = 4 * (ip[0] & 0x0F);
+	std::size_t total_length = read16(ip + 2);
+	// only the unfragmented TCP packets
+	if((ip[0] >> 4) != 4 || ip[9] != IPPROTO_TCP ||
+	   (read16(ip + 6) & 0x3FFF) != 0 ||
+	   ip_header_length < IPV4_HEADER_LEN ||
+	   total_length < ip_header_length + TCP_HEADER_LEN ||
+	   frame.length() < ip_offset + total_length)
+	{
+		return false;
+	}
+	const unsigned char *tcp = ip + ip_header_length;
+	std::size_t tcp_header_length = 4 * (tcp[12] >> 4);
+	if(tcp_header_length < TCP_HEADER_LEN ||
+	   total_length < ip_header_length + tcp_header_length)
+	{
+		return false;
+	}
+
+	segment.src_addr = read32(ip + 12);
+	segment.dst_addr = read32(ip + 16);
+	segment.src_port = read16(tcp);
+	segment.dst_port = read16(tcp + 2);
+	segment.seq = read32(tcp + 4);
+	segment.ack = read32(tcp + 8);
+	segment.flags = tcp[13];
+	segment.window = read16(tcp + 14);
+	segment.length = total_length - ip_header_length - tcp_header_length;
+	segment.wscale = -1;
+	segment.has_ts = false;
+	segment.tsval = 0;
+	segment.eth_length = ip_offset;
+
+	std::size_t offset = TCP_HEADER_LEN;
+	while(offset < tcp_header_length)
+	{
+		uint8_t kind = tcp[offset];
+		if(kind == TCP_OPTION_END)
+		{
+			break;
+		}
+		if(kind == TCP_OPTION_NOP)
+		{
+			++offset;
+			continue;
+		}
+		if(offset + 1 >= tcp_header_length)
+		{
+			break;
+		}
+		uint8_t length = tcp[offset + 1];
+		if(length < 2 || offset + length > tcp_header_length)
+		{
+			break;
+		}
+		if(kind == TCP_OPTION_WSCALE && length == 3)
+		{
+			segment.wscale = std::min(tcp[offset + 2], uint8_t(14));
+		}
+		else if(kind == TCP_OPTION_TIMESTAMP && length == 10)
+		{
+			segment.has_ts = true;
+			segment.tsval = read32(tcp + offset + 2);
+		}
+		offset += length;
+	}
+	return true;
+}
+
+
+std::size_t TcpSpoofing::bucket(uint32_t lan_addr, uint16_t lan_port,
+                                uint32_t remote_addr, uint16_t remote_port) const
+{
+	uint32_t hash = lan_addr * 31 + remote_addr;
+	hash = hash * 31 + ((lan_port << 16) | remote_port);
+	hash *= 0x9E3779B1;
+	return (hash ^ (hash >> 16)) & (this->buckets.size() - 1);
+}
+
+
+int32_t TcpSpoofing::find(uint32_t lan_addr, uint16_t lan_port,
+                          uint32_t remote_addr, uint16_t remote_port) const
+{
+	int32_t index = this->buckets[this->bucket(lan_addr, lan_port, remote_addr, remote_port)];
+	while(index >= 0)
+	{
+		const Connection &connection = this->connections[index];
+		if(connection.lan_addr == lan_addr && connection.lan_port == lan_port &&
+		   connection.remote_addr == remote_addr && connection.remote_port == remote_port)
+		{
+			return index;
+		}
+		index = connection.next;
+	}
+	return -1;
+}
+
+
+int32_t TcpSpoofing::allocate(uint32_t lan_addr, uint16_t lan_port,
+                              uint32_t remote_addr, uint16_t remote_port)
+{
+	int32_t index = this->free_list;
+	if(index < 0)
+	{
+		return -1;
+	}
+	Connection &connection = this->connections[index];
+	this->free_list = connection.next;
+
+	std::size_t key = this->bucket(lan_addr, lan_port, remote_addr, remote_port);
+	connection.used = true;
+	connection.next = this->buckets[key];
+	this->buckets[key] = index;
+	connection.lan_addr = lan_addr;
+	connection.remote_addr = remote_addr;
+	connection.lan_port = lan_port;
+	connection.remote_port = remote_port;
+	connection.lan_syn = false;
+	connection.remote_syn = false;
+	connection.lan_fin = false;
+	connection.remote_fin = false;
+	connection.lan_wscale = -1;
+	connection.remote_wscale = -1;
+	connection.lan_ts = false;
+	connection.remote_ts = false;
+	connection.lan_isn = 0;
+	connection.lan_next = 0;
+	connection.snd_una = 0;
+	connection.snd_nxt = 0;
+	connection.remote_next = 0;
+	connection.remote_window = 0;
+	connection.lan_tsval = 0;
+	connection.remote_tsval = 0;
+	connection.dupacks = 0;
+	connection.srtt = 0;
+	connection.rto = INITIAL_RTO;
+	connection.last_progress = 0;
+	connection.last_activity = 0;
+	connection.buffered = 0;
+	connection.segments.clear();
+	connection.header_length = 0;
+	++this->stats.connections;
+	return index;
+}
+
+
+void TcpSpoofing::release(int32_t index)
+{
+	Connection &connection = this->connections[index];
+	std::size_t key = this->bucket(connection.lan_addr, connection.lan_port,
+	                               connection.remote_addr, connection.remote_port);
+	int32_t *link = &this->buckets[key];
+	while(*link != index)
+	{
+		link = &this->connections[*link].next;
+	}
+	*link = connection.next;
+
+	this->stats.buffered_bytes -= connection.buffered;
+	--this->stats.connections;
+	connection.used = false;
+	connection.segments.clear();
+	connection.next = this->free_list;
+	this->free_list = index;
+}
+
+
+void TcpSpoofing::acknowledgeLan(Connection &connection, std::vector<Data> &acks)
+{
+	bool timestamps = connection.lan_ts && connection.remote_ts;
+	std::size_t tcp_length = TCP_HEADER_LEN + (timestamps ? TCP_TIMESTAMP_LEN : 0);
+	std::size_t ip_length = IPV4_HEADER_LEN + tcp_length;
+
+	Data ack;
+	ack.reserve(connection.header_length + ip_length);
+	ack.append(connection.header, connection.header_length);
+	ack.append(ip_length, 0);
+	unsigned char *ip = &ack[connection.header_length];
+	unsigned char *tcp = ip + IPV4_HEADER_LEN;
+
+	ip[0] = 0x45;
+	write16(ip + 2, ip_length);
+	// don't fragment
+	ip[6] = 0x40;
+	ip[8] = 64;
+	ip[9] = IPPROTO_TCP;
+	write32(ip + 12, connection.remote_addr);
+	write32(ip + 16, connection.lan_addr);
+	uint16_t ip_checksum = TapOffload::fold(TapOffload::sum(0, ip, IPV4_HEADER_LEN));
+	memcpy(ip + 10, &ip_checksum, sizeof(ip_checksum));
+
+	// the window is the free space of the buffer, scaled as the
+	// remote endpoint would do
+	std::size_t window = this->buffer_size - std::min(connection.buffered, this->buffer_size);
+	if(connection.lan_wscale >= 0 && connection.remote_wscale >= 0)
+	{
+		window >>= connection.remote_wscale;
+	}
+	write16(tcp, connection.remote_port);
+	write16(tcp + 2, connection.lan_port);
+	write32(tcp + 4, connection.remote_next);
+	write32(tcp + 8, connection.lan_next);
+	tcp[12] = (tcp_length / 4) << 4;
+	tcp[13] = TCP_FLAG_ACK;
+	write16(tcp + 14, std::min<std::size_t>(window, 0xFFFF));
+	if(timestamps)
+	{
+		tcp[20] = TCP_OPTION_NOP;
+		tcp[21] = TCP_OPTION_NOP;
+		tcp[22] = TCP_OPTION_TIMESTAMP;
+		tcp[23] = 10;
+		write32(tcp + 24, connection.remote_tsval);
+		write32(tcp + 28, connection.lan_tsval);
+	}
+	uint32_t pseudo = TapOffload::sum(0, ip + 12, 8);
+	pseudo += IPPROTO_TCP + tcp_length;
+	uint16_t tcp_checksum = TapOffload::fold(TapOffload::sum(pseudo, tcp, tcp_length));
+	memcpy(tcp + 16, &tcp_checksum, sizeof(tcp_checksum));
+
+	++this->stats.spoofed_acks;
+	acks.push_back(std::move(ack));
+}
+
+
+void TcpSpoofing::sendPending(Connection &connection, time_ms_t now,
+                              std::vector<std::unique_ptr<NetPacket>> &segments)
+{
+	for(auto &&buffered : connection.segments)
+	{
+		if(buffered.sent || seqBefore(buffered.seq, connection.snd_nxt))
+		{
+			continue;
+		}
+		if(buffered.end - connection.snd_una > connection.remote_window)
+		{
+			break;
+		}
+		if(connection.snd_una == connection.snd_nxt)
+		{
+			connection.last_progress = now;
+		}
+		buffered.sent = true;
+		buffered.sent_time = now;
+		segments.emplace_back(new NetPacket(*buffered.frame));
+		connection.snd_nxt = buffered.end;
+	}
+}
+
+
+void TcpSpoofing::retransmit(Connection &connection, time_ms_t now,
+                             std::vector<std::unique_ptr<NetPacket>> &segments)
+{
+	for(auto &&buffered : connection.segments)
+	{
+		if(!buffered.sent)
+		{
+			break;
+		}
+		if(seqBefore(connection.snd_una, buffered.end))
+		{
+			buffered.sent_time = now;
+			buffered.retransmitted = true;
+			segments.emplace_back(new NetPacket(*buffered.frame));
+			++this->stats.retransmissions;
+			break;
+		}
+	}
+	connection.last_progress = now;
+}
+
+
+void TcpSpoofing::probe(Connection &connection, time_ms_t now,
+                        std::vector<std::unique_ptr<NetPacket>> &segments)
+{
+	for(auto &&buffered : connection.segments)
+	{
+		if(!buffered.sent)
+		{
+			// the remote endpoint answers with its current window
+			buffered.sent = true;
+			buffered.sent_time = now;
+			buffered.retransmitted = true;
+			segments.emplace_back(new NetPacket(*buffered.frame));
+			connection.snd_nxt = buffered.end;
+			break;
+		}
+	}
+	connection.last_progress = now;
+}
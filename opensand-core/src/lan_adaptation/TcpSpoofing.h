@@ -0,0 +1,243 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file TcpSpoofing.h
+ * @brief A TCP performance enhancing proxy spoofing the acknowledgements
+ *        of the LAN endpoints
+ * @author Viveris Technologies
+ *
+ * The proxy acknowledges the in-order data of the TCP connections opened
+ * by or towards the LAN on behalf of the remote endpoint, so that the LAN
+ * endpoints are not slowed down by the satellite delay. The acknowledged
+ * data is kept until the remote endpoint acknowledges it and is sent on
+ * satellite as long as it fits in the remote window, the proxy of the
+ * remote entity advertises its own buffer as window. The lost segments
+ * are retransmitted by the proxy after three duplicate acknowledgements
+ * or a timeout.
+ *
+ * Only the IPv4 connections whose handshake was seen are handled, the
+ * other frames are left untouched.
+ */
+
+#ifndef TCP_SPOOFING_H
+#define TCP_SPOOFING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "Data.h"
+#include "NetPacket.h"
+#include "OpenSandCore.h"
+
+#include <opensand_rt/RtMutex.h>
+
+
+/// The statistics of the proxy
+struct TcpSpoofingStats
+{
+	/// The connections currently handled
+	std::size_t connections;
+	/// The bytes acknowledged to the LAN and not yet by the remote endpoint
+	std::size_t buffered_bytes;
+	/// The acknowledgements sent to the LAN
+	uint64_t spoofed_acks;
+	/// The segments retransmitted on satellite
+	uint64_t retransmissions;
+	/// The LAN segments dropped because they were out of order or
+	/// did not fit in the buffer
+	uint64_t drops;
+	/// The connections left untouched because the table was full
+	uint64_t untracked;
+};
+
+
+/**
+ * @class TcpSpoofing
+ * @brief Spoof the acknowledgements of the TCP connections of the LAN
+ *
+ * The methods may be called from the upward and downward channels.
+ */
+class TcpSpoofing
+{
+public:
+	/**
+	 * @brief Create the proxy
+	 *
+	 * @param max_connections  The maximum number of connections handled
+	 * @param buffer_size      The bytes buffered at most per connection
+	 */
+	TcpSpoofing(std::size_t max_connections, std::size_t buffer_size);
+
+	/**
+	 * @brief Handle an Ethernet frame read on the LAN
+	 *
+	 * @param packet  The frame, released if the proxy keeps or drops it,
+	 *                otherwise it must be sent on satellite
+	 * @param now     The current time
+	 * @param acks    OUT: the acknowledgements to write on the LAN
+	 */
+	void fromLan(std::unique_ptr<NetPacket> &packet, time_ms_t now,
+	             std::vector<Data> &acks);
+
+	/**
+	 * @brief Handle an Ethernet frame received from satellite
+	 *
+	 * @param frame     The frame
+	 * @param now       The current time
+	 * @param segments  OUT: the buffered segments to send on satellite
+	 * @return true if the frame must be written on the LAN, false if it
+	 *         only acknowledges data already acknowledged to the LAN
+	 */
+	bool fromSatellite(const Data &frame, time_ms_t now,
+	                   std::vector<std::unique_ptr<NetPacket>> &segments);
+
+	/**
+	 * @brief Retransmit the segments whose acknowledgement timed out
+	 *        and forget the idle connections
+	 *
+	 * @param now       The current time
+	 * @param segments  OUT: the segments to send on satellite
+	 */
+	void poll(time_ms_t now, std::vector<std::unique_ptr<NetPacket>> &segments);
+
+	/**
+	 * @brief Get the statistics of the proxy
+	 *
+	 * @return the statistics
+	 */
+	TcpSpoofingStats getStats();
+
+private:
+	/// The fields of a TCP segment
+	struct Segment
+	{
+		uint32_t src_addr;
+		uint32_t dst_addr;
+		uint16_t src_port;
+		uint16_t dst_port;
+		uint32_t seq;
+		uint32_t ack;
+		uint8_t flags;
+		uint16_t window;
+		/// The payload length
+		uint32_t length;
+		/// The window scale option, -1 if absent
+		int wscale;
+		bool has_ts;
+		uint32_t tsval;
+		/// The length of the Ethernet header
+		std::size_t eth_length;
+	};
+
+	/// A segment acknowledged to the LAN
+	struct Buffered
+	{
+		uint32_t seq;
+		/// The sequence number following the segment, FIN included
+		uint32_t end;
+		bool sent;
+		/// The last transmission
+		time_ms_t sent_time;
+		bool retransmitted;
+		std::unique_ptr<NetPacket> frame;
+	};
+
+	struct Connection
+	{
+		bool used;
+		/// The next connection of the hash bucket or of the free list
+		int32_t next;
+		uint32_t lan_addr;
+		uint32_t remote_addr;
+		uint16_t lan_port;
+		uint16_t remote_port;
+		bool lan_syn;
+		bool remote_syn;
+		bool lan_fin;
+		bool remote_fin;
+		int lan_wscale;
+		int remote_wscale;
+		bool lan_ts;
+		bool remote_ts;
+		/// The initial sequence number of the LAN endpoint
+		uint32_t lan_isn;
+		/// The next sequence number expected from the LAN endpoint
+		uint32_t lan_next;
+		/// The oldest sequence number not acknowledged by the remote endpoint
+		uint32_t snd_una;
+		/// The next sequence number to send on satellite
+		uint32_t snd_nxt;
+		/// The next sequence number of the remote endpoint
+		uint32_t remote_next;
+		uint32_t remote_window;
+		uint32_t lan_tsval;
+		uint32_t remote_tsval;
+		unsigned int dupacks;
+		time_ms_t srtt;
+		time_ms_t rto;
+		/// The last acknowledgement progress or retransmission
+		time_ms_t last_progress;
+		time_ms_t last_activity;
+		std::size_t buffered;
+		std::deque<Buffered> segments;
+		/// The Ethernet header of the acknowledgements sent to the LAN
+		uint8_t header[ETHERNET_802_1AD_HEADSIZE];
+		uint8_t header_length;
+	};
+
+	static bool parse(const Data &frame, Segment &segment);
+
+	int32_t find(uint32_t lan_addr, uint16_t lan_port,
+	             uint32_t remote_addr, uint16_t remote_port) const;
+	int32_t allocate(uint32_t lan_addr, uint16_t lan_port,
+	                 uint32_t remote_addr, uint16_t remote_port);
+	void release(int32_t index);
+	std::size_t bucket(uint32_t lan_addr, uint16_t lan_port,
+	                   uint32_t remote_addr, uint16_t remote_port) const;
+
+	void acknowledgeLan(Connection &connection, std::vector<Data> &acks);
+	void sendPending(Connection &connection, time_ms_t now,
+	                 std::vector<std::unique_ptr<NetPacket>> &segments);
+	void retransmit(Connection &connection, time_ms_t now,
+	                std::vector<std::unique_ptr<NetPacket>> &segments);
+	void probe(Connection &connection, time_ms_t now,
+	           std::vector<std::unique_ptr<NetPacket>> &segments);
+
+	std::size_t buffer_size;
+	std::vector<Connection> connections;
+	std::vector<int32_t> buckets;
+	int32_t free_list;
+	TcpSpoofingStats stats;
+	RtMutex mutex;
+};
+
+#endif
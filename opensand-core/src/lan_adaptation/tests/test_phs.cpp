@@ -0,0 +1,246 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file test_phs.cpp
+ * @brief Check the restoration of the headers suppressed by PHS,
+ *        including the reuse of the rule indexes
+ * @author Viveris Technologies
+ */
+
+
+#include "PhsTable.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+
+#define HEADER_LEN 14
+/// The rules of a pair of terminals, the next header reuses an index
+#define CHANNEL_RULES 64
+
+#define CHECK(condition) do \
+{ \
+	if(!(condition)) \
+	{ \
+		fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+		return false; \
+	} \
+} while(0)
+
+
+/**
+ * @brief Build an Ethernet frame of a flow
+ *
+ * @param flow     The flow, it sets the source MAC address
+ * @param counter  The payload content
+ * @return the frame
+ */
+static Data buildFrame(unsigned int flow, unsigned int counter)
+{
+	Data frame;
+	const unsigned char dst[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+	const unsigned char src[6] = {0x02, 0x00, 0x00, 0x01,
+	                              (unsigned char)(flow >> 8), (unsigned char)flow};
+	frame.append(dst, sizeof(dst));
+	frame.append(src, sizeof(src));
+	frame.push_back(0x08);
+	frame.push_back(0x00);
+	for(unsigned int index = 0; index < 40; ++index)
+	{
+		frame.push_back(counter + index);
+	}
+	return frame;
+}
+
+static Data suppress(PhsSuppressor &suppressor, const Data &frame)
+{
+	Data packet;
+	suppressor.suppress(frame, HEADER_LEN, 1, 2, packet);
+	return packet;
+}
+
+static bool isRestored(PhsRestorer &restorer, const Data &packet, const Data &frame)
+{
+	Data restored;
+	return restorer.restore(packet, 1, 2, restored) && restored == frame;
+}
+
+/// The headers are defined, then suppressed and restored
+static bool checkRoundTrip()
+{
+	PhsSuppressor suppressor;
+	PhsRestorer restorer;
+
+	for(unsigned int counter = 0; counter < 10; ++counter)
+	{
+		Data frame = buildFrame(1, counter);
+		Data packet = suppress(suppressor, frame);
+		// the first packets define the rule
+		CHECK(packet.length() == frame.length() + (counter < 3 ? 3 : 2 - HEADER_LEN));
+		CHECK(isRestored(restorer, packet, frame));
+	}
+
+	// the frames without suppressed header are kept whole
+	Data frame = buildFrame(2, 0);
+	Data packet;
+	suppressor.suppress(frame, 0, 1, 2, packet);
+	CHECK(packet.length() == frame.length() + 1);
+	CHECK(isRestored(restorer, packet, frame));
+
+	// the terminals pairs have their own rules
+	Data restored;
+	CHECK(!restorer.restore(suppress(suppressor, buildFrame(1, 0)), 2, 1, restored));
+	CHECK(restorer.getStats().failures == 1);
+	return true;
+}
+
+/**
+ * @brief Fill the rules of a pair of terminals, the definitions are
+ *        received by the restorer
+ */
+static bool fillRules(PhsSuppressor &suppressor, PhsRestorer &restorer)
+{
+	for(unsigned int flow = 0; flow < CHANNEL_RULES; ++flow)
+	{
+		for(unsigned int counter = 0; counter < 4; ++counter)
+		{
+			Data frame = buildFrame(flow, counter);
+			CHECK(isRestored(restorer, suppress(suppressor, frame), frame));
+		}
+	}
+	return true;
+}
+
+/// The definitions of a reused index are lost
+static bool checkLostRedefinition()
+{
+	PhsSuppressor suppressor;
+	PhsRestorer restorer;
+	CHECK(fillRules(suppressor, restorer));
+
+	// the new flow takes the index of the least recently used one, flow 0
+	for(unsigned int counter = 0; counter < 3; ++counter)
+	{
+		suppress(suppressor, buildFrame(CHANNEL_RULES, counter));
+	}
+	Data frame = buildFrame(CHANNEL_RULES, 3);
+	Data packet = suppress(suppressor, frame);
+	CHECK(packet[0] == 0 && packet.length() == frame.length() + 2 - HEADER_LEN);
+
+	// the restorer only knows the header of flow 0 for that index
+	Data restored;
+	uint64_t failures = restorer.getStats().failures;
+	CHECK(!restorer.restore(packet, 1, 2, restored));
+	CHECK(restorer.getStats().failures == failures + 1);
+
+	// the periodic definition recovers the flow
+	for(unsigned int counter = 4; counter < 300; ++counter)
+	{
+		frame = buildFrame(CHANNEL_RULES, counter);
+		packet = suppress(suppressor, frame);
+		if(packet[0] != 0)
+		{
+			break;
+		}
+		CHECK(!restorer.restore(packet, 1, 2, restored));
+	}
+	CHECK(packet[0] == 0x40);
+	CHECK(isRestored(restorer, packet, frame));
+	frame = buildFrame(CHANNEL_RULES, 0);
+	CHECK(isRestored(restorer, suppress(suppressor, frame), frame));
+	return true;
+}
+
+/// The packets of a reused index are received out of order
+static bool checkReorderedRedefinition()
+{
+	PhsSuppressor suppressor;
+	PhsRestorer restorer;
+	CHECK(fillRules(suppressor, restorer));
+
+	// a packet of flow 0 is late, its index is reused meanwhile by flow 1
+	// then by the new flow: flow 0 is the least recently used
+	Data late_frame = buildFrame(0, 100);
+	Data late = suppress(suppressor, late_frame);
+	CHECK(late[0] == 0);
+	for(unsigned int flow = 1; flow < CHANNEL_RULES; ++flow)
+	{
+		suppress(suppressor, buildFrame(flow, 0));
+	}
+	Data definition_frame = buildFrame(CHANNEL_RULES, 0);
+	Data definition = suppress(suppressor, definition_frame);
+	CHECK(definition[0] == 0x40);
+
+	// a suppressed packet of the new flow arrives before its definition
+	for(unsigned int counter = 1; counter < 3; ++counter)
+	{
+		suppress(suppressor, buildFrame(CHANNEL_RULES, counter));
+	}
+	Data early_frame = buildFrame(CHANNEL_RULES, 3);
+	Data early = suppress(suppressor, early_frame);
+	CHECK(early[0] == 0);
+	Data restored;
+	CHECK(!restorer.restore(early, 1, 2, restored));
+
+	// the definition redefines the index, then the late packet of the
+	// previous flow is dropped instead of taking the new header
+	CHECK(isRestored(restorer, definition, definition_frame));
+	CHECK(!restorer.restore(late, 1, 2, restored));
+	CHECK(isRestored(restorer, early, early_frame));
+	return true;
+}
+
+/// The malformed packets are dropped
+static bool checkMalformed()
+{
+	PhsRestorer restorer;
+	Data restored;
+	const unsigned char truncated[] = {0x40, 0x01, 0x0E, 0x02};
+	const unsigned char unknown[] = {0x80, 0x01};
+	const unsigned char no_generation[] = {0x00};
+
+	CHECK(!restorer.restore(Data{}, 1, 2, restored));
+	CHECK(!restorer.restore(Data{truncated, sizeof(truncated)}, 1, 2, restored));
+	CHECK(!restorer.restore(Data{unknown, sizeof(unknown)}, 1, 2, restored));
+	CHECK(!restorer.restore(Data{no_generation, sizeof(no_generation)}, 1, 2, restored));
+	CHECK(restorer.getStats().failures == 4);
+	return true;
+}
+
+int main()
+{
+	if(!checkRoundTrip() || !checkLostRedefinition() ||
+	   !checkReorderedRedefinition() || !checkMalformed())
+	{
+		return 1;
+	}
+
+	printf("PHS rules checked\n");
+	return 0;
+}
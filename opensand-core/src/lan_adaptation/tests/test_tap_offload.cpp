@@ -0,0 +1,250 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file test_tap_offload.cpp
+ * @brief Check the segmentation and checksum completion of the frames
+ *        read on a TAP interface with offloads
+ * @author Viveris Technologies
+ */
+
+
+#include "TapOffload.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+
+#define ETH_HEADER_LEN 14
+#define IPV4_HEADER_LEN 20
+#define TCP_HEADER_LEN 20
+#define HEADERS_LEN (ETH_HEADER_LEN + IPV4_HEADER_LEN + TCP_HEADER_LEN)
+
+#define CHECK(condition) do \
+{ \
+	if(!(condition)) \
+	{ \
+		fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+		return false; \
+	} \
+} while(0)
+
+
+/**
+ * @brief Build an Ethernet/IPv4/TCP frame as handed by the kernel
+ *
+ * @param payload_length  The TCP payload length
+ * @param flags           The TCP flags
+ * @return the frame
+ */
+static std::vector<unsigned char> buildFrame(std::size_t payload_length, uint8_t flags)
+{
+	std::vector<unsigned char> frame(HEADERS_LEN + payload_length, 0);
+	unsigned char *ip = &frame[ETH_HEADER_LEN];
+	unsigned char *tcp = ip + IPV4_HEADER_LEN;
+
+	frame[12] = 0x08;
+	ip[0] = 0x45;
+	uint16_t total_length = htons(IPV4_HEADER_LEN + TCP_HEADER_LEN + payload_length);
+	memcpy(ip + 2, &total_length, sizeof(total_length));
+	ip[4] = 0x12;
+	ip[5] = 0x34;
+	ip[8] = 64;
+	ip[9] = IPPROTO_TCP;
+	const unsigned char addresses[8] = {192, 168, 1, 1, 192, 168, 2, 1};
+	memcpy(ip + 12, addresses, sizeof(addresses));
+
+	tcp[0] = 0x9c;
+	tcp[1] = 0x40;
+	tcp[3] = 80;
+	uint32_t sequence = htonl(0xFFFFF000);
+	memcpy(tcp + 4, &sequence, sizeof(sequence));
+	tcp[12] = (TCP_HEADER_LEN / 4) << 4;
+	tcp[13] = flags;
+	tcp[14] = 0xFF;
+
+	for(std::size_t index = 0; index < payload_length; ++index)
+	{
+		tcp[TCP_HEADER_LEN + index] = index * 7;
+	}
+	return frame;
+}
+
+static vnet_header_t buildHeader(uint8_t gso_type, uint16_t gso_size)
+{
+	vnet_header_t header;
+	memset(&header, 0, sizeof(header));
+	header.flags = VNET_HDR_F_NEEDS_CSUM;
+	header.gso_type = gso_type;
+	header.hdr_len = HEADERS_LEN;
+	header.gso_size = gso_size;
+	header.csum_start = ETH_HEADER_LEN + IPV4_HEADER_LEN;
+	header.csum_offset = 16;
+	return header;
+}
+
+/// Check that the one's complement sum of the bytes, with the checksum, is valid
+static bool isValidSum(uint32_t sum)
+{
+	while(sum >> 16)
+	{
+		sum = (sum & 0xFFFF) + (sum >> 16);
+	}
+	return sum == 0xFFFF;
+}
+
+/**
+ * @brief Check the headers and checksums of a segment
+ *
+ * @param segment         The segment
+ * @param payload_length  The expected payload length
+ * @param sequence        The expected TCP sequence number
+ * @return true if the segment is valid, false otherwise
+ */
+static bool checkSegment(const Data &segment, std::size_t payload_length, uint32_t sequence)
+{
+	CHECK(segment.length() == HEADERS_LEN + payload_length);
+	const unsigned char *ip = segment.data() + ETH_HEADER_LEN;
+	const unsigned char *tcp = ip + IPV4_HEADER_LEN;
+
+	uint16_t total_length;
+	memcpy(&total_length, ip + 2, sizeof(total_length));
+	CHECK(ntohs(total_length) == IPV4_HEADER_LEN + TCP_HEADER_LEN + payload_length);
+	CHECK(isValidSum(TapOffload::sum(0, ip, IPV4_HEADER_LEN)));
+
+	uint32_t segment_sequence;
+	memcpy(&segment_sequence, tcp + 4, sizeof(segment_sequence));
+	CHECK(ntohl(segment_sequence) == sequence);
+
+	std::size_t tcp_length = TCP_HEADER_LEN + payload_length;
+	uint32_t pseudo = TapOffload::sum(0, ip + 12, 8) + IPPROTO_TCP + tcp_length;
+	CHECK(isValidSum(TapOffload::sum(pseudo, tcp, tcp_length)));
+	return true;
+}
+
+/// A large segment is split at the MSS, the sequence wrapping around
+static bool checkSplit()
+{
+	const std::size_t mss = 1000;
+	std::vector<unsigned char> frame = buildFrame(2500, 0x18);
+	std::vector<Data> segments;
+
+	CHECK(TapOffload::split(buildHeader(VNET_HDR_GSO_TCPV4, mss),
+	                        frame.data(), frame.size(), segments));
+	CHECK(segments.size() == 3);
+	CHECK(checkSegment(segments[0], 1000, 0xFFFFF000));
+	CHECK(checkSegment(segments[1], 1000, 0xFFFFF000 + 1000));
+	CHECK(checkSegment(segments[2], 500, 0xFFFFF000 + 2000));
+
+	// the push flag is only kept on the last segment, the payload
+	// is copied in order and the IP IDs follow each other
+	CHECK((segments[0][HEADERS_LEN - 7] & 0x08) == 0);
+	CHECK((segments[2][HEADERS_LEN - 7] & 0x08) != 0);
+	CHECK(memcmp(&segments[1][HEADERS_LEN], &frame[HEADERS_LEN + 1000], 1000) == 0);
+	CHECK(segments[1][ETH_HEADER_LEN + 5] == 0x35);
+	return true;
+}
+
+/// A segmentation offload frame without payload is kept as one segment
+static bool checkEmptyPayload()
+{
+	std::vector<unsigned char> frame = buildFrame(0, 0x11);
+	std::vector<Data> segments;
+
+	CHECK(TapOffload::split(buildHeader(VNET_HDR_GSO_TCPV4, 1000),
+	                        frame.data(), frame.size(), segments));
+	CHECK(segments.size() == 1);
+	CHECK(checkSegment(segments[0], 0, 0xFFFFF000));
+	// the FIN flag of the only segment is kept
+	CHECK((segments[0][HEADERS_LEN - 7] & 0x01) != 0);
+	return true;
+}
+
+/// A frame without segmentation only has its checksum completed
+static bool checkChecksum()
+{
+	std::vector<unsigned char> frame = buildFrame(100, 0x18);
+	std::vector<Data> segments;
+
+	// the kernel leaves the pseudo-header sum in the checksum field
+	const unsigned char *ip = &frame[ETH_HEADER_LEN];
+	uint32_t pseudo = TapOffload::sum(0, ip + 12, 8) + IPPROTO_TCP + TCP_HEADER_LEN + 100;
+	while(pseudo >> 16)
+	{
+		pseudo = (pseudo & 0xFFFF) + (pseudo >> 16);
+	}
+	frame[HEADERS_LEN - 4] = pseudo >> 8;
+	frame[HEADERS_LEN - 3] = pseudo;
+	// the IP checksum is computed by the kernel
+	uint16_t ip_checksum = TapOffload::fold(TapOffload::sum(0, ip, IPV4_HEADER_LEN));
+	memcpy(&frame[ETH_HEADER_LEN + 10], &ip_checksum, sizeof(ip_checksum));
+
+	CHECK(TapOffload::split(buildHeader(VNET_HDR_GSO_NONE, 0),
+	                        frame.data(), frame.size(), segments));
+	CHECK(segments.size() == 1);
+	CHECK(checkSegment(segments[0], 100, 0xFFFFF000));
+	return true;
+}
+
+/// The frames whose transport header cannot be located are rejected
+static bool checkInvalid()
+{
+	std::vector<unsigned char> frame = buildFrame(100, 0x18);
+	std::vector<Data> segments;
+
+	vnet_header_t header = buildHeader(VNET_HDR_GSO_TCPV4, 1000);
+	header.flags = 0;
+	CHECK(!TapOffload::split(header, frame.data(), frame.size(), segments));
+
+	header = buildHeader(VNET_HDR_GSO_TCPV4, 0);
+	CHECK(!TapOffload::split(header, frame.data(), frame.size(), segments));
+
+	header = buildHeader(VNET_HDR_GSO_UDP, 1000);
+	CHECK(!TapOffload::split(header, frame.data(), frame.size(), segments));
+
+	header = buildHeader(VNET_HDR_GSO_TCPV6, 1000);
+	CHECK(!TapOffload::split(header, frame.data(), frame.size(), segments));
+
+	header = buildHeader(VNET_HDR_GSO_TCPV4, 1000);
+	CHECK(!TapOffload::split(header, frame.data(), HEADERS_LEN - 1, segments));
+	CHECK(segments.empty());
+	return true;
+}
+
+int main()
+{
+	if(!checkSplit() || !checkEmptyPayload() || !checkChecksum() || !checkInvalid())
+	{
+		return 1;
+	}
+
+	printf("TAP offloads checked\n");
+	return 0;
+}
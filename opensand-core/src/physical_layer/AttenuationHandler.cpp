@@ -43,6 +43,7 @@
 
 #include <opensand_output/Output.h>
 
+#include <algorithm>
 #include <math.h>
 
 AttenuationHandler::AttenuationHandler(std::shared_ptr<OutputLog> log_channel):
@@ -50,7 +51,14 @@ AttenuationHandler::AttenuationHandler(std::shared_ptr<OutputLog> log_channel):
 	error_insertion_model(NULL),
 	log_channel(log_channel),
 	probe_minimal_condition(NULL),
-	probe_drops(NULL)
+	probe_drops(NULL),
+	modcod_frames(),
+	modcod_ids(),
+	message_types(),
+	cn_totals(),
+	minimal_cns(),
+	to_modify(),
+	to_modify_size(0)
 {
 }
 
@@ -143,49 +151,72 @@ bool AttenuationHandler::initialize(std::shared_ptr<OutputLog> log_init, const s
 
 bool AttenuationHandler::process(DvbFrame *dvb_frame, double cn_total)
 {
-	fmt_id_t modcod_id = 0;
-	double min_cn;
-	Data payload;
+	return this->process(&dvb_frame, &cn_total, 1);
+}
 
-	// Consider that the packet is not dropped  (if its dropped, the probe
-	// will be updated later), so that the probe emits a 0 value if necessary.
-	this->probe_drops->put(0);
+bool AttenuationHandler::process(DvbFrame *const *dvb_frames,
+                                 const double *cn_totals,
+                                 std::size_t count)
+{
+	this->modcod_frames.clear();
+	this->modcod_ids.clear();
+	this->message_types.clear();
+	this->cn_totals.clear();
 
-	// Get the MODCOD used to send DVB frame
-	// (keep the complete header because we carry useful data)
-	switch(dvb_frame->getMessageType())
+	for(std::size_t i = 0; i < count; ++i)
 	{
-		case EmulatedMessageType::BbFrame:
-		{
-			// TODO BBFrame *bbframe = dynamic_cast<BBFrame *>(dvb_frame);
-			BBFrame *bbframe = (BBFrame *)dvb_frame;
-			modcod_id = bbframe->getModcodId();
-			payload = bbframe->getPayload();
-		}
-		break;
+		DvbFrame *dvb_frame = dvb_frames[i];
+		fmt_id_t modcod_id;
 
-		case EmulatedMessageType::DvbBurst:
-		{
-			// TODO DvbRcsFrame *dvb_rcs_frame = dynamic_cast<DvbRcsFrame *>(dvb_frame);
-			DvbRcsFrame *dvb_rcs_frame = (DvbRcsFrame *)dvb_frame;
-			modcod_id = dvb_rcs_frame->getModcodId();
-			payload = dvb_rcs_frame->getPayload();
-		}
-		break;
+		// Consider that the packet is not dropped  (if its dropped, the probe
+		// will be updated later), so that the probe emits a 0 value if necessary.
+		this->probe_drops->put(0);
 
-		default:
+		// Get the MODCOD used to send DVB frame
+		switch(dvb_frame->getMessageType())
 		{
-			// This message, even though it carries C/N information (is attenuated)
-			// is not encoded using a MODCOD, and cannot be dropped.
-			return true;
+			case EmulatedMessageType::BbFrame:
+				// TODO BBFrame *bbframe = dynamic_cast<BBFrame *>(dvb_frame);
+				modcod_id = ((BBFrame *)dvb_frame)->getModcodId();
+				break;
+
+			case EmulatedMessageType::DvbBurst:
+				// TODO DvbRcsFrame *dvb_rcs_frame = dynamic_cast<DvbRcsFrame *>(dvb_frame);
+				modcod_id = ((DvbRcsFrame *)dvb_frame)->getModcodId();
+				break;
+
+			default:
+				// This message, even though it carries C/N information (is attenuated)
+				// is not encoded using a MODCOD, and cannot be dropped.
+				continue;
 		}
+
+		LOG(this->log_channel, LEVEL_INFO,
+		    "Receive frame with MODCOD %u, total C/N = %.2f", modcod_id, cn_totals[i]);
+
+		this->modcod_frames.push_back(dvb_frame);
+		this->modcod_ids.push_back(modcod_id);
+		this->message_types.push_back(dvb_frame->getMessageType());
+		this->cn_totals.push_back(cn_totals[i]);
 	}
 
-	LOG(this->log_channel, LEVEL_INFO,
-	    "Receive frame with MODCOD %u, total C/N = %.2f", modcod_id, cn_total);
+	std::size_t frames_count = this->modcod_frames.size();
+	if(frames_count == 0)
+	{
+		return true;
+	}
+	this->minimal_cns.resize(frames_count);
+	if(this->to_modify_size < frames_count)
+	{
+		this->to_modify.reset(new bool[frames_count]);
+		this->to_modify_size = frames_count;
+	}
 
 	// Update minimal condition threshold
-	if(!this->minimal_condition_model->updateThreshold(modcod_id, dvb_frame->getMessageType()))
+	if(!this->minimal_condition_model->updateThresholds(this->modcod_ids.data(),
+	                                                    this->message_types.data(),
+	                                                    this->minimal_cns.data(),
+	                                                    frames_count))
 	{
 		LOG(this->log_channel, LEVEL_ERROR,
 		    "Threshold update failed");
@@ -199,29 +230,53 @@ bool AttenuationHandler::process(DvbFrame *dvb_frame, double cn_total)
 	//      We would have to parse frames in order to remove them from
 	//      statistics, this is not efficient 
 	//      With physcal layer ACM loop, these frame would be mark as corrupted
-	min_cn = this->minimal_condition_model->getMinimalCN();
-	this->probe_minimal_condition->put(min_cn);
-	LOG(this->log_channel, LEVEL_INFO,
-	    "Minimal condition value for MODCOD %u: %.2f dB", modcod_id, min_cn);
-
-	// Insert error if required
-	if(!this->error_insertion_model->isToBeModifiedPacket(cn_total, min_cn))
+	double max_cn = this->minimal_cns[0];
+	for(std::size_t i = 0; i < frames_count; ++i)
 	{
-		return true;
+		max_cn = std::max(max_cn, this->minimal_cns[i]);
+		LOG(this->log_channel, LEVEL_INFO,
+		    "Minimal condition value for MODCOD %u: %.2f dB",
+		    this->modcod_ids[i], this->minimal_cns[i]);
 	}
-	LOG(this->log_channel, LEVEL_DEBUG,
-	    "Error insertion is required");
+	// the probe keeps the maximum of the period
+	this->probe_minimal_condition->put(max_cn);
 
-	if(!this->error_insertion_model->modifyPacket(payload))
+	// Insert error if required
+	this->error_insertion_model->areToBeModifiedPackets(this->cn_totals.data(),
+	                                                    this->minimal_cns.data(),
+	                                                    this->to_modify.get(),
+	                                                    frames_count);
+	for(std::size_t i = 0; i < frames_count; ++i)
 	{
-		LOG(this->log_channel, LEVEL_ERROR,
-		    "Error insertion failed");
-		return false;
+		if(!this->to_modify[i])
+		{
+			continue;
+		}
+		LOG(this->log_channel, LEVEL_DEBUG,
+		    "Error insertion is required");
+
+		// the payload follows the header, up to the trailer
+		DvbFrame *dvb_frame = this->modcod_frames[i];
+		bool corrupted;
+		if(!this->error_insertion_model->modifyPayload(dvb_frame->getRawData() + dvb_frame->getHeaderLength(),
+		                                               dvb_frame->getPayloadLength(),
+		                                               this->cn_totals[i],
+		                                               this->minimal_cns[i],
+		                                               corrupted))
+		{
+			LOG(this->log_channel, LEVEL_ERROR,
+			    "Error insertion failed");
+			return false;
+		}
+		if(!corrupted)
+		{
+			continue;
+		}
+		dvb_frame->setCorrupted(true);
+		this->probe_drops->put(1);
+		LOG(this->log_channel, LEVEL_NOTICE,
+		    "Received frame was corrupted");
 	}
-	dvb_frame->setCorrupted(true);
-	this->probe_drops->put(1);
-	LOG(this->log_channel, LEVEL_NOTICE,
-	    "Received frame was corrupted");
 
 	return true;
 }
@@ -41,7 +41,9 @@
 
 #include <opensand_output/Output.h>
 
+#include <memory>
 #include <string>
+#include <vector>
 
 
 /**
@@ -66,6 +68,16 @@ private:
 	std::shared_ptr<Probe<float>> probe_minimal_condition;
 	std::shared_ptr<Probe<int>> probe_drops;
 
+	/// The frames of the batch carrying a MODCOD and their parameters,
+	/// kept between batches to avoid allocations
+	std::vector<DvbFrame *> modcod_frames;
+	std::vector<uint8_t> modcod_ids;
+	std::vector<EmulatedMessageType> message_types;
+	std::vector<double> cn_totals;
+	std::vector<double> minimal_cns;
+	std::unique_ptr<bool[]> to_modify;
+	std::size_t to_modify_size;
+
 public:
 	/**
 	 * @brief Constructor of the attenuation handler
@@ -99,6 +111,18 @@ public:
 	 * @return true on success, false otherwise
 	 */
 	bool process(DvbFrame *dvb_frame, double cn_total);
+
+	/**
+	 * @brief Process the attenuation on a batch of DVB frames, the
+	 *        plugins handle the whole batch in one call
+	 *
+	 * @param dvb_frames  the DVB frames
+	 * @param cn_totals   the specific C/N of each frame
+	 * @param count       the number of frames
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool process(DvbFrame *const *dvb_frames, const double *cn_totals, std::size_t count);
 };
 
 #endif
@@ -96,6 +96,7 @@ bool BlockPhysicalLayer::onInit(void)
 		return false;
 	}
 	// init plugin
+	this->satdelay->setEntityId(this->mac_id);
 	if(!this->satdelay->init())
 	{
 		LOG(this->log_init, LEVEL_ERROR,
@@ -268,17 +269,85 @@ bool BlockPhysicalLayer::Upward::forwardPacket(DvbFrame *dvb_frame)
 		}
 	}
 
-	// Send frame to upper layer
-	if (!this->enqueueMessage((void **)&dvb_frame, 0, to_underlying(InternalMessageType::unknown)))
+	// Send frame to upper layer, the frame is released on failure
+	if (!this->enqueueMessage(std::unique_ptr<DvbFrame>{dvb_frame}, 0, to_underlying(InternalMessageType::unknown)))
 	{
 		LOG(this->log_send, LEVEL_ERROR, 
 		    "Failed to send burst of packets to upper layer");
-		delete dvb_frame;
 		return false;
 	}
 	return true;
 }
 
+bool BlockPhysicalLayer::Upward::forwardPackets(const std::vector<DvbFrame *> &dvb_frames)
+{
+	// Set C/N to Dvb frames
+	this->batch_frames.clear();
+	this->batch_cns.clear();
+	for(DvbFrame *dvb_frame : dvb_frames)
+	{
+		if(IsCnCapableFrame(dvb_frame->getMessageType()))
+		{
+			this->batch_frames.push_back(dvb_frame);
+			this->batch_cns.push_back(dvb_frame->getCn());
+		}
+	}
+	this->total_cns.resize(this->batch_frames.size());
+	GroundPhysicalChannel::computeTotalCn(this->batch_cns.data(),
+	                                      this->getCurrentCn(),
+	                                      this->total_cns.data(),
+	                                      this->batch_frames.size());
+	for(std::size_t i = 0; i < this->batch_frames.size(); ++i)
+	{
+		DvbFrame *dvb_frame = this->batch_frames[i];
+		dvb_frame->setCn(this->total_cns[i]);
+		LOG(this->log_event, LEVEL_DEBUG,
+		    "Set C/N to the DVB frame forwardPacket %f. Message type %d\n",
+		    this->total_cns[i], dvb_frame->getMessageType());
+
+		// Update probe
+		this->probe_total_cn->put(this->total_cns[i]);
+	}
+
+	// Process Attenuation
+	this->batch_frames.clear();
+	this->batch_cns.clear();
+	for(DvbFrame *dvb_frame : dvb_frames)
+	{
+		if(IsAttenuatedFrame(dvb_frame->getMessageType()))
+		{
+			this->batch_frames.push_back(dvb_frame);
+			this->batch_cns.push_back(dvb_frame->getCn());
+		}
+	}
+	if(!this->batch_frames.empty() &&
+	   !this->attenuation_hdl->process(this->batch_frames.data(),
+	                                   this->batch_cns.data(),
+	                                   this->batch_frames.size()))
+	{
+		LOG(this->log_event, LEVEL_ERROR,
+		    "Failed to get the attenuation");
+		for(DvbFrame *dvb_frame : dvb_frames)
+		{
+			delete dvb_frame;
+		}
+		return false;
+	}
+
+	// Send frames to upper layer, the frames are released on failure
+	bool success = true;
+	for(DvbFrame *dvb_frame : dvb_frames)
+	{
+		if (!this->enqueueMessage(std::unique_ptr<DvbFrame>{dvb_frame}, 0, to_underlying(InternalMessageType::unknown)))
+		{
+			LOG(this->log_send, LEVEL_ERROR, 
+			    "Failed to send burst of packets to upper layer");
+			success = false;
+		}
+	}
+	return success;
+}
+
 double BlockPhysicalLayer::Upward::getCn(DvbFrame *dvb_frame) const
 {
 	return GroundPhysicalChannel::computeTotalCn(dvb_frame->getCn(), this->getCurrentCn());
@@ -441,12 +510,11 @@ bool BlockPhysicalLayer::Downward::updateDelay()
 
 bool BlockPhysicalLayer::Downward::forwardPacket(DvbFrame *dvb_frame)
 {
-	// Send frame to upper layer
-	if (!this->enqueueMessage((void **)&dvb_frame, 0, to_underlying(InternalMessageType::unknown)))
+	// Send frame to lower layer, the frame is released on failure
+	if (!this->enqueueMessage(std::unique_ptr<DvbFrame>{dvb_frame}, 0, to_underlying(InternalMessageType::unknown)))
 	{
 		LOG(this->log_send, LEVEL_ERROR, 
-		    "Failed to send burst of packets to upper layer");
-		delete dvb_frame;
+		    "Failed to send burst of packets to lower layer");
 		return false;
 	}
 	return true;	
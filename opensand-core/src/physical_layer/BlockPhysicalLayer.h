@@ -50,6 +50,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 
 class AttenuationHandler;
@@ -72,6 +73,12 @@ public:
 		/// Probes
 		std::shared_ptr<Probe<float>> probe_total_cn = nullptr;
 
+		/// The frames of a batch carrying a C/N and their C/N,
+		/// kept to avoid allocations
+		std::vector<DvbFrame *> batch_frames;
+		std::vector<double> batch_cns;
+		std::vector<double> total_cns;
+
 	protected:
 		/// The attenuation process
 		AttenuationHandler *attenuation_hdl;
@@ -85,6 +92,16 @@ public:
 		 */
 		bool forwardPacket(DvbFrame *dvb_frame);
 
+		/**
+		 * @brief Forward the frames leaving the delay FIFO together,
+		 *        the C/N and the attenuation are processed on the batch
+		 *
+		 * @param dvb_frames  the DVB frames to forward
+		 *
+		 * @return true on success, false otherwise
+		 */
+		bool forwardPackets(const std::vector<DvbFrame *> &dvb_frames) override;
+
 		/**
 		 * @brief Get the C/N fot the current DVB frame
 		 *
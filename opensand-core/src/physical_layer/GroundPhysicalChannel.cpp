@@ -47,9 +47,22 @@
 #include <opensand_rt/RtChannelBase.h>
 
 
+/// The number of refresh periods computed ahead by the task pool
+constexpr std::size_t attenuation_lookahead = 16;
+
+
 GroundPhysicalChannel::GroundPhysicalChannel(PhyLayerConfig config):
 	clear_sky_condition{0},
+	attenuation{0},
+	attenuation_buffers{},
+	front_buffer{0},
+	front_position{0},
+	back_ready{false},
+	back_failed{false},
+	attenuation_refresh{nullptr},
 	delay_fifo{},
+	timer_channel{nullptr},
+	next_release{0},
 	mac_id{config.mac_id},
 	entity_type{config.entity_type},
 	spot_id{config.spot_id},
@@ -109,24 +122,16 @@ bool GroundPhysicalChannel::initGround(bool upward_channel, RtChannelBase *chann
 	LOG(log_init, LEVEL_NOTICE,
 	    "delay_fifo_max_size = %d pkt", max_size);
 
-	// Get the delay refresh period
-	time_ms_t refresh_period_ms;
-	if(!Conf->getDelayTimer(refresh_period_ms))
-	{
-		LOG(log_init, LEVEL_ERROR,
-		    "cannot get 'delay_timer' value");
-		return false;
-	}
-	LOG(log_init, LEVEL_NOTICE,
-	    "delay_refresh_period = %d ms", refresh_period_ms);
-
-	// Initialize the FIFO event
-	this->fifo_timer = channel->addTimerEvent("fifo_timer", refresh_period_ms);
+	// Initialize the FIFO event, armed for the release of the FIFO head
+	// rather than polling the FIFO
+	this->timer_channel = channel;
+	this->fifo_timer = channel->addTimerEvent("fifo_timer", 0, false, false);
 
 	// Initialize log
 	this->log_event = output->registerLog(LEVEL_WARNING, "PhysicalLayer." + link + "ward.Event");
 
 	// Get the refresh period
+	time_ms_t refresh_period_ms;
 	if(!Conf->getAcmRefreshPeriod(refresh_period_ms))
 	{
 		LOG(log_init, LEVEL_ERROR,
@@ -176,6 +181,17 @@ bool GroundPhysicalChannel::initGround(bool upward_channel, RtChannelBase *chann
 		return false;
 	}
 
+	// The model is evaluated ahead of its refresh periods so that a slow
+	// model does not delay the frames; without workers a single period
+	// is computed at a time, as before
+	this->attenuation = this->attenuation_model->getAttenuation();
+	std::size_t lookahead = Rt::getTaskPool().size() > 0 ? attenuation_lookahead : 1;
+	this->attenuation_buffers[0].resize(lookahead);
+	this->attenuation_buffers[1].resize(lookahead);
+	this->front_position = lookahead;
+	this->attenuation_refresh = std::make_unique<RtTaskGroup>(Rt::getTaskPool());
+	this->refreshBackBuffer();
+
 	// Initialize the attenuation event
 	std::ostringstream name;
 	name << "attenuation_" << link;
@@ -198,14 +214,29 @@ bool GroundPhysicalChannel::updateAttenuation()
 	LOG(this->log_channel, LEVEL_DEBUG,
 		"Update attenuation");
 
-	if(!this->attenuation_model->updateAttenuationModel())
+	if(this->front_position == this->attenuation_buffers[this->front_buffer].size())
 	{
-		LOG(this->log_channel, LEVEL_ERROR,
-		    "Attenuation update failed");
-		return false;
+		if(!this->back_ready.load(std::memory_order_acquire))
+		{
+			// the model is late, wait for it rather than skip periods
+			LOG(this->log_channel, LEVEL_INFO,
+			    "Waiting for the attenuation model");
+			this->attenuation_refresh->wait();
+		}
+		if(this->back_failed)
+		{
+			LOG(this->log_channel, LEVEL_ERROR,
+			    "Attenuation update failed");
+			return false;
+		}
+		this->front_buffer = 1 - this->front_buffer;
+		this->front_position = 0;
+		this->back_ready.store(false, std::memory_order_relaxed);
+		this->refreshBackBuffer();
 	}
 
-	double attenuation = this->attenuation_model->getAttenuation();
+	double attenuation = this->attenuation_buffers[this->front_buffer][this->front_position++];
+	this->attenuation = attenuation;
 
 	LOG(this->log_channel, LEVEL_INFO,
 		"New attenuation: %.2f dB",
@@ -219,7 +250,28 @@ bool GroundPhysicalChannel::updateAttenuation()
 double GroundPhysicalChannel::getCurrentCn() const
 {
 	// C/N calculation, as the substraction of the clear sky C/N with the Attenuation
-	return this->clear_sky_condition - this->attenuation_model->getAttenuation();
+	return this->clear_sky_condition - this->attenuation;
+}
+
+void GroundPhysicalChannel::refreshBackBuffer()
+{
+	std::vector<double> &back = this->attenuation_buffers[1 - this->front_buffer];
+	this->attenuation_refresh->run([this, &back]()
+	{
+		// only this task uses the model until the buffer is ready
+		bool failed = false;
+		for(double &value: back)
+		{
+			if(!this->attenuation_model->refreshAttenuation())
+			{
+				failed = true;
+				break;
+			}
+			value = this->attenuation_model->getAttenuation();
+		}
+		this->back_failed = failed;
+		this->back_ready.store(true, std::memory_order_release);
+	});
 }
 
 double GroundPhysicalChannel::computeTotalCn(double up_cn, double down_cn)
@@ -237,6 +289,18 @@ double GroundPhysicalChannel::computeTotalCn(double up_cn, double down_cn)
 	return total_cn;
 }
 
+void GroundPhysicalChannel::computeTotalCn(const double *up_cns, double down_cn,
+                                           double *total_cns, std::size_t count)
+{
+	double down_inverse = 1 / pow(10, down_cn / 10);
+
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		double up_num = pow(10, up_cns[i] / 10);
+		total_cns[i] = 10 * log10(1 / (down_inverse + (1 / up_num)));
+	}
+}
+
 bool GroundPhysicalChannel::pushPacket(NetContainer *pkt)
 {
 	FifoElement *elem;
@@ -270,9 +334,24 @@ bool GroundPhysicalChannel::pushPacket(NetContainer *pkt)
 	    elem->getTickIn(),
 	    elem->getTickOut(),
 	    delay);
+
+	// advance the timer if the frame leaves first
+	clock_t release = elem->getTickOut();
+	if(this->next_release == 0 || release < this->next_release)
+	{
+		return this->armFifoTimer(release);
+	}
 	return true;
 }
 
+bool GroundPhysicalChannel::armFifoTimer(clock_t release)
+{
+	this->next_release = release;
+	double remaining = release - getPreciseTime();
+	return this->timer_channel->setDuration(this->fifo_timer, std::max(remaining, 0.0)) &&
+	       this->timer_channel->startTimer(this->fifo_timer);
+}
+
 bool GroundPhysicalChannel::forwardReadyPackets()
 {
 	time_ms_t current_time = getCurrentTime();
@@ -280,6 +359,8 @@ bool GroundPhysicalChannel::forwardReadyPackets()
 	LOG(this->log_channel, LEVEL_DEBUG,
 		"Forward ready packets");
 
+	this->ready_frames.clear();
+	uint64_t now = 0;
 	while (this->delay_fifo.getCurrentSize() > 0 &&
 	       ((unsigned long)this->delay_fifo.getTickOut()) <= current_time)
 	{
@@ -288,7 +369,37 @@ bool GroundPhysicalChannel::forwardReadyPackets()
 
 		std::unique_ptr<NetContainer> pkt = elem->getElem();
 		delete elem;
-		this->forwardPacket(reinterpret_cast<DvbFrame *>(pkt.release()));
+		// the emulated propagation delay is not part of the processing latency
+		if(pkt->getTimestamp() != 0)
+		{
+			if(now == 0)
+			{
+				now = getTimestampNs();
+			}
+			pkt->setTimestamp(now);
+		}
+		this->ready_frames.push_back(reinterpret_cast<DvbFrame *>(pkt.release()));
+	}
+
+	this->next_release = 0;
+	if(this->delay_fifo.getCurrentSize() > 0 &&
+	   !this->armFifoTimer(this->delay_fifo.getTickOut()))
+	{
+		return false;
+	}
+	if(!this->ready_frames.empty())
+	{
+		this->forwardPackets(this->ready_frames);
 	}
 	return true;
 }
+
+bool GroundPhysicalChannel::forwardPackets(const std::vector<DvbFrame *> &dvb_frames)
+{
+	bool success = true;
+	for(DvbFrame *dvb_frame : dvb_frames)
+	{
+		success &= this->forwardPacket(dvb_frame);
+	}
+	return success;
+}
@@ -44,6 +44,11 @@
 #include <opensand_rt/Rt.h>
 #include <opensand_rt/Types.h>
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
 
 class NetContainer;
 
@@ -68,6 +73,22 @@ private:
 	/// Clear Sky Conditions (best C/N in clear-sky conditions)
 	double clear_sky_condition;
 
+	/// The attenuation of the current refresh period
+	double attenuation;
+
+	/// The attenuations of the next refresh periods: the channel reads
+	/// the front buffer while the task pool fills the back one
+	std::array<std::vector<double>, 2> attenuation_buffers;
+	std::size_t front_buffer;
+	std::size_t front_position;
+
+	/// Whether the back buffer is filled, and whether its model failed
+	std::atomic<bool> back_ready;
+	bool back_failed;
+
+	/// The computation of the back buffer, released before the buffers
+	std::unique_ptr<RtTaskGroup> attenuation_refresh;
+
 	/// The FIFO that implements the delay
 	DelayFifo delay_fifo;
 
@@ -75,6 +96,30 @@ private:
 	std::shared_ptr<Probe<float>> probe_attenuation = nullptr;
 	std::shared_ptr<Probe<float>> probe_clear_sky_condition = nullptr;
 
+	/// The frames leaving the FIFO together, kept to avoid allocations
+	std::vector<DvbFrame *> ready_frames;
+
+	/// The channel of the FIFO timer
+	RtChannelBase *timer_channel;
+
+	/// The release time the FIFO timer is armed for, 0 if it is not armed
+	clock_t next_release;
+
+	/**
+	 * @brief Arm the FIFO timer for the release time of the FIFO head,
+	 *        the frames due on the same time leave together
+	 *
+	 * @param release  the release time of the FIFO head
+	 * @return true on success, false otherwise
+	 */
+	bool armFifoTimer(clock_t release);
+
+	/**
+	 * @brief Compute the attenuations of the back buffer in the task
+	 *        pool, or right away without workers
+	 */
+	void refreshBackBuffer();
+
 protected:
 	/// The terminal or gateway id
 	tal_id_t mac_id;
@@ -149,6 +194,16 @@ protected:
 	 */
 	virtual bool forwardPacket(DvbFrame *dvb_frame) = 0;
 
+	/**
+	 * @brief Forward the frames leaving the FIFO together to the next
+	 *        channel, by default one at a time with forwardPacket
+	 *
+	 * @param dvb_frames  the DVB frames to forward, released here
+	 *
+	 * @return true on success, false otherwise
+	 */
+	virtual bool forwardPackets(const std::vector<DvbFrame *> &dvb_frames);
+
 public:
 	virtual ~GroundPhysicalChannel() = default;
 
@@ -171,6 +226,18 @@ public:
 	 * @return the total C/N value
 	 */
 	static double computeTotalCn(double up_cn, double down_cn);
+
+	/**
+	 * @brief Compute the total C/N of the links of a batch of frames
+	 *        sharing the same downlink C/N
+	 *
+	 * @param up_cns     the uplink C/N value of each frame
+	 * @param down_cn    the downlink C/N value
+	 * @param total_cns  OUT: the total C/N value of each frame
+	 * @param count      the number of frames
+	 */
+	static void computeTotalCn(const double *up_cns, double down_cn,
+	                           double *total_cns, std::size_t count);
 };
 
 
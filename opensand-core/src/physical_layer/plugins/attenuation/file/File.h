@@ -37,8 +37,8 @@
 
 
 #include "PhysicalLayerPlugin.h"
+#include "TimeSeries.h"
 
-#include <map>
 #include <string>
 
 
@@ -53,13 +53,14 @@ private:
 	unsigned int current_time;
 
 	/// The attenuation values we will interpolate
-	std::map<unsigned int, double> attenuation;
+	TimeSeries attenuation;
 
 	/// Reading mode
 	bool loop;
 
 	/**
-	 * @brief Load the attenuation file
+	 * @brief Load the attenuation file, text or converted by
+	 *        opensand_convert_trace
 	 *
 	 * @param filename  The attenuation file name
 	 * @return true on success, false otherwise
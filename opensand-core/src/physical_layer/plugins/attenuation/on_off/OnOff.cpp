@@ -40,6 +40,9 @@
 
 #include <opensand_output/Output.h>
 
+#include <iomanip>
+#include <sstream>
+
 
 OnOff::OnOff():
 		AttenuationModelPlugin(),
@@ -86,6 +89,13 @@ void OnOff::generateConfiguration(const std::string &parent_path,
 	                                                   types->getType("double"));
 	attenuation_value->setUnit("dB");
 	Conf->setProfileReference(attenuation_value, attenuation_type, plugin_name);
+	auto precomputed = attenuation->addParameter("onoff_precomputed",
+	                                             "Precomputed Profile",
+	                                             types->getType("bool"),
+	                                             "Compute one period of the attenuation at startup, "
+	                                             "shared by the links with the same parameters");
+	precomputed->setAdvanced(true);
+	Conf->setProfileReference(precomputed, attenuation_type, plugin_name);
 }
 
 
@@ -121,10 +131,30 @@ bool OnOff::init(time_ms_t refresh_period_ms, std::string link_path)
 		return false;
 	}
 
+	bool precomputed = false;
+	OpenSandModelConf::extractParameterData(attenuation->getParameter("onoff_precomputed"), precomputed);
+	if(precomputed)
+	{
+		std::ostringstream key;
+		key << std::setprecision(17) << "OnOff/" << this->on_duration
+		    << "/" << this->off_duration << "/" << this->amplitude;
+		return this->precomputeProfile(key.str(), this->on_duration + this->off_duration,
+		                               [this](std::size_t counter)
+		                               {
+		                                 return this->computeAttenuation(counter);
+		                               });
+	}
+
 	return true;
 }
 
 
+double OnOff::computeAttenuation(int counter) const
+{
+	return counter < this->off_duration ? 0 : this->amplitude;
+}
+
+
 bool OnOff::updateAttenuationModel()
 {
 	this->duration_counter = (this->duration_counter + 1) %
@@ -132,14 +162,7 @@ bool OnOff::updateAttenuationModel()
 
 	LOG(this->log_attenuation, LEVEL_INFO,
 	    "Attenuation model counter %d\n", this->duration_counter);
-	if(this->duration_counter < this->off_duration)
-	{
-		this->setAttenuation(0);
-	}
-	else
-	{
-		this->setAttenuation(this->amplitude);
-	}
+	this->setAttenuation(this->computeAttenuation(this->duration_counter));
 
 	LOG(this->log_attenuation, LEVEL_INFO,
 	    "On/Off Attenuation %.2f dB\n", this->getAttenuation());
@@ -40,9 +40,13 @@
 
 #include <opensand_output/Output.h>
 
+#include <iomanip>
+#include <sstream>
+
 
 const std::string SLOPE = "triangle_attenuation_slope";
 const std::string PERIOD = "triangle_attenuation_period";
+const std::string PRECOMPUTED = "triangle_precomputed";
 
 
 Triangular::Triangular():
@@ -81,6 +85,11 @@ void Triangular::generateConfiguration(const std::string &parent_path,
 	auto attenuation_period = attenuation->addParameter(PERIOD, "Attenuation Period", types->getType("int"));
 	attenuation_period->setUnit("refresh period");
 	Conf->setProfileReference(attenuation_period, attenuation_type, plugin_name);
+	auto precomputed = attenuation->addParameter(PRECOMPUTED, "Precomputed Profile", types->getType("bool"),
+	                                             "Compute one period of the attenuation at startup, "
+	                                             "shared by the links with the same parameters");
+	precomputed->setAdvanced(true);
+	Conf->setProfileReference(precomputed, attenuation_type, plugin_name);
 }
 
 
@@ -106,24 +115,41 @@ bool Triangular::init(time_ms_t refresh_period_ms, std::string link_path)
 		return false;
 	}
 
+	bool precomputed = false;
+	OpenSandModelConf::extractParameterData(attenuation->getParameter(PRECOMPUTED), precomputed);
+	if(precomputed)
+	{
+		std::ostringstream key;
+		key << std::setprecision(17) << "Triangular/" << this->slope
+		    << "/" << this->period << "/" << this->refresh_period_ms;
+		return this->precomputeProfile(key.str(), this->period,
+		                               [this](std::size_t counter)
+		                               {
+		                                 return this->computeAttenuation(counter);
+		                               });
+	}
+
 	return true;
 }
 
 
-bool Triangular::updateAttenuationModel()
+double Triangular::computeAttenuation(int counter) const
 {
-	this->duration_counter = (this->duration_counter + 1) % this->period;
-	double time = this->duration_counter * this->refresh_period_ms / 1000;
+	double time = counter * this->refresh_period_ms / 1000;
 
 	if(time < this->period / 2)
 	{
-		this->setAttenuation(time * this->slope);
-	}
-	else
-	{
-		double max = this->period * this->slope * this->refresh_period_ms / 1000;
-		this->setAttenuation(max - time * this->slope);
+		return time * this->slope;
 	}
+	double max = this->period * this->slope * this->refresh_period_ms / 1000;
+	return max - time * this->slope;
+}
+
+
+bool Triangular::updateAttenuationModel()
+{
+	this->duration_counter = (this->duration_counter + 1) % this->period;
+	this->setAttenuation(this->computeAttenuation(this->duration_counter));
 
 	LOG(this->log_attenuation, LEVEL_INFO,
 	    "On/Off Attenuation %.2f dB\n", this->getAttenuation());
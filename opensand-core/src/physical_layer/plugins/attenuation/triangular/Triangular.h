@@ -56,6 +56,14 @@ private:
 
 	int duration_counter;
 
+	/**
+	 * @brief Compute the attenuation at a step of the period
+	 *
+	 * @param counter  The number of refresh periods since the period start
+	 * @return the attenuation in dB
+	 */
+	double computeAttenuation(int counter) const;
+
 public:
 	/**
 	 * @brief Build a Triangular
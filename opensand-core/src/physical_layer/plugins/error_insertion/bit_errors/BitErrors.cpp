@@ -0,0 +1,265 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file BitErrors.cpp
+ * @brief Insert bit errors in the frames according to the C/N margin
+ * @author Viveris Technologies
+ */
+
+
+#include "BitErrors.h"
+#include "OpenSandModelConf.h"
+#include "Data.h"
+
+#include <opensand_output/Output.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+
+const std::string BER_AT_THRESHOLD = "ber_at_threshold";
+const std::string BER_SLOPE = "ber_slope";
+const std::string DROP_CORRUPTED = "drop_corrupted";
+
+/// Below this BER, the frames are forwarded untouched
+constexpr double MIN_BER = 1e-15;
+
+
+std::string BitErrors::config_path = "";
+
+
+static inline uint64_t rotl(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+
+BitErrors::BitErrors():
+	ErrorInsertionPlugin(),
+	ber_at_threshold(1e-7),
+	ber_slope(10),
+	drop_corrupted(false),
+	next_uniform(batch_size)
+{
+	// seed the lanes with splitmix64 as advised by the xoshiro authors
+	uint64_t seed;
+	unsigned int run_seed;
+	if(OpenSandModelConf::Get()->getRandomSeed(run_seed))
+	{
+		seed = run_seed;
+	}
+	else
+	{
+		std::random_device device;
+		seed = (uint64_t(device()) << 32) | device();
+	}
+	for(std::size_t word = 0; word < 4; ++word)
+	{
+		for(std::size_t lane = 0; lane < lanes; ++lane)
+		{
+			uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			this->state[word][lane] = z ^ (z >> 31);
+		}
+	}
+}
+
+
+BitErrors::~BitErrors()
+{
+}
+
+
+void BitErrors::generateConfiguration(const std::string &parent_path,
+                                      const std::string &param_id,
+                                      const std::string &plugin_name)
+{
+	auto Conf = OpenSandModelConf::Get();
+	auto types = Conf->getModelTypesDefinition();
+
+	BitErrors::config_path = parent_path;
+	auto error = Conf->getComponentByPath(parent_path);
+	if(error == nullptr)
+	{
+		return;
+	}
+	auto error_type = error->getParameter(param_id);
+	if(error_type == nullptr)
+	{
+		return;
+	}
+
+	auto ber = error->addParameter(BER_AT_THRESHOLD, "BER at Threshold",
+	                               types->getType("double"),
+	                               "Bit error rate when the C/N equals the QEF threshold of the MODCOD");
+	Conf->setProfileReference(ber, error_type, plugin_name);
+	auto slope = error->addParameter(BER_SLOPE, "BER Slope",
+	                                 types->getType("double"),
+	                                 "Decrease of the bit error rate per dB of margin above the threshold");
+	slope->setUnit("decades / dB");
+	Conf->setProfileReference(slope, error_type, plugin_name);
+	auto drop = error->addParameter(DROP_CORRUPTED, "Drop Corrupted Frames",
+	                                types->getType("bool"),
+	                                "Tag the frames with bit errors as corrupted instead of "
+	                                "forwarding them to the upper layers");
+	Conf->setProfileReference(drop, error_type, plugin_name);
+}
+
+
+bool BitErrors::init()
+{
+	auto error = OpenSandModelConf::Get()->getProfileData(config_path);
+
+	if(!OpenSandModelConf::extractParameterData(error->getParameter(BER_AT_THRESHOLD), this->ber_at_threshold) ||
+	   this->ber_at_threshold <= 0 || this->ber_at_threshold > 0.5)
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "Bit errors insertion: invalid or missing %s",
+		    BER_AT_THRESHOLD.c_str());
+		return false;
+	}
+
+	if(!OpenSandModelConf::extractParameterData(error->getParameter(BER_SLOPE), this->ber_slope) ||
+	   this->ber_slope < 0)
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "Bit errors insertion: invalid or missing %s",
+		    BER_SLOPE.c_str());
+		return false;
+	}
+
+	OpenSandModelConf::extractParameterData(error->getParameter(DROP_CORRUPTED), this->drop_corrupted);
+
+	return true;
+}
+
+
+double BitErrors::getBer(double cn_total, double threshold_qef) const
+{
+	double margin = cn_total - threshold_qef;
+	return std::min(0.5, this->ber_at_threshold * std::pow(10.0, -this->ber_slope * margin));
+}
+
+
+bool BitErrors::isToBeModifiedPacket(double cn_total,
+                                     double threshold_qef)
+{
+	return this->getBer(cn_total, threshold_qef) >= MIN_BER;
+}
+
+
+void BitErrors::areToBeModifiedPackets(const double *cn_totals,
+                                       const double *thresholds_qef,
+                                       bool *to_modify,
+                                       std::size_t count)
+{
+	// compare the margins rather than computing each BER
+	double max_margin = std::log10(this->ber_at_threshold / MIN_BER) / this->ber_slope;
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		to_modify[i] = cn_totals[i] - thresholds_qef[i] <= max_margin;
+	}
+}
+
+
+bool BitErrors::modifyPacket(const Data &)
+{
+	// the bits are flipped in place by modifyPayload
+	return true;
+}
+
+
+bool BitErrors::modifyPayload(unsigned char *payload,
+                              std::size_t length,
+                              double cn_total,
+                              double threshold_qef,
+                              bool &corrupted)
+{
+	double ber = this->getBer(cn_total, threshold_qef);
+	double log_success = std::log1p(-ber);
+	double bits = length * 8.0;
+
+	// the number of correct bits before an error follows a geometric law
+	std::size_t errors = 0;
+	double position = 0;
+	while(true)
+	{
+		position += std::floor(std::log(this->getUniform()) / log_success);
+		if(position >= bits)
+		{
+			break;
+		}
+		std::size_t bit = position;
+		payload[bit >> 3] ^= 0x80 >> (bit & 7);
+		++errors;
+		++position;
+	}
+
+	LOG(this->log_error, LEVEL_DEBUG,
+	    "%zu bit errors inserted in %zu bytes (BER %.3g)",
+	    errors, length, ber);
+	corrupted = this->drop_corrupted && errors > 0;
+	return true;
+}
+
+
+double BitErrors::getUniform()
+{
+	if(this->next_uniform == batch_size)
+	{
+		this->refill();
+	}
+	return this->uniforms[this->next_uniform++];
+}
+
+
+void BitErrors::refill()
+{
+	// the lanes are independent, the inner loops are vectorized
+	for(std::size_t i = 0; i < batch_size; i += lanes)
+	{
+		for(std::size_t lane = 0; lane < lanes; ++lane)
+		{
+			uint64_t result = this->state[0][lane] + this->state[3][lane];
+			uint64_t t = this->state[1][lane] << 17;
+			this->state[2][lane] ^= this->state[0][lane];
+			this->state[3][lane] ^= this->state[1][lane];
+			this->state[1][lane] ^= this->state[2][lane];
+			this->state[0][lane] ^= this->state[3][lane];
+			this->state[2][lane] ^= t;
+			this->state[3][lane] = rotl(this->state[3][lane], 45);
+
+			// the 53 upper bits give a value in (0, 1]
+			this->uniforms[i + lane] = ((result >> 11) + 1) * 0x1.0p-53;
+		}
+	}
+	this->next_uniform = 0;
+}
@@ -0,0 +1,141 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file BitErrors.h
+ * @brief Insert bit errors in the frames according to the C/N margin
+ * @author Viveris Technologies
+ */
+
+#ifndef BIT_ERRORS_ERROR_PLUGIN_H
+#define BIT_ERRORS_ERROR_PLUGIN_H
+
+
+#include "PhysicalLayerPlugin.h"
+
+#include <cstdint>
+#include <string>
+
+
+class Data;
+
+
+/**
+ * @class BitErrors
+ * @brief Flip the bits of the frames with a BER depending on the margin
+ *        between the C/N of the link and the QEF threshold of the MODCOD
+ *
+ * The BER is ber_at_threshold at the threshold and decreases by ber_slope
+ * decades per dB of margin. The positions of the errors are drawn with
+ * geometric jumps between errors so the cost of a frame is proportional
+ * to its number of errors rather than to its length.
+ */
+class BitErrors: public ErrorInsertionPlugin
+{
+public:
+	BitErrors();
+
+	~BitErrors();
+
+	/**
+	 * @brief Generate the configuration for the plugin
+	 */
+	static void generateConfiguration(const std::string &parent_path,
+	                                  const std::string &param_id,
+	                                  const std::string &plugin_name);
+
+	bool init();
+
+	bool modifyPacket(const Data &payload);
+
+	bool isToBeModifiedPacket(double cn_total,
+	                          double threshold_qef);
+
+	void areToBeModifiedPackets(const double *cn_totals,
+	                            const double *thresholds_qef,
+	                            bool *to_modify,
+	                            std::size_t count) override;
+
+	bool modifyPayload(unsigned char *payload,
+	                   std::size_t length,
+	                   double cn_total,
+	                   double threshold_qef,
+	                   bool &corrupted) override;
+
+private:
+	/// The number of interleaved generators, filled in one loop
+	static constexpr std::size_t lanes = 4;
+
+	/// The number of uniform values drawn per refill
+	static constexpr std::size_t batch_size = 64;
+
+	/**
+	 * @brief Compute the bit error rate of a link
+	 *
+	 * @param cn_total       The total C/N of the link
+	 * @param threshold_qef  The minimal C/N of the link
+	 * @return the bit error rate, up to 0.5
+	 */
+	double getBer(double cn_total, double threshold_qef) const;
+
+	/**
+	 * @brief Get a uniform value in (0, 1]
+	 */
+	double getUniform();
+
+	/**
+	 * @brief Draw a batch of uniform values with the xoshiro256+
+	 *        generators of the lanes
+	 */
+	void refill();
+
+	/// The path of the plugin configuration
+	static std::string config_path;
+
+	/// The BER at the QEF threshold
+	double ber_at_threshold;
+
+	/// The BER decrease per dB of margin, in decades
+	double ber_slope;
+
+	/// Whether the frames with errors are tagged as corrupted and dropped
+	bool drop_corrupted;
+
+	/// The xoshiro256+ states, one column per lane
+	uint64_t state[4][lanes];
+
+	/// The uniform values drawn and the next one to use
+	double uniforms[batch_size];
+	std::size_t next_uniform;
+};
+
+
+CREATE(BitErrors, PluginType::Error, "BitErrors");
+
+
+#endif
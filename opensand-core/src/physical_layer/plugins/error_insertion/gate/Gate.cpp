@@ -83,6 +83,18 @@ bool Gate::isToBeModifiedPacket(double cn_total,
 }
 
 
+void Gate::areToBeModifiedPackets(const double *cn_totals,
+                                  const double *thresholds_qef,
+                                  bool *to_modify,
+                                  std::size_t count)
+{
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		to_modify[i] = cn_totals[i] < thresholds_qef[i];
+	}
+}
+
+
 bool Gate::modifyPacket(const Data &)
 {
 	LOG(this->log_error, LEVEL_INFO,
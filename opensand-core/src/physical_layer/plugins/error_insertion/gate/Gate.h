@@ -88,6 +88,11 @@ public:
 	 */
 	bool isToBeModifiedPacket(double cn_total,
 	                          double threshold_qef);
+
+	void areToBeModifiedPackets(const double *cn_totals,
+	                            const double *thresholds_qef,
+	                            bool *to_modify,
+	                            std::size_t count) override;
 };
 
 
@@ -39,11 +39,16 @@
 
 #include <opensand_output/Output.h>
 
+#include <cmath>
+#include <limits>
+
 
 AcmLoop::AcmLoop():
 		MinimalConditionPlugin(),
 		modcod_table_rcs(),
-		modcod_table_s2()
+		modcod_table_s2(),
+		required_es_n0_rcs(),
+		required_es_n0_s2()
 {
 }
 
@@ -116,28 +121,89 @@ bool AcmLoop::init(void)
 		}
 	}
 
+	this->required_es_n0_rcs = AcmLoop::getRequiredEsN0(this->modcod_table_rcs);
+	this->required_es_n0_s2 = AcmLoop::getRequiredEsN0(this->modcod_table_s2);
+
 	return true;
 }
 
 
+std::vector<double> AcmLoop::getRequiredEsN0(const FmtDefinitionTable &table)
+{
+	// one entry per possible MODCOD id carried by the frames
+	std::vector<double> required_es_n0(256, std::numeric_limits<double>::quiet_NaN());
+	for(auto &definition : table.getDefinitions())
+	{
+		if(definition.first < required_es_n0.size())
+		{
+			required_es_n0[definition.first] = definition.second->getRequiredEsN0();
+		}
+	}
+	return required_es_n0;
+}
+
+
 bool AcmLoop::updateThreshold(uint8_t modcod_id, EmulatedMessageType message_type)
 {
-	double threshold = this->minimal_cn; // Default, keep previous threshold
-	switch(message_type)
+	const std::vector<double> &required_es_n0 =
+		message_type == EmulatedMessageType::DvbBurst ? this->required_es_n0_rcs
+		                                              : this->required_es_n0_s2;
+
+	double threshold = std::numeric_limits<double>::quiet_NaN();
+	if(modcod_id < required_es_n0.size())
 	{
-		case EmulatedMessageType::DvbBurst:
-			threshold = double(this->modcod_table_rcs.getRequiredEsN0(modcod_id));
-			LOG(this->log_minimal, LEVEL_DEBUG,
-			    "Required Es/N0 for ACM loop %u --> %.2f dB\n",
-			    modcod_id, this->modcod_table_rcs.getRequiredEsN0(modcod_id));
-			break;
-		default:
-			threshold = double(this->modcod_table_s2.getRequiredEsN0(modcod_id));
-			LOG(this->log_minimal, LEVEL_DEBUG,
-			    "Required Es/N0 for ACM loop %u --> %.2f dB\n",
-			    modcod_id, this->modcod_table_s2.getRequiredEsN0(modcod_id));
+		threshold = required_es_n0[modcod_id];
 	}
+	if(std::isnan(threshold))
+	{
+		// same result as FmtDefinitionTable::getRequiredEsN0
+		LOG(this->log_minimal, LEVEL_ERROR,
+		    "cannot find required Es/N0 for MODCOD %u\n", modcod_id);
+		threshold = 0.0;
+	}
+	LOG(this->log_minimal, LEVEL_DEBUG,
+	    "Required Es/N0 for ACM loop %u --> %.2f dB\n",
+	    modcod_id, threshold);
 
 	this->minimal_cn = threshold;
 	return true;
 }
+
+
+bool AcmLoop::updateThresholds(const uint8_t *modcod_ids,
+                               const EmulatedMessageType *message_types,
+                               double *minimal_cns,
+                               std::size_t count)
+{
+	const double *rcs = this->required_es_n0_rcs.data();
+	const double *s2 = this->required_es_n0_s2.data();
+	bool unknown = false;
+
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		const double *table = message_types[i] == EmulatedMessageType::DvbBurst ? rcs : s2;
+		minimal_cns[i] = table[modcod_ids[i]];
+		unknown |= std::isnan(minimal_cns[i]);
+	}
+
+	if(unknown)
+	{
+		// same result as FmtDefinitionTable::getRequiredEsN0
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			if(std::isnan(minimal_cns[i]))
+			{
+				LOG(this->log_minimal, LEVEL_ERROR,
+				    "cannot find required Es/N0 for MODCOD %u\n",
+				    modcod_ids[i]);
+				minimal_cns[i] = 0.0;
+			}
+		}
+	}
+
+	if(count > 0)
+	{
+		this->minimal_cn = minimal_cns[count - 1];
+	}
+	return true;
+}
@@ -39,6 +39,7 @@
 #include "FmtDefinitionTable.h"
 
 #include <string>
+#include <vector>
 
 
 /**
@@ -51,6 +52,18 @@ private:
 	FmtDefinitionTable modcod_table_rcs;
 	FmtDefinitionTable modcod_table_s2;
 
+	/// The required Es/N0 indexed by MODCOD id, NaN for unknown MODCODs
+	std::vector<double> required_es_n0_rcs;
+	std::vector<double> required_es_n0_s2;
+
+	/**
+	 * @brief Get the required Es/N0 of every MODCOD id of a table
+	 *
+	 * @param table  The MODCOD table
+	 * @return the required Es/N0 indexed by MODCOD id
+	 */
+	static std::vector<double> getRequiredEsN0(const FmtDefinitionTable &table);
+
 public:
 	/**
 	 * @brief Build the defaultMinimalCondition
@@ -83,6 +96,11 @@ public:
 	 * @return true on success, false otherwise
 	 */
 	bool updateThreshold(uint8_t modcod_id, EmulatedMessageType message_type);
+
+	bool updateThresholds(const uint8_t *modcod_ids,
+	                      const EmulatedMessageType *message_types,
+	                      double *minimal_cns,
+	                      std::size_t count) override;
 };
 
 
@@ -0,0 +1,389 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file EphemerisDelay.cpp
+ * @brief Propagation delay of the links to a LEO satellite on a
+ *        circular orbit
+ * @author Viveris Technologies
+ */
+
+
+#include "EphemerisDelay.h"
+#include "OpenSandModelConf.h"
+
+#include <opensand_output/Output.h>
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+
+const std::string MEAN_MOTION = "orbit_mean_motion";
+const std::string INCLINATION = "orbit_inclination";
+const std::string ASCENDING_NODE = "orbit_ascending_node";
+const std::string MEAN_ANOMALY = "orbit_mean_anomaly";
+const std::string REFRESH_PERIOD = "orbit_refresh_period";
+const std::string STATIONS = "ground_stations";
+
+/// The Earth gravitational parameter (km3/s2)
+constexpr double EARTH_MU = 398600.4418;
+/// The Earth mean radius (km), the Earth is considered spherical
+constexpr double EARTH_RADIUS = 6371.0;
+/// The Earth rotation rate (rad/s)
+constexpr double EARTH_ROTATION = 7.2921159e-5;
+/// The speed of light (km/ms)
+constexpr double LIGHT_SPEED = 299.792458;
+
+constexpr double DEG_TO_RAD = M_PI / 180.0;
+
+
+/**
+ * @class OrbitLinks
+ * @brief The distances between the ground stations and the satellite,
+ *        computed for all the stations at once for each refresh period
+ */
+class OrbitLinks
+{
+public:
+	OrbitLinks(double mean_motion,
+	           double inclination,
+	           double ascending_node,
+	           double mean_anomaly,
+	           time_ms_t refresh_period_ms):
+		refresh_period_ms{refresh_period_ms},
+		start_time{getCurrentTime()},
+		angular_rate{mean_motion * 2 * M_PI / 86400},
+		radius{std::cbrt(EARTH_MU / (angular_rate * angular_rate))},
+		cos_inclination{std::cos(inclination * DEG_TO_RAD)},
+		sin_inclination{std::sin(inclination * DEG_TO_RAD)},
+		ascending_node{ascending_node * DEG_TO_RAD},
+		mean_anomaly{mean_anomaly * DEG_TO_RAD},
+		period{-1}
+	{
+	};
+
+	/**
+	 * @brief Add a ground station on the spherical Earth
+	 *
+	 * @param id         The station entity id
+	 * @param latitude   The station latitude (deg)
+	 * @param longitude  The station longitude (deg)
+	 * @param altitude   The station altitude (m)
+	 */
+	void addStation(tal_id_t id, double latitude, double longitude, double altitude)
+	{
+		double distance = EARTH_RADIUS + altitude / 1000;
+		this->ids.push_back(id);
+		this->x.push_back(distance * std::cos(latitude * DEG_TO_RAD) * std::cos(longitude * DEG_TO_RAD));
+		this->y.push_back(distance * std::cos(latitude * DEG_TO_RAD) * std::sin(longitude * DEG_TO_RAD));
+		this->z.push_back(distance * std::sin(latitude * DEG_TO_RAD));
+		this->delays.push_back(0);
+	};
+
+	/**
+	 * @brief Find the index of a ground station
+	 *
+	 * @param id     The station entity id
+	 * @param index  OUT: the station index
+	 * @return true if the station is known, false otherwise
+	 */
+	bool findStation(tal_id_t id, std::size_t &index) const
+	{
+		for(index = 0; index < this->ids.size(); ++index)
+		{
+			if(this->ids[index] == id)
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+
+	/**
+	 * @brief Get the current delay of the link of a station, the links
+	 *        of all the stations are evaluated on a new refresh period
+	 *
+	 * @param index  The station index
+	 * @return the one way delay (ms)
+	 */
+	double getDelay(std::size_t index)
+	{
+		std::lock_guard<std::mutex> lock{this->mutex};
+		long period = (getCurrentTime() - this->start_time) / this->refresh_period_ms;
+		if(period != this->period)
+		{
+			this->evaluate(period * this->refresh_period_ms / 1000.0);
+			this->period = period;
+		}
+		return this->delays[index];
+	};
+
+	/**
+	 * @brief Get an upper bound of the delays, the satellite being
+	 *        on the other side of the Earth
+	 *
+	 * @return the maximum delay (ms)
+	 */
+	double getMaxDelay() const
+	{
+		double highest = 0;
+		for(std::size_t i = 0; i < this->ids.size(); ++i)
+		{
+			highest = std::max(highest, std::sqrt(this->x[i] * this->x[i] +
+			                                      this->y[i] * this->y[i] +
+			                                      this->z[i] * this->z[i]));
+		}
+		return (this->radius + highest) / LIGHT_SPEED;
+	};
+
+private:
+	/**
+	 * @brief Compute the delays of all the stations
+	 *
+	 * @param time  The time since the emulation start (s)
+	 */
+	void evaluate(double time)
+	{
+		// position on the orbit, in the inertial frame matching the
+		// Earth fixed frame at the emulation start
+		double argument = this->mean_anomaly + this->angular_rate * time;
+		double cos_argument = std::cos(argument);
+		double sin_argument = std::sin(argument);
+		double cos_node = std::cos(this->ascending_node);
+		double sin_node = std::sin(this->ascending_node);
+		double inertial_x = this->radius * (cos_node * cos_argument - sin_node * sin_argument * this->cos_inclination);
+		double inertial_y = this->radius * (sin_node * cos_argument + cos_node * sin_argument * this->cos_inclination);
+		double sat_z = this->radius * sin_argument * this->sin_inclination;
+
+		// rotate in the Earth fixed frame
+		double rotation = EARTH_ROTATION * time;
+		double sat_x = inertial_x * std::cos(rotation) + inertial_y * std::sin(rotation);
+		double sat_y = inertial_y * std::cos(rotation) - inertial_x * std::sin(rotation);
+
+		// the stations are stored by coordinate for the loop to be vectorized
+		std::size_t count = this->ids.size();
+		const double *x = this->x.data();
+		const double *y = this->y.data();
+		const double *z = this->z.data();
+		double *delays = this->delays.data();
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			double dx = sat_x - x[i];
+			double dy = sat_y - y[i];
+			double dz = sat_z - z[i];
+			delays[i] = std::sqrt(dx * dx + dy * dy + dz * dz) / LIGHT_SPEED;
+		}
+	};
+
+	std::mutex mutex;
+
+	/// The refresh period of the delays (ms)
+	time_ms_t refresh_period_ms;
+
+	/// The emulation start (ms)
+	clock_t start_time;
+
+	/// The orbit mean motion (rad/s) and radius (km)
+	double angular_rate;
+	double radius;
+
+	/// The orbit orientation (rad)
+	double cos_inclination;
+	double sin_inclination;
+	double ascending_node;
+	double mean_anomaly;
+
+	/// The stations ids and Earth fixed positions (km), by coordinate
+	std::vector<tal_id_t> ids;
+	std::vector<double> x;
+	std::vector<double> y;
+	std::vector<double> z;
+
+	/// The delays of the stations for the last refresh period evaluated (ms)
+	std::vector<double> delays;
+	long period;
+};
+
+
+/// The links shared by the plugins of the process
+static std::weak_ptr<OrbitLinks> shared_links;
+static std::mutex shared_links_mutex;
+
+
+std::string EphemerisDelay::config_path = "";
+
+
+EphemerisDelay::EphemerisDelay():
+	SatDelayPlugin(),
+	links(),
+	station(0)
+{
+}
+
+
+EphemerisDelay::~EphemerisDelay()
+{
+}
+
+
+void EphemerisDelay::generateConfiguration(const std::string &parent_path,
+                                           const std::string &param_id,
+                                           const std::string &plugin_name)
+{
+	auto Conf = OpenSandModelConf::Get();
+	auto types = Conf->getModelTypesDefinition();
+
+	EphemerisDelay::config_path = parent_path;
+	auto delay = Conf->getComponentByPath(parent_path);
+	if(delay == nullptr)
+	{
+		return;
+	}
+	auto delay_type = delay->getParameter(param_id);
+	if(delay_type == nullptr)
+	{
+		return;
+	}
+
+	auto mean_motion = delay->addParameter(MEAN_MOTION, "Mean Motion", types->getType("double"),
+	                                       "Revolutions of the satellite per day, as in a TLE");
+	mean_motion->setUnit("rev/day");
+	Conf->setProfileReference(mean_motion, delay_type, plugin_name);
+	auto inclination = delay->addParameter(INCLINATION, "Inclination", types->getType("double"));
+	inclination->setUnit("deg");
+	Conf->setProfileReference(inclination, delay_type, plugin_name);
+	auto node = delay->addParameter(ASCENDING_NODE, "Ascending Node Longitude", types->getType("double"),
+	                                "Longitude of the ascending node at the emulation start");
+	node->setUnit("deg");
+	Conf->setProfileReference(node, delay_type, plugin_name);
+	auto anomaly = delay->addParameter(MEAN_ANOMALY, "Mean Anomaly", types->getType("double"),
+	                                   "Position of the satellite on its orbit at the emulation start");
+	anomaly->setUnit("deg");
+	Conf->setProfileReference(anomaly, delay_type, plugin_name);
+	auto refresh_period = delay->addParameter(REFRESH_PERIOD, "Refresh Period", types->getType("int"));
+	refresh_period->setUnit("ms");
+	Conf->setProfileReference(refresh_period, delay_type, plugin_name);
+
+	auto stations = delay->addList(STATIONS, "Ground Stations", "ground_station",
+	                               "Positions of the terminals and gateways of the spot");
+	Conf->setProfileReference(stations, delay_type, plugin_name);
+	auto station = stations->getPattern();
+	station->addParameter("entity_id", "Entity ID", types->getType("int"));
+	station->addParameter("latitude", "Latitude", types->getType("double"))->setUnit("deg");
+	station->addParameter("longitude", "Longitude", types->getType("double"))->setUnit("deg");
+	station->addParameter("altitude", "Altitude", types->getType("double"))->setUnit("m");
+}
+
+
+bool EphemerisDelay::init()
+{
+	auto delay = OpenSandModelConf::Get()->getProfileData(config_path);
+
+	int refresh_period_ms;
+	if(!OpenSandModelConf::extractParameterData(delay->getParameter(REFRESH_PERIOD), refresh_period_ms) ||
+	   refresh_period_ms <= 0)
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "Ephemeris delay: cannot get %s", REFRESH_PERIOD.c_str());
+		return false;
+	}
+	this->refresh_period_ms = refresh_period_ms;
+
+	std::lock_guard<std::mutex> lock{shared_links_mutex};
+	this->links = shared_links.lock();
+	if(this->links == nullptr)
+	{
+		double mean_motion, inclination, node, anomaly;
+		if(!OpenSandModelConf::extractParameterData(delay->getParameter(MEAN_MOTION), mean_motion) ||
+		   !OpenSandModelConf::extractParameterData(delay->getParameter(INCLINATION), inclination) ||
+		   !OpenSandModelConf::extractParameterData(delay->getParameter(ASCENDING_NODE), node) ||
+		   !OpenSandModelConf::extractParameterData(delay->getParameter(MEAN_ANOMALY), anomaly) ||
+		   mean_motion <= 0)
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "Ephemeris delay: missing or invalid orbital elements");
+			return false;
+		}
+		this->links = std::make_shared<OrbitLinks>(mean_motion, inclination, node, anomaly,
+		                                           this->refresh_period_ms);
+
+		for(auto& item : delay->getList(STATIONS)->getItems())
+		{
+			auto station = std::dynamic_pointer_cast<OpenSANDConf::DataComponent>(item);
+			int id;
+			double latitude, longitude, altitude;
+			if(!OpenSandModelConf::extractParameterData(station, "entity_id", id) ||
+			   !OpenSandModelConf::extractParameterData(station, "latitude", latitude) ||
+			   !OpenSandModelConf::extractParameterData(station, "longitude", longitude) ||
+			   !OpenSandModelConf::extractParameterData(station, "altitude", altitude))
+			{
+				LOG(this->log_init, LEVEL_ERROR,
+				    "Ephemeris delay: invalid ground station");
+				return false;
+			}
+			this->links->addStation(id, latitude, longitude, altitude);
+		}
+		shared_links = this->links;
+	}
+
+	if(!this->links->findStation(this->entity_id, this->station))
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "Ephemeris delay: no ground station for entity %u",
+		    this->entity_id);
+		return false;
+	}
+
+	return this->updateSatDelay();
+}
+
+
+bool EphemerisDelay::updateSatDelay()
+{
+	time_ms_t delay = std::lround(this->links->getDelay(this->station));
+
+	LOG(this->log_delay, LEVEL_DEBUG,
+	    "new delay value: %u\n", delay);
+
+	this->setSatDelay(delay);
+	return true;
+}
+
+
+bool EphemerisDelay::getMaxDelay(time_ms_t &delay) const
+{
+	if(this->links == nullptr)
+	{
+		return false;
+	}
+
+	delay = std::ceil(this->links->getMaxDelay());
+	return true;
+}
@@ -0,0 +1,95 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file EphemerisDelay.h
+ * @brief Propagation delay of the links to a LEO satellite on a
+ *        circular orbit
+ * @author Viveris Technologies
+ */
+
+#ifndef EPHEMERIS_SATDELAY_PLUGIN_H
+#define EPHEMERIS_SATDELAY_PLUGIN_H
+
+
+#include "OpenSandCore.h"
+#include "PhysicalLayerPlugin.h"
+
+#include <memory>
+#include <string>
+
+
+class OrbitLinks;
+
+
+/**
+ * @class EphemerisDelay
+ * @brief The delay of the link between a ground station and a satellite
+ *        whose position is computed from its orbital elements
+ *
+ * The orbit is described by the elements of a TLE for a circular orbit
+ * (mean motion, inclination, ascending node and mean anomaly at the
+ * emulation start). The links of all the ground stations listed in the
+ * configuration are evaluated together once per refresh period and
+ * shared by the plugins of the process.
+ */
+class EphemerisDelay: public SatDelayPlugin
+{
+private:
+	static std::string config_path;
+
+	/// The links of the ground stations to the satellite
+	std::shared_ptr<OrbitLinks> links;
+
+	/// The index of the ground station of the entity in the links
+	std::size_t station;
+
+public:
+	EphemerisDelay();
+
+	~EphemerisDelay();
+
+	/**
+	 * @brief Generate the configuration for the plugin
+	 */
+	static void generateConfiguration(const std::string &parent_path,
+	                                  const std::string &param_id,
+	                                  const std::string &plugin_name);
+
+	bool init();
+
+	bool updateSatDelay();
+
+	bool getMaxDelay(time_ms_t &delay) const;
+};
+
+
+CREATE(EphemerisDelay, PluginType::SatDelay, "EphemerisDelay");
+
+
+#endif
@@ -37,9 +37,9 @@
 
 #include "OpenSandCore.h"
 #include "PhysicalLayerPlugin.h"
+#include "TimeSeries.h"
 
 #include <string>
-#include <map>
 
 
 /**
@@ -57,13 +57,14 @@ private:
 	unsigned int current_time;
 
 	/// The satdelay values we will interpolate
-	std::map<unsigned int, time_ms_t> delays;
+	TimeSeries delays;
 
 	/// Reading mode
 	bool loop;
 
 	/**
-	 * @brief Load the sat delay file
+	 * @brief Load the sat delay file, text or converted by
+	 *        opensand_convert_trace
 	 *
 	 * @param filename  The sat delay file name
 	 * @return true on success, false otherwise
@@ -0,0 +1,257 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file bench_delay_fifo.cpp
+ * @brief Measure the push and pop times of the delay fifo with the
+ *        delays of a satellite delay plugin
+ * @author Viveris Technologies
+ *
+ * The packets of a channel are pushed at a constant rate with the delay
+ * of the channel, in milliseconds like the ground physical channel does,
+ * and popped when their tick out is reached. The delay changes every
+ * period by a random step, as the FileDelay plugin does when it reads a
+ * new line of its file: a decrease makes the next packets leave before
+ * the ones already queued. The fifo is compared to a tree of the
+ * elements sorted by tick out.
+ */
+
+
+#include "DelayFifo.h"
+#include "FifoElement.h"
+#include "OpenSandCore.h"
+#include "NetContainer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+
+/// The program usage
+#define USAGE \
+"Delay fifo benchmark: measure the push and pop times with varying delays\n\n\
+usage: bench_delay_fifo [-h] [-r rate] [-d delay] [-j jitter] [-p period] [-t duration]\n\
+\t-h           print this usage and exit\n\
+\t-r rate      the packets pushed per millisecond (default: 20)\n\
+\t-d delay     the mean delay in milliseconds (default: 270)\n\
+\t-j jitter    the maximal delay step in milliseconds (default: 20)\n\
+\t-p period    the milliseconds between two delay changes (default: 100)\n\
+\t-t duration  the emulated duration in seconds (default: 60)\n\n"
+
+
+using bench_clock = std::chrono::steady_clock;
+
+
+/// The benchmark parameters
+struct bench_params_t
+{
+	unsigned int rate = 20;
+	unsigned int delay = 270;
+	unsigned int jitter = 20;
+	unsigned int period = 100;
+	unsigned int duration = 60;
+};
+
+
+/**
+ * @brief The delay fifo
+ */
+struct DelayFifoQueue
+{
+	DelayFifo fifo{std::numeric_limits<vol_pkt_t>::max()};
+
+	bool push(FifoElement *elem)
+	{
+		return this->fifo.push(elem);
+	}
+
+	FifoElement *pop(time_t current_time)
+	{
+		if(this->fifo.getCurrentSize() == 0 || this->fifo.getTickOut() > current_time)
+		{
+			return nullptr;
+		}
+		return this->fifo.pop();
+	}
+};
+
+
+/**
+ * @brief A tree of the elements sorted by tick out
+ */
+struct TreeQueue
+{
+	std::multimap<time_t, FifoElement *> tree;
+
+	bool push(FifoElement *elem)
+	{
+		this->tree.emplace_hint(this->tree.end(), elem->getTickOut(), elem);
+		return true;
+	}
+
+	FifoElement *pop(time_t current_time)
+	{
+		auto head = this->tree.begin();
+		if(head == this->tree.end() || head->first > current_time)
+		{
+			return nullptr;
+		}
+		FifoElement *elem = head->second;
+		this->tree.erase(head);
+		return elem;
+	}
+};
+
+
+/**
+ * @brief Emulate a channel and measure the time spent in a queue
+ *
+ * @param name    The queue name
+ * @param params  The benchmark parameters
+ * @return the number of packets pushed before a queued one
+ */
+template<class Queue>
+static uint64_t bench(const char *name, const bench_params_t &params)
+{
+	Queue queue;
+	std::mt19937 generator{params.delay};
+	std::uniform_int_distribution<int> step_distribution(-(int)params.jitter, params.jitter);
+	time_t delay = params.delay;
+	time_t last_tick_out = 0;
+	uint64_t packets = 0;
+	uint64_t reordered = 0;
+	std::size_t max_queued = 0;
+	std::size_t queued = 0;
+	std::chrono::nanoseconds push_time{0};
+	std::chrono::nanoseconds pop_time{0};
+
+	for(time_t now = 0; now < (time_t)params.duration * 1000; ++now)
+	{
+		if(params.period > 0 && now % params.period == 0)
+		{
+			// the delay stays around the mean one
+			delay += step_distribution(generator);
+			delay = std::max<time_t>(delay, params.delay - 5 * params.jitter);
+			delay = std::min<time_t>(delay, params.delay + 5 * params.jitter);
+		}
+
+		// the elements are allocated out of the measure
+		std::vector<FifoElement *> elements;
+		for(unsigned int index = 0; index < params.rate; ++index)
+		{
+			elements.push_back(new FifoElement(nullptr, now, now + delay));
+		}
+		if(now + delay < last_tick_out)
+		{
+			reordered += params.rate;
+		}
+		last_tick_out = now + delay;
+
+		auto start = bench_clock::now();
+		for(auto &&elem: elements)
+		{
+			queue.push(elem);
+		}
+		auto pushed = bench_clock::now();
+		elements.clear();
+		FifoElement *elem;
+		while((elem = queue.pop(now)) != nullptr)
+		{
+			elements.push_back(elem);
+		}
+		pop_time += bench_clock::now() - pushed;
+		push_time += pushed - start;
+
+		queued += params.rate - elements.size();
+		max_queued = std::max(max_queued, queued);
+		packets += params.rate;
+		for(auto &&popped: elements)
+		{
+			delete popped;
+		}
+	}
+
+	printf("%-10s %10lu packets, %8zu queued at most, "
+	       "push %7.1f ns, pop %7.1f ns\n",
+	       name, packets, max_queued,
+	       (double)push_time.count() / packets,
+	       (double)pop_time.count() / packets);
+	return reordered;
+}
+
+
+int main(int argc, char **argv)
+{
+	bench_params_t params;
+	int opt;
+
+	while((opt = getopt(argc, argv, "hr:d:j:p:t:")) != -1)
+	{
+		switch(opt)
+		{
+			case 'r':
+				params.rate = atoi(optarg);
+				break;
+			case 'd':
+				params.delay = atoi(optarg);
+				break;
+			case 'j':
+				params.jitter = atoi(optarg);
+				break;
+			case 'p':
+				params.period = atoi(optarg);
+				break;
+			case 't':
+				params.duration = atoi(optarg);
+				break;
+			case 'h':
+			default:
+				fprintf(stderr, USAGE);
+				return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	// the delay fifo holds up to 65535 packets
+	if(params.rate * (params.delay + 5 * params.jitter) >= std::numeric_limits<vol_pkt_t>::max())
+	{
+		fprintf(stderr, "too many packets in flight for the delay fifo\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("%u packets per ms, delay %u ms, steps up to %u ms every %u ms\n",
+	       params.rate, params.delay, params.jitter, params.period);
+	uint64_t reordered = bench<DelayFifoQueue>("DelayFifo", params);
+	bench<TreeQueue>("tree", params);
+	printf("%lu packets pushed before queued ones\n", reordered);
+	return EXIT_SUCCESS;
+}
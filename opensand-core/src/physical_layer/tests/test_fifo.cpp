@@ -35,43 +35,118 @@
  */
 
 
-#include <opensand_rt/Rt.h>
-
 #include "DelayFifo.h"
 #include "FifoElement.h"
 #include "OpenSandCore.h"
 #include "NetContainer.h"
-#include <stdlib.h>
-#include <string.h>
-#include <signal.h>
-#include <sched.h>
-#include <unistd.h>
 
-time_ms_t elem_times[5] = {0, 10, 20, 30, 40};
+#include <stdio.h>
+#include <vector>
+
+
+/**
+ * @brief Pop the elements whose tick out are reached and check that they
+ *        are the expected ones, identified by their tick in, in order
+ *
+ * @param fifo          The fifo
+ * @param current_time  The current time
+ * @param expected      The tick in of the expected elements
+ * @return true if the expected elements were popped, false otherwise
+ */
+static bool expire(DelayFifo &fifo, time_t current_time,
+                   const std::vector<time_t> &expected)
+{
+	std::vector<time_t> popped;
+	while(fifo.getCurrentSize() > 0 && fifo.getTickOut() <= current_time)
+	{
+		FifoElement *elem = fifo.pop();
+		popped.push_back(elem->getTickIn());
+		delete elem;
+	}
+
+	if(popped != expected)
+	{
+		fprintf(stderr, "at %ld: %zu elements expired instead of %zu:",
+		        current_time, popped.size(), expected.size());
+		for(time_t tick_in: popped)
+		{
+			fprintf(stderr, " %ld", tick_in);
+		}
+		fprintf(stderr, "\n");
+		return false;
+	}
+	return true;
+}
+
+static bool push(DelayFifo &fifo, time_t tick_in, time_t tick_out)
+{
+	FifoElement *elem = new FifoElement(nullptr, tick_in, tick_out);
+	if(!fifo.push(elem))
+	{
+		delete elem;
+		return false;
+	}
+	return true;
+}
 
 int main()
 {
-	int is_failure = 1;
-	time_ms_t current_time;
-	DelayFifo *fifo = new DelayFifo(1000);
+	DelayFifo fifo(8);
 
-	// Add elements to fifo
-	current_time = getCurrentTime();
+	// the elements are identified by their tick in; with a constant
+	// delay they are appended, a delay drop sends them earlier
+	if(!push(fifo, 1, 101) || !push(fifo, 2, 102) || !push(fifo, 3, 150) ||
+	   !push(fifo, 4, 104) || !push(fifo, 5, 103) || !push(fifo, 6, 50) ||
+	   // the same tick out as elements 4 and 3, they leave after them
+	   !push(fifo, 7, 104) || !push(fifo, 8, 150))
+	{
+		fprintf(stderr, "cannot push the elements\n");
+		return 1;
+	}
 
-	for(unsigned int i=0; i < sizeof(elem_times); i++)
+	// the fifo is full
+	if(push(fifo, 9, 200) || fifo.getCurrentSize() != 8)
 	{
-		FifoElement *elem = new FifoElement(nullptr, current_time, current_time + elem_times[i]);
-		fifo->push(elem);
+		fprintf(stderr, "an element was pushed in the full fifo\n");
+		return 1;
 	}
 
-	// everything went fine, so report success
-	is_failure = 0;
+	if(fifo.getTickOut() != 50)
+	{
+		fprintf(stderr, "the head tick out is %ld instead of 50\n",
+		        fifo.getTickOut());
+		return 1;
+	}
 
-	while(fifo->getCurrentSize() > 0)
+	if(!expire(fifo, 49, {}) ||
+	   !expire(fifo, 101, {6, 1}) ||
+	   !expire(fifo, 103, {2, 5}))
 	{
-		FifoElement *elem = fifo->pop();
-		delete elem;
+		return 1;
 	}
-	delete fifo;
-	return is_failure;
+
+	// a replaced fragment goes before the others whatever its tick out,
+	// and an element pushed back after them
+	if(!push(fifo, 10, 104) || !fifo.pushFront(new FifoElement(nullptr, 11, 200)) ||
+	   !fifo.pushBack(new FifoElement(nullptr, 12, 120)))
+	{
+		fprintf(stderr, "cannot push the elements\n");
+		return 1;
+	}
+
+	// the head blocks the elements behind it until it expires
+	if(!expire(fifo, 199, {}) ||
+	   !expire(fifo, 200, {11, 4, 7, 10, 3, 8, 12}))
+	{
+		return 1;
+	}
+
+	if(fifo.getCurrentSize() != 0 || fifo.pop() != nullptr || fifo.getTickOut() != 0)
+	{
+		fprintf(stderr, "the fifo is not empty\n");
+		return 1;
+	}
+
+	printf("delay fifo ordering and expiry checked\n");
+	return 0;
 }
@@ -57,8 +57,14 @@ bool BlockSatAsymetricHandler::onInit()
 
 BlockSatAsymetricHandler::Upward::Upward(const std::string& name, AsymetricConfig specific):
 	RtUpwardDemux<bool>{name},
-	split_traffic{specific.is_transparent}
+	carrier_directions{}
 {
+	// the data of a transparent satellite are split from the DVB stack
+	for(std::size_t carrier_id = 0; carrier_id < this->carrier_directions.size(); ++carrier_id)
+	{
+		this->carrier_directions[carrier_id] = specific.is_transparent &&
+		                                       isDataCarrier(extractCarrierType(carrier_id));
+	}
 }
 
 
@@ -73,9 +79,8 @@ bool BlockSatAsymetricHandler::Upward::onEvent(const RtEvent *const event)
 
 	auto msg_event = static_cast<const MessageEvent *>(event);
 	auto frame = static_cast<DvbFrame *>(msg_event->getData());
-	const bool is_data = isDataCarrier(extractCarrierType(frame->getCarrierId()));
 
-	if (!this->enqueueMessage(split_traffic && is_data,
+	if (!this->enqueueMessage(this->carrier_directions[frame->getCarrierId()],
 	                          (void**)&frame,
 	                          msg_event->getLength(),
 	                          msg_event->getMessageType()))
@@ -92,14 +97,27 @@ bool BlockSatAsymetricHandler::Upward::onEvent(const RtEvent *const event)
 BlockSatAsymetricHandler::Downward::Downward(const std::string& name, AsymetricConfig specific):
 	GroundPhysicalChannel{specific.phy_config},
 	RtDownwardMux{name},
-	is_regenerated_traffic{!specific.is_transparent}
+	cn_carriers{},
+	current_cn{0}
 {
+	// the control frames and the regenerated traffic are received on
+	// the satellite, the transparent data go through unchanged
+	for(std::size_t carrier_id = 0; carrier_id < this->cn_carriers.size(); ++carrier_id)
+	{
+		this->cn_carriers[carrier_id] = !specific.is_transparent ||
+		                                isControlCarrier(extractCarrierType(carrier_id));
+	}
 }
 
 
 bool BlockSatAsymetricHandler::Downward::onInit()
 {
-	return this->initGround(false, this, this->log_init);
+	if(!this->initGround(false, this, this->log_init))
+	{
+		return false;
+	}
+	this->current_cn = this->getCurrentCn();
+	return true;
 }
 
 
@@ -113,10 +131,9 @@ bool BlockSatAsymetricHandler::Downward::onEvent(const RtEvent *const event)
 
 				auto msg_event = static_cast<const MessageEvent *>(event);
 				auto frame = static_cast<DvbFrame *>(msg_event->getData());
-				const bool is_control = isControlCarrier(extractCarrierType(frame->getCarrierId()));
-				if ((is_control || this->is_regenerated_traffic) && IsCnCapableFrame(frame->getMessageType()))
+				if (this->cn_carriers[frame->getCarrierId()] && IsCnCapableFrame(frame->getMessageType()))
 				{
-					frame->setCn(this->getCurrentCn());
+					frame->setCn(this->current_cn);
 				}
 				return this->forwardPacket(frame);
 			}
@@ -127,7 +144,12 @@ bool BlockSatAsymetricHandler::Downward::onEvent(const RtEvent *const event)
 				{
 					LOG(this->log_event, LEVEL_DEBUG,
 					    "Attenuation update timer expired");
-					return this->updateAttenuation();
+					if (!this->updateAttenuation())
+					{
+						return false;
+					}
+					this->current_cn = this->getCurrentCn();
+					return true;
 				}
 				if (*event != this->fifo_timer)
 				{
@@ -38,6 +38,9 @@
 #define BLOCK_SAT_ASYMETRIC_HANDLER
 
 
+#include <array>
+#include <cstdint>
+
 #include <opensand_rt/Rt.h>
 #include <opensand_rt/RtChannelMux.h>
 #include <opensand_rt/RtChannelDemux.h>
@@ -67,7 +70,9 @@ public:
 	private:
 		bool onEvent(const RtEvent *const event) override;
 
-		bool split_traffic;
+		/// The direction of the frames of each carrier id: true for
+		/// the split traffic, false for the DVB stack
+		std::array<bool, UINT8_MAX + 1> carrier_directions;
 	};
 
 	class Downward : public GroundPhysicalChannel, public RtDownwardMux
@@ -81,7 +86,12 @@ public:
 		bool onEvent(const RtEvent *const event) override;
 		bool forwardPacket(DvbFrame *frame) override;
 
-		bool is_regenerated_traffic;
+		/// Whether the frames of each carrier id carry the C/N of the
+		/// link, the others pass through untouched
+		std::array<bool, UINT8_MAX + 1> cn_carriers;
+
+		/// The C/N of the link, refreshed with the attenuation
+		double current_cn;
 	};
 };
 
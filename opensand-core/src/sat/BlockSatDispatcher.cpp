@@ -33,6 +33,8 @@
  */
 
 
+#include <algorithm>
+#include <set>
 #include <tuple>
 
 #include "BlockSatDispatcher.h"
@@ -45,34 +47,109 @@ constexpr uint8_t DATA_IN_GW_ID = 8;
 constexpr uint8_t CTRL_IN_GW_ID = 4;
 
 
-BlockSatDispatcher::SpotByEntity::SpotByEntity():
-	spot_by_entity{},
+BlockSatDispatcher::RoutingTable::RoutingTable():
+	routes(route_count, Route{0, RegenLevel::Unknown, false}),
+	destinations{},
+	spot_by_entity(entity_count, 0),
+	has_spot(entity_count, false),
+	entity_types(entity_count, Component::unknown),
 	default_spot{0}
 {
 	OpenSandModelConf::Get()->getDefaultSpotId(default_spot);
 }
 
 
-void BlockSatDispatcher::SpotByEntity::addEntityInSpot(tal_id_t entity, spot_id_t spot)
+void BlockSatDispatcher::RoutingTable::addRoute(spot_id_t spot, Component dest,
+                                                tal_id_t sat_id, RegenLevel regen_level)
+{
+	Route &route = routes[getRouteIndex(spot, dest)];
+	if (!route.is_set)
+	{
+		destinations.push_back({spot, dest});
+	}
+	route = Route{sat_id, regen_level, true};
+}
+
+
+void BlockSatDispatcher::RoutingTable::addEntityInSpot(tal_id_t entity, spot_id_t spot)
 {
 	spot_by_entity[entity] = spot;
+	has_spot[entity] = true;
 }
 
 
-void BlockSatDispatcher::SpotByEntity::setDefaultSpot(spot_id_t spot)
+void BlockSatDispatcher::RoutingTable::setDefaultSpot(spot_id_t spot)
 {
 	default_spot = spot;
 }
 
 
-spot_id_t BlockSatDispatcher::SpotByEntity::getSpotForEntity(tal_id_t entity) const
+void BlockSatDispatcher::RoutingTable::setEntityTypes()
+{
+	const auto conf = OpenSandModelConf::Get();
+	for (std::size_t entity = 0; entity < entity_count; ++entity)
+	{
+		entity_types[entity] = conf->getEntityType(entity);
+	}
+}
+
+
+std::size_t BlockSatDispatcher::RoutingTable::getRouteIndex(spot_id_t spot, Component dest)
+{
+	return 2 * spot + (dest == Component::terminal ? 1 : 0);
+}
+
+
+const BlockSatDispatcher::Route *BlockSatDispatcher::RoutingTable::getRoute(spot_id_t spot,
+                                                                           Component dest) const
+{
+	if (dest != Component::gateway && dest != Component::terminal)
+	{
+		return nullptr;
+	}
+	return getRoute(getRouteIndex(spot, dest));
+}
+
+
+const BlockSatDispatcher::Route *BlockSatDispatcher::RoutingTable::getRoute(std::size_t route_index) const
+{
+	const Route &route = routes[route_index];
+	return route.is_set ? &route : nullptr;
+}
+
+
+spot_id_t BlockSatDispatcher::RoutingTable::getSpotForEntity(tal_id_t entity) const
+{
+	return has_spot[entity] ? spot_by_entity[entity] : default_spot;
+}
+
+
+Component BlockSatDispatcher::RoutingTable::getEntityType(tal_id_t entity) const
+{
+	return entity_types[entity];
+}
+
+
+bool BlockSatDispatcher::RoutingTable::getRouteFromSource(tal_id_t src_id, std::size_t &route_index) const
 {
-	auto found_spot = spot_by_entity.find(entity);
-	if (found_spot == spot_by_entity.end())
+	switch (entity_types[src_id])
 	{
-		return default_spot;
+		case Component::gateway:
+			route_index = getRouteIndex(getSpotForEntity(src_id), Component::terminal);
+			return true;
+		case Component::terminal:
+			route_index = getRouteIndex(getSpotForEntity(src_id), Component::gateway);
+			return true;
+		default:
+			route_index = route_count;
+			return false;
 	}
-	return found_spot->second;
+}
+
+
+const std::vector<SpotComponentPair> &BlockSatDispatcher::RoutingTable::getDestinations() const
+{
+	return destinations;
 }
 
 
@@ -87,28 +164,22 @@ BlockSatDispatcher::BlockSatDispatcher(const std::string &name, SatDispatcherCon
 bool BlockSatDispatcher::onInit()
 {
 	const auto conf = OpenSandModelConf::Get();
-	auto downward = dynamic_cast<Downward *>(this->downward);
-	auto upward = dynamic_cast<Upward *>(this->upward);
 
-	SpotByEntity spot_by_entity;
-	std::unordered_map<SpotComponentPair, tal_id_t> routes;
-	std::unordered_map<SpotComponentPair, RegenLevel> regen_levels;
+	auto routing = std::make_shared<RoutingTable>();
+	routing->setEntityTypes();
 
 	for (auto &&spot: conf->getSpotsTopology())
 	{
 		const SpotTopology &topo = spot.second;
 
-		spot_by_entity.addEntityInSpot(topo.gw_id, topo.spot_id);
+		routing->addEntityInSpot(topo.gw_id, topo.spot_id);
 		for (tal_id_t tal_id: topo.st_ids)
 		{
-			spot_by_entity.addEntityInSpot(tal_id, topo.spot_id);
+			routing->addEntityInSpot(tal_id, topo.spot_id);
 		}
 
-		routes[{topo.spot_id, Component::gateway}] = topo.sat_id_gw;
-		routes[{topo.spot_id, Component::terminal}] = topo.sat_id_st;
-
-		regen_levels[{topo.spot_id, Component::terminal}] = topo.forward_regen_level;
-		regen_levels[{topo.spot_id, Component::gateway}] = topo.return_regen_level;
+		routing->addRoute(topo.spot_id, Component::gateway, topo.sat_id_gw, topo.return_regen_level);
+		routing->addRoute(topo.spot_id, Component::terminal, topo.sat_id_st, topo.forward_regen_level);
 
 		// Check that ISL are enabled when they should be
 		if (topo.sat_id_gw != topo.sat_id_st &&
@@ -127,23 +198,119 @@ bool BlockSatDispatcher::onInit()
 		    spot.first, topo.spot_id);
 	}
 
-	upward->routes = routes;
-	downward->routes = routes;
-	upward->spot_by_entity = spot_by_entity;
-	downward->spot_by_entity = spot_by_entity;
-	upward->regen_levels = regen_levels;
-	downward->regen_levels = regen_levels;
+	setRoutingTable(routing);
 	return true;
 }
 
+
+void BlockSatDispatcher::setRoutingTable(std::shared_ptr<const RoutingTable> table)
+{
+	auto downward = dynamic_cast<Downward *>(this->downward);
+	auto upward = dynamic_cast<Upward *>(this->upward);
+
+	routing_tables.push_back(table);
+	upward->routing.store(table.get(), std::memory_order_release);
+	downward->routing.store(table.get(), std::memory_order_release);
+}
+
 BlockSatDispatcher::Upward::Upward(const std::string &name, SatDispatcherConfig config):
 	RtUpwardMuxDemux<IslComponentPair>(name),
-	entity_id{config.entity_id}
+	entity_id{config.entity_id},
+	routing{nullptr},
+	bursts(RoutingTable::route_count),
+	burst_routes{},
+	packet_routes{},
+	gathering{false},
+	upper_bursts(link_count),
+	upper_burst_keys{},
+	isl_stats{},
+	isl_stats_index(RoutingTable::entity_count, -1),
+	stats_period_ms{0},
+	isl_timer{-1}
 {
 }
 
+bool BlockSatDispatcher::Upward::onInit()
+{
+	const auto conf = OpenSandModelConf::Get();
+	auto output = Output::Get();
+
+	// the neighbours are the satellites connected to the destinations of
+	// the other satellites, the routes are direct
+	for (auto &&spot: conf->getSpotsTopology())
+	{
+		const SpotTopology &topo = spot.second;
+		const std::pair<tal_id_t, RegenLevel> routes[] = {
+			{topo.sat_id_gw, topo.return_regen_level},
+			{topo.sat_id_st, topo.forward_regen_level},
+		};
+		for (auto &&[sat_id, regen_level]: routes)
+		{
+			if (sat_id == entity_id)
+			{
+				continue;
+			}
+			int &index = isl_stats_index[sat_id];
+			if (index < 0)
+			{
+				index = isl_stats.size();
+				const std::string prefix = "Isl.Sat " + std::to_string(sat_id) + ".";
+				isl_stats.push_back(IslStats{
+					{},
+					0,
+					0,
+					output->registerProbe<int>(prefix + "Throughput", "Kbits/s", true, SAMPLE_AVG),
+					output->registerProbe<int>(prefix + "Messages", "messages", true, SAMPLE_SUM),
+					output->registerProbe<int>(prefix + "Queue", "messages", true, SAMPLE_MAX),
+				});
+			}
+			// the frames use the control channel, the bursts the data
+			// channel for IP regeneration and the control channel otherwise
+			std::vector<IslComponentPair> &keys = isl_stats[index].keys;
+			for (IslComponentPair key: {IslComponentPair{sat_id, false},
+			                            IslComponentPair{sat_id, regen_level == RegenLevel::IP}})
+			{
+				if (std::find(keys.begin(), keys.end(), key) == keys.end())
+				{
+					keys.push_back(key);
+				}
+			}
+		}
+	}
+
+	if (isl_stats.empty())
+	{
+		return true;
+	}
+
+	if (!conf->getStatisticsPeriod(stats_period_ms))
+	{
+		LOG(log_init, LEVEL_ERROR,
+		    "missing parameter 'statistics period'");
+		return false;
+	}
+	this->isl_timer = this->addTimerEvent("isl_stats", stats_period_ms);
+	return true;
+}
+
+bool BlockSatDispatcher::Upward::onMessageBatch(const MessageEvent *const event)
+{
+	// the bursts towards the same upper fifo during a wakeup are merged,
+	// the transit traffic then crosses the ISL in as few messages as possible
+	this->gathering = true;
+	bool status = RtUpwardMuxDemux<IslComponentPair>::onMessageBatch(event);
+	this->gathering = false;
+	return this->flushBursts() && status;
+}
+
 bool BlockSatDispatcher::Upward::onEvent(const RtEvent *const event)
 {
+	if (event->getType() == EventType::Timer && *event == this->isl_timer)
+	{
+		this->updateIslStats();
+		return true;
+	}
+
 	if (event->getType() != EventType::Message)
 	{
 		LOG(log_receive, LEVEL_ERROR, "Unexpected event received: %s",
@@ -170,15 +337,17 @@ bool BlockSatDispatcher::Upward::onEvent(const RtEvent *const event)
 		}
 		case InternalMessageType::link_up:
 		{
-			bool success = true;
+			bool success = this->flushBursts();
 			T_LINK_UP *link_up_msg = static_cast<T_LINK_UP *>(msg_event->getData());
-			for (auto&& [key, regen_level] : regen_levels)
+			const RoutingTable *routing = this->routing.load(std::memory_order_acquire);
+			for (auto &&dest : routing->getDestinations())
 			{
-				T_LINK_UP *link_up_copy = new T_LINK_UP{*link_up_msg};
-				if (regen_level == RegenLevel::IP)
+				const Route *route = routing->getRoute(dest.spot_id, dest.dest);
+				if (route->regen_level == RegenLevel::IP)
 				{
+					T_LINK_UP *link_up_copy = new T_LINK_UP{*link_up_msg};
 					IslComponentPair link_up_key{
-						.connected_sat = routes.at(key),
+						.connected_sat = route->sat_id,
 						.is_data_channel = true,
 					};
 					if (!this->enqueueMessage(link_up_key,
@@ -217,15 +386,16 @@ bool BlockSatDispatcher::Upward::handleDvbFrame(std::unique_ptr<DvbFrame> frame)
 
 	const Component dest = isGatewayCarrier(carrier_type) ? Component::terminal : Component::gateway;
 
-	const auto dest_sat_id_it = routes.find({spot_id, dest});
-	if (dest_sat_id_it == routes.end())
+	const RoutingTable *routing = this->routing.load(std::memory_order_acquire);
+	const Route *route = routing->getRoute(spot_id, dest);
+	if (route == nullptr)
 	{
 		LOG(log_receive, LEVEL_ERROR,
 		    "No route found for %s in spot %d",
 		    dest == Component::gateway ? "GW" : "ST", spot_id);
 		return false;
 	}
-	const tal_id_t dest_sat_id = dest_sat_id_it->second;
+	const tal_id_t dest_sat_id = route->sat_id;
 
 	if (dest_sat_id == entity_id)
 	{
@@ -238,85 +408,233 @@ bool BlockSatDispatcher::Upward::handleDvbFrame(std::unique_ptr<DvbFrame> frame)
 			.connected_sat = dest_sat_id,
 			.is_data_channel = false,
 		};
+		accountIsl(key, frame->getTotalLength());
 		return sendToUpperBlock(key, std::move(frame), msg_type);
 	}
 }
 
 bool BlockSatDispatcher::Upward::handleNetBurst(std::unique_ptr<NetBurst> in_burst)
 {
-	// Separate the packets by destination
-	std::unordered_map<SpotComponentPair, std::unique_ptr<NetBurst>> bursts{};
+	const RoutingTable *routing = this->routing.load(std::memory_order_acquire);
+	bool ok = true;
+
+	// Find the destination of each packet
+	packet_routes.clear();
+	bool single_route = true;
 	for (auto &&pkt: *in_burst)
 	{
 		const auto dest_id = pkt->getDstTalId();
 		const auto src_id = pkt->getSrcTalId();
-		const spot_id_t spot_id = spot_by_entity.getSpotForEntity(src_id);
-		LOG(log_receive, LEVEL_INFO, "Received a NetBurst (%d->%d, spot_id %d)", src_id, dest_id, spot_id);
+		LOG(log_receive, LEVEL_INFO, "Received a NetBurst (%d->%d, spot_id %d)",
+		    src_id, dest_id, routing->getSpotForEntity(src_id));
 
-		Component src = OpenSandModelConf::Get()->getEntityType(src_id);
-		Component dest;
-		if (src == Component::gateway)
+		std::size_t route_index;
+		if (!routing->getRouteFromSource(src_id, route_index))
 		{
-			dest = Component::terminal;
-		}
-		else if (src == Component::terminal)
-		{
-			dest = Component::gateway;
+			LOG(log_receive, LEVEL_ERROR, "The type of the src entity %d is %s",
+			    src_id, getComponentName(routing->getEntityType(src_id)).c_str());
+			ok = false;
 		}
-		else
+		single_route &= packet_routes.empty() || packet_routes.front() == route_index;
+		packet_routes.push_back(route_index);
+	}
+	if (packet_routes.empty())
+	{
+		return ok;
+	}
+
+	// Forward the burst as is when all its packets share a destination
+	if (single_route && packet_routes.front() != RoutingTable::route_count)
+	{
+		return sendBurst(routing, packet_routes.front(), std::move(in_burst));
+	}
+
+	// Separate the packets by destination
+	auto route_index_it = packet_routes.begin();
+	for (auto &&pkt: *in_burst)
+	{
+		const std::size_t route_index = *route_index_it++;
+		if (route_index == RoutingTable::route_count)
 		{
-			LOG(log_receive, LEVEL_ERROR, "The type of the src entity %d is %s", src_id, getComponentName(src).c_str());
-			return false;
+			continue;
 		}
-
-		auto &burst = bursts[{spot_id, dest}];
+		auto &burst = bursts[route_index];
 		if (burst == nullptr)
 		{
 			burst = std::unique_ptr<NetBurst>(new NetBurst{});
+			burst_routes.push_back(route_index);
 		}
 		burst->push_back(std::move(pkt));
 	}
 
 	// Send all bursts to their respective destination
-	bool ok = true;
-	for (auto &&[dest, burst]: bursts)
+	for (std::size_t route_index: burst_routes)
 	{
-		const auto dest_sat_id_it = routes.find(dest);
-		if (dest_sat_id_it == routes.end())
-		{
-			LOG(log_receive, LEVEL_ERROR, "No route found for %s in spot %d",
-			    dest.dest == Component::gateway ? "GW" : "ST", dest.spot_id);
-			ok = false;
-			continue;
-		}
+		ok &= sendBurst(routing, route_index, std::move(bursts[route_index]));
+	}
+	burst_routes.clear();
+	return ok;
+}
+
+bool BlockSatDispatcher::Upward::sendBurst(const RoutingTable *routing,
+                                           std::size_t route_index,
+                                           std::unique_ptr<NetBurst> burst)
+{
+	const Route *route = routing->getRoute(route_index);
+	if (route == nullptr)
+	{
+		LOG(log_receive, LEVEL_ERROR, "No route found for %s in spot %zu",
+		    route_index % 2 ? "ST" : "GW", route_index / 2);
+		return false;
+	}
 
-		const tal_id_t dest_sat_id = dest_sat_id_it->second;
-		auto regen_level = regen_levels.at(dest);
-		if (dest_sat_id == entity_id && regen_level != RegenLevel::IP)
+	const tal_id_t dest_sat_id = route->sat_id;
+	if (dest_sat_id == entity_id && route->regen_level != RegenLevel::IP)
+	{
+		return sendToOppositeChannel(std::move(burst), InternalMessageType::decap_data);
+	}
+	else
+	{
+		// send by ISL or to LanAdaptation for IP regen
+		IslComponentPair key{
+			.connected_sat = dest_sat_id,
+			.is_data_channel = route->regen_level == RegenLevel::IP,
+		};
+		accountIsl(key, burst->bytes());
+		if (gathering)
 		{
-			ok &= sendToOppositeChannel(std::move(burst), InternalMessageType::decap_data);
+			gatherBurst(key, std::move(burst));
+			return true;
 		}
-		else
+		return sendToUpperBlock(key, std::move(burst), InternalMessageType::decap_data);
+	}
+}
+
+void BlockSatDispatcher::Upward::gatherBurst(IslComponentPair key, std::unique_ptr<NetBurst> burst)
+{
+	auto &gathered = upper_bursts[std::hash<IslComponentPair>{}(key)];
+	if (gathered == nullptr)
+	{
+		gathered = std::move(burst);
+		upper_burst_keys.push_back(key);
+		return;
+	}
+	for (auto &&pkt: *burst)
+	{
+		gathered->push_back(std::move(pkt));
+	}
+}
+
+bool BlockSatDispatcher::Upward::flushBurst(std::size_t link_index)
+{
+	std::unique_ptr<NetBurst> burst = std::move(upper_bursts[link_index]);
+	if (burst == nullptr)
+	{
+		return true;
+	}
+	auto key_it = std::find_if(upper_burst_keys.begin(), upper_burst_keys.end(),
+	                           [link_index](IslComponentPair key)
+	                           {
+		                           return std::hash<IslComponentPair>{}(key) == link_index;
+	                           });
+	IslComponentPair key = *key_it;
+	upper_burst_keys.erase(key_it);
+	return sendToUpperBlock(key, std::move(burst), InternalMessageType::decap_data);
+}
+
+bool BlockSatDispatcher::Upward::flushBursts()
+{
+	bool ok = true;
+	while (!upper_burst_keys.empty())
+	{
+		ok &= flushBurst(std::hash<IslComponentPair>{}(upper_burst_keys.front()));
+	}
+	return ok;
+}
+
+void BlockSatDispatcher::Upward::accountIsl(IslComponentPair key, std::size_t length)
+{
+	const int index = isl_stats_index[key.connected_sat];
+	if (index < 0)
+	{
+		return;
+	}
+	IslStats &stats = isl_stats[index];
+	stats.bytes += length;
+	++stats.messages;
+}
+
+void BlockSatDispatcher::Upward::updateIslStats()
+{
+	for (auto &&stats: isl_stats)
+	{
+		// bits per ms are Kbits/s
+		stats.probe_throughput->put(stats.bytes * 8 / stats_period_ms);
+		stats.probe_messages->put(stats.messages);
+		std::size_t depth = 0;
+		for (IslComponentPair key: stats.keys)
 		{
-			// send by ISL or to LanAdaptation for IP regen
-			IslComponentPair key{
-				.connected_sat = dest_sat_id,
-				.is_data_channel = regen_level == RegenLevel::IP,
-			};
-			ok &= sendToUpperBlock(key, std::move(burst), InternalMessageType::decap_data);
+			depth += this->getNextDepth(key);
 		}
+		stats.probe_queue->put(depth);
+		stats.bytes = 0;
+		stats.messages = 0;
 	}
-	return ok;
 }
 
 BlockSatDispatcher::Downward::Downward(const std::string &name, SatDispatcherConfig config):
 	RtDownwardMuxDemux<RegenerativeSpotComponent>{name},
-	entity_id{config.entity_id}
+	entity_id{config.entity_id},
+	routing{nullptr},
+	bursts(RoutingTable::route_count),
+	burst_routes{},
+	packet_routes{},
+	numa_probes{},
+	numa_timer{-1}
 {
 }
 
+bool BlockSatDispatcher::Downward::onInit()
+{
+	const auto conf = OpenSandModelConf::Get();
+
+	// the nodes of the stacks of the spots served by this satellite
+	std::set<int> nodes;
+	for (auto &&spot: conf->getSpotsTopology())
+	{
+		const SpotTopology &topo = spot.second;
+		if (topo.sat_numa_node >= 0 &&
+		    (topo.sat_id_gw == entity_id || topo.sat_id_st == entity_id))
+		{
+			nodes.insert(topo.sat_numa_node);
+		}
+	}
+
+	this->numa_probes.init("", {nodes.begin(), nodes.end()});
+	if (!this->numa_probes.isEnabled())
+	{
+		return true;
+	}
+
+	time_ms_t stats_period_ms;
+	if (!conf->getStatisticsPeriod(stats_period_ms))
+	{
+		LOG(log_init, LEVEL_ERROR,
+		    "missing parameter 'statistics period'");
+		return false;
+	}
+	this->numa_timer = this->addTimerEvent("numa_stats", stats_period_ms);
+	return true;
+}
+
 bool BlockSatDispatcher::Downward::onEvent(const RtEvent *const event)
 {
+	if (event->getType() == EventType::Timer && *event == this->numa_timer)
+	{
+		this->numa_probes.update();
+		return true;
+	}
+
 	if (event->getType() != EventType::Message)
 	{
 		LOG(log_receive, LEVEL_ERROR, "Unexpected event received: %s",
@@ -368,14 +686,15 @@ bool BlockSatDispatcher::Downward::handleDvbFrame(std::unique_ptr<DvbFrame> fram
 	                       ? std::make_tuple(Component::terminal, Component::gateway)
 	                       : std::make_tuple(Component::gateway, Component::terminal);
 
-	const auto dest_sat_id_it = routes.find({spot_id, dest});
-	if (dest_sat_id_it == routes.end())
+	const RoutingTable *routing = this->routing.load(std::memory_order_acquire);
+	const Route *route = routing->getRoute(spot_id, dest);
+	if (route == nullptr)
 	{
 		LOG(log_receive, LEVEL_ERROR, "No route found for %s in spot %d",
 		    dest == Component::gateway ? "GW" : "ST", spot_id);
 		return false;
 	}
-	const tal_id_t dest_sat_id = dest_sat_id_it->second;
+	const tal_id_t dest_sat_id = route->sat_id;
 
 	if (dest_sat_id == entity_id)
 	{
@@ -388,8 +707,10 @@ bool BlockSatDispatcher::Downward::handleDvbFrame(std::unique_ptr<DvbFrame> fram
 
 		// add one to the input carrier id to get the corresponding output carrier id
 		frame->setCarrierId(carrier_id + 1);
-		bool is_transparent = regen_levels.at({spot_id, dest}) == RegenLevel::Transparent
-		                   && (is_data_carrier || regen_levels.at({spot_id, src}) == RegenLevel::Transparent);
+		const Route *src_route = routing->getRoute(spot_id, src);
+		bool is_transparent = route->regen_level == RegenLevel::Transparent
+		                   && (is_data_carrier || (src_route != nullptr &&
+		                                           src_route->regen_level == RegenLevel::Transparent));
 		return sendToLowerBlock({spot_id, dest, is_transparent}, std::move(frame), msg_type);
 	}
 	else
@@ -401,60 +722,89 @@ bool BlockSatDispatcher::Downward::handleDvbFrame(std::unique_ptr<DvbFrame> fram
 
 bool BlockSatDispatcher::Downward::handleNetBurst(std::unique_ptr<NetBurst> in_burst)
 {
-	// Separate the packets by destination
-	std::unordered_map<SpotComponentPair, std::unique_ptr<NetBurst>> bursts{};
+	const RoutingTable *routing = this->routing.load(std::memory_order_acquire);
+	bool ok = true;
+
+	// Find the destination of each packet
+	packet_routes.clear();
+	bool single_route = true;
 	for (auto &&pkt: *in_burst)
 	{
 		const auto dest_id = pkt->getDstTalId();
 		const auto src_id = pkt->getSrcTalId();
-		const spot_id_t spot_id = spot_by_entity.getSpotForEntity(src_id);
-		LOG(log_receive, LEVEL_INFO, "Received a NetBurst (%d->%d, spot_id %d)", src_id, dest_id, spot_id);
+		LOG(log_receive, LEVEL_INFO, "Received a NetBurst (%d->%d, spot_id %d)",
+		    src_id, dest_id, routing->getSpotForEntity(src_id));
 
-		Component src = OpenSandModelConf::Get()->getEntityType(src_id);
-		Component dest;
-		if (src == Component::gateway)
+		std::size_t route_index;
+		if (!routing->getRouteFromSource(src_id, route_index))
 		{
-			dest = Component::terminal;
+			LOG(log_receive, LEVEL_ERROR, "The type of the src entity %d is %s",
+			    src_id, getComponentName(routing->getEntityType(src_id)).c_str());
+			ok = false;
 		}
-		else if (src == Component::terminal)
+		single_route &= packet_routes.empty() || packet_routes.front() == route_index;
+		packet_routes.push_back(route_index);
+	}
+	if (packet_routes.empty())
+	{
+		return ok;
+	}
+
+	// Forward the burst as is when all its packets share a destination
+	if (single_route && packet_routes.front() != RoutingTable::route_count)
+	{
+		return sendBurst(routing, packet_routes.front(), std::move(in_burst));
+	}
+
+	// Separate the packets by destination
+	auto route_index_it = packet_routes.begin();
+	for (auto &&pkt: *in_burst)
+	{
+		const std::size_t route_index = *route_index_it++;
+		if (route_index == RoutingTable::route_count)
 		{
-			dest = Component::gateway;
+			continue;
 		}
-		else
+		auto &burst = bursts[route_index];
+		if (burst == nullptr)
 		{
-			LOG(log_receive, LEVEL_ERROR, "The type of the src entity %d is %s", src_id, getComponentName(src).c_str());
-			return false;
-		}
-
-		auto &burst = bursts[{spot_id, dest}];
-		if (burst == nullptr) {
 			burst = std::unique_ptr<NetBurst>(new NetBurst{});
+			burst_routes.push_back(route_index);
 		}
 		burst->push_back(std::move(pkt));
 	}
 
 	// Send all bursts to their respective destination
-	bool ok = true;
-	for (auto &&[dest, burst]: bursts)
+	for (std::size_t route_index: burst_routes)
 	{
-		const auto dest_sat_id_it = routes.find(dest);
-		if (dest_sat_id_it == routes.end())
-		{
-			LOG(log_receive, LEVEL_ERROR, "No route found for %s in spot %d",
-			    dest.dest == Component::gateway ? "GW" : "ST", dest.spot_id);
-			ok = false;
-			continue;
-		}
-		const tal_id_t dest_sat_id = dest_sat_id_it->second;
-		if (dest_sat_id == entity_id || regen_levels.at(dest) == RegenLevel::IP)
-		{
-			ok &= sendToLowerBlock({dest.spot_id, dest.dest, false}, std::move(burst), InternalMessageType::decap_data);
-		}
-		else
-		{
-			// send by ISL
-			ok &= sendToOppositeChannel(std::move(burst), InternalMessageType::decap_data);
-		}
+		ok &= sendBurst(routing, route_index, std::move(bursts[route_index]));
 	}
+	burst_routes.clear();
 	return ok;
 }
+
+bool BlockSatDispatcher::Downward::sendBurst(const RoutingTable *routing,
+                                             std::size_t route_index,
+                                             std::unique_ptr<NetBurst> burst)
+{
+	const Route *route = routing->getRoute(route_index);
+	if (route == nullptr)
+	{
+		LOG(log_receive, LEVEL_ERROR, "No route found for %s in spot %zu",
+		    route_index % 2 ? "ST" : "GW", route_index / 2);
+		return false;
+	}
+
+	const tal_id_t dest_sat_id = route->sat_id;
+	if (dest_sat_id == entity_id || route->regen_level == RegenLevel::IP)
+	{
+		const spot_id_t spot_id = route_index / 2;
+		const Component dest = route_index % 2 ? Component::terminal : Component::gateway;
+		return sendToLowerBlock({spot_id, dest, false}, std::move(burst), InternalMessageType::decap_data);
+	}
+	else
+	{
+		// send by ISL
+		return sendToOppositeChannel(std::move(burst), InternalMessageType::decap_data);
+	}
+}
@@ -35,7 +35,9 @@
 #ifndef BLOCK_SAT_DISPATCHER_H
 #define BLOCK_SAT_DISPATCHER_H
 
+#include <atomic>
 #include <memory>
+#include <vector>
 
 #include <opensand_rt/Rt.h>
 #include <opensand_rt/RtChannelMuxDemux.h>
@@ -44,6 +46,7 @@
 #include "DvbFrame.h"
 #include "NetBurst.h"
 #include "SpotComponentPair.h"
+#include "NumaProbes.h"
 
 
 struct SatDispatcherConfig
@@ -62,19 +65,102 @@ struct SatDispatcherConfig
  */
 class BlockSatDispatcher: public Block
 {
-	class SpotByEntity
+	/**
+	 * @brief The route towards the gateway or the terminals of a spot
+	 */
+	struct Route
+	{
+		/// The satellite connected to the destination
+		tal_id_t sat_id;
+		/// The regeneration level towards the destination
+		RegenLevel regen_level;
+		/// Whether the route is configured
+		bool is_set;
+	};
+
+	/**
+	 * @class RoutingTable
+	 * @brief The routes and the spot and type of each entity, compiled
+	 *        in arrays indexed by spot and by entity id
+	 *
+	 * A table is immutable once published to the channels. A change of
+	 * the routes builds a new table which replaces the previous one
+	 * with setRoutingTable.
+	 */
+	class RoutingTable
 	{
 	public:
-		SpotByEntity();
+		RoutingTable();
+
+		void addRoute(spot_id_t spot, Component dest, tal_id_t sat_id, RegenLevel regen_level);
 
 		void addEntityInSpot(tal_id_t entity, spot_id_t spot);
 
 		void setDefaultSpot(spot_id_t spot);
 
+		/**
+		 * @brief Fill the type of every entity id from the configuration
+		 */
+		void setEntityTypes();
+
+		/**
+		 * @brief Get the route towards a destination
+		 *
+		 * @param spot  The spot of the destination
+		 * @param dest  The destination, gateway or terminal
+		 * @return the route, nullptr if there is none
+		 */
+		const Route *getRoute(spot_id_t spot, Component dest) const;
+
+		/**
+		 * @brief Get a route from its index
+		 *
+		 * @param route_index  The index given by getRouteIndex
+		 * @return the route, nullptr if there is none
+		 */
+		const Route *getRoute(std::size_t route_index) const;
+
+		/**
+		 * @brief Get the index of a destination in the routes
+		 *
+		 * @param spot  The spot of the destination
+		 * @param dest  The destination, gateway or terminal
+		 * @return the index, between 0 and route_count
+		 */
+		static std::size_t getRouteIndex(spot_id_t spot, Component dest);
+
 		spot_id_t getSpotForEntity(tal_id_t entity) const;
 
+		Component getEntityType(tal_id_t entity) const;
+
+		/**
+		 * @brief Get the route of a packet from its source: the terminals
+		 *        of the spot for a gateway and the gateway for a terminal
+		 *
+		 * @param src_id       The source entity of the packet
+		 * @param route_index  OUT: the index of the route, route_count
+		 *                     if the source is neither a gateway nor a terminal
+		 * @return true on success, false if the source type is not handled
+		 */
+		bool getRouteFromSource(tal_id_t src_id, std::size_t &route_index) const;
+
+		/**
+		 * @brief Get the destinations of the configured routes
+		 */
+		const std::vector<SpotComponentPair> &getDestinations() const;
+
+		/// The number of routes: a gateway and terminals for each spot id
+		static constexpr std::size_t route_count = 2 * (1 << (8 * sizeof(spot_id_t)));
+
+		/// The number of entity ids
+		static constexpr std::size_t entity_count = 1 << (8 * sizeof(tal_id_t));
+
 	private:
-		std::unordered_map<tal_id_t, spot_id_t> spot_by_entity;
+		std::vector<Route> routes;
+		std::vector<SpotComponentPair> destinations;
+		std::vector<spot_id_t> spot_by_entity;
+		std::vector<bool> has_spot;
+		std::vector<Component> entity_types;
 		spot_id_t default_spot;
 	};
 
@@ -83,6 +169,17 @@ public:
 
 	bool onInit();
 
+	/**
+	 * @brief Publish new routes to both channels
+	 *
+	 * The channels read the table once per message, the replaced tables
+	 * are kept until the block is destroyed so that a message being
+	 * handled never sees a released table.
+	 *
+	 * @param table  The new routing table
+	 */
+	void setRoutingTable(std::shared_ptr<const RoutingTable> table);
+
 	class Upward: public RtUpwardMuxDemux<IslComponentPair>
 	{
 	public:
@@ -91,20 +188,100 @@ public:
 	private:
 		friend class BlockSatDispatcher;
 
+		bool onInit() override;
 		bool onEvent(const RtEvent *const event) override;
+		bool onMessageBatch(const MessageEvent *const event) override;
 		bool handleDvbFrame(std::unique_ptr<DvbFrame> frame);
 		bool handleNetBurst(std::unique_ptr<NetBurst> burst);
+		bool sendBurst(const RoutingTable *routing,
+		               std::size_t route_index,
+		               std::unique_ptr<NetBurst> burst);
 
 		template <typename T>
 		bool sendToUpperBlock(IslComponentPair key, std::unique_ptr<T> msg, InternalMessageType msg_type);
 		template <typename T>
 		bool sendToOppositeChannel(std::unique_ptr<T> msg, InternalMessageType msg_type);
 
+		/**
+		 * @brief Add a burst to the one gathered for an upper fifo
+		 *        during the current batch of messages
+		 *
+		 * @param key    The key of the upper fifo
+		 * @param burst  The burst
+		 */
+		void gatherBurst(IslComponentPair key, std::unique_ptr<NetBurst> burst);
+
+		/**
+		 * @brief Send the burst gathered for an upper fifo, if any
+		 *
+		 * @param link_index  The index of the upper fifo
+		 * @return true on success, false otherwise
+		 */
+		bool flushBurst(std::size_t link_index);
+
+		/**
+		 * @brief Send all the gathered bursts
+		 *
+		 * @return true on success, false otherwise
+		 */
+		bool flushBursts();
+
+		/**
+		 * @brief Count a message sent to a neighbour satellite
+		 *
+		 * @param key     The key of the ISL fifo
+		 * @param length  The message length in bytes
+		 */
+		void accountIsl(IslComponentPair key, std::size_t length);
+
+		/**
+		 * @brief Export the ISL statistics of the elapsed period
+		 */
+		void updateIslStats();
+
+		/// The number of upper fifo keys: a data and a control channel per entity id
+		static constexpr std::size_t link_count = 2 * RoutingTable::entity_count;
+
 		tal_id_t entity_id;
 
-		SpotByEntity spot_by_entity;
-		std::unordered_map<SpotComponentPair, tal_id_t> routes;
-		std::unordered_map<SpotComponentPair, RegenLevel> regen_levels;
+		/// The current routing table
+		std::atomic<const RoutingTable *> routing;
+		/// The bursts being built per route index, kept between messages
+		std::vector<std::unique_ptr<NetBurst>> bursts;
+		/// The route indexes of the bursts being built, in order of arrival
+		std::vector<std::size_t> burst_routes;
+		/// The route index of each packet of the burst being handled
+		std::vector<std::size_t> packet_routes;
+
+		/// Whether the bursts towards the upper blocks are gathered,
+		/// set while a batch of messages is handled
+		bool gathering;
+		/// The bursts gathered per upper fifo during a batch of messages,
+		/// indexed by the hash of the fifo key
+		std::vector<std::unique_ptr<NetBurst>> upper_bursts;
+		/// The keys of the gathered bursts, in order of arrival
+		std::vector<IslComponentPair> upper_burst_keys;
+
+		/// The traffic of an ISL towards a neighbour satellite
+		struct IslStats
+		{
+			/// The keys of the fifos towards the neighbour
+			std::vector<IslComponentPair> keys;
+			/// The bytes sent during the statistics period
+			std::size_t bytes;
+			/// The messages sent during the statistics period
+			std::size_t messages;
+			std::shared_ptr<Probe<int>> probe_throughput;
+			std::shared_ptr<Probe<int>> probe_messages;
+			std::shared_ptr<Probe<int>> probe_queue;
+		};
+		/// The statistics of the ISLs
+		std::vector<IslStats> isl_stats;
+		/// The index of the statistics of each neighbour in isl_stats,
+		/// indexed by satellite id, -1 for the other entities
+		std::vector<int> isl_stats_index;
+		time_ms_t stats_period_ms;
+		event_id_t isl_timer;
 	};
 
 	class Downward: public RtDownwardMuxDemux<RegenerativeSpotComponent>
@@ -115,9 +292,13 @@ public:
 	private:
 		friend class BlockSatDispatcher;
 
+		bool onInit() override;
 		bool onEvent(const RtEvent *const event) override;
 		bool handleDvbFrame(std::unique_ptr<DvbFrame> frame);
 		bool handleNetBurst(std::unique_ptr<NetBurst> burst);
+		bool sendBurst(const RoutingTable *routing,
+		               std::size_t route_index,
+		               std::unique_ptr<NetBurst> burst);
 
 		template <typename T>
 		bool sendToLowerBlock(RegenerativeSpotComponent key, std::unique_ptr<T> msg, InternalMessageType msg_type);
@@ -125,20 +306,36 @@ public:
 		bool sendToOppositeChannel(std::unique_ptr<T> msg, InternalMessageType msg_type);
 
 		tal_id_t entity_id;
-		SpotByEntity spot_by_entity;
-		std::unordered_map<SpotComponentPair, tal_id_t> routes;
-		std::unordered_map<SpotComponentPair, RegenLevel> regen_levels;
+
+		/// The current routing table
+		std::atomic<const RoutingTable *> routing;
+		/// The bursts being built per route index, kept between messages
+		std::vector<std::unique_ptr<NetBurst>> bursts;
+		/// The route indexes of the bursts being built, in order of arrival
+		std::vector<std::size_t> burst_routes;
+		/// The route index of each packet of the burst being handled
+		std::vector<std::size_t> packet_routes;
+
+		/// The memory of the NUMA nodes the spots stacks are placed on,
+		/// exported every statistics period
+		NumaProbes numa_probes;
+		event_id_t numa_timer;
 	};
 
 private:
 	tal_id_t entity_id;
 	bool isl_enabled;
+
+	/// The published routing tables, the last one is in use
+	std::vector<std::shared_ptr<const RoutingTable>> routing_tables;
 };
 
 template <typename T>
 bool BlockSatDispatcher::Upward::sendToUpperBlock(IslComponentPair key, std::unique_ptr<T> msg, InternalMessageType msg_type)
 {
 	LOG(log_send, LEVEL_INFO, "Sending a message to the upper block");
+	// keep the order of the messages towards the fifo
+	bool flushed = this->flushBurst(std::hash<IslComponentPair>{}(key));
 	const auto msg_ptr = msg.release();
 	if (!enqueueMessage(key, (void **)&msg_ptr, sizeof(T), to_underlying(msg_type)))
 	{
@@ -146,7 +343,7 @@ bool BlockSatDispatcher::Upward::sendToUpperBlock(IslComponentPair key, std::uni
 		delete msg_ptr;
 		return false;
 	}
-	return true;
+	return flushed;
 }
 
 template <typename T>
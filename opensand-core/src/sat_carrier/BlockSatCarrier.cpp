@@ -37,6 +37,7 @@
 #include "BlockSatCarrier.h"
 
 #include <opensand_rt/MessageEvent.h>
+#include <opensand_rt/FileEvent.h>
 #include <opensand_output/Output.h>
 
 #include "DvbFrame.h"
@@ -58,7 +59,10 @@ BlockSatCarrier::Upward::Upward(const std::string &name, struct sc_specific spec
 	tal_id{specific.tal_id},
 	in_channel_set{specific.tal_id},
 	destination_host{specific.destination_host},
-	spot_id{specific.spot_id}
+	spot_id{specific.spot_id},
+	mirror{name + ".Upward.carriers"},
+	relay{specific.relay},
+	relayed{false}
 {
 }
 
@@ -68,7 +72,9 @@ BlockSatCarrier::Downward::Downward(const std::string &name, struct sc_specific
 	tal_id{specific.tal_id},
 	out_channel_set{specific.tal_id},
 	destination_host{specific.destination_host},
-	spot_id{specific.spot_id}
+	spot_id{specific.spot_id},
+	mirror{name + ".Downward.carriers"},
+	relay{std::move(specific.relay)}
 {
 }
 
@@ -78,24 +84,36 @@ bool BlockSatCarrier::Downward::onEvent(const RtEvent *const event)
 	{
 		case EventType::Message:
 		{
-			DvbFrame *dvb_frame = (DvbFrame *)((MessageEvent *)event)->getData();
+			auto dvb_frame = static_cast<const MessageEvent *>(event)->releaseData<DvbFrame>();
 
 			LOG(this->log_receive, LEVEL_DEBUG,
 			    "%u-bytes %s message event received\n",
 			    dvb_frame->getMessageLength(),
 			    event->getName().c_str());
 
-			if(!this->out_channel_set.send(dvb_frame->getCarrierId(),
-			                               dvb_frame->getRawData(),
-			                               dvb_frame->getTotalLength()))
+			if(this->mirror.isEnabled())
+			{
+				this->mirror.copy(dvb_frame->getRawData(), dvb_frame->getTotalLength(),
+				                  this->tal_id);
+			}
+
+			// the channel keeps the frame as long as it is being sent
+			uint8_t carrier_id = dvb_frame->getCarrierId();
+			const unsigned char *data = dvb_frame->getRawData();
+			size_t length = dvb_frame->getTotalLength();
+			uint64_t timestamp = dvb_frame->getTimestamp();
+			if(!this->out_channel_set.queue(carrier_id, data, length, timestamp,
+			                                std::shared_ptr<const void>{std::move(dvb_frame)}))
 			{
 				LOG(this->log_receive, LEVEL_ERROR,
 				    "error when sending data\n");
 			}
-			delete dvb_frame;
 		}
 		break;
 
+		case EventType::File:
+			return this->onRelay(static_cast<const FileEvent *>(event));
+
 		default:
 			LOG(this->log_receive, LEVEL_ERROR,
 			    "unknown event received %s",
@@ -105,6 +123,58 @@ bool BlockSatCarrier::Downward::onEvent(const RtEvent *const event)
 	return true;
 }
 
+bool BlockSatCarrier::Downward::onRelay(const FileEvent *const event)
+{
+	// the eventfd counter is only a wake up
+	event->releaseData(event->getData());
+
+	// the channels keep the buffers as long as they are being sent
+	bool status = true;
+	sat_carrier_packet_t relayed;
+	SatCarrierRing &ring = this->relay->getRing(this->destination_host);
+	while(ring.pop(relayed))
+	{
+		if(this->mirror.isEnabled())
+		{
+			this->mirror.copy(relayed.packet.data(), relayed.packet.length(),
+			                  this->tal_id);
+		}
+		auto packet = std::make_shared<const Data>(std::move(relayed.packet));
+		if(!this->out_channel_set.queue(relayed.carrier_id,
+		                                packet->data(),
+		                                packet->length(),
+		                                relayed.timestamp,
+		                                packet))
+		{
+			LOG(this->log_receive, LEVEL_ERROR,
+			    "error when relaying data on carrier %u\n",
+			    relayed.carrier_id);
+			status = false;
+		}
+	}
+	if(!this->out_channel_set.flush())
+	{
+		LOG(this->log_receive, LEVEL_ERROR,
+		    "error when sending data\n");
+		status = false;
+	}
+	return status;
+}
+
+bool BlockSatCarrier::Downward::onMessageBatch(const MessageEvent *const event)
+{
+	// the frames emitted on a frame tick are received on the same wakeup,
+	// send them with one system call per carrier
+	bool status = RtDownward::onMessageBatch(event);
+	if(!this->out_channel_set.flush())
+	{
+		LOG(this->log_receive, LEVEL_ERROR,
+		    "error when sending data\n");
+		status = false;
+	}
+	return status;
+}
+
 bool BlockSatCarrier::Upward::onEvent(const RtEvent *const event)
 {
 	bool status = true;
@@ -114,8 +184,7 @@ bool BlockSatCarrier::Upward::onEvent(const RtEvent *const event)
 		case EventType::NetSocket:
 		{
 			// Data to read in Sat_Carrier socket buffer
-			size_t length;
-			unsigned char *buf = NULL;
+			Data packet;
 
 			unsigned int carrier_id;
 			spot_id_t spot_id;
@@ -131,30 +200,55 @@ bool BlockSatCarrier::Upward::onEvent(const RtEvent *const event)
 				ret = this->in_channel_set.receive((NetSocketEvent *)event,
 				                                    carrier_id,
 				                                    spot_id,
-				                                    &buf, length);
+				                                    packet);
 				if(ret < 0)
 				{
 					LOG(this->log_receive, LEVEL_ERROR,
 					    "failed to receive data on any "
-					    "input channel (code = %zu)\n", length);
+					    "input channel (code = %d)\n", ret);
 					status = false;
 				}
 				else
 				{
 					LOG(this->log_receive, LEVEL_DEBUG,
 					    "%zu bytes of data received on carrier ID %u\n",
-					    length, carrier_id);
+					    packet.length(), carrier_id);
 
-					if(length > 0)
+					if(!packet.empty())
 					{
-						this->onReceivePktFromCarrier(carrier_id, spot_id,  
-						                              buf, length);
+						this->onReceivePktFromCarrier(carrier_id, spot_id,
+						                              std::move(packet), 0);
 					}
 				}
 			} while(ret > 0);
 		}
 		break;
 
+		case EventType::File:
+		{
+			// the eventfd counter is only a wake up
+			auto file_event = static_cast<const FileEvent *>(event);
+			file_event->releaseData(file_event->getData());
+
+			for(auto &&receiver: this->receivers)
+			{
+				if(*event != receiver->getEventFd())
+				{
+					continue;
+				}
+				sat_carrier_packet_t received;
+				while(receiver->pop(received))
+				{
+					this->onReceivePktFromCarrier(received.carrier_id,
+					                              received.spot_id,
+					                              std::move(received.packet),
+					                              received.timestamp);
+				}
+				break;
+			}
+		}
+		break;
+
 		default:
 			LOG(this->log_receive, LEVEL_ERROR,
 			    "unknown event received %s\n", 
@@ -162,6 +256,13 @@ bool BlockSatCarrier::Upward::onEvent(const RtEvent *const event)
 			return false;
 	}
 
+	// the other side is woken up once for all the packets of the event
+	if(this->relayed)
+	{
+		this->relay->getRing(this->destination_host == Component::gateway ?
+		                     Component::terminal : Component::gateway).signal();
+		this->relayed = false;
+	}
 	return status;
 }
 
@@ -184,6 +285,28 @@ bool BlockSatCarrier::Upward::onInit(void)
 		return false;
 	}
 
+	auto Conf = OpenSandModelConf::Get();
+	unsigned int workers = 0;
+	if(!Conf->getCarrierReceivers(workers))
+	{
+		LOG(this->log_init, LEVEL_ERROR,
+		    "Wrong number of carrier receive workers\n");
+		return false;
+	}
+	// only the datagrams received in batches carry their kernel timestamp
+	bool timestamping = false;
+	if(workers == 0 &&
+	   Conf->getCarrierTimestamping(timestamping) && timestamping)
+	{
+		LOG(this->log_init, LEVEL_NOTICE,
+		    "Timestamped carriers received by a worker\n");
+		workers = 1;
+	}
+	if(workers > 0)
+	{
+		return this->startReceivers(workers);
+	}
+
 	// ask the runtime to manage channel file descriptors
 	// (only for channels that accept input)
 	for(it = this->in_channel_set.begin(); it != this->in_channel_set.end(); it++)
@@ -206,6 +329,49 @@ bool BlockSatCarrier::Upward::onInit(void)
 	return true;
 }
 
+bool BlockSatCarrier::Upward::startReceivers(unsigned int workers)
+{
+	std::vector<UdpChannel *> channels;
+	for(auto &&channel: this->in_channel_set)
+	{
+		if(channel->isInputOk() && channel->getChannelFd() != -1)
+		{
+			channels.push_back(channel);
+		}
+	}
+
+	// the carriers are given in turn to the workers in the order of the
+	// set, spot after spot, a worker without carrier is not created
+	std::size_t count = std::min<std::size_t>(workers, channels.size());
+	for(std::size_t index = 0; index < count; ++index)
+	{
+		std::ostringstream name;
+		name << this->getName() << ".Receiver_" << index;
+		this->receivers.emplace_back(new SatCarrierReceiver(name.str()));
+	}
+	for(std::size_t index = 0; index < channels.size(); ++index)
+	{
+		this->receivers[index % count]->addChannel(channels[index]);
+	}
+
+	for(std::size_t index = 0; index < count; ++index)
+	{
+		auto &receiver = this->receivers[index];
+		if(!receiver->start())
+		{
+			LOG(this->log_init, LEVEL_ERROR,
+			    "cannot start the carrier receive worker %zu\n", index);
+			return false;
+		}
+		std::ostringstream name;
+		name << "Receiver_" << index;
+		this->addFileEvent(name.str(), receiver->getEventFd(), sizeof(uint64_t));
+	}
+	LOG(this->log_init, LEVEL_NOTICE,
+	    "Receive %zu channels on %zu workers\n", channels.size(), count);
+	return true;
+}
+
 bool BlockSatCarrier::Downward::onInit()
 {
 	// initialize all channels from the configuration file
@@ -215,34 +381,63 @@ bool BlockSatCarrier::Downward::onInit()
 		    "Wrong channel set configuration\n");
 		return false;
 	}
+
+	if(this->relay != nullptr)
+	{
+		LOG(this->log_init, LEVEL_NOTICE,
+		    "Relay the transparent carriers of spot %u\n", this->spot_id);
+		this->addFileEvent("Relay",
+		                   this->relay->getRing(this->destination_host).getEventFd(),
+		                   sizeof(uint64_t));
+	}
 	return true;
 }
 
 
 void BlockSatCarrier::Upward::onReceivePktFromCarrier(uint8_t carrier_id,
                                                       spot_id_t spot_id,
-                                                      unsigned char *data,
-                                                      size_t length)
+                                                      Data &&data,
+                                                      uint64_t timestamp)
 {
-	DvbFrame *dvb_frame = new DvbFrame(data, length);
-	free(data);
+	if(this->mirror.isEnabled())
+	{
+		this->mirror.copy(data.data(), data.length(), this->tal_id);
+	}
+
+	if(this->relay != nullptr)
+	{
+		// the frame goes out unchanged on the output carrier of the other
+		// side, as the dispatcher would send it
+		Component destination = this->destination_host == Component::gateway ?
+		                        Component::terminal : Component::gateway;
+		if(!this->relay->getRing(destination).push({carrier_id + 1u, spot_id,
+		                                            std::move(data), timestamp}))
+		{
+			LOG(this->log_receive, LEVEL_ERROR,
+			    "failed to relay frame from carrier %u\n", carrier_id);
+			return;
+		}
+		this->relayed = true;
+		LOG(this->log_receive, LEVEL_DEBUG,
+		    "Frame from carrier %u relayed\n", carrier_id);
+		return;
+	}
+
+	std::unique_ptr<DvbFrame> dvb_frame{new DvbFrame(std::move(data))};
 
 	dvb_frame->setCarrierId(carrier_id);
 	dvb_frame->setSpot(spot_id);
+	dvb_frame->setTimestamp(timestamp);
 
-	if (!this->enqueueMessage((void **)&dvb_frame, 0, to_underlying(InternalMessageType::unknown)))
+	// the frame is released on failure
+	if (!this->enqueueMessage(std::move(dvb_frame), 0, to_underlying(InternalMessageType::unknown)))
 	{
 		LOG(this->log_receive, LEVEL_ERROR,
 		    "failed to send frame from carrier %u to upper layer\n",
 		    carrier_id);
-		goto release;
+		return;
 	}
 
 	LOG(this->log_receive, LEVEL_DEBUG,
 	    "Message from carrier %u sent to upper layer\n", carrier_id);
-
-	return;
-
-release:
-	delete dvb_frame;
 }
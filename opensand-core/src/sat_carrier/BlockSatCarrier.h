@@ -38,10 +38,19 @@
 #define BlockSatCarrier_H
 
 #include "sat_carrier_channel_set.h"
+#include "SatCarrierReceiver.h"
+#include "SatCarrierRelay.h"
+#include "DvbFrame.h"
+#include "PacketMirror.h"
 
 #include <opensand_rt/Rt.h>
 #include <opensand_rt/RtChannel.h>
 
+#include <memory>
+#include <vector>
+
+
+class FileEvent;
 
 struct sc_specific
 {
@@ -51,6 +60,9 @@ struct sc_specific
 	Component destination_host = Component::unknown;    
 	/// for sat only: the spot handled by this part of the stack
 	spot_id_t spot_id = 255;
+	/// for sat only: the relay of the spot to the other side if it is
+	/// transparent on this satellite, null otherwise
+	std::shared_ptr<SatCarrierRelay> relay;
 };
 
 /**
@@ -88,18 +100,37 @@ public:
 		Component destination_host;
 		/// for sat only: the spot handled by this part of the stack
 		spot_id_t spot_id;
+		/// The mirror of the frames received on the carriers
+		PacketMirror mirror;
+		/// The workers receiving the carriers, none if they are
+		/// received by the channel
+		std::vector<std::unique_ptr<SatCarrierReceiver>> receivers;
+		/// The relay to the sat carrier block of the other side, if any
+		std::shared_ptr<SatCarrierRelay> relay;
+		/// Whether packets were relayed since the other side was signaled
+		bool relayed;
+
+		/**
+		 * @brief Spread the input carriers between receive workers
+		 *
+		 * @param workers  The number of receive workers
+		 * @return true on success, false otherwise
+		 */
+		bool startReceivers(unsigned int workers);
 
 		/**
 		 * @brief Handle a packt received from carrier
 		 *
 		 * @param carrier_id  The carrier of the packet
+		 * @param spot_id     The spot of the carrier
 		 * @param data        The data read on socket
-		 * @param length      The data length
+		 * @param timestamp   The kernel reception time of the packet
+		 *                    (ns, see getTimestampNs), 0 if unknown
 		 */
 		void onReceivePktFromCarrier(uint8_t carrier_id,
 		                             spot_id_t spot_id,
-		                             unsigned char *data,
-		                             size_t length);
+		                             Data &&data,
+		                             uint64_t timestamp);
 	};
 
 	class Downward: public RtDownward
@@ -110,6 +141,15 @@ public:
 		bool onInit(void);
 		bool onEvent(const RtEvent *const event);
 
+		/**
+		 * @brief Queue the frames received on one wakeup and
+		 *        send them on the carriers in a single batch
+		 *
+		 * @param event  The message event, iterable on its frames
+		 * @return true on success, false otherwise
+		 */
+		bool onMessageBatch(const MessageEvent *const event) override;
+
 	private:
 		/// the IP address for emulation newtork
 		std::string ip_addr;
@@ -121,6 +161,18 @@ public:
 		Component destination_host;
 		/// for sat only: the spot handled by this part of the stack
 		spot_id_t spot_id;
+		/// The mirror of the frames sent on the carriers
+		PacketMirror mirror;
+		/// The relay from the sat carrier block of the other side, if any
+		std::shared_ptr<SatCarrierRelay> relay;
+
+		/**
+		 * @brief Send the packets relayed by the other side
+		 *
+		 * @param event  The event on the relay eventfd
+		 * @return true on success, false otherwise
+		 */
+		bool onRelay(const FileEvent *const event);
 	};
 
 protected:
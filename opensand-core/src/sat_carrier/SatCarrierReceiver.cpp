@@ -0,0 +1,221 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file SatCarrierReceiver.cpp
+ * @brief A worker receiving the datagrams of some input carriers
+ *        out of the sat carrier channel thread
+ * @author Viveris Technologies
+ */
+
+
+#include "SatCarrierReceiver.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+
+SatCarrierReceiver::SatCarrierReceiver(const std::string &name):
+	name{name},
+	channels{},
+	ring{name},
+	stopping{false},
+	epoll_fd{-1},
+	stop_fd{-1},
+	thread{}
+{
+	this->log_receive = Output::Get()->registerLog(LEVEL_WARNING, "Sat_Carrier.Receiver");
+}
+
+
+SatCarrierReceiver::~SatCarrierReceiver()
+{
+	this->stopping.store(true, std::memory_order_release);
+	this->ring.close();
+	if(this->thread.joinable())
+	{
+		uint64_t value = 1;
+		if(write(this->stop_fd, &value, sizeof(value)) < 0)
+		{
+			LOG(this->log_receive, LEVEL_ERROR,
+			    "cannot wake up the receiver %s: %s\n",
+			    this->name.c_str(), strerror(errno));
+		}
+		this->thread.join();
+	}
+	for(int fd: {this->epoll_fd, this->stop_fd})
+	{
+		if(fd >= 0)
+		{
+			close(fd);
+		}
+	}
+}
+
+
+void SatCarrierReceiver::addChannel(UdpChannel *channel)
+{
+	this->channels.push_back(channel);
+}
+
+
+bool SatCarrierReceiver::start()
+{
+	if(!this->ring.init())
+	{
+		return false;
+	}
+	this->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	this->stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if(this->epoll_fd < 0 || this->stop_fd < 0)
+	{
+		LOG(this->log_receive, LEVEL_ERROR,
+		    "cannot create the receiver %s: %s\n",
+		    this->name.c_str(), strerror(errno));
+		return false;
+	}
+
+	// the stop eventfd has no channel
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.ptr = nullptr;
+	if(epoll_ctl(this->epoll_fd, EPOLL_CTL_ADD, this->stop_fd, &event) < 0)
+	{
+		LOG(this->log_receive, LEVEL_ERROR,
+		    "cannot wait on the receiver %s: %s\n",
+		    this->name.c_str(), strerror(errno));
+		return false;
+	}
+	for(auto &&channel: this->channels)
+	{
+		event.events = EPOLLIN;
+		event.data.ptr = channel;
+		if(epoll_ctl(this->epoll_fd, EPOLL_CTL_ADD, channel->getChannelFd(), &event) < 0)
+		{
+			LOG(this->log_receive, LEVEL_ERROR,
+			    "cannot wait on channel %u in the receiver %s: %s\n",
+			    channel->getChannelID(), this->name.c_str(), strerror(errno));
+			return false;
+		}
+		LOG(this->log_receive, LEVEL_NOTICE,
+		    "Receive channel %u in the receiver %s\n",
+		    channel->getChannelID(), this->name.c_str());
+	}
+
+	this->thread = std::thread{&SatCarrierReceiver::run, this};
+	return true;
+}
+
+
+int SatCarrierReceiver::getEventFd() const
+{
+	return this->ring.getEventFd();
+}
+
+
+bool SatCarrierReceiver::pop(sat_carrier_packet_t &packet)
+{
+	return this->ring.pop(packet);
+}
+
+
+void SatCarrierReceiver::run()
+{
+	struct epoll_event events[16];
+
+	while(!this->stopping.load(std::memory_order_acquire))
+	{
+		int count = epoll_wait(this->epoll_fd, events, 16, -1);
+		if(count < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			LOG(this->log_receive, LEVEL_ERROR,
+			    "cannot wait on the channels of the receiver %s: %s\n",
+			    this->name.c_str(), strerror(errno));
+			return;
+		}
+
+		// the sockets are level-triggered, the datagrams left after a
+		// burst wake up the next wait
+		bool received = false;
+		for(int index = 0; index < count; ++index)
+		{
+			auto channel = static_cast<UdpChannel *>(events[index].data.ptr);
+			if(channel == nullptr)
+			{
+				return;
+			}
+			received |= this->receive(channel);
+		}
+		if(received)
+		{
+			this->ring.signal();
+		}
+	}
+}
+
+
+bool SatCarrierReceiver::receive(UdpChannel *channel)
+{
+	bool received = false;
+	Data packet;
+
+	for(std::size_t burst = 0; burst < max_burst; ++burst)
+	{
+		int ret = channel->receivePending(packet);
+		if(ret < 0)
+		{
+			LOG(this->log_receive, LEVEL_ERROR,
+			    "failed to receive data on channel %u\n",
+			    channel->getChannelID());
+			break;
+		}
+		if(!packet.empty())
+		{
+			if(!this->ring.push({channel->getChannelID(), channel->getSpotId(),
+			                     std::move(packet), channel->getLastTimestamp()}))
+			{
+				break;
+			}
+			received = true;
+		}
+		if(ret == 0)
+		{
+			break;
+		}
+	}
+	return received;
+}
+
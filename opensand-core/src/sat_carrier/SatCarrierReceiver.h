@@ -0,0 +1,151 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file SatCarrierReceiver.h
+ * @brief A worker receiving the datagrams of some input carriers
+ *        out of the sat carrier channel thread
+ * @author Viveris Technologies
+ */
+
+#ifndef SAT_CARRIER_RECEIVER_H
+#define SAT_CARRIER_RECEIVER_H
+
+#include "UdpChannel.h"
+#include "SatCarrierRing.h"
+
+#include <opensand_output/Output.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @class SatCarrierReceiver
+ * @brief A worker thread receiving the datagrams of a share of the input
+ *        carriers of a sat carrier block
+ *
+ * The worker waits on the sockets of its carriers, fetches their pending
+ * datagrams in batches and reorders them, then gives the packets to the
+ * channel thread through its ring, signaled once per wakeup.
+ */
+class SatCarrierReceiver
+{
+public:
+	/**
+	 * @brief Create a receive worker, it is started by start
+	 *
+	 * @param name  The worker name, in the logs
+	 */
+	SatCarrierReceiver(const std::string &name);
+
+	/**
+	 * @brief Stop the worker
+	 */
+	~SatCarrierReceiver();
+
+	SatCarrierReceiver(const SatCarrierReceiver &) = delete;
+	SatCarrierReceiver &operator=(const SatCarrierReceiver &) = delete;
+
+	/**
+	 * @brief Give an input carrier to the worker, before it is started;
+	 *        the channel is then only read by the worker
+	 *
+	 * @param channel  The input channel
+	 */
+	void addChannel(UdpChannel *channel);
+
+	/**
+	 * @brief Start the worker thread
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool start();
+
+	/**
+	 * @brief Get the file descriptor signaling the received packets
+	 *
+	 * @return the eventfd readable while packets may be ready
+	 */
+	int getEventFd() const;
+
+	/**
+	 * @brief Get the next received packet, for the channel thread
+	 *
+	 * @param packet  OUT: the received packet
+	 * @return true if a packet was ready, false if the ring is empty
+	 */
+	bool pop(sat_carrier_packet_t &packet);
+
+private:
+	/**
+	 * @brief Receive the datagrams of the carriers until the worker is stopped
+	 */
+	void run();
+
+	/**
+	 * @brief Receive the pending datagrams of a carrier
+	 *
+	 * @param channel  The carrier channel
+	 * @return true if packets were given to the channel thread
+	 */
+	bool receive(UdpChannel *channel);
+
+	/// The maximum number of datagrams received on a carrier per wakeup,
+	/// so that a loaded carrier does not delay the other ones
+	static constexpr std::size_t max_burst = 256;
+
+	/// The worker name
+	std::string name;
+
+	/// The input carriers read by the worker
+	std::vector<UdpChannel *> channels;
+
+	/// The packets given to the channel thread
+	SatCarrierRing ring;
+
+	/// Whether the worker should stop
+	std::atomic<bool> stopping;
+
+	/// The epoll instance waiting on the carriers sockets
+	int epoll_fd;
+
+	/// The eventfd waking up the worker to stop it
+	int stop_fd;
+
+	/// The worker thread
+	std::thread thread;
+
+	std::shared_ptr<OutputLog> log_receive;
+};
+
+
+#endif
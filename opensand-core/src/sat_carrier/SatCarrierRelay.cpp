@@ -0,0 +1,56 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file SatCarrierRelay.cpp
+ * @brief The relay of the carriers of a transparent spot between the
+ *        sat carrier blocks of its gateway and of its terminals
+ * @author Viveris Technologies
+ */
+
+
+#include "SatCarrierRelay.h"
+
+
+SatCarrierRelay::SatCarrierRelay(spot_id_t spot_id):
+	to_gateway{"Relay.GW" + std::to_string(spot_id)},
+	to_terminal{"Relay.ST" + std::to_string(spot_id)}
+{
+}
+
+
+bool SatCarrierRelay::init()
+{
+	return this->to_gateway.init() && this->to_terminal.init();
+}
+
+
+SatCarrierRing &SatCarrierRelay::getRing(Component destination)
+{
+	return destination == Component::gateway ? this->to_gateway : this->to_terminal;
+}
@@ -0,0 +1,90 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file SatCarrierRelay.h
+ * @brief The relay of the carriers of a transparent spot between the
+ *        sat carrier blocks of its gateway and of its terminals
+ * @author Viveris Technologies
+ */
+
+#ifndef SAT_CARRIER_RELAY_H
+#define SAT_CARRIER_RELAY_H
+
+#include "SatCarrierRing.h"
+#include "OpenSandCore.h"
+
+
+/**
+ * @class SatCarrierRelay
+ * @brief The relay of the carriers of a spot whose forward and return
+ *        links are transparent on the satellite
+ *
+ * The frames of such a spot are only relayed from each input carrier to
+ * its output carrier, the dispatcher would not change them. The sat
+ * carrier block receiving them gives the received buffers to the block
+ * of the other side with the output carrier ID, without creating any
+ * frame nor crossing the dispatcher, and that block sends them as they
+ * were received.
+ */
+class SatCarrierRelay
+{
+public:
+	/**
+	 * @brief Create the relay of a spot
+	 *
+	 * @param spot_id  The spot relayed
+	 */
+	SatCarrierRelay(spot_id_t spot_id);
+
+	/**
+	 * @brief Create the signaling of the relay, before the blocks start
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool init();
+
+	/**
+	 * @brief Get the ring of the packets to send to a destination, read by
+	 *        the sat carrier block handling it and written by the other one
+	 *
+	 * @param destination  The gateway or the terminals
+	 * @return the ring feeding the block of the destination
+	 */
+	SatCarrierRing &getRing(Component destination);
+
+private:
+	/// The packets sent to the gateway
+	SatCarrierRing to_gateway;
+
+	/// The packets sent to the terminals
+	SatCarrierRing to_terminal;
+};
+
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file SatCarrierRing.cpp
+ * @brief A ring of the packets received on the carriers, between two threads
+ * @author Viveris Technologies
+ */
+
+
+#include "SatCarrierRing.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <thread>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+
+SatCarrierRing::SatCarrierRing(const std::string &name):
+	name{name},
+	ring(capacity),
+	head{0},
+	tail{0},
+	closed{false},
+	event_fd{-1}
+{
+	this->log_ring = Output::Get()->registerLog(LEVEL_WARNING, "Sat_Carrier.Ring");
+}
+
+
+SatCarrierRing::~SatCarrierRing()
+{
+	if(this->event_fd >= 0)
+	{
+		::close(this->event_fd);
+	}
+}
+
+
+bool SatCarrierRing::init()
+{
+	this->event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if(this->event_fd < 0)
+	{
+		LOG(this->log_ring, LEVEL_ERROR,
+		    "cannot create the eventfd of the ring %s: %s\n",
+		    this->name.c_str(), strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+
+int SatCarrierRing::getEventFd() const
+{
+	return this->event_fd;
+}
+
+
+bool SatCarrierRing::push(sat_carrier_packet_t &&packet)
+{
+	std::size_t tail = this->tail.load(std::memory_order_relaxed);
+	if(tail - this->head.load(std::memory_order_acquire) >= capacity)
+	{
+		// the packets already pushed must be handled to make room
+		this->signal();
+		while(tail - this->head.load(std::memory_order_acquire) >= capacity)
+		{
+			if(this->closed.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			// a sleep, unlike a yield, lets a stopped channel be cancelled
+			std::this_thread::sleep_for(full_pause);
+		}
+	}
+	this->ring[tail & (capacity - 1)] = std::move(packet);
+	this->tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+
+bool SatCarrierRing::pop(sat_carrier_packet_t &packet)
+{
+	std::size_t head = this->head.load(std::memory_order_relaxed);
+	if(head == this->tail.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+	packet = std::move(this->ring[head & (capacity - 1)]);
+	this->head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+
+void SatCarrierRing::signal()
+{
+	uint64_t value = 1;
+	if(write(this->event_fd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+	{
+		LOG(this->log_ring, LEVEL_ERROR,
+		    "cannot signal the packets of the ring %s: %s\n",
+		    this->name.c_str(), strerror(errno));
+	}
+}
+
+
+void SatCarrierRing::close()
+{
+	this->closed.store(true, std::memory_order_release);
+}
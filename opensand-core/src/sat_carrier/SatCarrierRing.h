@@ -0,0 +1,157 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file SatCarrierRing.h
+ * @brief A ring of the packets received on the carriers, between two threads
+ * @author Viveris Technologies
+ */
+
+#ifndef SAT_CARRIER_RING_H
+#define SAT_CARRIER_RING_H
+
+#include "Data.h"
+#include "OpenSandCore.h"
+
+#include <opensand_output/Output.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/// A packet received on a carrier
+struct sat_carrier_packet_t
+{
+	unsigned int carrier_id;
+	spot_id_t spot_id;
+	Data packet;
+	/// the kernel reception time (ns, see getTimestampNs), 0 if unknown
+	uint64_t timestamp = 0;
+};
+
+
+/**
+ * @class SatCarrierRing
+ * @brief A bounded single-producer/single-consumer ring of the packets
+ *        received on the carriers
+ *
+ * The packets are moved in the ring, their pooled buffers are kept.
+ * The consumer is signaled through an eventfd the producer writes once
+ * per batch of packets; it is watched by the consumer channel as a
+ * file event. No packet is dropped: a producer whose ring is full
+ * waits for the consumer.
+ */
+class SatCarrierRing
+{
+public:
+	/**
+	 * @brief Create a ring
+	 *
+	 * @param name  The ring name, in the logs
+	 */
+	SatCarrierRing(const std::string &name);
+
+	~SatCarrierRing();
+
+	SatCarrierRing(const SatCarrierRing &) = delete;
+	SatCarrierRing &operator=(const SatCarrierRing &) = delete;
+
+	/**
+	 * @brief Create the ring eventfd
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool init();
+
+	/**
+	 * @brief Get the file descriptor signaling the packets
+	 *
+	 * @return the eventfd readable while packets may be ready
+	 */
+	int getEventFd() const;
+
+	/**
+	 * @brief Add a packet in the ring, for the producer;
+	 *        wait while the ring is full
+	 *
+	 * @param packet  The packet
+	 * @return true on success, false if the ring was closed meanwhile
+	 */
+	bool push(sat_carrier_packet_t &&packet);
+
+	/**
+	 * @brief Get the next packet, for the consumer
+	 *
+	 * @param packet  OUT: the packet
+	 * @return true if a packet was ready, false if the ring is empty
+	 */
+	bool pop(sat_carrier_packet_t &packet);
+
+	/**
+	 * @brief Wake up the consumer on the packets pushed, for the producer
+	 */
+	void signal();
+
+	/**
+	 * @brief Stop the waits of the producer on a full ring
+	 */
+	void close();
+
+private:
+	/// The number of packets in the ring, a power of 2
+	static constexpr std::size_t capacity = 1024;
+
+	/// The wait of a producer between two checks of a full ring
+	static constexpr std::chrono::microseconds full_pause{20};
+
+	/// The ring name
+	std::string name;
+
+	/// The packets given to the consumer
+	std::vector<sat_carrier_packet_t> ring;
+
+	/// The index of the next packet to pop, written by the consumer
+	alignas(64) std::atomic<std::size_t> head;
+
+	/// The index of the next packet to push, written by the producer
+	alignas(64) std::atomic<std::size_t> tail;
+
+	/// Whether the producer should not wait anymore
+	alignas(64) std::atomic<bool> closed;
+
+	/// The eventfd signaling the packets to the consumer
+	int event_fd;
+
+	std::shared_ptr<OutputLog> log_ring;
+};
+
+
+#endif
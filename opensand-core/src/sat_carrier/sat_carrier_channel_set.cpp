@@ -36,6 +36,7 @@
 #include <opensand_rt/NetSocketEvent.h>
 
 #include "sat_carrier_channel_set.h"
+#include "UringUdpChannel.h"
 
 #include "OpenSandModelConf.h"
 
@@ -82,18 +83,38 @@ bool sat_carrier_channel_set::readCarrier(const std::string &local_ip_addr,
 
 	// create a new udp channel configure it, with information from file
 	// and insert it in the channels vector
-	UdpChannel *channel = new UdpChannel("Sat_Carrier",
-	                                     gw_id,
-	                                     carrier_id,
-	                                     is_input,
-	                                     !is_input,
-	                                     carrier_port,
-	                                     carrier_multicast,
-	                                     local_ip_addr,
-	                                     carrier_ip,
-	                                     carrier.udp_stack,
-	                                     carrier.udp_rmem,
-	                                     carrier.udp_wmem);
+	UdpChannel *channel;
+	if(carrier.io_uring && !is_input)
+	{
+		// the channel falls back on UDP sockets if io_uring is not available
+		channel = new UringUdpChannel("Sat_Carrier",
+		                              gw_id,
+		                              carrier_id,
+		                              is_input,
+		                              !is_input,
+		                              carrier_port,
+		                              carrier_multicast,
+		                              local_ip_addr,
+		                              carrier_ip,
+		                              carrier.udp_stack,
+		                              carrier.udp_rmem,
+		                              carrier.udp_wmem);
+	}
+	else
+	{
+		channel = new UdpChannel("Sat_Carrier",
+		                         gw_id,
+		                         carrier_id,
+		                         is_input,
+		                         !is_input,
+		                         carrier_port,
+		                         carrier_multicast,
+		                         local_ip_addr,
+		                         carrier_ip,
+		                         carrier.udp_stack,
+		                         carrier.udp_rmem,
+		                         carrier.udp_wmem);
+	}
 
 	if(!channel->isInit())
 	{
@@ -102,6 +123,21 @@ bool sat_carrier_channel_set::readCarrier(const std::string &local_ip_addr,
 		delete channel;
 		return false;
 	}
+	// the datagrams are still sent in bursts if the pacing is not available
+	if(carrier.pacing_rate_bps > 0 && !is_input &&
+	   !channel->setPacing(carrier.pacing_rate_bps))
+	{
+		LOG(this->log_init, LEVEL_WARNING,
+		    "UDP channel %d is not paced\n", carrier_id);
+	}
+	// the latency probes are not exported if the timestamping is not available
+	bool timestamping = false;
+	if(OpenSandModelConf::Get()->getCarrierTimestamping(timestamping) &&
+	   timestamping && !channel->enableTimestamping())
+	{
+		LOG(this->log_init, LEVEL_WARNING,
+		    "UDP channel %d is not timestamped\n", carrier_id);
+	}
 	this->push_back(channel);
 
 	return true;
@@ -250,15 +286,50 @@ bool sat_carrier_channel_set::send(uint8_t carrier_id,
 }
 
 
+bool sat_carrier_channel_set::queue(uint8_t carrier_id,
+                                    const unsigned char *data,
+                                    size_t length,
+                                    uint64_t timestamp,
+                                    std::shared_ptr<const void> owner)
+{
+	for (auto&& channel : *this)
+	{
+		if (channel->getChannelID() == carrier_id && channel->isOutputOk())
+		{
+			return channel->queue(data, length, timestamp, std::move(owner));
+		}
+	}
+
+	LOG(this->log_sat_carrier, LEVEL_ERROR,
+	    "failed to queue %zu bytes of data on channel %u: "
+	    "channel not found\n", length, carrier_id);
+
+	return false;
+}
+
+
+bool sat_carrier_channel_set::flush()
+{
+	bool status = true;
+	for (auto&& channel : *this)
+	{
+		if (channel->isOutputOk() && !channel->flush())
+		{
+			status = false;
+		}
+	}
+	return status;
+}
+
+
 int sat_carrier_channel_set::receive(NetSocketEvent *const event,
                                      unsigned int &op_carrier,
                                      spot_id_t &op_spot,
-                                     unsigned char **op_buf,
-                                     size_t &op_len)
+                                     Data &op_packet)
 {
 	int ret = -1;
 
-	op_len = 0;
+	op_packet.clear();
 	op_carrier = 0;
 
 	LOG(this->log_sat_carrier, LEVEL_DEBUG,
@@ -272,10 +343,10 @@ int sat_carrier_channel_set::receive(NetSocketEvent *const event,
 		if(channel->isInputOk() && *event == channel->getChannelFd())
 		{
 			// the file descriptors match, try to receive data for the channel
-			ret = channel->receive(event, op_buf, op_len);
+			ret = channel->receive(event, op_packet);
 
 			// Stop the task on data or error
-			if(op_len != 0 || ret < 0)
+			if(!op_packet.empty() || ret < 0)
 			{
 				LOG(this->log_sat_carrier, LEVEL_DEBUG,
 				    "data/error received, set op_carrier to %d\n",
@@ -288,7 +359,7 @@ int sat_carrier_channel_set::receive(NetSocketEvent *const event,
 	}
 
 	LOG(this->log_sat_carrier, LEVEL_DEBUG,
-	    "Receive packet: size %zu, carrier %d\n", op_len,
+	    "Receive packet: size %zu, carrier %d\n", op_packet.length(),
 	    op_carrier);
 
 	return ret;
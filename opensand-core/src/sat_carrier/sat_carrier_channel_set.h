@@ -89,6 +89,30 @@ public:
 	 */
 	bool send(uint8_t carrier_id, const unsigned char *data, size_t length);
 
+	/**
+	 * @brief Queue data to be sent on a satellite carrier by the next flush,
+	 *        the data must remain valid until then unless its owner
+	 *        is given to the channel
+	 *
+	 * @param carrier_id  The satellite carrier ID
+	 * @param data        The data to send
+	 * @param length      The liength of the data
+	 * @param timestamp   The time the data entered the emulator processing,
+	 *                    0 if unknown (ns, see getTimestampNs)
+	 * @param owner       The object holding the data, kept by the channel
+	 *                    as long as the kernel may read the data
+	 * @return true on success, false otherwise
+	 */
+	bool queue(uint8_t carrier_id, const unsigned char *data, size_t length,
+	           uint64_t timestamp = 0, std::shared_ptr<const void> owner = nullptr);
+
+	/**
+	 * @brief Send the data queued on all the output channels
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool flush();
+
 	/**
 	* @brief Receive data on a channel set
 	*
@@ -97,15 +121,15 @@ public:
 	*
 	* @param event         The event on channel fd
 	* @param op_carrier    Satellite Carrier id
-	* @param op_buf        pointer to a char buffer
-	* @param op_len        the received data length
+	* @param op_spot       the spot of the carrier
+	* @param op_packet     the received packet, empty if there is no data
 	* @return  0 on success, 1 if the function should be
 	 *         called another time, -1 on error
 	*/
 	int receive(NetSocketEvent *const event,
 	            unsigned int &op_carrier,
 	            spot_id_t &op_spot,
-	            unsigned char **op_buf, size_t &op_len);
+	            Data &op_packet);
 
 	int getChannelFdByChannelId(unsigned int i_channelID);
 
@@ -178,8 +178,7 @@ bool TestSatCarriers::Upward::onEvent(const RtEvent *const event)
 		{
 			// event on UDP channel
 			// Data to read in Sat_Carrier socket buffer
-			size_t length;
-			unsigned char *buf = NULL;
+			Data buf;
 
 			unsigned int carrier_id;
 			spot_id_t spot_id;
@@ -191,19 +190,19 @@ bool TestSatCarriers::Upward::onEvent(const RtEvent *const event)
 			{
 				ret = this->in_channel_set.receive((NetSocketEvent *)event,
 				                                    carrier_id, spot_id,
-				                                    &buf, length);
+				                                    buf);
 				if(ret < 0)
 				{
 					fprintf(stderr, "failed to receive data on any "
-					        "input channel (code = %zu)\n", length);
+					        "input channel (code = %d)\n", ret);
 					status = false;
 				}
 				else
 				{
-					if(length > 0)
+					if(!buf.empty())
 					{
-						Data *packet = new Data(buf, length);
-						free(buf);
+						size_t length = buf.length();
+						Data *packet = new Data(std::move(buf));
 
 						if(!this->shareMessage((void **)(&packet), length, from_udp))
 						{
@@ -0,0 +1,644 @@
+/*
+ * Benchmark of the satellite carrier channels
+ *
+ * The application drives many pairs of carrier channels over the loopback
+ * interface at a controlled rate, the datagrams of each sending channel
+ * being reordered and dropped after their sequencing counter is set, as a
+ * congested network would do. The receiving channels reorder them in their
+ * stacks and deliver them as BlockSatCarrier would get them.
+ *
+ * The sending channels use one of the carrier backends:
+ *  - udp:      the existing path, one system call per datagram
+ *  - batched:  the datagrams are queued and flushed with sendmmsg
+ *  - zerocopy: the datagrams are queued and flushed through io_uring
+ *              zero-copy sends (the channel falls back on sendmmsg
+ *              if the ring cannot be created)
+ *
+ * For each backend, it reports the delivered datagrams rate, the datagrams
+ * handled per second of CPU time (sending and receiving), the injected
+ * losses, the datagrams missing at the receivers (injected losses
+ * excluded, i.e. the datagrams the stacks gave up on because they were
+ * reordered further than their size), the datagrams delivered out of
+ * sequence and the median, 99th percentile and maximum latency added from
+ * the queuing of a datagram to its delivery.
+ *
+ * Launch the application with -h to learn how to use it.
+ *
+ * Author: Viveris Technologies
+ */
+
+// OpenSAND includes
+#include "UdpChannel.h"
+#include "UringUdpChannel.h"
+#include "Data.h"
+
+#include <opensand_output/Output.h>
+#include <opensand_rt/NetSocketEvent.h>
+
+// system includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <poll.h>
+#include <random>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+
+/// The program usage
+#define USAGE \
+"Satellite carrier benchmark: measure the carrier channels throughput and reordering\n\n\
+usage: bench_sat_carrier [-h] [-c channels] [-w workers] [-r rate] [-t duration]\n\
+                         [-l length] [-s stack] [-o reorder] [-g distance] [-x loss]\n\
+                         [-p port] [backend...]\n\
+\t-h           print this usage and exit\n\
+\t-c channels  the number of carriers (default: 8)\n\
+\t-w workers   the number of threads the carriers are spread over (default: 1)\n\
+\t-r rate      the datagrams sent per second on each carrier (default: 10000)\n\
+\t-t duration  the duration of each run in seconds (default: 5)\n\
+\t-l length    the datagrams length in bytes (default: 1000)\n\
+\t-s stack     the maximum number of datagrams in the reorder stacks (default: 5)\n\
+\t-o reorder   the percentage of datagrams sent late (default: 1)\n\
+\t-g distance  the number of datagrams overtaking a late one (default: 3)\n\
+\t-x loss      the percentage of datagrams dropped (default: 0.1)\n\
+\t-p port      the first UDP port of the carriers (default: 56000)\n\
+\tbackend      the sending backends to benchmark: udp batched zerocopy\n\
+\t             (default: all of them)\n\n"
+
+#define ERROR(format, ...) \
+	do { \
+		fprintf(stderr, format, ##__VA_ARGS__); \
+	} while(0)
+
+
+using bench_clock = std::chrono::steady_clock;
+
+/// The local addresses of the sending and receiving channels
+static const char *send_address = "127.0.0.2";
+static const char *receive_address = "127.0.0.1";
+
+/// The period the datagrams are sent on
+static constexpr std::chrono::microseconds tick{1000};
+
+/// The time given to the receivers to get the last datagrams
+static constexpr std::chrono::milliseconds drain_time{300};
+
+/// The maximum number of datagrams sent on a carrier per tick
+static constexpr std::size_t max_burst = 256;
+
+/// The bench header of the datagrams: sequence and queuing time
+static constexpr std::size_t header_length = 2 * sizeof(uint64_t);
+
+
+/// The benchmark parameters
+struct bench_params_t
+{
+	unsigned int channels = 8;
+	unsigned int workers = 1;
+	unsigned int rate = 10000;
+	unsigned int duration = 5;
+	std::size_t length = 1000;
+	unsigned int stack = 5;
+	double reorder = 1.0;
+	unsigned int distance = 3;
+	double loss = 0.1;
+	unsigned short port = 56000;
+};
+
+
+/// The sending backends
+enum class backend_t
+{
+	udp,
+	batched,
+	zerocopy,
+};
+
+
+/// The counters of a worker or of a run
+struct bench_result_t
+{
+	uint64_t sent = 0;
+	uint64_t dropped = 0;
+	uint64_t held = 0;
+	uint64_t delivered = 0;
+	uint64_t out_of_sequence = 0;
+	uint64_t bytes = 0;
+	double cpu_seconds = 0.0;
+	std::vector<uint64_t> latencies_ns;
+};
+
+
+/*
+ * A sending channel whose queued datagrams are dropped or delayed by some
+ * others before being flushed, their sequencing counters are already set
+ * so the receiver sees a reordered sequence
+ */
+template<class Channel>
+class ImpairedChannel: public Channel
+{
+public:
+	template<class... Args>
+	ImpairedChannel(const bench_params_t &params, unsigned int seed, Args&&... args):
+		Channel(std::forward<Args>(args)...),
+		loss{params.loss / 100.0},
+		reorder{params.reorder / 100.0},
+		distance{params.distance},
+		random{seed},
+		draw{0.0, 1.0},
+		late{},
+		dropped{0}
+	{
+	}
+
+	bool flush() override
+	{
+		std::vector<std::pair<const unsigned char *, std::size_t>> queue;
+		std::vector<uint8_t> counters;
+		for(std::size_t index = 0; index < this->send_queue.size(); ++index)
+		{
+			const auto &datagram = this->send_queue[index];
+			double value = this->draw(this->random);
+			if(value < this->loss)
+			{
+				++this->dropped;
+				continue;
+			}
+			if(value < this->loss + this->reorder)
+			{
+				// the late datagram is copied as the caller may reuse its buffer
+				this->late.push_back({std::vector<unsigned char>(datagram.first, datagram.first + datagram.second),
+				                      this->send_counters[index], this->distance, false});
+				continue;
+			}
+			queue.push_back(datagram);
+			counters.push_back(this->send_counters[index]);
+
+			for(auto &&datagram_late : this->late)
+			{
+				if(!datagram_late.sent && --datagram_late.remaining == 0)
+				{
+					queue.emplace_back(datagram_late.data.data(), datagram_late.data.size());
+					counters.push_back(datagram_late.counter);
+					datagram_late.sent = true;
+				}
+			}
+		}
+		this->send_queue = std::move(queue);
+		this->send_counters = std::move(counters);
+		bool status = Channel::flush();
+		this->late.remove_if([](const Late &datagram_late) { return datagram_late.sent; });
+		return status;
+	}
+
+	/// The number of injected losses
+	inline uint64_t getDropped() const { return this->dropped; };
+
+	/// The number of late datagrams still waiting to be sent
+	inline uint64_t getHeld() const { return this->late.size(); };
+
+private:
+	/// A datagram waiting for others to overtake it
+	struct Late
+	{
+		std::vector<unsigned char> data;
+		uint8_t counter;
+		unsigned int remaining;
+		bool sent;
+	};
+
+	double loss;
+	double reorder;
+	unsigned int distance;
+	std::minstd_rand random;
+	std::uniform_real_distribution<double> draw;
+	std::list<Late> late;
+	uint64_t dropped;
+};
+
+
+/// A carrier: the sending and receiving channels and their state
+struct carrier_t
+{
+	std::unique_ptr<UdpChannel> sender;
+	std::unique_ptr<UdpChannel> receiver;
+	/// The event reading the receiving socket, on a duplicate of the
+	/// socket as the events close their file descriptor
+	std::unique_ptr<NetSocketEvent> event;
+	std::function<uint64_t()> dropped;
+	std::function<uint64_t()> held;
+	std::vector<unsigned char> buffers;
+	uint64_t next_sequence = 0;
+	uint64_t last_delivered = 0;
+	bool delivered_any = false;
+};
+
+
+static double thread_cpu_seconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+
+static uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now().time_since_epoch()).count();
+}
+
+
+/**
+ * @brief Receive the datagrams pending on the receiving channels
+ *
+ * @param carriers  The carriers of the worker
+ * @param fds       The receiving sockets of the carriers
+ * @param timeout   The maximum time to wait for a datagram
+ * @param result    The worker counters
+ * @return false on error
+ */
+static bool receive(std::vector<carrier_t *> &carriers,
+                    std::vector<struct pollfd> &fds,
+                    std::chrono::nanoseconds timeout,
+                    bench_result_t &result)
+{
+	struct timespec wait;
+	wait.tv_sec = std::max<int64_t>(timeout.count(), 0) / 1000000000;
+	wait.tv_nsec = std::max<int64_t>(timeout.count(), 0) % 1000000000;
+	int ready = ppoll(fds.data(), fds.size(), &wait, nullptr);
+	if(ready < 0)
+	{
+		return errno == EINTR;
+	}
+
+	for(std::size_t index = 0; index < fds.size() && ready > 0; ++index)
+	{
+		if(!(fds[index].revents & POLLIN))
+		{
+			continue;
+		}
+		--ready;
+
+		carrier_t *carrier = carriers[index];
+		if(!carrier->event->handle())
+		{
+			return false;
+		}
+		int ret;
+		do
+		{
+			Data packet;
+			ret = carrier->receiver->receive(carrier->event.get(), packet);
+			if(ret < 0)
+			{
+				return false;
+			}
+			if(packet.length() < header_length)
+			{
+				continue;
+			}
+
+			uint64_t sequence;
+			uint64_t queued_ns;
+			memcpy(&sequence, packet.data(), sizeof(sequence));
+			memcpy(&queued_ns, packet.data() + sizeof(sequence), sizeof(queued_ns));
+			result.latencies_ns.push_back(now_ns() - queued_ns);
+			result.delivered += 1;
+			result.bytes += packet.length();
+			if(carrier->delivered_any && sequence <= carrier->last_delivered)
+			{
+				result.out_of_sequence += 1;
+			}
+			carrier->last_delivered = std::max(carrier->last_delivered, sequence);
+			carrier->delivered_any = true;
+		}
+		while(ret == 1);
+	}
+	return true;
+}
+
+
+/**
+ * @brief Send and receive the datagrams of some carriers
+ *
+ * @param params    The benchmark parameters
+ * @param backend   The sending backend
+ * @param carriers  The carriers of the worker
+ * @param result    OUT: the worker counters
+ */
+static void run_worker(const bench_params_t &params,
+                       backend_t backend,
+                       std::vector<carrier_t *> carriers,
+                       bench_result_t &result)
+{
+	std::vector<struct pollfd> fds;
+	for(auto &&carrier : carriers)
+	{
+		fds.push_back({carrier->receiver->getChannelFd(), POLLIN, 0});
+	}
+	result.latencies_ns.reserve(static_cast<std::size_t>(params.rate) * params.duration * carriers.size());
+
+	double cpu_start = thread_cpu_seconds();
+	auto start = bench_clock::now();
+	auto end = start + std::chrono::seconds{params.duration};
+	auto next_tick = start;
+	bool success = true;
+	while(success && next_tick < end)
+	{
+		double elapsed = std::chrono::duration<double>(next_tick - start).count();
+		uint64_t due = elapsed * params.rate;
+		for(auto &&carrier : carriers)
+		{
+			std::size_t burst = std::min<uint64_t>(due - std::min(due, carrier->next_sequence), max_burst);
+			for(std::size_t index = 0; index < burst; ++index)
+			{
+				// the queued datagrams keep their buffer until the flush
+				unsigned char *datagram = &carrier->buffers[index * params.length];
+				uint64_t sequence = carrier->next_sequence++;
+				uint64_t queued_ns = now_ns();
+				memcpy(datagram, &sequence, sizeof(sequence));
+				memcpy(datagram + sizeof(sequence), &queued_ns, sizeof(queued_ns));
+				if(backend == backend_t::udp)
+				{
+					success &= carrier->sender->send(datagram, params.length);
+				}
+				else
+				{
+					success &= carrier->sender->queue(datagram, params.length);
+				}
+				result.sent += 1;
+			}
+			if(backend != backend_t::udp && burst > 0)
+			{
+				success &= carrier->sender->flush();
+			}
+		}
+
+		next_tick += tick;
+		success &= receive(carriers, fds, next_tick - bench_clock::now(), result);
+	}
+
+	// get the datagrams still on their way
+	auto drain_end = bench_clock::now() + drain_time;
+	while(success && bench_clock::now() < drain_end)
+	{
+		success &= receive(carriers, fds, drain_end - bench_clock::now(), result);
+	}
+	result.cpu_seconds = thread_cpu_seconds() - cpu_start;
+
+	for(auto &&carrier : carriers)
+	{
+		result.dropped += carrier->dropped();
+		result.held += carrier->held();
+	}
+	if(!success)
+	{
+		ERROR("a carrier failed during the run\n");
+	}
+}
+
+
+/**
+ * @brief Create the carriers of a run
+ *
+ * @param params    The benchmark parameters
+ * @param backend   The sending backend
+ * @param first_id  The ID of the first carrier
+ * @param carriers  OUT: the carriers
+ * @param ring_used OUT: whether all the zero-copy carriers use io_uring
+ * @return true on success, false otherwise
+ */
+static bool create_carriers(const bench_params_t &params,
+                            backend_t backend,
+                            unsigned int first_id,
+                            std::vector<carrier_t> &carriers,
+                            bool &ring_used)
+{
+	ring_used = true;
+	carriers.resize(params.channels);
+	for(unsigned int index = 0; index < params.channels; ++index)
+	{
+		carrier_t &carrier = carriers[index];
+		unsigned int id = first_id + index;
+		unsigned short port = params.port + id;
+		if(backend == backend_t::zerocopy)
+		{
+			auto sender = new ImpairedChannel<UringUdpChannel>(params, id, "BenchSend", 0, id, false, true,
+			                                                   port, false, send_address, receive_address,
+			                                                   params.stack, 0, 1 << 22);
+			ring_used &= sender->isRingUsed();
+			carrier.dropped = [sender]() { return sender->getDropped(); };
+			carrier.held = [sender]() { return sender->getHeld(); };
+			carrier.sender.reset(sender);
+		}
+		else
+		{
+			auto sender = new ImpairedChannel<UdpChannel>(params, id, "BenchSend", 0, id, false, true,
+			                                              port, false, send_address, receive_address,
+			                                              params.stack, 0, 1 << 22);
+			carrier.dropped = [sender]() { return sender->getDropped(); };
+			carrier.held = [sender]() { return sender->getHeld(); };
+			carrier.sender.reset(sender);
+		}
+		carrier.receiver.reset(new UdpChannel("BenchReceive", 0, id, true, false,
+		                                      port, false, receive_address, receive_address,
+		                                      params.stack, 1 << 22, 0));
+		if(!carrier.sender->isInit() || !carrier.receiver->isInit())
+		{
+			ERROR("cannot create the carrier %u on port %u\n", id, port);
+			return false;
+		}
+		carrier.event.reset(new NetSocketEvent("bench", dup(carrier.receiver->getChannelFd())));
+		carrier.buffers.assign(max_burst * params.length, 0);
+	}
+	return true;
+}
+
+
+static bool run(const bench_params_t &params,
+                backend_t backend,
+                const char *name,
+                unsigned int first_id,
+                bool &fell_back)
+{
+	std::vector<carrier_t> carriers;
+	bool ring_used;
+	if(!create_carriers(params, backend, first_id, carriers, ring_used))
+	{
+		return false;
+	}
+	fell_back |= backend == backend_t::zerocopy && !ring_used;
+
+	// the carriers are spread over the workers
+	std::vector<bench_result_t> results(params.workers);
+	std::vector<std::thread> threads;
+	for(unsigned int worker = 0; worker < params.workers; ++worker)
+	{
+		std::vector<carrier_t *> worker_carriers;
+		for(unsigned int index = worker; index < carriers.size(); index += params.workers)
+		{
+			worker_carriers.push_back(&carriers[index]);
+		}
+		threads.emplace_back(run_worker, std::cref(params), backend,
+		                     std::move(worker_carriers), std::ref(results[worker]));
+	}
+	for(auto &&thread : threads)
+	{
+		thread.join();
+	}
+
+	bench_result_t total;
+	for(auto &&result : results)
+	{
+		total.sent += result.sent;
+		total.dropped += result.dropped;
+		total.held += result.held;
+		total.delivered += result.delivered;
+		total.out_of_sequence += result.out_of_sequence;
+		total.bytes += result.bytes;
+		total.cpu_seconds += result.cpu_seconds;
+		total.latencies_ns.insert(total.latencies_ns.end(),
+		                          result.latencies_ns.begin(), result.latencies_ns.end());
+	}
+	std::sort(total.latencies_ns.begin(), total.latencies_ns.end());
+	uint64_t p50 = 0, p99 = 0, max = 0;
+	if(!total.latencies_ns.empty())
+	{
+		p50 = total.latencies_ns[total.latencies_ns.size() / 2];
+		p99 = total.latencies_ns[total.latencies_ns.size() * 99 / 100];
+		max = total.latencies_ns.back();
+	}
+	uint64_t expected = total.sent - total.dropped - total.held;
+	uint64_t missing = expected > total.delivered ? expected - total.delivered : 0;
+
+	printf("%-8s%s | %9.0f %9.0f %8.2f | %9llu %7llu %7llu %7llu | %8.1f %8.1f %9.1f\n",
+	       name, (backend == backend_t::zerocopy && !ring_used) ? "*" : " ",
+	       total.delivered / static_cast<double>(params.duration),
+	       total.cpu_seconds > 0 ? total.delivered / total.cpu_seconds : 0.0,
+	       total.bytes / static_cast<double>(params.duration) / 1e6,
+	       static_cast<unsigned long long>(total.delivered),
+	       static_cast<unsigned long long>(total.dropped),
+	       static_cast<unsigned long long>(missing),
+	       static_cast<unsigned long long>(total.out_of_sequence),
+	       p50 / 1e3, p99 / 1e3, max / 1e3);
+	return true;
+}
+
+
+int main(int argc, char *argv[])
+{
+	bench_params_t params;
+	std::vector<std::string> backends;
+	int opt;
+
+	while((opt = getopt(argc, argv, "hc:w:r:t:l:s:o:g:x:p:")) != -1)
+	{
+		switch(opt)
+		{
+			case 'c':
+				params.channels = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'w':
+				params.workers = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'r':
+				params.rate = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 't':
+				params.duration = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'l':
+				params.length = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 's':
+				params.stack = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'o':
+				params.reorder = std::strtod(optarg, nullptr);
+				break;
+			case 'g':
+				params.distance = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'x':
+				params.loss = std::strtod(optarg, nullptr);
+				break;
+			case 'p':
+				params.port = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'h':
+			default:
+				ERROR(USAGE);
+				return EXIT_FAILURE;
+		}
+	}
+	for(int index = optind; index < argc; ++index)
+	{
+		backends.push_back(argv[index]);
+	}
+	if(backends.empty())
+	{
+		backends = {"udp", "batched", "zerocopy"};
+	}
+	if(params.channels == 0 || params.workers == 0 || params.duration == 0 ||
+	   params.length < header_length || params.length + 1 > MAX_SOCK_SIZE ||
+	   params.distance == 0 || params.loss + params.reorder > 100.0)
+	{
+		ERROR(USAGE);
+		return EXIT_FAILURE;
+	}
+	params.workers = std::min(params.workers, params.channels);
+
+	// the channels logs are not displayed, the losses
+	// they report on each gap are counted by the benchmark
+	Output::Get()->finalizeConfiguration();
+
+	printf("%u carriers on %u workers, %u datagrams/s of %zu bytes each, stack of %u,\n"
+	       "%.2f%% sent %u datagrams late, %.2f%% dropped\n\n",
+	       params.channels, params.workers, params.rate, params.length,
+	       params.stack, params.reorder, params.distance, params.loss);
+	printf("         |           throughput          |             datagrams             |    added latency (us)\n");
+	printf("backend  |   dgram/s  dgram/cpu     MB/s | delivered dropped missing out-seq |      p50      p99       max\n");
+
+	bool success = true;
+	bool fell_back = false;
+	unsigned int first_id = 0;
+	for(auto &&name : backends)
+	{
+		backend_t backend;
+		if(name == "udp")
+		{
+			backend = backend_t::udp;
+		}
+		else if(name == "batched")
+		{
+			backend = backend_t::batched;
+		}
+		else if(name == "zerocopy")
+		{
+			backend = backend_t::zerocopy;
+		}
+		else
+		{
+			ERROR("unknown backend %s\n", name.c_str());
+			success = false;
+			continue;
+		}
+		// each run has its own ports so the previous datagrams are not received
+		success &= run(params, backend, name.c_str(), first_id, fell_back);
+		first_id += params.channels;
+	}
+	if(fell_back)
+	{
+		printf("\n* the zero-copy carriers fell back on sendmmsg\n");
+	}
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -37,10 +37,14 @@
  */
 
 
+#include <climits>
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 #include <map>
+#include <sstream>
 #include <unistd.h>
+#include <sys/stat.h>
 
 #include "Entity.h"
 #include "EntityGw.h"
@@ -49,12 +53,16 @@
 #include "EntitySat.h"
 #include "EntitySat.h"
 #include "EntitySt.h"
+#include "MessageCapture.h"
 #include "NetBurst.h"
 #include "OpenSandModelConf.h"
+#include "PacketMirror.h"
+#include "Plugin.h"
 
 #include <opensand_output/Output.h>
 #include <opensand_output/OutputEvent.h>
 #include <opensand_rt/Rt.h>
+#include <opensand_rt/RtMemory.h>
 
 #if HAVE_CONFIG_H
 #include <config.h>
@@ -65,7 +73,8 @@
 
 void usage(std::ostream &stream, const std::string &progname)
 {
-	stream << progname << " [-h] [-v] [-V] -i infrastructure_path -t topology_path [-p profile_path]" << std::endl;
+	stream << progname << " [-h] [-v] [-V] -i infrastructure_path -t topology_path [-p profile_path] [-c cache_folder]"
+	          " [-o output_folder] [-s seed]" << std::endl;
 	stream << "\t-h                         print this message and exit" << std::endl;
 	stream << "\t-V                         print version and exit" << std::endl;
 	stream << "\t-v                         enable verbose output: logs are handed to stderr in addition" << std::endl;
@@ -73,6 +82,11 @@ void usage(std::ostream &stream, const std::string &progname)
 	stream << "\t-i <infrastructure_path>   path to the XML file describing the network infrastructure of the platform" << std::endl;
 	stream << "\t-t <topology_path>         path to the XML file describing the satcom topology of the platform" << std::endl;
 	stream << "\t-p <profile_path>          path to the XML file selecting options for this specific entity" << std::endl;
+	stream << "\t-c <cache_folder>          folder of the compiled configuration cache, shared by the entities" << std::endl;
+	stream << "\t                           of the host to skip parsing the XML files which did not change" << std::endl;
+	stream << "\t-o <output_folder>         store the logs and probes in this folder, whatever the local storage" << std::endl;
+	stream << "\t                           of the infrastructure configuration file" << std::endl;
+	stream << "\t-s <seed>                  seed of the random generators, to reproduce a run" << std::endl;
 }
 
 
@@ -99,6 +113,72 @@ tal_id_t Entity::getInstanceId() const
 }
 
 
+void Entity::defineCachedProfileMetaModel(const std::string &entity_type,
+                                          const std::function<void()> &define) const
+{
+	auto Conf = OpenSandModelConf::Get();
+
+	// the model changes with the program and the plugins that generate it
+	std::ostringstream key;
+	key << entity_type;
+	char exe_path[PATH_MAX];
+	ssize_t length = readlink("/proc/self/exe", exe_path, sizeof(exe_path) - 1);
+	if(length > 0)
+	{
+		exe_path[length] = '\0';
+		struct stat status;
+		if(stat(exe_path, &status) == 0)
+		{
+			key << ";" << exe_path << ":" << status.st_size << ":" << status.st_mtime;
+		}
+	}
+	key << ";" << Plugin::getPluginsSignature();
+
+	if(Conf->loadProfileModel(key.str()))
+	{
+		return;
+	}
+	define();
+	if(!Conf->storeProfileModel(key.str()))
+	{
+		DFLTLOG(LEVEL_WARNING,
+		        "%s: cannot store the profile model in the configuration cache\n",
+		        this->getName().c_str());
+	}
+}
+
+void Entity::placeOnSpotNode(std::initializer_list<Block *> blocks, spot_id_t spot_id) const
+{
+	auto Conf = OpenSandModelConf::Get();
+	const auto &spots = Conf->getSpotsTopology();
+	auto spot = spots.find(spot_id);
+	if(spot == spots.end())
+	{
+		return;
+	}
+	int numa_node = Conf->getComponentType() == Component::satellite ?
+	                spot->second.sat_numa_node : spot->second.gw_numa_node;
+	if(numa_node < 0)
+	{
+		return;
+	}
+
+	rt_thread_placement_t placement{RtMemory::getNodeCpus(numa_node), SCHED_OTHER, 0, {numa_node}, 0, false};
+	if(placement.cpus.empty())
+	{
+		DFLTLOG(LEVEL_WARNING,
+		        "%s: no CPU found on NUMA node %d, the blocks of spot %u "
+		        "only allocate from it",
+		        this->name.c_str(), numa_node, spot_id);
+	}
+	for(auto &&block: blocks)
+	{
+		block->setThreadPlacement(true, placement);
+		block->setThreadPlacement(false, placement);
+	}
+}
+
+
 std::shared_ptr<Entity> Entity::parseArguments(int argc, char **argv, int &return_code)
 {
 	int opt;
@@ -106,11 +186,15 @@ std::shared_ptr<Entity> Entity::parseArguments(int argc, char **argv, int &retur
 	std::string infrastructure_path;
 	std::string topology_path;
 	std::string profile_path;
+	std::string cache_folder;
+	std::string output_override;
+	bool has_seed = false;
+	unsigned int seed = 0;
 	
 	auto output = Output::Get();
 
 	return_code = 0;
-	while((opt = getopt(argc, argv, "-hVvi:t:p:g:")) != EOF)
+	while((opt = getopt(argc, argv, "-hVvi:t:p:g:c:o:s:")) != EOF)
 	{
 		switch(opt)
 		{
@@ -123,6 +207,16 @@ std::shared_ptr<Entity> Entity::parseArguments(int argc, char **argv, int &retur
 		case 'p':
 			profile_path = optarg;
 			break;
+		case 'c':
+			cache_folder = optarg;
+			break;
+		case 'o':
+			output_override = optarg;
+			break;
+		case 's':
+			has_seed = true;
+			seed = std::strtoul(optarg, nullptr, 0);
+			break;
 		case 'v':
 			// Configure terminal output before constructing Conf to see Conf logs
 			output->configureTerminalOutput();
@@ -239,6 +333,11 @@ std::shared_ptr<Entity> Entity::parseArguments(int argc, char **argv, int &retur
 	}
 
 	Conf->createModels();
+	Conf->setConfigurationCache(cache_folder);
+	if(has_seed)
+	{
+		Conf->setRandomSeed(seed);
+	}
 	if(!Conf->readInfrastructure(infrastructure_path))
 	{
 		std::cerr << progname <<
@@ -306,18 +405,46 @@ std::shared_ptr<Entity> Entity::parseArguments(int argc, char **argv, int &retur
 	output->setEntityName(entity->getName());
 
 	std::string output_folder;
-	if(Conf->getLocalStorage(enabled, output_folder) && enabled)
+	if(!output_override.empty())
+	{
+		enabled = true;
+		output_folder = output_override;
+	}
+	else if(!Conf->getLocalStorage(enabled, output_folder))
 	{
+		enabled = false;
+	}
+	if(enabled)
+	{
+		unsigned int rotation_size = 0;
+		unsigned int rotation_period = 0;
+		bool rotation_compress = false;
+		Conf->getLocalStorageRotation(rotation_size, rotation_period, rotation_compress);
 		// TODO: Error handling
-		output->configureLocalOutput(output_folder);
+		output->configureLocalOutput(output_folder,
+		                             std::size_t(rotation_size) * 1024 * 1024,
+		                             rotation_period,
+		                             rotation_compress);
 	}
 	std::string remote_address;
 	unsigned short stats_port = 12345;
 	unsigned short logs_port = 23456;
 	if(Conf->getRemoteStorage(enabled, remote_address, stats_port, logs_port) && enabled)
 	{
+		bool binary = false;
+		Conf->getRemoteStorageBinary(binary);
 		// TODO: Error handling
-		output->configureRemoteOutput(remote_address, stats_port, logs_port);
+		output->configureRemoteOutput(remote_address, stats_port, logs_port, binary);
+	}
+	std::string probes_shm;
+	if(Conf->getProbesSharedMemory(probes_shm) && !probes_shm.empty())
+	{
+		output->configureShmOutput(probes_shm);
+	}
+	int metrics_port = 0;
+	if(Conf->getMetricsPort(metrics_port) && metrics_port)
+	{
+		output->configureMetricsOutput("0.0.0.0", metrics_port);
 	}
 	DFLTLOG(LEVEL_NOTICE, "starting output\n");
 
@@ -347,10 +474,146 @@ std::shared_ptr<Entity> Entity::parseArguments(int argc, char **argv, int &retur
 
 bool Entity::createBlocks()
 {
+	bool virtual_time = false;
+	OpenSandModelConf::Get()->getVirtualTime(virtual_time);
+	if(virtual_time)
+	{
+		// the timer wheels of the channels are driven by the clock
+		// from their creation
+		Rt::setVirtualTime();
+	}
+
 	if(!this->createSpecificBlocks())
 	{
 		return false;
 	}
+
+	std::vector<OpenSandModelConf::thread_placement> placements;
+	if(!OpenSandModelConf::Get()->getThreadPlacements(placements))
+	{
+		DFLTLOG(LEVEL_CRITICAL,
+		        "%s: cannot load the channels threads placement",
+		        this->name.c_str());
+		return false;
+	}
+	for(auto &&thread: placements)
+	{
+		if((thread.upward && !Rt::setThreadPlacement(thread.block, true, thread.placement)) ||
+		   (thread.downward && !Rt::setThreadPlacement(thread.block, false, thread.placement)))
+		{
+			DFLTLOG(LEVEL_CRITICAL,
+			        "%s: threads placement defined for unknown block %s",
+			        this->name.c_str(), thread.block.c_str());
+			return false;
+		}
+	}
+
+	std::vector<OpenSandModelConf::fused_link> fused_links;
+	if(!OpenSandModelConf::Get()->getFusedLinks(fused_links))
+	{
+		DFLTLOG(LEVEL_CRITICAL,
+		        "%s: cannot load the fused links",
+		        this->name.c_str());
+		return false;
+	}
+	for(auto &&link: fused_links)
+	{
+		if((link.upward && !Rt::setFusedLinks(link.block, true)) ||
+		   (link.downward && !Rt::setFusedLinks(link.block, false)))
+		{
+			DFLTLOG(LEVEL_CRITICAL,
+			        "%s: fused links defined for unknown block %s",
+			        this->name.c_str(), link.block.c_str());
+			return false;
+		}
+	}
+
+	unsigned int message_batch = 1;
+	if(!OpenSandModelConf::Get()->getMessageBatch(message_batch))
+	{
+		DFLTLOG(LEVEL_CRITICAL,
+		        "%s: invalid messages batch size",
+		        this->name.c_str());
+		return false;
+	}
+	Rt::setMessageBatchSize(message_batch);
+
+	bool flow_control = false;
+	OpenSandModelConf::Get()->getFlowControl(flow_control);
+	if(flow_control)
+	{
+		// only the traffic can be dropped, the signalling always waits
+		Rt::setFlowControl({to_underlying(InternalMessageType::encap_data),
+		                    to_underlying(InternalMessageType::decap_data)});
+	}
+
+	std::vector<OpenSandModelConf::capture> captures;
+	if(!OpenSandModelConf::Get()->getCaptures(captures))
+	{
+		DFLTLOG(LEVEL_CRITICAL,
+		        "%s: cannot load the messages captures",
+		        this->name.c_str());
+		return false;
+	}
+	for(auto &&capture: captures)
+	{
+		bool both = capture.upward && capture.downward;
+		if((capture.upward &&
+		    !Rt::setCapture(capture.block, true, both ? capture.file + ".upward" : capture.file,
+		                    MessageCapture::serialize)) ||
+		   (capture.downward &&
+		    !Rt::setCapture(capture.block, false, both ? capture.file + ".downward" : capture.file,
+		                    MessageCapture::serialize)))
+		{
+			DFLTLOG(LEVEL_CRITICAL,
+			        "%s: cannot capture the messages sent by block %s in %s",
+			        this->name.c_str(), capture.block.c_str(), capture.file.c_str());
+			return false;
+		}
+	}
+
+	bool hardware_counters;
+	if(!OpenSandModelConf::Get()->getHardwareCounters(hardware_counters))
+	{
+		DFLTLOG(LEVEL_CRITICAL,
+		        "%s: cannot get the hardware counters configuration",
+		        this->name.c_str());
+		return false;
+	}
+	Rt::setHardwareCounters(hardware_counters);
+
+	bool lock_profiling;
+	if(!OpenSandModelConf::Get()->getLockProfiling(lock_profiling))
+	{
+		DFLTLOG(LEVEL_CRITICAL,
+		        "%s: cannot get the locks profiling configuration",
+		        this->name.c_str());
+		return false;
+	}
+	if(lock_profiling)
+	{
+		LockProfiler::enable();
+	}
+
+	std::string trace_file;
+	if(!OpenSandModelConf::Get()->getTraceFile(trace_file))
+	{
+		DFLTLOG(LEVEL_CRITICAL,
+		        "%s: cannot get the trace file",
+		        this->name.c_str());
+		return false;
+	}
+	Rt::setTraceFile(trace_file);
+
+	int stats_period_ms;
+	if(!OpenSandModelConf::Get()->getEventsStatisticsPeriod(stats_period_ms) ||
+	   !Rt::setEventsStatistics(stats_period_ms))
+	{
+		DFLTLOG(LEVEL_CRITICAL,
+		        "%s: cannot enable the channels events statistics",
+		        this->name.c_str());
+		return false;
+	}
 	DFLTLOG(LEVEL_DEBUG,
 	        "All blocks are created, start");
 	return true;
@@ -358,15 +621,82 @@ bool Entity::createBlocks()
 
 bool Entity::run()
 {
+	// the blocks give their parallel computations to the workers
+	// from their initialization
+	unsigned int task_workers = 0;
+	rt_thread_placement_t task_placement;
+	if(!OpenSandModelConf::Get()->getTaskWorkers(task_workers, task_placement))
+	{
+		DFLTLOG(LEVEL_CRITICAL,
+		        "%s: cannot load the task workers",
+		        this->name.c_str());
+		return false;
+	}
+	if(task_workers > 0 && !Rt::setTaskPool(task_workers, task_placement))
+	{
+		DFLTLOG(LEVEL_CRITICAL,
+		        "%s: cannot start the task workers",
+		        this->name.c_str());
+		return false;
+	}
+
 	// make the entity alive
 	if(!Rt::init())
 	{
 		return false;
 	}
+	// the probes are registered by the blocks initialization
+	std::vector<OpenSandModelConf::probe_sampling> samplings;
+	if(!OpenSandModelConf::Get()->getProbesSampling(samplings))
+	{
+		DFLTLOG(LEVEL_CRITICAL,
+		        "%s: cannot load the probes sampling",
+		        this->name.c_str());
+		return false;
+	}
+	for(auto &&sampling: samplings)
+	{
+		Output::Get()->setProbeSampling(sampling.path, sampling.policy,
+		                                sampling.period, sampling.threshold);
+	}
+
+	// the mirrors are enabled with their probes, here or at runtime
+	std::string mirror_file;
+	std::vector<std::string> mirrors;
+	if(!OpenSandModelConf::Get()->getMirrors(mirror_file, mirrors))
+	{
+		DFLTLOG(LEVEL_CRITICAL,
+		        "%s: cannot load the packets mirrors",
+		        this->name.c_str());
+		return false;
+	}
+	if(!mirror_file.empty())
+	{
+		if(!PacketMirror::start(mirror_file))
+		{
+			DFLTLOG(LEVEL_CRITICAL,
+			        "%s: cannot mirror the packets in %s",
+			        this->name.c_str(), mirror_file.c_str());
+			return false;
+		}
+		for(auto &&mirror: mirrors)
+		{
+			Output::Get()->setProbeState(mirror, true);
+		}
+	}
 	Output::Get()->finalizeConfiguration();
 	status->sendEvent("Blocks initialized");
 
-	if(!Rt::run())
+	bool running = Rt::run();
+	PacketMirror::stop();
+	if(LockProfiler::isEnabled())
+	{
+		std::ostringstream report;
+		LockProfiler::dump(report);
+		DFLTLOG(LEVEL_NOTICE, "locks wait and hold times:\n%s",
+		        report.str().c_str());
+	}
+	if(!running)
 	{
 		DFLTLOG(LEVEL_CRITICAL,
 		        "%s: cannot run process loop",
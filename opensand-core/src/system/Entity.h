@@ -38,11 +38,14 @@
 
 #include <string>
 #include <memory>
+#include <functional>
+#include <initializer_list>
 
 #include "OpenSandCore.h"
 
 
 class OutputEvent;
+class Block;
 
 
 /**
@@ -126,6 +129,29 @@ protected:
 	 */
 	virtual bool createSpecificConfiguration(const std::string &filepath) const = 0;
 
+	/**
+	 * Place the channels of the blocks of a spot on the NUMA node the
+	 * topology sets for the spot on this entity: they run on its CPUs
+	 * and allocate from it, including during their initialization;
+	 * the threads placement of the infrastructure still overrides it
+	 * per block
+	 *
+	 * @param blocks   The blocks of the spot
+	 * @param spot_id  The spot
+	 */
+	void placeOnSpotNode(std::initializer_list<Block *> blocks, spot_id_t spot_id) const;
+
+	/**
+	 * Define the profile model of the entity, or read it from the
+	 * configuration cache when it was generated by the same program
+	 * with the same plugins, the generation is then skipped
+	 *
+	 * @param entity_type  The entity type, the model depends on it
+	 * @param define       The generation of the profile model
+	 */
+	void defineCachedProfileMetaModel(const std::string &entity_type,
+	                                  const std::function<void()> &define) const;
+
 	std::string name;
 	tal_id_t instance_id;
 
@@ -62,6 +62,7 @@
 #include "OpenSandModelConf.h"
 
 #include "BlockLanAdaptation.h"
+#include "BlockTraffic.h"
 #include "BlockDvbNcc.h"
 #include "BlockSatCarrier.h"
 #include "BlockEncap.h"
@@ -83,10 +84,6 @@ EntityGw::~EntityGw()
 bool EntityGw::createSpecificBlocks()
 {
 	try {
-		struct la_specific laspecific;
-		laspecific.tap_iface = this->tap_iface;
-		laspecific.packet_switch = new GatewayPacketSwitch(this->instance_id);
-
 		EncapConfig encap_cfg;
 		encap_cfg.entity_id = this->instance_id;
 		encap_cfg.entity_type = Component::gateway;
@@ -106,13 +103,31 @@ bool EntityGw::createSpecificBlocks()
 		phy_config.spot_id = instance_id;
 		phy_config.entity_type = Component::gateway;
 
-		auto block_lan_adaptation = Rt::createBlock<BlockLanAdaptation>("Lan_Adaptation", laspecific);	
 		auto block_encap = Rt::createBlock<BlockEncap>("Encap", encap_cfg);
 		auto block_dvb = Rt::createBlock<BlockDvbNcc>("Dvb", dvb_spec);
 		auto block_phy_layer = Rt::createBlock<BlockPhysicalLayer>("Physical_Layer", phy_config);
 		auto block_sat_carrier = Rt::createBlock<BlockSatCarrier>("Sat_Carrier", scspecific);
 
-		Rt::connectBlocks(block_lan_adaptation, block_encap);
+		// the synthetic flows replace the TAP interface for load tests
+		if (BlockTraffic::isEnabled())
+		{
+			traffic_specific traffic_spec;
+			traffic_spec.tal_id = this->instance_id;
+			auto block_traffic = Rt::createBlock<BlockTraffic>("Traffic", traffic_spec);
+			this->placeOnSpotNode({block_traffic}, this->instance_id);
+			Rt::connectBlocks(block_traffic, block_encap);
+		}
+		else
+		{
+			struct la_specific laspecific;
+			laspecific.tap_iface = this->tap_iface;
+			laspecific.packet_switch = new GatewayPacketSwitch(this->instance_id);
+			auto block_lan_adaptation = Rt::createBlock<BlockLanAdaptation>("Lan_Adaptation", laspecific);
+			this->placeOnSpotNode({block_lan_adaptation}, this->instance_id);
+			Rt::connectBlocks(block_lan_adaptation, block_encap);
+		}
+		this->placeOnSpotNode({block_encap, block_dvb, block_phy_layer, block_sat_carrier},
+		                      this->instance_id);
 		Rt::connectBlocks(block_encap, block_dvb);
 		Rt::connectBlocks(block_dvb, block_phy_layer);
 		Rt::connectBlocks(block_phy_layer, block_sat_carrier);
@@ -129,7 +144,7 @@ bool EntityGw::createSpecificBlocks()
 
 bool EntityGw::loadConfiguration(const std::string &profile_path)
 {
-	this->defineProfileMetaModel();
+	this->defineCachedProfileMetaModel("gw", [this]() { this->defineProfileMetaModel(); });
 	auto Conf = OpenSandModelConf::Get();
 	if(!Conf->readProfile(profile_path))
 	{
@@ -154,6 +169,7 @@ void EntityGw::defineProfileMetaModel() const
 	auto disable_ctrl_plane = ctrl_plane->addParameter("disable_control_plane", "Disable control plane", types->getType("bool"));
 
 	BlockLanAdaptation::generateConfiguration();
+	BlockTraffic::generateConfiguration();
 	BlockEncap::generateConfiguration();
 	BlockDvbNcc::generateConfiguration(disable_ctrl_plane);
 	BlockPhysicalLayer::generateConfiguration();
@@ -62,6 +62,7 @@
 
 #include "BlockInterconnect.h"
 #include "BlockLanAdaptation.h"
+#include "BlockTraffic.h"
 #include "BlockDvbNcc.h"
 #include "BlockEncap.h"
 
@@ -82,10 +83,6 @@ bool EntityGwNetAcc::createSpecificBlocks()
 {
 	try
 	{
-		la_specific spec_la;
-		spec_la.tap_iface = this->tap_iface;
-		spec_la.packet_switch = new GatewayPacketSwitch(this->instance_id);
-
 		EncapConfig encap_cfg;
 		encap_cfg.entity_id = this->instance_id;
 		encap_cfg.entity_type = Component::gateway;
@@ -100,12 +97,29 @@ bool EntityGwNetAcc::createSpecificBlocks()
 		interco_cfg.interconnect_addr = this->interconnect_address;
 		interco_cfg.delay = 0;
 
-		auto block_lan_adaptation = Rt::createBlock<BlockLanAdaptation>("Lan_Adaptation", spec_la);
 		auto block_encap = Rt::createBlock<BlockEncap>("Encap", encap_cfg);
 		auto block_dvb = Rt::createBlock<BlockDvbNcc>("Dvb", dvb_spec);
 		auto block_interconnect = Rt::createBlock<BlockInterconnectDownward>("Interconnect.Downward", interco_cfg);
 
-		Rt::connectBlocks(block_lan_adaptation, block_encap);
+		// the synthetic flows replace the TAP interface for load tests
+		if (BlockTraffic::isEnabled())
+		{
+			traffic_specific traffic_spec;
+			traffic_spec.tal_id = this->instance_id;
+			auto block_traffic = Rt::createBlock<BlockTraffic>("Traffic", traffic_spec);
+			this->placeOnSpotNode({block_traffic}, this->instance_id);
+			Rt::connectBlocks(block_traffic, block_encap);
+		}
+		else
+		{
+			la_specific spec_la;
+			spec_la.tap_iface = this->tap_iface;
+			spec_la.packet_switch = new GatewayPacketSwitch(this->instance_id);
+			auto block_lan_adaptation = Rt::createBlock<BlockLanAdaptation>("Lan_Adaptation", spec_la);
+			this->placeOnSpotNode({block_lan_adaptation}, this->instance_id);
+			Rt::connectBlocks(block_lan_adaptation, block_encap);
+		}
+		this->placeOnSpotNode({block_encap, block_dvb, block_interconnect}, this->instance_id);
 		Rt::connectBlocks(block_encap, block_dvb);
 		Rt::connectBlocks(block_dvb, block_interconnect);
 	}
@@ -120,7 +134,7 @@ bool EntityGwNetAcc::createSpecificBlocks()
 
 bool EntityGwNetAcc::loadConfiguration(const std::string &profile_path)
 {
-	this->defineProfileMetaModel();
+	this->defineCachedProfileMetaModel("gw_net_acc", [this]() { this->defineProfileMetaModel(); });
 	auto Conf = OpenSandModelConf::Get();
 	if(!Conf->readProfile(profile_path))
 	{
@@ -146,6 +160,7 @@ void EntityGwNetAcc::defineProfileMetaModel() const
 	auto disable_ctrl_plane = ctrl_plane->addParameter("disable_control_plane", "Disable control plane", types->getType("bool"));
 
 	BlockLanAdaptation::generateConfiguration();
+	BlockTraffic::generateConfiguration();
 	BlockEncap::generateConfiguration();
 	BlockDvbNcc::generateConfiguration(disable_ctrl_plane);
 }
@@ -91,6 +91,8 @@ bool EntityGwPhy::createSpecificBlocks()
 		auto block_phy_layer = Rt::createBlock<BlockPhysicalLayer>("Physical_Layer", phy_config);
 		auto block_sat_carrier = Rt::createBlock<BlockSatCarrier>("Sat_Carrier", specific);
 
+		this->placeOnSpotNode({block_interconnect, block_phy_layer, block_sat_carrier},
+		                      this->instance_id);
 		Rt::connectBlocks(block_interconnect, block_phy_layer);
 		Rt::connectBlocks(block_phy_layer, block_sat_carrier);	
 	}
@@ -105,7 +107,7 @@ bool EntityGwPhy::createSpecificBlocks()
 
 bool EntityGwPhy::loadConfiguration(const std::string &profile_path)
 {
-	this->defineProfileMetaModel();
+	this->defineCachedProfileMetaModel("gw_phy", [this]() { this->defineProfileMetaModel(); });
 	auto Conf = OpenSandModelConf::Get();
 	if(!Conf->readProfile(profile_path))
 	{
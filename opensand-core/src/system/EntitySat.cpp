@@ -146,10 +146,29 @@ bool EntitySat::createSpecificBlocks()
 
 		for (auto &&[spot_id, topo]: spot_topo)
 		{
+			// a spot transparent on both links of this satellite is relayed
+			// between its sat carrier blocks without crossing the dispatcher
+			std::shared_ptr<SatCarrierRelay> relay;
+			if (topo.sat_id_gw == instance_id && topo.sat_id_st == instance_id &&
+			    topo.forward_regen_level == RegenLevel::Transparent &&
+			    topo.return_regen_level == RegenLevel::Transparent)
+			{
+				relay = std::make_shared<SatCarrierRelay>(spot_id);
+				if (!relay->init())
+				{
+					DFLTLOG(LEVEL_CRITICAL,
+					        "%s: error during block creation: could not "
+					        "create the relay of spot %d",
+					        this->getName().c_str(), spot_id);
+					return false;
+				}
+			}
+
 			if (topo.sat_id_gw == instance_id)
 			{
 				if (!createStack<BlockDvbTal>(block_sat_dispatch, spot_id, Component::gateway,
-				                              topo.forward_regen_level, topo.return_regen_level))
+				                              topo.forward_regen_level, topo.return_regen_level,
+				                              relay))
 				{
 					DFLTLOG(LEVEL_CRITICAL,
 					        "%s: error during block creation: could not "
@@ -162,7 +181,8 @@ bool EntitySat::createSpecificBlocks()
 			if (topo.sat_id_st == instance_id)
 			{
 				if (!createStack<BlockDvbNcc>(block_sat_dispatch, spot_id, Component::terminal,
-				                              topo.forward_regen_level, topo.return_regen_level))
+				                              topo.forward_regen_level, topo.return_regen_level,
+				                              relay))
 				{
 					DFLTLOG(LEVEL_CRITICAL,
 					        "%s: error during block creation: could not "
@@ -188,7 +208,8 @@ bool EntitySat::createStack(BlockSatDispatcher *block_sat_dispatch,
                             spot_id_t spot_id,
                             Component destination,
                             RegenLevel forward_regen_level,
-                            RegenLevel return_regen_level)
+                            RegenLevel return_regen_level,
+                            std::shared_ptr<SatCarrierRelay> relay)
 {
 	bool is_transparent{};
 	std::ostringstream suffix_builder;
@@ -216,7 +237,9 @@ bool EntitySat::createStack(BlockSatDispatcher *block_sat_dispatch,
 	specific.tal_id = instance_id;
 	specific.spot_id = spot_id;
 	specific.destination_host = destination;
+	specific.relay = std::move(relay);
 	auto block_sc = Rt::createBlock<BlockSatCarrier>("Sat_Carrier." + suffix, specific);
+	this->placeOnSpotNode({block_sc}, spot_id);
 
 	if (forward_regen_level != RegenLevel::Transparent || return_regen_level != RegenLevel::Transparent)
 	{
@@ -250,6 +273,7 @@ bool EntitySat::createStack(BlockSatDispatcher *block_sat_dispatch,
 		auto block_encap = Rt::createBlock<BlockEncap>("Encap." + suffix, encap_config);
 		auto block_dvb = Rt::createBlock<Dvb>("Dvb." + suffix, dvb_spec);
 		auto block_asym = Rt::createBlock<BlockSatAsymetricHandler>("Asymetric_Handler." + suffix, asym_config);
+		this->placeOnSpotNode({block_encap, block_dvb, block_asym}, spot_id);
 
 		Rt::connectBlocks(block_sat_dispatch, block_encap, {spot_id, destination, false});
 		Rt::connectBlocks(block_encap, block_dvb);
@@ -285,7 +309,7 @@ void defineProfileMetaModel()
 
 bool EntitySat::loadConfiguration(const std::string &profile_path)
 {
-	defineProfileMetaModel();
+	this->defineCachedProfileMetaModel("sat", defineProfileMetaModel);
 	auto Conf = OpenSandModelConf::Get();
 
 	if (!Conf->getSatInfrastructure(this->ip_address, this->isl_config))
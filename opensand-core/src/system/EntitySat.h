@@ -37,12 +37,14 @@
 
 #include "Entity.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
 
 class BlockSatDispatcher;
+class SatCarrierRelay;
 
 /**
  * @class EntitySat
@@ -88,7 +90,8 @@ private:
 	                 spot_id_t spot_id,
 	                 Component destination,
 	                 RegenLevel forward_regen_level,
-	                 RegenLevel return_regen_level);
+	                 RegenLevel return_regen_level,
+	                 std::shared_ptr<SatCarrierRelay> relay);
 
 	/**
 	 * Returns the entities that are connected through an ISL connection
@@ -62,6 +62,7 @@
 #include "OpenSandModelConf.h"
 
 #include "BlockLanAdaptation.h"
+#include "BlockTraffic.h"
 #include "BlockEncap.h"
 #include "BlockDvbTal.h"
 #include "BlockSatCarrier.h"
@@ -78,47 +79,88 @@ EntitySt::~EntitySt()
 }
 
 bool EntitySt::createSpecificBlocks()
+{
+	if (!this->createTerminalBlocks(this->instance_id, this->tap_iface, ""))
+	{
+		return false;
+	}
+
+	// the terminals of the farm share the configuration and the plugins
+	// of the process, their blocks and probes are suffixed by their name
+	bool created = true;
+	for (auto &&terminal: this->farm_terminals)
+	{
+		std::string name = "st" + std::to_string(terminal.entity_id);
+		Output::Get()->setProbesPrefix(name);
+		created = this->createTerminalBlocks(terminal.entity_id, terminal.tap_iface, "_" + name);
+		if (!created)
+		{
+			break;
+		}
+	}
+	Output::Get()->setProbesPrefix("");
+	return created;
+}
+
+bool EntitySt::createTerminalBlocks(tal_id_t tal_id,
+                                    const std::string &tap_iface,
+                                    const std::string &suffix)
 {
 	try
 	{
 		auto Conf = OpenSandModelConf::Get();
 	
 		tal_id_t gw_id;
-	 	Conf->getGwWithTalId(this->instance_id, gw_id);
-		la_specific laspecific;
-		laspecific.tap_iface = this->tap_iface;
-		laspecific.packet_switch = new TerminalPacketSwitch(this->instance_id, gw_id);
-
+		if (!Conf->getGwWithTalId(tal_id, gw_id))
+		{
+			DFLTLOG(LEVEL_CRITICAL, "%s: terminal %u is not attached to a gateway",
+			        this->getName().c_str(), tal_id);
+			return false;
+		}
 		EncapConfig encap_cfg;
-		encap_cfg.entity_id = this->instance_id;
+		encap_cfg.entity_id = tal_id;
 		encap_cfg.entity_type = Component::terminal;
 		encap_cfg.filter_packets = true;
 		encap_cfg.scpc_enabled = scpc_enabled;
 
 		dvb_specific dvb_spec;
 		dvb_spec.disable_control_plane = false;
-		dvb_spec.mac_id = instance_id;
+		dvb_spec.mac_id = tal_id;
 		dvb_spec.spot_id = gw_id;
 
 		PhyLayerConfig phy_config;
-		phy_config.mac_id = instance_id;
+		phy_config.mac_id = tal_id;
 		phy_config.spot_id = gw_id;
 		phy_config.entity_type = Component::terminal;
 
 		sc_specific scspecific;
 		scspecific.ip_addr = this->ip_address;
-		scspecific.tal_id = this->instance_id;	
+		scspecific.tal_id = tal_id;
 
 		bool disable_ctrl_plane;
 		if (!Conf->getControlPlaneDisabled(disable_ctrl_plane)) return false;
 
-		auto block_lan_adaptation = Rt::createBlock<BlockLanAdaptation>("Lan_Adaptation", laspecific);
-		auto block_encap = Rt::createBlock<BlockEncap>("Encap", encap_cfg);
-		auto block_dvb = Rt::createBlock<BlockDvbTal>("Dvb", dvb_spec);
-		auto block_phy_layer = Rt::createBlock<BlockPhysicalLayer>("Physical_Layer", phy_config);
-		auto block_sat_carrier = Rt::createBlock<BlockSatCarrier>("Sat_Carrier", scspecific);
-	
-		Rt::connectBlocks(block_lan_adaptation, block_encap);
+		auto block_encap = Rt::createBlock<BlockEncap>("Encap" + suffix, encap_cfg);
+		auto block_dvb = Rt::createBlock<BlockDvbTal>("Dvb" + suffix, dvb_spec);
+		auto block_phy_layer = Rt::createBlock<BlockPhysicalLayer>("Physical_Layer" + suffix, phy_config);
+		auto block_sat_carrier = Rt::createBlock<BlockSatCarrier>("Sat_Carrier" + suffix, scspecific);
+
+		// the synthetic flows replace the TAP interface for load tests
+		if (BlockTraffic::isEnabled())
+		{
+			traffic_specific traffic_spec;
+			traffic_spec.tal_id = tal_id;
+			auto block_traffic = Rt::createBlock<BlockTraffic>("Traffic" + suffix, traffic_spec);
+			Rt::connectBlocks(block_traffic, block_encap);
+		}
+		else
+		{
+			la_specific laspecific;
+			laspecific.tap_iface = tap_iface;
+			laspecific.packet_switch = new TerminalPacketSwitch(tal_id, gw_id);
+			auto block_lan_adaptation = Rt::createBlock<BlockLanAdaptation>("Lan_Adaptation" + suffix, laspecific);
+			Rt::connectBlocks(block_lan_adaptation, block_encap);
+		}
 		Rt::connectBlocks(block_encap, block_dvb);
 		Rt::connectBlocks(block_dvb, block_phy_layer);
 		Rt::connectBlocks(block_phy_layer, block_sat_carrier);
@@ -134,13 +176,14 @@ bool EntitySt::createSpecificBlocks()
 
 bool EntitySt::loadConfiguration(const std::string &profile_path)
 {
-	this->defineProfileMetaModel();
+	this->defineCachedProfileMetaModel("st", [this]() { this->defineProfileMetaModel(); });
 	auto Conf = OpenSandModelConf::Get();
 	if(!Conf->readProfile(profile_path))
 	{
 		return false;
 	}
 	return Conf->getGroundInfrastructure(this->ip_address, this->tap_iface) &&
+	       Conf->getTerminalFarm(this->farm_terminals) &&
 	       Conf->getScpcEnabled(scpc_enabled);
 }
 
@@ -160,6 +203,7 @@ void EntitySt::defineProfileMetaModel() const
 	auto disable_ctrl_plane = ctrl_plane->addParameter("disable_control_plane", "Disable control plane", types->getType("bool"));
 
 	BlockLanAdaptation::generateConfiguration();
+	BlockTraffic::generateConfiguration();
 	BlockEncap::generateConfiguration();
 	BlockDvbTal::generateConfiguration(disable_ctrl_plane);
 	BlockPhysicalLayer::generateConfiguration();
@@ -39,6 +39,9 @@
 #include "Entity.h"
 
 #include <string>
+#include <vector>
+
+#include "OpenSandModelConf.h"
 
 
 /**
@@ -87,9 +90,25 @@ protected:
 private:
 	void defineProfileMetaModel() const;
 
+	/**
+	 * Create and connect the blocks of one terminal
+	 *
+	 * @param tal_id     The terminal ID
+	 * @param tap_iface  The TAP interface of the terminal
+	 * @param suffix     The suffix of the blocks names
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool createTerminalBlocks(tal_id_t tal_id,
+	                          const std::string &tap_iface,
+	                          const std::string &suffix);
+
 	std::string ip_address;
 	std::string tap_iface;
 	bool scpc_enabled;
+
+	/// The additional terminals emulated by the process
+	std::vector<OpenSandModelConf::farm_terminal> farm_terminals;
 };
 
 #endif
@@ -0,0 +1,347 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ * Copyright © 2020 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file opensand_batch.cpp
+ * @brief Run a batch of OpenSAND scenarios in virtual time on all the cores
+ * @author Viveris Technologies
+ */
+
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <opensand_output/Output.h>
+#include <opensand_rt/Rt.h>
+
+#include "Entity.h"
+#include "Plugin.h"
+
+
+/// A scenario of the batch, run by its own process
+struct scenario_t
+{
+	std::string name;
+	/// the simulated duration of the run (s)
+	double duration;
+	/// the seed of the random generators
+	std::string seed;
+	std::string infrastructure;
+	std::string topology;
+	std::string profile;
+};
+
+
+/// A scenario being run
+struct run_t
+{
+	const scenario_t *scenario;
+	std::chrono::steady_clock::time_point start;
+};
+
+
+static void usage(std::ostream &stream, const std::string &progname)
+{
+	stream << progname << " [-h] -b batch_path -o output_folder [-j jobs] [-c cache_folder]" << std::endl;
+	stream << "\t-h                     print this message and exit" << std::endl;
+	stream << "\t-b <batch_path>        file of the scenarios, one per line:" << std::endl;
+	stream << "\t                       name duration_s seed infrastructure_path topology_path profile_path" << std::endl;
+	stream << "\t-o <output_folder>     folder of the results, each scenario writes its logs, probes" << std::endl;
+	stream << "\t                       and console output in a sub-folder named after it" << std::endl;
+	stream << "\t-j <jobs>              number of scenarios run at the same time, the number of cores by default" << std::endl;
+	stream << "\t-c <cache_folder>      folder of the compiled configuration cache shared by the scenarios" << std::endl;
+}
+
+
+/**
+ * @brief Read the scenarios of a batch, the empty lines and the ones
+ *        starting with '#' are ignored
+ *
+ * @param path       The batch file
+ * @param scenarios  The scenarios read
+ * @return true on success, false otherwise
+ */
+static bool readBatch(const std::string &path, std::vector<scenario_t> &scenarios)
+{
+	std::ifstream batch{path};
+	if(!batch)
+	{
+		std::cerr << "cannot open the batch file " << path << std::endl;
+		return false;
+	}
+
+	std::string line;
+	unsigned int line_number = 0;
+	while(std::getline(batch, line))
+	{
+		++line_number;
+		std::istringstream fields{line};
+		scenario_t scenario;
+		if(!(fields >> scenario.name) || scenario.name[0] == '#')
+		{
+			continue;
+		}
+		if(!(fields >> scenario.duration >> scenario.seed >> scenario.infrastructure >>
+		     scenario.topology >> scenario.profile) || scenario.duration <= 0)
+		{
+			std::cerr << path << ":" << line_number << ": invalid scenario" << std::endl;
+			return false;
+		}
+		for(auto &&other: scenarios)
+		{
+			if(other.name == scenario.name)
+			{
+				std::cerr << path << ":" << line_number << ": scenario "
+				          << scenario.name << " already defined" << std::endl;
+				return false;
+			}
+		}
+		scenarios.push_back(scenario);
+	}
+	return true;
+}
+
+
+/**
+ * @brief Run a scenario, in the process forked for it
+ *
+ * @param progname  The name of the program
+ * @param scenario  The scenario
+ * @param folder    The folder of the scenario results
+ * @param cache     The folder of the configuration cache, may be empty
+ * @return the exit status of the process, as opensand
+ */
+static int runScenario(const std::string &progname,
+                       const scenario_t &scenario,
+                       const std::string &folder,
+                       const std::string &cache)
+{
+	int console = open((folder + "/console.log").c_str(),
+	                   O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if(console >= 0)
+	{
+		dup2(console, STDOUT_FILENO);
+		dup2(console, STDERR_FILENO);
+		close(console);
+	}
+
+	std::vector<std::string> arguments{progname,
+	                                   "-i", scenario.infrastructure,
+	                                   "-t", scenario.topology,
+	                                   "-p", scenario.profile,
+	                                   "-o", folder,
+	                                   "-s", scenario.seed};
+	if(!cache.empty())
+	{
+		arguments.push_back("-c");
+		arguments.push_back(cache);
+	}
+	std::vector<char *> argv;
+	for(auto &&argument: arguments)
+	{
+		argv.push_back(&argument[0]);
+	}
+	argv.push_back(nullptr);
+
+	// the batch options were parsed by the parent
+	optind = 1;
+	int status = -1;
+	auto entity = Entity::parseArguments(argv.size() - 1, argv.data(), status);
+	if(status != 0 || entity == nullptr)
+	{
+		return status;
+	}
+
+	// whatever the infrastructure says, the scenario runs in virtual
+	// time up to its duration
+	Rt::setVirtualTime();
+	if(!entity->createBlocks())
+	{
+		std::cerr << progname << ": error: unable to create specific blocks" << std::endl;
+		return 102;
+	}
+	Rt::setVirtualTimeLimit(static_cast<uint64_t>(scenario.duration * 1e9));
+
+	if(!entity->run())
+	{
+		std::cerr << progname << ": error during entity execution" << std::endl;
+		return 103;
+	}
+	return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+	const std::string progname = argv[0];
+	std::string batch_path;
+	std::string output_folder;
+	std::string cache_folder;
+	long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+
+	int opt;
+	while((opt = getopt(argc, argv, "hb:o:j:c:")) != EOF)
+	{
+		switch(opt)
+		{
+		case 'b':
+			batch_path = optarg;
+			break;
+		case 'o':
+			output_folder = optarg;
+			break;
+		case 'j':
+			jobs = std::strtol(optarg, nullptr, 10);
+			break;
+		case 'c':
+			cache_folder = optarg;
+			break;
+		case 'h':
+			usage(std::cout, progname);
+			return 0;
+		default:
+			usage(std::cerr, progname);
+			return 1;
+		}
+	}
+	if(batch_path.empty() || output_folder.empty() || jobs <= 0)
+	{
+		usage(std::cerr, progname);
+		return 1;
+	}
+
+	std::vector<scenario_t> scenarios;
+	if(!readBatch(batch_path, scenarios))
+	{
+		return 2;
+	}
+	if(mkdir(output_folder.c_str(), 0755) != 0 && errno != EEXIST)
+	{
+		std::cerr << progname << ": error: cannot create " << output_folder
+		          << ": " << std::strerror(errno) << std::endl;
+		return 3;
+	}
+
+	// loaded once, the processes of the scenarios share the plugins
+	// and their generated configuration with the parent
+	if(!Plugin::loadPlugins(true))
+	{
+		std::cerr << progname << ": error: unable to load plugins" << std::endl;
+		return 100;
+	}
+
+	std::map<pid_t, run_t> running;
+	std::size_t next = 0;
+	unsigned int failures = 0;
+	while(next < scenarios.size() || !running.empty())
+	{
+		while(next < scenarios.size() && running.size() < static_cast<std::size_t>(jobs))
+		{
+			const scenario_t &scenario = scenarios[next++];
+			std::string folder = output_folder + "/" + scenario.name;
+			if(mkdir(folder.c_str(), 0755) != 0 && errno != EEXIST)
+			{
+				std::cerr << scenario.name << ": cannot create " << folder
+				          << ": " << std::strerror(errno) << std::endl;
+				++failures;
+				continue;
+			}
+
+			// flush before forking so the child does not write it again
+			std::cout.flush();
+			pid_t pid = fork();
+			if(pid < 0)
+			{
+				std::cerr << scenario.name << ": cannot fork: " << std::strerror(errno) << std::endl;
+				++failures;
+				continue;
+			}
+			if(pid == 0)
+			{
+				int status = runScenario(progname, scenario, folder, cache_folder);
+				Plugin::releasePlugins();
+				std::exit(status);
+			}
+			running[pid] = {&scenario, std::chrono::steady_clock::now()};
+		}
+
+		int status;
+		pid_t pid = wait(&status);
+		if(pid < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			break;
+		}
+		auto run = running.find(pid);
+		if(run == running.end())
+		{
+			continue;
+		}
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - run->second.start;
+		std::cout << run->second.scenario->name << ": ";
+		if(WIFEXITED(status) && WEXITSTATUS(status) == 0)
+		{
+			std::cout << "done";
+		}
+		else
+		{
+			++failures;
+			if(WIFEXITED(status))
+			{
+				std::cout << "failed with status " << WEXITSTATUS(status);
+			}
+			else
+			{
+				std::cout << "killed by signal " << WTERMSIG(status);
+			}
+		}
+		std::cout << " in " << elapsed.count() << " s" << std::endl;
+		running.erase(run);
+	}
+
+	Plugin::releasePlugins();
+	std::cout << scenarios.size() - failures << "/" << scenarios.size()
+	          << " scenarios succeeded" << std::endl;
+	return failures == 0 ? 0 : 4;
+}
@@ -540,6 +540,7 @@ def create_platform_infrastructure(project):
                 gateway['udp_stack'] = _get_parameter(entity_gw, 'udp_stack')
                 gateway['udp_rmem'] = _get_parameter(entity_gw, 'udp_rmem')
                 gateway['udp_wmem'] = _get_parameter(entity_gw, 'udp_wmem')
+                gateway['data_carrier_backend'] = _get_parameter(entity_gw, 'data_carrier_backend')
                 infrastructure['gateways'][entity_id] = gateway
         elif entity_type == "Gateway Net Access":
             entity_gw_net_acc = entity.get_component('entity_gw_net_acc')
@@ -569,6 +570,7 @@ def create_platform_infrastructure(project):
                 gateway['udp_stack'] = _get_parameter(entity_gw_phy, 'udp_stack')
                 gateway['udp_rmem'] = _get_parameter(entity_gw_phy, 'udp_rmem')
                 gateway['udp_wmem'] = _get_parameter(entity_gw_phy, 'udp_wmem')
+                gateway['data_carrier_backend'] = _get_parameter(entity_gw_phy, 'data_carrier_backend')
                 infrastructure['gateways'][entity_id] = gateway
         elif entity_type == "Terminal":
             entity_st = entity.get_component('entity_st')
@@ -597,51 +599,23 @@ def create_platform_infrastructure(project):
         if infra is None:
             continue
 
+        # the list items are created and filled in a single call each
         satellites = infra.get_list('satellites')
         if satellites is not None:
             satellites.clear_items()
-
-        for satellite in infrastructure['satellite'].values():
-            sat = _create_list_item(infra, 'satellites')
-            _set_parameter(sat, 'entity_id', satellite.get('entity_id'))
-            _set_parameter(sat, 'emu_address', satellite.get('emu_address'))
+            satellites.add_items(list(infrastructure['satellite'].values()))
 
         _set_parameter(infra, 'default_gw', 0)
 
         gateways = infra.get_list('gateways')
         if gateways is not None:
             gateways.clear_items()
-
-        for gateway in infrastructure['gateways'].values():
-            gw = _create_list_item(infra, 'gateways')
-            _set_parameter(gw, 'entity_id', gateway.get('entity_id'))
-            _set_parameter(gw, 'emu_address', gateway.get('emu_address'))
-            _set_parameter(gw, 'mac_address', gateway.get('mac_address'))
-            _set_parameter(gw, 'ctrl_multicast_address', gateway.get('ctrl_multicast_address'))
-            _set_parameter(gw, 'data_multicast_address', gateway.get('data_multicast_address'))
-            _set_parameter(gw, 'ctrl_out_st_port', gateway.get('ctrl_out_st_port'))
-            _set_parameter(gw, 'ctrl_in_st_port', gateway.get('ctrl_in_st_port'))
-            _set_parameter(gw, 'ctrl_out_gw_port', gateway.get('ctrl_out_gw_port'))
-            _set_parameter(gw, 'ctrl_in_gw_port', gateway.get('ctrl_in_gw_port'))
-            _set_parameter(gw, 'logon_out_port', gateway.get('logon_out_port'))
-            _set_parameter(gw, 'logon_in_port', gateway.get('logon_in_port'))
-            _set_parameter(gw, 'data_out_st_port', gateway.get('data_out_st_port'))
-            _set_parameter(gw, 'data_in_st_port', gateway.get('data_in_st_port'))
-            _set_parameter(gw, 'data_out_gw_port', gateway.get('data_out_gw_port'))
-            _set_parameter(gw, 'data_in_gw_port', gateway.get('data_in_gw_port'))
-            _set_parameter(gw, 'udp_stack', gateway.get('udp_stack'))
-            _set_parameter(gw, 'udp_rmem', gateway.get('udp_rmem'))
-            _set_parameter(gw, 'udp_wmem', gateway.get('udp_wmem'))
+            gateways.add_items(list(infrastructure['gateways'].values()))
 
         terminals = infra.get_list('terminals')
         if terminals is not None:
             terminals.clear_items()
-
-        for terminal in infrastructure['terminals'].values():
-            st = _create_list_item(infra, 'terminals')
-            _set_parameter(st, 'entity_id', terminal.get('entity_id'))
-            _set_parameter(st, 'emu_address', terminal.get('emu_address'))
-            _set_parameter(st, 'mac_address', terminal.get('mac_address'))
+            terminals.add_items(list(infrastructure['terminals'].values()))
 
         py_opensand_conf.toXML(xml, filepath.as_posix())
 
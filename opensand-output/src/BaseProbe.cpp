@@ -34,6 +34,119 @@
  */
 
 #include "BaseProbe.h"
+#include "HistogramProbe.h"
+
+#include <cmath>
+
+
+ProbeValue::ProbeValue(const BaseProbe &probe):
+  probe(&probe),
+  type(probe.getDataType()),
+  empty(true),
+  value(),
+  histogram(),
+  text()
+{
+}
+
+
+ProbeValue::ProbeValue(const BaseProbe &probe, int32_t value):
+  probe(&probe),
+  type(INT32_TYPE),
+  empty(false),
+  value(),
+  histogram(),
+  text()
+{
+  this->value.int32 = value;
+}
+
+
+ProbeValue::ProbeValue(const BaseProbe &probe, float value):
+  probe(&probe),
+  type(FLOAT_TYPE),
+  empty(false),
+  value(),
+  histogram(),
+  text()
+{
+  this->value.real32 = value;
+}
+
+
+ProbeValue::ProbeValue(const BaseProbe &probe, double value):
+  probe(&probe),
+  type(DOUBLE_TYPE),
+  empty(false),
+  value(),
+  histogram(),
+  text()
+{
+  this->value.real64 = value;
+}
+
+
+ProbeValue::ProbeValue(const BaseProbe &probe, std::shared_ptr<const HistogramValue> histogram):
+  probe(&probe),
+  type(HISTOGRAM_TYPE),
+  empty(false),
+  value(),
+  histogram(histogram),
+  text()
+{
+  this->value.real64 = histogram->p99;
+}
+
+
+const std::string &ProbeValue::getName() const
+{
+  return this->probe->name;
+}
+
+
+const std::string &ProbeValue::toString() const
+{
+  if(!this->empty && this->text.empty())
+  {
+    switch(this->type)
+    {
+      case INT32_TYPE:
+        this->text = std::to_string(this->value.int32);
+        break;
+      case FLOAT_TYPE:
+        this->text = std::to_string(this->value.real32);
+        break;
+      case DOUBLE_TYPE:
+        this->text = std::to_string(this->value.real64);
+        break;
+      case HISTOGRAM_TYPE:
+      {
+        // no space nor semicolon, the text goes in the CSV files and
+        // the text statistics datagrams
+        const HistogramValue &histogram = *this->histogram;
+        std::string text = "count=" + std::to_string(histogram.count) +
+                           ",sum=" + std::to_string(histogram.sum) +
+                           ",p50=" + std::to_string(histogram.p50) +
+                           ",p90=" + std::to_string(histogram.p90) +
+                           ",p99=" + std::to_string(histogram.p99) +
+                           ",max=" + std::to_string(histogram.max) +
+                           ",buckets=";
+        for(auto bucket = histogram.buckets.begin(); bucket != histogram.buckets.end(); ++bucket)
+        {
+          if(bucket != histogram.buckets.begin())
+          {
+            text += "/";
+          }
+          text += std::to_string(HistogramProbe::getLowerBound(bucket->first)) + ":" +
+                  std::to_string(bucket->second);
+        }
+        this->text = text;
+        break;
+      }
+    }
+  }
+  return this->text;
+}
 
 
 BaseProbe::BaseProbe(const std::string& name, const std::string& unit, bool enabled, sample_type_t sample_type):
@@ -41,7 +154,12 @@ BaseProbe::BaseProbe(const std::string& name, const std::string& unit, bool enab
   unit(unit),
   enabled(enabled),
   s_type(sample_type),
-  values_count(0)
+  sampling(SAMPLING_ALL),
+  sampling_period(1),
+  sampling_threshold(0),
+  sampled_periods(0),
+  has_sent_value(false),
+  sent_value(0)
 {
 }
 
@@ -53,11 +171,50 @@ BaseProbe::~BaseProbe()
 
 void BaseProbe::enable(bool enabled)
 {
-  this->enabled = enabled;
+  this->enabled.store(enabled, std::memory_order_relaxed);
+}
+
+
+void BaseProbe::setSampling(sampling_policy_t policy, unsigned int period, double threshold)
+{
+  this->sampling = policy;
+  this->sampling_period = period ? period : 1;
+  this->sampling_threshold = threshold;
+  this->sampled_periods = 0;
+  this->has_sent_value = false;
+}
+
+
+bool BaseProbe::isSampledPeriod()
+{
+  if(this->sampling != SAMPLING_WINDOW)
+  {
+    return true;
+  }
+  if(++this->sampled_periods < this->sampling_period)
+  {
+    return false;
+  }
+  this->sampled_periods = 0;
+  return true;
 }
 
 
-void BaseProbe::reset()
+bool BaseProbe::isSampledValue(double value)
 {
-  this->values_count = 0; 
+  if(this->sampling != SAMPLING_ON_CHANGE)
+  {
+    return true;
+  }
+  if(this->has_sent_value)
+  {
+    double change = std::fabs(value - this->sent_value);
+    if(change == 0 || change < this->sampling_threshold)
+    {
+      return false;
+    }
+  }
+  this->has_sent_value = true;
+  this->sent_value = value;
+  return true;
 }
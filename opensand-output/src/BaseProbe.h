@@ -36,7 +36,12 @@
 #ifndef _BASE_PROBE_H
 #define _BASE_PROBE_H
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 
 /**
@@ -51,10 +56,122 @@ enum sample_type_t
   SAMPLE_SUM     /*!< Calculate the sum */
 };
 
+/**
+ * @brief Probe sampling policy, deciding at each probes sending whether
+ *        the value of the probe is sent
+ **/
+enum sampling_policy_t
+{
+  SAMPLING_ALL,       /*!< Send the value of each period */
+  SAMPLING_WINDOW,    /*!< Accumulate the values over a window of periods
+                           with the sample type and send them once per window */
+  SAMPLING_ON_CHANGE  /*!< Send the value only if it moved by more than
+                           a threshold since the last value sent */
+};
+
 enum datatype_t {
   INT32_TYPE = 0,
   FLOAT_TYPE = 1,
-  DOUBLE_TYPE = 2
+  DOUBLE_TYPE = 2,
+  HISTOGRAM_TYPE = 3
+};
+
+
+/**
+ * @brief The distribution of the values put in a histogram probe
+ *        between two sendings (see HistogramProbe.h)
+ **/
+struct HistogramValue
+{
+  uint64_t count;
+  uint64_t sum;
+  uint64_t max;
+  /// the 50th, 90th and 99th percentiles
+  uint64_t p50;
+  uint64_t p90;
+  uint64_t p99;
+  /// the non empty buckets as (bucket index, values count), by index
+  std::vector<std::pair<uint32_t, uint64_t>> buckets;
+};
+
+
+class BaseProbe;
+
+
+/**
+ * @class the value of a probe taken for the statistics handlers
+ */
+class ProbeValue
+{
+public:
+  /**
+   * @brief Create an empty value, the probe got no value since the last sending
+   *
+   * @param probe  The probe the value is taken from
+   **/
+  ProbeValue(const BaseProbe &probe);
+
+  ProbeValue(const BaseProbe &probe, int32_t value);
+  ProbeValue(const BaseProbe &probe, float value);
+  ProbeValue(const BaseProbe &probe, double value);
+
+  /**
+   * @brief Create the value of a histogram probe, its scalar value
+   *        is the 99th percentile
+   *
+   * @param probe      The probe the value is taken from
+   * @param histogram  The distribution of the values
+   **/
+  ProbeValue(const BaseProbe &probe, std::shared_ptr<const HistogramValue> histogram);
+
+  /**
+   * @brief Get the name of the probe
+   *
+   * @return the name of the probe
+   **/
+  const std::string &getName() const;
+
+  /**
+   * @brief Check whether the probe got no value
+   *
+   * @return true if there is no value
+   **/
+  inline bool isEmpty() const { return this->empty; };
+
+  /**
+   * @brief Get the type of the value
+   *
+   * @return the value type
+   **/
+  inline datatype_t getDataType() const { return this->type; };
+
+  inline int32_t getInt32() const { return this->value.int32; };
+  inline float getFloat() const { return this->value.real32; };
+  inline double getDouble() const { return this->value.real64; };
+  inline const HistogramValue &getHistogram() const { return *this->histogram; };
+
+  /**
+   * @brief Get the value formatted as text, formatted once
+   *        for all the handlers
+   *
+   * @return the formatted value, empty if there is no value
+   **/
+  const std::string &toString() const;
+
+private:
+  const BaseProbe *probe;
+  datatype_t type;
+  bool empty;
+  union
+  {
+    int32_t int32;
+    float real32;
+    double real64;
+  } value;
+  /// the distribution of a histogram value
+  std::shared_ptr<const HistogramValue> histogram;
+
+  mutable std::string text;
 };
 
 
@@ -64,6 +181,7 @@ enum datatype_t {
 class BaseProbe
 {
   friend class Output;
+  friend class ProbeValue;
 
 public:
 
@@ -79,7 +197,7 @@ public:
    *
    * @return true if the probe is currently enabled
    **/
-  inline bool isEnabled() const { return this->enabled; };
+  inline bool isEnabled() const { return this->enabled.load(std::memory_order_relaxed); };
 
   /**
    * @brief Get the name of the probe
@@ -95,6 +213,23 @@ public:
    **/
   inline const std::string getUnit() const { return this->unit; };
 
+  /**
+   * @brief Set the sampling policy of the probe
+   *
+   * @param policy     The sampling policy
+   * @param period     The number of periods of a window (SAMPLING_WINDOW)
+   * @param threshold  The change needed to send a new value (SAMPLING_ON_CHANGE),
+   *                   0 to send any change
+   **/
+  void setSampling(sampling_policy_t policy, unsigned int period, double threshold);
+
+  /**
+   * @brief Get the sampling policy of the probe
+   *
+   * @return the sampling policy
+   **/
+  inline sampling_policy_t getSampling() const { return this->sampling; };
+
   /**
    * @brief get the byte size of data
    *
@@ -109,6 +244,13 @@ public:
    **/
   virtual std::string getData() = 0;
 
+  /**
+   * @brief take the value accumulated since the last sending
+   *
+   * @return the value, empty if the probe got no value
+   **/
+  virtual ProbeValue takeValue() = 0;
+
   /**
    * @brief get data type
    *
@@ -117,23 +259,53 @@ public:
   virtual datatype_t getDataType() const = 0;
 
   /**
-   * @brief reset values count
+   * @brief drop the values put since the last data retrieval
    *
    **/
-  void reset();
+  virtual void reset() = 0;
 
-  inline bool isEmpty() const { return values_count == 0; };
+  /**
+   * @brief Check if no value was put since the last data retrieval
+   *
+   * @return true if there is no value in the probe
+   **/
+  virtual bool isEmpty() const = 0;
 
 protected:
   BaseProbe(const std::string &name, const std::string& unit, bool enabled, sample_type_t sample_type);
 
+  /**
+   * @brief Check whether the values are taken at this probes sending,
+   *        otherwise they keep accumulating for the end of the window
+   *
+   * @return true if the values are taken, false otherwise
+   **/
+  bool isSampledPeriod();
+
+  /**
+   * @brief Check whether a value taken is sent according to the last
+   *        value sent
+   *
+   * @param value  The value taken
+   * @return true if the value is sent, false otherwise
+   **/
+  bool isSampledValue(double value);
+
   std::string name;
   std::string unit;
-  bool enabled;
+  /// changed by the output configuration while the probe is used
+  std::atomic<bool> enabled;
   sample_type_t s_type;
 
-  /// the number of values in probe
-  uint16_t values_count;
+  /// the sampling policy, only used by the probes sending
+  sampling_policy_t sampling;
+  unsigned int sampling_period;
+  double sampling_threshold;
+  /// the number of sendings since the beginning of the window
+  unsigned int sampled_periods;
+  /// the last value sent, for the on change policy
+  bool has_sent_value;
+  double sent_value;
 };
 
 #endif
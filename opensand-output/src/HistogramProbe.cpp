@@ -0,0 +1,237 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file HistogramProbe.cpp
+ * @brief The HistogramProbe class represents a probe keeping the
+ *        distribution of its values.
+ * @author Viveris Technologies
+ */
+
+#include "HistogramProbe.h"
+
+#include <algorithm>
+
+
+/// the shard of the calling thread, the threads are spread over the shards
+/// in the order of their first value
+static std::atomic<unsigned int> next_shard{0};
+static thread_local unsigned int thread_shard = next_shard++;
+
+
+HistogramProbe::HistogramProbe(const std::string &name, const std::string& unit, bool enabled):
+  BaseProbe(name, unit, enabled, SAMPLE_SUM)
+{
+  for(auto &shard : this->shards)
+  {
+    for(auto &count : shard.counts)
+    {
+      count = 0;
+    }
+    shard.sum = 0;
+    shard.max = 0;
+  }
+}
+
+
+HistogramProbe::~HistogramProbe()
+{
+}
+
+
+unsigned int HistogramProbe::getBucket(uint64_t value)
+{
+  constexpr uint64_t linear = uint64_t(1) << precision_bits;
+  if(value < linear)
+  {
+    return value;
+  }
+  if(value > max_value)
+  {
+    value = max_value;
+  }
+
+  // keep the precision_bits most significant bits of the value: its
+  // power of two selects the group and the next bits the bucket in it
+  unsigned int shift = 63 - __builtin_clzll(value) - (precision_bits - 1);
+  return shift * (linear / 2) + (value >> shift);
+}
+
+
+uint64_t HistogramProbe::getLowerBound(unsigned int bucket)
+{
+  constexpr unsigned int linear = 1 << precision_bits;
+  if(bucket < linear)
+  {
+    return bucket;
+  }
+  unsigned int shift = bucket / (linear / 2) - 1;
+  return uint64_t(bucket - shift * (linear / 2)) << shift;
+}
+
+
+uint64_t HistogramProbe::getUpperBound(unsigned int bucket)
+{
+  if(bucket + 1 >= buckets_count)
+  {
+    return max_value;
+  }
+  return getLowerBound(bucket + 1) - 1;
+}
+
+
+void HistogramProbe::put(uint64_t value)
+{
+  // a disabled probe is not sent, its value is not worth accumulating
+  if(!this->isEnabled())
+  {
+    return;
+  }
+
+  Shard &shard = this->shards[thread_shard % shards_count];
+  uint64_t previous = shard.max.load(std::memory_order_relaxed);
+  while(previous < value &&
+        !shard.max.compare_exchange_weak(previous, value, std::memory_order_relaxed));
+  shard.sum.fetch_add(value, std::memory_order_relaxed);
+  shard.counts[getBucket(value)].fetch_add(1, std::memory_order_relaxed);
+}
+
+
+std::shared_ptr<HistogramValue> HistogramProbe::swap()
+{
+  uint64_t counts[buckets_count] = {};
+  uint64_t count = 0;
+  uint64_t sum = 0;
+  uint64_t max = 0;
+  for(auto &shard : this->shards)
+  {
+    for(unsigned int bucket = 0; bucket < buckets_count; ++bucket)
+    {
+      // only write the counters that changed, the others stay shared
+      // with the threads putting values
+      if(shard.counts[bucket].load(std::memory_order_relaxed) != 0)
+      {
+        uint64_t taken = shard.counts[bucket].exchange(0, std::memory_order_relaxed);
+        counts[bucket] += taken;
+        count += taken;
+      }
+    }
+    sum += shard.sum.exchange(0, std::memory_order_relaxed);
+    max = std::max(max, shard.max.exchange(0, std::memory_order_relaxed));
+  }
+  if(count == 0)
+  {
+    return nullptr;
+  }
+
+  auto histogram = std::make_shared<HistogramValue>();
+  histogram->count = count;
+  histogram->sum = sum;
+  histogram->max = max;
+
+  // a percentile is the upper bound of the bucket of its rank, or the
+  // maximum value when it is in that bucket
+  const double quantiles[] = {0.5, 0.9, 0.99};
+  uint64_t *percentiles[] = {&histogram->p50, &histogram->p90, &histogram->p99};
+  unsigned int quantile = 0;
+  uint64_t cumulated = 0;
+  for(unsigned int bucket = 0; bucket < buckets_count; ++bucket)
+  {
+    if(counts[bucket] == 0)
+    {
+      continue;
+    }
+    histogram->buckets.emplace_back(bucket, counts[bucket]);
+    cumulated += counts[bucket];
+    while(quantile < 3 && cumulated >= quantiles[quantile] * count)
+    {
+      uint64_t value = getUpperBound(bucket);
+      if(getLowerBound(bucket) <= max && max < value)
+      {
+        value = max;
+      }
+      *percentiles[quantile++] = value;
+    }
+  }
+  return histogram;
+}
+
+
+void HistogramProbe::reset()
+{
+  this->swap();
+}
+
+
+bool HistogramProbe::isEmpty() const
+{
+  for(auto &shard : this->shards)
+  {
+    for(auto &count : shard.counts)
+    {
+      if(count.load(std::memory_order_relaxed) != 0)
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+
+size_t HistogramProbe::getDataSize() const
+{
+  return sizeof(uint64_t);
+}
+
+
+datatype_t HistogramProbe::getDataType() const
+{
+  return HISTOGRAM_TYPE;
+}
+
+
+std::string HistogramProbe::getData()
+{
+  return this->takeValue().toString();
+}
+
+
+ProbeValue HistogramProbe::takeValue()
+{
+  // a window keeps accumulating in the counters until its end
+  if(!this->isSampledPeriod())
+  {
+    return ProbeValue(*this);
+  }
+  std::shared_ptr<HistogramValue> histogram = this->swap();
+  if(histogram == nullptr || !this->isSampledValue(histogram->p99))
+  {
+    return ProbeValue(*this);
+  }
+  return ProbeValue(*this, histogram);
+}
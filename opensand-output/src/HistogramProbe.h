@@ -0,0 +1,138 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file HistogramProbe.h
+ * @brief The HistogramProbe class represents a probe keeping the
+ *        distribution of its values.
+ * @author Viveris Technologies
+ */
+
+
+#ifndef _HISTOGRAM_PROBE_H
+#define _HISTOGRAM_PROBE_H
+
+#include "BaseProbe.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+
+/**
+ * @class the histogram probe representation
+ *
+ * The values are counted in log-linear buckets: one bucket per value
+ * below 16, then 8 buckets per power of two, so that a bucket spans at
+ * most 1/8 of its lower bound and the memory does not depend on the
+ * values. The values above 2^40 - 1 are counted in the last bucket.
+ *
+ * Each thread putting values works on one of a few shards of counters,
+ * without lock, and the probes sending takes and clears the counters of
+ * all the shards, the values put meanwhile are sent at the next sending.
+ */
+class HistogramProbe : public BaseProbe
+{
+  friend class Output;
+  friend class LockSite;
+
+public:
+  /// the number of linear buckets per power of two (2^precision_bits / 2)
+  static constexpr unsigned int precision_bits = 4;
+  /// the largest value counted in its own bucket
+  static constexpr uint64_t max_value = (uint64_t(1) << 40) - 1;
+  static constexpr unsigned int buckets_count =
+    (40 - precision_bits) * (1 << (precision_bits - 1)) + (1 << precision_bits);
+
+  virtual ~HistogramProbe();
+
+  /**
+   * @brief adds a value to the probe, to be sent when \send_probes is called.
+   *        Nothing is done if the probe is disabled.
+   *
+   * @param value The value to add to the probe
+   **/
+  void put(uint64_t value);
+
+  size_t getDataSize() const;
+
+  std::string getData();
+
+  ProbeValue takeValue();
+
+  datatype_t getDataType() const;
+
+  void reset();
+
+  bool isEmpty() const;
+
+  /**
+   * @brief Get the bucket a value is counted in
+   *
+   * @param value  The value
+   * @return the bucket index
+   **/
+  static unsigned int getBucket(uint64_t value);
+
+  /**
+   * @brief Get the smallest and the largest values of a bucket
+   *
+   * @param bucket  The bucket index
+   * @return the value
+   **/
+  static uint64_t getLowerBound(unsigned int bucket);
+  static uint64_t getUpperBound(unsigned int bucket);
+
+private:
+  HistogramProbe(const std::string &name, const std::string& unit, bool enabled);
+
+  /// the number of shards the threads are spread over
+  static constexpr unsigned int shards_count = 4;
+
+  /**
+   * @brief The counters of the threads of a shard, on their own cache lines
+   */
+  struct alignas(64) Shard
+  {
+    std::atomic<uint64_t> counts[buckets_count];
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+  };
+
+  /**
+   * @brief Take and clear the counters of all the shards
+   *
+   * @return the distribution, nullptr if there was no value
+   */
+  std::shared_ptr<HistogramValue> swap();
+
+  Shard shards[shards_count];
+};
+
+
+#endif
@@ -0,0 +1,254 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file LazyProbe.h
+ * @brief The probes registered on their first value, for the probes of
+ *        the many terminals or fifos that may never report anything.
+ * @author Viveris Technologies
+ */
+
+
+#ifndef _LAZY_PROBE_H
+#define _LAZY_PROBE_H
+
+#include "Output.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+
+template<typename T>
+class LazyProbe;
+
+
+/**
+ * @class ProbeFamily
+ * @brief The common description of probes whose names only differ by
+ *        a key, such as a terminal ID or a fifo name
+ *
+ * The section prefixing the probes of the registering thread is kept
+ * so that the probes registered later by another thread get the same
+ * name. The family must outlive its placeholders.
+ */
+template<typename T>
+class ProbeFamily
+{
+public:
+	/**
+	 * @brief Describe the probes named head + key + tail
+	 *
+	 * @param head     The beginning of the probes names
+	 * @param tail     The end of the probes names
+	 * @param unit     The probes unit
+	 * @param enabled  Whether the probes are enabled by default
+	 * @param type     The sample type
+	 */
+	ProbeFamily(const std::string &head, const std::string &tail,
+	            const std::string &unit, bool enabled, sample_type_t type):
+		prefix{Output::Get()->getProbesPrefix()},
+		head{head},
+		tail{tail},
+		unit{unit},
+		enabled{enabled},
+		type{type}
+	{
+	};
+
+	/**
+	 * @brief Get the placeholder of a probe, nothing is registered
+	 *
+	 * @param key  The key of the probe in its family
+	 * @return the placeholder
+	 */
+	LazyProbe<T> get(const std::string &key) const
+	{
+		return LazyProbe<T>(this, key);
+	};
+
+	/**
+	 * @brief Register a probe of the family
+	 *
+	 * @param key  The key of the probe in its family
+	 * @return the probe, nullptr if it cannot be registered
+	 */
+	std::shared_ptr<Probe<T>> create(const std::string &key) const
+	{
+		auto output = Output::Get();
+		std::string current = output->getProbesPrefix();
+		output->setProbesPrefix(this->prefix);
+		auto probe = output->registerProbe<T>(this->head + key + this->tail,
+		                                      this->unit, this->enabled, this->type);
+		output->setProbesPrefix(current);
+		return probe;
+	};
+
+private:
+	std::string prefix;
+	std::string head;
+	std::string tail;
+	std::string unit;
+	bool enabled;
+	sample_type_t type;
+};
+
+
+/**
+ * @class LazyProbe
+ * @brief A placeholder of a probe of a family, the probe is registered on
+ *        its first value or when explicitly asked, then the values go
+ *        straight to it. A placeholder is used by a single thread.
+ */
+template<typename T>
+class LazyProbe
+{
+	friend class ProbeFamily<T>;
+
+public:
+	/// A placeholder of no family, its values are dropped
+	LazyProbe(): family{nullptr}, key{}, probe{nullptr} {};
+
+	/**
+	 * @brief Add a value to the probe, registering it first if needed
+	 *
+	 * @param value  The value
+	 */
+	void put(T value)
+	{
+		if(this->probe == nullptr && !this->create())
+		{
+			return;
+		}
+		this->probe->put(value);
+	};
+
+	/**
+	 * @brief Add a value to the probe, a probe not registered yet is only
+	 *        registered by a value other than zero, the zeros of an idle
+	 *        terminal or fifo are not worth a probe
+	 *
+	 * @param value  The value
+	 */
+	void putNonZero(T value)
+	{
+		if(this->probe == nullptr && (value == 0 || !this->create()))
+		{
+			return;
+		}
+		this->probe->put(value);
+	};
+
+	/**
+	 * @brief Register the probe now if it is not already
+	 *
+	 * @return true if the probe is registered, false otherwise
+	 */
+	bool create()
+	{
+		if(this->probe != nullptr)
+		{
+			return true;
+		}
+		if(this->family == nullptr)
+		{
+			return false;
+		}
+		this->probe = this->family->create(this->key);
+		if(this->probe == nullptr)
+		{
+			// do not try again on each value
+			this->family = nullptr;
+			return false;
+		}
+		this->key.clear();
+		this->key.shrink_to_fit();
+		return true;
+	};
+
+	/**
+	 * @brief Check whether the probe is registered
+	 *
+	 * @return true if the probe is registered
+	 */
+	bool isRegistered() const { return this->probe != nullptr; };
+
+	/**
+	 * @brief Check whether the values are worth computing, a probe not
+	 *        registered yet may be enabled by its registration
+	 *
+	 * @return false if the values of the probe are dropped
+	 */
+	bool isEnabled() const
+	{
+		return this->probe != nullptr ? this->probe->isEnabled() : this->family != nullptr;
+	};
+
+private:
+	LazyProbe(const ProbeFamily<T> *family, const std::string &key):
+		family{family},
+		key{key},
+		probe{nullptr}
+	{
+	};
+
+	const ProbeFamily<T> *family;
+	std::string key;
+	std::shared_ptr<Probe<T>> probe;
+};
+
+
+/**
+ * @class LazyProbes
+ * @brief Own the families of single probes registered on their first value
+ */
+template<typename T>
+class LazyProbes
+{
+public:
+	/**
+	 * @brief Get the placeholder of a probe, nothing is registered
+	 *
+	 * @param name     The probe full name
+	 * @param unit     The probe unit
+	 * @param enabled  Whether the probe is enabled by default
+	 * @param type     The sample type
+	 * @return the placeholder, valid as long as this object
+	 */
+	LazyProbe<T> get(const std::string &name, const std::string &unit,
+	                 bool enabled, sample_type_t type)
+	{
+		this->families.push_back(std::make_unique<ProbeFamily<T>>(name, "", unit, enabled, type));
+		return this->families.back()->get("");
+	};
+
+private:
+	std::vector<std::unique_ptr<ProbeFamily<T>>> families;
+};
+
+
+#endif
@@ -43,10 +43,14 @@
 #include <algorithm>
 #include <cctype>
 #include <optional>
+#include <string_view>
 
 #include "Output.h"
 #include "OutputEvent.h"
+#include "OutputFileWriter.h"
 #include "OutputHandler.h"
+#include "OutputLogQueue.h"
+#include "OutputMetrics.h"
 
 
 class AlreadyExistsError : public std::runtime_error {
@@ -64,10 +68,11 @@ class OutputItem
 	OutputItem(const std::string& name, const std::string& full_name) : name(name), full_name(full_name) {}
 	virtual ~OutputItem() {}
 
-	std::string getFullName() const { return full_name; }
+	const std::string& getFullName() const { return full_name; }
 
 	virtual void setLogLevel(log_level_t level) = 0;
 	virtual void enableStats(bool enabled) = 0;
+	virtual void setStatsSampling(sampling_policy_t policy, unsigned int period, double threshold) = 0;
 	virtual void gatherEnabledStats(std::vector<std::shared_ptr<BaseProbe>>& probes) const = 0;
 
  protected:
@@ -100,6 +105,11 @@ class Output::OutputSection : public OutputItem
 			child.second->enableStats(enabled);
 		}
 	}
+	void setStatsSampling(sampling_policy_t policy, unsigned int period, double threshold) {
+		for (auto& child : children) {
+			child.second->setStatsSampling(policy, period, threshold);
+		}
+	}
 
 	void gatherEnabledStats(std::vector<std::shared_ptr<BaseProbe>>& probes) const {
 		for (auto& child : children) {
@@ -141,14 +151,6 @@ class Output::OutputSection : public OutputItem
 		}
 		return unit;
 	}
-	std::shared_ptr<OutputItem> find(const std::string& name) const {
-		auto child = children.find(name);
-		if (child == children.end()) {
-			return nullptr;
-		}
-		return child->second;
-	}
-
  private:
 	std::unordered_map<std::string, std::shared_ptr<OutputItem>> children;
 };
@@ -183,6 +185,11 @@ class OutputUnit : public OutputItem
 			stat.second->enable(enabled);
 		}
 	}
+	void setStatsSampling(sampling_policy_t policy, unsigned int period, double threshold) {
+		for (auto& stat : stats) {
+			stat.second->setSampling(policy, period, threshold);
+		}
+	}
 
 	void gatherEnabledStats(std::vector<std::shared_ptr<BaseProbe>>& probes) const {
 		for (auto& stat : stats) {
@@ -254,6 +261,40 @@ class OutputDesiredLogLevel
 };
 
 
+class OutputIndex
+{
+ public:
+	/**
+	 * @brief Find an item from its full name
+	 *
+	 * @param fullName  The item full name
+	 * @return the item, nullptr if it does not exist
+	 */
+	std::shared_ptr<OutputItem> find(std::string_view fullName) const {
+		auto item = items.find(fullName);
+		if (item == items.end()) {
+			return nullptr;
+		}
+		return item->second;
+	}
+
+	/**
+	 * @brief Add an item, indexed by its full name
+	 *
+	 * @param item  The item
+	 */
+	void add(std::shared_ptr<OutputItem> item) {
+		items.emplace(item->getFullName(), item);
+	}
+
+	void clear() { items.clear(); }
+
+ private:
+	/// the keys refer to the full names stored in the items
+	std::unordered_map<std::string_view, std::shared_ptr<OutputItem>> items;
+};
+
+
 inline std::string normalizeName(const std::string& name) {
 	std::string copy{name};
 	std::transform(name.begin(), name.end(), copy.begin(),
@@ -262,6 +303,15 @@ inline std::string normalizeName(const std::string& name) {
 }
 
 
+/// the section prefixing the probes registered by each thread
+static thread_local std::string probesPrefix;
+
+
+inline std::string normalizeProbeName(const std::string& name) {
+	return normalizeName(probesPrefix.empty() ? name : probesPrefix + "." + name);
+}
+
+
 inline std::vector<std::string> splitName(const std::string& name) {
 	std::istringstream line(name);
 	std::string token;
@@ -282,19 +332,30 @@ inline void logException(std::shared_ptr<OutputLog>& log, const std::exception&
 }
 
 
-Output::Output()
+Output::Output():
+	reportedDroppedLogs(0),
+	registeredProbes(0),
+	probeSettings(),
+	finalized(false)
 {
+	logQueue = std::make_shared<OutputLogQueue>();
 	root = std::make_shared<OutputSection>("", "");
+	items = std::make_shared<OutputIndex>();
 	desiredLogLevels = std::make_shared<OutputDesiredLogLevel>();
 	privateLog = registerLog(LEVEL_WARNING, "output");
 	defaultLog = registerLog(LEVEL_WARNING, "default");
+	logQueue->setReportLog(privateLog);
+	droppedLogs = registerProbe<int32_t>("output.dropped_logs", "messages", true, SAMPLE_SUM);
 }
 
 
 Output::~Output()
 {
+	logQueue->stop();
+	logQueue->setReportLog(nullptr);
 	privateLog = nullptr;
 	defaultLog = nullptr;
+	items->clear();
 	root = nullptr;
 	enabledProbes.clear();
 	logHandlers.clear();
@@ -318,18 +379,14 @@ std::shared_ptr<OutputEvent> Output::registerEvent(const std::string& identifier
 	}
 
 	OutputLock acquire{lock};
-	std::vector<std::string> parts = splitName(name);
-
-	std::string unitName = parts.back();
-	parts.pop_back();
-
 	try {
-		std::shared_ptr<OutputUnit> logUnit = getOrCreateSection(parts)->findUnit(unitName);
+		std::shared_ptr<OutputUnit> logUnit = getOrCreateUnit(name);
 		std::shared_ptr<OutputEvent> existingEvent = std::dynamic_pointer_cast<OutputEvent>(logUnit->getLog());
 		if (existingEvent != nullptr) {
 				return existingEvent;
 		}
 		std::shared_ptr<OutputEvent> event{new OutputEvent(logUnit->getFullName())};
+		event->queue = logQueue;
 		logUnit->setLog(event);
 
 		for (auto& handler : logHandlers) {
@@ -362,17 +419,15 @@ std::shared_ptr<OutputLog> Output::registerLog(log_level_t display_level, const
 		desiredLogLevel->setLogLevel(log_level);
 	}
 
-	std::string unitName = parts.back();
-	parts.pop_back();
-
 	try {
-		std::shared_ptr<OutputUnit> logUnit = getOrCreateSection(parts)->findUnit(unitName);
+		std::shared_ptr<OutputUnit> logUnit = getOrCreateUnit(name);
 		std::shared_ptr<OutputLog> existingLog = logUnit->getLog();
 		if (existingLog != nullptr) {
 				existingLog->setDisplayLevel(log_level);
 				return existingLog;
 		}
 		std::shared_ptr<OutputLog> log{new OutputLog(log_level, logUnit->getFullName())};
+		log->queue = logQueue;
 		logUnit->setLog(log);
 
 		for (auto& handler : logHandlers) {
@@ -409,6 +464,12 @@ std::shared_ptr<OutputLog> Output::registerLog(log_level_t default_display_level
 }
 
 
+std::size_t Output::getProbesCount() const
+{
+	return registeredProbes;
+}
+
+
 std::string Output::getEntityName() const
 {
 	if (this->entityName.empty()) {
@@ -418,7 +479,22 @@ std::string Output::getEntityName() const
 }
 
 
-bool Output::configureLocalOutput(const std::string& folder)
+void Output::setProbesPrefix(const std::string& prefix)
+{
+	probesPrefix = prefix;
+}
+
+
+std::string Output::getProbesPrefix() const
+{
+	return probesPrefix;
+}
+
+
+bool Output::configureLocalOutput(const std::string& folder,
+                                  std::size_t rotateSize,
+                                  unsigned int rotatePeriod,
+                                  bool compress)
 {
 	std::string entityName = getEntityName();
 
@@ -426,8 +502,8 @@ bool Output::configureLocalOutput(const std::string& folder)
 	std::shared_ptr<FileStatHandler> statHandler;
 
 	try {
-		logHandler = std::make_shared<FileLogHandler>(entityName, folder);
-		statHandler = std::make_shared<FileStatHandler>(entityName, folder);
+		logHandler = std::make_shared<FileLogHandler>(entityName, folder, rotateSize, rotatePeriod, compress);
+		statHandler = std::make_shared<FileStatHandler>(entityName, folder, rotateSize, rotatePeriod, compress);
 	} catch (const HandlerCreationFailedError& exc) {
 		logException(privateLog, exc);
 		return false;
@@ -439,13 +515,20 @@ bool Output::configureLocalOutput(const std::string& folder)
 
 	probeHandlers.push_back(statHandler);
 
+	if (compress && !OutputFileWriter::hasCompression()) {
+		privateLog->sendLog(LEVEL_WARNING,
+		                    "OpenSAND output built without zstd, the rotated files are not compressed");
+	}
+
+	logQueue->start();
 	return true;
 }
 
 
 bool Output::configureRemoteOutput(const std::string& address,
                                    unsigned short statsPort,
-                                   unsigned short logsPort)
+                                   unsigned short logsPort,
+                                   bool binaryStats)
 {
 	std::string entityName = getEntityName();
 
@@ -454,7 +537,7 @@ bool Output::configureRemoteOutput(const std::string& address,
 
 	try {
 		logHandler = std::make_shared<SocketLogHandler>(entityName, address, logsPort);
-		statHandler = std::make_shared<SocketStatHandler>(entityName, address, statsPort);
+		statHandler = std::make_shared<SocketStatHandler>(entityName, address, statsPort, false, binaryStats);
 	} catch (const HandlerCreationFailedError& exc) {
 		logException(privateLog, exc);
 		return false;
@@ -466,6 +549,41 @@ bool Output::configureRemoteOutput(const std::string& address,
 
 	probeHandlers.push_back(statHandler);
 
+	logQueue->start();
+	return true;
+}
+
+
+bool Output::configureShmOutput(const std::string& name)
+{
+	std::string entityName = getEntityName();
+
+	std::shared_ptr<ShmStatHandler> statHandler;
+	try {
+		statHandler = std::make_shared<ShmStatHandler>(entityName, name[0] == '/' ? name : "/" + name);
+	} catch (const HandlerCreationFailedError& exc) {
+		logException(privateLog, exc);
+		return false;
+	}
+
+	probeHandlers.push_back(statHandler);
+	return true;
+}
+
+
+bool Output::configureMetricsOutput(const std::string& address, unsigned short port)
+{
+	std::string entityName = getEntityName();
+
+	std::shared_ptr<MetricsStatHandler> statHandler;
+	try {
+		statHandler = std::make_shared<MetricsStatHandler>(entityName, address, port);
+	} catch (const HandlerCreationFailedError& exc) {
+		logException(privateLog, exc);
+		return false;
+	}
+
+	probeHandlers.push_back(statHandler);
 	return true;
 }
 
@@ -485,12 +603,23 @@ bool Output::configureTerminalOutput()
 	logHandlers.push_back(logHandler);
 	privateLog->addHandler(logHandler);
 	defaultLog->addHandler(logHandler);
+
+	logQueue->start();
 	return true;
 }
 
 
 void Output::finalizeConfiguration(void)
 {
+	// the locks sites created since the previous configuration
+	for (auto& probe : LockProfiler::takeProbes()) {
+		try {
+			registerProbe(probe.first, probe.second);
+		} catch (const AlreadyExistsError& exc) {
+			logException(privateLog, exc);
+		}
+	}
+
 	OutputLock acquire{lock};
 
 	enabledProbes.clear();
@@ -499,6 +628,7 @@ void Output::finalizeConfiguration(void)
 	for (auto& handler : probeHandlers) {
 		handler->configure(enabledProbes);
 	}
+	finalized = true;
 }
 
 
@@ -506,9 +636,16 @@ void Output::sendProbes(void)
 {
 	OutputLock acquire{lock};
 
-	std::vector<std::pair<std::string, std::string>> probesValues;
+	uint64_t dropped = logQueue->getDropped();
+	if (dropped != reportedDroppedLogs) {
+		droppedLogs->put(dropped - reportedDroppedLogs);
+		reportedDroppedLogs = dropped;
+	}
+
+	std::vector<ProbeValue> probesValues;
+	probesValues.reserve(enabledProbes.size());
 	for (auto& probe : enabledProbes) {
-		probesValues.emplace_back(probe->getName(), probe->getData());
+		probesValues.push_back(probe->takeValue());
 	}
 
 	for (auto& handler : probeHandlers) {
@@ -532,15 +669,84 @@ void Output::setDisplayLevel(log_level_t log_level)
 }
 
 
-std::shared_ptr<Output::OutputSection> Output::getOrCreateSection(const std::vector<std::string>& sectionNames)
+void Output::setLogRateLimit(unsigned int limit)
 {
-	std::shared_ptr<OutputSection> currentSection = root;
+	logQueue->setRateLimit(limit);
+}
 
-	for (auto& name : sectionNames) {
-		currentSection = currentSection->findSection(name);
+
+std::shared_ptr<Output::OutputSection> Output::getOrCreateSection(const std::string& fullName)
+{
+	if (fullName.empty()) {
+		return root;
 	}
 
-	return currentSection;
+	std::shared_ptr<OutputItem> item = items->find(fullName);
+	if (item != nullptr) {
+		std::shared_ptr<OutputSection> section = std::dynamic_pointer_cast<OutputSection>(item);
+		if (section == nullptr) {
+			std::stringstream message;
+			message << "Searching for section " << fullName << " but found Unit instead!";
+			throw AlreadyExistsError(message.str());
+		}
+		return section;
+	}
+
+	// only the creation walks up the tree
+	std::size_t separator = fullName.rfind('.');
+	std::shared_ptr<OutputSection> parent = separator == std::string::npos ?
+	                                        root : getOrCreateSection(fullName.substr(0, separator));
+	std::shared_ptr<OutputSection> section = parent->findSection(fullName.substr(separator + 1));
+	items->add(section);
+	return section;
+}
+
+
+std::shared_ptr<OutputUnit> Output::getOrCreateUnit(const std::string& fullName)
+{
+	std::shared_ptr<OutputItem> item = items->find(fullName);
+	if (item != nullptr) {
+		std::shared_ptr<OutputUnit> unit = std::dynamic_pointer_cast<OutputUnit>(item);
+		if (unit == nullptr) {
+			std::stringstream message;
+			message << "Searching for unit " << fullName << " but found Section instead!";
+			throw AlreadyExistsError(message.str());
+		}
+		return unit;
+	}
+
+	std::size_t separator = fullName.rfind('.');
+	std::shared_ptr<OutputSection> parent = separator == std::string::npos ?
+	                                        root : getOrCreateSection(fullName.substr(0, separator));
+	std::shared_ptr<OutputUnit> unit = parent->findUnit(fullName.substr(separator + 1));
+	items->add(unit);
+	return unit;
+}
+
+
+std::shared_ptr<OutputItem> Output::findItem(const std::string& fullName) const
+{
+	if (fullName.empty()) {
+		return root;
+	}
+
+	return items->find(fullName);
+}
+
+
+std::shared_ptr<BaseProbe> Output::findProbe(const std::string& fullName) const
+{
+	std::size_t separator = fullName.rfind('.');
+	if (separator == std::string::npos) {
+		return nullptr;
+	}
+
+	std::shared_ptr<OutputUnit> unit = std::dynamic_pointer_cast<OutputUnit>(
+		items->find(std::string_view(fullName).substr(0, separator)));
+	if (unit == nullptr) {
+		return nullptr;
+	}
+	return unit->getBaseStat(fullName.substr(separator + 1));
 }
 
 
@@ -550,22 +756,55 @@ void Output::registerProbe(const std::string& name, std::shared_ptr<BaseProbe> p
 		privateLog->sendLog(LEVEL_INFO, "Registering probe '%s'", name.c_str());
 	}
 
-	std::vector<std::string> parts = splitName(name);
+	OutputLock acquire{lock};
+	std::size_t separator = name.rfind('.');
+	getOrCreateUnit(name.substr(0, separator))->setStat(name.substr(separator + 1), probe);
+	registeredProbes++;
+	applySettings(name, *probe);
+
+	if (finalized && probe->isEnabled()) {
+		// the values of the new probe follow the ones already sent
+		std::size_t first = enabledProbes.size();
+		enabledProbes.push_back(probe);
+		for (auto& handler : probeHandlers) {
+			handler->addProbes(enabledProbes, first);
+		}
+	}
+}
 
-	std::string statName = parts.back();
-	parts.pop_back();
 
-	std::string unitName = parts.back();
-	parts.pop_back();
+void Output::keepSetting(const ProbeSetting& setting)
+{
+	probeSettings.erase(std::remove_if(probeSettings.begin(), probeSettings.end(),
+	                                   [&setting](const ProbeSetting& kept) {
+	                                     return kept.sampling == setting.sampling && kept.path == setting.path;
+	                                   }),
+	                    probeSettings.end());
+	probeSettings.push_back(setting);
+}
+
 
-	getOrCreateSection(parts)->findUnit(unitName)->setStat(statName, probe);
+void Output::applySettings(const std::string& name, BaseProbe& probe) const
+{
+	for (auto& setting : probeSettings) {
+		bool covered = name.compare(0, setting.path.size(), setting.path) == 0 &&
+		               (name.size() == setting.path.size() || name[setting.path.size()] == '.');
+		if (!covered) {
+			continue;
+		}
+		if (setting.sampling) {
+			probe.setSampling(setting.policy, setting.period, setting.threshold);
+		} else {
+			probe.enable(setting.enabled);
+		}
+	}
 }
 
 
 template<>
 std::shared_ptr<Probe<int32_t>> Output::registerProbe(const std::string& identifier, const std::string& unit, bool enabled, sample_type_t type)
 {
-	std::string name = normalizeName(identifier);
+	std::string name = normalizeProbeName(identifier);
 
 	std::shared_ptr<Probe<int32_t>> probe{new Probe<int32_t>(name, unit, enabled, type)};
 	try {
@@ -581,7 +820,7 @@ std::shared_ptr<Probe<int32_t>> Output::registerProbe(const std::string& identif
 template<>
 std::shared_ptr<Probe<float>> Output::registerProbe(const std::string& identifier, const std::string& unit, bool enabled, sample_type_t type)
 {
-	std::string name = normalizeName(identifier);
+	std::string name = normalizeProbeName(identifier);
 
 	std::shared_ptr<Probe<float>> probe{new Probe<float>(name, unit, enabled, type)};
 	try {
@@ -597,7 +836,7 @@ std::shared_ptr<Probe<float>> Output::registerProbe(const std::string& identifie
 template<>
 std::shared_ptr<Probe<double>> Output::registerProbe(const std::string& identifier, const std::string& unit, bool enabled, sample_type_t type)
 {
-	std::string name = normalizeName(identifier);
+	std::string name = normalizeProbeName(identifier);
 
 	std::shared_ptr<Probe<double>> probe{new Probe<double>(name, unit, enabled, type)};
 	try {
@@ -610,60 +849,89 @@ std::shared_ptr<Probe<double>> Output::registerProbe(const std::string& identifi
 }
 
 
+std::shared_ptr<HistogramProbe> Output::registerHistogram(const std::string& identifier, const std::string& unit, bool enabled)
+{
+	std::string name = normalizeProbeName(identifier);
+
+	std::shared_ptr<HistogramProbe> probe{new HistogramProbe(name, unit, enabled)};
+	try {
+		registerProbe(name, probe);
+	} catch (const AlreadyExistsError& exc) {
+		logException(privateLog, exc);
+		return nullptr;
+	}
+	return probe;
+}
+
+
+std::shared_ptr<HistogramProbe> Output::registerHistogram(const std::string& unit, bool enabled, const char *name, ...)
+{
+	std::va_list args;
+	va_start(args, name);
+	std::string probeName = formatMessage(name, args);
+	va_end(args);
+
+	return registerHistogram(probeName, unit, enabled);
+}
+
+
 void Output::setProbeState(const std::string& path, bool enabled) {
-	std::vector<std::string> parts = splitName(normalizeName(path));
-	if (parts.empty()) {
-		root->enableStats(enabled);
-	} else {
-		std::string possibleStatName = parts.back();
-		parts.pop_back();
-
-		std::shared_ptr<OutputItem> currentItem = root;
-		for (auto& name : parts) {
-			std::shared_ptr<OutputSection> currentSection = std::dynamic_pointer_cast<OutputSection>(currentItem);
-			if (currentSection == nullptr) { goto probe_not_found; }
-			currentItem = currentSection->find(name);
-		}
+	OutputLock acquire{lock};
 
-		std::shared_ptr<OutputSection> lastSection;
-		std::shared_ptr<OutputUnit> lastUnit;
-		if ((lastSection = std::dynamic_pointer_cast<OutputSection>(currentItem)) != nullptr) {
-			currentItem = lastSection->find(possibleStatName);
-			if (currentItem == nullptr) { goto probe_not_found; }
-			currentItem->enableStats(enabled);
-		} else if ((lastUnit = std::dynamic_pointer_cast<OutputUnit>(currentItem)) != nullptr) {
-			std::shared_ptr<BaseProbe> probe = lastUnit->getBaseStat(possibleStatName);
-			if (probe == nullptr) { goto probe_not_found; }
-			probe->enable(enabled);
-		} else {
-			goto probe_not_found;
-		}
+	std::string name = normalizeName(path);
+	keepSetting({name, false, enabled, SAMPLING_ALL, 0, 0.0});
+	std::shared_ptr<OutputItem> item = findItem(name);
+	if (item != nullptr) {
+		item->enableStats(enabled);
+		return;
+	}
+	std::shared_ptr<BaseProbe> probe = findProbe(name);
+	if (probe != nullptr) {
+		probe->enable(enabled);
+		return;
 	}
 
-	return;
+	if (privateLog != nullptr) {
+		privateLog->sendLog(LEVEL_INFO, "No probe named %s yet, its state applies to the probes registered later.", path.c_str());
+	}
+}
+
+
+void Output::setProbeSampling(const std::string& path,
+                              sampling_policy_t policy,
+                              unsigned int period,
+                              double threshold) {
+	// the sampling state is used by the probes sending
+	OutputLock acquire{lock};
+
+	std::string name = normalizeName(path);
+	keepSetting({name, true, false, policy, period, threshold});
+	std::shared_ptr<OutputItem> item = findItem(name);
+	if (item != nullptr) {
+		item->setStatsSampling(policy, period, threshold);
+		return;
+	}
+	std::shared_ptr<BaseProbe> probe = findProbe(name);
+	if (probe != nullptr) {
+		probe->setSampling(policy, period, threshold);
+		return;
+	}
 
-probe_not_found:
 	if (privateLog != nullptr) {
-		privateLog->sendLog(LEVEL_WARNING, "Cannot change probes states: %s is not a valid group or probe name.", path.c_str());
+		privateLog->sendLog(LEVEL_INFO, "No probe named %s yet, its sampling applies to the probes registered later.", path.c_str());
 	}
 }
 
 
 void Output::setLogLevel(const std::string& path, log_level_t level) {
-	std::vector<std::string> parts = splitName(normalizeName(path));
+	OutputLock acquire{lock};
 
-	std::shared_ptr<OutputItem> currentItem = root;
-	for (auto& name : parts) {
-		std::shared_ptr<OutputSection> currentSection = std::dynamic_pointer_cast<OutputSection>(currentItem);
-		if (currentSection == nullptr) { goto log_not_found; }
-		currentItem = currentSection->find(name);
+	std::shared_ptr<OutputItem> item = findItem(normalizeName(path));
+	if (item != nullptr) {
+		item->setLogLevel(level);
+		return;
 	}
 
-	if (currentItem == nullptr) { goto log_not_found; }
-	currentItem->setLogLevel(level);
-	return;
-
-log_not_found:
 	if (privateLog != nullptr) {
 		privateLog->sendLog(LEVEL_WARNING, "Cannot change logs levels: %s is not a valid group or log name.", path.c_str());
 	}
@@ -672,23 +940,18 @@ log_not_found:
 
 void Output::setLevels(const std::map<std::string, log_level_t> &levels)
 {
+	OutputLock acquire{lock};
 	for (auto&& log_level : levels) {
 		auto log_name = normalizeName(log_level.first);
 		std::vector<std::string> parts = splitName(log_name);
 
 		std::shared_ptr<OutputDesiredLogLevel> desiredLevel = desiredLogLevels;
-		std::shared_ptr<OutputItem> currentItem = root;
 		for (auto&& name : parts) {
-			std::shared_ptr<OutputSection> currentSection = std::dynamic_pointer_cast<OutputSection>(currentItem);
-			if (currentSection == nullptr) {
-				currentItem = nullptr;
-			} else {
-				currentItem = currentSection->find(name);
-			}
 			desiredLevel = desiredLevel->getOrCreateChild(name);
 		}
 
 		desiredLevel->setLogLevel(log_level.second);
+		std::shared_ptr<OutputItem> currentItem = findItem(log_name);
 		if (currentItem != nullptr) {
 			currentItem->setLogLevel(log_level.second);
 		}
@@ -39,33 +39,53 @@
 #ifndef _OUTPUT_H
 #define _OUTPUT_H
 
+#include <atomic>
 #include <map>
 #include <vector>
 #include <memory>
 #include <string>
 
 #include "Probe.h"
+#include "HistogramProbe.h"
 #include "OutputLog.h"
 #include "OutputMutex.h"
 
 
 #define PRINTFLIKE(fmt_pos, vararg_pos) __attribute__((format(printf,fmt_pos,vararg_pos)))
 
+/*
+ * The least important level of the logs built in the application
+ * (configure --with-min-log-level), the LOG and DFLTLOG calls of less
+ * important levels compile to nothing, arguments included.
+ */
+#ifndef OUTPUT_MIN_LOG_LEVEL
+#define OUTPUT_MIN_LOG_LEVEL LEVEL_DEBUG
+#endif
+
+constexpr log_level_t output_min_log_level = OUTPUT_MIN_LOG_LEVEL;
+
 #define DFLTLOG(level, fmt, args...) \
 	do \
 	{ \
-		Output::Get()->sendLog(level, \
-		                       "[%s:%s():%d] " fmt, \
-		                       __FILE__, __FUNCTION__, __LINE__, ##args); \
+		if((level) <= output_min_log_level) \
+		{ \
+			Output::Get()->sendLog(level, \
+			                       "[%s:%s():%d] " fmt, \
+			                       __FILE__, __FUNCTION__, __LINE__, ##args); \
+		} \
 	} \
 	while(0)
 
 #define LOG(log, level, fmt, args...) \
 	do \
 	{ \
-		log->sendLog(level, \
-		             "[%s:%s():%d] " fmt, \
-		             __FILE__, __FUNCTION__, __LINE__, ##args); \
+		if((level) <= output_min_log_level && \
+		   __builtin_expect(log->isEnabled(level), 0)) \
+		{ \
+			log->sendLog(level, \
+			             "[%s:%s():%d] " fmt, \
+			             __FILE__, __FUNCTION__, __LINE__, ##args); \
+		} \
 	} \
 	while(0)
 
@@ -85,6 +105,10 @@
 
 
 class OutputEvent;
+class OutputItem;
+class OutputUnit;
+class OutputIndex;
+class OutputLogQueue;
 class LogHandler;
 class StatHandler;
 class OutputDesiredLogLevel;
@@ -119,6 +143,22 @@ class Output
 	*/
 	std::string getEntityName() const;
 
+	/**
+	 * @brief Prefix the names of the probes registered by the calling
+	 *        thread with a section, so that the probes of several
+	 *        instances of the same blocks can live in one process
+	 *
+	 * @param prefix  The section, empty for no prefix
+	 */
+	void setProbesPrefix(const std::string& prefix);
+
+	/**
+	 * @brief Get the section prefixing the probes registered by the calling thread
+	 *
+	 * @return the section, empty for no prefix
+	 */
+	std::string getProbesPrefix() const;
+
 	/**
 	 * @brief Register a probe in the output library
 	 *
@@ -173,6 +213,31 @@ class Output
 	std::shared_ptr<Probe<T>> registerProbe(const std::string& unit, bool enabled, sample_type_t type, const char* msg_format, ...)
 		PRINTFLIKE(5, 6);
 
+	/**
+	 * @brief Register a histogram probe in the output library, sending
+	 *        the distribution of its values (see HistogramProbe.h)
+	 *
+	 * @param name     The probe full name (section.subsection.name)
+	 * @param unit     The probe unit
+	 * @param enabled  Whether the probe is enabled by default
+	 *
+	 * @return the probe object
+	 **/
+	std::shared_ptr<HistogramProbe> registerHistogram(const std::string& name, const std::string& unit, bool enabled);
+
+	/**
+	 * @brief Register a histogram probe in the output library
+	 *        with variable arguments in name
+	 *
+	 * @param unit     The probe unit
+	 * @param enabled  Whether the probe is enabled by default
+	 * @param name     The probe full name (section.subsection.name) with variable arguments
+	 *
+	 * @return the probe object
+	 **/
+	std::shared_ptr<HistogramProbe> registerHistogram(const std::string& unit, bool enabled, const char* msg_format, ...)
+		PRINTFLIKE(4, 5);
+
 	/**
 	 * @brief Register an event in the output library
 	 *
@@ -216,13 +281,29 @@ class Output
 		PRINTFLIKE(3, 4);
 
 	/**
-	 * @brief Set the probe state
+	 * @brief Set the probe state, also applied to the probes
+	 *        registered later under this name
 	 *
 	 * @param path      full name of a unit or a probe
 	 * @param enabled   Whether the probe is enabled or not
 	 */
 	void setProbeState(const std::string& path, bool enabled);
 
+	/**
+	 * @brief Set the sampling policy of the probes, to send less values
+	 *        of the probes that seldom change, also applied to the probes
+	 *        registered later under this name
+	 *
+	 * @param path       full name of a section, a unit or a probe
+	 * @param policy     The sampling policy
+	 * @param period     The number of sending periods of a window (SAMPLING_WINDOW)
+	 * @param threshold  The change needed to send a new value (SAMPLING_ON_CHANGE)
+	 */
+	void setProbeSampling(const std::string& path,
+	                      sampling_policy_t policy,
+	                      unsigned int period,
+	                      double threshold);
+
 	/**
 	 * @brief Set the log level
 	 *
@@ -236,18 +317,24 @@ class Output
 	 *
 	 * @warning Needs to be called after registering probes or they
 	 *          wont send anything. Must also be called after each
-	 *          reconfiguration.
+	 *          reconfiguration. The enabled probes registered afterwards
+	 *          are announced to the handlers one at a time.
 	 **/
 	void finalizeConfiguration(void);
 
 	/**
 	 * @brief Configure the output library to use file-based logs and probes
 	 *
-	 * @param folder      The path to store produced files in
-	 * @param entityName  The name of the entity that will be part of the final files names
-	 * @return            Whether or not the configuration was successful
+	 * @param folder        The path to store produced files in
+	 * @param rotateSize    The size of the files triggering their rotation in bytes, 0 to disable
+	 * @param rotatePeriod  The age of the files triggering their rotation in seconds, 0 to disable
+	 * @param compress      Whether to compress the rotated files with zstd
+	 * @return              Whether or not the configuration was successful
 	 **/
-	bool configureLocalOutput(const std::string& folder);
+	bool configureLocalOutput(const std::string& folder,
+	                          std::size_t rotateSize = 0,
+	                          unsigned int rotatePeriod = 0,
+	                          bool compress = false);
 
 	/**
 	 * @brief Configure the output library to use UDP socket-based logs and probes
@@ -255,11 +342,35 @@ class Output
 	 * @param address   Address of the remote host listening for messages
 	 * @param statsPort Port used by the remote host to listen for probes
 	 * @param logsPort  Port used by the remote host to listen for logs
+	 * @param binaryStats  Whether to send the probes with the binary
+	 *                     protocol (see OutputStatProtocol.h) or as text
 	 * @return          Whether or not the configuration was successful
 	 **/
 	bool configureRemoteOutput(const std::string& address,
 	                           unsigned short statsPort,
-	                           unsigned short logsPort);
+	                           unsigned short logsPort,
+	                           bool binaryStats = false);
+
+	/**
+	 * @brief Configure the output library to also publish the latest value
+	 *        of each probe in a shared memory region read by the local
+	 *        collectors (see OutputStatShm.h)
+	 *
+	 * @param name  Name of the POSIX shared memory object
+	 * @return      Whether or not the configuration was successful
+	 **/
+	bool configureShmOutput(const std::string& name);
+
+	/**
+	 * @brief Configure the output library to also serve the latest probes
+	 *        values on an OpenMetrics/Prometheus HTTP endpoint, scraped by
+	 *        the monitoring systems (see OutputMetrics.h)
+	 *
+	 * @param address  Address the endpoint listens on
+	 * @param port     TCP port the endpoint listens on
+	 * @return         Whether or not the configuration was successful
+	 **/
+	bool configureMetricsOutput(const std::string& address, unsigned short port);
 
 	/**
 	 * @brief Configure the output library to use the stderr stream for logs
@@ -297,6 +408,23 @@ class Output
 	 */
 	void setLevels(const std::map<std::string, log_level_t> &levels);
 
+	/**
+	 * @brief Set the maximum number of warnings and errors emitted
+	 *        per second by each log, the following ones are dropped
+	 *        and counted in the output.dropped_logs probe
+	 *
+	 * @param limit  The number of messages per second, 0 for no limit
+	 */
+	void setLogRateLimit(unsigned int limit);
+
+	/**
+	 * @brief Get the number of probes registered since the start,
+	 *        to watch the growth of their storage
+	 *
+	 * @return the number of probes
+	 */
+	std::size_t getProbesCount() const;
+
  private:
 	Output();
 	void registerProbe(const std::string& name, std::shared_ptr<BaseProbe> probe);
@@ -304,16 +432,86 @@ class Output
 	std::string entityName;
 
 	class OutputSection;
-	std::shared_ptr<OutputSection> getOrCreateSection(const std::vector<std::string>& names);
 
-	OutputMutex lock;
+	/**
+	 * @brief Get a section from its full name, creating it and its parents
+	 *        if needed
+	 *
+	 * @param fullName  The section full name (section.subsection)
+	 * @return the section
+	 */
+	std::shared_ptr<OutputSection> getOrCreateSection(const std::string& fullName);
+
+	/**
+	 * @brief Get a unit from its full name, creating it and its parents
+	 *        if needed
+	 *
+	 * @param fullName  The unit full name (section.subsection.unit)
+	 * @return the unit
+	 */
+	std::shared_ptr<OutputUnit> getOrCreateUnit(const std::string& fullName);
+
+	/**
+	 * @brief Find a section or a unit from its normalized full name
+	 *
+	 * @param fullName  The section or unit full name, empty for the root
+	 * @return the item, nullptr if it does not exist
+	 */
+	std::shared_ptr<OutputItem> findItem(const std::string& fullName) const;
+
+	/**
+	 * @brief Find a probe from its normalized full name
+	 *
+	 * @param fullName  The probe full name (section.unit.probe)
+	 * @return the probe, nullptr if it does not exist
+	 */
+	std::shared_ptr<BaseProbe> findProbe(const std::string& fullName) const;
+
+	/// A probes state or sampling change, kept for the probes registered later
+	struct ProbeSetting
+	{
+		std::string path;
+		bool sampling;
+		bool enabled;
+		sampling_policy_t policy;
+		unsigned int period;
+		double threshold;
+	};
+
+	/**
+	 * @brief Remember a probes setting, replacing the previous one of
+	 *        the same kind on the same path
+	 *
+	 * @param setting  The setting, with a normalized path
+	 */
+	void keepSetting(const ProbeSetting& setting);
+
+	/**
+	 * @brief Apply the settings covering a probe being registered
+	 *
+	 * @param name   The probe normalized full name
+	 * @param probe  The probe
+	 */
+	void applySettings(const std::string& name, BaseProbe& probe) const;
+
+	OutputMutex lock{"output"};
+	std::shared_ptr<OutputLogQueue> logQueue;
 	std::shared_ptr<OutputSection> root;
+	/// the sections and units of the tree indexed by their full names
+	std::shared_ptr<OutputIndex> items;
 	std::shared_ptr<OutputLog> privateLog;
 	std::shared_ptr<OutputLog> defaultLog;
 	std::vector<std::shared_ptr<BaseProbe>> enabledProbes;
 	std::vector<std::shared_ptr<LogHandler>> logHandlers;
 	std::vector<std::shared_ptr<StatHandler>> probeHandlers;
 
+	std::shared_ptr<Probe<int32_t>> droppedLogs;
+	uint64_t reportedDroppedLogs;
+	std::atomic<std::size_t> registeredProbes;
+	std::vector<ProbeSetting> probeSettings;
+	/// whether the probes registered now are announced to the handlers
+	bool finalized;
+
 	std::shared_ptr<OutputDesiredLogLevel> desiredLogLevels;
 };
 
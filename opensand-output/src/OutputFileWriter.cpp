@@ -0,0 +1,320 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file OutputFileWriter.cpp
+ * @brief The buffered file written by a dedicated thread for the
+ *        local logs and probes.
+ * @author Viveris Technologies
+ */
+
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#if HAVE_ZSTD_H
+#include <zstd.h>
+#endif
+
+#include "OutputFileWriter.h"
+#include "OutputHandler.h"
+
+
+/// The size of the front buffer waking the writer thread up
+constexpr std::size_t batch_size = 256 * 1024;
+
+/// The maximum size of the front buffer, the following data is dropped
+constexpr std::size_t max_pending = 64 * 1024 * 1024;
+
+/// The maximum time the data waits in the front buffer
+constexpr std::chrono::milliseconds flush_period{500};
+
+
+static bool writeFd(int fd, const char *data, std::size_t length)
+{
+  while (length > 0) {
+    ssize_t written = ::write(fd, data, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    length -= written;
+  }
+  return true;
+}
+
+
+#if HAVE_ZSTD_H
+static bool compressFile(const std::string& source, const std::string& destination)
+{
+  int input_fd = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+  if (input_fd < 0) {
+    return false;
+  }
+  int output_fd = ::open(destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (output_fd < 0) {
+    ::close(input_fd);
+    return false;
+  }
+
+  ZSTD_CCtx *context = ZSTD_createCCtx();
+  std::vector<char> input(ZSTD_CStreamInSize());
+  std::vector<char> output(ZSTD_CStreamOutSize());
+  bool success = context != nullptr;
+  bool last = false;
+  while (success && !last) {
+    ssize_t length = ::read(input_fd, input.data(), input.size());
+    if (length < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      success = false;
+      break;
+    }
+
+    last = length == 0;
+    ZSTD_EndDirective mode = last ? ZSTD_e_end : ZSTD_e_continue;
+    ZSTD_inBuffer in_buffer = {input.data(), static_cast<std::size_t>(length), 0};
+    bool finished = false;
+    while (success && !finished) {
+      ZSTD_outBuffer out_buffer = {output.data(), output.size(), 0};
+      std::size_t remaining = ZSTD_compressStream2(context, &out_buffer, &in_buffer, mode);
+      success = !ZSTD_isError(remaining) && writeFd(output_fd, output.data(), out_buffer.pos);
+      finished = last ? remaining == 0 : in_buffer.pos == in_buffer.size;
+    }
+  }
+
+  ZSTD_freeCCtx(context);
+  ::close(input_fd);
+  if (::close(output_fd) != 0) {
+    success = false;
+  }
+  if (!success) {
+    ::unlink(destination.c_str());
+  }
+  return success;
+}
+#endif
+
+
+OutputFileWriter::OutputFileWriter(const std::string& path,
+                                   std::size_t rotateSize,
+                                   unsigned int rotatePeriod,
+                                   bool compress):
+  path(path),
+  rotateSize(rotateSize),
+  rotatePeriod(rotatePeriod),
+  compress(compress && hasCompression()),
+  fd(-1),
+  fileSize(0),
+  rotations(0),
+  failed(false),
+  running(true),
+  dropped(0),
+  reported(0)
+{
+  if (!open()) {
+    throw HandlerCreationFailedError("Unable to open " + path + ": " + std::strerror(errno));
+  }
+  front.reserve(batch_size);
+  back.reserve(batch_size);
+
+  // the signals are handled by the application threads (signalfd),
+  // the writer thread must not catch them
+  sigset_t all_signals;
+  sigset_t previous_signals;
+  sigfillset(&all_signals);
+  pthread_sigmask(SIG_SETMASK, &all_signals, &previous_signals);
+  thread = std::thread{&OutputFileWriter::run, this};
+  pthread_sigmask(SIG_SETMASK, &previous_signals, nullptr);
+}
+
+
+OutputFileWriter::~OutputFileWriter()
+{
+  {
+    std::lock_guard<std::mutex> acquire{lock};
+    running = false;
+    wake.notify_one();
+  }
+  thread.join();
+  ::close(fd);
+}
+
+
+bool OutputFileWriter::hasCompression()
+{
+#if HAVE_ZSTD_H
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+void OutputFileWriter::setHeader(const std::string& data)
+{
+  std::lock_guard<std::mutex> acquire{lock};
+  header = data;
+  front += data;
+}
+
+
+void OutputFileWriter::write(const std::string& data)
+{
+  std::lock_guard<std::mutex> acquire{lock};
+  std::size_t pending = front.size();
+  if (pending + data.size() > max_pending) {
+    dropped += data.size();
+    return;
+  }
+
+  front += data;
+  if (pending < batch_size && front.size() >= batch_size) {
+    wake.notify_one();
+  }
+}
+
+
+bool OutputFileWriter::open()
+{
+  fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  fileSize = 0;
+  fileOpened = std::chrono::steady_clock::now();
+
+  std::string data;
+  {
+    std::lock_guard<std::mutex> acquire{lock};
+    data = header;
+  }
+  if (!writeFd(fd, data.data(), data.size())) {
+    return false;
+  }
+  fileSize = data.size();
+  return true;
+}
+
+
+void OutputFileWriter::rotate()
+{
+  ::close(fd);
+  fd = -1;
+
+  std::string rotated = path + "." + std::to_string(++rotations);
+  if (::rename(path.c_str(), rotated.c_str()) != 0) {
+    std::cerr << "Unable to rotate " << path << ": " << std::strerror(errno) << std::endl;
+  }
+#if HAVE_ZSTD_H
+  else if (compress) {
+    // the emitting threads keep filling the front buffer meanwhile
+    if (compressFile(rotated, rotated + ".zst")) {
+      ::unlink(rotated.c_str());
+    } else {
+      std::cerr << "Unable to compress " << rotated << std::endl;
+    }
+  }
+#endif
+
+  if (!open()) {
+    std::cerr << "Unable to open " << path << ": " << std::strerror(errno) << std::endl;
+    failed = true;
+  }
+}
+
+
+void OutputFileWriter::writeBatch()
+{
+  if (failed) {
+    back.clear();
+    return;
+  }
+
+  bool too_large = rotateSize != 0 && fileSize != 0 && fileSize + back.size() > rotateSize;
+  bool too_old = rotatePeriod.count() != 0 && !back.empty() &&
+                 std::chrono::steady_clock::now() - fileOpened >= rotatePeriod;
+  if (too_large || too_old) {
+    rotate();
+    if (failed) {
+      back.clear();
+      return;
+    }
+  }
+
+  if (back.empty()) {
+    return;
+  }
+  if (!writeFd(fd, back.data(), back.size())) {
+    std::cerr << "Unable to write to " << path << ": " << std::strerror(errno) << std::endl;
+    failed = true;
+  }
+  fileSize += back.size();
+  back.clear();
+}
+
+
+void OutputFileWriter::run()
+{
+  std::unique_lock<std::mutex> acquire{lock};
+  while (true) {
+    wake.wait_for(acquire, flush_period, [this]() {
+      return !running || front.size() >= batch_size;
+    });
+    bool stopping = !running;
+    std::swap(front, back);
+    uint64_t lost = dropped - reported;
+    reported = dropped;
+    acquire.unlock();
+
+    if (lost != 0) {
+      std::cerr << lost << " bytes dropped from " << path << std::endl;
+    }
+    writeBatch();
+
+    acquire.lock();
+    if (stopping && front.empty()) {
+      break;
+    }
+  }
+}
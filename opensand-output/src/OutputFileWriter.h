@@ -0,0 +1,144 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file OutputFileWriter.h
+ * @brief The buffered file written by a dedicated thread for the
+ *        local logs and probes, so that the emitting threads never
+ *        wait for the disk.
+ * @author Viveris Technologies
+ */
+
+
+#ifndef _OUTPUT_FILE_WRITER_H
+#define _OUTPUT_FILE_WRITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+
+/**
+ * @class OutputFileWriter
+ * @brief File written by batches from a dedicated thread
+ *
+ * The emitting threads only append their data to the front buffer under a
+ * short lock. The writer thread swaps it with the back buffer and writes the
+ * whole batch at once, either when it is large enough or periodically.
+ * When the writer lags behind and the front buffer reaches its limit, the
+ * data is dropped and counted instead of blocking the emitting thread.
+ *
+ * The file is rotated when it reaches a size or an age: it is renamed with
+ * the rotation number appended and, if requested and zstd is available,
+ * compressed by the writer thread.
+ */
+class OutputFileWriter
+{
+ public:
+  /**
+   * @brief Open the file and start the writer thread
+   *
+   * @param path          The path of the file
+   * @param rotateSize    The size triggering a rotation in bytes, 0 to disable
+   * @param rotatePeriod  The age triggering a rotation in seconds, 0 to disable
+   * @param compress      Whether to compress the rotated files with zstd
+   * @throw HandlerCreationFailedError if the file can not be opened
+   */
+  OutputFileWriter(const std::string& path,
+                   std::size_t rotateSize = 0,
+                   unsigned int rotatePeriod = 0,
+                   bool compress = false);
+
+  /**
+   * @brief Write the pending data, stop the thread and close the file
+   */
+  ~OutputFileWriter();
+
+  /**
+   * @brief Set the data written at the beginning of each file and
+   *        append it to the current one
+   *
+   * @param data  The header of the files
+   */
+  void setHeader(const std::string& data);
+
+  /**
+   * @brief Add data to the next batch
+   *
+   * @param data  The data to write
+   */
+  void write(const std::string& data);
+
+  /**
+   * @brief Check whether the rotated files can be compressed
+   *
+   * @return true if OpenSAND output was built with zstd
+   */
+  static bool hasCompression();
+
+ private:
+  /// Open the file, truncating it, and write the header
+  bool open();
+
+  /// Close the file and rename it, then compress it if requested
+  void rotate();
+
+  /// Write the back buffer to the file, rotating it beforehand if needed
+  void writeBatch();
+
+  /// The writer thread main loop
+  void run();
+
+  std::string path;
+  std::size_t rotateSize;
+  std::chrono::seconds rotatePeriod;
+  bool compress;
+
+  int fd;
+  std::size_t fileSize;
+  std::chrono::steady_clock::time_point fileOpened;
+  unsigned long rotations;
+  bool failed;
+
+  std::mutex lock;
+  std::condition_variable wake;
+  bool running;
+  std::string header;
+  std::string front;
+  std::string back;
+  uint64_t dropped;
+  uint64_t reported;
+
+  std::thread thread;
+};
+
+
+#endif
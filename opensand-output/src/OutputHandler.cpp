@@ -34,21 +34,35 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <ctime>
+#include <new>
 #include <sstream>
 #include <iomanip>
 #include <iostream>
 
 #include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
 #include <experimental/filesystem>
 
 #include "OutputHandler.h"
+#include "OutputFileWriter.h"
+#include "OutputStatProtocol.h"
+#include "OutputStatShm.h"
 #include "BaseProbe.h"
 
 
+/// The period of the probes definitions sending, for collectors starting late
+constexpr unsigned long long statDefinitionsPeriod = 5000;
+
+/// The maximum time values wait in a binary datagram before being sent
+constexpr unsigned long long statMaxDelay = 100;
+
+
 HandlerCreationFailedError::HandlerCreationFailedError(const std::string& what_arg) : std::runtime_error(what_arg)
 {
 };
@@ -75,7 +89,10 @@ struct getDate {
 std::ostream& operator<<(std::ostream& os, const getDate& date) {
 	const char prevFill = os.fill();
 	const std::streamsize prevWidth = os.width();
-	os << std::put_time(std::localtime(&date.date_time), "%F %T.") << std::setfill('0') << std::setw(3) << date.date_milli << std::setfill(prevFill) << std::setw(prevWidth);
+	// the logs and the probes are emitted from different threads
+	std::tm local_time;
+	localtime_r(&date.date_time, &local_time);
+	os << std::put_time(&local_time, "%F %T.") << std::setfill('0') << std::setw(3) << date.date_milli << std::setfill(prevFill) << std::setw(prevWidth);
 	return os;
 }
 
@@ -88,19 +105,31 @@ StatHandler::StatHandler(const std::string& entityName) : Handler(entityName) {
 }
 
 
+void StatHandler::addProbes(const std::vector<std::shared_ptr<BaseProbe>>& probes, std::size_t) {
+	configure(probes);
+}
+
+
 LogHandler::LogHandler(const std::string& entityName) : Handler(entityName) {
 }
 
 
-FileStatHandler::FileStatHandler(const std::string& fileName, const std::string& originFolder) : StatHandler(fileName), filesOpened(0), folder(originFolder), filename(fileName) {
+FileStatHandler::FileStatHandler(const std::string& fileName, const std::string& originFolder,
+                                 std::size_t rotateSize, unsigned int rotatePeriod, bool compress) :
+	StatHandler(fileName),
+	filesOpened(0),
+	folder(originFolder),
+	filename(fileName),
+	rotateSize(rotateSize),
+	rotatePeriod(rotatePeriod),
+	compress(compress)
+{
 	std::experimental::filesystem::create_directories(folder);
-	file.open(buildFullPath());
+	file = std::make_unique<OutputFileWriter>(buildFullPath(), rotateSize, rotatePeriod, compress);
 }
 
 
 FileStatHandler::~FileStatHandler() {
-	file.flush();
-	file.close();
 }
 
 
@@ -111,31 +140,48 @@ std::string FileStatHandler::buildFullPath() const {
 }
 
 
-void FileStatHandler::emitStats(const std::vector<std::pair<std::string, std::string>>& probesValues)
+void FileStatHandler::emitStats(const std::vector<ProbeValue>& probesValues)
 {
-	file << getDate();
+	// only the formatting happens here, the disk is written by the writer thread
+	std::stringstream line;
+	line << getDate();
 	for (auto& probe : probesValues) {
-		file << ";" << probe.second;
+		line << ";" << probe.toString();
 	}
-	file << "\n";
-	file.flush();
+	line << "\n";
+	file->write(line.str());
 }
 
 
 void FileStatHandler::configure(const std::vector<std::shared_ptr<BaseProbe>>& probes)
 {
 	if (filesOpened++) {
-		file.flush();
-		file.close();
-		file.open(buildFullPath());
+		// the previous writer writes its pending lines before closing its file
+		file.reset();
+		file = std::make_unique<OutputFileWriter>(buildFullPath(), rotateSize, rotatePeriod, compress);
 	}
 
-	file << "Date";
+	writeHeader(probes);
+}
+
+
+void FileStatHandler::addProbes(const std::vector<std::shared_ptr<BaseProbe>>& probes, std::size_t)
+{
+	// the new columns are announced by a new header line in the same file
+	writeHeader(probes);
+}
+
+
+void FileStatHandler::writeHeader(const std::vector<std::shared_ptr<BaseProbe>>& probes)
+{
+	// repeated at the beginning of each rotated file
+	std::stringstream header;
+	header << "Date";
 	for (auto& probe : probes) {
-		file << ";" << probe->getName() << " (" << probe->getUnit() << ")";
+		header << ";" << probe->getName() << " (" << probe->getUnit() << ")";
 	}
-	file << "\n";
-	file.flush();
+	header << "\n";
+	file->setHeader(header.str());
 }
 
 
@@ -152,27 +198,41 @@ void LogHandler::prepareMessage(std::ostream& formatter, const std::string& logN
 }
 
 
-FileLogHandler::FileLogHandler(const std::string& fileName, const std::string& originFolder) : LogHandler(fileName) {
+FileLogHandler::FileLogHandler(const std::string& fileName, const std::string& originFolder,
+                               std::size_t rotateSize, unsigned int rotatePeriod, bool compress) :
+	LogHandler(fileName)
+{
 	std::experimental::filesystem::create_directories(originFolder);
 
-	file.open(originFolder + '/' + fileName + ".log");
+	file = std::make_unique<OutputFileWriter>(originFolder + '/' + fileName + ".log", rotateSize, rotatePeriod, compress);
 }
 
 
 FileLogHandler::~FileLogHandler() {
-	file.flush();
-	file.close();
 }
 
 
 void FileLogHandler::emitLog(const std::string& logName, const std::string& level, const std::string& message) {
-	std::lock_guard<std::mutex> acquire{lock};
-	prepareMessage(file, logName, level, message);
-	file << std::endl;
+	std::stringstream line;
+	prepareMessage(line, logName, level, message);
+	line << "\n";
+	file->write(line.str());
 }
 
 
-SocketStatHandler::SocketStatHandler(const std::string& entityName, const std::string& address, unsigned short port, bool useTCP) : StatHandler(entityName), useTcp(useTCP) {
+SocketStatHandler::SocketStatHandler(const std::string& entityName, const std::string& address, unsigned short port, bool useTCP, bool binary) :
+	StatHandler(entityName),
+	useTcp(useTCP),
+	binary(binary),
+	configuration(0),
+	definitions(),
+	definitionsTimestamp(0),
+	pending(),
+	pendingTimestamp(0),
+	batchTimestamp(0),
+	emitTimestamp(0),
+	emitPeriod(0)
+{
 	remote.sin_family = AF_INET;
 	remote.sin_port = htons(port);
 	if (inet_pton(AF_INET, address.c_str(), &remote.sin_addr) < 0) {
@@ -195,22 +255,33 @@ SocketStatHandler::SocketStatHandler(const std::string& entityName, const std::s
 
 
 SocketStatHandler::~SocketStatHandler() {
+	flush();
 	close(socketFd);
 }
 
 
-void SocketStatHandler::emitStats(const std::vector<std::pair<std::string, std::string>>& probesValues)
+void SocketStatHandler::emitStats(const std::vector<ProbeValue>& probesValues)
+{
+	if (binary) {
+		emitBinaryStats(probesValues);
+	} else {
+		emitTextStats(probesValues);
+	}
+}
+
+
+void SocketStatHandler::emitTextStats(const std::vector<ProbeValue>& probesValues)
 {
 	bool needSending = false;
 	std::stringstream formatter;
 	formatter << getTimestamp();
 
 	for (auto& probe : probesValues) {
-		if (probe.second.empty()) {
+		if (probe.isEmpty()) {
 			continue;
 		}
 		needSending = true;
-		formatter << " " << probe.first << " " << probe.second;
+		formatter << " " << probe.getName() << " " << probe.toString();
 	}
 
 	if (!needSending) {
@@ -218,19 +289,292 @@ void SocketStatHandler::emitStats(const std::vector<std::pair<std::string, std::
 	}
 
 	formatter << " entity " << entityName;
-	std::string msg = formatter.str();
+	sendDatagram(formatter.str());
+}
+
+
+void SocketStatHandler::emitBinaryStats(const std::vector<ProbeValue>& probesValues)
+{
+	unsigned long long timestamp = getTimestamp();
+	if (timestamp - definitionsTimestamp >= statDefinitionsPeriod) {
+		sendDefinitions(timestamp);
+	}
+	if (emitTimestamp) {
+		emitPeriod = timestamp - emitTimestamp;
+	}
+	emitTimestamp = timestamp;
+
+	// keep room for the datagram header and the batch header
+	const std::size_t maxValues = stat_protocol_max_datagram - 9 - UINT8_MAX - 8 - 20;
+	std::string values;
+	std::size_t count = 0;
+	std::size_t previousId = 0;
+	for (std::size_t id = 0; id < probesValues.size(); ++id) {
+		const ProbeValue& value = probesValues[id];
+		if (value.isEmpty()) {
+			continue;
+		}
+		if (values.size() + 10 + StatEncoder::valueSize(value) > maxValues) {
+			// the following values go in the next datagram
+			appendBatch(timestamp, values, count);
+			flush();
+			values.clear();
+			count = 0;
+			previousId = 0;
+		}
+		StatEncoder::writeVarint(values, id - previousId);
+		StatEncoder::writeValue(values, value);
+		previousId = id;
+		count++;
+	}
+	if (count) {
+		appendBatch(timestamp, values, count);
+	}
+
+	// wait for the next values only if they come before the maximum delay
+	if (!pending.empty() && timestamp - pendingTimestamp + emitPeriod >= statMaxDelay) {
+		flush();
+	}
+}
+
 
+void SocketStatHandler::appendBatch(unsigned long long timestamp, const std::string& values, std::size_t count)
+{
+	if (!pending.empty() && pending.size() + 20 + values.size() > stat_protocol_max_datagram) {
+		flush();
+	}
+	if (pending.empty()) {
+		StatEncoder::writeHeader(pending, StatMessageType::values, configuration, entityName);
+		StatEncoder::writeU64(pending, timestamp);
+		pendingTimestamp = timestamp;
+		batchTimestamp = timestamp;
+	}
+	StatEncoder::writeVarint(pending, timestamp - batchTimestamp);
+	StatEncoder::writeVarint(pending, count);
+	pending.append(values);
+	batchTimestamp = timestamp;
+}
+
+
+void SocketStatHandler::flush()
+{
+	if (pending.empty()) {
+		return;
+	}
+	sendDatagram(pending);
+	pending.clear();
+}
+
+
+void SocketStatHandler::sendDefinitions(unsigned long long timestamp)
+{
+	for (auto& datagram : definitions) {
+		sendDatagram(datagram);
+	}
+	definitionsTimestamp = timestamp;
+}
+
+
+void SocketStatHandler::sendDatagram(const std::string& datagram)
+{
 	if (useTcp) {
-		send(socketFd, msg.c_str(), msg.length(), 0);
+		if (binary) {
+			// keep the datagrams boundaries on the stream
+			std::string length;
+			StatEncoder::writeU16(length, datagram.length());
+			send(socketFd, length.c_str(), length.length(), MSG_MORE);
+		}
+		send(socketFd, datagram.c_str(), datagram.length(), 0);
 	} else {
-		sendto(socketFd, msg.c_str(), msg.length(), 0, (struct sockaddr*)(&remote), sizeof(remote));
+		sendto(socketFd, datagram.c_str(), datagram.length(), 0, (struct sockaddr*)(&remote), sizeof(remote));
 	}
 }
 
 
-void SocketStatHandler::configure(const std::vector<std::shared_ptr<BaseProbe>>&)
+void SocketStatHandler::configure(const std::vector<std::shared_ptr<BaseProbe>>& probes)
 {
-	// Do nothing
+	if (!binary) {
+		return;
+	}
+
+	// the pending values belong to the previous configuration
+	flush();
+	configuration++;
+
+	definitions.clear();
+	appendDefinitions(probes, 0);
+	sendDefinitions(getTimestamp());
+}
+
+
+void SocketStatHandler::addProbes(const std::vector<std::shared_ptr<BaseProbe>>& probes, std::size_t first)
+{
+	if (!binary) {
+		return;
+	}
+
+	// the IDs of the previous probes do not change, only the new
+	// definitions are sent before the values using them
+	std::size_t sent = definitions.size();
+	appendDefinitions(probes, first);
+	for (std::size_t index = sent; index < definitions.size(); ++index) {
+		sendDatagram(definitions[index]);
+	}
+}
+
+
+void SocketStatHandler::appendDefinitions(const std::vector<std::shared_ptr<BaseProbe>>& probes, std::size_t first)
+{
+	// the probes IDs are their positions in the emitted values
+	std::string datagram;
+	for (std::size_t id = first; id < probes.size(); ++id) {
+		std::string definition;
+		StatEncoder::writeVarint(definition, id);
+		StatEncoder::writeU8(definition, probes[id]->getDataType());
+		StatEncoder::writeString(definition, probes[id]->getName());
+		StatEncoder::writeString(definition, probes[id]->getUnit());
+
+		if (!datagram.empty() && datagram.size() + definition.size() > stat_protocol_max_datagram) {
+			definitions.push_back(datagram);
+			datagram.clear();
+		}
+		if (datagram.empty()) {
+			StatEncoder::writeHeader(datagram, StatMessageType::definitions, configuration, entityName);
+		}
+		datagram.append(definition);
+	}
+	if (!datagram.empty()) {
+		definitions.push_back(datagram);
+	}
+}
+
+
+ShmStatHandler::ShmStatHandler(const std::string& entityName, const std::string& name) : StatHandler(entityName), name(name), region(nullptr), mapped(0) {
+	if ((fd = shm_open(name.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644)) < 0) {
+		std::stringstream message;
+		message << "Cannot open shared memory " << name << ".";
+		throw HandlerCreationFailedError(message.str());
+	}
+
+	if (!resize(sizeof(stat_shm_header))) {
+		close(fd);
+		shm_unlink(name.c_str());
+		std::stringstream message;
+		message << "Cannot map shared memory " << name << ".";
+		throw HandlerCreationFailedError(message.str());
+	}
+
+	auto header = new (region) stat_shm_header();
+	header->magic = stat_shm_magic;
+	header->version = stat_shm_version;
+	header->size = mapped;
+	header->table_offset = sizeof(stat_shm_header);
+	header->values_offset = sizeof(stat_shm_header);
+	entityName.copy(header->entity, stat_shm_entity_size - 1);
+}
+
+
+ShmStatHandler::~ShmStatHandler() {
+	munmap(region, mapped);
+	close(fd);
+	shm_unlink(name.c_str());
+}
+
+
+bool ShmStatHandler::resize(std::size_t size) {
+	if (size <= mapped) {
+		return true;
+	}
+	if (ftruncate(fd, size) < 0) {
+		return false;
+	}
+
+	// the readers keep their own mapping of the object
+	void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (address == MAP_FAILED) {
+		return false;
+	}
+	if (region != nullptr) {
+		munmap(region, mapped);
+	}
+	region = address;
+	mapped = size;
+	return true;
+}
+
+
+void ShmStatHandler::beginUpdate() {
+	auto header = static_cast<stat_shm_header *>(region);
+	header->sequence.store(header->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+
+void ShmStatHandler::endUpdate() {
+	auto header = static_cast<stat_shm_header *>(region);
+	header->sequence.store(header->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+
+void ShmStatHandler::emitStats(const std::vector<ProbeValue>& probesValues)
+{
+	auto header = static_cast<stat_shm_header *>(region);
+	auto values = reinterpret_cast<stat_shm_value *>(static_cast<char *>(region) + header->values_offset);
+	std::size_t count = std::min<std::size_t>(probesValues.size(), header->probe_count);
+	unsigned long long timestamp = getTimestamp();
+
+	beginUpdate();
+	for (std::size_t index = 0; index < count; ++index) {
+		const ProbeValue& probe = probesValues[index];
+		if (probe.isEmpty()) {
+			continue;
+		}
+		stat_shm_value& value = values[index];
+		value.timestamp = timestamp;
+		switch (probe.getDataType()) {
+			case INT32_TYPE:
+				value.value.int32 = probe.getInt32();
+				break;
+			case FLOAT_TYPE:
+				value.value.real32 = probe.getFloat();
+				break;
+			default:
+				value.value.real64 = probe.getDouble();
+				break;
+		}
+	}
+	header->timestamp = timestamp;
+	endUpdate();
+}
+
+
+void ShmStatHandler::configure(const std::vector<std::shared_ptr<BaseProbe>>& probes)
+{
+	// the region only grows, publish the probes that fit if it cannot
+	std::size_t count = probes.size();
+	if (!resize(sizeof(stat_shm_header) + count * (sizeof(stat_shm_entry) + sizeof(stat_shm_value)))) {
+		count = (mapped - sizeof(stat_shm_header)) / (sizeof(stat_shm_entry) + sizeof(stat_shm_value));
+	}
+
+	auto header = static_cast<stat_shm_header *>(region);
+	auto entries = reinterpret_cast<stat_shm_entry *>(static_cast<char *>(region) + sizeof(stat_shm_header));
+	auto values = reinterpret_cast<stat_shm_value *>(entries + count);
+
+	beginUpdate();
+	header->size = mapped;
+	header->layout++;
+	header->probe_count = count;
+	header->table_offset = sizeof(stat_shm_header);
+	header->values_offset = sizeof(stat_shm_header) + count * sizeof(stat_shm_entry);
+	for (std::size_t index = 0; index < count; ++index) {
+		stat_shm_entry& entry = entries[index];
+		std::memset(&entry, 0, sizeof(entry));
+		probes[index]->getName().copy(entry.name, stat_shm_name_size - 1);
+		probes[index]->getUnit().copy(entry.unit, stat_shm_unit_size - 1);
+		entry.type = probes[index]->getDataType();
+	}
+	std::memset(values, 0, count * sizeof(stat_shm_value));
+	endUpdate();
 }
 
 
@@ -267,10 +611,10 @@ void SocketLogHandler::emitLog(const std::string& logName, const std::string& le
 	std::string msg = formatter.str();
 
 	if (useTcp) {
-		std::lock_guard<std::mutex> acquire{lock};
+		OutputLock acquire{lock};
 		send(socketFd, msg.c_str(), msg.length(), 0);
 	} else {
-		std::lock_guard<std::mutex> acquire{lock};
+		OutputLock acquire{lock};
 		sendto(socketFd, msg.c_str(), msg.length(), 0, (struct sockaddr*)(&remote), sizeof(remote));
 	}
 }
@@ -285,7 +629,7 @@ StreamLogHandler::~StreamLogHandler() {
 
 
 void StreamLogHandler::emitLog(const std::string& logName, const std::string& level, const std::string& message) {
-	std::lock_guard<std::mutex> acquire{lock};
+	OutputLock acquire{lock};
 	prepareMessage(std::cerr, logName, level, message);
 	std::cerr << std::endl;
 }
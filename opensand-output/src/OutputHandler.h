@@ -39,9 +39,15 @@
 #include <string>
 #include <memory>
 #include <stdexcept>
+#include <vector>
 #include <sys/types.h>
 #include <netinet/in.h>
 
+#include "OutputMutex.h"
+
+
+class OutputFileWriter;
+
 
 class HandlerCreationFailedError : public std::runtime_error {
  public:
@@ -50,6 +56,7 @@ class HandlerCreationFailedError : public std::runtime_error {
 
 
 class BaseProbe;
+class ProbeValue;
 
 
 class Handler {
@@ -64,43 +71,122 @@ class Handler {
 class StatHandler : public Handler {
  public:
 	StatHandler(const std::string& entityName);
-	virtual void emitStats(const std::vector<std::pair<std::string, std::string>>& probesValues) = 0;
+	virtual void emitStats(const std::vector<ProbeValue>& probesValues) = 0;
 	virtual void configure(const std::vector<std::shared_ptr<BaseProbe>>& probes) = 0;
+
+	/**
+	 * @brief Announce the probes registered after the configuration, their
+	 *        values are appended to the emitted ones. Calls configure by default.
+	 *
+	 * @param probes  All the enabled probes
+	 * @param first   The index of the first new probe
+	 */
+	virtual void addProbes(const std::vector<std::shared_ptr<BaseProbe>>& probes, std::size_t first);
 };
 
 
 class FileStatHandler : public StatHandler {
  public:
-	FileStatHandler(const std::string& fileName, const std::string& originFolder);
+	/**
+	 * @param rotateSize    The size of the files triggering a rotation in bytes, 0 to disable
+	 * @param rotatePeriod  The age of the files triggering a rotation in seconds, 0 to disable
+	 * @param compress      Whether to compress the rotated files
+	 */
+	FileStatHandler(const std::string& fileName, const std::string& originFolder,
+	                std::size_t rotateSize=0, unsigned int rotatePeriod=0, bool compress=false);
 	~FileStatHandler();
 
-	void emitStats(const std::vector<std::pair<std::string, std::string>>& probesValues);
+	void emitStats(const std::vector<ProbeValue>& probesValues);
 	void configure(const std::vector<std::shared_ptr<BaseProbe>>& probes);
+	void addProbes(const std::vector<std::shared_ptr<BaseProbe>>& probes, std::size_t first);
 
  private:
 	std::string buildFullPath() const;
+	/// Write the columns header, repeated at the beginning of each rotated file
+	void writeHeader(const std::vector<std::shared_ptr<BaseProbe>>& probes);
 
-	std::ofstream file;
+	std::unique_ptr<OutputFileWriter> file;
 	unsigned long filesOpened;
 	std::string folder;
 	std::string filename;
+	std::size_t rotateSize;
+	unsigned int rotatePeriod;
+	bool compress;
 };
 
 
 class SocketStatHandler : public StatHandler {
  public:
-	SocketStatHandler(const std::string& entityName, const std::string& address, unsigned short port, bool useTCP=false);
+	/**
+	 * @param binary  Whether to use the binary statistics protocol
+	 *                (see OutputStatProtocol.h) instead of the text one
+	 */
+	SocketStatHandler(const std::string& entityName, const std::string& address, unsigned short port, bool useTCP=false, bool binary=false);
 	~SocketStatHandler();
 
-	void emitStats(const std::vector<std::pair<std::string, std::string>>& probesValues);
+	void emitStats(const std::vector<ProbeValue>& probesValues);
 	void configure(const std::vector<std::shared_ptr<BaseProbe>>& probes);
+	void addProbes(const std::vector<std::shared_ptr<BaseProbe>>& probes, std::size_t first);
 
  private:
+	void emitTextStats(const std::vector<ProbeValue>& probesValues);
+	/// Encode the definitions of the probes from the first one in new datagrams
+	void appendDefinitions(const std::vector<std::shared_ptr<BaseProbe>>& probes, std::size_t first);
+	void emitBinaryStats(const std::vector<ProbeValue>& probesValues);
+
+	/// Add a batch of encoded values to the pending datagram
+	void appendBatch(unsigned long long timestamp, const std::string& values, std::size_t count);
+	/// Send the pending datagram, if any
+	void flush();
+	void sendDefinitions(unsigned long long timestamp);
+	void sendDatagram(const std::string& datagram);
+
 	int socketFd;
 	struct sockaddr_in remote;
 	bool useTcp;
+	bool binary;
+
+	/// The number of the current probes configuration
+	uint16_t configuration;
+	/// The definitions datagrams of the current configuration
+	std::vector<std::string> definitions;
+	unsigned long long definitionsTimestamp;
+
+	/// The values datagram being filled and the timestamps of its
+	/// first and last batches
+	std::string pending;
+	unsigned long long pendingTimestamp;
+	unsigned long long batchTimestamp;
+
+	/// The time of the previous emission and the period between them
+	unsigned long long emitTimestamp;
+	unsigned long long emitPeriod;
+};
 
-	std::vector<std::string> statNames;
+
+class ShmStatHandler : public StatHandler {
+ public:
+	/**
+	 * @param name  The name of the POSIX shared memory object the latest
+	 *              values are published in (see OutputStatShm.h)
+	 */
+	ShmStatHandler(const std::string& entityName, const std::string& name);
+	~ShmStatHandler();
+
+	void emitStats(const std::vector<ProbeValue>& probesValues);
+	void configure(const std::vector<std::shared_ptr<BaseProbe>>& probes);
+
+ private:
+	/// Grow the region to the given size, keep it as is on failure
+	bool resize(std::size_t size);
+	/// Make the seqlock sequence odd, then even again
+	void beginUpdate();
+	void endUpdate();
+
+	std::string name;
+	int fd;
+	void *region;
+	std::size_t mapped;
 };
 
 
@@ -112,7 +198,7 @@ class LogHandler : public Handler {
  protected:
 	void prepareMessage(std::ostream& formatter, const std::string& logName, const std::string& level, const std::string& message);
 
-	std::mutex lock;
+	OutputMutex lock{"output.log_handler"};
 };
 
 
@@ -127,13 +213,19 @@ class StreamLogHandler : public LogHandler {
 
 class FileLogHandler : public LogHandler {
  public:
-	FileLogHandler(const std::string& fileName, const std::string& originFolder);
+	/**
+	 * @param rotateSize    The size of the file triggering a rotation in bytes, 0 to disable
+	 * @param rotatePeriod  The age of the file triggering a rotation in seconds, 0 to disable
+	 * @param compress      Whether to compress the rotated files
+	 */
+	FileLogHandler(const std::string& fileName, const std::string& originFolder,
+	               std::size_t rotateSize=0, unsigned int rotatePeriod=0, bool compress=false);
 	~FileLogHandler();
 
 	void emitLog(const std::string& logName, const std::string& level, const std::string& message);
 
  private:
-	std::ofstream file;
+	std::unique_ptr<OutputFileWriter> file;
 };
 
 
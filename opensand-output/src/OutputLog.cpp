@@ -34,8 +34,10 @@
 
 
 #include <cstdio>
+#include <chrono>
 
 #include "OutputLog.h"
+#include "OutputLogQueue.h"
 #include "OutputHandler.h"
 
 
@@ -57,7 +59,10 @@ const char *OutputLog::levels[] =
 
 OutputLog::OutputLog(log_level_t display_level, const std::string &name):
   name(name),
-  display_level(display_level)
+  display_level(display_level),
+  queue(nullptr),
+  rate_window(0),
+  rate_count(0)
 {
 }
 
@@ -70,15 +75,13 @@ OutputLog::~OutputLog()
 
 log_level_t OutputLog::getDisplayLevel(void) const
 {
-  OutputLock acquire{lock};
-  return this->display_level;
+  return this->display_level.load(std::memory_order_relaxed);
 }
 
 
 void OutputLog::setDisplayLevel(log_level_t level)
 {
-  OutputLock acquire{lock};
-  this->display_level = level;
+  this->display_level.store(level, std::memory_order_relaxed);
 }
 
 
@@ -100,12 +103,29 @@ void OutputLog::sendLog(log_level_t log_level, const char* msg_format, ...) cons
 
 void OutputLog::vSendLog(log_level_t log_level, const char* msg_format, va_list args) const
 {
-  if (log_level > display_level) {
+  if (!isEnabled(log_level)) {
     return;
   }
 
-  std::string message = formatMessage(msg_format, args);
+  if (queue != nullptr) {
+    // limit the storms of warnings and errors, lower levels are
+    // explicitly enabled by the user
+    if (log_level <= LEVEL_WARNING && !acceptRate()) {
+      queue->drop();
+      return;
+    }
+    if (queue->push(this, log_level, msg_format, args)) {
+      return;
+    }
+  }
+
+  emitLog(log_level, formatMessage(msg_format, args));
+}
+
 
+void OutputLog::emitLog(log_level_t log_level, const std::string &message) const
+{
+  OutputLock acquire{lock};
   const std::string level = levels[log_level];
   for (auto& handler : handlers) {
     handler->emitLog(name, level, message);
@@ -113,6 +133,23 @@ void OutputLog::vSendLog(log_level_t log_level, const char* msg_format, va_list
 }
 
 
+bool OutputLog::acceptRate() const
+{
+  uint32_t limit = queue->getRateLimit();
+  if (limit == 0) {
+    return true;
+  }
+
+  using namespace std::chrono;
+  int64_t now = duration_cast<seconds>(steady_clock::now().time_since_epoch()).count();
+  int64_t window = rate_window.load(std::memory_order_relaxed);
+  if (window != now && rate_window.compare_exchange_strong(window, now, std::memory_order_relaxed)) {
+    rate_count.store(0, std::memory_order_relaxed);
+  }
+  return rate_count.fetch_add(1, std::memory_order_relaxed) < limit;
+}
+
+
 std::string formatMessage(const char* name, std::va_list args)
 {
   std::va_list args_copy;
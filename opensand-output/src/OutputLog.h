@@ -44,6 +44,7 @@
 #include <vector>
 #include <memory>
 #include <cstdarg>
+#include <atomic>
 
 #include "OutputMutex.h"
 
@@ -66,6 +67,7 @@ enum log_level_t : unsigned int
 
 
 class LogHandler;
+class OutputLogQueue;
 
 
 /**
@@ -74,6 +76,7 @@ class LogHandler;
 class OutputLog
 {
   friend class Output;
+  friend class OutputLogQueue;
 
  public:
 
@@ -93,6 +96,19 @@ class OutputLog
    */
   log_level_t getDisplayLevel(void) const;
 
+  /**
+   * @brief Check whether the messages of a level are displayed,
+   *        inlined so that the LOG macro skips the formatting
+   *        and the arguments of the hidden messages
+   *
+   * @param log_level  The messages level
+   * @return true if the messages are displayed
+   */
+  inline bool isEnabled(log_level_t log_level) const
+  {
+    return log_level <= display_level.load(std::memory_order_relaxed);
+  };
+
   void addHandler(std::shared_ptr<LogHandler> handler);
 
   void sendLog(log_level_t log_level, const char* msg_format, ...) const;
@@ -115,15 +131,38 @@ class OutputLog
 
   void vSendLog(log_level_t log_level, const char* msg_format, va_list args) const;
 
+  /**
+   * @brief Send a formatted message to the handlers
+   *
+   * @param log_level  The message level
+   * @param message    The formatted message
+   */
+  void emitLog(log_level_t log_level, const std::string &message) const;
+
+  /**
+   * @brief Check whether a message fits in the log rate limit
+   *
+   * @return false if too many messages were sent during the current second
+   */
+  bool acceptRate() const;
+
   /// The levels string representation
   const static char *levels[];
 
 private:
   std::string name;
-  log_level_t display_level;
+  std::atomic<log_level_t> display_level;
   std::vector<std::shared_ptr<LogHandler>> handlers;
 
-  mutable OutputMutex lock;
+  /// The queue emitting the messages from the output thread,
+  /// messages are emitted synchronously without it
+  std::shared_ptr<OutputLogQueue> queue;
+
+  /// The second of the rate limit window and the messages sent during it
+  mutable std::atomic<int64_t> rate_window;
+  mutable std::atomic<uint32_t> rate_count;
+
+  mutable OutputMutex lock{"output.log"};
 };
 
 
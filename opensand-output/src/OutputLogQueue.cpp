@@ -0,0 +1,231 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file OutputLogQueue.cpp
+ * @brief The queue handing the logs over to the output thread that
+ *        emits them.
+ * @author Viveris Technologies
+ */
+
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <csignal>
+#include <pthread.h>
+
+#include "OutputLogQueue.h"
+
+
+/// The period of the dropped messages reports
+constexpr std::chrono::seconds report_period{1};
+
+
+OutputLogQueue::OutputLogQueue(std::size_t capacity):
+  mask(0),
+  enqueue_pos(0),
+  dequeue_pos(0),
+  rate_limit(100),
+  dropped(0),
+  reported(0),
+  report_log(nullptr),
+  running(false),
+  sleeping(false)
+{
+  std::size_t size = 1;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  slots = std::vector<Slot>(size);
+  for (std::size_t index = 0; index < size; ++index) {
+    slots[index].sequence.store(index, std::memory_order_relaxed);
+  }
+  mask = size - 1;
+}
+
+
+OutputLogQueue::~OutputLogQueue()
+{
+  stop();
+}
+
+
+void OutputLogQueue::start()
+{
+  if (running.exchange(true)) {
+    return;
+  }
+
+  // the signals are handled by the application threads (signalfd),
+  // the output thread must not catch them
+  sigset_t all_signals;
+  sigset_t previous_signals;
+  sigfillset(&all_signals);
+  pthread_sigmask(SIG_SETMASK, &all_signals, &previous_signals);
+  thread = std::thread{&OutputLogQueue::run, this};
+  pthread_sigmask(SIG_SETMASK, &previous_signals, nullptr);
+}
+
+
+void OutputLogQueue::stop()
+{
+  if (!running.exchange(false)) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> acquire{wake_lock};
+    wake.notify_one();
+  }
+  thread.join();
+  drain();
+  report();
+}
+
+
+void OutputLogQueue::setReportLog(std::shared_ptr<OutputLog> log)
+{
+  report_log = log;
+}
+
+
+bool OutputLogQueue::push(const OutputLog *log, log_level_t level, const char *msg_format, va_list args)
+{
+  if (!running.load(std::memory_order_relaxed)) {
+    return false;
+  }
+
+  Slot *slot;
+  std::size_t position = enqueue_pos.load(std::memory_order_relaxed);
+  for (;;) {
+    slot = &slots[position & mask];
+    std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+    if (difference == 0) {
+      if (enqueue_pos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      // full: the output thread is late, do not wait for it
+      drop();
+      return true;
+    } else {
+      position = enqueue_pos.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->log = log;
+  slot->level = level;
+  slot->long_message = nullptr;
+
+  std::va_list args_copy;
+  va_copy(args_copy, args);
+  int length = std::vsnprintf(slot->message, inline_length, msg_format, args_copy);
+  va_end(args_copy);
+  if (length < 0) {
+    length = 0;
+    slot->message[0] = '\0';
+  } else if (static_cast<std::size_t>(length) >= inline_length) {
+    slot->long_message.reset(new char[length + 1]);
+    std::vsnprintf(slot->long_message.get(), length + 1, msg_format, args);
+  }
+  slot->length = length;
+
+  slot->sequence.store(position + 1, std::memory_order_release);
+
+  // the output thread checks the queue after announcing it sleeps
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping.load(std::memory_order_seq_cst)) {
+    std::lock_guard<std::mutex> acquire{wake_lock};
+    wake.notify_one();
+  }
+  return true;
+}
+
+
+bool OutputLogQueue::isReady() const
+{
+  const Slot &slot = slots[dequeue_pos & mask];
+  return slot.sequence.load(std::memory_order_acquire) == dequeue_pos + 1;
+}
+
+
+bool OutputLogQueue::drain()
+{
+  bool emitted = false;
+  while (isReady()) {
+    Slot &slot = slots[dequeue_pos & mask];
+    const char *message = slot.long_message ? slot.long_message.get() : slot.message;
+    slot.log->emitLog(slot.level, std::string(message, slot.length));
+    slot.long_message = nullptr;
+    emitted = true;
+
+    // give the slot back to the producers for the next lap
+    slot.sequence.store(dequeue_pos + mask + 1, std::memory_order_release);
+    dequeue_pos++;
+  }
+  return emitted;
+}
+
+
+void OutputLogQueue::report()
+{
+  uint64_t total_dropped = getDropped();
+  if (total_dropped == reported || report_log == nullptr) {
+    return;
+  }
+
+  char message[64];
+  int length = std::snprintf(message, sizeof(message), "%llu log messages dropped",
+                             static_cast<unsigned long long>(total_dropped - reported));
+  report_log->emitLog(LEVEL_WARNING, std::string(message, length));
+  reported = total_dropped;
+}
+
+
+void OutputLogQueue::run()
+{
+  auto next_report = std::chrono::steady_clock::now() + report_period;
+  while (running.load(std::memory_order_relaxed)) {
+    if (!drain()) {
+      std::unique_lock<std::mutex> acquire{wake_lock};
+      sleeping.store(true, std::memory_order_seq_cst);
+      if (!isReady() && running.load(std::memory_order_relaxed)) {
+        wake.wait_until(acquire, next_report);
+      }
+      sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now >= next_report) {
+      // the dropped messages are reported at most once per period
+      report();
+      next_report = now + report_period;
+    }
+  }
+}
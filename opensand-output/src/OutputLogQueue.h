@@ -0,0 +1,184 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file OutputLogQueue.h
+ * @brief The queue handing the logs over to the output thread that
+ *        emits them, so that the application threads never block
+ *        on the logs handlers.
+ * @author Viveris Technologies
+ */
+
+
+#ifndef _OUTPUT_LOG_QUEUE_H
+#define _OUTPUT_LOG_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "OutputLog.h"
+
+
+/**
+ * @class OutputLogQueue
+ * @brief Lock-free bounded queue of formatted log messages
+ *        drained by a dedicated thread
+ *
+ * The producers format their message directly in a queue slot, and the slot
+ * is published with its sequence number (bounded MPMC queue of D. Vyukov).
+ * When the queue is full the message is dropped and counted, a logging thread
+ * never waits for the handlers.
+ */
+class OutputLogQueue
+{
+ public:
+  /**
+   * @param capacity  The number of slots, rounded up to a power of two
+   */
+  OutputLogQueue(std::size_t capacity = 4096);
+  ~OutputLogQueue();
+
+  /**
+   * @brief Start the thread emitting the queued messages
+   */
+  void start();
+
+  /**
+   * @brief Emit the messages remaining in the queue and stop the thread,
+   *        the following messages are emitted synchronously
+   */
+  void stop();
+
+  /**
+   * @brief Queue a message
+   *
+   * @param log         The log emitting the message
+   * @param level       The message level
+   * @param msg_format  The message format
+   * @param args        The message arguments
+   * @return false if the message must be emitted synchronously because the
+   *         thread is not running, true if it was queued or dropped
+   */
+  bool push(const OutputLog *log, log_level_t level, const char *msg_format, va_list args);
+
+  /**
+   * @brief Count a message dropped before being queued
+   */
+  inline void drop() { dropped.fetch_add(1, std::memory_order_relaxed); };
+
+  /**
+   * @brief Get the number of messages dropped since the queue creation
+   *
+   * @return the number of dropped messages
+   */
+  inline uint64_t getDropped() const { return dropped.load(std::memory_order_relaxed); };
+
+  /**
+   * @brief Set the maximum number of warnings and errors per second
+   *        emitted by each log, the following ones are dropped
+   *
+   * @param limit  The number of messages per second, 0 for no limit
+   */
+  inline void setRateLimit(uint32_t limit) { rate_limit.store(limit, std::memory_order_relaxed); };
+
+  /**
+   * @brief Get the maximum number of warnings and errors per second
+   *
+   * @return the number of messages per second, 0 for no limit
+   */
+  inline uint32_t getRateLimit() const { return rate_limit.load(std::memory_order_relaxed); };
+
+  /**
+   * @brief Set the log used to report the dropped messages
+   *
+   * @param log  The log, emitted synchronously from the output thread
+   */
+  void setReportLog(std::shared_ptr<OutputLog> log);
+
+ private:
+  /// The size of the messages kept in the slots,
+  /// longer messages are allocated
+  static constexpr std::size_t inline_length = 480;
+
+  struct Slot
+  {
+    std::atomic<std::size_t> sequence;
+    const OutputLog *log;
+    log_level_t level;
+    std::size_t length;
+    std::unique_ptr<char[]> long_message;
+    char message[inline_length];
+  };
+
+  /**
+   * @brief Check whether the next message can be emitted
+   *
+   * @return true if the next slot is published
+   */
+  bool isReady() const;
+
+  /**
+   * @brief Emit the queued messages
+   *
+   * @return whether some messages were emitted
+   */
+  bool drain();
+
+  /**
+   * @brief Report the messages dropped since the previous report
+   */
+  void report();
+
+  /// The output thread main loop
+  void run();
+
+  std::vector<Slot> slots;
+  std::size_t mask;
+  alignas(64) std::atomic<std::size_t> enqueue_pos;
+  alignas(64) std::size_t dequeue_pos;
+
+  std::atomic<uint32_t> rate_limit;
+  std::atomic<uint64_t> dropped;
+  uint64_t reported;
+  std::shared_ptr<OutputLog> report_log;
+
+  std::atomic<bool> running;
+  std::atomic<bool> sleeping;
+  std::mutex wake_lock;
+  std::condition_variable wake;
+  std::thread thread;
+};
+
+
+#endif
@@ -0,0 +1,371 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file OutputMetrics.cpp
+ * @brief The HTTP endpoint serving the latest probes values to the
+ *        monitoring systems in the OpenMetrics/Prometheus text format.
+ * @author Viveris Technologies
+ */
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#include <arpa/inet.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "OutputMetrics.h"
+#include "HistogramProbe.h"
+
+
+/// The maximum size of a scrape request
+constexpr std::size_t metricsMaxRequest = 8192;
+
+/// The time a scraper gets to send its request and read the answer (s)
+constexpr time_t metricsTimeout = 2;
+
+
+/// Make a probe name a valid metric name: [a-zA-Z_:][a-zA-Z0-9_:]*
+static std::string metricName(const std::string& probeName) {
+	std::string name = "opensand_";
+	for (char character : probeName) {
+		bool valid = (character >= 'a' && character <= 'z') ||
+		             (character >= 'A' && character <= 'Z') ||
+		             (character >= '0' && character <= '9') ||
+		             character == '_' || character == ':';
+		name += valid ? character : '_';
+	}
+	return name;
+}
+
+
+/// Escape a label value or a help text
+static std::string escape(const std::string& text) {
+	std::string escaped;
+	for (char character : text) {
+		switch (character) {
+			case '\\':
+				escaped += "\\\\";
+				break;
+			case '"':
+				escaped += "\\\"";
+				break;
+			case '\n':
+				escaped += "\\n";
+				break;
+			default:
+				escaped += character;
+				break;
+		}
+	}
+	return escaped;
+}
+
+
+static std::string formatNumber(double value) {
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.10g", value);
+	return buffer;
+}
+
+
+MetricsStatHandler::MetricsStatHandler(const std::string& entityName, const std::string& address, unsigned short port) :
+	StatHandler(entityName),
+	listenFd(-1),
+	wakeFd(-1),
+	labels("entity=\"" + escape(entityName) + "\"")
+{
+	struct sockaddr_in local;
+	std::memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_port = htons(port);
+	if (inet_pton(AF_INET, address.c_str(), &local.sin_addr) <= 0) {
+		std::stringstream message;
+		message << "Cannot set " << address << " as metrics endpoint address.";
+		throw HandlerCreationFailedError(message.str());
+	}
+
+	if ((listenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) {
+		throw HandlerCreationFailedError("Cannot open metrics endpoint socket.");
+	}
+	int reuse = 1;
+	setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	if (bind(listenFd, reinterpret_cast<struct sockaddr *>(&local), sizeof(local)) < 0 ||
+	    listen(listenFd, 8) < 0) {
+		close(listenFd);
+		std::stringstream message;
+		message << "Cannot listen for scrapes on " << address << ":" << port << ".";
+		throw HandlerCreationFailedError(message.str());
+	}
+
+	if ((wakeFd = eventfd(0, EFD_CLOEXEC)) < 0) {
+		close(listenFd);
+		throw HandlerCreationFailedError("Cannot create metrics endpoint eventfd.");
+	}
+
+	// the signals are handled by the application threads (signalfd),
+	// the endpoint thread must not catch them
+	sigset_t all_signals;
+	sigset_t previous_signals;
+	sigfillset(&all_signals);
+	pthread_sigmask(SIG_SETMASK, &all_signals, &previous_signals);
+	thread = std::thread{&MetricsStatHandler::run, this};
+	pthread_sigmask(SIG_SETMASK, &previous_signals, nullptr);
+}
+
+
+MetricsStatHandler::~MetricsStatHandler() {
+	uint64_t wake = 1;
+	if (write(wakeFd, &wake, sizeof(wake)) < 0) {
+		std::perror("metrics endpoint wake up");
+	}
+	thread.join();
+	close(wakeFd);
+	close(listenFd);
+}
+
+
+MetricsStatHandler::Metric MetricsStatHandler::makeMetric(const BaseProbe& probe)
+{
+	Metric metric;
+	metric.name = metricName(probe.getName());
+	metric.help = escape(probe.getName());
+	if (!probe.getUnit().empty()) {
+		metric.help += " (" + escape(probe.getUnit()) + ")";
+	}
+	metric.type = probe.getDataType();
+	metric.valued = false;
+	metric.value = 0;
+	metric.count = 0;
+	metric.sum = 0;
+	if (metric.type == HISTOGRAM_TYPE) {
+		metric.buckets.assign(HistogramProbe::buckets_count, 0);
+	}
+	return metric;
+}
+
+
+void MetricsStatHandler::configure(const std::vector<std::shared_ptr<BaseProbe>>& probes)
+{
+	std::vector<Metric> configured;
+	configured.reserve(probes.size());
+	for (auto& probe : probes) {
+		configured.push_back(makeMetric(*probe));
+	}
+
+	OutputLock acquire{lock};
+	metrics.swap(configured);
+}
+
+
+void MetricsStatHandler::addProbes(const std::vector<std::shared_ptr<BaseProbe>>& probes, std::size_t first)
+{
+	std::vector<Metric> added;
+	for (std::size_t index = first; index < probes.size(); ++index) {
+		added.push_back(makeMetric(*probes[index]));
+	}
+
+	// the values of the previous probes are kept
+	OutputLock acquire{lock};
+	metrics.resize(first);
+	for (auto& metric : added) {
+		metrics.push_back(std::move(metric));
+	}
+}
+
+
+void MetricsStatHandler::emitStats(const std::vector<ProbeValue>& probesValues)
+{
+	OutputLock acquire{lock};
+	std::size_t count = std::min(probesValues.size(), metrics.size());
+	for (std::size_t index = 0; index < count; ++index) {
+		const ProbeValue& value = probesValues[index];
+		if (value.isEmpty()) {
+			continue;
+		}
+
+		Metric& metric = metrics[index];
+		metric.valued = true;
+		switch (value.getDataType()) {
+			case INT32_TYPE:
+				metric.value = value.getInt32();
+				break;
+			case FLOAT_TYPE:
+				metric.value = value.getFloat();
+				break;
+			case DOUBLE_TYPE:
+				metric.value = value.getDouble();
+				break;
+			case HISTOGRAM_TYPE: {
+				const HistogramValue& histogram = value.getHistogram();
+				metric.count += histogram.count;
+				metric.sum += histogram.sum;
+				for (auto& bucket : histogram.buckets) {
+					metric.buckets[bucket.first] += bucket.second;
+				}
+				break;
+			}
+		}
+	}
+}
+
+
+std::string MetricsStatHandler::render(bool openMetrics)
+{
+	// copy the values so that the probes sending does not wait for the formatting
+	std::vector<Metric> snapshot;
+	{
+		OutputLock acquire{lock};
+		snapshot = metrics;
+	}
+
+	std::string exposition;
+	for (auto& metric : snapshot) {
+		if (!metric.valued) {
+			continue;
+		}
+
+		exposition += "# HELP " + metric.name + " " + metric.help + "\n";
+		if (metric.type != HISTOGRAM_TYPE) {
+			exposition += "# TYPE " + metric.name + " gauge\n";
+			exposition += metric.name + "{" + labels + "} " + formatNumber(metric.value) + "\n";
+			continue;
+		}
+
+		exposition += "# TYPE " + metric.name + " histogram\n";
+		uint64_t cumulated = 0;
+		for (unsigned int bucket = 0; bucket < metric.buckets.size(); ++bucket) {
+			if (metric.buckets[bucket] == 0 || bucket + 1 == metric.buckets.size()) {
+				continue;
+			}
+			cumulated += metric.buckets[bucket];
+			exposition += metric.name + "_bucket{" + labels + ",le=\"" +
+			              std::to_string(HistogramProbe::getUpperBound(bucket)) + "\"} " +
+			              std::to_string(cumulated) + "\n";
+		}
+		exposition += metric.name + "_bucket{" + labels + ",le=\"+Inf\"} " + std::to_string(metric.count) + "\n";
+		exposition += metric.name + "_sum{" + labels + "} " + std::to_string(metric.sum) + "\n";
+		exposition += metric.name + "_count{" + labels + "} " + std::to_string(metric.count) + "\n";
+	}
+
+	if (openMetrics) {
+		exposition += "# EOF\n";
+	}
+	return exposition;
+}
+
+
+void MetricsStatHandler::run()
+{
+	struct pollfd fds[2];
+	fds[0].fd = listenFd;
+	fds[0].events = POLLIN;
+	fds[1].fd = wakeFd;
+	fds[1].events = POLLIN;
+
+	while (true) {
+		fds[0].revents = 0;
+		fds[1].revents = 0;
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return;
+		}
+		if (fds[1].revents) {
+			return;
+		}
+		if (fds[0].revents & POLLIN) {
+			int client = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+			if (client >= 0) {
+				serve(client);
+				close(client);
+			}
+		}
+	}
+}
+
+
+void MetricsStatHandler::serve(int client)
+{
+	// a scraper too slow does not hold the endpoint for long
+	struct timeval timeout{metricsTimeout, 0};
+	setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+	std::string request;
+	char buffer[1024];
+	while (request.find("\r\n\r\n") == std::string::npos) {
+		ssize_t received = recv(client, buffer, sizeof(buffer), 0);
+		if (received <= 0 || request.size() + received > metricsMaxRequest) {
+			return;
+		}
+		request.append(buffer, received);
+	}
+
+	std::string status = "200 OK";
+	std::string contentType = "text/plain; version=0.0.4; charset=utf-8";
+	std::string body;
+	std::string line = request.substr(0, request.find("\r\n"));
+	std::size_t separator = line.find(' ');
+	std::string method = line.substr(0, separator);
+	std::string path = line.substr(separator + 1, line.find(' ', separator + 1) - separator - 1);
+	if (method != "GET") {
+		status = "405 Method Not Allowed";
+	} else if (path != "/metrics" && path != "/") {
+		status = "404 Not Found";
+	} else {
+		bool openMetrics = request.find("application/openmetrics-text") != std::string::npos;
+		if (openMetrics) {
+			contentType = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+		}
+		body = render(openMetrics);
+	}
+
+	std::string response = "HTTP/1.1 " + status + "\r\n" +
+	                       "Content-Type: " + contentType + "\r\n" +
+	                       "Content-Length: " + std::to_string(body.size()) + "\r\n" +
+	                       "Connection: close\r\n\r\n" + body;
+	std::size_t sent = 0;
+	while (sent < response.size()) {
+		ssize_t written = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+		if (written <= 0) {
+			return;
+		}
+		sent += written;
+	}
+}
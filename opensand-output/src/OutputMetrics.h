@@ -0,0 +1,113 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file OutputMetrics.h
+ * @brief The HTTP endpoint serving the latest probes values to the
+ *        monitoring systems in the OpenMetrics/Prometheus text format.
+ * @author Viveris Technologies
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BaseProbe.h"
+#include "OutputHandler.h"
+
+
+/**
+ * @class MetricsStatHandler
+ * @brief Keep the latest value of each probe and render them when the
+ *        endpoint is scraped
+ *
+ * The probes sending only stores the values taken from the probes, the
+ * rendering and the HTTP exchanges happen on the endpoint thread at the
+ * pace of the scrapes. The probes are gauges of their latest value, the
+ * histogram probes are histograms whose buckets, sum and count add up the
+ * values since the probes configuration.
+ */
+class MetricsStatHandler : public StatHandler {
+ public:
+	/**
+	 * @param address  The address the endpoint listens on
+	 * @param port     The TCP port the endpoint listens on
+	 */
+	MetricsStatHandler(const std::string& entityName, const std::string& address, unsigned short port);
+	~MetricsStatHandler();
+
+	void emitStats(const std::vector<ProbeValue>& probesValues);
+	void configure(const std::vector<std::shared_ptr<BaseProbe>>& probes);
+	void addProbes(const std::vector<std::shared_ptr<BaseProbe>>& probes, std::size_t first);
+
+	/**
+	 * @brief Render the latest values
+	 *
+	 * @param openMetrics  Whether to use the OpenMetrics format instead
+	 *                     of the Prometheus text format 0.0.4
+	 * @return the metrics exposition
+	 */
+	std::string render(bool openMetrics);
+
+ private:
+	/// The latest value of a probe
+	struct Metric
+	{
+		std::string name;
+		std::string help;
+		datatype_t type;
+		bool valued;
+		double value;
+		/// the cumulated distribution of a histogram probe
+		uint64_t count;
+		uint64_t sum;
+		std::vector<uint64_t> buckets;
+	};
+
+	/// Build the metric of a probe, without value
+	static Metric makeMetric(const BaseProbe& probe);
+
+	/// The endpoint thread main loop
+	void run();
+	/// Answer a scrape on an accepted connection
+	void serve(int client);
+
+	int listenFd;
+	int wakeFd;
+	std::thread thread;
+
+	/// The labels of all the metrics
+	std::string labels;
+	/// Protects the metrics between the probes sending and the rendering
+	OutputMutex lock{"output.metrics"};
+	std::vector<Metric> metrics;
+};
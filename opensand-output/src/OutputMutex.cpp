@@ -0,0 +1,245 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file OutputMutex.cpp
+ * @brief  The profiling of the wait and hold times of the locks
+ * @author Viveris Technologies
+ */
+
+
+#include <algorithm>
+#include <ctime>
+#include <iomanip>
+#include <map>
+
+#include "OutputMutex.h"
+#include "HistogramProbe.h"
+
+
+std::atomic<bool> LockProfiler::enabled{false};
+
+
+/**
+ * @brief The sites by name, protected by a plain mutex as the sites
+ *        are created by the profiled mutexes
+ */
+struct LockSites
+{
+	std::mutex mutex;
+	std::map<std::string, std::unique_ptr<LockSite>> sites;
+};
+
+
+static LockSites& getSites()
+{
+	// created on first use, the mutexes of the static objects need it
+	static LockSites *sites = new LockSites();
+	return *sites;
+}
+
+
+LockSite::LockSite(const std::string& name):
+	name(name),
+	wait(),
+	hold(),
+	total_wait(),
+	total_hold(),
+	exposed(false)
+{
+}
+
+
+void LockSite::createHistograms()
+{
+	// one unit per site whatever the dots in its name, the names are
+	// already normalized as registered by the output
+	std::string unit = "locks." + name;
+	std::replace(unit.begin() + 6, unit.end(), '.', '_');
+	wait.reset(new HistogramProbe(unit + ".wait_time", "ns", true));
+	hold.reset(new HistogramProbe(unit + ".hold_time", "ns", true));
+	total_wait.reset(new HistogramProbe(unit + ".total_wait_time", "ns", true));
+	total_hold.reset(new HistogramProbe(unit + ".total_hold_time", "ns", true));
+}
+
+
+void LockSite::record(uint64_t wait, uint64_t hold)
+{
+	this->wait->put(wait);
+	this->hold->put(hold);
+	total_wait->put(wait);
+	total_hold->put(hold);
+}
+
+
+void LockProfiler::enable()
+{
+	LockSites& registry = getSites();
+	std::lock_guard<std::mutex> acquire{registry.mutex};
+	if(enabled.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+	for(auto& site : registry.sites)
+	{
+		site.second->createHistograms();
+	}
+	// the histograms are created before the locks see the profiling enabled
+	enabled.store(true, std::memory_order_release);
+}
+
+
+LockSite *LockProfiler::getSite(const std::string& name)
+{
+	LockSites& registry = getSites();
+	std::lock_guard<std::mutex> acquire{registry.mutex};
+	std::unique_ptr<LockSite>& site = registry.sites[name];
+	if(site == nullptr)
+	{
+		site.reset(new LockSite(name));
+		if(enabled.load(std::memory_order_relaxed))
+		{
+			site->createHistograms();
+		}
+	}
+	return site.get();
+}
+
+
+uint64_t LockProfiler::now()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return uint64_t(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+
+std::vector<std::pair<std::string, std::shared_ptr<BaseProbe>>> LockProfiler::takeProbes()
+{
+	std::vector<std::pair<std::string, std::shared_ptr<BaseProbe>>> probes;
+	if(!isEnabled())
+	{
+		return probes;
+	}
+
+	LockSites& registry = getSites();
+	std::lock_guard<std::mutex> acquire{registry.mutex};
+	for(auto& entry : registry.sites)
+	{
+		LockSite& site = *entry.second;
+		if(site.exposed)
+		{
+			continue;
+		}
+		site.exposed = true;
+		probes.emplace_back(site.wait->getName(), site.wait);
+		probes.emplace_back(site.hold->getName(), site.hold);
+	}
+	return probes;
+}
+
+
+void LockProfiler::dump(std::ostream& report)
+{
+	if(!isEnabled())
+	{
+		return;
+	}
+
+	std::vector<std::pair<LockSite *, std::pair<ProbeValue, ProbeValue>>> sites;
+	{
+		LockSites& registry = getSites();
+		std::lock_guard<std::mutex> acquire{registry.mutex};
+		for(auto& entry : registry.sites)
+		{
+			LockSite& site = *entry.second;
+			ProbeValue wait = site.total_wait->takeValue();
+			ProbeValue hold = site.total_hold->takeValue();
+			if(!wait.isEmpty() && !hold.isEmpty())
+			{
+				sites.emplace_back(&site, std::make_pair(wait, hold));
+			}
+		}
+	}
+	std::sort(sites.begin(), sites.end(), [](const std::pair<LockSite *, std::pair<ProbeValue, ProbeValue>>& first,
+	                                         const std::pair<LockSite *, std::pair<ProbeValue, ProbeValue>>& second) {
+		return first.second.first.getHistogram().sum > second.second.first.getHistogram().sum;
+	});
+
+	report << std::left << std::setw(32) << "site" << std::right
+	       << std::setw(12) << "locks"
+	       << std::setw(14) << "wait total"
+	       << std::setw(10) << "wait p50" << std::setw(10) << "wait p99" << std::setw(12) << "wait max"
+	       << std::setw(10) << "hold p50" << std::setw(10) << "hold p99" << std::setw(12) << "hold max"
+	       << " (ns)\n";
+	for(auto& site : sites)
+	{
+		const HistogramValue& wait = site.second.first.getHistogram();
+		const HistogramValue& hold = site.second.second.getHistogram();
+		report << std::left << std::setw(32) << site.first->name << std::right
+		       << std::setw(12) << wait.count
+		       << std::setw(14) << wait.sum
+		       << std::setw(10) << wait.p50 << std::setw(10) << wait.p99 << std::setw(12) << wait.max
+		       << std::setw(10) << hold.p50 << std::setw(10) << hold.p99 << std::setw(12) << hold.max
+		       << "\n";
+	}
+}
+
+
+OutputMutex::OutputMutex():
+	OutputMutex("unnamed")
+{
+}
+
+
+OutputMutex::OutputMutex(const std::string& site):
+	mutex(),
+	site(LockProfiler::getSite(site)),
+	waited(0),
+	acquired(0)
+{
+}
+
+
+void OutputMutex::lockProfiled()
+{
+	uint64_t start = LockProfiler::now();
+	mutex.lock();
+	acquired = LockProfiler::now();
+	waited = acquired - start;
+}
+
+
+void OutputMutex::unlockProfiled()
+{
+	uint64_t wait = waited;
+	uint64_t hold = LockProfiler::now() - acquired;
+	acquired = 0;
+	mutex.unlock();
+	// recorded out of the critical section
+	site->record(wait, hold);
+}
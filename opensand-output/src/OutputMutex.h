@@ -27,7 +27,8 @@
 
 /**
  * @file OutputMutex.h
- * @brief  Wrapper for using a mutex with RAII method
+ * @brief  Wrapper for using a mutex with RAII method, with an opt-in
+ *         profiling of the wait and hold times of the locks
  * @author Julien BERNARD     <jbernard@toulouse.viveris.com>
  * @author Mathias Ettinger   <mathias.ettinger@viveris.fr>
  */
@@ -37,10 +38,175 @@
 #ifndef OUTPUT_MUTEX_H
 #define OUTPUT_MUTEX_H
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+class BaseProbe;
+class HistogramProbe;
+
+
+/**
+ * @class LockSite
+ * @brief The wait and hold times of the locks sharing a name
+ */
+class LockSite
+{
+	friend class LockProfiler;
+
+ public:
+	/**
+	 * @brief Record an acquisition of a lock of the site
+	 *
+	 * @param wait  The time waited for the lock (ns)
+	 * @param hold  The time the lock was held (ns)
+	 */
+	void record(uint64_t wait, uint64_t hold);
+
+	/// The site name
+	const std::string name;
+
+ private:
+	LockSite(const std::string& name);
+
+	/// Create the histograms, when the profiling is enabled
+	void createHistograms();
+
+	/// The times since the last probes sending and since the start
+	std::shared_ptr<HistogramProbe> wait;
+	std::shared_ptr<HistogramProbe> hold;
+	std::shared_ptr<HistogramProbe> total_wait;
+	std::shared_ptr<HistogramProbe> total_hold;
+	/// Whether the probes of the site are registered in the output
+	bool exposed;
+};
+
+
+/**
+ * @class LockProfiler
+ * @brief The registry of the lock sites
+ *
+ * The profiling is disabled by default: the locks then only check it is
+ * disabled. Once enabled, the wait and hold times of each lock are
+ * recorded after its release in the histograms of its site.
+ */
+class LockProfiler
+{
+ public:
+	/**
+	 * @brief Enable the profiling of all the locks, it cannot be disabled
+	 */
+	static void enable();
+
+	static inline bool isEnabled() { return enabled.load(std::memory_order_acquire); };
+
+	/**
+	 * @brief Get a site from its name, creating it if needed,
+	 *        the sites live until the end of the process
+	 *
+	 * @param name  The site name
+	 * @return the site
+	 */
+	static LockSite *getSite(const std::string& name);
+
+	/**
+	 * @brief Get the time the locks are measured with
+	 *
+	 * @return the monotonic time (ns)
+	 */
+	static uint64_t now();
+
+	/**
+	 * @brief Get the probes of the sites not registered in the output yet
+	 *
+	 * @return the probes with their names
+	 */
+	static std::vector<std::pair<std::string, std::shared_ptr<BaseProbe>>> takeProbes();
+
+	/**
+	 * @brief Write the times of each site since the start, the sites
+	 *        waited for the most first
+	 *
+	 * @param report  The stream the report is written in
+	 */
+	static void dump(std::ostream& report);
+
+ private:
+	static std::atomic<bool> enabled;
+};
+
+
+/**
+ * @class OutputMutex
+ * @brief A mutex whose wait and hold times are recorded in its site
+ *        when the profiling is enabled
+ */
+class OutputMutex
+{
+ public:
+	OutputMutex();
+
+	/**
+	 * @param site  The name of the site the times are recorded in
+	 */
+	OutputMutex(const std::string& site);
+
+	OutputMutex(const OutputMutex&) = delete;
+	OutputMutex& operator =(const OutputMutex&) = delete;
+
+	inline void lock()
+	{
+		if(!LockProfiler::isEnabled())
+		{
+			mutex.lock();
+			return;
+		}
+		lockProfiled();
+	};
+
+	inline bool try_lock()
+	{
+		if(!mutex.try_lock())
+		{
+			return false;
+		}
+		if(LockProfiler::isEnabled())
+		{
+			waited = 0;
+			acquired = LockProfiler::now();
+		}
+		return true;
+	};
+
+	inline void unlock()
+	{
+		// a lock taken before the profiling was enabled is not recorded
+		if(acquired == 0)
+		{
+			mutex.unlock();
+			return;
+		}
+		unlockProfiled();
+	};
+
+ private:
+	void lockProfiled();
+	void unlockProfiled();
+
+	std::mutex mutex;
+	LockSite *site;
+	/// The wait time and the acquisition time of the current owner
+	uint64_t waited;
+	uint64_t acquired;
+};
 
 
-using OutputMutex = std::mutex;
 using OutputLock = std::lock_guard<OutputMutex>;
 
 
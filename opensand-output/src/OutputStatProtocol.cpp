@@ -0,0 +1,406 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file OutputStatProtocol.cpp
+ * @brief The binary protocol used to send the probes values to a collector
+ *        and its decoder for the collector side.
+ * @author Viveris Technologies
+ */
+
+
+#include <algorithm>
+#include <cstring>
+
+#include "OutputStatProtocol.h"
+
+
+void StatEncoder::writeHeader(std::string& buffer, StatMessageType type,
+                              uint16_t configuration, const std::string& entityName)
+{
+	std::size_t length = std::min<std::size_t>(entityName.length(), UINT8_MAX);
+
+	buffer.clear();
+	writeU32(buffer, stat_protocol_magic);
+	writeU8(buffer, stat_protocol_version);
+	writeU8(buffer, static_cast<uint8_t>(type));
+	writeU16(buffer, configuration);
+	writeU8(buffer, length);
+	buffer.append(entityName, 0, length);
+}
+
+
+void StatEncoder::writeU8(std::string& buffer, uint8_t value)
+{
+	buffer.push_back(static_cast<char>(value));
+}
+
+
+void StatEncoder::writeU16(std::string& buffer, uint16_t value)
+{
+	writeU8(buffer, value >> 8);
+	writeU8(buffer, value);
+}
+
+
+void StatEncoder::writeU32(std::string& buffer, uint32_t value)
+{
+	writeU16(buffer, value >> 16);
+	writeU16(buffer, value);
+}
+
+
+void StatEncoder::writeU64(std::string& buffer, uint64_t value)
+{
+	writeU32(buffer, value >> 32);
+	writeU32(buffer, value);
+}
+
+
+void StatEncoder::writeVarint(std::string& buffer, uint64_t value)
+{
+	while (value >= 0x80) {
+		writeU8(buffer, (value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	writeU8(buffer, value);
+}
+
+
+void StatEncoder::writeString(std::string& buffer, const std::string& value)
+{
+	writeVarint(buffer, value.length());
+	buffer.append(value);
+}
+
+
+static std::size_t varintSize(uint64_t value)
+{
+	std::size_t size = 1;
+	while (value >= 0x80) {
+		value >>= 7;
+		size++;
+	}
+	return size;
+}
+
+
+/// Get the encoded size of the buckets of a histogram, 0 if they are left out
+static std::size_t bucketsSize(const HistogramValue& histogram)
+{
+	std::size_t size = 0;
+	uint32_t previous = 0;
+	for (auto& bucket : histogram.buckets) {
+		size += varintSize(bucket.first - previous) + varintSize(bucket.second);
+		previous = bucket.first;
+	}
+	return size > stat_protocol_max_histogram ? 0 : size;
+}
+
+
+void StatEncoder::writeValue(std::string& buffer, const ProbeValue& value)
+{
+	switch (value.getDataType()) {
+		case INT32_TYPE:
+			writeU32(buffer, static_cast<uint32_t>(value.getInt32()));
+			break;
+
+		case FLOAT_TYPE: {
+			float real = value.getFloat();
+			uint32_t bits;
+			std::memcpy(&bits, &real, sizeof(bits));
+			writeU32(buffer, bits);
+			break;
+		}
+
+		case DOUBLE_TYPE: {
+			double real = value.getDouble();
+			uint64_t bits;
+			std::memcpy(&bits, &real, sizeof(bits));
+			writeU64(buffer, bits);
+			break;
+		}
+
+		case HISTOGRAM_TYPE: {
+			const HistogramValue& histogram = value.getHistogram();
+			writeVarint(buffer, histogram.count);
+			writeVarint(buffer, histogram.sum);
+			writeVarint(buffer, histogram.max);
+			writeVarint(buffer, histogram.p50);
+			writeVarint(buffer, histogram.p90);
+			writeVarint(buffer, histogram.p99);
+			if (!bucketsSize(histogram)) {
+				writeVarint(buffer, 0);
+				break;
+			}
+			writeVarint(buffer, histogram.buckets.size());
+			uint32_t previous = 0;
+			for (auto& bucket : histogram.buckets) {
+				writeVarint(buffer, bucket.first - previous);
+				writeVarint(buffer, bucket.second);
+				previous = bucket.first;
+			}
+			break;
+		}
+	}
+}
+
+
+std::size_t StatEncoder::valueSize(datatype_t type)
+{
+	return type == DOUBLE_TYPE ? sizeof(uint64_t) : sizeof(uint32_t);
+}
+
+
+std::size_t StatEncoder::valueSize(const ProbeValue& value)
+{
+	if (value.getDataType() != HISTOGRAM_TYPE) {
+		return valueSize(value.getDataType());
+	}
+
+	const HistogramValue& histogram = value.getHistogram();
+	std::size_t buckets = bucketsSize(histogram);
+	return varintSize(histogram.count) + varintSize(histogram.sum) + varintSize(histogram.max) +
+	       varintSize(histogram.p50) + varintSize(histogram.p90) + varintSize(histogram.p99) +
+	       varintSize(buckets ? histogram.buckets.size() : 0) + buckets;
+}
+
+
+static bool readU8(const uint8_t *&data, const uint8_t *end, uint8_t& value)
+{
+	if (data >= end) {
+		return false;
+	}
+	value = *data++;
+	return true;
+}
+
+
+static bool readUint(const uint8_t *&data, const uint8_t *end, std::size_t size, uint64_t& value)
+{
+	if (static_cast<std::size_t>(end - data) < size) {
+		return false;
+	}
+	value = 0;
+	for (std::size_t index = 0; index < size; ++index) {
+		value = (value << 8) | *data++;
+	}
+	return true;
+}
+
+
+static bool readVarint(const uint8_t *&data, const uint8_t *end, uint64_t& value)
+{
+	value = 0;
+	for (unsigned int shift = 0; shift < 64; shift += 7) {
+		uint8_t byte;
+		if (!readU8(data, end, byte)) {
+			return false;
+		}
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+static bool readString(const uint8_t *&data, const uint8_t *end, std::string& value)
+{
+	uint64_t length;
+	if (!readVarint(data, end, length) || static_cast<uint64_t>(end - data) < length) {
+		return false;
+	}
+	value.assign(reinterpret_cast<const char *>(data), length);
+	data += length;
+	return true;
+}
+
+
+StatDecoder::StatDecoder(): entities() {
+}
+
+
+bool StatDecoder::decode(const uint8_t *data, std::size_t length, std::vector<StatSample>& samples)
+{
+	const uint8_t *end = data + length;
+	uint64_t magic;
+	uint8_t version;
+	uint8_t type;
+	uint64_t configuration;
+	uint8_t nameLength;
+
+	if (!readUint(data, end, 4, magic) || magic != stat_protocol_magic ||
+	    !readU8(data, end, version) || version != stat_protocol_version ||
+	    !readU8(data, end, type) ||
+	    !readUint(data, end, 2, configuration) ||
+	    !readU8(data, end, nameLength) ||
+	    end - data < nameLength) {
+		return false;
+	}
+	std::string name(reinterpret_cast<const char *>(data), nameLength);
+	data += nameLength;
+
+	switch (static_cast<StatMessageType>(type)) {
+		case StatMessageType::definitions: {
+			Entity& entity = entities[name];
+			if (entity.configuration != configuration) {
+				// the probes were reconfigured, drop the previous definitions
+				entity.configuration = configuration;
+				entity.definitions.clear();
+			}
+			return decodeDefinitions(data, end, entity);
+		}
+
+		case StatMessageType::values: {
+			auto entity = entities.find(name);
+			if (entity == entities.end() || entity->second.configuration != configuration) {
+				return false;
+			}
+			return decodeValues(data, end, name, entity->second, samples);
+		}
+	}
+
+	return false;
+}
+
+
+bool StatDecoder::decodeDefinitions(const uint8_t *&data, const uint8_t *end, Entity& entity)
+{
+	while (data < end) {
+		uint64_t id;
+		uint8_t type;
+		Definition definition;
+		if (!readVarint(data, end, id) || !readU8(data, end, type) || type > HISTOGRAM_TYPE ||
+		    !readString(data, end, definition.name) || !readString(data, end, definition.unit)) {
+			return false;
+		}
+		definition.type = static_cast<datatype_t>(type);
+		entity.definitions[id] = definition;
+	}
+	return true;
+}
+
+
+bool StatDecoder::decodeValues(const uint8_t *&data, const uint8_t *end, const std::string& name,
+                               const Entity& entity, std::vector<StatSample>& samples)
+{
+	uint64_t timestamp;
+	if (!readUint(data, end, 8, timestamp)) {
+		return false;
+	}
+
+	while (data < end) {
+		uint64_t delay;
+		uint64_t count;
+		uint64_t id = 0;
+		if (!readVarint(data, end, delay) || !readVarint(data, end, count)) {
+			return false;
+		}
+		timestamp += delay;
+
+		for (uint64_t index = 0; index < count; ++index) {
+			uint64_t offset;
+			uint64_t bits;
+			if (!readVarint(data, end, offset)) {
+				return false;
+			}
+			id += offset;
+
+			auto definition = entity.definitions.find(id);
+			if (definition == entity.definitions.end()) {
+				// the value size is unknown, the rest cannot be decoded
+				return false;
+			}
+			const Definition& probe = definition->second;
+			StatSample sample{name, timestamp, probe.name, probe.unit, probe.type, 0.0, {}};
+			if (probe.type == HISTOGRAM_TYPE) {
+				if (!decodeHistogram(data, end, sample.histogram)) {
+					return false;
+				}
+				sample.value = sample.histogram.p99;
+				samples.push_back(sample);
+				continue;
+			}
+			if (!readUint(data, end, StatEncoder::valueSize(probe.type), bits)) {
+				return false;
+			}
+
+			switch (probe.type) {
+				case INT32_TYPE:
+					sample.value = static_cast<int32_t>(static_cast<uint32_t>(bits));
+					break;
+
+				case FLOAT_TYPE: {
+					uint32_t real_bits = bits;
+					float real;
+					std::memcpy(&real, &real_bits, sizeof(real));
+					sample.value = real;
+					break;
+				}
+
+				case DOUBLE_TYPE:
+					std::memcpy(&sample.value, &bits, sizeof(sample.value));
+					break;
+
+				case HISTOGRAM_TYPE:
+					break;
+			}
+			samples.push_back(sample);
+		}
+	}
+	return true;
+}
+
+
+bool StatDecoder::decodeHistogram(const uint8_t *&data, const uint8_t *end, HistogramValue& histogram)
+{
+	uint64_t buckets;
+	if (!readVarint(data, end, histogram.count) ||
+	    !readVarint(data, end, histogram.sum) ||
+	    !readVarint(data, end, histogram.max) ||
+	    !readVarint(data, end, histogram.p50) ||
+	    !readVarint(data, end, histogram.p90) ||
+	    !readVarint(data, end, histogram.p99) ||
+	    !readVarint(data, end, buckets)) {
+		return false;
+	}
+
+	uint64_t bucket = 0;
+	for (uint64_t index = 0; index < buckets; ++index) {
+		uint64_t offset;
+		uint64_t count;
+		if (!readVarint(data, end, offset) || !readVarint(data, end, count)) {
+			return false;
+		}
+		bucket += offset;
+		histogram.buckets.emplace_back(bucket, count);
+	}
+	return true;
+}
@@ -0,0 +1,213 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file OutputStatProtocol.h
+ * @brief The binary protocol used to send the probes values to a collector
+ *        and its decoder for the collector side.
+ * @author Viveris Technologies
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "BaseProbe.h"
+
+
+/*
+ * All the fields are in network byte order, the variable length integers
+ * (varint) use 7 bits per byte, least significant group first, with the
+ * high bit set on all the bytes but the last one.
+ *
+ * Datagram header:
+ *   u32 magic, u8 version, u8 message type, u16 configuration,
+ *   u8 entity name length, entity name
+ *
+ * Definitions message, sent when the probes are configured and periodically:
+ *   repeated { varint probe id, u8 data type,
+ *              varint name length, name, varint unit length, unit }
+ *
+ * Values message:
+ *   u64 timestamp of the first batch (ms since epoch)
+ *   repeated batch { varint delay since the previous batch (ms),
+ *                    varint values count,
+ *                    repeated { varint id offset from the previous id,
+ *                               value (4 bytes for int32 and float,
+ *                                      8 bytes for double,
+ *                                      histogram for histograms) } }
+ *
+ * Histogram value:
+ *   varint count, varint sum, varint max, varint p50, varint p90, varint p99,
+ *   varint buckets count,
+ *   repeated { varint bucket index offset from the previous bucket,
+ *              varint values count }
+ * The buckets are those of HistogramProbe, they are left out (count 0)
+ * when they would take more than stat_protocol_max_histogram bytes.
+ *
+ * The probe IDs are the probe positions in the configuration identified by
+ * the configuration number, the values are only decoded with the matching
+ * definitions. On TCP each datagram is preceded by its u16 length.
+ */
+
+/// The first bytes of the binary statistics datagrams ("OSST")
+constexpr uint32_t stat_protocol_magic = 0x4F535354;
+
+/// The binary statistics protocol version
+constexpr uint8_t stat_protocol_version = 2;
+
+/// The maximum size of a datagram, below the usual Ethernet MTU
+constexpr std::size_t stat_protocol_max_datagram = 1400;
+
+/// The maximum size of the buckets of a histogram value
+constexpr std::size_t stat_protocol_max_histogram = 1024;
+
+
+/// The binary statistics messages types
+enum class StatMessageType : uint8_t
+{
+	definitions = 0,
+	values = 1,
+};
+
+
+/**
+ * @class StatEncoder
+ * @brief Helpers to build the binary statistics messages
+ */
+class StatEncoder
+{
+ public:
+	/**
+	 * @brief Start a new datagram
+	 *
+	 * @param buffer         The datagram, cleared
+	 * @param type           The message type
+	 * @param configuration  The probes configuration number
+	 * @param entityName     The name of the entity sending the probes
+	 */
+	static void writeHeader(std::string& buffer, StatMessageType type,
+	                        uint16_t configuration, const std::string& entityName);
+
+	static void writeU8(std::string& buffer, uint8_t value);
+	static void writeU16(std::string& buffer, uint16_t value);
+	static void writeU32(std::string& buffer, uint32_t value);
+	static void writeU64(std::string& buffer, uint64_t value);
+	static void writeVarint(std::string& buffer, uint64_t value);
+	static void writeString(std::string& buffer, const std::string& value);
+
+	/**
+	 * @brief Append a probe value
+	 *
+	 * @param buffer  The datagram
+	 * @param value   The probe value, not empty
+	 */
+	static void writeValue(std::string& buffer, const ProbeValue& value);
+
+	/**
+	 * @brief Get the encoded size of a probe value
+	 *
+	 * @param type  The value type, not a histogram
+	 * @return the size in bytes
+	 */
+	static std::size_t valueSize(datatype_t type);
+
+	/**
+	 * @brief Get the encoded size of a probe value
+	 *
+	 * @param value  The probe value, not empty
+	 * @return the size in bytes
+	 */
+	static std::size_t valueSize(const ProbeValue& value);
+};
+
+
+/**
+ * @brief A probe value decoded by the collector
+ */
+struct StatSample
+{
+	std::string entity;
+	uint64_t timestamp;
+	std::string name;
+	std::string unit;
+	datatype_t type;
+	/// the 99th percentile for the histograms
+	double value;
+	/// the distribution of the histograms
+	HistogramValue histogram;
+};
+
+
+/**
+ * @class StatDecoder
+ * @brief Decode the binary statistics datagrams of several entities
+ */
+class StatDecoder
+{
+ public:
+	StatDecoder();
+
+	/**
+	 * @brief Decode a datagram
+	 *
+	 * @param data     The datagram
+	 * @param length   The datagram length
+	 * @param samples  OUT: the decoded probes values are appended
+	 * @return false if the datagram is malformed or if its values cannot be
+	 *         decoded yet because their definitions were not received
+	 */
+	bool decode(const uint8_t *data, std::size_t length, std::vector<StatSample>& samples);
+
+ private:
+	/// A probe definition
+	struct Definition
+	{
+		std::string name;
+		std::string unit;
+		datatype_t type;
+	};
+
+	/// The probes definitions of an entity
+	struct Entity
+	{
+		uint16_t configuration = 0;
+		std::map<uint64_t, Definition> definitions;
+	};
+
+	bool decodeDefinitions(const uint8_t *&data, const uint8_t *end, Entity& entity);
+	bool decodeValues(const uint8_t *&data, const uint8_t *end, const std::string& name,
+	                  const Entity& entity, std::vector<StatSample>& samples);
+	bool decodeHistogram(const uint8_t *&data, const uint8_t *end, HistogramValue& histogram);
+
+	std::map<std::string, Entity> entities;
+};
@@ -0,0 +1,182 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file OutputStatShm.cpp
+ * @brief The reader of the shared memory region where the latest probes
+ *        values are published, for the local collectors.
+ * @author Viveris Technologies
+ */
+
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "OutputStatShm.h"
+
+
+/// The reads of a snapshot tried before giving up, while the writer updates it
+constexpr unsigned int stat_shm_read_attempts = 1000;
+
+
+StatShmReader::StatShmReader():
+	fd(-1),
+	region(nullptr),
+	mapped(0),
+	layout(0)
+{
+}
+
+
+StatShmReader::~StatShmReader()
+{
+	if (region != nullptr) {
+		munmap(region, mapped);
+	}
+	if (fd >= 0) {
+		close(fd);
+	}
+}
+
+
+bool StatShmReader::open(const std::string& name)
+{
+	fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(fd, &status) < 0 ||
+	    static_cast<std::size_t>(status.st_size) < sizeof(stat_shm_header) ||
+	    !remap(status.st_size)) {
+		return false;
+	}
+
+	auto header = static_cast<const stat_shm_header *>(region);
+	return header->magic == stat_shm_magic && header->version == stat_shm_version;
+}
+
+
+bool StatShmReader::read(std::vector<StatSample>& samples)
+{
+	if (region == nullptr) {
+		return false;
+	}
+
+	for (unsigned int attempt = 0; attempt < stat_shm_read_attempts; ++attempt) {
+		auto header = static_cast<const stat_shm_header *>(region);
+		uint64_t sequence = header->sequence.load(std::memory_order_acquire);
+		if (sequence & 1) {
+			continue;
+		}
+
+		uint64_t size = header->size;
+		uint32_t count = header->probe_count;
+		uint32_t tableOffset = header->table_offset;
+		uint32_t valuesOffset = header->values_offset;
+		if (size > mapped) {
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (header->sequence.load(std::memory_order_relaxed) == sequence && !remap(size)) {
+				return false;
+			}
+			continue;
+		}
+		if (tableOffset + uint64_t(count) * sizeof(stat_shm_entry) > mapped ||
+		    valuesOffset + uint64_t(count) * sizeof(stat_shm_value) > mapped) {
+			// torn read of the header, checked again below
+			count = 0;
+		}
+
+		std::string entity(header->entity, strnlen(header->entity, stat_shm_entity_size));
+		auto entries = reinterpret_cast<const stat_shm_entry *>(static_cast<const char *>(region) + tableOffset);
+		auto values = reinterpret_cast<const stat_shm_value *>(static_cast<const char *>(region) + valuesOffset);
+		samples.clear();
+		for (uint32_t index = 0; index < count; ++index) {
+			const stat_shm_value& value = values[index];
+			if (value.timestamp == 0) {
+				continue;
+			}
+			const stat_shm_entry& entry = entries[index];
+			StatSample sample;
+			sample.entity = entity;
+			sample.timestamp = value.timestamp;
+			sample.name.assign(entry.name, strnlen(entry.name, stat_shm_name_size));
+			sample.unit.assign(entry.unit, strnlen(entry.unit, stat_shm_unit_size));
+			sample.type = static_cast<datatype_t>(entry.type);
+			switch (sample.type) {
+				case INT32_TYPE:
+					sample.value = value.value.int32;
+					break;
+				case FLOAT_TYPE:
+					sample.value = value.value.real32;
+					break;
+				default:
+					sample.value = value.value.real64;
+					break;
+			}
+			samples.push_back(sample);
+		}
+		uint32_t readLayout = header->layout;
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (header->sequence.load(std::memory_order_relaxed) == sequence) {
+			layout = readLayout;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+uint32_t StatShmReader::getLayout() const
+{
+	return layout;
+}
+
+
+bool StatShmReader::remap(uint64_t size)
+{
+	if (region != nullptr) {
+		munmap(region, mapped);
+		region = nullptr;
+		mapped = 0;
+	}
+
+	void *address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (address == MAP_FAILED) {
+		return false;
+	}
+	region = address;
+	mapped = size;
+	return true;
+}
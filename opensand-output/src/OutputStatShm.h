@@ -0,0 +1,179 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2020 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file OutputStatShm.h
+ * @brief The layout of the shared memory region where the latest probes
+ *        values are published, and its reader for the local collectors.
+ * @author Viveris Technologies
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BaseProbe.h"
+#include "OutputStatProtocol.h"
+
+
+/*
+ * The region is a POSIX shared memory object, all the fields are in host
+ * byte order:
+ *   header (stat_shm_header)
+ *   probe count entries (stat_shm_entry) at the table offset
+ *   probe count values (stat_shm_value) at the values offset
+ *
+ * The value of a probe is at the same position as its entry in the table
+ * and is kept until the probe gets a new one, its timestamp is 0 until
+ * the probe gets a first value. A histogram probe publishes its 99th
+ * percentile as a double.
+ *
+ * The region is protected by a seqlock: the writer makes the sequence odd
+ * before an update and even again after it. A reader copies what it needs
+ * between two reads of the sequence and starts again if the sequence was
+ * odd or changed meanwhile, the writer never waits for the readers.
+ *
+ * The layout number changes each time the probes are configured again,
+ * the region may grow then: a reader maps the size given in the header
+ * again when it exceeds its mapping.
+ */
+
+/// The first bytes of the region ("OSSM")
+constexpr uint32_t stat_shm_magic = 0x4F53534D;
+
+/// The region layout version
+constexpr uint32_t stat_shm_version = 1;
+
+/// The room for a probe name and unit, longer ones are truncated
+constexpr std::size_t stat_shm_name_size = 120;
+constexpr std::size_t stat_shm_unit_size = 16;
+constexpr std::size_t stat_shm_entity_size = 64;
+
+
+/**
+ * @brief The region header
+ */
+struct stat_shm_header
+{
+	uint32_t magic;
+	uint32_t version;
+	/// The seqlock sequence, odd while the region is updated
+	std::atomic<uint64_t> sequence;
+	/// The region size in bytes
+	uint64_t size;
+	/// The layout number
+	uint32_t layout;
+	uint32_t probe_count;
+	uint32_t table_offset;
+	uint32_t values_offset;
+	/// The time of the last publication (ms since epoch)
+	uint64_t timestamp;
+	/// The name of the entity publishing the probes, nul-terminated
+	char entity[stat_shm_entity_size];
+};
+
+
+/**
+ * @brief The description of a probe in the table
+ */
+struct stat_shm_entry
+{
+	/// The nul-terminated probe name and unit
+	char name[stat_shm_name_size];
+	char unit[stat_shm_unit_size];
+	/// The datatype_t of the value
+	uint8_t type;
+	uint8_t reserved[7];
+};
+
+
+/**
+ * @brief The latest value of a probe
+ */
+struct stat_shm_value
+{
+	/// The time the value was published (ms since epoch), 0 if none yet
+	uint64_t timestamp;
+	union
+	{
+		int32_t int32;
+		float real32;
+		double real64;
+	} value;
+};
+
+
+/**
+ * @class StatShmReader
+ * @brief Read the probes values published in a shared memory region,
+ *        mapped once so the reads do not need any system call
+ */
+class StatShmReader
+{
+ public:
+	StatShmReader();
+	~StatShmReader();
+
+	/**
+	 * @brief Map a region
+	 *
+	 * @param name  The name of the shared memory object
+	 * @return false if the region cannot be mapped or is not a probes region
+	 */
+	bool open(const std::string& name);
+
+	/**
+	 * @brief Read a consistent snapshot of the probes that got a value
+	 *
+	 * @param samples  OUT: the probes values, the previous content is dropped
+	 * @return false if no consistent snapshot could be read, the region
+	 *         being updated on each try
+	 */
+	bool read(std::vector<StatSample>& samples);
+
+	/**
+	 * @brief Get the layout number of the last snapshot read, the probes
+	 *        keep their position in the snapshot while it does not change
+	 *
+	 * @return the layout number
+	 */
+	uint32_t getLayout() const;
+
+ private:
+	/// Map the region again if it grew, may only be called between reads
+	bool remap(uint64_t size);
+
+	int fd;
+	void *region;
+	std::size_t mapped;
+	uint32_t layout;
+};
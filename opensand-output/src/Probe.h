@@ -37,16 +37,24 @@
 #define _PROBE_H
 
 #include "BaseProbe.h"
-#include "OutputMutex.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <cassert>
+#include <limits>
 #include <sstream>
+#include <thread>
 
 
 /**
  * @class the probe respresentation
+ *
+ * The values are accumulated without lock so that the channels threads
+ * putting values never wait for each other nor for the probes sending:
+ * put works on the current accumulator while getData switches to the
+ * other one and reads the previous one once its last put is done.
  */
 template<typename T>
 class Probe : public BaseProbe
@@ -58,6 +66,7 @@ public:
 
   /**
    * @brief adds a value to the probe, to be sent when \send_probes is called.
+   *        Nothing is done if the probe is disabled.
    *
    * @param value The value to add to the probe
    **/
@@ -69,23 +78,82 @@ public:
 
   std::string getData();
 
+  ProbeValue takeValue();
+
   datatype_t getDataType() const;
 
+  void reset();
+
+  bool isEmpty() const;
+
 private:
   Probe(const std::string &name, const std::string& unit, bool enabled, sample_type_t s_type);
 
-  /// the concatenation of all values
-  T accumulator;
+  /**
+   * @brief The accumulation of the values put between two data retrievals
+   */
+  struct Accumulator
+  {
+    /// the concatenation of all values
+    std::atomic<T> value;
+    /// the number of values
+    std::atomic<uint32_t> count;
+    /// the number of put in progress on this accumulator
+    std::atomic<uint32_t> writers;
+  };
+
+  /**
+   * @brief Get the accumulator value before any value is put
+   *
+   * @return the neutral value of the sample type
+   */
+  T getNeutral() const;
+
+  /**
+   * @brief Get the value of an accumulator according to the sample type
+   *
+   * @param accumulator  The accumulator
+   * @param count        The number of values in the accumulator
+   * @return the probe value
+   */
+  T getValue(const Accumulator &accumulator, uint32_t count) const;
+
+  /**
+   * @brief Take the values of the current accumulator for the probes sending,
+   *        the following values are put in the other accumulator
+   *
+   * @param value  OUT: the probe value
+   * @return true if there was at least one value, false otherwise
+   */
+  bool swap(T &value);
+
+  /**
+   * @brief Take the values for the probes sending according to the
+   *        sampling policy
+   *
+   * @param value  OUT: the probe value
+   * @return true if the value is sent, false otherwise
+   */
+  bool sample(T &value);
+
+  /// the accumulator being filled and the one read at the previous sending
+  Accumulator accumulators[2];
 
-  /// mutex on probe (is it necessary ?)
-  OutputMutex mutex;
+  /// the index of the accumulator being filled
+  std::atomic<unsigned int> current;
 };
 
 template<typename T>
 Probe<T>::Probe(const std::string &name, const std::string& unit, bool enabled, sample_type_t s_type)
   : BaseProbe(name, unit, enabled, s_type),
-  accumulator(0)
+  current(0)
 {
+  for(auto &accumulator : this->accumulators)
+  {
+    accumulator.value = this->getNeutral();
+    accumulator.count = 0;
+    accumulator.writers = 0;
+  }
 }
 
 template<typename T>
@@ -93,60 +161,152 @@ Probe<T>::~Probe()
 {
 }
 
+template<typename T>
+T Probe<T>::getNeutral() const
+{
+  switch (this->s_type)
+  {
+    case SAMPLE_MIN:
+      return std::numeric_limits<T>::max();
+    case SAMPLE_MAX:
+      return std::numeric_limits<T>::lowest();
+    default:
+      return 0;
+  }
+}
+
 template<typename T>
 void Probe<T>::put(T value)
 {
-  OutputLock lock(mutex);
+  // a disabled probe is not sent, its value is not worth accumulating
+  if(!this->isEnabled())
+  {
+    return;
+  }
+
+  unsigned int index = this->current.load();
+  Accumulator *accumulator = &this->accumulators[index];
 
-  if(this->values_count == 0)
+  // register on the current accumulator, if they are switched meanwhile
+  // use the new one as the previous one is being read
+  accumulator->writers++;
+  while(this->current.load() != index)
   {
-    this->accumulator = value;
-  
+    accumulator->writers--;
+    index = this->current.load();
+    accumulator = &this->accumulators[index];
+    accumulator->writers++;
   }
-  else
+
+  T previous = accumulator->value.load(std::memory_order_relaxed);
+  switch (this->s_type)
   {
-    switch (this->s_type)
-    {
-      case SAMPLE_LAST:
-        this->accumulator = value;
-      break;
-      
-      case SAMPLE_MIN:
-        this->accumulator = std::min(this->accumulator, value);
-      break;
-      
-      case SAMPLE_MAX:
-        this->accumulator = std::max(this->accumulator, value);
-      break;
-      
-      case SAMPLE_AVG:
-      case SAMPLE_SUM:
-        this->accumulator += value;
-      break;
-    }
+    case SAMPLE_LAST:
+      accumulator->value.store(value, std::memory_order_relaxed);
+    break;
+    
+    case SAMPLE_MIN:
+      while(value < previous &&
+            !accumulator->value.compare_exchange_weak(previous, value,
+                                                      std::memory_order_relaxed));
+    break;
+    
+    case SAMPLE_MAX:
+      while(previous < value &&
+            !accumulator->value.compare_exchange_weak(previous, value,
+                                                      std::memory_order_relaxed));
+    break;
+    
+    case SAMPLE_AVG:
+    case SAMPLE_SUM:
+      while(!accumulator->value.compare_exchange_weak(previous, previous + value,
+                                                      std::memory_order_relaxed));
+    break;
   }
-  
-  this->values_count++;
+  accumulator->count.fetch_add(1, std::memory_order_relaxed);
+
+  // the release of the accumulator publishes the value to the reader
+  accumulator->writers--;
 }
 
 template<typename T>
-T Probe<T>::get() const
+T Probe<T>::getValue(const Accumulator &accumulator, uint32_t count) const
 {
-  T value = this->accumulator;
+  T value = accumulator.value.load();
     
   if(this->s_type == SAMPLE_AVG)
   {
-    value /= this->values_count;
+    value /= static_cast<T>(count);
     return value; 
   }
   
   return value;
 }
 
+template<typename T>
+T Probe<T>::get() const
+{
+  const Accumulator &accumulator = this->accumulators[this->current.load()];
+  uint32_t count = accumulator.count.load();
+  if(count == 0)
+  {
+    return this->getNeutral();
+  }
+  return this->getValue(accumulator, count);
+}
+
+template<typename T>
+bool Probe<T>::swap(T &value)
+{
+  unsigned int index = this->current.load();
+  Accumulator &accumulator = this->accumulators[index];
+
+  this->current.store(index ^ 1);
+  // wait for the put that started before the switch,
+  // they only last a few instructions
+  while(accumulator.writers.load() != 0)
+  {
+    std::this_thread::yield();
+  }
+
+  uint32_t count = accumulator.count.load();
+  if(count != 0)
+  {
+    value = this->getValue(accumulator, count);
+  }
+  accumulator.value.store(this->getNeutral());
+  accumulator.count.store(0);
+  return count != 0;
+}
+
+template<typename T>
+bool Probe<T>::sample(T &value)
+{
+  // a window keeps accumulating in the current accumulator until its end
+  return this->isSampledPeriod() &&
+         this->swap(value) &&
+         this->isSampledValue(static_cast<double>(value));
+}
+
+template<typename T>
+void Probe<T>::reset()
+{
+  T value;
+  // drop the values of both accumulators
+  this->swap(value);
+  this->swap(value);
+}
+
+template<typename T>
+bool Probe<T>::isEmpty() const
+{
+  return this->accumulators[this->current.load()].count.load() == 0;
+}
+
 template<typename T>
 size_t Probe<T>::getDataSize() const
 {
-  return sizeof(this->accumulator);
+  return sizeof(T);
 }
 
 template<>
@@ -161,12 +321,18 @@ datatype_t Probe<double>::getDataType() const;
 template<typename T>
 std::string Probe<T>::getData()
 {
-  OutputLock lock(mutex);
-  if (this->isEmpty()) { return ""; }
-  T value = this->get();
-  this->reset();
+  T value;
+  if(!this->sample(value)) { return ""; }
   return std::to_string(value);
 }
 
+template<typename T>
+ProbeValue Probe<T>::takeValue()
+{
+  T value;
+  if(!this->sample(value)) { return ProbeValue(*this); }
+  return ProbeValue(*this, value);
+}
+
 
 #endif
@@ -211,7 +211,7 @@ class EnvironmentPlaneBaseTester:
         self.send_cmd(0, 0, 0, 0, 0, 0, 0, 0, "i")
         self.assert_line("info\n")
         msg = self.get_message(MessageSendLog)
-        msg.assert_values('INFO', 'info', '[test_output.cpp:main():167] This is the info log message.')
+        msg.assert_values('INFO', 'info', '[test_output.cpp:main():395] This is the info log message.')
 
     def check_default_log(self):
         print("Test: default log")
@@ -295,7 +295,7 @@ class EnvironmentPlaneNormalTester(EnvironmentPlaneBaseTester):
         self.send_cmd(0, 0, 0, 0, 0, 0, 0, 0, "d")
         self.assert_line("debug\n")
         msg = self.get_message(MessageSendLog)
-        msg.assert_values('DEBUG', 'debug', '[test_output.cpp:main():161] This is a debug log message.')
+        msg.assert_values('DEBUG', 'debug', '[test_output.cpp:main():389] This is a debug log message.')
 
     def run(self):
         self.check_startup()
@@ -392,6 +392,19 @@ class EnvironmentPlaneNoDebugTester(EnvironmentPlaneBaseTester):
         self.check_quit()
 
 
+class StatCodecTester(EnvironmentPlaneBaseTester):
+    def __init__(self):
+        super().__init__("codec")
+
+    def check_codec(self):
+        print("Test: Binary statistics encoding and decoding")
+        self.assert_line("init\n")
+        self.assert_line("codec\n")
+
+    def run(self):
+        self.check_codec()
+
+
 if __name__ == '__main__':
     print("* Normal startup:")
     with EnvironmentPlaneNormalTester() as tester:
@@ -405,4 +418,8 @@ if __name__ == '__main__':
     with EnvironmentPlaneNoDebugTester() as tester:
         tester.run()
 
+    print("* Binary statistics protocol:")
+    with StatCodecTester() as tester:
+        tester.run()
+
     print("All tests passed.")
@@ -34,11 +34,16 @@
 
 
 #include "Output.h"
+#include "OutputHandler.h"
+#include "OutputStatProtocol.h"
 
 #include <iostream>
 #include <cstdio>
 #include <cstring>
 #include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
 
 #define PUT_IN_PROBE(probe, action, val) do \
 { \
@@ -50,15 +55,230 @@
   } \
 } while(0)
 
+#define CHECK(condition) do \
+{ \
+  if (!(condition)) { \
+    fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+    return false; \
+  } \
+} while(0)
+
+
+static bool decodeDatagram(StatDecoder& decoder, const std::string& datagram,
+                           std::vector<StatSample>& samples)
+{
+  return decoder.decode(reinterpret_cast<const uint8_t *>(datagram.data()),
+                        datagram.length(), samples);
+}
+
+
+static void writeDefinition(std::string& datagram, uint64_t id, datatype_t type,
+                            const std::string& name, const std::string& unit)
+{
+  StatEncoder::writeVarint(datagram, id);
+  StatEncoder::writeU8(datagram, type);
+  StatEncoder::writeString(datagram, name);
+  StatEncoder::writeString(datagram, unit);
+}
+
+
+/**
+ * @brief Encode definitions and values by hand and check that they are
+ *        decoded back, including the delta encoded timestamps and IDs
+ */
+static bool checkStatRoundTrip(const std::shared_ptr<BaseProbe>& probe,
+                               const std::shared_ptr<HistogramProbe>& histogram)
+{
+  StatDecoder decoder;
+  std::vector<StatSample> samples;
+
+  // IDs on one and two varint bytes
+  std::string definitions;
+  StatEncoder::writeHeader(definitions, StatMessageType::definitions, 7, "testing");
+  writeDefinition(definitions, 0, INT32_TYPE, "int32", "µF");
+  writeDefinition(definitions, 3, FLOAT_TYPE, "float", "");
+  writeDefinition(definitions, 300, DOUBLE_TYPE, "double", "m²");
+  writeDefinition(definitions, 301, HISTOGRAM_TYPE, "histogram", "us");
+  CHECK(decodeDatagram(decoder, definitions, samples));
+  CHECK(samples.empty());
+
+  for (uint64_t value : {1ull, 120ull, 130ull, 5000ull, 70000ull, 1ull << 39}) {
+    histogram->put(value);
+  }
+  ProbeValue distribution = histogram->takeValue();
+  const HistogramValue& expected = distribution.getHistogram();
+  CHECK(expected.count == 6 && !expected.buckets.empty());
+
+  const uint64_t timestamp = 1600000000123ull;
+  std::string values;
+  StatEncoder::writeHeader(values, StatMessageType::values, 7, "testing");
+  StatEncoder::writeU64(values, timestamp);
+  StatEncoder::writeVarint(values, 0);
+  StatEncoder::writeVarint(values, 4);
+  StatEncoder::writeVarint(values, 0);
+  StatEncoder::writeValue(values, ProbeValue(*probe, int32_t(-42)));
+  StatEncoder::writeVarint(values, 3);
+  StatEncoder::writeValue(values, ProbeValue(*probe, 3.25f));
+  StatEncoder::writeVarint(values, 297);
+  StatEncoder::writeValue(values, ProbeValue(*probe, 2.718281828459045));
+  StatEncoder::writeVarint(values, 1);
+  StatEncoder::writeValue(values, distribution);
+  // a later batch with a single value, the IDs restart from 0
+  StatEncoder::writeVarint(values, 70000);
+  StatEncoder::writeVarint(values, 1);
+  StatEncoder::writeVarint(values, 0);
+  StatEncoder::writeValue(values, ProbeValue(*probe, int32_t(INT32_MIN)));
+  CHECK(decodeDatagram(decoder, values, samples));
+
+  CHECK(samples.size() == 5);
+  CHECK(samples[0].entity == "testing" && samples[0].timestamp == timestamp);
+  CHECK(samples[0].name == "int32" && samples[0].unit == "µF");
+  CHECK(samples[0].type == INT32_TYPE && samples[0].value == -42);
+  CHECK(samples[1].name == "float" && samples[1].value == 3.25);
+  CHECK(samples[2].name == "double" && samples[2].unit == "m²");
+  CHECK(samples[2].value == 2.718281828459045);
+  CHECK(samples[3].type == HISTOGRAM_TYPE && samples[3].timestamp == timestamp);
+  CHECK(samples[3].histogram.count == expected.count);
+  CHECK(samples[3].histogram.sum == expected.sum);
+  CHECK(samples[3].histogram.max == expected.max);
+  CHECK(samples[3].histogram.p50 == expected.p50);
+  CHECK(samples[3].histogram.p90 == expected.p90);
+  CHECK(samples[3].histogram.buckets == expected.buckets);
+  CHECK(samples[3].value == expected.p99);
+  CHECK(samples[4].name == "int32" && samples[4].timestamp == timestamp + 70000);
+  CHECK(samples[4].value == INT32_MIN);
+
+  // the encoded sizes match the written ones
+  std::string value;
+  StatEncoder::writeValue(value, distribution);
+  CHECK(value.size() == StatEncoder::valueSize(distribution));
+
+  // malformed and truncated datagrams are rejected
+  samples.clear();
+  std::string corrupted = values;
+  corrupted[0] ^= 0xFF;
+  CHECK(!decodeDatagram(decoder, corrupted, samples));
+  CHECK(!decodeDatagram(decoder, values.substr(0, values.size() - 1), samples));
+  for (std::size_t length = 0; length < values.size(); ++length) {
+    decodeDatagram(decoder, values.substr(0, length), samples);
+  }
+
+  // the values of another configuration wait for its definitions
+  samples.clear();
+  std::string reconfigured;
+  StatEncoder::writeHeader(reconfigured, StatMessageType::values, 8, "testing");
+  StatEncoder::writeU64(reconfigured, timestamp);
+  CHECK(!decodeDatagram(decoder, reconfigured, samples));
+  definitions.clear();
+  StatEncoder::writeHeader(definitions, StatMessageType::definitions, 8, "testing");
+  writeDefinition(definitions, 0, DOUBLE_TYPE, "renamed", "");
+  CHECK(decodeDatagram(decoder, definitions, samples));
+  StatEncoder::writeVarint(reconfigured, 0);
+  StatEncoder::writeVarint(reconfigured, 1);
+  StatEncoder::writeVarint(reconfigured, 0);
+  StatEncoder::writeValue(reconfigured, ProbeValue(*probe, 1.5));
+  CHECK(decodeDatagram(decoder, reconfigured, samples));
+  CHECK(samples.size() == 1 && samples[0].name == "renamed" && samples[0].value == 1.5);
+
+  // the IDs of the previous configuration are forgotten
+  samples.clear();
+  CHECK(!decodeDatagram(decoder, values, samples));
+
+  return true;
+}
+
+
+/**
+ * @brief Send probes with the binary SocketStatHandler and decode
+ *        the datagrams received on a local collector socket
+ */
+static bool checkStatHandler(const std::vector<std::shared_ptr<BaseProbe>>& probes)
+{
+  int collector = socket(AF_INET, SOCK_DGRAM, 0);
+  CHECK(collector >= 0);
+
+  struct sockaddr_in address;
+  socklen_t length = sizeof(address);
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bool bound = bind(collector, (struct sockaddr *)&address, sizeof(address)) == 0 &&
+               getsockname(collector, (struct sockaddr *)&address, &length) == 0;
+  if (!bound) {
+    close(collector);
+  }
+  CHECK(bound);
+
+  {
+    SocketStatHandler handler("testing", "127.0.0.1", ntohs(address.sin_port), false, true);
+    handler.configure(probes);
+
+    // the previous values are still pending when the next ones are emitted
+    handler.emitStats({ProbeValue(*probes[0], int32_t(12)), ProbeValue(*probes[1]),
+                       ProbeValue(*probes[2], 0.5)});
+    handler.emitStats({ProbeValue(*probes[0]), ProbeValue(*probes[1], -1.0f),
+                       ProbeValue(*probes[2], 1e300)});
+    // the handler flushes its pending values on destruction
+  }
+
+  StatDecoder decoder;
+  std::vector<StatSample> samples;
+  std::size_t datagrams = 0;
+  char buffer[stat_protocol_max_datagram];
+  ssize_t received;
+  while ((received = recv(collector, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+    datagrams++;
+    if (!decoder.decode(reinterpret_cast<const uint8_t *>(buffer), received, samples)) {
+      close(collector);
+      CHECK(!"the handler datagram is decoded");
+    }
+  }
+  close(collector);
+
+  // one definitions datagram and the two batches in one values datagram
+  CHECK(datagrams == 2);
+  CHECK(samples.size() == 4);
+  CHECK(samples[0].name == probes[0]->getName() && samples[0].value == 12);
+  CHECK(samples[1].name == probes[2]->getName() && samples[1].value == 0.5);
+  CHECK(samples[2].name == probes[1]->getName() && samples[2].value == -1.0);
+  CHECK(samples[3].name == probes[2]->getName() && samples[3].value == 1e300);
+  CHECK(samples[3].unit == probes[2]->getUnit());
+  CHECK(samples[0].timestamp <= samples[2].timestamp);
+
+  return true;
+}
+
+
+static int testStatCodec(std::shared_ptr<Output> output)
+{
+  std::vector<std::shared_ptr<BaseProbe>> probes = {
+    output->registerProbe<int32_t>("testing.codec_int32", "µF", true, SAMPLE_LAST),
+    output->registerProbe<float>("testing.codec_float", true, SAMPLE_LAST),
+    output->registerProbe<double>("testing.codec_double", "m²", true, SAMPLE_LAST),
+  };
+  auto histogram = output->registerHistogram("testing.codec_histogram", "us", true);
+
+  if (!checkStatRoundTrip(probes[0], histogram) || !checkStatHandler(probes)) {
+    puts("codec_error");
+    fflush(stdout);
+    return 1;
+  }
+
+  puts("codec");
+  fflush(stdout);
+  return 0;
+}
+
 
 int main(int argc, char* argv[])
 {
   bool output_enabled = true;
+  bool codec = false;
   log_level_t min_level = LEVEL_DEBUG;
 
   if(argc < 2)
   {
-    fprintf(stderr, "Usage: %s <socket path> [disable|nodebug]\n", argv[0]);
+    fprintf(stderr, "Usage: %s <socket path> [disable|nodebug|codec]\n", argv[0]);
     exit(1);
   }
 
@@ -72,6 +292,10 @@ int main(int argc, char* argv[])
     {
       min_level = LEVEL_INFO;
     }
+    if(strcmp(argv[2], "codec") == 0)
+    {
+      codec = true;
+    }
   }
 
   puts("init");
@@ -86,6 +310,10 @@ int main(int argc, char* argv[])
   }
 
   output->setEntityName("testing");
+  if (codec)
+  {
+    return testStatCodec(output);
+  }
   if (output_enabled)
   {
     output->configureRemoteOutput(argv[1], 58008, 58008);
@@ -36,6 +36,7 @@
 
 #include "Gse.h"
 #include "GseEncapCtx.h"
+#include "GseReassembly.h"
 #include <NetPacket.h>
 #include <NetBurst.h>
 #include <OpenSandModelConf.h>
@@ -51,6 +52,12 @@ constexpr std::size_t MAX_CNI_EXT_LEN = 6;
 constexpr std::size_t GSE_MANDATORY_FIELDS_LENGTH = 2;
 constexpr std::size_t GSE_FRAG_ID_LENGTH = 1;
 constexpr std::size_t GSE_TOTAL_LENGTH_LENGTH = 2;
+// the GSE packets built from a PDU keep room for a CNI extension,
+// even the first fragment of a jumbo frame
+constexpr std::size_t GSE_MAX_ENCAP_PACKET_LENGTH = GSE_MAX_PACKET_LENGTH - MAX_CNI_EXT_LEN;
+// the defaults of the reassembly parameters missing from older profiles
+constexpr int DEFAULT_REASSEMBLY_MEMORY_KB = 16384;
+constexpr int DEFAULT_REASSEMBLY_TIMEOUT_MS = 500;
 
 
 static int encodeHeaderCniExtensions(unsigned char *ext,
@@ -122,6 +129,7 @@ Gse::Gse():
 {
 	this->upper.push_back("ROHC");
 	this->upper.push_back("Ethernet");
+	this->upper.push_back("PHS");
 }
 
 
@@ -131,7 +139,7 @@ Gse::~Gse()
 
 
 Gse::Context::Context(EncapPlugin &plugin):
-	EncapPlugin::EncapContext(plugin), contexts()
+	EncapPlugin::EncapContext(plugin), contexts(), encap_plugin(plugin)
 {
 	this->vfrag_pkt = nullptr;
 	this->vfrag_gse = nullptr;
@@ -148,6 +156,13 @@ void Gse::generateConfiguration(const std::string &, const std::string &, const
 	auto gse = conf->addComponent("gse", "GSE", "The GSE Plugin Configuration");
 	gse->setAdvanced(true);
 	gse->addParameter("packing_threshold", "Packing Threshold", types->getType("int"));
+	auto memory = gse->addParameter("reassembly_memory", "Reassembly Memory", types->getType("int"),
+	                                "Memory shared by the fragmented PDUs under reassembly, "
+	                                "the least recently updated ones are evicted beyond");
+	memory->setUnit("kB");
+	auto timeout = gse->addParameter("reassembly_timeout", "Reassembly Timeout", types->getType("int"),
+	                                 "Time a fragmented PDU waits for its next fragment before being dropped");
+	timeout->setUnit("ms");
 }
 
 
@@ -173,6 +188,29 @@ bool Gse::Context::init(void)
 	LOG(this->log, LEVEL_NOTICE,
 	    "packing threshold: %lu\n", this->packing_threshold);
 
+	int reassembly_memory;
+	int reassembly_timeout;
+	if(!OpenSandModelConf::extractParameterData(gse->getParameter("reassembly_memory"), reassembly_memory))
+	{
+		reassembly_memory = DEFAULT_REASSEMBLY_MEMORY_KB;
+	}
+	if(!OpenSandModelConf::extractParameterData(gse->getParameter("reassembly_timeout"), reassembly_timeout))
+	{
+		reassembly_timeout = DEFAULT_REASSEMBLY_TIMEOUT_MS;
+	}
+	if(reassembly_memory <= 0 || reassembly_timeout <= 0)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "Section GSE, the reassembly memory and timeout shall be positive\n");
+		goto error;
+	}
+	this->reassembly.reset(new GseReassembly(std::size_t(reassembly_memory) * 1024,
+	                                         std::chrono::milliseconds(reassembly_timeout),
+	                                         this->log));
+	LOG(this->log, LEVEL_NOTICE,
+	    "reassembly memory: %d kB, timeout: %d ms\n",
+	    reassembly_memory, reassembly_timeout);
+
 	// Initialize encapsulation and deencapsulation contexts
 	// Since we use a "custom" frag_id based on QoS value and the source tal_id,
 	// set the qos_nbr in GSE library to its max value.
@@ -230,7 +268,6 @@ error:
 Gse::Context::~Context()
 {
 	gse_status_t status;
-	std::map<GseIdentifier *, GseEncapCtx *, ltGseIdentifier>::iterator it;
 
 	// free the vfrags and buffer if created
 	if(this->vfrag_pkt != NULL)
@@ -287,10 +324,10 @@ Gse::Context::~Context()
 		}
 	}
 
-	for(it = this->contexts.begin(); it != this->contexts.end(); it++)
+	for(auto &&context: this->contexts)
 	{
-		if((*it).second != NULL)
-			delete (*it).second;
+		if(context.second != NULL)
+			delete context.second;
 	}
 }
 
@@ -383,10 +420,8 @@ NetBurst *Gse::Context::encapsulate(NetBurst *burst,
 bool Gse::Context::encapFixedLength(NetPacket *packet, NetBurst *gse_packets,
                                     long &time)
 {
-	std::map<GseIdentifier *, GseEncapCtx *, ltGseIdentifier >::iterator context_it;
 	GseEncapCtx *context = NULL;
 	gse_status_t status;
-	GseIdentifier *identifier;
 	// keep the destination spot
 	uint16_t dest_spot = packet->getSpot();
 
@@ -398,19 +433,18 @@ bool Gse::Context::encapFixedLength(NetPacket *packet, NetBurst *gse_packets,
 		return false;
 	}
 
-	identifier = new GseIdentifier(packet->getSrcTalId(),
-	                               packet->getDstTalId(),
-	                               packet->getQos());
+	GseIdentifier identifier(packet->getSrcTalId(),
+	                         packet->getDstTalId(),
+	                         packet->getQos());
 	LOG(this->log, LEVEL_INFO,
 	    "check if encapsulation context exists\n");
-	context_it = this->contexts.find(identifier);
+	auto context_it = this->contexts.find(identifier.getKey());
 	if(context_it == this->contexts.end())
 	{
 		LOG(this->log, LEVEL_INFO,
 		    "encapsulation context does not exist yet\n");
-		context = new GseEncapCtx(identifier, dest_spot);
-		this->contexts.insert(std::pair<GseIdentifier *, GseEncapCtx *>
-		                      (identifier, context));
+		context = new GseEncapCtx(&identifier, dest_spot);
+		this->contexts.emplace(identifier.getKey(), context);
 		LOG(this->log, LEVEL_INFO,
 		    "new encapsulation context created, "
 		    "Src TAL Id = %u, Dst TAL Id = %u, QoS = %u\n",
@@ -423,7 +457,6 @@ bool Gse::Context::encapFixedLength(NetPacket *packet, NetBurst *gse_packets,
 		LOG(this->log, LEVEL_INFO,
 		    "find an encapsulation context containing %zu "
 		    "bytes of data\n", context->length());
-		delete identifier;
 	}
 
 	// set the destination spot ID
@@ -508,10 +541,19 @@ bool Gse::Context::encapFixedLength(NetPacket *packet, NetBurst *gse_packets,
 bool Gse::Context::encapVariableLength(NetPacket *packet, NetBurst *gse_packets)
 {
 	gse_status_t status;
+	if(packet->getTotalLength() > GSE_MAX_PDU_LENGTH)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "%zu-byte packet longer than the GSE PDUs, drop packet\n",
+		    packet->getTotalLength());
+		return false;
+	}
 	if(this->vfrag_pkt == NULL)
 	{
+		// the PDU is fragmented in GSE packets, its buffer holds
+		// the longest one and not only a GSE packet
 		status = gse_allocate_vfrag(&this->vfrag_pkt, 1);
-		this->buf = new uint8_t[GSE_MAX_PACKET_LENGTH +
+		this->buf = new uint8_t[GSE_MAX_PDU_LENGTH +
 		                        GSE_MAX_HEADER_LENGTH +
 		                        GSE_MAX_TRAILER_LENGTH];
 		if(status != GSE_STATUS_OK)
@@ -563,11 +605,7 @@ bool Gse::Context::encapPacket(NetPacket *packet,
 	uint8_t frag_id;
 	// keep the destination spot
 	uint16_t dest_spot = packet->getSpot();
-	// keep the QoS
-	uint8_t qos = packet->getQos();
-	
-	// keep the source/destination tal_id
-	uint8_t src_tal_id = packet->getSrcTalId();
+	// keep the destination tal_id
 	uint8_t dst_tal_id = packet->getDstTalId();
 
 	// Common part for all packet types
@@ -618,7 +656,7 @@ bool Gse::Context::encapPacket(NetPacket *packet,
 	{
 		counter++;
 		status = gse_encap_get_packet_no_alloc(&this->vfrag_gse,
-		                                       this->encap, GSE_MAX_PACKET_LENGTH,
+		                                       this->encap, GSE_MAX_ENCAP_PACKET_LENGTH,
 		                                       frag_id);
 		if(status != GSE_STATUS_OK && status != GSE_STATUS_FIFO_EMPTY)
 		{
@@ -630,17 +668,10 @@ bool Gse::Context::encapPacket(NetPacket *packet,
 
 		if(status == GSE_STATUS_OK)
 		{
-      std::unique_ptr<NetPacket> gse;
-			Data gse_packet(gse_get_vfrag_start(this->vfrag_gse),
-			                gse_get_vfrag_length(this->vfrag_gse));
-      try
-      {
-        // create a GSE packet from fragments computed by the GSE library
-        gse = this->createPacket(gse_packet,
-                                 gse_get_vfrag_length(this->vfrag_gse),
-                                 qos, src_tal_id, dst_tal_id);
-      }
-			catch (const std::bad_alloc&)
+			// create a GSE packet from fragments computed by the GSE library
+			std::unique_ptr<NetPacket> gse = this->createGsePacket(this->vfrag_gse,
+			                                                       dst_tal_id);
+			if(gse == nullptr)
 			{
 				LOG(this->log, LEVEL_ERROR,
 				    "cannot create GSE packet, drop the network "
@@ -751,6 +782,13 @@ NetBurst *Gse::Context::deencapsulate(NetBurst *burst)
 			continue;
 		}
 
+		// the fragments are reassembled here, in a bounded memory
+		if(GseReassembly::isFragment(packet->getRawData(), packet->getTotalLength()))
+		{
+			this->deencapFragment(*packet, net_packets);
+			continue;
+		}
+
 		// Create a virtual fragment containing the GSE packet
 		// TODO : this function could be optimized (preallocating vfrag_gse), but
 		// gse_deencap_packet call below frees vfrag struct (need to change that
@@ -815,24 +853,15 @@ bool Gse::Context::deencapPacket(gse_vfrag_t *vfrag_gse,
 			break;
 
 		case GSE_STATUS_PDU_RECEIVED:
+		{
 			LOG(this->log, LEVEL_INFO,
 			    "received a packet with type 0x%.4x\n", protocol);
-			if(this->current_upper->getFixedLength() > 0)
-			{
-				LOG(this->log, LEVEL_INFO,
-				    "Inner packet has a fixed length (%zu)\n",
-				    this->current_upper->getFixedLength());
-				return this->deencapFixedLength(vfrag_pdu ,dest_spot,
-				                                label, net_packets);
-			}
-			else
-			{
-				LOG(this->log, LEVEL_INFO,
-				    "Inner packet has a variable length\n");
-				return this->deencapVariableLength(vfrag_pdu, dest_spot,
-				                                   label, net_packets);
-			}
-			break;
+			bool success = this->deencapPdu(gse_get_vfrag_start(vfrag_pdu),
+			                                gse_get_vfrag_length(vfrag_pdu),
+			                                dest_spot, label, net_packets);
+			gse_free_vfrag(&vfrag_pdu);
+			return success;
+		}
 
 		case GSE_STATUS_CTX_NOT_INIT:
 			LOG(this->log, LEVEL_INFO,
@@ -859,57 +888,95 @@ bool Gse::Context::deencapPacket(gse_vfrag_t *vfrag_gse,
 }
 
 
-bool Gse::Context::deencapFixedLength(gse_vfrag_t *vfrag_pdu,
+bool Gse::Context::deencapFragment(const NetPacket &packet,
+                                   NetBurst *net_packets)
+{
+	GseReassembly::Pdu pdu;
+
+	switch(this->reassembly->add(packet.getSpot(),
+	                             packet.getRawData(),
+	                             packet.getTotalLength(),
+	                             pdu))
+	{
+		case GseReassembly::Status::incomplete:
+			LOG(this->log, LEVEL_INFO,
+			    "GSE fragment reassembled, PDU is not complete "
+			    "(%zu bytes under reassembly)\n",
+			    this->reassembly->getUsedMemory());
+			return true;
+
+		case GseReassembly::Status::complete:
+			LOG(this->log, LEVEL_INFO,
+			    "received a fragmented packet with type 0x%.4x\n",
+			    pdu.protocol);
+			return this->deencapPdu(pdu.data.data() + pdu.offset,
+			                        pdu.data.length() - pdu.offset,
+			                        packet.getSpot(), pdu.label, net_packets);
+
+		case GseReassembly::Status::dropped:
+		default:
+			return false;
+	}
+}
+
+
+bool Gse::Context::deencapPdu(const unsigned char *pdu,
+                              std::size_t pdu_length,
+                              uint16_t dest_spot,
+                              uint8_t label[6],
+                              NetBurst *net_packets)
+{
+	if(this->current_upper->getFixedLength() > 0)
+	{
+		LOG(this->log, LEVEL_INFO,
+		    "Inner packet has a fixed length (%zu)\n",
+		    this->current_upper->getFixedLength());
+		return this->deencapFixedLength(pdu, pdu_length, dest_spot,
+		                                label, net_packets);
+	}
+	LOG(this->log, LEVEL_INFO,
+	    "Inner packet has a variable length\n");
+	return this->deencapVariableLength(pdu, pdu_length, dest_spot,
+	                                   label, net_packets);
+}
+
+
+bool Gse::Context::deencapFixedLength(const unsigned char *pdu,
+                                      std::size_t pdu_length,
                                       uint16_t dest_spot,
                                       uint8_t label[6],
                                       NetBurst *net_packets)
 {
-	gse_status_t status;
 	uint8_t src_tal_id, dst_tal_id;
 	uint8_t qos;
 	unsigned int pkt_nbr = 0;
+	std::size_t fixed_length = this->current_upper->getFixedLength();
 
 	src_tal_id = Gse::getSrcTalIdFromLabel(label);
 	dst_tal_id = Gse::getDstTalIdFromLabel(label);
 	qos = Gse::getQosFromLabel(label);
 
-	if(gse_get_vfrag_length(vfrag_pdu) %
-	   this->current_upper->getFixedLength() != 0)
+	if(pdu_length % fixed_length != 0)
 	{
 		LOG(this->log, LEVEL_ERROR,
 		    "Number of packets in GSE payload is not an integer,"
 		    " drop packets\n");
-		gse_free_vfrag(&vfrag_pdu);
 		return false;
 	}
-	while(gse_get_vfrag_length(vfrag_pdu) > 0)
-	{
-    std::unique_ptr<NetPacket> packet;
-		Data pdu_frag(gse_get_vfrag_start(vfrag_pdu),
-		              this->current_upper->getFixedLength());
-    try
-    {
-      packet = this->current_upper->build(pdu_frag,
-                                          this->current_upper->getFixedLength(),
-                                          qos, src_tal_id, dst_tal_id);
-    }
+	for(std::size_t offset = 0; offset < pdu_length; offset += fixed_length)
+	{
+		std::unique_ptr<NetPacket> packet;
+		Data pdu_frag(pdu + offset, fixed_length);
+		try
+		{
+			packet = this->current_upper->build(pdu_frag, fixed_length,
+			                                    qos, src_tal_id, dst_tal_id);
+		}
 		catch (const std::bad_alloc&)
 		{
 			LOG(this->log, LEVEL_ERROR,
 			    "cannot build a %s packet, drop the GSE packet\n",
 			    this->current_upper->getName().c_str());
-			gse_free_vfrag(&vfrag_pdu);
-			// move the data pointer after the current packet
-			status = gse_shift_vfrag(vfrag_pdu,
-			                         this->current_upper->getFixedLength(), 0);
-			if(status != GSE_STATUS_OK)
-			{
-				LOG(this->log, LEVEL_ERROR,
-				    "cannot shift virtual fragment (%s), drop the "
-				    "GSE packet\n", gse_get_status(status));
-				gse_free_vfrag(&vfrag_pdu);
-				return false;
-			}
 			continue;
 		}
 
@@ -918,32 +985,18 @@ bool Gse::Context::deencapFixedLength(gse_vfrag_t *vfrag_pdu,
 		// add network packet to burst
 		net_packets->add(std::move(packet));
 		pkt_nbr++;
-
-		// move the data pointer after the current packet
-		status = gse_shift_vfrag(vfrag_pdu,
-		                         this->current_upper->getFixedLength(), 0);
-		if(status != GSE_STATUS_OK)
-		{
-			LOG(this->log, LEVEL_ERROR,
-			    "cannot shift virtual fragment (%s), drop the "
-			    "GSE packet\n", gse_get_status(status));
-			gse_free_vfrag(&vfrag_pdu);
-			return false;
-		}
-		pkt_nbr++;
 	}
 
 	LOG(this->log, LEVEL_INFO,
 	    "Complete PDU received, got %u GSE packet(s)/frame "
 	    "(GSE packet length = %zu, Src TAL id = %u, Dst TAL id = %u, qos = %u)\n",
-	    pkt_nbr, gse_get_vfrag_length(vfrag_pdu), src_tal_id, dst_tal_id, qos);
-
-	gse_free_vfrag(&vfrag_pdu);
+	    pkt_nbr, pdu_length, src_tal_id, dst_tal_id, qos);
 
 	return true;
 }
 
-bool Gse::Context::deencapVariableLength(gse_vfrag_t *vfrag_pdu,
+bool Gse::Context::deencapVariableLength(const unsigned char *pdu,
+                                         std::size_t pdu_length,
                                          uint16_t dest_spot,
                                          uint8_t label[6],
                                          NetBurst *net_packets)
@@ -951,8 +1004,7 @@ bool Gse::Context::deencapVariableLength(gse_vfrag_t *vfrag_pdu,
 	uint8_t src_tal_id, dst_tal_id;
 	uint8_t qos;
 	unsigned int pkt_nbr = 0;
-	Data pdu_frag(gse_get_vfrag_start(vfrag_pdu),
-	              gse_get_vfrag_length(vfrag_pdu));
+	Data pdu_frag(pdu, pdu_length);
 
 	src_tal_id = Gse::getSrcTalIdFromLabel(label);
 	dst_tal_id = Gse::getDstTalIdFromLabel(label);
@@ -961,8 +1013,7 @@ bool Gse::Context::deencapVariableLength(gse_vfrag_t *vfrag_pdu,
   std::unique_ptr<NetPacket> packet;
   try
   {
-    packet = this->current_upper->build(pdu_frag,
-                                        gse_get_vfrag_length(vfrag_pdu),
+    packet = this->current_upper->build(pdu_frag, pdu_length,
                                         qos, src_tal_id, dst_tal_id);
   }
 	catch (const std::bad_alloc&)
@@ -970,7 +1021,6 @@ bool Gse::Context::deencapVariableLength(gse_vfrag_t *vfrag_pdu,
 		LOG(this->log, LEVEL_ERROR, 
 		    "cannot build a %s packet, drop the GSE packet\n",
 		    this->current_upper->getName().c_str());
-		gse_free_vfrag(&vfrag_pdu);
 		return false;
 	}
 
@@ -982,13 +1032,11 @@ bool Gse::Context::deencapVariableLength(gse_vfrag_t *vfrag_pdu,
 	    "Complete PDU received, got %u %zu-byte %s packet(s)/frame "
 	    "(GSE packet length = %zu, Src TAL id = %u, Dst TAL id = %u, qos = %u)\n",
 	    pkt_nbr, packet->getTotalLength(), packet->getName().c_str(),
-	    gse_get_vfrag_length(vfrag_pdu), src_tal_id, dst_tal_id, qos);
+	    pdu_length, src_tal_id, dst_tal_id, qos);
 
 	// add network packet to burst
 	net_packets->add(std::move(packet));
 
-	gse_free_vfrag(&vfrag_pdu);
-
 	return true;
 }
 
@@ -997,8 +1045,8 @@ NetBurst *Gse::Context::flush(int context_id)
 	gse_status_t status;
 	NetBurst *gse_packets;
 	GseEncapCtx *context;
-	GseIdentifier *identifier;
-	std::map<GseIdentifier *, GseEncapCtx *, ltGseIdentifier >::iterator context_it;
+	uint32_t key;
+	std::unordered_map<uint32_t, GseEncapCtx *>::iterator context_it;
 	uint8_t label[6];
 	std::string packet_name;
 	uint16_t protocol;
@@ -1021,19 +1069,18 @@ NetBurst *Gse::Context::flush(int context_id)
 	LOG(this->log, LEVEL_INFO,
 	    "search for encapsulation context (id = %d) to flush...\n",
 	    context_id);
-	identifier = new GseIdentifier((context_id >> 8) & 0x1f,
-	                               (context_id >> 3) & 0x1f,
-	                               context_id & 0x07);
+	key = GseIdentifier::getKey((context_id >> 8) & 0x1f,
+	                            (context_id >> 3) & 0x1f,
+	                            context_id & 0x07);
 	LOG(this->log, LEVEL_INFO,
 	    "Associated identifier: Src TAL Id = %u, Dst TAL Id = %u, QoS = %u\n",
-	    identifier->getSrcTalId(), identifier->getDstTalId(),
-	    identifier->getQos());
-	context_it = this->contexts.find(identifier);
+	    (context_id >> 8) & 0x1f, (context_id >> 3) & 0x1f,
+	    context_id & 0x07);
+	context_it = this->contexts.find(key);
 	if(context_it == this->contexts.end())
 	{
 		LOG(this->log, LEVEL_ERROR,
 		    "encapsulation context does not exist\n");
-		delete identifier;
 		goto erase_burst;
 	}
 	else
@@ -1042,7 +1089,6 @@ NetBurst *Gse::Context::flush(int context_id)
 		LOG(this->log, LEVEL_INFO,
 		    "find an encapsulation context containing %zu "
 		    "bytes of data\n", context->length());
-		delete identifier;
 	}
 
 	// Duplicate context virtual fragment before giving it to GSE library
@@ -1132,7 +1178,7 @@ NetBurst *Gse::Context::flush(int context_id)
 	{
 		counter++;
 		status = gse_encap_get_packet_no_alloc(&this->vfrag_gse, this->encap,
-		                                       GSE_MAX_PACKET_LENGTH, frag_id);
+		                                       GSE_MAX_ENCAP_PACKET_LENGTH, frag_id);
 		if(status != GSE_STATUS_OK && status != GSE_STATUS_FIFO_EMPTY)
 		{
 			LOG(this->log, LEVEL_ERROR,
@@ -1144,17 +1190,10 @@ NetBurst *Gse::Context::flush(int context_id)
 
 		if(status == GSE_STATUS_OK)
 		{
-      std::unique_ptr<NetPacket> gse;
-			Data gse_frag(gse_get_vfrag_start(this->vfrag_gse),
-			              gse_get_vfrag_length(this->vfrag_gse));
-      try
-      {
-        // create a GSE packet from fragments computed by the GSE library
-          gse = this->createPacket(gse_frag,
-                                   gse_get_vfrag_length(this->vfrag_gse),
-                                   qos, src_tal_id, dst_tal_id);
-      }
-			catch (const std::bad_alloc&)
+			// create a GSE packet from fragments computed by the GSE library
+			std::unique_ptr<NetPacket> gse = this->createGsePacket(this->vfrag_gse,
+			                                                       dst_tal_id);
+			if(gse == nullptr)
 			{
 				LOG(this->log, LEVEL_ERROR,
 				    "cannot create GSE packet, drop the network packet\n");
@@ -1209,11 +1248,43 @@ NetBurst *Gse::Context::flushAll()
 	return NULL;
 }
 
+/**
+ *  @brief create a GSE packet straight from the fragment built by
+ *         the GSE library, copying it once in the packet
+ *
+ *  @param vfrag_gse   The GSE fragment
+ *  @param dst_tal_id  The destination terminal ID
+ *  @return the packet on success, nullptr otherwise
+ */
+std::unique_ptr<NetPacket> Gse::Context::createGsePacket(gse_vfrag_t *vfrag_gse,
+                                                         uint8_t dst_tal_id)
+{
+	auto handler = static_cast<Gse::PacketHandler *>(this->encap_plugin.getPacketHandler());
+	try
+	{
+		return handler->build(gse_get_vfrag_start(vfrag_gse),
+		                      gse_get_vfrag_length(vfrag_gse),
+		                      dst_tal_id);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return nullptr;
+	}
+}
+
 std::unique_ptr<NetPacket> Gse::PacketHandler::build(const Data &data,
                                                      size_t data_length,
                                                      uint8_t UNUSED(_qos),
                                                      uint8_t UNUSED(_src_tal_id),
                                                      uint8_t _dst_tal_id) const
+{
+	return this->build(data.c_str(), data_length, _dst_tal_id);
+}
+
+
+std::unique_ptr<NetPacket> Gse::PacketHandler::build(const unsigned char *data,
+                                                     size_t data_length,
+                                                     uint8_t _dst_tal_id) const
 {
 	gse_status_t status;
 	uint8_t label[6];
@@ -1226,7 +1297,7 @@ std::unique_ptr<NetPacket> Gse::PacketHandler::build(const Data &data,
 	uint8_t dst_tal_id = BROADCAST_TAL_ID;
 	uint8_t frag_id;
 	uint16_t header_length = 0;
-	unsigned char *packet = (unsigned char *)data.c_str();
+	unsigned char *packet = (unsigned char *)data;
 
 	status = gse_get_start_indicator(packet, &s);
 	if(status != GSE_STATUS_OK)
@@ -1392,11 +1463,8 @@ bool Gse::PacketHandler::getChunk(std::unique_ptr<NetPacket> packet,
 	else if(status == GSE_STATUS_OK)
 	{
 		// the packet has been fragmented in order to be encapsulated partially
-		// (use case 2)
-		Data gse_first(gse_get_vfrag_start(first_frag),
-		               gse_get_vfrag_length(first_frag));
-		Data gse_second(gse_get_vfrag_start(second_frag),
-		                gse_get_vfrag_length(second_frag));
+		// (use case 2), the fragments are built straight from the
+		// virtual fragments
 
 		LOG(this->log, LEVEL_INFO,
 		    "packet has been refragmented, first fragment is "
@@ -1405,10 +1473,8 @@ bool Gse::PacketHandler::getChunk(std::unique_ptr<NetPacket> packet,
 		// add the first fragment to the BB frame
 		try
 		{
-			data = this->build(gse_first,
+			data = this->build(gse_get_vfrag_start(first_frag),
 			                   gse_get_vfrag_length(first_frag),
-			                   packet->getQos(),
-			                   packet->getSrcTalId(),
 			                   packet->getDstTalId());
 		}
 		catch (const std::bad_alloc&)
@@ -1421,10 +1487,8 @@ bool Gse::PacketHandler::getChunk(std::unique_ptr<NetPacket> packet,
 		// create a new NetPacket containing the second fragment
 		try
 		{
-			remaining_data = this->build(gse_second,
+			remaining_data = this->build(gse_get_vfrag_start(second_frag),
 			                             gse_get_vfrag_length(second_frag),
-			                             packet->getQos(),
-			                             packet->getSrcTalId(),
 			                             packet->getDstTalId());
 		}
 		catch (const std::bad_alloc&)
@@ -1466,15 +1530,137 @@ error:
 }
 
 
+bool Gse::PacketHandler::encapNextPacketInto(std::unique_ptr<NetPacket> packet,
+                                             std::size_t remaining_length,
+                                             bool,
+                                             Data &frame,
+                                             std::unique_ptr<NetPacket> &remaining_data)
+{
+	gse_vfrag_t *first_frag = nullptr;
+	gse_vfrag_t *second_frag = nullptr;
+	gse_status_t status;
+	uint8_t frag_id;
+	bool success = true;
+
+	remaining_data.reset();
+
+	// the whole packet fits, it is written as is in the frame
+	if(packet->getTotalLength() <= MIN(remaining_length, GSE_MAX_PACKET_LENGTH))
+	{
+		frame.append(packet->getRawData(), packet->getTotalLength());
+		return true;
+	}
+
+	frag_id = Gse::getFragId(packet.get());
+	status = gse_create_vfrag_with_data(&first_frag,
+	                                    packet->getTotalLength(),
+	                                    GSE_MAX_REFRAG_HEAD_OFFSET, 0,
+	                                    packet->getRawData(),
+	                                    packet->getTotalLength());
+	if(status != GSE_STATUS_OK)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "Failed to create a virtual fragment for the GSE packet "
+		    "refragmentation (%s)\n", gse_get_status(status));
+		return false;
+	}
+
+	status = gse_refrag_packet(first_frag, &second_frag, 0, 0,
+	                           frag_id,
+	                           MIN(remaining_length, GSE_MAX_PACKET_LENGTH));
+	if(status == GSE_STATUS_LENGTH_TOO_SMALL)
+	{
+		// not enough space for a GSE fragment, keep the whole packet
+		LOG(this->log, LEVEL_INFO,
+		    "Unable to refragment GSE packet (%s)\n",
+		    gse_get_status(status));
+		remaining_data = std::move(packet);
+	}
+	else if(status == GSE_STATUS_REFRAG_UNNECESSARY)
+	{
+		frame.append(packet->getRawData(), packet->getTotalLength());
+	}
+	else if(status == GSE_STATUS_OK)
+	{
+		LOG(this->log, LEVEL_INFO,
+		    "packet has been refragmented, first fragment is "
+		    "%zu bytes long, second fragment is %zu bytes long\n",
+		    gse_get_vfrag_length(first_frag), gse_get_vfrag_length(second_frag));
+		// the first fragment is written in the frame, only the second
+		// one is kept as a packet for the next frame
+		frame.append(gse_get_vfrag_start(first_frag),
+		             gse_get_vfrag_length(first_frag));
+		try
+		{
+			remaining_data = this->build(gse_get_vfrag_start(second_frag),
+			                             gse_get_vfrag_length(second_frag),
+			                             packet->getDstTalId());
+		}
+		catch (const std::bad_alloc&)
+		{
+			remaining_data.reset();
+		}
+		if(!remaining_data)
+		{
+			LOG(this->log, LEVEL_ERROR,
+			    "failed to create the second fragment\n");
+			success = false;
+		}
+	}
+	else
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "Failed to refragment GSE packet (%s)\n",
+		    gse_get_status(status));
+		success = false;
+	}
+
+	if(second_frag != nullptr)
+	{
+		gse_free_vfrag(&second_frag);
+	}
+	gse_free_vfrag(&first_frag);
+	return success;
+}
+
+
+std::size_t Gse::PacketHandler::getMaxPduLength() const
+{
+	return GSE_MAX_PDU_LENGTH;
+}
+
+
 Gse::PacketHandler::PacketHandler(EncapPlugin &plugin):
 	EncapPlugin::EncapPacketHandler(plugin)
 {
-	this->encap_callback["encodeCniExt"] = encodeHeaderCniExtensions;
-	this->deencap_callback["deencodeCniExt"] = deencodeHeaderCniExtensions;
+	this->encap_callback[static_cast<std::size_t>(HeaderExtension::cni)] = encodeHeaderCniExtensions;
+	this->deencap_callback[static_cast<std::size_t>(HeaderExtension::cni)] = deencodeHeaderCniExtensions;
 	this->callback_name.push_back("encodeCniExt");
 	this->callback_name.push_back("deencodeCniExt");
 }
 
+bool Gse::PacketHandler::getEncapExtension(const std::string &callback,
+                                           HeaderExtension &extension)
+{
+	if(callback == "encodeCniExt")
+	{
+		extension = HeaderExtension::cni;
+		return true;
+	}
+	return false;
+}
+
+bool Gse::PacketHandler::getDeencapExtension(const std::string &callback,
+                                             HeaderExtension &extension)
+{
+	if(callback == "deencodeCniExt")
+	{
+		extension = HeaderExtension::cni;
+		return true;
+	}
+	return false;
+}
+
 bool Gse::PacketHandler::getSrc(const Data &data, tal_id_t &tal_id) const
 {
 	gse_status_t status;
@@ -1589,6 +1775,73 @@ bool Gse::PacketHandler::getQos(const Data &data, qos_t &qos) const
 }
 
 
+bool Gse::PacketHandler::getDst(const unsigned char *data, tal_id_t &tal_id) const
+{
+	gse_status_t status;
+	uint8_t s;
+	uint8_t label[6];
+
+	unsigned char *packet = const_cast<unsigned char *>(data);
+
+	status = gse_get_start_indicator(packet, &s);
+	if(status != GSE_STATUS_OK || s == 0)
+	{
+		// the subsequent fragments have no label
+		return false;
+	}
+
+	status = gse_get_label(packet, label);
+	if(status != GSE_STATUS_OK)
+	{
+		return false;
+	}
+	tal_id = Gse::getDstTalIdFromLabel(label);
+	return true;
+}
+
+
+bool Gse::PacketHandler::isForOtherTerminal(const unsigned char *data, tal_id_t tal_id)
+{
+	uint8_t s;
+	uint8_t e;
+	uint8_t frag_id;
+
+	unsigned char *packet = const_cast<unsigned char *>(data);
+
+	if(gse_get_start_indicator(packet, &s) != GSE_STATUS_OK ||
+	   gse_get_end_indicator(packet, &e) != GSE_STATUS_OK)
+	{
+		return false;
+	}
+
+	// complete packet
+	if(s != 0 && e != 0)
+	{
+		return EncapPacketHandler::isForOtherTerminal(data, tal_id);
+	}
+
+	if(gse_get_frag_id(packet, &frag_id) != GSE_STATUS_OK)
+	{
+		return false;
+	}
+
+	// the first fragment carries the label, remember it for the next ones
+	if(s != 0)
+	{
+		bool skip = EncapPacketHandler::isForOtherTerminal(data, tal_id);
+		this->skipped_fragments[frag_id] = skip;
+		return skip;
+	}
+
+	bool skip = this->skipped_fragments[frag_id];
+	if(e != 0)
+	{
+		this->skipped_fragments[frag_id] = false;
+	}
+	return skip;
+}
+
+
 bool Gse::PacketHandler::checkPacketForHeaderExtensions(std::unique_ptr<NetPacket> &packet)
 {
 	// Search for a non-fragmented GSE packet, since extension cannot be
@@ -1650,6 +1903,15 @@ bool Gse::PacketHandler::setHeaderExtensions(std::unique_ptr<NetPacket> packet,
 	gse_vfrag_t *vfrag;
 	gse_vfrag_t *vfrag2;
 	uint32_t crc;
+	HeaderExtension extension;
+
+	if(!getEncapExtension(callback_name, extension))
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "unknown header extension callback %s\n",
+		    callback_name.c_str());
+		return false;
+	}
 
 	// Empty GSE packet
 	// TODO macro for sizes
@@ -1688,7 +1950,7 @@ bool Gse::PacketHandler::setHeaderExtensions(std::unique_ptr<NetPacket> packet,
 	// TODO: once packet refragmentation will be handled, set QoS to actual
 	// value (see NOTE #2).
 	status = gse_encap_add_header_ext(vfrag, &vfrag2, &crc,
-	                                  this->encap_callback[callback_name],
+	                                  this->encap_callback[static_cast<std::size_t>(extension)],
 	                                  GSE_MAX_PACKET_LENGTH, 0, 0,
 	                                  /* qos */ 0,
 	                                  opaque);
@@ -1752,24 +2014,30 @@ bool Gse::PacketHandler::getHeaderExtensions(const std::unique_ptr<NetPacket>& p
                                              std::string callback_name,
                                              void *opaque)
 {
-	gse_vfrag_t *gse_data;
 	gse_status_t status;
+	HeaderExtension extension;
 
-	status = gse_create_vfrag_with_data(&gse_data,
-	                                    packet->getTotalLength(),
-	                                    0, 0,
-	                                    packet->getRawData(),
-	                                    packet->getTotalLength());
-	if(status != GSE_STATUS_OK)
+	if(!getDeencapExtension(callback_name, extension))
 	{
-		LOG(this->log, LEVEL_ERROR, "cannot create virtual fragment (%s)",
-		    gse_get_status(status));
+		LOG(this->log, LEVEL_ERROR,
+		    "unknown header extension callback %s\n",
+		    callback_name.c_str());
 		return false;
 	}
-	
+
+	// the CNI is read in the header, libgse is only
+	// used for the packets the fast path does not handle
+	if(extension == HeaderExtension::cni &&
+	   this->readCniExtension(packet->getRawData(),
+	                          packet->getTotalLength(),
+	                          opaque))
+	{
+		return true;
+	}
+
 	// Get the in-band extension
 	status = gse_deencap_get_header_ext(packet->getRawData(),
-	                                    this->deencap_callback[callback_name],
+	                                    this->deencap_callback[static_cast<std::size_t>(extension)],
 	                                    opaque);
 	if(status != GSE_STATUS_OK && status != GSE_STATUS_EXTENSION_UNAVAILABLE)
 	{
@@ -1783,6 +2051,60 @@ bool Gse::PacketHandler::getHeaderExtensions(const std::unique_ptr<NetPacket>& p
 }
 
 
+bool Gse::PacketHandler::readCniExtension(const unsigned char *data,
+                                          std::size_t length,
+                                          void *opaque) const
+{
+	std::size_t offset = GSE_MANDATORY_FIELDS_LENGTH;
+	uint16_t protocol_type;
+	uint8_t ext_length;
+
+	if(length < GSE_MANDATORY_FIELDS_LENGTH)
+	{
+		return false;
+	}
+	bool start = data[0] & 0x80;
+	bool end = data[0] & 0x40;
+	uint8_t label_type = (data[0] >> 4) & 0x03;
+	if(!start)
+	{
+		// the subsequent fragments have no protocol type
+		return false;
+	}
+	if(!end)
+	{
+		offset += GSE_FRAG_ID_LENGTH + GSE_TOTAL_LENGTH_LENGTH;
+	}
+	if(length < offset + sizeof(uint16_t))
+	{
+		return false;
+	}
+	protocol_type = (data[offset] << 8) | data[offset + 1];
+	offset += sizeof(uint16_t);
+	if(protocol_type >= GSE_MIN_ETHER_TYPE)
+	{
+		// no extension
+		return true;
+	}
+
+	// the extensions follow the label: 6 bytes, 3 bytes, or none
+	// for a broadcast label and a label reuse
+	offset += label_type == 0 ? 6 : (label_type == 1 ? 3 : 0);
+
+	// an optional extension of H-LEN words including the next
+	// protocol type, the others are left to libgse
+	ext_length = 2 * ((protocol_type >> 8) & 0x07);
+	if((protocol_type & 0xFF) != to_underlying(NET_PROTO::GSE_EXTENSION_CNI) ||
+	   ext_length < sizeof(uint32_t) + sizeof(uint16_t) ||
+	   length < offset + ext_length)
+	{
+		return false;
+	}
+	memcpy(opaque, data + offset, sizeof(uint32_t));
+	return true;
+}
+
+
 // Static methods
 
 bool Gse::setLabel(NetPacket *packet, uint8_t label[])
@@ -41,8 +41,11 @@
 
 #include <EncapPlugin.h>
 
+#include <array>
+#include <bitset>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 extern "C"
@@ -58,6 +61,7 @@ extern "C"
 
 
 class GseEncapCtx;
+class GseReassembly;
 class NetPacket;
 class NetBurst;
 
@@ -89,12 +93,17 @@ class Gse: public EncapPlugin
 		/// Buffer used by the vfrags
 		uint8_t *buf;
 		/// Temporary buffers for encapsulation contexts. Contexts are identified
-		/// by an unique identifier
-		std::map<GseIdentifier *, GseEncapCtx *, ltGseIdentifier> contexts;
+		/// by the key of their unique identifier (see GseIdentifier::getKey)
+		std::unordered_map<uint32_t, GseEncapCtx *> contexts;
 		/// The packing threshold for encapsulation. Packing Threshold is the time
 		/// the context can wait for additional SNDU packets to fill the incomplete
 		/// GSE packet before sending the GSE packet with padding.
 		unsigned long packing_threshold;
+		/// The plugin, to build the GSE packets with its packet handler
+		EncapPlugin &encap_plugin;
+		/// The reassembly of the fragmented PDUs, libgse only
+		/// deencapsulates the complete GSE packets
+		std::unique_ptr<GseReassembly> reassembly;
 
 	 public:
 		/// constructor
@@ -118,14 +127,32 @@ class Gse: public EncapPlugin
 		bool deencapPacket(gse_vfrag_t *vfrag_gse,
 		                   uint16_t dest_spot,
 		                   NetBurst *net_packets);
-		bool deencapFixedLength(gse_vfrag_t *vfrag_pdu,
+		/**
+		 * @brief Reassemble a fragment and deencapsulate its PDU once complete
+		 *
+		 * @param packet       The GSE fragment
+		 * @param net_packets  The burst of the deencapsulated packets
+		 * @return true on success, false if the fragment was dropped
+		 */
+		bool deencapFragment(const NetPacket &packet,
+		                     NetBurst *net_packets);
+		bool deencapPdu(const unsigned char *pdu,
+		                std::size_t pdu_length,
+		                uint16_t dest_spot,
+		                uint8_t label[6],
+		                NetBurst *net_packets);
+		bool deencapFixedLength(const unsigned char *pdu,
+		                        std::size_t pdu_length,
 		                        uint16_t dest_spot,
 		                        uint8_t label[6],
 		                        NetBurst *net_packets);
-		bool deencapVariableLength(gse_vfrag_t *vfrag_pdu,
+		bool deencapVariableLength(const unsigned char *pdu,
+		                           std::size_t pdu_length,
 		                           uint16_t dest_spot,
 		                           uint8_t label[6],
 		                           NetBurst *net_packets);
+		std::unique_ptr<NetPacket> createGsePacket(gse_vfrag_t *vfrag_gse,
+		                                           uint8_t dst_tal_id);
 	};
 
 	/**
@@ -135,8 +162,56 @@ class Gse: public EncapPlugin
 	class PacketHandler: public EncapPacketHandler
 	{
 	 private:
-		std::map<std::string, gse_encap_build_header_ext_cb_t> encap_callback;
-		std::map<std::string, gse_deencap_read_header_ext_cb_t> deencap_callback;
+		/// The header extensions known by the handler
+		enum class HeaderExtension: uint8_t
+		{
+			cni,
+			count,
+		};
+
+		/// The callbacks building and reading the header extensions
+		std::array<gse_encap_build_header_ext_cb_t,
+		           static_cast<std::size_t>(HeaderExtension::count)> encap_callback;
+		std::array<gse_deencap_read_header_ext_cb_t,
+		           static_cast<std::size_t>(HeaderExtension::count)> deencap_callback;
+
+		/// The fragment IDs of the PDUs whose first fragment was
+		/// for another terminal, their next fragments are skipped too
+		std::bitset<256> skipped_fragments;
+
+		/**
+		 * @brief Get the header extension built by an encapsulation callback
+		 *
+		 * @param callback   The callback name
+		 * @param extension  OUT: The header extension
+		 * @return true if the callback is known, false otherwise
+		 */
+		static bool getEncapExtension(const std::string &callback,
+		                              HeaderExtension &extension);
+
+		/**
+		 * @brief Get the header extension read by a deencapsulation callback
+		 *
+		 * @param callback   The callback name
+		 * @param extension  OUT: The header extension
+		 * @return true if the callback is known, false otherwise
+		 */
+		static bool getDeencapExtension(const std::string &callback,
+		                                HeaderExtension &extension);
+
+		/**
+		 * @brief Read the CNI of the first header extension of a
+		 *        GSE packet directly in its header
+		 *
+		 * @param data    The GSE packet
+		 * @param length  The GSE packet length
+		 * @param opaque  OUT: The CNI in network byte order, if present
+		 * @return true if the packet was handled, false if it shall
+		 *         be read by libgse
+		 */
+		bool readCniExtension(const unsigned char *data,
+		                      std::size_t length,
+		                      void *opaque) const;
 
 	 public:
 		PacketHandler(EncapPlugin &plugin);
@@ -146,11 +221,29 @@ class Gse: public EncapPlugin
 		                                 uint8_t qos,
 		                                 uint8_t src_tal_id,
 		                                 uint8_t dst_tal_id) const override;
+
+		/**
+		 * @brief Build a GSE packet from a raw buffer, without
+		 *        an intermediate copy in a Data
+		 *
+		 * @param data         The GSE packet
+		 * @param data_length  The GSE packet length
+		 * @param dst_tal_id   The destination terminal ID of the
+		 *                     subsequent fragments, which have no label
+		 * @return the packet on success, nullptr otherwise
+		 */
+		std::unique_ptr<NetPacket> build(const unsigned char *data,
+		                                 std::size_t data_length,
+		                                 uint8_t dst_tal_id) const;
+
 		size_t getFixedLength() const {return 0;};
 		size_t getMinLength() const {return 3;};
 		size_t getLength(const unsigned char *data) const;
 		bool getSrc(const Data &data, tal_id_t &tal_id) const;
 		bool getQos(const Data &data, qos_t &qos) const;
+		bool getDst(const unsigned char *data, tal_id_t &tal_id) const override;
+		bool isForOtherTerminal(const unsigned char *data, tal_id_t tal_id) override;
+		std::size_t getMaxPduLength() const override;
 
 		bool checkPacketForHeaderExtensions(std::unique_ptr<NetPacket> &packet) override;
 		bool setHeaderExtensions(std::unique_ptr<NetPacket> packet,
@@ -164,6 +257,12 @@ class Gse: public EncapPlugin
 		                         std::string callback,
 		                         void *opaque) override;
 
+		bool encapNextPacketInto(std::unique_ptr<NetPacket> packet,
+		                         std::size_t remaining_length,
+		                         bool new_burst,
+		                         Data &frame,
+		                         std::unique_ptr<NetPacket> &remaining_data) override;
+
 	 protected:
 		bool getChunk(std::unique_ptr<NetPacket> packet,
                   std::size_t remaining_length,
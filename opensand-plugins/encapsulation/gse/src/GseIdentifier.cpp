@@ -69,18 +69,15 @@ uint8_t GseIdentifier::getQos() const
 }
 
 
-bool ltGseIdentifier::operator() (GseIdentifier *ai1, GseIdentifier *ai2) const
+uint32_t GseIdentifier::getKey() const
 {
-	const auto srcTalId1 = ai1->getSrcTalId();
-	const auto srcTalId2 = ai2->getSrcTalId();
-
-	if (srcTalId1 == srcTalId2)
-	{
-		const auto dstTalId1 = ai1->getDstTalId();
-		const auto dstTalId2 = ai2->getDstTalId();
+	return GseIdentifier::getKey(this->src_tal_id, this->dst_tal_id, this->qos);
+}
 
-		return dstTalId1 == dstTalId2 ? ai1->getQos() < ai2->getQos() : dstTalId1 < dstTalId2;
-	}
 
-	return srcTalId1 < srcTalId2;
+uint32_t GseIdentifier::getKey(uint8_t src_tal_id, uint8_t dst_tal_id, uint8_t qos)
+{
+	return (static_cast<uint32_t>(src_tal_id) << 16) |
+	       (static_cast<uint32_t>(dst_tal_id) << 8) |
+	       qos;
 }
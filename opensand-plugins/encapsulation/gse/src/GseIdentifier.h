@@ -89,24 +89,24 @@ class GseIdentifier
 	 * @return the QoS
 	 */
 	uint8_t getQos() const;
-};
 
+	/**
+	 * Get the identifier packed in an integer, used as key of
+	 * the encapsulation contexts table
+	 *
+	 * @return the key
+	 */
+	uint32_t getKey() const;
 
-/**
- * @brief Operator to compare two GSE identifiers
- */
-struct ltGseIdentifier
-{
 	/**
-	 * Operator to test if one GSE identifier is lesser than another
-	 * GSE identifier
+	 * Get the key of the identifier of the given values
 	 *
-	 * @param ai1 the first GSE identifier
-	 * @param ai2 the second GSE identifier
-	 * @return true if first GSE identifier is lesser than the second,
-	 *         false otherwise
+	 * @param src_tal_id the source Tal Id
+	 * @param dst_tal_id the destination Tal Id
+	 * @param qos        the Qos
+	 * @return the key
 	 */
-	bool operator() (GseIdentifier * ai1, GseIdentifier * ai2) const;
+	static uint32_t getKey(uint8_t src_tal_id, uint8_t dst_tal_id, uint8_t qos);
 };
 
 
@@ -0,0 +1,402 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file GseReassembly.cpp
+ * @brief Bounded-memory reassembly of the fragmented GSE PDUs
+ * @author Viveris Technologies
+ */
+
+#include "GseReassembly.h"
+
+#include <opensand_output/Output.h>
+
+#include <algorithm>
+#include <iterator>
+
+
+constexpr uint16_t GSE_MIN_ETHER_TYPE = 1536;
+constexpr std::size_t GSE_MANDATORY_FIELDS_LENGTH = 2;
+constexpr std::size_t GSE_FRAG_ID_LENGTH = 1;
+constexpr std::size_t GSE_TOTAL_LENGTH_LENGTH = 2;
+constexpr std::size_t GSE_PROTOCOL_TYPE_LENGTH = 2;
+constexpr std::size_t GSE_CRC_LENGTH = 4;
+constexpr uint32_t GSE_CRC_INIT = 0xFFFFFFFF;
+
+
+/**
+ * @brief Update the CRC-32 of a GSE PDU (polynomial 0x04C11DB7,
+ *        most significant bit first, no final xor)
+ *
+ * @param crc     The CRC of the previous data
+ * @param data    The data
+ * @param length  The data length
+ * @return the CRC of the previous data and the data
+ */
+static uint32_t updateCrc(uint32_t crc, const unsigned char *data, std::size_t length)
+{
+	static const std::array<uint32_t, 256> table = []()
+	{
+		std::array<uint32_t, 256> values;
+		for(uint32_t byte = 0; byte < values.size(); ++byte)
+		{
+			uint32_t value = byte << 24;
+			for(unsigned int bit = 0; bit < 8; ++bit)
+			{
+				value = (value & 0x80000000) ? (value << 1) ^ 0x04C11DB7 : value << 1;
+			}
+			values[byte] = value;
+		}
+		return values;
+	}();
+
+	for(std::size_t index = 0; index < length; ++index)
+	{
+		crc = (crc << 8) ^ table[((crc >> 24) ^ data[index]) & 0xFF];
+	}
+	return crc;
+}
+
+
+/**
+ * @brief Get the label length of a first fragment
+ *
+ * @param label_type  The label type
+ * @return the label length, -1 for a label reuse which
+ *         cannot start a fragmented PDU
+ */
+static int getLabelLength(uint8_t label_type)
+{
+	switch(label_type)
+	{
+		case 0:
+			return 6;
+		case 1:
+			return 3;
+		case 2:
+			// broadcast
+			return 0;
+		default:
+			return -1;
+	}
+}
+
+
+GseReassembly::Slot::Slot():
+	active{false},
+	source{0},
+	frag_id{0},
+	label_type{0},
+	total_length{0},
+	crc{GSE_CRC_INIT},
+	buffer{},
+	updated{},
+	prev{nullptr},
+	next{nullptr}
+{
+}
+
+
+GseReassembly::GseReassembly(std::size_t max_memory,
+                             std::chrono::milliseconds timeout,
+                             std::shared_ptr<OutputLog> log):
+	sources{},
+	head{nullptr},
+	tail{nullptr},
+	max_memory{max_memory},
+	used_memory{0},
+	timeout{timeout},
+	log{log}
+{
+	// the engines of all the contexts share the probes
+	static std::shared_ptr<Probe<int>> timeouts =
+		Output::Get()->registerProbe<int>("Encap.GSE.Reassembly_timeouts", "PDUs", true, SAMPLE_SUM);
+	static std::shared_ptr<Probe<int>> evictions =
+		Output::Get()->registerProbe<int>("Encap.GSE.Reassembly_evictions", "PDUs", true, SAMPLE_SUM);
+	this->probe_timeouts = timeouts;
+	this->probe_evictions = evictions;
+}
+
+
+GseReassembly::~GseReassembly()
+{
+}
+
+
+bool GseReassembly::isFragment(const unsigned char *data, std::size_t length)
+{
+	if(length < GSE_MANDATORY_FIELDS_LENGTH)
+	{
+		return false;
+	}
+	bool start = data[0] & 0x80;
+	bool end = data[0] & 0x40;
+	// padding has its four first bits cleared
+	return !(start && end) && (data[0] & 0xF0) != 0;
+}
+
+
+GseReassembly::Status GseReassembly::add(uint16_t source,
+                                         const unsigned char *data,
+                                         std::size_t length,
+                                         Pdu &pdu)
+{
+	auto now = std::chrono::steady_clock::now();
+	this->expire(now);
+
+	std::size_t gse_length = ((data[0] & 0x0F) << 8) | data[1];
+	bool start = data[0] & 0x80;
+	bool end = data[0] & 0x40;
+	if(length < GSE_MANDATORY_FIELDS_LENGTH + gse_length ||
+	   gse_length < GSE_FRAG_ID_LENGTH + (start ? GSE_TOTAL_LENGTH_LENGTH : 0) + (end ? GSE_CRC_LENGTH : 0))
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "truncated GSE fragment (%zu bytes, GSE length = %zu), drop it\n",
+		    length, gse_length);
+		return Status::dropped;
+	}
+	uint8_t frag_id = data[GSE_MANDATORY_FIELDS_LENGTH];
+	const unsigned char *fragment = data + GSE_MANDATORY_FIELDS_LENGTH + GSE_FRAG_ID_LENGTH;
+	std::size_t fragment_length = gse_length - GSE_FRAG_ID_LENGTH - (end ? GSE_CRC_LENGTH : 0);
+
+	Slots &slots = this->sources[source];
+	Slot &slot = slots[frag_id];
+
+	if(start)
+	{
+		if(slot.active)
+		{
+			LOG(this->log, LEVEL_NOTICE,
+			    "first fragment for the incomplete PDU %u of source %u, "
+			    "the previous one is erased\n", frag_id, source);
+			this->release(slot);
+		}
+
+		uint16_t total_length = (fragment[0] << 8) | fragment[1];
+		fragment += GSE_TOTAL_LENGTH_LENGTH;
+		fragment_length -= GSE_TOTAL_LENGTH_LENGTH;
+		int label_length = getLabelLength((data[0] >> 4) & 0x03);
+		if(label_length < 0 ||
+		   total_length < GSE_PROTOCOL_TYPE_LENGTH + label_length ||
+		   fragment_length > total_length)
+		{
+			LOG(this->log, LEVEL_ERROR,
+			    "invalid first fragment of the PDU %u of source %u "
+			    "(total length = %u), drop it\n", frag_id, source, total_length);
+			return Status::dropped;
+		}
+		if(!this->reserve(total_length))
+		{
+			LOG(this->log, LEVEL_ERROR,
+			    "the %u-byte PDU %u of source %u exceeds the reassembly "
+			    "memory, drop it\n", total_length, frag_id, source);
+			return Status::dropped;
+		}
+
+		slot.active = true;
+		slot.source = source;
+		slot.frag_id = frag_id;
+		slot.label_type = (data[0] >> 4) & 0x03;
+		slot.total_length = total_length;
+		slot.crc = updateCrc(GSE_CRC_INIT, data + GSE_MANDATORY_FIELDS_LENGTH + GSE_FRAG_ID_LENGTH,
+		                     GSE_TOTAL_LENGTH_LENGTH);
+		slot.buffer.reserve(total_length);
+		this->used_memory += total_length;
+	}
+	else if(!slot.active)
+	{
+		// the first fragment was lost, evicted or for another context
+		LOG(this->log, LEVEL_INFO,
+		    "fragment of the unknown PDU %u of source %u, drop it\n",
+		    frag_id, source);
+		return Status::dropped;
+	}
+	else if(slot.buffer.length() + fragment_length > slot.total_length)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "the fragments of the PDU %u of source %u exceed its "
+		    "total length (%u), drop it\n", frag_id, source, slot.total_length);
+		this->release(slot);
+		return Status::dropped;
+	}
+
+	slot.buffer.append(fragment, fragment_length);
+	slot.crc = updateCrc(slot.crc, fragment, fragment_length);
+	this->touch(slot, now);
+	if(!end)
+	{
+		return Status::incomplete;
+	}
+
+	const unsigned char *trailer = fragment + fragment_length;
+	uint32_t crc = (uint32_t(trailer[0]) << 24) | (trailer[1] << 16) | (trailer[2] << 8) | trailer[3];
+	if(slot.buffer.length() != slot.total_length || crc != slot.crc)
+	{
+		LOG(this->log, LEVEL_ERROR,
+		    "the PDU %u of source %u is corrupted (%zu/%u bytes, "
+		    "CRC 0x%08x/0x%08x), drop it\n", frag_id, source,
+		    slot.buffer.length(), slot.total_length, crc, slot.crc);
+		this->release(slot);
+		return Status::dropped;
+	}
+
+	bool valid = this->readHeaders(slot, pdu);
+	if(valid)
+	{
+		pdu.data.swap(slot.buffer);
+	}
+	this->release(slot);
+	return valid ? Status::complete : Status::dropped;
+}
+
+
+std::size_t GseReassembly::getUsedMemory() const
+{
+	return this->used_memory;
+}
+
+
+void GseReassembly::expire(std::chrono::steady_clock::time_point now)
+{
+	int expired = 0;
+	while(this->tail != nullptr && now - this->tail->updated > this->timeout)
+	{
+		LOG(this->log, LEVEL_NOTICE,
+		    "the PDU %u of source %u timed out after %zu/%u bytes\n",
+		    this->tail->frag_id, this->tail->source,
+		    this->tail->buffer.length(), this->tail->total_length);
+		this->release(*this->tail);
+		++expired;
+	}
+	if(expired > 0 && this->probe_timeouts != nullptr)
+	{
+		this->probe_timeouts->put(expired);
+	}
+}
+
+
+bool GseReassembly::reserve(std::size_t length)
+{
+	if(length > this->max_memory)
+	{
+		return false;
+	}
+
+	int evicted = 0;
+	while(this->used_memory + length > this->max_memory && this->tail != nullptr)
+	{
+		LOG(this->log, LEVEL_NOTICE,
+		    "evict the PDU %u of source %u after %zu/%u bytes\n",
+		    this->tail->frag_id, this->tail->source,
+		    this->tail->buffer.length(), this->tail->total_length);
+		this->release(*this->tail);
+		++evicted;
+	}
+	if(evicted > 0 && this->probe_evictions != nullptr)
+	{
+		this->probe_evictions->put(evicted);
+	}
+	return true;
+}
+
+
+void GseReassembly::release(Slot &slot)
+{
+	if(!slot.active)
+	{
+		return;
+	}
+
+	(slot.prev != nullptr ? slot.prev->next : this->head) = slot.next;
+	(slot.next != nullptr ? slot.next->prev : this->tail) = slot.prev;
+	slot.prev = nullptr;
+	slot.next = nullptr;
+
+	this->used_memory -= slot.total_length;
+	slot.active = false;
+	// give the block back to the pool
+	Data().swap(slot.buffer);
+}
+
+
+void GseReassembly::touch(Slot &slot, std::chrono::steady_clock::time_point now)
+{
+	slot.updated = now;
+	if(this->head == &slot)
+	{
+		return;
+	}
+
+	// unlink the slot if it is already in the list
+	if(slot.prev != nullptr)
+	{
+		slot.prev->next = slot.next;
+		(slot.next != nullptr ? slot.next->prev : this->tail) = slot.prev;
+	}
+
+	slot.prev = nullptr;
+	slot.next = this->head;
+	(this->head != nullptr ? this->head->prev : this->tail) = &slot;
+	this->head = &slot;
+}
+
+
+bool GseReassembly::readHeaders(Slot &slot, Pdu &pdu) const
+{
+	const unsigned char *data = slot.buffer.data();
+	std::size_t length = slot.buffer.length();
+	std::size_t label_length = getLabelLength(slot.label_type);
+
+	pdu.label_type = slot.label_type;
+	std::fill(std::begin(pdu.label), std::end(pdu.label), 0);
+	std::copy(data + GSE_PROTOCOL_TYPE_LENGTH,
+	          data + GSE_PROTOCOL_TYPE_LENGTH + label_length,
+	          pdu.label);
+
+	uint16_t protocol = (data[0] << 8) | data[1];
+	std::size_t offset = GSE_PROTOCOL_TYPE_LENGTH + label_length;
+	while(protocol < GSE_MIN_ETHER_TYPE)
+	{
+		// an optional extension of H-LEN words ending with the next
+		// protocol type, the mandatory ones are not supported
+		std::size_t ext_length = 2 * ((protocol >> 8) & 0x07);
+		if(ext_length == 0 || offset + ext_length > length)
+		{
+			LOG(this->log, LEVEL_ERROR,
+			    "invalid header extension 0x%04x in the PDU %u of "
+			    "source %u, drop it\n", protocol, slot.frag_id, slot.source);
+			return false;
+		}
+		offset += ext_length;
+		protocol = (data[offset - 2] << 8) | data[offset - 1];
+	}
+
+	pdu.protocol = protocol;
+	pdu.offset = offset;
+	return true;
+}
@@ -0,0 +1,226 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file GseReassembly.h
+ * @brief Bounded-memory reassembly of the fragmented GSE PDUs
+ * @author Viveris Technologies
+ */
+
+#ifndef GSE_REASSEMBLY_H
+#define GSE_REASSEMBLY_H
+
+
+#include <Data.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+
+class OutputLog;
+template<typename> class Probe;
+
+
+/**
+ * @class GseReassembly
+ * @brief Reassembly of the fragmented GSE PDUs in a bounded memory
+ *
+ * Each source (the spot of the packets) owns a fixed array of slots,
+ * one per fragment ID. The first fragment of a PDU reserves a pooled
+ * buffer of the announced total length, the next ones are appended
+ * to it and the last one checks the CRC. The buffers of all the
+ * sources share a memory cap: when a new PDU does not fit in it,
+ * the least recently updated PDUs are evicted. The PDUs that are
+ * not updated within the timeout are dropped.
+ */
+class GseReassembly
+{
+ public:
+	/// The outcome of a fragment
+	enum class Status
+	{
+		incomplete,
+		complete,
+		dropped,
+	};
+
+	/// A reassembled PDU
+	struct Pdu
+	{
+		/// The label type of the first fragment
+		uint8_t label_type;
+		/// The label of the first fragment, zeroed if shorter
+		uint8_t label[6];
+		/// The protocol type following the extensions
+		uint16_t protocol;
+		/// The reassembled data, from the protocol type of the first fragment
+		Data data;
+		/// The offset of the PDU in the data, after the label and extensions
+		std::size_t offset;
+	};
+
+	/**
+	 * @brief Build a reassembly engine
+	 *
+	 * @param max_memory  The memory cap of the buffers under reassembly (bytes)
+	 * @param timeout     The time a PDU may wait for its next fragment
+	 * @param log         The log of the encapsulation context
+	 */
+	GseReassembly(std::size_t max_memory,
+	              std::chrono::milliseconds timeout,
+	              std::shared_ptr<OutputLog> log);
+
+	~GseReassembly();
+
+	/**
+	 * @brief Check whether a GSE packet is a fragment of a PDU
+	 *
+	 * @param data    The GSE packet
+	 * @param length  The GSE packet length
+	 * @return true for a first, intermediate or last fragment,
+	 *         false for a complete packet or padding
+	 */
+	static bool isFragment(const unsigned char *data, std::size_t length);
+
+	/**
+	 * @brief Add a fragment to the PDU of its source and fragment ID
+	 *
+	 * @param source  The source of the fragment
+	 * @param data    The GSE packet
+	 * @param length  The GSE packet length
+	 * @param pdu     OUT: The reassembled PDU, if complete
+	 * @return the outcome of the fragment
+	 */
+	Status add(uint16_t source,
+	           const unsigned char *data,
+	           std::size_t length,
+	           Pdu &pdu);
+
+	/**
+	 * @brief Get the memory used by the buffers under reassembly
+	 *
+	 * @return the memory used (bytes)
+	 */
+	std::size_t getUsedMemory() const;
+
+ private:
+	/// A PDU under reassembly
+	struct Slot
+	{
+		/// Whether a PDU is being reassembled in the slot
+		bool active;
+		/// The source and fragment ID of the slot
+		uint16_t source;
+		uint8_t frag_id;
+		/// The label type of the first fragment
+		uint8_t label_type;
+		/// The total length announced by the first fragment
+		uint16_t total_length;
+		/// The CRC of the data received so far
+		uint32_t crc;
+		/// The data received so far
+		Data buffer;
+		/// The time of the last fragment
+		std::chrono::steady_clock::time_point updated;
+		/// The more and less recently updated slots
+		Slot *prev;
+		Slot *next;
+
+		Slot();
+	};
+
+	/// The slots of a source, indexed by fragment ID
+	using Slots = std::array<Slot, 256>;
+
+	/**
+	 * @brief Drop the PDUs not updated within the timeout
+	 *
+	 * @param now  The current time
+	 */
+	void expire(std::chrono::steady_clock::time_point now);
+
+	/**
+	 * @brief Make room in the memory cap for a new PDU
+	 *
+	 * @param length  The total length of the new PDU
+	 * @return true if the PDU fits, false if it exceeds the cap
+	 */
+	bool reserve(std::size_t length);
+
+	/**
+	 * @brief Release the buffer of a slot and remove it from the LRU list
+	 *
+	 * @param slot  The slot
+	 */
+	void release(Slot &slot);
+
+	/**
+	 * @brief Put a slot at the head of the LRU list
+	 *
+	 * @param slot  The slot
+	 * @param now   The current time
+	 */
+	void touch(Slot &slot, std::chrono::steady_clock::time_point now);
+
+	/**
+	 * @brief Read the protocol type, label and extensions of a PDU
+	 *
+	 * @param slot  The complete slot
+	 * @param pdu   OUT: The PDU
+	 * @return true on success, false if the headers are invalid
+	 */
+	bool readHeaders(Slot &slot, Pdu &pdu) const;
+
+	/// The slots of each source
+	std::unordered_map<uint16_t, Slots> sources;
+
+	/// The most and least recently updated slots
+	Slot *head;
+	Slot *tail;
+
+	/// The memory cap of the buffers and the memory they use (bytes)
+	std::size_t max_memory;
+	std::size_t used_memory;
+
+	/// The time a PDU may wait for its next fragment
+	std::chrono::milliseconds timeout;
+
+	/// The output log
+	std::shared_ptr<OutputLog> log;
+
+	/// The PDUs dropped on timeout and evicted to respect the memory cap,
+	/// shared by all the engines of the process
+	std::shared_ptr<Probe<int>> probe_timeouts;
+	std::shared_ptr<Probe<int>> probe_evictions;
+};
+
+
+#endif
@@ -0,0 +1,313 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file test_gse_reassembly.cpp
+ * @brief Check the reassembly of the fragmented GSE PDUs: the fragments
+ *        out of order, the CRC failures, the timeouts and the evictions
+ *        of the memory cap
+ * @author Viveris Technologies
+ */
+
+
+#include "GseReassembly.h"
+
+#include <opensand_output/Output.h>
+
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+
+#define CHECK(condition) do \
+{ \
+	if(!(condition)) \
+	{ \
+		fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+		return false; \
+	} \
+} while(0)
+
+
+/// The timeout of the PDUs waiting for their next fragment
+static const std::chrono::milliseconds timeout{50};
+
+typedef std::vector<unsigned char> Packet;
+
+
+/**
+ * @brief Compute the CRC-32 of a GSE PDU, bit per bit
+ */
+static uint32_t computeCrc(const Packet &data)
+{
+	uint32_t crc = 0xFFFFFFFF;
+	for(unsigned char byte: data)
+	{
+		crc ^= uint32_t(byte) << 24;
+		for(unsigned int bit = 0; bit < 8; ++bit)
+		{
+			crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+		}
+	}
+	return crc;
+}
+
+/**
+ * @brief Build a broadcast PDU: the protocol type and the payload
+ *
+ * @param length  The payload length
+ * @param seed    The first payload byte
+ */
+static Packet buildPdu(std::size_t length, unsigned char seed)
+{
+	Packet pdu{0x08, 0x00};
+	for(std::size_t index = 0; index < length; ++index)
+	{
+		pdu.push_back(seed + index);
+	}
+	return pdu;
+}
+
+/**
+ * @brief Split a PDU in GSE fragments of at most some bytes of data
+ *
+ * @param pdu      The PDU, from its protocol type
+ * @param frag_id  The fragment ID
+ * @param size     The maximal data length of a fragment
+ * @return the first, intermediate and last fragments
+ */
+static std::vector<Packet> fragment(const Packet &pdu, uint8_t frag_id, std::size_t size)
+{
+	std::vector<Packet> fragments;
+	Packet crc_data{uint8_t(pdu.size() >> 8), uint8_t(pdu.size())};
+	crc_data.insert(crc_data.end(), pdu.begin(), pdu.end());
+	uint32_t crc = computeCrc(crc_data);
+
+	for(std::size_t offset = 0; offset < pdu.size(); offset += size)
+	{
+		bool start = (offset == 0);
+		bool end = (offset + size >= pdu.size());
+		Packet packet{0, 0, frag_id};
+		if(start)
+		{
+			packet.push_back(pdu.size() >> 8);
+			packet.push_back(pdu.size());
+		}
+		packet.insert(packet.end(), pdu.begin() + offset,
+		              pdu.begin() + std::min(offset + size, pdu.size()));
+		if(end)
+		{
+			packet.push_back(crc >> 24);
+			packet.push_back(crc >> 16);
+			packet.push_back(crc >> 8);
+			packet.push_back(crc);
+		}
+		// the broadcast label type, no label
+		std::size_t gse_length = packet.size() - 2;
+		packet[0] = (start ? 0x80 : 0) | (end ? 0x40 : 0) | 0x20 | (gse_length >> 8);
+		packet[1] = gse_length;
+		fragments.push_back(packet);
+	}
+	return fragments;
+}
+
+static GseReassembly::Status add(GseReassembly &reassembly, uint16_t source,
+                                 const Packet &packet, GseReassembly::Pdu &pdu)
+{
+	return reassembly.add(source, packet.data(), packet.size(), pdu);
+}
+
+/**
+ * @brief Check a reassembled PDU against the one fragmented
+ */
+static bool isPdu(const GseReassembly::Pdu &pdu, const Packet &expected)
+{
+	return pdu.protocol == 0x0800 && pdu.label_type == 2 &&
+	       pdu.data.length() - pdu.offset == expected.size() - 2 &&
+	       std::equal(expected.begin() + 2, expected.end(), pdu.data.begin() + pdu.offset);
+}
+
+
+/// The fragments of two PDUs are interleaved, or in a wrong order
+static bool checkOrder(std::shared_ptr<OutputLog> log)
+{
+	GseReassembly reassembly{4096, timeout, log};
+	GseReassembly::Pdu pdu;
+
+	Packet first = buildPdu(100, 0);
+	Packet second = buildPdu(150, 100);
+	auto first_fragments = fragment(first, 1, 40);
+	auto second_fragments = fragment(second, 2, 40);
+	CHECK(GseReassembly::isFragment(first_fragments[0].data(), first_fragments[0].size()));
+
+	// the PDUs of distinct fragment IDs or sources are kept apart
+	CHECK(add(reassembly, 1, first_fragments[0], pdu) == GseReassembly::Status::incomplete);
+	CHECK(add(reassembly, 1, second_fragments[0], pdu) == GseReassembly::Status::incomplete);
+	CHECK(add(reassembly, 2, first_fragments[0], pdu) == GseReassembly::Status::incomplete);
+	CHECK(add(reassembly, 1, second_fragments[1], pdu) == GseReassembly::Status::incomplete);
+	CHECK(add(reassembly, 1, first_fragments[1], pdu) == GseReassembly::Status::incomplete);
+	CHECK(add(reassembly, 1, first_fragments[2], pdu) == GseReassembly::Status::complete);
+	CHECK(isPdu(pdu, first));
+	for(std::size_t index = 2; index < second_fragments.size() - 1; ++index)
+	{
+		CHECK(add(reassembly, 1, second_fragments[index], pdu) == GseReassembly::Status::incomplete);
+	}
+	CHECK(add(reassembly, 1, second_fragments.back(), pdu) == GseReassembly::Status::complete);
+	CHECK(isPdu(pdu, second));
+
+	// the last fragment before an intermediate one fails the checks
+	CHECK(add(reassembly, 2, first_fragments[2], pdu) == GseReassembly::Status::dropped);
+	CHECK(add(reassembly, 2, first_fragments[1], pdu) == GseReassembly::Status::dropped);
+
+	// the fragments without their first one are dropped
+	CHECK(add(reassembly, 2, first_fragments[1], pdu) == GseReassembly::Status::dropped);
+	CHECK(add(reassembly, 2, first_fragments[2], pdu) == GseReassembly::Status::dropped);
+
+	// a first fragment resets the PDU of its fragment ID
+	CHECK(add(reassembly, 1, first_fragments[0], pdu) == GseReassembly::Status::incomplete);
+	CHECK(add(reassembly, 1, first_fragments[1], pdu) == GseReassembly::Status::incomplete);
+	CHECK(add(reassembly, 1, first_fragments[0], pdu) == GseReassembly::Status::incomplete);
+	CHECK(add(reassembly, 1, first_fragments[1], pdu) == GseReassembly::Status::incomplete);
+	CHECK(add(reassembly, 1, first_fragments[2], pdu) == GseReassembly::Status::complete);
+	CHECK(isPdu(pdu, first));
+	CHECK(reassembly.getUsedMemory() == 0);
+	return true;
+}
+
+/// The corrupted PDUs are dropped
+static bool checkCrc(std::shared_ptr<OutputLog> log)
+{
+	GseReassembly reassembly{4096, timeout, log};
+	GseReassembly::Pdu pdu;
+
+	Packet data = buildPdu(100, 0);
+	auto fragments = fragment(data, 3, 60);
+
+	// a payload byte of the intermediate fragment
+	fragments[1][10] ^= 0x01;
+	CHECK(add(reassembly, 1, fragments[0], pdu) == GseReassembly::Status::incomplete);
+	CHECK(add(reassembly, 1, fragments[1], pdu) == GseReassembly::Status::dropped);
+	CHECK(reassembly.getUsedMemory() == 0);
+
+	// the CRC itself
+	fragments = fragment(data, 3, 60);
+	fragments[1].back() ^= 0x80;
+	CHECK(add(reassembly, 1, fragments[0], pdu) == GseReassembly::Status::incomplete);
+	CHECK(add(reassembly, 1, fragments[1], pdu) == GseReassembly::Status::dropped);
+
+	// the PDU is not kept, a retransmission is reassembled
+	CHECK(add(reassembly, 1, fragments[1], pdu) == GseReassembly::Status::dropped);
+	fragments = fragment(data, 3, 60);
+	CHECK(add(reassembly, 1, fragments[0], pdu) == GseReassembly::Status::incomplete);
+	CHECK(add(reassembly, 1, fragments[1], pdu) == GseReassembly::Status::complete);
+	CHECK(isPdu(pdu, data));
+	return true;
+}
+
+/// The PDUs not updated within the timeout are dropped
+static bool checkTimeout(std::shared_ptr<OutputLog> log)
+{
+	GseReassembly reassembly{4096, timeout, log};
+	GseReassembly::Pdu pdu;
+
+	Packet old_data = buildPdu(100, 0);
+	Packet new_data = buildPdu(100, 50);
+	auto old_fragments = fragment(old_data, 4, 60);
+	auto new_fragments = fragment(new_data, 5, 60);
+
+	CHECK(add(reassembly, 1, old_fragments[0], pdu) == GseReassembly::Status::incomplete);
+	std::this_thread::sleep_for(2 * timeout);
+
+	// the next fragment expires the old PDU
+	CHECK(add(reassembly, 1, new_fragments[0], pdu) == GseReassembly::Status::incomplete);
+	CHECK(reassembly.getUsedMemory() == new_data.size());
+	CHECK(add(reassembly, 1, old_fragments[1], pdu) == GseReassembly::Status::dropped);
+	CHECK(add(reassembly, 1, new_fragments[1], pdu) == GseReassembly::Status::complete);
+	CHECK(isPdu(pdu, new_data));
+	CHECK(reassembly.getUsedMemory() == 0);
+	return true;
+}
+
+/// The least recently updated PDUs are evicted when the memory is full
+static bool checkEviction(std::shared_ptr<OutputLog> log)
+{
+	// room for two PDUs of 102 bytes
+	GseReassembly reassembly{250, timeout, log};
+	GseReassembly::Pdu pdu;
+
+	std::vector<Packet> pdus;
+	std::vector<std::vector<Packet>> fragments;
+	for(uint8_t frag_id = 0; frag_id < 3; ++frag_id)
+	{
+		pdus.push_back(buildPdu(100, frag_id));
+		fragments.push_back(fragment(pdus.back(), frag_id, 40));
+	}
+
+	CHECK(add(reassembly, 1, fragments[0][0], pdu) == GseReassembly::Status::incomplete);
+	CHECK(add(reassembly, 2, fragments[1][0], pdu) == GseReassembly::Status::incomplete);
+	// the first PDU is now the most recently updated
+	CHECK(add(reassembly, 1, fragments[0][1], pdu) == GseReassembly::Status::incomplete);
+	CHECK(reassembly.getUsedMemory() == 2 * pdus[0].size());
+
+	// the third PDU evicts the second one
+	CHECK(add(reassembly, 1, fragments[2][0], pdu) == GseReassembly::Status::incomplete);
+	CHECK(reassembly.getUsedMemory() == 2 * pdus[0].size());
+	CHECK(add(reassembly, 2, fragments[1][1], pdu) == GseReassembly::Status::dropped);
+	CHECK(add(reassembly, 1, fragments[0][2], pdu) == GseReassembly::Status::complete);
+	CHECK(isPdu(pdu, pdus[0]));
+	CHECK(add(reassembly, 1, fragments[2][1], pdu) == GseReassembly::Status::incomplete);
+	CHECK(add(reassembly, 1, fragments[2][2], pdu) == GseReassembly::Status::complete);
+	CHECK(isPdu(pdu, pdus[2]));
+
+	// a PDU larger than the memory cap is dropped without evicting
+	Packet large = buildPdu(300, 0);
+	CHECK(add(reassembly, 1, fragments[0][0], pdu) == GseReassembly::Status::incomplete);
+	CHECK(add(reassembly, 1, fragment(large, 7, 40)[0], pdu) == GseReassembly::Status::dropped);
+	CHECK(reassembly.getUsedMemory() == pdus[0].size());
+	return true;
+}
+
+
+int main()
+{
+	// the dropped fragments are logged as errors, they are expected
+	auto output = Output::Get();
+	output->configureTerminalOutput();
+	auto log = output->registerLog(LEVEL_CRITICAL, "Encap.GSE");
+	output->finalizeConfiguration();
+
+	if(!checkOrder(log) || !checkCrc(log) || !checkTimeout(log) || !checkEviction(log))
+	{
+		return 1;
+	}
+
+	printf("GSE reassembly checked\n");
+	return 0;
+}
@@ -40,7 +40,6 @@
 
 #include <opensand_output/Output.h>
 
-#include <algorithm>
 #include <cstring>
 
 
@@ -138,6 +137,7 @@ Rle::Rle():
 {
 	this->upper.push_back("ROHC");
 	this->upper.push_back("Ethernet");
+	this->upper.push_back("PHS");
 	
 	rle_set_trace_callback(&(rle_log));
 }
@@ -226,20 +226,22 @@ unload:
 }
 
 Rle::Context::Context(EncapPlugin &plugin):
-	EncapPlugin::EncapContext(plugin)
+	EncapPlugin::EncapContext(plugin),
+	receivers(RleIdentifier::index_count, nullptr),
+	sdus(),
+	sdus_buffer()
 {
 }
 
 Rle::Context::~Context()
 {
-	std::map<RleIdentifier *, struct rle_receiver *, ltRleIdentifier>::iterator recei_it;
-
 	// Clean decapsulation
-	for(recei_it = this->receivers.begin();
-		recei_it != this->receivers.end(); ++recei_it)
+	for(auto &&receiver : this->receivers)
 	{
-		delete recei_it->first;
-		rle_receiver_destroy(&(recei_it->second));
+		if(receiver)
+		{
+			rle_receiver_destroy(&receiver);
+		}
 	}
 	this->receivers.clear();
 }
@@ -282,9 +284,11 @@ NetBurst *Rle::Context::encapsulate(NetBurst *burst,
 	{
 		try
 		{
-			// Create a new packet (already encapsulated)
-			std::unique_ptr<NetPacket> encap_packet{new NetPacket(packet->getData(),
-			                                                      packet->getTotalLength(),
+			// Create a new packet (already encapsulated) taking the buffer
+			// of the packet, the burst is released afterwards
+			std::size_t length = packet->getTotalLength();
+			std::unique_ptr<NetPacket> encap_packet{new NetPacket(packet->releaseData(),
+			                                                      length,
 			                                                      this->getName(),
 			                                                      this->getEtherType(),
 			                                                      packet->getQos(),
@@ -367,13 +371,11 @@ bool Rle::Context::decapNextPacket(const std::unique_ptr<NetPacket>& packet, Net
 	uint8_t src_tal_id, dst_tal_id, qos;
 	uint8_t label[LABEL_SIZE];
 	unsigned char label_str[LABEL_SIZE];
-	RleIdentifier *identifier = NULL;
-	std::map<RleIdentifier *, struct rle_receiver *, ltRleIdentifier>::iterator it;
 
 	struct rle_receiver *receiver;
-	struct rle_sdu *sdus = NULL;
+	unsigned char *fpdu;
+	size_t fpdu_size;
 	size_t sdus_count = 0;
-	size_t sdus_capacity = 0;
 	size_t sdus_max_count = 0;
 	enum rle_decap_status status;
 
@@ -382,19 +384,22 @@ bool Rle::Context::decapNextPacket(const std::unique_ptr<NetPacket>& packet, Net
 	    packet->getTotalLength());
 
 	// Get data which identify the receiver
-	if(packet->getPayloadLength() <= LABEL_SIZE + ALPDU_HEADER_SIZE)
+	fpdu_size = packet->getPayloadLength();
+	if(fpdu_size <= LABEL_SIZE + ALPDU_HEADER_SIZE)
 	{
 		LOG(this->log, LEVEL_ERROR,
 		    "Not enough payload in %s packet\n",
 		    this->getName().c_str());
-		goto error;
+		return false;
 	}
-	if(!Rle::getLabel(packet->getPayload(), label))
+	// librle does not modify the FPDU
+	fpdu = packet->getRawData() + packet->getHeaderLength();
+	if(!Rle::getLabel(fpdu, label))
 	{
 		LOG(this->log, LEVEL_ERROR,
 		    "Unable to get label from %s packet\n",
 		    this->getName().c_str());
-		goto error;
+		return false;
 	}
 	src_tal_id = label[0];
 	dst_tal_id = label[1];
@@ -404,53 +409,47 @@ bool Rle::Context::decapNextPacket(const std::unique_ptr<NetPacket>& packet, Net
 	    src_tal_id, dst_tal_id, qos);
 
 	// Get receiver
-	identifier = new RleIdentifier(src_tal_id, dst_tal_id);
-	it = this->receivers.find(identifier);
-	if(it == this->receivers.end())
+	struct rle_receiver *&stored_receiver = this->receivers[RleIdentifier::getIndex(src_tal_id, dst_tal_id)];
+	if(!stored_receiver)
 	{
 		LOG(this->log, LEVEL_DEBUG, "Packet requiring a new RLE receiver");
 
 		// Create receiver
-		receiver = rle_receiver_new(&this->rle_conf);
-		if(!receiver)
+		stored_receiver = rle_receiver_new(&this->rle_conf);
+		if(!stored_receiver)
 		{
-			delete identifier;
 			LOG(this->log, LEVEL_ERROR,
 			    "cannot create a RLE receiver\n");
-			goto error;
+			return false;
 		}
-
-		// Store receiver
-		this->receivers[identifier] = receiver;
 		LOG(this->log, LEVEL_DEBUG, "RLE receiver created");
 	}
-	else
+	receiver = stored_receiver;
+
+	// Prepare SDUs structures, only grown when a FPDU may
+	// contain more SDUs than the previous ones
+	sdus_max_count = fpdu_size / LABEL_SIZE;
+	if(this->sdus.size() < sdus_max_count)
 	{
-		LOG(this->log, LEVEL_DEBUG, "Packet requiring an existing RLE receiver");
-		// Get existing identifier and context
-		delete identifier;
-		identifier = it->first;
-		receiver = it->second;
+		this->sdus.resize(sdus_max_count);
+		this->sdus_buffer.resize(sdus_max_count * SDU_MAX_SIZE);
+		for(unsigned int i = 0; i < sdus_max_count; ++i)
+		{
+			this->sdus[i].buffer = &this->sdus_buffer[i * SDU_MAX_SIZE];
+		}
 	}
-
-	// Prepare SDUs structures
-	sdus_max_count = packet->getPayloadLength() / LABEL_SIZE;
-	sdus_capacity = SDU_MAX_SIZE;
-	sdus_count = 0;
-	sdus = new struct rle_sdu[sdus_max_count];
 	for(unsigned int i = 0; i < sdus_max_count; ++i)
 	{
-		sdus[i].size = 0;
-		sdus[i].buffer = new unsigned char[sdus_capacity];
+		this->sdus[i].size = 0;
 	}
 	LOG(this->log, LEVEL_DEBUG, "Initialize SDUs before RLE decapsulation (max_count=%u, count=%u)",
 			sdus_max_count, sdus_count);
 
 	// Decapsulate RLE FPDU
 	status = rle_decapsulate(receiver,
-	                         const_cast<unsigned char *>(packet->getPayload().c_str()),
-	                         packet->getPayloadLength(),
-	                         sdus,
+	                         fpdu,
+	                         fpdu_size,
+	                         this->sdus.data(),
 	                         sdus_max_count,
 	                         &sdus_count,
 	                         label_str,
@@ -459,7 +458,7 @@ bool Rle::Context::decapNextPacket(const std::unique_ptr<NetPacket>& packet, Net
 	{
 		LOG(this->log, LEVEL_ERROR,
 		    "RLE failed to decaspulate SDU\n");
-		goto error;
+		return false;
 	}
 	LOG(this->log, LEVEL_DEBUG,
 	    "Decapsulated SDUs (max_count=%u, count=%u)",
@@ -468,7 +467,7 @@ bool Rle::Context::decapNextPacket(const std::unique_ptr<NetPacket>& packet, Net
 	// Add all SDUs to decapsulated packets list
 	for(unsigned int i = 0; i< sdus_count; ++i)
 	{
-		struct rle_sdu sdu = sdus[i];
+		const struct rle_sdu &sdu = this->sdus[i];
 		std::unique_ptr<NetPacket> decap_packet;
 
 		LOG(this->log, LEVEL_DEBUG,
@@ -479,7 +478,7 @@ bool Rle::Context::decapNextPacket(const std::unique_ptr<NetPacket>& packet, Net
 		{
 			LOG(this->log, LEVEL_ERROR,
 			    "Empty RLE decapsulated packet\n");
-			goto error;
+			return false;
 		}
 
 		// Create packet from SDU
@@ -492,55 +491,32 @@ bool Rle::Context::decapNextPacket(const std::unique_ptr<NetPacket>& packet, Net
 		{
 			LOG(this->log, LEVEL_ERROR,
 			    "RLE failed to create decapsulated packet\n");
-			goto error;
+			return false;
 		}
 
 		// Add SDU to decapsulated packets list
 		burst->add(std::move(decap_packet));
-		delete[] sdus[i].buffer;
-		sdus[i].buffer = NULL;
-		sdus[i].size = 0;
 	}
-	for(unsigned int i = sdus_count; i < sdus_max_count; ++i)
-	{
-		delete[] sdus[i].buffer;
-	}
-	delete[] sdus;
 
 	return true;
-	
-error:
-	if(sdus)
-	{
-		for(unsigned int i = 0; i< sdus_count; ++i)
-		{
-			if(sdus[i].buffer != NULL)
-			{
-				delete[] sdus[i].buffer;
-			}
-		}
-		delete[] sdus;
-	}
-	return false;
 }
 
 Rle::PacketHandler::PacketHandler(EncapPlugin &plugin):
-	EncapPlugin::EncapPacketHandler(plugin)
+	EncapPlugin::EncapPacketHandler(plugin),
+	transmitters(RleIdentifier::index_count, rle_trans_ctxt_t{}),
+	fpdu_buffer()
 {
 }
 
 Rle::PacketHandler::~PacketHandler()
 {
-	std::map<RleIdentifier *, rle_trans_ctxt_t, ltRleIdentifier>::iterator trans_it;
-	
 	// Reset and clean encapsulation
-	for(trans_it = this->transmitters.begin();
-		trans_it != this->transmitters.end();
-		++trans_it)
+	for(auto &&context : this->transmitters)
 	{
-		delete trans_it->first;
-		rle_transmitter_destroy(&(trans_it->second.first));
-		trans_it->second.second.clear();
+		if(context.transmitter)
+		{
+			rle_transmitter_destroy(&context.transmitter);
+		}
 	}
 	this->transmitters.clear();
 }
@@ -564,6 +540,15 @@ std::unique_ptr<NetPacket> Rle::PacketHandler::build(const Data &data,
                                                      uint8_t qos,
                                                      uint8_t src_tal_id,
                                                      uint8_t dst_tal_id) const
+{
+	return this->build(data.c_str(), data_length, qos, src_tal_id, dst_tal_id);
+}
+
+std::unique_ptr<NetPacket> Rle::PacketHandler::build(const unsigned char *data,
+                                                     std::size_t data_length,
+                                                     uint8_t qos,
+                                                     uint8_t src_tal_id,
+                                                     uint8_t dst_tal_id) const
 {
 	// Check payload length
 	if(data_length < LABEL_SIZE)
@@ -592,13 +577,35 @@ bool Rle::PacketHandler::encapNextPacket(std::unique_ptr<NetPacket> packet,
                                          bool new_burst,
                                          std::unique_ptr<NetPacket> &encap_packet,
                                          std::unique_ptr<NetPacket> &remaining_data)
+{
+	return this->encapNext(std::move(packet), remaining_length, new_burst,
+	                       nullptr, encap_packet, remaining_data);
+}
+
+
+bool Rle::PacketHandler::encapNextPacketInto(std::unique_ptr<NetPacket> packet,
+                                             std::size_t remaining_length,
+                                             bool new_burst,
+                                             Data &frame,
+                                             std::unique_ptr<NetPacket> &remaining_data)
+{
+	std::unique_ptr<NetPacket> encap_packet;
+	return this->encapNext(std::move(packet), remaining_length, new_burst,
+	                       &frame, encap_packet, remaining_data);
+}
+
+
+bool Rle::PacketHandler::encapNext(std::unique_ptr<NetPacket> packet,
+                                   std::size_t remaining_length,
+                                   bool new_burst,
+                                   Data *frame,
+                                   std::unique_ptr<NetPacket> &encap_packet,
+                                   std::unique_ptr<NetPacket> &remaining_data)
 {
 	uint8_t frag_id;
 	uint8_t src_tal_id, dst_tal_id, qos;
 	struct rle_transmitter *transmitter;
-	std::vector<NetPacket *>::iterator pkt_it;
-	std::map<RleIdentifier *, rle_trans_ctxt_t, ltRleIdentifier>::iterator it;
-	RleIdentifier *identifier = NULL;
+	bool already_encapsulated;
 	uint8_t label[LABEL_SIZE];
 
 	enum rle_frag_status frag_status;
@@ -609,11 +616,10 @@ bool Rle::PacketHandler::encapNextPacket(std::unique_ptr<NetPacket> packet,
 	size_t ppdu_size;
 	size_t fpdu_size;
 	size_t fpdu_cur_pos;
+	unsigned char *fpdu;
+	size_t frame_length = 0;
 	size_t prev_queue_size, queue_size;
 
-	Data fpdu;
-	unsigned char *fpdu_buffer;
-	
 	// Set default returned values
 	bool partial_encap = false;
 	LOG(this->log, LEVEL_DEBUG,
@@ -666,54 +672,29 @@ bool Rle::PacketHandler::encapNextPacket(std::unique_ptr<NetPacket> packet,
 	frag_id = qos;
 
 	// Get transmitter
-	identifier = new RleIdentifier(src_tal_id, dst_tal_id);
-	it = this->transmitters.find(identifier);
-	if(it == this->transmitters.end())
+	rle_trans_ctxt_t &context = this->transmitters[RleIdentifier::getIndex(src_tal_id, dst_tal_id)];
+	if(!context.transmitter)
 	{
 		LOG(this->log, LEVEL_DEBUG, "Packet requiring a new RLE transmitter");
 
 		// Create transmitter
-		transmitter = rle_transmitter_new(&this->rle_conf);
-		if(!transmitter)
+		context.transmitter = rle_transmitter_new(&this->rle_conf);
+		if(!context.transmitter)
 		{
-			delete identifier;
 			LOG(this->log, LEVEL_ERROR,
 				"cannot create a RLE transmitter\n");
 			return false;
 		}
-
-		// Store transmitter
-		// TODO: remove? this->transmitters[identifier] = std::pair<struct rle_transmitter *, std::vector<NetPacket *> >(transmitter, std::vector<NetPacket *>());
-		this->transmitters[identifier] = std::make_pair(transmitter, std::vector<NetPacket *>{});
-		it = this->transmitters.find(identifier);
-		if(it == this->transmitters.end())
-		{
-			delete identifier;
-			rle_transmitter_destroy(&transmitter);  // FIXME: beware of move semantics of make_pair, does this work?
-			LOG(this->log, LEVEL_ERROR,
-				"cannot store the RLE transmitter\n");
-			return false;
-		}
 		LOG(this->log, LEVEL_DEBUG, "RLE transmitter created");
 	}
-	else
-	{
-		LOG(this->log, LEVEL_DEBUG, "Packet requiring an existing RLE transmitter");
-		// Get existing identifier and context
-		delete identifier;
-		identifier = it->first;
-		transmitter = it->second.first;
-	}
+	transmitter = context.transmitter;
 
 	// Check packet has already been partially sent
-	std::vector<NetPacket *> &sent_packets = it->second.second;
+	NetPacket *&partial_packet = context.partial_packets[frag_id];
 	prev_queue_size = rle_transmitter_stats_get_queue_size(transmitter, frag_id);
-	LOG(this->log, LEVEL_DEBUG,
-	    "Already sent packets (total=%u)",
-	    sent_packets.size());
 
-	pkt_it = std::find(sent_packets.begin(), sent_packets.end(), packet.get());
-	if(pkt_it == sent_packets.end())
+	already_encapsulated = (partial_packet == packet.get());
+	if(!already_encapsulated)
 	{
 		LOG(this->log, LEVEL_DEBUG, "RLE encapsulation of this SDU (len=%u bytes)",
 		    packet->getTotalLength());
@@ -723,21 +704,26 @@ bool Rle::PacketHandler::encapNextPacket(std::unique_ptr<NetPacket> packet,
 				prev_queue_size);
 		}
 
-		// Build RLE SDU
+		if(packet->getTotalLength() > RLE_MAX_PDU_SIZE)
+		{
+			LOG(this->log, LEVEL_ERROR,
+			    "%zu-byte SDU longer than the RLE ones (%u bytes), drop it\n",
+			    packet->getTotalLength(), RLE_MAX_PDU_SIZE);
+			return false;
+		}
+
+		// Build RLE SDU, librle copies the SDU in the transmitter
 		sdu.protocol_type = to_underlying(packet->getType());
 		sdu.size = packet->getTotalLength();
-		sdu.buffer = new unsigned char[sdu.size];
-		memcpy(sdu.buffer, packet->getRawData(), sdu.size);
+		sdu.buffer = packet->getRawData();
 
 		// Encapsulate RLE SDU
 		if(rle_encapsulate(transmitter, &sdu, frag_id) != 0)
 		{
-			delete[] sdu.buffer;
 			LOG(this->log, LEVEL_ERROR,
 			    "RLE failed to encaspulate SDU\n");
 			return false;
 		}
-		delete[] sdu.buffer;
 		sdu.size = 0;
 	}
 	else
@@ -800,16 +786,36 @@ bool Rle::PacketHandler::encapNextPacket(std::unique_ptr<NetPacket> packet,
 	    prev_queue_size < queue_size ? "+" : "",
 	    (int)queue_size - (int)prev_queue_size);
 
-	// Prepare FPDU
+	// Prepare FPDU, straight at the end of the frame if any, else in
+	// a buffer only grown for longer FPDUs
 	fpdu_size = ppdu_size + label_size;
 	fpdu_cur_pos = 0;
-	fpdu_buffer = new unsigned char[fpdu_size];
+	if(frame != nullptr)
+	{
+		frame_length = frame->length();
+		frame->resize(frame_length + fpdu_size);
+		fpdu = &(*frame)[frame_length];
+	}
+	else
+	{
+		if(this->fpdu_buffer.size() < fpdu_size)
+		{
+			this->fpdu_buffer.resize(fpdu_size);
+		}
+		fpdu = this->fpdu_buffer.data();
+	}
 
 	// Pack RLE PPD to RLE FPDU
 	LOG(this->log, LEVEL_DEBUG,
 	    "RLE packing (FPDU len=%u bytes, FPDU pos=%u)",
 	    fpdu_size, fpdu_cur_pos);
-	pack_status = rle_pack(ppdu, ppdu_size, label, label_size, fpdu_buffer, &fpdu_cur_pos, &fpdu_size);
+	pack_status = rle_pack(ppdu, ppdu_size, label, label_size,
+	                       fpdu, &fpdu_cur_pos, &fpdu_size);
+	if(frame != nullptr)
+	{
+		// keep only the packed bytes in the frame
+		frame->resize(frame_length + (pack_status == 0 ? fpdu_cur_pos : 0));
+	}
 	if(pack_status == RLE_PACK_ERR_FPDU_TOO_SMALL)
 	{
 		LOG(this->log, LEVEL_INFO,
@@ -820,32 +826,31 @@ bool Rle::PacketHandler::encapNextPacket(std::unique_ptr<NetPacket> packet,
 	}
 	if(pack_status != 0)
 	{
-		delete[] fpdu_buffer;
 		LOG(this->log, LEVEL_ERROR,
 		    "RLE failed to pack PPDU (code=%d)\n",
 		    (int)pack_status);
 		return false;
 	}
-	fpdu.assign(fpdu_buffer, fpdu_cur_pos);
-	delete[] fpdu_buffer;
-
-	encap_packet.reset(new NetPacket(fpdu, fpdu_cur_pos,
-	                                 this->getName(),
-	                                 this->getEtherType(),
-	                                 qos, src_tal_id, dst_tal_id, 0));
+	if(frame == nullptr)
+	{
+		encap_packet.reset(new NetPacket(this->fpdu_buffer.data(), fpdu_cur_pos,
+		                                 this->getName(),
+		                                 this->getEtherType(),
+		                                 qos, src_tal_id, dst_tal_id, 0));
+	}
 
 encap_end:
-	if((pkt_it == sent_packets.end()) && partial_encap)
+	if(!already_encapsulated && partial_encap)
 	{
-		// Add packet to partial sent packets list
+		// Keep the packet as partially sent on its fragment id
 		LOG(this->log, LEVEL_DEBUG, "Add packet to partially sent packets list");
-		sent_packets.push_back(packet.get());
+		partial_packet = packet.get();
 	}
-	else if((pkt_it != sent_packets.end()) && !partial_encap)
+	else if(already_encapsulated && !partial_encap)
 	{
-		// Remove packet from partial sent packets list
+		// The packet is fully sent
 		LOG(this->log, LEVEL_DEBUG, "Remove packet from partially sent packets list");
-		sent_packets.erase(pkt_it);
+		partial_packet = nullptr;
 	}
 
 	if (partial_encap)
@@ -869,7 +874,8 @@ bool Rle::PacketHandler::getEncapsulatedPackets(std::unique_ptr<NetContainer> pa
 	std::unique_ptr<NetPacket> decap_packet;
 	try
 	{
-		decap_packet = this->build(packet->getPayload(), packet->getPayloadLength(),
+		decap_packet = this->build(packet->getRawData() + packet->getHeaderLength(),
+		                           packet->getPayloadLength(),
 		                           0x00, BROADCAST_TAL_ID, BROADCAST_TAL_ID);
 	}
 	catch (const std::bad_alloc&)
@@ -886,6 +892,18 @@ bool Rle::PacketHandler::getEncapsulatedPackets(std::unique_ptr<NetContainer> pa
 	return true;
 }
 
+bool Rle::PacketHandler::getEncapsulatedPacketsFor(std::unique_ptr<NetContainer> packet,
+                                                   unsigned int decap_packets_count,
+                                                   tal_id_t,
+                                                   std::vector<std::unique_ptr<NetPacket>> &decap_packets)
+{
+	// the payload is a single RLE packet, the destination is
+	// known once the ALPDU is rebuilt by the context
+	bool partial_decap;
+	return this->getEncapsulatedPackets(std::move(packet), partial_decap,
+	                                    decap_packets, decap_packets_count);
+}
+
 bool Rle::PacketHandler::getChunk(std::unique_ptr<NetPacket>,
                                   std::size_t,
                                   std::unique_ptr<NetPacket>&,
@@ -926,6 +944,13 @@ bool Rle::PacketHandler::getQos(const Data &data, qos_t &qos) const
 }
 
 
+std::size_t Rle::PacketHandler::getMaxPduLength() const
+{
+	// the ALPDU length field bounds the SDUs, jumbo frames do not fit
+	return RLE_MAX_PDU_SIZE;
+}
+
+
 bool Rle::PacketHandler::checkPacketForHeaderExtensions(std::unique_ptr<NetPacket> &)
 {
 	LOG(this->log, LEVEL_ERROR,
@@ -987,9 +1012,18 @@ bool Rle::getLabel(NetPacket *packet, uint8_t label[])
 
 bool Rle::getLabel(const Data &data, uint8_t label[])
 {
-	uint8_t src_tal_id = (uint8_t)(data.at(0));
-	uint8_t dst_tal_id = (uint8_t)(data.at(1));
-	uint8_t qos = (uint8_t)(data.at(2));
+	if(data.length() < LABEL_SIZE)
+	{
+		return false;
+	}
+	return Rle::getLabel(data.c_str(), label);
+}
+
+bool Rle::getLabel(const unsigned char *data, uint8_t label[])
+{
+	uint8_t src_tal_id = (uint8_t)(data[0]);
+	uint8_t dst_tal_id = (uint8_t)(data[1]);
+	uint8_t qos = (uint8_t)(data[2]);
 
 	//DFLTLOG(LEVEL_ERROR, "Src_tal_id = %u (& 0x1F = %u)",
 	//	src_tal_id, src_tal_id & 0x1F);
@@ -41,6 +41,7 @@
 #include <EncapPlugin.h>
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -93,8 +94,14 @@ class Rle: public EncapPlugin
 		/// RLE configuration
 		struct rle_config rle_conf;
 
-		/// Receivers identified by an unique identifier
-		std::map<RleIdentifier *, struct rle_receiver *, ltRleIdentifier> receivers;
+		/// Receivers indexed by RleIdentifier::getIndex, created on first use
+		std::vector<struct rle_receiver *> receivers;
+
+		/// The SDUs decapsulated from a FPDU, kept from a FPDU to the other
+		std::vector<struct rle_sdu> sdus;
+
+		/// The buffers of the decapsulated SDUs
+		std::vector<unsigned char> sdus_buffer;
 
 		bool decapNextPacket(const std::unique_ptr<NetPacket>& packet, NetBurst *burst);
 	};
@@ -109,9 +116,21 @@ class Rle: public EncapPlugin
 		/// RLE configuration
 		struct rle_config rle_conf;
 
-		// Transmitters and partial sent packets list
-		typedef std::pair<struct rle_transmitter *, std::vector<NetPacket *> > rle_trans_ctxt_t;
-		std::map<RleIdentifier *, rle_trans_ctxt_t, ltRleIdentifier> transmitters;
+		/// The number of fragment ids of a RLE transmitter, one per QoS
+		static constexpr std::size_t frag_id_count = 8;
+
+		/// Transmitter and partially sent packet of each fragment id
+		struct rle_trans_ctxt_t
+		{
+			struct rle_transmitter *transmitter;
+			NetPacket *partial_packets[frag_id_count];
+		};
+
+		/// Transmitters indexed by RleIdentifier::getIndex, created on first use
+		std::vector<rle_trans_ctxt_t> transmitters;
+
+		/// The buffer the PPDUs are packed in
+		std::vector<unsigned char> fpdu_buffer;
 
 	  public:
 		PacketHandler(EncapPlugin &plugin);
@@ -125,11 +144,28 @@ class Rle: public EncapPlugin
 		                                 uint8_t qos,
 		                                 uint8_t src_tal_id,
 		                                 uint8_t dst_tal_id) const override;
+
+		/**
+		 * @brief Build a RLE packet from a buffer
+		 *
+		 * @param data         The RLE FPDU
+		 * @param data_length  The FPDU length
+		 * @param qos          The QoS of the packet
+		 * @param src_tal_id   The source terminal id
+		 * @param dst_tal_id   The destination terminal id
+		 * @return the RLE packet
+		 */
+		std::unique_ptr<NetPacket> build(const unsigned char *data,
+		                                 size_t data_length,
+		                                 uint8_t qos,
+		                                 uint8_t src_tal_id,
+		                                 uint8_t dst_tal_id) const;
 		size_t getFixedLength() const {return 0;};
 		size_t getMinLength() const {return 3;};
 		size_t getLength(const unsigned char *data) const;
 		bool getSrc(const Data &data, tal_id_t &tal_id) const;
 		bool getQos(const Data &data, qos_t &qos) const;
+		std::size_t getMaxPduLength() const override;
 
 		bool encapNextPacket(std::unique_ptr<NetPacket> packet,
 		                     std::size_t remaining_length,
@@ -137,11 +173,22 @@ class Rle: public EncapPlugin
 		                     std::unique_ptr<NetPacket> &encap_packet,
 		                     std::unique_ptr<NetPacket> &remaining_data) override;
 
+		bool encapNextPacketInto(std::unique_ptr<NetPacket> packet,
+		                         std::size_t remaining_length,
+		                         bool new_burst,
+		                         Data &frame,
+		                         std::unique_ptr<NetPacket> &remaining_data) override;
+
 		bool getEncapsulatedPackets(std::unique_ptr<NetContainer> packet,
 		                            bool &partial_decap,
 		                            std::vector<std::unique_ptr<NetPacket>> &decap_packets,
 		                            unsigned int decap_packet_count = 0) override;
 
+		bool getEncapsulatedPacketsFor(std::unique_ptr<NetContainer> packet,
+		                               unsigned int decap_packets_count,
+		                               tal_id_t dst_tal_id,
+		                               std::vector<std::unique_ptr<NetPacket>> &decap_packets) override;
+
 		bool checkPacketForHeaderExtensions(std::unique_ptr<NetPacket> &packet) override;
 
 		bool setHeaderExtensions(std::unique_ptr<NetPacket> packet,
@@ -160,6 +207,25 @@ class Rle: public EncapPlugin
                   std::size_t remaining_length,
 		              std::unique_ptr<NetPacket> &data,
                   std::unique_ptr<NetPacket> &remaining_data) const override;
+
+		/**
+		 * @brief Encapsulate the next part of a packet in a FPDU
+		 *
+		 * @param packet            The packet to encapsulate
+		 * @param remaining_length  The remaining length in the frame
+		 * @param new_burst         The new burst status
+		 * @param frame             The frame buffer the FPDU is packed at
+		 *                          the end of, nullptr to build a packet
+		 * @param encap_packet      OUT: The FPDU packet if frame is nullptr
+		 * @param remaining_data    OUT: The packet if it is partially sent
+		 * @return  true if success, false otherwise
+		 */
+		bool encapNext(std::unique_ptr<NetPacket> packet,
+		               std::size_t remaining_length,
+		               bool new_burst,
+		               Data *frame,
+		               std::unique_ptr<NetPacket> &encap_packet,
+		               std::unique_ptr<NetPacket> &remaining_data);
 	};
 
 	/// Constructor
@@ -177,6 +243,7 @@ class Rle: public EncapPlugin
 
 	static bool getLabel(NetPacket *packet, uint8_t label[]);
 	static bool getLabel(const Data &data, uint8_t label[]);
+	static bool getLabel(const unsigned char *data, uint8_t label[]);
 };
 
 
@@ -60,9 +60,13 @@ uint8_t RleIdentifier::getDstTalId() const
 }
 
 
-bool ltRleIdentifier::operator() (RleIdentifier *ai1, RleIdentifier *ai2) const
+uint16_t RleIdentifier::getIndex() const
 {
-	const auto talId1 = ai1->getSrcTalId();
-	const auto talId2 = ai2->getSrcTalId();
-	return talId1 == talId2 ? ai1->getDstTalId() < ai2->getDstTalId() : talId1 < talId2;
+	return RleIdentifier::getIndex(this->src_tal_id, this->dst_tal_id);
+}
+
+
+uint16_t RleIdentifier::getIndex(uint8_t src_tal_id, uint8_t dst_tal_id)
+{
+	return ((src_tal_id & 0x1F) << 5) | (dst_tal_id & 0x1F);
 }
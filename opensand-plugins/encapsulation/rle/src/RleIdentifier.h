@@ -37,6 +37,7 @@
 #define RLE_IDENT_H
 
 
+#include <cstddef>
 #include <stdint.h>
 
 
@@ -81,24 +82,27 @@ class RleIdentifier
 	 * @return the destination Tal Id
 	 */
 	uint8_t getDstTalId() const;
-};
 
+	/**
+	 * Get the index of the identifier in the RLE contexts tables
+	 *
+	 * @return the index of the identifier
+	 */
+	uint16_t getIndex() const;
 
-/**
- * @brief Operator to compare two RLE identifiers
- */
-struct ltRleIdentifier
-{
 	/**
-	 * Operator to test if one RLE identifier is lesser than another
-	 * RLE identifier
+	 * Get the index of a source and destination Tal Ids pair in the
+	 * RLE contexts tables, the Tal Ids being coded on 5 bits in the
+	 * RLE labels
 	 *
-	 * @param ai1 the first RLE identifier
-	 * @param ai2 the second RLE identifier
-	 * @return true if first RLE identifier is lesser than the second,
-	 *         false otherwise
+	 * @param src_tal_id the source Tal Id
+	 * @param dst_tal_id the destination Tal Id
+	 * @return the index of the pair
 	 */
-	bool operator() (RleIdentifier * ai1, RleIdentifier * ai2) const;
+	static uint16_t getIndex(uint8_t src_tal_id, uint8_t dst_tal_id);
+
+	/// The number of indexes in the RLE contexts tables
+	static constexpr std::size_t index_count = 1 << 10;
 };
 
 
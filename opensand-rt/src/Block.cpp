@@ -35,6 +35,12 @@
  */
 
 #include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <sstream>
 
 #include <opensand_output/Output.h>
 
@@ -42,11 +48,107 @@
 #include "Rt.h"
 #include "RtChannelBase.h"
 #include "RtChannel.h"
+#include "RtMemory.h"
+#include "RtAccounting.h"
+
+
+/**
+ * @brief Get the time elapsed since a startup phase began
+ *
+ * @param start  The beginning of the phase, reset to now
+ * @return the phase duration in milliseconds
+ */
+/// The delay given to the channel loops to leave before they are cancelled
+static const std::chrono::seconds stop_grace{1};
+
+
+static double phaseDuration(std::chrono::steady_clock::time_point &start)
+{
+	auto now = std::chrono::steady_clock::now();
+	double duration = std::chrono::duration<double, std::milli>(now - start).count();
+	start = now;
+	return duration;
+}
+
+
+/**
+ * @brief Format a list of CPUs or NUMA nodes for logging
+ *
+ * @param list  The list to format
+ * @return the comma separated list, or "any" if empty
+ */
+static std::string formatList(const std::vector<int> &list)
+{
+	if(list.empty())
+	{
+		return "any";
+	}
+
+	std::ostringstream formatted;
+	for(auto it = list.begin(); it != list.end(); ++it)
+	{
+		if(it != list.begin())
+		{
+			formatted << ",";
+		}
+		formatted << *it;
+	}
+	return formatted.str();
+}
+
+
+/**
+ * @brief Get the name of a scheduling policy for logging
+ *
+ * @param policy  The scheduling policy
+ * @return the name of the policy
+ */
+/**
+ * @class ProbesScope
+ * @brief Register the probes of a block under its prefix in a scope
+ */
+class ProbesScope
+{
+ public:
+	ProbesScope(const std::string &prefix):
+		previous{Output::Get()->getProbesPrefix()}
+	{
+		Output::Get()->setProbesPrefix(prefix);
+	};
+
+	~ProbesScope()
+	{
+		Output::Get()->setProbesPrefix(this->previous);
+	};
+
+ private:
+	std::string previous;
+};
+
+
+static const char *policyName(int policy)
+{
+	switch(policy)
+	{
+		case SCHED_FIFO:
+			return "SCHED_FIFO";
+		case SCHED_RR:
+			return "SCHED_RR";
+		default:
+			return "SCHED_OTHER";
+	}
+}
 
 
 Block::Block(const std::string &name):
 	name(name),
-	initialized(false)
+	up_placement{{}, SCHED_OTHER, 0, {}, 0, false},
+	down_placement{{}, SCHED_OTHER, 0, {}, 0, false},
+	running_channels{0},
+	running_mutex{},
+	running_cond{},
+	initialized(false),
+	probes_prefix{Output::Get()->getProbesPrefix()}
 {
 	// Output logs
 	this->log_rt = Output::Get()->registerLog(LEVEL_WARNING, "%s.rt", this->name.c_str());
@@ -67,11 +169,20 @@ Block::~Block()
 
 bool Block::init(void)
 {
-	// initialize channels
-	if(!this->upward->init())
+	ProbesScope probes{this->probes_prefix};
+
+	// initialize channels, their fifos rings are placed on their nodes
+	// and the objects they build are counted in their accounts
 	{
-		return false;
+		RtMemory::Scope memory{this->up_placement};
+		RtAccounting::Scope accounting{this->upward->account};
+		if(!this->upward->init())
+		{
+			return false;
+		}
 	}
+	RtMemory::Scope memory{this->down_placement};
+	RtAccounting::Scope accounting{this->downward->account};
 	if(!this->downward->init())
 	{
 		return false;
@@ -83,6 +194,9 @@ bool Block::init(void)
 
 bool Block::initSpecific(void)
 {
+	ProbesScope probes{this->probes_prefix};
+	auto start = std::chrono::steady_clock::now();
+
 	// specific block initialization
 	if(!this->onInit())
 	{
@@ -90,25 +204,42 @@ bool Block::initSpecific(void)
 		                true, "Block onInit failed");
 		return false;
 	}
+	double block_duration = phaseDuration(start);
 
 	// initialize channels
-	if(!this->upward->onInit())
+	bool status;
+	{
+		RtMemory::Scope memory{this->up_placement};
+		RtAccounting::Scope accounting{this->upward->account};
+		status = this->upward->onInit();
+	}
+	if(!status)
 	{
 		Rt::reportError(this->name, std::this_thread::get_id(),
 		                true, "Upward onInit failed");
 		return false;
 	}
-	if(!this->downward->onInit())
+	double upward_duration = phaseDuration(start);
+	{
+		RtMemory::Scope memory{this->down_placement};
+		RtAccounting::Scope accounting{this->downward->account};
+		status = this->downward->onInit();
+	}
+	if(!status)
 	{
 		Rt::reportError(this->name, std::this_thread::get_id(),
 		                true, "Downward onInit failed");
 		return false;
 	}
+	double downward_duration = phaseDuration(start);
 	this->initialized = true;
 	this->upward->setIsBlockInitialized(true);
 	this->downward->setIsBlockInitialized(true);
 	LOG(this->log_init, LEVEL_NOTICE,
-	    "Block initialization complete\n");
+	    "Block initialization complete in %.1f ms "
+	    "(block %.1f ms, upward %.1f ms, downward %.1f ms)\n",
+	    block_duration + upward_duration + downward_duration,
+	    block_duration, upward_duration, downward_duration);
 
 	return true;
 }
@@ -117,6 +248,116 @@ bool Block::initSpecific(void)
 bool Block::onInit() { return true; }
 
 
+void Block::setThreadPlacement(bool upward, const rt_thread_placement_t &placement)
+{
+	if(upward)
+	{
+		this->up_placement = placement;
+		this->upward->setBusyPoll(placement.busy_poll_us);
+	}
+	else
+	{
+		this->down_placement = placement;
+		this->downward->setBusyPoll(placement.busy_poll_us);
+	}
+}
+
+
+bool Block::applyPlacement(const rt_thread_placement_t &placement,
+                           const char *direction)
+{
+	pthread_t handle = pthread_self();
+	int ret;
+
+	if(!placement.cpus.empty())
+	{
+		cpu_set_t cpu_set;
+		CPU_ZERO(&cpu_set);
+		for(int cpu: placement.cpus)
+		{
+			if(cpu < 0 || cpu >= CPU_SETSIZE)
+			{
+				Rt::reportError(this->name, std::this_thread::get_id(), false,
+				                "invalid CPU %d for %s channel", cpu, direction);
+				return false;
+			}
+			CPU_SET(cpu, &cpu_set);
+		}
+		ret = pthread_setaffinity_np(handle, sizeof(cpu_set), &cpu_set);
+		if(ret != 0)
+		{
+			Rt::reportError(this->name, std::this_thread::get_id(), false,
+			                "cannot set %s channel CPU affinity [%d: %s]",
+			                direction, ret, strerror(ret));
+			return false;
+		}
+	}
+
+	if(placement.policy != SCHED_OTHER)
+	{
+		struct sched_param param;
+		param.sched_priority = placement.priority;
+		ret = pthread_setschedparam(handle, placement.policy, &param);
+		if(ret != 0)
+		{
+			Rt::reportError(this->name, std::this_thread::get_id(), false,
+			                "cannot set %s channel scheduling policy %s "
+			                "with priority %d [%d: %s]",
+			                direction, policyName(placement.policy),
+			                placement.priority, ret, strerror(ret));
+			return false;
+		}
+	}
+
+	LOG(this->log_rt, LEVEL_NOTICE,
+	    "Block %s: %s channel placed on CPUs %s with policy %s "
+	    "(priority %d), memory placed on NUMA nodes %s%s\n",
+	    this->name.c_str(), direction,
+	    formatList(placement.cpus).c_str(),
+	    policyName(placement.policy), placement.priority,
+	    formatList(RtMemory::getNodes(placement)).c_str(),
+	    placement.huge_pages ? " with huge pages" : "");
+	return true;
+}
+
+
+bool Block::bindMemory(const rt_thread_placement_t &placement,
+                       const char *direction)
+{
+	// without NUMA nodes, the node of the CPUs is preferred
+	if(!RtMemory::bindThread(placement))
+	{
+		Rt::reportError(this->name, std::this_thread::get_id(), false,
+		                "cannot bind %s channel memory to NUMA nodes %s [%d: %s]",
+		                direction, formatList(RtMemory::getNodes(placement)).c_str(),
+		                errno, strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+
+void Block::runChannel(RtChannelBase *channel,
+                       const rt_thread_placement_t &placement,
+                       const char *direction,
+                       std::shared_ptr<std::promise<bool>> placed)
+{
+	// the placement is applied before the channel allocates its memory
+	bool status = this->applyPlacement(placement, direction) &&
+	              this->bindMemory(placement, direction);
+	placed->set_value(status);
+	if(status)
+	{
+		Output::Get()->setProbesPrefix(this->probes_prefix);
+		channel->executeThread();
+	}
+
+	std::lock_guard<std::mutex> lock{this->running_mutex};
+	this->running_channels--;
+	this->running_cond.notify_all();
+}
+
+
 bool Block::isInitialized(void)
 {
 	return this->initialized;
@@ -125,12 +366,20 @@ bool Block::isInitialized(void)
 
 bool Block::start(void)
 {
+	auto up_placed = std::make_shared<std::promise<bool>>();
+	auto down_placed = std::make_shared<std::promise<bool>>();
+
 	//create upward thread
 	LOG(this->log_rt, LEVEL_INFO,
 	    "Block %s: start upward channel\n", this->name.c_str());
   try {
-	  this->up_thread = std::thread{&RtUpward::executeThread, this->upward};
+	  this->running_channels++;
+	  this->up_thread = std::thread{[this, up_placed]()
+	  {
+		  this->runChannel(this->upward, this->up_placement, "upward", up_placed);
+	  }};
   } catch (const std::system_error& e) {
+	  this->running_channels--;
 		Rt::reportError(this->name, std::this_thread::get_id(), true,
 		                "cannot start upward thread [%u: %s]", e.code(), e.what());
     return false;
@@ -138,13 +387,24 @@ bool Block::start(void)
 	LOG(this->log_rt, LEVEL_INFO,
 	    "Block %s: upward channel thread id %lu\n",
 	    this->name.c_str(), this->up_thread.get_id());
+	if(!up_placed->get_future().get())
+	{
+		// the error is already reported, the channel did not run
+		this->up_thread.join();
+		return false;
+	}
 
 	//create downward thread
 	LOG(this->log_rt, LEVEL_INFO,
 	    "Block %s: start downward channel\n", this->name.c_str());
   try {
-    this->down_thread = std::thread{&RtDownward::executeThread, this->downward};
+    this->running_channels++;
+    this->down_thread = std::thread{[this, down_placed]()
+    {
+	    this->runChannel(this->downward, this->down_placement, "downward", down_placed);
+    }};
   } catch (const std::system_error& e) {
+    this->running_channels--;
 		Rt::reportError(this->name, std::this_thread::get_id(), true,
 		                "cannot downward start thread [%u: %s]", e.code(), e.what());
     pthread_cancel(this->up_thread.native_handle());
@@ -154,6 +414,13 @@ bool Block::start(void)
 	LOG(this->log_rt, LEVEL_INFO,
 	    "Block %s: downward channel thread id: %lu\n",
 	    this->name.c_str(), this->down_thread.get_id());
+	if(!down_placed->get_future().get())
+	{
+		this->down_thread.join();
+		pthread_cancel(this->up_thread.native_handle());
+		this->up_thread.join();
+		return false;
+	}
 
 	return true;
 }
@@ -164,10 +431,23 @@ bool Block::stop()
 
 	LOG(this->log_rt, LEVEL_INFO,
 	    "Block %s: stop channels\n", this->name.c_str());
-	// the process may be already killed as the may have caught the stop signal first
-	// So, do not report an error
-	pthread_cancel(this->up_thread.native_handle());
-	pthread_cancel(this->down_thread.native_handle());
+	// the loops leave on their next wake up, only the channels still
+	// blocked elsewhere after the grace delay are cancelled
+	this->upward->requestStop();
+	this->downward->requestStop();
+	std::unique_lock<std::mutex> lock{this->running_mutex};
+	if(!this->running_cond.wait_for(lock, stop_grace,
+	                                [this]() { return this->running_channels == 0; }))
+	{
+		LOG(this->log_rt, LEVEL_NOTICE,
+		    "Block %s: %u channels did not stop, cancel them\n",
+		    this->name.c_str(), this->running_channels);
+		// the process may be already killed as the may have caught the stop signal first
+		// So, do not report an error
+		pthread_cancel(this->up_thread.native_handle());
+		pthread_cancel(this->down_thread.native_handle());
+	}
+	lock.unlock();
 
 	LOG(this->log_rt, LEVEL_INFO,
 	    "Block %s: join channels\n", this->name.c_str());
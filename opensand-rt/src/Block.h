@@ -37,10 +37,15 @@
 #ifndef BLOCK_H
 #define BLOCK_H
 
+#include <condition_variable>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 
+#include "Types.h"
+
 
 class RtEvent;
 class RtChannelBase;
@@ -81,6 +86,16 @@ class Block
 	/// The downward channel
 	RtChannelBase *downward;
 
+	/**
+	 * @brief Set the placement of a channel thread, applied when
+	 *        the block is started
+	 *
+	 * @param upward     Whether the upward or the downward channel is placed
+	 * @param placement  The CPU set, scheduling policy and NUMA nodes
+	 *                   of the channel thread
+	 */
+	void setThreadPlacement(bool upward, const rt_thread_placement_t &placement);
+
   private:
 	/**
 	 * @class Upward channel
@@ -187,6 +202,43 @@ class Block
 	 */
 	bool stop(void);
 
+	/**
+	 * @brief Apply the CPU affinity and scheduling policy of the calling
+	 *        channel thread
+	 *
+	 * @param placement  The placement of the channel thread
+	 * @param direction  The channel direction, for logging
+	 * @return true on success, false otherwise
+	 */
+	bool applyPlacement(const rt_thread_placement_t &placement,
+	                    const char *direction);
+
+	/**
+	 * @brief Bind the memory of the calling channel thread to NUMA nodes,
+	 *        the memory policy only applies to the calling thread
+	 *
+	 * @param placement  The placement of the channel thread
+	 * @param direction  The channel direction, for logging
+	 * @return true on success, false otherwise
+	 */
+	bool bindMemory(const rt_thread_placement_t &placement,
+	                const char *direction);
+
+	/**
+	 * @brief Place the calling thread then run the loop of a channel
+	 *        in it and signal its end to stop, the channel is not run
+	 *        if it could not be placed
+	 *
+	 * @param channel    The channel to run
+	 * @param placement  The placement of the channel thread
+	 * @param direction  The channel direction, for logging
+	 * @param placed     Set to the result of the placement
+	 */
+	void runChannel(RtChannelBase *channel,
+	                const rt_thread_placement_t &placement,
+	                const char *direction,
+	                std::shared_ptr<std::promise<bool>> placed);
+
 	/// Output Log
 	std::shared_ptr<OutputLog> log_rt;
 	std::shared_ptr<OutputLog> log_init;
@@ -200,9 +252,24 @@ class Block
 	/// The downward channel thread
   std::thread down_thread;
 
+	/// The upward channel thread placement
+	rt_thread_placement_t up_placement;
+	/// The downward channel thread placement
+	rt_thread_placement_t down_placement;
+
+	/// The number of channel loops still running, stop waits
+	/// for them before cancelling the blocked ones
+	unsigned int running_channels;
+	std::mutex running_mutex;
+	std::condition_variable running_cond;
+
 	/// Whether the block is initialized
 	bool initialized;
 
+	/// The section prefixing the probes of the block, that of the
+	/// thread creating the block
+	std::string probes_prefix;
+
 	/// The event for block initialization
 	std::shared_ptr<OutputEvent> event_init;
 };
@@ -38,6 +38,7 @@
 #include <signal.h>
 #include <syslog.h>
 #include <cstring>
+#include <chrono>
 
 #include <cxxabi.h>
 #include <execinfo.h>
@@ -48,6 +49,8 @@
 #include "Rt.h"
 #include "RtChannelBase.h"
 #include "RtFifo.h"
+#include "RtAccounting.h"
+#include "RtTrace.h"
 
 
 // taken from http://oroboro.com/stack-trace-on-crash/
@@ -156,9 +159,29 @@ static void crash_handler(int sig)
 }
 
 
+/**
+ * @brief Block the signals stopping the process, dumping the memory
+ *        accounting and toggling the tracing in the calling thread,
+ *        before it starts the threads that inherit its mask, so that
+ *        only the manager signalfd reads them
+ */
+static void blockManagerSignals(void)
+{
+	sigset_t signal_mask;
+	sigemptyset(&signal_mask);
+	sigaddset(&signal_mask, SIGINT);
+	sigaddset(&signal_mask, SIGQUIT);
+	sigaddset(&signal_mask, SIGTERM);
+	sigaddset(&signal_mask, SIGUSR1);
+	sigaddset(&signal_mask, SIGUSR2);
+	pthread_sigmask(SIG_BLOCK, &signal_mask, NULL);
+}
+
+
 BlockManager::BlockManager():
 	stopped(false),
-	status(true)
+	status(true),
+	trace_file()
 {
 }
 
@@ -190,6 +213,158 @@ void BlockManager::stop(void)
 			block->stop();
 		}
 	}
+	// the channels no longer give tasks to the workers
+	this->task_pool.stop();
+
+	if(RtTrace::isEnabled())
+	{
+		this->toggleTracing();
+	}
+}
+
+
+bool BlockManager::setThreadPlacement(const std::string &block_name, bool upward,
+                                      const rt_thread_placement_t &placement)
+{
+	for(auto &&block: block_list)
+	{
+		if(block->name == block_name)
+		{
+			block->setThreadPlacement(upward, placement);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool BlockManager::setFusedLinks(const std::string &block_name, bool upward)
+{
+	for(auto &&block: block_list)
+	{
+		if(block->name == block_name)
+		{
+			RtChannelBase *channel = upward ? block->upward : block->downward;
+			channel->fuseNextChannels();
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool BlockManager::startTaskPool(std::size_t workers, const rt_thread_placement_t &placement)
+{
+	// the workers are started before the blocks initialization
+	this->log_rt = Output::Get()->registerLog(LEVEL_WARNING, "Rt");
+	blockManagerSignals();
+	if(!this->task_pool.start(workers, placement))
+	{
+		LOG(this->log_rt, LEVEL_ERROR,
+		    "cannot start the %zu workers of the task pool\n", workers);
+		return false;
+	}
+	LOG(this->log_rt, LEVEL_NOTICE,
+	    "%zu workers started for the channels tasks\n", workers);
+	return true;
+}
+
+
+RtTaskPool &BlockManager::getTaskPool(void)
+{
+	return this->task_pool;
+}
+
+
+bool BlockManager::setCapture(const std::string &block_name, bool upward,
+                              const std::string &filename, rt_msg_serializer_t serializer)
+{
+	for(auto &&block: block_list)
+	{
+		if(block->name == block_name)
+		{
+			RtChannelBase *channel = upward ? block->upward : block->downward;
+			return channel->setCapture(filename, serializer);
+		}
+	}
+	return false;
+}
+
+
+bool BlockManager::setEventsStatistics(double period_ms)
+{
+	for(auto &&block: block_list)
+	{
+		if(!block->upward->setEventsStatistics(period_ms) ||
+		   !block->downward->setEventsStatistics(period_ms))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+void BlockManager::setHardwareCounters(bool enabled)
+{
+	for(auto &&block: block_list)
+	{
+		block->upward->setHardwareCounters(enabled);
+		block->downward->setHardwareCounters(enabled);
+	}
+}
+
+
+void BlockManager::setTraceFile(const std::string &filename)
+{
+	this->trace_file = filename;
+}
+
+
+void BlockManager::toggleTracing(void)
+{
+	if(this->trace_file.empty())
+	{
+		LOG(this->log_rt, LEVEL_WARNING,
+		    "no trace file configured, SIGUSR2 is ignored\n");
+		return;
+	}
+	if(!RtTrace::isEnabled())
+	{
+		RtTrace::enable();
+		LOG(this->log_rt, LEVEL_NOTICE, "tracing started\n");
+		return;
+	}
+	RtTrace::disable();
+	if(!RtTrace::write(this->trace_file))
+	{
+		LOG(this->log_rt, LEVEL_ERROR,
+		    "cannot write the trace in %s: %s\n",
+		    this->trace_file.c_str(), strerror(errno));
+		return;
+	}
+	LOG(this->log_rt, LEVEL_NOTICE,
+	    "tracing stopped, trace written in %s\n", this->trace_file.c_str());
+}
+
+
+void BlockManager::setFlowControl(const std::vector<uint8_t> &droppable_types)
+{
+	for(auto &&block: block_list)
+	{
+		block->upward->setFlowControl(droppable_types);
+		block->downward->setFlowControl(droppable_types);
+	}
+}
+
+
+void BlockManager::setMessageBatchSize(std::size_t batch_size)
+{
+	for(auto &&block: block_list)
+	{
+		block->upward->setMessageBatchSize(batch_size);
+		block->downward->setMessageBatchSize(batch_size);
+	}
 }
 
 
@@ -203,6 +378,9 @@ bool BlockManager::init(void)
 
 	// Output log
 	this->log_rt = Output::Get()->registerLog(LEVEL_WARNING, "Rt");
+	this->log_memory = Output::Get()->registerLog(LEVEL_NOTICE, "Memory");
+	this->log_graph = Output::Get()->registerLog(LEVEL_NOTICE, "Graph");
+	blockManagerSignals();
 
 	for(auto &&block: block_list)
 	{
@@ -228,8 +406,13 @@ bool BlockManager::init(void)
 		    block->getName().c_str());
 	}
 
+	// time the specific initializations to spot the slow blocks
+	auto start = std::chrono::steady_clock::now();
+	std::string slowest_block;
+	double slowest_duration = 0;
 	for(auto &&block: block_list)
 	{
+		auto block_start = std::chrono::steady_clock::now();
 		LOG(this->log_rt, LEVEL_DEBUG,
 		    "Initializing specifics of block %s.",
 		    block->getName().c_str());
@@ -245,10 +428,23 @@ bool BlockManager::init(void)
 			// report error with critical to true
 			return false;
 		}
+		double duration = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - block_start).count();
+		if(duration >= slowest_duration)
+		{
+			slowest_block = block->getName();
+			slowest_duration = duration;
+		}
 		LOG(this->log_rt, LEVEL_NOTICE,
-		    "Block %s initialized its specifics.",
-		    block->getName().c_str());
+		    "Block %s initialized its specifics in %.1f ms.",
+		    block->getName().c_str(), duration);
 	}
+	LOG(this->log_rt, LEVEL_NOTICE,
+	    "%zu blocks initialized in %.1f ms, the slowest is %s (%.1f ms).",
+	    block_list.size(),
+	    std::chrono::duration<double, std::milli>(
+	    	std::chrono::steady_clock::now() - start).count(),
+	    slowest_block.c_str(), slowest_duration);
 
 	return true;
 }
@@ -319,20 +515,26 @@ void BlockManager::wait(void)
 	sigaddset(&signal_mask, SIGINT);
 	sigaddset(&signal_mask, SIGQUIT);
 	sigaddset(&signal_mask, SIGTERM);
+	// SIGUSR1 dumps the memory accounting and the block graph and
+	// SIGUSR2 toggles the tracing, both keep running
+	sigaddset(&signal_mask, SIGUSR1);
+	sigaddset(&signal_mask, SIGUSR2);
 	fd = signalfd(-1, &signal_mask, 0);
 
-	FD_ZERO(&fds);
-	FD_SET(fd, &fds);
-
-	ret = select(fd + 1, &fds, NULL, NULL, NULL);
-	if(ret == -1 || !FD_ISSET(fd, &fds))
-	{
-		Rt::reportError("manager", std::this_thread::get_id(),
-		                true, "select error");
-		this->status = false;
-	}
-	else if(ret)
+	while(true)
 	{
+		FD_ZERO(&fds);
+		FD_SET(fd, &fds);
+
+		ret = select(fd + 1, &fds, NULL, NULL, NULL);
+		if(ret == -1 || !FD_ISSET(fd, &fds))
+		{
+			Rt::reportError("manager", std::this_thread::get_id(),
+			                true, "select error");
+			this->status = false;
+			return;
+		}
+
 		struct signalfd_siginfo fdsi;
 		auto rlen = read(fd, &fdsi, sizeof(struct signalfd_siginfo));
 		if(rlen != sizeof(struct signalfd_siginfo))
@@ -341,9 +543,77 @@ void BlockManager::wait(void)
 			                true, "cannot read signal");
 			this->status = false;
 		}
+		else if(fdsi.ssi_signo == SIGUSR1)
+		{
+			this->dumpMemory();
+			this->dumpGraph();
+			continue;
+		}
+		else if(fdsi.ssi_signo == SIGUSR2)
+		{
+			this->toggleTracing();
+			continue;
+		}
 		LOG(this->log_rt, LEVEL_INFO,
 		    "signal received: %d\n", fdsi.ssi_signo);
 		this->stop();
+		return;
+	}
+}
+
+
+void BlockManager::dumpMemory(void)
+{
+	std::vector<RtAccounting::Entry> entries = RtAccounting::getEntries();
+	LOG(this->log_memory, LEVEL_NOTICE,
+	    "memory accounting: %zu probes registered\n",
+	    Output::Get()->getProbesCount());
+	for(auto &&entry: entries)
+	{
+		LOG(this->log_memory, LEVEL_NOTICE,
+		    "memory accounting: %s: %llu %s live (%llu built)\n",
+		    entry.account.c_str(),
+		    static_cast<unsigned long long>(entry.live), entry.type.c_str(),
+		    static_cast<unsigned long long>(entry.allocated));
+	}
+}
+
+
+void BlockManager::dumpGraph(void)
+{
+	for(auto &&block: this->block_list)
+	{
+		for(RtChannelBase *channel: {block->upward, block->downward})
+		{
+			if(channel == nullptr)
+			{
+				continue;
+			}
+			float utilisation = channel->getUtilisation();
+			if(utilisation < 0)
+			{
+				LOG(this->log_graph, LEVEL_NOTICE,
+				    "block graph: %s.%s: no events statistics\n",
+				    block->getName().c_str(), channel->getType().c_str());
+			}
+			else
+			{
+				LOG(this->log_graph, LEVEL_NOTICE,
+				    "block graph: %s.%s: %.1f%% busy\n",
+				    block->getName().c_str(), channel->getType().c_str(),
+				    utilisation);
+			}
+			// the fifos are named after the channels reading them
+			for(auto &&fifo: channel->getOutputFifosState())
+			{
+				LOG(this->log_graph, LEVEL_NOTICE,
+				    "block graph: %s.%s -> %s: %zu waiting (high-water %zu), "
+				    "%zu enqueued, %zu dequeued\n",
+				    block->getName().c_str(), channel->getType().c_str(),
+				    fifo.name.c_str(), fifo.depth, fifo.high_water,
+				    fifo.enqueued, fifo.dequeued);
+			}
+		}
 	}
 }
 
@@ -359,8 +629,9 @@ void BlockManager::setupBlock(Block *block, RtChannelBase *upward, RtChannelBase
 	block->upward = upward;
 	block->downward = downward;
 
-	auto up_opp_fifo = std::shared_ptr<RtFifo>{new RtFifo()};
-	auto down_opp_fifo = std::shared_ptr<RtFifo>{new RtFifo()};
+	// each opposite fifo is named after the channel reading it
+	auto up_opp_fifo = createFifo(block->getName(), "Upward");
+	auto down_opp_fifo = createFifo(block->getName(), "Downward");
 
 	upward->setOppositeFifo(up_opp_fifo, down_opp_fifo);
 	downward->setOppositeFifo(down_opp_fifo, up_opp_fifo);
@@ -385,8 +656,14 @@ bool BlockManager::checkConnectedBlocks(const Block *upper, const Block *lower)
 }
 
 
-std::shared_ptr<RtFifo> BlockManager::createFifo()
+std::shared_ptr<RtFifo> BlockManager::createFifo(const std::string &receiver,
+                                                 const std::string &type)
 {
 	// Do we catch bad_alloc to return nullptr here?
-	return std::shared_ptr<RtFifo>{new RtFifo()};
+	std::string name = receiver;
+	if(!type.empty())
+	{
+		name += "_" + type;
+	}
+	return std::shared_ptr<RtFifo>{new RtFifo(name)};
 }
@@ -40,6 +40,8 @@
 #include <vector>
 
 #include "Block.h"
+#include "RtCapture.h"
+#include "RtTaskPool.h"
 #include "TemplateHelper.h"
 
 
@@ -57,7 +59,15 @@ class BlockManager
 	friend class Rt;
 
  public:
-	static std::shared_ptr<RtFifo> createFifo();
+	/**
+	 * @brief Create a fifo between two channels
+	 *
+	 * @param receiver  The name of the channel reading the fifo
+	 * @param type      The type of the channel reading the fifo
+	 * @return the fifo
+	 */
+	static std::shared_ptr<RtFifo> createFifo(const std::string &receiver = "",
+	                                          const std::string &type = "");
 
  protected:
 	BlockManager();
@@ -168,6 +178,18 @@ class BlockManager
 	 */
 	void stop(void);
 
+	/**
+	 * @brief Log the live objects of each type per channel and the
+	 *        number of probes, on SIGUSR1
+	 */
+	void dumpMemory(void);
+
+	/**
+	 * @brief Log the blocks with the utilisation of their channels
+	 *        and the state of the fifos they push messages in, on SIGUSR1
+	 */
+	void dumpGraph(void);
+
 	/**
 	 * @brief Initialize the manager, creates and initialize blocks
 	 *
@@ -181,6 +203,101 @@ class BlockManager
 	 */
 	bool start(void);
 
+	/**
+	 * @brief Set the placement of a block channel thread
+	 *
+	 * @param block_name  The name of the block
+	 * @param upward      Whether the upward or the downward channel is placed
+	 * @param placement   The placement of the channel thread
+	 * @return true if the block exists, false otherwise
+	 */
+	bool setThreadPlacement(const std::string &block_name, bool upward,
+	                        const rt_thread_placement_t &placement);
+
+	/**
+	 * @brief Fuse the links from a block channel to the next blocks
+	 *
+	 * @param block_name  The name of the block
+	 * @param upward      Whether the upward or the downward channel is fused
+	 *                    with the next channels
+	 * @return true if the block exists, false otherwise
+	 */
+	bool setFusedLinks(const std::string &block_name, bool upward);
+
+	/**
+	 * @brief Export the events statistics of all the channels periodically
+	 *
+	 * @param period_ms  The export period (ms), 0 to disable
+	 * @return true on success, false otherwise
+	 */
+	bool setEventsStatistics(double period_ms);
+
+	/**
+	 * @brief Read the hardware counters of all the channels threads
+	 *
+	 * @param enabled  Whether the hardware counters are read
+	 */
+	void setHardwareCounters(bool enabled);
+
+	/**
+	 * @brief Set the file the traced spans are written in
+	 *
+	 * @param filename  The JSON trace file, empty to ignore SIGUSR2
+	 */
+	void setTraceFile(const std::string &filename);
+
+	/**
+	 * @brief Start the tracing, or stop it and write the trace, on SIGUSR2
+	 */
+	void toggleTracing(void);
+
+	/**
+	 * @brief Drop the messages of some types instead of blocking
+	 *        the channels pushing them in a full fifo
+	 *
+	 * @param droppable_types  The types of the messages that can be dropped
+	 */
+	void setFlowControl(const std::vector<uint8_t> &droppable_types);
+
+	/**
+	 * @brief Set the maximum number of messages the channels
+	 *        drain from each input fifo on a single wakeup
+	 *
+	 * @param batch_size  The maximum number of messages
+	 */
+	void setMessageBatchSize(std::size_t batch_size);
+
+	/**
+	 * @brief Record the messages a block channel sends to the next block
+	 *
+	 * @param block_name  The name of the block
+	 * @param upward      Whether the upward or the downward channel is recorded
+	 * @param filename    The capture file name
+	 * @param serializer  The serialization of the messages content
+	 * @return true on success, false if the block does not exist or
+	 *         the capture cannot be created
+	 */
+	bool setCapture(const std::string &block_name, bool upward,
+	                const std::string &filename, rt_msg_serializer_t serializer);
+
+	/**
+	 * @brief Start the workers shared by the channels
+	 *        for their parallel computations
+	 *
+	 * @param workers    The number of workers
+	 * @param placement  The CPUs spread over the workers and
+	 *                   their scheduling
+	 * @return true on success, false otherwise
+	 */
+	bool startTaskPool(std::size_t workers, const rt_thread_placement_t &placement);
+
+	/**
+	 * @brief Get the workers shared by the channels
+	 *
+	 * @return the task pool
+	 */
+	RtTaskPool &getTaskPool(void);
+
 	/**
 	 * @brief Internal error report
 	 *
@@ -205,6 +322,12 @@ class BlockManager
 	/// Output Log
 	std::shared_ptr<OutputLog> log_rt;
 
+	/// Output Log of the memory accounting dumps
+	std::shared_ptr<OutputLog> log_memory;
+
+	/// Output Log of the block graph dumps
+	std::shared_ptr<OutputLog> log_graph;
+
  private:
 	void setupBlock(Block *block, RtChannelBase *upward, RtChannelBase *downward);
 
@@ -213,11 +336,17 @@ class BlockManager
 	/// list of pointers to the blocks
 	std::vector<Block *> block_list;
 
+	/// the workers shared by the channels
+	RtTaskPool task_pool;
+
 	/// check if we already tried to stop process
 	bool stopped;
 
 	/// whether a critical error was raised
 	bool status;
+
+	/// the file the traced spans are written in, empty if not traced
+	std::string trace_file;
 };
 
 
@@ -349,7 +478,7 @@ struct ChannelsConnectorBase<SenderCh, ReceiverCh, true>
 	static inline void connect(SenderCh &sender,
 	                           ReceiverCh &receiver)
 	{
-		auto fifo = BlockManager::createFifo();
+		auto fifo = BlockManager::createFifo(receiver.getName(), receiver.getType());
 		sender.setNextFifo(fifo);
 		receiver.setPreviousFifo(fifo);
 	}
@@ -362,7 +491,7 @@ struct ChannelsConnectorBase<SenderCh, ReceiverCh, false>
 	static inline void connect(SenderCh &sender,
 	                           ReceiverCh &receiver)
 	{
-		auto fifo = BlockManager::createFifo();
+		auto fifo = BlockManager::createFifo(receiver.getName(), receiver.getType());
 		sender.setNextFifo(fifo);
 		receiver.addPreviousFifo(fifo);
 	}
@@ -382,7 +511,7 @@ struct ChannelsConnector<SenderCh, ReceiverCh, true, true> : public ChannelsConn
 	                           ReceiverCh &receiver,
 	                           typename SenderCh::DemuxKey key)
 	{
-		auto fifo = BlockManager::createFifo();
+		auto fifo = BlockManager::createFifo(receiver.getName(), receiver.getType());
 		sender.addNextFifo(key, fifo);
 		receiver.setPreviousFifo(fifo);
 	}
@@ -396,7 +525,7 @@ struct ChannelsConnector<SenderCh, ReceiverCh, false, true> : public ChannelsCon
 	                           ReceiverCh &receiver,
 	                           typename SenderCh::DemuxKey key)
 	{
-		auto fifo = BlockManager::createFifo();
+		auto fifo = BlockManager::createFifo(receiver.getName(), receiver.getType());
 		sender.addNextFifo(key, fifo);
 		receiver.addPreviousFifo(fifo);
 	}
@@ -0,0 +1,226 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file BlockReplay.h
+ * @author Viveris Technologies
+ * @brief  A block sending the messages of captures to the block it is
+ *         connected to
+ *
+ */
+
+#ifndef BLOCK_REPLAY_H
+#define BLOCK_REPLAY_H
+
+#include <functional>
+#include <string>
+
+#include "Block.h"
+#include "MessageEvent.h"
+#include "RtCapture.h"
+#include "RtChannel.h"
+
+#include <opensand_output/Output.h>
+
+
+/// The configuration of a replay block
+struct rt_replay_config_t
+{
+	/// The capture replayed by the upward channel, empty for none
+	std::string upward_capture;
+	/// The capture replayed by the downward channel, empty for none
+	std::string downward_capture;
+	/// The rebuild of the captured messages
+	rt_msg_deserializer_t deserializer;
+	/// The release of the content of the messages sent by the tested block
+	std::function<void(const rt_msg_t &message)> release;
+	/// Whether the messages are sent as fast as the tested block reads
+	/// them instead of with their captured spacing
+	bool max_speed;
+};
+
+
+/**
+ * @class BlockReplay
+ * @brief Feed a single block with the messages captured at its
+ *        boundaries, to profile it in isolation with real traffic
+ *
+ * Connected above the tested block, its downward channel replays a
+ * capture of the messages the upper block sent; connected below, its
+ * upward channel replays those of the lower block. The messages the
+ * tested block sends to the replay block are released.
+ */
+class BlockReplay: public Block
+{
+ public:
+	BlockReplay(const std::string &name, rt_replay_config_t):
+		Block{name}
+	{
+	};
+
+ private:
+	/**
+	 * @class ReplayChannel
+	 * @brief A channel sending the messages of a capture
+	 */
+	template <class Base>
+	class ReplayChannel: public Base
+	{
+	 public:
+		ReplayChannel(const std::string &name,
+		              const rt_replay_config_t &config,
+		              const std::string &capture):
+			Base{name},
+			config{config},
+			capture{capture},
+			reader{},
+			record{nullptr},
+			payload{nullptr},
+			timer{-1},
+			offset{0},
+			sent{0}
+		{
+		};
+
+	 protected:
+		bool onInit(void) override
+		{
+			if(this->capture.empty())
+			{
+				return true;
+			}
+			if(!this->reader.open(this->capture))
+			{
+				return false;
+			}
+			if(!this->reader.next(this->record, this->payload))
+			{
+				this->record = nullptr;
+			}
+			this->timer = this->addTimerEvent("replay", 0, false, true);
+			return this->timer >= 0;
+		};
+
+		bool onEvent(const RtEvent *const event) override
+		{
+			if(event->getType() == EventType::Message)
+			{
+				auto message = static_cast<const MessageEvent *>(event);
+				if(this->config.release)
+				{
+					this->config.release(message->getMessage());
+				}
+				return true;
+			}
+			if(*event != this->timer)
+			{
+				return true;
+			}
+
+			// the messages keep their spacing from the first one
+			uint64_t now = RtCaptureWriter::getTime();
+			if(this->sent == 0 && this->record != nullptr)
+			{
+				this->offset = now - this->record->time_ns;
+			}
+			std::size_t batch = 0;
+			while(this->record != nullptr)
+			{
+				uint64_t due = this->record->time_ns + this->offset;
+				if(this->config.max_speed ? batch == batch_size : due > now)
+				{
+					// come back once the other events are processed
+					double delay = this->config.max_speed ? 0 : (due - now) / 1e6;
+					return this->setDuration(this->timer, delay) && this->startTimer(this->timer);
+				}
+
+				rt_msg_t message{nullptr, 0, this->record->type};
+				if(!this->config.deserializer(this->record->type, this->payload,
+				                              this->record->length, message) ||
+				   !this->enqueueMessage(&message.data, message.length, message.type))
+				{
+					LOG(this->log_receive, LEVEL_ERROR,
+					    "cannot replay message %zu of %s\n",
+					    this->sent, this->capture.c_str());
+				}
+				++this->sent;
+				++batch;
+				if(!this->reader.next(this->record, this->payload))
+				{
+					this->record = nullptr;
+				}
+			}
+			LOG(this->log_receive, LEVEL_NOTICE,
+			    "%zu messages of %s replayed\n",
+			    this->sent, this->capture.c_str());
+			return true;
+		};
+
+	 private:
+		/// the number of messages sent at once at maximum speed
+		static constexpr std::size_t batch_size = 64;
+
+		/// the block configuration
+		const rt_replay_config_t config;
+		/// the capture file name
+		const std::string capture;
+		/// the capture
+		RtCaptureReader reader;
+		/// the next message to send, nullptr once all are sent
+		const rt_capture_record_t *record;
+		const unsigned char *payload;
+		/// the timer sending the messages
+		event_id_t timer;
+		/// the time between the capture and the replay (ns)
+		uint64_t offset;
+		/// the number of messages sent
+		std::size_t sent;
+	};
+
+ public:
+	class Upward: public ReplayChannel<RtUpward>
+	{
+	 public:
+		Upward(const std::string &name, rt_replay_config_t config):
+			ReplayChannel<RtUpward>{name, config, config.upward_capture}
+		{
+		};
+	};
+
+	class Downward: public ReplayChannel<RtDownward>
+	{
+	 public:
+		Downward(const std::string &name, rt_replay_config_t config):
+			ReplayChannel<RtDownward>{name, config, config.downward_capture}
+		{
+		};
+	};
+};
+
+
+#endif
@@ -48,7 +48,8 @@ FileEvent::FileEvent(const std::string &name,
 	RtEvent{type, name, fd, priority},
 	max_size{max_size},
 	data{nullptr},
-	size{0}
+	size{0},
+	spare{nullptr}
 {
 }
 
@@ -56,6 +57,7 @@ FileEvent::FileEvent(const std::string &name,
 FileEvent::~FileEvent()
 {
 	delete [] this->data;
+	delete [] this->spare;
 }
 
 
@@ -68,8 +70,7 @@ bool FileEvent::handle(void)
 		                this->name.c_str());
 		delete [] this->data;
 	}
-	// one more byte so we can use it as char*
-	this->data = new unsigned char[this->max_size + 1]();  // parens do value initialization to 0
+	this->data = this->allocData();
 
 	int ret = read(this->fd, this->data, this->max_size);
 	std::size_t actual_size = static_cast<std::size_t>(ret);
@@ -90,15 +91,19 @@ bool FileEvent::handle(void)
 	else if(actual_size == 0)
 	{
 		// EOF
-		delete [] this->data;
+		this->releaseData(this->data);
 		this->data = nullptr;
 	}
+	else
+	{
+		this->data[actual_size] = '\0';
+	}
 	this->size = actual_size;
 
 	return true;
 
 error:
-	delete [] this->data;
+	this->releaseData(this->data);
 	this->data = nullptr;
 	return false;
 }
@@ -110,3 +115,29 @@ unsigned char *FileEvent::getData(void) const
 	this->data = nullptr;
 	return buf;
 }
+
+
+void FileEvent::releaseData(unsigned char *buffer) const
+{
+	if(this->spare == nullptr)
+	{
+		this->spare = buffer;
+	}
+	else
+	{
+		delete [] buffer;
+	}
+}
+
+
+unsigned char *FileEvent::allocData(void) const
+{
+	unsigned char *buf = this->spare;
+	this->spare = nullptr;
+	if(buf == nullptr)
+	{
+		// one more byte so we can use it as char*
+		buf = new unsigned char[this->max_size + 1];
+	}
+	return buf;
+}
@@ -72,6 +72,14 @@ class FileEvent: public RtEvent
 	 */
 	 virtual unsigned char *getData(void) const;
 
+	/**
+	 * @brief Give back a buffer obtained with getData once its content
+	 *        is not needed anymore, so the next read reuses it
+	 *
+	 * @param buffer  The buffer returned by getData on this event
+	 */
+	void releaseData(unsigned char *buffer) const;
+
 	/*
 	 * @brief Get the size of data in the message
 	 *
@@ -82,6 +90,14 @@ class FileEvent: public RtEvent
 	bool handle(void) override;
 
  protected:
+	/**
+	 * @brief Get a receive buffer of max_size + 1 bytes, the released
+	 *        one if any, without initializing it
+	 *
+	 * @return the buffer to read into
+	 */
+	unsigned char *allocData(void) const;
+
 	/// The maximum size of received data
 	std::size_t max_size;
 
@@ -90,6 +106,9 @@ class FileEvent: public RtEvent
 
 	/// data size
 	std::size_t size;
+
+	/// buffer given back by the consumer of the previous read
+	mutable unsigned char *spare;
 };
 
 
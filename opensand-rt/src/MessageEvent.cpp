@@ -33,41 +33,57 @@
  *
  */
 
+#include <algorithm>
 #include <cstring>
 
 #include "MessageEvent.h"
 #include "Rt.h"
 #include "RtFifo.h"
-#include "RtCommunicate.h"
 
 
 MessageEvent::MessageEvent(std::shared_ptr<RtFifo> &fifo,
                            const std::string &name,
                            int32_t fd,
-                           uint8_t priority):
+                           uint8_t priority,
+                           std::size_t batch_size):
 	RtEvent{EventType::Message, name, fd, priority},
+	messages(std::max<std::size_t>(batch_size, 1)),
+	count{0},
+	current{0},
+	max_depth{0},
 	fifo{fifo}
 {
 }
 
 
-bool MessageEvent::handle(void)
+void MessageEvent::setBatchSize(std::size_t batch_size)
+{
+	this->messages.resize(std::max<std::size_t>(batch_size, 1));
+	this->count = 0;
+	this->current = 0;
+}
+
+
+bool MessageEvent::isPending(void) const
+{
+	return this->fifo->getDepth() > 0;
+}
+
+
+void MessageEvent::setMessage(const rt_msg_t &message)
 {
-	// read the pipe to clear it, and check that if contains
-	// the correct signaling
-	if (!check_read(this->fd))
-	{
-		Rt::reportError(this->name, std::this_thread::get_id(), false,
-		                "pipe signaling message from previous block contain wrong data ",
-		                "[%u: %s]", errno, strerror(errno));
-		return false;
-	}
+	this->messages[0] = message;
+	this->count = 1;
+	this->current = 0;
+}
 
-	// set the event content
-	if(!this->fifo->pop(this->message))
-	{
-		return false;
-	}
 
-	return true;
+bool MessageEvent::handle(void)
+{
+	// set the event content, the fifo clears its
+	// signaling once it gets empty
+	this->current = 0;
+	this->max_depth = std::max(this->max_depth, this->fifo->getDepth());
+	this->count = this->fifo->pop(this->messages.data(), this->messages.size());
+	return this->count > 0;
 }
@@ -37,6 +37,7 @@
 #define MESSAGE_EVENT_H
 
 #include <memory>
+#include <vector>
 
 #include "RtEvent.h"
 #include "Types.h"
@@ -51,53 +52,140 @@ class RtFifo;
   */
 class MessageEvent: public RtEvent
 {
+	friend class RtChannelBase;
+
  public:
 	/**
 	 * @brief MessageEvent constructor
 	 *
-	 * @param fifo      The signaling fifo
-	 * @param name      The event name
-	 * @param fd        The file descriptor to monitor for the event
-	 * @param priority  The priority of the event
+	 * @param fifo        The signaling fifo
+	 * @param name        The event name
+	 * @param fd          The file descriptor to monitor for the event
+	 * @param priority    The priority of the event
+	 * @param batch_size  The maximum number of messages drained on each wakeup
 	 */
 	MessageEvent(std::shared_ptr<RtFifo> &fifo,
 	             const std::string &name,
 	             int32_t fd,
-	             uint8_t priority = 3);
+	             uint8_t priority = 3,
+	             std::size_t batch_size = 1);
 
 	/**
-	 * @brief Get the message
+	 * @brief Get the current message
 	 *
 	 * @return the message
 	 */
-	inline rt_msg_t getMessage() const {return this->message;};
+	inline rt_msg_t getMessage() const {return this->messages[this->current];};
 
 	/**
-	 * @brief Get the message type
+	 * @brief Get the current message type
 	 *
 	 * @return the message type
 	 */
-	inline uint8_t getMessageType() const {return this->message.type;};
+	inline uint8_t getMessageType() const {return this->messages[this->current].type;};
 
 	/**
-	 * @brief Get the message content
+	 * @brief Get the current message content
 	 *
 	 * @return the message conetnt
 	 */
-	inline void *getData() const {return this->message.data;};
+	inline void *getData() const {return this->messages[this->current].data;};
+
+	/**
+	 * @brief Take the ownership of the current message content,
+	 *        the message is then no longer available in the event
+	 *
+	 * @tparam T  The type of the message content
+	 * @return the message content
+	 */
+	template<class T>
+	std::unique_ptr<T> releaseData() const
+	{
+		void *data = this->messages[this->current].data;
+		this->messages[this->current].data = nullptr;
+		return std::unique_ptr<T>{static_cast<T *>(data)};
+	};
 	
 	/**
-	 * @brief Get the message length
+	 * @brief Get the current message length
 	 *
 	 * @return the message length
 	 */
-	inline std::size_t getLength() const {return this->message.length;};
+	inline std::size_t getLength() const {return this->messages[this->current].length;};
+
+	/**
+	 * @brief Get the number of messages drained on the last wakeup
+	 *
+	 * @return the number of messages
+	 */
+	inline std::size_t getMessageCount() const {return this->count;};
+
+	/**
+	 * @brief Select the message returned by the single message accessors
+	 *
+	 * @param index  The index of the message in the batch
+	 */
+	inline void selectMessage(std::size_t index) const {this->current = index;};
+
+	/**
+	 * @brief Iterate on the messages drained on the last wakeup
+	 *
+	 * @return the first or past-the-end message of the batch
+	 */
+	inline const rt_msg_t *begin() const {return this->messages.data();};
+	inline const rt_msg_t *end() const {return this->messages.data() + this->count;};
+
+	/**
+	 * @brief Set the maximum number of messages drained on each wakeup
+	 *
+	 * @param batch_size  The maximum number of messages, at least 1
+	 */
+	void setBatchSize(std::size_t batch_size);
+
+	/**
+	 * @brief Get the maximum number of messages found waiting in
+	 *        the fifo on a wakeup since the last reset
+	 *
+	 * @return the maximum fifo depth
+	 */
+	inline std::size_t getMaxDepth() const {return this->max_depth;};
+
+	/**
+	 * @brief Reset the maximum fifo depth
+	 */
+	inline void resetMaxDepth() {this->max_depth = 0;};
+
+	/**
+	 * @brief Check whether messages wait in the fifo, without reading
+	 *        its signaling
+	 *
+	 * @return true if the event can be handled
+	 */
+	bool isPending(void) const;
 
 	bool handle(void) override;
 
  protected:
-	/// the message
-	rt_msg_t message;
+	/**
+	 * @brief Set the event content to a message given directly by
+	 *        the channel pushing it, without going through the fifo
+	 *
+	 * @param message  The message
+	 */
+	void setMessage(const rt_msg_t &message);
+
+	/// the messages drained on the last wakeup, mutable as handlers
+	/// receiving a const event may take the ownership of their content
+	mutable std::vector<rt_msg_t> messages;
+
+	/// the number of valid messages
+	std::size_t count;
+
+	/// the message returned by the single message accessors
+	mutable std::size_t current;
+
+	/// the maximum number of messages waiting in the fifo on a wakeup
+	std::size_t max_depth;
 
 	/// the fifo
 	const std::shared_ptr<RtFifo> fifo;
@@ -56,10 +56,9 @@ bool NetSocketEvent::handle(void)
 		Rt::reportError(this->name, std::this_thread::get_id(), false,
 		                "event %s: previous data was not handled\n",
 		                this->name.c_str());
-    delete [] this->data;
+		delete [] this->data;
 	}
-	// one more byte so we can use it as char*
-	this->data = new unsigned char[this->max_size + 1]();  // parens do value initialization to 0
+	this->data = this->allocData();
 
 	socklen_t addrlen = sizeof(struct sockaddr_in);
 	int ret = recvfrom(this->fd, this->data, this->max_size, 0,
@@ -88,12 +87,13 @@ bool NetSocketEvent::handle(void)
 		                 this->name.c_str());
 		goto error;
 	}
-	this->size = ret;
+	this->data[actual_size] = '\0';
+	this->size = actual_size;
 
 	return true;
 
 error:
-	delete [] this->data;
+	this->releaseData(this->data);
 	this->data = nullptr;
 	return false;
 }
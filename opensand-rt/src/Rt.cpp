@@ -37,6 +37,7 @@
 #include <sstream>
 
 #include "Rt.h"
+#include "RtVirtualClock.h"
 
 
 // Create bloc instance
@@ -49,6 +50,86 @@ bool Rt::init(void)
 }
 
 
+bool Rt::setThreadPlacement(const std::string &block_name, bool upward,
+                            const rt_thread_placement_t &placement)
+{
+	return manager.setThreadPlacement(block_name, upward, placement);
+}
+
+
+bool Rt::setFusedLinks(const std::string &block_name, bool upward)
+{
+	return manager.setFusedLinks(block_name, upward);
+}
+
+
+bool Rt::setEventsStatistics(double period_ms)
+{
+	return manager.setEventsStatistics(period_ms);
+}
+
+
+void Rt::setHardwareCounters(bool enabled)
+{
+	manager.setHardwareCounters(enabled);
+}
+
+
+void Rt::setTraceFile(const std::string &filename)
+{
+	manager.setTraceFile(filename);
+}
+
+
+void Rt::dumpGraph(void)
+{
+	manager.dumpGraph();
+}
+
+
+void Rt::setFlowControl(const std::vector<uint8_t> &droppable_types)
+{
+	manager.setFlowControl(droppable_types);
+}
+
+
+void Rt::setMessageBatchSize(std::size_t batch_size)
+{
+	manager.setMessageBatchSize(batch_size);
+}
+
+
+bool Rt::setTaskPool(std::size_t workers, const rt_thread_placement_t &placement)
+{
+	return manager.startTaskPool(workers, placement);
+}
+
+
+RtTaskPool &Rt::getTaskPool(void)
+{
+	return manager.getTaskPool();
+}
+
+
+void Rt::setVirtualTime(void)
+{
+	RtVirtualClock::enable();
+}
+
+
+void Rt::setVirtualTimeLimit(uint64_t duration_ns)
+{
+	RtVirtualClock::setLimit(duration_ns);
+}
+
+
+bool Rt::setCapture(const std::string &block_name, bool upward,
+                    const std::string &filename, rt_msg_serializer_t serializer)
+{
+	return manager.setCapture(block_name, upward, filename, serializer);
+}
+
+
 bool Rt::run(bool init)
 {
 	if(init && !manager.init())
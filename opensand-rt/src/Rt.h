@@ -150,6 +150,145 @@ class Rt
 	template <class SenderCh, class ReceiverCh>
 	static void connectChannels(SenderCh &sender, ReceiverCh &receiver, typename SenderCh::DemuxKey key);
 
+	/**
+	 * @brief Set the placement of a block channel thread,
+	 *        applied when the blocks are started
+	 *
+	 * @param block_name  The name of the block
+	 * @param upward      Whether the upward or the downward channel is placed
+	 * @param placement   The CPU set, scheduling policy and NUMA nodes
+	 *                    of the channel thread
+	 * @return true if the block exists, false otherwise
+	 */
+	static bool setThreadPlacement(const std::string &block_name, bool upward,
+	                               const rt_thread_placement_t &placement);
+
+	/**
+	 * @brief Fuse the links from a block channel to the next blocks:
+	 *        the next channels process the messages directly in the
+	 *        thread of the block channel whenever they are idle, saving
+	 *        the fifo hop and the wakeup of their thread, that still
+	 *        handles their other events; should be called once the
+	 *        blocks are connected and before their initialization
+	 *
+	 * @param block_name  The name of the block
+	 * @param upward      Whether the upward or the downward channel sends
+	 *                    on the fused links
+	 * @return true if the block exists, false otherwise
+	 */
+	static bool setFusedLinks(const std::string &block_name, bool upward);
+
+	/**
+	 * @brief Record the processing duration and wakeup latency of the
+	 *        events of all the channels and export them periodically
+	 *        as probes, should be called before the blocks initialization
+	 *
+	 * @param period_ms  The export period (ms), 0 to disable
+	 * @return true on success, false otherwise
+	 */
+	static bool setEventsStatistics(double period_ms);
+
+	/**
+	 * @brief Export the instructions per cycle and the cache and branch
+	 *        misses of the events of all the channels, per event type,
+	 *        with the events statistics; should be called before
+	 *        setEventsStatistics
+	 *
+	 * @param enabled  Whether the hardware counters are read
+	 */
+	static void setHardwareCounters(bool enabled);
+
+	/**
+	 * @brief Set the file the traced spans are written in; SIGUSR2
+	 *        starts the tracing and the next one stops it and writes
+	 *        the trace, which is also written on exit while tracing
+	 *
+	 * @param filename  The JSON trace file, empty to ignore SIGUSR2
+	 */
+	static void setTraceFile(const std::string &filename);
+
+	/**
+	 * @brief Log the blocks with the utilisation of their channels and
+	 *        the depth, high-water mark and totals of their fifos, also
+	 *        logged on SIGUSR1; the utilisation and high-water marks
+	 *        need the events statistics
+	 */
+	static void dumpGraph(void);
+
+	/**
+	 * @brief Drop the messages of some types instead of blocking the
+	 *        channels pushing them in a full fifo, so that a slow block
+	 *        does not stall the timers and the other fifos of the blocks
+	 *        sending to it; the other messages still wait for space.
+	 *        Only the messages pushed with their ownership can be dropped.
+	 *
+	 * @param droppable_types  The types of the messages that can be dropped,
+	 *                         empty to always block
+	 */
+	static void setFlowControl(const std::vector<uint8_t> &droppable_types);
+
+	/**
+	 * @brief Set the maximum number of messages the channels of all the
+	 *        blocks drain from each of their input fifos on a single
+	 *        wakeup, should be called before the blocks initialization
+	 *        so the fifos are sized for the batches
+	 *
+	 * @param batch_size  The maximum number of messages, 1 to handle
+	 *                    one message per wakeup
+	 */
+	static void setMessageBatchSize(std::size_t batch_size);
+
+	/**
+	 * @brief Start the workers the channels share to split their
+	 *        computations in parallel tasks, see getTaskPool;
+	 *        should be called before init
+	 *
+	 * @param workers    The number of workers
+	 * @param placement  The CPUs spread one per worker, the NUMA nodes
+	 *                   of their memory and their scheduling policy
+	 * @return true on success, false otherwise
+	 */
+	static bool setTaskPool(std::size_t workers, const rt_thread_placement_t &placement);
+
+	/**
+	 * @brief Get the workers shared by the channels; without workers
+	 *        the tasks are run by the channel giving them
+	 *
+	 * @return the task pool
+	 */
+	static RtTaskPool &getTaskPool(void);
+
+	/**
+	 * @brief Drive the timers of all the channels with a simulated
+	 *        clock that jumps to the next timer expiration once all
+	 *        the channels are idle, should be called before the blocks
+	 *        creation
+	 */
+	static void setVirtualTime(void);
+
+	/**
+	 * @brief Stop the process, as with SIGTERM, once the simulated
+	 *        time would pass a duration from now instead of running
+	 *        the timers past it; only with the virtual time
+	 *
+	 * @param duration_ns  The simulated duration (ns)
+	 */
+	static void setVirtualTimeLimit(uint64_t duration_ns);
+
+	/**
+	 * @brief Record the messages a block channel sends to the next
+	 *        block in a capture file, that a BlockReplay can feed to
+	 *        the next block alone
+	 *
+	 * @param block_name  The name of the block
+	 * @param upward      Whether the upward or the downward channel is recorded
+	 * @param filename    The capture file name
+	 * @param serializer  The serialization of the messages content
+	 * @return true on success, false otherwise
+	 */
+	static bool setCapture(const std::string &block_name, bool upward,
+	                       const std::string &filename, rt_msg_serializer_t serializer);
+
 	/**
 	 * @brief Initialize the blocks
 	 *
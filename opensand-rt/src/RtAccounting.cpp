@@ -0,0 +1,217 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file RtAccounting.cpp
+ * @author Viveris Technologies
+ * @brief  The count of the live objects of each type per channel,
+ *         to attribute the memory growth of long runs
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "RtAccounting.h"
+
+
+/**
+ * @brief The counters of an account, the objects built by its threads
+ *        and the ones destroyed by any thread are kept apart so the
+ *        releases do not contend with the allocations
+ */
+class RtAccounting::Account
+{
+ public:
+	Account(const std::string &name):
+		name{name}
+	{
+		for(std::size_t type = 0; type < max_types; ++type)
+		{
+			this->allocated[type].store(0, std::memory_order_relaxed);
+			this->released[type].store(0, std::memory_order_relaxed);
+		}
+	};
+
+	const std::string name;
+	std::atomic<uint64_t> allocated[max_types];
+	/// keep the released counters on their own cache lines
+	char padding[64];
+	std::atomic<uint64_t> released[max_types];
+};
+
+
+namespace
+{
+
+/// The registered types and accounts
+struct Registry
+{
+	std::mutex mutex;
+	std::vector<std::string> types;
+	std::map<std::string, std::unique_ptr<RtAccounting::Account>> accounts;
+};
+
+
+Registry &getRegistry()
+{
+	// never destroyed as the objects may be released after the exit
+	static Registry *registry = new Registry();
+	return *registry;
+}
+
+
+/**
+ * @brief Get the account of the objects built out of any scope
+ *
+ * @return the main account
+ */
+RtAccounting::Account *getMainAccount()
+{
+	static RtAccounting::Account *account = RtAccounting::getAccount("main");
+	return account;
+}
+
+
+/// the account of the objects built by each thread, nullptr for the main one
+thread_local RtAccounting::Account *current_account = nullptr;
+
+}
+
+
+RtAccounting::Scope::Scope(Account *account):
+	previous{current_account}
+{
+	current_account = account;
+}
+
+
+RtAccounting::Scope::~Scope()
+{
+	current_account = this->previous;
+}
+
+
+std::size_t RtAccounting::registerType(const std::string &name)
+{
+	Registry &registry = getRegistry();
+	std::lock_guard<std::mutex> lock{registry.mutex};
+	auto type = std::find(registry.types.begin(), registry.types.end(), name);
+	if(type != registry.types.end())
+	{
+		return type - registry.types.begin();
+	}
+	if(registry.types.size() >= max_types)
+	{
+		return max_types;
+	}
+	registry.types.push_back(name);
+	return registry.types.size() - 1;
+}
+
+
+std::vector<std::string> RtAccounting::getTypes(void)
+{
+	Registry &registry = getRegistry();
+	std::lock_guard<std::mutex> lock{registry.mutex};
+	return registry.types;
+}
+
+
+RtAccounting::Account *RtAccounting::getAccount(const std::string &name)
+{
+	Registry &registry = getRegistry();
+	std::lock_guard<std::mutex> lock{registry.mutex};
+	std::unique_ptr<Account> &account = registry.accounts[name];
+	if(!account)
+	{
+		account.reset(new Account(name));
+	}
+	return account.get();
+}
+
+
+RtAccounting::Account *RtAccounting::acquire(std::size_t type) noexcept
+{
+	if(type >= max_types)
+	{
+		return nullptr;
+	}
+	Account *account = current_account != nullptr ? current_account : getMainAccount();
+	account->allocated[type].fetch_add(1, std::memory_order_relaxed);
+	return account;
+}
+
+
+void RtAccounting::release(Account *account, std::size_t type) noexcept
+{
+	if(account == nullptr)
+	{
+		return;
+	}
+	account->released[type].fetch_add(1, std::memory_order_relaxed);
+}
+
+
+uint64_t RtAccounting::getLive(const Account *account, std::size_t type)
+{
+	if(account == nullptr || type >= max_types)
+	{
+		return 0;
+	}
+	// an object is released after being counted, read in the opposite order
+	uint64_t released = account->released[type].load(std::memory_order_relaxed);
+	uint64_t allocated = account->allocated[type].load(std::memory_order_relaxed);
+	return allocated > released ? allocated - released : 0;
+}
+
+
+std::vector<RtAccounting::Entry> RtAccounting::getEntries(void)
+{
+	std::vector<Entry> entries;
+	Registry &registry = getRegistry();
+	std::lock_guard<std::mutex> lock{registry.mutex};
+	for(auto &&account_pair: registry.accounts)
+	{
+		const Account *account = account_pair.second.get();
+		for(std::size_t type = 0; type < registry.types.size(); ++type)
+		{
+			uint64_t allocated = account->allocated[type].load(std::memory_order_relaxed);
+			if(allocated == 0)
+			{
+				continue;
+			}
+			entries.push_back({account->name, registry.types[type],
+			                   allocated, getLive(account, type)});
+		}
+	}
+	return entries;
+}
@@ -0,0 +1,200 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file RtAccounting.h
+ * @author Viveris Technologies
+ * @brief  The count of the live objects of each type per channel,
+ *         to attribute the memory growth of long runs
+ *
+ */
+
+#ifndef RT_ACCOUNTING_H
+#define RT_ACCOUNTING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/**
+ * @class RtAccounting
+ * @brief Count the objects built and destroyed per type and per account
+ *
+ * Each channel owns an account, applied with a Scope by its thread and
+ * by the threads processing its messages or initializing it; the objects
+ * built by the other threads are counted in the "main" account. An
+ * object is counted in the account active when it is built and
+ * released from the same account by any thread, so the live objects of
+ * an account are the ones its channel built and nobody destroyed yet.
+ * The accounts are never destroyed as the objects may outlive them.
+ */
+class RtAccounting
+{
+ public:
+	/// The maximum number of types counted, the next ones are ignored
+	static constexpr std::size_t max_types{16};
+
+	class Account;
+
+	/**
+	 * @class Scope
+	 * @brief Count the objects built by the calling thread in an
+	 *        account until the scope is left
+	 */
+	class Scope
+	{
+	 public:
+		Scope(Account *account);
+		~Scope();
+
+	 private:
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+		Account *previous;
+	};
+
+	/// The counters of a type in an account
+	struct Entry
+	{
+		std::string account;
+		std::string type;
+		/// the objects built since the start
+		uint64_t allocated;
+		/// the objects not destroyed yet
+		uint64_t live;
+	};
+
+	/**
+	 * @brief Register a type of counted objects
+	 *
+	 * @param name  The type name, registering it again gives the same type
+	 * @return the type index, max_types if too many types are registered
+	 */
+	static std::size_t registerType(const std::string &name);
+
+	/**
+	 * @brief Get the names of the registered types, by index
+	 *
+	 * @return the names of the types
+	 */
+	static std::vector<std::string> getTypes(void);
+
+	/**
+	 * @brief Get an account, creating it if needed
+	 *
+	 * @param name  The account name
+	 * @return the account
+	 */
+	static Account *getAccount(const std::string &name);
+
+	/**
+	 * @brief Count an object built by the calling thread
+	 *
+	 * @param type  The object type
+	 * @return the account the object is counted in, to release it
+	 */
+	static Account *acquire(std::size_t type) noexcept;
+
+	/**
+	 * @brief Count an object destroyed by any thread
+	 *
+	 * @param account  The account returned when the object was built
+	 * @param type     The object type
+	 */
+	static void release(Account *account, std::size_t type) noexcept;
+
+	/**
+	 * @brief Get the number of live objects of a type in an account
+	 *
+	 * @param account  The account
+	 * @param type     The object type
+	 * @return the number of objects not destroyed yet
+	 */
+	static uint64_t getLive(const Account *account, std::size_t type);
+
+	/**
+	 * @brief Get the counters of all the accounts, for a dump
+	 *
+	 * @return the counters of the types with objects built in each account
+	 */
+	static std::vector<Entry> getEntries(void);
+};
+
+
+/**
+ * @class RtAccounted
+ * @brief Member counting the live objects of a class, named by its
+ *        accounting_name constant
+ *
+ * A copy is a new object, an assignment keeps the account of the
+ * assigned object.
+ */
+template<class T>
+class RtAccounted
+{
+ public:
+	RtAccounted():
+		account{RtAccounting::acquire(getType())}
+	{
+	};
+
+	RtAccounted(const RtAccounted &):
+		RtAccounted()
+	{
+	};
+
+	RtAccounted &operator =(const RtAccounted &)
+	{
+		return *this;
+	};
+
+	~RtAccounted()
+	{
+		RtAccounting::release(this->account, getType());
+	};
+
+	/**
+	 * @brief Get the type counting the objects of the class
+	 *
+	 * @return the type index
+	 */
+	static std::size_t getType(void)
+	{
+		static const std::size_t type = RtAccounting::registerType(T::accounting_name);
+		return type;
+	};
+
+ private:
+	RtAccounting::Account *account;
+};
+
+
+#endif
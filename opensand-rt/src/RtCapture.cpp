@@ -0,0 +1,299 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file RtCapture.cpp
+ * @author Viveris Technologies
+ * @brief  The capture files of the messages sent by a channel
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#include "RtCapture.h"
+#include "RtVirtualClock.h"
+#include "Rt.h"
+
+
+/// The magic number at the start of the capture files
+static const char capture_magic[8] = {'O', 'S', 'N', 'D', 'R', 'C', '0', '1'};
+
+/// The records alignment
+static const std::size_t capture_alignment = 8;
+
+/// The minimum growth of a capture file
+static const std::size_t capture_chunk = 4 << 20;
+
+
+/**
+ * @brief Get the offset of the next record
+ */
+static inline std::size_t alignLength(std::size_t length)
+{
+	return (length + capture_alignment - 1) & ~(capture_alignment - 1);
+}
+
+
+RtCaptureWriter::RtCaptureWriter(rt_msg_serializer_t serializer):
+	serializer{serializer},
+	payload{},
+	fd{-1},
+	memory{nullptr},
+	mapped{0},
+	used{0}
+{
+}
+
+
+RtCaptureWriter::~RtCaptureWriter()
+{
+	this->close();
+}
+
+
+uint64_t RtCaptureWriter::getTime(void)
+{
+	if(RtVirtualClock::isEnabled())
+	{
+		return RtVirtualClock::getTime();
+	}
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+
+bool RtCaptureWriter::open(const std::string &filename)
+{
+	this->close();
+	this->fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if(this->fd < 0)
+	{
+		Rt::reportError("capture", std::this_thread::get_id(), false,
+		                "cannot create capture %s [%d: %s]\n",
+		                filename.c_str(), errno, strerror(errno));
+		return false;
+	}
+
+	if(!this->reserve(sizeof(capture_magic)))
+	{
+		this->close();
+		return false;
+	}
+	memcpy(this->memory, capture_magic, sizeof(capture_magic));
+	this->used = sizeof(capture_magic);
+	return true;
+}
+
+
+bool RtCaptureWriter::reserve(std::size_t length)
+{
+	if(this->used + length <= this->mapped)
+	{
+		return true;
+	}
+
+	std::size_t size = std::max(this->used + length, this->mapped + std::max(this->mapped, capture_chunk));
+	if(this->memory != nullptr)
+	{
+		munmap(this->memory, this->mapped);
+		this->memory = nullptr;
+		this->mapped = 0;
+	}
+	void *memory = MAP_FAILED;
+	if(ftruncate(this->fd, size) == 0)
+	{
+		memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+	}
+	if(memory == MAP_FAILED)
+	{
+		Rt::reportError("capture", std::this_thread::get_id(), false,
+		                "cannot grow capture to %zu bytes [%d: %s]\n",
+		                size, errno, strerror(errno));
+		return false;
+	}
+	this->memory = static_cast<unsigned char *>(memory);
+	this->mapped = size;
+	return true;
+}
+
+
+bool RtCaptureWriter::record(const rt_msg_t &message)
+{
+	if(this->fd < 0)
+	{
+		return false;
+	}
+
+	this->payload.clear();
+	if(!this->serializer(message, this->payload))
+	{
+		return false;
+	}
+
+	rt_capture_record_t record{};
+	record.time_ns = getTime();
+	record.length = this->payload.size();
+	record.type = message.type;
+	std::size_t length = alignLength(sizeof(record) + this->payload.size());
+	if(!this->reserve(length))
+	{
+		// the capture cannot be completed, keep what was recorded
+		this->close();
+		return false;
+	}
+
+	unsigned char *position = this->memory + this->used;
+	memcpy(position, &record, sizeof(record));
+	memcpy(position + sizeof(record), this->payload.data(), this->payload.size());
+	memset(position + sizeof(record) + this->payload.size(), 0,
+	       length - sizeof(record) - this->payload.size());
+	this->used += length;
+	return true;
+}
+
+
+void RtCaptureWriter::close(void)
+{
+	if(this->memory != nullptr)
+	{
+		munmap(this->memory, this->mapped);
+		this->memory = nullptr;
+		this->mapped = 0;
+	}
+	if(this->fd >= 0)
+	{
+		if(ftruncate(this->fd, this->used) != 0)
+		{
+			Rt::reportError("capture", std::this_thread::get_id(), false,
+			                "cannot truncate capture [%d: %s]\n",
+			                errno, strerror(errno));
+		}
+		::close(this->fd);
+		this->fd = -1;
+	}
+	this->used = 0;
+}
+
+
+RtCaptureReader::RtCaptureReader():
+	memory{nullptr},
+	length{0},
+	position{0}
+{
+}
+
+
+RtCaptureReader::~RtCaptureReader()
+{
+	if(this->memory != nullptr)
+	{
+		munmap(const_cast<unsigned char *>(this->memory), this->length);
+	}
+}
+
+
+bool RtCaptureReader::open(const std::string &filename)
+{
+	int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+	{
+		Rt::reportError("capture", std::this_thread::get_id(), false,
+		                "cannot open capture %s [%d: %s]\n",
+		                filename.c_str(), errno, strerror(errno));
+		return false;
+	}
+
+	struct stat status;
+	void *memory = MAP_FAILED;
+	if(fstat(fd, &status) == 0 &&
+	   static_cast<std::size_t>(status.st_size) >= sizeof(capture_magic))
+	{
+		memory = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	::close(fd);
+	if(memory == MAP_FAILED)
+	{
+		Rt::reportError("capture", std::this_thread::get_id(), false,
+		                "cannot map capture %s\n", filename.c_str());
+		return false;
+	}
+	if(memcmp(memory, capture_magic, sizeof(capture_magic)) != 0)
+	{
+		munmap(memory, status.st_size);
+		Rt::reportError("capture", std::this_thread::get_id(), false,
+		                "%s is not a capture\n", filename.c_str());
+		return false;
+	}
+
+	if(this->memory != nullptr)
+	{
+		munmap(const_cast<unsigned char *>(this->memory), this->length);
+	}
+	this->memory = static_cast<const unsigned char *>(memory);
+	this->length = status.st_size;
+	this->rewind();
+	return true;
+}
+
+
+bool RtCaptureReader::next(const rt_capture_record_t *&record, const unsigned char *&payload)
+{
+	if(this->memory == nullptr ||
+	   this->length - this->position < sizeof(rt_capture_record_t))
+	{
+		return false;
+	}
+
+	record = reinterpret_cast<const rt_capture_record_t *>(this->memory + this->position);
+	if(record->time_ns == 0 ||
+	   record->length > this->length - this->position - sizeof(rt_capture_record_t))
+	{
+		// the capture was interrupted before the file was truncated,
+		// the rest of it was never written
+		return false;
+	}
+	payload = this->memory + this->position + sizeof(rt_capture_record_t);
+	this->position = std::min(this->length,
+	                          alignLength(this->position + sizeof(rt_capture_record_t) + record->length));
+	return true;
+}
+
+
+void RtCaptureReader::rewind(void)
+{
+	this->position = sizeof(capture_magic);
+}
@@ -0,0 +1,216 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file RtCapture.h
+ * @author Viveris Technologies
+ * @brief  The capture files of the messages sent by a channel
+ *
+ */
+
+#ifndef RT_CAPTURE_H
+#define RT_CAPTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+
+
+/**
+ * @brief The header of a captured message, in host byte order
+ *
+ * It is followed by the serialized message, padded to 8 bytes.
+ */
+struct rt_capture_record_t
+{
+	/// the time the message was sent (ns)
+	uint64_t time_ns;
+	/// the length of the serialized message
+	uint32_t length;
+	/// the message type
+	uint8_t type;
+	uint8_t padding[3];
+} __attribute__((__packed__));
+
+
+/**
+ * @brief Serialize the content of a message, which is left untouched
+ *
+ * @param message  The message
+ * @param payload  OUT: the serialized content
+ * @return true on success, false if the message cannot be captured
+ */
+using rt_msg_serializer_t = std::function<bool(const rt_msg_t &message,
+                                               std::vector<unsigned char> &payload)>;
+
+/**
+ * @brief Rebuild a message from its serialized content
+ *
+ * @param type     The message type
+ * @param payload  The serialized content
+ * @param length   The length of the serialized content
+ * @param message  OUT: the message, owning its new content
+ * @return true on success, false otherwise
+ */
+using rt_msg_deserializer_t = std::function<bool(uint8_t type,
+                                                 const unsigned char *payload,
+                                                 std::size_t length,
+                                                 rt_msg_t &message)>;
+
+
+/**
+ * @class RtCaptureWriter
+ * @brief Append the messages sent by a channel to a capture file
+ *
+ * The file is mapped in memory and grown by chunks, so recording a
+ * message is a copy of its serialized content without system call.
+ */
+class RtCaptureWriter
+{
+ public:
+	/**
+	 * @brief Create a capture writer
+	 *
+	 * @param serializer  The serialization of the messages content
+	 */
+	RtCaptureWriter(rt_msg_serializer_t serializer);
+	~RtCaptureWriter();
+
+	RtCaptureWriter(const RtCaptureWriter &) = delete;
+	RtCaptureWriter &operator=(const RtCaptureWriter &) = delete;
+
+	/**
+	 * @brief Create the capture file, an existing one is replaced
+	 *
+	 * @param filename  The file name
+	 * @return true on success, false otherwise
+	 */
+	bool open(const std::string &filename);
+
+	/**
+	 * @brief Append a message to the capture
+	 *
+	 * @param message  The message, it is not modified
+	 * @return true on success, false otherwise
+	 */
+	bool record(const rt_msg_t &message);
+
+	/**
+	 * @brief Truncate the file to the captured messages and close it
+	 */
+	void close(void);
+
+	/**
+	 * @brief Get the capture time, simulated in virtual time mode
+	 *
+	 * @return the current time (ns)
+	 */
+	static uint64_t getTime(void);
+
+ private:
+	/**
+	 * @brief Make room in the mapping for some bytes
+	 *
+	 * @param length  The number of bytes
+	 * @return true on success, false otherwise
+	 */
+	bool reserve(std::size_t length);
+
+	/// the serialization of the messages content
+	rt_msg_serializer_t serializer;
+
+	/// the buffer reused to serialize the messages
+	std::vector<unsigned char> payload;
+
+	/// the capture file descriptor, -1 if closed
+	int fd;
+
+	/// the mapping of the file
+	unsigned char *memory;
+
+	/// the length of the file and of its mapping
+	std::size_t mapped;
+
+	/// the length of the captured messages
+	std::size_t used;
+};
+
+
+/**
+ * @class RtCaptureReader
+ * @brief Read the messages of a capture file mapped in memory
+ */
+class RtCaptureReader
+{
+ public:
+	RtCaptureReader();
+	~RtCaptureReader();
+
+	RtCaptureReader(const RtCaptureReader &) = delete;
+	RtCaptureReader &operator=(const RtCaptureReader &) = delete;
+
+	/**
+	 * @brief Map a capture file
+	 *
+	 * @param filename  The file name
+	 * @return true on success, false otherwise
+	 */
+	bool open(const std::string &filename);
+
+	/**
+	 * @brief Get the next captured message
+	 *
+	 * @param record   OUT: the header of the message
+	 * @param payload  OUT: the serialized content, valid while the
+	 *                 reader is open
+	 * @return true on success, false at the end of the capture
+	 */
+	bool next(const rt_capture_record_t *&record, const unsigned char *&payload);
+
+	/**
+	 * @brief Go back to the first captured message
+	 */
+	void rewind(void);
+
+ private:
+	/// the mapping of the file, nullptr if closed
+	const unsigned char *memory;
+
+	/// the length of the file
+	std::size_t length;
+
+	/// the offset of the next message
+	std::size_t position;
+};
+
+
+#endif
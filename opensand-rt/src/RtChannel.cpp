@@ -61,7 +61,14 @@ void RtChannel::setPreviousFifo(std::shared_ptr<RtFifo> &fifo)
 };
 
 
+bool RtChannel::isNextCongested(void) const
+{
+	return this->isCongested(this->next_fifo);
+}
+
+
 void RtChannel::setNextFifo(std::shared_ptr<RtFifo> &fifo)
 {
 	this->next_fifo = fifo;
+	this->addOutputFifo(fifo);
 };
@@ -59,6 +59,22 @@ class RtChannel: public RtChannelBase
 	 */
 	bool enqueueMessage(void **data, size_t size, uint8_t type);
 
+	/**
+	 * @brief Add a message in the next channel fifo,
+	 *        the ownership of the message is moved to the next channel
+	 *        and the message is released if it cannot be enqueued
+	 *
+	 * @param data  The message to enqueue
+	 * @param size  The size of data in message
+	 * @param type  The type of message
+	 * @return true on success, false otherwise
+	 */
+	template<class T>
+	bool enqueueMessage(std::unique_ptr<T> data, size_t size, uint8_t type)
+	{
+		return this->pushMessage(this->next_fifo, std::move(data), size, type);
+	};
+
 	/**
 	 * @brief Set the fifo of the previous channel
 	 *
@@ -66,6 +82,14 @@ class RtChannel: public RtChannelBase
 	 */
 	void setPreviousFifo(std::shared_ptr<RtFifo> &fifo);
 
+	/**
+	 * @brief Check whether the next channel fifo is full,
+	 *        a message enqueued in it would wait or be dropped
+	 *
+	 * @return true if the next channel is congested
+	 */
+	bool isNextCongested(void) const;
+
 	/**
 	 * @brief Set the fifo of the next channel
 	 *
@@ -35,6 +35,7 @@
 
 #include <unistd.h>
 #include <signal.h>
+#include <algorithm>
 #include <cstring>
 
 #include <opensand_output/Output.h>
@@ -48,12 +49,10 @@
 #include "SignalEvent.h"
 #include "TcpListenEvent.h"
 #include "TimerEvent.h"
-#include "RtCommunicate.h"
-
-#ifdef TIME_REPORTS
-	#include <numeric>
-	#include <algorithm>
-#endif
+#include "RtTimerWheel.h"
+#include "RtVirtualClock.h"
+#include "RtPerfCounters.h"
+#include "RtTrace.h"
 
 
 // TODO pointer on onEventUp/Down
@@ -64,25 +63,47 @@ RtChannelBase::RtChannelBase(const std::string &name, const std::string &type):
 	log_send{nullptr},
 	channel_name{name},
 	channel_type{type},
+	account{RtAccounting::getAccount(name + "." + type)},
 	block_initialized{false},
+	timers{new RtTimerWheel()},
 	in_opp_fifo{nullptr},
 	out_opp_fifo{nullptr},
-	max_input_fd{-1},
-	stop_fd{-1},
-	w_sel_break{-1},
-	r_sel_break{-1}
+	poller{RtPoller::create(PollerType::Epoll)},
+	message_batch_size{1},
+	ready_queue{},
+	low_priority{UINT8_MAX},
+	low_priority_budget{0},
+	busy_poll_budget{0},
+	polled_events{},
+	busy_poll_time{0},
+	busy_poll_sleeps{0},
+	capture{nullptr},
+	busy_poll_time_probe{nullptr},
+	busy_poll_sleeps_probe{nullptr},
+	idle_time{0},
+	last_export{},
+	utilisation{-1},
+	busy_time_probe{nullptr},
+	idle_time_probe{nullptr},
+	utilisation_probe{nullptr},
+	stop_requested{false},
+	events_probes{},
+	hardware_counters{false},
+	perf_counters{nullptr},
+	perf_probes{},
+	memory_probes{},
+	output_fifos{},
+	droppable_types{},
+	stats_timer{-1},
+	fused_inputs{false},
+	processing_mutex{},
+	processing_thread{}
 {
-	FD_ZERO(&(this->input_fd_set));
 }
 
 
 RtChannelBase::~RtChannelBase()
 {
-	close(this->w_sel_break);
-	close(this->r_sel_break);
-#ifdef TIME_REPORTS
-	this->getDurationsStatistics();
-#endif
 }
 
 
@@ -111,26 +132,31 @@ bool RtChannelBase::init(void)
 	LOG(this->log_init, LEVEL_INFO,
 	    "Starting initialization\n");
 
-	// pipe used to break select when a new event is received
-	int32_t pipefd[2];
-	if(pipe(pipefd) != 0)
+	if(!this->poller)
+	{
+		this->reportError(true, "cannot initialize poller\n");
+		return false;
+	}
+	LOG(this->log_init, LEVEL_INFO,
+	    "Events are monitored with %s\n",
+	    this->poller->getType() == PollerType::Epoll ? "epoll" : "select");
+
+	// all the timers are driven by the timer wheel file descriptor
+	if(this->timers->getFd() < 0 || !this->poller->addEvent(this->timers.get()))
 	{
-		this->reportError(true, "cannot initialize pipe\n");
+		this->reportError(true, "cannot initialize timers [%u: %s]\n",
+		                  errno, strerror(errno));
 		return false;
 	}
-	this->r_sel_break = pipefd[0];
-	this->w_sel_break = pipefd[1];
-	this->addInputFd(this->r_sel_break);
 
-	// create the signal mask for stop (highest priority)
-	sigset_t signal_mask;
-	sigemptyset(&signal_mask);
-	sigaddset(&signal_mask, SIGINT);
-	sigaddset(&signal_mask, SIGQUIT);
-	sigaddset(&signal_mask, SIGTERM);
-  this->stop_fd = this->addSignalEvent("stop", signal_mask, 0);
+	// the stop signals are only read by the block manager, which
+	// stops the loops through the poller wake up
 
 	// initialize fifos and create associated messages
+	if(this->in_opp_fifo)
+	{
+		this->in_opp_fifo->reserve(2 * this->message_batch_size);
+	}
 	if(!this->in_opp_fifo || !this->in_opp_fifo->init())
 	{
 		this->reportError(true, "cannot initialize opposite fifo\n");
@@ -151,6 +177,411 @@ bool RtChannelBase::init(void)
 }
 
 
+bool RtChannelBase::setPollerType(PollerType type)
+{
+	if(!this->events.empty() || !this->new_events.empty())
+	{
+		// events are already registered in the current poller
+		return false;
+	}
+	this->poller = RtPoller::create(type);
+	return this->poller != nullptr && this->poller->getType() == type;
+}
+
+
+void RtChannelBase::setMessageBatchSize(std::size_t batch_size)
+{
+	this->message_batch_size = std::max<std::size_t>(batch_size, 1);
+
+	// update the message events that are already created
+	for(auto &&event_pair: this->events)
+	{
+		if(event_pair.second->getType() == EventType::Message)
+		{
+			static_cast<MessageEvent *>(event_pair.second.get())->setBatchSize(this->message_batch_size);
+		}
+	}
+	for(auto &&event: this->new_events)
+	{
+		if(event->getType() == EventType::Message)
+		{
+			static_cast<MessageEvent *>(event.get())->setBatchSize(this->message_batch_size);
+		}
+	}
+}
+
+
+void RtChannelBase::setLowPriorityBudget(uint8_t priority, std::size_t count)
+{
+	this->low_priority = priority;
+	this->low_priority_budget = count;
+}
+
+
+void RtChannelBase::setBusyPoll(double budget_us)
+{
+	this->busy_poll_budget = std::chrono::nanoseconds(static_cast<int64_t>(std::max(budget_us, 0.0) * 1000));
+	if(this->stats_timer >= 0)
+	{
+		this->registerBusyPollProbes();
+	}
+}
+
+
+bool RtChannelBase::setCapture(const std::string &filename, rt_msg_serializer_t serializer)
+{
+	this->capture.reset(new RtCaptureWriter(serializer));
+	if(!this->capture->open(filename))
+	{
+		this->capture.reset();
+		return false;
+	}
+	return true;
+}
+
+
+void RtChannelBase::setHardwareCounters(bool enabled)
+{
+	this->hardware_counters = enabled;
+	if(this->stats_timer >= 0)
+	{
+		this->registerPerfProbes();
+	}
+}
+
+
+bool RtChannelBase::setEventsStatistics(double period_ms)
+{
+	if(this->stats_timer >= 0)
+	{
+		this->removeEvent(this->stats_timer);
+		this->stats_timer = -1;
+	}
+	if(period_ms <= 0)
+	{
+		return true;
+	}
+
+	// processed last so it does not delay the other events
+	this->stats_timer = this->addTimerEvent("rt_events_statistics", period_ms,
+	                                        true, true, UINT8_MAX);
+	if(this->stats_timer < 0)
+	{
+		return false;
+	}
+
+	// the fifos are given when the blocks are connected, before
+	for(auto &&output: this->output_fifos)
+	{
+		auto output_log = Output::Get();
+		const char *channel = this->channel_name.c_str();
+		const char *type = this->channel_type.c_str();
+		const char *fifo = output.fifo->getName().c_str();
+		if(!output.depth_max)
+		{
+			output.depth_max = output_log->registerProbe<int32_t>("messages", true, SAMPLE_LAST,
+			                                                      "Runtime.%s.%s.fifo_%s.depth_max", channel, type, fifo);
+			output.dropped = output_log->registerProbe<int32_t>("messages", true, SAMPLE_SUM,
+			                                                    "Runtime.%s.%s.fifo_%s.dropped", channel, type, fifo);
+			output.depth = output_log->registerProbe<int32_t>("messages", true, SAMPLE_LAST,
+			                                                  "Runtime.%s.%s.fifo_%s.depth", channel, type, fifo);
+			output.high_water = output_log->registerProbe<int32_t>("messages", true, SAMPLE_LAST,
+			                                                       "Runtime.%s.%s.fifo_%s.high_water", channel, type, fifo);
+			output.enqueue_rate = output_log->registerProbe<float>("messages/s", true, SAMPLE_LAST,
+			                                                       "Runtime.%s.%s.fifo_%s.enqueue_rate", channel, type, fifo);
+			output.dequeue_rate = output_log->registerProbe<float>("messages/s", true, SAMPLE_LAST,
+			                                                       "Runtime.%s.%s.fifo_%s.dequeue_rate", channel, type, fifo);
+		}
+		output.last_enqueued = output.fifo->getEnqueued();
+		output.last_dequeued = output.fifo->getDequeued();
+	}
+
+	if(!this->busy_time_probe)
+	{
+		auto output = Output::Get();
+		const char *channel = this->channel_name.c_str();
+		const char *type = this->channel_type.c_str();
+		this->busy_time_probe = output->registerProbe<int32_t>("us", true, SAMPLE_LAST,
+		                                                       "Runtime.%s.%s.busy_time", channel, type);
+		this->idle_time_probe = output->registerProbe<int32_t>("us", true, SAMPLE_LAST,
+		                                                       "Runtime.%s.%s.idle_time", channel, type);
+		this->utilisation_probe = output->registerProbe<float>("%", true, SAMPLE_LAST,
+		                                                       "Runtime.%s.%s.utilisation", channel, type);
+	}
+	this->idle_time = std::chrono::nanoseconds(0);
+	this->last_export = std::chrono::steady_clock::now();
+
+	this->registerBusyPollProbes();
+	this->registerPerfProbes();
+	this->registerMemoryProbes();
+
+	// register the probes of the events that are already created
+	for(auto &&event_pair: this->events)
+	{
+		this->registerEventsProbes(event_pair.second->getName(),
+		                           event_pair.second->getType() == EventType::Message);
+	}
+	for(auto &&event: this->new_events)
+	{
+		if(*event != this->stats_timer)
+		{
+			this->registerEventsProbes(event->getName(),
+			                           event->getType() == EventType::Message);
+		}
+	}
+	return true;
+}
+
+
+void RtChannelBase::registerEventsProbes(const std::string &event_name, bool message)
+{
+	if(this->events_probes.find(event_name) != this->events_probes.end())
+	{
+		return;
+	}
+
+	auto output = Output::Get();
+	const char *channel = this->channel_name.c_str();
+	const char *type = this->channel_type.c_str();
+	const char *name = event_name.c_str();
+	events_probes_t probes;
+	probes.count = output->registerProbe<int32_t>("", true, SAMPLE_LAST,
+	                                              "Runtime.%s.%s.%s.count", channel, type, name);
+	probes.handle_p50 = output->registerProbe<int32_t>("us", true, SAMPLE_LAST,
+	                                                   "Runtime.%s.%s.%s.handle_p50", channel, type, name);
+	probes.handle_p99 = output->registerProbe<int32_t>("us", true, SAMPLE_LAST,
+	                                                   "Runtime.%s.%s.%s.handle_p99", channel, type, name);
+	probes.handle_max = output->registerProbe<int32_t>("us", true, SAMPLE_LAST,
+	                                                   "Runtime.%s.%s.%s.handle_max", channel, type, name);
+	probes.latency_p50 = output->registerProbe<int32_t>("us", true, SAMPLE_LAST,
+	                                                    "Runtime.%s.%s.%s.latency_p50", channel, type, name);
+	probes.latency_p99 = output->registerProbe<int32_t>("us", true, SAMPLE_LAST,
+	                                                    "Runtime.%s.%s.%s.latency_p99", channel, type, name);
+	probes.latency_max = output->registerProbe<int32_t>("us", true, SAMPLE_LAST,
+	                                                    "Runtime.%s.%s.%s.latency_max", channel, type, name);
+	if(message)
+	{
+		probes.depth_max = output->registerProbe<int32_t>("messages", true, SAMPLE_LAST,
+		                                                  "Runtime.%s.%s.%s.depth_max", channel, type, name);
+	}
+	this->events_probes[event_name] = probes;
+}
+
+
+void RtChannelBase::registerBusyPollProbes(void)
+{
+	if(this->busy_poll_budget.count() <= 0 || this->busy_poll_time_probe)
+	{
+		return;
+	}
+
+	auto output = Output::Get();
+	const char *channel = this->channel_name.c_str();
+	const char *type = this->channel_type.c_str();
+	this->busy_poll_time_probe = output->registerProbe<int32_t>("us", true, SAMPLE_LAST,
+	                                                            "Runtime.%s.%s.busy_poll.spin_time", channel, type);
+	this->busy_poll_sleeps_probe = output->registerProbe<int32_t>("", true, SAMPLE_LAST,
+	                                                              "Runtime.%s.%s.busy_poll.sleeps", channel, type);
+}
+
+
+void RtChannelBase::registerPerfProbes(void)
+{
+	if(!this->hardware_counters || !this->perf_probes.empty())
+	{
+		return;
+	}
+
+	auto output = Output::Get();
+	const char *channel = this->channel_name.c_str();
+	const char *type = this->channel_type.c_str();
+	for(std::size_t event_type = 0; event_type < RtPerfCounters::event_types_count; event_type++)
+	{
+		const char *name = RtPerfCounters::getTypeName(static_cast<EventType>(event_type));
+		perf_probes_t probes;
+		probes.ipc = output->registerProbe<float>("", true, SAMPLE_LAST,
+		                                          "Runtime.%s.%s.perf.%s.ipc", channel, type, name);
+		probes.cache_misses = output->registerProbe<float>("misses/event", true, SAMPLE_LAST,
+		                                                   "Runtime.%s.%s.perf.%s.cache_misses", channel, type, name);
+		probes.branch_misses = output->registerProbe<float>("misses/event", true, SAMPLE_LAST,
+		                                                    "Runtime.%s.%s.perf.%s.branch_misses", channel, type, name);
+		this->perf_probes.push_back(probes);
+	}
+}
+
+
+void RtChannelBase::registerMemoryProbes(void)
+{
+	std::vector<std::string> types = RtAccounting::getTypes();
+	auto output = Output::Get();
+	const char *channel = this->channel_name.c_str();
+	const char *type = this->channel_type.c_str();
+	for(std::size_t index = this->memory_probes.size(); index < types.size(); index++)
+	{
+		this->memory_probes.push_back(output->registerProbe<int32_t>("objects", true, SAMPLE_LAST,
+		                                                             "Runtime.%s.%s.memory.%s",
+		                                                             channel, type, types[index].c_str()));
+	}
+}
+
+
+void RtChannelBase::exportEventsStatistics(void)
+{
+	// events sharing a name are exported together
+	std::map<std::string, RtHistogram> handle_times;
+	std::map<std::string, RtHistogram> latencies;
+	std::map<std::string, std::size_t> depths;
+	for(auto &&event_pair: this->events)
+	{
+		RtEvent *event = event_pair.second.get();
+		if(*event == this->stats_timer)
+		{
+			continue;
+		}
+		handle_times[event->getName()].merge(event->getHandleTimes());
+		latencies[event->getName()].merge(event->getLatencies());
+		event->resetHistograms();
+		if(event->getType() == EventType::Message)
+		{
+			auto message = static_cast<MessageEvent *>(event);
+			std::size_t &depth = depths[event->getName()];
+			depth = std::max(depth, message->getMaxDepth());
+			message->resetMaxDepth();
+		}
+	}
+
+	static const auto put = [](std::shared_ptr<Probe<int32_t>> &probe, int64_t value)
+	{
+		if(probe)
+		{
+			probe->put(value);
+		}
+	};
+	put(this->busy_poll_time_probe,
+	    std::chrono::duration_cast<std::chrono::microseconds>(this->busy_poll_time).count());
+	put(this->busy_poll_sleeps_probe, this->busy_poll_sleeps);
+	this->busy_poll_time = std::chrono::nanoseconds(0);
+	this->busy_poll_sleeps = 0;
+
+	// the time not spent waiting for events is spent handling them
+	const auto now = std::chrono::steady_clock::now();
+	const std::chrono::duration<double> elapsed = now - this->last_export;
+	const auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+	const auto busy_time = elapsed_ns - std::min(this->idle_time, elapsed_ns);
+	if(elapsed_ns.count() > 0)
+	{
+		this->utilisation.store(100.0 * busy_time.count() / elapsed_ns.count(),
+		                        std::memory_order_relaxed);
+		if(this->utilisation_probe)
+		{
+			this->utilisation_probe->put(this->utilisation.load(std::memory_order_relaxed));
+		}
+	}
+	put(this->busy_time_probe,
+	    std::chrono::duration_cast<std::chrono::microseconds>(busy_time).count());
+	put(this->idle_time_probe,
+	    std::chrono::duration_cast<std::chrono::microseconds>(elapsed_ns - busy_time).count());
+	this->idle_time = std::chrono::nanoseconds(0);
+	this->last_export = now;
+
+	for(auto &&output: this->output_fifos)
+	{
+		RtFifo &fifo = *output.fifo;
+		if(fifo.push_max_depth > fifo.high_water.load(std::memory_order_relaxed))
+		{
+			fifo.high_water.store(fifo.push_max_depth, std::memory_order_relaxed);
+		}
+		put(output.depth_max, fifo.push_max_depth);
+		put(output.dropped, fifo.dropped);
+		put(output.depth, fifo.getDepth());
+		put(output.high_water, fifo.getHighWater());
+		fifo.push_max_depth = 0;
+		fifo.dropped = 0;
+
+		const std::size_t enqueued = fifo.getEnqueued();
+		const std::size_t dequeued = fifo.getDequeued();
+		// the dequeued total is read from another thread, it may lag
+		const std::size_t last_dequeued = std::min(output.last_dequeued, dequeued);
+		if(elapsed.count() > 0 && output.enqueue_rate)
+		{
+			output.enqueue_rate->put((enqueued - output.last_enqueued) / elapsed.count());
+			output.dequeue_rate->put((dequeued - last_dequeued) / elapsed.count());
+		}
+		output.last_enqueued = enqueued;
+		output.last_dequeued = dequeued;
+	}
+	for(auto &&handle_pair: handle_times)
+	{
+		const std::string &name = handle_pair.first;
+		const RtHistogram &handle = handle_pair.second;
+		const RtHistogram &latency = latencies[name];
+
+		// probes of events created after the initialization are
+		// only exported if the output configuration is updated
+		auto depth = depths.find(name);
+		this->registerEventsProbes(name, depth != depths.end());
+		events_probes_t &probes = this->events_probes[name];
+		put(probes.count, handle.getCount());
+		put(probes.handle_p50, handle.getPercentile(50));
+		put(probes.handle_p99, handle.getPercentile(99));
+		put(probes.handle_max, handle.getMax());
+		put(probes.latency_p50, latency.getPercentile(50));
+		put(probes.latency_p99, latency.getPercentile(99));
+		put(probes.latency_max, latency.getMax());
+		if(depth != depths.end())
+		{
+			put(probes.depth_max, depth->second);
+		}
+	}
+
+	if(this->perf_counters)
+	{
+		for(std::size_t event_type = 0; event_type < this->perf_probes.size(); event_type++)
+		{
+			const RtPerfCounters::totals_t &totals =
+				this->perf_counters->getTotals(static_cast<EventType>(event_type));
+			if(totals.events == 0)
+			{
+				continue;
+			}
+			perf_probes_t &probes = this->perf_probes[event_type];
+			const auto &values = totals.values;
+			float events = totals.events;
+			if(values[RtPerfCounters::Cycles] > 0)
+			{
+				probes.ipc->put(static_cast<float>(values[RtPerfCounters::Instructions]) /
+				                values[RtPerfCounters::Cycles]);
+			}
+			probes.cache_misses->put(values[RtPerfCounters::CacheMisses] / events);
+			probes.branch_misses->put(values[RtPerfCounters::BranchMisses] / events);
+		}
+		this->perf_counters->reset();
+	}
+
+	// the types counted since the last export are added
+	this->registerMemoryProbes();
+	for(std::size_t type = 0; type < this->memory_probes.size(); type++)
+	{
+		put(this->memory_probes[type], RtAccounting::getLive(this->account, type));
+	}
+}
+
+
+bool RtChannelBase::onMessageBatch(const MessageEvent *const event)
+{
+	bool success = true;
+	for(std::size_t index = 0; index < event->getMessageCount(); ++index)
+	{
+		event->selectMessage(index);
+		if(!this->onEvent(event))
+		{
+			success = false;
+		}
+	}
+	return success;
+}
+
+
 void RtChannelBase::setIsBlockInitialized(bool initialized)
 {
 	this->block_initialized = initialized;
@@ -166,7 +597,8 @@ int32_t RtChannelBase::addTimerEvent(const std::string &name,
 	std::unique_ptr<TimerEvent> event;
 
 	try {
-		event.reset(new TimerEvent(name, duration_ms, auto_rearm, start, priority));
+		event.reset(new TimerEvent(*this->timers, name, duration_ms,
+		                           auto_rearm, start, priority));
 	} catch (std::bad_alloc&) {
 		this->reportError(true, "cannot create timer event\n");
 		return -1;
@@ -182,6 +614,27 @@ int32_t RtChannelBase::addTimerEvent(const std::string &name,
 }
 
 
+int32_t RtChannelBase::addAlignedTimerEvent(const std::string &name,
+                                            double duration_ms,
+                                            uint8_t priority)
+{
+	int32_t event_id = this->addTimerEvent(name, duration_ms, true, false, priority);
+	if(event_id < 0)
+	{
+		return -1;
+	}
+
+	TimerEvent *timer = this->getTimer(event_id);
+	if(timer == nullptr)
+	{
+		return -1;
+	}
+	timer->setAligned(true);
+	timer->start();
+	return event_id;
+}
+
+
 int32_t RtChannelBase::addTcpListenEvent(const std::string &name,
                                          int32_t fd,
                                          size_t max_size,
@@ -277,9 +730,9 @@ int32_t RtChannelBase::addSignalEvent(const std::string &name,
 }
 
 
-bool RtChannelBase::addMessageEvent(std::shared_ptr<RtFifo> &out_fifo,
-                                    uint8_t priority,
-                                    bool opposite)
+MessageEvent *RtChannelBase::addMessageEvent(std::shared_ptr<RtFifo> &out_fifo,
+                                             uint8_t priority,
+                                             bool opposite)
 {
 	std::string name = this->channel_type;
 	std::transform(name.begin(), name.end(), name.begin(), ::tolower);
@@ -291,13 +744,19 @@ bool RtChannelBase::addMessageEvent(std::shared_ptr<RtFifo> &out_fifo,
 	std::unique_ptr<MessageEvent> event;
   
   try {
-    event.reset(new MessageEvent(out_fifo, name, out_fifo->getSigFd(), priority));
+    event.reset(new MessageEvent(out_fifo, name, out_fifo->getSigFd(),
+                                 priority, this->message_batch_size));
   } catch (std::bad_alloc&) {
 		this->reportError(true, "cannot create message event\n");
-		return false;
+		return nullptr;
   }
 
-	return this->addEvent(std::move(event));
+	MessageEvent *message_event = event.get();
+	if(!this->addEvent(std::move(event)))
+	{
+		return nullptr;
+	}
+	return message_event;
 }
 
 
@@ -308,19 +767,25 @@ bool RtChannelBase::addEvent(std::unique_ptr<RtEvent> event)
 		this->reportError(true, "duplicated fd\n");
 		return false;
 	}
-	this->new_events.push_back(std::move(event));
 
-	// break the select loop
-	if (!check_write(this->w_sel_break))
+	// the event is monitored right now, its address remains
+	// valid when it is moved in the events map, timers are
+	// driven by the timer wheel instead
+	if(event->getType() != EventType::Timer &&
+	   (!this->poller || !this->poller->addEvent(event.get())))
 	{
-		LOG(this->log_rt, LEVEL_ERROR,
-		    "failed to break select upon a new "
-		    "event reception\n");
+		this->reportError(true, "cannot monitor event \"%s\" [%u: %s]\n",
+		                  event->getName().c_str(), errno, strerror(errno));
+		return false;
 	}
 
-#ifdef TIME_REPORTS
-	this->durations[event->getName()] = std::vector<double>();
-#endif
+	if(this->stats_timer >= 0)
+	{
+		this->registerEventsProbes(event->getName(),
+		                           event->getType() == EventType::Message);
+	}
+
+	this->new_events.push_back(std::move(event));
 
 	return true;
 }
@@ -328,13 +793,14 @@ bool RtChannelBase::addEvent(std::unique_ptr<RtEvent> event)
 
 void RtChannelBase::updateEvents(void)
 {
+	bool updated = !this->new_events.empty() || !this->removed_events.empty();
+
 	// add new events
 	for(auto &&new_event: new_events)
 	{
 		LOG(this->log_rt, LEVEL_INFO,
 		    "Add new event \"%s\" in list\n",
 		    new_event->getName().c_str());
-		this->addInputFd(new_event->getFd());
 		this->events[new_event->getFd()] = std::move(new_event);
 	}
 	this->new_events.clear();
@@ -348,34 +814,78 @@ void RtChannelBase::updateEvents(void)
 			LOG(this->log_rt, LEVEL_INFO,
 			    "Remove event \"%s\" from list\n",
 			    it->second->getName().c_str());
-			// remove fd from set
-			FD_CLR(it->first, &(this->input_fd_set));
-			if(it->first == this->max_input_fd)
-			{
-				this->updateMaxFd();
-			}
+			// the event may still wait to be processed
+			this->ready_queue.remove(it->second.get());
 			// remove fd from map
 			this->events.erase(it);
 		}
 	}
 	this->removed_events.clear();
+
+	if(updated)
+	{
+		this->polled_events.clear();
+		for(auto &&event_pair: this->events)
+		{
+			if(event_pair.second->getType() == EventType::Message)
+			{
+				this->polled_events.push_back(static_cast<MessageEvent *>(event_pair.second.get()));
+			}
+		}
+	}
 }
 
 
-void RtChannelBase::updateMaxFd(void)
+void RtChannelBase::requestStop(void)
 {
-	this->max_input_fd = 0;
-	// update the greater fd
-	for(auto &&event: events)
+	this->stop_requested = true;
+	if(this->poller && !this->poller->wakeUp())
 	{
-		if(event.first > this->max_input_fd)
+		this->reportError(false, "cannot wake up the channel to stop it [%u: %s]\n",
+		                  errno, strerror(errno));
+	}
+}
+
+
+bool RtChannelBase::busyPoll(std::vector<RtEvent *> &ready)
+{
+	// number of spins between two checks of the other file descriptors
+	static const unsigned int poller_period = 64;
+
+	const time_point_t start = std::chrono::high_resolution_clock::now();
+	time_point_t now = start;
+	unsigned int spins = 0;
+	do
+	{
+		for(auto &&event: this->polled_events)
+		{
+			if(event->isPending())
+			{
+				ready.push_back(event);
+			}
+		}
+		if(this->timers->isDue())
+		{
+			ready.push_back(this->timers.get());
+		}
+		if(ready.empty() && ++spins % poller_period == 0)
 		{
-			this->max_input_fd = event.first;
+			this->poller->wait(ready, false);
 		}
+		now = std::chrono::high_resolution_clock::now();
 	}
+	while(ready.empty() && now - start < this->busy_poll_budget);
 
+	this->busy_poll_time += now - start;
+	if(ready.empty())
+	{
+		++this->busy_poll_sleeps;
+		return false;
+	}
+	return true;
 }
 
+
 TimerEvent *RtChannelBase::getTimer(event_id_t id)
 {
 	RtEvent *event = nullptr;
@@ -461,82 +971,190 @@ bool RtChannelBase::raiseTimer(event_id_t id)
 }
 
 
-void RtChannelBase::addInputFd(int32_t fd)
+void RtChannelBase::removeEvent(event_id_t id)
 {
-	if(fd > this->max_input_fd)
+	// stop monitoring now, the event is released in the next loop
+	if(this->poller)
 	{
-		this->max_input_fd = fd;
+		this->poller->removeEvent(id);
 	}
-	FD_SET(fd, &(this->input_fd_set));
+	this->removed_events.push_back(id);
+	// a flow waiting for the event is never resumed
+	this->event_flows.erase(id);
 }
 
 
-void RtChannelBase::removeEvent(event_id_t id)
+bool RtChannelBase::suspendUntilEvent(event_id_t id,
+                                      std::function<void(const RtEvent *)> continuation)
 {
-	this->removed_events.push_back(id);
+	return this->event_flows.emplace(id, std::move(continuation)).second;
+}
+
+
+bool RtChannelBase::suspendUntilMessage(uint8_t type,
+                                        std::function<void(const MessageEvent *)> continuation)
+{
+	return this->message_flows.emplace(type, std::move(continuation)).second;
+}
+
+
+bool RtChannelBase::resumeFlow(const RtEvent *event)
+{
+	auto flow = this->event_flows.find(event->getFd());
+	if(flow == this->event_flows.end())
+	{
+		return false;
+	}
+	// the flow may suspend again on the same event
+	auto continuation = std::move(flow->second);
+	this->event_flows.erase(flow);
+	continuation(event);
+	return true;
+}
+
+
+bool RtChannelBase::resumeMessageFlows(const MessageEvent *event)
+{
+	bool success = true;
+	for(std::size_t index = 0; index < event->getMessageCount(); ++index)
+	{
+		event->selectMessage(index);
+		auto flow = this->message_flows.find(event->getMessageType());
+		if(flow == this->message_flows.end())
+		{
+			if(!this->onEvent(event))
+			{
+				success = false;
+			}
+			continue;
+		}
+		auto continuation = std::move(flow->second);
+		this->message_flows.erase(flow);
+		continuation(event);
+	}
+	return success;
 }
 
 
 void RtChannelBase::executeThread(void)
 {
 	int32_t number_fd;
-	int32_t handled;
-	fd_set readfds;
 
-	std::vector<RtEvent *> priority_sorted_events;
+	std::vector<RtEvent *> ready_events;
+
+	RtAccounting::Scope accounting{this->account};
+	RtTrace::setThreadName(this->channel_name + "." + this->channel_type);
+
+	// the previous channels of fused links only process their messages
+	// while the channel sleeps
+	std::unique_lock<std::mutex> processing{this->processing_mutex, std::defer_lock};
+	if(this->fused_inputs)
+	{
+		processing.lock();
+		this->processing_thread = std::this_thread::get_id();
+	}
+
+	// the counters are opened by the thread they measure
+	if(this->hardware_counters && this->stats_timer >= 0)
+	{
+		this->perf_counters.reset(new RtPerfCounters());
+		if(!this->perf_counters->open())
+		{
+			LOG(this->log_rt, LEVEL_WARNING,
+			    "cannot open the hardware counters, they are disabled: %s\n",
+			    strerror(errno));
+			this->perf_counters.reset();
+		}
+	}
+	RtPerfCounters *counters = this->perf_counters.get();
 
 	while(true)
 	{
-		handled = 0;
-		
 		// get the new events for the next loop
 		this->updateEvents();
-		readfds = this->input_fd_set;
 
-		// wait for any event
-		// we need a timeout in order to refresh event list
-		number_fd = select(this->max_input_fd + 1, &readfds, NULL, NULL, NULL);
+		// wait for any event, unless some are left from the last iteration
+		// or are found while spinning
+		ready_events.clear();
+		bool statistics = this->stats_timer >= 0;
+		std::chrono::steady_clock::time_point wait_start;
+		if(statistics)
+		{
+			wait_start = std::chrono::steady_clock::now();
+		}
+		bool block = this->ready_queue.empty();
+		bool virtual_time = RtVirtualClock::isEnabled();
+		if(block && this->busy_poll_budget.count() > 0 && !virtual_time)
+		{
+			block = !this->busyPoll(ready_events);
+		}
+		if(block && virtual_time)
+		{
+			RtVirtualClock::idle(this->timers.get());
+		}
+		if(this->stop_requested)
+		{
+			// the wake up may have been read while spinning,
+			// so check before sleeping
+			LOG(this->log_rt, LEVEL_INFO,
+			    "stop requested\n");
+			return;
+		}
+		if(block && this->fused_inputs)
+		{
+			this->processing_thread = std::thread::id();
+			processing.unlock();
+		}
+		number_fd = this->poller->wait(ready_events, block);
+		if(block && this->fused_inputs)
+		{
+			processing.lock();
+			this->processing_thread = std::this_thread::get_id();
+		}
+		if(block && virtual_time)
+		{
+			RtVirtualClock::busy(this->timers.get());
+		}
 		if(number_fd < 0)
 		{
-			this->reportError(true, "select failed: [%u: %s]\n", errno, strerror(errno));
+			this->reportError(true, "poll failed: [%u: %s]\n", errno, strerror(errno));
 		}
-		// unfortunately, FD_ISSET is the only usable thing
-		priority_sorted_events.clear();
 
-		// check for select break
-		if(FD_ISSET(this->r_sel_break, &readfds))
+		// replace the timer wheel by all the timers that expired, it may
+		// be found both while spinning and by the poller
+		auto wheel = std::remove(ready_events.begin(), ready_events.end(), this->timers.get());
+		if(wheel != ready_events.end())
 		{
-			if (!check_read(this->r_sel_break))
+			ready_events.erase(wheel, ready_events.end());
+			if(!this->timers->handle())
 			{
-				LOG(this->log_rt, LEVEL_ERROR,
-				    "failed to read in pipe");
+				this->reportError(false, "unable to handle timers\n");
 			}
-			handled++;
+			const auto &expired = this->timers->getExpiredTimers();
+			ready_events.insert(ready_events.end(), expired.begin(), expired.end());
+		}
+		time_point_t wakeup;
+		if(statistics)
+		{
+			wakeup = std::chrono::high_resolution_clock::now();
+			this->idle_time += std::chrono::steady_clock::now() - wait_start;
 		}
 
-		// handle each event
-		for(auto &&event_pair: events)
+		// handle each ready event
+		for(auto &&event: ready_events)
 		{
-			RtEvent *event = event_pair.second.get();
-			if(handled >= number_fd)
-			{
-				// all events treated, no need to continue the loop
-				break;
-			}
-			// if this event FD has raised
-			if(!FD_ISSET(event->getFd(), &readfds))
+			if(this->ready_queue.contains(event))
 			{
+				// still waiting from the last iteration, it is handled
+				// again once processed
 				continue;
 			}
-			handled++;
-
-			// fd is set
 			if(!event->handle())
 			{
 				if(event->getType() == EventType::Signal)
 				{
 					// this is the only case where it is critical as
-					// stop event is a signal
+					// a signal is not delivered again
 					this->reportError(true, "unable to handle signal event\n");
 					return;
 				}
@@ -544,35 +1162,69 @@ void RtChannelBase::executeThread(void)
 				// ignore this event
 				continue;
 			}
-			priority_sorted_events.push_back(event);
-			if(*event == this->stop_fd)
-			{
-				// we have to stop
-				LOG(this->log_rt, LEVEL_INFO,
-				    "stop signal received\n");
-				return;
-			}
+			this->ready_queue.push(event);
 		}
-		// sort the list according to priority
-		static const auto eventSorter = [](const RtEvent* e1, const RtEvent* e2) { return (*e1) < (*e2); };
-		std::sort(priority_sorted_events.begin(), priority_sorted_events.end(), eventSorter);
 
-		// call processEvent on each event
-		for(auto &&event: priority_sorted_events)
+		// call processEvent on each event, by priority
+		std::size_t low_priority_count = 0;
+		RtEvent *event;
+		while((event = this->ready_queue.front()) != nullptr)
 		{
-			event->setTriggerTime();
+			if(event->getPriority() >= this->low_priority &&
+			   this->low_priority_budget > 0 &&
+			   low_priority_count++ >= this->low_priority_budget)
+			{
+				// the remaining events are processed on the next iteration
+				break;
+			}
+			this->ready_queue.pop();
+			if(statistics && *event == this->stats_timer)
+			{
+				this->exportEventsStatistics();
+				continue;
+			}
+			if(statistics)
+			{
+				event->startProcessing(wakeup);
+				if(counters)
+				{
+					counters->start();
+				}
+			}
+			else
+			{
+				event->setTriggerTime();
+			}
 			LOG(this->log_rt, LEVEL_DEBUG, "event received (%s)",
 			    event->getName().c_str());
-			if(!this->onEvent(event))
+			RtTrace::Span span{event->getTraceName()};
+			// the suspended flows are only looked up when there are some
+			bool success = true;
+			if(event->getType() == EventType::Message)
+			{
+				auto message = static_cast<MessageEvent *>(event);
+				success = this->message_flows.empty() ?
+				          this->onMessageBatch(message) :
+				          this->resumeMessageFlows(message);
+			}
+			else if(this->event_flows.empty() || !this->resumeFlow(event))
+			{
+				success = this->onEvent(event);
+			}
+			if(!success)
 			{
 				LOG(this->log_rt, LEVEL_ERROR,
 				    "failed to process event %s\n",
 				    event->getName().c_str());
 			}
-#ifdef TIME_REPORTS
-			time_val_t time = (*iter)->getTimeFromTrigger();
-			this->durations[(*iter)->getName()].push_back(time);
-#endif
+			if(statistics)
+			{
+				if(counters)
+				{
+					counters->stop(event->getType());
+				}
+				event->endProcessing();
+			}
 		}
 	}
 }
@@ -595,6 +1247,71 @@ void RtChannelBase::setOppositeFifo(std::shared_ptr<RtFifo> &in_fifo, std::share
 {
 	this->in_opp_fifo = in_fifo;
 	this->out_opp_fifo = out_fifo;
+	this->addOutputFifo(out_fifo);
+}
+
+
+void RtChannelBase::addOutputFifo(std::shared_ptr<RtFifo> &fifo)
+{
+	this->output_fifos.push_back({fifo, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, 0, 0});
+}
+
+
+void RtChannelBase::setFlowControl(const std::vector<uint8_t> &droppable_types)
+{
+	this->droppable_types.reset();
+	for(auto &&type: droppable_types)
+	{
+		this->droppable_types.set(type);
+	}
+}
+
+
+bool RtChannelBase::isCongested(const std::shared_ptr<RtFifo> &fifo) const
+{
+	return fifo != nullptr && fifo->isFull();
+}
+
+
+bool RtChannelBase::isOppositeCongested(void) const
+{
+	return this->isCongested(this->out_opp_fifo);
+}
+
+
+std::vector<RtChannelBase::fifo_state_t> RtChannelBase::getOutputFifosState(void) const
+{
+	std::vector<fifo_state_t> states;
+	for(auto &&output: this->output_fifos)
+	{
+		const RtFifo &fifo = *output.fifo;
+		states.push_back({fifo.getName(), fifo.getDepth(), fifo.getHighWater(),
+		                  fifo.getEnqueued(), fifo.getDequeued()});
+	}
+	return states;
+}
+
+
+float RtChannelBase::getUtilisation(void) const
+{
+	return this->utilisation.load(std::memory_order_relaxed);
+}
+
+
+bool RtChannelBase::dropMessage(std::shared_ptr<RtFifo> &fifo, uint8_t type)
+{
+	// only this channel pushes in the fifo, it cannot fill up meanwhile
+	if(!this->droppable_types.test(type) || !this->isCongested(fifo))
+	{
+		return false;
+	}
+	if(fifo->dropped++ == 0)
+	{
+		LOG(this->log_send, LEVEL_WARNING,
+		    "fifo %s is full, dropping the messages of type %u",
+		    fifo->getName().c_str(), type);
+	}
+	return true;
 }
 
 
@@ -602,16 +1319,28 @@ bool RtChannelBase::initSingleFifo(std::shared_ptr<RtFifo> &fifo)
 {
 	if (fifo)
 	{
+		// the producer fills a batch while the previous one is handled
+		fifo->reserve(2 * this->message_batch_size);
 		if (!fifo->init())
 		{
 			this->reportError(true, "cannot initialize previous fifo\n");
 			return false;
 		}
-		if (!this->addMessageEvent(fifo))
+		MessageEvent *event = this->addMessageEvent(fifo);
+		if (!event)
 		{
 			this->reportError(true, "cannot create previous message event\n");
 			return false;
 		}
+		if (fifo->fused)
+		{
+			LOG(this->log_init, LEVEL_NOTICE,
+			    "messages of fifo %s processed in the thread of the previous channel\n",
+			    fifo->getName().c_str());
+			fifo->fused_event = event;
+			fifo->fused_receiver = this;
+			this->fused_inputs = true;
+		}
 	}
 	return true;
 }
@@ -638,42 +1367,89 @@ bool RtChannelBase::pushMessage(std::shared_ptr<RtFifo> &out_fifo, void **data,
 		//       initialization when threads are started
 	}
 
+	if(this->capture && out_fifo != this->out_opp_fifo &&
+	   !this->capture->record({*data, size, type}))
+	{
+		LOG(this->log_send, LEVEL_DEBUG,
+		    "message of type %u not captured\n", type);
+	}
+
+	// only this channel writes the total, counted before the consumer
+	// may see the message so that the dequeued ones never exceed it
+	out_fifo->enqueued.store(out_fifo->enqueued.load(std::memory_order_relaxed) + 1,
+	                         std::memory_order_relaxed);
+
+	if(out_fifo->fused_receiver != nullptr &&
+	   out_fifo->fused_receiver->processFusedMessage(*out_fifo, {*data, size, type}))
+	{
+		*data = nullptr;
+		return true;
+	}
+
 	if(!out_fifo->push(*data, size, type))
 	{
 		this->reportError(false, "cannot push data in fifo for next block\n");
+		out_fifo->enqueued.store(out_fifo->enqueued.load(std::memory_order_relaxed) - 1,
+		                         std::memory_order_relaxed);
 		success = false;
 	}
+	else if(this->stats_timer >= 0)
+	{
+		out_fifo->push_max_depth = std::max(out_fifo->push_max_depth,
+		                                    out_fifo->getDepth());
+	}
 
 	// be sure that the pointer won't be used anymore
 	*data = nullptr;
 	return success;
 }
 
-#ifdef TIME_REPORTS
-void RtChannelBase::getDurationsStatistics(void) const
+
+void RtChannelBase::fuseNextChannels(void)
 {
-  std::shared_ptr<OutputEvent> event = Output::Get()->registerEvent("Time Report");
-	for(auto &&duration_pair: durations)
+	for(auto &&output: this->output_fifos)
 	{
-		std::vector<double> duration = duration_pair.second;
-		if(duration.empty())
+		if(output.fifo != this->out_opp_fifo)
 		{
-			continue;
+			output.fifo->fused = true;
 		}
-		double sum = std::accumulate(duration.begin(),
-		                             duration.end(), 0.0);
-		double max = *std::max_element(duration.begin(),
-		                               duration.end());
-		double min = *std::min_element(duration.begin(),
-		                               duration.end());
-		double mean = sum / duration.size();
+	}
+}
+
+
+bool RtChannelBase::processFusedMessage(RtFifo &fifo, const rt_msg_t &message)
+{
+	if(!this->block_initialized ||
+	   this->processing_thread.load() == std::this_thread::get_id())
+	{
+		return false;
+	}
 
-		Output::Get()->sendEvent(event,
-		                  "[%s:%s] Event %s: mean = %.2f us, max = %d us, "
-		                  "min = %d us, total = %.2f ms\n",
-		                  this->channel_name.c_str(),
-		                  this->channel_type.c_str(),
-		                  duration_pair.first.c_str(), mean, int(max), int(min), sum / 1000);
+	std::unique_lock<std::mutex> processing{this->processing_mutex, std::try_to_lock};
+	MessageEvent *event = fifo.fused_event;
+	if(!processing.owns_lock() || fifo.getDepth() > 0 ||
+	   this->ready_queue.contains(event))
+	{
+		// the channel is busy or older messages wait for it,
+		// its thread processes the message in order
+		return false;
 	}
+
+	this->processing_thread = std::this_thread::get_id();
+	RtAccounting::Scope accounting{this->account};
+	event->setMessage(message);
+	event->setTriggerTime();
+	LOG(this->log_rt, LEVEL_DEBUG, "fused event received (%s)",
+	    event->getName().c_str());
+	bool success = this->message_flows.empty() ?
+	               this->onMessageBatch(event) :
+	               this->resumeMessageFlows(event);
+	if(!success)
+	{
+		LOG(this->log_rt, LEVEL_ERROR,
+		    "failed to process event %s\n",
+		    event->getName().c_str());
+	}
+	this->processing_thread = std::thread::id();
+	return true;
 }
-#endif
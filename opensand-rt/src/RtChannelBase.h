@@ -37,23 +37,34 @@
 #ifndef RT_CHANNEL_BASE_H
 #define RT_CHANNEL_BASE_H
 
+#include <atomic>
+#include <bitset>
+#include <functional>
 #include <string>
 #include <map>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <memory>
 
 #include "Types.h"
 #include "TimerEvent.h"
+#include "RtCapture.h"
+#include "RtPoller.h"
+#include "RtReadyQueue.h"
+#include "RtAccounting.h"
 
 
 class Block;
 class RtFifo;
 class RtEvent;
+class MessageEvent;
 class OutputLog;
+class RtTimerWheel;
+class RtPerfCounters;
+template<typename T> class Probe;
 
 
-//#define TIME_REPORTS
-
 /**
  * @class RtChannelBase
  * @brief Base for all channel classes
@@ -105,6 +116,16 @@ class RtChannelBase
 	 */
 	virtual bool onEvent(const RtEvent *const event) = 0;
 
+	/**
+	 * @brief Process the messages drained from a fifo on one wakeup
+	 *        The default implementation calls onEvent for each message,
+	 *        channels can override it to process the whole batch at once
+	 *
+	 * @param event  The message event, iterable on its messages
+	 * @return true on success, false otherwise
+	 */
+	virtual bool onMessageBatch(const MessageEvent *const event);
+
  public:
 	/**
 	 * @brief Get the channel name
@@ -112,6 +133,130 @@ class RtChannelBase
 	 * @return channel name
 	 */
 	std::string getName() { return this->channel_name; }
+
+	/**
+	 * @brief Get the channel type
+	 *
+	 * @return channel type (Upward or Downward)
+	 */
+	std::string getType() { return this->channel_type; }
+
+	/**
+	 * @brief Select the poller used by the channel event loop
+	 *        Should be called before the channel initialization
+	 *
+	 * @param type  The poller type
+	 * @return true on success, false otherwise
+	 */
+	bool setPollerType(PollerType type);
+
+	/**
+	 * @brief Set the maximum number of messages drained from
+	 *        each input fifo on a single wakeup, the input fifos
+	 *        are grown to hold two batches on their initialization
+	 *
+	 * @param batch_size  The maximum number of messages, at least 1
+	 */
+	void setMessageBatchSize(std::size_t batch_size);
+
+	/**
+	 * @brief Limit the number of low priority events processed on each
+	 *        loop iteration so they cannot delay the high priority ones,
+	 *        the other ready events are kept for the next iteration
+	 *
+	 * @param priority  The priority from which an event is limited
+	 * @param count     The maximum number of limited events processed
+	 *                  per iteration, 0 for no limit
+	 */
+	void setLowPriorityBudget(uint8_t priority, std::size_t count);
+
+	/**
+	 * @brief Spin on the input fifos and the timers for some time
+	 *        before sleeping in the poller when no event is ready,
+	 *        trading CPU time, best spent on an isolated core, for
+	 *        the wakeup latency
+	 *        The other file descriptors are only checked from time
+	 *        to time while spinning
+	 *
+	 * @param budget_us  The spinning time (us), 0 to always sleep
+	 */
+	void setBusyPoll(double budget_us);
+
+	/**
+	 * @brief Record the messages sent to the next blocks in a capture
+	 *        file, that can be replayed by a BlockReplay
+	 *
+	 * @param filename    The capture file name
+	 * @param serializer  The serialization of the messages content
+	 * @return true on success, false otherwise
+	 */
+	bool setCapture(const std::string &filename, rt_msg_serializer_t serializer);
+
+	/**
+	 * @brief Record the processing duration and wakeup latency of
+	 *        the channel events and export them periodically as probes
+	 *        Should be called before the channel initialization so
+	 *        the probes are registered with the output configuration
+	 *
+	 * @param period_ms  The export period (ms), 0 to disable
+	 * @return true on success, false otherwise
+	 */
+	bool setEventsStatistics(double period_ms);
+
+	/**
+	 * @brief Read the hardware counters of the channel thread around the
+	 *        processing of the events and export the instructions per
+	 *        cycle and the misses per event type with the events
+	 *        statistics; the counters are disabled if they cannot be
+	 *        opened by the thread.
+	 *        Should be called before setEventsStatistics
+	 *
+	 * @param enabled  Whether the hardware counters are read
+	 */
+	void setHardwareCounters(bool enabled);
+
+	/**
+	 * @brief Drop the messages of some types pushed with their ownership
+	 *        in a full fifo instead of waiting for space
+	 *
+	 * @param droppable_types  The types of the messages that can be dropped
+	 */
+	void setFlowControl(const std::vector<uint8_t> &droppable_types);
+
+	/**
+	 * @brief Check whether the fifo to the opposite channel is full,
+	 *        a message pushed in it would wait or be dropped
+	 *
+	 * @return true if the opposite channel is congested
+	 */
+	bool isOppositeCongested(void) const;
+
+	/// The state of a fifo this channel pushes messages in
+	struct fifo_state_t
+	{
+		std::string name;
+		std::size_t depth;
+		std::size_t high_water;
+		std::size_t enqueued;
+		std::size_t dequeued;
+	};
+
+	/**
+	 * @brief Get the state of the fifos this channel pushes messages in,
+	 *        can be called from another thread once the blocks are connected
+	 *
+	 * @return the state of each output fifo
+	 */
+	std::vector<fifo_state_t> getOutputFifosState(void) const;
+
+	/**
+	 * @brief Get the share of the time the channel spent handling its
+	 *        events rather than waiting for them over the last
+	 *        statistics period, can be called from another thread
+	 *
+	 * @return the utilisation (%), negative without events statistics
+	 */
+	float getUtilisation(void) const;
 	
 	/**
 	 * @brief Add a timer event to the channel
@@ -129,6 +274,21 @@ class RtChannelBase
 	                      bool start = true,
 	                      uint8_t priority = 2);
 
+	/**
+	 * @brief Add a periodic timer event expiring on the multiples of its
+	 *        duration on the monotonic clock: it does not drift and all
+	 *        the aligned timers of a same duration, in any channel,
+	 *        expire together
+	 *
+	 * @param name         The name of the timer
+	 * @param duration_ms  The duration of the timer (ms)
+	 * @param priority     The priority of the event (small for high priority)
+	 * @return the event id on success, -1 otherwise
+	 */
+	int32_t addAlignedTimerEvent(const std::string &name,
+	                             double duration_ms,
+	                             uint8_t priority = 2);
+
 	/**
 	 * @brief Add a net socket event to the channel
 	 *
@@ -225,6 +385,31 @@ class RtChannelBase
 	 */
 	bool raiseTimer(event_id_t id);
 
+	/**
+	 * @brief Suspend a flow until an event is processed: on its next
+	 *        occurrence, the event is given to the continuation
+	 *        instead of onEvent (see RtFlow.h for coroutines)
+	 *
+	 * @param id            The event id, a timer or a file descriptor event
+	 * @param continuation  The flow continuation, called once
+	 * @return false if a flow already waits for this event
+	 */
+	bool suspendUntilEvent(event_id_t id,
+	                       std::function<void(const RtEvent *)> continuation);
+
+	/**
+	 * @brief Suspend a flow until a message of a type is received: the
+	 *        next message of this type is given to the continuation
+	 *        instead of onEvent, whatever the fifo it is received on
+	 *
+	 * @param type          The message type
+	 * @param continuation  The flow continuation, called once with
+	 *                      the message selected in its event
+	 * @return false if a flow already waits for this message type
+	 */
+	bool suspendUntilMessage(uint8_t type,
+	                         std::function<void(const MessageEvent *)> continuation);
+
 	/**
 	 * @brief Transmit a message to the opposite channel (in the same block)
 	 *
@@ -236,6 +421,19 @@ class RtChannelBase
 	 */
 	bool shareMessage(void **data, size_t size=0, uint8_t type=0);
 
+	/**
+	 * @brief Transmit a message to the opposite channel (in the same block),
+	 *        the ownership of the message is moved to the opposite channel
+	 *        and the message is released if it cannot be transmitted
+	 *
+	 * @param data  The message to transmit
+	 * @param size  The size of data in message
+	 * @param type  The type of message
+	 * @return true on success, false otherwise
+	 */
+	template<class T>
+	bool shareMessage(std::unique_ptr<T> data, size_t size=0, uint8_t type=0);
+
  protected:
 	/**
 	 * @brief Internal channel initialization
@@ -270,9 +468,9 @@ class RtChannelBase
 	 * @param fifo      The fifo for the messages
 	 * @param priority  The priority of the event (small for high priority)
 	 * @param opposite  Whether this is a message for opposite channels
-	 * @return true on success, false otherwise
+	 * @return the event on success, nullptr otherwise
 	 */
-	bool addMessageEvent(std::shared_ptr<RtFifo> &fifo, uint8_t priority = 6, bool opposite = false);
+	MessageEvent *addMessageEvent(std::shared_ptr<RtFifo> &fifo, uint8_t priority = 6, bool opposite = false);
 
 	/**
 	 * @brief Push a message in another channel fifo
@@ -286,28 +484,108 @@ class RtChannelBase
 	 */
 	bool pushMessage(std::shared_ptr<RtFifo> &fifo, void **data, size_t size, uint8_t type = 0);
 
-#ifdef TIME_REPORTS
-	/// statistics about events durations (in us)
-	std::map<std::string, std::vector<double> > durations;
+	/**
+	 * @brief Push a message in another channel fifo, moving its ownership
+	 *        to the receiving channel without copy
+	 *
+	 * @param fifo  The fifo
+	 * @param data  The message, released if it cannot be pushed
+	 * @param size  The size of data in message
+	 * @param type  The type of message
+	 * @return true on success, false otherwise
+	 */
+	template<class T>
+	bool pushMessage(std::shared_ptr<RtFifo> &fifo, std::unique_ptr<T> data, size_t size, uint8_t type = 0);
+
+	/**
+	 * @brief Record a fifo this channel pushes messages in,
+	 *        for its statistics
+	 *
+	 * @param fifo  The fifo
+	 */
+	void addOutputFifo(std::shared_ptr<RtFifo> &fifo);
 
 	/**
-	 * @brief print statistics on events durations
+	 * @brief Check whether a fifo is full, a message pushed in it
+	 *        would wait or be dropped
+	 *
+	 * @param fifo  The fifo
+	 * @return true if the channel reading the fifo is congested
 	 */
-	void getDurationsStatistics(void) const;
-#endif
+	bool isCongested(const std::shared_ptr<RtFifo> &fifo) const;
+
+	/**
+	 * @brief Let the next channels process the messages pushed by this
+	 *        channel directly in its thread, instead of waking up their
+	 *        own thread with the fifo, whenever they are idle;
+	 *        should be called before the initialization
+	 */
+	void fuseNextChannels(void);
 
  private:
+	/**
+	 * @brief Process a message pushed in a fused fifo in the thread of
+	 *        the channel pushing it, if this channel is idle and no
+	 *        older message waits in the fifo
+	 *
+	 * @param fifo     The fused fifo
+	 * @param message  The message
+	 * @return true if the message was processed, false if it must be
+	 *         pushed in the fifo
+	 */
+	bool processFusedMessage(RtFifo &fifo, const rt_msg_t &message);
+
+	/**
+	 * @brief Check whether a message is dropped instead of pushed
+	 *        in a full fifo because of its type, and count it
+	 *
+	 * @param fifo  The fifo
+	 * @param type  The type of message
+	 * @return true if the message is dropped
+	 */
+	bool dropMessage(std::shared_ptr<RtFifo> &fifo, uint8_t type);
+
+	/**
+	 * @brief Give an event to the flow waiting for it, if any
+	 *
+	 * @param event  The processed event
+	 * @return true if a flow was resumed, false if the event is
+	 *         for onEvent
+	 */
+	bool resumeFlow(const RtEvent *event);
+
+	/**
+	 * @brief Process the messages drained from a fifo while flows
+	 *        wait for messages: each message is given to the flow
+	 *        waiting for its type or to onEvent
+	 *
+	 * @param event  The message event
+	 * @return true on success, false otherwise
+	 */
+	bool resumeMessageFlows(const MessageEvent *event);
+
 	/// name of the block channel
 	std::string channel_name;
 	
 	/// type of the block channel (upward or downward)
 	std::string channel_type;
+
+	/// the account of the objects built by the channel
+	RtAccounting::Account *account;
 	
 	bool block_initialized;
+
+	/// the timer wheel driving the timers, it outlives the events
+	std::unique_ptr<RtTimerWheel> timers;
 	
 	/// events that are currently monitored by the channel thread
 	std::map<event_id_t, std::unique_ptr<RtEvent>> events;
 
+	/// the continuations of the flows suspended until an event
+	/// or a message type, only checked when not empty
+	std::map<event_id_t, std::function<void(const RtEvent *)>> event_flows;
+	std::map<uint8_t, std::function<void(const MessageEvent *)>> message_flows;
+
 	/// the list of new events (used to avoid updates inside the loop)
 	std::vector<std::unique_ptr<RtEvent>> new_events;
 
@@ -319,19 +597,163 @@ class RtChannelBase
 	/// The fifo for outgoing messages to opposite channel
 	std::shared_ptr<RtFifo> out_opp_fifo;
 
-	/// contains the highest FD of input events
-	int32_t max_input_fd;
+	/// the poller monitoring the events file descriptors
+	std::unique_ptr<RtPoller> poller;
+
+	/// the maximum number of messages drained on a single wakeup
+	std::size_t message_batch_size;
+
+	/// the ready events waiting to be processed, by priority
+	RtReadyQueue ready_queue;
+
+	/// the priority from which the events are limited per iteration
+	uint8_t low_priority;
+
+	/// the maximum number of low priority events per iteration, 0 for no limit
+	std::size_t low_priority_budget;
+
+	/// the time spent spinning before sleeping, 0 to always sleep
+	std::chrono::nanoseconds busy_poll_budget;
+
+	/// the message events checked while spinning
+	std::vector<MessageEvent *> polled_events;
+
+	/// the time spent spinning and the number of times the channel
+	/// went to sleep since the last statistics export
+	std::chrono::nanoseconds busy_poll_time;
+	std::size_t busy_poll_sleeps;
+
+	/// the capture of the messages sent to the next blocks, if any
+	std::unique_ptr<RtCaptureWriter> capture;
+
+	/// the probes exporting the spinning statistics
+	std::shared_ptr<Probe<int32_t>> busy_poll_time_probe;
+	std::shared_ptr<Probe<int32_t>> busy_poll_sleeps_probe;
+
+	/// the time spent waiting for events since the last statistics
+	/// export, spinning included, and the time of that export
+	std::chrono::nanoseconds idle_time;
+	std::chrono::steady_clock::time_point last_export;
+
+	/// the utilisation of the last statistics period, read by the
+	/// graph dumps, negative until exported
+	std::atomic<float> utilisation;
+
+	/// the probes exporting the time spent handling and waiting
+	/// for events and the utilisation
+	std::shared_ptr<Probe<int32_t>> busy_time_probe;
+	std::shared_ptr<Probe<int32_t>> idle_time_probe;
+	std::shared_ptr<Probe<float>> utilisation_probe;
+
+	/// Whether the loop has to leave, set by requestStop
+	std::atomic<bool> stop_requested;
+
+	/// The probes exporting the statistics of the events with a given name
+	struct events_probes_t
+	{
+		std::shared_ptr<Probe<int32_t>> count;
+		std::shared_ptr<Probe<int32_t>> handle_p50;
+		std::shared_ptr<Probe<int32_t>> handle_p99;
+		std::shared_ptr<Probe<int32_t>> handle_max;
+		std::shared_ptr<Probe<int32_t>> latency_p50;
+		std::shared_ptr<Probe<int32_t>> latency_p99;
+		std::shared_ptr<Probe<int32_t>> latency_max;
+		std::shared_ptr<Probe<int32_t>> depth_max;
+	};
+
+	/// the events statistics probes, per event name
+	std::map<std::string, events_probes_t> events_probes;
+
+	/// whether the hardware counters are read, and the counters
+	/// of the channel thread once opened
+	bool hardware_counters;
+	std::unique_ptr<RtPerfCounters> perf_counters;
+
+	/// The probes exporting the hardware counters of an event type
+	struct perf_probes_t
+	{
+		std::shared_ptr<Probe<float>> ipc;
+		std::shared_ptr<Probe<float>> cache_misses;
+		std::shared_ptr<Probe<float>> branch_misses;
+	};
+
+	/// the hardware counters probes, per event type
+	std::vector<perf_probes_t> perf_probes;
+
+	/// the probes exporting the live objects of the channel, per type
+	std::vector<std::shared_ptr<Probe<int32_t>>> memory_probes;
+
+	/// The fifos this channel pushes messages in and their probes
+	struct output_fifo_t
+	{
+		std::shared_ptr<RtFifo> fifo;
+		std::shared_ptr<Probe<int32_t>> depth_max;
+		std::shared_ptr<Probe<int32_t>> dropped;
+		std::shared_ptr<Probe<int32_t>> depth;
+		std::shared_ptr<Probe<int32_t>> high_water;
+		std::shared_ptr<Probe<float>> enqueue_rate;
+		std::shared_ptr<Probe<float>> dequeue_rate;
+		/// the totals at the last statistics export
+		std::size_t last_enqueued;
+		std::size_t last_dequeued;
+	};
+	std::vector<output_fifo_t> output_fifos;
+
+	/// the types of the messages dropped instead of pushed in a full fifo
+	std::bitset<UINT8_MAX + 1> droppable_types;
+
+	/// id of the timer exporting the events statistics, -1 if disabled
+	int32_t stats_timer;
+
+	/// Whether previous channels process their messages in this channel
+	/// from their thread, the channel state is then guarded by a mutex
+	/// held by its thread except while it sleeps
+	bool fused_inputs;
+	std::mutex processing_mutex;
+
+	/// The thread processing the channel events, to detect fused links
+	/// looping back to the channel
+	std::atomic<std::thread::id> processing_thread;
 
-	/// fd_set containing monitored input FDs
-	fd_set input_fd_set;
+	/**
+	 * @brief Register the statistics probes for an event name
+	 *
+	 * @param event_name  The name of the event
+	 * @param message     Whether the event reads a fifo, its depth is
+	 *                    then exported too
+	 */
+	void registerEventsProbes(const std::string &event_name, bool message);
 
-	/// fd o the stop signal event
-	int32_t stop_fd;
+	/**
+	 * @brief Register the spinning statistics probes
+	 */
+	void registerBusyPollProbes(void);
+
+	/**
+	 * @brief Register the hardware counters probes
+	 */
+	void registerPerfProbes(void);
+
+	/**
+	 * @brief Register the live objects probes of the types counted
+	 *        since the last registration
+	 */
+	void registerMemoryProbes(void);
+
+	/**
+	 * @brief Export the events statistics in their probes
+	 *        and reset the histograms
+	 */
+	void exportEventsStatistics(void);
 
-	/// fd used to write on a pipe that  breaks select when an event is created
-	int32_t w_sel_break;
-	/// fd used in select to break when an event is created
-	int32_t r_sel_break;
+	/**
+	 * @brief Spin until an input fifo holds messages, the timers
+	 *        are due or the budget is elapsed
+	 *
+	 * @param ready  OUT: the events that are ready
+	 * @return true if some events are ready, false to sleep
+	 */
+	bool busyPoll(std::vector<RtEvent *> &ready);
 
 	/**
 	 * @brief the loop
@@ -339,6 +761,13 @@ class RtChannelBase
 	 */
 	void executeThread(void);
 
+	/**
+	 * @brief Ask the loop to leave, it wakes up the poller so a
+	 *        sleeping channel stops right away
+	 *        This can be called from any thread
+	 */
+	void requestStop(void);
+
 	/**
 	 * @brief Add an event in event map
 	 *
@@ -354,19 +783,6 @@ class RtChannelBase
 	 */
 	void updateEvents(void);
 
-	/**
-	 * @brief Update the maximum input fd after event removal
-	 */
-	void updateMaxFd(void);
-
-	/**
-	 * @brief Add a fd to input_fd_set
-	 *        Should be called each time the channel got a new event
-	 *
-	 * @param fd  The file descriptor to monitor
-	 */
-	void addInputFd(int32_t fd);
-
 	/**
 	 * @brief Get a timer
 	 *
@@ -377,4 +793,30 @@ class RtChannelBase
 };
 
 
+template<class T>
+bool RtChannelBase::shareMessage(std::unique_ptr<T> data, size_t size, uint8_t type)
+{
+	return this->pushMessage(this->out_opp_fifo, std::move(data), size, type);
+}
+
+
+template<class T>
+bool RtChannelBase::pushMessage(std::shared_ptr<RtFifo> &fifo, std::unique_ptr<T> data, size_t size, uint8_t type)
+{
+	if(this->dropMessage(fifo, type))
+	{
+		// the message is released here instead of stalling the channel
+		return true;
+	}
+	void *message = data.get();
+	if(!this->pushMessage(fifo, &message, size, type))
+	{
+		// the message was not pushed, it is still owned here
+		return false;
+	}
+	data.release();
+	return true;
+}
+
+
 #endif
@@ -35,11 +35,11 @@
 #ifndef RT_CHANNEL_DEMUX_H
 #define RT_CHANNEL_DEMUX_H
 
-#include <unordered_map>
 
 #include <opensand_output/Output.h>
 
 #include "RtChannelBase.h"
+#include "RtDemuxFifos.h"
 #include "RtFifo.h"
 
 
@@ -49,7 +49,9 @@
  *        The output fifo is selected with a key when
  *        enqueuing a message.
  * @tparam Key the type used to select the output fifo.
- *             Should be cheap to copy (int, enum, etc.)
+ *             Should be cheap to copy (int, enum, etc.),
+ *             the keys of a dense key space (see RtDenseKey)
+ *             select the fifo in an array instead of a hash map
  */
 template <typename Key>
 class RtChannelDemux: public RtChannelBase
@@ -73,6 +75,20 @@ class RtChannelDemux: public RtChannelBase
 	 */
 	bool enqueueMessage(Key key, void **data, size_t size, uint8_t type);
 
+	/**
+	 * @brief Add a message in the next channel fifo mapped to key,
+	 *        the ownership of the message is moved to the next channel
+	 *        and the message is released if it cannot be enqueued
+	 *
+	 * @param key   The key to select which fifo to use
+	 * @param data  The message to enqueue
+	 * @param size  The size of data in message
+	 * @param type  The type of message
+	 * @return true on success, false otherwise
+	 */
+	template<class T>
+	bool enqueueMessage(Key key, std::unique_ptr<T> data, size_t size, uint8_t type);
+
 	/**
 	 * @brief Set the fifo of the previous channel
 	 *
@@ -80,6 +96,15 @@ class RtChannelDemux: public RtChannelBase
 	 */
 	void setPreviousFifo(std::shared_ptr<RtFifo> &fifo);
 
+	/**
+	 * @brief Check whether the next channel fifo mapped to key is full,
+	 *        a message enqueued in it would wait or be dropped
+	 *
+	 * @param key  The key to select which fifo to check
+	 * @return true if the next channel is congested
+	 */
+	bool isNextCongested(Key key);
+
 	/**
 	 * @brief Add a fifo of a next channel
 	 *
@@ -95,7 +120,7 @@ class RtChannelDemux: public RtChannelBase
 	/// The fifo of the previous channel
   std::shared_ptr<RtFifo> previous_fifo;
 	/// The fifos of the next channels
-	std::unordered_map<Key, std::shared_ptr<RtFifo>> next_fifos;
+	RtDemuxFifos<Key> next_fifos;
 };
 
 
@@ -118,25 +143,48 @@ bool RtChannelDemux<Key>::initPreviousFifo()
 template <typename Key>
 bool RtChannelDemux<Key>::enqueueMessage(Key key, void **data, size_t size, uint8_t type)
 {
-	auto fifo_it = next_fifos.find(key);
-	if (fifo_it == next_fifos.end())
+	std::shared_ptr<RtFifo> *fifo = this->next_fifos.find(key);
+	if (fifo == nullptr)
 	{
 		LOG(this->log_send, LEVEL_ERROR,
 		    "Cannot enqueue message: no FIFO found for this key");
 		return false;
 	}
-	auto fifo = fifo_it->second;
-	return this->pushMessage(fifo, data, size, type);
+	return this->pushMessage(*fifo, data, size, type);
+}
+
+
+template <typename Key>
+template <class T>
+bool RtChannelDemux<Key>::enqueueMessage(Key key, std::unique_ptr<T> data, size_t size, uint8_t type)
+{
+	void *message = data.get();
+	if(!this->enqueueMessage(key, &message, size, type))
+	{
+		return false;
+	}
+	data.release();
+	return true;
+}
+
+
+template <typename Key>
+bool RtChannelDemux<Key>::isNextCongested(Key key)
+{
+	std::shared_ptr<RtFifo> *fifo = this->next_fifos.find(key);
+	return fifo != nullptr && this->isCongested(*fifo);
 }
 
 
 template <typename Key>
 void RtChannelDemux<Key>::addNextFifo(Key key, std::shared_ptr<RtFifo> &fifo)
 {
-	bool actually_inserted = this->next_fifos.emplace(key, fifo).second;
+	bool actually_inserted = this->next_fifos.add(key, fifo);
 	if (!actually_inserted) {
 		std::cout << "ERROR: Cannot add next FIFO: a FIFO already exists with this key\n";
+		return;
 	}
+	this->addOutputFifo(fifo);
 };
 
 
@@ -64,7 +64,14 @@ void RtChannelMux::addPreviousFifo(std::shared_ptr<RtFifo> &fifo)
 }
 
 
+bool RtChannelMux::isNextCongested(void) const
+{
+	return this->isCongested(this->next_fifo);
+}
+
+
 void RtChannelMux::setNextFifo(std::shared_ptr<RtFifo> &fifo)
 {
 	this->next_fifo = fifo;
+	this->addOutputFifo(fifo);
 }
@@ -36,11 +36,11 @@
 #define RT_CHANNEL_MUXDEMUX_H
 
 #include <vector>
-#include <unordered_map>
 
 #include <opensand_output/Output.h>
 
 #include "RtChannelBase.h"
+#include "RtDemuxFifos.h"
 #include "RtFifo.h"
 
 
@@ -50,7 +50,9 @@
  *        The output fifo is selected with a key when
  *        enqueuing a message.
  * @tparam Key the type used to select the output fifo.
- *             Should be cheap to copy (int, enum, etc.)
+ *             Should be cheap to copy (int, enum, etc.),
+ *             the keys of a dense key space (see RtDenseKey)
+ *             select the fifo in an array instead of a hash map
  */
 template <typename Key>
 class RtChannelMuxDemux: public RtChannelBase
@@ -74,6 +76,20 @@ class RtChannelMuxDemux: public RtChannelBase
 	 */
 	bool enqueueMessage(Key key, void **data, size_t size, uint8_t type);
 
+	/**
+	 * @brief Add a message in the next channel fifo mapped to key,
+	 *        the ownership of the message is moved to the next channel
+	 *        and the message is released if it cannot be enqueued
+	 *
+	 * @param key   The key to select which fifo to use
+	 * @param data  The message to enqueue
+	 * @param size  The size of data in message
+	 * @param type  The type of message
+	 * @return true on success, false otherwise
+	 */
+	template<class T>
+	bool enqueueMessage(Key key, std::unique_ptr<T> data, size_t size, uint8_t type);
+
 	/**
 	 * @brief Add a fifo of a previous channel
 	 *
@@ -81,6 +97,25 @@ class RtChannelMuxDemux: public RtChannelBase
 	 */
 	void addPreviousFifo(std::shared_ptr<RtFifo> &fifo);
 
+	/**
+	 * @brief Check whether the next channel fifo mapped to key is full,
+	 *        a message enqueued in it would wait or be dropped
+	 *
+	 * @param key  The key to select which fifo to check
+	 * @return true if the next channel is congested
+	 */
+	bool isNextCongested(Key key);
+
+	/**
+	 * @brief Get the number of messages waiting in the next channel fifo
+	 *        mapped to key, an upper bound as the next channel may be
+	 *        popping them meanwhile
+	 *
+	 * @param key  The key to select which fifo to check
+	 * @return the number of messages waiting, 0 if there is no fifo
+	 */
+	std::size_t getNextDepth(Key key);
+
 	/**
 	 * @brief Add a fifo of a next channel
 	 *
@@ -96,7 +131,7 @@ class RtChannelMuxDemux: public RtChannelBase
 	/// The fifos of the previous channels
 	std::vector<std::shared_ptr<RtFifo>> previous_fifos;
 	/// The fifos of the next channels
-	std::unordered_map<Key, std::shared_ptr<RtFifo>> next_fifos;
+	RtDemuxFifos<Key> next_fifos;
 };
 
 
@@ -123,26 +158,57 @@ bool RtChannelMuxDemux<Key>::initPreviousFifo()
 template <typename Key>
 bool RtChannelMuxDemux<Key>::enqueueMessage(Key key, void **data, size_t size, uint8_t type)
 {
-	auto fifo_it = next_fifos.find(key);
-	if (fifo_it == next_fifos.end())
+	std::shared_ptr<RtFifo> *fifo = this->next_fifos.find(key);
+	if (fifo == nullptr)
 	{
 		LOG(this->log_send, LEVEL_ERROR,
 		    "Cannot enqueue message: no FIFO found for this key");
 		return false;
 	}
-	auto fifo = fifo_it->second;
-	return this->pushMessage(fifo, data, size, type);
+	return this->pushMessage(*fifo, data, size, type);
+}
+
+
+template <typename Key>
+template <class T>
+bool RtChannelMuxDemux<Key>::enqueueMessage(Key key, std::unique_ptr<T> data, size_t size, uint8_t type)
+{
+	void *message = data.get();
+	if(!this->enqueueMessage(key, &message, size, type))
+	{
+		return false;
+	}
+	data.release();
+	return true;
+}
+
+
+template <typename Key>
+bool RtChannelMuxDemux<Key>::isNextCongested(Key key)
+{
+	std::shared_ptr<RtFifo> *fifo = this->next_fifos.find(key);
+	return fifo != nullptr && this->isCongested(*fifo);
+}
+
+
+template <typename Key>
+std::size_t RtChannelMuxDemux<Key>::getNextDepth(Key key)
+{
+	std::shared_ptr<RtFifo> *fifo = this->next_fifos.find(key);
+	return fifo != nullptr && *fifo != nullptr ? (*fifo)->getDepth() : 0;
 }
 
 
 template <typename Key>
 void RtChannelMuxDemux<Key>::addNextFifo(Key key, std::shared_ptr<RtFifo> &fifo)
 {
-	bool actually_inserted = this->next_fifos.emplace(key, fifo).second;
+	bool actually_inserted = this->next_fifos.add(key, fifo);
 	if (!actually_inserted)
 	{
 		std::cout << "ERROR: Cannot add next FIFO: a FIFO already exists with this key\n";
+		return;
 	}
+	this->addOutputFifo(fifo);
 }
 
 
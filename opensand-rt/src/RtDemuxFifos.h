@@ -0,0 +1,154 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+
+/**
+ * @file RtDemuxFifos.h
+ * @author Viveris Technologies
+ * @brief  The next fifos of the demultiplexing channels, selected by key
+ *
+ */
+
+#ifndef RT_DEMUX_FIFOS_H
+#define RT_DEMUX_FIFOS_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+
+#include "RtFifo.h"
+
+
+/**
+ * @brief The mapping of the keys of a dense key space to the indexes
+ *        of a fixed array, specialize it with:
+ *          static constexpr std::size_t size;
+ *          static constexpr std::size_t index(const Key &key);
+ *        the keys without specialization are hashed
+ *
+ * @tparam Key  the type used to select the output fifo
+ */
+template <typename Key>
+struct RtDenseKey
+{
+	static constexpr bool dense = false;
+};
+
+
+template <>
+struct RtDenseKey<bool>
+{
+	static constexpr bool dense = true;
+	static constexpr std::size_t size = 2;
+	static constexpr std::size_t index(bool key) { return key ? 1 : 0; }
+};
+
+
+/**
+ * @class RtDemuxFifos
+ * @brief The next fifos of a demultiplexing channel, kept in a hash map
+ *        for the open key spaces
+ *
+ * @tparam Key  the type used to select the output fifo
+ */
+template <typename Key, bool dense = RtDenseKey<Key>::dense>
+class RtDemuxFifos
+{
+ public:
+	/**
+	 * @brief Add the fifo mapped to a key
+	 *
+	 * @param key   The key
+	 * @param fifo  The fifo
+	 * @return true on success, false if a fifo is already mapped to the key
+	 */
+	bool add(const Key &key, std::shared_ptr<RtFifo> &fifo)
+	{
+		return this->fifos.emplace(key, fifo).second;
+	}
+
+	/**
+	 * @brief Find the fifo mapped to a key
+	 *
+	 * @param key  The key
+	 * @return the fifo, nullptr if no fifo is mapped to the key
+	 */
+	std::shared_ptr<RtFifo> *find(const Key &key)
+	{
+		auto fifo_it = this->fifos.find(key);
+		if(fifo_it == this->fifos.end())
+		{
+			return nullptr;
+		}
+		return &fifo_it->second;
+	}
+
+ private:
+	std::unordered_map<Key, std::shared_ptr<RtFifo>> fifos;
+};
+
+
+/**
+ * @class RtDemuxFifos
+ * @brief The next fifos of a demultiplexing channel, kept in a fixed
+ *        array indexed by the keys of a dense key space
+ *
+ * @tparam Key  the type used to select the output fifo
+ */
+template <typename Key>
+class RtDemuxFifos<Key, true>
+{
+ public:
+	bool add(const Key &key, std::shared_ptr<RtFifo> &fifo)
+	{
+		std::size_t index = RtDenseKey<Key>::index(key);
+		if(index >= this->fifos.size() || this->fifos[index] != nullptr)
+		{
+			return false;
+		}
+		this->fifos[index] = fifo;
+		return true;
+	}
+
+	std::shared_ptr<RtFifo> *find(const Key &key)
+	{
+		std::size_t index = RtDenseKey<Key>::index(key);
+		if(index >= this->fifos.size() || this->fifos[index] == nullptr)
+		{
+			return nullptr;
+		}
+		return &this->fifos[index];
+	}
+
+ private:
+	std::array<std::shared_ptr<RtFifo>, RtDenseKey<Key>::size> fifos;
+};
+
+
+#endif
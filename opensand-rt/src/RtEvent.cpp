@@ -35,13 +35,19 @@
 #include <unistd.h>
 
 #include "RtEvent.h"
+#include "RtTrace.h"
 
 
 RtEvent::RtEvent(EventType type, const std::string &name, int32_t fd, uint8_t priority):
 	type{type},
 	name{name},
+	trace_name{RtTrace::intern(name)},
 	fd{fd},
-	priority{priority}
+	priority{priority},
+	ready_next{nullptr},
+	ready_queued{false},
+	handle_times{},
+	latencies{}
 {
 	this->setTriggerTime();
 	this->setCustomTime();
@@ -85,6 +91,25 @@ time_val_t RtEvent::getAndSetCustomTime(void) const
 }
 
 
+void RtEvent::startProcessing(time_point_t wakeup)
+{
+	this->setTriggerTime();
+	auto latency = this->trigger_time - wakeup;
+	this->latencies.record(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+}
+
+void RtEvent::endProcessing(void)
+{
+	this->handle_times.record(this->getTimeFromTrigger());
+}
+
+void RtEvent::resetHistograms(void)
+{
+	this->handle_times.reset();
+	this->latencies.reset();
+}
+
+
 bool RtEvent::operator <(const RtEvent& event) const
 {
 	long int delta = 100000000L * (this->priority - event.priority);
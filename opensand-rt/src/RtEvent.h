@@ -40,6 +40,7 @@
 #include <string>
 
 #include "Types.h"
+#include "RtHistogram.h"
 
 
 using time_point_t = std::chrono::high_resolution_clock::time_point;
@@ -52,6 +53,8 @@ using time_val_t = std::chrono::high_resolution_clock::rep;
   */
 class RtEvent
 {
+	friend class RtReadyQueue;
+
  public:
 	/**
 	 * @brief RtEvent constructor
@@ -100,6 +103,13 @@ class RtEvent
 	 */
 	std::string getName(void) const {return this->name;};
 
+	/**
+	 * @brief Get the event name kept for the traced spans
+	 *
+	 * @return the event name
+	 */
+	const char *getTraceName(void) const {return this->trace_name;};
+
 	/**
 	 * @brief Get the file descriptor on the event
 	 *
@@ -133,7 +143,40 @@ class RtEvent
 	 */
 	time_val_t getAndSetCustomTime(void) const;
 
-	/// operator < used by sort on events priority
+	/**
+	 * @brief Record the latency between the channel wakeup and the
+	 *        beginning of the event processing, update the trigger time
+	 *
+	 * @param wakeup  The time the channel was woken up
+	 */
+	void startProcessing(time_point_t wakeup);
+
+	/**
+	 * @brief Record the time spent processing the event
+	 */
+	void endProcessing(void);
+
+	/**
+	 * @brief Get the histogram of the event processing durations
+	 *
+	 * @return the processing durations histogram (us)
+	 */
+	const RtHistogram &getHandleTimes(void) const { return this->handle_times; };
+
+	/**
+	 * @brief Get the histogram of the latencies between the channel
+	 *        wakeup and the beginning of the event processing
+	 *
+	 * @return the latencies histogram (us)
+	 */
+	const RtHistogram &getLatencies(void) const { return this->latencies; };
+
+	/**
+	 * @brief Forget the recorded processing durations and latencies
+	 */
+	void resetHistograms(void);
+
+	/// operator < comparing the events priority
 	bool operator <(const RtEvent &event) const;
 
 	/// operator == used to check if the event id corresponds
@@ -149,17 +192,32 @@ class RtEvent
 	/// event name
 	const std::string name;
 
+	/// event name kept until the traces export
+	const char *trace_name;
+
 	/// Event input file descriptor
 	int32_t fd;
 
 	/// Event priority
 	uint8_t priority;
 
+	/// the next event of the same priority in the ready queue
+	RtEvent *ready_next;
+
+	/// whether the event is in the ready queue of its channel
+	bool ready_queued;
+
 	/// date, used as event trigger date
 	time_point_t trigger_time;
 	
 	/// date, used as custom processing date
 	mutable time_point_t custom_time;
+
+	/// processing durations (us)
+	RtHistogram handle_times;
+
+	/// latencies between the channel wakeup and the processing (us)
+	RtHistogram latencies;
 };
 
 #endif
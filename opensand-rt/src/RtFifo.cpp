@@ -33,76 +33,128 @@
  */
 
 #include <unistd.h>
+#include <sys/eventfd.h>
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
 
 #include "RtFifo.h"
+#include "RtVirtualClock.h"
 #include "Rt.h"
-#include "RtCommunicate.h"
 
 
 #define DEFAULT_FIFO_SIZE 3
 
 
-RtFifo::RtFifo():
-	fifo{},
+RtFifo::RtFifo(const std::string &name):
+	name{name},
+	ring{},
 	max_size{DEFAULT_FIFO_SIZE},
-	fifo_mutex{},
-  fifo_size_sem{DEFAULT_FIFO_SIZE}
+	head_padding{},
+	head{0},
+	cached_tail{0},
+	tail_padding{},
+	tail{0},
+	cached_head{0},
+	sig_padding{},
+	sig_fd{-1},
+	space_fd{-1},
+	push_max_depth{0},
+	dropped{0},
+	enqueued{0},
+	high_water{0},
+	fused{false},
+	fused_receiver{nullptr},
+	fused_event{nullptr}
 {
 }
 
 
 RtFifo::~RtFifo()
 {
-	close(this->r_sig_pipe);
-	close(this->w_sig_pipe);
+	close(this->sig_fd);
+	close(this->space_fd);
 }
 
 
 bool RtFifo::init()
 {
-	int32_t pipefd[2];
-	if(pipe(pipefd) != 0)
+	// the consumer channel initializes its fifos
+	try
+	{
+		this->ring.resize(this->max_size);
+	}
+	catch(const std::bad_alloc &)
 	{
 		return false;
 	}
 
-	this->r_sig_pipe = pipefd[0];
-	this->w_sig_pipe = pipefd[1];
+	this->sig_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(this->sig_fd < 0)
+	{
+		return false;
+	}
+
+	this->space_fd = eventfd(0, EFD_CLOEXEC);
+	if(this->space_fd < 0)
+	{
+		return false;
+	}
 
 	return true;
 }
 
 
+void RtFifo::reserve(std::size_t size)
+{
+	this->max_size = std::max(this->max_size, size);
+}
+
+
 bool RtFifo::push(void *data, size_t size, uint8_t type)
 {
-	// we need a semaphore here to block while fifo is full
-	fifo_size_sem.wait();
-	RtLock acquire{fifo_mutex};
+	const std::size_t position = this->tail.load(std::memory_order_relaxed);
 
-	if(this->fifo.size() >= this->max_size)
+	// block while fifo is full
+	while(position - this->cached_head >= this->max_size)
 	{
-		Rt::reportError("fifo", std::this_thread::get_id(), false,
-		                "Size is greater than maximum size (%u > %u), "
-		                "this should not happend\n",
-		                this->fifo.size(), this->max_size);
+		this->cached_head = this->head.load(std::memory_order_acquire);
+		if(position - this->cached_head < this->max_size)
+		{
+			break;
+		}
+
+		// the consumer signals us when it pops from a full ring
+		uint64_t value;
+		if(read(this->space_fd, &value, sizeof(value)) < 0 && errno != EINTR)
+		{
+			Rt::reportError("fifo", std::this_thread::get_id(), false,
+			                "Failed to wait for space in fifo [%d: %s]\n",
+			                errno, strerror(errno));
+			return false;
+		}
 	}
-	this->fifo.push({data, size, type});
 
-	fd_set wset;
-	FD_ZERO(&wset);
-	FD_SET(this->w_sig_pipe, &wset);
-	if(select(this->w_sig_pipe + 1, NULL, &wset, NULL, NULL) < 0)
+	this->ring[position % this->max_size] = {data, size, type};
+	if(RtVirtualClock::isEnabled())
 	{
-		Rt::reportError("fifo", std::this_thread::get_id(), false,
-		                "Select failed on pipe [%d: %s]\n",
-		                errno, strerror(errno));
-		return false;
+		// counted before the consumer can pop it
+		RtVirtualClock::addMessages(1);
 	}
-	if (!check_write(this->w_sig_pipe))
+	this->tail.store(position + 1, std::memory_order_seq_cst);
+
+	// only wake the consumer when the ring was empty
+	if(position != this->head.load(std::memory_order_seq_cst))
+	{
+		return true;
+	}
+
+	const uint64_t value = 1;
+	if(write(this->sig_fd, &value, sizeof(value)) != sizeof(value))
 	{
 		Rt::reportError("fifo", std::this_thread::get_id(), false,
-		                "Failed to write on pipe\n");
+		                "Failed to signal data in fifo [%d: %s]\n",
+		                errno, strerror(errno));
 		return false;
 	}
 
@@ -110,30 +162,112 @@ bool RtFifo::push(void *data, size_t size, uint8_t type)
 }
 
 
+bool RtFifo::isFull(void) const
+{
+	const std::size_t position = this->tail.load(std::memory_order_relaxed);
+	return position - this->head.load(std::memory_order_acquire) >= this->max_size;
+}
+
+
 bool RtFifo::pop(rt_msg_t &elem)
 {
-  {
-    RtLock acquire{fifo_mutex};
+	return this->pop(&elem, 1) == 1;
+}
 
-    if(this->fifo.empty())
-    {
-      Rt::reportError("fifo", std::this_thread::get_id(), false,
-                      "Fifo is already empty, this should not happend\n");
-      return false;
-    }
-    else
-    {
-      // get element in queue
-      elem = this->fifo.front();
 
-      // remove element from queue
-      this->fifo.pop();
-    }
+std::size_t RtFifo::pop(rt_msg_t *elems, std::size_t max_count)
+{
+	const std::size_t position = this->head.load(std::memory_order_relaxed);
 
-  }
+	if(position == this->cached_tail)
+	{
+		this->cached_tail = this->tail.load(std::memory_order_acquire);
+		if(position == this->cached_tail)
+		{
+			Rt::reportError("fifo", std::this_thread::get_id(), false,
+			                "Fifo is already empty, this should not happend\n");
+			this->clearSignal();
+			return 0;
+		}
+	}
 
-	// fifo has empty space, we can unlock it
-  fifo_size_sem.notify();
+	// get elements in queue and remove them
+	const std::size_t count = std::min(max_count, this->cached_tail - position);
+	for(std::size_t index = 0; index < count; ++index)
+	{
+		elems[index] = this->ring[(position + index) % this->max_size];
+	}
+	this->head.store(position + count, std::memory_order_seq_cst);
+	if(RtVirtualClock::isEnabled())
+	{
+		RtVirtualClock::removeMessages(count);
+	}
+
+	// fifo was full, the producer may be waiting for space
+	this->cached_tail = this->tail.load(std::memory_order_seq_cst);
+	if(this->cached_tail - position >= this->max_size)
+	{
+		const uint64_t value = 1;
+		if(write(this->space_fd, &value, sizeof(value)) != sizeof(value))
+		{
+			Rt::reportError("fifo", std::this_thread::get_id(), false,
+			                "Failed to signal space in fifo [%d: %s]\n",
+			                errno, strerror(errno));
+		}
+	}
+
+	if(position + count != this->cached_tail)
+	{
+		// remaining data, keep the signaling readable
+		return count;
+	}
+
+	this->clearSignal();
+	return count;
+}
+
+
+std::size_t RtFifo::getDepth(void) const
+{
+	const std::size_t position = this->head.load(std::memory_order_relaxed);
+	return this->tail.load(std::memory_order_acquire) - position;
+}
+
+
+std::size_t RtFifo::getDequeued(void) const
+{
+	// the fused messages are dequeued as soon as they are enqueued
+	const std::size_t total = this->getEnqueued();
+	return total - std::min(total, this->getDepth());
+}
 
+
+bool RtFifo::clearSignal(void)
+{
+	uint64_t value;
+	if(read(this->sig_fd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+	{
+		Rt::reportError("fifo", std::this_thread::get_id(), false,
+		                "Failed to read fifo signaling [%d: %s]\n",
+		                errno, strerror(errno));
+		return false;
+	}
+
+	// the producer may have pushed while we were clearing the
+	// signaling, make sure it is readable again in this case
+	this->cached_tail = this->tail.load(std::memory_order_seq_cst);
+	if(this->head.load(std::memory_order_relaxed) == this->cached_tail)
+	{
+		return true;
+	}
+
+	value = 1;
+	if(write(this->sig_fd, &value, sizeof(value)) != sizeof(value))
+	{
+		Rt::reportError("fifo", std::this_thread::get_id(), false,
+		                "Failed to signal data in fifo [%d: %s]\n",
+		                errno, strerror(errno));
+		return false;
+	}
 	return true;
 }
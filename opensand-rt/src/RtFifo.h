@@ -36,15 +36,32 @@
 #ifndef RT_FIFO_H
 #define RT_FIFO_H
 
-#include <queue>
+#include <atomic>
+#include <string>
+#include <vector>
 
+#include "RtMemory.h"
 #include "Types.h"
-#include "RtMutex.h"
+
+
+class RtChannelBase;
+class MessageEvent;
+
+/// Size of a cache line, used to keep producer and consumer indexes apart
+/// (padding is used as aligned new is not available in C++11)
+constexpr std::size_t RT_CACHE_LINE_SIZE{64};
 
 
 /**
  * @class RtFifo
  * @brief A fifo between two blocks
+ *
+ * The fifo is a bounded single-producer/single-consumer ring: each
+ * fifo is only written by the channel it was given to as next fifo
+ * and only read by the channel it was given to as previous fifo.
+ * The consumer is signaled through an eventfd that stays readable
+ * as long as the ring is not empty; the producer only writes on it
+ * when the ring goes from empty to non-empty.
  */
 class RtFifo
 {
@@ -65,60 +82,170 @@ class RtFifo
 	/**
 	 * @brief Fifo constructor
 	 *
+	 * @param name  The name of the fifo in the statistics
 	 */
-	RtFifo();
+	RtFifo(const std::string &name = "");
 
 	/**
-	 * @brief Initialize the fifo
+	 * @brief Initialize the fifo, its ring is allocated with
+	 *        the memory placement of the calling thread
 	 *
 	 * @return true on success, false otherwise
 	 */
 	bool init();
+
+	/**
+	 * @brief Grow the fifo so it holds at least a number of elements,
+	 *        should be called before the initialization
+	 *
+	 * @param size  The minimum number of elements
+	 */
+	void reserve(std::size_t size);
 	
 	/**
 	 * @brief Add a new element in the fifo
+	 *        Block while the fifo is full
 	 * 
 	 * @param the data part of the element to add in the fifo
 	 * @param the size of the element to add in the fifo
 	 * @return true on success, false otherwise
 	 */
 	bool push(void *data, std::size_t size, uint8_t type);
+
+	/**
+	 * @brief Check whether the fifo is full, a push would then block
+	 *        until the consumer pops an element
+	 *        (only meaningful for the producer)
+	 *
+	 * @return true if the fifo has no free slot
+	 */
+	bool isFull(void) const;
 	
 	/**
-	 * @brief Access the first element but do not delete it
+	 * @brief Get the first element and remove it from the fifo
 	 * 
 	 * @param elem  the first element in the fifo
 	 * @return true on success, false otherwise
 	 */
 	bool pop(rt_msg_t &message);
+
+	/**
+	 * @brief Get up to max_count elements and remove them from the fifo
+	 *
+	 * @param messages   OUT: the popped elements, in fifo order
+	 * @param max_count  The maximum number of elements to pop
+	 * @return the number of popped elements, 0 on error
+	 */
+	std::size_t pop(rt_msg_t *messages, std::size_t max_count);
+
+	/**
+	 * @brief Get the number of elements waiting in the fifo,
+	 *        exact when called by the consumer before a pop
+	 *
+	 * @return the number of elements pushed and not popped yet
+	 */
+	std::size_t getDepth(void) const;
+
+	/**
+	 * @brief Get the number of messages given to the fifo since the start,
+	 *        pushed or processed through a fused link
+	 *
+	 * @return the number of enqueued messages
+	 */
+	std::size_t getEnqueued(void) const {return this->enqueued.load(std::memory_order_relaxed);};
+
+	/**
+	 * @brief Get the number of messages taken by the consumer since the start
+	 *
+	 * @return the number of dequeued messages
+	 */
+	std::size_t getDequeued(void) const;
+
+	/**
+	 * @brief Get the maximum number of elements in the fifo after a push
+	 *        since the start, only measured with the events statistics
+	 *
+	 * @return the high-water mark
+	 */
+	std::size_t getHighWater(void) const {return this->high_water.load(std::memory_order_relaxed);};
 	
 	/**
 	 * 	@brief Get the file descriptor signaling data
 	 * 	
-	 * 	@return the read end of the pipe for data signaling
+	 * 	@return the eventfd readable while the fifo contains data
+	 */
+	int32_t getSigFd(void) const {return this->sig_fd;};
+
+	/**
+	 * @brief Get the name of the fifo in the statistics
+	 *
+	 * @return the name of the fifo
 	 */
-	int32_t getSigFd(void) const {return this->r_sig_pipe;};
+	const std::string &getName(void) const {return this->name;};
 
  private:
-	/// the queue
-	std::queue<rt_msg_t> fifo;
+	/**
+	 * @brief Clear the data signaling once the ring is empty
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool clearSignal(void);
+
+	/// The name of the fifo in the statistics
+	std::string name;
+
+	/// The ring slots, on the memory of the consumer channel
+	std::vector<rt_msg_t, RtAllocator<rt_msg_t>> ring;
 
 	/// The fifo size
-  std::size_t max_size;
-	
-	/// The signaling pipe file descriptor for writing operations
-	int32_t w_sig_pipe;
-	
-	/// The signaling pipe file descriptor for reading operations
-	int32_t r_sig_pipe;
-	
-	/// The mutex on fifo access
-	RtMutex fifo_mutex;
-	
-	/// The mutex for fifo full (we need a semaphore here because it is
-	//  lock and unlocked by different threads
-	//  This semaphore is intialized with the fifo size
-	RtSemaphore fifo_size_sem;
+	std::size_t max_size;
+
+	/// Keep the consumer index on its own cache line
+	char head_padding[RT_CACHE_LINE_SIZE];
+
+	/// The index of the next element to pop, written by the consumer
+	std::atomic<std::size_t> head;
+
+	/// The consumer copy of tail, avoids reading the producer cache line
+	std::size_t cached_tail;
+
+	/// Keep the producer index on its own cache line
+	char tail_padding[RT_CACHE_LINE_SIZE];
+
+	/// The index of the next element to push, written by the producer
+	std::atomic<std::size_t> tail;
+
+	/// The producer copy of head, avoids reading the consumer cache line
+	std::size_t cached_head;
+
+	/// Keep the signaling away from the producer cache line
+	char sig_padding[RT_CACHE_LINE_SIZE];
+
+	/// The eventfd signaling data to the consumer
+	int32_t sig_fd;
+
+	/// The eventfd signaling free space to a blocked producer
+	int32_t space_fd;
+
+	/// The statistics of the producer, only used by its channel
+	/// the maximum number of elements in the fifo after a push
+	std::size_t push_max_depth;
+	/// the number of messages dropped instead of pushed in the full fifo
+	std::size_t dropped;
+
+	/// The totals of the producer, also read by the graph dumps:
+	/// the messages enqueued and the maximum push_max_depth
+	std::atomic<std::size_t> enqueued;
+	std::atomic<std::size_t> high_water;
+
+	/// Whether the messages are processed by the consumer channel
+	/// directly in the producer thread when it is idle
+	bool fused;
+
+	/// The consumer channel of a fused fifo and its message event,
+	/// set when the consumer is initialized
+	RtChannelBase *fused_receiver;
+	MessageEvent *fused_event;
 };
 
 
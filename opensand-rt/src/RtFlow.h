@@ -0,0 +1,181 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file RtFlow.h
+ * @author Viveris Technologies
+ * @brief  Coroutines for the multi-step flows of the channels
+ *         (logon, synchronization, retransmissions), resumed by
+ *         the channel event loop; needs C++20
+ *
+ */
+
+#ifndef RT_FLOW_H
+#define RT_FLOW_H
+
+#if __cplusplus < 202002L || !__has_include(<coroutine>)
+#error "RtFlow.h needs the C++20 coroutines"
+#endif
+
+#include <coroutine>
+#include <exception>
+
+#include "RtChannelBase.h"
+#include "MessageEvent.h"
+
+
+/**
+ * @class RtFlow
+ * @brief The return type of the coroutines run in a channel thread
+ *
+ * A flow starts when it is called and runs until its first co_await,
+ * it is then resumed by the channel loop when the awaited timer
+ * expires or the awaited message is received, in place of onEvent.
+ * The flow frame is released when it returns; a flow waiting for a
+ * removed event is never resumed.
+ *
+ * @code
+ * RtFlow Downward::logon()
+ * {
+ *     while(true)
+ *     {
+ *         this->sendLogonReq();
+ *         auto message = co_await RtMessageAwaiter{*this, logon_resp_type};
+ *         ...
+ *         co_await RtTimerAwaiter{*this, this->retry_timer};
+ *     }
+ * }
+ * @endcode
+ */
+class RtFlow
+{
+ public:
+	struct promise_type
+	{
+		RtFlow get_return_object() noexcept { return {}; };
+		std::suspend_never initial_suspend() noexcept { return {}; };
+		std::suspend_never final_suspend() noexcept { return {}; };
+		void return_void() noexcept {};
+		void unhandled_exception() noexcept { std::terminate(); };
+	};
+};
+
+
+/**
+ * @class RtTimerAwaiter
+ * @brief Suspend a flow until a timer expires
+ *
+ * co_await returns false if the flow could not be suspended (the
+ * timer cannot be started or another flow waits for it), the flow
+ * then goes on immediately.
+ */
+class RtTimerAwaiter
+{
+ public:
+	/**
+	 * @param channel  The channel running the flow
+	 * @param timer    The timer
+	 * @param start    Whether the timer is started before suspending,
+	 *                 otherwise its next expiration is awaited
+	 */
+	RtTimerAwaiter(RtChannelBase &channel, event_id_t timer, bool start = true):
+		channel{channel},
+		timer{timer},
+		start{start},
+		expired{false}
+	{
+	};
+
+	bool await_ready() const noexcept { return false; };
+
+	bool await_suspend(std::coroutine_handle<> flow)
+	{
+		if(this->start && !this->channel.startTimer(this->timer))
+		{
+			return false;
+		}
+		return this->channel.suspendUntilEvent(this->timer, [this, flow](const RtEvent *)
+		{
+			this->expired = true;
+			flow.resume();
+		});
+	};
+
+	bool await_resume() const noexcept { return this->expired; };
+
+ private:
+	RtChannelBase &channel;
+	event_id_t timer;
+	bool start;
+	bool expired;
+};
+
+
+/**
+ * @class RtMessageAwaiter
+ * @brief Suspend a flow until a message of a type is received
+ *
+ * co_await returns the message event with the message selected, only
+ * valid until the next co_await, the flow may release its data; or
+ * nullptr if another flow waits for this type, the flow then goes on
+ * immediately.
+ */
+class RtMessageAwaiter
+{
+ public:
+	/**
+	 * @param channel  The channel running the flow
+	 * @param type     The message type
+	 */
+	RtMessageAwaiter(RtChannelBase &channel, uint8_t type):
+		channel{channel},
+		type{type},
+		message{nullptr}
+	{
+	};
+
+	bool await_ready() const noexcept { return false; };
+
+	bool await_suspend(std::coroutine_handle<> flow)
+	{
+		return this->channel.suspendUntilMessage(this->type, [this, flow](const MessageEvent *message)
+		{
+			this->message = message;
+			flow.resume();
+		});
+	};
+
+	const MessageEvent *await_resume() const noexcept { return this->message; };
+
+ private:
+	RtChannelBase &channel;
+	uint8_t type;
+	const MessageEvent *message;
+};
+
+
+#endif
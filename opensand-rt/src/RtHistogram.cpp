@@ -0,0 +1,173 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file RtHistogram.cpp
+ * @author Viveris Technologies
+ * @brief  Fixed-size log-bucketed histogram of durations
+ *
+ */
+
+#include <cmath>
+
+#include "RtHistogram.h"
+
+
+RtHistogram::RtHistogram():
+	buckets(),
+	count{0},
+	sum{0},
+	min{0},
+	max{0}
+{
+}
+
+
+void RtHistogram::record(int64_t value)
+{
+	int64_t duration = value < 0 ? 0 : value;
+
+	this->buckets[getBucket(duration)]++;
+	if(this->count == 0 || duration < this->min)
+	{
+		this->min = duration;
+	}
+	if(this->count == 0 || duration > this->max)
+	{
+		this->max = duration;
+	}
+	this->count++;
+	this->sum += duration;
+}
+
+
+void RtHistogram::merge(const RtHistogram &other)
+{
+	if(other.count == 0)
+	{
+		return;
+	}
+
+	for(std::size_t bucket = 0; bucket < bucket_count; ++bucket)
+	{
+		this->buckets[bucket] += other.buckets[bucket];
+	}
+	if(this->count == 0 || other.min < this->min)
+	{
+		this->min = other.min;
+	}
+	if(this->count == 0 || other.max > this->max)
+	{
+		this->max = other.max;
+	}
+	this->count += other.count;
+	this->sum += other.sum;
+}
+
+
+void RtHistogram::reset(void)
+{
+	this->buckets.fill(0);
+	this->count = 0;
+	this->sum = 0;
+	this->min = 0;
+	this->max = 0;
+}
+
+
+double RtHistogram::getMean(void) const
+{
+	if(this->count == 0)
+	{
+		return 0.0;
+	}
+	return static_cast<double>(this->sum) / this->count;
+}
+
+
+int64_t RtHistogram::getPercentile(double percentile) const
+{
+	if(this->count == 0)
+	{
+		return 0;
+	}
+
+	// rank of the requested value among the recorded ones
+	uint64_t rank = std::ceil(percentile / 100.0 * this->count);
+	if(rank < 1)
+	{
+		rank = 1;
+	}
+
+	uint64_t seen = 0;
+	for(std::size_t bucket = 0; bucket < bucket_count; ++bucket)
+	{
+		seen += this->buckets[bucket];
+		// the last bucket is only bounded by the greatest value
+		if(seen >= rank && bucket < bucket_count - 1)
+		{
+			int64_t bound = getBucketUpperBound(bucket);
+			return bound < this->max ? bound : this->max;
+		}
+	}
+	return this->max;
+}
+
+
+std::size_t RtHistogram::getBucket(uint64_t value)
+{
+	if(value < sub_bucket_count)
+	{
+		// small values are recorded exactly
+		return value;
+	}
+
+	unsigned int magnitude = 63 - __builtin_clzll(value);
+	if(magnitude > max_magnitude)
+	{
+		return bucket_count - 1;
+	}
+
+	unsigned int shift = magnitude - sub_bucket_bits;
+	std::size_t sub_bucket = (value >> shift) - sub_bucket_count;
+	return sub_bucket_count * (shift + 1) + sub_bucket;
+}
+
+
+uint64_t RtHistogram::getBucketUpperBound(std::size_t bucket)
+{
+	if(bucket < sub_bucket_count)
+	{
+		return bucket;
+	}
+
+	unsigned int shift = bucket / sub_bucket_count - 1;
+	uint64_t sub_bucket = bucket % sub_bucket_count;
+	uint64_t lower = (sub_bucket_count + sub_bucket) << shift;
+	return lower + (UINT64_C(1) << shift) - 1;
+}
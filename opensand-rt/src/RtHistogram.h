@@ -0,0 +1,158 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file RtHistogram.h
+ * @author Viveris Technologies
+ * @brief  Fixed-size log-bucketed histogram of durations
+ *
+ */
+
+#ifndef RT_HISTOGRAM_H
+#define RT_HISTOGRAM_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+/**
+ * @class RtHistogram
+ * @brief Histogram of durations in microseconds with logarithmic buckets
+ *
+ * Each power of two is split into a fixed number of linear sub-buckets,
+ * as in HDR histograms, so the relative error on a recorded value is
+ * bounded whatever its magnitude while the memory stays constant.
+ */
+class RtHistogram
+{
+ public:
+	RtHistogram();
+
+	/**
+	 * @brief Record a duration
+	 *
+	 * @param value  The duration (us), negative values are recorded as 0
+	 */
+	void record(int64_t value);
+
+	/**
+	 * @brief Add the values recorded in another histogram
+	 *
+	 * @param other  The other histogram
+	 */
+	void merge(const RtHistogram &other);
+
+	/**
+	 * @brief Forget all the recorded values
+	 */
+	void reset(void);
+
+	/**
+	 * @brief Get the number of recorded values
+	 *
+	 * @return the number of recorded values
+	 */
+	uint64_t getCount(void) const { return this->count; };
+
+	/**
+	 * @brief Get the smallest recorded value
+	 *
+	 * @return the smallest recorded value, 0 if empty
+	 */
+	int64_t getMin(void) const { return this->min; };
+
+	/**
+	 * @brief Get the greatest recorded value
+	 *
+	 * @return the greatest recorded value, 0 if empty
+	 */
+	int64_t getMax(void) const { return this->max; };
+
+	/**
+	 * @brief Get the mean of the recorded values
+	 *
+	 * @return the mean, 0 if empty
+	 */
+	double getMean(void) const;
+
+	/**
+	 * @brief Get the value below which a percentage of the
+	 *        recorded values fall
+	 *
+	 * @param percentile  The percentage, between 0 and 100
+	 * @return the upper bound of the bucket holding the percentile,
+	 *         0 if empty
+	 */
+	int64_t getPercentile(double percentile) const;
+
+ private:
+	/// The number of bits of linear sub-buckets per power of two
+	static constexpr unsigned int sub_bucket_bits = 3;
+	/// The number of linear sub-buckets per power of two
+	static constexpr std::size_t sub_bucket_count = 1 << sub_bucket_bits;
+	/// The highest power of two tracked, greater values go in the last bucket
+	static constexpr unsigned int max_magnitude = 34;
+	/// The total number of buckets
+	static constexpr std::size_t bucket_count =
+		sub_bucket_count * (max_magnitude - sub_bucket_bits + 2);
+
+	/**
+	 * @brief Get the bucket holding a value
+	 *
+	 * @param value  The value
+	 * @return the bucket index
+	 */
+	static std::size_t getBucket(uint64_t value);
+
+	/**
+	 * @brief Get the greatest value held by a bucket
+	 *
+	 * @param bucket  The bucket index
+	 * @return the upper bound of the bucket
+	 */
+	static uint64_t getBucketUpperBound(std::size_t bucket);
+
+	/// The number of values recorded in each bucket
+	std::array<uint32_t, bucket_count> buckets;
+
+	/// The number of recorded values
+	uint64_t count;
+
+	/// The sum of the recorded values
+	uint64_t sum;
+
+	/// The smallest recorded value
+	int64_t min;
+
+	/// The greatest recorded value
+	int64_t max;
+};
+
+
+#endif
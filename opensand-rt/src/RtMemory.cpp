@@ -0,0 +1,445 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file RtMemory.cpp
+ * @author Viveris Technologies
+ * @brief  The memory of the channels rings and pools, allocated on the
+ *         NUMA nodes of the channels with optional huge pages
+ *
+ */
+
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+
+#include "RtMemory.h"
+
+
+namespace
+{
+
+/// The memory placement of a thread
+struct MemoryPolicy
+{
+	std::vector<int> nodes;
+	int mode;
+	bool huge_pages;
+};
+
+
+MemoryPolicy &getPolicy()
+{
+	static thread_local MemoryPolicy policy{{}, MPOL_DEFAULT, false};
+	return policy;
+}
+
+
+/// A buffer mapped and the NUMA node it is placed on, -1 if none
+/// or several
+struct Mapping
+{
+	std::size_t length;
+	int node;
+};
+
+
+/// The buffers mapped and the memory mapped on each node
+struct Mappings
+{
+	std::mutex mutex;
+	std::map<void *, Mapping> mappings;
+	std::map<int, std::size_t> allocated;
+};
+
+
+Mappings &getMappings()
+{
+	// never destroyed as the buffers may be released after the exit
+	static Mappings *mappings = new Mappings();
+	return *mappings;
+}
+
+
+/**
+ * @brief Build the mask of a list of NUMA nodes for the memory policy calls
+ *
+ * @param nodes  The nodes, all positive
+ * @param mask   OUT: the nodes mask
+ * @return the maxnode argument of the calls
+ */
+unsigned long buildMask(const std::vector<int> &nodes, std::vector<unsigned long> &mask)
+{
+	constexpr std::size_t bits_per_mask = sizeof(unsigned long) * CHAR_BIT;
+	for(int node: nodes)
+	{
+		std::size_t index = node / bits_per_mask;
+		if(mask.size() <= index)
+		{
+			mask.resize(index + 1, 0);
+		}
+		mask[index] |= 1UL << (node % bits_per_mask);
+	}
+	// the kernel ignores the last bit of maxnode
+	return mask.size() * bits_per_mask + 1;
+}
+
+
+/// The number of nodes in the masks read from the kernel
+constexpr std::size_t max_nodes = 1024;
+
+
+/**
+ * @brief Parse a sysfs list of CPUs such as "0-3,8"
+ *
+ * @param list    The list
+ * @param values  OUT: the CPUs
+ */
+void parseList(const char *list, std::vector<int> &values)
+{
+	while(*list != '\0' && *list != '\n')
+	{
+		char *end;
+		long first = strtol(list, &end, 10);
+		long last = first;
+		if(end == list)
+		{
+			return;
+		}
+		if(*end == '-')
+		{
+			list = end + 1;
+			last = strtol(list, &end, 10);
+		}
+		for(long value = first; value <= last; ++value)
+		{
+			values.push_back(value);
+		}
+		list = *end == ',' ? end + 1 : end;
+	}
+}
+
+
+/**
+ * @brief Get the NUMA node of a CPU
+ *
+ * @param cpu  The CPU
+ * @return the node listed in the CPU sysfs directory, -1 if unknown
+ */
+int getCpuNode(int cpu)
+{
+	char path[64];
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+	DIR *directory = opendir(path);
+	if(directory == nullptr)
+	{
+		return -1;
+	}
+	int node = -1;
+	struct dirent *entry;
+	while(node < 0 && (entry = readdir(directory)) != nullptr)
+	{
+		sscanf(entry->d_name, "node%d", &node);
+	}
+	closedir(directory);
+	return node;
+}
+
+}
+
+
+RtMemory::Scope::Scope(const rt_thread_placement_t &placement):
+	nodes{},
+	mode{MPOL_DEFAULT},
+	huge_pages{false},
+	thread_mode{MPOL_DEFAULT},
+	thread_mask{},
+	bound{false},
+	thread_cpus{},
+	pinned{false}
+{
+	MemoryPolicy &policy = getPolicy();
+	this->nodes.swap(policy.nodes);
+	this->mode = policy.mode;
+	this->huge_pages = policy.huge_pages;
+
+	policy.nodes = RtMemory::getNodes(placement);
+	policy.mode = placement.numa_nodes.empty() ? MPOL_PREFERRED : MPOL_BIND;
+	policy.huge_pages = placement.huge_pages;
+
+	// failures only leave the initialization structures on the
+	// current node, the buffers are still placed by allocate
+	if(!placement.cpus.empty() &&
+	   sched_getaffinity(0, sizeof(this->thread_cpus), &this->thread_cpus) == 0)
+	{
+		cpu_set_t cpu_set;
+		CPU_ZERO(&cpu_set);
+		for(int cpu: placement.cpus)
+		{
+			if(cpu >= 0 && cpu < CPU_SETSIZE)
+			{
+				CPU_SET(cpu, &cpu_set);
+			}
+		}
+		this->pinned = sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+	}
+	if(!policy.nodes.empty())
+	{
+		constexpr std::size_t bits_per_mask = sizeof(unsigned long) * CHAR_BIT;
+		this->thread_mask.resize(max_nodes / bits_per_mask, 0);
+		if(syscall(SYS_get_mempolicy, &this->thread_mode, this->thread_mask.data(),
+		           max_nodes, nullptr, 0) == 0)
+		{
+			std::vector<unsigned long> mask;
+			unsigned long maxnode = buildMask(policy.nodes, mask);
+			this->bound = syscall(SYS_set_mempolicy, policy.mode, mask.data(), maxnode) == 0;
+		}
+	}
+}
+
+
+RtMemory::Scope::~Scope()
+{
+	if(this->bound)
+	{
+		syscall(SYS_set_mempolicy, this->thread_mode, this->thread_mask.data(), max_nodes);
+	}
+	if(this->pinned)
+	{
+		sched_setaffinity(0, sizeof(this->thread_cpus), &this->thread_cpus);
+	}
+
+	MemoryPolicy &policy = getPolicy();
+	policy.nodes.swap(this->nodes);
+	policy.mode = this->mode;
+	policy.huge_pages = this->huge_pages;
+}
+
+
+std::vector<int> RtMemory::getNodes(const rt_thread_placement_t &placement)
+{
+	if(!placement.numa_nodes.empty())
+	{
+		return placement.numa_nodes;
+	}
+
+	// the node of the CPUs is only preferred when they all share it
+	std::vector<int> nodes;
+	for(int cpu: placement.cpus)
+	{
+		int node = getCpuNode(cpu);
+		if(node < 0 || (!nodes.empty() && nodes.front() != node))
+		{
+			return {};
+		}
+		nodes = {node};
+	}
+	return nodes;
+}
+
+
+std::vector<int> RtMemory::getThreadNodes(void)
+{
+	return getPolicy().nodes;
+}
+
+
+std::vector<int> RtMemory::getNodeCpus(int node)
+{
+	std::vector<int> cpus;
+	char path[64];
+	snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+	FILE *file = fopen(path, "r");
+	if(file == nullptr)
+	{
+		return cpus;
+	}
+	char list[4096];
+	if(fgets(list, sizeof(list), file) != nullptr)
+	{
+		parseList(list, cpus);
+	}
+	fclose(file);
+	return cpus;
+}
+
+
+std::size_t RtMemory::getNodeUsedMemory(int node)
+{
+	char path[64];
+	snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/meminfo", node);
+	FILE *file = fopen(path, "r");
+	if(file == nullptr)
+	{
+		return 0;
+	}
+	char line[128];
+	unsigned long used = 0;
+	while(fgets(line, sizeof(line), file) != nullptr &&
+	      sscanf(line, "Node %*d MemUsed: %lu kB", &used) != 1)
+	{
+	}
+	fclose(file);
+	return used;
+}
+
+
+std::size_t RtMemory::getNodeAllocatedMemory(int node)
+{
+	Mappings &mappings = getMappings();
+	std::lock_guard<std::mutex> lock{mappings.mutex};
+	auto allocated = mappings.allocated.find(node);
+	return allocated != mappings.allocated.end() ? allocated->second : 0;
+}
+
+
+bool RtMemory::bindThread(const rt_thread_placement_t &placement)
+{
+	for(int node: placement.numa_nodes)
+	{
+		if(node < 0)
+		{
+			errno = EINVAL;
+			return false;
+		}
+	}
+
+	MemoryPolicy &policy = getPolicy();
+	policy.nodes = RtMemory::getNodes(placement);
+	policy.mode = placement.numa_nodes.empty() ? MPOL_PREFERRED : MPOL_BIND;
+	policy.huge_pages = placement.huge_pages;
+	if(policy.nodes.empty())
+	{
+		return true;
+	}
+
+	// use the syscall directly to avoid depending on libnuma
+	std::vector<unsigned long> mask;
+	unsigned long maxnode = buildMask(policy.nodes, mask);
+	return syscall(SYS_set_mempolicy, policy.mode, mask.data(), maxnode) == 0;
+}
+
+
+void *RtMemory::allocate(std::size_t size)
+{
+	const MemoryPolicy &policy = getPolicy();
+	bool huge = policy.huge_pages && size >= huge_page_size / 2;
+	std::size_t page_size = huge ? huge_page_size : sysconf(_SC_PAGESIZE);
+	std::size_t length = std::max<std::size_t>((size + page_size - 1) / page_size, 1) * page_size;
+
+	void *memory = MAP_FAILED;
+	if(huge)
+	{
+		memory = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+		              MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	}
+	if(memory == MAP_FAILED && huge)
+	{
+		// no reserved huge pages, align the buffer on a huge page
+		// so it can be backed by transparent huge pages
+		void *mapping = mmap(nullptr, length + huge_page_size, PROT_READ | PROT_WRITE,
+		                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(mapping == MAP_FAILED)
+		{
+			return nullptr;
+		}
+		uintptr_t start = reinterpret_cast<uintptr_t>(mapping);
+		uintptr_t aligned = (start + huge_page_size - 1) & ~(huge_page_size - 1);
+		if(aligned > start)
+		{
+			munmap(mapping, aligned - start);
+		}
+		munmap(reinterpret_cast<void *>(aligned + length), start + huge_page_size - aligned);
+		memory = reinterpret_cast<void *>(aligned);
+		madvise(memory, length, MADV_HUGEPAGE);
+	}
+	else if(memory == MAP_FAILED)
+	{
+		memory = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+		              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(memory == MAP_FAILED)
+		{
+			return nullptr;
+		}
+	}
+
+	// the pages are placed when first touched, whatever the thread,
+	// a failure only leaves them on the node of this thread
+	if(!policy.nodes.empty())
+	{
+		std::vector<unsigned long> mask;
+		unsigned long maxnode = buildMask(policy.nodes, mask);
+		syscall(SYS_mbind, memory, length, policy.mode, mask.data(), maxnode, 0);
+	}
+
+	int node = policy.nodes.size() == 1 ? policy.nodes.front() : -1;
+	Mappings &mappings = getMappings();
+	std::lock_guard<std::mutex> lock{mappings.mutex};
+	mappings.mappings[memory] = {length, node};
+	mappings.allocated[node] += length;
+	return memory;
+}
+
+
+void RtMemory::release(void *memory)
+{
+	if(memory == nullptr)
+	{
+		return;
+	}
+
+	std::size_t length;
+	{
+		Mappings &mappings = getMappings();
+		std::lock_guard<std::mutex> lock{mappings.mutex};
+		auto mapping = mappings.mappings.find(memory);
+		if(mapping == mappings.mappings.end())
+		{
+			return;
+		}
+		length = mapping->second.length;
+		mappings.allocated[mapping->second.node] -= length;
+		mappings.mappings.erase(mapping);
+	}
+	munmap(memory, length);
+}
+
+
+bool RtMemory::hasHugePages(void)
+{
+	return getPolicy().huge_pages;
+}
@@ -0,0 +1,222 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file RtMemory.h
+ * @author Viveris Technologies
+ * @brief  The memory of the channels rings and pools, allocated on the
+ *         NUMA nodes of the channels with optional huge pages
+ *
+ */
+
+#ifndef RT_MEMORY_H
+#define RT_MEMORY_H
+
+#include <sched.h>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "Types.h"
+
+
+/**
+ * @class RtMemory
+ * @brief Allocate the long-lived buffers of a channel (fifos rings,
+ *        packets pools slabs) on the NUMA nodes it runs on
+ *
+ * The placement of a channel gives the NUMA nodes of its memory: the
+ * numa_nodes it is bound to, or else the node of the CPUs it is pinned
+ * on, which is then only preferred. The channel thread applies it with
+ * bindThread; the initialization of the channel, done by the main
+ * thread, applies it with a Scope, which also runs the thread on the
+ * CPUs of the channel and binds its memory so the structures built by
+ * the initialization (such as the spots of the DVB blocks) are placed
+ * with the channel. The buffers allocated by a thread
+ * are mapped on the nodes of its current placement and, if the
+ * placement asks so and the buffer spans at least half a huge page,
+ * backed by 2 MB huge pages (hugetlbfs pages when reserved,
+ * transparent huge pages otherwise).
+ */
+class RtMemory
+{
+ public:
+	/// The size of the huge pages backing the buffers
+	static constexpr std::size_t huge_page_size{2 * 1024 * 1024};
+
+	/**
+	 * @class Scope
+	 * @brief Use the placement of a channel for the buffers allocated
+	 *        by the calling thread until the scope is left
+	 */
+	class Scope
+	{
+	 public:
+		Scope(const rt_thread_placement_t &placement);
+		~Scope();
+
+	 private:
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+		std::vector<int> nodes;
+		int mode;
+		bool huge_pages;
+
+		/// The memory policy of the thread before the scope
+		int thread_mode;
+		std::vector<unsigned long> thread_mask;
+		bool bound;
+
+		/// The CPU affinity of the thread before the scope
+		cpu_set_t thread_cpus;
+		bool pinned;
+	};
+
+	/**
+	 * @brief Bind all the memory of the calling thread to the NUMA
+	 *        nodes of a channel placement and use the placement for
+	 *        its buffers
+	 *
+	 * @param placement  The placement of the channel of the thread
+	 * @return true on success, false otherwise with errno set
+	 */
+	static bool bindThread(const rt_thread_placement_t &placement);
+
+	/**
+	 * @brief Get the NUMA nodes a channel memory is placed on
+	 *
+	 * @param placement  The placement of the channel
+	 * @return the NUMA nodes, empty if the memory is not placed
+	 */
+	static std::vector<int> getNodes(const rt_thread_placement_t &placement);
+
+	/**
+	 * @brief Get the NUMA nodes the buffers of the calling thread are
+	 *        placed on
+	 *
+	 * @return the NUMA nodes, empty if the memory is not placed
+	 */
+	static std::vector<int> getThreadNodes(void);
+
+	/**
+	 * @brief Get the CPUs of a NUMA node
+	 *
+	 * @param node  The NUMA node
+	 * @return the CPUs listed in the node sysfs directory, empty if unknown
+	 */
+	static std::vector<int> getNodeCpus(int node);
+
+	/**
+	 * @brief Get the memory used on a NUMA node by the whole host
+	 *
+	 * @param node  The NUMA node
+	 * @return the used memory (kB), 0 if unknown
+	 */
+	static std::size_t getNodeUsedMemory(int node);
+
+	/**
+	 * @brief Get the memory of the buffers placed on a single NUMA node
+	 *
+	 * @param node  The NUMA node
+	 * @return the memory mapped for the buffers on the node (bytes)
+	 */
+	static std::size_t getNodeAllocatedMemory(int node);
+
+	/**
+	 * @brief Map a buffer with the placement of the calling thread
+	 *
+	 * @param size  The buffer size
+	 * @return the buffer, nullptr on failure
+	 */
+	static void *allocate(std::size_t size);
+
+	/**
+	 * @brief Unmap a buffer
+	 *
+	 * @param memory  The buffer returned by allocate, may be nullptr
+	 */
+	static void release(void *memory);
+
+	/**
+	 * @brief Check whether the buffers allocated by the calling thread
+	 *        are backed by huge pages, a pool should then carve its
+	 *        slabs in huge pages
+	 *
+	 * @return true if the calling thread placement uses huge pages
+	 */
+	static bool hasHugePages(void);
+};
+
+
+/**
+ * @class RtAllocator
+ * @brief Standard allocator for the rings of the channels, the
+ *        containers should be sized once by the channel initialization
+ */
+template<class T>
+struct RtAllocator
+{
+	using value_type = T;
+
+	RtAllocator() noexcept = default;
+
+	template<class U>
+	RtAllocator(const RtAllocator<U> &) noexcept {};
+
+	T *allocate(std::size_t n)
+	{
+		void *memory = RtMemory::allocate(n * sizeof(T));
+		if(memory == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+		return static_cast<T *>(memory);
+	};
+
+	void deallocate(T *ptr, std::size_t) noexcept
+	{
+		RtMemory::release(ptr);
+	};
+};
+
+
+template<class T, class U>
+bool operator ==(const RtAllocator<T> &, const RtAllocator<U> &) noexcept
+{
+	return true;
+}
+
+
+template<class T, class U>
+bool operator !=(const RtAllocator<T> &, const RtAllocator<U> &) noexcept
+{
+	return false;
+}
+
+
+#endif
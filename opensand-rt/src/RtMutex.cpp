@@ -38,25 +38,49 @@
 using InnerLock = std::unique_lock<std::mutex>;
 
 
-RtSemaphore::RtSemaphore(std::size_t initial_value):
+RtSemaphore::RtSemaphore(std::size_t initial_value, const std::string &site):
 	lock{},
 	condition{},
-	count{initial_value}
+	count{initial_value},
+	site{LockProfiler::getSite(site)},
+	waited{0},
+	acquired{0}
 {
 }
 
 
 void RtSemaphore::wait()
 {
+	bool profiled = LockProfiler::isEnabled();
+	uint64_t start = profiled ? LockProfiler::now() : 0;
   InnerLock take{lock};
 	condition.wait(take, [this]() {return count != 0;});
 	--count;
+	if(profiled)
+	{
+		acquired = LockProfiler::now();
+		waited = acquired - start;
+	}
 }
 
 
 void RtSemaphore::notify()
 {
-	InnerLock take{lock};
-	++count;
-	condition.notify_one();
+	uint64_t wait = 0;
+	uint64_t hold = 0;
+	{
+		InnerLock take{lock};
+		++count;
+		condition.notify_one();
+		if(acquired != 0)
+		{
+			wait = waited;
+			hold = LockProfiler::now() - acquired;
+			acquired = 0;
+		}
+	}
+	if(hold != 0)
+	{
+		site->record(wait, hold);
+	}
 }
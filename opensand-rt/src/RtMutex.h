@@ -40,9 +40,13 @@
 #include <mutex>
 #include <condition_variable>
 
+#include <opensand_output/OutputMutex.h>
 
-using RtMutex = std::mutex;
-using RtLock = std::lock_guard<RtMutex>;
+
+/// the wait and hold times are recorded per site name when the
+/// lock profiling is enabled (see LockProfiler)
+using RtMutex = OutputMutex;
+using RtLock = OutputLock;
 
 
 /**
@@ -52,7 +56,11 @@ using RtLock = std::lock_guard<RtMutex>;
 class RtSemaphore
 {
  public:
-	RtSemaphore(std::size_t = 1);
+	/**
+	 * @param site  The name of the site the wait times and the times between
+	 *              a wait and the next notify are recorded in
+	 */
+	RtSemaphore(std::size_t = 1, const std::string &site = "rt.semaphore");
 
 	RtSemaphore(const RtSemaphore&) = delete;
 	RtSemaphore& operator =(const RtSemaphore&) = delete;
@@ -64,6 +72,11 @@ class RtSemaphore
 	std::mutex lock;
 	std::condition_variable condition;
   std::size_t count;
+
+	LockSite *site;
+	/// The wait time and the end of the last profiled wait
+	uint64_t waited;
+	uint64_t acquired;
 };
 
 
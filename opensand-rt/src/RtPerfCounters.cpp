@@ -0,0 +1,179 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file RtPerfCounters.cpp
+ * @author Viveris Technologies
+ * @brief  Hardware counters of a channel thread, per event type
+ *
+ */
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+
+#include "RtPerfCounters.h"
+
+
+RtPerfCounters::RtPerfCounters():
+	fds(),
+	started(),
+	running{false},
+	totals()
+{
+	this->fds.fill(-1);
+	this->reset();
+}
+
+
+RtPerfCounters::~RtPerfCounters()
+{
+	for(auto &&fd: this->fds)
+	{
+		if(fd >= 0)
+		{
+			close(fd);
+		}
+	}
+}
+
+
+bool RtPerfCounters::open(void)
+{
+	static const std::array<uint64_t, counters_count> configs{{
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES,
+	}};
+
+	for(std::size_t counter = 0; counter < counters_count; counter++)
+	{
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = configs[counter];
+		attr.read_format = PERF_FORMAT_GROUP;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		// the group is enabled at once when complete
+		attr.disabled = counter == 0;
+
+		// the calling thread, on any CPU
+		int leader = this->fds[0];
+		int fd = syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+		if(fd < 0)
+		{
+			return false;
+		}
+		this->fds[counter] = fd;
+	}
+	return ioctl(this->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) == 0;
+}
+
+
+void RtPerfCounters::start(void)
+{
+	this->running = this->read(this->started);
+}
+
+
+void RtPerfCounters::stop(EventType type)
+{
+	std::array<uint64_t, counters_count> values;
+	if(!this->running || !this->read(values))
+	{
+		return;
+	}
+	this->running = false;
+
+	totals_t &total = this->totals[type];
+	total.events++;
+	for(std::size_t counter = 0; counter < counters_count; counter++)
+	{
+		total.values[counter] += values[counter] - this->started[counter];
+	}
+}
+
+
+const RtPerfCounters::totals_t &RtPerfCounters::getTotals(EventType type) const
+{
+	return this->totals[type];
+}
+
+
+void RtPerfCounters::reset(void)
+{
+	for(auto &&total: this->totals)
+	{
+		total.events = 0;
+		total.values.fill(0);
+	}
+}
+
+
+const char *RtPerfCounters::getTypeName(EventType type)
+{
+	switch(type)
+	{
+		case EventType::NetSocket:
+			return "net_socket";
+		case EventType::Timer:
+			return "timer";
+		case EventType::Message:
+			return "message";
+		case EventType::Signal:
+			return "signal";
+		case EventType::File:
+			return "file";
+		case EventType::TcpListen:
+			return "tcp_listen";
+	}
+	return "unknown";
+}
+
+
+bool RtPerfCounters::read(std::array<uint64_t, counters_count> &values) const
+{
+	// the number of counters followed by their values
+	uint64_t group[counters_count + 1];
+	if(this->fds[0] < 0 ||
+	   ::read(this->fds[0], group, sizeof(group)) != sizeof(group) ||
+	   group[0] != counters_count)
+	{
+		return false;
+	}
+	for(std::size_t counter = 0; counter < counters_count; counter++)
+	{
+		values[counter] = group[counter + 1];
+	}
+	return true;
+}
@@ -0,0 +1,148 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file RtPerfCounters.h
+ * @author Viveris Technologies
+ * @brief  Hardware counters of a channel thread, per event type
+ *
+ */
+
+#ifndef RT_PERF_COUNTERS_H
+#define RT_PERF_COUNTERS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "Types.h"
+
+
+/**
+ * @class RtPerfCounters
+ * @brief A group of hardware counters of the calling thread, read around
+ *        the processing of the events and accumulated per event type
+ *
+ * The counters only measure the user space of the thread, so that they
+ * can be opened with the default perf_event_paranoid level.
+ */
+class RtPerfCounters
+{
+public:
+	/// The counters of the group
+	enum Counter
+	{
+		Cycles,
+		Instructions,
+		CacheMisses,
+		BranchMisses,
+	};
+	static constexpr std::size_t counters_count = BranchMisses + 1;
+
+	/// The number of event types the counters are accumulated for
+	static constexpr std::size_t event_types_count = EventType::TcpListen + 1;
+
+	/// The counters accumulated for an event type
+	struct totals_t
+	{
+		std::size_t events;
+		std::array<uint64_t, counters_count> values;
+	};
+
+	RtPerfCounters();
+	~RtPerfCounters();
+
+	RtPerfCounters(const RtPerfCounters &) = delete;
+	RtPerfCounters &operator=(const RtPerfCounters &) = delete;
+
+	/**
+	 * @brief Open and enable the counters of the calling thread
+	 *
+	 * @return true on success, false if the counters are not available
+	 */
+	bool open(void);
+
+	/**
+	 * @brief Read the counters before processing an event
+	 */
+	void start(void);
+
+	/**
+	 * @brief Read the counters after processing an event
+	 *        and add them to the totals of its type
+	 *
+	 * @param type  The type of the processed event
+	 */
+	void stop(EventType type);
+
+	/**
+	 * @brief Get the counters accumulated for an event type
+	 *        since the last reset
+	 *
+	 * @param type  The event type
+	 * @return the accumulated counters
+	 */
+	const totals_t &getTotals(EventType type) const;
+
+	/**
+	 * @brief Reset the accumulated counters
+	 */
+	void reset(void);
+
+	/**
+	 * @brief Get the name of an event type, to name its probes
+	 *
+	 * @param type  The event type
+	 * @return the event type name
+	 */
+	static const char *getTypeName(EventType type);
+
+private:
+	/**
+	 * @brief Read the values of the group
+	 *
+	 * @param values  OUT: the current values of the counters
+	 * @return true on success, false otherwise
+	 */
+	bool read(std::array<uint64_t, counters_count> &values) const;
+
+	/// the counters file descriptors, the first one leads the group
+	std::array<int, counters_count> fds;
+
+	/// the values read before processing the current event
+	std::array<uint64_t, counters_count> started;
+
+	/// whether the values were read before processing the current event
+	bool running;
+
+	/// the accumulated counters, per event type
+	std::array<totals_t, event_types_count> totals;
+};
+
+
+#endif
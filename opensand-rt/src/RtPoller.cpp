@@ -0,0 +1,334 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file RtPoller.cpp
+ * @author Viveris Technologies
+ * @brief  The file descriptors pollers used by the channels event loop
+ *
+ */
+
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <algorithm>
+#include <cerrno>
+
+#include "RtPoller.h"
+#include "RtEvent.h"
+
+
+std::unique_ptr<RtPoller> RtPoller::create(PollerType type)
+{
+	if(type == PollerType::Epoll)
+	{
+		std::unique_ptr<RtEpollPoller> poller{new RtEpollPoller()};
+		if(poller->init())
+		{
+			return poller;
+		}
+	}
+
+	std::unique_ptr<RtSelectPoller> poller{new RtSelectPoller()};
+	if(!poller->init())
+	{
+		return nullptr;
+	}
+	return poller;
+}
+
+
+RtPoller::RtPoller():
+	wake_fd{-1}
+{
+}
+
+
+RtPoller::~RtPoller()
+{
+	if(this->wake_fd >= 0)
+	{
+		close(this->wake_fd);
+	}
+}
+
+
+bool RtPoller::initWakeUp(void)
+{
+	this->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	return this->wake_fd >= 0;
+}
+
+
+bool RtPoller::wakeUp(void)
+{
+	uint64_t count = 1;
+	// a full counter is already readable
+	return write(this->wake_fd, &count, sizeof(count)) == sizeof(count) ||
+	       errno == EAGAIN;
+}
+
+
+void RtPoller::clearWakeUp(void)
+{
+	uint64_t count;
+	if(read(this->wake_fd, &count, sizeof(count)) < 0)
+	{
+		// already reset by a previous wait
+		return;
+	}
+}
+
+
+RtEpollPoller::RtEpollPoller():
+	RtPoller{},
+	epoll_fd{-1},
+	ready_events(1),
+	nb_fds{0},
+	always_ready{}
+{
+}
+
+
+RtEpollPoller::~RtEpollPoller()
+{
+	if(this->epoll_fd >= 0)
+	{
+		close(this->epoll_fd);
+	}
+}
+
+
+bool RtEpollPoller::init(void)
+{
+	this->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if(this->epoll_fd < 0 || !this->initWakeUp())
+	{
+		return false;
+	}
+
+	// the wake up eventfd is the only one without event
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.ptr = nullptr;
+	if(epoll_ctl(this->epoll_fd, EPOLL_CTL_ADD, this->wake_fd, &ev) != 0)
+	{
+		return false;
+	}
+	this->nb_fds++;
+	return true;
+}
+
+
+bool RtEpollPoller::addEvent(RtEvent *event)
+{
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.ptr = event;
+	if(epoll_ctl(this->epoll_fd, EPOLL_CTL_ADD, event->getFd(), &ev) != 0)
+	{
+		if(errno != EPERM)
+		{
+			return false;
+		}
+		// regular files do not support epoll but are always readable
+		this->always_ready.push_back(event);
+		return true;
+	}
+
+	this->nb_fds++;
+	if(this->ready_events.size() < this->nb_fds)
+	{
+		this->ready_events.resize(this->nb_fds);
+	}
+	return true;
+}
+
+
+bool RtEpollPoller::removeEvent(int32_t fd)
+{
+	// a non-null event is required by kernels older than 2.6.9
+	struct epoll_event ev{};
+	if(epoll_ctl(this->epoll_fd, EPOLL_CTL_DEL, fd, &ev) != 0)
+	{
+		auto it = std::find_if(this->always_ready.begin(),
+		                       this->always_ready.end(),
+		                       [fd](const RtEvent *event) { return *event == fd; });
+		if(it == this->always_ready.end())
+		{
+			return false;
+		}
+		this->always_ready.erase(it);
+		return true;
+	}
+
+	this->nb_fds--;
+	return true;
+}
+
+
+int32_t RtEpollPoller::wait(std::vector<RtEvent *> &ready, bool block)
+{
+	// do not block if some events are always ready
+	int32_t timeout = block && this->always_ready.empty() ? -1 : 0;
+	int32_t number_fd = epoll_wait(this->epoll_fd,
+	                               this->ready_events.data(),
+	                               this->ready_events.size(),
+	                               timeout);
+	if(number_fd < 0)
+	{
+		// interrupted by a signal, nothing is ready
+		return errno == EINTR ? 0 : -1;
+	}
+
+	for(int32_t index = 0; index < number_fd; ++index)
+	{
+		RtEvent *event = static_cast<RtEvent *>(this->ready_events[index].data.ptr);
+		if(event == nullptr)
+		{
+			this->clearWakeUp();
+			continue;
+		}
+		ready.push_back(event);
+	}
+	ready.insert(ready.end(), this->always_ready.begin(), this->always_ready.end());
+	return ready.size();
+}
+
+
+RtSelectPoller::RtSelectPoller():
+	RtPoller{},
+	events{},
+	max_input_fd{-1}
+{
+	FD_ZERO(&(this->input_fd_set));
+}
+
+
+bool RtSelectPoller::init(void)
+{
+	// eventfd used to break select when a new event is received
+	if(!this->initWakeUp())
+	{
+		return false;
+	}
+
+	FD_SET(this->wake_fd, &(this->input_fd_set));
+	this->max_input_fd = this->wake_fd;
+	return true;
+}
+
+
+bool RtSelectPoller::addEvent(RtEvent *event)
+{
+	int32_t fd = event->getFd();
+	if(fd >= FD_SETSIZE)
+	{
+		return false;
+	}
+
+	this->events[fd] = event;
+	FD_SET(fd, &(this->input_fd_set));
+	if(fd > this->max_input_fd)
+	{
+		this->max_input_fd = fd;
+	}
+
+	// break the select loop
+	return this->wakeUp();
+}
+
+
+bool RtSelectPoller::removeEvent(int32_t fd)
+{
+	auto it = this->events.find(fd);
+	if(it == this->events.end())
+	{
+		return false;
+	}
+
+	FD_CLR(fd, &(this->input_fd_set));
+	this->events.erase(it);
+	if(fd == this->max_input_fd)
+	{
+		this->updateMaxFd();
+	}
+	return true;
+}
+
+
+void RtSelectPoller::updateMaxFd(void)
+{
+	this->max_input_fd = this->wake_fd;
+	// update the greater fd
+	for(auto &&event: this->events)
+	{
+		if(event.first > this->max_input_fd)
+		{
+			this->max_input_fd = event.first;
+		}
+	}
+}
+
+
+int32_t RtSelectPoller::wait(std::vector<RtEvent *> &ready, bool block)
+{
+	fd_set readfds = this->input_fd_set;
+
+	struct timeval no_wait = {0, 0};
+	int32_t number_fd = select(this->max_input_fd + 1, &readfds, NULL, NULL,
+	                           block ? NULL : &no_wait);
+	if(number_fd < 0)
+	{
+		// interrupted by a signal, nothing is ready
+		return errno == EINTR ? 0 : -1;
+	}
+
+	int32_t handled = 0;
+
+	// check for select break
+	if(FD_ISSET(this->wake_fd, &readfds))
+	{
+		this->clearWakeUp();
+		handled++;
+	}
+
+	// unfortunately, FD_ISSET is the only usable thing
+	for(auto &&event_pair: this->events)
+	{
+		if(handled >= number_fd)
+		{
+			// all events treated, no need to continue the loop
+			break;
+		}
+		if(FD_ISSET(event_pair.first, &readfds))
+		{
+			ready.push_back(event_pair.second);
+			handled++;
+		}
+	}
+	return ready.size();
+}
@@ -0,0 +1,223 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file RtPoller.h
+ * @author Viveris Technologies
+ * @brief  The file descriptors pollers used by the channels event loop
+ *
+ */
+
+#ifndef RT_POLLER_H
+#define RT_POLLER_H
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/select.h>
+
+#include "Types.h"
+
+
+class RtEvent;
+
+
+/// The available pollers for the channels event loop
+enum class PollerType
+{
+	Epoll,   ///< epoll based poller, cost only depends on ready events
+	Select,  ///< select based poller, limited to FD_SETSIZE descriptors
+};
+
+
+/**
+ * @class RtPoller
+ * @brief Wait for a set of events file descriptors to be readable
+ *
+ * Events are registered once when they are added to the channel
+ * and unregistered when they are removed, the poller then only
+ * reports the events that are ready.
+ * Each poller also monitors one eventfd that only wakes up a blocked
+ * wait, for stop requests and changes of the monitored set.
+ */
+class RtPoller
+{
+ public:
+	virtual ~RtPoller();
+
+	/**
+	 * @brief Create a poller
+	 *        If the requested poller cannot be created
+	 *        the select poller is used as a fallback
+	 *
+	 * @param type  The requested poller type
+	 * @return the poller on success, nullptr otherwise
+	 */
+	static std::unique_ptr<RtPoller> create(PollerType type);
+
+	/**
+	 * @brief Get the poller type
+	 *
+	 * @return the poller type
+	 */
+	virtual PollerType getType(void) const = 0;
+
+	/**
+	 * @brief Start monitoring the file descriptor of an event
+	 *
+	 * @param event  The event to monitor
+	 * @return true on success, false otherwise
+	 */
+	virtual bool addEvent(RtEvent *event) = 0;
+
+	/**
+	 * @brief Stop monitoring a file descriptor
+	 *
+	 * @param fd  The file descriptor to stop monitoring
+	 * @return true on success, false otherwise
+	 */
+	virtual bool removeEvent(int32_t fd) = 0;
+
+	/**
+	 * @brief Wait for events to be ready
+	 *
+	 * @param ready  OUT: the events that are ready
+	 * @param block  Whether to wait for an event, or only collect
+	 *               the events that are already ready
+	 * @return the number of ready events, -1 on error
+	 */
+	virtual int32_t wait(std::vector<RtEvent *> &ready, bool block = true) = 0;
+
+	/**
+	 * @brief Wake up a blocked wait, it returns without any new
+	 *        ready event, this can be called from any thread
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool wakeUp(void);
+
+ protected:
+	RtPoller();
+
+	/**
+	 * @brief Create the wake up eventfd
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool initWakeUp(void);
+
+	/**
+	 * @brief Reset the wake up eventfd once it was reported readable
+	 */
+	void clearWakeUp(void);
+
+	/// The eventfd readable once wakeUp is called
+	int32_t wake_fd;
+};
+
+
+/**
+ * @class RtEpollPoller
+ * @brief Poller based on epoll, the ready file descriptors
+ *        directly give their event through the epoll data
+ */
+class RtEpollPoller: public RtPoller
+{
+ public:
+	RtEpollPoller();
+	~RtEpollPoller();
+
+	/**
+	 * @brief Create the epoll instance
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool init(void);
+
+	PollerType getType(void) const override { return PollerType::Epoll; };
+	bool addEvent(RtEvent *event) override;
+	bool removeEvent(int32_t fd) override;
+	int32_t wait(std::vector<RtEvent *> &ready, bool block) override;
+
+ private:
+	/// The epoll file descriptor
+	int32_t epoll_fd;
+
+	/// The buffer receiving ready events
+	std::vector<struct epoll_event> ready_events;
+
+	/// The number of monitored file descriptors
+	std::size_t nb_fds;
+
+	/// The events that epoll cannot monitor (regular files),
+	/// they are always ready as with select
+	std::vector<RtEvent *> always_ready;
+};
+
+
+/**
+ * @class RtSelectPoller
+ * @brief Poller based on select, kept as a fallback
+ */
+class RtSelectPoller: public RtPoller
+{
+ public:
+	RtSelectPoller();
+
+	/**
+	 * @brief Create the eventfd used to break select
+	 *        when the monitored set changes
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool init(void);
+
+	PollerType getType(void) const override { return PollerType::Select; };
+	bool addEvent(RtEvent *event) override;
+	bool removeEvent(int32_t fd) override;
+	int32_t wait(std::vector<RtEvent *> &ready, bool block) override;
+
+ private:
+	/**
+	 * @brief Update the maximum input fd after event removal
+	 */
+	void updateMaxFd(void);
+
+	/// The monitored events
+	std::map<int32_t, RtEvent *> events;
+
+	/// fd_set containing monitored input FDs
+	fd_set input_fd_set;
+
+	/// contains the highest FD of input events
+	int32_t max_input_fd;
+};
+
+
+#endif
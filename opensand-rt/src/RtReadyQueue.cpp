@@ -0,0 +1,159 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file RtReadyQueue.cpp
+ * @author Viveris Technologies
+ * @brief  The queue of the events ready to be processed by a channel
+ *
+ */
+
+#include "RtReadyQueue.h"
+#include "RtEvent.h"
+
+
+RtReadyQueue::RtReadyQueue():
+	heads{},
+	tails{},
+	bitmap{}
+{
+}
+
+
+bool RtReadyQueue::push(RtEvent *event)
+{
+	if(event->ready_queued)
+	{
+		return false;
+	}
+
+	const uint8_t priority = event->getPriority();
+	event->ready_queued = true;
+	event->ready_next = nullptr;
+	if(this->heads[priority] == nullptr)
+	{
+		this->heads[priority] = event;
+		this->bitmap[priority / word_bits] |= UINT64_C(1) << (priority % word_bits);
+	}
+	else
+	{
+		this->tails[priority]->ready_next = event;
+	}
+	this->tails[priority] = event;
+	return true;
+}
+
+
+RtEvent *RtReadyQueue::front(void) const
+{
+	for(std::size_t word = 0; word < this->bitmap.size(); ++word)
+	{
+		if(this->bitmap[word] != 0)
+		{
+			return this->heads[word * word_bits + __builtin_ctzll(this->bitmap[word])];
+		}
+	}
+	return nullptr;
+}
+
+
+RtEvent *RtReadyQueue::pop(void)
+{
+	RtEvent *event = this->front();
+	if(event == nullptr)
+	{
+		return nullptr;
+	}
+
+	const uint8_t priority = event->getPriority();
+	this->heads[priority] = event->ready_next;
+	if(event->ready_next == nullptr)
+	{
+		this->tails[priority] = nullptr;
+		this->bitmap[priority / word_bits] &= ~(UINT64_C(1) << (priority % word_bits));
+	}
+	event->ready_queued = false;
+	event->ready_next = nullptr;
+	return event;
+}
+
+
+void RtReadyQueue::remove(RtEvent *event)
+{
+	if(!event->ready_queued)
+	{
+		return;
+	}
+
+	// only the rare removal of a deferred event walks its list
+	const uint8_t priority = event->getPriority();
+	RtEvent *previous = nullptr;
+	for(RtEvent *current = this->heads[priority];
+	    current != event;
+	    current = current->ready_next)
+	{
+		previous = current;
+	}
+	if(previous == nullptr)
+	{
+		this->heads[priority] = event->ready_next;
+	}
+	else
+	{
+		previous->ready_next = event->ready_next;
+	}
+	if(this->tails[priority] == event)
+	{
+		this->tails[priority] = previous;
+	}
+	if(this->heads[priority] == nullptr)
+	{
+		this->bitmap[priority / word_bits] &= ~(UINT64_C(1) << (priority % word_bits));
+	}
+	event->ready_queued = false;
+	event->ready_next = nullptr;
+}
+
+
+bool RtReadyQueue::contains(const RtEvent *event) const
+{
+	return event->ready_queued;
+}
+
+
+bool RtReadyQueue::empty(void) const
+{
+	for(auto &&word: this->bitmap)
+	{
+		if(word != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,122 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+
+/**
+ * @file RtReadyQueue.h
+ * @author Viveris Technologies
+ * @brief  The queue of the events ready to be processed by a channel
+ *
+ */
+
+#ifndef RT_READY_QUEUE_H
+#define RT_READY_QUEUE_H
+
+#include <array>
+#include <cstdint>
+
+
+class RtEvent;
+
+
+/**
+ * @class RtReadyQueue
+ * @brief The events ready to be processed, ordered by priority
+ *
+ * The events are linked in one list per priority, in the order they
+ * became ready, and a bitmap tells which lists are not empty: queuing
+ * an event and getting the most important one do not depend on the
+ * number of queued events.
+ */
+class RtReadyQueue
+{
+ public:
+	RtReadyQueue();
+
+	/**
+	 * @brief Queue an event after the ready events of its priority
+	 *
+	 * @param event  The event
+	 * @return true if the event is queued, false if it already was
+	 */
+	bool push(RtEvent *event);
+
+	/**
+	 * @brief Get the most important ready event, the one with the
+	 *        smallest priority that became ready first
+	 *
+	 * @return the event, nullptr if the queue is empty
+	 */
+	RtEvent *front(void) const;
+
+	/**
+	 * @brief Remove the most important ready event
+	 *
+	 * @return the event, nullptr if the queue is empty
+	 */
+	RtEvent *pop(void);
+
+	/**
+	 * @brief Remove an event if it is queued
+	 *
+	 * @param event  The event
+	 */
+	void remove(RtEvent *event);
+
+	/**
+	 * @brief Check whether an event is queued
+	 *
+	 * @param event  The event
+	 * @return true if the event waits to be processed
+	 */
+	bool contains(const RtEvent *event) const;
+
+	/**
+	 * @brief Check whether the queue is empty
+	 *
+	 * @return true if no event is ready
+	 */
+	bool empty(void) const;
+
+ private:
+	/// the number of priorities
+	static constexpr std::size_t priorities = UINT8_MAX + 1;
+
+	/// the number of bits in a word of the bitmap
+	static constexpr std::size_t word_bits = 64;
+
+	/// the first and last events of each priority
+	std::array<RtEvent *, priorities> heads;
+	std::array<RtEvent *, priorities> tails;
+
+	/// the priorities with ready events
+	std::array<uint64_t, priorities / word_bits> bitmap;
+};
+
+
+#endif
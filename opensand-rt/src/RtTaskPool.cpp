@@ -0,0 +1,396 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file RtTaskPool.cpp
+ * @author Viveris Technologies
+ * @brief  A work-stealing pool of threads shared by the blocks for
+ *         their parallel computations
+ *
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <system_error>
+
+#include <opensand_output/Output.h>
+
+#include "RtTaskPool.h"
+#include "RtMemory.h"
+#include "Rt.h"
+
+
+/// The period of the workers utilisation probes
+constexpr std::chrono::seconds utilisation_period{1};
+
+/// The longest sleep of a worker without tasks, to report its utilisation
+constexpr std::chrono::milliseconds worker_sleep{100};
+
+/// The longest sleep of a thread waiting for a group, between two
+/// looks for queued tasks to run
+constexpr std::chrono::microseconds group_sleep{50};
+
+
+RtTaskPool::Worker::Worker():
+	lock{},
+	tasks{},
+	thread{},
+	busy_ns{0},
+	utilisation{nullptr}
+{
+}
+
+
+RtTaskPool::RtTaskPool():
+	workers{},
+	next_worker{0},
+	queued{0},
+	sleep_lock{},
+	wake_workers{},
+	stopping{false}
+{
+}
+
+
+RtTaskPool::~RtTaskPool()
+{
+	this->stop();
+}
+
+
+bool RtTaskPool::start(std::size_t workers, const rt_thread_placement_t &placement)
+{
+	if(!this->workers.empty())
+	{
+		return false;
+	}
+
+	this->stopping = false;
+	for(std::size_t index = 0; index < workers; ++index)
+	{
+		this->workers.emplace_back(new Worker());
+		this->workers.back()->utilisation =
+			Output::Get()->registerProbe<float>("%", true, SAMPLE_AVG,
+			                                    "Runtime.workers.%zu.utilisation", index);
+	}
+
+	for(std::size_t index = 0; index < workers; ++index)
+	{
+		// each worker runs on its own CPU of the placement
+		rt_thread_placement_t worker_placement = placement;
+		if(!placement.cpus.empty())
+		{
+			worker_placement.cpus = {placement.cpus[index % placement.cpus.size()]};
+		}
+		Worker *worker = this->workers[index].get();
+		try
+		{
+			worker->thread = std::thread{[this, worker, worker_placement, index]()
+			{
+				if(!worker_placement.cpus.empty())
+				{
+					cpu_set_t cpu_set;
+					CPU_ZERO(&cpu_set);
+					CPU_SET(worker_placement.cpus.front(), &cpu_set);
+					int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+					if(ret != 0)
+					{
+						Rt::reportError("workers", std::this_thread::get_id(), false,
+						                "cannot set worker %zu CPU affinity [%d: %s]",
+						                index, ret, strerror(ret));
+					}
+				}
+				if(worker_placement.policy != SCHED_OTHER)
+				{
+					struct sched_param param;
+					param.sched_priority = worker_placement.priority;
+					int ret = pthread_setschedparam(pthread_self(), worker_placement.policy, &param);
+					if(ret != 0)
+					{
+						Rt::reportError("workers", std::this_thread::get_id(), false,
+						                "cannot set worker %zu scheduling policy [%d: %s]",
+						                index, ret, strerror(ret));
+					}
+				}
+				if(!RtMemory::bindThread(worker_placement))
+				{
+					Rt::reportError("workers", std::this_thread::get_id(), false,
+					                "cannot bind worker %zu memory [%d: %s]",
+					                index, errno, strerror(errno));
+				}
+				this->loop(worker);
+			}};
+		}
+		catch(const std::system_error &error)
+		{
+			Rt::reportError("workers", std::this_thread::get_id(), true,
+			                "cannot start worker %zu: %s", index, error.what());
+			this->stop();
+			return false;
+		}
+	}
+	return true;
+}
+
+
+void RtTaskPool::stop(void)
+{
+	{
+		std::lock_guard<std::mutex> guard{this->sleep_lock};
+		this->stopping = true;
+	}
+	this->wake_workers.notify_all();
+	for(auto &&worker: this->workers)
+	{
+		if(worker->thread.joinable())
+		{
+			worker->thread.join();
+		}
+	}
+	this->workers.clear();
+}
+
+
+std::size_t RtTaskPool::size(void) const
+{
+	return this->workers.size();
+}
+
+
+void RtTaskPool::parallelFor(std::size_t begin, std::size_t end,
+                             const std::function<void(std::size_t)> &body,
+                             std::size_t grain)
+{
+	grain = std::max<std::size_t>(grain, 1);
+	if(end <= begin)
+	{
+		return;
+	}
+
+	RtTaskGroup group{*this};
+	for(std::size_t start = begin + grain; start < end; start += grain)
+	{
+		std::size_t stop = std::min(start + grain, end);
+		group.run([&body, start, stop]()
+		{
+			for(std::size_t index = start; index < stop; ++index)
+			{
+				body(index);
+			}
+		});
+	}
+	for(std::size_t index = begin; index < std::min(begin + grain, end); ++index)
+	{
+		body(index);
+	}
+	group.wait();
+}
+
+
+RtTaskPool::Worker *&RtTaskPool::current(void)
+{
+	static thread_local Worker *worker = nullptr;
+	return worker;
+}
+
+
+bool RtTaskPool::push(Task &&task)
+{
+	if(this->workers.empty() || this->stopping)
+	{
+		return false;
+	}
+
+	// a worker keeps its own tasks, the channels spread theirs
+	Worker *worker = current();
+	if(worker == nullptr)
+	{
+		worker = this->workers[this->next_worker++ % this->workers.size()].get();
+	}
+	{
+		std::lock_guard<std::mutex> guard{worker->lock};
+		worker->tasks.push_back(std::move(task));
+	}
+	this->queued++;
+	{
+		std::lock_guard<std::mutex> guard{this->sleep_lock};
+	}
+	this->wake_workers.notify_one();
+	return true;
+}
+
+
+bool RtTaskPool::runOne(Worker *worker)
+{
+	if(this->queued == 0)
+	{
+		return false;
+	}
+
+	Task task;
+	bool found = false;
+	if(worker != nullptr)
+	{
+		// the last task pushed is the hottest in cache
+		std::lock_guard<std::mutex> guard{worker->lock};
+		if(!worker->tasks.empty())
+		{
+			task = std::move(worker->tasks.back());
+			worker->tasks.pop_back();
+			found = true;
+		}
+	}
+	std::size_t count = this->workers.size();
+	std::size_t first = this->next_worker.load();
+	for(std::size_t offset = 0; !found && offset < count; ++offset)
+	{
+		// steal the oldest task of another worker
+		Worker *victim = this->workers[(first + offset) % count].get();
+		std::lock_guard<std::mutex> guard{victim->lock};
+		if(!victim->tasks.empty())
+		{
+			task = std::move(victim->tasks.front());
+			victim->tasks.pop_front();
+			found = true;
+		}
+	}
+	if(!found)
+	{
+		return false;
+	}
+	this->queued--;
+
+	if(worker != nullptr)
+	{
+		auto start = std::chrono::steady_clock::now();
+		task.function();
+		worker->busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - start).count();
+	}
+	else
+	{
+		task.function();
+	}
+	task.group->done();
+	return true;
+}
+
+
+void RtTaskPool::loop(Worker *worker)
+{
+	current() = worker;
+	auto report = std::chrono::steady_clock::now();
+	while(true)
+	{
+		bool ran = this->runOne(worker);
+
+		auto now = std::chrono::steady_clock::now();
+		if(now - report >= utilisation_period && worker->utilisation)
+		{
+			auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - report).count();
+			worker->utilisation->put(100.0 * worker->busy_ns / elapsed);
+			worker->busy_ns = 0;
+			report = now;
+		}
+		if(ran)
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> guard{this->sleep_lock};
+		if(this->stopping && this->queued == 0)
+		{
+			return;
+		}
+		this->wake_workers.wait_for(guard, worker_sleep, [this]()
+		{
+			return this->stopping || this->queued > 0;
+		});
+	}
+}
+
+
+RtTaskGroup::RtTaskGroup(RtTaskPool &pool):
+	pool{pool},
+	pending{0},
+	lock{},
+	finished{}
+{
+}
+
+
+RtTaskGroup::~RtTaskGroup()
+{
+	this->wait();
+}
+
+
+void RtTaskGroup::run(std::function<void()> function)
+{
+	this->pending++;
+	RtTaskPool::Task task{std::move(function), this};
+	if(!this->pool.push(std::move(task)))
+	{
+		// the task was not moved
+		task.function();
+		this->done();
+	}
+}
+
+
+void RtTaskGroup::wait(void)
+{
+	while(this->pending > 0)
+	{
+		if(this->pool.runOne(RtTaskPool::current()))
+		{
+			continue;
+		}
+		std::unique_lock<std::mutex> guard{this->lock};
+		this->finished.wait_for(guard, group_sleep, [this]()
+		{
+			return this->pending == 0;
+		});
+	}
+	// wait for the last task to release the group
+	std::lock_guard<std::mutex> guard{this->lock};
+}
+
+
+void RtTaskGroup::done(void)
+{
+	// the group may be destroyed as soon as a waiter sees no pending
+	// task, the lock keeps it alive until the notification is sent
+	std::lock_guard<std::mutex> guard{this->lock};
+	if(--this->pending == 0)
+	{
+		this->finished.notify_all();
+	}
+}
@@ -0,0 +1,239 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file RtTaskPool.h
+ * @author Viveris Technologies
+ * @brief  A work-stealing pool of threads shared by the blocks for
+ *         their parallel computations
+ *
+ */
+
+#ifndef RT_TASK_POOL_H
+#define RT_TASK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Types.h"
+
+
+template<typename T>
+class Probe;
+class RtTaskGroup;
+
+
+/**
+ * @class RtTaskPool
+ * @brief The threads running the tasks of the channels
+ *
+ * Each worker owns a deque of tasks: it runs the last task it pushed
+ * first and, once its deque is empty, steals the oldest task of the
+ * others. The tasks pushed by a channel thread are spread over the
+ * workers. A thread waiting for a task group runs the queued tasks
+ * itself, so groups can be nested and a channel never waits for
+ * workers busy with other channels work while tasks are queued.
+ *
+ * Without workers (the pool is not started or is stopped), the tasks
+ * are run by the thread adding them. The tasks must not throw.
+ */
+class RtTaskPool
+{
+ public:
+	RtTaskPool();
+	~RtTaskPool();
+
+	RtTaskPool(const RtTaskPool &) = delete;
+	RtTaskPool &operator=(const RtTaskPool &) = delete;
+
+	/**
+	 * @brief Start the workers
+	 *
+	 * @param workers    The number of workers
+	 * @param placement  The placement of the workers: they are spread
+	 *                   over its CPUs, one CPU each, and their memory
+	 *                   is placed as a channel one
+	 * @return true on success, false otherwise
+	 */
+	bool start(std::size_t workers, const rt_thread_placement_t &placement);
+
+	/**
+	 * @brief Stop the workers once the queued tasks are run
+	 */
+	void stop(void);
+
+	/**
+	 * @brief Get the number of workers
+	 *
+	 * @return the number of workers, 0 if the tasks are run by the
+	 *         threads adding them
+	 */
+	std::size_t size(void) const;
+
+	/**
+	 * @brief Run a function on a range of indexes in parallel and
+	 *        wait for all of them, the calling thread takes its
+	 *        share of the range
+	 *
+	 * @param begin  The first index
+	 * @param end    The index after the last one
+	 * @param body   The function, called once with each index
+	 * @param grain  The number of consecutive indexes run by a task
+	 */
+	void parallelFor(std::size_t begin, std::size_t end,
+	                 const std::function<void(std::size_t)> &body,
+	                 std::size_t grain = 1);
+
+ private:
+	friend class RtTaskGroup;
+
+	struct Task
+	{
+		std::function<void()> function;
+		RtTaskGroup *group;
+	};
+
+	struct Worker
+	{
+		Worker();
+
+		std::mutex lock;
+		std::deque<Task> tasks;
+		std::thread thread;
+
+		/// The time spent running tasks since the last report (ns)
+		uint64_t busy_ns;
+		std::shared_ptr<Probe<float>> utilisation;
+	};
+
+	/**
+	 * @brief Queue a task of a group
+	 *
+	 * @param task  The task
+	 * @return false if the task must be run by the caller
+	 */
+	bool push(Task &&task);
+
+	/**
+	 * @brief Run one queued task, from the deque of a worker
+	 *        or from the others
+	 *
+	 * @param worker  The worker running the task, nullptr for
+	 *                a thread waiting for a group
+	 * @return true if a task was run, false if none is queued
+	 */
+	bool runOne(Worker *worker);
+
+	/**
+	 * @brief The worker of the calling thread
+	 *
+	 * @return the worker, nullptr if the thread is not a worker
+	 */
+	static Worker *&current(void);
+
+	/**
+	 * @brief The loop of a worker
+	 *
+	 * @param worker  The worker
+	 */
+	void loop(Worker *worker);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	/// The worker the next task of a channel is given to
+	std::atomic<std::size_t> next_worker;
+
+	/// The number of tasks queued on all the workers
+	std::atomic<std::size_t> queued;
+
+	/// Wake the workers once tasks are queued
+	std::mutex sleep_lock;
+	std::condition_variable wake_workers;
+	std::atomic<bool> stopping;
+};
+
+
+/**
+ * @class RtTaskGroup
+ * @brief A set of tasks run by a pool, which a channel waits for
+ */
+class RtTaskGroup
+{
+ public:
+	/**
+	 * @param pool  The pool running the tasks
+	 */
+	RtTaskGroup(RtTaskPool &pool);
+
+	/**
+	 * @brief Wait for the tasks before the group is released
+	 */
+	~RtTaskGroup();
+
+	RtTaskGroup(const RtTaskGroup &) = delete;
+	RtTaskGroup &operator=(const RtTaskGroup &) = delete;
+
+	/**
+	 * @brief Add a task to the group
+	 *
+	 * @param function  The task
+	 */
+	void run(std::function<void()> function);
+
+	/**
+	 * @brief Wait for all the tasks of the group, running the
+	 *        queued tasks meanwhile
+	 */
+	void wait(void);
+
+ private:
+	friend class RtTaskPool;
+
+	/**
+	 * @brief Count a finished task
+	 */
+	void done(void);
+
+	RtTaskPool &pool;
+
+	/// The tasks added and not finished
+	std::atomic<std::size_t> pending;
+
+	std::mutex lock;
+	std::condition_variable finished;
+};
+
+
+#endif
@@ -0,0 +1,363 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file RtTimerWheel.cpp
+ * @author Viveris Technologies
+ * @brief  The hierarchical timer wheel driving the timers of a channel
+ *
+ */
+
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include <cerrno>
+#include <ctime>
+
+#include "RtTimerWheel.h"
+#include "RtVirtualClock.h"
+#include "TimerEvent.h"
+
+
+constexpr uint64_t RtTimerWheel::tick_ns;
+constexpr uint64_t RtTimerWheel::no_tick;
+
+
+RtTimerWheel::RtTimerWheel():
+	RtEvent{EventType::Timer, "timer_wheel", -1, 0},
+	slots(),
+	occupied(),
+	due{nullptr},
+	current_tick{getTime() / tick_ns},
+	programmed_tick{no_tick},
+	expired{}
+{
+	this->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if(RtVirtualClock::isEnabled())
+	{
+		RtVirtualClock::addWheel(this);
+	}
+}
+
+
+RtTimerWheel::~RtTimerWheel()
+{
+	if(RtVirtualClock::isEnabled())
+	{
+		RtVirtualClock::removeWheel(this);
+	}
+}
+
+
+uint64_t RtTimerWheel::getTime(void)
+{
+	if(RtVirtualClock::isEnabled())
+	{
+		return RtVirtualClock::getTime();
+	}
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+
+void RtTimerWheel::arm(TimerEvent *timer, double duration_ms)
+{
+	uint64_t now = getTime();
+	uint64_t deadline = now;
+	if(duration_ms > 0)
+	{
+		deadline += static_cast<uint64_t>(duration_ms * 1000000);
+	}
+	this->schedule(timer, now, deadline);
+}
+
+
+void RtTimerWheel::armAligned(TimerEvent *timer, double period_ms)
+{
+	uint64_t period = static_cast<uint64_t>(period_ms * 1000000);
+	if(period == 0)
+	{
+		this->arm(timer, period_ms);
+		return;
+	}
+
+	// the next period boundary, missed boundaries are skipped
+	uint64_t now = getTime();
+	this->schedule(timer, now, (now / period + 1) * period);
+}
+
+
+void RtTimerWheel::schedule(TimerEvent *timer, uint64_t now, uint64_t deadline)
+{
+	if(timer->armed)
+	{
+		this->unlink(timer);
+	}
+
+	if(this->due == nullptr && this->getNextTick() == no_tick)
+	{
+		// nothing is armed, catch up with the current time
+		// to avoid useless cascades on the next wakeups
+		this->current_tick = now / tick_ns;
+	}
+
+	// round up so the timer never expires early
+	timer->expiry_tick = (deadline + tick_ns - 1) / tick_ns;
+	this->insert(timer);
+	this->program(false);
+}
+
+
+void RtTimerWheel::cancel(TimerEvent *timer)
+{
+	// the timerfd is not reprogrammed, a useless wakeup is cheaper
+	if(timer->armed)
+	{
+		this->unlink(timer);
+	}
+}
+
+
+bool RtTimerWheel::handle(void)
+{
+	uint64_t expirations;
+	if(read(this->fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN)
+	{
+		return false;
+	}
+
+	this->expired.clear();
+	this->programmed_tick = no_tick;
+	this->advance(getTime() / tick_ns);
+	this->program(true);
+	return true;
+}
+
+
+bool RtTimerWheel::isDue(void) const
+{
+	return this->programmed_tick != no_tick &&
+	       getTime() >= this->programmed_tick * tick_ns;
+}
+
+
+void RtTimerWheel::insert(TimerEvent *timer)
+{
+	TimerEvent **head;
+	uint64_t tick = timer->expiry_tick;
+	if(tick <= this->current_tick)
+	{
+		timer->wheel_level = -1;
+		head = &this->due;
+	}
+	else
+	{
+		// the level of the highest bits group differing from the current tick,
+		// the slot is then always ahead of the current one in this level
+		unsigned int level = (63 - __builtin_clzll(tick ^ this->current_tick)) / slot_bits;
+		unsigned int slot = (tick >> (level * slot_bits)) & (slot_count - 1);
+		timer->wheel_level = level;
+		timer->wheel_slot = slot;
+		head = &this->slots[level][slot];
+		this->occupied[level] |= UINT64_C(1) << slot;
+	}
+
+	timer->wheel_prev = nullptr;
+	timer->wheel_next = *head;
+	if(*head != nullptr)
+	{
+		(*head)->wheel_prev = timer;
+	}
+	*head = timer;
+	timer->armed = true;
+}
+
+
+void RtTimerWheel::unlink(TimerEvent *timer)
+{
+	TimerEvent **head = &this->due;
+	if(timer->wheel_level >= 0)
+	{
+		head = &this->slots[timer->wheel_level][timer->wheel_slot];
+	}
+
+	if(timer->wheel_prev != nullptr)
+	{
+		timer->wheel_prev->wheel_next = timer->wheel_next;
+	}
+	else
+	{
+		*head = timer->wheel_next;
+	}
+	if(timer->wheel_next != nullptr)
+	{
+		timer->wheel_next->wheel_prev = timer->wheel_prev;
+	}
+	if(timer->wheel_level >= 0 && *head == nullptr)
+	{
+		this->occupied[timer->wheel_level] &= ~(UINT64_C(1) << timer->wheel_slot);
+	}
+
+	timer->wheel_prev = nullptr;
+	timer->wheel_next = nullptr;
+	timer->armed = false;
+}
+
+
+uint64_t RtTimerWheel::getNextTick(void) const
+{
+	if(this->due != nullptr)
+	{
+		return this->current_tick;
+	}
+
+	uint64_t next = no_tick;
+	for(unsigned int level = 0; level < level_count; ++level)
+	{
+		if(this->occupied[level] == 0)
+		{
+			continue;
+		}
+		unsigned int shift = level * slot_bits;
+		unsigned int index = (this->current_tick >> shift) & (slot_count - 1);
+		uint64_t ahead = this->occupied[level] & ~((UINT64_C(2) << index) - 1);
+		if(ahead == 0)
+		{
+			continue;
+		}
+
+		// expiration tick on the first level, cascade tick on the others
+		unsigned int window_shift = shift + slot_bits;
+		uint64_t window = 0;
+		if(window_shift < 64)
+		{
+			window = (this->current_tick >> window_shift) << window_shift;
+		}
+		uint64_t tick = window | (static_cast<uint64_t>(__builtin_ctzll(ahead)) << shift);
+		if(tick < next)
+		{
+			next = tick;
+		}
+	}
+	return next;
+}
+
+
+void RtTimerWheel::advance(uint64_t target)
+{
+	while(true)
+	{
+		uint64_t next = this->getNextTick();
+		if(next == no_tick || next > target)
+		{
+			break;
+		}
+		this->current_tick = next;
+
+		// cascade the upper levels slots beginning at the current tick
+		for(unsigned int level = level_count - 1; level > 0; --level)
+		{
+			unsigned int shift = level * slot_bits;
+			if(this->current_tick & ((UINT64_C(1) << shift) - 1))
+			{
+				continue;
+			}
+			unsigned int index = (this->current_tick >> shift) & (slot_count - 1);
+			TimerEvent *timer = this->slots[level][index];
+			this->slots[level][index] = nullptr;
+			this->occupied[level] &= ~(UINT64_C(1) << index);
+			while(timer != nullptr)
+			{
+				TimerEvent *next_timer = timer->wheel_next;
+				this->insert(timer);
+				timer = next_timer;
+			}
+		}
+
+		unsigned int index = this->current_tick & (slot_count - 1);
+		this->expire(this->slots[0][index]);
+		this->slots[0][index] = nullptr;
+		this->occupied[0] &= ~(UINT64_C(1) << index);
+
+		this->expire(this->due);
+		this->due = nullptr;
+	}
+
+	if(target > this->current_tick)
+	{
+		this->current_tick = target;
+	}
+}
+
+
+void RtTimerWheel::expire(TimerEvent *head)
+{
+	while(head != nullptr)
+	{
+		TimerEvent *next = head->wheel_next;
+		head->wheel_prev = nullptr;
+		head->wheel_next = nullptr;
+		head->armed = false;
+		this->expired.push_back(head);
+		head = next;
+	}
+}
+
+
+void RtTimerWheel::program(bool force)
+{
+	uint64_t next = this->getNextTick();
+	if(next == this->programmed_tick || (!force && next > this->programmed_tick))
+	{
+		return;
+	}
+
+	if(RtVirtualClock::isEnabled())
+	{
+		// the virtual clock wakes the channel up at the deadline
+		RtVirtualClock::setDeadline(this, next == no_tick ? UINT64_MAX : next * tick_ns);
+		this->programmed_tick = next;
+		return;
+	}
+
+	itimerspec timer_value{};
+	if(next != no_tick)
+	{
+		// a tick in the past, for due timers, expires immediately
+		uint64_t time_ns = next * tick_ns;
+		timer_value.it_value.tv_sec = time_ns / 1000000000;
+		timer_value.it_value.tv_nsec = time_ns % 1000000000;
+		if(time_ns == 0)
+		{
+			timer_value.it_value.tv_nsec = 1;
+		}
+	}
+	timerfd_settime(this->fd, TFD_TIMER_ABSTIME, &timer_value, NULL);
+	this->programmed_tick = next;
+}
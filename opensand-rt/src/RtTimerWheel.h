@@ -0,0 +1,205 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file RtTimerWheel.h
+ * @author Viveris Technologies
+ * @brief  The hierarchical timer wheel driving the timers of a channel
+ *
+ */
+
+#ifndef RT_TIMER_WHEEL_H
+#define RT_TIMER_WHEEL_H
+
+#include <array>
+#include <vector>
+
+#include "RtEvent.h"
+
+
+class TimerEvent;
+
+
+/**
+ * @class RtTimerWheel
+ * @brief Hierarchical timer wheel driven by a single timerfd
+ *
+ * Timers are stored in the slot of their expiration tick at the level
+ * of the highest bits group that differs from the current tick, so
+ * arming and cancelling are O(1). When the current tick reaches the
+ * beginning of a slot of an upper level, its timers cascade to the
+ * lower levels. The timerfd is programmed on the next non-empty slot
+ * and all the expired timers are collected on a single wakeup.
+ */
+class RtTimerWheel: public RtEvent
+{
+ public:
+	RtTimerWheel();
+	~RtTimerWheel();
+
+	/**
+	 * @brief Arm a timer, it is rearmed if it was already armed
+	 *
+	 * @param timer        The timer
+	 * @param duration_ms  The time before the timer expiration (ms),
+	 *                     the timer is due immediately if not positive
+	 */
+	void arm(TimerEvent *timer, double duration_ms);
+
+	/**
+	 * @brief Arm a timer on the next multiple of its period on the
+	 *        monotonic clock, so the timers of a same period expire
+	 *        together whatever the channel or the process
+	 *
+	 * @param timer      The timer
+	 * @param period_ms  The timer period (ms)
+	 */
+	void armAligned(TimerEvent *timer, double period_ms);
+
+	/**
+	 * @brief Cancel a timer, nothing is done if it is not armed
+	 *
+	 * @param timer  The timer
+	 */
+	void cancel(TimerEvent *timer);
+
+	/**
+	 * @brief Collect the expired timers and program the next wakeup
+	 *
+	 * @return true on success, false otherwise
+	 */
+	bool handle(void) override;
+
+	/**
+	 * @brief Get the timers collected by the last call to handle
+	 *
+	 * @return the expired timers
+	 */
+	const std::vector<RtEvent *> &getExpiredTimers(void) const {return this->expired;};
+
+	/**
+	 * @brief Check without system call whether the next wakeup is
+	 *        reached, the timers can then be handled before the
+	 *        timerfd is reported readable
+	 *
+	 * @return true if some timers may have expired
+	 */
+	bool isDue(void) const;
+
+ private:
+	/// The duration of a tick (ns)
+	static constexpr uint64_t tick_ns = 10000;
+	/// The number of bits of the tick indexing the slots of a level
+	static constexpr unsigned int slot_bits = 6;
+	/// The number of slots per level
+	static constexpr unsigned int slot_count = 1 << slot_bits;
+	/// The number of levels needed to cover 64 bits ticks
+	static constexpr unsigned int level_count = (64 + slot_bits - 1) / slot_bits;
+	/// No next tick
+	static constexpr uint64_t no_tick = UINT64_MAX;
+
+	/**
+	 * @brief Get the current monotonic time (ns)
+	 *
+	 * @return the current time
+	 */
+	static uint64_t getTime(void);
+
+	/**
+	 * @brief Arm a timer on a deadline
+	 *
+	 * @param timer     The timer
+	 * @param now       The current time (ns)
+	 * @param deadline  The expiration time (ns)
+	 */
+	void schedule(TimerEvent *timer, uint64_t now, uint64_t deadline);
+
+	/**
+	 * @brief Store an armed timer in the slot of its expiration tick
+	 *
+	 * @param timer  The timer
+	 */
+	void insert(TimerEvent *timer);
+
+	/**
+	 * @brief Remove an armed timer from its slot
+	 *
+	 * @param timer  The timer
+	 */
+	void unlink(TimerEvent *timer);
+
+	/**
+	 * @brief Get the first tick at which expirations or cascades happen
+	 *
+	 * @return the next tick, no_tick if no timer is armed
+	 */
+	uint64_t getNextTick(void) const;
+
+	/**
+	 * @brief Move the current tick, cascading the upper levels slots
+	 *        and collecting the expired timers on the way
+	 *
+	 * @param target  The new current tick
+	 */
+	void advance(uint64_t target);
+
+	/**
+	 * @brief Move the timers of a slot in the expired list
+	 *
+	 * @param head  The first timer of the slot
+	 */
+	void expire(TimerEvent *head);
+
+	/**
+	 * @brief Program the timerfd on the next tick
+	 *
+	 * @param force  Whether a later tick than the programmed one is applied
+	 */
+	void program(bool force);
+
+	/// The first timer of each slot of each level
+	std::array<std::array<TimerEvent *, slot_count>, level_count> slots;
+
+	/// The non-empty slots of each level
+	std::array<uint64_t, level_count> occupied;
+
+	/// The first of the timers that are due before the current tick
+	TimerEvent *due;
+
+	/// The tick up to which the expirations are collected
+	uint64_t current_tick;
+
+	/// The tick the timerfd is programmed on
+	uint64_t programmed_tick;
+
+	/// The timers collected by the last call to handle
+	std::vector<RtEvent *> expired;
+};
+
+
+#endif
@@ -0,0 +1,297 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file RtTrace.cpp
+ * @author Viveris Technologies
+ * @brief  The spans traced by the threads, exported in the Chrome
+ *         trace event format read by Perfetto
+ *
+ */
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <set>
+#include <vector>
+
+#include "RtTrace.h"
+
+
+namespace
+{
+
+/// An ended span
+struct SpanRecord
+{
+	const char *name;
+	int64_t start;
+	int64_t duration;
+};
+
+
+/**
+ * @brief The spans of a thread, only written by the thread; the export
+ *        drops the spans that may be overwritten while it reads them
+ */
+struct Ring
+{
+	Ring():
+		records{new (std::nothrow) SpanRecord[RtTrace::spans_per_thread]},
+		head{0},
+		first{0},
+		generation{0},
+		name{},
+		tid{syscall(SYS_gettid)}
+	{
+	};
+
+	std::unique_ptr<SpanRecord[]> records;
+	/// the number of spans written since the thread start
+	std::atomic<uint64_t> head;
+	/// the first span written since the tracing was enabled
+	std::atomic<uint64_t> first;
+	/// the tracing the spans from first belong to
+	std::atomic<uint64_t> generation;
+	/// the track name, guarded by the registry mutex
+	std::string name;
+	long tid;
+};
+
+
+/// The rings of all the threads and the interned names
+struct Registry
+{
+	std::mutex mutex;
+	std::vector<Ring *> rings;
+	std::set<std::string> names;
+	/// incremented each time the tracing is enabled
+	std::atomic<uint64_t> generation{0};
+};
+
+
+Registry &getRegistry()
+{
+	// never destroyed as the threads may trace until the exit
+	static Registry *registry = new Registry();
+	return *registry;
+}
+
+
+thread_local Ring *thread_ring = nullptr;
+thread_local std::string thread_name;
+
+
+/**
+ * @brief Get the ring of the calling thread, creating it if needed
+ *
+ * @return the ring, nullptr if it cannot be allocated
+ */
+Ring *getRing()
+{
+	if(thread_ring == nullptr)
+	{
+		Ring *ring = new (std::nothrow) Ring();
+		if(ring == nullptr || ring->records == nullptr)
+		{
+			delete ring;
+			return nullptr;
+		}
+		Registry &registry = getRegistry();
+		std::lock_guard<std::mutex> lock{registry.mutex};
+		ring->name = thread_name.empty() ? "thread " + std::to_string(ring->tid) : thread_name;
+		registry.rings.push_back(ring);
+		thread_ring = ring;
+	}
+	return thread_ring;
+}
+
+
+/**
+ * @brief Write a string in a JSON document
+ *
+ * @param file   The document
+ * @param value  The string
+ */
+void writeString(FILE *file, const char *value)
+{
+	fputc('"', file);
+	for(const char *c = value; *c != '\0'; ++c)
+	{
+		if(*c == '"' || *c == '\\')
+		{
+			fputc('\\', file);
+			fputc(*c, file);
+		}
+		else if(static_cast<unsigned char>(*c) < 0x20)
+		{
+			fprintf(file, "\\u%04x", *c);
+		}
+		else
+		{
+			fputc(*c, file);
+		}
+	}
+	fputc('"', file);
+}
+
+}
+
+
+std::atomic<bool> RtTrace::enabled{false};
+
+
+void RtTrace::enable(void)
+{
+	getRegistry().generation++;
+	enabled = true;
+}
+
+
+void RtTrace::disable(void)
+{
+	enabled = false;
+}
+
+
+void RtTrace::setThreadName(const std::string &name)
+{
+	thread_name = name;
+	if(thread_ring != nullptr)
+	{
+		Registry &registry = getRegistry();
+		std::lock_guard<std::mutex> lock{registry.mutex};
+		thread_ring->name = name;
+	}
+}
+
+
+const char *RtTrace::intern(const std::string &name)
+{
+	Registry &registry = getRegistry();
+	std::lock_guard<std::mutex> lock{registry.mutex};
+	return registry.names.insert(name).first->c_str();
+}
+
+
+int64_t RtTrace::now(void) noexcept
+{
+	auto date = std::chrono::steady_clock::now().time_since_epoch();
+	return std::max<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(date).count(), 1);
+}
+
+
+void RtTrace::record(const char *name, int64_t start) noexcept
+{
+	int64_t end = now();
+	Ring *ring = getRing();
+	if(ring == nullptr)
+	{
+		return;
+	}
+
+	uint64_t head = ring->head.load(std::memory_order_relaxed);
+	uint64_t generation = getRegistry().generation.load(std::memory_order_relaxed);
+	if(ring->generation.load(std::memory_order_relaxed) != generation)
+	{
+		// the spans of the previous tracing are not exported
+		ring->first.store(head, std::memory_order_relaxed);
+		ring->generation.store(generation, std::memory_order_relaxed);
+	}
+	ring->records[head % spans_per_thread] = {name, start, end - start};
+	ring->head.store(head + 1, std::memory_order_release);
+}
+
+
+bool RtTrace::write(const std::string &filename)
+{
+	FILE *file = fopen(filename.c_str(), "w");
+	if(file == nullptr)
+	{
+		return false;
+	}
+
+	Registry &registry = getRegistry();
+	std::lock_guard<std::mutex> lock{registry.mutex};
+	uint64_t generation = registry.generation.load(std::memory_order_relaxed);
+	pid_t pid = getpid();
+	std::vector<SpanRecord> spans;
+	fprintf(file, "{\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"opensand\"}}",
+	        pid);
+	for(const Ring *ring: registry.rings)
+	{
+		fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%ld,\"args\":{\"name\":",
+		        pid, ring->tid);
+		writeString(file, ring->name.c_str());
+		fprintf(file, "}}");
+		if(ring->generation.load(std::memory_order_relaxed) != generation)
+		{
+			// nothing traced by the thread since the tracing was enabled
+			continue;
+		}
+
+		uint64_t head = ring->head.load(std::memory_order_acquire);
+		uint64_t begin = ring->first.load(std::memory_order_relaxed);
+		if(head > spans_per_thread)
+		{
+			begin = std::max(begin, head - spans_per_thread);
+		}
+		spans.clear();
+		for(uint64_t index = begin; index < head; ++index)
+		{
+			spans.push_back(ring->records[index % spans_per_thread]);
+		}
+		// the thread may have overwritten the oldest spans meanwhile
+		uint64_t end = ring->head.load(std::memory_order_acquire);
+		std::size_t skipped = 0;
+		if(end >= spans_per_thread && end - spans_per_thread + 1 > begin)
+		{
+			skipped = std::min<std::size_t>(end - spans_per_thread + 1 - begin, spans.size());
+		}
+
+		for(std::size_t index = skipped; index < spans.size(); ++index)
+		{
+			const SpanRecord &span = spans[index];
+			fprintf(file, ",\n{\"name\":");
+			writeString(file, span.name);
+			fprintf(file, ",\"cat\":\"opensand\",\"ph\":\"X\",\"pid\":%d,\"tid\":%ld,"
+			        "\"ts\":%.3f,\"dur\":%.3f}",
+			        pid, ring->tid, span.start / 1000.0, span.duration / 1000.0);
+		}
+	}
+	fprintf(file, "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+	bool status = !ferror(file);
+	return fclose(file) == 0 && status;
+}
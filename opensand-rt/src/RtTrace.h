@@ -0,0 +1,162 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file RtTrace.h
+ * @author Viveris Technologies
+ * @brief  The spans traced by the threads, exported in the Chrome
+ *         trace event format read by Perfetto
+ *
+ */
+
+#ifndef RT_TRACE_H
+#define RT_TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+/**
+ * @class RtTrace
+ * @brief Trace scoped spans in per-thread rings while enabled
+ *
+ * A span is a static name with its start date and duration. Each
+ * thread writes the spans it ends in its own ring, without lock,
+ * and overwrites the oldest ones when the ring is full. The rings are
+ * exported as a JSON trace, one track per thread named after its
+ * channel, that chrome://tracing and the Perfetto UI open. While the
+ * tracing is disabled a span only reads a flag.
+ */
+class RtTrace
+{
+ public:
+	/// The number of spans kept per thread
+	static constexpr std::size_t spans_per_thread{1 << 16};
+
+	/**
+	 * @class Span
+	 * @brief Trace the scope it lives in
+	 */
+	class Span
+	{
+	 public:
+		/**
+		 * @brief Start a span
+		 *
+		 * @param name  The span name, it must outlive the trace export
+		 */
+		explicit Span(const char *name) noexcept:
+			name{name},
+			start{RtTrace::isEnabled() ? RtTrace::now() : 0}
+		{
+		};
+
+		~Span()
+		{
+			if(this->start != 0)
+			{
+				RtTrace::record(this->name, this->start);
+			}
+		};
+
+	 private:
+		Span(const Span &) = delete;
+		Span &operator=(const Span &) = delete;
+
+		const char *name;
+		int64_t start;
+	};
+
+	/**
+	 * @brief Start tracing, the spans traced before are dropped
+	 */
+	static void enable(void);
+
+	/**
+	 * @brief Stop tracing, the traced spans are kept for the export
+	 */
+	static void disable(void);
+
+	/**
+	 * @brief Check whether the spans are traced
+	 *
+	 * @return true if the tracing is enabled
+	 */
+	static bool isEnabled(void)
+	{
+		return enabled.load(std::memory_order_relaxed);
+	};
+
+	/**
+	 * @brief Name the track of the calling thread
+	 *
+	 * @param name  The thread name, usually its channel
+	 */
+	static void setThreadName(const std::string &name);
+
+	/**
+	 * @brief Get a name kept until the exit for the spans of a
+	 *        dynamic object, such as an event
+	 *
+	 * @param name  The name
+	 * @return the kept copy of the name
+	 */
+	static const char *intern(const std::string &name);
+
+	/**
+	 * @brief Write the traced spans of all the threads
+	 *
+	 * @param filename  The JSON trace file
+	 * @return true on success, false otherwise with errno set
+	 */
+	static bool write(const std::string &filename);
+
+ private:
+	/**
+	 * @brief Get the current date of the spans
+	 *
+	 * @return the date (ns), never 0
+	 */
+	static int64_t now(void) noexcept;
+
+	/**
+	 * @brief Add an ended span in the ring of the calling thread
+	 *
+	 * @param name   The span name
+	 * @param start  The span start date (ns)
+	 */
+	static void record(const char *name, int64_t start) noexcept;
+
+	/// whether the spans are traced
+	static std::atomic<bool> enabled;
+};
+
+
+#endif
@@ -0,0 +1,229 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file RtVirtualClock.cpp
+ * @author Viveris Technologies
+ * @brief  The simulated time driving the timers of all the channels
+ *
+ */
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <csignal>
+#include <ctime>
+#include <map>
+
+#include "RtVirtualClock.h"
+#include "RtTimerWheel.h"
+#include "RtMutex.h"
+
+
+/// The state of a timer wheel driven by the clock
+struct virtual_wheel_t
+{
+	/// the next expiration (ns), UINT64_MAX if no timer is armed
+	uint64_t deadline;
+	/// whether the channel of the wheel sleeps
+	bool idle;
+};
+
+/// The wheels and the number of idle ones, protected by the lock
+struct virtual_clock_state_t
+{
+	RtMutex lock;
+	std::map<RtTimerWheel *, virtual_wheel_t> wheels;
+	std::size_t idle_wheels;
+	/// the end of the scenario (ns), UINT64_MAX if none
+	uint64_t limit;
+	/// whether the end was reached and the process stopped
+	bool over;
+};
+
+/**
+ * @brief Get the state of the clock, never released as the channels
+ *        may be destroyed with the other static objects
+ *
+ * @return the state
+ */
+static virtual_clock_state_t &getState(void)
+{
+	static virtual_clock_state_t *state = new virtual_clock_state_t{{"rt.virtual_clock"}, {}, 0, UINT64_MAX, false};
+	return *state;
+}
+
+
+bool RtVirtualClock::enabled = false;
+std::atomic<uint64_t> RtVirtualClock::now{0};
+std::atomic<std::size_t> RtVirtualClock::pending{0};
+
+
+void RtVirtualClock::enable(void)
+{
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	now.store(static_cast<uint64_t>(start.tv_sec) * 1000000000 + start.tv_nsec,
+	          std::memory_order_release);
+	enabled = true;
+}
+
+
+void RtVirtualClock::setLimit(uint64_t duration_ns)
+{
+	virtual_clock_state_t &clock = getState();
+	RtLock lock{clock.lock};
+	clock.limit = getTime() + duration_ns;
+}
+
+
+void RtVirtualClock::addWheel(RtTimerWheel *wheel)
+{
+	virtual_clock_state_t &clock = getState();
+	RtLock lock{clock.lock};
+	clock.wheels[wheel] = {UINT64_MAX, false};
+}
+
+
+void RtVirtualClock::removeWheel(RtTimerWheel *wheel)
+{
+	virtual_clock_state_t &clock = getState();
+	RtLock lock{clock.lock};
+	auto it = clock.wheels.find(wheel);
+	if(it == clock.wheels.end())
+	{
+		return;
+	}
+	if(it->second.idle)
+	{
+		--clock.idle_wheels;
+	}
+	clock.wheels.erase(it);
+}
+
+
+void RtVirtualClock::setDeadline(RtTimerWheel *wheel, uint64_t deadline)
+{
+	virtual_clock_state_t &clock = getState();
+	RtLock lock{clock.lock};
+	clock.wheels[wheel].deadline = deadline;
+}
+
+
+void RtVirtualClock::idle(RtTimerWheel *wheel)
+{
+	virtual_clock_state_t &clock = getState();
+	RtLock lock{clock.lock};
+	virtual_wheel_t &state = clock.wheels[wheel];
+	if(state.deadline <= getTime())
+	{
+		// timers are already due, the channel does not sleep
+		wake(wheel);
+		return;
+	}
+
+	state.idle = true;
+	++clock.idle_wheels;
+	if(clock.idle_wheels == clock.wheels.size() &&
+	   pending.load(std::memory_order_acquire) == 0)
+	{
+		advance();
+	}
+}
+
+
+void RtVirtualClock::busy(RtTimerWheel *wheel)
+{
+	virtual_clock_state_t &clock = getState();
+	RtLock lock{clock.lock};
+	virtual_wheel_t &state = clock.wheels[wheel];
+	if(state.idle)
+	{
+		state.idle = false;
+		--clock.idle_wheels;
+	}
+}
+
+
+void RtVirtualClock::advance(void)
+{
+	virtual_clock_state_t &clock = getState();
+	if(clock.over)
+	{
+		return;
+	}
+	uint64_t next = UINT64_MAX;
+	for(auto &&wheel_pair: clock.wheels)
+	{
+		next = std::min(next, wheel_pair.second.deadline);
+	}
+	if(next == UINT64_MAX)
+	{
+		// nothing will ever happen, unless from outside the process
+		return;
+	}
+	if(next > clock.limit)
+	{
+		// the scenario is over, the process stops as on a signal
+		clock.over = true;
+		kill(getpid(), SIGTERM);
+		return;
+	}
+
+	if(next > getTime())
+	{
+		now.store(next, std::memory_order_release);
+	}
+	for(auto &&wheel_pair: clock.wheels)
+	{
+		if(wheel_pair.second.deadline <= next)
+		{
+			wake(wheel_pair.first);
+		}
+	}
+}
+
+
+void RtVirtualClock::wake(RtTimerWheel *wheel)
+{
+	virtual_clock_state_t &clock = getState();
+	virtual_wheel_t &state = clock.wheels[wheel];
+	if(state.idle)
+	{
+		// the channel is busy as soon as it is woken up, so the clock
+		// does not move again before it handles its timers
+		state.idle = false;
+		--clock.idle_wheels;
+	}
+	// the deadline is set again once the timers are handled
+	state.deadline = UINT64_MAX;
+
+	itimerspec timer_value{};
+	timer_value.it_value.tv_nsec = 1;
+	timerfd_settime(wheel->getFd(), 0, &timer_value, NULL);
+}
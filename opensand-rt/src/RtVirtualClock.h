@@ -0,0 +1,180 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+
+/**
+ * @file RtVirtualClock.h
+ * @author Viveris Technologies
+ * @brief  The simulated time driving the timers of all the channels
+ *
+ */
+
+#ifndef RT_VIRTUAL_CLOCK_H
+#define RT_VIRTUAL_CLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+
+class RtTimerWheel;
+
+
+/**
+ * @class RtVirtualClock
+ * @brief A clock that jumps to the next timer expiration once all
+ *        the channels are idle
+ *
+ * When enabled, the timer wheels read the time from this clock and
+ * give it their next expiration instead of programming their timerfd.
+ * A channel is idle when it sleeps in its poller while no message
+ * waits in any fifo: once all of them are, the clock is moved to the
+ * earliest expiration and the channels owning the expired timers are
+ * woken up. Scenarios then run as fast as the blocks process them and
+ * the timers expire at the same simulated instants on every run.
+ *
+ * Only the fifos and the timers are taken into account: file
+ * descriptors fed from outside the process are still processed when
+ * they are ready but do not prevent the clock from moving.
+ */
+class RtVirtualClock
+{
+ public:
+	/**
+	 * @brief Use the simulated time, starting from the current
+	 *        monotonic time; should be called before the blocks
+	 *        creation
+	 */
+	static void enable(void);
+
+	/**
+	 * @brief Check whether the simulated time is used
+	 *
+	 * @return true if the timers are driven by this clock
+	 */
+	static bool isEnabled(void) {return enabled;};
+
+	/**
+	 * @brief Get the simulated time
+	 *
+	 * @return the current time (ns)
+	 */
+	static uint64_t getTime(void) {return now.load(std::memory_order_acquire);};
+
+	/**
+	 * @brief Set the end of the scenario: the clock does not move past
+	 *        it but sends SIGTERM to the process, which stops as usual
+	 *
+	 * @param duration_ns  The simulated duration from now (ns)
+	 */
+	static void setLimit(uint64_t duration_ns);
+
+	/**
+	 * @brief Add a timer wheel driven by the clock, its channel is busy
+	 *        until it first sleeps
+	 *
+	 * @param wheel  The timer wheel
+	 */
+	static void addWheel(RtTimerWheel *wheel);
+
+	/**
+	 * @brief Remove a timer wheel
+	 *
+	 * @param wheel  The timer wheel
+	 */
+	static void removeWheel(RtTimerWheel *wheel);
+
+	/**
+	 * @brief Set the next expiration of a timer wheel
+	 *
+	 * @param wheel     The timer wheel
+	 * @param deadline  The expiration time (ns), UINT64_MAX if no timer is armed
+	 */
+	static void setDeadline(RtTimerWheel *wheel, uint64_t deadline);
+
+	/**
+	 * @brief Declare the channel of a timer wheel about to sleep,
+	 *        the clock moves if all the channels are idle
+	 *
+	 * @param wheel  The timer wheel of the channel
+	 */
+	static void idle(RtTimerWheel *wheel);
+
+	/**
+	 * @brief Declare the channel of a timer wheel woken up
+	 *
+	 * @param wheel  The timer wheel of the channel
+	 */
+	static void busy(RtTimerWheel *wheel);
+
+	/**
+	 * @brief Count messages pushed in a fifo, the clock does not
+	 *        move until they are popped
+	 *
+	 * @param count  The number of messages
+	 */
+	static void addMessages(std::size_t count)
+	{
+		pending.fetch_add(count, std::memory_order_acq_rel);
+	};
+
+	/**
+	 * @brief Count messages popped from a fifo
+	 *
+	 * @param count  The number of messages
+	 */
+	static void removeMessages(std::size_t count)
+	{
+		pending.fetch_sub(count, std::memory_order_acq_rel);
+	};
+
+ private:
+	/**
+	 * @brief Move the clock to the earliest expiration and wake the
+	 *        channels whose timers expired, with the lock held
+	 */
+	static void advance(void);
+
+	/**
+	 * @brief Wake the channel of a timer wheel, with the lock held
+	 *
+	 * @param wheel  The timer wheel
+	 */
+	static void wake(RtTimerWheel *wheel);
+
+	/// whether the simulated time is used
+	static bool enabled;
+
+	/// the simulated time (ns)
+	static std::atomic<uint64_t> now;
+
+	/// the number of messages waiting in the fifos
+	static std::atomic<std::size_t> pending;
+};
+
+
+#endif
@@ -33,23 +33,35 @@
  *
  */
 
-#include <sys/timerfd.h>
+#include <atomic>
 
 #include "TimerEvent.h"
+#include "RtTimerWheel.h"
 
 
-TimerEvent::TimerEvent(const std::string &name,
+/// The next timer id, far above the file descriptors of the events
+static std::atomic<event_id_t> next_timer_id{0x40000000};
+
+
+TimerEvent::TimerEvent(RtTimerWheel &wheel,
+                       const std::string &name,
                        double timer_duration_ms,
                        bool auto_rearm,
                        bool start,
                        uint8_t priority):
-	RtEvent{EventType::Timer, name, -1, priority},
+	RtEvent{EventType::Timer, name, next_timer_id++, priority},
 	duration_ms{timer_duration_ms},
 	enabled{start},
-	auto_rearm{auto_rearm}
+	auto_rearm{auto_rearm},
+	aligned{false},
+	wheel(wheel),
+	wheel_prev{nullptr},
+	wheel_next{nullptr},
+	wheel_level{-1},
+	wheel_slot{0},
+	expiry_tick{0},
+	armed{false}
 {
-	this->fd = timerfd_create(CLOCK_MONOTONIC, 0);
-
 	if(this->enabled)
 	{
 		this->start();
@@ -57,64 +69,40 @@ TimerEvent::TimerEvent(const std::string &name,
 }
 
 
+TimerEvent::~TimerEvent()
+{
+	this->wheel.cancel(this);
+	// the id is not a file descriptor, do not close it
+	this->fd = -1;
+}
+
+
 void TimerEvent::start(void)
 {
-	itimerspec timer_value;
 	this->enabled = true;
 
 	// non periodic, restart manually to avoid more than one timer expiration
-	// TODO this create a non precise timer better use the periodic part offered
-	// by the timerfd (do not forget to read fd)
-	timer_value.it_interval.tv_nsec = 0;
-	timer_value.it_interval.tv_sec = 0;
-
-	//set value
-	if(this->duration_ms < 1000)
+	if(this->aligned)
 	{
-		timer_value.it_value.tv_nsec = this->duration_ms * 1000000;
-		timer_value.it_value.tv_sec = 0;
+		this->wheel.armAligned(this, this->duration_ms);
 	}
 	else
 	{
-		timer_value.it_value.tv_nsec = (static_cast<uint32_t>(this->duration_ms) % 1000) * 1000000 ;
-		timer_value.it_value.tv_sec = this->duration_ms / 1000;
+		this->wheel.arm(this, this->duration_ms);
 	}
-
-	//start timer
-	timerfd_settime(this->fd, 0, &timer_value, NULL);
 }
 
 
 void TimerEvent::raise(void)
 {
-	itimerspec timer_value;
-
-	// it_interval is used as a period
-	// when it is 0, it isn't periodic
-	timer_value.it_interval.tv_sec = 0;
-	timer_value.it_interval.tv_nsec = 0;
-
-	timer_value.it_value.tv_sec = 0;
-	timer_value.it_value.tv_nsec = 1;
-
-	//start timer
-	timerfd_settime(this->fd, 0, &timer_value, NULL);
+	this->wheel.arm(this, 0);
 }
 
 
 void TimerEvent::disable(void)
 {
-	itimerspec timer_value;
 	this->enabled = false;
-
-	//non periodic
-	timer_value.it_interval.tv_nsec = 0;
-	timer_value.it_interval.tv_sec = 0;
-	timer_value.it_value.tv_nsec = 0;
-	timer_value.it_value.tv_sec = 0;
-
-	//stop timer
-	timerfd_settime(this->fd, 0, &timer_value, NULL);
+	this->wheel.cancel(this);
 }
 
 
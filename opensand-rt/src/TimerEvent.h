@@ -41,17 +41,25 @@
 #include "Types.h"
 
 
+class RtTimerWheel;
+
 /**
   * @class TimerEvent
   * @brief Event describing a timer
   *
+  * Timers do not own a file descriptor, they are driven by the
+  * timer wheel of their channel and identified by a unique id
+  * that cannot collide with the events file descriptors.
   */
 class TimerEvent: public RtEvent
 {
+	friend class RtTimerWheel;
+
  public:
 	/**
 	 * @brief TimerEvent constructor
 	 *
+	 * @param wheel              The timer wheel driving the timer
 	 * @param name               The event name
 	 * @param timer_duration_ms  The timer duration (in ms)
 	 * @param auto_rearm         Whether the timer is automatically launched again
@@ -59,21 +67,33 @@ class TimerEvent: public RtEvent
 	 * @param start              default state when created
 	 * @param priority           The priority of the event
 	 */
-	TimerEvent(const std::string &name,
+	TimerEvent(RtTimerWheel &wheel,
+	           const std::string &name,
 	           double timer_duration_ms,
 	           bool auto_rearm = false,
 	           bool start = true,
 	           uint8_t priority = 2);
 
+	~TimerEvent();
+
 	/**
 	 * @brief Start the timer
 	 */
 	void start(void);
 
+	/**
+	 * @brief Make the timer expire on the multiples of its duration
+	 *        on the monotonic clock instead of a duration after
+	 *        it is started, it applies from the next start
+	 *
+	 * @param aligned  Whether the timer is aligned
+	 */
+	inline void setAligned(bool aligned) {this->aligned = aligned;};
+
 	/**
 	 * @brief Trigger a timer immediately
 	 *        In fact, we set the minimum time and start it
-	 *        because there is no way to trigger it manually
+	 *        so it expires on the next wheel tick
 	 */
 	void raise(void);
 
@@ -115,6 +135,26 @@ class TimerEvent: public RtEvent
 
 	/// Whether the timer is rearmed automatically or not
 	bool auto_rearm;
+
+	/// Whether the timer expires on the multiples of its duration
+	bool aligned;
+
+ private:
+	/// The timer wheel driving the timer
+	RtTimerWheel &wheel;
+
+	/// The previous timer in the wheel slot
+	TimerEvent *wheel_prev;
+	/// The next timer in the wheel slot
+	TimerEvent *wheel_next;
+	/// The wheel level of the timer slot, -1 if the timer is due
+	int wheel_level;
+	/// The wheel slot of the timer in its level
+	unsigned int wheel_slot;
+	/// The wheel tick on which the timer expires
+	uint64_t expiry_tick;
+	/// Whether the timer is stored in the wheel
+	bool armed;
 };
 
 
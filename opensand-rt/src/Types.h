@@ -40,6 +40,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <vector>
 
 
 constexpr std::size_t MAX_SOCK_SIZE{9000};
@@ -68,4 +69,25 @@ struct rt_msg_t
 };
 
 
+/// Placement of a channel thread on the host
+struct rt_thread_placement_t
+{
+	/// The CPUs the thread may run on, empty to keep the default affinity
+	std::vector<int> cpus;
+	/// The scheduling policy (SCHED_OTHER, SCHED_FIFO or SCHED_RR)
+	int policy;
+	/// The real-time priority, only used with SCHED_FIFO and SCHED_RR
+	int priority;
+	/// The NUMA nodes the thread memory is bound to, empty to only
+	/// prefer the node of the CPUs
+	std::vector<int> numa_nodes;
+	/// The time the channel spins on its fifos and timers before
+	/// sleeping (us), 0 to always sleep
+	double busy_poll_us;
+	/// Whether the fifos rings and packets pools of the channel are
+	/// backed by huge pages
+	bool huge_pages;
+};
+
+
 #endif
@@ -0,0 +1,868 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file BenchBlocks.cpp
+ * @brief Throughput and latency benchmark of the opensand-rt block graph
+ * @author Viveris Technologies
+ */
+
+
+// This benchmark creates a chain of blocks and pumps messages upward from
+// the source blocks to the sink blocks, the downward channels are idle:
+//
+//  linear:       mux:                demux:              muxdemux:
+//
+//   sink          sink_mux           sink  ... sink      sink  ... sink
+//    |           |        |           |         |         |         |
+//  relays      relays .. relays     relays .. relays     +-- switch --+
+//    |           |        |           |         |         |         |
+//  source      source .. source     +- source_demux -+   relays .. relays
+//                                                         |         |
+//                                                        source .. source
+//
+// Each channel receiving a message stamps it, the sinks record the latency
+// between consecutive stamps (the hops) and between the first and the last
+// one. The messages created during the warmup are ignored.
+//
+// With a rate of 0, the sources send as many messages as the chain accepts,
+// the producers being blocked by the full fifos: the rate received by the
+// sinks is the maximum sustainable rate of the chain.
+
+
+#include "BenchBlocks.h"
+#include "Rt.h"
+#include "MessageEvent.h"
+
+#include <opensand_output/Output.h>
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <unistd.h>
+
+
+/// The maximum number of latencies recorded by each sink
+#define MAX_SAMPLES (1 << 21)
+
+/// The period of the sources timer (ms)
+#define SOURCE_PERIOD_MS 1
+
+
+/**
+ * @brief The benchmark parameters
+ */
+static struct
+{
+	std::string topology = "linear";
+	unsigned int relays = 2;
+	unsigned int branches = 2;
+	std::size_t message_size = 1500;
+	double rate = 0;
+	double duration = 5;
+	double warmup = 1;
+	std::size_t batch_size = 1;
+	PollerType poller = PollerType::Epoll;
+	bool fused = false;
+
+	/// The names of the blocks, to fuse their links
+	std::vector<std::string> blocks;
+	/// The number of source channels sharing the rate
+	unsigned int sources = 1;
+	/// The number of sink channels
+	unsigned int sinks = 1;
+	bench_clock::time_point window_start;
+	bench_clock::time_point window_end;
+} config;
+
+
+/**
+ * @brief The measures of all the sinks
+ */
+static struct
+{
+	std::mutex lock;
+	std::atomic<uint64_t> offered{0};
+	std::atomic<uint64_t> send_errors{0};
+	uint64_t received = 0;
+	uint64_t bytes = 0;
+	std::vector<std::vector<uint32_t>> hop_latencies;
+	std::vector<uint32_t> latencies;
+	unsigned int finished_sinks = 0;
+} results;
+
+
+/**
+ * @brief Apply the benchmark parameters to a channel
+ */
+static void configureChannel(RtChannelBase &channel)
+{
+	channel.setPollerType(config.poller);
+	channel.setMessageBatchSize(config.batch_size);
+}
+
+
+static bool inWindow(const BenchMessage &message)
+{
+	return message.stamps[0] >= config.window_start &&
+	       message.stamps[0] < config.window_end;
+}
+
+
+/**
+ * @brief Get the message of an event of a relay channel and stamp it
+ */
+static std::unique_ptr<BenchMessage> receive(RtChannelBase &channel,
+                                             const RtEvent *const event)
+{
+	if(event->getType() != EventType::Message)
+	{
+		Rt::reportError(channel.getName(), std::this_thread::get_id(), true,
+		                "Unexpected event received");
+		return nullptr;
+	}
+	auto msg = static_cast<const MessageEvent *>(event);
+	std::unique_ptr<BenchMessage> message = msg->releaseData<BenchMessage>();
+	message->stamp();
+	return message;
+}
+
+
+static bool unexpectedEvent(RtChannelBase &channel, const RtEvent *const event)
+{
+	Rt::reportError(channel.getName(), std::this_thread::get_id(), true,
+	                "Unexpected event received on the idle channel");
+	return false;
+}
+
+
+static bool sendError(RtChannelBase &channel)
+{
+	results.send_errors++;
+	Rt::reportError(channel.getName(), std::this_thread::get_id(), true,
+	                "Cannot send a message");
+	return false;
+}
+
+
+///////////////////////// BenchMessage /////////////////////////
+
+void BenchMessage::stamp()
+{
+	if(this->hops < BENCH_MAX_HOPS)
+	{
+		this->stamps[this->hops++] = bench_clock::now();
+	}
+}
+
+
+///////////////////////// BenchSource /////////////////////////
+
+BenchSource::BenchSource(unsigned int route):
+	route{route},
+	started{false},
+	first_tick{},
+	emitted{0}
+{
+}
+
+
+std::unique_ptr<BenchMessage> BenchSource::create()
+{
+	std::unique_ptr<BenchMessage> message{new BenchMessage};
+	message->payload.assign(config.message_size, 0x5a);
+	message->route = this->route;
+	message->hops = 0;
+	message->stamp();
+	if(inWindow(*message))
+	{
+		results.offered++;
+	}
+	this->emitted++;
+	return message;
+}
+
+
+template <class Channel, class Send>
+bool BenchSource::tick(Channel &channel, Send send)
+{
+	auto now = bench_clock::now();
+	if(now >= config.window_end)
+	{
+		return true;
+	}
+	if(!this->started)
+	{
+		this->started = true;
+		this->first_tick = now;
+	}
+
+	if(config.rate > 0)
+	{
+		// send the messages due since the first tick
+		double elapsed = std::chrono::duration<double>(now - this->first_tick).count();
+		uint64_t due = elapsed * config.rate / config.sources;
+		while(this->emitted < due)
+		{
+			if(!send(this->create()))
+			{
+				return sendError(channel);
+			}
+		}
+	}
+	else
+	{
+		// send until the next tick, blocked by the full fifos
+		auto next_tick = now + std::chrono::milliseconds(SOURCE_PERIOD_MS);
+		do
+		{
+			for(unsigned int index = 0; index < 64; ++index)
+			{
+				if(!send(this->create()))
+				{
+					return sendError(channel);
+				}
+			}
+			now = bench_clock::now();
+		}
+		while(now < next_tick && now < config.window_end);
+	}
+	return true;
+}
+
+
+///////////////////////// BenchSink /////////////////////////
+
+BenchSink::BenchSink():
+	received{0},
+	bytes{0},
+	hop_latencies{},
+	latencies{}
+{
+}
+
+
+void BenchSink::record(std::unique_ptr<BenchMessage> message)
+{
+	if(!inWindow(*message))
+	{
+		return;
+	}
+	this->received++;
+	this->bytes += message->payload.size();
+	if(this->latencies.size() >= MAX_SAMPLES)
+	{
+		return;
+	}
+
+	unsigned int hops = message->hops - 1;
+	if(this->hop_latencies.size() < hops)
+	{
+		this->hop_latencies.resize(hops);
+	}
+	for(unsigned int hop = 0; hop < hops; ++hop)
+	{
+		auto latency = message->stamps[hop + 1] - message->stamps[hop];
+		this->hop_latencies[hop].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+	}
+	auto latency = message->stamps[hops] - message->stamps[0];
+	this->latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+}
+
+
+void BenchSink::finish()
+{
+	std::lock_guard<std::mutex> lock{results.lock};
+	results.received += this->received;
+	results.bytes += this->bytes;
+	if(results.hop_latencies.size() < this->hop_latencies.size())
+	{
+		results.hop_latencies.resize(this->hop_latencies.size());
+	}
+	for(std::size_t hop = 0; hop < this->hop_latencies.size(); ++hop)
+	{
+		results.hop_latencies[hop].insert(results.hop_latencies[hop].end(),
+		                                  this->hop_latencies[hop].begin(),
+		                                  this->hop_latencies[hop].end());
+	}
+	results.latencies.insert(results.latencies.end(),
+	                         this->latencies.begin(),
+	                         this->latencies.end());
+
+	results.finished_sinks++;
+	if(results.finished_sinks == config.sinks)
+	{
+		kill(getpid(), SIGTERM);
+	}
+}
+
+
+static bool sinkInit(RtChannelBase &channel)
+{
+	// stop once the messages of the window had time to reach the sink
+	auto end = config.window_end + std::chrono::milliseconds(500);
+	double duration_ms = std::chrono::duration<double, std::milli>(end - bench_clock::now()).count();
+	return channel.addTimerEvent("end", std::max(duration_ms, 1.0), false) >= 0;
+}
+
+
+static bool sinkEvent(RtChannelBase &channel, BenchSink &sink,
+                      const RtEvent *const event)
+{
+	switch(event->getType())
+	{
+		case EventType::Message:
+		{
+			auto msg = static_cast<const MessageEvent *>(event);
+			std::unique_ptr<BenchMessage> message = msg->releaseData<BenchMessage>();
+			message->stamp();
+			sink.record(std::move(message));
+			return true;
+		}
+		case EventType::Timer:
+			sink.finish();
+			return true;
+		default:
+			return unexpectedEvent(channel, event);
+	}
+}
+
+
+///////////////////////// Source /////////////////////////
+
+Source::Source(const std::string &name, unsigned int route):
+	Block{name}
+{
+}
+
+Source::Upward::Upward(const std::string &name, unsigned int route):
+	RtUpward{name},
+	source{route}
+{
+	configureChannel(*this);
+}
+
+bool Source::Upward::onInit()
+{
+	return this->addTimerEvent("source", SOURCE_PERIOD_MS) >= 0;
+}
+
+bool Source::Upward::onEvent(const RtEvent *const event)
+{
+	if(event->getType() != EventType::Timer)
+	{
+		return unexpectedEvent(*this, event);
+	}
+	return this->source.tick(*this, [this](std::unique_ptr<BenchMessage> message)
+	{
+		return this->enqueueMessage(std::move(message), config.message_size, 0);
+	});
+}
+
+Source::Downward::Downward(const std::string &name, unsigned int route):
+	RtDownward{name}
+{
+	configureChannel(*this);
+}
+
+bool Source::Downward::onEvent(const RtEvent *const event)
+{
+	return unexpectedEvent(*this, event);
+}
+
+
+///////////////////////// SourceDemux /////////////////////////
+
+SourceDemux::Upward::Upward(const std::string &name):
+	RtUpwardDemux<unsigned int>{name},
+	source{0},
+	next_route{0}
+{
+	configureChannel(*this);
+}
+
+bool SourceDemux::Upward::onInit()
+{
+	return this->addTimerEvent("source", SOURCE_PERIOD_MS) >= 0;
+}
+
+bool SourceDemux::Upward::onEvent(const RtEvent *const event)
+{
+	if(event->getType() != EventType::Timer)
+	{
+		return unexpectedEvent(*this, event);
+	}
+	return this->source.tick(*this, [this](std::unique_ptr<BenchMessage> message)
+	{
+		// spread the messages on the branches
+		unsigned int route = this->next_route;
+		this->next_route = (this->next_route + 1) % config.branches;
+		message->route = route;
+		return this->enqueueMessage(route, std::move(message), config.message_size, 0);
+	});
+}
+
+SourceDemux::Downward::Downward(const std::string &name):
+	RtDownwardMux{name}
+{
+	configureChannel(*this);
+}
+
+bool SourceDemux::Downward::onEvent(const RtEvent *const event)
+{
+	return unexpectedEvent(*this, event);
+}
+
+
+///////////////////////// Relay /////////////////////////
+
+Relay::Upward::Upward(const std::string &name):
+	RtUpward{name}
+{
+	configureChannel(*this);
+}
+
+bool Relay::Upward::onEvent(const RtEvent *const event)
+{
+	std::unique_ptr<BenchMessage> message = receive(*this, event);
+	if(message == nullptr)
+	{
+		return false;
+	}
+	if(!this->enqueueMessage(std::move(message), config.message_size, 0))
+	{
+		return sendError(*this);
+	}
+	return true;
+}
+
+Relay::Downward::Downward(const std::string &name):
+	RtDownward{name}
+{
+	configureChannel(*this);
+}
+
+bool Relay::Downward::onEvent(const RtEvent *const event)
+{
+	return unexpectedEvent(*this, event);
+}
+
+
+///////////////////////// Switch /////////////////////////
+
+Switch::Upward::Upward(const std::string &name):
+	RtUpwardMuxDemux<unsigned int>{name}
+{
+	configureChannel(*this);
+}
+
+bool Switch::Upward::onEvent(const RtEvent *const event)
+{
+	std::unique_ptr<BenchMessage> message = receive(*this, event);
+	if(message == nullptr)
+	{
+		return false;
+	}
+	unsigned int route = message->route;
+	if(!this->enqueueMessage(route, std::move(message), config.message_size, 0))
+	{
+		return sendError(*this);
+	}
+	return true;
+}
+
+Switch::Downward::Downward(const std::string &name):
+	RtDownwardMuxDemux<unsigned int>{name}
+{
+	configureChannel(*this);
+}
+
+bool Switch::Downward::onEvent(const RtEvent *const event)
+{
+	return unexpectedEvent(*this, event);
+}
+
+
+///////////////////////// Sink /////////////////////////
+
+Sink::Upward::Upward(const std::string &name):
+	RtUpward{name},
+	sink{}
+{
+	configureChannel(*this);
+}
+
+bool Sink::Upward::onInit()
+{
+	return sinkInit(*this);
+}
+
+bool Sink::Upward::onEvent(const RtEvent *const event)
+{
+	return sinkEvent(*this, this->sink, event);
+}
+
+Sink::Downward::Downward(const std::string &name):
+	RtDownward{name}
+{
+	configureChannel(*this);
+}
+
+bool Sink::Downward::onEvent(const RtEvent *const event)
+{
+	return unexpectedEvent(*this, event);
+}
+
+
+///////////////////////// SinkMux /////////////////////////
+
+SinkMux::Upward::Upward(const std::string &name):
+	RtUpwardMux{name},
+	sink{}
+{
+	configureChannel(*this);
+}
+
+bool SinkMux::Upward::onInit()
+{
+	return sinkInit(*this);
+}
+
+bool SinkMux::Upward::onEvent(const RtEvent *const event)
+{
+	return sinkEvent(*this, this->sink, event);
+}
+
+SinkMux::Downward::Downward(const std::string &name):
+	RtDownwardDemux<unsigned int>{name}
+{
+	configureChannel(*this);
+}
+
+bool SinkMux::Downward::onEvent(const RtEvent *const event)
+{
+	return unexpectedEvent(*this, event);
+}
+
+
+///////////////////////// main /////////////////////////
+
+/**
+ * @brief The relays of a branch, connected together
+ */
+struct Branch
+{
+	Relay *bottom;
+	Relay *top;
+};
+
+template <class Bl, class... Specific>
+static Bl *createBlock(const std::string &name, Specific... specific)
+{
+	config.blocks.push_back(name);
+	return Rt::createBlock<Bl>(name, specific...);
+}
+
+static Branch createBranch(const std::string &name)
+{
+	Branch branch{nullptr, nullptr};
+	for(unsigned int index = 0; index < config.relays; ++index)
+	{
+		auto relay = createBlock<Relay>(name + "_relay" + std::to_string(index));
+		if(branch.top != nullptr)
+		{
+			Rt::connectBlocks(relay, branch.top);
+		}
+		else
+		{
+			branch.bottom = relay;
+		}
+		branch.top = relay;
+	}
+	return branch;
+}
+
+
+static bool createBlocks()
+{
+	if(config.topology == "linear")
+	{
+		auto source = createBlock<Source>("source", 0u);
+		auto sink = createBlock<Sink>("sink");
+		Branch branch = createBranch("branch");
+		if(branch.bottom != nullptr)
+		{
+			Rt::connectBlocks(branch.bottom, source);
+			Rt::connectBlocks(sink, branch.top);
+		}
+		else
+		{
+			Rt::connectBlocks(sink, source);
+		}
+		config.sources = 1;
+		config.sinks = 1;
+	}
+	else if(config.topology == "mux")
+	{
+		auto sink = createBlock<SinkMux>("sink_mux");
+		for(unsigned int route = 0; route < config.branches; ++route)
+		{
+			auto name = "branch" + std::to_string(route);
+			auto source = createBlock<Source>(name + "_source", route);
+			Branch branch = createBranch(name);
+			if(branch.bottom != nullptr)
+			{
+				Rt::connectBlocks(branch.bottom, source);
+				Rt::connectBlocks(sink, branch.top, route);
+			}
+			else
+			{
+				Rt::connectBlocks(sink, source, route);
+			}
+		}
+		config.sources = config.branches;
+		config.sinks = 1;
+	}
+	else if(config.topology == "demux")
+	{
+		auto source = createBlock<SourceDemux>("source_demux");
+		for(unsigned int route = 0; route < config.branches; ++route)
+		{
+			auto name = "branch" + std::to_string(route);
+			auto sink = createBlock<Sink>(name + "_sink");
+			Branch branch = createBranch(name);
+			if(branch.bottom != nullptr)
+			{
+				Rt::connectBlocks(branch.bottom, source, route);
+				Rt::connectBlocks(sink, branch.top);
+			}
+			else
+			{
+				Rt::connectBlocks(sink, source, route);
+			}
+		}
+		config.sources = 1;
+		config.sinks = config.branches;
+	}
+	else if(config.topology == "muxdemux")
+	{
+		auto middle = createBlock<Switch>("switch");
+		for(unsigned int route = 0; route < config.branches; ++route)
+		{
+			auto name = "branch" + std::to_string(route);
+			auto source = createBlock<Source>(name + "_source", route);
+			auto sink = createBlock<Sink>(name + "_sink");
+			Branch branch = createBranch(name);
+			if(branch.bottom != nullptr)
+			{
+				Rt::connectBlocks(branch.bottom, source);
+				Rt::connectBlocks(middle, branch.top, route);
+			}
+			else
+			{
+				Rt::connectBlocks(middle, source, route);
+			}
+			Rt::connectBlocks(sink, middle, route);
+		}
+		config.sources = config.branches;
+		config.sinks = config.branches;
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+
+static void printLatencies(const std::string &name, std::vector<uint32_t> &latencies)
+{
+	if(latencies.empty())
+	{
+		return;
+	}
+	std::sort(latencies.begin(), latencies.end());
+	auto percentile = [&latencies](double ratio)
+	{
+		return latencies[std::min<std::size_t>(latencies.size() * ratio, latencies.size() - 1)] / 1000.0;
+	};
+	printf("%-10s %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+	       name.c_str(), percentile(0.5), percentile(0.9),
+	       percentile(0.99), percentile(0.999), latencies.back() / 1000.0);
+}
+
+
+/**
+ * @brief Print usage of the benchmark application
+ */
+static void usage(void)
+{
+	std::cerr << "Bench blocks: measure the throughput and latency of the opensand rt library" << std::endl
+	          << "usage: bench_blocks [-h] [-t topology] [-n relays] [-k branches] [-s size]" << std::endl
+	          << "                    [-r rate] [-d duration] [-w warmup] [-b batch] [-p poller] [-f]" << std::endl
+	          << "  -t topology  linear, mux, demux or muxdemux (default: linear)" << std::endl
+	          << "  -n relays    the number of relay blocks on each branch (default: 2)" << std::endl
+	          << "  -k branches  the number of branches of the mux and demux topologies (default: 2)" << std::endl
+	          << "  -s size      the messages payload size in bytes (default: 1500)" << std::endl
+	          << "  -r rate      the total messages rate in messages per second," << std::endl
+	          << "               0 to find the maximum sustainable rate (default: 0)" << std::endl
+	          << "  -d duration  the measure duration in seconds (default: 5)" << std::endl
+	          << "  -w warmup    the duration ignored before the measure in seconds (default: 1)" << std::endl
+	          << "  -b batch     the maximum messages drained per fifo wakeup (default: 1)" << std::endl
+	          << "  -p poller    the channels poller, epoll or select (default: epoll)" << std::endl
+	          << "  -f           fuse the links between the blocks" << std::endl;
+}
+
+
+int main(int argc, char **argv)
+{
+	int opt;
+	while((opt = getopt(argc, argv, "ht:n:k:s:r:d:w:b:p:f")) != -1)
+	{
+		switch(opt)
+		{
+			case 't':
+				config.topology = optarg;
+				break;
+			case 'n':
+				config.relays = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'k':
+				config.branches = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 's':
+				config.message_size = std::strtoul(optarg, nullptr, 10);
+				break;
+			case 'r':
+				config.rate = std::strtod(optarg, nullptr);
+				break;
+			case 'd':
+				config.duration = std::strtod(optarg, nullptr);
+				break;
+			case 'w':
+				config.warmup = std::strtod(optarg, nullptr);
+				break;
+			case 'b':
+				config.batch_size = std::max(1ul, std::strtoul(optarg, nullptr, 10));
+				break;
+			case 'p':
+				if(!strcmp(optarg, "epoll"))
+				{
+					config.poller = PollerType::Epoll;
+				}
+				else if(!strcmp(optarg, "select"))
+				{
+					config.poller = PollerType::Select;
+				}
+				else
+				{
+					usage();
+					return 1;
+				}
+				break;
+			case 'f':
+				config.fused = true;
+				break;
+			case 'h':
+			default:
+				usage();
+				return 1;
+		}
+	}
+	// the sources and the sinks stamp the messages too
+	if(config.branches == 0 || config.duration <= 0 || config.rate < 0 ||
+	   config.relays + 3 > BENCH_MAX_HOPS)
+	{
+		usage();
+		return 1;
+	}
+
+	if(!createBlocks())
+	{
+		usage();
+		return 1;
+	}
+	if(config.fused)
+	{
+		for(auto &&name: config.blocks)
+		{
+			Rt::setFusedLinks(name, true);
+			Rt::setFusedLinks(name, false);
+		}
+	}
+
+	auto output = Output::Get();
+	output->configureTerminalOutput();
+	output->setDisplayLevel(LEVEL_ERROR);
+	output->finalizeConfiguration();
+
+	auto warmup = std::chrono::duration<double>(config.warmup);
+	auto duration = std::chrono::duration<double>(config.duration);
+	config.window_start = bench_clock::now() + std::chrono::duration_cast<bench_clock::duration>(warmup);
+	config.window_end = config.window_start + std::chrono::duration_cast<bench_clock::duration>(duration);
+
+	if(!Rt::run(true))
+	{
+		std::cerr << "Error during execution\n";
+		return 1;
+	}
+
+	std::lock_guard<std::mutex> lock{results.lock};
+	printf("topology %s, %u branch(es) of %u relay(s), %zu-byte messages, %s poller, batches of %zu%s\n",
+	       config.topology.c_str(), config.topology == "linear" ? 1 : config.branches,
+	       config.relays, config.message_size,
+	       config.poller == PollerType::Epoll ? "epoll" : "select",
+	       config.batch_size, config.fused ? ", fused links" : "");
+	if(config.rate > 0)
+	{
+		printf("offered:  %.0f msg/s\n", results.offered / config.duration);
+	}
+	else
+	{
+		printf("offered:  maximum rate\n");
+	}
+	printf("received: %.0f msg/s, %.2f MB/s, %llu lost\n",
+	       results.received / config.duration,
+	       results.bytes / config.duration / 1e6,
+	       static_cast<unsigned long long>(results.offered - results.received));
+	printf("latency (us)      p50        p90        p99      p99.9        max\n");
+	for(std::size_t hop = 0; hop < results.hop_latencies.size(); ++hop)
+	{
+		printLatencies("hop " + std::to_string(hop), results.hop_latencies[hop]);
+	}
+	printLatencies("total", results.latencies);
+
+	return results.send_errors == 0 ? 0 : 1;
+}
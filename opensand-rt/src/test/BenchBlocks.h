@@ -0,0 +1,276 @@
+/*
+ *
+ * OpenSAND is an emulation testbed aiming to represent in a cost effective way a
+ * satellite telecommunication system for research and engineering activities.
+ *
+ *
+ * Copyright © 2019 TAS
+ * Copyright © 2019 CNES
+ *
+ *
+ * This file is part of the OpenSAND testbed.
+ *
+ *
+ * OpenSAND is free software : you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY, without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/**
+ * @file BenchBlocks.h
+ * @brief Blocks of the opensand-rt throughput and latency benchmark
+ * @author Viveris Technologies
+ */
+
+#ifndef BENCHBLOCKS_H
+#define BENCHBLOCKS_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Block.h"
+#include "RtChannel.h"
+#include "RtChannelMux.h"
+#include "RtChannelDemux.h"
+#include "RtChannelMuxDemux.h"
+
+
+using bench_clock = std::chrono::steady_clock;
+
+/// The maximum number of hops a message can go through
+#define BENCH_MAX_HOPS 16
+
+
+/**
+ * @brief A message of the benchmark, stamped by each channel it goes through
+ */
+struct BenchMessage
+{
+	std::vector<unsigned char> payload;
+	/// The branch of the message, used as demux key
+	unsigned int route;
+	/// The number of stamps
+	unsigned int hops;
+	bench_clock::time_point stamps[BENCH_MAX_HOPS];
+
+	void stamp();
+};
+
+
+/**
+ * @brief Generate the messages of a source channel at the configured rate
+ */
+class BenchSource
+{
+  public:
+	BenchSource(unsigned int route);
+
+	/**
+	 * @brief Create the messages due since the first tick
+	 *
+	 * @param channel  The channel sending the messages
+	 * @param send     Send a message on the channel
+	 * @return true on success, false otherwise
+	 */
+	template <class Channel, class Send>
+	bool tick(Channel &channel, Send send);
+
+  private:
+	std::unique_ptr<BenchMessage> create();
+
+	unsigned int route;
+	bool started;
+	bench_clock::time_point first_tick;
+	uint64_t emitted;
+};
+
+
+/**
+ * @brief Record the latencies of the messages received by a sink channel
+ *        and merge them in the results at the end of the measure
+ */
+class BenchSink
+{
+  public:
+	BenchSink();
+
+	void record(std::unique_ptr<BenchMessage> message);
+	void finish();
+
+  private:
+	uint64_t received;
+	uint64_t bytes;
+	std::vector<std::vector<uint32_t>> hop_latencies;
+	std::vector<uint32_t> latencies;
+};
+
+
+/**
+ * @brief The first block of a branch, with a single output
+ */
+class Source: public Block
+{
+  public:
+	Source(const std::string &name, unsigned int route);
+
+	class Upward: public RtUpward
+	{
+	  public:
+		Upward(const std::string &name, unsigned int route);
+		bool onInit() override;
+		bool onEvent(const RtEvent *const event) override;
+
+	  private:
+		BenchSource source;
+	};
+
+	class Downward: public RtDownward
+	{
+	  public:
+		Downward(const std::string &name, unsigned int route);
+		bool onEvent(const RtEvent *const event) override;
+	};
+};
+
+/**
+ * @brief A source dispatching its messages to several branches
+ */
+class SourceDemux: public Block
+{
+  public:
+	using Block::Block;
+
+	class Upward: public RtUpwardDemux<unsigned int>
+	{
+	  public:
+		Upward(const std::string &name);
+		bool onInit() override;
+		bool onEvent(const RtEvent *const event) override;
+
+	  private:
+		BenchSource source;
+		unsigned int next_route;
+	};
+
+	class Downward: public RtDownwardMux
+	{
+	  public:
+		Downward(const std::string &name);
+		bool onEvent(const RtEvent *const event) override;
+	};
+};
+
+/**
+ * @brief A block forwarding the messages to the upper block
+ */
+class Relay: public Block
+{
+  public:
+	using Block::Block;
+
+	class Upward: public RtUpward
+	{
+	  public:
+		Upward(const std::string &name);
+		bool onEvent(const RtEvent *const event) override;
+	};
+
+	class Downward: public RtDownward
+	{
+	  public:
+		Downward(const std::string &name);
+		bool onEvent(const RtEvent *const event) override;
+	};
+};
+
+/**
+ * @brief A block forwarding the messages of several branches
+ *        to the upper branch of their route
+ */
+class Switch: public Block
+{
+  public:
+	using Block::Block;
+
+	class Upward: public RtUpwardMuxDemux<unsigned int>
+	{
+	  public:
+		Upward(const std::string &name);
+		bool onEvent(const RtEvent *const event) override;
+	};
+
+	class Downward: public RtDownwardMuxDemux<unsigned int>
+	{
+	  public:
+		Downward(const std::string &name);
+		bool onEvent(const RtEvent *const event) override;
+	};
+};
+
+/**
+ * @brief The last block of a branch, with a single input
+ */
+class Sink: public Block
+{
+  public:
+	using Block::Block;
+
+	class Upward: public RtUpward
+	{
+	  public:
+		Upward(const std::string &name);
+		bool onInit() override;
+		bool onEvent(const RtEvent *const event) override;
+
+	  private:
+		BenchSink sink;
+	};
+
+	class Downward: public RtDownward
+	{
+	  public:
+		Downward(const std::string &name);
+		bool onEvent(const RtEvent *const event) override;
+	};
+};
+
+/**
+ * @brief A sink receiving the messages of several branches
+ */
+class SinkMux: public Block
+{
+  public:
+	using Block::Block;
+
+	class Upward: public RtUpwardMux
+	{
+	  public:
+		Upward(const std::string &name);
+		bool onInit() override;
+		bool onEvent(const RtEvent *const event) override;
+
+	  private:
+		BenchSink sink;
+	};
+
+	class Downward: public RtDownwardDemux<unsigned int>
+	{
+	  public:
+		Downward(const std::string &name);
+		bool onEvent(const RtEvent *const event) override;
+	};
+};
+
+#endif
@@ -46,6 +46,14 @@ enum struct Side
 	RIGHT
 };
 
+template <>
+struct RtDenseKey<Side>
+{
+	static constexpr bool dense = true;
+	static constexpr std::size_t size = 2;
+	static constexpr std::size_t index(Side key) { return static_cast<std::size_t>(key); }
+};
+
 class TopMux : public Block
 {
   public: